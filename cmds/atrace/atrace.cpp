@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -30,8 +31,10 @@
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -273,6 +276,7 @@ static int g_traceDurationSeconds = 5;
 static bool g_traceOverwrite = false;
 static int g_traceBufferSizeKB = 2048;
 static bool g_compress = false;
+static bool g_rawTrace = false;
 static bool g_nohup = false;
 static int g_initialSleepSecs = 0;
 static const char* g_categoriesFile = nullptr;
@@ -334,6 +338,9 @@ static const char* k_tracePath =
 static const char* k_traceStreamPath =
     "trace_pipe";
 
+static const char* k_traceRawStreamPathFormat =
+    "per_cpu/cpu%d/trace_pipe_raw";
+
 static const char* k_traceMarkerPath =
     "trace_marker";
 
@@ -1026,6 +1033,170 @@ static void dumpTrace(int outFd)
     close(traceFD);
 }
 
+// A record of a raw trace is made of this header followed by size bytes of
+// whole ring buffer pages recorded on cpu, in the format of events/header_page.
+struct RawTraceRecordHeader {
+    uint32_t cpu;
+    uint32_t size;
+};
+
+// Number of pages moved by each splice of a raw trace buffer.
+static const size_t k_rawTraceSplicePages = 16;
+
+// Moves size bytes from pipeFd to outFd, without copying them to user space
+// unless outFd doesn't support splice.
+static bool writeFromPipe(int pipeFd, int outFd, size_t size)
+{
+    char buf[4096];
+    while (size > 0) {
+        ssize_t n = splice(pipeFd, nullptr, outFd, nullptr, size, SPLICE_F_MOVE);
+        if (n == -1 && errno == EINVAL) {
+            n = TEMP_FAILURE_RETRY(read(pipeFd, buf, std::min(size, sizeof(buf))));
+            if (n > 0 && !android::base::WriteFully(outFd, buf, n)) {
+                n = -1;
+            }
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeRawTraceRecord(uint32_t cpu, size_t size, int outFd)
+{
+    RawTraceRecordHeader header = { cpu, static_cast<uint32_t>(size) };
+    return android::base::WriteFully(outFd, &header, sizeof(header));
+}
+
+// Writes the pages available in the raw trace buffer of a CPU to outFd. Whole
+// pages are spliced through pipeFds, and once drain is set, the page still being
+// filled is read as well. Returns false if the trace can't be written.
+static bool copyRawTraceBuffer(uint32_t cpu, int rawFd, const int pipeFds[2], int outFd,
+        bool drain)
+{
+    const size_t pageSize = getpagesize();
+    while (true) {
+        ssize_t size = splice(rawFd, nullptr, pipeFds[1], nullptr,
+                k_rawTraceSplicePages * pageSize, SPLICE_F_NONBLOCK);
+        if (size <= 0) {
+            // Reading still works where splice doesn't.
+            drain |= (size == -1 && errno != EAGAIN && errno != EINTR);
+            break;
+        }
+        if (!writeRawTraceRecord(cpu, size, outFd) || !writeFromPipe(pipeFds[0], outFd, size)) {
+            fprintf(stderr, "error writing raw trace: %s\n", strerror(errno));
+            return false;
+        }
+    }
+    if (!drain) {
+        return true;
+    }
+
+    std::unique_ptr<char[]> page(new char[pageSize]);
+    ssize_t size;
+    while ((size = TEMP_FAILURE_RETRY(read(rawFd, page.get(), pageSize))) > 0) {
+        if (!writeRawTraceRecord(cpu, size, outFd)
+                || !android::base::WriteFully(outFd, page.get(), size)) {
+            fprintf(stderr, "error writing raw trace: %s\n", strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+// The raw trace buffers of the CPUs, and the pipe used to splice them.
+struct RawTraceBuffers {
+    std::vector<uint32_t> cpus;
+    std::vector<pollfd> fds;
+    int pipeFds[2] = { -1, -1 };
+
+    ~RawTraceBuffers() {
+        for (const pollfd& fd : fds) {
+            close(fd.fd);
+        }
+        if (pipeFds[0] != -1) {
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+        }
+    }
+
+    // Copies the available pages of every buffer to outFd.
+    bool copy(int outFd, bool drain) {
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (!copyRawTraceBuffer(cpus[i], fds[i].fd, pipeFds, outFd, drain)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Opens the raw trace buffer of each CPU. Returns false if there is nothing to
+// read.
+static bool openRawTraceBuffers(RawTraceBuffers* buffers)
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < cpus; cpu++) {
+        std::string path = g_traceFolder +
+                android::base::StringPrintf(k_traceRawStreamPathFormat, static_cast<int>(cpu));
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd == -1) {
+            // Offline CPUs may have no buffer.
+            continue;
+        }
+        buffers->cpus.push_back(cpu);
+        buffers->fds.push_back({ fd, POLLIN, 0 });
+    }
+    if (buffers->fds.empty()) {
+        fprintf(stderr, "error opening the raw trace buffers: %s (%d)\n",
+                strerror(errno), errno);
+        return false;
+    }
+    if (pipe2(buffers->pipeFds, O_CLOEXEC) == -1) {
+        fprintf(stderr, "error creating pipe: %s (%d)\n", strerror(errno), errno);
+        return false;
+    }
+    fcntl(buffers->pipeFds[1], F_SETPIPE_SZ, k_rawTraceSplicePages * getpagesize());
+    return true;
+}
+
+// Forwards the raw trace buffers to stdout as pages are filled, until tracing
+// is aborted.
+static void streamRawTrace()
+{
+    RawTraceBuffers buffers;
+    if (!openRawTraceBuffers(&buffers)) {
+        return;
+    }
+    while (!g_traceAborted) {
+        // The timeout catches signals arriving before poll is entered.
+        int rc = poll(buffers.fds.data(), buffers.fds.size(), 1000);
+        if (rc == -1 && errno != EINTR) {
+            fprintf(stderr, "error polling raw trace: %s (%d)\n", strerror(errno), errno);
+            return;
+        }
+        if (rc > 0 && !buffers.copy(STDOUT_FILENO, /* drain */ false)) {
+            return;
+        }
+    }
+    buffers.copy(STDOUT_FILENO, /* drain */ true);
+}
+
+// Writes the current contents of the raw trace buffers to outFd.
+static void dumpRawTrace(int outFd)
+{
+    ALOGI("Dumping raw trace");
+    RawTraceBuffers buffers;
+    if (openRawTraceBuffers(&buffers)) {
+        buffers.copy(outFd, /* drain */ true);
+    }
+}
+
 static void handleSignal(int /*signo*/)
 {
     if (!g_nohup) {
@@ -1082,6 +1253,10 @@ static void showHelp(const char *cmd)
                     "                    Note: this can take significant CPU time, and is best\n"
                     "                    used for measuring things that are not affected by\n"
                     "                    CPU performance, like pagecache usage.\n"
+                    "  --raw           dump or stream the binary ring buffer pages of each\n"
+                    "                    CPU, spliced from per_cpu/cpuN/trace_pipe_raw, instead\n"
+                    "                    of text. Each record is a u32 cpu and a u32 size\n"
+                    "                    followed by size bytes of pages.\n"
                     "  --list_categories\n"
                     "                  list the available tracing categories\n"
                     " -o filename      write the trace to the specified file instead\n"
@@ -1216,6 +1391,7 @@ int main(int argc, char **argv)
             {"only_userspace",    no_argument, nullptr,  0 },
             {"list_categories",   no_argument, nullptr,  0 },
             {"stream",            no_argument, nullptr,  0 },
+            {"raw",               no_argument, nullptr,  0 },
             {nullptr,                       0, nullptr,  0 }
         };
 
@@ -1291,6 +1467,8 @@ int main(int argc, char **argv)
                 } else if (!strcmp(long_options[option_index].name, "stream")) {
                     traceStream = true;
                     traceDump = false;
+                } else if (!strcmp(long_options[option_index].name, "raw")) {
+                    g_rawTrace = true;
                 } else if (!strcmp(long_options[option_index].name, "list_categories")) {
                     listSupportedCategories();
                     exit(0);
@@ -1305,6 +1483,11 @@ int main(int argc, char **argv)
         }
     }
 
+    if (g_rawTrace && g_compress) {
+        fprintf(stderr, "--raw can't be used with -z\n");
+        exit(1);
+    }
+
     if (onlyUserspace) {
         if (!async || !(traceStart || traceStop)) {
             fprintf(stderr, "--only_userspace can only be used with "
@@ -1360,7 +1543,11 @@ int main(int argc, char **argv)
         }
 
         if (traceStream) {
-            streamTrace();
+            if (g_rawTrace) {
+                streamRawTrace();
+            } else {
+                streamTrace();
+            }
         }
     }
 
@@ -1380,7 +1567,11 @@ int main(int argc, char **argv)
                 printf("Failed to open '%s', err=%d", g_outputFile, errno);
             } else {
                 dprintf(outFd, "TRACE:\n");
-                dumpTrace(outFd);
+                if (g_rawTrace) {
+                    dumpRawTrace(outFd);
+                } else {
+                    dumpTrace(outFd);
+                }
                 if (g_outputFile) {
                     close(outFd);
                 }
@@ -21,6 +21,8 @@
 #include <array>
 #include <thread>
 
+#include <sys/mman.h>
+
 #include <log/log.h>
 
 #include "dumpstate.h"
@@ -90,14 +92,16 @@ void DumpPool::waitForTask(const std::string& task_name, const std::string& titl
     Future future = iterator->second;
     futures_map_.erase(iterator);
 
-    std::string result = future.get();
-    if (result.empty()) {
+    std::shared_ptr<TmpFile> result = future.get();
+    if (!result) {
         return;
     }
-    DumpFileToFd(out_fd, title, result);
-    if (unlink(result.c_str())) {
-        MYLOGE("Failed to unlink (%s): %s\n", result.c_str(), strerror(errno));
+    if (lseek(result->fd.get(), 0, SEEK_SET) == -1) {
+        MYLOGE("Failed to rewind (%s): %s\n", result->path, strerror(errno));
+        return;
     }
+    DumpFileFromFdToFd(title, result->path, result->fd.get(), out_fd,
+            PropertiesHelper::IsDryRun());
 }
 
 void DumpPool::deleteTempFiles() {
@@ -126,6 +130,13 @@ void DumpPool::invokeTask<std::function<void(int)>>(std::function<void(int)> dum
 
 std::unique_ptr<DumpPool::TmpFile> DumpPool::createTempFile() {
     auto tmp_file_ptr = std::make_unique<TmpFile>();
+    snprintf(tmp_file_ptr->path, sizeof(tmp_file_ptr->path), "memfd:%s",
+             PREFIX_TMPFILE_NAME.c_str());
+    tmp_file_ptr->fd.reset(memfd_create(PREFIX_TMPFILE_NAME.c_str(), MFD_CLOEXEC));
+    if (tmp_file_ptr->fd.get() != -1) {
+        return tmp_file_ptr;
+    }
+
     std::string file_name_format = "%s/" + PREFIX_TMPFILE_NAME + "XXXXXX";
     snprintf(tmp_file_ptr->path, sizeof(tmp_file_ptr->path), file_name_format.c_str(),
              tmp_root_.c_str());
@@ -136,6 +147,9 @@ std::unique_ptr<DumpPool::TmpFile> DumpPool::createTempFile() {
         tmp_file_ptr = nullptr;
         return tmp_file_ptr;
     }
+    if (unlink(tmp_file_ptr->path)) {
+        MYLOGE("Failed to unlink (%s): %s\n", tmp_file_ptr->path, strerror(errno));
+    }
     return tmp_file_ptr;
 }
 
@@ -19,6 +19,7 @@
 
 #include <future>
 #include <map>
+#include <memory>
 #include <queue>
 #include <string>
 
@@ -142,20 +143,23 @@ class DumpPool {
     static const std::string PREFIX_TMPFILE_NAME;
 
   private:
-    using Task = std::packaged_task<std::string()>;
-    using Future = std::shared_future<std::string>;
+    typedef struct {
+      android::base::unique_fd fd;
+      char path[1024];
+    } TmpFile;
+
+    using Task = std::packaged_task<std::shared_ptr<TmpFile>()>;
+    using Future = std::shared_future<std::shared_ptr<TmpFile>>;
 
     template<class T> void invokeTask(T dump_func, const std::string& duration_title, int out_fd);
 
     template<class T> Future post(const std::string& task_name, T dump_func) {
         Task packaged_task([=]() {
-            std::unique_ptr<TmpFile> tmp_file_ptr = createTempFile();
-            if (!tmp_file_ptr) {
-                return std::string("");
+            std::shared_ptr<TmpFile> tmp_file_ptr = createTempFile();
+            if (tmp_file_ptr) {
+                invokeTask(dump_func, task_name, tmp_file_ptr->fd.get());
             }
-            invokeTask(dump_func, task_name, tmp_file_ptr->fd.get());
-            fsync(tmp_file_ptr->fd.get());
-            return std::string(tmp_file_ptr->path);
+            return tmp_file_ptr;
         });
         std::unique_lock lock(lock_);
         auto future = packaged_task.get_future().share();
@@ -164,11 +168,11 @@ class DumpPool {
         return future;
     }
 
-    typedef struct {
-      android::base::unique_fd fd;
-      char path[1024];
-    } TmpFile;
-
+    /*
+     * Creates the file receiving the results of a task. It lives in memory
+     * when possible, or is unlinked from |tmp_root| right away otherwise, so
+     * that it goes away with its last fd.
+     */
     std::unique_ptr<TmpFile> createTempFile();
     void deleteTempFiles(const std::string& folder);
     void setThreadName(const pthread_t thread, int id);
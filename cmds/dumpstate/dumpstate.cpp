@@ -230,6 +230,7 @@ static const std::string DUMP_INCIDENT_REPORT_TASK = "INCIDENT REPORT";
 static const std::string DUMP_HALS_TASK = "DUMP HALS";
 static const std::string DUMP_BOARD_TASK = "dumpstate_board()";
 static const std::string DUMP_CHECKINS_TASK = "DUMP CHECKINS";
+static const std::string DUMP_MEMORY_RANKS_TASK = "DUMP MEMORY RANKS";
 
 namespace android {
 namespace os {
@@ -819,6 +820,12 @@ static const std::set<std::string> PROBLEMATIC_FILE_EXTENSIONS = {
       ".shb", ".sys", ".vb",  ".vbe", ".vbs", ".vxd", ".wsc", ".wsf", ".wsh"
 };
 
+// List of file extensions of entries that are already compressed, which are stored as they are
+// instead of spending time deflating them again for next to no gain.
+static const std::set<std::string> COMPRESSED_FILE_EXTENSIONS = {
+      ".7z", ".br", ".bz2", ".gz", ".jpg", ".lz4", ".png", ".tgz", ".webp", ".xz", ".zip", ".zst"
+};
+
 status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
                                       std::chrono::milliseconds timeout = 0ms) {
     if (!IsZipping()) {
@@ -827,6 +834,7 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
         return INVALID_OPERATION;
     }
     std::string valid_name = entry_name;
+    size_t flags = ZipWriter::kCompress;
 
     // Rename extension if necessary.
     size_t idx = entry_name.rfind('.');
@@ -837,11 +845,14 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
             valid_name = entry_name + ".renamed";
             MYLOGI("Renaming entry %s to %s\n", entry_name.c_str(), valid_name.c_str());
         }
+        if (COMPRESSED_FILE_EXTENSIONS.count(extension) != 0) {
+            flags = 0;
+        }
     }
 
     // Logging statement  below is useful to time how long each entry takes, but it's too verbose.
     // MYLOGD("Adding zip entry %s\n", entry_name.c_str());
-    int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), ZipWriter::kCompress,
+    int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), flags,
                                                   get_mtime(fd, ds.now_));
     if (err != 0) {
         MYLOGE("zip_writer_->StartEntryWithTime(%s): %s\n", valid_name.c_str(),
@@ -1519,6 +1530,19 @@ static void DumpstateLimitedOnly() {
     printf("========================================================\n");
 }
 
+/*
+ * Runs procrank and librank one after the other, as both walk the smaps of
+ * every process and would only slow each other down.
+ *
+ * |out_fd| A fd to support the DumpPool to output results to a temporary file.
+ * Dumpstate can pick up later and output to the bugreport. Using STDOUT_FILENO
+ * if it's not running in the parallel task.
+ */
+static void DumpMemoryRanks(int out_fd = STDOUT_FILENO) {
+    RunCommand("PROCRANK", {"procrank"}, AS_ROOT_20, false, out_fd);
+    RunCommand("LIBRANK", {"librank"}, CommandOptions::AS_ROOT, false, out_fd);
+}
+
 /*
  * |out_fd| A fd to support the DumpPool to output results to a temporary file.
  * Dumpstate can pick up later and output to the bugreport. Using STDOUT_FILENO
@@ -1596,9 +1620,10 @@ static Dumpstate::RunStatus dumpstate() {
     // Enqueue slow functions into the thread pool, if the parallel run is enabled.
     if (ds.dump_pool_) {
         // Pool was shutdown in DumpstateDefaultAfterCritical method in order to
-        // drop root user. Restarts it with two threads for the parallel run.
-        ds.dump_pool_->start(/* thread_counts = */2);
+        // drop root user. Restarts it with three threads for the parallel run.
+        ds.dump_pool_->start(/* thread_counts = */3);
 
+        ds.dump_pool_->enqueueTaskWithFd(DUMP_MEMORY_RANKS_TASK, &DumpMemoryRanks, _1);
         ds.dump_pool_->enqueueTaskWithFd(DUMP_HALS_TASK, &DumpHals, _1);
         ds.dump_pool_->enqueueTask(DUMP_INCIDENT_REPORT_TASK, &DumpIncidentReport);
         ds.dump_pool_->enqueueTaskWithFd(DUMP_BOARD_TASK, &Dumpstate::DumpstateBoard, &ds, _1);
@@ -1615,8 +1640,6 @@ static Dumpstate::RunStatus dumpstate() {
     RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
                             "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"});
 
-    RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunCommand, "PROCRANK", {"procrank"}, AS_ROOT_20);
-
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(DumpVisibleWindowViews);
 
     DumpFile("VIRTUAL MEMORY STATS", "/proc/vmstat");
@@ -1633,8 +1656,11 @@ static Dumpstate::RunStatus dumpstate() {
     RunCommand("PROCESSES AND THREADS",
                {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"});
 
-    RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunCommand, "LIBRANK", {"librank"},
-                                         CommandOptions::AS_ROOT);
+    if (ds.dump_pool_) {
+        WAIT_TASK_WITH_CONSENT_CHECK(DUMP_MEMORY_RANKS_TASK, ds.dump_pool_);
+    } else {
+        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(DumpMemoryRanks);
+    }
 
     if (ds.dump_pool_) {
         WAIT_TASK_WITH_CONSENT_CHECK(DUMP_HALS_TASK, ds.dump_pool_);
@@ -2499,12 +2525,23 @@ static bool PrepareToWriteToFile() {
         ds.tmp_path_.c_str(), ds.screenshot_path_.c_str());
 
     ds.path_ = ds.GetPath(ds.CalledByApi() ? "-zip.tmp" : ".zip");
-    MYLOGD("Creating initial .zip file (%s)\n", ds.path_.c_str());
-    create_parent_dirs(ds.path_.c_str());
-    ds.zip_file.reset(fopen(ds.path_.c_str(), "wb"));
-    if (ds.zip_file == nullptr) {
-        MYLOGE("fopen(%s, 'wb'): %s\n", ds.path_.c_str(), strerror(errno));
-        return false;
+    if (ds.options_->stream_to_socket) {
+        // The socket is not seekable, so ZipWriter follows each entry with a data descriptor
+        // rather than going back to its header, and the client gets the entries as they finish.
+        MYLOGD("Streaming .zip file to the control socket\n");
+        ds.zip_file.reset(fdopen(dup(ds.control_socket_fd_), "wb"));
+        if (ds.zip_file == nullptr) {
+            MYLOGE("fdopen(control socket, 'wb'): %s\n", strerror(errno));
+            return false;
+        }
+    } else {
+        MYLOGD("Creating initial .zip file (%s)\n", ds.path_.c_str());
+        create_parent_dirs(ds.path_.c_str());
+        ds.zip_file.reset(fopen(ds.path_.c_str(), "wb"));
+        if (ds.zip_file == nullptr) {
+            MYLOGE("fopen(%s, 'wb'): %s\n", ds.path_.c_str(), strerror(errno));
+            return false;
+        }
     }
     ds.zip_writer_.reset(new ZipWriter(ds.zip_file.get()));
     ds.AddTextZipEntry("version.txt", ds.version_);
@@ -2528,7 +2565,8 @@ static void FinalizeFile() {
     }
 
     if (ds.options_->stream_to_socket) {
-        android::os::CopyFileToFd(ds.path_, ds.control_socket_fd_);
+        // Already streamed; closing the file ends the stream even if the zip wasn't finished.
+        ds.zip_file.reset(nullptr);
     } else if (ds.options_->progress_updates_to_socket) {
         if (do_text_file) {
             dprintf(ds.control_socket_fd_,
@@ -2876,7 +2914,7 @@ Dumpstate::RunStatus Dumpstate::RunInternal(int32_t calling_uid,
         Vibrate(150);
     }
 
-    if (zip_file != nullptr) {
+    if (zip_file != nullptr && !options_->stream_to_socket) {
         if (chown(path_.c_str(), AID_SHELL, AID_SHELL)) {
             MYLOGE("Unable to change ownership of zip file %s: %s\n", path_.c_str(),
                     strerror(errno));
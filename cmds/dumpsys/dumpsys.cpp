@@ -16,6 +16,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <deque>
+#include <future>
 #include <iomanip>
 #include <thread>
 
@@ -25,6 +27,7 @@
 #include <binder/Parcel.h>
 #include <binder/ProcessState.h>
 #include <binder/TextOutput.h>
+#include <binder/TransactionLatencyStats.h>
 #include <binderdebug/BinderDebug.h>
 #include <serviceutils/PriorityDumper.h>
 #include <utils/Log.h>
@@ -36,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -61,15 +65,20 @@ static void usage() {
             "usage: dumpsys\n"
             "         To dump all services.\n"
             "or:\n"
-            "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--pid] [--thread] [--help | -l | "
+            "       dumpsys [-t TIMEOUT] [-j JOBS] [--priority LEVEL] [--pid] [--thread] "
+            "[--latency] "
+            "[--help | -l | "
             "--skip SERVICES "
             "| SERVICE [ARGS]]\n"
             "         --help: shows this help\n"
             "         -l: only list services, do not dump them\n"
             "         -t TIMEOUT_SEC: TIMEOUT to use in seconds instead of default 10 seconds\n"
             "         -T TIMEOUT_MS: TIMEOUT to use in milliseconds instead of default 10 seconds\n"
+            "         -j JOBS: dump up to JOBS services at the same time, keeping their order\n"
             "         --pid: dump PID instead of usual dump\n"
             "         --thread: dump thread usage instead of usual dump\n"
+            "         --latency: dump binder transaction latencies recorded by the process\n"
+            "               instead of usual dump\n"
             "         --proto: filter services that support dumping data in proto format. Dumps\n"
             "               will be in proto format.\n"
             "         --priority LEVEL: filter services based on specified priority\n"
@@ -127,9 +136,11 @@ int Dumpsys::main(int argc, char* const argv[]) {
     bool asProto = false;
     Type type = Type::DUMP;
     int timeoutArgMs = 10000;
+    int jobs = 1;
     int priorityFlags = IServiceManager::DUMP_FLAG_PRIORITY_ALL;
     static struct option longOptions[] = {{"thread", no_argument, 0, 0},
                                           {"pid", no_argument, 0, 0},
+                                          {"latency", no_argument, 0, 0},
                                           {"priority", required_argument, 0, 0},
                                           {"proto", no_argument, 0, 0},
                                           {"skip", no_argument, 0, 0},
@@ -143,7 +154,7 @@ int Dumpsys::main(int argc, char* const argv[]) {
         int c;
         int optionIndex = 0;
 
-        c = getopt_long(argc, argv, "+t:T:l", longOptions, &optionIndex);
+        c = getopt_long(argc, argv, "+t:T:j:l", longOptions, &optionIndex);
 
         if (c == -1) {
             break;
@@ -169,6 +180,8 @@ int Dumpsys::main(int argc, char* const argv[]) {
                 type = Type::PID;
             } else if (!strcmp(longOptions[optionIndex].name, "thread")) {
                 type = Type::THREAD;
+            } else if (!strcmp(longOptions[optionIndex].name, "latency")) {
+                type = Type::LATENCY;
             }
             break;
 
@@ -195,6 +208,17 @@ int Dumpsys::main(int argc, char* const argv[]) {
             }
             break;
 
+        case 'j':
+            {
+                char* endptr;
+                jobs = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || jobs <= 0) {
+                    fprintf(stderr, "Error: invalid number of jobs: '%s'\n", optarg);
+                    return -1;
+                }
+            }
+            break;
+
         case 'l':
             showListOnly = true;
             break;
@@ -254,6 +278,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
         return 0;
     }
 
+    if (jobs > 1 && N > 1) {
+        Vector<String16> servicesToDump;
+        for (const auto& serviceName : services) {
+            if (!IsSkipped(skippedServices, serviceName)) {
+                servicesToDump.add(serviceName);
+            }
+        }
+        dumpServicesConcurrently(type, servicesToDump, args, priorityFlags,
+                                 std::chrono::milliseconds(timeoutArgMs), asProto, jobs);
+        return 0;
+    }
+
     for (size_t i = 0; i < N; i++) {
         const String16& serviceName = services[i];
         if (IsSkipped(skippedServices, serviceName)) continue;
@@ -287,6 +323,70 @@ int Dumpsys::main(int argc, char* const argv[]) {
     return 0;
 }
 
+void Dumpsys::dumpServicesConcurrently(Type type, const Vector<String16>& services,
+                                       const Vector<String16>& args, int priorityFlags,
+                                       std::chrono::milliseconds timeout, bool asProto,
+                                       size_t jobs) {
+    struct ServiceDump {
+        status_t status = UNKNOWN_ERROR;
+        unique_fd fd;
+        std::chrono::duration<double> elapsedDuration{0};
+    };
+
+    // Each dump goes through its own Dumpsys, which redirects the service into a buffer.
+    auto dump = [=](const String16& serviceName) {
+        ServiceDump result;
+        result.fd.reset(memfd_create("dumpsys", MFD_CLOEXEC));
+        if (result.fd == -1) {
+            std::cerr << "Failed to create buffer to dump service " << serviceName << ": "
+                      << strerror(errno) << std::endl;
+            return result;
+        }
+        Dumpsys dumpsys(sm_);
+        result.status = dumpsys.startDumpThread(type, serviceName, args);
+        if (result.status == OK) {
+            size_t bytesWritten = 0;
+            result.status = dumpsys.writeDump(result.fd.get(), serviceName, timeout, asProto,
+                                              result.elapsedDuration, bytesWritten);
+            dumpsys.stopDumpThread(/* dumpComplete = */ result.status == OK);
+        } else {
+            result.fd.reset();
+        }
+        return result;
+    };
+
+    std::deque<std::future<ServiceDump>> pending;
+    for (size_t next = 0, written = 0; written < services.size();) {
+        if (next < services.size() && pending.size() < jobs) {
+            pending.push_back(std::async(std::launch::async, dump, services[next++]));
+            continue;
+        }
+
+        const String16& serviceName = services[written++];
+        ServiceDump result = pending.front().get();
+        pending.pop_front();
+        if (result.fd == -1) {
+            continue;
+        }
+        writeDumpHeader(STDOUT_FILENO, serviceName, priorityFlags);
+        char buf[4096];
+        ssize_t rc;
+        lseek(result.fd.get(), 0, SEEK_SET);
+        while ((rc = TEMP_FAILURE_RETRY(read(result.fd.get(), buf, sizeof(buf)))) > 0) {
+            if (!WriteFully(STDOUT_FILENO, buf, rc)) {
+                break;
+            }
+        }
+        if (result.status == TIMED_OUT) {
+            std::cout << std::endl
+                      << "*** SERVICE '" << serviceName << "' DUMP TIMEOUT (" << timeout.count()
+                      << "ms) EXPIRED ***" << std::endl
+                      << std::endl;
+        }
+        writeDumpFooter(STDOUT_FILENO, serviceName, result.elapsedDuration);
+    }
+}
+
 Vector<String16> Dumpsys::listServices(int priorityFilterFlags, bool filterByProto) const {
     Vector<String16> services = sm_->listServices(priorityFilterFlags);
     services.sort(sort_func);
@@ -352,6 +452,20 @@ static status_t dumpThreadsToFd(const sp<IBinder>& service, const unique_fd& fd)
     return OK;
 }
 
+static status_t dumpLatencyToFd(const sp<IBinder>& service, const unique_fd& fd) {
+    TransactionLatencyStats stats;
+    status_t status = service->getTransactionLatencyStats(&stats);
+    if (status != OK) {
+        return status;
+    }
+    std::string out = stats.toString();
+    if (out.empty()) {
+        out = "No transaction latencies recorded.\n";
+    }
+    WriteStringToFd(out, fd.get());
+    return OK;
+}
+
 status_t Dumpsys::startDumpThread(Type type, const String16& serviceName,
                                   const Vector<String16>& args) {
     sp<IBinder> service = sm_->checkService(serviceName);
@@ -385,6 +499,9 @@ status_t Dumpsys::startDumpThread(Type type, const String16& serviceName,
         case Type::THREAD:
             err = dumpThreadsToFd(service, remote_end);
             break;
+        case Type::LATENCY:
+            err = dumpLatencyToFd(service, remote_end);
+            break;
         default:
             std::cerr << "Unknown dump type" << static_cast<int>(type) << std::endl;
             return;
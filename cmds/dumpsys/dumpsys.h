@@ -17,6 +17,7 @@
 #ifndef FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 #define FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 
+#include <chrono>
 #include <thread>
 
 #include <android-base/unique_fd.h>
@@ -55,6 +56,7 @@ class Dumpsys {
         DUMP,    // dump using `dump` function
         PID,     // dump pid of server only
         THREAD,  // dump thread usage of server only
+        LATENCY, // dump transaction latencies recorded by server only
     };
 
     /**
@@ -123,6 +125,15 @@ class Dumpsys {
     }
 
   private:
+    /**
+     * Dumps services on up to {@code jobs} threads at a time, each into its own buffer, and
+     * writes the dumps to stdout in the order of {@code services} as they complete.
+     * Each service gets the whole {@code timeout}, counted from the start of its own dump.
+     */
+    void dumpServicesConcurrently(Type type, const Vector<String16>& services,
+                                  const Vector<String16>& args, int priorityFlags,
+                                  std::chrono::milliseconds timeout, bool asProto, size_t jobs);
+
     android::IServiceManager* sm_;
     std::thread activeThread_;
     mutable android::base::unique_fd redirectFd_;
@@ -447,6 +447,28 @@ TEST_F(DumpsysTest, DumpMultipleServices) {
     AssertDumped("running3", "dump3");
 }
 
+// Tests 'dumpsys -j 2', which should dump the services in order while running two at a time
+TEST_F(DumpsysTest, DumpMultipleServicesConcurrently) {
+    ExpectListServices({"running1", "stopped2", "running3", "running4"});
+    sp<BinderMock> binder_mock = ExpectDumpAndHang("running1", 1, "dump1");
+    ExpectCheckService("stopped2", false);
+    ExpectDump("running3", "dump3");
+    ExpectDump("running4", "dump4");
+
+    CallMain({"-j", "2", "-T", "500"});
+
+    AssertRunningServices({"running1", "running3", "running4"});
+    AssertOutputContains("SERVICE 'running1' DUMP TIMEOUT (500ms) EXPIRED");
+    AssertNotDumped("dump1");
+    AssertStopped("stopped2");
+    AssertOutputFormat("(.|\n)*DUMP OF SERVICE running1:(.|\n)*"
+                       "DUMP OF SERVICE running3:\ndump3(.|\n)*"
+                       "DUMP OF SERVICE running4:\ndump4(.|\n)*");
+
+    // TODO(b/65056227): BinderMock is not destructed because thread is detached on dumpsys.cpp
+    Mock::AllowLeak(binder_mock.get());
+}
+
 // Tests 'dumpsys --skip skipped3 skipped5', which should skip these services
 TEST_F(DumpsysTest, DumpWithSkip) {
     ExpectListServices({"running1", "stopped2", "skipped3", "running4", "skipped5"});
@@ -606,6 +628,15 @@ TEST_F(DumpsysTest, ListServiceWithThread) {
     AssertOutputFormat(format);
 }
 
+// Tests 'dumpsys --latency service_name'
+TEST_F(DumpsysTest, ListServiceWithLatency) {
+    ExpectCheckService("Locksmith");
+
+    CallMain({"--latency", "Locksmith"});
+    // nothing is recorded unless the process has enabled tracking
+    AssertOutput("No transaction latencies recorded.\n");
+}
+
 TEST_F(DumpsysTest, GetBytesWritten) {
     const char* serviceName = "service2";
     const char* dumpContents = "dump1";
@@ -66,6 +66,11 @@ std::string CacheItem::buildPath() {
     return res;
 }
 
+void CacheItem::detach() {
+    mName = buildPath();
+    mParent = nullptr;
+}
+
 int CacheItem::purge() {
     int res = 0;
     auto path = buildPath();
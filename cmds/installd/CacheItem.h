@@ -42,6 +42,12 @@ public:
     std::string toString();
     std::string buildPath();
 
+    /**
+     * Resolves the path of this item so that it no longer refers to its
+     * parents, which may then be deleted.
+     */
+    void detach();
+
     int purge();
 
     short level;
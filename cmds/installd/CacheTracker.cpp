@@ -18,6 +18,7 @@
 
 #include "CacheTracker.h"
 
+#include <algorithm>
 #include <fts.h>
 #include <sys/xattr.h>
 #include <utils/Trace.h>
@@ -36,9 +37,11 @@ namespace installd {
 CacheTracker::CacheTracker(userid_t userId, appid_t appId, const std::string& uuid)
       : cacheUsed(0),
         cacheQuota(0),
+        purgeFailed(false),
         mUserId(userId),
         mAppId(appId),
         mItemsLoaded(false),
+        mHasMoreItems(false),
         mUuid(uuid) {
 }
 
@@ -94,7 +97,32 @@ bool CacheTracker::loadQuotaStats() {
     }
 }
 
-void CacheTracker::loadItemsFrom(const std::string& path) {
+namespace {
+
+// Order of the items in CacheTracker::items, which are purged from the back
+bool sortsBefore(const std::shared_ptr<CacheItem>& left,
+        const std::shared_ptr<CacheItem>& right) {
+    // TODO: sort dotfiles last
+    // TODO: sort code_cache last
+    if (left->modified != right->modified) {
+        return (left->modified > right->modified);
+    }
+    if (left->level != right->level) {
+        return (left->level < right->level);
+    }
+    return left->directory && !right->directory;
+}
+
+// Heap order of the purge candidates: the front is the last one to purge
+bool purgedBefore(const std::shared_ptr<CacheItem>& left,
+        const std::shared_ptr<CacheItem>& right) {
+    return sortsBefore(right, left);
+}
+
+}  // namespace
+
+void CacheTracker::loadItemsFrom(const std::string& path, size_t maxItems,
+        std::vector<std::shared_ptr<CacheItem>>* candidates) {
     FTS *fts;
     FTSENT *p;
     char *argv[] = { (char*) path.c_str(), nullptr };
@@ -112,9 +140,14 @@ void CacheTracker::loadItemsFrom(const std::string& path) {
         case FTS_F:
         case FTS_SL:
         case FTS_SLNONE: {
-            auto item = std::shared_ptr<CacheItem>(new CacheItem(p));
-            p->fts_pointer = static_cast<void*>(item.get());
-            items.push_back(item);
+            if (maxItems == 0) {
+                auto item = std::shared_ptr<CacheItem>(new CacheItem(p));
+                p->fts_pointer = static_cast<void*>(item.get());
+                items.push_back(item);
+            } else {
+                // Owned by the walk until the item is complete, see below
+                p->fts_pointer = static_cast<void*>(new CacheItem(p));
+            }
         }
         }
 
@@ -155,43 +188,67 @@ void CacheTracker::loadItemsFrom(const std::string& path) {
             if (parent) {
                 parent->modified = std::max(parent->modified, item->modified);
             }
+
+            // The item is complete, since all its children have been
+            // visited: keep it only if it is one of the first to purge. The
+            // kept items are detached, as their parents are deleted once
+            // complete in turn.
+            if (maxItems != 0) {
+                auto candidate = std::shared_ptr<CacheItem>(item);
+                p->fts_pointer = nullptr;
+                if (candidates->size() < maxItems) {
+                    candidate->detach();
+                    candidates->push_back(candidate);
+                    std::push_heap(candidates->begin(), candidates->end(), purgedBefore);
+                } else if (purgedBefore(candidate, candidates->front())) {
+                    candidate->detach();
+                    std::pop_heap(candidates->begin(), candidates->end(), purgedBefore);
+                    candidates->back() = candidate;
+                    std::push_heap(candidates->begin(), candidates->end(), purgedBefore);
+                    mHasMoreItems = true;
+                } else {
+                    mHasMoreItems = true;
+                }
+            }
         }
         }
     }
     fts_close(fts);
 }
 
-void CacheTracker::loadItems() {
+void CacheTracker::loadItems(size_t maxItems) {
     items.clear();
+    mHasMoreItems = false;
 
     ATRACE_BEGIN("loadItems");
+    std::vector<std::shared_ptr<CacheItem>> candidates;
     for (const auto& path : mDataPaths) {
-        loadItemsFrom(read_path_inode(path, "cache", kXattrInodeCache));
-        loadItemsFrom(read_path_inode(path, "code_cache", kXattrInodeCodeCache));
+        loadItemsFrom(read_path_inode(path, "cache", kXattrInodeCache), maxItems, &candidates);
+        loadItemsFrom(read_path_inode(path, "code_cache", kXattrInodeCodeCache), maxItems,
+                &candidates);
     }
+    if (mHasMoreItems) {
+        // Don't look for more items once only empty ones are found, like the
+        // tombstones truncated before, as purging them frees nothing.
+        int64_t size = 0;
+        for (const auto& item : candidates) {
+            size += item->size;
+        }
+        mHasMoreItems = (size > 0);
+    }
+    items.insert(items.end(), candidates.begin(), candidates.end());
     ATRACE_END();
 
     ATRACE_BEGIN("sortItems");
-    auto cmp = [](std::shared_ptr<CacheItem> left, std::shared_ptr<CacheItem> right) {
-        // TODO: sort dotfiles last
-        // TODO: sort code_cache last
-        if (left->modified != right->modified) {
-            return (left->modified > right->modified);
-        }
-        if (left->level != right->level) {
-            return (left->level < right->level);
-        }
-        return left->directory;
-    };
-    std::stable_sort(items.begin(), items.end(), cmp);
+    std::stable_sort(items.begin(), items.end(), sortsBefore);
     ATRACE_END();
 }
 
-void CacheTracker::ensureItems() {
+void CacheTracker::ensureItems(size_t maxItems) {
     if (mItemsLoaded) {
         return;
     } else {
-        loadItems();
+        loadItems(maxItems);
         mItemsLoaded = true;
     }
 }
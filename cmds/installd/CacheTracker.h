@@ -47,27 +47,46 @@ public:
     void addDataPath(const std::string& dataPath);
 
     void loadStats();
-    void loadItems();
 
-    void ensureItems();
+    /**
+     * Loads the items to purge, sorted so that the next one to purge is at
+     * the back. When maxItems isn't 0, only the first maxItems items to purge
+     * are kept, and hasMoreItems() tells whether others were left out: they
+     * are found by loading the items again once these have been purged.
+     */
+    void loadItems(size_t maxItems = 0);
+
+    void ensureItems(size_t maxItems = 0);
+
+    bool hasMoreItems() const { return mHasMoreItems; }
 
     int getCacheRatio();
 
     int64_t cacheUsed;
     int64_t cacheQuota;
 
+    /* Whether purging one of the items failed */
+    bool purgeFailed;
+
     std::vector<std::shared_ptr<CacheItem>> items;
 
 private:
     userid_t mUserId;
     appid_t mAppId;
     bool mItemsLoaded;
+    bool mHasMoreItems;
     const std::string& mUuid;
 
     std::vector<std::string> mDataPaths;
 
     bool loadQuotaStats();
-    void loadItemsFrom(const std::string& path);
+
+    /**
+     * Adds the items found under path to items, or to the heap of at most
+     * maxItems candidates when maxItems isn't 0.
+     */
+    void loadItemsFrom(const std::string& path, size_t maxItems,
+            std::vector<std::shared_ptr<CacheItem>>* candidates);
 
     DISALLOW_COPY_AND_ASSIGN(CacheTracker);
 };
@@ -53,7 +53,6 @@
 #include <cutils/properties.h>
 #include <cutils/sched_policy.h>
 #include <log/log.h>               // TODO: Move everything to base/logging.
-#include <logwrap/logwrap.h>
 #include <private/android_filesystem_config.h>
 #include <private/android_projectid_config.h>
 #include <selinux/android.h>
@@ -88,7 +87,6 @@ static constexpr const char* kTestUuid = "TEST";
 
 static constexpr const mode_t kRollbackFolderMode = 0700;
 
-static constexpr const char* kCpPath = "/system/bin/cp";
 static constexpr const char* kXattrDefault = "user.default";
 
 static constexpr const char* kDataMirrorCePath = "/data_mirror/data_ce";
@@ -107,6 +105,23 @@ static constexpr size_t kSha256Size = 32;
 static constexpr const char* kPropApkVerityMode = "ro.apk_verity.mode";
 static constexpr const char* kFuseProp = "persist.sys.fuse";
 
+// Maximum number of threads measuring directory trees at the same time when quotas can't be
+// used. The trees are walked with one lstat per node, so several walks keep the storage busy.
+static constexpr size_t kMaxMeasureThreads = 4;
+
+// Maximum number of threads copying the files of app code and data trees at the same time.
+static constexpr size_t kMaxCopyThreads = 4;
+
+// Maximum number of cache items of an app loaded at once by freeCache. The next ones are found
+// by walking the app cache again once these are purged.
+static constexpr size_t kMaxCacheItemsPerRound = 65536;
+
+// Property limiting the number of dexopt calls running dex2oat at the same time, capped at
+// kMaxDex2oatJobs. It is read for each job, so that the framework can lower it when the device
+// gets hot or the battery low.
+static constexpr const char* kDex2oatMaxJobsProp = "dalvik.vm.dex2oat-max-jobs";
+static constexpr size_t kMaxDex2oatJobs = 8;
+
 /**
  * Property to control if app data isolation is enabled.
  */
@@ -894,19 +909,8 @@ binder::Status InstalldNativeService::fixupAppData(const std::optional<std::stri
 }
 
 static int32_t copy_directory_recursive(const char* from, const char* to) {
-    char *argv[] = {
-        (char*) kCpPath,
-        (char*) "-F", /* delete any existing destination file first (--remove-destination) */
-        (char*) "-p", /* preserve timestamps, ownership, and permissions */
-        (char*) "-R", /* recurse into subdirectories (DEST must be a directory) */
-        (char*) "-P", /* Do not follow symlinks [default] */
-        (char*) "-d", /* don't dereference symlinks */
-        (char*) from,
-        (char*) to
-    };
-
     LOG(DEBUG) << "Copying " << from << " to " << to;
-    return logwrap_fork_execvp(ARRAY_SIZE(argv), argv, nullptr, false, LOG_ALOG, false, nullptr);
+    return copy_tree(from, to, kMaxCopyThreads);
 }
 
 binder::Status InstalldNativeService::snapshotAppData(
@@ -1429,13 +1433,24 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         };
         std::priority_queue<std::shared_ptr<CacheTracker>,
                 std::vector<std::shared_ptr<CacheTracker>>, decltype(cmp)> queue(cmp);
+        std::vector<std::shared_ptr<CacheTracker>> trackerList;
         for (const auto& it : trackers) {
-            it.second->loadStats();
-            queue.push(it.second);
-            cacheTotal += it.second->cacheUsed;
+            trackerList.push_back(it.second);
+        }
+        run_in_parallel(trackerList.size(), kMaxMeasureThreads, [&](size_t i) {
+            trackerList[i]->loadStats();
+        });
+        for (const auto& tracker : trackerList) {
+            queue.push(tracker);
+            cacheTotal += tracker->cacheUsed;
         }
         ATRACE_END();
 
+        // Only keep a bounded number of items to purge per tracker, and find
+        // the next ones once they are purged. A dry run loads all of them, as
+        // nothing gets purged.
+        const size_t maxItems = noop ? 0 : kMaxCacheItemsPerRound;
+
         // 3. Bounce across the queue, freeing items from whichever tracker is
         // the most over their assigned quota
         ATRACE_BEGIN("bounce");
@@ -1466,21 +1481,26 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                     queue.push(active);
                 }
                 active = queue.top(); queue.pop();
-                active->ensureItems();
+                active->ensureItems(maxItems);
                 continue;
             }
 
-            // If no items remain, go find another tracker
+            // If no items remain, look for more unless we could fail to purge
+            // the same items again, or go find another tracker
             if (active->items.empty()) {
-                active = nullptr;
+                if (active->hasMoreItems() && !active->purgeFailed) {
+                    active->loadItems(maxItems);
+                } else {
+                    active = nullptr;
+                }
                 continue;
             } else {
                 auto item = active->items.back();
                 active->items.pop_back();
 
                 LOG(DEBUG) << "Purging " << item->toString() << " from " << active->toString();
-                if (!noop) {
-                    item->purge();
+                if (!noop && item->purge() != 0) {
+                    active->purgeFailed = true;
                 }
                 active->cacheUsed -= item->size;
                 needed -= item->size;
@@ -1631,7 +1651,9 @@ static void collectQuotaStats(const std::string& uuid, int32_t userId,
     }
 }
 
-static void collectManualStats(const std::string& path, struct stats* stats) {
+
+static void collectManualStats(const std::string& path, struct stats* stats,
+        bool parallel = true) {
     DIR *d;
     int dfd;
     struct dirent *de;
@@ -1644,15 +1666,14 @@ static void collectManualStats(const std::string& path, struct stats* stats) {
         }
         return;
     }
+    // Child directories are measured once the listing is done, so that they can be walked in
+    // parallel.
+    std::vector<std::string> subdirs;
     dfd = dirfd(d);
     while ((de = readdir(d))) {
         const char *name = de->d_name;
 
         int64_t size = 0;
-        if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) == 0) {
-            size = s.st_blocks * 512;
-        }
-
         if (de->d_type == DT_DIR) {
             if (!strcmp(name, ".")) {
                 // Don't recurse, but still count node size
@@ -1661,14 +1682,13 @@ static void collectManualStats(const std::string& path, struct stats* stats) {
                 continue;
             } else {
                 // Measure all children nodes
-                size = 0;
-                calculate_tree_size(StringPrintf("%s/%s", path.c_str(), name), &size);
-            }
-
-            if (!strcmp(name, "cache") || !strcmp(name, "code_cache")) {
-                stats->cacheSize += size;
+                subdirs.push_back(name);
+                continue;
             }
         }
+        if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) == 0) {
+            size = s.st_blocks * 512;
+        }
 
         // Legacy symlink isn't owned by app
         if (de->d_type == DT_LNK && !strcmp(name, "lib")) {
@@ -1679,6 +1699,17 @@ static void collectManualStats(const std::string& path, struct stats* stats) {
         stats->dataSize += size;
     }
     closedir(d);
+
+    std::vector<int64_t> sizes(subdirs.size(), 0);
+    run_in_parallel(subdirs.size(), parallel ? kMaxMeasureThreads : 1, [&](size_t i) {
+        calculate_tree_size(StringPrintf("%s/%s", path.c_str(), subdirs[i].c_str()), &sizes[i]);
+    });
+    for (size_t i = 0; i < subdirs.size(); i++) {
+        if (subdirs[i] == "cache" || subdirs[i] == "code_cache") {
+            stats->cacheSize += sizes[i];
+        }
+        stats->dataSize += sizes[i];
+    }
 }
 
 static void collectManualStatsForUser(const std::string& path, struct stats* stats,
@@ -1695,6 +1726,7 @@ static void collectManualStatsForUser(const std::string& path, struct stats* sta
         }
         return;
     }
+    std::vector<std::string> packageDirs;
     dfd = dirfd(d);
     while ((de = readdir(d))) {
         if (de->d_type == DT_DIR) {
@@ -1708,11 +1740,22 @@ static void collectManualStatsForUser(const std::string& path, struct stats* sta
             } else if (exclude_apps && (user_uid >= AID_APP_START && user_uid <= AID_APP_END)) {
                 continue;
             } else {
-                collectManualStats(StringPrintf("%s/%s", path.c_str(), name), stats);
+                packageDirs.push_back(StringPrintf("%s/%s", path.c_str(), name));
             }
         }
     }
     closedir(d);
+
+    // Measure the packages in parallel, each of them on a single thread.
+    std::vector<struct stats> packageStats(packageDirs.size(), {0, 0, 0});
+    run_in_parallel(packageDirs.size(), kMaxMeasureThreads, [&](size_t i) {
+        collectManualStats(packageDirs[i], &packageStats[i], false /* parallel */);
+    });
+    for (const auto& packageStat : packageStats) {
+        stats->codeSize += packageStat.codeSize;
+        stats->dataSize += packageStat.dataSize;
+        stats->cacheSize += packageStat.cacheSize;
+    }
 }
 
 static void collectManualExternalStatsForUser(const std::string& path, struct stats* stats) {
@@ -2410,6 +2453,21 @@ binder::Status InstalldNativeService::dexopt(const std::string& apkPath, int32_t
     }
     CHECK_ARGUMENT_PATH(outputPath);
     CHECK_ARGUMENT_PATH(dexMetadataPath);
+
+    // Only dex2oat itself runs outside of mLock, so that several calls can compile at once. The
+    // job slot is taken first, as a call waiting for one must not hold mLock: a running job needs
+    // it back to finish.
+    const size_t maxJobs = std::clamp<size_t>(
+            android::base::GetUintProperty<size_t>(kDex2oatMaxJobsProp, 1), 1, kMaxDex2oatJobs);
+    std::unique_lock<std::mutex> jobsLock(mDexoptJobsLock);
+    mDexoptJobsCondition.wait(jobsLock, [&] { return mDexoptJobs < maxJobs; });
+    mDexoptJobs++;
+    jobsLock.unlock();
+    auto jobGuard = android::base::make_scope_guard([this] {
+        std::lock_guard<std::mutex> guard(mDexoptJobsLock);
+        mDexoptJobs--;
+        mDexoptJobsCondition.notify_one();
+    });
     std::lock_guard<std::recursive_mutex> lock(mLock);
 
     const char* oat_dir = getCStr(outputPath);
@@ -2431,7 +2489,8 @@ binder::Status InstalldNativeService::dexopt(const std::string& apkPath, int32_t
     std::string error_msg;
     int res = android::installd::dexopt(apk_path, uid, pkgname, instruction_set, dexoptNeeded,
             oat_dir, dexFlags, compiler_filter, volume_uuid, class_loader_context, se_info,
-            downgrade, targetSdkVersion, profile_name, dm_path, compilation_reason, &error_msg);
+            downgrade, targetSdkVersion, profile_name, dm_path, compilation_reason, &error_msg,
+            &mLock);
     return res ? error(res, error_msg) : ok();
 }
 
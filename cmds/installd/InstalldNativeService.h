@@ -21,6 +21,8 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 
@@ -181,6 +183,11 @@ private:
     std::recursive_mutex mMountsLock;
     std::recursive_mutex mQuotasLock;
 
+    /* Number of dexopt calls running, bounded by the dex2oat job limit */
+    std::mutex mDexoptJobsLock;
+    std::condition_variable mDexoptJobsCondition;
+    size_t mDexoptJobs = 0;
+
     /* Map of all storage mounts from source to target */
     std::unordered_map<std::string, std::string> mStorageMounts;
 
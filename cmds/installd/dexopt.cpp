@@ -29,7 +29,10 @@
 #include <unistd.h>
 
 #include <iomanip>
+#include <mutex>
+#include <unordered_map>
 
+#include <android-base/chrono_utils.h>
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/properties.h>
@@ -557,6 +560,55 @@ class RunProfman : public ExecVHelper {
     std::vector<unique_fd> apk_fds_;
 };
 
+// Identifies the version of a profile file: a file written since has another stamp, unless it
+// was rewritten with the same size within the same modification time.
+struct ProfileStamp {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    int64_t modified_ns;
+
+    bool operator==(const ProfileStamp& other) const {
+        return device == other.device && inode == other.inode && size == other.size &&
+                modified_ns == other.modified_ns;
+    }
+};
+
+// The result of a profman analysis that left the profiles as they were, with their stamps.
+struct UnchangedProfilesAnalysis {
+    std::vector<ProfileStamp> stamps;
+    int result;
+};
+
+// Analyses that left their profiles unchanged, by profile, so that background dexopt doesn't run
+// profman again for packages whose profiles haven't changed since. Bounded since it has an entry
+// for each code path of each package analyzed.
+static constexpr size_t kMaxUnchangedProfilesAnalyses = 4096;
+static std::mutex unchanged_profiles_analyses_lock;
+static std::unordered_map<std::string, UnchangedProfilesAnalysis> unchanged_profiles_analyses;
+
+static bool stat_profiles(const unique_fd& reference_profile_fd,
+        const std::vector<unique_fd>& profiles_fd, /*out*/ std::vector<ProfileStamp>* stamps) {
+    auto add_stamp = [stamps](const unique_fd& fd) {
+        struct stat st;
+        if (fstat(fd.get(), &st) != 0) {
+            return false;
+        }
+        stamps->push_back({st.st_dev, st.st_ino, st.st_size,
+                           st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec});
+        return true;
+    };
+    if (!add_stamp(reference_profile_fd)) {
+        return false;
+    }
+    for (const unique_fd& fd : profiles_fd) {
+        if (!add_stamp(fd)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static int analyze_profiles(uid_t uid, const std::string& package_name,
         const std::string& location, bool is_secondary_dex) {
     std::vector<unique_fd> profiles_fd;
@@ -569,6 +621,20 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
         return PROFILES_ANALYSIS_DONT_OPTIMIZE_EMPTY_PROFILES;
     }
 
+    // profman comes to the same result for the same profiles, as long as it is run the same way.
+    const bool boot_class_path_profiling = IsBootClassPathProfilingEnable();
+    const std::string analysis_key = StringPrintf("%d:%s:%s:%d:%d", uid, package_name.c_str(),
+            location.c_str(), is_secondary_dex, boot_class_path_profiling);
+    std::vector<ProfileStamp> stamps;
+    const bool have_stamps = stat_profiles(reference_profile_fd, profiles_fd, &stamps);
+    if (have_stamps) {
+        std::lock_guard<std::mutex> lock(unchanged_profiles_analyses_lock);
+        auto it = unchanged_profiles_analyses.find(analysis_key);
+        if (it != unchanged_profiles_analyses.end() && it->second.stamps == stamps) {
+            return it->second.result;
+        }
+    }
+
     RunProfman profman_merge;
     const std::vector<unique_fd>& apk_fds = std::vector<unique_fd>();
     const std::vector<std::string>& dex_locations = std::vector<std::string>();
@@ -578,7 +644,7 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
             apk_fds,
             dex_locations,
             /* for_snapshot= */ false,
-            IsBootClassPathProfilingEnable());
+            boot_class_path_profiling);
     pid_t pid = fork();
     if (pid == 0) {
         /* child -- drop privileges before continuing */
@@ -591,6 +657,8 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
     bool empty_profiles = false;
     bool should_clear_current_profiles = false;
     bool should_clear_reference_profile = false;
+    // Whether profman left the profiles as they were, so that its result holds until they change.
+    bool profiles_unchanged = false;
     if (!WIFEXITED(return_code)) {
         LOG(WARNING) << "profman failed for location " << location << ": " << return_code;
     } else {
@@ -605,12 +673,14 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
                 need_to_compile = false;
                 should_clear_current_profiles = false;
                 should_clear_reference_profile = false;
+                profiles_unchanged = true;
                 break;
             case PROFMAN_BIN_RETURN_CODE_SKIP_COMPILATION_EMPTY_PROFILES:
                 need_to_compile = false;
                 empty_profiles = true;
                 should_clear_current_profiles = false;
                 should_clear_reference_profile = false;
+                profiles_unchanged = true;
                 break;
             case PROFMAN_BIN_RETURN_CODE_BAD_PROFILES:
                 LOG(WARNING) << "Bad profiles for location " << location;
@@ -662,6 +732,18 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
     } else {
         result = PROFILES_ANALYSIS_DONT_OPTIMIZE_SMALL_DELTA;
     }
+
+    if (have_stamps) {
+        std::lock_guard<std::mutex> lock(unchanged_profiles_analyses_lock);
+        if (profiles_unchanged) {
+            if (unchanged_profiles_analyses.size() >= kMaxUnchangedProfilesAnalyses) {
+                unchanged_profiles_analyses.clear();
+            }
+            unchanged_profiles_analyses[analysis_key] = {std::move(stamps), result};
+        } else {
+            unchanged_profiles_analyses.erase(analysis_key);
+        }
+    }
     return result;
 }
 
@@ -1670,11 +1752,21 @@ static std::string format_dexopt_error(int status, const char* dex_path) {
   return StringPrintf("Dex2oat invocation for %s failed with 0x%04x", dex_path, status);
 }
 
+// Returns the size of a dexopt artifact, or 0 if it wasn't generated.
+static int64_t get_artifact_size(const UniqueFile& file) {
+    struct stat st;
+    if (file.fd() < 0 || fstat(file.fd(), &st) != 0) {
+        return 0;
+    }
+    return st.st_size;
+}
+
 int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* instruction_set,
         int dexopt_needed, const char* oat_dir, int dexopt_flags, const char* compiler_filter,
         const char* volume_uuid, const char* class_loader_context, const char* se_info,
         bool downgrade, int target_sdk_version, const char* profile_name,
-        const char* dex_metadata_path, const char* compilation_reason, std::string* error_msg) {
+        const char* dex_metadata_path, const char* compilation_reason, std::string* error_msg,
+        std::recursive_mutex* dex2oat_unlocked) {
     CHECK(pkgname != nullptr);
     CHECK(pkgname[0] != 0);
     CHECK(error_msg != nullptr);
@@ -1849,6 +1941,12 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
                       use_jitzygote_image,
                       compilation_reason);
 
+    // Let other calls go on while dex2oat runs. The outputs are only committed once the lock is
+    // taken again.
+    if (dex2oat_unlocked != nullptr) {
+        dex2oat_unlocked->unlock();
+    }
+    android::base::Timer timer;
     pid_t pid = fork();
     if (pid == 0) {
         // Need to set schedpolicy before dropping privileges
@@ -1867,8 +1965,17 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
         runner.Exec(DexoptReturnCodes::kDex2oatExec);
     } else {
         int res = wait_child(pid);
+        if (dex2oat_unlocked != nullptr) {
+            dex2oat_unlocked->lock();
+        }
         if (res == 0) {
             LOG(VERBOSE) << "DexInv: --- END '" << dex_path << "' (success) ---";
+            LOG(INFO) << "dex2oat of " << dex_path << " (" << compiler_filter << ", "
+                      << (compilation_reason != nullptr ? compilation_reason : "unknown")
+                      << ") took " << timer.duration().count() << "ms, oat "
+                      << get_artifact_size(out_oat) << " bytes, vdex "
+                      << get_artifact_size(out_vdex) << " bytes, image "
+                      << get_artifact_size(out_image) << " bytes";
         } else {
             LOG(VERBOSE) << "DexInv: --- END '" << dex_path << "' --- status=0x"
                          << std::hex << std::setw(4) << res << ", process failed";
@@ -392,8 +392,8 @@ private:
         // Create the given path. Use string processing instead of dirname, as dirname's need for
         // a writable char buffer is painful.
 
-        // First, try to use the full path.
-        if (mkdir(path.c_str(), 0711) == 0) {
+        // First, try to use the full path. Jobs running in parallel may race to create it.
+        if (mkdir(path.c_str(), 0711) == 0 || errno == EEXIST) {
             return true;
         }
         if (errno != ENOENT) {
@@ -412,7 +412,7 @@ private:
             return false;
         }
 
-        if (mkdir(path.c_str(), 0711) == 0) {
+        if (mkdir(path.c_str(), 0711) == 0 || errno == EEXIST) {
             return true;
         }
         PLOG(ERROR) << "Could not create " << path;
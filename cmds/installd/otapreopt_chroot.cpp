@@ -14,14 +14,19 @@
  ** limitations under the License.
  */
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <linux/unistd.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <array>
+#include <deque>
 #include <fstream>
+#include <iostream>
+#include <map>
 #include <sstream>
 
 #include <android-base/file.h>
@@ -29,6 +34,7 @@
 #include <android-base/macros.h>
 #include <android-base/scopeguard.h>
 #include <android-base/stringprintf.h>
+#include <android-base/strings.h>
 #include <android-base/unique_fd.h>
 #include <libdm/dm.h>
 #include <selinux/android.h>
@@ -40,7 +46,10 @@
 #define LOG_TAG "otapreopt"
 #endif
 
+using android::base::Join;
+using android::base::ReadFileToString;
 using android::base::StringPrintf;
+using android::base::WriteStringToFile;
 
 namespace android {
 namespace installd {
@@ -113,10 +122,194 @@ static void TryExtraMount(const char* name, const char* slot, const char* target
     UNUSED(mount_result);
 }
 
+// Upper bound on the memory that one otapreopt job, with its dex2oat, is expected to need.
+static constexpr uint64_t kMemoryPerJobBytes = 512 * 1024 * 1024;
+
+// Runs at most one job per two cores, leaving the others to the user of the device, and
+// no more jobs than fit in the memory available.
+static size_t GetMaxParallelJobs() {
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t jobs = cores > 1 ? static_cast<size_t>(cores) / 2 : 1;
+
+    std::string meminfo;
+    if (ReadFileToString("/proc/meminfo", &meminfo)) {
+        const char* available = strstr(meminfo.c_str(), "MemAvailable:");
+        unsigned long long available_kb;
+        if (available != nullptr &&
+            sscanf(available, "MemAvailable: %llu kB", &available_kb) == 1) {
+            jobs = std::min<size_t>(jobs, available_kb * 1024 / kMemoryPerJobBytes);
+        }
+    }
+    return std::max<size_t>(jobs, 1);
+}
+
+// Returns the directory with a marker for each job completed for the build in the chroot, so
+// that a postinstall run that is interrupted and started again skips them. The markers of any
+// other build are removed. Returns an empty string if markers can't be kept.
+static std::string PrepareCompletedJobsDir(const std::string& target_slot) {
+    std::string build_prop;
+    if (!ReadFileToString("/system/build.prop", &build_prop)) {
+        PLOG(WARNING) << "Unable to read /system/build.prop, not keeping completed jobs";
+        return "";
+    }
+    const std::string build = StringPrintf("%zx", std::hash<std::string>{}(build_prop));
+    const std::string ota_dir = StringPrintf("/data/ota/%s", target_slot.c_str());
+    const std::string dir = ota_dir + "/otapreopt_done";
+    const std::string build_file = dir + "/build";
+
+    std::string marked_build;
+    if (ReadFileToString(build_file, &marked_build) && marked_build == build) {
+        return dir;
+    }
+
+    // The markers are all in the directory itself.
+    DIR* old_markers = opendir(dir.c_str());
+    if (old_markers != nullptr) {
+        for (dirent* entry = readdir(old_markers); entry != nullptr;
+             entry = readdir(old_markers)) {
+            if (entry->d_type == DT_REG) {
+                unlinkat(dirfd(old_markers), entry->d_name, 0);
+            }
+        }
+        closedir(old_markers);
+    }
+    if ((mkdir(ota_dir.c_str(), 0711) != 0 && errno != EEXIST) ||
+        (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) ||
+        !WriteStringToFile(build, build_file)) {
+        PLOG(WARNING) << "Unable to set up " << dir << ", not keeping completed jobs";
+        return "";
+    }
+    return dir;
+}
+
+// Forks and executes the given command without waiting for it. Returns the pid of the child, or
+// -1 if the fork failed.
+static pid_t StartJob(const std::vector<std::string>& arg_vector) {
+    std::vector<char*> args;
+    for (const std::string& arg : arg_vector) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // No allocation allowed between fork and exec.
+
+        // Change process groups, so we don't get reaped by ProcessManager.
+        setpgid(0, 0);
+
+        execv(args[0], &args[0]);
+
+        PLOG(ERROR) << "Failed to execv(" << arg_vector[0] << ")";
+        // _exit to avoid atexit handlers in child.
+        _exit(1);
+    }
+    if (pid == -1) {
+        PLOG(ERROR) << "Failed to fork for " << Join(arg_vector, ' ');
+    }
+    return pid;
+}
+
+// Runs the dexopt commands read from stdin, one per line, as otapreopt jobs in parallel. A job
+// that fails is logged and doesn't stop the others.
+//
+// Each line starts with the progress to report once the command on it is done, followed by the
+// dexopt parameters. As jobs finish in any order, the n-th job to finish writes the progress of
+// the n-th line to stdout, so that the progress only grows and counts finished jobs. Returns the
+// number of commands processed.
+static size_t RunJobsFromStdin(const std::string& target_slot) {
+    const size_t max_jobs = GetMaxParallelJobs();
+    const std::string completed_jobs_dir = PrepareCompletedJobsDir(target_slot);
+    LOG(INFO) << "Running up to " << max_jobs << " otapreopt jobs in parallel";
+
+    // The progress of the commands read but not yet done, in the order they were read.
+    std::deque<std::string> pending_progress;
+    size_t processed = 0;
+    auto report_done = [&pending_progress, &processed]() {
+        std::cout << pending_progress.front() << std::endl;
+        pending_progress.pop_front();
+        processed++;
+    };
+
+    // The marker of each running job, by pid. Empty if markers aren't kept.
+    std::map<pid_t, std::string> running_jobs;
+    auto wait_for_job = [&running_jobs, &report_done]() {
+        int status;
+        pid_t pid = TEMP_FAILURE_RETRY(waitpid(-1, &status, 0));
+        if (pid == -1) {
+            PLOG(ERROR) << "waitpid failed with " << running_jobs.size() << " jobs running";
+            for (size_t i = 0; i < running_jobs.size(); i++) {
+                report_done();
+            }
+            running_jobs.clear();
+            return;
+        }
+        auto job = running_jobs.find(pid);
+        if (job == running_jobs.end()) {
+            return;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            LOG(ERROR) << "otapreopt job " << pid << " failed with status " << status;
+        } else if (!job->second.empty() && !WriteStringToFile("", job->second)) {
+            PLOG(WARNING) << "Unable to mark job as completed: " << job->second;
+        }
+        running_jobs.erase(job);
+        report_done();
+    };
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::vector<std::string> params;
+        std::istringstream stream(line);
+        std::string progress;
+        stream >> progress;
+        for (std::string param; stream >> param;) {
+            params.push_back(param);
+        }
+        if (params.empty()) {
+            continue;
+        }
+        pending_progress.push_back(std::move(progress));
+
+        std::string marker;
+        if (!completed_jobs_dir.empty()) {
+            marker = StringPrintf("%s/%zx", completed_jobs_dir.c_str(),
+                                  std::hash<std::string>{}(Join(params, ' ')));
+            if (access(marker.c_str(), F_OK) == 0) {
+                report_done();
+                continue;
+            }
+        }
+
+        while (running_jobs.size() >= max_jobs) {
+            wait_for_job();
+        }
+
+        // Outgoing: cmd + target-slot + dexopt-params
+        std::vector<std::string> cmd{"/system/bin/otapreopt", target_slot};
+        cmd.insert(cmd.end(), params.begin(), params.end());
+        pid_t pid = StartJob(cmd);
+        if (pid != -1) {
+            running_jobs.emplace(pid, std::move(marker));
+        } else {
+            report_done();
+        }
+    }
+
+    while (!running_jobs.empty()) {
+        wait_for_job();
+    }
+    return processed;
+}
+
 // Entry for otapreopt_chroot. Expected parameters are:
 //   [cmd] [status-fd] [target-slot] "dexopt" [dexopt-params]
 // The file descriptor denoted by status-fd will be closed. The rest of the parameters will
 // be passed on to otapreopt in the chroot.
+//
+// Without any dexopt parameters, the chroot is instead set up once for all the dexopt commands
+// read from stdin, one per line, which are run in parallel. See RunJobsFromStdin. The progress
+// is written to stdout as they finish.
 static int otapreopt_chroot(const int argc, char **arg) {
     // Validate arguments
     // We need the command, status channel and target slot, at a minimum.
@@ -124,11 +317,18 @@ static int otapreopt_chroot(const int argc, char **arg) {
         PLOG(ERROR) << "Not enough arguments.";
         exit(208);
     }
+    const bool jobs_from_stdin = argc == 3;
     // Close all file descriptors. They are coming from the caller, we do not want to pass them
     // on across our fork/exec into a different domain.
-    // 1) Default descriptors.
-    CloseDescriptor(STDIN_FILENO);
-    CloseDescriptor(STDOUT_FILENO);
+    // 1) Default descriptors. Commands read from stdin keep it and stdout, where the progress is
+    //    reported, open, but not across exec.
+    if (jobs_from_stdin) {
+        fcntl(STDIN_FILENO, F_SETFD, FD_CLOEXEC);
+        fcntl(STDOUT_FILENO, F_SETFD, FD_CLOEXEC);
+    } else {
+        CloseDescriptor(STDIN_FILENO);
+        CloseDescriptor(STDOUT_FILENO);
+    }
     CloseDescriptor(STDERR_FILENO);
     // 2) The status channel.
     CloseDescriptor(arg[1]);
@@ -315,6 +515,12 @@ static int otapreopt_chroot(const int argc, char **arg) {
 
     // Now go on and run otapreopt.
 
+    if (jobs_from_stdin) {
+        size_t processed = RunJobsFromStdin(arg[2]);
+        LOG(INFO) << "Processed " << processed << " otapreopt commands";
+        return 0;
+    }
+
     // Incoming:  cmd + status-fd + target-slot + cmd...      | Incoming | = argc
     // Outgoing:  cmd             + target-slot + cmd...      | Outgoing | = argc - 1
     std::vector<std::string> cmd;
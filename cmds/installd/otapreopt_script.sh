@@ -58,23 +58,51 @@ PREPARE=$(cmd otadexopt prepare)
 PROGRESS=$(cmd otadexopt progress)
 print -u${STATUS_FD} "global_progress $PROGRESS"
 
-i=0
-while ((i<MAXIMUM_PACKAGES)) ; do
-  DEXOPT_PARAMS=$(cmd otadexopt next)
-
-  /system/bin/otapreopt_chroot $STATUS_FD $TARGET_SLOT_SUFFIX $DEXOPT_PARAMS >&- 2>&-
-
-  PROGRESS=$(cmd otadexopt progress)
-  print -u${STATUS_FD} "global_progress $PROGRESS"
+# Feed the dexopt commands to a single otapreopt_chroot, which sets up the chroot once and runs
+# them in parallel. It keeps a marker for each completed command, so that commands handed out
+# again after an interrupted run are skipped. Each command is preceded by the progress to report
+# once it is done, which otapreopt_chroot writes back as the commands finish.
+PROCESSED=$(
+  i=0
+  while ((i<MAXIMUM_PACKAGES)) ; do
+    DONE=$(cmd otadexopt done)
+    if [ "$DONE" != "OTA incomplete." ] ; then
+      break
+    fi
+
+    DEXOPT_PARAMS=$(cmd otadexopt next)
+    PROGRESS=$(cmd otadexopt progress)
+    echo $PROGRESS $DEXOPT_PARAMS
+    i=$((i+1))
+  done | /system/bin/otapreopt_chroot $STATUS_FD $TARGET_SLOT_SUFFIX 2>&- | {
+    n=0
+    while read -r PROGRESS ; do
+      print -u${STATUS_FD} "global_progress $PROGRESS"
+      n=$((n+1))
+    done
+    echo $n
+  })
+
+# Without the policy to use the pipes, otapreopt_chroot processes no commands. Fall back to one
+# otapreopt_chroot per package, as before.
+if [ "$PROCESSED" = "0" ] ; then
+  i=0
+  while ((i<MAXIMUM_PACKAGES)) ; do
+    DONE=$(cmd otadexopt done)
+    if [ "$DONE" != "OTA incomplete." ] ; then
+      break
+    fi
+
+    DEXOPT_PARAMS=$(cmd otadexopt next)
+    /system/bin/otapreopt_chroot $STATUS_FD $TARGET_SLOT_SUFFIX $DEXOPT_PARAMS >&- 2>&-
+
+    PROGRESS=$(cmd otadexopt progress)
+    print -u${STATUS_FD} "global_progress $PROGRESS"
 
-  DONE=$(cmd otadexopt done)
-  if [ "$DONE" = "OTA incomplete." ] ; then
     sleep 1
     i=$((i+1))
-    continue
-  fi
-  break
-done
+  done
+fi
 
 DONE=$(cmd otadexopt done)
 if [ "$DONE" = "OTA incomplete." ] ; then
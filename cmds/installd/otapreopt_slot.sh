@@ -20,6 +20,8 @@
 
 SLOT_SUFFIX=$(getprop ro.boot.slot_suffix)
 if test -n "$SLOT_SUFFIX" ; then
+  # The markers of the otapreopt jobs completed for this slot are only needed before the reboot.
+  rm -rf /data/ota/$SLOT_SUFFIX/otapreopt_done
   if test -d /data/ota/$SLOT_SUFFIX/dalvik-cache ; then
     log -p i -t otapreopt_slot "Moving A/B artifacts for slot ${SLOT_SUFFIX}."
     OLD_SIZE=$(du -h -s /data/dalvik-cache)
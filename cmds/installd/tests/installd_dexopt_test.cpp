@@ -1154,6 +1154,28 @@ TEST_F(ProfileTest, ProfileMergeOkNoReference) {
     mergePackageProfiles(package_name_, "primary.prof", PROFILES_ANALYSIS_OPTIMIZE);
 }
 
+TEST_F(ProfileTest, ProfileMergeAgainAfterProfilesChange) {
+    LOG(INFO) << "ProfileMergeAgainAfterProfilesChange";
+
+    SetupProfiles(/*setup_ref*/ true);
+    mergePackageProfiles(package_name_, "primary.prof", PROFILES_ANALYSIS_OPTIMIZE);
+
+    // The current profile was merged and cleared, so there is nothing new to compile, whether or
+    // not the analysis runs again.
+    int result;
+    ASSERT_BINDER_SUCCESS(service_->mergeProfiles(kTestAppUid, package_name_, "primary.prof",
+            &result));
+    ASSERT_NE(PROFILES_ANALYSIS_OPTIMIZE, result);
+    int unchanged_result;
+    ASSERT_BINDER_SUCCESS(service_->mergeProfiles(kTestAppUid, package_name_, "primary.prof",
+            &unchanged_result));
+    ASSERT_EQ(result, unchanged_result);
+
+    // New data in the current profile is analyzed again.
+    SetupProfile(cur_profile_, kTestAppUid, kTestAppGid, 0600, 3);
+    mergePackageProfiles(package_name_, "primary.prof", PROFILES_ANALYSIS_OPTIMIZE);
+}
+
 TEST_F(ProfileTest, ProfileMergeFailWrongPackage) {
     LOG(INFO) << "ProfileMergeFailWrongPackage";
 
@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/scopeguard.h>
 #include <gtest/gtest.h>
@@ -638,5 +641,53 @@ TEST_F(UtilsTest, TestCreateDirIfNeeded) {
     ASSERT_NE(0, create_dir_if_needed("/data/local/tmp/user/0/bar/baz", 0700));
 }
 
+TEST_F(UtilsTest, RunInParallel) {
+    std::vector<std::atomic<int>> calls(100);
+    run_in_parallel(calls.size(), 4, [&](size_t i) { calls[i]++; });
+    for (const auto& count : calls) {
+        EXPECT_EQ(1, count.load());
+    }
+
+    // Nothing to do, and a single thread.
+    run_in_parallel(0, 4, [&](size_t) { FAIL(); });
+    run_in_parallel(calls.size(), 1, [&](size_t i) { calls[i]++; });
+    for (const auto& count : calls) {
+        EXPECT_EQ(2, count.load());
+    }
+}
+
+TEST_F(UtilsTest, CopyTree) {
+    TemporaryDir from;
+    TemporaryDir to;
+    auto cleanup = android::base::make_scope_guard([&] {
+        delete_dir_contents(from.path);
+        delete_dir_contents(to.path);
+    });
+    const std::string root = std::string(from.path) + "/";
+    ASSERT_EQ(0, mkdir((root + "dir").c_str(), 0751));
+    ASSERT_TRUE(android::base::WriteStringToFile("data", root + "dir/file"));
+    ASSERT_EQ(0, symlink("dir/file", (root + "link").c_str()));
+    const struct timespec times[2] = { { 1000, 0 }, { 2000, 0 } };
+    ASSERT_EQ(0, utimensat(AT_FDCWD, (root + "dir").c_str(), times, 0));
+
+    // Copying again replaces the files copied before.
+    EXPECT_EQ(0, copy_tree(from.path, to.path, 4));
+    EXPECT_EQ(0, copy_tree(from.path, to.path, 4));
+
+    const std::string copy = std::string(to.path) + "/" + android::base::Basename(from.path) + "/";
+    std::string content;
+    EXPECT_TRUE(android::base::ReadFileToString(copy + "dir/file", &content));
+    EXPECT_EQ("data", content);
+    std::string target;
+    EXPECT_TRUE(android::base::Readlink(copy + "link", &target));
+    EXPECT_EQ("dir/file", target);
+    struct stat st;
+    ASSERT_EQ(0, stat((copy + "dir").c_str(), &st));
+    EXPECT_EQ(0751u, st.st_mode & 07777);
+    EXPECT_EQ(2000, st.st_mtime);
+
+    EXPECT_EQ(-1, copy_tree(root + "missing", to.path, 4));
+}
+
 }  // namespace installd
 }  // namespace android
@@ -19,13 +19,20 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <fts.h>
+#include <linux/fs.h>
 #include <stdlib.h>
 #include <sys/capability.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <sys/xattr.h>
 #include <sys/statvfs.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/strings.h>
@@ -429,6 +436,255 @@ int calculate_tree_size(const std::string& path, int64_t* size,
     return 0;
 }
 
+void run_in_parallel(size_t count, size_t max_threads, const std::function<void(size_t)>& work) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            work(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t num_threads = std::min(count, max_threads);
+    for (size_t i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Bytes copied by copy_tree between two progress messages.
+static constexpr int64_t kCopyProgressInterval = 256 * 1024 * 1024;
+
+struct CopyEntry {
+    std::string from;
+    std::string to;
+    struct stat st;
+};
+
+// Copies the user xattrs of a file or directory, like the cache group and tombstone markers.
+// SELinux labels are left to restorecon.
+static int copy_xattrs(int from_fd, int to_fd, const std::string& from) {
+    ssize_t size = flistxattr(from_fd, nullptr, 0);
+    if (size == 0 || (size < 0 && errno == ENOTSUP)) {
+        return 0;
+    }
+    std::vector<char> names(size > 0 ? size : 0);
+    if (size > 0) {
+        size = flistxattr(from_fd, names.data(), names.size());
+    }
+    if (size < 0) {
+        PLOG(ERROR) << "Failed to list xattrs of " << from;
+        return -1;
+    }
+    std::vector<char> value;
+    for (const char* name = names.data(); name < names.data() + size; name += strlen(name) + 1) {
+        if (strncmp(name, "user.", 5) != 0) {
+            continue;
+        }
+        ssize_t len = fgetxattr(from_fd, name, nullptr, 0);
+        if (len >= 0) {
+            value.resize(len);
+            len = fgetxattr(from_fd, name, value.data(), value.size());
+        }
+        if (len < 0 || fsetxattr(to_fd, name, value.data(), len, 0) != 0) {
+            PLOG(ERROR) << "Failed to copy xattr " << name << " of " << from;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Gives to_fd the ownership, mode, user xattrs and timestamps of entry.
+static int copy_metadata(int from_fd, int to_fd, const CopyEntry& entry) {
+    if (fchown(to_fd, entry.st.st_uid, entry.st.st_gid) != 0
+            || fchmod(to_fd, entry.st.st_mode & 07777) != 0) {
+        PLOG(ERROR) << "Failed to set owner and mode of " << entry.to;
+        return -1;
+    }
+    if (copy_xattrs(from_fd, to_fd, entry.from) != 0) {
+        return -1;
+    }
+    const struct timespec times[2] = { entry.st.st_atim, entry.st.st_mtim };
+    if (futimens(to_fd, times) != 0) {
+        PLOG(ERROR) << "Failed to set times of " << entry.to;
+        return -1;
+    }
+    return 0;
+}
+
+// Copies the data of from_fd to the empty to_fd. The data is shared with a reflink when the
+// filesystem supports it, and otherwise copied within the kernel, falling back to read and
+// write when from_fd and to_fd don't allow that.
+static int copy_file_data(int from_fd, int to_fd) {
+    if (ioctl(to_fd, FICLONE, from_fd) == 0) {
+        return 0;
+    }
+    bool in_kernel = true;
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n;
+        if (in_kernel) {
+            n = syscall(__NR_copy_file_range, from_fd, nullptr, to_fd, nullptr, 1 << 30, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL
+                    || errno == EOPNOTSUPP)) {
+                in_kernel = false;
+                continue;
+            }
+        } else {
+            n = TEMP_FAILURE_RETRY(read(from_fd, buf, sizeof(buf)));
+            if (n > 0 && !android::base::WriteFully(to_fd, buf, n)) {
+                n = -1;
+            }
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n;
+        }
+    }
+}
+
+static int copy_file(const CopyEntry& entry) {
+    unique_fd from_fd(open(entry.from.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (from_fd < 0) {
+        PLOG(ERROR) << "Failed to open " << entry.from;
+        return -1;
+    }
+    if (unlink(entry.to.c_str()) != 0 && errno != ENOENT) {
+        PLOG(ERROR) << "Failed to remove " << entry.to;
+        return -1;
+    }
+    unique_fd to_fd(open(entry.to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+            0600));
+    if (to_fd < 0) {
+        PLOG(ERROR) << "Failed to create " << entry.to;
+        return -1;
+    }
+    if (copy_file_data(from_fd, to_fd) != 0) {
+        PLOG(ERROR) << "Failed to copy " << entry.from << " to " << entry.to;
+        return -1;
+    }
+    return copy_metadata(from_fd, to_fd, entry);
+}
+
+static int copy_directory_metadata(const CopyEntry& entry) {
+    unique_fd from_fd(open(entry.from.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    unique_fd to_fd(open(entry.to.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (from_fd < 0 || to_fd < 0) {
+        PLOG(ERROR) << "Failed to open " << entry.from << " or " << entry.to;
+        return -1;
+    }
+    return copy_metadata(from_fd, to_fd, entry);
+}
+
+static int copy_symlink(const CopyEntry& entry) {
+    std::string target;
+    if (!android::base::Readlink(entry.from, &target)) {
+        PLOG(ERROR) << "Failed to read link " << entry.from;
+        return -1;
+    }
+    if ((unlink(entry.to.c_str()) != 0 && errno != ENOENT)
+            || symlink(target.c_str(), entry.to.c_str()) != 0
+            || lchown(entry.to.c_str(), entry.st.st_uid, entry.st.st_gid) != 0) {
+        PLOG(ERROR) << "Failed to create link " << entry.to;
+        return -1;
+    }
+    const struct timespec times[2] = { entry.st.st_atim, entry.st.st_mtim };
+    if (utimensat(AT_FDCWD, entry.to.c_str(), times, AT_SYMLINK_NOFOLLOW) != 0) {
+        PLOG(ERROR) << "Failed to set times of " << entry.to;
+        return -1;
+    }
+    return 0;
+}
+
+
+int copy_tree(const std::string& from, const std::string& to_dir, size_t max_threads) {
+    std::string source(from);
+    while (source.size() > 1 && source.back() == '/') {
+        source.pop_back();
+    }
+    const std::string to = to_dir + "/" + android::base::Basename(source);
+
+    char* argv[] = { const_cast<char*>(source.c_str()), nullptr };
+    FTS* fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR, nullptr);
+    if (fts == nullptr) {
+        PLOG(ERROR) << "Failed to fts_open " << source;
+        return -1;
+    }
+
+    // Directories are created as they are found, but only get their metadata once the files in
+    // them are copied, so that creating the files doesn't change their times.
+    std::vector<CopyEntry> files;
+    std::vector<CopyEntry> directories;
+    int64_t total_size = 0;
+    int res = 0;
+    FTSENT* p;
+    while (res == 0 && (p = fts_read(fts)) != nullptr) {
+        CopyEntry entry = { p->fts_path, to + (p->fts_path + source.size()), *p->fts_statp };
+        switch (p->fts_info) {
+        case FTS_D:
+            if (mkdir(entry.to.c_str(), 0700) != 0 && errno != EEXIST) {
+                PLOG(ERROR) << "Failed to create " << entry.to;
+                res = -1;
+            }
+            break;
+        case FTS_DP:
+            directories.push_back(std::move(entry));
+            break;
+        case FTS_F:
+            total_size += entry.st.st_size;
+            files.push_back(std::move(entry));
+            break;
+        case FTS_SL:
+        case FTS_SLNONE:
+            res = copy_symlink(entry);
+            break;
+        case FTS_DEFAULT:
+            LOG(WARNING) << "Skipping special file " << entry.from;
+            break;
+        case FTS_DNR:
+        case FTS_ERR:
+        case FTS_NS:
+            errno = p->fts_errno;
+            PLOG(ERROR) << "Failed to read " << entry.from;
+            res = -1;
+            break;
+        }
+    }
+    fts_close(fts);
+    if (res != 0) {
+        return res;
+    }
+
+    std::atomic<bool> failed(false);
+    std::atomic<int64_t> copied_size(0);
+    run_in_parallel(files.size(), max_threads, [&](size_t i) {
+        if (failed || copy_file(files[i]) != 0) {
+            failed = true;
+            return;
+        }
+        const int64_t size = files[i].st.st_size;
+        const int64_t copied = copied_size.fetch_add(size) + size;
+        if ((copied - size) / kCopyProgressInterval != copied / kCopyProgressInterval) {
+            LOG(INFO) << "Copied " << copied << " of " << total_size << " bytes from " << source;
+        }
+    });
+    if (failed) {
+        return -1;
+    }
+
+    for (const auto& entry : directories) {
+        if (copy_directory_metadata(entry) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /**
  * Checks whether the package name is valid. Returns -1 on error and
  * 0 on success.
@@ -18,6 +18,7 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -110,6 +111,15 @@ std::vector<userid_t> get_known_users(const char* volume_uuid);
 int calculate_tree_size(const std::string& path, int64_t* size,
         int32_t include_gid = -1, int32_t exclude_gid = -1, bool exclude_apps = false);
 
+// Calls work(i) for each i in [0, count), spread over up to max_threads threads including the
+// calling one. Returns once all the calls have returned.
+void run_in_parallel(size_t count, size_t max_threads, const std::function<void(size_t)>& work);
+
+// Copies the file tree at from into to_dir, like cp -F -p -R -P -d, keeping the user xattrs.
+// Files are copied by up to max_threads threads with reflinks where supported, and progress
+// is logged for large trees. Returns 0 on success.
+int copy_tree(const std::string& from, const std::string& to_dir, size_t max_threads);
+
 int create_user_config_path(char path[PKG_PATH_MAX], userid_t userid);
 
 bool is_valid_filename(const std::string& name);
@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -99,8 +100,10 @@ protected:
     Status fetchManifestHals();
     Status fetchLazyHals();
 
+    // Warnings are written to |warnings|, so that entries fetched at the same time don't
+    // interleave them.
     Status fetchBinderizedEntry(const sp<::android::hidl::manager::V1_0::IServiceManager> &manager,
-                                TableEntry *entry);
+                                TableEntry *entry, std::ostream *warnings);
 
     // Get relevant information for a PID by parsing files under
     // /dev/binderfs/binder_logs or /d/binder.
@@ -185,7 +188,9 @@ protected:
     // If an entry exist and not empty, it contains the cached content of /proc/{pid}/cmdline.
     std::map<pid_t, std::string> mCmdlines;
 
-    // Cache for getPidInfo.
+    // Cache for getPidInfo. Binderized entries are fetched on several threads, so it is
+    // guarded by mCachedPidInfosLock.
+    std::mutex mCachedPidInfosLock;
     std::map<pid_t, BinderPidInfo> mCachedPidInfos;
 
     // Cache for getPartition.
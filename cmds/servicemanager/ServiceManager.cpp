@@ -24,6 +24,8 @@
 #include <binder/Stability.h>
 #include <cutils/android_filesystem_config.h>
 #include <cutils/multiuser.h>
+
+#include <algorithm>
 #include <thread>
 
 #ifndef VENDORSERVICEMANAGER
@@ -192,9 +194,27 @@ Status ServiceManager::checkService(const std::string& name, sp<IBinder>* outBin
     return Status::ok();
 }
 
-sp<IBinder> ServiceManager::tryGetService(const std::string& name, bool startIfNotFound) {
+Status ServiceManager::checkServices(const std::vector<std::string>& names,
+                                     std::optional<std::vector<sp<IBinder>>>* outBinders) {
+    // Looking up the calling context may require reading the caller's SELinux
+    // context, so only do it once for the whole batch.
     auto ctx = mAccess->getCallingContext();
 
+    outBinders->emplace();
+    (*outBinders)->reserve(names.size());
+    for (const std::string& name : names) {
+        (*outBinders)->push_back(tryGetService(ctx, name, false));
+    }
+    // returns ok regardless of result, like checkService
+    return Status::ok();
+}
+
+sp<IBinder> ServiceManager::tryGetService(const std::string& name, bool startIfNotFound) {
+    return tryGetService(mAccess->getCallingContext(), name, startIfNotFound);
+}
+
+sp<IBinder> ServiceManager::tryGetService(const Access::CallingContext& ctx,
+                                          const std::string& name, bool startIfNotFound) {
     sp<IBinder> out;
     Service* service = nullptr;
     if (auto it = mNameToService.find(name); it != mNameToService.end()) {
@@ -291,7 +311,7 @@ Status ServiceManager::addService(const std::string& name, const sp<IBinder>& bi
         for (const sp<IServiceCallback>& cb : it->second) {
             mNameToService[name].guaranteeClient = true;
             // permission checked in registerForNotifications
-            cb->onRegistration(name, binder);
+            mPendingRegistrations.push_back({cb, name, binder});
         }
     }
 
@@ -320,6 +340,8 @@ Status ServiceManager::listServices(int32_t dumpPriority, std::vector<std::strin
             outList->push_back(name);
         }
     }
+    // services are hashed by name, but clients expect them sorted
+    std::sort(outList->begin(), outList->end());
 
     return Status::ok();
 }
@@ -355,7 +377,7 @@ Status ServiceManager::registerForNotifications(
 
         // never null if an entry exists
         CHECK(binder != nullptr) << name;
-        callback->onRegistration(name, binder);
+        mPendingRegistrations.push_back({callback, name, binder});
     }
 
     return Status::ok();
@@ -474,6 +496,23 @@ void ServiceManager::binderDied(const wp<IBinder>& who) {
     for (auto it = mNameToClientCallback.begin(); it != mNameToClientCallback.end();) {
         removeClientCallback(who, &it);
     }
+
+    mPendingRegistrations.erase(
+            std::remove_if(mPendingRegistrations.begin(), mPendingRegistrations.end(),
+                           [&](const PendingRegistration& pending) {
+                               return IInterface::asBinder(pending.callback) == who;
+                           }),
+            mPendingRegistrations.end());
+}
+
+void ServiceManager::sendPendingNotifications() {
+    // callbacks are oneway, but take the queue first in case one of them is local
+    std::vector<PendingRegistration> pending;
+    pending.swap(mPendingRegistrations);
+
+    for (const PendingRegistration& registration : pending) {
+        registration.callback->onRegistration(registration.name, registration.binder);
+    }
 }
 
 void ServiceManager::tryStartService(const std::string& name) {
@@ -556,7 +595,8 @@ ssize_t ServiceManager::Service::getNodeStrongRefCount() {
 }
 
 void ServiceManager::handleClientCallbacks() {
-    for (const auto& [name, service] : mNameToService) {
+    // only services with client callbacks need their clients checked
+    for (const auto& [name, callbacks] : mNameToClientCallback) {
         handleServiceClientCallback(name, true);
     }
 }
@@ -694,6 +734,8 @@ Status ServiceManager::getServiceDebugInfo(std::vector<ServiceDebugInfo>* outRet
 
         outReturn->push_back(std::move(info));
     }
+    std::sort(outReturn->begin(), outReturn->end(),
+              [](const ServiceDebugInfo& a, const ServiceDebugInfo& b) { return a.name < b.name; });
 
     return Status::ok();
 }
@@ -20,6 +20,8 @@
 #include <android/os/IClientCallback.h>
 #include <android/os/IServiceCallback.h>
 
+#include <unordered_map>
+
 #include "Access.h"
 
 namespace android {
@@ -36,6 +38,8 @@ public:
     // getService will try to start any services it cannot find
     binder::Status getService(const std::string& name, sp<IBinder>* outBinder) override;
     binder::Status checkService(const std::string& name, sp<IBinder>* outBinder) override;
+    binder::Status checkServices(const std::vector<std::string>& names,
+                                 std::optional<std::vector<sp<IBinder>>>* outBinders) override;
     binder::Status addService(const std::string& name, const sp<IBinder>& binder,
                               bool allowIsolated, int32_t dumpPriority) override;
     binder::Status listServices(int32_t dumpPriority, std::vector<std::string>* outList) override;
@@ -55,6 +59,11 @@ public:
     void binderDied(const wp<IBinder>& who) override;
     void handleClientCallbacks();
 
+    // Sends the registration notifications queued by addService and registerForNotifications.
+    // Called by the looper once the incoming transactions have been handled, so that the
+    // fan-out to all the registered callbacks doesn't delay the replies.
+    void sendPendingNotifications();
+
 protected:
     virtual void tryStartService(const std::string& name);
 
@@ -71,9 +80,16 @@ private:
         ssize_t getNodeStrongRefCount();
     };
 
-    using ServiceCallbackMap = std::map<std::string, std::vector<sp<IServiceCallback>>>;
-    using ClientCallbackMap = std::map<std::string, std::vector<sp<IClientCallback>>>;
-    using ServiceMap = std::map<std::string, Service>;
+    struct PendingRegistration {
+        sp<IServiceCallback> callback;
+        std::string name;
+        sp<IBinder> binder;
+    };
+
+    using ServiceCallbackMap =
+            std::unordered_map<std::string, std::vector<sp<IServiceCallback>>>;
+    using ClientCallbackMap = std::unordered_map<std::string, std::vector<sp<IClientCallback>>>;
+    using ServiceMap = std::unordered_map<std::string, Service>;
 
     // removes a callback from mNameToRegistrationCallback, removing it if the vector is empty
     // this updates iterator to the next location
@@ -88,11 +104,16 @@ private:
     void removeClientCallback(const wp<IBinder>& who, ClientCallbackMap::iterator* it);
 
     sp<IBinder> tryGetService(const std::string& name, bool startIfNotFound);
+    sp<IBinder> tryGetService(const Access::CallingContext& ctx, const std::string& name,
+                              bool startIfNotFound);
 
     ServiceMap mNameToService;
     ServiceCallbackMap mNameToRegistrationCallback;
     ClientCallbackMap mNameToClientCallback;
 
+    // registration notifications not sent yet, in the order they were queued
+    std::vector<PendingRegistration> mPendingRegistrations;
+
     std::unique_ptr<Access> mAccess;
 };
 
@@ -38,8 +38,8 @@ using ::android::sp;
 
 class BinderCallback : public LooperCallback {
 public:
-    static sp<BinderCallback> setupTo(const sp<Looper>& looper) {
-        sp<BinderCallback> cb = sp<BinderCallback>::make();
+    static sp<BinderCallback> setupTo(const sp<Looper>& looper, const sp<ServiceManager>& manager) {
+        sp<BinderCallback> cb = sp<BinderCallback>::make(manager);
 
         int binder_fd = -1;
         IPCThreadState::self()->setupPolling(&binder_fd);
@@ -57,8 +57,14 @@ public:
 
     int handleEvent(int /* fd */, int /* events */, void* /* data */) override {
         IPCThreadState::self()->handlePolledCommands();
+        // the transactions have been replied to, now notify the registration callbacks
+        mManager->sendPendingNotifications();
         return 1;  // Continue receiving callbacks.
     }
+private:
+    friend sp<BinderCallback>;
+    BinderCallback(const sp<ServiceManager>& manager) : mManager(manager) {}
+    sp<ServiceManager> mManager;
 };
 
 // LooperCallback for IClientCallback
@@ -131,7 +137,7 @@ int main(int argc, char** argv) {
 
     sp<Looper> looper = Looper::prepare(false /*allowNonCallbacks*/);
 
-    BinderCallback::setupTo(looper);
+    BinderCallback::setupTo(looper, manager);
     ClientCallbackCallback::setupTo(looper, manager);
 
     while(true) {
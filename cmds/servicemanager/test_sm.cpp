@@ -255,6 +255,47 @@ TEST(GetService, NotAllowedFromIsolated) {
     EXPECT_EQ(nullptr, out.get());
 }
 
+TEST(CheckServices, HappyHappy) {
+    auto sm = getPermissiveServiceManager();
+    sp<IBinder> foo = getBinder();
+    sp<IBinder> bar = getBinder();
+
+    EXPECT_TRUE(sm->addService("foo", foo, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    EXPECT_TRUE(sm->addService("bar", bar, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::optional<std::vector<sp<IBinder>>> out;
+    EXPECT_TRUE(sm->checkServices({"foo", "baz", "bar"}, &out).isOk());
+    ASSERT_TRUE(out.has_value());
+    EXPECT_THAT(*out, ElementsAre(foo, sp<IBinder>(), bar));
+}
+
+TEST(CheckServices, OneCallingContextPerBatch) {
+    std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
+
+    EXPECT_CALL(*access, getCallingContext())
+        // something adds it
+        .WillOnce(Return(Access::CallingContext{}))
+        // the whole batch
+        .WillOnce(Return(Access::CallingContext{}));
+    EXPECT_CALL(*access, canAdd(_, _)).WillOnce(Return(true));
+    // each name is still checked on its own
+    EXPECT_CALL(*access, canFind(_, "foo")).WillOnce(Return(true));
+    EXPECT_CALL(*access, canFind(_, "bar")).WillOnce(Return(false));
+
+    sp<ServiceManager> sm = sp<NiceMock<MockServiceManager>>::make(std::move(access));
+
+    sp<IBinder> service = getBinder();
+    EXPECT_TRUE(sm->addService("foo", service, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::optional<std::vector<sp<IBinder>>> out;
+    EXPECT_TRUE(sm->checkServices({"foo", "bar"}, &out).isOk());
+    ASSERT_TRUE(out.has_value());
+    EXPECT_THAT(*out, ElementsAre(service, sp<IBinder>()));
+}
+
 TEST(ListServices, NoPermissions) {
     std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
 
@@ -394,6 +435,7 @@ TEST(ServiceNotifications, NoNotification) {
     EXPECT_TRUE(sm->registerForNotifications("foofoo", cb).isOk());
     EXPECT_TRUE(sm->addService("otherservice", getBinder(),
         false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    sm->sendPendingNotifications();
 
     EXPECT_THAT(cb->registrations, ElementsAre());
     EXPECT_THAT(cb->binders, ElementsAre());
@@ -409,9 +451,33 @@ TEST(ServiceNotifications, GetNotification) {
     EXPECT_TRUE(sm->registerForNotifications("asdfasdf", cb).isOk());
     EXPECT_TRUE(sm->addService("asdfasdf", service,
         false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    sm->sendPendingNotifications();
+
+    EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf"));
+    EXPECT_THAT(cb->binders, ElementsAre(service));
+}
+
+TEST(ServiceNotifications, NotificationSentAfterTransaction) {
+    auto sm = getPermissiveServiceManager();
+
+    sp<CallbackHistorian> cb = sp<CallbackHistorian>::make();
+
+    sp<IBinder> service = getBinder();
+
+    EXPECT_TRUE(sm->registerForNotifications("asdfasdf", cb).isOk());
+    EXPECT_TRUE(sm->addService("asdfasdf", service,
+        false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    // queued until the looper is done with the incoming transactions
+    EXPECT_THAT(cb->registrations, ElementsAre());
 
+    sm->sendPendingNotifications();
     EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf"));
     EXPECT_THAT(cb->binders, ElementsAre(service));
+
+    // sent only once
+    sm->sendPendingNotifications();
+    EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf"));
 }
 
 TEST(ServiceNotifications, GetNotificationForAlreadyRegisteredService) {
@@ -425,6 +491,7 @@ TEST(ServiceNotifications, GetNotificationForAlreadyRegisteredService) {
         false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
 
     EXPECT_TRUE(sm->registerForNotifications("asdfasdf", cb).isOk());
+    sm->sendPendingNotifications();
 
     EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf"));
     EXPECT_THAT(cb->binders, ElementsAre(service));
@@ -443,6 +510,7 @@ TEST(ServiceNotifications, GetMultipleNotification) {
         false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
     EXPECT_TRUE(sm->addService("asdfasdf", binder2,
         false /*allowIsolated*/, IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    sm->sendPendingNotifications();
 
     EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf", "asdfasdf"));
     EXPECT_THAT(cb->registrations, ElementsAre("asdfasdf", "asdfasdf"));
@@ -33,6 +33,7 @@
 #include <utils/Trace.h>
 
 #include <chrono>
+#include <algorithm>
 #include <cmath>
 #include <condition_variable>
 #include <cstdlib>
@@ -50,14 +51,15 @@ using namespace android;
 std::atomic_bool Replayer::sReplayingManually(false);
 
 Replayer::Replayer(const std::string& filename, bool replayManually, int numThreads, bool wait,
-        nsecs_t stopHere)
+        nsecs_t stopHere, bool measure)
       : mTrace(),
         mLoaded(false),
         mIncrementIndex(0),
         mCurrentTime(0),
         mNumThreads(numThreads),
         mWaitForTimeStamps(wait),
-        mStopTimeStamp(stopHere) {
+        mStopTimeStamp(stopHere),
+        mMeasure(measure) {
     srand(RAND_COLOR_SEED);
 
     std::string input;
@@ -81,14 +83,16 @@ Replayer::Replayer(const std::string& filename, bool replayManually, int numThre
     }
 }
 
-Replayer::Replayer(const Trace& t, bool replayManually, int numThreads, bool wait, nsecs_t stopHere)
+Replayer::Replayer(const Trace& t, bool replayManually, int numThreads, bool wait, nsecs_t stopHere,
+        bool measure)
       : mTrace(t),
         mLoaded(true),
         mIncrementIndex(0),
         mCurrentTime(0),
         mNumThreads(numThreads),
         mWaitForTimeStamps(wait),
-        mStopTimeStamp(stopHere) {
+        mStopTimeStamp(stopHere),
+        mMeasure(measure) {
     srand(RAND_COLOR_SEED);
     mCurrentTime = mTrace.increment(0).time_stamp();
 
@@ -115,6 +119,9 @@ status_t Replayer::replay() {
 
     initReplay();
 
+    mReplayStartTime = systemTime();
+    mTraceStartTime = mTrace.increment(0).time_stamp();
+
     ALOGV("Starting actual Replay!");
     while (!mPendingIncrements.empty()) {
         mCurrentIncrement = mTrace.increment(mIncrementIndex);
@@ -154,6 +161,10 @@ status_t Replayer::replay() {
 
     SurfaceComposerClient::enableVSyncInjections(false);
 
+    if (mMeasure) {
+        reportMetrics();
+    }
+
     return status;
 }
 
@@ -346,6 +357,17 @@ status_t Replayer::doTransaction(const Transaction& t, const std::shared_ptr<Eve
 
     event->readyToExecute();
 
+    if (mMeasure) {
+        const nsecs_t applyTime = systemTime();
+        liveTransaction.addTransactionCompletedCallback(
+                [this, applyTime](void* /*context*/, nsecs_t latchTime,
+                                  const sp<Fence>& presentFence,
+                                  const std::vector<SurfaceControlStats>& /*stats*/) {
+                    std::lock_guard<std::mutex> lock(mTimingsLock);
+                    mTimings.push_back({applyTime, latchTime, presentFence});
+                },
+                nullptr);
+    }
     liveTransaction.apply(t.synchronous());
 
     ALOGV("Ended Transaction");
@@ -654,10 +676,64 @@ void Replayer::updatePowerMode(const PowerModeUpdate& pmu, const std::shared_ptr
 }
 
 void Replayer::waitUntilTimestamp(int64_t timestamp) {
+    if (mMeasure) {
+        // Wait for a deadline from the start of the replay, so that the time spent dispatching
+        // the increments doesn't add up over the trace.
+        const nsecs_t deadline = mReplayStartTime + (timestamp - mTraceStartTime);
+        const nsecs_t now = systemTime();
+        if (deadline > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+        }
+        mDispatchDelays.push_back(std::max<nsecs_t>(systemTime() - deadline, 0));
+        return;
+    }
     ALOGV("Waiting for %lld nanoseconds...", static_cast<int64_t>(timestamp - mCurrentTime));
     std::this_thread::sleep_for(std::chrono::nanoseconds(timestamp - mCurrentTime));
 }
 
+static void printLatencies(const char* name, std::vector<nsecs_t> latencies) {
+    if (latencies.empty()) {
+        std::cout << name << ": no samples\n";
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](size_t p) {
+        return ns2us(latencies[(latencies.size() - 1) * p / 100]) / 1000.0;
+    };
+    std::cout << name << " (ms, " << latencies.size() << " samples): p50 " << percentile(50)
+              << ", p90 " << percentile(90) << ", p99 " << percentile(99) << ", max "
+              << percentile(100) << "\n";
+}
+
+void Replayer::reportMetrics() {
+    // Let the last transactions be latched and presented
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    std::vector<nsecs_t> latchLatencies;
+    std::vector<nsecs_t> presentLatencies;
+    size_t notPresented = 0;
+    {
+        std::lock_guard<std::mutex> lock(mTimingsLock);
+        for (const auto& timing : mTimings) {
+            latchLatencies.push_back(timing.latchTime - timing.applyTime);
+            const nsecs_t presentTime = timing.presentFence ? timing.presentFence->getSignalTime()
+                                                            : Fence::SIGNAL_TIME_INVALID;
+            if (presentTime == Fence::SIGNAL_TIME_INVALID ||
+                presentTime == Fence::SIGNAL_TIME_PENDING) {
+                notPresented++;
+                continue;
+            }
+            presentLatencies.push_back(presentTime - timing.applyTime);
+        }
+    }
+
+    std::cout << "Replay metrics:\n";
+    printLatencies("  Increment dispatch delay", mDispatchDelays);
+    printLatencies("  Transaction latch latency", latchLatencies);
+    printLatencies("  Transaction present latency", presentLatencies);
+    std::cout << "  Transactions without a present time: " << notPresented << std::endl;
+}
+
 status_t Replayer::loadSurfaceComposerClient() {
     mComposerClient = new SurfaceComposerClient;
     return mComposerClient->initCheck();
@@ -26,6 +26,8 @@
 #include <gui/SurfaceComposerClient.h>
 #include <gui/SurfaceControl.h>
 
+#include <ui/Fence.h>
+
 #include <utils/Errors.h>
 #include <utils/StrongPointer.h>
 
@@ -37,6 +39,7 @@
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 using namespace android::surfaceflinger;
 
@@ -54,10 +57,13 @@ typedef google::protobuf::RepeatedPtrField<DisplayChange> DisplayChanges;
 
 class Replayer {
   public:
+    // When measure is set, the increments are replayed with the timing of the trace measured from
+    // the start of the replay, and latency metrics are reported once the trace is replayed.
     Replayer(const std::string& filename, bool replayManually = false,
-            int numThreads = DEFAULT_THREADS, bool wait = true, nsecs_t stopHere = -1);
+            int numThreads = DEFAULT_THREADS, bool wait = true, nsecs_t stopHere = -1,
+            bool measure = false);
     Replayer(const Trace& trace, bool replayManually = false, int numThreads = DEFAULT_THREADS,
-            bool wait = true, nsecs_t stopHere = -1);
+            bool wait = true, nsecs_t stopHere = -1, bool measure = false);
 
     status_t replay();
 
@@ -131,6 +137,14 @@ class Replayer {
     void waitUntilTimestamp(int64_t timestamp);
     status_t loadSurfaceComposerClient();
 
+    // Timing of a transaction applied while measuring
+    struct TransactionTiming {
+        nsecs_t applyTime;
+        nsecs_t latchTime;
+        sp<Fence> presentFence;
+    };
+    void reportMetrics();
+
     Trace mTrace;
     bool mLoaded = false;
     int32_t mIncrementIndex = 0;
@@ -147,6 +161,14 @@ class Replayer {
     nsecs_t mStopTimeStamp;
     bool mHasStopped;
 
+    bool mMeasure = false;
+    nsecs_t mReplayStartTime = 0;
+    int64_t mTraceStartTime = 0;
+    // How late each increment was dispatched compared to the trace
+    std::vector<nsecs_t> mDispatchDelays;
+    std::mutex mTimingsLock;
+    std::vector<TransactionTiming> mTimings;
+
     std::mutex mLayerLock;
     std::condition_variable mLayerCond;
     std::unordered_map<layer_id, sp<SurfaceControl>> mLayers;
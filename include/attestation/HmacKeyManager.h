@@ -15,6 +15,9 @@
  */
 
 #include <array>
+#include <memory>
+
+struct hmac_ctx_st;
 
 namespace android {
 /**
@@ -27,6 +30,13 @@ public:
     HmacKeyManager();
     std::array<uint8_t, 32> sign(const uint8_t* data, size_t size) const;
 private:
-    const std::array<uint8_t, 128> mHmacKey;
+    struct HmacContextDeleter {
+        void operator()(hmac_ctx_st* context) const;
+    };
+    /**
+     * HMAC state with the key already set up, copied for each signature so that the key isn't
+     * hashed into the inner and outer pads again for every event.
+     */
+    const std::unique_ptr<hmac_ctx_st, HmacContextDeleter> mKeyedContext;
 };
 } // namespace android
\ No newline at end of file
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <memory>
 #include <new>
 #include <type_traits>
 
@@ -52,6 +54,40 @@ struct ArrayTraits {
       return new (ptr) value_type{std::forward<Args>(args)...};
     }
   }
+
+  // Copies the range [first, last) to uninitialized storage at it, and returns the end of the
+  // copy. Ranges of trivially copyable elements in contiguous memory are copied in bulk.
+  template <typename Iterator>
+  static pointer uninitialized_copy(Iterator first, Iterator last, const_iterator it) {
+    const pointer ptr = const_cast<pointer>(it);
+    if constexpr (is_memcpy_range<Iterator>) {
+      const auto count = static_cast<size_type>(last - first);
+      // The destination is uninitialized, so elements need not be assignable.
+      if (count > 0) std::memcpy(static_cast<void*>(ptr), first, count * sizeof(value_type));
+      return ptr + count;
+    } else {
+      return std::uninitialized_copy(first, last, ptr);
+    }
+  }
+
+  // Moves the range [first, last) to uninitialized storage at it, which must not overlap, then
+  // destroys the source for destructor side effects. Returns the end of the destination.
+  static pointer relocate(iterator first, iterator last, const_iterator it) {
+    if constexpr (std::is_trivially_copyable_v<value_type>) {
+      return uninitialized_copy(first, last, it);
+    } else {
+      const pointer end = std::uninitialized_move(first, last, const_cast<pointer>(it));
+      std::destroy(first, last);
+      return end;
+    }
+  }
+
+ private:
+  template <typename Iterator>
+  static constexpr bool is_memcpy_range =
+      std::is_pointer_v<Iterator> &&
+      std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Iterator>>, value_type> &&
+      std::is_trivially_copyable_v<value_type>;
 };
 
 // CRTP mixin to define iterator functions in terms of non-const Self::begin and Self::end.
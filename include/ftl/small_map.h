@@ -19,10 +19,13 @@
 #include <ftl/initializer_list.h>
 #include <ftl/small_vector.h>
 
+#include <algorithm>
 #include <functional>
 #include <optional>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace android::ftl {
 
@@ -32,6 +35,10 @@ namespace android::ftl {
 //
 // SmallMap<K, V, 0> unconditionally allocates on the heap.
 //
+// Lookup is a linear search while the map holds few mappings. Past the larger of N and 16, if keys
+// can be compared with operator<, the map also keeps the positions of its mappings sorted by key,
+// and lookup is a binary search over them. The mappings themselves stay unordered either way.
+//
 // Example usage:
 //
 //   ftl::SmallMap<int, std::string, 3> map;
@@ -54,10 +61,29 @@ namespace android::ftl {
 //
 //   assert(map == SmallMap(ftl::init::map(-1, "xyz")(42, "???")(123, "abc")));
 //
+//   assert(map.try_emplace(7, "seven").second);
+//   assert(map.size() == 4u);
+//   assert(map.dynamic());
+//
+//   assert(map.erase(123));
+//   assert(!map.contains(123));
+//
 template <typename K, typename V, std::size_t N>
 class SmallMap final {
   using Map = SmallVector<std::pair<const K, V>, N>;
 
+  template <typename, typename = void>
+  struct is_ordered : std::false_type {};
+
+  template <typename T>
+  struct is_ordered<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>>
+      : std::true_type {};
+
+  static constexpr bool kIndexed = is_ordered<K>::value;
+
+  // Below this size, a linear search is faster than a binary search through the index.
+  static constexpr std::size_t kIndexThreshold = std::max<std::size_t>(N, 16);
+
  public:
   using key_type = K;
   using mapped_type = V;
@@ -150,18 +176,16 @@ class SmallMap final {
   template <typename F, typename R = std::invoke_result_t<F, const mapped_type&>>
   auto find(const key_type& key, F f) const
       -> std::conditional_t<std::is_void_v<R>, bool, std::optional<R>> {
-    for (auto& [k, v] : *this) {
-      if (k == key) {
-        if constexpr (std::is_void_v<R>) {
-          f(v);
-          return true;
-        } else {
-          return f(v);
-        }
-      }
-    }
+    const size_type i = position(key);
+    if (i == size()) return {};
 
-    return {};
+    const mapped_type& v = map_[i].second;
+    if constexpr (std::is_void_v<R>) {
+      f(v);
+      return true;
+    } else {
+      return f(v);
+    }
   }
 
   template <typename F>
@@ -170,8 +194,99 @@ class SmallMap final {
         key, [&f](const mapped_type& v) { return f(const_cast<mapped_type&>(v)); });
   }
 
+  // Adds a mapping constructed in place from the arguments, unless the key already exists. Returns
+  // an iterator to the mapping for the key, and whether it was added.
+  //
+  //   ftl::SmallMap map = ftl::init::map(1, '1')(2, '2');
+  //
+  //   assert(map.try_emplace(3, '3').second);
+  //   assert(!map.try_emplace(1, 'x').second);
+  //   assert(map.find(1) == '1');
+  //
+  // If the map reaches its static or dynamic capacity, then all iterators are invalidated.
+  //
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    if (const size_type i = position(key); i != size()) {
+      return {begin() + i, false};
+    }
+
+    map_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+
+    if constexpr (kIndexed) {
+      if (size() == kIndexThreshold + 1) {
+        index_.resize(size());
+        for (size_type j = 0; j < size(); j++) index_[j] = j;
+        std::sort(index_.begin(), index_.end(),
+                  [this](size_type lhs, size_type rhs) { return key_at(lhs) < key_at(rhs); });
+      } else if (size() > kIndexThreshold + 1) {
+        // The key argument may refer to storage that was reallocated.
+        index_.insert(lower_bound(key_at(size() - 1)), size() - 1);
+      }
+    }
+
+    return {begin() + (size() - 1), true};
+  }
+
+  // Removes the mapping for the key, and returns whether it existed. Like SmallVector's
+  // unstable_erase, this moves the last mapping to the slot of the erased one.
+  //
+  // The last() and end() iterators, as well as those to the erased mapping, are invalidated.
+  //
+  bool erase(const key_type& key) {
+    const size_type i = position(key);
+    if (i == size()) return false;
+
+    if constexpr (kIndexed) {
+      if (size() == kIndexThreshold + 1) {
+        index_.clear();
+      } else if (size() > kIndexThreshold + 1) {
+        index_.erase(lower_bound(key));
+
+        // The last mapping is moved into the erased slot.
+        if (const size_type last = size() - 1; i != last) {
+          index_[lower_bound(key_at(last)) - index_.cbegin()] = i;
+        }
+      }
+    }
+
+    map_.unstable_erase(begin() + i);
+    return true;
+  }
+
  private:
+  const key_type& key_at(size_type i) const { return map_[i].first; }
+
+  // Returns the first position in the index whose key is not less than the given key.
+  auto lower_bound(const key_type& key) const {
+    const const_iterator mappings = begin();
+    return std::lower_bound(
+        index_.cbegin(), index_.cend(), key,
+        [mappings](size_type i, const key_type& k) { return mappings[i].first < k; });
+  }
+
+  // Returns the position of the mapping for the key, or size() if there is none.
+  size_type position(const key_type& key) const {
+    if constexpr (kIndexed) {
+      if (size() > kIndexThreshold) {
+        const auto it = lower_bound(key);
+        return it != index_.end() && key_at(*it) == key ? *it : size();
+      }
+    }
+
+    const const_iterator mappings = begin();
+    const size_type count = size();
+
+    size_type i = 0;
+    while (i < count && !(mappings[i].first == key)) i++;
+    return i;
+  }
+
   Map map_;
+
+  // Positions of the mappings sorted by key, while there are more than kIndexThreshold of them.
+  std::vector<size_type> index_;
 };
 
 // Deduction guide for in-place constructor.
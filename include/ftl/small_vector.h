@@ -210,6 +210,25 @@ class SmallVector final : ArrayTraits<T>, ArrayComparators<SmallVector> {
     insert<kInsertStatic, kInsertDynamic>(std::move(v));
   }
 
+  // Appends the elements of the range [first, last), which must not be part of this vector.
+  // Trivially copyable elements are copied in bulk from contiguous ranges.
+  //
+  // If the vector reaches its static or dynamic capacity, then all iterators are invalidated.
+  // Otherwise, only the end() iterator is invalidated.
+  //
+  template <typename Iterator>
+  void append(Iterator first, Iterator last) {
+    if (Dynamic* const vector = std::get_if<Dynamic>(&vector_)) {
+      vector->append(first, last);
+      return;
+    }
+
+    auto& vector = std::get<Static>(vector_);
+    if (!vector.append(first, last)) {
+      promote(vector, static_cast<size_type>(std::distance(first, last))).append(first, last);
+    }
+  }
+
   // Removes the last element. The vector must not be empty, or the call is erroneous.
   //
   // The last() and end() iterators are invalidated.
@@ -250,13 +269,19 @@ class SmallVector final : ArrayTraits<T>, ArrayComparators<SmallVector> {
     }
   }
 
-  Dynamic& promote(Static& static_vector) {
-    assert(static_vector.full());
-
+  // Moves the elements to dynamic storage with room for count more.
+  Dynamic& promote(Static& static_vector, size_type count = 1) {
     // Allocate double capacity to reduce probability of reallocation.
     Dynamic vector;
-    vector.reserve(Static::max_size() * 2);
-    std::move(static_vector.begin(), static_vector.end(), std::back_inserter(vector));
+    vector.reserve(std::max(Static::max_size() * 2, static_vector.size() + count));
+
+    // Copied in bulk if trivially copyable, since moving such elements is copying them.
+    if constexpr (std::is_trivially_copyable_v<value_type>) {
+      vector.append(static_vector.begin(), static_vector.end());
+    } else {
+      vector.append(std::make_move_iterator(static_vector.begin()),
+                    std::make_move_iterator(static_vector.end()));
+    }
 
     return vector_.template emplace<Dynamic>(std::move(vector));
   }
@@ -345,10 +370,23 @@ class SmallVector<T, 0> final : ArrayTraits<T>,
     return true;
   }
 
+  template <typename Iterator>
+  bool append(Iterator first, Iterator last) {
+    // std::vector::insert requires assignable elements, even at the end.
+    if constexpr (std::is_move_assignable_v<T>) {
+      Impl::insert(Impl::end(), first, last);
+    } else {
+      Impl::reserve(Impl::size() + static_cast<size_type>(std::distance(first, last)));
+      std::copy(first, last, std::back_inserter(static_cast<Impl&>(*this)));
+    }
+    return true;
+  }
+
   using Impl::pop_back;
 
+  // Like StaticVector, moves rather than swaps, so that T does not need to be assignable.
   void unstable_erase(iterator it) {
-    if (it != last()) std::iter_swap(it, last());
+    if (it != last()) replace(it, std::move(back()));
     pop_back();
   }
 
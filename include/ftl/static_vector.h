@@ -79,6 +79,8 @@ class StaticVector final : ArrayTraits<T>,
   static_assert(N > 0);
 
   using ArrayTraits<T>::construct_at;
+  using ArrayTraits<T>::relocate;
+  using ArrayTraits<T>::uninitialized_copy;
 
   using Iter = ArrayIterators<StaticVector, T>;
   friend Iter;
@@ -139,7 +141,7 @@ class StaticVector final : ArrayTraits<T>,
   template <typename Iterator>
   StaticVector(IteratorRangeTag, Iterator first, Iterator last)
       : size_(std::min(max_size(), static_cast<size_type>(std::distance(first, last)))) {
-    std::uninitialized_copy(first, first + size_, begin());
+    uninitialized_copy(first, first + size_, begin());
   }
 
   // Constructs at most N elements. The template arguments T and N are inferred using the
@@ -274,6 +276,21 @@ class StaticVector final : ArrayTraits<T>,
     return it != end();
   }
 
+  // Appends the elements of the range [first, last) unless they do not all fit, and returns whether
+  // they were appended. Trivially copyable elements are copied in bulk from contiguous ranges.
+  //
+  // On success, the end() iterator is invalidated.
+  //
+  template <typename Iterator>
+  bool append(Iterator first, Iterator last) {
+    const auto count = static_cast<size_type>(std::distance(first, last));
+    if (count > max_size() - size()) return false;
+
+    uninitialized_copy(first, last, end());
+    size_ += count;
+    return true;
+  }
+
   // Removes the last element. The vector must not be empty, or the call is erroneous.
   //
   // The last() and end() iterators are invalidated.
@@ -379,9 +396,7 @@ void StaticVector<T, N>::swap(StaticVector& other) {
   }
 
   // Move elements [min, max) and destroy their source for destructor side effects.
-  const auto [first, last] = std::make_pair(from->begin() + min, from->begin() + max);
-  std::uninitialized_move(first, last, to->begin() + min);
-  std::destroy(first, last);
+  relocate(from->begin() + min, from->begin() + max, to->begin() + min);
 
   std::swap(size_, other.size_);
 }
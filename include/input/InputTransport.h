@@ -31,6 +31,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/chrono_utils.h>
 #include <android-base/result.h>
@@ -258,6 +259,16 @@ public:
      */
     status_t sendMessage(const InputMessage* msg);
 
+    /* Sends several messages in order, with as few system calls as possible.
+     * The messages are sanitized in place before they are sent.
+     *
+     * Sets outSentCount to the number of messages that were sent, whatever the result.
+     *
+     * Return OK if all the messages were sent.
+     * Otherwise, return what sendMessage would have returned for the first message not sent.
+     */
+    status_t sendMessages(InputMessage* msgs, size_t count, size_t* outSentCount);
+
     /* Receive a message sent by the other endpoint.
      *
      * If there is no message present, try again after poll() indicates that the fd
@@ -421,8 +432,28 @@ public:
      */
     android::base::Result<ConsumerResponse> receiveConsumerResponse();
 
+    /* Starts a batch: until flush() is called, the publish methods queue their
+     * events instead of sending them, and only return errors about the event itself.
+     */
+    void beginBatch();
+
+    /* Sends the events queued since beginBatch() in order, with as few system calls as
+     * possible, and ends the batch.
+     *
+     * Sets outPublishedCount to the number of events that were sent. The events that
+     * were not sent are dropped.
+     *
+     * Returns OK if all the events were sent.
+     * Otherwise, returns what publishing the first event not sent would have returned.
+     */
+    status_t flush(size_t* outPublishedCount);
+
 private:
     std::shared_ptr<InputChannel> mChannel;
+    bool mBatching = false;
+    std::vector<InputMessage> mBatchedMessages;
+
+    status_t sendMessage(const InputMessage& msg);
 };
 
 /*
@@ -430,6 +461,17 @@ private:
  */
 class InputConsumer {
 public:
+    /* How batched touch samples are resampled to the frame time passed to consume(). */
+    enum class ResamplingMode {
+        /* Resamples a few milliseconds before the frame time, interpolating between the
+         * samples on either side of it where possible. This is the default. */
+        INTERPOLATE,
+        /* Resamples at the frame time itself, consuming every sample up to it and
+         * extrapolating from the two most recent samples. This trades some accuracy for
+         * lower latency. */
+        PREDICT,
+    };
+
     /* Creates a consumer associated with an input channel. */
     explicit InputConsumer(const std::shared_ptr<InputChannel>& channel);
 
@@ -510,12 +552,22 @@ public:
      */
     int32_t getPendingBatchSource() const;
 
+    /* Sets how touch samples are resampled. Has no effect if touch resampling is disabled. */
+    void setResamplingMode(ResamplingMode mode);
+
+    ResamplingMode getResamplingMode() const { return mResamplingMode; }
+
     std::string dump() const;
 
 private:
+    // Maximum number of samples held in a batch. A full batch is consumed right away.
+    static constexpr size_t MAX_BATCH_SAMPLES = 32;
+
     // True if touch resampling is enabled.
     const bool mResampleTouch;
 
+    ResamplingMode mResamplingMode;
+
     std::shared_ptr<InputChannel> mChannel;
 
     // The current input message.
@@ -525,9 +577,33 @@ private:
     // call to consume and that still needs to be handled.
     bool mMsgDeferred;
 
-    // Batched motion events per device and source.
+    // Batched motion events per device and source. The samples are kept in a ring whose
+    // storage is allocated once, and a consumed batch is left empty in mBatches to be reused,
+    // so a stream of motion events neither allocates nor moves messages around.
     struct Batch {
         std::vector<InputMessage> samples;
+        size_t head;
+        size_t count;
+
+        Batch() : samples(MAX_BATCH_SAMPLES), head(0), count(0) {}
+
+        bool empty() const { return count == 0; }
+        bool isFull() const { return count == MAX_BATCH_SAMPLES; }
+
+        const InputMessage& sample(size_t index) const {
+            return samples[(head + index) % MAX_BATCH_SAMPLES];
+        }
+        InputMessage& sample(size_t index) { return samples[(head + index) % MAX_BATCH_SAMPLES]; }
+
+        void push(const InputMessage& msg) {
+            samples[(head + count) % MAX_BATCH_SAMPLES] = msg;
+            count += 1;
+        }
+
+        void pop(size_t n) {
+            head = (head + n) % MAX_BATCH_SAMPLES;
+            count -= n;
+        }
     };
     std::vector<Batch> mBatches;
 
@@ -645,6 +721,7 @@ private:
             const InputMessage *next);
 
     ssize_t findBatch(int32_t deviceId, int32_t source) const;
+    Batch& obtainBatch();
     ssize_t findTouchState(int32_t deviceId, int32_t source) const;
 
     nsecs_t getConsumeTime(uint32_t seq) const;
@@ -19,6 +19,10 @@
 
 #include <stdint.h>
 
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #ifdef __linux__
 #include <binder/IBinder.h>
 #endif
@@ -234,8 +238,17 @@ private:
     KeyedVector<int32_t, int32_t> mKeysByScanCode;
     KeyedVector<int32_t, int32_t> mKeysByUsageCode;
 
+    // Lookup tables derived from mKeys by buildLookupTables() each time mKeys changes. They are
+    // not parceled.
+    // The keys indexed by key code, for the key codes from 0 to MAX_KEYS.
+    std::vector<const Key*> mKeysByKeyCode;
+    // The key code and meta state that findKey() returns for each character.
+    std::unordered_map<char16_t, std::pair<int32_t, int32_t>> mKeysByCharacter;
+
     KeyCharacterMap();
 
+    void buildLookupTables();
+
     bool getKey(int32_t keyCode, const Key** outKey) const;
     bool getKeyBehavior(int32_t keyCode, int32_t metaState,
             const Key** outKey, const Behavior** outBehavior) const;
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *            http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_POWERHALCOALESCER_H
+#define ANDROID_POWERHALCOALESCER_H
+
+#include <android-base/thread_annotations.h>
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/Mode.h>
+#include <powermanager/PowerHalWrapper.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+// Coalesces the boosts and mode changes sent to a HalWrapper, by default a PowerHalController,
+// and sends them from a dedicated thread, so that callers don't wait on the HAL. Boosts and mode
+// changes are accepted with an ok result, and their failures are only logged.
+//  - A boost is dropped while the same boost sent earlier stays active for at least as long as
+//    the new one would, or while it is still waiting to be sent. Boosts with no duration, which
+//    is left to the HAL, are never considered active once sent.
+//  - Only the last state requested for a mode is sent, and not at all if the HAL is already in
+//    that state.
+// Hint sessions are created synchronously.
+class PowerHalCoalescer : public HalWrapper {
+public:
+    PowerHalCoalescer();
+    explicit PowerHalCoalescer(std::unique_ptr<HalWrapper> hal);
+    virtual ~PowerHalCoalescer();
+
+    virtual HalResult<void> setBoost(hardware::power::Boost boost, int32_t durationMs) override;
+    virtual HalResult<void> setMode(hardware::power::Mode mode, bool enabled) override;
+    virtual HalResult<sp<hardware::power::IPowerHintSession>> createHintSession(
+            int32_t tgid, int32_t uid, const std::vector<int32_t>& threadIds,
+            int64_t durationNanos) override;
+    virtual HalResult<int64_t> getHintSessionPreferredRate() override;
+
+    // Waits until the boosts and mode changes accepted so far have been sent.
+    void flush();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const std::unique_ptr<HalWrapper> mHal;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mRunning GUARDED_BY(mMutex) = true;
+    // Incremented by the thread each time it is done sending what it found pending.
+    uint64_t mSentGeneration GUARDED_BY(mMutex) = 0;
+    bool mSending GUARDED_BY(mMutex) = false;
+
+    std::map<hardware::power::Boost, int32_t /*durationMs*/> mPendingBoosts GUARDED_BY(mMutex);
+    std::map<hardware::power::Mode, bool /*enabled*/> mPendingModes GUARDED_BY(mMutex);
+    std::map<hardware::power::Boost, Clock::time_point /*end*/> mActiveBoosts GUARDED_BY(mMutex);
+    std::map<hardware::power::Mode, bool /*enabled*/> mSentModes GUARDED_BY(mMutex);
+
+    std::thread mThread;
+
+    void threadMain();
+};
+
+// -------------------------------------------------------------------------------------------------
+
+}; // namespace power
+
+}; // namespace android
+
+#endif // ANDROID_POWERHALCOALESCER_H
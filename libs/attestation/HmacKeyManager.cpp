@@ -29,15 +29,30 @@ static std::array<uint8_t, 128> getRandomKey() {
     return key;
 }
 
-HmacKeyManager::HmacKeyManager() : mHmacKey(getRandomKey()) {}
+static HMAC_CTX* createKeyedContext() {
+    const std::array<uint8_t, 128> key = getRandomKey();
+    HMAC_CTX* context = HMAC_CTX_new();
+    if (context == nullptr ||
+        HMAC_Init_ex(context, key.data(), key.size(), EVP_sha256(), nullptr) != 1) {
+        LOG_ALWAYS_FATAL("Can't initialize HMAC context");
+    }
+    return context;
+}
+
+void HmacKeyManager::HmacContextDeleter::operator()(hmac_ctx_st* context) const {
+    HMAC_CTX_free(context);
+}
+
+HmacKeyManager::HmacKeyManager() : mKeyedContext(createKeyedContext()) {}
 
 std::array<uint8_t, 32> HmacKeyManager::sign(const uint8_t* data, size_t size) const {
     // SHA256 always generates 32-bytes result
     std::array<uint8_t, 32> hash;
     unsigned int hashLen = 0;
-    uint8_t* result =
-            HMAC(EVP_sha256(), mHmacKey.data(), mHmacKey.size(), data, size, hash.data(), &hashLen);
-    if (result == nullptr) {
+    bssl::ScopedHMAC_CTX context;
+    if (HMAC_CTX_copy_ex(context.get(), mKeyedContext.get()) != 1 ||
+        HMAC_Update(context.get(), data, size) != 1 ||
+        HMAC_Final(context.get(), hash.data(), &hashLen) != 1) {
         ALOGE("Could not sign the data using HMAC");
         return INVALID_HMAC;
     }
@@ -49,4 +49,18 @@ TEST_F(HmacKeyManagerTest, GeneratedHmac_ChangesWhenFieldsChange) {
     ASSERT_NE(initialHmac, mHmacKeyManager.sign(data.data(), sizeof(data)));
 }
 
+/**
+ * Ensure that signing other data in between doesn't change the hmac of the same data.
+ */
+TEST_F(HmacKeyManagerTest, GeneratedHmac_IsIndependentOfPreviousData) {
+    std::array<uint8_t, 10> data = {4, 3, 5, 1, 8, 5, 2, 7, 1, 8};
+    std::array<uint8_t, 100> otherData = {};
+    otherData.fill(9);
+
+    std::array<uint8_t, 32> hmac1 = mHmacKeyManager.sign(data.data(), sizeof(data));
+    mHmacKeyManager.sign(otherData.data(), sizeof(otherData));
+    std::array<uint8_t, 32> hmac2 = mHmacKeyManager.sign(data.data(), sizeof(data));
+    ASSERT_EQ(hmac1, hmac2);
+}
+
 } // namespace android
\ No newline at end of file
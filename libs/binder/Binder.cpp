@@ -23,10 +23,13 @@
 #include <binder/IResultReceiver.h>
 #include <binder/IShellCallback.h>
 #include <binder/Parcel.h>
+#include <binder/TransactionLatencyStats.h>
 
 #include <linux/sched.h>
 #include <stdio.h>
 
+#include "TransactionLatency.h"
+
 namespace android {
 
 // Service implementations inherit from BBinder and IBinder, and this is frozen
@@ -136,6 +139,24 @@ status_t IBinder::getDebugPid(pid_t* out) {
     return OK;
 }
 
+status_t IBinder::getTransactionLatencyStats(TransactionLatencyStats* out) {
+    BBinder* local = this->localBinder();
+    if (local != nullptr) {
+        *out = collectTransactionLatencyStats();
+        return OK;
+    }
+
+    BpBinder* proxy = this->remoteBinder();
+    LOG_ALWAYS_FATAL_IF(proxy == nullptr);
+
+    Parcel data;
+    Parcel reply;
+    status_t status = transact(TRANSACTION_LATENCY_TRANSACTION, data, &reply);
+    if (status != OK) return status;
+
+    return out->readFromParcel(&reply);
+}
+
 // ---------------------------------------------------------------------------
 
 class BBinder::Extras
@@ -199,6 +220,9 @@ status_t BBinder::transact(
         case DEBUG_PID_TRANSACTION:
             err = reply->writeInt32(getDebugPid());
             break;
+        case TRANSACTION_LATENCY_TRANSACTION:
+            err = collectTransactionLatencyStats().writeToParcel(reply);
+            break;
         default:
             err = onTransact(code, data, reply, flags);
             break;
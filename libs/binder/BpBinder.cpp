@@ -258,7 +258,9 @@ status_t BpBinder::transact(
         if (code >= FIRST_CALL_TRANSACTION && code <= LAST_CALL_TRANSACTION) {
             using android::internal::Stability;
 
-            auto category = Stability::getCategory(this);
+            // Read directly rather than through getCategory(), which has to find out what kind
+            // of binder this is.
+            auto category = Stability::Category::fromRepr(mStability);
             Stability::Level required = privateVendor ? Stability::VENDOR
                 : Stability::getLocalLevel();
 
@@ -30,8 +30,12 @@
 #include <utils/threads.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <errno.h>
 #include <inttypes.h>
+#include <mutex>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <signal.h>
@@ -41,6 +45,7 @@
 #include <unistd.h>
 
 #include "Static.h"
+#include "TransactionLatency.h"
 #include "binder_module.h"
 
 #if LOG_NDEBUG
@@ -116,6 +121,9 @@ static const char *kCommandStrings[] = {
 
 static const int64_t kWorkSourcePropagatedBitIndex = 32;
 
+// Each reference count command takes 8 bytes, so about 30 of them are written out together.
+static const size_t kMaxDeferredRefCommandsSize = 256;
+
 static const char* getReturnString(uint32_t cmd)
 {
     size_t idx = cmd & _IOC_NRMASK;
@@ -285,6 +293,12 @@ static pthread_key_t gTLS = 0;
 static std::atomic<bool> gShutdown = false;
 static std::atomic<bool> gDisableBackgroundScheduling = false;
 
+// Idle pooled threads of an adaptive thread pool take turns reading from the
+// driver, see waitForPooledWork.
+[[clang::no_destroy]] static std::mutex gPooledReadMutex;
+[[clang::no_destroy]] static std::condition_variable gPooledReadDone;
+static bool gPooledReadActive = false; // guarded by gPooledReadMutex
+
 IPCThreadState* IPCThreadState::self()
 {
     if (gHaveTLS.load(std::memory_order_acquire)) {
@@ -550,6 +564,7 @@ status_t IPCThreadState::getAndExecuteCommand()
                 ALOGE("binder thread pool (%zu threads) starved for %" PRId64 " ms",
                       mProcess->mMaxThreads, starvationTimeMs);
             }
+            mProcess->onThreadPoolStarvedLocked(starvationTimeMs);
             mProcess->mStarvationStartTimeMs = 0;
         }
 
@@ -564,6 +579,70 @@ status_t IPCThreadState::getAndExecuteCommand()
     return result;
 }
 
+// A thread blocked in the driver can't time out, so to let idle threads leave
+// an adaptive pool, they poll the driver instead. Only one of them at a time
+// blocks in the driver, so that the driver still sees a thread waiting for
+// work, and doesn't ask for more threads while others are polling.
+//
+// Returns TIMED_OUT if this thread should leave the pool. Otherwise, either
+// mIn has been filled or this thread should block in the driver as usual.
+status_t IPCThreadState::waitForPooledWork()
+{
+    if (mIn.dataPosition() < mIn.dataSize()) return NO_ERROR;
+
+    pthread_mutex_lock(&mProcess->mThreadCountLock);
+    const int64_t idleTimeoutMs =
+            mProcess->mAdaptiveMaxThreads != 0 ? mProcess->mAdaptiveIdleTimeoutMs : 0;
+    pthread_mutex_unlock(&mProcess->mThreadCountLock);
+    if (idleTimeoutMs == 0) return NO_ERROR;
+
+    // The driver only lets registered loopers poll, and BC_REGISTER_LOOPER
+    // may still be in mOut, along with buffers to free.
+    if (mOut.dataSize() > 0) {
+        status_t result = talkWithDriver(false);
+        if (result != NO_ERROR) return result;
+    }
+
+    using std::chrono::steady_clock;
+    const steady_clock::time_point deadline =
+            steady_clock::now() + std::chrono::milliseconds(idleTimeoutMs);
+
+    std::unique_lock<std::mutex> lock(gPooledReadMutex);
+    while (true) {
+        if (!gPooledReadActive) {
+            gPooledReadActive = true;
+            lock.unlock();
+            status_t result = talkWithDriver();
+            lock.lock();
+            gPooledReadActive = false;
+            lock.unlock();
+            gPooledReadDone.notify_all();
+            return result;
+        }
+        lock.unlock();
+
+        const int64_t remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            deadline - steady_clock::now())
+                                            .count();
+        int ret = 0;
+        if (remainingMs > 0) {
+            struct pollfd pfd = {.fd = mProcess->mDriverFD, .events = POLLIN, .revents = 0};
+            ret = TEMP_FAILURE_RETRY(poll(&pfd, 1, static_cast<int>(remainingMs)));
+            if (ret < 0) return -errno;
+        }
+        if (ret == 0 && steady_clock::now() >= deadline) {
+            // If the pool stopped adapting, block in the driver instead.
+            return mProcess->retireIdlePooledThread() ? TIMED_OUT : NO_ERROR;
+        }
+
+        // All polling threads are woken for work which no blocked thread is
+        // there to take. Polling again would return straight away until the
+        // reader has taken it, so wait for the reader.
+        lock.lock();
+        gPooledReadDone.wait_until(lock, deadline, [] { return !gPooledReadActive; });
+    }
+}
+
 // When we've cleared the incoming command queue, process any pending derefs
 void IPCThreadState::processPendingDerefs()
 {
@@ -625,7 +704,10 @@ void IPCThreadState::joinThreadPool(bool isMain)
     do {
         processPendingDerefs();
         // now get the next command to be processed, waiting if necessary
-        result = getAndExecuteCommand();
+        result = isMain ? NO_ERROR : waitForPooledWork();
+        if (result == NO_ERROR) {
+            result = getAndExecuteCommand();
+        }
 
         if (result < NO_ERROR && result != TIMED_OUT && result != -ECONNREFUSED && result != -EBADF) {
             LOG_ALWAYS_FATAL("getAndExecuteCommand(fd=%d) returned unexpected error %d, aborting",
@@ -726,12 +808,18 @@ status_t IPCThreadState::transact(int32_t handle,
             ALOGI(">>>>>> CALLING transaction %d", code);
         }
         #endif
+        const bool trackLatency = isTransactionLatencyTrackingEnabled();
+        const nsecs_t start = trackLatency ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
         if (reply) {
             err = waitForResponse(reply);
         } else {
             Parcel fakeReply;
             err = waitForResponse(&fakeReply);
         }
+        if (trackLatency) {
+            recordTransactionLatency(handle, code, false /*server*/, data,
+                                     systemTime(SYSTEM_TIME_MONOTONIC) - start);
+        }
         #if 0
         if (code == 4) { // relayout
             ALOGI("<<<<<< RETURNING transaction 4");
@@ -754,12 +842,28 @@ status_t IPCThreadState::transact(int32_t handle,
     return err;
 }
 
+void IPCThreadState::setRefCommandsDeferred(bool deferred)
+{
+    mRefCommandsDeferred = deferred;
+    if (!deferred) {
+        flushIfNeeded();
+    }
+}
+
+bool IPCThreadState::flushRefCommandsIfNeeded()
+{
+    if (mRefCommandsDeferred && mOut.dataSize() < kMaxDeferredRefCommandsSize) {
+        return false;
+    }
+    return flushIfNeeded();
+}
+
 void IPCThreadState::incStrongHandle(int32_t handle, BpBinder *proxy)
 {
     LOG_REMOTEREFS("IPCThreadState::incStrongHandle(%d)\n", handle);
     mOut.writeInt32(BC_ACQUIRE);
     mOut.writeInt32(handle);
-    if (!flushIfNeeded()) {
+    if (!flushRefCommandsIfNeeded()) {
         // Create a temp reference until the driver has handled this command.
         proxy->incStrong(mProcess.get());
         mPostWriteStrongDerefs.push(proxy);
@@ -771,7 +875,7 @@ void IPCThreadState::decStrongHandle(int32_t handle)
     LOG_REMOTEREFS("IPCThreadState::decStrongHandle(%d)\n", handle);
     mOut.writeInt32(BC_RELEASE);
     mOut.writeInt32(handle);
-    flushIfNeeded();
+    flushRefCommandsIfNeeded();
 }
 
 void IPCThreadState::incWeakHandle(int32_t handle, BpBinder *proxy)
@@ -779,7 +883,7 @@ void IPCThreadState::incWeakHandle(int32_t handle, BpBinder *proxy)
     LOG_REMOTEREFS("IPCThreadState::incWeakHandle(%d)\n", handle);
     mOut.writeInt32(BC_INCREFS);
     mOut.writeInt32(handle);
-    if (!flushIfNeeded()) {
+    if (!flushRefCommandsIfNeeded()) {
         // Create a temp reference until the driver has handled this command.
         proxy->getWeakRefs()->incWeak(mProcess.get());
         mPostWriteWeakDerefs.push(proxy->getWeakRefs());
@@ -791,7 +895,7 @@ void IPCThreadState::decWeakHandle(int32_t handle)
     LOG_REMOTEREFS("IPCThreadState::decWeakHandle(%d)\n", handle);
     mOut.writeInt32(BC_DECREFS);
     mOut.writeInt32(handle);
-    flushIfNeeded();
+    flushRefCommandsIfNeeded();
 }
 
 status_t IPCThreadState::attemptIncStrongHandle(int32_t handle)
@@ -849,6 +953,7 @@ IPCThreadState::IPCThreadState()
         mPropagateWorkSource(false),
         mIsLooper(false),
         mIsFlushing(false),
+        mRefCommandsDeferred(false),
         mStrictModePolicy(0),
         mLastTransactionBinderFlags(0),
         mCallRestriction(mProcess->mCallRestriction) {
@@ -1262,6 +1367,8 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                     << ", offsets addr="
                     << reinterpret_cast<const size_t*>(tr.data.ptr.offsets) << endl;
             }
+            const bool trackLatency = isTransactionLatencyTrackingEnabled();
+            const nsecs_t start = trackLatency ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
             if (tr.target.ptr) {
                 // We only have a weak reference on the target object, so we must first try to
                 // safely acquire a strong reference before doing anything else with it.
@@ -1277,6 +1384,10 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
             } else {
                 error = the_context_object->transact(tr.code, buffer, &reply, tr.flags);
             }
+            if (trackLatency) {
+                recordTransactionLatency(tr.cookie, tr.code, true /*server*/, buffer,
+                                         systemTime(SYSTEM_TIME_MONOTONIC) - start);
+            }
 
             //ALOGI("<<<< TRANSACT from pid %d restore pid %d sid %s uid %d\n",
             //     mCallingPid, origPid, (origSid ? origSid : "<N/A>"), origUid);
@@ -21,6 +21,9 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <map>
+#include <set>
+
 #include <android/os/BnServiceCallback.h>
 #include <android/os/IServiceManager.h>
 #include <binder/IPCThreadState.h>
@@ -61,6 +64,15 @@ const String16& IServiceManager::getInterfaceDescriptor() const {
 IServiceManager::IServiceManager() {}
 IServiceManager::~IServiceManager() {}
 
+Vector<sp<IBinder>> IServiceManager::checkServices(const Vector<String16>& names) const {
+    Vector<sp<IBinder>> ret;
+    ret.setCapacity(names.size());
+    for (const String16& name : names) {
+        ret.push_back(checkService(name));
+    }
+    return ret;
+}
+
 // From the old libbinder IServiceManager interface to IServiceManager.
 class ServiceManagerShim : public IServiceManager
 {
@@ -76,6 +88,7 @@ public:
     bool isDeclared(const String16& name) override;
     Vector<String16> getDeclaredInstances(const String16& interface) override;
     std::optional<String16> updatableViaApex(const String16& name) override;
+    Vector<sp<IBinder>> checkServices(const Vector<String16>& names) const override;
 
     // for legacy ABI
     const String16& getInterfaceDescriptor() const override {
@@ -85,9 +98,99 @@ public:
         return IInterface::asBinder(mTheRealServiceManager).get();
     }
 private:
+    class ServiceCache;
+
+    sp<IBinder> getCachedService(const std::string& name, uint64_t* outGeneration) const;
+    void cacheService(const std::string& name, const sp<IBinder>& binder,
+                      uint64_t generation) const;
+
     sp<AidlServiceManager> mTheRealServiceManager;
+    sp<ServiceCache> mCache;
+};
+
+static std::atomic<bool> gServiceCacheEnabled = false;
+
+// Binders found by this process, by name. An entry is dropped when its binder
+// dies, or when servicemanager says that the name was registered again, so a
+// cached binder is never one that servicemanager would no longer return.
+class ServiceManagerShim::ServiceCache : public android::os::BnServiceCallback,
+                                         public IBinder::DeathRecipient {
+public:
+    // 'outGeneration' is to be passed to add, for what servicemanager returns
+    // if this returns null.
+    sp<IBinder> get(const std::string& name, uint64_t* outGeneration) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        *outGeneration = mGeneration;
+        auto it = mServices.find(name);
+        if (it == mServices.end()) return nullptr;
+        return it->second;
+    }
+
+    void add(const sp<AidlServiceManager>& sm, const std::string& name,
+             const sp<IBinder>& binder, uint64_t generation) {
+        bool registered;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mServices.count(name) != 0) return;
+            registered = mRegistered.count(name) != 0;
+        }
+
+        sp<ServiceCache> thiz = sp<ServiceCache>::fromExisting(this);
+        const bool remote = binder->remoteBinder() != nullptr;
+        // Local binders can't die, this returns INVALID_OPERATION for them.
+        if (remote && binder->linkToDeath(thiz) != OK) return;
+
+        // Done only once per name, and we stay registered for as long as the
+        // process lives, since the name might be looked up again.
+        if (!registered && !sm->registerForNotifications(name, thiz).isOk()) {
+            // e.g. no permission to find this name in the first place
+            if (remote) binder->unlinkToDeath(thiz);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRegistered.insert(name);
+        // Something changed since 'binder' was looked up, it may be stale.
+        if (generation != mGeneration) return;
+        mServices.emplace(name, binder);
+    }
+
+    Status onRegistration(const std::string& name, const sp<IBinder>& /*binder*/) override {
+        // Also sent right after registering, for the binder that is already
+        // cached. That only costs one more lookup, so it isn't special cased.
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGeneration++;
+        mServices.erase(name);
+        return Status::ok();
+    }
+
+    void binderDied(const wp<IBinder>& who) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGeneration++;
+        for (auto it = mServices.begin(); it != mServices.end();) {
+            if (it->second.get() == who.unsafe_get()) {
+                it = mServices.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+private:
+    std::mutex mMutex;
+    // incremented on every notification, whatever service it is for
+    uint64_t mGeneration = 0;
+    std::map<std::string, sp<IBinder>> mServices;
+    // names which we get registration callbacks for
+    std::set<std::string> mRegistered;
 };
 
+void setServiceCacheEnabled(bool enabled) {
+    // Entries are kept up to date while this is disabled, so they don't need
+    // to be cleared here.
+    gServiceCacheEnabled = enabled;
+}
+
 [[clang::no_destroy]] static std::once_flag gSmOnce;
 [[clang::no_destroy]] static sp<IServiceManager> gDefaultServiceManager;
 
@@ -206,9 +309,24 @@ bool checkPermission(const String16& permission, pid_t pid, uid_t uid)
 // ----------------------------------------------------------------------
 
 ServiceManagerShim::ServiceManagerShim(const sp<AidlServiceManager>& impl)
- : mTheRealServiceManager(impl)
+ : mTheRealServiceManager(impl), mCache(sp<ServiceCache>::make())
 {}
 
+sp<IBinder> ServiceManagerShim::getCachedService(const std::string& name,
+                                                 uint64_t* outGeneration) const
+{
+    *outGeneration = 0;
+    if (!gServiceCacheEnabled.load(std::memory_order_relaxed)) return nullptr;
+    return mCache->get(name, outGeneration);
+}
+
+void ServiceManagerShim::cacheService(const std::string& name, const sp<IBinder>& binder,
+                                      uint64_t generation) const
+{
+    if (binder == nullptr || !gServiceCacheEnabled.load(std::memory_order_relaxed)) return;
+    mCache->add(mTheRealServiceManager, name, binder, generation);
+}
+
 // This implementation could be simplified and made more efficient by delegating
 // to waitForService. However, this changes the threading structure in some
 // cases and could potentially break prebuilts. Once we have higher logistical
@@ -259,10 +377,49 @@ sp<IBinder> ServiceManagerShim::getService(const String16& name) const
 
 sp<IBinder> ServiceManagerShim::checkService(const String16& name) const
 {
-    sp<IBinder> ret;
-    if (!mTheRealServiceManager->checkService(String8(name).c_str(), &ret).isOk()) {
+    const std::string name8 = String8(name).c_str();
+    uint64_t generation;
+    sp<IBinder> ret = getCachedService(name8, &generation);
+    if (ret != nullptr) return ret;
+
+    if (!mTheRealServiceManager->checkService(name8, &ret).isOk()) {
         return nullptr;
     }
+    cacheService(name8, ret, generation);
+    return ret;
+}
+
+Vector<sp<IBinder>> ServiceManagerShim::checkServices(const Vector<String16>& names) const
+{
+    std::vector<std::string> names8;
+    names8.reserve(names.size());
+    Vector<sp<IBinder>> ret;
+    ret.setCapacity(names.size());
+    bool allCached = true;
+    uint64_t generation = 0;
+    for (const String16& name : names) {
+        names8.push_back(String8(name).c_str());
+        uint64_t nameGeneration;
+        ret.push_back(getCachedService(names8.back(), &nameGeneration));
+        // the first one read is the oldest
+        if (ret.size() == 1) generation = nameGeneration;
+        allCached = allCached && ret.top() != nullptr;
+    }
+    if (allCached) return ret;
+    ret.clear();
+
+    std::optional<std::vector<sp<IBinder>>> binders;
+    if (!mTheRealServiceManager->checkServices(names8, &binders).isOk() ||
+        !binders.has_value() || binders->size() != names.size()) {
+        // e.g. a servicemanager from before this was added
+        return IServiceManager::checkServices(names);
+    }
+
+    ret.setCapacity(binders->size());
+    for (size_t i = 0; i < binders->size(); i++) {
+        cacheService(names8[i], (*binders)[i], generation);
+        ret.push_back(std::move((*binders)[i]));
+    }
     return ret;
 }
 
@@ -319,11 +476,17 @@ sp<IBinder> ServiceManagerShim::waitForService(const String16& name16)
 
     const std::string name = String8(name16).c_str();
 
-    sp<IBinder> out;
+    uint64_t generation;
+    sp<IBinder> out = getCachedService(name, &generation);
+    if (out != nullptr) return out;
+
     if (!mTheRealServiceManager->getService(name, &out).isOk()) {
         return nullptr;
     }
-    if (out != nullptr) return out;
+    if (out != nullptr) {
+        cacheService(name, out, generation);
+        return out;
+    }
 
     sp<Waiter> waiter = sp<Waiter>::make();
     if (!mTheRealServiceManager->registerForNotifications(
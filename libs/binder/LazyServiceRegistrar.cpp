@@ -24,11 +24,49 @@
 #include <android/os/IServiceManager.h>
 #include <utils/Log.h>
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
 namespace android {
 namespace binder {
 namespace internal {
 
 using AidlServiceManager = android::os::IServiceManager;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+// Time elapsed since this process was started, as recorded by the kernel.
+static std::optional<milliseconds> getTimeSinceProcessStart() {
+    FILE* file = fopen("/proc/self/stat", "re");
+    if (file == nullptr) return std::nullopt;
+    char buf[1024];
+    size_t size = fread(buf, 1, sizeof(buf) - 1, file);
+    fclose(file);
+    buf[size] = '\0';
+
+    // the command name may contain spaces, the fields are counted from its closing ')'
+    const char* fields = strrchr(buf, ')');
+    unsigned long long startTicks;
+    if (fields == nullptr ||
+        sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d "
+                           "%*d %*d %llu", &startTicks) != 1) {
+        return std::nullopt;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (ticksPerSecond <= 0) return std::nullopt;
+    return milliseconds(now.tv_sec * 1000LL + now.tv_nsec / 1000000 -
+                        static_cast<long long>(startTicks * 1000 / ticksPerSecond));
+}
 
 class ClientCounterCallbackImpl : public ::android::os::BnClientCallback {
 public:
@@ -40,6 +78,8 @@ public:
 
     void setActiveServicesCallback(const std::function<bool(bool)>& activeServicesCallback);
 
+    void setShutdownDelay(milliseconds minDelay, milliseconds maxDelay);
+
     bool tryUnregisterLocked();
 
     void reRegisterLocked();
@@ -81,6 +121,18 @@ private:
      */
     void maybeTryShutdownLocked();
 
+    /**
+     * Shuts down now, or after the shutdown delay from the thread running shutdownLoop.
+     */
+    void scheduleShutdownLocked();
+    milliseconds getShutdownDelayLocked() const;
+    void shutdownLoop();
+
+    /**
+     * Records the times the services spent without clients, for the shutdown delay.
+     */
+    void updateIdleTimesLocked(size_t previousNumConnectedServices);
+
     // for below
     std::mutex mMutex;
 
@@ -97,6 +149,21 @@ private:
 
     // Callback used to report if there are services with clients
     std::function<bool(bool)> mActiveServicesCallback;
+
+    milliseconds mMinShutdownDelay{0};
+    milliseconds mMaxShutdownDelay{0};
+
+    // when the services last lost all their clients, while they have none
+    std::optional<steady_clock::time_point> mIdleSince;
+    // moving average of the times the services stayed without clients before being used again
+    std::optional<milliseconds> mAverageIdleTime;
+    // number of times the services got clients again after having none
+    size_t mNumIdleReturns = 0;
+
+    // when the pending delayed shutdown is due
+    std::optional<steady_clock::time_point> mShutdownDeadline;
+    std::condition_variable mShutdownCondition;
+    bool mShutdownThreadStarted = false;
 };
 
 class ClientCounterCallback {
@@ -113,6 +180,8 @@ public:
 
     void setActiveServicesCallback(const std::function<bool(bool)>& activeServicesCallback);
 
+    void setShutdownDelay(milliseconds minDelay, milliseconds maxDelay);
+
     bool tryUnregister();
 
     void reRegister();
@@ -142,6 +211,14 @@ bool ClientCounterCallbackImpl::registerServiceLocked(const sp<IBinder>& service
         return false;
     }
 
+    if (mRegisteredServices.empty()) {
+        // how long a client waiting for the first service of this process waited for it to start
+        if (std::optional<milliseconds> startTime = getTimeSinceProcessStart()) {
+            ALOGI("Registered service %s %" PRId64 " ms after the process started", name.c_str(),
+                  static_cast<int64_t>(startTime->count()));
+        }
+    }
+
     if (!reRegister) {
         if (Status status =
                     manager->registerClientCallback(name, service,
@@ -236,7 +313,71 @@ void ClientCounterCallbackImpl::maybeTryShutdownLocked() {
     // client count change event, try to shutdown the process if its services
     // have no clients.
     if (!handledInCallback && mNumConnectedServices == 0) {
+        scheduleShutdownLocked();
+    }
+}
+
+milliseconds ClientCounterCallbackImpl::getShutdownDelayLocked() const {
+    if (!mAverageIdleTime) return mMinShutdownDelay;
+    return std::clamp(*mAverageIdleTime * 2, mMinShutdownDelay,
+                      std::max(mMinShutdownDelay, mMaxShutdownDelay));
+}
+
+void ClientCounterCallbackImpl::scheduleShutdownLocked() {
+    const milliseconds delay = getShutdownDelayLocked();
+    if (delay == milliseconds::zero()) {
         tryShutdownLocked();
+        return;
+    }
+
+    ALOGI("Shutting down in %" PRId64 " ms unless the services get clients again.",
+          static_cast<int64_t>(delay.count()));
+    mShutdownDeadline = steady_clock::now() + delay;
+    if (!mShutdownThreadStarted) {
+        // the callback lives as long as the registrar, until the process exits
+        std::thread([self = sp<ClientCounterCallbackImpl>::fromExisting(this)] {
+            self->shutdownLoop();
+        }).detach();
+        mShutdownThreadStarted = true;
+    }
+    mShutdownCondition.notify_one();
+}
+
+void ClientCounterCallbackImpl::shutdownLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        if (!mShutdownDeadline) {
+            mShutdownCondition.wait(lock);
+            continue;
+        }
+        if (steady_clock::now() < *mShutdownDeadline) {
+            mShutdownCondition.wait_until(lock, *mShutdownDeadline);
+            continue;
+        }
+
+        mShutdownDeadline.reset();
+        if (mForcePersist) {
+            ALOGI("Shutdown prevented by forcePersist override flag.");
+        } else if (mNumConnectedServices == 0) {
+            tryShutdownLocked();
+        }
+    }
+}
+
+void ClientCounterCallbackImpl::updateIdleTimesLocked(size_t previousNumConnectedServices) {
+    if (previousNumConnectedServices != 0 && mNumConnectedServices == 0) {
+        mIdleSince = steady_clock::now();
+    } else if (previousNumConnectedServices == 0 && mNumConnectedServices != 0) {
+        // a client came back in time, the pending shutdown is cancelled
+        mShutdownDeadline.reset();
+        if (mIdleSince) {
+            const milliseconds idleTime =
+                    std::chrono::duration_cast<milliseconds>(steady_clock::now() - *mIdleSince);
+            mAverageIdleTime = mAverageIdleTime ? (*mAverageIdleTime * 3 + idleTime) / 4
+                                                : idleTime;
+            mNumIdleReturns++;
+            mIdleSince.reset();
+        }
     }
 }
 
@@ -256,7 +397,9 @@ Status ClientCounterCallbackImpl::onClients(const sp<IBinder>& service, bool cli
              (void) name;
              if (registered.clients) numWithClients++;
          }
+         const size_t previousNumConnectedServices = mNumConnectedServices;
          mNumConnectedServices = numWithClients;
+         updateIdleTimesLocked(previousNumConnectedServices);
     }
 
     ALOGI("Process has %zu (of %zu available) client(s) in use after notification %s has clients: %d",
@@ -270,7 +413,12 @@ void ClientCounterCallbackImpl::tryShutdownLocked() {
     ALOGI("Trying to shut down the service. No clients in use for any service in process.");
 
     if (tryUnregisterLocked()) {
-        ALOGI("Unregistered all clients and exiting");
+        // the uptime and the number of times clients came back help tuning the shutdown delay
+        std::optional<milliseconds> uptime = getTimeSinceProcessStart();
+        ALOGI("Unregistered all clients and exiting after %" PRId64 " ms, clients came back "
+              "%zu time(s) after the services had none (average idle time %" PRId64 " ms)",
+              uptime ? static_cast<int64_t>(uptime->count()) : -1, mNumIdleReturns,
+              mAverageIdleTime ? static_cast<int64_t>(mAverageIdleTime->count()) : -1);
         exit(EXIT_SUCCESS);
     }
 
@@ -283,6 +431,12 @@ void ClientCounterCallbackImpl::setActiveServicesCallback(const std::function<bo
     mActiveServicesCallback = activeServicesCallback;
 }
 
+void ClientCounterCallbackImpl::setShutdownDelay(milliseconds minDelay, milliseconds maxDelay) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMinShutdownDelay = minDelay;
+    mMaxShutdownDelay = maxDelay;
+}
+
 ClientCounterCallback::ClientCounterCallback() {
       mImpl = sp<ClientCounterCallbackImpl>::make();
 }
@@ -301,6 +455,10 @@ void ClientCounterCallback::setActiveServicesCallback(const std::function<bool(b
     mImpl->setActiveServicesCallback(activeServicesCallback);
 }
 
+void ClientCounterCallback::setShutdownDelay(milliseconds minDelay, milliseconds maxDelay) {
+    mImpl->setShutdownDelay(minDelay, maxDelay);
+}
+
 bool ClientCounterCallback::tryUnregister() {
     // see comments in header, this should only be called from the active
     // services callback, see also b/191781736
@@ -341,6 +499,11 @@ void LazyServiceRegistrar::setActiveServicesCallback(const std::function<bool(bo
     mClientCC->setActiveServicesCallback(activeServicesCallback);
 }
 
+void LazyServiceRegistrar::setShutdownDelay(std::chrono::milliseconds minDelay,
+                                            std::chrono::milliseconds maxDelay) {
+    mClientCC->setShutdownDelay(minDelay, maxDelay);
+}
+
 bool LazyServiceRegistrar::tryUnregister() {
     return mClientCC->tryUnregister();
 }
@@ -25,6 +25,11 @@
 #include <utils/String8.h>
 #include <utils/threads.h>
 
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -120,7 +125,23 @@ private:
 
 // ----------------------------------------------------------------------------
 
-class SimpleBestFitAllocator
+// align all the memory blocks on a cache-line boundary
+static constexpr int kMemoryAlign = 32;
+
+class SubAllocator
+{
+public:
+    virtual ~SubAllocator() = default;
+
+    // returns the offset of the allocated block, or NO_MEMORY
+    virtual size_t      allocate(size_t size) = 0;
+    virtual status_t    deallocate(size_t offset) = 0;
+    virtual size_t      size() const = 0;
+    virtual void        dump(const char* what) const = 0;
+    virtual void        getFreeSizes(size_t* freeSize, size_t* largestFreeSize) const = 0;
+};
+
+class SimpleBestFitAllocator : public SubAllocator
 {
     enum {
         PAGE_ALIGNED = 0x00000001
@@ -129,13 +150,13 @@ public:
     explicit SimpleBestFitAllocator(size_t size);
     ~SimpleBestFitAllocator();
 
-    size_t      allocate(size_t size, uint32_t flags = 0);
-    status_t    deallocate(size_t offset);
-    size_t      size() const;
-    void        dump(const char* what) const;
+    size_t      allocate(size_t size) override { return allocate(size, 0); }
+    size_t      allocate(size_t size, uint32_t flags);
+    status_t    deallocate(size_t offset) override;
+    size_t      size() const override;
+    void        dump(const char* what) const override;
     void        dump(String8& res, const char* what) const;
-
-    static size_t getAllocationAlignment() { return kMemoryAlign; }
+    void        getFreeSizes(size_t* freeSize, size_t* largestFreeSize) const override;
 
 private:
 
@@ -155,12 +176,48 @@ private:
     void     dump_l(const char* what) const;
     void     dump_l(String8& res, const char* what) const;
 
-    static const int    kMemoryAlign;
     mutable Mutex       mLock;
     LinkedList<chunk_t> mList;
     size_t              mHeapSize;
 };
 
+/*
+ * A buddy allocator: blocks are kMemoryAlign << order bytes, aligned on their size, and each
+ * order has its own free list. Allocating splits the smallest free block that fits in halves,
+ * freeing merges a block with its buddy (the other half of the block it was split from) while
+ * that one is free too. Both are O(log(heap size)) whatever the number of allocations.
+ *
+ * The bookkeeping is kept out of the heap, which may not be mapped locally.
+ */
+class SizeClassAllocator : public SubAllocator
+{
+public:
+    explicit SizeClassAllocator(size_t size);
+
+    size_t      allocate(size_t size) override;
+    status_t    deallocate(size_t offset) override;
+    size_t      size() const override;
+    void        dump(const char* what) const override;
+    void        getFreeSizes(size_t* freeSize, size_t* largestFreeSize) const override;
+
+private:
+    static size_t blockSize(size_t order) { return size_t(kMemoryAlign) << order; }
+    void getFreeSizes_l(size_t* freeSize, size_t* largestFreeSize) const;
+
+    mutable Mutex                       mLock;
+    // offsets of the free blocks of each order, lowest first
+    std::vector<std::set<size_t>>       mFreeBlocks;
+    struct Block {
+        size_t order;
+        size_t requestedSize;
+    };
+    // allocated blocks, by offset
+    std::unordered_map<size_t, Block>   mAllocatedBlocks;
+    size_t                              mHeapSize;
+    // bytes asked for by the current allocations, to tell how much rounding up wastes
+    size_t                              mRequestedSize = 0;
+};
+
 // ----------------------------------------------------------------------------
 
 Allocation::Allocation(
@@ -228,8 +285,14 @@ Allocation::~Allocation()
 // ----------------------------------------------------------------------------
 
 MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags)
+      : MemoryDealer(size, name, flags, AllocationPolicy::BEST_FIT) {}
+
+MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags,
+                           AllocationPolicy policy)
       : mHeap(sp<MemoryHeapBase>::make(size, flags, name)),
-        mAllocator(new SimpleBestFitAllocator(size)) {}
+        mAllocator(policy == AllocationPolicy::SIZE_CLASSES
+                           ? static_cast<SubAllocator*>(new SizeClassAllocator(size))
+                           : new SimpleBestFitAllocator(size)) {}
 
 MemoryDealer::~MemoryDealer()
 {
@@ -260,20 +323,31 @@ const sp<IMemoryHeap>& MemoryDealer::heap() const {
     return mHeap;
 }
 
-SimpleBestFitAllocator* MemoryDealer::allocator() const {
+SubAllocator* MemoryDealer::allocator() const {
     return mAllocator;
 }
 
 // static
 size_t MemoryDealer::getAllocationAlignment()
 {
-    return SimpleBestFitAllocator::getAllocationAlignment();
+    return kMemoryAlign;
 }
 
-// ----------------------------------------------------------------------------
+size_t MemoryDealer::getFreeSize() const
+{
+    size_t freeSize, largestFreeSize;
+    allocator()->getFreeSizes(&freeSize, &largestFreeSize);
+    return freeSize;
+}
 
-// align all the memory blocks on a cache-line boundary
-const int SimpleBestFitAllocator::kMemoryAlign = 32;
+size_t MemoryDealer::getLargestFreeSize() const
+{
+    size_t freeSize, largestFreeSize;
+    allocator()->getFreeSizes(&freeSize, &largestFreeSize);
+    return largestFreeSize;
+}
+
+// ----------------------------------------------------------------------------
 
 SimpleBestFitAllocator::SimpleBestFitAllocator(size_t size)
 {
@@ -425,6 +499,19 @@ void SimpleBestFitAllocator::dump(const char* what) const
     dump_l(what);
 }
 
+void SimpleBestFitAllocator::getFreeSizes(size_t* freeSize, size_t* largestFreeSize) const
+{
+    Mutex::Autolock _l(mLock);
+    *freeSize = 0;
+    *largestFreeSize = 0;
+    for (chunk_t const* cur = mList.head(); cur; cur = cur->next) {
+        if (cur->free) {
+            *freeSize += size_t(cur->size) * kMemoryAlign;
+            *largestFreeSize = std::max(*largestFreeSize, size_t(cur->size) * kMemoryAlign);
+        }
+    }
+}
+
 void SimpleBestFitAllocator::dump_l(const char* what) const
 {
     String8 result;
@@ -478,5 +565,124 @@ void SimpleBestFitAllocator::dump_l(String8& result,
     result.append(buffer);
 }
 
+// ----------------------------------------------------------------------------
+
+SizeClassAllocator::SizeClassAllocator(size_t size)
+{
+    size_t pagesize = getpagesize();
+    mHeapSize = ((size + pagesize-1) & ~(pagesize-1));
+
+    size_t maxOrder = 0;
+    while (blockSize(maxOrder + 1) <= mHeapSize) maxOrder++;
+    mFreeBlocks.resize(maxOrder + 1);
+
+    // Cover the heap with the largest blocks that fit, largest first. Each block is then
+    // aligned on its size, and the buddy of one is never a block of the same order.
+    size_t offset = 0;
+    for (size_t order = maxOrder + 1; order-- > 0;) {
+        if (mHeapSize - offset >= blockSize(order)) {
+            mFreeBlocks[order].insert(offset);
+            offset += blockSize(order);
+        }
+    }
+}
+
+size_t SizeClassAllocator::size() const
+{
+    return mHeapSize;
+}
+
+size_t SizeClassAllocator::allocate(size_t size)
+{
+    if (size == 0) {
+        // like SimpleBestFitAllocator, empty allocations have no record
+        return 0;
+    }
+
+    size_t order = 0;
+    while (order < mFreeBlocks.size() && blockSize(order) < size) order++;
+
+    Mutex::Autolock _l(mLock);
+    size_t freeOrder = order;
+    while (freeOrder < mFreeBlocks.size() && mFreeBlocks[freeOrder].empty()) freeOrder++;
+    if (freeOrder >= mFreeBlocks.size()) {
+        return NO_MEMORY;
+    }
+
+    const size_t offset = *mFreeBlocks[freeOrder].begin();
+    mFreeBlocks[freeOrder].erase(mFreeBlocks[freeOrder].begin());
+    // keep the lower half, free the upper halves
+    while (freeOrder > order) {
+        freeOrder--;
+        mFreeBlocks[freeOrder].insert(offset + blockSize(freeOrder));
+    }
+
+    mAllocatedBlocks[offset] = {order, size};
+    mRequestedSize += size;
+    return offset;
+}
+
+status_t SizeClassAllocator::deallocate(size_t offset)
+{
+    Mutex::Autolock _l(mLock);
+    auto it = mAllocatedBlocks.find(offset);
+    if (it == mAllocatedBlocks.end()) {
+        return NAME_NOT_FOUND;
+    }
+    size_t order = it->second.order;
+    mRequestedSize -= it->second.requestedSize;
+    mAllocatedBlocks.erase(it);
+
+    while (order + 1 < mFreeBlocks.size()) {
+        const size_t buddy = offset ^ blockSize(order);
+        if (mFreeBlocks[order].erase(buddy) == 0) break;
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    mFreeBlocks[order].insert(offset);
+    return NO_ERROR;
+}
+
+void SizeClassAllocator::getFreeSizes_l(size_t* freeSize, size_t* largestFreeSize) const
+{
+    *freeSize = 0;
+    *largestFreeSize = 0;
+    for (size_t order = 0; order < mFreeBlocks.size(); order++) {
+        *freeSize += mFreeBlocks[order].size() * blockSize(order);
+        if (!mFreeBlocks[order].empty()) *largestFreeSize = blockSize(order);
+    }
+}
+
+void SizeClassAllocator::getFreeSizes(size_t* freeSize, size_t* largestFreeSize) const
+{
+    Mutex::Autolock _l(mLock);
+    getFreeSizes_l(freeSize, largestFreeSize);
+}
+
+void SizeClassAllocator::dump(const char* what) const
+{
+    Mutex::Autolock _l(mLock);
+    String8 result;
+    result.appendFormat("  %s (%p, size=%zu, size classes)\n", what, this, mHeapSize);
+    for (size_t order = 0; order < mFreeBlocks.size(); order++) {
+        if (mFreeBlocks[order].empty()) continue;
+        result.appendFormat("  free blocks of 0x%08zX: %zu\n", blockSize(order),
+                            mFreeBlocks[order].size());
+    }
+
+    size_t freeSize, largestFreeSize;
+    getFreeSizes_l(&freeSize, &largestFreeSize);
+    const size_t allocatedSize = mHeapSize - freeSize;
+    // how much of the free memory can't be allocated at once
+    const unsigned fragmentation =
+            freeSize ? unsigned((freeSize - largestFreeSize) * 100 / freeSize) : 0;
+    result.appendFormat("  size allocated: %zu (%zu KB) in %zu block(s), %zu requested\n",
+                        allocatedSize, allocatedSize / 1024, mAllocatedBlocks.size(),
+                        mRequestedSize);
+    result.appendFormat("  size free: %zu (%zu KB), largest block %zu, %u%% fragmented\n",
+                        freeSize, freeSize / 1024, largestFreeSize, fragmentation);
+    ALOGD("%s", result.string());
+}
+
 
 } // namespace android
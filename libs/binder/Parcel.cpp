@@ -98,6 +98,103 @@ enum {
     BLOB_ASHMEM_MUTABLE = 2,
 };
 
+// Most transactions are small, so each thread keeps a few of the smallest data
+// and objects buffers of the Parcels it frees, and hands them out again to new
+// Parcels, rather than hitting the heap for every transaction. Larger buffers
+// always come from the heap (and buffers can still be realloc'd to grow).
+static constexpr size_t kCachedDataCapacity = 128; // minimum growData allocation
+static constexpr size_t kCachedObjectsCapacity = 8;
+static constexpr size_t kMaxCachedBuffers = 4;
+
+// trivially destructible, so that it can still be used by Parcels destroyed
+// during thread exit (e.g. by IPCThreadState's destructor)
+struct ParcelBufferCache {
+    bool registered;
+    bool closed;
+    size_t dataCount;
+    uint8_t* data[kMaxCachedBuffers];
+    size_t objectsCount;
+    binder_size_t* objects[kMaxCachedBuffers];
+};
+static thread_local ParcelBufferCache gBufferCache;
+
+static pthread_key_t gBufferCacheKey;
+static pthread_once_t gBufferCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static void closeBufferCache(void* arg) {
+    ParcelBufferCache* cache = static_cast<ParcelBufferCache*>(arg);
+    for (size_t i = 0; i < cache->dataCount; i++) free(cache->data[i]);
+    for (size_t i = 0; i < cache->objectsCount; i++) free(cache->objects[i]);
+    cache->dataCount = cache->objectsCount = 0;
+    // anything freed after this point goes straight back to the heap
+    cache->closed = true;
+}
+
+static ParcelBufferCache* getBufferCache() {
+    ParcelBufferCache* cache = &gBufferCache;
+    if (CC_UNLIKELY(!cache->registered)) {
+        // the cached buffers are freed when the thread exits
+        pthread_once(&gBufferCacheKeyOnce,
+                     [] { pthread_key_create(&gBufferCacheKey, closeBufferCache); });
+        pthread_setspecific(gBufferCacheKey, cache);
+        cache->registered = true;
+    }
+    return cache->closed ? nullptr : cache;
+}
+
+static uint8_t* takeCachedData() {
+    ParcelBufferCache* cache = getBufferCache();
+    if (cache == nullptr || cache->dataCount == 0) return nullptr;
+    return cache->data[--cache->dataCount];
+}
+
+static void freeDataBuffer(uint8_t* data, size_t capacity) {
+    if (capacity == kCachedDataCapacity) {
+        ParcelBufferCache* cache = getBufferCache();
+        if (cache != nullptr && cache->dataCount < kMaxCachedBuffers) {
+            cache->data[cache->dataCount++] = data;
+            return;
+        }
+    }
+    free(data);
+}
+
+static binder_size_t* takeCachedObjects() {
+    ParcelBufferCache* cache = getBufferCache();
+    if (cache == nullptr || cache->objectsCount == 0) return nullptr;
+    return cache->objects[--cache->objectsCount];
+}
+
+static void freeObjectsBuffer(binder_size_t* objects, size_t capacity) {
+    if (objects == nullptr) return;
+    if (capacity == kCachedObjectsCapacity) {
+        ParcelBufferCache* cache = getBufferCache();
+        if (cache != nullptr && cache->objectsCount < kMaxCachedBuffers) {
+            cache->objects[cache->objectsCount++] = objects;
+            return;
+        }
+    }
+    free(objects);
+}
+
+// Grows an objects buffer to hold at least 'newSize' entries, preferring a
+// cached buffer for a Parcel's first few objects.
+static binder_size_t* growObjectsBuffer(binder_size_t* objects, size_t* inOutCapacity,
+                                        size_t newSize) {
+    if (objects == nullptr && newSize <= kCachedObjectsCapacity) {
+        binder_size_t* cached = takeCachedObjects();
+        if (cached != nullptr) {
+            *inOutCapacity = kCachedObjectsCapacity;
+            return cached;
+        }
+        // allocated at the cached size, so it can be cached when it is freed
+        newSize = kCachedObjectsCapacity;
+    }
+    binder_size_t* grown = (binder_size_t*)realloc(objects, newSize * sizeof(binder_size_t));
+    if (grown != nullptr) *inOutCapacity = newSize;
+    return grown;
+}
+
 static void acquire_object(const sp<ProcessState>& proc,
     const flat_binder_object& obj, const void* who, size_t* outAshmemSize)
 {
@@ -172,9 +269,7 @@ static void release_object(const sp<ProcessState>& proc,
 
 status_t Parcel::finishFlattenBinder(const sp<IBinder>& binder)
 {
-    internal::Stability::tryMarkCompilationUnit(binder.get());
-    auto category = internal::Stability::getCategory(binder.get());
-    return writeInt32(category.repr());
+    return writeInt32(internal::Stability::tryMarkCompilationUnit(binder.get()));
 }
 
 status_t Parcel::finishUnflattenBinder(
@@ -486,13 +581,11 @@ status_t Parcel::appendFrom(const Parcel *parcel, size_t offset, size_t len)
             if (mObjectsSize + numObjects > SIZE_MAX / 3) return NO_MEMORY; // overflow
             size_t newSize = ((mObjectsSize + numObjects)*3)/2;
             if (newSize > SIZE_MAX / sizeof(binder_size_t)) return NO_MEMORY; // overflow
-            binder_size_t *objects =
-                (binder_size_t*)realloc(mObjects, newSize*sizeof(binder_size_t));
+            binder_size_t *objects = growObjectsBuffer(mObjects, &mObjectsCapacity, newSize);
             if (objects == (binder_size_t*)nullptr) {
                 return NO_MEMORY;
             }
             mObjects = objects;
-            mObjectsCapacity = newSize;
         }
 
         // append and acquire objects
@@ -1343,10 +1436,9 @@ restart_write:
         if ((mObjectsSize + 2) > SIZE_MAX / 3) return NO_MEMORY; // overflow
         size_t newSize = ((mObjectsSize+2)*3)/2;
         if (newSize > SIZE_MAX / sizeof(binder_size_t)) return NO_MEMORY; // overflow
-        binder_size_t* objects = (binder_size_t*)realloc(mObjects, newSize*sizeof(binder_size_t));
+        binder_size_t* objects = growObjectsBuffer(mObjects, &mObjectsCapacity, newSize);
         if (objects == nullptr) return NO_MEMORY;
         mObjects = objects;
-        mObjectsCapacity = newSize;
     }
 
     goto restart_write;
@@ -2237,9 +2329,9 @@ void Parcel::freeDataNoInit()
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
             }
-            free(mData);
+            freeDataBuffer(mData, mDataCapacity);
         }
-        if (mObjects) free(mObjects);
+        freeObjectsBuffer(mObjects, mObjectsCapacity);
     }
 }
 
@@ -2314,7 +2406,7 @@ status_t Parcel::restartWrite(size_t desired)
     ALOGV("restartWrite Setting data size of %p to %zu", this, mDataSize);
     ALOGV("restartWrite Setting data pos of %p to %zu", this, mDataPos);
 
-    free(mObjects);
+    freeObjectsBuffer(mObjects, mObjectsCapacity);
     mObjects = nullptr;
     mObjectsSize = mObjectsCapacity = 0;
     mNextObjectHint = 0;
@@ -2420,7 +2512,7 @@ status_t Parcel::continueWrite(size_t desired)
             }
 
             if (objectsSize == 0) {
-                free(mObjects);
+                freeObjectsBuffer(mObjects, mObjectsCapacity);
                 mObjects = nullptr;
                 mObjectsCapacity = 0;
             } else {
@@ -2463,7 +2555,13 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        uint8_t* data = nullptr;
+        if (desired > 0 && desired <= kCachedDataCapacity) {
+            data = takeCachedData();
+            // allocated at the cached size, so it can be cached when it is freed
+            desired = kCachedDataCapacity;
+        }
+        if (!data) data = (uint8_t*)malloc(desired);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
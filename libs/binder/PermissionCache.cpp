@@ -17,6 +17,7 @@
 #define LOG_TAG "PermissionCache"
 
 #include <stdint.h>
+#include <string_view>
 #include <utils/Log.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
@@ -34,44 +35,62 @@ ANDROID_SINGLETON_STATIC_INSTANCE(PermissionCache)
 PermissionCache::PermissionCache() {
 }
 
+size_t PermissionCache::KeyHash::operator()(const Key& k) const {
+    const size_t nameHash =
+            std::hash<std::u16string_view>()(std::u16string_view(k.name.string(), k.name.size()));
+    return nameHash ^ (std::hash<uid_t>()(k.uid) * 31);
+}
+
+PermissionCache::Shard& PermissionCache::shardFor(const Key& key) {
+    // the low bits of the hash pick the bucket within the shard, use others
+    return mShards[(KeyHash()(key) >> 8) % NUM_SHARDS];
+}
+
 status_t PermissionCache::check(bool* granted,
-        const String16& permission, uid_t uid) const {
-    Mutex::Autolock _l(mLock);
-    Entry e;
-    e.name = permission;
-    e.uid  = uid;
-    ssize_t index = mCache.indexOf(e);
-    if (index >= 0) {
-        *granted = mCache.itemAt(index).granted;
-        return NO_ERROR;
+        const String16& permission, uid_t uid) {
+    // note, we don't need to store the pid, which is not actually used in
+    // permission checks
+    const Key key{permission, uid};
+    Shard& shard = shardFor(key);
+    Mutex::Autolock _l(shard.lock);
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end()) {
+        return NAME_NOT_FOUND;
+    }
+    if (it->second.expiry <= systemTime()) {
+        shard.cache.erase(it);
+        return NAME_NOT_FOUND;
     }
-    return NAME_NOT_FOUND;
+    *granted = it->second.granted;
+    return NO_ERROR;
 }
 
 void PermissionCache::cache(const String16& permission,
         uid_t uid, bool granted) {
-    Mutex::Autolock _l(mLock);
-    Entry e;
-    ssize_t index = mPermissionNamesPool.indexOf(permission);
-    if (index > 0) {
-        e.name = mPermissionNamesPool.itemAt(index);
-    } else {
-        mPermissionNamesPool.add(permission);
-        e.name = permission;
-    }
-    // note, we don't need to store the pid, which is not actually used in
-    // permission checks
-    e.uid  = uid;
-    e.granted = granted;
-    index = mCache.indexOf(e);
-    if (index < 0) {
-        mCache.add(e);
-    }
+    const Key key{permission, uid};
+    Shard& shard = shardFor(key);
+    Mutex::Autolock _l(shard.lock);
+    shard.cache[key] = Entry{granted, systemTime() + CACHE_TIMEOUT};
 }
 
 void PermissionCache::purge() {
-    Mutex::Autolock _l(mLock);
-    mCache.clear();
+    for (Shard& shard : mShards) {
+        Mutex::Autolock _l(shard.lock);
+        shard.cache.clear();
+    }
+}
+
+void PermissionCache::purge(uid_t uid) {
+    for (Shard& shard : mShards) {
+        Mutex::Autolock _l(shard.lock);
+        for (auto it = shard.cache.begin(); it != shard.cache.end();) {
+            if (it->first.uid == uid) {
+                it = shard.cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
 }
 
 bool PermissionCache::checkCallingPermission(const String16& permission) {
@@ -114,5 +133,10 @@ void PermissionCache::purgeCache() {
     pc.purge();
 }
 
+void PermissionCache::purgeCache(uid_t uid) {
+    PermissionCache& pc(PermissionCache::getInstance());
+    pc.purge(uid);
+}
+
 // ---------------------------------------------------------------------------
 } // namespace android
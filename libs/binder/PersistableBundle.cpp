@@ -18,7 +18,9 @@
 
 #include <binder/PersistableBundle.h>
 
+#include <algorithm>
 #include <limits>
+#include <mutex>
 
 #include <binder/IBinder.h>
 #include <binder/Parcel.h>
@@ -46,7 +48,7 @@ using android::binder::VAL_DOUBLEARRAY;
 using android::binder::VAL_STRINGARRAY;
 using android::binder::VAL_PERSISTABLEBUNDLE;
 
-using std::map;
+using std::pair;
 using std::set;
 using std::vector;
 
@@ -57,22 +59,35 @@ enum {
 };
 
 namespace {
+struct KeyLess {
+    template <typename T>
+    bool operator()(const pair<android::String16, T>& entry, const android::String16& key) const {
+        return entry.first < key;
+    }
+};
+
 template <typename T>
-bool getValue(const android::String16& key, T* out, const map<android::String16, T>& map) {
-    const auto& it = map.find(key);
-    if (it == map.end()) return false;
-    *out = it->second;
-    return true;
+auto findKey(const vector<pair<android::String16, T>>& map, const android::String16& key) {
+    const auto& it = std::lower_bound(map.begin(), map.end(), key, KeyLess());
+    return it != map.end() && it->first == key ? it : map.end();
 }
 
 template <typename T>
-set<android::String16> getKeys(const map<android::String16, T>& map) {
-    if (map.empty()) return set<android::String16>();
-    set<android::String16> keys;
-    for (const auto& key_value_pair : map) {
-        keys.emplace(key_value_pair.first);
+void putKey(vector<pair<android::String16, T>>* map, const android::String16& key, T value) {
+    auto it = std::lower_bound(map->begin(), map->end(), key, KeyLess());
+    if (it != map->end() && it->first == key) {
+        it->second = std::move(value);
+    } else {
+        map->emplace(it, key, std::move(value));
     }
-    return keys;
+}
+
+template <typename T>
+size_t eraseKey(vector<pair<android::String16, T>>* map, const android::String16& key) {
+    const auto& it = findKey(*map, key);
+    if (it == map->end()) return 0;
+    map->erase(it);
+    return 1;
 }
 }  // namespace
 
@@ -91,13 +106,212 @@ namespace os {
 
 #define RETURN_IF_ENTRY_ERASED(map, key)                                 \
     {                                                                    \
-        size_t num_erased = (map).erase(key);                            \
+        size_t num_erased = eraseKey(&(map), key);                       \
         if (num_erased) {                                                \
             ALOGE("Failed at %s:%d (%s)", __FILE__, __LINE__, __func__); \
             return num_erased;                                           \
          }                                                               \
     }
 
+struct PersistableBundle::Impl {
+    // Values of one type, sorted by key.
+    template <typename T>
+    using FlatMap = vector<pair<String16, T>>;
+
+    // The bytes of a bundle read from a parcel, and the index of its keys.
+    struct LazyData {
+        struct Entry {
+            String16 key;
+            int32_t type;
+            // Where the value starts in parcel.
+            size_t position;
+        };
+
+        int32_t magic;
+        // Holds the entries of the bundle, without the length and the magic number before them.
+        Parcel parcel;
+        // Sorted by key, then by type. A key appears at most once for each type.
+        vector<Entry> entries;
+        // Guards the data position of parcel, which every read moves.
+        std::mutex lock;
+
+        struct KeyLess {
+            bool operator()(const Entry& lhs, const Entry& rhs) const {
+                return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.type < rhs.type);
+            }
+            bool operator()(const Entry& entry, const String16& key) const {
+                return entry.key < key;
+            }
+            bool operator()(const String16& key, const Entry& entry) const {
+                return key < entry.key;
+            }
+        };
+    };
+
+    size_t size() const;
+
+    status_t writeToParcelInner(Parcel* parcel) const;
+    status_t readFromParcelInner(const Parcel* parcel, size_t length);
+
+    // Reads all the values out of mLazyData, if any, into the maps.
+    void materialize();
+
+    template <typename T>
+    bool getValue(const String16& key, int32_t type, T* out, const FlatMap<T>& map) const;
+    template <typename T>
+    set<String16> getKeys(int32_t type, const FlatMap<T>& map) const;
+
+    // Shared by the copies of a bundle, which only read it. The maps are empty while it is set.
+    std::shared_ptr<LazyData> mLazyData;
+
+    FlatMap<bool> mBoolMap;
+    FlatMap<int32_t> mIntMap;
+    FlatMap<int64_t> mLongMap;
+    FlatMap<double> mDoubleMap;
+    FlatMap<String16> mStringMap;
+    FlatMap<vector<bool>> mBoolVectorMap;
+    FlatMap<vector<int32_t>> mIntVectorMap;
+    FlatMap<vector<int64_t>> mLongVectorMap;
+    FlatMap<vector<double>> mDoubleVectorMap;
+    FlatMap<vector<String16>> mStringVectorMap;
+    FlatMap<PersistableBundle> mPersistableBundleMap;
+};
+
+    int32_t magic;
+    // Holds the entries of the bundle, without the length and the magic number before them.
+    Parcel parcel;
+    // Sorted by key.
+    vector<Entry> entries;
+    // Guards the data position of parcel, which every read moves.
+    std::mutex lock;
+
+    struct KeyLess {
+        bool operator()(const Entry& lhs, const Entry& rhs) const { return lhs.key < rhs.key; }
+        bool operator()(const Entry& entry, const String16& key) const { return entry.key < key; }
+        bool operator()(const String16& key, const Entry& entry) const { return key < entry.key; }
+    };
+};
+
+namespace {
+
+status_t readValue(const Parcel& parcel, bool* out) {
+    return parcel.readBool(out);
+}
+status_t readValue(const Parcel& parcel, int32_t* out) {
+    return parcel.readInt32(out);
+}
+status_t readValue(const Parcel& parcel, int64_t* out) {
+    return parcel.readInt64(out);
+}
+status_t readValue(const Parcel& parcel, double* out) {
+    return parcel.readDouble(out);
+}
+status_t readValue(const Parcel& parcel, String16* out) {
+    return parcel.readString16(out);
+}
+status_t readValue(const Parcel& parcel, vector<bool>* out) {
+    return parcel.readBoolVector(out);
+}
+status_t readValue(const Parcel& parcel, vector<int32_t>* out) {
+    return parcel.readInt32Vector(out);
+}
+status_t readValue(const Parcel& parcel, vector<int64_t>* out) {
+    return parcel.readInt64Vector(out);
+}
+status_t readValue(const Parcel& parcel, vector<double>* out) {
+    return parcel.readDoubleVector(out);
+}
+status_t readValue(const Parcel& parcel, vector<String16>* out) {
+    return parcel.readString16Vector(out);
+}
+status_t readValue(const Parcel& parcel, PersistableBundle* out) {
+    return out->readFromParcel(&parcel);
+}
+
+template <typename T>
+status_t readEntry(const Parcel& parcel, const String16& key, vector<pair<String16, T>>* map) {
+    T value;
+    RETURN_IF_FAILED(readValue(parcel, &value));
+    putKey(map, key, std::move(value));
+    return NO_ERROR;
+}
+
+status_t skipBytes(const Parcel& parcel, size_t length) {
+    if (length == 0) return NO_ERROR;
+    return parcel.readInplace(length) != nullptr ? NO_ERROR : BAD_VALUE;
+}
+
+status_t skipString16(const Parcel& parcel) {
+    size_t length;
+    return parcel.readString16Inplace(&length) != nullptr ? NO_ERROR : BAD_VALUE;
+}
+
+status_t skipArray(const Parcel& parcel, size_t elementSize) {
+    int32_t size;
+    RETURN_IF_FAILED(parcel.readInt32(&size));
+    if (size < 0) return UNEXPECTED_NULL;
+    if (static_cast<size_t>(size) > parcel.dataAvail() / elementSize) return BAD_VALUE;
+    return skipBytes(parcel, static_cast<size_t>(size) * elementSize);
+}
+
+/*
+ * Moves past a value of |type| as written by writeToParcelInner(), checking only that it fits
+ * in |parcel|.
+ */
+status_t skipValue(const Parcel& parcel, int32_t type) {
+    switch (type) {
+        case VAL_BOOLEAN:
+        case VAL_INTEGER:
+            return skipBytes(parcel, sizeof(int32_t));
+        case VAL_LONG:
+        case VAL_DOUBLE:
+            return skipBytes(parcel, sizeof(int64_t));
+        case VAL_STRING:
+            return skipString16(parcel);
+        case VAL_BOOLEANARRAY:
+        case VAL_INTARRAY:
+            // Booleans are written as 32-bit ints.
+            return skipArray(parcel, sizeof(int32_t));
+        case VAL_LONGARRAY:
+        case VAL_DOUBLEARRAY:
+            return skipArray(parcel, sizeof(int64_t));
+        case VAL_STRINGARRAY: {
+            int32_t size;
+            RETURN_IF_FAILED(parcel.readInt32(&size));
+            if (size < 0) return UNEXPECTED_NULL;
+            for (; size > 0; --size) {
+                RETURN_IF_FAILED(skipString16(parcel));
+            }
+            return NO_ERROR;
+        }
+        case VAL_PERSISTABLEBUNDLE: {
+            int32_t length;
+            RETURN_IF_FAILED(parcel.readInt32(&length));
+            if (length < 0) return UNEXPECTED_NULL;
+            if (length == 0) return NO_ERROR;
+            // The length doesn't count the magic number that follows it.
+            return skipBytes(parcel, sizeof(int32_t) + static_cast<size_t>(length));
+        }
+        default:
+            ALOGE("Unrecognized type: %d", type);
+            return BAD_TYPE;
+    }
+}
+
+}  // namespace
+
+PersistableBundle::PersistableBundle() : mImpl(std::make_unique<Impl>()) {}
+
+PersistableBundle::~PersistableBundle() = default;
+
+PersistableBundle::PersistableBundle(const PersistableBundle& bundle)
+      : mImpl(std::make_unique<Impl>(*bundle.mImpl)) {}
+
+PersistableBundle& PersistableBundle::operator=(const PersistableBundle& bundle) {
+    *mImpl = *bundle.mImpl;
+    return *this;
+}
+
 status_t PersistableBundle::writeToParcel(Parcel* parcel) const {
     /*
      * Keep implementation in sync with writeToParcelInner() in
@@ -110,12 +324,20 @@ status_t PersistableBundle::writeToParcel(Parcel* parcel) const {
         return NO_ERROR;
     }
 
+    // Unchanged since it was read, so the bytes it was read from still hold its entries.
+    if (const Impl::LazyData* lazy = mImpl->mLazyData.get(); lazy != nullptr) {
+        const Parcel& data = lazy->parcel;
+        RETURN_IF_FAILED(parcel->writeInt32(static_cast<int32_t>(data.dataSize())));
+        RETURN_IF_FAILED(parcel->writeInt32(lazy->magic));
+        return parcel->write(data.data(), data.dataSize());
+    }
+
     size_t length_pos = parcel->dataPosition();
     RETURN_IF_FAILED(parcel->writeInt32(1));  // dummy, will hold length
     RETURN_IF_FAILED(parcel->writeInt32(BUNDLE_MAGIC_NATIVE));
 
     size_t start_pos = parcel->dataPosition();
-    RETURN_IF_FAILED(writeToParcelInner(parcel));
+    RETURN_IF_FAILED(mImpl->writeToParcelInner(parcel));
     size_t end_pos = parcel->dataPosition();
 
     // Backpatch length. This length value includes the length header.
@@ -141,7 +363,7 @@ status_t PersistableBundle::readFromParcel(const Parcel* parcel) {
         return UNEXPECTED_NULL;
     }
 
-    return readFromParcelInner(parcel, static_cast<size_t>(length));
+    return mImpl->readFromParcelInner(parcel, static_cast<size_t>(length));
 }
 
 bool PersistableBundle::empty() const {
@@ -149,177 +371,229 @@ bool PersistableBundle::empty() const {
 }
 
 size_t PersistableBundle::size() const {
-    return (mBoolMap.size() +
-            mIntMap.size() +
-            mLongMap.size() +
-            mDoubleMap.size() +
-            mStringMap.size() +
-            mBoolVectorMap.size() +
-            mIntVectorMap.size() +
-            mLongVectorMap.size() +
-            mDoubleVectorMap.size() +
-            mStringVectorMap.size() +
-            mPersistableBundleMap.size());
+    return mImpl->size();
 }
 
 size_t PersistableBundle::erase(const String16& key) {
-    RETURN_IF_ENTRY_ERASED(mBoolMap, key);
-    RETURN_IF_ENTRY_ERASED(mIntMap, key);
-    RETURN_IF_ENTRY_ERASED(mLongMap, key);
-    RETURN_IF_ENTRY_ERASED(mDoubleMap, key);
-    RETURN_IF_ENTRY_ERASED(mStringMap, key);
-    RETURN_IF_ENTRY_ERASED(mBoolVectorMap, key);
-    RETURN_IF_ENTRY_ERASED(mIntVectorMap, key);
-    RETURN_IF_ENTRY_ERASED(mLongVectorMap, key);
-    RETURN_IF_ENTRY_ERASED(mDoubleVectorMap, key);
-    RETURN_IF_ENTRY_ERASED(mStringVectorMap, key);
-    return mPersistableBundleMap.erase(key);
+    mImpl->materialize();
+    RETURN_IF_ENTRY_ERASED(mImpl->mBoolMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mIntMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mLongMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mDoubleMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mStringMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mBoolVectorMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mIntVectorMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mLongVectorMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mDoubleVectorMap, key);
+    RETURN_IF_ENTRY_ERASED(mImpl->mStringVectorMap, key);
+    return eraseKey(&mImpl->mPersistableBundleMap, key);
 }
 
 void PersistableBundle::putBoolean(const String16& key, bool value) {
     erase(key);
-    mBoolMap[key] = value;
+    putKey(&mImpl->mBoolMap, key, value);
 }
 
 void PersistableBundle::putInt(const String16& key, int32_t value) {
     erase(key);
-    mIntMap[key] = value;
+    putKey(&mImpl->mIntMap, key, value);
 }
 
 void PersistableBundle::putLong(const String16& key, int64_t value) {
     erase(key);
-    mLongMap[key] = value;
+    putKey(&mImpl->mLongMap, key, value);
 }
 
 void PersistableBundle::putDouble(const String16& key, double value) {
     erase(key);
-    mDoubleMap[key] = value;
+    putKey(&mImpl->mDoubleMap, key, value);
 }
 
 void PersistableBundle::putString(const String16& key, const String16& value) {
     erase(key);
-    mStringMap[key] = value;
+    putKey(&mImpl->mStringMap, key, value);
 }
 
 void PersistableBundle::putBooleanVector(const String16& key, const vector<bool>& value) {
     erase(key);
-    mBoolVectorMap[key] = value;
+    putKey(&mImpl->mBoolVectorMap, key, value);
 }
 
 void PersistableBundle::putIntVector(const String16& key, const vector<int32_t>& value) {
     erase(key);
-    mIntVectorMap[key] = value;
+    putKey(&mImpl->mIntVectorMap, key, value);
 }
 
 void PersistableBundle::putLongVector(const String16& key, const vector<int64_t>& value) {
     erase(key);
-    mLongVectorMap[key] = value;
+    putKey(&mImpl->mLongVectorMap, key, value);
 }
 
 void PersistableBundle::putDoubleVector(const String16& key, const vector<double>& value) {
     erase(key);
-    mDoubleVectorMap[key] = value;
+    putKey(&mImpl->mDoubleVectorMap, key, value);
 }
 
 void PersistableBundle::putStringVector(const String16& key, const vector<String16>& value) {
     erase(key);
-    mStringVectorMap[key] = value;
+    putKey(&mImpl->mStringVectorMap, key, value);
 }
 
 void PersistableBundle::putPersistableBundle(const String16& key, const PersistableBundle& value) {
     erase(key);
-    mPersistableBundleMap[key] = value;
+    putKey(&mImpl->mPersistableBundleMap, key, value);
+}
+
+size_t PersistableBundle::Impl::size() const {
+    if (mLazyData != nullptr) {
+        return mLazyData->entries.size();
+    }
+    return (mBoolMap.size() +
+            mIntMap.size() +
+            mLongMap.size() +
+            mDoubleMap.size() +
+            mStringMap.size() +
+            mBoolVectorMap.size() +
+            mIntVectorMap.size() +
+            mLongVectorMap.size() +
+            mDoubleVectorMap.size() +
+            mStringVectorMap.size() +
+            mPersistableBundleMap.size());
+}
+
+template <typename T>
+bool PersistableBundle::Impl::getValue(const String16& key, int32_t type, T* out,
+                                       const FlatMap<T>& map) const {
+    if (mLazyData == nullptr) {
+        const auto& it = findKey(map, key);
+        if (it == map.end()) return false;
+        *out = it->second;
+        return true;
+    }
+
+    const auto& [begin, end] = std::equal_range(mLazyData->entries.begin(),
+                                                mLazyData->entries.end(), key, LazyData::KeyLess());
+    for (auto it = begin; it != end; ++it) {
+        if (it->type != type) continue;
+        T value;
+        {
+            std::lock_guard<std::mutex> lock(mLazyData->lock);
+            mLazyData->parcel.setDataPosition(it->position);
+            if (readValue(mLazyData->parcel, &value) != NO_ERROR) {
+                ALOGE("Failed to read value of type %d", type);
+                return false;
+            }
+        }
+        *out = std::move(value);
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+set<String16> PersistableBundle::Impl::getKeys(int32_t type, const FlatMap<T>& map) const {
+    set<String16> keys;
+    if (mLazyData != nullptr) {
+        for (const LazyData::Entry& entry : mLazyData->entries) {
+            if (entry.type == type) keys.emplace(entry.key);
+        }
+        return keys;
+    }
+    for (const auto& key_value_pair : map) {
+        keys.emplace(key_value_pair.first);
+    }
+    return keys;
 }
 
 bool PersistableBundle::getBoolean(const String16& key, bool* out) const {
-    return getValue(key, out, mBoolMap);
+    return mImpl->getValue(key, VAL_BOOLEAN, out, mImpl->mBoolMap);
 }
 
 bool PersistableBundle::getInt(const String16& key, int32_t* out) const {
-    return getValue(key, out, mIntMap);
+    return mImpl->getValue(key, VAL_INTEGER, out, mImpl->mIntMap);
 }
 
 bool PersistableBundle::getLong(const String16& key, int64_t* out) const {
-    return getValue(key, out, mLongMap);
+    return mImpl->getValue(key, VAL_LONG, out, mImpl->mLongMap);
 }
 
 bool PersistableBundle::getDouble(const String16& key, double* out) const {
-    return getValue(key, out, mDoubleMap);
+    return mImpl->getValue(key, VAL_DOUBLE, out, mImpl->mDoubleMap);
 }
 
 bool PersistableBundle::getString(const String16& key, String16* out) const {
-    return getValue(key, out, mStringMap);
+    return mImpl->getValue(key, VAL_STRING, out, mImpl->mStringMap);
 }
 
 bool PersistableBundle::getBooleanVector(const String16& key, vector<bool>* out) const {
-    return getValue(key, out, mBoolVectorMap);
+    return mImpl->getValue(key, VAL_BOOLEANARRAY, out, mImpl->mBoolVectorMap);
 }
 
 bool PersistableBundle::getIntVector(const String16& key, vector<int32_t>* out) const {
-    return getValue(key, out, mIntVectorMap);
+    return mImpl->getValue(key, VAL_INTARRAY, out, mImpl->mIntVectorMap);
 }
 
 bool PersistableBundle::getLongVector(const String16& key, vector<int64_t>* out) const {
-    return getValue(key, out, mLongVectorMap);
+    return mImpl->getValue(key, VAL_LONGARRAY, out, mImpl->mLongVectorMap);
 }
 
 bool PersistableBundle::getDoubleVector(const String16& key, vector<double>* out) const {
-    return getValue(key, out, mDoubleVectorMap);
+    return mImpl->getValue(key, VAL_DOUBLEARRAY, out, mImpl->mDoubleVectorMap);
 }
 
 bool PersistableBundle::getStringVector(const String16& key, vector<String16>* out) const {
-    return getValue(key, out, mStringVectorMap);
+    return mImpl->getValue(key, VAL_STRINGARRAY, out, mImpl->mStringVectorMap);
 }
 
 bool PersistableBundle::getPersistableBundle(const String16& key, PersistableBundle* out) const {
-    return getValue(key, out, mPersistableBundleMap);
+    return mImpl->getValue(key, VAL_PERSISTABLEBUNDLE, out, mImpl->mPersistableBundleMap);
 }
 
 set<String16> PersistableBundle::getBooleanKeys() const {
-    return getKeys(mBoolMap);
+    return mImpl->getKeys(VAL_BOOLEAN, mImpl->mBoolMap);
 }
 
 set<String16> PersistableBundle::getIntKeys() const {
-    return getKeys(mIntMap);
+    return mImpl->getKeys(VAL_INTEGER, mImpl->mIntMap);
 }
 
 set<String16> PersistableBundle::getLongKeys() const {
-    return getKeys(mLongMap);
+    return mImpl->getKeys(VAL_LONG, mImpl->mLongMap);
 }
 
 set<String16> PersistableBundle::getDoubleKeys() const {
-    return getKeys(mDoubleMap);
+    return mImpl->getKeys(VAL_DOUBLE, mImpl->mDoubleMap);
 }
 
 set<String16> PersistableBundle::getStringKeys() const {
-    return getKeys(mStringMap);
+    return mImpl->getKeys(VAL_STRING, mImpl->mStringMap);
 }
 
 set<String16> PersistableBundle::getBooleanVectorKeys() const {
-    return getKeys(mBoolVectorMap);
+    return mImpl->getKeys(VAL_BOOLEANARRAY, mImpl->mBoolVectorMap);
 }
 
 set<String16> PersistableBundle::getIntVectorKeys() const {
-    return getKeys(mIntVectorMap);
+    return mImpl->getKeys(VAL_INTARRAY, mImpl->mIntVectorMap);
 }
 
 set<String16> PersistableBundle::getLongVectorKeys() const {
-    return getKeys(mLongVectorMap);
+    return mImpl->getKeys(VAL_LONGARRAY, mImpl->mLongVectorMap);
 }
 
 set<String16> PersistableBundle::getDoubleVectorKeys() const {
-    return getKeys(mDoubleVectorMap);
+    return mImpl->getKeys(VAL_DOUBLEARRAY, mImpl->mDoubleVectorMap);
 }
 
 set<String16> PersistableBundle::getStringVectorKeys() const {
-    return getKeys(mStringVectorMap);
+    return mImpl->getKeys(VAL_STRINGARRAY, mImpl->mStringVectorMap);
 }
 
 set<String16> PersistableBundle::getPersistableBundleKeys() const {
-    return getKeys(mPersistableBundleMap);
+    return mImpl->getKeys(VAL_PERSISTABLEBUNDLE, mImpl->mPersistableBundleMap);
 }
 
-status_t PersistableBundle::writeToParcelInner(Parcel* parcel) const {
+status_t PersistableBundle::Impl::writeToParcelInner(Parcel* parcel) const {
     /*
      * To keep this implementation in sync with writeArrayMapInternal() in
      * frameworks/base/core/java/android/os/Parcel.java, the number of key
@@ -392,12 +666,8 @@ status_t PersistableBundle::writeToParcelInner(Parcel* parcel) const {
     return NO_ERROR;
 }
 
-status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t length) {
-    /*
-     * Note: we don't actually use length for anything other than an empty PersistableBundle
-     * check, since we do not actually need to copy in an entire Parcel, unlike in the Java
-     * implementation.
-     */
+status_t PersistableBundle::Impl::readFromParcelInner(const Parcel* parcel, size_t length) {
+    *this = Impl();
     if (length == 0) {
         // Empty PersistableBundle or end of data.
         return NO_ERROR;
@@ -410,6 +680,18 @@ status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t len
         return BAD_VALUE;
     }
 
+    // Like in the Java implementation, the entries are copied out of |parcel|, but only the keys
+    // are read here. The values are read when they are asked for.
+    const size_t start_pos = parcel->dataPosition();
+    if (length > parcel->dataAvail()) {
+        ALOGE("Bad length in parcel: %zu", length);
+        return BAD_VALUE;
+    }
+    auto lazy = std::make_shared<LazyData>();
+    lazy->magic = magic;
+    RETURN_IF_FAILED(lazy->parcel.setData(parcel->data() + start_pos, length));
+    const Parcel& data = lazy->parcel;
+
     /*
      * To keep this implementation in sync with unparcel() in
      * frameworks/base/core/java/android/os/BaseBundle.java, the number of
@@ -417,72 +699,107 @@ status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t len
      * pairs themselves.
      */
     int32_t num_entries;
-    RETURN_IF_FAILED(parcel->readInt32(&num_entries));
+    RETURN_IF_FAILED(data.readInt32(&num_entries));
+    if (num_entries > 0) {
+        // Each entry takes at least three 32-bit ints, which bounds a bad count.
+        lazy->entries.reserve(std::min(static_cast<size_t>(num_entries),
+                                       data.dataAvail() / (3 * sizeof(int32_t))));
+    }
 
     for (; num_entries > 0; --num_entries) {
-        String16 key;
-        int32_t value_type;
-        RETURN_IF_FAILED(parcel->readString16(&key));
-        RETURN_IF_FAILED(parcel->readInt32(&value_type));
-
-        /*
-         * We assume that both the C++ and Java APIs ensure that all keys in a PersistableBundle
-         * are unique.
-         */
-        switch (value_type) {
-            case VAL_STRING: {
-                RETURN_IF_FAILED(parcel->readString16(&mStringMap[key]));
-                break;
-            }
-            case VAL_INTEGER: {
-                RETURN_IF_FAILED(parcel->readInt32(&mIntMap[key]));
+        LazyData::Entry entry;
+        RETURN_IF_FAILED(data.readString16(&entry.key));
+        RETURN_IF_FAILED(data.readInt32(&entry.type));
+        entry.position = data.dataPosition();
+        RETURN_IF_FAILED(skipValue(data, entry.type));
+        lazy->entries.push_back(std::move(entry));
+    }
+
+    // As when the values were read one by one into the maps, a key repeated with the same type
+    // keeps the value that comes last.
+    std::stable_sort(lazy->entries.begin(), lazy->entries.end(), LazyData::KeyLess());
+    const auto& kept = std::unique(lazy->entries.rbegin(), lazy->entries.rend(),
+                                   [](const LazyData::Entry& lhs, const LazyData::Entry& rhs) {
+                                       return lhs.key == rhs.key && lhs.type == rhs.type;
+                                   });
+    lazy->entries.erase(lazy->entries.begin(), kept.base());
+    parcel->setDataPosition(start_pos + length);
+    if (!lazy->entries.empty()) {
+        mLazyData = std::move(lazy);
+    }
+    return NO_ERROR;
+}
+
+void PersistableBundle::Impl::materialize() {
+    if (mLazyData == nullptr) {
+        return;
+    }
+    std::shared_ptr<LazyData> lazy = std::move(mLazyData);
+    mLazyData = nullptr;
+
+    std::lock_guard<std::mutex> lock(lazy->lock);
+    for (const LazyData::Entry& entry : lazy->entries) {
+        lazy->parcel.setDataPosition(entry.position);
+        status_t status = BAD_TYPE;
+        switch (entry.type) {
+            case VAL_STRING:
+                status = readEntry(lazy->parcel, entry.key, &mStringMap);
                 break;
-            }
-            case VAL_LONG: {
-                RETURN_IF_FAILED(parcel->readInt64(&mLongMap[key]));
+            case VAL_INTEGER:
+                status = readEntry(lazy->parcel, entry.key, &mIntMap);
                 break;
-            }
-            case VAL_DOUBLE: {
-                RETURN_IF_FAILED(parcel->readDouble(&mDoubleMap[key]));
+            case VAL_LONG:
+                status = readEntry(lazy->parcel, entry.key, &mLongMap);
                 break;
-            }
-            case VAL_BOOLEAN: {
-                RETURN_IF_FAILED(parcel->readBool(&mBoolMap[key]));
+            case VAL_DOUBLE:
+                status = readEntry(lazy->parcel, entry.key, &mDoubleMap);
                 break;
-            }
-            case VAL_STRINGARRAY: {
-                RETURN_IF_FAILED(parcel->readString16Vector(&mStringVectorMap[key]));
+            case VAL_BOOLEAN:
+                status = readEntry(lazy->parcel, entry.key, &mBoolMap);
                 break;
-            }
-            case VAL_INTARRAY: {
-                RETURN_IF_FAILED(parcel->readInt32Vector(&mIntVectorMap[key]));
+            case VAL_STRINGARRAY:
+                status = readEntry(lazy->parcel, entry.key, &mStringVectorMap);
                 break;
-            }
-            case VAL_LONGARRAY: {
-                RETURN_IF_FAILED(parcel->readInt64Vector(&mLongVectorMap[key]));
+            case VAL_INTARRAY:
+                status = readEntry(lazy->parcel, entry.key, &mIntVectorMap);
                 break;
-            }
-            case VAL_BOOLEANARRAY: {
-                RETURN_IF_FAILED(parcel->readBoolVector(&mBoolVectorMap[key]));
+            case VAL_LONGARRAY:
+                status = readEntry(lazy->parcel, entry.key, &mLongVectorMap);
                 break;
-            }
-            case VAL_PERSISTABLEBUNDLE: {
-                RETURN_IF_FAILED(mPersistableBundleMap[key].readFromParcel(parcel));
+            case VAL_BOOLEANARRAY:
+                status = readEntry(lazy->parcel, entry.key, &mBoolVectorMap);
                 break;
-            }
-            case VAL_DOUBLEARRAY: {
-                RETURN_IF_FAILED(parcel->readDoubleVector(&mDoubleVectorMap[key]));
+            case VAL_PERSISTABLEBUNDLE:
+                status = readEntry(lazy->parcel, entry.key, &mPersistableBundleMap);
                 break;
-            }
-            default: {
-                ALOGE("Unrecognized type: %d", value_type);
-                return BAD_TYPE;
+            case VAL_DOUBLEARRAY:
+                status = readEntry(lazy->parcel, entry.key, &mDoubleVectorMap);
                 break;
-            }
+        }
+        if (status != NO_ERROR) {
+            // Only a nested bundle can fail here, as the other values were checked when indexed.
+            ALOGE("Dropping value of type %d that failed to read: %d", entry.type, status);
         }
     }
+}
 
-    return NO_ERROR;
+bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs) {
+    const PersistableBundle::Impl& l = *lhs.mImpl;
+    const PersistableBundle::Impl& r = *rhs.mImpl;
+    if (l.mLazyData != nullptr || r.mLazyData != nullptr) {
+        if (l.mLazyData == r.mLazyData) return true;
+        PersistableBundle lhsCopy(lhs);
+        PersistableBundle rhsCopy(rhs);
+        lhsCopy.mImpl->materialize();
+        rhsCopy.mImpl->materialize();
+        return lhsCopy == rhsCopy;
+    }
+    return (l.mBoolMap == r.mBoolMap && l.mIntMap == r.mIntMap && l.mLongMap == r.mLongMap &&
+            l.mDoubleMap == r.mDoubleMap && l.mStringMap == r.mStringMap &&
+            l.mBoolVectorMap == r.mBoolVectorMap && l.mIntVectorMap == r.mIntVectorMap &&
+            l.mLongVectorMap == r.mLongVectorMap && l.mDoubleVectorMap == r.mDoubleVectorMap &&
+            l.mStringVectorMap == r.mStringVectorMap &&
+            l.mPersistableBundleMap == r.mPersistableBundleMap);
 }
 
 }  // namespace os
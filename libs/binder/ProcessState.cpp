@@ -28,6 +28,7 @@
 #include <utils/threads.h>
 
 #include "Static.h"
+#include "TransactionLatency.h"
 #include "binder_module.h"
 
 #include <errno.h>
@@ -234,6 +235,10 @@ void ProcessState::setCallRestriction(CallRestriction restriction) {
     mCallRestriction = restriction;
 }
 
+void ProcessState::setTransactionLatencyTrackingEnabled(bool enabled) {
+    gTransactionLatencyTrackingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
 ProcessState::handle_entry* ProcessState::lookupHandleLocked(int32_t handle)
 {
     const size_t N=mHandleToObject.size();
@@ -347,18 +352,79 @@ void ProcessState::spawnPooledThread(bool isMain)
 }
 
 status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
-    LOG_ALWAYS_FATAL_IF(mThreadPoolStarted && maxThreads < mMaxThreads,
+    pthread_mutex_lock(&mThreadCountLock);
+    LOG_ALWAYS_FATAL_IF(mThreadPoolStarted && maxThreads < mBaseMaxThreads,
            "Binder threadpool cannot be shrunk after starting");
-    status_t result = NO_ERROR;
-    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) != -1) {
-        mMaxThreads = maxThreads;
+    const size_t oldMaxThreads = mMaxThreads;
+    mMaxThreads = maxThreads;
+    status_t result = setDriverMaxThreadsLocked();
+    if (result == NO_ERROR) {
+        mBaseMaxThreads = maxThreads;
     } else {
-        result = -errno;
-        ALOGE("Binder ioctl to set max threads failed: %s", strerror(-result));
+        mMaxThreads = oldMaxThreads;
+    }
+    pthread_mutex_unlock(&mThreadCountLock);
+    return result;
+}
+
+status_t ProcessState::setThreadPoolAdaptivePolicy(size_t hardMaxThreads, int64_t maxStarvationMs,
+                                                   int64_t idleTimeoutMs) {
+    pthread_mutex_lock(&mThreadCountLock);
+    if (hardMaxThreads != 0 &&
+        (hardMaxThreads < mBaseMaxThreads || maxStarvationMs <= 0 || idleTimeoutMs <= 0)) {
+        pthread_mutex_unlock(&mThreadCountLock);
+        return BAD_VALUE;
+    }
+    mAdaptiveMaxThreads = hardMaxThreads;
+    mAdaptiveStarvationMs = maxStarvationMs;
+    mAdaptiveIdleTimeoutMs = idleTimeoutMs;
+
+    status_t result = NO_ERROR;
+    if (hardMaxThreads == 0 && mMaxThreads != mBaseMaxThreads) {
+        mMaxThreads = mBaseMaxThreads;
+        result = setDriverMaxThreadsLocked();
     }
+    pthread_mutex_unlock(&mThreadCountLock);
     return result;
 }
 
+status_t ProcessState::setDriverMaxThreadsLocked() {
+    // The driver keeps counting the threads it asked for after they exit, so
+    // it is told about the retired ones too, or it would never replace them.
+    size_t maxThreads = mMaxThreads + mRetiredThreadsCount;
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) == -1) {
+        status_t result = -errno;
+        ALOGE("Binder ioctl to set max threads failed: %s", strerror(-result));
+        return result;
+    }
+    return NO_ERROR;
+}
+
+void ProcessState::onThreadPoolStarvedLocked(int64_t starvationTimeMs) {
+    if (mAdaptiveMaxThreads == 0 || starvationTimeMs <= mAdaptiveStarvationMs ||
+        mMaxThreads >= mAdaptiveMaxThreads) {
+        return;
+    }
+    // The driver asks for the new thread the next time it has no thread
+    // waiting for work, so this doesn't spawn anything itself.
+    mMaxThreads++;
+    if (setDriverMaxThreadsLocked() != NO_ERROR) {
+        mMaxThreads--;
+    }
+}
+
+bool ProcessState::retireIdlePooledThread() {
+    pthread_mutex_lock(&mThreadCountLock);
+    const bool retire = mAdaptiveMaxThreads != 0;
+    if (retire) {
+        mRetiredThreadsCount++;
+        if (mMaxThreads > mBaseMaxThreads) mMaxThreads--;
+        setDriverMaxThreadsLocked();
+    }
+    pthread_mutex_unlock(&mThreadCountLock);
+    return retire;
+}
+
 status_t ProcessState::enableOnewaySpamDetection(bool enable) {
     uint32_t enableDetection = enable ? 1 : 0;
     if (ioctl(mDriverFD, BINDER_ENABLE_ONEWAY_SPAM_DETECTION, &enableDetection) == -1) {
@@ -419,6 +485,11 @@ ProcessState::ProcessState(const char *driver)
     , mWaitingForThreads(0)
     , mMaxThreads(DEFAULT_MAX_BINDER_THREADS)
     , mStarvationStartTimeMs(0)
+    , mBaseMaxThreads(DEFAULT_MAX_BINDER_THREADS)
+    , mAdaptiveMaxThreads(0)
+    , mAdaptiveStarvationMs(0)
+    , mAdaptiveIdleTimeoutMs(0)
+    , mRetiredThreadsCount(0)
     , mThreadPoolStarted(false)
     , mThreadPoolSeq(1)
     , mCallRestriction(CallRestriction::NONE)
@@ -16,6 +16,8 @@
 
 #define LOG_TAG "RpcServer"
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
@@ -28,6 +30,7 @@
 #include <log/log.h>
 #include "RpcState.h"
 
+#include "RpcSharedMemoryChannel.h"
 #include "RpcSocketAddress.h"
 #include "RpcWireFormat.h"
 
@@ -37,7 +40,20 @@ using base::ScopeGuard;
 using base::unique_fd;
 
 RpcServer::RpcServer() {}
-RpcServer::~RpcServer() {}
+RpcServer::~RpcServer() {
+    if (!mEpollFd.ok()) return;
+
+    // the shutdown fd stays readable, so this wakes up every worker
+    uint64_t one = 1;
+    if (TEMP_FAILURE_RETRY(write(mEventLoopShutdownFd.get(), &one, sizeof(one))) < 0) {
+        LOG_ALWAYS_FATAL("Could not stop event loop: %s", strerror(errno));
+    }
+    for (std::thread& worker : mEventLoopWorkers) {
+        LOG_ALWAYS_FATAL_IF(worker.get_id() == std::this_thread::get_id(),
+                            "RpcServer destroyed by one of its event loop workers");
+        worker.join();
+    }
+}
 
 sp<RpcServer> RpcServer::make() {
     return sp<RpcServer>::make();
@@ -107,6 +123,13 @@ size_t RpcServer::getMaxThreads() {
     return mMaxThreads;
 }
 
+void RpcServer::setEventLoopEnabled(bool enabled) {
+    LOG_ALWAYS_FATAL_IF(mStarted, "must be called before started");
+    std::lock_guard<std::mutex> _l(mLock);
+    LOG_ALWAYS_FATAL_IF(mEpollFd.ok(), "must be called before accepting connections");
+    mEventLoopEnabled = enabled;
+}
+
 void RpcServer::setRootObject(const sp<IBinder>& binder) {
     std::lock_guard<std::mutex> _l(mLock);
     mRootObjectWeak = mRootObject = binder;
@@ -147,6 +170,8 @@ bool RpcServer::acceptOne() {
 
     {
         std::lock_guard<std::mutex> _l(mLock);
+        if (mEventLoopEnabled && !mEpollFd.ok()) startEventLoopLocked();
+
         std::thread thread =
                 std::thread(&RpcServer::establishConnection, this,
                             std::move(sp<RpcServer>::fromExisting(this)), std::move(clientFd));
@@ -171,20 +196,62 @@ size_t RpcServer::numUninitializedSessions() {
     return mConnectingThreads.size();
 }
 
+// Reads the session ID sent by RpcSession::setupOneSocketClient, along with
+// the shared memory for the connection, if the client sent any.
+static bool readSessionId(const unique_fd& clientFd, int32_t* id,
+                          std::unique_ptr<RpcSharedMemoryChannel>* sharedMemory) {
+    iovec iov{id, sizeof(*id)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * RpcSharedMemoryChannel::kNumFds)];
+    msghdr msg{
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control,
+            .msg_controllen = sizeof(control),
+    };
+
+    ssize_t recd = TEMP_FAILURE_RETRY(recvmsg(clientFd.get(), &msg, MSG_CMSG_CLOEXEC));
+
+    // take ownership of anything received first, so nothing leaks on error
+    std::array<unique_fd, RpcSharedMemoryChannel::kNumFds> fds;
+    size_t numFds = 0;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+        for (size_t i = 0; i < n; i++) {
+            unique_fd fd(data[i]);
+            if (numFds < fds.size()) fds[numFds] = std::move(fd);
+            numFds++;
+        }
+    }
+
+    if (recd != sizeof(*id) || (msg.msg_flags & MSG_CTRUNC)) {
+        ALOGE("Could not read ID from fd %d", clientFd.get());
+        return false;
+    }
+
+    if (numFds == 0) return true;
+    if (numFds != fds.size()) {
+        ALOGE("Expecting %zu fds for shared memory connection, but got %zu", fds.size(), numFds);
+        return false;
+    }
+
+    *sharedMemory = RpcSharedMemoryChannel::makeForServer(std::move(fds));
+    return *sharedMemory != nullptr;
+}
+
 void RpcServer::establishConnection(sp<RpcServer>&& server, base::unique_fd clientFd) {
     LOG_ALWAYS_FATAL_IF(this != server.get(), "Must pass same ownership object");
 
     // TODO(b/183988761): cannot trust this simple ID
     LOG_ALWAYS_FATAL_IF(!mAgreedExperimental, "no!");
-    bool idValid = true;
     int32_t id;
-    if (sizeof(id) != read(clientFd.get(), &id, sizeof(id))) {
-        ALOGE("Could not read ID from fd %d", clientFd.get());
-        idValid = false;
-    }
+    std::unique_ptr<RpcSharedMemoryChannel> sharedMemory;
+    bool idValid = readSessionId(clientFd, &id, &sharedMemory);
 
     std::thread thisThread;
     sp<RpcSession> session;
+    bool useEventLoop = false;
     {
         std::lock_guard<std::mutex> _l(mLock);
 
@@ -216,8 +283,20 @@ void RpcServer::establishConnection(sp<RpcServer>&& server, base::unique_fd clie
             session = it->second;
         }
 
-        detachGuard.Disable();
-        session->preJoin(std::move(thisThread));
+        // The event loop only watches sockets, so shared memory connections
+        // always get a thread of their own.
+        useEventLoop = mEventLoopEnabled && sharedMemory == nullptr;
+        if (!useEventLoop) {
+            detachGuard.Disable();
+            session->preJoin(std::move(thisThread));
+        }
+    }
+
+    if (useEventLoop) {
+        // this thread only needed to read the ID, the worker threads serve
+        // the connection from here on
+        addToEventLoop(session, session->addIdleServerConnection(std::move(clientFd)));
+        return;
     }
 
     // avoid strong cycle
@@ -227,7 +306,92 @@ void RpcServer::establishConnection(sp<RpcServer>&& server, base::unique_fd clie
     // DO NOT ACCESS MEMBER VARIABLES BELOW
     //
 
-    session->join(std::move(clientFd));
+    session->join(std::move(clientFd), std::move(sharedMemory));
+}
+
+void RpcServer::startEventLoopLocked() {
+    mEpollFd.reset(epoll_create1(EPOLL_CLOEXEC));
+    LOG_ALWAYS_FATAL_IF(!mEpollFd.ok(), "Could not create epoll set: %s", strerror(errno));
+
+    mEventLoopShutdownFd.reset(eventfd(0, EFD_CLOEXEC));
+    LOG_ALWAYS_FATAL_IF(!mEventLoopShutdownFd.ok(), "Could not create eventfd: %s",
+                        strerror(errno));
+    epoll_event event{
+            .events = EPOLLIN,
+            .data = {.fd = mEventLoopShutdownFd.get()},
+    };
+    LOG_ALWAYS_FATAL_IF(0 != epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, event.data.fd, &event),
+                        "Could not add eventfd to event loop: %s", strerror(errno));
+
+    // workers don't keep the server alive, the destructor stops and joins them
+    for (size_t i = 0; i < mMaxThreads; i++) {
+        mEventLoopWorkers.push_back(std::thread(&RpcServer::eventLoopWorker, this));
+    }
+}
+
+void RpcServer::addToEventLoop(const sp<RpcSession>& session,
+                               const sp<RpcSession::RpcConnection>& connection) {
+    int fd = connection->fd.get();
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        mEventLoopConnections[fd] = EventLoopConnection{
+                .session = session,
+                .connection = connection,
+        };
+    }
+
+    // oneshot, so that only one worker at a time reads from a connection
+    epoll_event event{
+            .events = EPOLLIN | EPOLLONESHOT,
+            .data = {.fd = fd},
+    };
+    if (0 != epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd, &event)) {
+        ALOGE("Could not add fd %d to event loop: %s", fd, strerror(errno));
+        {
+            std::lock_guard<std::mutex> _l(mLock);
+            mEventLoopConnections.erase(fd);
+        }
+        (void)session->removeServerConnection(connection);
+    }
+}
+
+void RpcServer::eventLoopWorker() {
+    while (true) {
+        epoll_event event;
+        int ready = TEMP_FAILURE_RETRY(epoll_wait(mEpollFd.get(), &event, 1, -1 /*timeout*/));
+        if (ready < 0) {
+            ALOGE("Could not wait on event loop: %s", strerror(errno));
+            return;
+        }
+        if (ready == 0) continue;
+
+        int fd = event.data.fd;
+        if (fd == mEventLoopShutdownFd.get()) return;
+
+        EventLoopConnection item;
+        {
+            std::lock_guard<std::mutex> _l(mLock);
+            auto it = mEventLoopConnections.find(fd);
+            if (it == mEventLoopConnections.end()) continue;
+            item = it->second;
+        }
+
+        // The connection can't fire again until it is re-armed, so this is the
+        // only thread reading from it, and any nested transactions made while
+        // executing this command will use it on this thread.
+        if (item.session->serveOneCommand(item.connection)) {
+            event.events = EPOLLIN | EPOLLONESHOT;
+            if (0 == epoll_ctl(mEpollFd.get(), EPOLL_CTL_MOD, fd, &event)) continue;
+
+            ALOGE("Could not re-arm fd %d in event loop: %s", fd, strerror(errno));
+            (void)item.session->removeServerConnection(item.connection);
+        }
+
+        // connection fd is still open here, since 'item' holds it
+        (void)epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, fd, nullptr);
+        std::lock_guard<std::mutex> _l(mLock);
+        mEventLoopConnections.erase(fd);
+    }
 }
 
 bool RpcServer::setupSocketServer(const RpcSocketAddress& addr) {
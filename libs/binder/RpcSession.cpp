@@ -19,6 +19,7 @@
 #include <binder/RpcSession.h>
 
 #include <inttypes.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <string_view>
@@ -28,6 +29,7 @@
 #include <binder/Stability.h>
 #include <utils/String8.h>
 
+#include "RpcSharedMemoryChannel.h"
 #include "RpcSocketAddress.h"
 #include "RpcState.h"
 #include "RpcWireFormat.h"
@@ -53,6 +55,9 @@ RpcSession::~RpcSession() {
                         "Should not be able to destroy a session with servers in use.");
 }
 
+RpcSession::RpcConnection::RpcConnection() {}
+RpcSession::RpcConnection::~RpcConnection() {}
+
 sp<RpcSession> RpcSession::make() {
     return sp<RpcSession>::make();
 }
@@ -61,6 +66,14 @@ bool RpcSession::setupUnixDomainClient(const char* path) {
     return setupSocketClient(UnixSocketAddress(path));
 }
 
+bool RpcSession::setupSharedMemoryClient(const char* path) {
+    {
+        std::lock_guard<std::mutex> _l(mMutex);
+        mSharedMemoryTransport = true;
+    }
+    return setupSocketClient(UnixSocketAddress(path));
+}
+
 bool RpcSession::setupVsockClient(unsigned int cid, unsigned int port) {
     return setupSocketClient(VsockSocketAddress(cid, port));
 }
@@ -88,29 +101,49 @@ bool RpcSession::addNullDebuggingClient() {
     return true;
 }
 
+void RpcSession::setOnewayPipeliningEnabled(bool enabled) {
+    std::lock_guard<std::mutex> _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mClientConnections.size() != 0,
+                        "Must set oneway pipelining before setting up the session");
+    mOnewayPipelining = enabled;
+}
+
 sp<IBinder> RpcSession::getRootObject() {
     ExclusiveConnection connection(sp<RpcSession>::fromExisting(this), ConnectionUse::CLIENT);
-    return state()->getRootObject(connection.fd(), sp<RpcSession>::fromExisting(this));
+    return state()->getRootObject(connection.get(), sp<RpcSession>::fromExisting(this));
 }
 
 status_t RpcSession::getRemoteMaxThreads(size_t* maxThreads) {
     ExclusiveConnection connection(sp<RpcSession>::fromExisting(this), ConnectionUse::CLIENT);
-    return state()->getMaxThreads(connection.fd(), sp<RpcSession>::fromExisting(this), maxThreads);
+    return state()->getMaxThreads(connection.get(), sp<RpcSession>::fromExisting(this), maxThreads);
 }
 
 status_t RpcSession::transact(const RpcAddress& address, uint32_t code, const Parcel& data,
                               Parcel* reply, uint32_t flags) {
+    if ((flags & IBinder::FLAG_ONEWAY) && mOnewayPipelining) {
+        bool shouldFlush = false;
+        if (status_t status =
+                    state()->queueAsyncTransaction(address, code, data, flags, &shouldFlush);
+            status != OK || !shouldFlush) {
+            return status;
+        }
+
+        ExclusiveConnection connection(sp<RpcSession>::fromExisting(this),
+                                       ConnectionUse::CLIENT_ASYNC);
+        return state()->flushAsyncTransactions(connection.get());
+    }
+
     ExclusiveConnection connection(sp<RpcSession>::fromExisting(this),
                                    (flags & IBinder::FLAG_ONEWAY) ? ConnectionUse::CLIENT_ASYNC
                                                                   : ConnectionUse::CLIENT);
-    return state()->transact(connection.fd(), address, code, data,
+    return state()->transact(connection.get(), address, code, data,
                              sp<RpcSession>::fromExisting(this), reply, flags);
 }
 
 status_t RpcSession::sendDecStrong(const RpcAddress& address) {
     ExclusiveConnection connection(sp<RpcSession>::fromExisting(this),
                                    ConnectionUse::CLIENT_REFCOUNT);
-    return state()->sendDecStrong(connection.fd(), address);
+    return state()->sendDecStrong(connection.get(), address);
 }
 
 status_t RpcSession::readId() {
@@ -123,7 +156,7 @@ status_t RpcSession::readId() {
 
     ExclusiveConnection connection(sp<RpcSession>::fromExisting(this), ConnectionUse::CLIENT);
     status_t status =
-            state()->getSessionId(connection.fd(), sp<RpcSession>::fromExisting(this), &id);
+            state()->getSessionId(connection.get(), sp<RpcSession>::fromExisting(this), &id);
     if (status != OK) return status;
 
     LOG_RPC_DETAIL("RpcSession %p has id %d", this, id);
@@ -141,13 +174,18 @@ void RpcSession::preJoin(std::thread thread) {
 }
 
 void RpcSession::join(unique_fd client) {
+    join(std::move(client), nullptr);
+}
+
+void RpcSession::join(unique_fd client, std::unique_ptr<RpcSharedMemoryChannel> sharedMemory) {
     // must be registered to allow arbitrary client code executing commands to
     // be able to do nested calls (we can't only read from it)
-    sp<RpcConnection> connection = assignServerToThisThread(std::move(client));
+    sp<RpcConnection> connection =
+            assignServerToThisThread(std::move(client), std::move(sharedMemory));
 
     while (true) {
         status_t error =
-                state()->getAndExecuteCommand(connection->fd, sp<RpcSession>::fromExisting(this));
+                state()->getAndExecuteCommand(connection, sp<RpcSession>::fromExisting(this));
 
         if (error != OK) {
             ALOGI("Binder connection thread closing w/ status %s", statusToString(error).c_str());
@@ -222,6 +260,31 @@ bool RpcSession::setupSocketClient(const RpcSocketAddress& addr) {
     return true;
 }
 
+static bool sendSessionId(const unique_fd& fd, int32_t id,
+                          const RpcSharedMemoryChannel* sharedMemory) {
+    iovec iov{&id, sizeof(id)};
+    msghdr msg{
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+    };
+
+    // the shared memory for the connection is sent along with the ID
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * RpcSharedMemoryChannel::kNumFds)];
+    if (sharedMemory != nullptr) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * RpcSharedMemoryChannel::kNumFds);
+        auto fds = sharedMemory->fds();
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    return sizeof(id) == TEMP_FAILURE_RETRY(sendmsg(fd.get(), &msg, MSG_NOSIGNAL));
+}
+
 bool RpcSession::setupOneSocketClient(const RpcSocketAddress& addr, int32_t id) {
     for (size_t tries = 0; tries < 5; tries++) {
         if (tries > 0) usleep(10000);
@@ -246,7 +309,13 @@ bool RpcSession::setupOneSocketClient(const RpcSocketAddress& addr, int32_t id)
             return false;
         }
 
-        if (sizeof(id) != TEMP_FAILURE_RETRY(write(serverFd.get(), &id, sizeof(id)))) {
+        std::unique_ptr<RpcSharedMemoryChannel> sharedMemory;
+        if (mSharedMemoryTransport) {
+            sharedMemory = RpcSharedMemoryChannel::makeForClient();
+            if (sharedMemory == nullptr) return false;
+        }
+
+        if (!sendSessionId(serverFd, id, sharedMemory.get())) {
             int savedErrno = errno;
             ALOGE("Could not write id to socket at %s: %s", addr.toString().c_str(),
                   strerror(savedErrno));
@@ -255,7 +324,7 @@ bool RpcSession::setupOneSocketClient(const RpcSocketAddress& addr, int32_t id)
 
         LOG_RPC_DETAIL("Socket at %s client with fd %d", addr.toString().c_str(), serverFd.get());
 
-        addClientConnection(std::move(serverFd));
+        addClientConnection(std::move(serverFd), std::move(sharedMemory));
         return true;
     }
 
@@ -264,9 +333,15 @@ bool RpcSession::setupOneSocketClient(const RpcSocketAddress& addr, int32_t id)
 }
 
 void RpcSession::addClientConnection(unique_fd fd) {
+    addClientConnection(std::move(fd), nullptr);
+}
+
+void RpcSession::addClientConnection(unique_fd fd,
+                                     std::unique_ptr<RpcSharedMemoryChannel> sharedMemory) {
     std::lock_guard<std::mutex> _l(mMutex);
     sp<RpcConnection> session = sp<RpcConnection>::make();
     session->fd = std::move(fd);
+    session->sharedMemory = std::move(sharedMemory);
     mClientConnections.push_back(session);
 }
 
@@ -276,15 +351,55 @@ void RpcSession::setForServer(const wp<RpcServer>& server, int32_t sessionId) {
 }
 
 sp<RpcSession::RpcConnection> RpcSession::assignServerToThisThread(unique_fd fd) {
+    return assignServerToThisThread(std::move(fd), nullptr);
+}
+
+sp<RpcSession::RpcConnection> RpcSession::assignServerToThisThread(
+        unique_fd fd, std::unique_ptr<RpcSharedMemoryChannel> sharedMemory) {
     std::lock_guard<std::mutex> _l(mMutex);
     sp<RpcConnection> session = sp<RpcConnection>::make();
     session->fd = std::move(fd);
+    session->sharedMemory = std::move(sharedMemory);
     session->exclusiveTid = gettid();
     mServerConnections.push_back(session);
 
     return session;
 }
 
+sp<RpcSession::RpcConnection> RpcSession::addIdleServerConnection(unique_fd fd) {
+    std::lock_guard<std::mutex> _l(mMutex);
+    sp<RpcConnection> session = sp<RpcConnection>::make();
+    session->fd = std::move(fd);
+    mServerConnections.push_back(session);
+
+    return session;
+}
+
+bool RpcSession::serveOneCommand(const sp<RpcConnection>& connection) {
+    {
+        std::lock_guard<std::mutex> _l(mMutex);
+        LOG_ALWAYS_FATAL_IF(connection->exclusiveTid != std::nullopt,
+                            "Connection is already being served by thread %d",
+                            *connection->exclusiveTid);
+        connection->exclusiveTid = gettid();
+    }
+
+    status_t error = state()->getAndExecuteCommand(connection, sp<RpcSession>::fromExisting(this));
+
+    {
+        std::lock_guard<std::mutex> _l(mMutex);
+        connection->exclusiveTid = std::nullopt;
+    }
+
+    if (error != OK) {
+        ALOGI("Binder connection closing w/ status %s", statusToString(error).c_str());
+        LOG_ALWAYS_FATAL_IF(!removeServerConnection(connection),
+                            "bad state: connection object guaranteed to be in list");
+        return false;
+    }
+    return true;
+}
+
 bool RpcSession::removeServerConnection(const sp<RpcConnection>& connection) {
     std::lock_guard<std::mutex> _l(mMutex);
     if (auto it = std::find(mServerConnections.begin(), mServerConnections.end(), connection);
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcSharedMemoryChannel"
+
+#include "RpcSharedMemoryChannel.h"
+
+#include <log/log.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace android {
+
+using base::unique_fd;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "must be usable in shared memory");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "must be usable in shared memory");
+
+// Large enough to hold the largest transaction RpcState will accept, so a
+// transaction can be written without waiting for the other side to read.
+constexpr size_t kRingCapacity = 128 * 1024;
+
+struct RpcSharedMemoryChannel::Ring {
+    // total number of bytes ever written, only modified by the producer
+    std::atomic<uint64_t> head;
+    // total number of bytes ever read, only modified by the consumer
+    std::atomic<uint64_t> tail;
+    // set while the consumer (or producer) is blocked on its eventfd
+    std::atomic<uint32_t> consumerWaiting;
+    std::atomic<uint32_t> producerWaiting;
+
+    uint8_t data[kRingCapacity];
+};
+
+struct RpcSharedMemoryChannel::Layout {
+    Ring toServer;
+    Ring toClient;
+};
+
+std::unique_ptr<RpcSharedMemoryChannel> RpcSharedMemoryChannel::makeForClient() {
+    std::array<unique_fd, kNumFds> fds;
+
+    fds[0].reset(memfd_create("RpcSharedMemoryChannel", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!fds[0].ok()) {
+        ALOGE("Could not create memfd: %s", strerror(errno));
+        return nullptr;
+    }
+    if (0 != ftruncate(fds[0].get(), sizeof(Layout))) {
+        ALOGE("Could not size memfd: %s", strerror(errno));
+        return nullptr;
+    }
+    // the server relies on this never changing size underneath it
+    if (0 != fcntl(fds[0].get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)) {
+        ALOGE("Could not seal memfd: %s", strerror(errno));
+        return nullptr;
+    }
+
+    for (size_t i = 1; i < kNumFds; i++) {
+        fds[i].reset(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+        if (!fds[i].ok()) {
+            ALOGE("Could not create eventfd: %s", strerror(errno));
+            return nullptr;
+        }
+    }
+
+    // a new memfd is zero-filled, which is the initial state of both rings
+    void* mapped =
+            mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0].get(), 0);
+    if (mapped == MAP_FAILED) {
+        ALOGE("Could not map memfd: %s", strerror(errno));
+        return nullptr;
+    }
+
+    return std::unique_ptr<RpcSharedMemoryChannel>(
+            new RpcSharedMemoryChannel(std::move(fds), static_cast<Layout*>(mapped),
+                                       false /*isServer*/));
+}
+
+std::unique_ptr<RpcSharedMemoryChannel> RpcSharedMemoryChannel::makeForServer(
+        std::array<unique_fd, kNumFds> fds) {
+    struct stat st;
+    if (0 != fstat(fds[0].get(), &st) || st.st_size != static_cast<off_t>(sizeof(Layout))) {
+        ALOGE("Shared memory for connection has an unexpected size.");
+        return nullptr;
+    }
+
+    int seals = fcntl(fds[0].get(), F_GET_SEALS);
+    if (seals < 0 || (seals & (F_SEAL_SHRINK | F_SEAL_SEAL)) != (F_SEAL_SHRINK | F_SEAL_SEAL)) {
+        ALOGE("Shared memory for connection is not sealed against shrinking.");
+        return nullptr;
+    }
+
+    void* mapped =
+            mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0].get(), 0);
+    if (mapped == MAP_FAILED) {
+        ALOGE("Could not map shared memory for connection: %s", strerror(errno));
+        return nullptr;
+    }
+
+    return std::unique_ptr<RpcSharedMemoryChannel>(
+            new RpcSharedMemoryChannel(std::move(fds), static_cast<Layout*>(mapped),
+                                       true /*isServer*/));
+}
+
+RpcSharedMemoryChannel::RpcSharedMemoryChannel(std::array<unique_fd, kNumFds> fds,
+                                               Layout* layout, bool isServer)
+      : mFds(std::move(fds)), mLayout(layout) {
+    if (isServer) {
+        mOut = &mLayout->toClient;
+        mIn = &mLayout->toServer;
+        mWaitFd = mFds[2].get();
+        mWakeFd = mFds[1].get();
+    } else {
+        mOut = &mLayout->toServer;
+        mIn = &mLayout->toClient;
+        mWaitFd = mFds[1].get();
+        mWakeFd = mFds[2].get();
+    }
+}
+
+RpcSharedMemoryChannel::~RpcSharedMemoryChannel() {
+    munmap(mLayout, sizeof(Layout));
+}
+
+std::array<int, RpcSharedMemoryChannel::kNumFds> RpcSharedMemoryChannel::fds() const {
+    std::array<int, kNumFds> ret;
+    for (size_t i = 0; i < kNumFds; i++) ret[i] = mFds[i].get();
+    return ret;
+}
+
+ssize_t RpcSharedMemoryChannel::readable() const {
+    uint64_t used = mIn->head.load() - mIn->tail.load(std::memory_order_relaxed);
+    if (used > kRingCapacity) return -1;
+    return used;
+}
+
+ssize_t RpcSharedMemoryChannel::writable() const {
+    uint64_t used = mOut->head.load(std::memory_order_relaxed) - mOut->tail.load();
+    if (used > kRingCapacity) return -1;
+    return kRingCapacity - used;
+}
+
+void RpcSharedMemoryChannel::wakeOtherSide() {
+    uint64_t one = 1;
+    if (sizeof(one) != TEMP_FAILURE_RETRY(::write(mWakeFd, &one, sizeof(one)))) {
+        // only fails if the counter would overflow, so a wakeup is still pending
+        ALOGW("Could not signal eventfd: %s", strerror(errno));
+    }
+}
+
+template <typename Ready>
+bool RpcSharedMemoryChannel::waitFor(const unique_fd& socket, std::atomic<uint32_t>* waiting,
+                                     Ready ready) {
+    while (true) {
+        // Paired with the other side updating the ring and then checking this
+        // flag, so one of us always sees the other's update.
+        waiting->store(1);
+        if (ready()) break;
+
+        // Nothing else is sent on the socket once the connection is set up,
+        // so any event there means that the other side is gone.
+        pollfd pfds[]{
+                {.fd = mWaitFd, .events = POLLIN, .revents = 0},
+                {.fd = socket.get(), .events = POLLIN | POLLRDHUP, .revents = 0},
+        };
+        if (0 > TEMP_FAILURE_RETRY(poll(pfds, 2, -1 /*timeout*/))) {
+            ALOGE("Could not poll shared memory connection: %s", strerror(errno));
+            waiting->store(0);
+            return false;
+        }
+        if (pfds[1].revents != 0) {
+            waiting->store(0);
+            // the other side may have written something before leaving
+            return ready();
+        }
+
+        uint64_t count;
+        (void)TEMP_FAILURE_RETRY(::read(mWaitFd, &count, sizeof(count)));
+    }
+    waiting->store(0);
+    return true;
+}
+
+bool RpcSharedMemoryChannel::write(const unique_fd& socket, const iovec* iovs, size_t niovs) {
+    for (size_t i = 0; i < niovs; i++) {
+        const uint8_t* src = static_cast<const uint8_t*>(iovs[i].iov_base);
+        size_t remaining = iovs[i].iov_len;
+
+        while (remaining > 0) {
+            ssize_t space = writable();
+            if (space < 0) {
+                ALOGE("Shared memory ring was corrupted by the other side.");
+                return false;
+            }
+            if (space == 0) {
+                if (!waitFor(socket, &mOut->producerWaiting, [&] { return writable() != 0; })) {
+                    return false;
+                }
+                continue;
+            }
+
+            size_t len = std::min(static_cast<size_t>(space), remaining);
+            uint64_t head = mOut->head.load(std::memory_order_relaxed);
+            size_t offset = head % kRingCapacity;
+            size_t first = std::min(len, kRingCapacity - offset);
+            memcpy(mOut->data + offset, src, first);
+            memcpy(mOut->data, src + first, len - first);
+            mOut->head.store(head + len);
+
+            if (mOut->consumerWaiting.load()) wakeOtherSide();
+
+            src += len;
+            remaining -= len;
+        }
+    }
+    return true;
+}
+
+bool RpcSharedMemoryChannel::read(const unique_fd& socket, const iovec* iovs, size_t niovs) {
+    for (size_t i = 0; i < niovs; i++) {
+        uint8_t* dst = static_cast<uint8_t*>(iovs[i].iov_base);
+        size_t remaining = iovs[i].iov_len;
+
+        while (remaining > 0) {
+            ssize_t avail = readable();
+            if (avail < 0) {
+                ALOGE("Shared memory ring was corrupted by the other side.");
+                return false;
+            }
+            if (avail == 0) {
+                if (!waitFor(socket, &mIn->consumerWaiting, [&] { return readable() != 0; })) {
+                    return false;
+                }
+                continue;
+            }
+
+            size_t len = std::min(static_cast<size_t>(avail), remaining);
+            uint64_t tail = mIn->tail.load(std::memory_order_relaxed);
+            size_t offset = tail % kRingCapacity;
+            size_t first = std::min(len, kRingCapacity - offset);
+            memcpy(dst, mIn->data + offset, first);
+            memcpy(dst + first, mIn->data, len - first);
+            mIn->tail.store(tail + len);
+
+            if (mIn->producerWaiting.load()) wakeOtherSide();
+
+            dst += len;
+            remaining -= len;
+        }
+    }
+    return true;
+}
+
+} // namespace android
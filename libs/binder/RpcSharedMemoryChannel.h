@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include <sys/uio.h>
+
+namespace android {
+
+/**
+ * Transport for a single RpcSession connection between two processes on the
+ * same host. The client creates a memfd holding two single-producer,
+ * single-consumer byte rings (one for each direction) and an eventfd for each
+ * side, and sends them to the server over the connection's unix domain
+ * socket when the connection is set up.
+ *
+ * After that, all data is copied directly into the rings, and eventfds are
+ * only signaled when the other side is blocked waiting for data or for space.
+ * The socket is kept open to detect when the other side goes away.
+ *
+ * Each side of a connection is only ever used by one thread at a time (see
+ * RpcSession::ExclusiveConnection), so no locking is needed.
+ */
+class RpcSharedMemoryChannel {
+public:
+    // memfd, client eventfd, server eventfd
+    static constexpr size_t kNumFds = 3;
+
+    /**
+     * Creates and initializes the shared memory for a new connection. The file
+     * descriptors from fds() should then be sent to the server.
+     */
+    static std::unique_ptr<RpcSharedMemoryChannel> makeForClient();
+
+    /**
+     * Maps the shared memory for a connection received from a client,
+     * checking that it is usable. Returns nullptr if it can't be used.
+     */
+    static std::unique_ptr<RpcSharedMemoryChannel> makeForServer(
+            std::array<base::unique_fd, kNumFds> fds);
+
+    ~RpcSharedMemoryChannel();
+
+    std::array<int, kNumFds> fds() const;
+
+    /**
+     * Blocks until all of 'iovs' has been written (or read). 'socket' is the
+     * socket of the connection, it is only used to detect that the other side
+     * has hung up, in which case this returns false.
+     */
+    [[nodiscard]] bool write(const base::unique_fd& socket, const iovec* iovs, size_t niovs);
+    [[nodiscard]] bool read(const base::unique_fd& socket, const iovec* iovs, size_t niovs);
+
+private:
+    struct Ring;
+    struct Layout;
+
+    RpcSharedMemoryChannel(std::array<base::unique_fd, kNumFds> fds, Layout* layout,
+                           bool isServer);
+
+    // returns the number of bytes available to read from mIn (or write to
+    // mOut), or -1 if the other side has corrupted the ring
+    ssize_t readable() const;
+    ssize_t writable() const;
+
+    // Waits until 'ready' returns non-zero, while 'waiting' is set so that the
+    // other side knows to signal our eventfd.
+    template <typename Ready>
+    bool waitFor(const base::unique_fd& socket, std::atomic<uint32_t>* waiting, Ready ready);
+    void wakeOtherSide();
+
+    std::array<base::unique_fd, kNumFds> mFds;
+    Layout* mLayout;
+    // ring this side writes to, and ring this side reads from
+    Ring* mOut;
+    Ring* mIn;
+    // eventfd this side waits on, and eventfd of the other side
+    int mWaitFd;
+    int mWakeFd;
+};
+
+} // namespace android
@@ -22,9 +22,15 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "RpcSharedMemoryChannel.h"
 #include "RpcWireFormat.h"
 
+#include <android-base/macros.h>
+
 #include <inttypes.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace android {
 
@@ -203,62 +209,136 @@ RpcState::CommandData::CommandData(size_t size) : mSize(size) {
     mData.reset(new (std::nothrow) uint8_t[size]);
 }
 
-bool RpcState::rpcSend(const base::unique_fd& fd, const char* what, const void* data, size_t size) {
-    LOG_RPC_DETAIL("Sending %s on fd %d: %s", what, fd.get(), hexString(data, size).c_str());
+bool RpcState::rpcSend(const sp<RpcSession::RpcConnection>& connection, const char* what,
+                       iovec* iovs, size_t niovs) {
+    size_t size = 0;
+    for (size_t i = 0; i < niovs; i++) {
+        LOG_RPC_DETAIL("Sending %s (part %zu) on fd %d: %s", what, i, connection->fd.get(),
+                       hexString(iovs[i].iov_base, iovs[i].iov_len).c_str());
+        if (__builtin_add_overflow(size, iovs[i].iov_len, &size) ||
+            size > std::numeric_limits<ssize_t>::max()) {
+            ALOGE("Cannot send %s (too big)", what);
+            terminate();
+            return false;
+        }
+    }
 
-    if (size > std::numeric_limits<ssize_t>::max()) {
-        ALOGE("Cannot send %s at size %zu (too big)", what, size);
+    if (niovs > IOV_MAX) {
+        ALOGE("Cannot send %s in %zu pieces (max %d)", what, niovs, IOV_MAX);
         terminate();
         return false;
     }
 
-    ssize_t sent = TEMP_FAILURE_RETRY(send(fd.get(), data, size, MSG_NOSIGNAL));
+    if (connection->sharedMemory != nullptr) {
+        if (!connection->sharedMemory->write(connection->fd, iovs, niovs)) {
+            ALOGE("Failed to send %s (%zu bytes) through shared memory of fd %d", what, size,
+                  connection->fd.get());
+            terminate();
+            return false;
+        }
+        return true;
+    }
 
-    if (sent < 0 || sent != static_cast<ssize_t>(size)) {
-        ALOGE("Failed to send %s (sent %zd of %zu bytes) on fd %d, error: %s", what, sent, size,
-              fd.get(), strerror(errno));
+    // A single sendmsg gathers the header and the Parcel payload directly from
+    // their own buffers, so no intermediate copy of the payload is needed.
+    msghdr msg{
+            .msg_iov = iovs,
+            .msg_iovlen = niovs,
+    };
 
-        terminate();
-        return false;
+    size_t sentTotal = 0;
+    while (sentTotal < size) {
+        ssize_t sent = TEMP_FAILURE_RETRY(sendmsg(connection->fd.get(), &msg, MSG_NOSIGNAL));
+        if (sent <= 0) {
+            ALOGE("Failed to send %s (sent %zu of %zu bytes) on fd %d, error: %s", what, sentTotal,
+                  size, connection->fd.get(), strerror(errno));
+            terminate();
+            return false;
+        }
+        sentTotal += sent;
+
+        // short write, advance past what was sent and try again
+        size_t remaining = sent;
+        while (msg.msg_iovlen > 0 && remaining >= msg.msg_iov->iov_len) {
+            remaining -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (remaining > 0) {
+            msg.msg_iov->iov_base = reinterpret_cast<uint8_t*>(msg.msg_iov->iov_base) + remaining;
+            msg.msg_iov->iov_len -= remaining;
+        }
     }
 
     return true;
 }
 
-bool RpcState::rpcRec(const base::unique_fd& fd, const char* what, void* data, size_t size) {
-    if (size > std::numeric_limits<ssize_t>::max()) {
-        ALOGE("Cannot rec %s at size %zu (too big)", what, size);
+bool RpcState::rpcRec(const sp<RpcSession::RpcConnection>& connection, const char* what,
+                      iovec* iovs, size_t niovs) {
+    size_t size = 0;
+    for (size_t i = 0; i < niovs; i++) {
+        if (__builtin_add_overflow(size, iovs[i].iov_len, &size) ||
+            size > std::numeric_limits<ssize_t>::max()) {
+            ALOGE("Cannot rec %s (too big)", what);
+            terminate();
+            return false;
+        }
+    }
+
+    if (niovs > IOV_MAX) {
+        ALOGE("Cannot rec %s in %zu pieces (max %d)", what, niovs, IOV_MAX);
         terminate();
         return false;
     }
 
-    ssize_t recd = TEMP_FAILURE_RETRY(recv(fd.get(), data, size, MSG_WAITALL | MSG_NOSIGNAL));
+    if (connection->sharedMemory != nullptr) {
+        if (!connection->sharedMemory->read(connection->fd, iovs, niovs)) {
+            LOG_RPC_DETAIL("Failed to read %s (%zu bytes) through shared memory of fd %d", what,
+                           size, connection->fd.get());
+            terminate();
+            return false;
+        }
+        return true;
+    }
+
+    msghdr msg{
+            .msg_iov = iovs,
+            .msg_iovlen = niovs,
+    };
+
+    ssize_t recd =
+            TEMP_FAILURE_RETRY(recvmsg(connection->fd.get(), &msg, MSG_WAITALL | MSG_NOSIGNAL));
 
     if (recd < 0 || recd != static_cast<ssize_t>(size)) {
         terminate();
 
         if (recd == 0 && errno == 0) {
-            LOG_RPC_DETAIL("No more data when trying to read %s on fd %d", what, fd.get());
+            LOG_RPC_DETAIL("No more data when trying to read %s on fd %d", what,
+                           connection->fd.get());
             return false;
         }
 
         ALOGE("Failed to read %s (received %zd of %zu bytes) on fd %d, error: %s", what, recd, size,
-              fd.get(), strerror(errno));
+              connection->fd.get(), strerror(errno));
         return false;
     } else {
-        LOG_RPC_DETAIL("Received %s on fd %d: %s", what, fd.get(), hexString(data, size).c_str());
+        for (size_t i = 0; i < niovs; i++) {
+            LOG_RPC_DETAIL("Received %s (part %zu) on fd %d: %s", what, i, connection->fd.get(),
+                           hexString(iovs[i].iov_base, iovs[i].iov_len).c_str());
+        }
     }
 
     return true;
 }
 
-sp<IBinder> RpcState::getRootObject(const base::unique_fd& fd, const sp<RpcSession>& session) {
+sp<IBinder> RpcState::getRootObject(const sp<RpcSession::RpcConnection>& connection,
+                                    const sp<RpcSession>& session) {
     Parcel data;
     data.markForRpc(session);
     Parcel reply;
 
-    status_t status = transact(fd, RpcAddress::zero(), RPC_SPECIAL_TRANSACT_GET_ROOT, data, session,
-                               &reply, 0);
+    status_t status = transact(connection, RpcAddress::zero(), RPC_SPECIAL_TRANSACT_GET_ROOT, data,
+                               session, &reply, 0);
     if (status != OK) {
         ALOGE("Error getting root object: %s", statusToString(status).c_str());
         return nullptr;
@@ -267,14 +347,14 @@ sp<IBinder> RpcState::getRootObject(const base::unique_fd& fd, const sp<RpcSessi
     return reply.readStrongBinder();
 }
 
-status_t RpcState::getMaxThreads(const base::unique_fd& fd, const sp<RpcSession>& session,
-                                 size_t* maxThreadsOut) {
+status_t RpcState::getMaxThreads(const sp<RpcSession::RpcConnection>& connection,
+                                 const sp<RpcSession>& session, size_t* maxThreadsOut) {
     Parcel data;
     data.markForRpc(session);
     Parcel reply;
 
-    status_t status = transact(fd, RpcAddress::zero(), RPC_SPECIAL_TRANSACT_GET_MAX_THREADS, data,
-                               session, &reply, 0);
+    status_t status = transact(connection, RpcAddress::zero(),
+                               RPC_SPECIAL_TRANSACT_GET_MAX_THREADS, data, session, &reply, 0);
     if (status != OK) {
         ALOGE("Error getting max threads: %s", statusToString(status).c_str());
         return status;
@@ -292,14 +372,14 @@ status_t RpcState::getMaxThreads(const base::unique_fd& fd, const sp<RpcSession>
     return OK;
 }
 
-status_t RpcState::getSessionId(const base::unique_fd& fd, const sp<RpcSession>& session,
-                                int32_t* sessionIdOut) {
+status_t RpcState::getSessionId(const sp<RpcSession::RpcConnection>& connection,
+                                const sp<RpcSession>& session, int32_t* sessionIdOut) {
     Parcel data;
     data.markForRpc(session);
     Parcel reply;
 
-    status_t status = transact(fd, RpcAddress::zero(), RPC_SPECIAL_TRANSACT_GET_SESSION_ID, data,
-                               session, &reply, 0);
+    status_t status = transact(connection, RpcAddress::zero(),
+                               RPC_SPECIAL_TRANSACT_GET_SESSION_ID, data, session, &reply, 0);
     if (status != OK) {
         ALOGE("Error getting session ID: %s", statusToString(status).c_str());
         return status;
@@ -313,9 +393,9 @@ status_t RpcState::getSessionId(const base::unique_fd& fd, const sp<RpcSession>&
     return OK;
 }
 
-status_t RpcState::transact(const base::unique_fd& fd, const RpcAddress& address, uint32_t code,
-                            const Parcel& data, const sp<RpcSession>& session, Parcel* reply,
-                            uint32_t flags) {
+status_t RpcState::prepareTransaction(const RpcAddress& address, uint32_t code,
+                                      const Parcel& data, uint32_t flags,
+                                      RpcWireTransaction* transaction) {
     uint64_t asyncNumber = 0;
 
     if (!address.isZero()) {
@@ -340,35 +420,41 @@ status_t RpcState::transact(const base::unique_fd& fd, const RpcAddress& address
         return BAD_TYPE;
     }
 
-    RpcWireTransaction transaction{
+    *transaction = RpcWireTransaction{
             .address = address.viewRawEmbedded(),
             .code = code,
             .flags = flags,
             .asyncNumber = asyncNumber,
     };
+    return OK;
+}
 
-    CommandData transactionData(sizeof(RpcWireTransaction) + data.dataSize());
-    if (!transactionData.valid()) {
-        return NO_MEMORY;
+status_t RpcState::transact(const sp<RpcSession::RpcConnection>& connection,
+                            const RpcAddress& address, uint32_t code, const Parcel& data,
+                            const sp<RpcSession>& session, Parcel* reply, uint32_t flags) {
+    RpcWireTransaction transaction;
+    if (status_t status = prepareTransaction(address, code, data, flags, &transaction);
+        status != OK) {
+        return status;
     }
 
-    memcpy(transactionData.data() + 0, &transaction, sizeof(RpcWireTransaction));
-    memcpy(transactionData.data() + sizeof(RpcWireTransaction), data.data(), data.dataSize());
-
-    if (transactionData.size() > std::numeric_limits<uint32_t>::max()) {
-        ALOGE("Transaction size too big %zu", transactionData.size());
+    size_t bodySize = sizeof(RpcWireTransaction) + data.dataSize();
+    if (bodySize > std::numeric_limits<uint32_t>::max()) {
+        ALOGE("Transaction size too big %zu", bodySize);
         return BAD_VALUE;
     }
 
     RpcWireHeader command{
             .command = RPC_COMMAND_TRANSACT,
-            .bodySize = static_cast<uint32_t>(transactionData.size()),
+            .bodySize = static_cast<uint32_t>(bodySize),
     };
 
-    if (!rpcSend(fd, "transact header", &command, sizeof(command))) {
-        return DEAD_OBJECT;
-    }
-    if (!rpcSend(fd, "command body", transactionData.data(), transactionData.size())) {
+    iovec iovs[]{
+            {&command, sizeof(RpcWireHeader)},
+            {&transaction, sizeof(RpcWireTransaction)},
+            {const_cast<uint8_t*>(data.data()), data.dataSize()},
+    };
+    if (!rpcSend(connection, "transaction", iovs, arraysize(iovs))) {
         return DEAD_OBJECT;
     }
 
@@ -378,7 +464,81 @@ status_t RpcState::transact(const base::unique_fd& fd, const RpcAddress& address
 
     LOG_ALWAYS_FATAL_IF(reply == nullptr, "Reply parcel must be used for synchronous transaction.");
 
-    return waitForReply(fd, session, reply);
+    return waitForReply(connection, session, reply);
+}
+
+status_t RpcState::queueAsyncTransaction(const RpcAddress& address, uint32_t code,
+                                         const Parcel& data, uint32_t flags, bool* shouldFlush) {
+    LOG_ALWAYS_FATAL_IF(!(flags & IBinder::FLAG_ONEWAY), "Only oneway transactions are queued");
+
+    RpcWireTransaction transaction;
+    if (status_t status = prepareTransaction(address, code, data, flags, &transaction);
+        status != OK) {
+        return status;
+    }
+
+    size_t bodySize = sizeof(RpcWireTransaction) + data.dataSize();
+    if (bodySize > std::numeric_limits<uint32_t>::max()) {
+        ALOGE("Transaction size too big %zu", bodySize);
+        return BAD_VALUE;
+    }
+
+    RpcWireHeader command{
+            .command = RPC_COMMAND_TRANSACT,
+            .bodySize = static_cast<uint32_t>(bodySize),
+    };
+
+    // The Parcel belongs to the caller, who doesn't wait for it to be written,
+    // so this is the one place the payload is copied.
+    CommandData commandData(sizeof(RpcWireHeader) + bodySize);
+    if (!commandData.valid()) {
+        return NO_MEMORY;
+    }
+    uint8_t* out = commandData.data();
+    memcpy(out, &command, sizeof(RpcWireHeader));
+    out += sizeof(RpcWireHeader);
+    memcpy(out, &transaction, sizeof(RpcWireTransaction));
+    out += sizeof(RpcWireTransaction);
+    memcpy(out, data.data(), data.dataSize());
+
+    std::lock_guard<std::mutex> _l(mAsyncQueueMutex);
+    mAsyncQueue.push_back(std::move(commandData));
+    *shouldFlush = !mAsyncFlushing;
+    mAsyncFlushing = true;
+    return OK;
+}
+
+status_t RpcState::flushAsyncTransactions(const sp<RpcSession::RpcConnection>& connection) {
+    while (true) {
+        std::vector<CommandData> queue;
+        {
+            std::lock_guard<std::mutex> _l(mAsyncQueueMutex);
+            LOG_ALWAYS_FATAL_IF(!mAsyncFlushing, "Flushing oneway queue without owning it");
+            if (mAsyncQueue.empty()) {
+                mAsyncFlushing = false;
+                return OK;
+            }
+            queue.swap(mAsyncQueue);
+        }
+
+        LOG_RPC_DETAIL("Flushing %zu queued oneway transactions on fd %d", queue.size(),
+                       connection->fd.get());
+
+        std::vector<iovec> iovs;
+        iovs.reserve(queue.size());
+        for (CommandData& commandData : queue) {
+            iovs.push_back({commandData.data(), commandData.size()});
+        }
+
+        for (size_t i = 0; i < iovs.size(); i += IOV_MAX) {
+            size_t niovs = std::min(iovs.size() - i, static_cast<size_t>(IOV_MAX));
+            if (!rpcSend(connection, "queued oneway transactions", iovs.data() + i, niovs)) {
+                std::lock_guard<std::mutex> _l(mAsyncQueueMutex);
+                mAsyncFlushing = false;
+                return DEAD_OBJECT;
+            }
+        }
+    }
 }
 
 static void cleanup_reply_data(Parcel* p, const uint8_t* data, size_t dataSize,
@@ -390,17 +550,18 @@ static void cleanup_reply_data(Parcel* p, const uint8_t* data, size_t dataSize,
     LOG_ALWAYS_FATAL_IF(objectsCount, 0);
 }
 
-status_t RpcState::waitForReply(const base::unique_fd& fd, const sp<RpcSession>& session,
-                                Parcel* reply) {
+status_t RpcState::waitForReply(const sp<RpcSession::RpcConnection>& connection,
+                                const sp<RpcSession>& session, Parcel* reply) {
     RpcWireHeader command;
     while (true) {
-        if (!rpcRec(fd, "command header", &command, sizeof(command))) {
+        iovec iov{&command, sizeof(command)};
+        if (!rpcRec(connection, "command header", &iov, 1)) {
             return DEAD_OBJECT;
         }
 
         if (command.command == RPC_COMMAND_REPLY) break;
 
-        status_t status = processServerCommand(fd, session, command);
+        status_t status = processServerCommand(connection, session, command);
         if (status != OK) return status;
     }
 
@@ -409,7 +570,8 @@ status_t RpcState::waitForReply(const base::unique_fd& fd, const sp<RpcSession>&
         return NO_MEMORY;
     }
 
-    if (!rpcRec(fd, "reply body", data.data(), command.bodySize)) {
+    iovec iov{data.data(), command.bodySize};
+    if (!rpcRec(connection, "reply body", &iov, 1)) {
         return DEAD_OBJECT;
     }
 
@@ -431,7 +593,8 @@ status_t RpcState::waitForReply(const base::unique_fd& fd, const sp<RpcSession>&
     return OK;
 }
 
-status_t RpcState::sendDecStrong(const base::unique_fd& fd, const RpcAddress& addr) {
+status_t RpcState::sendDecStrong(const sp<RpcSession::RpcConnection>& connection,
+                                 const RpcAddress& addr) {
     {
         std::lock_guard<std::mutex> _l(mNodeMutex);
         if (mTerminated) return DEAD_OBJECT; // avoid fatal only, otherwise races
@@ -451,30 +614,35 @@ status_t RpcState::sendDecStrong(const base::unique_fd& fd, const RpcAddress& ad
             .command = RPC_COMMAND_DEC_STRONG,
             .bodySize = sizeof(RpcWireAddress),
     };
-    if (!rpcSend(fd, "dec ref header", &cmd, sizeof(cmd))) return DEAD_OBJECT;
-    if (!rpcSend(fd, "dec ref body", &addr.viewRawEmbedded(), sizeof(RpcWireAddress)))
-        return DEAD_OBJECT;
+    iovec iovs[]{
+            {&cmd, sizeof(cmd)},
+            {const_cast<RpcWireAddress*>(&addr.viewRawEmbedded()), sizeof(RpcWireAddress)},
+    };
+    if (!rpcSend(connection, "dec ref", iovs, arraysize(iovs))) return DEAD_OBJECT;
     return OK;
 }
 
-status_t RpcState::getAndExecuteCommand(const base::unique_fd& fd, const sp<RpcSession>& session) {
-    LOG_RPC_DETAIL("getAndExecuteCommand on fd %d", fd.get());
+status_t RpcState::getAndExecuteCommand(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<RpcSession>& session) {
+    LOG_RPC_DETAIL("getAndExecuteCommand on fd %d", connection->fd.get());
 
     RpcWireHeader command;
-    if (!rpcRec(fd, "command header", &command, sizeof(command))) {
+    iovec iov{&command, sizeof(command)};
+    if (!rpcRec(connection, "command header", &iov, 1)) {
         return DEAD_OBJECT;
     }
 
-    return processServerCommand(fd, session, command);
+    return processServerCommand(connection, session, command);
 }
 
-status_t RpcState::processServerCommand(const base::unique_fd& fd, const sp<RpcSession>& session,
+status_t RpcState::processServerCommand(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<RpcSession>& session,
                                         const RpcWireHeader& command) {
     switch (command.command) {
         case RPC_COMMAND_TRANSACT:
-            return processTransact(fd, session, command);
+            return processTransact(connection, session, command);
         case RPC_COMMAND_DEC_STRONG:
-            return processDecStrong(fd, command);
+            return processDecStrong(connection, command);
     }
 
     // We should always know the version of the opposing side, and since the
@@ -486,19 +654,20 @@ status_t RpcState::processServerCommand(const base::unique_fd& fd, const sp<RpcS
     terminate();
     return DEAD_OBJECT;
 }
-status_t RpcState::processTransact(const base::unique_fd& fd, const sp<RpcSession>& session,
-                                   const RpcWireHeader& command) {
+status_t RpcState::processTransact(const sp<RpcSession::RpcConnection>& connection,
+                                   const sp<RpcSession>& session, const RpcWireHeader& command) {
     LOG_ALWAYS_FATAL_IF(command.command != RPC_COMMAND_TRANSACT, "command: %d", command.command);
 
     CommandData transactionData(command.bodySize);
     if (!transactionData.valid()) {
         return NO_MEMORY;
     }
-    if (!rpcRec(fd, "transaction body", transactionData.data(), transactionData.size())) {
+    iovec iov{transactionData.data(), transactionData.size()};
+    if (!rpcRec(connection, "transaction body", &iov, 1)) {
         return DEAD_OBJECT;
     }
 
-    return processTransactInternal(fd, session, std::move(transactionData));
+    return processTransactInternal(connection, session, std::move(transactionData));
 }
 
 static void do_nothing_to_transact_data(Parcel* p, const uint8_t* data, size_t dataSize,
@@ -510,7 +679,8 @@ static void do_nothing_to_transact_data(Parcel* p, const uint8_t* data, size_t d
     (void)objectsCount;
 }
 
-status_t RpcState::processTransactInternal(const base::unique_fd& fd, const sp<RpcSession>& session,
+status_t RpcState::processTransactInternal(const sp<RpcSession::RpcConnection>& connection,
+                                           const sp<RpcSession>& session,
                                            CommandData transactionData) {
     if (transactionData.size() < sizeof(RpcWireTransaction)) {
         ALOGE("Expecting %zu but got %zu bytes for RpcWireTransaction. Terminating!",
@@ -665,7 +835,7 @@ status_t RpcState::processTransactInternal(const base::unique_fd& fd, const sp<R
                         const_cast<BinderNode::AsyncTodo&>(it->second.asyncTodo.top()).data);
                 it->second.asyncTodo.pop();
                 _l.unlock();
-                return processTransactInternal(fd, session, std::move(data));
+                return processTransactInternal(connection, session, std::move(data));
             }
         }
         return OK;
@@ -675,41 +845,39 @@ status_t RpcState::processTransactInternal(const base::unique_fd& fd, const sp<R
             .status = replyStatus,
     };
 
-    CommandData replyData(sizeof(RpcWireReply) + reply.dataSize());
-    if (!replyData.valid()) {
-        return NO_MEMORY;
-    }
-    memcpy(replyData.data() + 0, &rpcReply, sizeof(RpcWireReply));
-    memcpy(replyData.data() + sizeof(RpcWireReply), reply.data(), reply.dataSize());
-
-    if (replyData.size() > std::numeric_limits<uint32_t>::max()) {
-        ALOGE("Reply size too big %zu", transactionData.size());
+    size_t bodySize = sizeof(RpcWireReply) + reply.dataSize();
+    if (bodySize > std::numeric_limits<uint32_t>::max()) {
+        ALOGE("Reply size too big %zu", bodySize);
         terminate();
         return BAD_VALUE;
     }
 
     RpcWireHeader cmdReply{
             .command = RPC_COMMAND_REPLY,
-            .bodySize = static_cast<uint32_t>(replyData.size()),
+            .bodySize = static_cast<uint32_t>(bodySize),
     };
 
-    if (!rpcSend(fd, "reply header", &cmdReply, sizeof(RpcWireHeader))) {
-        return DEAD_OBJECT;
-    }
-    if (!rpcSend(fd, "reply body", replyData.data(), replyData.size())) {
+    iovec iovs[]{
+            {&cmdReply, sizeof(RpcWireHeader)},
+            {&rpcReply, sizeof(RpcWireReply)},
+            {const_cast<uint8_t*>(reply.data()), reply.dataSize()},
+    };
+    if (!rpcSend(connection, "reply", iovs, arraysize(iovs))) {
         return DEAD_OBJECT;
     }
     return OK;
 }
 
-status_t RpcState::processDecStrong(const base::unique_fd& fd, const RpcWireHeader& command) {
+status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connection,
+                                    const RpcWireHeader& command) {
     LOG_ALWAYS_FATAL_IF(command.command != RPC_COMMAND_DEC_STRONG, "command: %d", command.command);
 
     CommandData commandData(command.bodySize);
     if (!commandData.valid()) {
         return NO_MEMORY;
     }
-    if (!rpcRec(fd, "dec ref body", commandData.data(), commandData.size())) {
+    iovec iov{commandData.data(), commandData.size()};
+    if (!rpcRec(connection, "dec ref body", &iov, 1)) {
         return DEAD_OBJECT;
     }
 
@@ -24,9 +24,12 @@
 #include <optional>
 #include <queue>
 
+#include <sys/uio.h>
+
 namespace android {
 
 struct RpcWireHeader;
+struct RpcWireTransaction;
 
 /**
  * Log a lot more information about RPC calls, when debugging issues. Usually,
@@ -52,17 +55,35 @@ public:
     ~RpcState();
 
     // TODO(b/182940634): combine some special transactions into one "getServerInfo" call?
-    sp<IBinder> getRootObject(const base::unique_fd& fd, const sp<RpcSession>& session);
-    status_t getMaxThreads(const base::unique_fd& fd, const sp<RpcSession>& session,
-                           size_t* maxThreadsOut);
-    status_t getSessionId(const base::unique_fd& fd, const sp<RpcSession>& session,
-                          int32_t* sessionIdOut);
-
-    [[nodiscard]] status_t transact(const base::unique_fd& fd, const RpcAddress& address,
-                                    uint32_t code, const Parcel& data,
+    sp<IBinder> getRootObject(const sp<RpcSession::RpcConnection>& connection,
+                              const sp<RpcSession>& session);
+    status_t getMaxThreads(const sp<RpcSession::RpcConnection>& connection,
+                           const sp<RpcSession>& session, size_t* maxThreadsOut);
+    status_t getSessionId(const sp<RpcSession::RpcConnection>& connection,
+                          const sp<RpcSession>& session, int32_t* sessionIdOut);
+
+    [[nodiscard]] status_t transact(const sp<RpcSession::RpcConnection>& connection,
+                                    const RpcAddress& address, uint32_t code, const Parcel& data,
                                     const sp<RpcSession>& session, Parcel* reply, uint32_t flags);
-    [[nodiscard]] status_t sendDecStrong(const base::unique_fd& fd, const RpcAddress& address);
-    [[nodiscard]] status_t getAndExecuteCommand(const base::unique_fd& fd,
+    [[nodiscard]] status_t sendDecStrong(const sp<RpcSession::RpcConnection>& connection,
+                                         const RpcAddress& address);
+
+    /**
+     * Serializes a oneway transaction into the pipelined queue without writing
+     * it. If no other thread is currently flushing the queue, *shouldFlush is
+     * set, and the caller must call flushAsyncTransactions.
+     */
+    [[nodiscard]] status_t queueAsyncTransaction(const RpcAddress& address, uint32_t code,
+                                                 const Parcel& data, uint32_t flags,
+                                                 bool* shouldFlush);
+    /**
+     * Writes out everything in the pipelined queue (including transactions
+     * which are queued while this is writing), coalescing them into as few
+     * syscalls as possible.
+     */
+    [[nodiscard]] status_t flushAsyncTransactions(const sp<RpcSession::RpcConnection>& connection);
+
+    [[nodiscard]] status_t getAndExecuteCommand(const sp<RpcSession::RpcConnection>& connection,
                                                 const sp<RpcSession>& session);
 
     /**
@@ -115,21 +136,29 @@ private:
         size_t mSize;
     };
 
-    [[nodiscard]] bool rpcSend(const base::unique_fd& fd, const char* what, const void* data,
-                               size_t size);
-    [[nodiscard]] bool rpcRec(const base::unique_fd& fd, const char* what, void* data, size_t size);
-
-    [[nodiscard]] status_t waitForReply(const base::unique_fd& fd, const sp<RpcSession>& session,
-                                        Parcel* reply);
-    [[nodiscard]] status_t processServerCommand(const base::unique_fd& fd,
+    // Send or receive all of the buffers described by 'iovs' in a single
+    // syscall (sendmsg/recvmsg), so that the header and the Parcel payload
+    // don't need to be copied into a temporary buffer first.
+    [[nodiscard]] bool rpcSend(const sp<RpcSession::RpcConnection>& connection, const char* what,
+                               iovec* iovs, size_t niovs);
+    [[nodiscard]] bool rpcRec(const sp<RpcSession::RpcConnection>& connection, const char* what,
+                              iovec* iovs, size_t niovs);
+
+    [[nodiscard]] status_t prepareTransaction(const RpcAddress& address, uint32_t code,
+                                              const Parcel& data, uint32_t flags,
+                                              RpcWireTransaction* transaction);
+    [[nodiscard]] status_t waitForReply(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<RpcSession>& session, Parcel* reply);
+    [[nodiscard]] status_t processServerCommand(const sp<RpcSession::RpcConnection>& connection,
                                                 const sp<RpcSession>& session,
                                                 const RpcWireHeader& command);
-    [[nodiscard]] status_t processTransact(const base::unique_fd& fd, const sp<RpcSession>& session,
+    [[nodiscard]] status_t processTransact(const sp<RpcSession::RpcConnection>& connection,
+                                           const sp<RpcSession>& session,
                                            const RpcWireHeader& command);
-    [[nodiscard]] status_t processTransactInternal(const base::unique_fd& fd,
+    [[nodiscard]] status_t processTransactInternal(const sp<RpcSession::RpcConnection>& connection,
                                                    const sp<RpcSession>& session,
                                                    CommandData transactionData);
-    [[nodiscard]] status_t processDecStrong(const base::unique_fd& fd,
+    [[nodiscard]] status_t processDecStrong(const sp<RpcSession::RpcConnection>& connection,
                                             const RpcWireHeader& command);
 
     struct BinderNode {
@@ -183,6 +212,12 @@ private:
     bool mTerminated = false;
     // binders known by both sides of a session
     std::map<RpcAddress, BinderNode> mNodeForAddress;
+
+    std::mutex mAsyncQueueMutex; // for all below
+    // serialized oneway transactions (header and body) waiting to be written
+    std::vector<CommandData> mAsyncQueue;
+    // whether a thread is currently responsible for writing mAsyncQueue
+    bool mAsyncFlushing = false;
 };
 
 } // namespace android
@@ -94,9 +94,15 @@ bool Stability::requiresVintfDeclaration(const sp<IBinder>& binder) {
     return check(getCategory(binder.get()), Level::VINTF);
 }
 
-void Stability::tryMarkCompilationUnit(IBinder* binder) {
+int32_t Stability::tryMarkCompilationUnit(IBinder* binder) {
+    // Nearly every binder written is already marked (and null binders are always undeclared), so
+    // that is checked before anything else.
+    int32_t current = getCategory(binder).repr();
+    if (current != 0) return current;
+
     auto stability = Category::currentFromLevel(getLocalLevel());
     (void) setRepr(binder, stability.repr(), REPR_NONE);
+    return getCategory(binder).repr();
 }
 
 Stability::Level Stability::getLocalLevel() {
@@ -117,6 +123,11 @@ status_t Stability::setRepr(IBinder* binder, int32_t representation, uint32_t fl
     bool allowDowngrade = flags & REPR_ALLOW_DOWNGRADE;
 
     auto current = getCategory(binder);
+
+    // A binder is mostly read back with the stability it already has, which was checked when it
+    // was set.
+    if (current.repr() == representation && representation != 0) return OK;
+
     auto setting = Category::fromRepr(representation);
 
     // If we have ahold of a binder with a newer declared version, then it
@@ -193,6 +204,9 @@ Stability::Category Stability::getCategory(IBinder* binder) {
 }
 
 bool Stability::check(Category provided, Level required) {
+    // The usual case of a binder from the same partition.
+    if (provided.level == required) return true;
+
     bool stable = (provided.level & required) == required;
 
     if (provided.level != UNDECLARED && !isDeclaredLevel(provided.level)) {
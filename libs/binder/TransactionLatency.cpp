@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionLatency"
+
+#include "TransactionLatency.h"
+
+#include <binder/IBinder.h>
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+
+#include <inttypes.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+std::atomic<bool> gTransactionLatencyTrackingEnabled = false;
+
+// distinct targets and codes tracked by each thread, anything beyond this is
+// only counted as dropped
+constexpr size_t kSlotsPerThread = 64;
+
+struct LatencySlot {
+    // set once the key below is written, and never cleared
+    std::atomic<bool> used = false;
+    uintptr_t target = 0;
+    uint32_t code = 0;
+    bool server = false;
+    String16 descriptor;
+
+    // only written by the thread owning the table, so these don't need
+    // fetch_add, they are atomic so that they can be read while recording
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> totalNs = 0;
+    std::atomic<uint64_t> maxNs = 0;
+    std::atomic<uint64_t> buckets[TransactionLatencyStats::kNumBuckets] = {};
+};
+
+struct LatencyTable {
+    LatencySlot slots[kSlotsPerThread];
+    std::atomic<uint64_t> dropped = 0;
+};
+
+// Tables are never freed. When a thread exits, its table is reused by the
+// next thread which records something, so nothing recorded is lost.
+static std::mutex gTablesMutex; // for below
+static std::vector<LatencyTable*> gTables;
+static std::vector<LatencyTable*> gFreeTables;
+
+static thread_local LatencyTable* gThreadTable = nullptr;
+static pthread_key_t gThreadTableKey;
+static pthread_once_t gThreadTableKeyOnce = PTHREAD_ONCE_INIT;
+
+static void releaseThreadTable(void* table) {
+    std::lock_guard<std::mutex> _l(gTablesMutex);
+    gFreeTables.push_back(static_cast<LatencyTable*>(table));
+}
+
+static LatencyTable* getThreadTable() {
+    if (CC_LIKELY(gThreadTable != nullptr)) return gThreadTable;
+
+    pthread_once(&gThreadTableKeyOnce,
+                 [] { pthread_key_create(&gThreadTableKey, releaseThreadTable); });
+
+    LatencyTable* table;
+    {
+        std::lock_guard<std::mutex> _l(gTablesMutex);
+        if (!gFreeTables.empty()) {
+            table = gFreeTables.back();
+            gFreeTables.pop_back();
+        } else {
+            table = new LatencyTable;
+            gTables.push_back(table);
+        }
+    }
+    pthread_setspecific(gThreadTableKey, table);
+    gThreadTable = table;
+    return table;
+}
+
+// Reads the descriptor written by Parcel::writeInterfaceToken, if 'data'
+// starts with one.
+static String16 readDescriptor(const Parcel& data) {
+    const size_t pos = data.dataPosition();
+    data.setDataPosition(0);
+
+    String16 descriptor;
+    int32_t strictPolicy, workSource, header;
+    if (data.readInt32(&strictPolicy) == OK && data.readInt32(&workSource) == OK &&
+        data.readInt32(&header) == OK &&
+        (header == B_PACK_CHARS('S', 'Y', 'S', 'T') ||
+         header == B_PACK_CHARS('V', 'N', 'D', 'R'))) {
+        size_t len;
+        const char16_t* str = data.readString16Inplace(&len);
+        if (str != nullptr) descriptor = String16(str, len);
+    }
+
+    data.setDataPosition(pos);
+    return descriptor;
+}
+
+static size_t bucketFor(nsecs_t elapsed) {
+    uint64_t us = static_cast<uint64_t>(elapsed) / 1000;
+    if (us == 0) return 0;
+    size_t bucket = 64 - __builtin_clzll(us);
+    return std::min(bucket, TransactionLatencyStats::kNumBuckets - 1);
+}
+
+template <typename T>
+static void increment(std::atomic<T>& value, T by) {
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+void recordTransactionLatency(uintptr_t target, uint32_t code, bool server, const Parcel& data,
+                              nsecs_t elapsed) {
+    if (elapsed < 0) elapsed = 0;
+    LatencyTable* table = getThreadTable();
+
+    size_t hash = (target * 31 + code) * 2 + server;
+    LatencySlot* slot = nullptr;
+    for (size_t i = 0; i < kSlotsPerThread; i++) {
+        LatencySlot* candidate = &table->slots[(hash + i) % kSlotsPerThread];
+        if (!candidate->used.load(std::memory_order_relaxed)) {
+            candidate->target = target;
+            candidate->code = code;
+            candidate->server = server;
+            candidate->descriptor = readDescriptor(data);
+            // publish the key to collectTransactionLatencyStats
+            candidate->used.store(true, std::memory_order_release);
+            slot = candidate;
+            break;
+        }
+        if (candidate->target == target && candidate->code == code &&
+            candidate->server == server) {
+            slot = candidate;
+            break;
+        }
+    }
+    if (slot == nullptr) {
+        increment<uint64_t>(table->dropped, 1);
+        return;
+    }
+
+    increment<uint64_t>(slot->count, 1);
+    increment<uint64_t>(slot->totalNs, elapsed);
+    if (static_cast<uint64_t>(elapsed) > slot->maxNs.load(std::memory_order_relaxed)) {
+        slot->maxNs.store(elapsed, std::memory_order_relaxed);
+    }
+    increment<uint64_t>(slot->buckets[bucketFor(elapsed)], 1);
+}
+
+TransactionLatencyStats collectTransactionLatencyStats() {
+    TransactionLatencyStats stats;
+    uint64_t dropped = 0;
+
+    std::lock_guard<std::mutex> _l(gTablesMutex);
+    for (const LatencyTable* table : gTables) {
+        TransactionLatencyStats tableStats;
+        for (const LatencySlot& slot : table->slots) {
+            if (!slot.used.load(std::memory_order_acquire)) continue;
+
+            TransactionLatencyStats::Entry entry;
+            entry.descriptor = slot.descriptor;
+            entry.code = slot.code;
+            entry.server = slot.server;
+            entry.count = slot.count.load(std::memory_order_relaxed);
+            entry.totalNs = slot.totalNs.load(std::memory_order_relaxed);
+            entry.maxNs = slot.maxNs.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < TransactionLatencyStats::kNumBuckets; i++) {
+                entry.buckets[i] = slot.buckets[i].load(std::memory_order_relaxed);
+            }
+            tableStats.entries.push_back(std::move(entry));
+        }
+        stats.merge(tableStats);
+        dropped += table->dropped.load(std::memory_order_relaxed);
+    }
+
+    if (dropped != 0) {
+        ALOGW("%" PRIu64 " transactions were not tracked, too many distinct codes and targets.",
+              dropped);
+    }
+    return stats;
+}
+
+} // namespace android
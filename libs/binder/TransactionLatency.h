@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Parcel.h>
+#include <binder/TransactionLatencyStats.h>
+#include <utils/Timers.h>
+
+#include <atomic>
+
+namespace android {
+
+// Implementation of ProcessState::setTransactionLatencyTrackingEnabled. Each
+// thread records into its own table, which only that thread writes to, so
+// recording a transaction takes no locks and no atomic read-modify-writes.
+
+extern std::atomic<bool> gTransactionLatencyTrackingEnabled;
+
+inline bool isTransactionLatencyTrackingEnabled() {
+    return gTransactionLatencyTrackingEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records one transaction on the calling thread. 'target' identifies the
+ * binder (a handle for calls, or the BBinder being called), and the interface
+ * descriptor is read from 'data' the first time a target and code are seen.
+ */
+void recordTransactionLatency(uintptr_t target, uint32_t code, bool server, const Parcel& data,
+                              nsecs_t elapsed);
+
+/**
+ * Combines what every thread in this process has recorded so far.
+ */
+TransactionLatencyStats collectTransactionLatencyStats();
+
+} // namespace android
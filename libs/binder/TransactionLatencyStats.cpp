@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/TransactionLatencyStats.h>
+
+#include <android-base/stringprintf.h>
+#include <binder/Parcel.h>
+#include <utils/String8.h>
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace android {
+
+using base::StringAppendF;
+
+// upper bound of a bucket, in microseconds
+static uint64_t bucketLimitUs(size_t bucket) {
+    return uint64_t(1) << bucket;
+}
+
+// the upper bound of the bucket which the 'percent' percentile falls in
+static uint64_t percentileUs(const TransactionLatencyStats::Entry& entry, uint64_t percent) {
+    uint64_t target = (entry.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < TransactionLatencyStats::kNumBuckets; i++) {
+        seen += entry.buckets[i];
+        if (seen >= target) return bucketLimitUs(i);
+    }
+    return bucketLimitUs(TransactionLatencyStats::kNumBuckets - 1);
+}
+
+void TransactionLatencyStats::merge(const TransactionLatencyStats& other) {
+    for (const Entry& from : other.entries) {
+        auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry& e) {
+            return e.code == from.code && e.server == from.server &&
+                    e.descriptor == from.descriptor;
+        });
+        if (it == entries.end()) {
+            entries.push_back(from);
+            continue;
+        }
+
+        it->count += from.count;
+        it->totalNs += from.totalNs;
+        it->maxNs = std::max(it->maxNs, from.maxNs);
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            it->buckets[i] += from.buckets[i];
+        }
+    }
+}
+
+std::string TransactionLatencyStats::toString() const {
+    std::vector<const Entry*> sorted;
+    for (const Entry& entry : entries) sorted.push_back(&entry);
+    // slowest (in total) first
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Entry* a, const Entry* b) { return a->totalNs > b->totalNs; });
+
+    std::string ret;
+    for (const Entry* entry : sorted) {
+        if (entry->count == 0) continue;
+        StringAppendF(&ret,
+                      "%s %s code %u: count %" PRIu64 " avg %" PRIu64 "us max %" PRIu64
+                      "us p50 <%" PRIu64 "us p90 <%" PRIu64 "us p99 <%" PRIu64 "us\n",
+                      entry->server ? "server" : "client",
+                      entry->descriptor.size() == 0 ? "(no descriptor)"
+                                                    : String8(entry->descriptor).c_str(),
+                      entry->code, entry->count, entry->totalNs / entry->count / 1000,
+                      entry->maxNs / 1000, percentileUs(*entry, 50), percentileUs(*entry, 90),
+                      percentileUs(*entry, 99));
+    }
+    return ret;
+}
+
+status_t TransactionLatencyStats::writeToParcel(Parcel* parcel) const {
+    if (entries.size() > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
+
+    status_t status = parcel->writeInt32(static_cast<int32_t>(entries.size()));
+    if (status != OK) return status;
+    for (const Entry& entry : entries) {
+        if (OK != (status = parcel->writeString16(entry.descriptor))) return status;
+        if (OK != (status = parcel->writeUint32(entry.code))) return status;
+        if (OK != (status = parcel->writeBool(entry.server))) return status;
+        if (OK != (status = parcel->writeUint64(entry.count))) return status;
+        if (OK != (status = parcel->writeUint64(entry.totalNs))) return status;
+        if (OK != (status = parcel->writeUint64(entry.maxNs))) return status;
+        std::vector<uint64_t> buckets(entry.buckets.begin(), entry.buckets.end());
+        if (OK != (status = parcel->writeUint64Vector(buckets))) return status;
+    }
+    return OK;
+}
+
+status_t TransactionLatencyStats::readFromParcel(const Parcel* parcel) {
+    int32_t size;
+    status_t status = parcel->readInt32(&size);
+    if (status != OK) return status;
+    // each entry is much larger than this, so this bounds allocations by the
+    // size of the parcel
+    if (size < 0 || static_cast<size_t>(size) > parcel->dataAvail() / sizeof(int32_t)) {
+        return BAD_VALUE;
+    }
+
+    entries.clear();
+    entries.resize(size);
+    for (Entry& entry : entries) {
+        if (OK != (status = parcel->readString16(&entry.descriptor))) return status;
+        if (OK != (status = parcel->readUint32(&entry.code))) return status;
+        if (OK != (status = parcel->readBool(&entry.server))) return status;
+        if (OK != (status = parcel->readUint64(&entry.count))) return status;
+        if (OK != (status = parcel->readUint64(&entry.totalNs))) return status;
+        if (OK != (status = parcel->readUint64(&entry.maxNs))) return status;
+        std::vector<uint64_t> buckets;
+        if (OK != (status = parcel->readUint64Vector(&buckets))) return status;
+        // newer senders may have more buckets, fold those into the last one
+        for (size_t i = 0; i < buckets.size(); i++) {
+            entry.buckets[std::min(i, kNumBuckets - 1)] += buckets[i];
+        }
+    }
+    return OK;
+}
+
+} // namespace android
@@ -38,6 +38,7 @@ class IInterface;
 class Parcel;
 class IResultReceiver;
 class IShellCallback;
+class TransactionLatencyStats;
 
 /**
  * Base class and low-level protocol for a remotable object.
@@ -60,6 +61,7 @@ public:
         SYSPROPS_TRANSACTION = B_PACK_CHARS('_', 'S', 'P', 'R'),
         EXTENSION_TRANSACTION = B_PACK_CHARS('_', 'E', 'X', 'T'),
         DEBUG_PID_TRANSACTION = B_PACK_CHARS('_', 'P', 'I', 'D'),
+        TRANSACTION_LATENCY_TRANSACTION = B_PACK_CHARS('_', 'L', 'A', 'T'),
 
         // See android.os.IBinder.TWEET_TRANSACTION
         // Most importantly, messages can be anything not exceeding 130 UTF-8
@@ -152,6 +154,13 @@ public:
      */
     status_t                getDebugPid(pid_t* outPid);
 
+    /**
+     * Transaction latencies recorded by the process hosting this binder, for
+     * debugging. These are only recorded while that process has enabled
+     * ProcessState::setTransactionLatencyTrackingEnabled.
+     */
+    status_t                getTransactionLatencyStats(TransactionLatencyStats* outStats);
+
     // NOLINTNEXTLINE(google-default-arguments)
     virtual status_t        transact(   uint32_t code,
                                         const Parcel& data,
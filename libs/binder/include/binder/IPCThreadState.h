@@ -103,6 +103,14 @@ public:
             void                setCallRestriction(CallRestriction restriction);
             CallRestriction     getCallRestriction() const;
 
+            // Opt-in for threads that call into binder often. While enabled, the reference
+            // count commands for remote objects are not written to the driver one at a time.
+            // Instead, they go out with the next transaction or flushCommands(), or once a
+            // few dozen are queued. The objects they release stay alive until then, so a
+            // thread that opts in must either make calls soon or flush. Disabling the
+            // deferral flushes the commands.
+            void                setRefCommandsDeferred(bool deferred);
+
             int64_t             clearCallingIdentity();
             // Restores PID/UID (not SID)
             void                restoreCallingIdentity(int64_t token);
@@ -170,6 +178,8 @@ private:
             status_t            waitForResponse(Parcel *reply,
                                                 status_t *acquireResult=nullptr);
             status_t            talkWithDriver(bool doReceive=true);
+            // Like flushIfNeeded(), unless reference count commands are deferred.
+            bool                flushRefCommandsIfNeeded();
             status_t            writeTransactionData(int32_t cmd,
                                                      uint32_t binderFlags,
                                                      int32_t handle,
@@ -177,6 +187,7 @@ private:
                                                      const Parcel& data,
                                                      status_t* statusBuffer);
             status_t            getAndExecuteCommand();
+            status_t            waitForPooledWork();
             status_t            executeCommand(int32_t command);
             void                processPendingDerefs();
             void                processPostWriteDerefs();
@@ -207,6 +218,7 @@ private:
             bool                mPropagateWorkSource;
             bool                mIsLooper;
             bool mIsFlushing;
+            bool                mRefCommandsDeferred;
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
@@ -107,6 +107,15 @@ public:
      * this can be updated.
      */
     virtual std::optional<String16> updatableViaApex(const String16& name) = 0;
+
+    /**
+     * Retrieve several existing services in a single call to the service
+     * manager, non-blocking. The result has an entry for each of 'names', in
+     * order, which is null if that service doesn't exist.
+     *
+     * The default implementation calls checkService for each name.
+     */
+    virtual Vector<sp<IBinder>> checkServices(const Vector<String16>& names) const;
 };
 
 sp<IServiceManager> defaultServiceManager();
@@ -119,6 +128,17 @@ sp<IServiceManager> defaultServiceManager();
  */
 void setDefaultServiceManager(const sp<IServiceManager>& sm);
 
+/**
+ * Keep the binders returned by getService, checkService, checkServices and
+ * waitForService on the default service manager, so that later lookups of the
+ * same names don't call into servicemanager. This is off by default.
+ *
+ * Entries are dropped when the service dies or is registered again, which is
+ * only known to this process if it has binder threads to receive those
+ * notifications, so this should only be enabled after starting a threadpool.
+ */
+void setServiceCacheEnabled(bool enabled);
+
 template<typename INTERFACE>
 sp<INTERFACE> waitForService(const String16& name) {
     const sp<IServiceManager> sm = defaultServiceManager();
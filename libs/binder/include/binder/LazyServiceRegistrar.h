@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 
 #include <binder/IServiceManager.h>
@@ -79,6 +80,24 @@ class LazyServiceRegistrar {
       */
      void setActiveServicesCallback(const std::function<bool(bool)>& activeServicesCallback);
 
+     /**
+      * Wait before shutting down the process once its services have no clients, so that a
+      * client coming back shortly after doesn't pay for a cold start. The delay is twice the
+      * average time the services stayed without clients before being used again, clamped to
+      * [minDelay, maxDelay]: bursty clients keep the process up, occasional ones let it go.
+      * Until such a time has been observed, minDelay is used. Both zero (the default) shuts
+      * the process down as soon as possible.
+      *
+      * The delay only applies to the default shutdown, not to an active services callback.
+      *
+      * A service can also be prewarmed by starting it from its init .rc file, e.g. on
+      * property:sys.boot_completed=1: the process then stays up until it has had clients.
+      *
+      * This method should be called before 'registerService' to avoid races.
+      */
+     void setShutdownDelay(std::chrono::milliseconds minDelay,
+                           std::chrono::milliseconds maxDelay);
+
      /**
       * Try to unregister all services previously registered with 'registerService'.
       * Returns 'true' if successful. This should only be called within the callback registered by
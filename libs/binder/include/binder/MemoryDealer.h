@@ -25,15 +25,24 @@
 namespace android {
 // ----------------------------------------------------------------------------
 
-class SimpleBestFitAllocator;
+class SubAllocator;
 
 // ----------------------------------------------------------------------------
 
 class MemoryDealer : public RefBase
 {
 public:
+    enum class AllocationPolicy {
+        // best fit over a list of the free chunks, the most compact but O(number of chunks)
+        BEST_FIT,
+        // power of two size classes with a free list each (a buddy allocator), O(log(size)):
+        // for many allocations, at the cost of rounding them up to a power of two
+        SIZE_CLASSES,
+    };
+
     explicit MemoryDealer(size_t size, const char* name = nullptr,
             uint32_t flags = 0 /* or bits such as MemoryHeapBase::READ_ONLY */ );
+    MemoryDealer(size_t size, const char* name, uint32_t flags, AllocationPolicy policy);
 
     virtual sp<IMemory> allocate(size_t size);
     virtual void        deallocate(size_t offset);
@@ -42,6 +51,11 @@ public:
     // allocations are aligned to some value. return that value so clients can account for it.
     static size_t      getAllocationAlignment();
 
+    // bytes not allocated, and the size of the largest allocation that can still succeed, which
+    // is smaller when the free memory is fragmented
+    size_t             getFreeSize() const;
+    size_t             getLargestFreeSize() const;
+
     sp<IMemoryHeap> getMemoryHeap() const { return heap(); }
 
 protected:
@@ -49,10 +63,10 @@ protected:
 
 private:
     const sp<IMemoryHeap>&      heap() const;
-    SimpleBestFitAllocator*     allocator() const;
+    SubAllocator*               allocator() const;
 
     sp<IMemoryHeap>             mHeap;
-    SimpleBestFitAllocator*     mAllocator;
+    SubAllocator*               mAllocator;
 };
 
 
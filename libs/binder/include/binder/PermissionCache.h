@@ -21,18 +21,22 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <unordered_map>
+
 #include <utils/String16.h>
 #include <utils/Singleton.h>
-#include <utils/SortedVector.h>
+#include <utils/Timers.h>
 
 namespace android {
 // ---------------------------------------------------------------------------
 
 /*
- * PermissionCache caches permission checks for a given uid.
+ * PermissionCache caches permission checks, granted or denied, for a given uid.
  *
- * Currently the cache is not updated when there is a permission change,
- * for instance when an application is uninstalled.
+ * The cache is not notified when there is a permission change, for instance
+ * when an application is uninstalled: a result is only kept for
+ * CACHE_TIMEOUT, and purgeCache can be called by a process that learns
+ * about a change in another way.
  *
  * IMPORTANT: for the reason stated above, only system permissions are safe
  * to cache. This restriction may be lifted at a later time.
@@ -40,30 +44,44 @@ namespace android {
  */
 
 class PermissionCache : Singleton<PermissionCache> {
-    struct Entry {
+    struct Key {
         String16    name;
         uid_t       uid;
-        bool        granted;
-        inline bool operator < (const Entry& e) const {
-            return (uid == e.uid) ? (name < e.name) : (uid < e.uid);
+        inline bool operator == (const Key& k) const {
+            return uid == k.uid && name == k.name;
         }
     };
-    mutable Mutex mLock;
-    // we pool all the permission names we see, as many permissions checks
-    // will have identical names
-    SortedVector< String16 > mPermissionNamesPool;
-    // this is our cache per say. it stores pooled names.
-    SortedVector< Entry > mCache;
-
-    // free the whole cache, but keep the permission name pool
+    struct KeyHash {
+        size_t operator()(const Key& k) const;
+    };
+    struct Entry {
+        bool        granted;
+        nsecs_t     expiry;
+    };
+    // the checks come from all the binder threads, so the cache is split by
+    // key, each shard with its own lock
+    static constexpr size_t NUM_SHARDS = 8;
+    struct Shard {
+        mutable Mutex lock;
+        std::unordered_map<Key, Entry, KeyHash> cache;
+    };
+    Shard mShards[NUM_SHARDS];
+
+    Shard& shardFor(const Key& key);
+
+    // free the whole cache, or the entries of a uid
     void purge();
+    void purge(uid_t uid);
 
     status_t check(bool* granted,
-            const String16& permission, uid_t uid) const;
+            const String16& permission, uid_t uid);
 
     void cache(const String16& permission, uid_t uid, bool granted);
 
 public:
+    // how long the result of a permission check is reused
+    static constexpr nsecs_t CACHE_TIMEOUT = s2ns(60);
+
     PermissionCache();
 
     static bool checkCallingPermission(const String16& permission);
@@ -75,6 +93,9 @@ public:
             pid_t pid, uid_t uid);
 
     static void purgeCache();
+
+    // forget the permissions of a uid, e.g. when its package goes away
+    static void purgeCache(uid_t uid);
 };
 
 // ---------------------------------------------------------------------------
@@ -16,7 +16,7 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -31,12 +31,18 @@ namespace os {
 /*
  * C++ implementation of PersistableBundle, a mapping from String values to
  * various types that can be saved to persistent and later restored.
+ *
+ * A bundle read from a parcel keeps the bytes it was sent and an index of its
+ * keys, and only reads a value out of them when it is asked for, so that
+ * reading a large bundle costs little when only a few of its values are used.
+ * Its values are all read out on the first change.
  */
 class PersistableBundle : public Parcelable {
 public:
-    PersistableBundle() = default;
-    virtual ~PersistableBundle() = default;
-    PersistableBundle(const PersistableBundle& bundle) = default;
+    PersistableBundle();
+    virtual ~PersistableBundle();
+    PersistableBundle(const PersistableBundle& bundle);
+    PersistableBundle& operator=(const PersistableBundle& bundle);
 
     status_t writeToParcel(Parcel* parcel) const override;
     status_t readFromParcel(const Parcel* parcel) override;
@@ -92,36 +98,17 @@ public:
     std::set<String16> getStringVectorKeys() const;
     std::set<String16> getPersistableBundleKeys() const;
 
-    friend bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs) {
-        return (lhs.mBoolMap == rhs.mBoolMap && lhs.mIntMap == rhs.mIntMap &&
-                lhs.mLongMap == rhs.mLongMap && lhs.mDoubleMap == rhs.mDoubleMap &&
-                lhs.mStringMap == rhs.mStringMap && lhs.mBoolVectorMap == rhs.mBoolVectorMap &&
-                lhs.mIntVectorMap == rhs.mIntVectorMap &&
-                lhs.mLongVectorMap == rhs.mLongVectorMap &&
-                lhs.mDoubleVectorMap == rhs.mDoubleVectorMap &&
-                lhs.mStringVectorMap == rhs.mStringVectorMap &&
-                lhs.mPersistableBundleMap == rhs.mPersistableBundleMap);
-    }
+    friend bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs);
 
     friend bool operator!=(const PersistableBundle& lhs, const PersistableBundle& rhs) {
         return !(lhs == rhs);
     }
 
 private:
-    status_t writeToParcelInner(Parcel* parcel) const;
-    status_t readFromParcelInner(const Parcel* parcel, size_t length);
-
-    std::map<String16, bool> mBoolMap;
-    std::map<String16, int32_t> mIntMap;
-    std::map<String16, int64_t> mLongMap;
-    std::map<String16, double> mDoubleMap;
-    std::map<String16, String16> mStringMap;
-    std::map<String16, std::vector<bool>> mBoolVectorMap;
-    std::map<String16, std::vector<int32_t>> mIntVectorMap;
-    std::map<String16, std::vector<int64_t>> mLongVectorMap;
-    std::map<String16, std::vector<double>> mDoubleVectorMap;
-    std::map<String16, std::vector<String16>> mStringVectorMap;
-    std::map<String16, PersistableBundle> mPersistableBundleMap;
+    // Holds the values, so that how they are stored does not change the layout of this class.
+    struct Impl;
+
+    std::unique_ptr<Impl> mImpl;
 };
 
 }  // namespace os
@@ -58,6 +58,14 @@ public:
             void                spawnPooledThread(bool isMain);
             
             status_t            setThreadPoolMaxThreadCount(size_t maxThreads);
+            // Lets the thread pool follow the load. While every binder thread has been busy for
+            // longer than 'maxStarvationMs', the setThreadPoolMaxThreadCount limit is raised, by
+            // one thread each time, up to 'hardMaxThreads'. Threads started by the driver exit
+            // after being idle for 'idleTimeoutMs' (one of them is kept to wait in the driver),
+            // and the limit goes back down as they do. A 'hardMaxThreads' of 0 turns this off.
+            status_t            setThreadPoolAdaptivePolicy(size_t hardMaxThreads,
+                                                            int64_t maxStarvationMs,
+                                                            int64_t idleTimeoutMs);
             status_t            enableOnewaySpamDetection(bool enable);
             void                giveThreadPoolName();
 
@@ -85,6 +93,11 @@ public:
             // before any threads are spawned.
             void setCallRestriction(CallRestriction restriction);
 
+            // Records latency histograms of transactions made and served by this process, which
+            // can be read with IBinder::getTransactionLatencyStats (e.g. 'dumpsys --latency').
+            // This adds a clock read to each side of a transaction, so it is off by default.
+            void setTransactionLatencyTrackingEnabled(bool enabled);
+
 private:
     static  sp<ProcessState>    init(const char *defaultDriver, bool requireDefault);
 
@@ -98,6 +111,12 @@ private:
             ProcessState&       operator=(const ProcessState& o);
             String8             makeBinderThreadName();
 
+            // For the adaptive thread pool, these must be called with mThreadCountLock held.
+            status_t            setDriverMaxThreadsLocked();
+            void                onThreadPoolStarvedLocked(int64_t starvationTimeMs);
+            // Returns whether an idle pooled thread should exit.
+            bool                retireIdlePooledThread();
+
             struct handle_entry {
                 IBinder* binder;
                 RefBase::weakref_type* refs;
@@ -121,6 +140,16 @@ private:
             size_t              mMaxThreads;
             // Time when thread pool was emptied
             int64_t             mStarvationStartTimeMs;
+            // Value given to setThreadPoolMaxThreadCount, which mMaxThreads starts from when the
+            // pool is adaptive.
+            size_t              mBaseMaxThreads;
+            // Set by setThreadPoolAdaptivePolicy, mAdaptiveMaxThreads is 0 if the pool doesn't
+            // adapt.
+            size_t              mAdaptiveMaxThreads;
+            int64_t             mAdaptiveStarvationMs;
+            int64_t             mAdaptiveIdleTimeoutMs;
+            // Pooled threads which exited after being idle.
+            size_t              mRetiredThreadsCount;
 
     mutable Mutex               mLock;  // protects everything below.
 
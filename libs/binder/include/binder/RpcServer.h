@@ -103,6 +103,20 @@ public:
     void setMaxThreads(size_t threads);
     size_t getMaxThreads();
 
+    /**
+     * By default, each connection is served by its own thread. In event loop
+     * mode, all connections of all sessions are instead watched by a single
+     * epoll set, and a pool of getMaxThreads() worker threads (shared across
+     * sessions) executes commands as they arrive. While a worker is executing
+     * a command, it owns that connection, so nested transactions behave the
+     * same way in both modes. The workers don't keep the server alive. When
+     * it is destroyed, they finish the commands they are executing and are
+     * joined.
+     *
+     * This must be called before join or acceptOne.
+     */
+    void setEventLoopEnabled(bool enabled);
+
     /**
      * The root object can be retrieved by any client, without any
      * authentication. TODO(b/183988761)
@@ -147,17 +161,32 @@ private:
 
     void establishConnection(sp<RpcServer>&& session, base::unique_fd clientFd);
     bool setupSocketServer(const RpcSocketAddress& address);
+    void startEventLoopLocked();
+    void addToEventLoop(const sp<RpcSession>& session,
+                        const sp<RpcSession::RpcConnection>& connection);
+    void eventLoopWorker();
 
     bool mAgreedExperimental = false;
     bool mStarted = false; // TODO(b/185167543): support dynamically added clients
     size_t mMaxThreads = 1;
+    bool mEventLoopEnabled = false;
     base::unique_fd mServer; // socket we are accepting sessions on
+    base::unique_fd mEpollFd; // for event loop mode, set once when starting
+    base::unique_fd mEventLoopShutdownFd; // set with mEpollFd, written when destroyed
+    std::vector<std::thread> mEventLoopWorkers; // set with mEpollFd
 
     std::mutex mLock; // for below
     std::map<std::thread::id, std::thread> mConnectingThreads;
     sp<IBinder> mRootObject;
     wp<IBinder> mRootObjectWeak;
     std::map<int32_t, sp<RpcSession>> mSessions;
+
+    // for event loop mode, all server connections being watched, by fd
+    struct EventLoopConnection {
+        sp<RpcSession> session;
+        sp<RpcSession::RpcConnection> connection;
+    };
+    std::map<int, EventLoopConnection> mEventLoopConnections;
     int32_t mSessionIdCounter = 0;
 };
 
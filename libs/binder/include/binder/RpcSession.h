@@ -22,6 +22,7 @@
 #include <utils/RefBase.h>
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -34,6 +35,7 @@ namespace android {
 
 class Parcel;
 class RpcServer;
+class RpcSharedMemoryChannel;
 class RpcSocketAddress;
 class RpcState;
 
@@ -52,6 +54,14 @@ public:
      */
     [[nodiscard]] bool setupUnixDomainClient(const char* path);
 
+    /**
+     * Connects to an RPC server at a unix domain socket on the same host, like
+     * setupUnixDomainClient. However, each connection only uses its socket to
+     * share a memfd ring buffer with the server, and all transactions are
+     * copied into that shared memory instead of going through the socket.
+     */
+    [[nodiscard]] bool setupSharedMemoryClient(const char* path);
+
     /**
      * Connects to an RPC server at the CVD & port.
      */
@@ -71,6 +81,17 @@ public:
      */
     [[nodiscard]] bool addNullDebuggingClient();
 
+    /**
+     * When enabled, oneway transactions are queued and coalesced into batched
+     * writes on one connection, instead of each one holding a connection
+     * exclusively until its write finishes. Only the thread which ends up
+     * flushing the queue waits for the write. The remote side still processes
+     * oneway transactions to each binder object in order.
+     *
+     * This must be called before setting up the session.
+     */
+    void setOnewayPipeliningEnabled(bool enabled);
+
     /**
      * Query the other side of the session for the root object hosted by that
      * process's RpcServer (if one exists)
@@ -110,6 +131,7 @@ private:
     friend PrivateAccessorForId;
     friend sp<RpcSession>;
     friend RpcServer;
+    friend RpcState;
     RpcSession();
 
     status_t readId();
@@ -118,11 +140,19 @@ private:
     void preJoin(std::thread thread);
     // join on thread passed to preJoin
     void join(base::unique_fd client);
+    void join(base::unique_fd client, std::unique_ptr<RpcSharedMemoryChannel> sharedMemory);
     void terminateLocked();
 
     struct RpcConnection : public RefBase {
+        RpcConnection();
+        ~RpcConnection();
+
         base::unique_fd fd;
 
+        // If set, all data is sent and received over this, and 'fd' is only
+        // used to detect when the other side hangs up.
+        std::unique_ptr<RpcSharedMemoryChannel> sharedMemory;
+
         // whether this or another thread is currently using this fd to make
         // or receive transactions.
         std::optional<pid_t> exclusiveTid;
@@ -131,8 +161,20 @@ private:
     bool setupSocketClient(const RpcSocketAddress& address);
     bool setupOneSocketClient(const RpcSocketAddress& address, int32_t sessionId);
     void addClientConnection(base::unique_fd fd);
+    void addClientConnection(base::unique_fd fd,
+                             std::unique_ptr<RpcSharedMemoryChannel> sharedMemory);
     void setForServer(const wp<RpcServer>& server, int32_t sessionId);
     sp<RpcConnection> assignServerToThisThread(base::unique_fd fd);
+    sp<RpcConnection> assignServerToThisThread(
+            base::unique_fd fd, std::unique_ptr<RpcSharedMemoryChannel> sharedMemory);
+    // For RpcServer's event loop mode, where a connection is not owned by any
+    // thread while it is waiting for a command.
+    sp<RpcConnection> addIdleServerConnection(base::unique_fd fd);
+    // Reads and executes a single command on a connection from
+    // addIdleServerConnection on the calling thread, which owns the connection
+    // (so nested transactions can use it) until the command is finished.
+    // Returns false if the connection is no longer usable and was removed.
+    bool serveOneCommand(const sp<RpcConnection>& connection);
     bool removeServerConnection(const sp<RpcConnection>& connection);
 
     enum class ConnectionUse {
@@ -146,7 +188,7 @@ private:
     public:
         explicit ExclusiveConnection(const sp<RpcSession>& session, ConnectionUse use);
         ~ExclusiveConnection();
-        const base::unique_fd& fd() { return mConnection->fd; }
+        const sp<RpcConnection>& get() { return mConnection; }
 
     private:
         static void findConnection(pid_t tid, sp<RpcConnection>* exclusive,
@@ -199,6 +241,11 @@ private:
     // process? (or combine with mServerConnections)
     std::map<std::thread::id, std::thread> mThreads;
     bool mTerminated = false;
+
+    // see setOnewayPipeliningEnabled, only set before the session is setup
+    bool mOnewayPipelining = false;
+    // whether client connections should be set up with setupSharedMemoryClient
+    bool mSharedMemoryTransport = false;
 };
 
 } // namespace android
@@ -126,7 +126,9 @@ private:
     // through Parcel)
     friend ::android::ProcessState;
 
-    static void tryMarkCompilationUnit(IBinder* binder);
+    // Marks binder with the stability of this compilation unit if it has none yet, and returns
+    // the representation of its stability to write on the wire.
+    static int32_t tryMarkCompilationUnit(IBinder* binder);
 
     enum Level : uint8_t {
         UNDECLARED = 0,
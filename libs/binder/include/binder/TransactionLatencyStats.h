@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Parcelable.h>
+#include <utils/String16.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace android {
+
+/**
+ * Latency histograms of binder transactions made or served by a process,
+ * collected while ProcessState::setTransactionLatencyTrackingEnabled is on.
+ * Use IBinder::getTransactionLatencyStats to get these from the process
+ * hosting a binder.
+ */
+class TransactionLatencyStats : public Parcelable {
+public:
+    // Bucket 0 counts transactions which took less than 1us, and bucket i > 0
+    // counts transactions which took [2^(i-1), 2^i) us. The last bucket also
+    // counts everything slower than that.
+    static constexpr size_t kNumBuckets = 24;
+
+    struct Entry {
+        // descriptor from the interface token of the transaction, if it has one
+        String16 descriptor;
+        uint32_t code = 0;
+        // if set, this is the time taken to handle the transaction in this
+        // process, otherwise it is the round trip time of a synchronous call
+        // made by this process
+        bool server = false;
+
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        std::array<uint64_t, kNumBuckets> buckets{};
+    };
+
+    std::vector<Entry> entries;
+
+    /**
+     * Adds the counts from 'other', for instance from another process or
+     * another thread, combining entries with the same descriptor, code and
+     * direction.
+     */
+    void merge(const TransactionLatencyStats& other);
+
+    /**
+     * Human readable summary, one line per entry, with approximate percentiles
+     * (the upper bound of the bucket they fall in).
+     */
+    std::string toString() const;
+
+    status_t writeToParcel(Parcel* parcel) const override;
+    status_t readFromParcel(const Parcel* parcel) override;
+};
+
+} // namespace android
@@ -598,14 +598,14 @@ binder_status_t AIBinder_prepareTransaction(AIBinder* binder, AParcel** in) {
         return STATUS_INVALID_OPERATION;
     }
 
-    *in = new AParcel(binder);
+    *in = AParcel::create(binder);
     (*in)->get()->markForBinder(binder->getBinder());
 
     status_t status = (*in)->get()->writeInterfaceToken(clazz->getInterfaceDescriptor());
     binder_status_t ret = PruneStatusT(status);
 
     if (ret != STATUS_OK) {
-        delete *in;
+        AParcel::destroy(*in);
         *in = nullptr;
     }
 
@@ -613,7 +613,7 @@ binder_status_t AIBinder_prepareTransaction(AIBinder* binder, AParcel** in) {
 }
 
 static void DestroyParcel(AParcel** parcel) {
-    delete *parcel;
+    AParcel::destroy(*parcel);
     *parcel = nullptr;
 }
 
@@ -651,13 +651,13 @@ binder_status_t AIBinder_transact(AIBinder* binder, transaction_code_t code, APa
         return STATUS_BAD_VALUE;
     }
 
-    *out = new AParcel(binder);
+    *out = AParcel::create(binder);
 
     status_t status = binder->getBinder()->transact(code, *(*in)->get(), (*out)->get(), flags);
     binder_status_t ret = PruneStatusT(status);
 
     if (ret != STATUS_OK) {
-        delete *out;
+        AParcel::destroy(*out);
         *out = nullptr;
     }
 
@@ -21,7 +21,10 @@
 #include "ibinder_internal.h"
 #include "status_internal.h"
 
+#include <pthread.h>
+
 #include <limits>
+#include <new>
 
 #include <android-base/logging.h>
 #include <android-base/unique_fd.h>
@@ -92,14 +95,14 @@ binder_status_t WriteArray<char16_t>(AParcel* parcel, const char16_t* array, int
     if (length <= 0) return STATUS_OK;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    Parcel* rawParcel = parcel->get();
+    // reserve space for the whole array at once, rather than growing per element
+    int32_t* data = static_cast<int32_t*>(parcel->get()->writeInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
     for (int32_t i = 0; i < length; i++) {
-        status = rawParcel->writeChar(array[i]);
-
-        if (status != STATUS_OK) return PruneStatusT(status);
+        data[i] = static_cast<int32_t>(array[i]);
     }
 
     return STATUS_OK;
@@ -152,40 +155,46 @@ binder_status_t ReadArray<char16_t>(const AParcel* parcel, void* arrayData,
     if (array == nullptr) return STATUS_NO_MEMORY;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    for (int32_t i = 0; i < length; i++) {
-        status = rawParcel->readChar(array + i);
+    const int32_t* data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+    for (int32_t i = 0; i < length; i++) {
+        array[i] = static_cast<char16_t>(data[i]);
     }
 
     return STATUS_OK;
 }
 
+// Each element is converted to an int32_t (not packed), like Parcel::writeBool.
 template <typename T>
 binder_status_t WriteArray(AParcel* parcel, const void* arrayData, int32_t length,
-                           ArrayGetter<T> getter, status_t (Parcel::*write)(T)) {
+                           ArrayGetter<T> getter) {
     // we have no clue if arrayData represents a null object or not, we can only infer from length
     bool arrayIsNull = length < 0;
     binder_status_t status = WriteAndValidateArraySize(parcel, arrayIsNull, length);
     if (status != STATUS_OK) return status;
     if (length <= 0) return STATUS_OK;
 
-    Parcel* rawParcel = parcel->get();
+    int32_t size = 0;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    for (int32_t i = 0; i < length; i++) {
-        status = (rawParcel->*write)(getter(arrayData, i));
+    // reserve space for the whole array at once, rather than growing per element
+    int32_t* data = static_cast<int32_t*>(parcel->get()->writeInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+    for (int32_t i = 0; i < length; i++) {
+        data[i] = static_cast<int32_t>(getter(arrayData, i));
     }
 
     return STATUS_OK;
 }
 
+// Each element is converted from an int32_t (not packed), like Parcel::readBool.
 template <typename T>
 binder_status_t ReadArray(const AParcel* parcel, void* arrayData, ArrayAllocator<T> allocator,
-                          ArraySetter<T> setter, status_t (Parcel::*read)(T*) const) {
+                          ArraySetter<T> setter) {
     const Parcel* rawParcel = parcel->get();
 
     int32_t length;
@@ -198,19 +207,78 @@ binder_status_t ReadArray(const AParcel* parcel, void* arrayData, ArrayAllocator
 
     if (length <= 0) return STATUS_OK;
 
-    for (int32_t i = 0; i < length; i++) {
-        T readTarget;
-        status = (rawParcel->*read)(&readTarget);
-        if (status != STATUS_OK) return PruneStatusT(status);
+    int32_t size = 0;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-        setter(arrayData, i, readTarget);
+    const int32_t* data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
+
+    for (int32_t i = 0; i < length; i++) {
+        setter(arrayData, i, static_cast<T>(data[i]));
     }
 
     return STATUS_OK;
 }
 
+// Each thread keeps the memory of a few AParcels, enough for the in and out parcels of nested
+// transactions, to construct the next ones in. Like the Parcel buffer cache, this is trivially
+// destructible, so that AParcels destroyed during thread exit can still use it.
+static constexpr size_t kMaxCachedAParcels = 4;
+
+struct AParcelCache {
+    bool registered;
+    bool closed;
+    size_t count;
+    void* parcels[kMaxCachedAParcels];
+};
+static thread_local AParcelCache gAParcelCache;
+
+static pthread_key_t gAParcelCacheKey;
+static pthread_once_t gAParcelCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static void closeAParcelCache(void* arg) {
+    AParcelCache* cache = static_cast<AParcelCache*>(arg);
+    for (size_t i = 0; i < cache->count; i++) ::operator delete(cache->parcels[i]);
+    cache->count = 0;
+    // anything destroyed after this point goes straight back to the heap
+    cache->closed = true;
+}
+
+static AParcelCache* getAParcelCache() {
+    AParcelCache* cache = &gAParcelCache;
+    if (__builtin_expect(!cache->registered, false)) {
+        // the cached memory is freed when the thread exits
+        pthread_once(&gAParcelCacheKeyOnce,
+                     [] { pthread_key_create(&gAParcelCacheKey, closeAParcelCache); });
+        pthread_setspecific(gAParcelCacheKey, cache);
+        cache->registered = true;
+    }
+    return cache->closed ? nullptr : cache;
+}
+
+AParcel* AParcel::create(AIBinder* binder) {
+    AParcelCache* cache = getAParcelCache();
+    if (cache == nullptr || cache->count == 0) {
+        return new AParcel(binder);
+    }
+    return new (cache->parcels[--cache->count]) AParcel(binder);
+}
+
+void AParcel::destroy(AParcel* parcel) {
+    if (parcel == nullptr) return;
+
+    parcel->~AParcel();
+    // AParcels always come from the default operator new, whichever way they were created
+    AParcelCache* cache = getAParcelCache();
+    if (cache != nullptr && cache->count < kMaxCachedAParcels) {
+        cache->parcels[cache->count++] = parcel;
+        return;
+    }
+    ::operator delete(parcel);
+}
+
 void AParcel_delete(AParcel* parcel) {
-    delete parcel;
+    AParcel::destroy(parcel);
 }
 
 binder_status_t AParcel_setDataPosition(const AParcel* parcel, int32_t position) {
@@ -590,7 +658,7 @@ binder_status_t AParcel_writeDoubleArray(AParcel* parcel, const double* arrayDat
 
 binder_status_t AParcel_writeBoolArray(AParcel* parcel, const void* arrayData, int32_t length,
                                        AParcel_boolArrayGetter getter) {
-    return WriteArray<bool>(parcel, arrayData, length, getter, &Parcel::writeBool);
+    return WriteArray<bool>(parcel, arrayData, length, getter);
 }
 
 binder_status_t AParcel_writeCharArray(AParcel* parcel, const char16_t* arrayData, int32_t length) {
@@ -634,7 +702,7 @@ binder_status_t AParcel_readDoubleArray(const AParcel* parcel, void* arrayData,
 binder_status_t AParcel_readBoolArray(const AParcel* parcel, void* arrayData,
                                       AParcel_boolArrayAllocator allocator,
                                       AParcel_boolArraySetter setter) {
-    return ReadArray<bool>(parcel, arrayData, allocator, setter, &Parcel::readBool);
+    return ReadArray<bool>(parcel, arrayData, allocator, setter);
 }
 
 binder_status_t AParcel_readCharArray(const AParcel* parcel, void* arrayData,
@@ -666,7 +734,7 @@ binder_status_t AParcel_appendFrom(const AParcel* from, AParcel* to, int32_t sta
 }
 
 AParcel* AParcel_create() {
-    return new AParcel(nullptr);
+    return AParcel::create(nullptr);
 }
 
 // @END
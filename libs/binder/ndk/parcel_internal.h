@@ -20,6 +20,8 @@
 
 #include <sys/cdefs.h>
 
+#include <optional>
+
 #include <binder/Parcel.h>
 #include "ibinder_internal.h"
 
@@ -27,7 +29,10 @@ struct AParcel {
     const ::android::Parcel* get() const { return mParcel; }
     ::android::Parcel* get() { return mParcel; }
 
-    explicit AParcel(AIBinder* binder) : AParcel(binder, new ::android::Parcel, true /*owns*/) {}
+    // The owned Parcel is kept inline, so that an AParcel is a single allocation.
+    explicit AParcel(AIBinder* binder) : mBinder(binder), mOwnedParcel(std::in_place) {
+        mParcel = &*mOwnedParcel;
+    }
     AParcel(AIBinder* binder, ::android::Parcel* parcel, bool owns)
         : mBinder(binder), mParcel(parcel), mOwns(owns) {}
 
@@ -37,6 +42,15 @@ struct AParcel {
         }
     }
 
+    AParcel(const AParcel&) = delete;
+    AParcel& operator=(const AParcel&) = delete;
+
+    // Creates an AParcel owning its Parcel (like new AParcel(binder)), reusing the memory of
+    // the AParcels recently destroyed on this thread, so that the parcels of a transaction
+    // don't hit the heap. Must be released with destroy (or AParcel_delete).
+    static AParcel* create(AIBinder* binder);
+    static void destroy(AParcel* parcel);
+
     static const AParcel readOnly(AIBinder* binder, const ::android::Parcel* parcel) {
         return AParcel(binder, const_cast<::android::Parcel*>(parcel), false);
     }
@@ -49,5 +63,8 @@ struct AParcel {
     const AIBinder* mBinder;
 
     ::android::Parcel* mParcel;
-    bool mOwns;
+    // when the Parcel isn't owned through mOwnedParcel, whether it needs to be deleted
+    bool mOwns = false;
+
+    std::optional<::android::Parcel> mOwnedParcel;
 };
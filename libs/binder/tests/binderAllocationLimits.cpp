@@ -172,7 +172,30 @@ TEST(BinderAllocation, SmallTransaction) {
     });
     manager->checkService(empty_descriptor);
 
-    EXPECT_EQ(mallocs, 1);
+    // may be zero if an earlier transaction on this thread left a buffer to reuse
+    EXPECT_LE(mallocs, 1);
+}
+
+TEST(BinderAllocation, SmallTransactionReusesBuffer) {
+    String16 empty_descriptor = String16("");
+    sp<IServiceManager> manager = defaultServiceManager();
+    manager->checkService(empty_descriptor); // leaves a buffer for this thread
+
+    const auto m = ScopeDisallowMalloc();
+    manager->checkService(empty_descriptor);
+}
+
+TEST(BinderAllocation, SmallParcelReusesBuffers) {
+    const auto write = [] {
+        Parcel p;
+        p.writeInt32(42);
+        p.writeFileDescriptor(0 /*stdin*/, false /*takeOwnership*/);
+        imaginary_use = p.data();
+    };
+    write(); // first data and objects buffers come from the heap
+
+    const auto m = ScopeDisallowMalloc();
+    for (size_t i = 0; i < 10; i++) write();
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A single benchmark suite for binder calls, so that changes to binder are measured against the
+// same baseline. The calls go to a service in a forked process over kernel binder, and to a
+// service in this process over RPC on a unix domain socket, for what RPC supports.
+//
+// Besides the time per call, each benchmark reports the p50/p99/p99.9 latencies of its calls,
+// and the single-threaded ones the C++ allocations per call, counting both ends for RPC. All of
+// them are counters, which are machine-readable with --benchmark_format=json.
+
+#include <android-base/logging.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/IPCThreadState.h>
+#include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
+#include <binder/ProcessState.h>
+#include <binder/RpcServer.h>
+#include <binder/RpcSession.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using android::BBinder;
+using android::defaultServiceManager;
+using android::IBinder;
+using android::IPCThreadState;
+using android::OK;
+using android::Parcel;
+using android::ProcessState;
+using android::RpcServer;
+using android::RpcSession;
+using android::sp;
+using android::status_t;
+using android::String16;
+using android::base::unique_fd;
+
+static std::atomic<uint64_t> gAllocations = 0;
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size)) return p;
+    abort();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static constexpr size_t kMaxThreads = 8;
+
+enum BenchmarkCode : uint32_t {
+    // Returns the payload it is sent.
+    ECHO = IBinder::FIRST_CALL_TRANSACTION,
+    // Returns the file descriptor it is sent.
+    ECHO_FD,
+    // Makes an ECHO call to the binder it is sent, then returns.
+    CALL_BACK,
+};
+
+class BenchmarkService : public BBinder {
+    status_t onTransact(uint32_t code, const Parcel& data, Parcel* reply,
+                        uint32_t flags) override {
+        const bool oneway = flags & IBinder::FLAG_ONEWAY;
+        switch (code) {
+            case ECHO: {
+                const int32_t size = data.readInt32();
+                const void* payload = data.readInplace(size);
+                if (payload == nullptr) return android::BAD_VALUE;
+                if (oneway) return OK;
+                reply->writeInt32(size);
+                return reply->write(payload, size);
+            }
+            case ECHO_FD:
+                return reply->writeFileDescriptor(data.readFileDescriptor());
+            case CALL_BACK: {
+                const sp<IBinder> callback = data.readStrongBinder();
+                if (callback == nullptr) return android::BAD_VALUE;
+                Parcel callbackData, callbackReply;
+                callbackData.markForBinder(callback);
+                callbackData.writeInt32(0);
+                return callback->transact(ECHO, callbackData, &callbackReply);
+            }
+            default:
+                return BBinder::onTransact(code, data, reply, flags);
+        }
+    }
+};
+
+static sp<IBinder> gKernelService;
+static sp<IBinder> gRpcService;
+static sp<RpcSession> gRpcSession = RpcSession::make();
+
+// Times each call, then reports the latency percentiles and, if countAllocations, the
+// allocations per call. Only single-threaded benchmarks count allocations, since the counter is
+// shared by all the threads of the process.
+template <typename F>
+static void measureCalls(benchmark::State& state, bool countAllocations, F&& call) {
+    std::vector<uint64_t> latencies;
+    latencies.reserve(1 << 16);
+    const uint64_t allocationsBefore = gAllocations.load();
+
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        call();
+        const auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                                    .count());
+    }
+
+    const uint64_t allocations = gAllocations.load() - allocationsBefore;
+    if (latencies.empty()) return;
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double fraction) {
+        const size_t index = std::min(latencies.size() - 1,
+                                      static_cast<size_t>(fraction * latencies.size()));
+        return static_cast<double>(latencies[index]);
+    };
+    using benchmark::Counter;
+    state.counters["p50_ns"] = Counter(percentile(0.5), Counter::kAvgThreads);
+    state.counters["p99_ns"] = Counter(percentile(0.99), Counter::kAvgThreads);
+    state.counters["p99.9_ns"] = Counter(percentile(0.999), Counter::kAvgThreads);
+    if (countAllocations) {
+        state.counters["allocs_per_call"] =
+                static_cast<double>(allocations) / static_cast<double>(latencies.size());
+    }
+}
+
+static void echoCall(const sp<IBinder>& binder, const std::vector<uint8_t>& payload,
+                     uint32_t flags) {
+    Parcel data, reply;
+    data.markForBinder(binder);
+    data.writeInt32(static_cast<int32_t>(payload.size()));
+    data.write(payload.data(), payload.size());
+    CHECK_EQ(OK, binder->transact(ECHO, data, &reply, flags));
+}
+
+static void syncCall(benchmark::State& state, const sp<IBinder>& binder) {
+    const std::vector<uint8_t> payload(state.range(0), 'a');
+    measureCalls(state, true /* countAllocations */, [&] { echoCall(binder, payload, 0); });
+    state.SetBytesProcessed(state.iterations() * payload.size() * 2);
+}
+void BM_syncCallKernel(benchmark::State& state) {
+    syncCall(state, gKernelService);
+}
+void BM_syncCallRpc(benchmark::State& state) {
+    syncCall(state, gRpcService);
+}
+// RpcState caps transactions to around 100KB, so stay below that.
+BENCHMARK(BM_syncCallKernel)->RangeMultiplier(4)->Range(64, 16 * 1024);
+BENCHMARK(BM_syncCallRpc)->RangeMultiplier(4)->Range(64, 16 * 1024);
+
+static void onewayCall(benchmark::State& state, const sp<IBinder>& binder) {
+    const std::vector<uint8_t> payload(state.range(0), 'a');
+    measureCalls(state, true /* countAllocations */,
+                 [&] { echoCall(binder, payload, IBinder::FLAG_ONEWAY); });
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+void BM_onewayCallKernel(benchmark::State& state) {
+    onewayCall(state, gKernelService);
+}
+void BM_onewayCallRpc(benchmark::State& state) {
+    onewayCall(state, gRpcService);
+}
+// Small enough that the service keeps up with the calls, which would otherwise run out of the
+// buffer space for oneway transactions.
+BENCHMARK(BM_onewayCallKernel)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK(BM_onewayCallRpc)->RangeMultiplier(4)->Range(64, 1024);
+
+// RPC binder can't pass file descriptors.
+void BM_fdCallKernel(benchmark::State& state) {
+    unique_fd fd(open("/dev/null", O_RDONLY | O_CLOEXEC));
+    CHECK(fd.ok());
+    measureCalls(state, true /* countAllocations */, [&] {
+        Parcel data, reply;
+        data.writeFileDescriptor(fd.get());
+        CHECK_EQ(OK, gKernelService->transact(ECHO_FD, data, &reply));
+        CHECK_GE(reply.readFileDescriptor(), 0);
+    });
+}
+BENCHMARK(BM_fdCallKernel);
+
+// The service calls back into this process before it returns. RPC sessions set up as clients
+// don't serve calls from the server.
+void BM_nestedCallKernel(benchmark::State& state) {
+    const sp<IBinder> callback = sp<BenchmarkService>::make();
+    measureCalls(state, true /* countAllocations */, [&] {
+        Parcel data, reply;
+        data.writeStrongBinder(callback);
+        CHECK_EQ(OK, gKernelService->transact(CALL_BACK, data, &reply));
+    });
+}
+BENCHMARK(BM_nestedCallKernel);
+
+// Calls from several threads of this process at once, to as many service threads.
+static void contendedCall(benchmark::State& state, const sp<IBinder>& binder) {
+    const std::vector<uint8_t> payload(64, 'a');
+    measureCalls(state, false /* countAllocations */, [&] { echoCall(binder, payload, 0); });
+}
+void BM_contendedCallKernel(benchmark::State& state) {
+    contendedCall(state, gKernelService);
+}
+void BM_contendedCallRpc(benchmark::State& state) {
+    contendedCall(state, gRpcService);
+}
+BENCHMARK(BM_contendedCallKernel)->ThreadRange(2, kMaxThreads)->UseRealTime();
+BENCHMARK(BM_contendedCallRpc)->ThreadRange(2, kMaxThreads)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // The service for kernel binder is forked before this process uses binder.
+    const String16 serviceName(("binderBenchmark-" + std::to_string(getpid())).c_str());
+    const pid_t servicePid = fork();
+    CHECK_GE(servicePid, 0);
+    if (servicePid == 0) {
+        CHECK_EQ(OK, defaultServiceManager()->addService(serviceName,
+                                                         sp<BenchmarkService>::make()));
+        ProcessState::self()->setThreadPoolMaxThreadCount(kMaxThreads);
+        ProcessState::self()->startThreadPool();
+        IPCThreadState::self()->joinThreadPool();
+        return 0;
+    }
+
+    // For the calls back from the service.
+    ProcessState::self()->startThreadPool();
+    gKernelService = defaultServiceManager()->waitForService(serviceName);
+    CHECK(gKernelService != nullptr);
+
+    std::string addr = std::string(getenv("TMPDIR") ?: "/tmp") + "/binderBenchmark";
+    (void)unlink(addr.c_str());
+
+    std::thread([addr]() {
+        sp<RpcServer> server = RpcServer::make();
+        server->setRootObject(sp<BenchmarkService>::make());
+        server->setMaxThreads(kMaxThreads);
+        server->iUnderstandThisCodeIsExperimentalAndIWillNotUseItInProduction();
+        CHECK(server->setupUnixDomainServer(addr.c_str()));
+        server->join();
+    }).detach();
+
+    for (size_t tries = 0; tries < 5; tries++) {
+        usleep(10000);
+        if (gRpcSession->setupUnixDomainClient(addr.c_str())) goto success;
+    }
+    LOG(FATAL) << "Could not connect.";
+success:
+    gRpcService = gRpcSession->getRootObject();
+    CHECK(gRpcService != nullptr);
+
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    kill(servicePid, SIGKILL);
+    waitpid(servicePid, nullptr, 0);
+    return 0;
+}
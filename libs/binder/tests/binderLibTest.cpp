@@ -603,6 +603,30 @@ TEST_F(BinderLibTest, CallBack)
     EXPECT_THAT(callBack->getResult(), StatusEq(NO_ERROR));
 }
 
+TEST_F(BinderLibTest, AdaptiveThreadPool)
+{
+    sp<ProcessState> proc = ProcessState::self();
+    // the hard limit can't be below the setThreadPoolMaxThreadCount one
+    EXPECT_THAT(proc->setThreadPoolAdaptivePolicy(1, 10, 100), StatusEq(BAD_VALUE));
+    EXPECT_THAT(proc->setThreadPoolAdaptivePolicy(64, 0, 100), StatusEq(BAD_VALUE));
+    EXPECT_THAT(proc->setThreadPoolAdaptivePolicy(64, 10, 0), StatusEq(BAD_VALUE));
+    ASSERT_THAT(proc->setThreadPoolAdaptivePolicy(64, 10, 100), StatusEq(NO_ERROR));
+
+    for (int i = 0; i < 2; i++) {
+        Parcel data, reply;
+        sp<BinderLibTestCallBack> callBack = new BinderLibTestCallBack();
+        data.writeStrongBinder(callBack);
+        EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_CALL_BACK, data, &reply, TF_ONE_WAY),
+                    StatusEq(NO_ERROR));
+        EXPECT_THAT(callBack->waitEvent(5), StatusEq(NO_ERROR));
+        EXPECT_THAT(callBack->getResult(), StatusEq(NO_ERROR));
+        // long enough for idle pooled threads to exit before the next call
+        usleep(300 * 1000);
+    }
+
+    EXPECT_THAT(proc->setThreadPoolAdaptivePolicy(0, 0, 0), StatusEq(NO_ERROR));
+}
+
 TEST_F(BinderLibTest, AddServer)
 {
     sp<IBinder> server = addServer();
@@ -1134,6 +1158,56 @@ TEST_F(BinderLibTest, GotSid) {
     EXPECT_THAT(server->transact(BINDER_LIB_TEST_CAN_GET_SID, data, nullptr), StatusEq(OK));
 }
 
+TEST_F(BinderLibTest, ServiceCacheDropsReregisteredService) {
+    sp<IServiceManager> sm = defaultServiceManager();
+    String16 name = binderLibTestServiceName + String16(".cached");
+    sp<IBinder> first = sp<BBinder>::make();
+    sp<IBinder> second = sp<BBinder>::make();
+
+    setServiceCacheEnabled(true);
+    ASSERT_THAT(sm->addService(name, first), StatusEq(OK));
+    EXPECT_EQ(first, sm->checkService(name));
+    EXPECT_EQ(first, sm->checkService(name));
+
+    ASSERT_THAT(sm->addService(name, second), StatusEq(OK));
+    // the registration callback is oneway
+    sp<IBinder> found;
+    for (int i = 0; i < 50 && (found = sm->checkService(name)) != second; i++) {
+        usleep(100 * 1000);
+    }
+    EXPECT_EQ(second, found);
+    setServiceCacheEnabled(false);
+}
+
+TEST_F(BinderLibTest, ServiceCacheDropsDeadService) {
+    sp<IServiceManager> sm = defaultServiceManager();
+    String16 name = binderLibTestServiceName + String16(".cachedDead");
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+    sp<TestDeathRecipient> testDeathRecipient = sp<TestDeathRecipient>::make();
+    EXPECT_THAT(server->linkToDeath(testDeathRecipient), StatusEq(NO_ERROR));
+
+    setServiceCacheEnabled(true);
+    ASSERT_THAT(sm->addService(name, server), StatusEq(OK));
+    EXPECT_EQ(server, sm->checkService(name));
+
+    {
+        Parcel data, reply;
+        EXPECT_THAT(server->transact(BINDER_LIB_TEST_EXIT_TRANSACTION, data, &reply, TF_ONE_WAY),
+                    StatusEq(OK));
+    }
+    IPCThreadState::self()->flushCommands();
+    EXPECT_THAT(testDeathRecipient->waitEvent(5), StatusEq(NO_ERROR));
+
+    // servicemanager forgets about it too, though maybe not as quickly
+    sp<IBinder> found;
+    for (int i = 0; i < 50 && (found = sm->checkService(name)) != nullptr; i++) {
+        usleep(100 * 1000);
+    }
+    EXPECT_TRUE(found == nullptr);
+    setServiceCacheEnabled(false);
+}
+
 class BinderLibTestService : public BBinder
 {
     public:
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <android/binder_ibinder.h>
+#include <android/binder_parcel.h>
+#include <binder/Binder.h>
 #include <binder/Parcel.h>
 #include <benchmark/benchmark.h>
 
@@ -169,4 +172,151 @@ BENCHMARK(BM_CharVector)->Apply(VectorArgs);
 BENCHMARK(BM_Int32Vector)->Apply(VectorArgs);
 BENCHMARK(BM_Int64Vector)->Apply(VectorArgs);
 
+/*
+  NDK arrays which are not packed (each element is sent as an int32_t). These
+  reserve space for the whole array once, like the C++ vector methods above,
+  instead of growing the Parcel for every element.
+*/
+static void BM_NdkCharArray(benchmark::State& state) {
+    const size_t elements = state.range(0);
+
+    std::vector<char16_t> v1(elements);
+    std::vector<char16_t> v2(elements);
+    AParcel* p = AParcel_create();
+    while (state.KeepRunning()) {
+        AParcel_setDataPosition(p, 0);
+        AParcel_writeCharArray(p, v1.data(), v1.size());
+
+        AParcel_setDataPosition(p, 0);
+        AParcel_readCharArray(p, &v2, [](void* vector, int32_t length, char16_t** outBuffer) {
+            auto v = static_cast<std::vector<char16_t>*>(vector);
+            v->resize(length);
+            *outBuffer = v->data();
+            return true;
+        });
+
+        benchmark::DoNotOptimize(v2[0]);
+        benchmark::ClobberMemory();
+    }
+    AParcel_delete(p);
+    state.SetComplexityN(elements);
+}
+
+static void BM_NdkBoolArray(benchmark::State& state) {
+    const size_t elements = state.range(0);
+
+    std::vector<bool> v1(elements);
+    std::vector<bool> v2(elements);
+    AParcel* p = AParcel_create();
+    while (state.KeepRunning()) {
+        AParcel_setDataPosition(p, 0);
+        AParcel_writeBoolArray(p, &v1, v1.size(), [](const void* vector, size_t index) {
+            return static_cast<bool>((*static_cast<const std::vector<bool>*>(vector))[index]);
+        });
+
+        AParcel_setDataPosition(p, 0);
+        AParcel_readBoolArray(
+                p, &v2,
+                [](void* vector, int32_t length) {
+                    static_cast<std::vector<bool>*>(vector)->resize(length);
+                    return true;
+                },
+                [](void* vector, size_t index, bool value) {
+                    (*static_cast<std::vector<bool>*>(vector))[index] = value;
+                });
+
+        benchmark::DoNotOptimize(v2[0]);
+        benchmark::ClobberMemory();
+    }
+    AParcel_delete(p);
+    state.SetComplexityN(elements);
+}
+
+BENCHMARK(BM_NdkCharArray)->Apply(VectorArgs);
+BENCHMARK(BM_NdkBoolArray)->Apply(VectorArgs);
+
+/*
+  A new Parcel for each small write, like most transactions. Up to 128 bytes
+  of data (and a few objects), the buffers for a Parcel are reused from ones
+  freed earlier on the same thread, rather than allocated each time.
+*/
+static void BM_SmallParcel(benchmark::State& state) {
+    const size_t ints = state.range(0);
+
+    while (state.KeepRunning()) {
+        android::Parcel p;
+        for (size_t i = 0; i < ints; i++) {
+            p.writeInt32(i);
+        }
+        benchmark::DoNotOptimize(p.data());
+    }
+}
+
+BENCHMARK(BM_SmallParcel)->Arg(1)->Arg(8)->Arg(32)->Arg(64);
+
+/*
+  A transaction to a local binder through the NDK, against the same through
+  libbinder, to measure what the NDK adds to each call. The AParcels for the
+  data and the reply are reused from ones destroyed earlier on the same
+  thread, rather than allocated for each transaction.
+*/
+static constexpr char kTransactionDescriptor[] = "binderParcelBenchmark";
+static constexpr uint32_t kTransactionCode = android::IBinder::FIRST_CALL_TRANSACTION;
+
+static void BM_NdkTransaction(benchmark::State& state) {
+    AIBinder_Class* clazz = AIBinder_Class_define(
+            kTransactionDescriptor, [](void* args) { return args; }, [](void*) {},
+            [](AIBinder*, transaction_code_t, const AParcel* in, AParcel* out) {
+                int32_t value;
+                binder_status_t status = AParcel_readInt32(in, &value);
+                if (status != STATUS_OK) return status;
+                return AParcel_writeInt32(out, value);
+            });
+    AIBinder* binder = AIBinder_new(clazz, nullptr);
+
+    while (state.KeepRunning()) {
+        AParcel* in = nullptr;
+        AParcel* out = nullptr;
+        AIBinder_prepareTransaction(binder, &in);
+        AParcel_writeInt32(in, 42);
+        AIBinder_transact(binder, kTransactionCode, &in, &out, 0 /*flags*/);
+
+        int32_t value = 0;
+        AParcel_readInt32(out, &value);
+        AParcel_delete(out);
+        benchmark::DoNotOptimize(value);
+    }
+    AIBinder_decStrong(binder);
+}
+
+class EchoBinder : public android::BBinder {
+    android::status_t onTransact(uint32_t code, const android::Parcel& data,
+                                 android::Parcel* reply, uint32_t flags) override {
+        if (code != kTransactionCode) return BBinder::onTransact(code, data, reply, flags);
+        if (!data.enforceInterface(android::String16(kTransactionDescriptor))) {
+            return android::BAD_TYPE;
+        }
+        return reply->writeInt32(data.readInt32());
+    }
+};
+
+static void BM_CppTransaction(benchmark::State& state) {
+    android::sp<android::IBinder> binder = android::sp<EchoBinder>::make();
+    const android::String16 descriptor(kTransactionDescriptor);
+
+    while (state.KeepRunning()) {
+        android::Parcel data;
+        android::Parcel reply;
+        data.markForBinder(binder);
+        data.writeInterfaceToken(descriptor);
+        data.writeInt32(42);
+        binder->transact(kTransactionCode, data, &reply);
+
+        benchmark::DoNotOptimize(reply.readInt32());
+    }
+}
+
+BENCHMARK(BM_NdkTransaction);
+BENCHMARK(BM_CppTransaction);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "../ParcelValTypes.h"
+
+using android::OK;
+using android::Parcel;
+using android::String16;
+using android::os::PersistableBundle;
+
+namespace {
+
+// Keep in sync with BUNDLE_MAGIC_NATIVE in PersistableBundle.cpp.
+constexpr int32_t kBundleMagicNative = 0x4C444E44;
+
+PersistableBundle makeBundle() {
+    PersistableBundle nested;
+    nested.putInt(String16("nested-int"), 7);
+    nested.putString(String16("nested-string"), String16("inner"));
+
+    PersistableBundle bundle;
+    bundle.putBoolean(String16("bool"), true);
+    bundle.putInt(String16("int"), 42);
+    bundle.putLong(String16("long"), 1ll << 40);
+    bundle.putDouble(String16("double"), 2.5);
+    bundle.putString(String16("string"), String16("value"));
+    bundle.putBooleanVector(String16("bool-vector"), {true, false, true});
+    bundle.putIntVector(String16("int-vector"), {1, 2, 3});
+    bundle.putLongVector(String16("long-vector"), {4, 5});
+    bundle.putDoubleVector(String16("double-vector"), {0.5, 1.5});
+    bundle.putStringVector(String16("string-vector"), {String16("a"), String16("b")});
+    bundle.putPersistableBundle(String16("bundle"), nested);
+    return bundle;
+}
+
+PersistableBundle writeAndRead(const PersistableBundle& in, Parcel* parcel) {
+    EXPECT_EQ(OK, in.writeToParcel(parcel));
+    parcel->setDataPosition(0);
+    PersistableBundle out;
+    EXPECT_EQ(OK, out.readFromParcel(parcel));
+    EXPECT_EQ(parcel->dataSize(), parcel->dataPosition());
+    return out;
+}
+
+} // namespace
+
+TEST(PersistableBundle, ReadThenGet) {
+    Parcel parcel;
+    PersistableBundle bundle = writeAndRead(makeBundle(), &parcel);
+
+    EXPECT_EQ(11u, bundle.size());
+    bool boolValue = false;
+    EXPECT_TRUE(bundle.getBoolean(String16("bool"), &boolValue));
+    EXPECT_TRUE(boolValue);
+    int32_t intValue = 0;
+    EXPECT_TRUE(bundle.getInt(String16("int"), &intValue));
+    EXPECT_EQ(42, intValue);
+    int64_t longValue = 0;
+    EXPECT_TRUE(bundle.getLong(String16("long"), &longValue));
+    EXPECT_EQ(1ll << 40, longValue);
+    double doubleValue = 0;
+    EXPECT_TRUE(bundle.getDouble(String16("double"), &doubleValue));
+    EXPECT_EQ(2.5, doubleValue);
+    String16 stringValue;
+    EXPECT_TRUE(bundle.getString(String16("string"), &stringValue));
+    EXPECT_EQ(String16("value"), stringValue);
+    std::vector<bool> boolVector;
+    EXPECT_TRUE(bundle.getBooleanVector(String16("bool-vector"), &boolVector));
+    EXPECT_EQ((std::vector<bool>{true, false, true}), boolVector);
+    std::vector<int32_t> intVector;
+    EXPECT_TRUE(bundle.getIntVector(String16("int-vector"), &intVector));
+    EXPECT_EQ((std::vector<int32_t>{1, 2, 3}), intVector);
+    std::vector<int64_t> longVector;
+    EXPECT_TRUE(bundle.getLongVector(String16("long-vector"), &longVector));
+    EXPECT_EQ((std::vector<int64_t>{4, 5}), longVector);
+    std::vector<double> doubleVector;
+    EXPECT_TRUE(bundle.getDoubleVector(String16("double-vector"), &doubleVector));
+    EXPECT_EQ((std::vector<double>{0.5, 1.5}), doubleVector);
+    std::vector<String16> stringVector;
+    EXPECT_TRUE(bundle.getStringVector(String16("string-vector"), &stringVector));
+    EXPECT_EQ((std::vector<String16>{String16("a"), String16("b")}), stringVector);
+
+    // A key is only found with the type it was put with.
+    EXPECT_FALSE(bundle.getLong(String16("int"), &longValue));
+    EXPECT_FALSE(bundle.getInt(String16("missing"), &intValue));
+    EXPECT_EQ(std::set<String16>{String16("int")}, bundle.getIntKeys());
+}
+
+TEST(PersistableBundle, ReadThenWriteKeepsBytes) {
+    Parcel parcel;
+    PersistableBundle bundle = writeAndRead(makeBundle(), &parcel);
+
+    Parcel rewritten;
+    EXPECT_EQ(OK, bundle.writeToParcel(&rewritten));
+    ASSERT_EQ(parcel.dataSize(), rewritten.dataSize());
+    EXPECT_EQ(0, memcmp(parcel.data(), rewritten.data(), parcel.dataSize()));
+}
+
+TEST(PersistableBundle, ReadNestedBundle) {
+    Parcel parcel;
+    PersistableBundle bundle = writeAndRead(makeBundle(), &parcel);
+
+    PersistableBundle nested;
+    EXPECT_TRUE(bundle.getPersistableBundle(String16("bundle"), &nested));
+    EXPECT_EQ(2u, nested.size());
+    int32_t intValue = 0;
+    EXPECT_TRUE(nested.getInt(String16("nested-int"), &intValue));
+    EXPECT_EQ(7, intValue);
+    String16 stringValue;
+    EXPECT_TRUE(nested.getString(String16("nested-string"), &stringValue));
+    EXPECT_EQ(String16("inner"), stringValue);
+}
+
+TEST(PersistableBundle, PutAfterRead) {
+    Parcel parcel;
+    PersistableBundle bundle = writeAndRead(makeBundle(), &parcel);
+    PersistableBundle copy(bundle);
+
+    bundle.putInt(String16("int"), 43);
+    bundle.putString(String16("new"), String16("added"));
+    EXPECT_EQ(1u, bundle.erase(String16("bool")));
+
+    EXPECT_EQ(11u, bundle.size());
+    int32_t intValue = 0;
+    EXPECT_TRUE(bundle.getInt(String16("int"), &intValue));
+    EXPECT_EQ(43, intValue);
+    String16 stringValue;
+    EXPECT_TRUE(bundle.getString(String16("new"), &stringValue));
+    EXPECT_EQ(String16("added"), stringValue);
+    bool boolValue = false;
+    EXPECT_FALSE(bundle.getBoolean(String16("bool"), &boolValue));
+    double doubleValue = 0;
+    EXPECT_TRUE(bundle.getDouble(String16("double"), &doubleValue));
+    EXPECT_EQ(2.5, doubleValue);
+
+    // The copy made before the changes still reads the original bytes.
+    EXPECT_TRUE(copy.getInt(String16("int"), &intValue));
+    EXPECT_EQ(42, intValue);
+    EXPECT_TRUE(copy.getBoolean(String16("bool"), &boolValue));
+
+    Parcel changed;
+    PersistableBundle reread = writeAndRead(bundle, &changed);
+    EXPECT_EQ(bundle, reread);
+}
+
+TEST(PersistableBundle, LazyEqualsEager) {
+    PersistableBundle eager = makeBundle();
+    Parcel parcel;
+    PersistableBundle lazy = writeAndRead(eager, &parcel);
+
+    EXPECT_EQ(eager, lazy);
+    EXPECT_EQ(lazy, eager);
+    EXPECT_EQ(eager.getBooleanKeys(), lazy.getBooleanKeys());
+    EXPECT_EQ(eager.getStringVectorKeys(), lazy.getStringVectorKeys());
+    EXPECT_EQ(eager.getPersistableBundleKeys(), lazy.getPersistableBundleKeys());
+
+    PersistableBundle changed = makeBundle();
+    changed.putInt(String16("int"), 43);
+    EXPECT_NE(changed, lazy);
+}
+
+TEST(PersistableBundle, DuplicateKeyKeepsLastValue) {
+    Parcel parcel;
+    size_t lengthPos = parcel.dataPosition();
+    parcel.writeInt32(0);
+    parcel.writeInt32(kBundleMagicNative);
+    size_t startPos = parcel.dataPosition();
+    parcel.writeInt32(3);
+    parcel.writeString16(String16("key"));
+    parcel.writeInt32(android::binder::VAL_INTEGER);
+    parcel.writeInt32(1);
+    parcel.writeString16(String16("key"));
+    parcel.writeInt32(android::binder::VAL_INTEGER);
+    parcel.writeInt32(2);
+    parcel.writeString16(String16("key"));
+    parcel.writeInt32(android::binder::VAL_STRING);
+    parcel.writeString16(String16("text"));
+    size_t endPos = parcel.dataPosition();
+    parcel.setDataPosition(lengthPos);
+    parcel.writeInt32(static_cast<int32_t>(endPos - startPos));
+    parcel.setDataPosition(0);
+
+    PersistableBundle lazy;
+    ASSERT_EQ(OK, lazy.readFromParcel(&parcel));
+    EXPECT_EQ(2u, lazy.size());
+    int32_t intValue = 0;
+    EXPECT_TRUE(lazy.getInt(String16("key"), &intValue));
+    EXPECT_EQ(2, intValue);
+    String16 stringValue;
+    EXPECT_TRUE(lazy.getString(String16("key"), &stringValue));
+    EXPECT_EQ(String16("text"), stringValue);
+
+    // Reading all the values out keeps the same ones.
+    PersistableBundle materialized(lazy);
+    EXPECT_EQ(0u, materialized.erase(String16("missing")));
+    EXPECT_EQ(2u, materialized.size());
+    EXPECT_TRUE(materialized.getInt(String16("key"), &intValue));
+    EXPECT_EQ(2, intValue);
+    EXPECT_EQ(lazy, materialized);
+}
@@ -47,6 +47,7 @@ class MyBinderRpcBenchmark : public BnBinderRpcBenchmark {
 };
 
 static sp<RpcSession> gSession = RpcSession::make();
+static sp<RpcSession> gSharedMemorySession = RpcSession::make();
 
 void BM_getRootObject(benchmark::State& state) {
     while (state.KeepRunning()) {
@@ -55,15 +56,22 @@ void BM_getRootObject(benchmark::State& state) {
 }
 BENCHMARK(BM_getRootObject);
 
-void BM_pingTransaction(benchmark::State& state) {
-    sp<IBinder> binder = gSession->getRootObject();
+static void pingTransaction(benchmark::State& state, const sp<RpcSession>& session) {
+    sp<IBinder> binder = session->getRootObject();
     CHECK(binder != nullptr);
 
     while (state.KeepRunning()) {
         CHECK_EQ(OK, binder->pingBinder());
     }
 }
+void BM_pingTransaction(benchmark::State& state) {
+    pingTransaction(state, gSession);
+}
 BENCHMARK(BM_pingTransaction);
+void BM_pingTransactionSharedMemory(benchmark::State& state) {
+    pingTransaction(state, gSharedMemorySession);
+}
+BENCHMARK(BM_pingTransactionSharedMemory);
 
 void BM_repeatString(benchmark::State& state) {
     sp<IBinder> binder = gSession->getRootObject();
@@ -94,6 +102,33 @@ void BM_repeatString(benchmark::State& state) {
 }
 BENCHMARK(BM_repeatString);
 
+// Measures how the cost of sending a transaction scales with the size of the
+// Parcel payload, e.g. for the scatter/gather send path in RpcState.
+static void repeatStringSize(benchmark::State& state, const sp<RpcSession>& session) {
+    sp<IBinder> binder = session->getRootObject();
+    CHECK(binder != nullptr);
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+
+    std::string str = std::string(state.range(0), 'a');
+
+    while (state.KeepRunning()) {
+        std::string out;
+        Status ret = iface->repeatString(str, &out);
+        CHECK(ret.isOk()) << ret;
+    }
+    state.SetBytesProcessed(state.iterations() * str.size() * 2);
+}
+void BM_repeatStringSize(benchmark::State& state) {
+    repeatStringSize(state, gSession);
+}
+void BM_repeatStringSizeSharedMemory(benchmark::State& state) {
+    repeatStringSize(state, gSharedMemorySession);
+}
+// RpcState caps transactions to around 100KB, so stay below that.
+BENCHMARK(BM_repeatStringSize)->RangeMultiplier(4)->Range(64, 16 * 1024);
+BENCHMARK(BM_repeatStringSizeSharedMemory)->RangeMultiplier(4)->Range(64, 16 * 1024);
+
 void BM_repeatBinder(benchmark::State& state) {
     sp<IBinder> binder = gSession->getRootObject();
     CHECK(binder != nullptr);
@@ -132,6 +167,7 @@ int main(int argc, char** argv) {
     }
     LOG(FATAL) << "Could not connect.";
 success:
+    CHECK(gSharedMemorySession->setupSharedMemoryClient(addr.c_str()));
 
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
@@ -303,6 +303,7 @@ enum class SocketType {
     UNIX,
     VSOCK,
     INET,
+    SHARED_MEMORY,
 };
 static inline std::string PrintSocketType(const testing::TestParamInfo<SocketType>& info) {
     switch (info.param) {
@@ -312,6 +313,8 @@ static inline std::string PrintSocketType(const testing::TestParamInfo<SocketTyp
             return "vm_socket";
         case SocketType::INET:
             return "inet_socket";
+        case SocketType::SHARED_MEMORY:
+            return "shared_memory";
         default:
             LOG_ALWAYS_FATAL("Unknown socket type");
             return "";
@@ -323,7 +326,8 @@ public:
     // threads.
     ProcessSession createRpcTestSocketServerProcess(
             size_t numThreads, size_t numSessions,
-            const std::function<void(const sp<RpcServer>&)>& configure) {
+            const std::function<void(const sp<RpcServer>&)>& configure,
+            const std::function<void(const sp<RpcSession>&)>& configureSession = nullptr) {
         CHECK_GE(numSessions, 1) << "Must have at least one session to a server";
 
         SocketType socketType = GetParam();
@@ -344,6 +348,7 @@ public:
 
                     switch (socketType) {
                         case SocketType::UNIX:
+                        case SocketType::SHARED_MEMORY:
                             CHECK(server->setupUnixDomainServer(addr.c_str())) << addr;
                             break;
                         case SocketType::VSOCK:
@@ -375,6 +380,7 @@ public:
 
         for (size_t i = 0; i < numSessions; i++) {
             sp<RpcSession> session = RpcSession::make();
+            if (configureSession) configureSession(session);
             switch (socketType) {
                 case SocketType::UNIX:
                     if (session->setupUnixDomainClient(addr.c_str())) goto success;
@@ -385,6 +391,9 @@ public:
                 case SocketType::INET:
                     if (session->setupInetClient("127.0.0.1", outPort)) goto success;
                     break;
+                case SocketType::SHARED_MEMORY:
+                    if (session->setupSharedMemoryClient(addr.c_str())) goto success;
+                    break;
                 default:
                     LOG_ALWAYS_FATAL("Unknown socket type");
             }
@@ -395,16 +404,21 @@ public:
         return ret;
     }
 
-    BinderRpcTestProcessSession createRpcTestSocketServerProcess(size_t numThreads,
-                                                                 size_t numSessions = 1) {
+    BinderRpcTestProcessSession createRpcTestSocketServerProcess(
+            size_t numThreads,
+            size_t numSessions = 1,
+            const std::function<void(const sp<RpcSession>&)>& configureSession = nullptr,
+            const std::function<void(const sp<RpcServer>&)>& configureServer = nullptr) {
         BinderRpcTestProcessSession ret{
-                .proc = createRpcTestSocketServerProcess(numThreads, numSessions,
-                                                         [&](const sp<RpcServer>& server) {
-                                                             sp<MyBinderRpcTest> service =
-                                                                     new MyBinderRpcTest;
-                                                             server->setRootObject(service);
-                                                             service->server = server;
-                                                         }),
+                .proc = createRpcTestSocketServerProcess(
+                        numThreads, numSessions,
+                        [&](const sp<RpcServer>& server) {
+                            sp<MyBinderRpcTest> service = new MyBinderRpcTest;
+                            server->setRootObject(service);
+                            service->server = server;
+                            if (configureServer) configureServer(server);
+                        },
+                        configureSession),
         };
 
         ret.rootBinder = ret.proc.sessions.at(0).root;
@@ -829,6 +843,56 @@ TEST_P(BinderRpc, OnewayStressTest) {
     for (auto& t : threads) t.join();
 }
 
+static void enableOnewayPipelining(const sp<RpcSession>& session) {
+    session->setOnewayPipeliningEnabled(true);
+}
+
+TEST_P(BinderRpc, OnewayPipeliningStressTest) {
+    constexpr size_t kNumClientThreads = 10;
+    constexpr size_t kNumServerThreads = 10;
+    constexpr size_t kNumCalls = 100;
+
+    auto proc = createRpcTestSocketServerProcess(kNumServerThreads, 1 /*sessions*/,
+                                                 enableOnewayPipelining);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kNumClientThreads; i++) {
+        threads.push_back(std::thread([&] {
+            for (size_t j = 0; j < kNumCalls; j++) {
+                EXPECT_OK(proc.rootIface->sendString("a"));
+            }
+
+            // check threads are not stuck
+            EXPECT_OK(proc.rootIface->sleepMs(250));
+        }));
+    }
+
+    for (auto& t : threads) t.join();
+}
+
+TEST_P(BinderRpc, OnewayPipeliningCallQueueing) {
+    constexpr size_t kNumSleeps = 10;
+    constexpr size_t kNumExtraServerThreads = 4;
+    constexpr size_t kSleepMs = 50;
+
+    auto proc = createRpcTestSocketServerProcess(1 + kNumExtraServerThreads, 1 /*sessions*/,
+                                                 enableOnewayPipelining);
+
+    EXPECT_OK(proc.rootIface->lock());
+
+    for (size_t i = 0; i < kNumSleeps; i++) {
+        // these should still be processed serially, in order
+        proc.rootIface->sleepMsAsync(kSleepMs);
+    }
+    EXPECT_OK(proc.rootIface->unlockInMsAsync(kSleepMs));
+
+    size_t epochMsBefore = epochMillis();
+    EXPECT_OK(proc.rootIface->lockUnlock());
+    size_t epochMsAfter = epochMillis();
+
+    EXPECT_GT(epochMsAfter, epochMsBefore + kSleepMs * kNumSleeps);
+}
+
 TEST_P(BinderRpc, OnewayCallDoesNotWait) {
     constexpr size_t kReallyLongTimeMs = 100;
     constexpr size_t kSleepMs = kReallyLongTimeMs * 5;
@@ -868,6 +932,55 @@ TEST_P(BinderRpc, OnewayCallQueueing) {
     EXPECT_GT(epochMsAfter, epochMsBefore + kSleepMs * kNumSleeps);
 }
 
+static void enableEventLoop(const sp<RpcServer>& server) {
+    server->setEventLoopEnabled(true);
+}
+
+TEST_P(BinderRpc, EventLoopNestedTransactions) {
+    auto proc = createRpcTestSocketServerProcess(1, 1 /*sessions*/, nullptr, enableEventLoop);
+
+    auto nastyNester = sp<MyBinderRpcTest>::make();
+    EXPECT_OK(proc.rootIface->nestMe(nastyNester, 10));
+
+    wp<IBinder> weak = nastyNester;
+    nastyNester = nullptr;
+    EXPECT_EQ(nullptr, weak.promote());
+}
+
+TEST_P(BinderRpc, EventLoopCallMeBack) {
+    auto proc = createRpcTestSocketServerProcess(1, 1 /*sessions*/, nullptr, enableEventLoop);
+
+    int32_t pingResult;
+    EXPECT_OK(proc.rootIface->pingMe(new MyBinderRpcSession("foo"), &pingResult));
+    EXPECT_EQ(OK, pingResult);
+
+    EXPECT_EQ(0, MyBinderRpcSession::gNum);
+}
+
+TEST_P(BinderRpc, EventLoopManySessionsStressTest) {
+    constexpr size_t kNumSessions = 10;
+    constexpr size_t kNumServerThreads = 4;
+    constexpr size_t kNumCalls = 100;
+
+    auto proc = createRpcTestSocketServerProcess(kNumServerThreads, kNumSessions, nullptr,
+                                                 enableEventLoop);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kNumSessions; i++) {
+        threads.push_back(std::thread([&, i] {
+            sp<IBinderRpcTest> iface =
+                    interface_cast<IBinderRpcTest>(proc.proc.sessions.at(i).root);
+            for (size_t j = 0; j < kNumCalls; j++) {
+                sp<IBinder> out;
+                EXPECT_OK(iface->repeatBinder(proc.proc.sessions.at(i).root, &out));
+                EXPECT_EQ(proc.proc.sessions.at(i).root, out);
+            }
+        }));
+    }
+
+    for (auto& t : threads) t.join();
+}
+
 TEST_P(BinderRpc, Die) {
     for (bool doDeathCleanup : {true, false}) {
         auto proc = createRpcTestSocketServerProcess(1);
@@ -939,6 +1052,7 @@ INSTANTIATE_TEST_CASE_P(PerSocket, BinderRpc,
                                 SocketType::VSOCK,
 #endif
                                 SocketType::INET,
+                                SocketType::SHARED_MEMORY,
                         }),
                         PrintSocketType);
 
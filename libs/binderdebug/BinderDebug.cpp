@@ -14,12 +14,15 @@
  * limitations under the License.
  */
 
-#include <android-base/parseint.h>
-#include <android-base/strings.h>
+#include <android-base/file.h>
 #include <binder/Binder.h>
+#include <ctype.h>
 #include <sys/types.h>
-#include <fstream>
-#include <regex>
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <set>
+#include <string_view>
 
 #include <binderdebug/BinderDebug.h>
 
@@ -38,81 +41,166 @@ static std::string contextToString(BinderDebugContext context) {
     }
 }
 
-static status_t scanBinderContext(pid_t pid, const std::string& contextName,
-                                  std::function<void(const std::string&)> eachLine) {
-    std::ifstream ifs("/dev/binderfs/binder_logs/proc/" + std::to_string(pid));
-    if (!ifs.is_open()) {
-        ifs.open("/d/binder/proc/" + std::to_string(pid));
-        if (!ifs.is_open()) {
-            return -errno;
-        }
+// The helpers below tokenize the lines in place, without allocating.
+static bool consumePrefix(std::string_view* s, std::string_view prefix) {
+    if (s->substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+    s->remove_prefix(prefix.size());
+    return true;
+}
+
+static std::string_view nextToken(std::string_view* s) {
+    size_t start = s->find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        *s = std::string_view();
+        return *s;
     }
-    static const std::regex kContextLine("^context (\\w+)$");
+    s->remove_prefix(start);
+    size_t end = std::min(s->find(' '), s->size());
+    std::string_view token = s->substr(0, end);
+    s->remove_prefix(end);
+    return token;
+}
 
+template <typename T>
+static bool parseNumber(std::string_view s, T* out, int base = 10) {
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), *out, base);
+    return ec == std::errc() && end == s.data() + s.size() && !s.empty();
+}
+
+// Reads the binder state at path, which holds the state of one or all processes, and calls
+// eachLine for each line that belongs to contextName along with the pid of its process. An empty
+// line is passed for each process first, so that processes without threads or nodes are seen.
+static status_t scanBinderContext(const std::string& path, const std::string& fallbackPath,
+                                  const std::string& contextName,
+                                  const std::function<void(pid_t, std::string_view)>& eachLine) {
+    std::string content;
+    if (!base::ReadFileToString(path, &content) &&
+        !base::ReadFileToString(fallbackPath, &content)) {
+        return -errno;
+    }
+
+    pid_t pid = -1;
     bool isDesiredContext = false;
-    std::string line;
-    std::smatch match;
-    while (getline(ifs, line)) {
-        if (std::regex_search(line, match, kContextLine)) {
-            isDesiredContext = match.str(1) == contextName;
+    std::string_view remaining(content);
+    while (!remaining.empty()) {
+        size_t end = std::min(remaining.find('\n'), remaining.size());
+        std::string_view line = remaining.substr(0, end);
+        remaining.remove_prefix(std::min(end + 1, remaining.size()));
+
+        if (consumePrefix(&line, "proc ")) {
+            if (!parseNumber(line, &pid)) pid = -1;
+            isDesiredContext = false;
+            continue;
+        }
+        if (consumePrefix(&line, "context ")) {
+            isDesiredContext = pid != -1 && line == contextName;
+            if (isDesiredContext) {
+                eachLine(pid, std::string_view());
+            }
             continue;
         }
         if (!isDesiredContext) {
             continue;
         }
-        eachLine(line);
+        eachLine(pid, line);
     }
     return OK;
 }
 
-status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
-    std::smatch match;
-    static const std::regex kReferencePrefix("^\\s*node \\d+:\\s+u([0-9a-f]+)\\s+c([0-9a-f]+)\\s+");
-    static const std::regex kThreadPrefix("^\\s*thread \\d+:\\s+l\\s+(\\d)(\\d)");
-    std::string contextStr = contextToString(context);
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (std::regex_search(line, match, kReferencePrefix)) {
-            const std::string& ptrString = "0x" + match.str(2); // use number after c
-            uint64_t ptr;
-            if (!::android::base::ParseUint(ptrString.c_str(), &ptr)) {
-                // Should not reach here, but just be tolerant.
-                return;
-            }
-            const std::string proc = " proc ";
-            auto pos = line.rfind(proc);
-            if (pos != std::string::npos) {
-                for (const std::string& pidStr : base::Split(line.substr(pos + proc.size()), " ")) {
-                    int32_t pid;
-                    if (!::android::base::ParseInt(pidStr, &pid)) {
-                        return;
-                    }
-                    pidInfo->refPids[ptr].push_back(pid);
-                }
-            }
-
+static void addBinderStateLine(std::string_view line, BinderPidInfo* pidInfo) {
+    std::string_view type = nextToken(&line);
+    if (type == "node") {
+        // node 5: u0000007b6d9e1234 c0000007b6d9e5678 pri 0:139 hs 1 hw 1 ... proc 456 789
+        nextToken(&line);
+        std::string_view ptrToken = nextToken(&line);
+        std::string_view cookieToken = nextToken(&line);
+        uint64_t ptr;
+        // use number after c
+        if (!consumePrefix(&ptrToken, "u") || !consumePrefix(&cookieToken, "c") ||
+            !parseNumber(cookieToken, &ptr, 16)) {
+            // Should not reach here, but just be tolerant.
             return;
         }
-        if (std::regex_search(line, match, kThreadPrefix)) {
-            // "1" is waiting in binder driver
-            // "2" is poll. It's impossible to tell if these are in use.
-            //     and HIDL default code doesn't use it.
-            bool isInUse = match.str(1) != "1";
-            // "0" is a thread that has called into binder
-            // "1" is looper thread
-            // "2" is main looper thread
-            bool isBinderThread = match.str(2) != "0";
-            if (!isBinderThread) {
+        const std::string_view proc = " proc ";
+        auto pos = line.rfind(proc);
+        if (pos == std::string_view::npos) {
+            return;
+        }
+        line.remove_prefix(pos + proc.size());
+        for (std::string_view pidToken = nextToken(&line); !pidToken.empty();
+             pidToken = nextToken(&line)) {
+            int32_t pid;
+            if (!parseNumber(pidToken, &pid)) {
                 return;
             }
-            if (isInUse) {
-                pidInfo->threadUsage++;
-            }
-
-            pidInfo->threadCount++;
+            pidInfo->refPids[ptr].push_back(pid);
+        }
+        return;
+    }
+    if (type == "thread") {
+        // thread 123: l 12 need_return 0 tr 0
+        nextToken(&line);
+        std::string_view looper = nextToken(&line);
+        std::string_view state = nextToken(&line);
+        if (looper != "l" || state.size() < 2 || !isdigit(state[0]) || !isdigit(state[1])) {
+            return;
+        }
+        // "1" is waiting in binder driver
+        // "2" is poll. It's impossible to tell if these are in use.
+        //     and HIDL default code doesn't use it.
+        bool isInUse = state[0] != '1';
+        // "0" is a thread that has called into binder
+        // "1" is looper thread
+        // "2" is main looper thread
+        bool isBinderThread = state[1] != '0';
+        if (!isBinderThread) {
             return;
         }
+        if (isInUse) {
+            pidInfo->threadUsage++;
+        }
+
+        pidInfo->threadCount++;
         return;
-    });
+    }
+}
+
+status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
+    const std::string pidStr = std::to_string(pid);
+    return scanBinderContext("/dev/binderfs/binder_logs/proc/" + pidStr, "/d/binder/proc/" + pidStr,
+                             contextToString(context),
+                             [&](pid_t /*linePid*/, std::string_view line) {
+                                 addBinderStateLine(line, pidInfo);
+                             });
+}
+
+status_t getAllBinderPidInfo(BinderDebugContext context,
+                             std::map<pid_t, BinderPidInfo>* pidInfos) {
+    return scanBinderContext("/dev/binderfs/binder_logs/state", "/d/binder/state",
+                             contextToString(context), [&](pid_t pid, std::string_view line) {
+                                 addBinderStateLine(line, &(*pidInfos)[pid]);
+                             });
+}
+
+status_t getMergedTransactionLatencyStats(const std::vector<sp<IBinder>>& binders,
+                                          TransactionLatencyStats* stats) {
+    status_t ret = OK;
+    std::set<pid_t> seenPids;
+    for (const sp<IBinder>& binder : binders) {
+        pid_t pid;
+        status_t status = binder->getDebugPid(&pid);
+        if (status == OK && !seenPids.insert(pid).second) continue;
+
+        TransactionLatencyStats processStats;
+        if (status == OK) status = binder->getTransactionLatencyStats(&processStats);
+        if (status != OK) {
+            if (ret == OK) ret = status;
+            continue;
+        }
+        stats->merge(processStats);
+    }
     return ret;
 }
 
@@ -15,6 +15,9 @@
  */
 #pragma once
 
+#include <binder/IBinder.h>
+#include <binder/TransactionLatencyStats.h>
+
 #include <map>
 #include <vector>
 
@@ -34,4 +37,21 @@ enum class BinderDebugContext {
 
 status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo);
 
+/**
+ * Same as getBinderPidInfo, for all the processes using 'context' at once.
+ * The binder state of all processes is read in a single pass, which is
+ * cheaper than one getBinderPidInfo call per process when querying many.
+ */
+status_t getAllBinderPidInfo(BinderDebugContext context,
+                             std::map<pid_t, BinderPidInfo>* pidInfos);
+
+/**
+ * Merges the transaction latencies recorded by the processes hosting each of
+ * 'binders' (see IBinder::getTransactionLatencyStats). Each process is only
+ * counted once, even if it hosts several of them. If some processes can't be
+ * queried, the others are still merged, and the first error is returned.
+ */
+status_t getMergedTransactionLatencyStats(const std::vector<sp<IBinder>>& binders,
+                                          TransactionLatencyStats* stats);
+
 } // namespace  android
@@ -60,6 +60,39 @@ TEST(BinderDebugTests, BinderThreads) {
     EXPECT_GE(pidInfo.threadCount, 1);
 }
 
+TEST(BinderDebugTests, AllBinderPids) {
+    BinderPidInfo pidInfo;
+    ASSERT_EQ(OK, getBinderPidInfo(BinderDebugContext::BINDER, getpid(), &pidInfo));
+
+    std::map<pid_t, BinderPidInfo> pidInfos;
+    const auto& status = getAllBinderPidInfo(BinderDebugContext::BINDER, &pidInfos);
+    ASSERT_EQ(status, OK);
+    auto it = pidInfos.find(getpid());
+    ASSERT_NE(it, pidInfos.end());
+    EXPECT_EQ(it->second.refPids.size(), pidInfo.refPids.size());
+    EXPECT_GE(it->second.threadCount, 1);
+}
+
+TEST(BinderDebugTests, MergedTransactionLatencies) {
+    ProcessState::self()->setTransactionLatencyTrackingEnabled(true);
+    sp<IBinder> sm = IInterface::asBinder(defaultServiceManager());
+    for (size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(OK, sm->pingBinder());
+    }
+    ProcessState::self()->setTransactionLatencyTrackingEnabled(false);
+
+    // the same process twice, it should only be counted once
+    sp<IBinder> local = new BBinder;
+    TransactionLatencyStats stats;
+    ASSERT_EQ(OK, getMergedTransactionLatencyStats({local, local}, &stats));
+
+    uint64_t pings = 0;
+    for (const auto& entry : stats.entries) {
+        if (!entry.server && entry.code == IBinder::PING_TRANSACTION) pings += entry.count;
+    }
+    EXPECT_GE(pings, 10u);
+}
+
 extern "C" {
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -22,7 +22,10 @@
 #include <dirent.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
+#include <unistd.h>
 
 #include <mutex>
 #include <numeric>
@@ -324,10 +327,73 @@ std::optional<std::vector<std::vector<uint64_t>>> getUidCpuFreqTimes(uint32_t ui
     return out;
 }
 
-static std::optional<bool> uidUpdatedSince(uint32_t uid, uint64_t lastUpdate,
-                                           uint64_t *newLastUpdate) {
-    uint64_t uidLastUpdate;
-    if (findMapEntry(gUidLastUpdateMapFd, &uid, &uidLastUpdate)) return {};
+// Number of entries requested from the kernel by each BPF_MAP_LOOKUP_BATCH call
+static constexpr uint32_t BATCH_SIZE = 64;
+
+// Call fn(key, vals) for each entry of the map mapFd, where vals points to the nVals values of the
+// entry (one per cpu for per-cpu maps). Entries are read BATCH_SIZE at a time with
+// BPF_MAP_LOOKUP_BATCH, falling back to a getNextMapKey and findMapEntry call per entry on kernels
+// that don't support it. Returns false on error or as soon as fn returns false, true otherwise.
+template <typename Key, typename Val, typename Fn>
+static bool forEachMapEntry(const unique_fd &mapFd, size_t nVals, Fn fn) {
+    std::vector<Key> keys(BATCH_SIZE);
+    std::vector<Val> vals(BATCH_SIZE * nVals);
+    uint64_t batch = 0;
+    bool first = true;
+    while (true) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.batch.in_batch = first ? 0 : reinterpret_cast<uint64_t>(&batch);
+        attr.batch.out_batch = reinterpret_cast<uint64_t>(&batch);
+        attr.batch.keys = reinterpret_cast<uint64_t>(keys.data());
+        attr.batch.values = reinterpret_cast<uint64_t>(vals.data());
+        attr.batch.count = keys.size();
+        attr.batch.map_fd = mapFd.get();
+        int ret = syscall(__NR_bpf, BPF_MAP_LOOKUP_BATCH, &attr, sizeof(attr));
+        if (ret && errno == ENOSPC && attr.batch.count == 0) {
+            // A hash bucket holds more entries than fit in the buffers
+            keys.resize(keys.size() * 2);
+            vals.resize(keys.size() * nVals);
+            continue;
+        }
+        if (ret && errno != ENOENT) {
+            if (!first) return false;
+            Key key, prevKey;
+            if (getFirstMapKey(mapFd, &key)) return errno == ENOENT;
+            do {
+                if (findMapEntry(mapFd, &key, vals.data()) || !fn(key, vals.data())) return false;
+            } while (prevKey = key, !getNextMapKey(mapFd, &prevKey, &key));
+            return errno == ENOENT;
+        }
+        for (uint32_t i = 0; i < attr.batch.count; ++i) {
+            if (!fn(keys[i], &vals[i * nVals])) return false;
+        }
+        // ENOENT means the last entries of the map were returned
+        if (ret) return true;
+        first = false;
+    }
+}
+
+// Retrieve the time in ns of the last update of each uid, read with a single pass over the map
+// rather than a lookup per uid and bucket.
+static std::optional<std::unordered_map<uint32_t, uint64_t>> getUidLastUpdates() {
+    std::unordered_map<uint32_t, uint64_t> uidLastUpdates;
+    if (!forEachMapEntry<uint32_t, uint64_t>(gUidLastUpdateMapFd, 1,
+                                             [&](const uint32_t &uid, const uint64_t *val) {
+                                                 uidLastUpdates[uid] = *val;
+                                                 return true;
+                                             })) {
+        return {};
+    }
+    return uidLastUpdates;
+}
+
+static bool uidUpdatedSince(const std::unordered_map<uint32_t, uint64_t> &uidLastUpdates,
+                            uint32_t uid, uint64_t lastUpdate, uint64_t *newLastUpdate) {
+    auto it = uidLastUpdates.find(uid);
+    // The uid started running after the update times were read
+    if (it == uidLastUpdates.end()) return true;
+    uint64_t uidLastUpdate = it->second;
     // Updates that occurred during the previous read may have been missed. To mitigate
     // this, don't ignore entries updated up to 1s before *lastUpdate
     constexpr uint64_t NSEC_PER_SEC = 1000000000;
@@ -353,25 +419,22 @@ getUidsCpuFreqTimes() {
 std::optional<std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>>>
 getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate) {
     if (!gInitialized && !initGlobals()) return {};
-    time_key_t key, prevKey;
     std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>> map;
-    if (getFirstMapKey(gTisMapFd, &key)) {
-        if (errno == ENOENT) return map;
-        return std::nullopt;
+    std::unordered_map<uint32_t, uint64_t> uidLastUpdates;
+    if (lastUpdate) {
+        auto updates = getUidLastUpdates();
+        if (!updates.has_value()) return {};
+        uidLastUpdates = std::move(*updates);
     }
 
     std::vector<std::vector<uint64_t>> mapFormat;
     for (const auto &freqList : gPolicyFreqs) mapFormat.emplace_back(freqList.size(), 0);
 
     uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
-    std::vector<tis_val_t> vals(gNCpus);
-    do {
-        if (lastUpdate) {
-            auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
-            if (!uidUpdated.has_value()) return {};
-            if (!*uidUpdated) continue;
+    auto addEntry = [&](const time_key_t &key, const tis_val_t *vals) {
+        if (lastUpdate && !uidUpdatedSince(uidLastUpdates, key.uid, *lastUpdate, &newLastUpdate)) {
+            return true;
         }
-        if (findMapEntry(gTisMapFd, &key, vals.data())) return {};
         if (map.find(key.uid) == map.end()) map.emplace(key.uid, mapFormat);
 
         auto offset = key.bucket * FREQS_PER_ENTRY;
@@ -385,9 +448,9 @@ getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate) {
                 std::transform(begin, end, std::begin(vals[cpu].ar), begin, std::plus<uint64_t>());
             }
         }
-        prevKey = key;
-    } while (prevKey = key, !getNextMapKey(gTisMapFd, &prevKey, &key));
-    if (errno != ENOENT) return {};
+        return true;
+    };
+    if (!forEachMapEntry<time_key_t, tis_val_t>(gTisMapFd, gNCpus, addEntry)) return {};
     if (lastUpdate && newLastUpdate > *lastUpdate) *lastUpdate = newLastUpdate;
     return map;
 }
@@ -463,28 +526,25 @@ std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsConcurrent
 std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsUpdatedConcurrentTimes(
         uint64_t *lastUpdate) {
     if (!gInitialized && !initGlobals()) return {};
-    time_key_t key, prevKey;
     std::unordered_map<uint32_t, concurrent_time_t> ret;
-    if (getFirstMapKey(gConcurrentMapFd, &key)) {
-        if (errno == ENOENT) return ret;
-        return {};
+    std::unordered_map<uint32_t, uint64_t> uidLastUpdates;
+    if (lastUpdate) {
+        auto updates = getUidLastUpdates();
+        if (!updates.has_value()) return {};
+        uidLastUpdates = std::move(*updates);
     }
 
     concurrent_time_t retFormat = {.active = std::vector<uint64_t>(gNCpus, 0)};
     for (const auto &cpuList : gPolicyCpus) retFormat.policy.emplace_back(cpuList.size(), 0);
 
-    std::vector<concurrent_val_t> vals(gNCpus);
     std::vector<uint64_t>::iterator activeBegin, activeEnd, policyBegin, policyEnd;
 
     uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
-    do {
-        if (key.bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return {};
-        if (lastUpdate) {
-            auto uidUpdated = uidUpdatedSince(key.uid, *lastUpdate, &newLastUpdate);
-            if (!uidUpdated.has_value()) return {};
-            if (!*uidUpdated) continue;
+    auto addEntry = [&](const time_key_t &key, const concurrent_val_t *vals) {
+        if (key.bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return false;
+        if (lastUpdate && !uidUpdatedSince(uidLastUpdates, key.uid, *lastUpdate, &newLastUpdate)) {
+            return true;
         }
-        if (findMapEntry(gConcurrentMapFd, &key, vals.data())) return {};
         if (ret.find(key.uid) == ret.end()) ret.emplace(key.uid, retFormat);
 
         auto offset = key.bucket * CPUS_PER_ENTRY;
@@ -509,8 +569,11 @@ std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsUpdatedCon
                                std::plus<uint64_t>());
             }
         }
-    } while (prevKey = key, !getNextMapKey(gConcurrentMapFd, &prevKey, &key));
-    if (errno != ENOENT) return {};
+        return true;
+    };
+    if (!forEachMapEntry<time_key_t, concurrent_val_t>(gConcurrentMapFd, gNCpus, addEntry)) {
+        return {};
+    }
     for (const auto &[key, value] : ret) {
         if (!verifyConcurrentTimes(value)) {
             auto val = getUidConcurrentTimes(key, false);
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/small_map.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+// Usage: atest ftl_benchmark
+
+namespace android {
+namespace {
+
+// Same inline capacity as the display maps in SurfaceFlinger.
+constexpr std::size_t kCapacity = 4;
+
+// Keys in an order that is neither ascending nor descending.
+int key(int64_t i, int64_t count) {
+  return static_cast<int>((i * 37) % count);
+}
+
+template <typename Map>
+Map makeMap(int64_t count) {
+  Map map;
+  for (int64_t i = 0; i < count; i++) {
+    map.try_emplace(key(i, count), static_cast<int>(i));
+  }
+  return map;
+}
+
+// Inserts count mappings into an empty map.
+void BM_SmallMapInsert(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(makeMap<ftl::SmallMap<int, int, kCapacity>>(state.range(0)));
+  }
+}
+BENCHMARK(BM_SmallMapInsert)->Arg(2)->Arg(4)->Arg(8)->Arg(32)->Arg(128);
+
+// Looks up every key of a map with count mappings.
+void BM_SmallMapFind(benchmark::State& state) {
+  const int64_t count = state.range(0);
+  const auto map = makeMap<ftl::SmallMap<int, int, kCapacity>>(count);
+  for (auto _ : state) {
+    for (int64_t i = 0; i < count; i++) {
+      benchmark::DoNotOptimize(map.find(static_cast<int>(i)));
+    }
+  }
+}
+BENCHMARK(BM_SmallMapFind)->Arg(2)->Arg(4)->Arg(8)->Arg(32)->Arg(128);
+
+// Same as above, with keys that only support equality and so are found by linear search.
+void BM_SmallMapFindUnordered(benchmark::State& state) {
+  struct Key {
+    int id;
+    bool operator==(const Key& other) const { return id == other.id; }
+  };
+
+  const int64_t count = state.range(0);
+  ftl::SmallMap<Key, int, kCapacity> map;
+  for (int64_t i = 0; i < count; i++) {
+    map.try_emplace(Key{key(i, count)}, static_cast<int>(i));
+  }
+  for (auto _ : state) {
+    for (int64_t i = 0; i < count; i++) {
+      benchmark::DoNotOptimize(map.find(Key{static_cast<int>(i)}));
+    }
+  }
+}
+BENCHMARK(BM_SmallMapFindUnordered)->Arg(2)->Arg(4)->Arg(8)->Arg(32)->Arg(128);
+
+// Baseline for the lookups above.
+void BM_UnorderedMapFind(benchmark::State& state) {
+  const int64_t count = state.range(0);
+  std::unordered_map<int, int> map;
+  for (int64_t i = 0; i < count; i++) {
+    map.emplace(key(i, count), static_cast<int>(i));
+  }
+  for (auto _ : state) {
+    for (int64_t i = 0; i < count; i++) {
+      benchmark::DoNotOptimize(map.find(static_cast<int>(i)));
+    }
+  }
+}
+BENCHMARK(BM_UnorderedMapFind)->Arg(2)->Arg(4)->Arg(8)->Arg(32)->Arg(128);
+
+}  // namespace
+}  // namespace android
+
+BENCHMARK_MAIN();
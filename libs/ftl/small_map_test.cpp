@@ -45,6 +45,13 @@ TEST(SmallMap, Example) {
   ref = "xyz";
 
   EXPECT_EQ(map, SmallMap(ftl::init::map(-1, "xyz")(42, "???")(123, "abc")));
+
+  EXPECT_TRUE(map.try_emplace(7, "seven").second);
+  EXPECT_EQ(map.size(), 4u);
+  EXPECT_TRUE(map.dynamic());
+
+  EXPECT_TRUE(map.erase(123));
+  EXPECT_FALSE(map.contains(123));
 }
 
 TEST(SmallMap, Construct) {
@@ -128,4 +135,95 @@ TEST(SmallMap, Find) {
   }
 }
 
+TEST(SmallMap, TryEmplace) {
+  SmallMap<int, std::string, 2> map;
+
+  auto [it, ok] = map.try_emplace(1, "a");
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(it->first, 1);
+  EXPECT_EQ(it->second, "a");
+
+  std::tie(it, ok) = map.try_emplace(2, 3u, 'b');
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(it->second, "bbb");
+  EXPECT_FALSE(map.dynamic());
+
+  // The key already exists.
+  std::tie(it, ok) = map.try_emplace(1, "x");
+  EXPECT_FALSE(ok);
+  EXPECT_EQ(it->second, "a");
+  EXPECT_EQ(map.size(), 2u);
+
+  std::tie(it, ok) = map.try_emplace(3, "c");
+  EXPECT_TRUE(ok);
+  EXPECT_TRUE(map.dynamic());
+
+  EXPECT_EQ(map, SmallMap(ftl::init::map<int, std::string>(3, "c")(2, "bbb")(1, "a")));
+}
+
+TEST(SmallMap, Erase) {
+  {
+    SmallMap map = ftl::init::map('a', 1)('b', 2)('c', 3);
+
+    EXPECT_TRUE(map.erase('a'));
+    EXPECT_FALSE(map.erase('a'));
+    EXPECT_FALSE(map.erase('d'));
+
+    EXPECT_EQ(map, SmallMap(ftl::init::map('b', 2)('c', 3)));
+  }
+  {
+    // Dynamic storage, with enough mappings for binary search.
+    SmallMap<int, int, 2> map;
+    for (int i = 0; i < 20; i++) map.try_emplace(i, i * i);
+
+    EXPECT_TRUE(map.erase(0));
+    EXPECT_TRUE(map.erase(19));
+    EXPECT_TRUE(map.erase(4));
+    EXPECT_EQ(map.size(), 17u);
+
+    for (int i = 0; i < 20; i++) {
+      EXPECT_EQ(map.contains(i), i != 0 && i != 19 && i != 4);
+    }
+
+    // Back to linear search.
+    for (int i = 1; i < 17; i++) {
+      if (i == 4) continue;
+      EXPECT_TRUE(map.erase(i));
+    }
+    EXPECT_EQ(map, SmallMap(ftl::init::map(17, 289)(18, 324)));
+  }
+}
+
+TEST(SmallMap, FindDynamic) {
+  struct Key {
+    int id;
+    bool operator==(const Key& other) const { return id == other.id; }
+  };
+
+  // Ordered keys are found by binary search, others by linear search.
+  SmallMap<int, int, 3> ordered;
+  SmallMap<Key, int, 3> unordered;
+
+  // Insert in an order that is neither ascending nor descending.
+  for (int i = 0; i < 100; i++) {
+    const int key = (i * 37) % 100;
+    EXPECT_TRUE(ordered.try_emplace(key, -key).second);
+    EXPECT_TRUE(unordered.try_emplace(Key{key}, -key).second);
+  }
+
+  for (int key = 0; key < 100; key++) {
+    EXPECT_EQ(ordered.find(key), -key);
+    EXPECT_EQ(unordered.find(Key{key}), -key);
+  }
+
+  EXPECT_FALSE(ordered.contains(100));
+  EXPECT_FALSE(unordered.contains(Key{-1}));
+
+  // Erasing moves the last mapping, whose position must follow.
+  for (int key = 0; key < 100; key += 2) EXPECT_TRUE(ordered.erase(key));
+  for (int key = 0; key < 100; key++) {
+    EXPECT_EQ(ordered.contains(key), key % 2 == 1);
+  }
+}
+
 }  // namespace android::test
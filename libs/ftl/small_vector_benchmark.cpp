@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/small_vector.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Usage: atest ftl_benchmark
+
+namespace android {
+namespace {
+
+constexpr std::size_t kCapacity = 16;
+
+// Trivially copyable, like the layer and display snapshots copied around in SurfaceFlinger.
+struct Rect {
+  int32_t left, top, right, bottom;
+};
+
+template <typename T>
+std::vector<T> makeElements(int64_t count);
+
+template <>
+std::vector<Rect> makeElements(int64_t count) {
+  return std::vector<Rect>(static_cast<std::size_t>(count), Rect{0, 0, 1080, 2400});
+}
+
+template <>
+std::vector<std::string> makeElements(int64_t count) {
+  return std::vector<std::string>(static_cast<std::size_t>(count), "display");
+}
+
+// Appends count elements one at a time to an empty vector.
+template <typename T>
+void BM_SmallVectorPushBack(benchmark::State& state) {
+  const auto elements = makeElements<T>(state.range(0));
+  for (auto _ : state) {
+    ftl::SmallVector<T, kCapacity> vector;
+    for (const auto& element : elements) {
+      vector.push_back(element);
+    }
+    benchmark::DoNotOptimize(vector);
+  }
+}
+BENCHMARK_TEMPLATE(BM_SmallVectorPushBack, Rect)->Arg(8)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(BM_SmallVectorPushBack, std::string)->Arg(8)->Arg(16)->Arg(64);
+
+// Appends count elements at once to an empty vector.
+template <typename T>
+void BM_SmallVectorAppend(benchmark::State& state) {
+  const auto elements = makeElements<T>(state.range(0));
+  for (auto _ : state) {
+    ftl::SmallVector<T, kCapacity> vector;
+    vector.append(elements.begin(), elements.end());
+    benchmark::DoNotOptimize(vector);
+  }
+}
+BENCHMARK_TEMPLATE(BM_SmallVectorAppend, Rect)->Arg(8)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(BM_SmallVectorAppend, std::string)->Arg(8)->Arg(16)->Arg(64);
+
+// Fills the static storage, then promotes it by pushing one more element.
+template <typename T>
+void BM_SmallVectorPromote(benchmark::State& state) {
+  const auto elements = makeElements<T>(kCapacity + 1);
+  for (auto _ : state) {
+    ftl::SmallVector<T, kCapacity> vector;
+    vector.append(elements.begin(), elements.end() - 1);
+    vector.push_back(elements.back());
+    benchmark::DoNotOptimize(vector);
+  }
+}
+BENCHMARK_TEMPLATE(BM_SmallVectorPromote, Rect);
+BENCHMARK_TEMPLATE(BM_SmallVectorPromote, std::string);
+
+// Copies a vector with static storage.
+template <typename T>
+void BM_SmallVectorCopy(benchmark::State& state) {
+  const auto elements = makeElements<T>(kCapacity);
+  ftl::SmallVector<T, kCapacity> vector;
+  vector.append(elements.begin(), elements.end());
+  for (auto _ : state) {
+    auto copy = vector;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK_TEMPLATE(BM_SmallVectorCopy, Rect);
+BENCHMARK_TEMPLATE(BM_SmallVectorCopy, std::string);
+
+}  // namespace
+}  // namespace android
@@ -21,6 +21,7 @@
 #include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 using namespace std::string_literals;
 
@@ -290,6 +291,39 @@ TEST(SmallVector, Replace) {
   EXPECT_EQ(words, (SmallVector{Word("red"), Word("velvet"), Word("cake")}));
 }
 
+TEST(SmallVector, Append) {
+  SmallVector<int, 4> vector = {1, 2};
+
+  {
+    const int array[] = {3, 4};
+    vector.append(std::begin(array), std::end(array));
+    EXPECT_EQ(vector, (SmallVector{1, 2, 3, 4}));
+    EXPECT_FALSE(vector.dynamic());
+  }
+
+  // The vector is promoted with room for all elements.
+  {
+    const std::vector<int> numbers(10, 5);
+    vector.append(numbers.begin(), numbers.end());
+    EXPECT_EQ(vector.size(), 14u);
+    EXPECT_TRUE(vector.dynamic());
+    EXPECT_EQ(vector.back(), 5);
+  }
+
+  // Non-trivially copyable elements.
+  SmallVector strings = {"red"s, "velvet"s};
+  {
+    const std::vector words = {"cake"s, "pie"s};
+    strings.append(words.begin(), words.end());
+  }
+  EXPECT_EQ(strings, (SmallVector{"red"s, "velvet"s, "cake"s, "pie"s}));
+  EXPECT_TRUE(strings.dynamic());
+
+  SmallVector<std::string, 0> dynamic;
+  dynamic.append(strings.begin(), strings.end());
+  EXPECT_EQ(dynamic, strings);
+}
+
 TEST(SmallVector, ReverseAppend) {
   SmallVector strings = {"red"s, "velvet"s, "cake"s};
   EXPECT_FALSE(strings.dynamic());
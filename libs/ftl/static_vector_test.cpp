@@ -21,6 +21,7 @@
 #include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 using namespace std::string_literals;
 
@@ -266,6 +267,29 @@ TEST(StaticVector, Replace) {
   EXPECT_EQ(word.str, "velvet");
 }
 
+TEST(StaticVector, Append) {
+  StaticVector<int, 5> vector = {1, 2};
+
+  {
+    const int array[] = {3, 4};
+    EXPECT_TRUE(vector.append(std::begin(array), std::end(array)));
+    EXPECT_EQ(vector, (StaticVector{1, 2, 3, 4}));
+  }
+
+  // Nothing is appended unless all elements fit.
+  {
+    const int array[] = {5, 6};
+    EXPECT_FALSE(vector.append(std::begin(array), std::end(array)));
+    EXPECT_EQ(vector, (StaticVector{1, 2, 3, 4}));
+  }
+
+  // Non-trivially copyable elements.
+  StaticVector<std::string, 3> strings = {"red"s};
+  const std::vector words = {"velvet"s, "cake"s};
+  EXPECT_TRUE(strings.append(words.begin(), words.end()));
+  EXPECT_EQ(strings, (StaticVector{"red"s, "velvet"s, "cake"s}));
+}
+
 TEST(StaticVector, ReverseTruncate) {
   StaticVector<std::string, 10> strings("pie", "quince", "tart", "red", "velvet", "cake");
   EXPECT_FALSE(strings.full());
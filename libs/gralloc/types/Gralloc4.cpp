@@ -800,13 +800,15 @@ status_t decodePlaneLayoutsHelper(InputHidlVec* inputHidlVec, std::vector<PlaneL
     if (err) {
         return err;
     }
-    if (size < 0) {
+    if (size < 0 || size > 10000) {
         return BAD_VALUE;
     }
 
-    for (size_t i = 0; i < size; i++) {
-        outPlaneLayouts->emplace_back();
-        err = decodePlaneLayout(inputHidlVec, &outPlaneLayouts->back());
+    // Decodes into the existing elements, so that decoding into the same output again reuses
+    // its allocations.
+    outPlaneLayouts->resize(size);
+    for (auto& planeLayout : *outPlaneLayouts) {
+        err = decodePlaneLayout(inputHidlVec, &planeLayout);
         if (err) {
             return err;
         }
@@ -843,13 +845,13 @@ status_t decodeCropHelper(InputHidlVec* inputHidlVec, std::vector<Rect>* outCrop
     if (err) {
         return err;
     }
-    if (size < 0) {
+    if (size < 0 || size > 10000) {
         return BAD_VALUE;
     }
 
-    for (size_t i = 0; i < size; i++) {
-        outCrops->emplace_back();
-        err = decodeRect(inputHidlVec, &outCrops->back());
+    outCrops->resize(size);
+    for (auto& rect : *outCrops) {
+        err = decodeRect(inputHidlVec, &rect);
         if (err) {
             return err;
         }
@@ -376,6 +376,23 @@ TEST_F(Gralloc4TestCrop, Crop) {
     ASSERT_NO_FATAL_FAILURE(testHelperStableAidlType(crops, gralloc4::encodeCrop, gralloc4::decodeCrop));
 }
 
+TEST_F(Gralloc4TestCrop, DecodeReplacesPreviousCrops) {
+    Rect crop;
+    crop.left = 0;
+    crop.top = 0;
+    crop.right = 64;
+    crop.bottom = 64;
+
+    hidl_vec<uint8_t> vec;
+    ASSERT_EQ(NO_ERROR, gralloc4::encodeCrop({crop}, &vec));
+
+    std::vector<Rect> output(3);
+    ASSERT_EQ(NO_ERROR, gralloc4::decodeCrop(vec, &output));
+    ASSERT_EQ(std::vector<Rect>{crop}, output);
+    ASSERT_EQ(NO_ERROR, gralloc4::decodeCrop(vec, &output));
+    ASSERT_EQ(std::vector<Rect>{crop}, output);
+}
+
 class Gralloc4TestDataspace : public testing::TestWithParam<Dataspace> { };
 
 INSTANTIATE_TEST_CASE_P(
@@ -146,26 +146,20 @@ void GraphicsEnv::setDriverPathAndSphalLibraries(const std::string path,
 void GraphicsEnv::hintActivityLaunch() {
     ATRACE_CALL();
 
-    {
-        std::lock_guard<std::mutex> lock(mStatsLock);
-        if (mActivityLaunched) return;
-        mActivityLaunched = true;
-    }
-
-    std::thread trySendGpuStatsThread([this]() {
-        // If there's already graphics driver preloaded in the process, just send
-        // the stats info to GpuStats directly through async binder.
-        std::lock_guard<std::mutex> lock(mStatsLock);
-        if (mGpuStats.glDriverToSend) {
-            mGpuStats.glDriverToSend = false;
-            sendGpuStatsLocked(GpuStatsInfo::Api::API_GL, true, mGpuStats.glDriverLoadingTime);
-        }
-        if (mGpuStats.vkDriverToSend) {
-            mGpuStats.vkDriverToSend = false;
-            sendGpuStatsLocked(GpuStatsInfo::Api::API_VK, true, mGpuStats.vkDriverLoadingTime);
-        }
-    });
-    trySendGpuStatsThread.detach();
+    std::lock_guard<std::mutex> lock(mStatsLock);
+    if (mActivityLaunched) return;
+    mActivityLaunched = true;
+
+    // If there's already graphics driver preloaded in the process, just send
+    // the stats info to GpuStats directly through async binder.
+    if (mGpuStats.glDriverToSend) {
+        mGpuStats.glDriverToSend = false;
+        sendGpuStatsLocked(GpuStatsInfo::Api::API_GL, true, mGpuStats.glDriverLoadingTime);
+    }
+    if (mGpuStats.vkDriverToSend) {
+        mGpuStats.vkDriverToSend = false;
+        sendGpuStatsLocked(GpuStatsInfo::Api::API_VK, true, mGpuStats.vkDriverLoadingTime);
+    }
 }
 
 void GraphicsEnv::setGpuStats(const std::string& driverPackageName,
@@ -268,11 +262,11 @@ void GraphicsEnv::setTargetStats(const GpuStatsInfo::Stats stats, const uint64_t
     std::lock_guard<std::mutex> lock(mStatsLock);
     if (!readyToSendGpuStatsLocked()) return;
 
-    const sp<IGpuService> gpuService = getGpuService();
-    if (gpuService) {
-        gpuService->setTargetStats(mGpuStats.appPackageName, mGpuStats.driverVersionCode, stats,
-                                   value);
-    }
+    queueGpuServiceCallLocked([appPackageName = mGpuStats.appPackageName,
+                               driverVersionCode = mGpuStats.driverVersionCode, stats,
+                               value](IGpuService& gpuService) {
+        gpuService.setTargetStats(appPackageName, driverVersionCode, stats, value);
+    });
 }
 
 void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
@@ -307,13 +301,41 @@ void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
                 isDriverLoaded && (mGpuStats.vkDriverFallback == GpuStatsInfo::Driver::NONE);
     }
 
-    const sp<IGpuService> gpuService = getGpuService();
-    if (gpuService) {
-        gpuService->setGpuStats(mGpuStats.driverPackageName, mGpuStats.driverVersionName,
-                                mGpuStats.driverVersionCode, mGpuStats.driverBuildTime,
-                                mGpuStats.appPackageName, mGpuStats.vulkanVersion, driver,
-                                isIntendedDriverLoaded, driverLoadingTime);
-    }
+    queueGpuServiceCallLocked([stats = mGpuStats, driver, isIntendedDriverLoaded,
+                               driverLoadingTime](IGpuService& gpuService) {
+        gpuService.setGpuStats(stats.driverPackageName, stats.driverVersionName,
+                               stats.driverVersionCode, stats.driverBuildTime,
+                               stats.appPackageName, stats.vulkanVersion, driver,
+                               isIntendedDriverLoaded, driverLoadingTime);
+    });
+}
+
+void GraphicsEnv::queueGpuServiceCallLocked(std::function<void(IGpuService&)> call) {
+    mPendingGpuServiceCalls.push_back(std::move(call));
+    if (mGpuServiceCallsSending) return;
+    mGpuServiceCallsSending = true;
+
+    // The calls themselves are oneway, but looking up gpuservice the first time is a synchronous
+    // call to servicemanager, which is kept off the threads loading the drivers. A single thread
+    // makes the calls, so that the target stats never arrive before the stats of their app.
+    std::thread sendGpuStatsThread([this]() {
+        std::unique_lock<std::mutex> lock(mStatsLock);
+        while (!mPendingGpuServiceCalls.empty()) {
+            std::deque<std::function<void(IGpuService&)>> calls;
+            calls.swap(mPendingGpuServiceCalls);
+            lock.unlock();
+
+            if (const sp<IGpuService> gpuService = getGpuService()) {
+                for (const auto& call : calls) {
+                    call(*gpuService);
+                }
+            }
+
+            lock.lock();
+        }
+        mGpuServiceCallsSending = false;
+    });
+    sendGpuStatsThread.detach();
 }
 
 bool GraphicsEnv::setInjectLayersPrSetDumpable() {
@@ -19,6 +19,8 @@
 
 #include <graphicsenv/GpuStatsInfo.h>
 
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -28,6 +30,7 @@ struct android_namespace_t;
 namespace android {
 
 struct NativeLoaderNamespace;
+class IGpuService;
 
 class GraphicsEnv {
 public:
@@ -139,18 +142,24 @@ private:
     bool readyToSendGpuStatsLocked();
     // Send the initial complete GpuStats to GpuService.
     void sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded, int64_t driverLoadingTime);
+    // Queue a call to GpuService, to be made in order from the stats sender thread.
+    void queueGpuServiceCallLocked(std::function<void(IGpuService&)> call);
 
     GraphicsEnv() = default;
     // Path to updatable driver libs.
     std::string mDriverPath;
     // Path to additional sphal libs linked to updatable driver namespace.
     std::string mSphalLibraries;
-    // This mutex protects mGpuStats and get gpuservice call.
+    // This mutex protects mGpuStats and the calls queued for gpuservice.
     std::mutex mStatsLock;
     // Cache the activity launch info
     bool mActivityLaunched = false;
     // Information bookkept for GpuStats.
     GpuStatsInfo mGpuStats;
+    // Calls to GpuService waiting for the stats sender thread.
+    std::deque<std::function<void(IGpuService&)>> mPendingGpuServiceCalls;
+    // Whether the stats sender thread is running.
+    bool mGpuServiceCallsSending = false;
     // Path to ANGLE libs.
     std::string mAnglePath;
     // This App's name.
@@ -288,6 +288,7 @@ void BLASTBufferQueue::transactionCallback(nsecs_t /*latchTime*/, const sp<Fence
                                                     stat.frameEventStats.dequeueReadyTime);
                 }
                 currFrameNumber = stat.frameEventStats.frameNumber;
+                onBufferPresentedLocked(currFrameNumber);
 
                 if (mTransactionCompleteCallback &&
                     currFrameNumber >= mTransactionCompleteFrameNumber) {
@@ -343,6 +344,9 @@ void BLASTBufferQueue::releaseBufferCallback(const ReleaseCallbackId& id,
     std::unique_lock _lock{mMutex};
     BQA_LOGV("releaseBufferCallback %s", id.to_string().c_str());
 
+    // A buffer SurfaceFlinger dropped is released without being presented.
+    onBufferPresentedLocked(id.framenumber);
+
     if (mSurfaceControl != nullptr) {
         mTransformHint = transformHint;
         mSurfaceControl->setTransformHint(transformHint);
@@ -401,6 +405,13 @@ void BLASTBufferQueue::processNextBufferLocked(bool useNextTransaction) {
         return;
     }
 
+    // Hold the buffers back until the one sent last is presented, and then send the latest.
+    if (mCoalesceBuffers && mInFlightFrameNumber && !useNextTransaction) {
+        BQA_LOGV("holding %u buffers until frame %" PRIu64 " is presented", mNumFrameAvailable,
+                 *mInFlightFrameNumber);
+        return;
+    }
+
     SurfaceComposerClient::Transaction localTransaction;
     bool applyTransaction = true;
     SurfaceComposerClient::Transaction* t = &localTransaction;
@@ -421,6 +432,9 @@ void BLASTBufferQueue::processNextBufferLocked(bool useNextTransaction) {
         BQA_LOGE("Failed to acquire a buffer, err=%s", statusToString(status).c_str());
         return;
     }
+    if (mCoalesceBuffers && !useNextTransaction) {
+        skipToLatestBufferLocked(&bufferItem);
+    }
     auto buffer = bufferItem.mGraphicBuffer;
     mNumFrameAvailable--;
 
@@ -525,6 +539,9 @@ void BLASTBufferQueue::processNextBufferLocked(bool useNextTransaction) {
 
     if (applyTransaction) {
         t->setApplyToken(mApplyToken).apply();
+        if (mCoalesceBuffers) {
+            mInFlightFrameNumber = bufferItem.mFrameNumber;
+        }
     }
 
     BQA_LOGV("processNextBufferLocked size=%dx%d mFrameNumber=%" PRIu64
@@ -536,6 +553,53 @@ void BLASTBufferQueue::processNextBufferLocked(bool useNextTransaction) {
              bufferItem.mAutoRefresh ? " mAutoRefresh" : "", bufferItem.mTransform);
 }
 
+void BLASTBufferQueue::skipToLatestBufferLocked(BufferItem* bufferItem) {
+    // Holding the skipped buffer while acquiring the next one takes an extra acquire.
+    while (mNumFrameAvailable > 1 && bufferItem->mIsAutoTimestamp &&
+           bufferItem->mGraphicBuffer != nullptr && mNumAcquired < mMaxAcquiredBuffers) {
+        BufferItem nextItem;
+        if (mBufferItemConsumer->acquireBuffer(&nextItem, 0 /* expectedPresent */, false) != OK) {
+            break;
+        }
+        mNumFrameAvailable--;
+
+        if (!mNextFrameTimelineInfoQueue.empty()) {
+            mNextFrameTimelineInfoQueue.pop();
+        }
+        {
+            std::unique_lock _lock{mTimestampMutex};
+            mDequeueTimestamps.erase(bufferItem->mGraphicBuffer->getId());
+        }
+
+        // The skipped buffer is never read, so it can be reused once the producer is done.
+        BQA_LOGV("skipping frameNumber=%" PRIu64, bufferItem->mFrameNumber);
+        mBufferItemConsumer->releaseBuffer(*bufferItem,
+                                           bufferItem->mFence ? bufferItem->mFence
+                                                              : Fence::NO_FENCE);
+        *bufferItem = std::move(nextItem);
+        mSkippedBuffers++;
+    }
+    ATRACE_INT("SkippedBuffers", static_cast<int32_t>(mSkippedBuffers));
+}
+
+void BLASTBufferQueue::onBufferPresentedLocked(uint64_t frameNumber) {
+    if (!mInFlightFrameNumber || frameNumber < *mInFlightFrameNumber) {
+        return;
+    }
+    mInFlightFrameNumber.reset();
+    processNextBufferLocked(false /* useNextTransaction */);
+    mCallbackCV.notify_all();
+}
+
+void BLASTBufferQueue::setBufferCoalescing(bool enabled) {
+    std::unique_lock _lock{mMutex};
+    mCoalesceBuffers = enabled;
+    if (!enabled && mInFlightFrameNumber) {
+        mInFlightFrameNumber.reset();
+        processNextBufferLocked(false /* useNextTransaction */);
+    }
+}
+
 Rect BLASTBufferQueue::computeCrop(const BufferItem& item) {
     if (item.mScalingMode == NATIVE_WINDOW_SCALING_MODE_SCALE_CROP) {
         return GLConsumer::scaleDownCrop(item.mCrop, mSize.width, mSize.height);
@@ -22,6 +22,7 @@
 
 #include <gui/BufferItem.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #define CC_LOGV(x, ...) ALOGV("[%s] " x, mName.string(), ##__VA_ARGS__)
 //#define CC_LOGD(x, ...) ALOGD("[%s] " x, mName.string(), ##__VA_ARGS__)
@@ -35,7 +36,8 @@ CpuConsumer::CpuConsumer(const sp<IGraphicBufferConsumer>& bq,
         size_t maxLockedBuffers, bool controlledByApp) :
     ConsumerBase(bq, controlledByApp),
     mMaxLockedBuffers(maxLockedBuffers),
-    mCurrentLockedBuffers(0)
+    mCurrentLockedBuffers(0),
+    mNonYCbCrBufferIds{}
 {
     // Create tracking entries for locked buffers
     mAcquiredBuffers.insertAt(0, maxLockedBuffers);
@@ -87,12 +89,13 @@ static bool isPossiblyYUV(PixelFormat format) {
     }
 }
 
-status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const {
+status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) {
     android_ycbcr ycbcr = android_ycbcr();
 
     PixelFormat format = item.mGraphicBuffer->getPixelFormat();
     PixelFormat flexFormat = format;
-    if (isPossiblyYUV(format)) {
+    const uint64_t bufferId = item.mGraphicBuffer->getId();
+    if (isPossiblyYUV(format) && mNonYCbCrBufferIds[item.mSlot] != bufferId) {
         int fenceFd = item.mFence.get() ? item.mFence->dup() : -1;
         status_t err = item.mGraphicBuffer->lockAsyncYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN,
                                                            item.mCrop, &ycbcr, fenceFd);
@@ -104,6 +107,8 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
         } else if (format == HAL_PIXEL_FORMAT_YCbCr_420_888) {
             CC_LOGE("Unable to lock YCbCr buffer for CPU reading: %s (%d)", strerror(-err), err);
             return err;
+        } else {
+            mNonYCbCrBufferIds[item.mSlot] = bufferId;
         }
     }
 
@@ -176,10 +181,12 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         b.mGraphicBuffer = mSlots[b.mSlot].mGraphicBuffer;
     }
 
+    const nsecs_t lockStart = systemTime();
     err = lockBufferItem(b, nativeBuffer);
     if (err != OK) {
         return err;
     }
+    nativeBuffer->lockDuration = systemTime() - lockStart;
 
     // find an unused AcquiredBuffer
     size_t lockedIdx = findAcquiredBufferLocked(AcquiredBuffer::kUnusedId);
@@ -16,6 +16,7 @@
 
 #define LOG_TAG "DisplayEventDispatcher"
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 
@@ -155,19 +156,32 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
                     outVsyncEventData->frameInterval = ev.vsync.frameInterval;
                     break;
                 case DisplayEventReceiver::DISPLAY_EVENT_HOTPLUG:
+                    dispatchPendingModeChanges();
                     dispatchHotplug(ev.header.timestamp, ev.header.displayId, ev.hotplug.connected);
                     break;
-                case DisplayEventReceiver::DISPLAY_EVENT_MODE_CHANGE:
-                    dispatchModeChanged(ev.header.timestamp, ev.header.displayId,
-                                        ev.modeChange.modeId, ev.modeChange.vsyncPeriod);
+                case DisplayEventReceiver::DISPLAY_EVENT_MODE_CHANGE: {
+                    // Only the latest mode of a display matters, keep it for later.
+                    auto it = std::find_if(mPendingModeChanges.begin(), mPendingModeChanges.end(),
+                                           [&](const DisplayEventReceiver::Event& pending) {
+                                               return pending.header.displayId ==
+                                                       ev.header.displayId;
+                                           });
+                    if (it != mPendingModeChanges.end()) {
+                        *it = ev;
+                    } else {
+                        mPendingModeChanges.push_back(ev);
+                    }
                     break;
+                }
                 case DisplayEventReceiver::DISPLAY_EVENT_NULL:
+                    dispatchPendingModeChanges();
                     dispatchNullEvent(ev.header.timestamp, ev.header.displayId);
                     break;
                 case DisplayEventReceiver::DISPLAY_EVENT_FRAME_RATE_OVERRIDE:
                     mFrameRateOverrides.emplace_back(ev.frameRateOverride);
                     break;
                 case DisplayEventReceiver::DISPLAY_EVENT_FRAME_RATE_OVERRIDE_FLUSH:
+                    dispatchPendingModeChanges();
                     dispatchFrameRateOverrides(ev.header.timestamp, ev.header.displayId,
                                                std::move(mFrameRateOverrides));
                     break;
@@ -180,7 +194,25 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
     if (n < 0) {
         ALOGW("Failed to get events from display event dispatcher, status=%d", status_t(n));
     }
+    dispatchPendingModeChanges();
     return gotVsync;
 }
 
+void DisplayEventDispatcher::dispatchPendingModeChanges() {
+    if (mPendingModeChanges.empty()) return;
+
+    // Taken out first, in case a callback drains the pending events itself.
+    std::vector<DisplayEventReceiver::Event> pending;
+    pending.swap(mPendingModeChanges);
+    for (const DisplayEventReceiver::Event& ev : pending) {
+        dispatchModeChanged(ev.header.timestamp, ev.header.displayId, ev.modeChange.modeId,
+                            ev.modeChange.vsyncPeriod);
+    }
+    pending.clear();
+    if (mPendingModeChanges.empty()) {
+        // keep the capacity for the next burst
+        mPendingModeChanges.swap(pending);
+    }
+}
+
 } // namespace android
@@ -285,16 +285,15 @@ void ProducerFrameEventHistory::applyDelta(
         frame.addPostCompositeCalled = d.mAddPostCompositeCalled != 0;
         frame.addReleaseCalled = d.mAddReleaseCalled != 0;
 
-        frame.postedTime = d.mPostedTime;
-        frame.requestedPresentTime = d.mRequestedPresentTime;
-        frame.latchTime = d.mLatchTime;
-        frame.firstRefreshStartTime = d.mFirstRefreshStartTime;
-        frame.lastRefreshStartTime = d.mLastRefreshStartTime;
-        frame.dequeueReadyTime = d.mDequeueReadyTime;
-
         if (frame.frameNumber != d.mFrameNumber) {
             // We got a new frame. Initialize some of the fields.
             frame.frameNumber = d.mFrameNumber;
+            frame.postedTime = FrameEvents::TIMESTAMP_PENDING;
+            frame.requestedPresentTime = FrameEvents::TIMESTAMP_PENDING;
+            frame.latchTime = FrameEvents::TIMESTAMP_PENDING;
+            frame.firstRefreshStartTime = FrameEvents::TIMESTAMP_PENDING;
+            frame.lastRefreshStartTime = FrameEvents::TIMESTAMP_PENDING;
+            frame.dequeueReadyTime = FrameEvents::TIMESTAMP_PENDING;
             frame.acquireFence = FenceTime::NO_FENCE;
             frame.gpuCompositionDoneFence = FenceTime::NO_FENCE;
             frame.displayPresentFence = FenceTime::NO_FENCE;
@@ -303,6 +302,26 @@ void ProducerFrameEventHistory::applyDelta(
             frame.valid = true;
         }
 
+        // The delta only holds the timestamps that changed.
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::POSTED)) {
+            frame.postedTime = d.mPostedTime;
+        }
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::REQUESTED_PRESENT)) {
+            frame.requestedPresentTime = d.mRequestedPresentTime;
+        }
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::LATCH)) {
+            frame.latchTime = d.mLatchTime;
+        }
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::FIRST_REFRESH_START)) {
+            frame.firstRefreshStartTime = d.mFirstRefreshStartTime;
+        }
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::LAST_REFRESH_START)) {
+            frame.lastRefreshStartTime = d.mLastRefreshStartTime;
+        }
+        if (d.mDirtyTimestamps & FrameEventsDelta::eventBit(FrameEvent::DEQUEUE_READY)) {
+            frame.dequeueReadyTime = d.mDequeueReadyTime;
+        }
+
         applyFenceDelta(&mGpuCompositionDoneTimeline,
                 &frame.gpuCompositionDoneFence, d.mGpuCompositionDoneFence);
         applyFenceDelta(&mPresentTimeline,
@@ -388,6 +407,7 @@ void ConsumerFrameEventHistory::addQueue(const NewFrameEventsEntry& newEntry) {
     // they have the original one already, so there is no need to set the
     // acquire dirty bit.
     mFramesDirty[mQueueOffset].setDirty<FrameEvent::POSTED>();
+    mFramesDirty[mQueueOffset].setDirty<FrameEvent::REQUESTED_PRESENT>();
 
     mQueueOffset = (mQueueOffset + 1) % mFrames.size();
 }
@@ -453,6 +473,7 @@ void ConsumerFrameEventHistory::addRelease(uint64_t frameNumber,
     frame->addReleaseCalled = true;
     frame->dequeueReadyTime = dequeueReadyTime;
     frame->releaseFence = std::move(release);
+    mFramesDirty[mReleaseOffset].setDirty<FrameEvent::DEQUEUE_READY>();
     mFramesDirty[mReleaseOffset].setDirty<FrameEvent::RELEASE>();
 }
 
@@ -508,6 +529,14 @@ FrameEventsDelta::FrameEventsDelta(
       mFirstRefreshStartTime(frameTimestamps.firstRefreshStartTime),
       mLastRefreshStartTime(frameTimestamps.lastRefreshStartTime),
       mDequeueReadyTime(frameTimestamps.dequeueReadyTime) {
+    // Only send the timestamps that changed, the producer has the others.
+    for (auto [event, timestamp] : allTimestamps(this)) {
+        if (dirtyFields.isDirty(event)) {
+            mDirtyTimestamps |= eventBit(event);
+        } else {
+            *timestamp = FrameEvents::TIMESTAMP_PENDING;
+        }
+    }
     if (dirtyFields.isDirty<FrameEvent::GPU_COMPOSITION_DONE>()) {
         mGpuCompositionDoneFence =
                 frameTimestamps.gpuCompositionDoneFence->getSnapshot();
@@ -526,18 +555,14 @@ constexpr size_t FrameEventsDelta::minFlattenedSize() {
             sizeof(uint16_t) + // mIndex
             sizeof(uint8_t) + // mAddPostCompositeCalled
             sizeof(uint8_t) + // mAddReleaseCalled
-            sizeof(FrameEventsDelta::mPostedTime) +
-            sizeof(FrameEventsDelta::mRequestedPresentTime) +
-            sizeof(FrameEventsDelta::mLatchTime) +
-            sizeof(FrameEventsDelta::mFirstRefreshStartTime) +
-            sizeof(FrameEventsDelta::mLastRefreshStartTime) +
-            sizeof(FrameEventsDelta::mDequeueReadyTime);
+            sizeof(FrameEventsDelta::mDirtyTimestamps);
 }
 
 // Flattenable implementation
 size_t FrameEventsDelta::getFlattenedSize() const {
     auto fences = allFences(this);
     return minFlattenedSize() +
+            __builtin_popcount(mDirtyTimestamps) * sizeof(nsecs_t) +
             std::accumulate(fences.begin(), fences.end(), size_t(0),
                     [](size_t a, const FenceTime::Snapshot* fence) {
                             return a + fence->getFlattenedSize();
@@ -572,12 +597,14 @@ status_t FrameEventsDelta::flatten(void*& buffer, size_t& size, int*& fds,
     FlattenableUtils::write(
             buffer, size, static_cast<uint8_t>(mAddReleaseCalled));
 
-    FlattenableUtils::write(buffer, size, mPostedTime);
-    FlattenableUtils::write(buffer, size, mRequestedPresentTime);
-    FlattenableUtils::write(buffer, size, mLatchTime);
-    FlattenableUtils::write(buffer, size, mFirstRefreshStartTime);
-    FlattenableUtils::write(buffer, size, mLastRefreshStartTime);
-    FlattenableUtils::write(buffer, size, mDequeueReadyTime);
+    // Only the timestamps in mDirtyTimestamps follow, in the order of
+    // allTimestamps.
+    FlattenableUtils::write(buffer, size, mDirtyTimestamps);
+    for (auto [event, timestamp] : allTimestamps(this)) {
+        if (mDirtyTimestamps & eventBit(event)) {
+            FlattenableUtils::write(buffer, size, *timestamp);
+        }
+    }
 
     // Fences
     for (auto fence : allFences(this)) {
@@ -610,12 +637,20 @@ status_t FrameEventsDelta::unflatten(void const*& buffer, size_t& size,
     FlattenableUtils::read(buffer, size, temp8);
     mAddReleaseCalled = static_cast<bool>(temp8);
 
-    FlattenableUtils::read(buffer, size, mPostedTime);
-    FlattenableUtils::read(buffer, size, mRequestedPresentTime);
-    FlattenableUtils::read(buffer, size, mLatchTime);
-    FlattenableUtils::read(buffer, size, mFirstRefreshStartTime);
-    FlattenableUtils::read(buffer, size, mLastRefreshStartTime);
-    FlattenableUtils::read(buffer, size, mDequeueReadyTime);
+    FlattenableUtils::read(buffer, size, mDirtyTimestamps);
+    if (size < __builtin_popcount(mDirtyTimestamps) * sizeof(nsecs_t)) {
+        return NO_MEMORY;
+    }
+    uint32_t unknownTimestamps = mDirtyTimestamps;
+    for (auto [event, timestamp] : allTimestamps(this)) {
+        if (mDirtyTimestamps & eventBit(event)) {
+            FlattenableUtils::read(buffer, size, *timestamp);
+            unknownTimestamps &= ~eventBit(event);
+        }
+    }
+    if (unknownTimestamps != 0) {
+        return BAD_VALUE;
+    }
 
     // Fences
     for (auto fence : allFences(this)) {
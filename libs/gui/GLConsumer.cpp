@@ -189,21 +189,39 @@ status_t GLConsumer::updateTexImage() {
 
     BufferItem item;
 
-    // Acquire the next buffer.
-    // In asynchronous mode the list is guaranteed to be one buffer
-    // deep, while in synchronous mode we use the oldest buffer.
-    err = acquireBufferLocked(&item, 0);
-    if (err != NO_ERROR) {
-        if (err == BufferQueue::NO_BUFFER_AVAILABLE) {
-            // We always bind the texture even if we don't update its contents.
-            GLC_LOGV("updateTexImage: no buffers were available");
-            glBindTexture(mTexTarget, mTexName);
-            err = NO_ERROR;
-        } else {
-            GLC_LOGE("updateTexImage: acquire failed: %s (%d)",
-                strerror(-err), err);
+    if (mHasPendingBuffer) {
+        // Acquired by an earlier call, which kept the previous image.
+        item = mPendingBuffer;
+        mPendingBuffer = BufferItem();
+        mHasPendingBuffer = false;
+    } else {
+        // Acquire the next buffer.
+        // In asynchronous mode the list is guaranteed to be one buffer
+        // deep, while in synchronous mode we use the oldest buffer.
+        err = acquireBufferLocked(&item, 0);
+        if (err != NO_ERROR) {
+            if (err == BufferQueue::NO_BUFFER_AVAILABLE) {
+                // We always bind the texture even if we don't update its contents.
+                GLC_LOGV("updateTexImage: no buffers were available");
+                glBindTexture(mTexTarget, mTexName);
+                err = NO_ERROR;
+            } else {
+                GLC_LOGE("updateTexImage: acquire failed: %s (%d)",
+                    strerror(-err), err);
+            }
+            return err;
         }
-        return err;
+    }
+
+    if (mBindSignaledBuffersOnly && item.mFence->isValid() &&
+            item.mFence->getStatus() == Fence::Status::Unsignaled) {
+        // Keep the previous image rather than waiting for the producer.
+        GLC_LOGV("updateTexImage: buffer in slot %d not signaled yet", item.mSlot);
+        mPendingBuffer = item;
+        mHasPendingBuffer = true;
+        mDeferredUpdateCount++;
+        glBindTexture(mTexTarget, mTexName);
+        return NO_ERROR;
     }
 
     // Release the previous buffer.
@@ -803,6 +821,16 @@ uint64_t GLConsumer::getFrameNumber() {
     return mCurrentFrameNumber;
 }
 
+void GLConsumer::setBindSignaledBuffersOnly(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    mBindSignaledBuffersOnly = enabled;
+}
+
+uint64_t GLConsumer::getDeferredUpdateCount() {
+    Mutex::Autolock lock(mMutex);
+    return mDeferredUpdateCount;
+}
+
 sp<GraphicBuffer> GLConsumer::getCurrentBuffer(int* outSlot) const {
     Mutex::Autolock lock(mMutex);
 
@@ -907,6 +935,10 @@ void GLConsumer::freeBufferLocked(int slotIndex) {
     if (slotIndex == mCurrentTexture) {
         mCurrentTexture = BufferQueue::INVALID_BUFFER_SLOT;
     }
+    if (mHasPendingBuffer && slotIndex == mPendingBuffer.mSlot) {
+        mPendingBuffer = BufferItem();
+        mHasPendingBuffer = false;
+    }
     mEglSlots[slotIndex].mEglImage.clear();
     ConsumerBase::freeBufferLocked(slotIndex);
 }
@@ -925,10 +957,11 @@ void GLConsumer::dumpLocked(String8& result, const char* prefix) const
 {
     result.appendFormat(
        "%smTexName=%d mCurrentTexture=%d\n"
-       "%smCurrentCrop=[%d,%d,%d,%d] mCurrentTransform=%#x\n",
+       "%smCurrentCrop=[%d,%d,%d,%d] mCurrentTransform=%#x\n"
+       "%smBindSignaledBuffersOnly=%d mDeferredUpdateCount=%" PRIu64 "\n",
        prefix, mTexName, mCurrentTexture, prefix, mCurrentCrop.left,
        mCurrentCrop.top, mCurrentCrop.right, mCurrentCrop.bottom,
-       mCurrentTransform);
+       mCurrentTransform, prefix, mBindSignaledBuffersOnly, mDeferredUpdateCount);
 
     ConsumerBase::dumpLocked(result, prefix);
 }
@@ -29,7 +29,8 @@ namespace { // Anonymous
 enum class Tag : uint32_t {
     ON_TRANSACTION_COMPLETED = IBinder::FIRST_CALL_TRANSACTION,
     ON_RELEASE_BUFFER,
-    LAST = ON_RELEASE_BUFFER,
+    ON_BUFFER_EVICTED,
+    LAST = ON_BUFFER_EVICTED,
 };
 
 } // Anonymous namespace
@@ -261,6 +262,11 @@ public:
                                                                   transformHint,
                                                                   currentMaxAcquiredBufferCount);
     }
+
+    void onBufferEvicted(uint64_t cacheId) override {
+        callRemoteAsync<decltype(
+                &ITransactionCompletedListener::onBufferEvicted)>(Tag::ON_BUFFER_EVICTED, cacheId);
+    }
 };
 
 // Out-of-line virtual method definitions to trigger vtable emission in this translation unit (see
@@ -281,6 +287,8 @@ status_t BnTransactionCompletedListener::onTransact(uint32_t code, const Parcel&
                                   &ITransactionCompletedListener::onTransactionCompleted);
         case Tag::ON_RELEASE_BUFFER:
             return callLocalAsync(data, reply, &ITransactionCompletedListener::onReleaseBuffer);
+        case Tag::ON_BUFFER_EVICTED:
+            return callLocalAsync(data, reply, &ITransactionCompletedListener::onBufferEvicted);
     }
 }
 
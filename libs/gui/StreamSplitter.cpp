@@ -62,9 +62,8 @@ StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
 
 StreamSplitter::~StreamSplitter() {
     mInput->consumerDisconnect();
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
-        (*output)->disconnect(NATIVE_WINDOW_API_CPU);
+    for (const Output& output : mOutputs) {
+        output.queue->disconnect(NATIVE_WINDOW_API_CPU);
     }
 
     if (mBuffers.size() > 0) {
@@ -73,7 +72,7 @@ StreamSplitter::~StreamSplitter() {
 }
 
 status_t StreamSplitter::addOutput(
-        const sp<IGraphicBufferProducer>& outputQueue) {
+        const sp<IGraphicBufferProducer>& outputQueue, OutputPolicy policy) {
     if (outputQueue == nullptr) {
         ALOGE("addOutput: outputQueue must not be NULL");
         return BAD_VALUE;
@@ -91,7 +90,7 @@ status_t StreamSplitter::addOutput(
         return status;
     }
 
-    mOutputs.push_back(outputQueue);
+    mOutputs.push_back(Output{outputQueue, policy, /* heldBuffers */ 0});
 
     return NO_ERROR;
 }
@@ -103,44 +102,65 @@ void StreamSplitter::setName(const String8 &name) {
 
 void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
-
-    // The current policy is that if any one consumer is consuming buffers too
-    // slowly, the splitter will stall the rest of the outputs by not acquiring
-    // any more buffers from the input. This will cause back pressure on the
-    // input queue, slowing down its producer.
-
-    // If there are too many outstanding buffers, we block until a buffer is
-    // released back to the input in onBufferReleased
-    while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
-        mReleaseCondition.wait(mMutex);
-
-        // If the splitter is abandoned while we are waiting, the release
-        // condition variable will be broadcast, and we should just return
-        // without attempting to do anything more (since the input queue will
-        // also be abandoned).
-        if (mIsAbandoned) {
-            return;
+    BufferItem bufferItem;
+    std::vector<sp<IGraphicBufferProducer> > outputs;
+    {
+        Mutex::Autolock lock(mMutex);
+
+        // The current policy is that if any one lossless consumer is consuming
+        // buffers too slowly, the splitter will stall the rest of the outputs
+        // by not acquiring any more buffers from the input. This will cause
+        // back pressure on the input queue, slowing down its producer.
+
+        // If there are too many outstanding buffers, we block until a buffer
+        // is released back to the input in onBufferReleased
+        while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+            mReleaseCondition.wait(mMutex);
+
+            // If the splitter is abandoned while we are waiting, the release
+            // condition variable will be broadcast, and we should just return
+            // without attempting to do anything more (since the input queue
+            // will also be abandoned).
+            if (mIsAbandoned) {
+                return;
+            }
         }
-    }
-    ++mOutstandingBuffers;
+        ++mOutstandingBuffers;
 
-    // Acquire and detach the buffer from the input
-    BufferItem bufferItem;
-    status_t status = mInput->acquireBuffer(&bufferItem, /* presentWhen */ 0);
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "acquiring buffer from input failed (%d)", status);
+        // Acquire and detach the buffer from the input
+        status_t status = mInput->acquireBuffer(&bufferItem,
+                /* presentWhen */ 0);
+        LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+                "acquiring buffer from input failed (%d)", status);
 
-    ALOGV("acquired buffer %#" PRIx64 " from input",
-            bufferItem.mGraphicBuffer->getId());
+        ALOGV("acquired buffer %#" PRIx64 " from input",
+                bufferItem.mGraphicBuffer->getId());
 
-    status = mInput->detachBuffer(bufferItem.mSlot);
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "detaching buffer from input failed (%d)", status);
+        status = mInput->detachBuffer(bufferItem.mSlot);
+        LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+                "detaching buffer from input failed (%d)", status);
+
+        for (Output& output : mOutputs) {
+            if (output.policy == OutputPolicy::LATEST_ONLY &&
+                    output.heldBuffers > 0) {
+                ALOGV("skipping output %p for buffer %#" PRIx64,
+                        output.queue.get(), bufferItem.mGraphicBuffer->getId());
+                continue;
+            }
+            ++output.heldBuffers;
+            outputs.push_back(output.queue);
+        }
 
-    // Initialize our reference count for this buffer
-    mBuffers.add(bufferItem.mGraphicBuffer->getId(),
-            new BufferTracker(bufferItem.mGraphicBuffer));
+        // Initialize our reference count for this buffer
+        mBuffers.add(bufferItem.mGraphicBuffer->getId(),
+                new BufferTracker(bufferItem.mGraphicBuffer, outputs.size()));
+
+        if (outputs.empty()) {
+            // Every output is still busy with an earlier buffer
+            releaseBufferToInputLocked(bufferItem.mGraphicBuffer->getId());
+            return;
+        }
+    }
 
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
@@ -148,52 +168,50 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             static_cast<int32_t>(bufferItem.mScalingMode),
             bufferItem.mTransform, bufferItem.mFence);
 
-    // Attach and queue the buffer to each of the outputs
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
+    // Attach and queue the buffer to each of the outputs. This is done without
+    // holding mMutex, so that an output which is slow to take the buffer
+    // doesn't also hold up the buffers released by the other outputs.
+    for (const sp<IGraphicBufferProducer>& output : outputs) {
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
-        if (status == NO_INIT) {
-            // If we just discovered that this output has been abandoned, note
-            // that, increment the release count so that we still release this
-            // buffer eventually, and move on to the next output
-            onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
-            continue;
+        status_t status = output->attachBuffer(&slot,
+                bufferItem.mGraphicBuffer);
+        if (status == NO_ERROR) {
+            IGraphicBufferProducer::QueueBufferOutput queueOutput;
+            status = output->queueBuffer(slot, queueInput, &queueOutput);
+            LOG_ALWAYS_FATAL_IF(status != NO_ERROR && status != NO_INIT,
+                    "queueing buffer to output failed (%d)", status);
         } else {
-            LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+            LOG_ALWAYS_FATAL_IF(status != NO_INIT,
                     "attaching buffer to output failed (%d)", status);
         }
 
-        IGraphicBufferProducer::QueueBufferOutput queueOutput;
-        status = (*output)->queueBuffer(slot, queueInput, &queueOutput);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
-            // that, increment the release count so that we still release this
-            // buffer eventually, and move on to the next output
+            // that, count the buffer as released by this output so that we
+            // still release it eventually, and move on to the next output
+            Mutex::Autolock lock(mMutex);
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            onOutputReleasedBufferLocked(output,
+                    bufferItem.mGraphicBuffer->getId(), Fence::NO_FENCE);
             continue;
-        } else {
-            LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-                    "queueing buffer to output failed (%d)", status);
         }
 
         ALOGV("queued buffer %#" PRIx64 " to output %p",
-                bufferItem.mGraphicBuffer->getId(), output->get());
+                bufferItem.mGraphicBuffer->getId(), output.get());
     }
 }
 
 void StreamSplitter::onBufferReleasedByOutput(
         const sp<IGraphicBufferProducer>& from) {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
 
+    // The output may live in another process, so it is called before taking
+    // mMutex.
     sp<GraphicBuffer> buffer;
     sp<Fence> fence;
     status_t status = from->detachNextBuffer(&buffer, &fence);
+
+    Mutex::Autolock lock(mMutex);
     if (status == NO_INIT) {
         // If we just discovered that this output has been abandoned, note that,
         // but we can't do anything else, since buffer is invalid
@@ -207,7 +225,20 @@ void StreamSplitter::onBufferReleasedByOutput(
     ALOGV("detached buffer %#" PRIx64 " from output %p",
           buffer->getId(), from.get());
 
-    const sp<BufferTracker>& tracker = mBuffers.editValueFor(buffer->getId());
+    onOutputReleasedBufferLocked(from, buffer->getId(), fence);
+}
+
+void StreamSplitter::onOutputReleasedBufferLocked(
+        const sp<IGraphicBufferProducer>& from, uint64_t bufferId,
+        const sp<Fence>& fence) {
+    for (Output& output : mOutputs) {
+        if (output.queue == from && output.heldBuffers > 0) {
+            --output.heldBuffers;
+            break;
+        }
+    }
+
+    const sp<BufferTracker>& tracker = mBuffers.editValueFor(bufferId);
 
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
@@ -215,22 +246,28 @@ void StreamSplitter::onBufferReleasedByOutput(
 
     // Check to see if this is the last outstanding reference to this buffer
     size_t releaseCount = tracker->incrementReleaseCountLocked();
-    ALOGV("buffer %#" PRIx64 " reference count %zu (of %zu)", buffer->getId(),
-            releaseCount, mOutputs.size());
-    if (releaseCount < mOutputs.size()) {
+    ALOGV("buffer %#" PRIx64 " reference count %zu (of %zu)", bufferId,
+            releaseCount, tracker->getOutputCount());
+    if (releaseCount < tracker->getOutputCount()) {
         return;
     }
 
+    releaseBufferToInputLocked(bufferId);
+}
+
+void StreamSplitter::releaseBufferToInputLocked(uint64_t bufferId) {
     // If we've been abandoned, we can't return the buffer to the input, so just
     // stop tracking it and move on
     if (mIsAbandoned) {
-        mBuffers.removeItem(buffer->getId());
+        mBuffers.removeItem(bufferId);
         return;
     }
 
+    const sp<BufferTracker> tracker = mBuffers.valueFor(bufferId);
+
     // Attach and release the buffer back to the input
     int consumerSlot;
-    status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
+    status_t status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "attaching buffer to input failed (%d)", status);
 
@@ -239,11 +276,11 @@ void StreamSplitter::onBufferReleasedByOutput(
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "releasing buffer to input failed (%d)", status);
 
-    ALOGV("released buffer %#" PRIx64 " to input", buffer->getId());
+    ALOGV("released buffer %#" PRIx64 " to input", bufferId);
 
     // We no longer need to track the buffer once it has been returned to the
     // input
-    mBuffers.removeItem(buffer->getId());
+    mBuffers.removeItem(bufferId);
 
     // Notify any waiting onFrameAvailable calls
     --mOutstandingBuffers;
@@ -275,8 +312,10 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
     mSplitter->onAbandonedLocked();
 }
 
-StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer,
+        size_t outputCount)
+      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE),
+        mOutputCount(outputCount), mReleaseCount(0) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
@@ -119,6 +119,8 @@ Surface::~Surface() {
     if (mConnectedToCpu) {
         Surface::disconnect(NATIVE_WINDOW_API_CPU);
     }
+    Mutex::Autolock lock(mMutex);
+    cancelPrefetchedBufferLocked();
 }
 
 sp<ISurfaceComposer> Surface::composerService() const {
@@ -187,6 +189,7 @@ status_t Surface::getDisplayRefreshCycleDuration(nsecs_t* outRefreshDuration) {
 
 void Surface::enableFrameTimestamps(bool enable) {
     Mutex::Autolock lock(mMutex);
+    Mutex::Autolock historyLock(mFrameEventHistoryMutex);
     // If going from disabled to enabled, get the initial values for
     // compositor and display timing.
     if (!mEnableFrameTimestamps && enable) {
@@ -200,7 +203,7 @@ void Surface::enableFrameTimestamps(bool enable) {
 status_t Surface::getCompositorTiming(
         nsecs_t* compositeDeadline, nsecs_t* compositeInterval,
         nsecs_t* compositeToPresentLatency) {
-    Mutex::Autolock lock(mMutex);
+    Mutex::Autolock lock(mFrameEventHistoryMutex);
     if (!mEnableFrameTimestamps) {
         return INVALID_OPERATION;
     }
@@ -285,7 +288,9 @@ status_t Surface::getFrameTimestamps(uint64_t frameNumber,
         nsecs_t* outReleaseTime) {
     ATRACE_CALL();
 
-    Mutex::Autolock lock(mMutex);
+    // Only the frame event history is needed, so don't wait for a dequeue or
+    // queue in progress.
+    Mutex::Autolock lock(mFrameEventHistoryMutex);
 
     if (!mEnableFrameTimestamps) {
         return INVALID_OPERATION;
@@ -615,6 +620,121 @@ private:
     std::mutex mMutex;
 };
 
+class Surface::DequeuePrefetcher {
+public:
+    using DequeueBufferInput = IGraphicBufferProducer::DequeueBufferInput;
+    using DequeueBufferOutput = IGraphicBufferProducer::DequeueBufferOutput;
+
+    explicit DequeuePrefetcher(const sp<IGraphicBufferProducer>& producer)
+          : mProducer(producer), mThread(&DequeuePrefetcher::loop, this) {}
+
+    ~DequeuePrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    // Starts dequeuing a buffer with the given input, unless a buffer is
+    // already prefetched or being prefetched.
+    void prefetch(const DequeueBufferInput& input) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mRequest || mBusy || mOutput) {
+                return;
+            }
+            mRequest = input;
+        }
+        mCondition.notify_all();
+    }
+
+    // Waits for the buffer being prefetched, if any, and takes it along with
+    // the input it was dequeued with. Returns false if there is no buffer.
+    bool take(DequeueBufferInput* outInput, DequeueBufferOutput* outOutput) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return !mRequest && !mBusy; });
+        if (!mOutput) {
+            return false;
+        }
+        *outInput = mInput;
+        *outOutput = std::move(*mOutput);
+        mOutput.reset();
+        return true;
+    }
+
+private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mCondition.wait(lock, [this] { return mRequest || mStopping; });
+            if (mStopping) {
+                return;
+            }
+            mInput = *mRequest;
+            mRequest.reset();
+            mBusy = true;
+            lock.unlock();
+
+            ATRACE_NAME("Surface::DequeuePrefetcher::dequeue");
+            std::vector<DequeueBufferOutput> outputs;
+            status_t result = mProducer->dequeueBuffers({mInput}, &outputs);
+
+            lock.lock();
+            mBusy = false;
+            if (result == NO_ERROR && outputs.size() == 1 && outputs[0].result >= 0) {
+                mOutput = std::move(outputs[0]);
+            }
+            mCondition.notify_all();
+        }
+    }
+
+    const sp<IGraphicBufferProducer> mProducer;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::optional<DequeueBufferInput> mRequest;
+    bool mBusy = false;
+    bool mStopping = false;
+    DequeueBufferInput mInput;
+    std::optional<DequeueBufferOutput> mOutput;
+
+    // Last, so that it starts after everything it uses is constructed.
+    std::thread mThread;
+};
+
+void Surface::setDequeuePrefetch(bool enable) {
+    Mutex::Autolock lock(mMutex);
+    if (enable && !mDequeuePrefetcher) {
+        mDequeuePrefetcher = std::make_unique<DequeuePrefetcher>(mGraphicBufferProducer);
+    }
+    if (!enable) {
+        cancelPrefetchedBufferLocked();
+    }
+    mDequeuePrefetchEnabled = enable;
+}
+
+void Surface::prefetchNextBufferLocked() {
+    if (!mDequeuePrefetchEnabled || mSharedBufferMode || !mDequeuedSlots.empty()) {
+        return;
+    }
+    IGraphicBufferProducer::DequeueBufferInput input;
+    getDequeueBufferInputLocked(&input);
+    mDequeuePrefetcher->prefetch(input);
+}
+
+void Surface::cancelPrefetchedBufferLocked(bool producerConnected) {
+    if (!mDequeuePrefetcher) {
+        return;
+    }
+    IGraphicBufferProducer::DequeueBufferInput input;
+    IGraphicBufferProducer::DequeueBufferOutput output;
+    if (mDequeuePrefetcher->take(&input, &output) && producerConnected) {
+        mGraphicBufferProducer->cancelBuffer(output.slot, output.fence);
+    }
+}
+
 void Surface::getDequeueBufferInputLocked(
         IGraphicBufferProducer::DequeueBufferInput* dequeueInput) {
     LOG_ALWAYS_FATAL_IF(dequeueInput == nullptr, "input is null");
@@ -633,6 +753,7 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     ALOGV("Surface::dequeueBuffer");
 
     IGraphicBufferProducer::DequeueBufferInput dqInput;
+    DequeuePrefetcher* prefetcher = nullptr;
     {
         Mutex::Autolock lock(mMutex);
         if (mReportRemovedBuffers) {
@@ -650,6 +771,8 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
                 return OK;
             }
         }
+
+        prefetcher = mDequeuePrefetcher.get();
     } // Drop the lock so that we can still touch the Surface while blocking in IGBP::dequeueBuffer
 
     int buf = -1;
@@ -657,11 +780,31 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     nsecs_t startTime = systemTime();
 
     FrameEventHistoryDelta frameTimestamps;
-    status_t result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width,
-                                                            dqInput.height, dqInput.format,
-                                                            dqInput.usage, &mBufferAge,
-                                                            dqInput.getTimestamps ?
-                                                                    &frameTimestamps : nullptr);
+    status_t result;
+    IGraphicBufferProducer::DequeueBufferInput prefetchedInput;
+    IGraphicBufferProducer::DequeueBufferOutput prefetched;
+    if (prefetcher && prefetcher->take(&prefetchedInput, &prefetched) &&
+        prefetchedInput.width == dqInput.width && prefetchedInput.height == dqInput.height &&
+        prefetchedInput.format == dqInput.format && prefetchedInput.usage == dqInput.usage &&
+        prefetchedInput.getTimestamps == dqInput.getTimestamps) {
+        buf = prefetched.slot;
+        fence = prefetched.fence;
+        result = prefetched.result;
+        mBufferAge = prefetched.bufferAge;
+        if (prefetched.timestamps.has_value()) {
+            frameTimestamps = std::move(*prefetched.timestamps);
+        }
+    } else {
+        if (prefetched.slot >= 0) {
+            // The surface was resized or reconfigured since the buffer was prefetched.
+            mGraphicBufferProducer->cancelBuffer(prefetched.slot, prefetched.fence);
+        }
+        result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width,
+                                                       dqInput.height, dqInput.format,
+                                                       dqInput.usage, &mBufferAge,
+                                                       dqInput.getTimestamps ? &frameTimestamps
+                                                                             : nullptr);
+    }
     mLastDequeueDuration = systemTime() - startTime;
 
     if (result < 0) {
@@ -697,7 +840,8 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     }
 
     if (dqInput.getTimestamps) {
-         mFrameEventHistory->applyDelta(frameTimestamps);
+        Mutex::Autolock historyLock(mFrameEventHistoryMutex);
+        mFrameEventHistory->applyDelta(frameTimestamps);
     }
 
     if ((result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) || gbuf == nullptr) {
@@ -769,6 +913,7 @@ int Surface::dequeueBuffers(std::vector<BatchBuffer>* buffers) {
         }
 
         getDequeueBufferInputLocked(&input);
+        cancelPrefetchedBufferLocked();
     } // Drop the lock so that we can still touch the Surface while blocking in IGBP::dequeueBuffers
 
     std::vector<DequeueBufferInput> dequeueInput(numBufferRequested, input);
@@ -888,7 +1033,8 @@ int Surface::dequeueBuffers(std::vector<BatchBuffer>* buffers) {
         }
 
         if (input.getTimestamps) {
-             mFrameEventHistory->applyDelta(output.timestamps.value());
+            Mutex::Autolock historyLock(mFrameEventHistoryMutex);
+            mFrameEventHistory->applyDelta(output.timestamps.value());
         }
 
         if (output.fence->isValid()) {
@@ -1100,21 +1246,24 @@ void Surface::onBufferQueuedLocked(int slot, sp<Fence> fence,
         const IGraphicBufferProducer::QueueBufferOutput& output) {
     mDequeuedSlots.erase(slot);
 
-    if (mEnableFrameTimestamps) {
-        mFrameEventHistory->applyDelta(output.frameTimestamps);
-        // Update timestamps with the local acquire fence.
-        // The consumer doesn't send it back to prevent us from having two
-        // file descriptors of the same fence.
-        mFrameEventHistory->updateAcquireFence(mNextFrameNumber,
-                std::make_shared<FenceTime>(fence));
+    { // scope for the frame event history lock
+        Mutex::Autolock historyLock(mFrameEventHistoryMutex);
+        if (mEnableFrameTimestamps) {
+            mFrameEventHistory->applyDelta(output.frameTimestamps);
+            // Update timestamps with the local acquire fence.
+            // The consumer doesn't send it back to prevent us from having two
+            // file descriptors of the same fence.
+            mFrameEventHistory->updateAcquireFence(mNextFrameNumber,
+                    std::make_shared<FenceTime>(fence));
+
+            // Cache timestamps of signaled fences so we can close their file
+            // descriptors.
+            mFrameEventHistory->updateSignalTimes();
+        }
 
-        // Cache timestamps of signaled fences so we can close their file
-        // descriptors.
-        mFrameEventHistory->updateSignalTimes();
+        mLastFrameNumber = mNextFrameNumber;
     }
 
-    mLastFrameNumber = mNextFrameNumber;
-
     mDefaultWidth = output.width;
     mDefaultHeight = output.height;
     mNextFrameNumber = output.nextFrameNumber;
@@ -1176,6 +1325,9 @@ int Surface::queueBuffer(android_native_buffer_t* buffer, int fenceFd) {
     }
 
     onBufferQueuedLocked(i, fence, output);
+    if (err == OK) {
+        prefetchNextBufferLocked();
+    }
     return err;
 }
 
@@ -1230,7 +1382,7 @@ int Surface::queueBuffers(const std::vector<BatchQueuedBuffer>& buffers) {
 }
 
 void Surface::querySupportedTimestampsLocked() const {
-    // mMutex must be locked when calling this method.
+    // mFrameEventHistoryMutex must be locked when calling this method.
 
     if (mQueriedSupportedTimestamps) {
         return;
@@ -1329,6 +1481,7 @@ int Surface::query(int what, int* value) const {
                 return NO_ERROR;
             }
             case NATIVE_WINDOW_FRAME_TIMESTAMPS_SUPPORTS_PRESENT: {
+                Mutex::Autolock historyLock(mFrameEventHistoryMutex);
                 querySupportedTimestampsLocked();
                 *value = mFrameTimestampsSupportsPresent ? 1 : 0;
                 return NO_ERROR;
@@ -1918,6 +2071,8 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
     mSharedBufferHasBeenQueued = false;
     freeAllBuffers();
     int err = mGraphicBufferProducer->disconnect(api, mode);
+    // Disconnecting wakes up a prefetch blocked in the producer, and frees the prefetched buffer.
+    cancelPrefetchedBufferLocked(/*producerConnected*/ err != NO_ERROR);
     if (!err) {
         mReqFormat = 0;
         mReqWidth = 0;
@@ -1928,7 +2083,10 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
         mTransform = 0;
         mStickyTransform = 0;
         mAutoPrerotation = false;
-        mEnableFrameTimestamps = false;
+        {
+            Mutex::Autolock historyLock(mFrameEventHistoryMutex);
+            mEnableFrameTimestamps = false;
+        }
         mMaxBufferCount = NUM_BUFFER_SLOTS;
 
         if (api == NATIVE_WINDOW_API_CPU) {
@@ -2044,6 +2202,8 @@ int Surface::setBufferCount(int bufferCount)
     ATRACE_CALL();
     ALOGV("Surface::setBufferCount");
     Mutex::Autolock lock(mMutex);
+    // The producer would count a prefetched buffer as dequeued.
+    cancelPrefetchedBufferLocked();
 
     status_t err = NO_ERROR;
     if (bufferCount == 0) {
@@ -2068,6 +2228,7 @@ int Surface::setMaxDequeuedBufferCount(int maxDequeuedBuffers) {
     ATRACE_CALL();
     ALOGV("Surface::setMaxDequeuedBufferCount");
     Mutex::Autolock lock(mMutex);
+    cancelPrefetchedBufferLocked();
 
     status_t err = mGraphicBufferProducer->setMaxDequeuedBufferCount(
             maxDequeuedBuffers);
@@ -2081,6 +2242,7 @@ int Surface::setAsyncMode(bool async) {
     ATRACE_CALL();
     ALOGV("Surface::setAsyncMode");
     Mutex::Autolock lock(mMutex);
+    cancelPrefetchedBufferLocked();
 
     status_t err = mGraphicBufferProducer->setAsyncMode(async);
     ALOGE_IF(err, "IGraphicBufferProducer::setAsyncMode(%d) returned %s",
@@ -2093,6 +2255,7 @@ int Surface::setSharedBufferMode(bool sharedBufferMode) {
     ATRACE_CALL();
     ALOGV("Surface::setSharedBufferMode (%d)", sharedBufferMode);
     Mutex::Autolock lock(mMutex);
+    cancelPrefetchedBufferLocked();
 
     status_t err = mGraphicBufferProducer->setSharedBufferMode(
             sharedBufferMode);
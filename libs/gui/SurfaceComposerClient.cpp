@@ -49,8 +49,9 @@
 
 #include <private/gui/ComposerService.h>
 
-// This server size should always be smaller than the server cache size
-#define BUFFER_CACHE_MAX_SIZE 64
+// These limits should always be lower than the ones of the server cache, in ClientCache.h
+#define BUFFER_CACHE_MAX_SIZE 256
+#define BUFFER_CACHE_MAX_BYTES (256 * 1024 * 1024)
 
 namespace android {
 
@@ -413,9 +414,12 @@ void removeDeadBufferCallback(void* /*context*/, uint64_t graphicBufferId);
  * A few details about lifetime:
  *     1. The cache evicts by LRU. The server side cache is keyed by BufferCache::getToken
  *        which is per process Unique. The server side cache is larger than the client side
- *        cache so that the server will never evict entries before the client.
+ *        cache so that the server will never evict entries before the client. Both caches
+ *        are bounded by a number of buffers and by their size, as counted by
+ *        clientCacheBufferSize.
  *     2. When the client evicts an entry it notifies the server via an uncacheBuffer
- *        transaction.
+ *        transaction. Should the server evict an entry anyway, it notifies the client via
+ *        ITransactionCompletedListener::onBufferEvicted.
  *     3. The client only references the Buffers by ID, and uses buffer->addDeathCallback
  *        to auto-evict destroyed buffers.
  */
@@ -434,7 +438,7 @@ public:
         if (itr == mBuffers.end()) {
             return BAD_VALUE;
         }
-        itr->second = getCounter();
+        itr->second.counter = getCounter();
         *cacheId = buffer->getId();
         return NO_ERROR;
     }
@@ -442,13 +446,17 @@ public:
     uint64_t cache(const sp<GraphicBuffer>& buffer) {
         std::lock_guard<std::mutex> lock(mMutex);
 
-        if (mBuffers.size() >= BUFFER_CACHE_MAX_SIZE) {
+        const size_t size = clientCacheBufferSize(buffer);
+        while (!mBuffers.empty() &&
+               (mBuffers.size() >= BUFFER_CACHE_MAX_SIZE ||
+                mBytes + size > BUFFER_CACHE_MAX_BYTES)) {
             evictLeastRecentlyUsedBuffer();
         }
 
         buffer->addDeathCallback(removeDeadBufferCallback, nullptr);
 
-        mBuffers[buffer->getId()] = getCounter();
+        mBuffers[buffer->getId()] = {getCounter(), size};
+        mBytes += size;
         return buffer->getId();
     }
 
@@ -458,19 +466,38 @@ public:
     }
 
     void uncacheLocked(uint64_t cacheId) REQUIRES(mMutex) {
-        mBuffers.erase(cacheId);
+        forgetLocked(cacheId);
         SurfaceComposerClient::doUncacheBufferTransaction(cacheId);
     }
 
+    // Called when the server has evicted the buffer on its own, so there is nothing to uncache.
+    void evicted(uint64_t cacheId) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        forgetLocked(cacheId);
+    }
+
 private:
+    struct CachedBuffer {
+        uint64_t counter;
+        size_t size;
+    };
+
+    void forgetLocked(uint64_t cacheId) REQUIRES(mMutex) {
+        auto itr = mBuffers.find(cacheId);
+        if (itr != mBuffers.end()) {
+            mBytes -= itr->second.size;
+            mBuffers.erase(itr);
+        }
+    }
+
     void evictLeastRecentlyUsedBuffer() REQUIRES(mMutex) {
         auto itr = mBuffers.begin();
-        uint64_t minCounter = itr->second;
+        uint64_t minCounter = itr->second.counter;
         auto minBuffer = itr;
         itr++;
 
         while (itr != mBuffers.end()) {
-            uint64_t counter = itr->second;
+            uint64_t counter = itr->second.counter;
             if (counter < minCounter) {
                 minCounter = counter;
                 minBuffer = itr;
@@ -486,7 +513,8 @@ private:
     }
 
     std::mutex mMutex;
-    std::map<uint64_t /*Cache id*/, uint64_t /*counter*/> mBuffers GUARDED_BY(mMutex);
+    std::unordered_map<uint64_t /*Cache id*/, CachedBuffer> mBuffers GUARDED_BY(mMutex);
+    size_t mBytes GUARDED_BY(mMutex) = 0;
 
     // Used by ISurfaceComposer to identify which process is sending the cached buffer.
     sp<IBinder> token;
@@ -499,6 +527,10 @@ void removeDeadBufferCallback(void* /*context*/, uint64_t graphicBufferId) {
     BufferCache::getInstance().uncache(graphicBufferId);
 }
 
+void TransactionCompletedListener::onBufferEvicted(uint64_t cacheId) {
+    BufferCache::getInstance().evicted(cacheId);
+}
+
 // ---------------------------------------------------------------------------
 
 // Initialize transaction id counter used to generate transaction ids
@@ -612,7 +644,7 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
             return BAD_VALUE;
         }
 
-        composerStates[surfaceControlHandle] = composerState;
+        composerStates[surfaceControlHandle] = std::move(composerState);
     }
 
     InputWindowCommands inputWindowCommands;
@@ -628,10 +660,10 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     mDesiredPresentTime = desiredPresentTime;
     mIsAutoTimestamp = isAutoTimestamp;
     mFrameTimelineInfo = frameTimelineInfo;
-    mDisplayStates = displayStates;
-    mListenerCallbacks = listenerCallbacks;
-    mComposerStates = composerStates;
-    mInputWindowCommands = inputWindowCommands;
+    mDisplayStates = std::move(displayStates);
+    mListenerCallbacks = std::move(listenerCallbacks);
+    mComposerStates = std::move(composerStates);
+    mInputWindowCommands = std::move(inputWindowCommands);
     mApplyToken = applyToken;
     return NO_ERROR;
 }
@@ -673,7 +705,7 @@ status_t SurfaceComposerClient::Transaction::writeToParcel(Parcel* parcel) const
             parcel->writeParcelable(callbackId);
         }
         parcel->writeUint32(static_cast<uint32_t>(callbackInfo.surfaceControls.size()));
-        for (auto surfaceControl : callbackInfo.surfaceControls) {
+        for (const auto& surfaceControl : callbackInfo.surfaceControls) {
             SAFE_PARCEL(surfaceControl->writeToParcel, *parcel);
         }
     }
@@ -689,11 +721,11 @@ status_t SurfaceComposerClient::Transaction::writeToParcel(Parcel* parcel) const
 }
 
 SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Transaction&& other) {
-    for (auto const& [handle, composerState] : other.mComposerStates) {
-        if (mComposerStates.count(handle) == 0) {
-            mComposerStates[handle] = composerState;
-        } else {
-            mComposerStates[handle].state.merge(composerState.state);
+    for (auto& [handle, composerState] : other.mComposerStates) {
+        // other is cleared below, so the states this transaction doesn't have yet are moved over.
+        const auto [it, inserted] = mComposerStates.try_emplace(handle, std::move(composerState));
+        if (!inserted) {
+            it->second.state.merge(composerState.state);
         }
     }
 
@@ -706,14 +738,14 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
         }
     }
 
-    for (const auto& [listener, callbackInfo] : other.mListenerCallbacks) {
+    for (auto& [listener, callbackInfo] : other.mListenerCallbacks) {
         auto& [callbackIds, surfaceControls] = callbackInfo;
-        mListenerCallbacks[listener].callbackIds.insert(std::make_move_iterator(
-                                                                callbackIds.begin()),
-                                                        std::make_move_iterator(callbackIds.end()));
+        auto& listenerCallbackInfo = mListenerCallbacks[listener];
+        listenerCallbackInfo.callbackIds.insert(std::make_move_iterator(callbackIds.begin()),
+                                                std::make_move_iterator(callbackIds.end()));
 
-        mListenerCallbacks[listener].surfaceControls.insert(surfaceControls.begin(),
-                                                            surfaceControls.end());
+        listenerCallbackInfo.surfaceControls.insert(surfaceControls.begin(),
+                                                    surfaceControls.end());
 
         auto& currentProcessCallbackInfo =
                 mListenerCallbacks[TransactionCompletedListener::getIInstance()];
@@ -778,7 +810,7 @@ void SurfaceComposerClient::Transaction::cacheBuffers() {
 
     size_t count = 0;
     for (auto& [handle, cs] : mComposerStates) {
-        layer_state_t* s = &(mComposerStates[handle].state);
+        layer_state_t* s = &cs.state;
         if (!(s->what & layer_state_t::eBufferChanged)) {
             continue;
         } else if (s->what & layer_state_t::eCachedBufferChanged) {
@@ -859,6 +891,7 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous) {
 
     mForceSynchronous |= synchronous;
 
+    composerStates.setCapacity(mComposerStates.size());
     for (auto const& kv : mComposerStates){
         composerStates.add(kv.second);
     }
@@ -940,17 +973,14 @@ void SurfaceComposerClient::Transaction::setEarlyWakeupEnd() {
 layer_state_t* SurfaceComposerClient::Transaction::getLayerState(const sp<SurfaceControl>& sc) {
     auto handle = sc->getLayerStateHandle();
 
-    if (mComposerStates.count(handle) == 0) {
-        // we don't have it, add an initialized layer_state to our list
-        ComposerState s;
-
-        s.state.surface = handle;
-        s.state.layerId = sc->getLayerId();
-
-        mComposerStates[handle] = s;
+    const auto [it, inserted] = mComposerStates.try_emplace(handle);
+    if (inserted) {
+        // we didn't have it, initialize the layer_state added to our list
+        it->second.state.surface = handle;
+        it->second.state.layerId = sc->getLayerId();
     }
 
-    return &(mComposerStates[handle].state);
+    return &it->second.state;
 }
 
 void SurfaceComposerClient::Transaction::registerSurfaceControlForCallback(
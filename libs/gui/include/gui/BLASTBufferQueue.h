@@ -27,6 +27,7 @@
 #include <utils/RefBase.h>
 
 #include <system/window.h>
+#include <optional>
 #include <thread>
 #include <queue>
 
@@ -105,6 +106,12 @@ public:
 
     void setSidebandStream(const sp<NativeHandle>& stream);
 
+    // While enabled, buffers queued after a buffer was sent to SurfaceFlinger are held until
+    // that buffer is presented, and only the latest of them is sent then. The skipped buffers are
+    // released right away. Buffers with a desired present time are never skipped. This is meant
+    // for producers that queue faster than the display refreshes.
+    void setBufferCoalescing(bool enabled);
+
     uint32_t getLastTransformHint() const;
 
     virtual ~BLASTBufferQueue();
@@ -123,6 +130,10 @@ private:
     // Return true if we need to reject the buffer based on the scaling mode and the buffer size.
     bool rejectBuffer(const BufferItem& item) REQUIRES(mMutex);
     bool maxBuffersAcquired(bool includeExtraAcquire) const REQUIRES(mMutex);
+    // Replaces bufferItem with the latest buffer queued while coalescing buffers, releasing the
+    // ones it skips.
+    void skipToLatestBufferLocked(BufferItem* bufferItem) REQUIRES(mMutex);
+    void onBufferPresentedLocked(uint64_t frameNumber) REQUIRES(mMutex);
     static PixelFormat convertBufferFormat(PixelFormat& format);
 
     std::string mName;
@@ -232,6 +243,13 @@ private:
     // Keep track of SurfaceControls that have submitted a transaction and BBQ is waiting on a
     // callback for them.
     std::queue<sp<SurfaceControl>> mSurfaceControlsWithPendingCallback GUARDED_BY(mMutex);
+
+    // See setBufferCoalescing.
+    bool mCoalesceBuffers GUARDED_BY(mMutex) = false;
+    // The frame number of the last buffer this adapter sent to SurfaceFlinger, while coalescing
+    // buffers, until it is presented or released.
+    std::optional<uint64_t> mInFlightFrameNumber GUARDED_BY(mMutex);
+    uint64_t mSkippedBuffers GUARDED_BY(mMutex) = 0;
 };
 
 } // namespace android
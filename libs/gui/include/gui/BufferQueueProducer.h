@@ -17,7 +17,9 @@
 #ifndef ANDROID_GUI_BUFFERQUEUEPRODUCER_H
 #define ANDROID_GUI_BUFFERQUEUEPRODUCER_H
 
+#include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
+#include <gui/IConsumerListener.h>
 #include <gui/IGraphicBufferProducer.h>
 
 namespace android {
@@ -45,6 +47,11 @@ public:
     // flags indicating that previously-returned buffers are no longer valid.
     virtual status_t requestBuffer(int slot, sp<GraphicBuffer>* buf);
 
+    // See IGraphicBufferProducer::requestBuffers. All of the buffers are
+    // requested with mCore->mMutex held once.
+    virtual status_t requestBuffers(const std::vector<int32_t>& slots,
+            std::vector<RequestBufferOutput>* outputs) override;
+
     // see IGraphicsBufferProducer::setMaxDequeuedBufferCount
     virtual status_t setMaxDequeuedBufferCount(int maxDequeuedBuffers);
 
@@ -119,6 +126,11 @@ public:
     virtual status_t queueBuffer(int slot,
             const QueueBufferInput& input, QueueBufferOutput* output);
 
+    // See IGraphicBufferProducer::queueBuffers. All of the buffers are queued
+    // with mCore->mMutex held once.
+    virtual status_t queueBuffers(const std::vector<QueueBufferInput>& inputs,
+            std::vector<QueueBufferOutput>* outputs) override;
+
     // cancelBuffer returns a dequeued buffer to the BufferQueue, but doesn't
     // queue it for use by the consumer.
     //
@@ -126,6 +138,11 @@ public:
     // will usually be the one obtained from dequeueBuffer.
     virtual status_t cancelBuffer(int slot, const sp<Fence>& fence);
 
+    // See IGraphicBufferProducer::cancelBuffers. All of the buffers are
+    // cancelled with mCore->mMutex held once.
+    virtual status_t cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+            std::vector<status_t>* results) override;
+
     // Query native window attributes.  The "what" values are enumerated in
     // window.h (e.g. NATIVE_WINDOW_FORMAT).
     virtual int query(int what, int* outValue);
@@ -214,6 +231,34 @@ private:
     // BufferQueueCore::INVALID_BUFFER_SLOT otherwise
     int getFreeSlotLocked() const;
 
+    // The parts of requestBuffer and cancelBuffer that run with mCore->mMutex
+    // held.
+    status_t requestBufferLocked(int slot, sp<GraphicBuffer>* buf);
+    status_t cancelBufferLocked(int slot, const sp<Fence>& fence);
+
+    // A frame queued by queueBufferLocked, to be passed to the consumer by
+    // onFrameQueued.
+    struct QueuedFrame {
+        BufferItem item;
+        sp<IConsumerListener> frameAvailableListener;
+        sp<IConsumerListener> frameReplacedListener;
+        int callbackTicket = 0;
+        int64_t requestedPresentTimestamp = 0;
+        std::shared_ptr<FenceTime> acquireFenceTime;
+        sp<Fence> acquireFence;
+        bool getFrameTimestamps = false;
+    };
+
+    // The part of queueBuffer that runs with mCore->mMutex held. It fills in
+    // outFrame on success.
+    status_t queueBufferLocked(int slot, const QueueBufferInput& input,
+            QueueBufferOutput* output, QueuedFrame* outFrame);
+
+    // The part of queueBuffer that runs without mCore->mMutex held. It calls
+    // the consumer back in the order the frames were queued, and throttles
+    // EGL producers.
+    void onFrameQueued(QueuedFrame& frame, QueueBufferOutput* output);
+
     void addAndGetFrameTimestamps(const NewFrameEventsEntry* newTimestamps,
             FrameEventHistoryDelta* outDelta);
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERSLOTSET_H
+#define ANDROID_GUI_BUFFERSLOTSET_H
+
+#include <ui/BufferQueueDefs.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace android {
+
+static_assert(BufferQueueDefs::NUM_BUFFER_SLOTS <= 64,
+              "Buffer slot sets are backed by a 64-bit mask");
+
+// A set of buffer slots, iterated in ascending slot order like std::set<int>.
+// It is backed by a bit mask, so that it never allocates and all of its
+// operations take constant time.
+class BufferSlotSet {
+public:
+    // Iterates over a snapshot of the set, so the set may be modified while
+    // it is iterated.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+
+        int operator*() const { return __builtin_ctzll(mSlots); }
+        const_iterator& operator++() {
+            mSlots &= mSlots - 1;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator& other) const { return mSlots == other.mSlots; }
+        bool operator!=(const const_iterator& other) const { return mSlots != other.mSlots; }
+
+    private:
+        friend class BufferSlotSet;
+        explicit const_iterator(uint64_t slots) : mSlots(slots) {}
+
+        uint64_t mSlots = 0;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(mSlots); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return mSlots == 0; }
+    size_t size() const { return static_cast<size_t>(__builtin_popcountll(mSlots)); }
+    size_t count(int slot) const { return (mSlots & mask(slot)) ? 1 : 0; }
+
+    void insert(int slot) { mSlots |= mask(slot); }
+    void erase(int slot) { mSlots &= ~mask(slot); }
+    void erase(const_iterator it) { erase(*it); }
+    void clear() { mSlots = 0; }
+
+private:
+    static uint64_t mask(int slot) { return uint64_t(1) << slot; }
+
+    uint64_t mSlots = 0;
+};
+
+// An ordered list of distinct buffer slots, with the interface of the
+// std::list<int> it replaces. The order is kept by links between the slots in
+// inline arrays, so that it never allocates, and adding or removing a slot at
+// either end or anywhere in the list takes constant time.
+class BufferSlotList {
+public:
+    // Iterates over the list in order. The list must not be modified while it
+    // is iterated.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+
+        int operator*() const { return mSlot; }
+        const_iterator& operator++() {
+            mSlot = mList->mNext[mSlot];
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator& other) const { return mSlot == other.mSlot; }
+        bool operator!=(const const_iterator& other) const { return mSlot != other.mSlot; }
+
+    private:
+        friend class BufferSlotList;
+        const_iterator(const BufferSlotList* list, int slot) : mList(list), mSlot(slot) {}
+
+        const BufferSlotList* mList = nullptr;
+        int mSlot = kNone;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(this, mFront); }
+    const_iterator end() const { return const_iterator(this, kNone); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return mSlots.empty(); }
+    size_t size() const { return mSlots.size(); }
+    size_t count(int slot) const { return mSlots.count(slot); }
+
+    int front() const { return mFront; }
+    int back() const { return mBack; }
+
+    // A slot already in the list is moved to the requested end.
+    void push_front(int slot) {
+        remove(slot);
+        link(slot, kNone, mFront);
+    }
+    void push_back(int slot) {
+        remove(slot);
+        link(slot, mBack, kNone);
+    }
+    void pop_front() { remove(mFront); }
+    void pop_back() { remove(mBack); }
+
+    void remove(int slot) {
+        if (!mSlots.count(slot)) {
+            return;
+        }
+        const int8_t prev = mPrev[slot];
+        const int8_t next = mNext[slot];
+        (prev == kNone ? mFront : mNext[prev]) = next;
+        (next == kNone ? mBack : mPrev[next]) = prev;
+        mSlots.erase(slot);
+    }
+
+    void clear() {
+        mSlots.clear();
+        mFront = kNone;
+        mBack = kNone;
+    }
+
+private:
+    static constexpr int8_t kNone = -1;
+
+    void link(int slot, int8_t prev, int8_t next) {
+        mPrev[slot] = prev;
+        mNext[slot] = next;
+        (prev == kNone ? mFront : mNext[prev]) = static_cast<int8_t>(slot);
+        (next == kNone ? mBack : mPrev[next]) = static_cast<int8_t>(slot);
+        mSlots.insert(slot);
+    }
+
+    BufferSlotSet mSlots;
+    int8_t mFront = kNone;
+    int8_t mBack = kNone;
+    int8_t mPrev[BufferQueueDefs::NUM_BUFFER_SLOTS];
+    int8_t mNext[BufferQueueDefs::NUM_BUFFER_SLOTS];
+};
+
+} // namespace android
+
+#endif
@@ -68,6 +68,9 @@ class CpuConsumer : public ConsumerBase
         uint8_t    *dataCr;
         uint32_t    chromaStride;
         uint32_t    chromaStep;
+        // Time spent locking the buffer for this frame, which includes waiting
+        // on its acquire fence and the cache maintenance done by gralloc.
+        nsecs_t     lockDuration;
 
         LockedBuffer() :
             data(nullptr),
@@ -85,7 +88,8 @@ class CpuConsumer : public ConsumerBase
             dataCb(nullptr),
             dataCr(nullptr),
             chromaStride(0),
-            chromaStep(0)
+            chromaStep(0),
+            lockDuration(0)
         {}
     };
 
@@ -140,12 +144,17 @@ class CpuConsumer : public ConsumerBase
 
     size_t findAcquiredBufferLocked(uintptr_t id) const;
 
-    status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
+    status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer);
 
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
     // Count of currently locked buffers
     size_t mCurrentLockedBuffers;
+
+    // Id of the buffer last seen in each slot when it could not be locked as
+    // flexible YUV, so that the following frames of that buffer go straight to
+    // lockAsync instead of failing a lockAsyncYCbCr first.
+    uint64_t mNonYCbCrBufferIds[BufferQueueDefs::NUM_BUFFER_SLOTS];
 };
 
 } // namespace android
@@ -59,6 +59,11 @@ private:
 
     std::vector<FrameRateOverride> mFrameRateOverrides;
 
+    // The latest mode change of each display among the events read so far, dispatched once the
+    // events are drained (or before a later event of another type), so that a burst of mode
+    // changes, e.g. while the refresh rate settles, is dispatched once.
+    std::vector<DisplayEventReceiver::Event> mPendingModeChanges;
+
     virtual void dispatchVsync(nsecs_t timestamp, PhysicalDisplayId displayId, uint32_t count,
                                VsyncEventData vsyncEventData) = 0;
     virtual void dispatchHotplug(nsecs_t timestamp, PhysicalDisplayId displayId,
@@ -74,5 +79,6 @@ private:
 
     bool processPendingEvents(nsecs_t* outTimestamp, PhysicalDisplayId* outDisplayId,
                               uint32_t* outCount, VsyncEventData* outVsyncEventData);
+    void dispatchPendingModeChanges();
 };
 } // namespace android
@@ -24,6 +24,7 @@
 
 #include <array>
 #include <bitset>
+#include <utility>
 #include <vector>
 
 namespace android {
@@ -197,6 +198,10 @@ public:
         return mBitset[eventIndex];
     }
 
+    inline bool isDirty(FrameEvent event) const {
+        return mBitset[static_cast<size_t>(event)];
+    }
+
 private:
     std::bitset<FrameEvents::EVENT_COUNT> mBitset;
 };
@@ -243,7 +248,8 @@ private:
 // A single frame update from the consumer to producer that can be sent
 // through Binder.
 // Although this may be sent multiple times for the same frame as new
-// timestamps are set, Fences only need to be sent once.
+// timestamps are set, each timestamp and Fence only needs to be sent once,
+// so only the ones that changed since the last delta are included.
 class FrameEventsDelta : public Flattenable<FrameEventsDelta> {
 friend class ProducerFrameEventHistory;
 public:
@@ -276,6 +282,8 @@ private:
     bool mAddPostCompositeCalled{0};
     bool mAddReleaseCalled{0};
 
+    // The FrameEvent bits of the timestamps below that are included.
+    uint32_t mDirtyTimestamps{0};
     nsecs_t mPostedTime{FrameEvents::TIMESTAMP_PENDING};
     nsecs_t mRequestedPresentTime{FrameEvents::TIMESTAMP_PENDING};
     nsecs_t mLatchTime{FrameEvents::TIMESTAMP_PENDING};
@@ -297,6 +305,23 @@ private:
             &fed->mReleaseFence
         }};
     }
+
+    template <typename ThisT>
+    static inline auto allTimestamps(ThisT fed)
+            -> std::array<std::pair<FrameEvent, decltype(&fed->mPostedTime)>, 6> {
+        return {{
+            {FrameEvent::POSTED, &fed->mPostedTime},
+            {FrameEvent::REQUESTED_PRESENT, &fed->mRequestedPresentTime},
+            {FrameEvent::LATCH, &fed->mLatchTime},
+            {FrameEvent::FIRST_REFRESH_START, &fed->mFirstRefreshStartTime},
+            {FrameEvent::LAST_REFRESH_START, &fed->mLastRefreshStartTime},
+            {FrameEvent::DEQUEUE_READY, &fed->mDequeueReadyTime},
+        }};
+    }
+
+    static constexpr uint32_t eventBit(FrameEvent event) {
+        return uint32_t(1) << static_cast<uint32_t>(event);
+    }
 };
 
 
@@ -20,6 +20,7 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
 #include <gui/ConsumerBase.h>
 
@@ -98,6 +99,18 @@ public:
     // This calls doGLFenceWait to ensure proper synchronization.
     status_t updateTexImage();
 
+    // setBindSignaledBuffersOnly sets whether updateTexImage only binds buffers
+    // whose acquire fence has signaled. When enabled, a buffer whose fence has
+    // not signaled yet is kept back and the texture keeps its previous image;
+    // a later call to updateTexImage binds it once its fence has signaled,
+    // rather than having the GL or the CPU wait for the producer. It is
+    // disabled by default.
+    void setBindSignaledBuffersOnly(bool enabled);
+
+    // getDeferredUpdateCount returns how many calls to updateTexImage kept the
+    // previous image because the next buffer's fence had not signaled.
+    uint64_t getDeferredUpdateCount();
+
     // releaseTexImage releases the texture acquired in updateTexImage().
     // This is intended to be used in single buffer mode.
     //
@@ -496,6 +509,18 @@ private:
     // attachToContext.
     bool mAttached;
 
+    // mBindSignaledBuffersOnly is set by setBindSignaledBuffersOnly.
+    bool mBindSignaledBuffersOnly = false;
+
+    // mPendingBuffer is a buffer acquired by updateTexImage that was kept back
+    // because its acquire fence had not signaled, if mHasPendingBuffer is set.
+    // The next call to updateTexImage uses it instead of acquiring another.
+    BufferItem mPendingBuffer;
+    bool mHasPendingBuffer = false;
+
+    // mDeferredUpdateCount is returned by getDeferredUpdateCount.
+    uint64_t mDeferredUpdateCount = 0;
+
     // protects static initialization
     static Mutex sStaticInitLock;
 
@@ -194,6 +194,10 @@ public:
     virtual void onReleaseBuffer(ReleaseCallbackId callbackId, sp<Fence> releaseFence,
                                  uint32_t transformHint,
                                  uint32_t currentMaxAcquiredBufferCount) = 0;
+
+    // Called when SurfaceFlinger evicts a buffer of this process from its buffer cache, so that
+    // the buffer is sent again the next time it is used.
+    virtual void onBufferEvicted(uint64_t cacheId) = 0;
 };
 
 class BnTransactionCompletedListener : public SafeBnInterface<ITransactionCompletedListener> {
@@ -58,6 +58,11 @@ struct client_cache_t {
     bool isValid() const { return token != nullptr; }
 };
 
+// Returns the size in bytes the buffer is counted as in the per-process limits of the buffer
+// caches of SurfaceComposerClient and SurfaceFlinger. Formats of unknown size, like YUV ones, are
+// counted as four bytes per pixel.
+size_t clientCacheBufferSize(const sp<GraphicBuffer>& buffer);
+
 /*
  * Used to communicate layer information between SurfaceFlinger and its clients.
  */
@@ -25,6 +25,8 @@
 #include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
 
+#include <vector>
+
 namespace android {
 
 class GraphicBuffer;
@@ -36,9 +38,22 @@ class IGraphicBufferProducer;
 // in BufferQueue, it is able to present the illusion of a single split
 // BufferQueue, where each buffer queued to the input is available to be
 // acquired by each of the outputs, and is able to be dequeued by the input
-// again only once all of the outputs have released it.
+// again only once all of the outputs it was queued to have released it.
 class StreamSplitter : public BnConsumerListener {
 public:
+    // How the buffers queued to the input are queued to an output.
+    enum class OutputPolicy {
+        // Every buffer is queued to the output. If the output is slow to
+        // release them, the splitter stops acquiring buffers from the input,
+        // which slows down both the input's producer and the other outputs.
+        LOSSLESS,
+        // The buffers queued to the input while the output still holds one
+        // are not queued to it, so the output gets the newest buffer once it
+        // releases the last one. The output never holds more than one buffer,
+        // and so never stalls the other outputs.
+        LATEST_ONLY,
+    };
+
     // createSplitter creates a new splitter, outSplitter, using inputQueue as
     // the input BufferQueue. Output BufferQueues must be added using addOutput
     // before queueing any buffers to the input.
@@ -55,13 +70,15 @@ public:
     // to the input will be queued to each output. It is assumed that all of the
     // outputs are added before any buffers are queued on the input. If any
     // output is abandoned by its consumer, the splitter will abandon its input
-    // queue (see onAbandoned).
+    // queue (see onAbandoned). policy selects which of the buffers are queued
+    // to the output.
     //
     // A return value other than NO_ERROR means that an error has occurred and
     // outputQueue has not been added to the splitter. BAD_VALUE is returned if
     // outputQueue is NULL. See IGraphicBufferProducer::connect for explanations
     // of other error codes.
-    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue);
+    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue,
+            OutputPolicy policy = OutputPolicy::LOSSLESS);
 
     // setName sets the consumer name of the input queue
     void setName(const String8& name);
@@ -70,10 +87,10 @@ private:
     // From IConsumerListener
     //
     // During this callback, we store some tracking information, detach the
-    // buffer from the input, and attach it to each of the outputs. This call
-    // can block if there are too many outstanding buffers. If it blocks, it
-    // will resume when onBufferReleasedByOutput releases a buffer back to the
-    // input.
+    // buffer from the input, and attach it to each of the outputs that takes
+    // it, without holding mMutex. This call can block if there are too many
+    // outstanding buffers. If it blocks, it will resume when
+    // onBufferReleasedByOutput releases a buffer back to the input.
     virtual void onFrameAvailable(const BufferItem& item);
 
     // From IConsumerListener
@@ -97,6 +114,16 @@ private:
     // onFrameAvailable call to proceed.
     void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
 
+    // Counts the buffer as released by the output 'from', and releases it to
+    // the input once all of the outputs it was queued to have released it.
+    // This must be called with mMutex locked.
+    void onOutputReleasedBufferLocked(const sp<IGraphicBufferProducer>& from,
+            uint64_t bufferId, const sp<Fence>& fence);
+
+    // Releases the buffer back to the input, or only stops tracking it if the
+    // splitter has been abandoned. This must be called with mMutex locked.
+    void releaseBufferToInputLocked(uint64_t bufferId);
+
     // When this is called, the splitter disconnects from (i.e., abandons) its
     // input queue and signals any waiting onFrameAvailable calls to wake up.
     // It still processes callbacks from other outputs, but only detaches their
@@ -128,10 +155,12 @@ private:
 
     class BufferTracker : public LightRefBase<BufferTracker> {
     public:
-        explicit BufferTracker(const sp<GraphicBuffer>& buffer);
+        BufferTracker(const sp<GraphicBuffer>& buffer, size_t outputCount);
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
         const sp<Fence>& getMergedFence() const { return mMergedFence; }
+        // The number of outputs the buffer was queued to
+        size_t getOutputCount() const { return mOutputCount; }
 
         void mergeFence(const sp<Fence>& with);
 
@@ -150,9 +179,17 @@ private:
 
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
         sp<Fence> mMergedFence;
+        const size_t mOutputCount;
         size_t mReleaseCount;
     };
 
+    struct Output {
+        sp<IGraphicBufferProducer> queue;
+        OutputPolicy policy;
+        // The number of buffers queued to the output that it has not released
+        size_t heldBuffers;
+    };
+
     // Only called from createSplitter
     explicit StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue);
 
@@ -171,7 +208,7 @@ private:
     Condition mReleaseCondition;
     int mOutstandingBuffers;
     sp<IGraphicBufferConsumer> mInput;
-    Vector<sp<IGraphicBufferProducer> > mOutputs;
+    std::vector<Output> mOutputs;
 
     // Map of GraphicBuffer IDs (GraphicBuffer::getId()) to buffer tracking
     // objects (which are mostly for counting how many outputs have released the
@@ -149,6 +149,15 @@ public:
     // See IGraphicBufferProducer::setDequeueTimeout
     status_t setDequeueTimeout(nsecs_t timeout);
 
+    /* Enables or disables dequeue prefetching. It is disabled by default. When
+     * enabled, queueing a buffer while no other buffer is dequeued starts
+     * dequeuing the next one on a background thread, so that the next
+     * dequeueBuffer call doesn't have to wait for the producer. A prefetched
+     * buffer is cancelled if it no longer matches the requested size, format
+     * or usage, and it isn't used in shared buffer mode.
+     */
+    void setDequeuePrefetch(bool enable);
+
     /*
      * Wait for frame number to increase past lastFrame for at most
      * timeoutNs. Useful for one thread to wait for another unknown
@@ -388,6 +397,7 @@ protected:
         sp<SurfaceListener> mSurfaceListener;
     };
 
+    // mFrameEventHistoryMutex must be locked when calling this method.
     void querySupportedTimestampsLocked() const;
 
     void freeAllBuffers();
@@ -395,6 +405,17 @@ protected:
 
     void getDequeueBufferInputLocked(IGraphicBufferProducer::DequeueBufferInput* dequeueInput);
 
+    // Dequeues a buffer on its own thread ahead of the next dequeueBuffer call.
+    class DequeuePrefetcher;
+
+    // Starts prefetching the next buffer after a queue, if prefetching is
+    // enabled and no other buffer is dequeued.
+    void prefetchNextBufferLocked();
+
+    // Waits for the buffer being prefetched, if any, and cancels it. The
+    // buffer is only dropped if the producer was disconnected, which freed it.
+    void cancelPrefetchedBufferLocked(bool producerConnected = true);
+
     void getQueueBufferInputLocked(android_native_buffer_t* buffer, int fenceFd, nsecs_t timestamp,
             IGraphicBufferProducer::QueueBufferInput* out);
 
@@ -509,6 +530,12 @@ protected:
     // member variables are accessed.
     mutable Mutex mMutex;
 
+    // mFrameEventHistoryMutex guards the frame timestamps below that are read
+    // by getFrameTimestamps and getCompositorTiming, so that apps polling them
+    // every frame don't wait for a dequeue or queue holding mMutex across its
+    // call to the producer. It is locked after mMutex when both are needed.
+    mutable Mutex mFrameEventHistoryMutex;
+
     // mInterceptorMutex is the mutex guarding interceptors.
     mutable std::shared_mutex mInterceptorMutex;
 
@@ -568,13 +595,18 @@ protected:
     Condition mQueueBufferCondition;
 
     uint64_t mNextFrameNumber = 1;
+    // Guarded by mFrameEventHistoryMutex.
     uint64_t mLastFrameNumber = 0;
 
     // Mutable because ANativeWindow::query needs this class const.
+    // Guarded by mFrameEventHistoryMutex.
     mutable bool mQueriedSupportedTimestamps;
     mutable bool mFrameTimestampsSupportsPresent;
 
     // A cached copy of the FrameEventHistory maintained by the consumer.
+    // mEnableFrameTimestamps is written with both mMutex and
+    // mFrameEventHistoryMutex locked, so either may be held to read it.
+    // mFrameEventHistory is guarded by mFrameEventHistoryMutex.
     bool mEnableFrameTimestamps = false;
     std::unique_ptr<ProducerFrameEventHistory> mFrameEventHistory;
 
@@ -597,6 +629,12 @@ protected:
 
     // Buffers that are successfully dequeued/attached and handed to clients
     std::unordered_set<int> mDequeuedSlots;
+
+    // Created the first time prefetching is enabled, and kept until the
+    // Surface is destroyed so that dequeueBuffer can use it without mMutex.
+    // Guarded by mMutex.
+    bool mDequeuePrefetchEnabled = false;
+    std::unique_ptr<DequeuePrefetcher> mDequeuePrefetcher;
 };
 
 } // namespace android
@@ -57,6 +57,10 @@ public:
         mBlastBufferQueueAdapter->setNextTransaction(next);
     }
 
+    void setBufferCoalescing(bool enabled) {
+        mBlastBufferQueueAdapter->setBufferCoalescing(enabled);
+    }
+
     int getWidth() { return mBlastBufferQueueAdapter->mSize.width; }
 
     int getHeight() { return mBlastBufferQueueAdapter->mSize.height; }
@@ -436,6 +440,50 @@ TEST_F(BLASTBufferQueueTest, TripleBuffering) {
     adapter.waitForCallbacks();
 }
 
+TEST_F(BLASTBufferQueueTest, CoalesceBuffers_PresentsLatestBuffer) {
+    BLASTBufferQueueHelper adapter(mSurfaceControl, mDisplayWidth, mDisplayHeight);
+    adapter.setBufferCoalescing(true);
+    sp<IGraphicBufferProducer> igbProducer;
+    setUpProducer(adapter, igbProducer);
+
+    constexpr int64_t kFrames = 20;
+    adapter.setTransactionCompleteCallback(kFrames);
+    for (int64_t frame = 1; frame <= kFrames; frame++) {
+        int slot;
+        sp<Fence> fence;
+        sp<GraphicBuffer> buf;
+        auto ret = igbProducer->dequeueBuffer(&slot, &fence, mDisplayWidth, mDisplayHeight,
+                                              PIXEL_FORMAT_RGBA_8888, GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                              nullptr, nullptr);
+        ASSERT_LE(0, ret);
+        ASSERT_EQ(OK, igbProducer->requestBuffer(slot, &buf));
+        if (fence != nullptr) {
+            fence->waitForever("CoalesceBuffers");
+        }
+
+        // Only the last buffer is red.
+        uint32_t* bufData;
+        buf->lock(static_cast<uint32_t>(GraphicBuffer::USAGE_SW_WRITE_OFTEN),
+                  reinterpret_cast<void**>(&bufData));
+        fillBuffer(bufData, Rect(buf->getWidth(), buf->getHeight()), buf->getStride(),
+                   frame == kFrames ? 255 : 0, 0, frame == kFrames ? 0 : 255);
+        buf->unlock();
+
+        IGraphicBufferProducer::QueueBufferOutput qbOutput;
+        IGraphicBufferProducer::QueueBufferInput input(systemTime(), true /* autotimestamp */,
+                                                       HAL_DATASPACE_UNKNOWN,
+                                                       Rect(mDisplayWidth, mDisplayHeight),
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+        ASSERT_EQ(OK, igbProducer->queueBuffer(slot, input, &qbOutput));
+    }
+    adapter.waitForCallback(kFrames);
+
+    ASSERT_EQ(NO_ERROR, captureDisplay(mCaptureArgs, mCaptureResults));
+    ASSERT_NO_FATAL_FAILURE(
+            checkScreenCapture(255, 0, 0, {0, 0, (int32_t)mDisplayWidth, (int32_t)mDisplayHeight}));
+}
+
 TEST_F(BLASTBufferQueueTest, SetCrop_Item) {
     uint8_t r = 255;
     uint8_t g = 0;
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockConsumer.h"
+
+#include <benchmark/benchmark.h>
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/BufferSlotSet.h>
+#include <gui/IProducerListener.h>
+#include <ui/GraphicBuffer.h>
+
+// Usage: atest libgui_benchmark
+
+namespace android {
+namespace {
+
+// Dequeues, queues, acquires and releases a buffer, as a producer and a
+// consumer in the same process do for every frame.
+void BM_BufferQueueCycle(benchmark::State& state) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(new MockConsumer, false);
+    IGraphicBufferProducer::QueueBufferOutput qbo;
+    producer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false, &qbo);
+    producer->setMaxDequeuedBufferCount(state.range(0));
+
+    const IGraphicBufferProducer::QueueBufferInput qbi(0, false, HAL_DATASPACE_UNKNOWN,
+                                                       Rect(0, 0, 1, 1),
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    BufferItem item;
+    for (auto _ : state) {
+        const status_t result =
+                producer->dequeueBuffer(&slot, &fence, 1, 1, 0, GRALLOC_USAGE_SW_READ_OFTEN,
+                                        nullptr, nullptr);
+        if (result < 0) {
+            state.SkipWithError("dequeueBuffer failed");
+            break;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            producer->requestBuffer(slot, &buffer);
+        }
+        producer->queueBuffer(slot, qbi, &qbo);
+        consumer->acquireBuffer(&item, 0);
+        consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY, EGL_NO_SYNC_KHR,
+                                Fence::NO_FENCE);
+    }
+}
+BENCHMARK(BM_BufferQueueCycle)->Arg(1)->Arg(3);
+
+// Moves a slot between the free buffers and the active buffers, and counts the
+// active buffers, as BufferQueueCore does in the cycle above.
+void BM_BufferSlotCycle(benchmark::State& state) {
+    BufferSlotList freeBuffers;
+    BufferSlotSet activeBuffers;
+    for (int slot = 0; slot < state.range(0); slot++) {
+        freeBuffers.push_back(slot);
+    }
+
+    for (auto _ : state) {
+        const int slot = freeBuffers.front();
+        freeBuffers.pop_front();
+        activeBuffers.insert(slot);
+        int activeCount = 0;
+        for (int s : activeBuffers) {
+            benchmark::DoNotOptimize(s);
+            activeCount++;
+        }
+        benchmark::DoNotOptimize(activeCount);
+        activeBuffers.erase(slot);
+        freeBuffers.push_back(slot);
+    }
+}
+BENCHMARK(BM_BufferSlotCycle)->Arg(3)->Arg(64);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gui/BufferSlotSet.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace android {
+namespace {
+
+using testing::ElementsAre;
+
+template <typename Slots>
+std::vector<int> toVector(const Slots& slots) {
+    return std::vector<int>(slots.begin(), slots.end());
+}
+
+TEST(BufferSlotSetTest, iteratesInSlotOrder) {
+    BufferSlotSet slots;
+    EXPECT_TRUE(slots.empty());
+
+    slots.insert(63);
+    slots.insert(2);
+    slots.insert(0);
+    slots.insert(2);
+    EXPECT_EQ(3u, slots.size());
+    EXPECT_EQ(0, *slots.begin());
+    EXPECT_THAT(toVector(slots), ElementsAre(0, 2, 63));
+}
+
+TEST(BufferSlotSetTest, erasesSlots) {
+    BufferSlotSet slots;
+    slots.insert(1);
+    slots.insert(5);
+    slots.insert(7);
+
+    slots.erase(5);
+    EXPECT_EQ(0u, slots.count(5));
+    slots.erase(slots.begin());
+    EXPECT_THAT(toVector(slots), ElementsAre(7));
+
+    slots.clear();
+    EXPECT_TRUE(slots.empty());
+    EXPECT_EQ(slots.begin(), slots.end());
+}
+
+TEST(BufferSlotSetTest, canBeModifiedWhileIterated) {
+    BufferSlotSet slots;
+    slots.insert(1);
+    slots.insert(2);
+
+    std::vector<int> iterated;
+    for (int slot : slots) {
+        iterated.push_back(slot);
+        slots.erase(slot);
+    }
+    EXPECT_THAT(iterated, ElementsAre(1, 2));
+    EXPECT_TRUE(slots.empty());
+}
+
+TEST(BufferSlotListTest, keepsInsertionOrder) {
+    BufferSlotList slots;
+    EXPECT_TRUE(slots.empty());
+
+    slots.push_back(3);
+    slots.push_back(1);
+    slots.push_front(63);
+    EXPECT_EQ(3u, slots.size());
+    EXPECT_EQ(63, slots.front());
+    EXPECT_EQ(1, slots.back());
+    EXPECT_THAT(toVector(slots), ElementsAre(63, 3, 1));
+}
+
+TEST(BufferSlotListTest, popsAndRemovesSlots) {
+    BufferSlotList slots;
+    for (int slot : {4, 5, 6, 7}) {
+        slots.push_back(slot);
+    }
+
+    slots.pop_front();
+    slots.pop_back();
+    EXPECT_THAT(toVector(slots), ElementsAre(5, 6));
+
+    slots.remove(6);
+    slots.remove(6);
+    EXPECT_EQ(0u, slots.count(6));
+    EXPECT_THAT(toVector(slots), ElementsAre(5));
+
+    slots.pop_front();
+    EXPECT_TRUE(slots.empty());
+    EXPECT_EQ(slots.begin(), slots.end());
+
+    slots.push_back(2);
+    EXPECT_EQ(2, slots.front());
+    EXPECT_EQ(2, slots.back());
+}
+
+TEST(BufferSlotListTest, movesSlotPushedAgain) {
+    BufferSlotList slots;
+    slots.push_back(1);
+    slots.push_back(2);
+    slots.push_back(3);
+
+    slots.push_back(1);
+    EXPECT_THAT(toVector(slots), ElementsAre(2, 3, 1));
+    slots.push_front(3);
+    EXPECT_THAT(toVector(slots), ElementsAre(3, 2, 1));
+}
+
+} // namespace
+} // namespace android
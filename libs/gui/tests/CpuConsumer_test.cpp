@@ -32,6 +32,7 @@
 #include <utils/Thread.h>
 #include <utils/Mutex.h>
 #include <utils/Condition.h>
+#include <utils/Timers.h>
 
 #include <thread>
 #include <vector>
@@ -531,6 +532,17 @@ void produceOneFrame(const sp<ANativeWindow>& anw,
     ASSERT_NO_ERROR(err, "queueBuffer error:");
 };
 
+// Queues one frame without writing to it, for tests that only look at how
+// the buffer is locked.
+status_t queueUnfilledFrame(const sp<ANativeWindow>& anw) {
+    ANativeWindowBuffer* anb;
+    status_t err = native_window_dequeue_buffer_and_wait(anw.get(), &anb);
+    if (err != NO_ERROR) {
+        return err;
+    }
+    return anw->queueBuffer(anw.get(), anb, -1);
+}
+
 // This test is disabled because the HAL_PIXEL_FORMAT_RAW16 format is not
 // supported on all devices.
 TEST_P(CpuConsumerTest, FromCpuSingle) {
@@ -682,6 +694,82 @@ TEST_P(CpuConsumerTest, FromCpuLockMax) {
     }
 }
 
+TEST_P(CpuConsumerTest, FromCpuLockDuration) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, 1));
+
+    uint32_t stride;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, i, &stride));
+
+        CpuConsumer::LockedBuffer b;
+        const nsecs_t before = systemTime();
+        err = mCC->lockNextBuffer(&b);
+        const nsecs_t after = systemTime();
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+
+        // The lock is timed inside lockNextBuffer, after the buffer is
+        // acquired.
+        EXPECT_GT(b.lockDuration, 0) << "frame " << i;
+        EXPECT_LE(b.lockDuration, after - before) << "frame " << i;
+
+        mCC->unlockBuffer(b);
+    }
+}
+
+// Uses the dimensions of the test parameters, with formats that may be YUV.
+TEST_P(CpuConsumerTest, FromCpuNonYCbCrBuffersReusedAndReplaced) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    // RAW12 may be YUV as far as CpuConsumer knows, but gralloc can't lock
+    // it as flexible YUV, so CpuConsumer remembers its buffers.
+    params.format = HAL_PIXEL_FORMAT_RAW12;
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, 1));
+    // tradefed infrastructure does not support use of GTEST_SKIP
+    if (queueUnfilledFrame(mANW) != NO_ERROR) {
+        ALOGI("RAW12 buffers can't be allocated, skipping");
+        return;
+    }
+
+    CpuConsumer::LockedBuffer b;
+    err = mCC->lockNextBuffer(&b);
+    ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+    if (b.flexFormat == HAL_PIXEL_FORMAT_YCbCr_420_888) {
+        ALOGI("RAW12 buffers can be locked as flexible YUV, skipping");
+        mCC->unlockBuffer(b);
+        return;
+    }
+    mCC->unlockBuffer(b);
+
+    // Later frames of the same buffers are locked the way the first one was.
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(NO_ERROR, queueUnfilledFrame(mANW));
+        err = mCC->lockNextBuffer(&b);
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+        EXPECT_TRUE(b.data != nullptr) << "frame " << i;
+        EXPECT_EQ(HAL_PIXEL_FORMAT_RAW12, b.format) << "frame " << i;
+        EXPECT_EQ(HAL_PIXEL_FORMAT_RAW12, b.flexFormat) << "frame " << i;
+        EXPECT_TRUE(b.dataCb == nullptr) << "frame " << i;
+        mCC->unlockBuffer(b);
+    }
+
+    // New buffers in the same slots are tried as flexible YUV again.
+    err = native_window_set_buffers_format(mANW.get(), HAL_PIXEL_FORMAT_YV12);
+    ASSERT_NO_ERROR(err, "set_buffers_format error: ");
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(NO_ERROR, queueUnfilledFrame(mANW));
+        err = mCC->lockNextBuffer(&b);
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+        EXPECT_EQ(HAL_PIXEL_FORMAT_YV12, b.format) << "frame " << i;
+        EXPECT_EQ(HAL_PIXEL_FORMAT_YCbCr_420_888, b.flexFormat) << "frame " << i;
+        EXPECT_TRUE(b.dataCb != nullptr) << "frame " << i;
+        mCC->unlockBuffer(b);
+    }
+}
+
 TEST_P(CpuConsumerTest, FromCpuInvalid) {
     status_t err = mCC->lockNextBuffer(nullptr);
     ASSERT_EQ(BAD_VALUE, err) << "lockNextBuffer did not fail";
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LayerState_test"
+
+#include <gtest/gtest.h>
+
+#include <binder/Parcel.h>
+#include <gui/LayerState.h>
+
+namespace android {
+
+TEST(LayerStateTest, ParcelsSelectedFields) {
+    layer_state_t state;
+    state.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eCropChanged | layer_state_t::eMatrixChanged;
+    state.x = 10.f;
+    state.y = 20.f;
+    state.alpha = 0.5f;
+    state.crop = Rect(1, 2, 3, 4);
+    state.matrix.dsdx = 2.f;
+
+    Parcel p;
+    ASSERT_EQ(NO_ERROR, state.write(p));
+    p.setDataPosition(0);
+
+    layer_state_t result;
+    ASSERT_EQ(NO_ERROR, result.read(p));
+    EXPECT_EQ(state.what, result.what);
+    EXPECT_EQ(10.f, result.x);
+    EXPECT_EQ(20.f, result.y);
+    EXPECT_EQ(0.5f, result.alpha);
+    EXPECT_EQ(Rect(1, 2, 3, 4), result.crop);
+    EXPECT_EQ(2.f, result.matrix.dsdx);
+    EXPECT_EQ(p.dataSize(), p.dataPosition());
+}
+
+TEST(LayerStateTest, SkipsUnselectedFields) {
+    layer_state_t positionOnly;
+    positionOnly.what = layer_state_t::ePositionChanged;
+    positionOnly.cornerRadius = 5.f;
+    positionOnly.transparentRegion = Region(Rect(0, 0, 100, 100));
+
+    layer_state_t everything = positionOnly;
+    everything.what = ~uint64_t(0);
+
+    Parcel positionOnlyParcel;
+    ASSERT_EQ(NO_ERROR, positionOnly.write(positionOnlyParcel));
+    Parcel everythingParcel;
+    ASSERT_EQ(NO_ERROR, everything.write(everythingParcel));
+    EXPECT_LT(positionOnlyParcel.dataSize(), everythingParcel.dataSize());
+
+    positionOnlyParcel.setDataPosition(0);
+    layer_state_t result;
+    ASSERT_EQ(NO_ERROR, result.read(positionOnlyParcel));
+    EXPECT_EQ(0.f, result.cornerRadius);
+    EXPECT_TRUE(result.transparentRegion.isEmpty());
+}
+
+} // namespace android
@@ -196,6 +196,67 @@ TEST_F(StreamSplitterTest, OneInputMultipleOutputs) {
                                            nullptr, nullptr));
 }
 
+TEST_F(StreamSplitterTest, LatestOnlyOutputDoesNotStallOthers) {
+    sp<IGraphicBufferProducer> inputProducer;
+    sp<IGraphicBufferConsumer> inputConsumer;
+    BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+    sp<IGraphicBufferProducer> losslessProducer;
+    sp<IGraphicBufferConsumer> losslessConsumer;
+    BufferQueue::createBufferQueue(&losslessProducer, &losslessConsumer);
+    ASSERT_EQ(OK, losslessConsumer->consumerConnect(new FakeListener, false));
+
+    sp<IGraphicBufferProducer> latestOnlyProducer;
+    sp<IGraphicBufferConsumer> latestOnlyConsumer;
+    BufferQueue::createBufferQueue(&latestOnlyProducer, &latestOnlyConsumer);
+    ASSERT_EQ(OK, latestOnlyConsumer->consumerConnect(new FakeListener, false));
+
+    sp<StreamSplitter> splitter;
+    status_t status = StreamSplitter::createSplitter(inputConsumer, &splitter);
+    ASSERT_EQ(OK, status);
+    ASSERT_EQ(OK, splitter->addOutput(losslessProducer));
+    ASSERT_EQ(OK, splitter->addOutput(latestOnlyProducer,
+            StreamSplitter::OutputPolicy::LATEST_ONLY));
+
+    IGraphicBufferProducer::QueueBufferOutput qbOutput;
+    ASSERT_EQ(OK,
+              inputProducer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false,
+                                     &qbOutput));
+
+    IGraphicBufferProducer::QueueBufferInput qbInput(0, false,
+            HAL_DATASPACE_UNKNOWN, Rect(0, 0, 1, 1),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, Fence::NO_FENCE);
+
+    // Queue more buffers than the splitter keeps outstanding, while the
+    // latest-only output holds on to the first one
+    const int NUM_BUFFERS = 4;
+    for (int i = 0; i < NUM_BUFFERS; ++i) {
+        int slot;
+        sp<Fence> fence;
+        sp<GraphicBuffer> buffer;
+        ASSERT_LE(OK,
+                  inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0,
+                                               GRALLOC_USAGE_SW_WRITE_OFTEN, nullptr, nullptr));
+        ASSERT_EQ(OK, inputProducer->requestBuffer(slot, &buffer));
+        ASSERT_EQ(OK, inputProducer->queueBuffer(slot, qbInput, &qbOutput));
+
+        BufferItem item;
+        ASSERT_EQ(OK, losslessConsumer->acquireBuffer(&item, 0));
+        ASSERT_EQ(OK, losslessConsumer->releaseBuffer(item.mSlot,
+                    item.mFrameNumber, EGL_NO_DISPLAY, EGL_NO_SYNC_KHR,
+                    Fence::NO_FENCE));
+    }
+
+    // The latest-only output only received the first buffer
+    BufferItem item;
+    ASSERT_EQ(OK, latestOnlyConsumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(OK, latestOnlyConsumer->releaseBuffer(item.mSlot,
+                item.mFrameNumber, EGL_NO_DISPLAY, EGL_NO_SYNC_KHR,
+                Fence::NO_FENCE));
+    ASSERT_EQ(BufferQueue::NO_BUFFER_AVAILABLE,
+              latestOnlyConsumer->acquireBuffer(&item, 0));
+}
+
 TEST_F(StreamSplitterTest, OutputAbandonment) {
     sp<IGraphicBufferProducer> inputProducer;
     sp<IGraphicBufferConsumer> inputConsumer;
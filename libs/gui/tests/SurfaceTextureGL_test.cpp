@@ -532,6 +532,22 @@ TEST_F(SurfaceTextureGLTest, DisconnectClearsCurrentTexture) {
             NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(SurfaceTextureGLTest, BindSignaledBuffersOnlyUpdatesToBuffersWithoutFence) {
+    mST->setBindSignaledBuffersOnly(true);
+    ASSERT_EQ(OK, native_window_api_connect(mANW.get(), NATIVE_WINDOW_API_CPU));
+
+    ANativeWindowBuffer* anb;
+    ASSERT_EQ(OK, native_window_dequeue_buffer_and_wait(mANW.get(), &anb));
+    ASSERT_EQ(OK, mANW->queueBuffer(mANW.get(), anb, -1));
+    mFW->waitForFrame();
+    ASSERT_EQ(OK, mST->updateTexImage());
+
+    EXPECT_EQ(1u, mST->getFrameNumber());
+    EXPECT_EQ(0u, mST->getDeferredUpdateCount());
+
+    ASSERT_EQ(OK, native_window_api_disconnect(mANW.get(), NATIVE_WINDOW_API_CPU));
+}
+
 TEST_F(SurfaceTextureGLTest, ScaleToWindowMode) {
     ASSERT_EQ(OK, native_window_set_scaling_mode(mANW.get(),
         NATIVE_WINDOW_SCALING_MODE_SCALE_TO_WINDOW));
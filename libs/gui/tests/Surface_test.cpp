@@ -1944,6 +1944,59 @@ TEST_F(GetFrameTimestampsTest, PresentUnsupportedNoSync) {
     EXPECT_EQ(-1, outDisplayPresentTime);
 }
 
+static void flattenAndUnflatten(const FrameEventHistoryDelta& delta,
+                                FrameEventHistoryDelta* outDelta) {
+    std::vector<uint8_t> buffer(delta.getFlattenedSize());
+    std::vector<int> fds(delta.getFdCount());
+    void* data = buffer.data();
+    size_t size = buffer.size();
+    int* fdData = fds.data();
+    size_t fdCount = fds.size();
+    ASSERT_EQ(NO_ERROR, delta.flatten(data, size, fdData, fdCount));
+    EXPECT_EQ(0u, size);
+
+    const void* readData = buffer.data();
+    size = buffer.size();
+    const int* readFdData = fds.data();
+    fdCount = fds.size();
+    ASSERT_EQ(NO_ERROR, outDelta->unflatten(readData, size, readFdData, fdCount));
+    EXPECT_EQ(0u, size);
+}
+
+// This test verifies that a delta sent through Binder only carries the
+// timestamps that changed, and that the producer keeps the ones it already
+// received.
+TEST(FrameEventHistoryDeltaTest, SendsOnlyChangedTimestamps) {
+    ConsumerFrameEventHistory consumerHistory;
+    ProducerFrameEventHistory producerHistory;
+
+    NewFrameEventsEntry entry;
+    entry.frameNumber = 1;
+    entry.postedTime = 10;
+    entry.requestedPresentTime = 20;
+    consumerHistory.addQueue(entry);
+    FrameEventHistoryDelta queueDelta;
+    consumerHistory.getAndResetDelta(&queueDelta);
+    FrameEventHistoryDelta sentQueueDelta;
+    flattenAndUnflatten(queueDelta, &sentQueueDelta);
+    producerHistory.applyDelta(sentQueueDelta);
+
+    consumerHistory.addLatch(1, 30);
+    FrameEventHistoryDelta latchDelta;
+    consumerHistory.getAndResetDelta(&latchDelta);
+    EXPECT_LT(latchDelta.getFlattenedSize(), queueDelta.getFlattenedSize());
+    FrameEventHistoryDelta sentLatchDelta;
+    flattenAndUnflatten(latchDelta, &sentLatchDelta);
+    producerHistory.applyDelta(sentLatchDelta);
+
+    const FrameEvents* events = producerHistory.getFrame(1);
+    ASSERT_NE(nullptr, events);
+    EXPECT_EQ(10, events->postedTime);
+    EXPECT_EQ(20, events->requestedPresentTime);
+    EXPECT_EQ(30, events->latchTime);
+    EXPECT_EQ(FrameEvents::TIMESTAMP_PENDING, events->firstRefreshStartTime);
+}
+
 TEST_F(SurfaceTest, DequeueWithConsumerDrivenSize) {
     sp<IGraphicBufferProducer> producer;
     sp<IGraphicBufferConsumer> consumer;
@@ -2091,6 +2144,43 @@ TEST_F(SurfaceTest, BatchOperations) {
     ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(SurfaceTest, DequeuePrefetch) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<CpuConsumer> cpuConsumer = new CpuConsumer(consumer, 1);
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    sp<StubProducerListener> listener = new StubProducerListener();
+
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, /*listener*/listener,
+            /*reportBufferRemoval*/false));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), 16));
+    surface->setDequeuePrefetch(true);
+
+    for (int i = 0; i < 3; i++) {
+        ANativeWindowBuffer* buffer;
+        int fence;
+        ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+        ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+    }
+
+    // A buffer prefetched at the old size is replaced.
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(window.get(), 32, 16));
+    ANativeWindowBuffer* buffer;
+    int fence;
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    EXPECT_EQ(32, buffer->width);
+    EXPECT_EQ(16, buffer->height);
+    ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+
+    // The prefetched buffer is cancelled before the buffer count changes.
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), 8));
+
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
 TEST_F(SurfaceTest, BatchIllegalOperations) {
     const int BUFFER_COUNT = 16;
     const int BATCH_SIZE = 8;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+
+#include <vector>
+
+// Usage: atest libgui_benchmark
+
+namespace android {
+namespace {
+
+std::vector<sp<SurfaceControl>> createSurfaceControls(int count) {
+    std::vector<sp<SurfaceControl>> surfaceControls;
+    for (int i = 0; i < count; i++) {
+        // Transactions only use the handle and the layer id, so there is no need for actual
+        // layers in SurfaceFlinger.
+        surfaceControls.push_back(new SurfaceControl(nullptr, new BBinder(), nullptr, i));
+    }
+    return surfaceControls;
+}
+
+// Builds a transaction per half of the surfaces and merges both into a transaction that is
+// written to a parcel, as applying it would. The surfaces of the second half overlap the first,
+// so that merging both moves states and merges states into existing ones.
+void BM_TransactionBuildMergeWrite(benchmark::State& state) {
+    const std::vector<sp<SurfaceControl>> surfaceControls = createSurfaceControls(state.range(0));
+    const size_t half = surfaceControls.size() / 2;
+    Parcel parcel;
+    for (auto _ : state) {
+        SurfaceComposerClient::Transaction first;
+        for (size_t i = 0; i < half + 1; i++) {
+            first.setPosition(surfaceControls[i], 1.f, 2.f).setAlpha(surfaceControls[i], 0.5f);
+        }
+        SurfaceComposerClient::Transaction second;
+        for (size_t i = half; i < surfaceControls.size(); i++) {
+            second.setLayer(surfaceControls[i], static_cast<int32_t>(i)).show(surfaceControls[i]);
+        }
+
+        SurfaceComposerClient::Transaction merged;
+        merged.merge(std::move(first)).merge(std::move(second));
+
+        parcel.setDataPosition(0);
+        merged.writeToParcel(&parcel);
+        benchmark::DoNotOptimize(parcel.dataSize());
+        merged.clear();
+    }
+}
+BENCHMARK(BM_TransactionBuildMergeWrite)->Arg(2)->Arg(16)->Arg(64);
+
+// Reads back a transaction written to a parcel, as a process receiving it does.
+void BM_TransactionRead(benchmark::State& state) {
+    const std::vector<sp<SurfaceControl>> surfaceControls = createSurfaceControls(state.range(0));
+    SurfaceComposerClient::Transaction transaction;
+    for (const auto& surfaceControl : surfaceControls) {
+        transaction.setPosition(surfaceControl, 1.f, 2.f).setAlpha(surfaceControl, 0.5f);
+    }
+    Parcel parcel;
+    transaction.writeToParcel(&parcel);
+    transaction.clear();
+
+    for (auto _ : state) {
+        parcel.setDataPosition(0);
+        transaction.readFromParcel(&parcel);
+        transaction.clear();
+    }
+}
+BENCHMARK(BM_TransactionRead)->Arg(2)->Arg(16)->Arg(64);
+
+} // namespace
+} // namespace android
@@ -23,6 +23,7 @@ static constexpr bool DEBUG_TRANSPORT_ACTIONS = false;
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -36,6 +37,8 @@ static constexpr bool DEBUG_TRANSPORT_ACTIONS = false;
 #include <input/InputTransport.h>
 #include <input/NamedEnum.h>
 
+#include <algorithm>
+
 using android::base::StringPrintf;
 
 namespace android {
@@ -352,6 +355,16 @@ status_t InputChannel::openInputChannelPair(const std::string& name,
     return OK;
 }
 
+static status_t sendErrorToStatus(int error) {
+    if (error == EAGAIN || error == EWOULDBLOCK) {
+        return WOULD_BLOCK;
+    }
+    if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+        return DEAD_OBJECT;
+    }
+    return -error;
+}
+
 status_t InputChannel::sendMessage(const InputMessage* msg) {
     const size_t msgLength = msg->size();
     InputMessage cleanMsg;
@@ -367,13 +380,7 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
         ALOGD("channel '%s' ~ error sending message of type %d, %s", mName.c_str(),
               msg->header.type, strerror(error));
 #endif
-        if (error == EAGAIN || error == EWOULDBLOCK) {
-            return WOULD_BLOCK;
-        }
-        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
-            return DEAD_OBJECT;
-        }
-        return -error;
+        return sendErrorToStatus(error);
     }
 
     if (size_t(nWrite) != msgLength) {
@@ -390,6 +397,58 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessages(InputMessage* msgs, size_t count, size_t* outSentCount) {
+    static constexpr size_t MAX_MESSAGES_PER_CALL = 64;
+    struct iovec iovs[MAX_MESSAGES_PER_CALL];
+    struct mmsghdr headers[MAX_MESSAGES_PER_CALL];
+
+    *outSentCount = 0;
+    while (*outSentCount < count) {
+        InputMessage* const first = msgs + *outSentCount;
+        const size_t n = std::min(count - *outSentCount, MAX_MESSAGES_PER_CALL);
+        for (size_t i = 0; i < n; i++) {
+            InputMessage cleanMsg;
+            first[i].getSanitizedCopy(&cleanMsg);
+            memcpy(&first[i], &cleanMsg, sizeof(InputMessage));
+            iovs[i].iov_base = &first[i];
+            iovs[i].iov_len = first[i].size();
+            memset(&headers[i], 0, sizeof(headers[i]));
+            headers[i].msg_hdr.msg_iov = &iovs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int nSent;
+        do {
+            nSent = ::sendmmsg(getFd(), headers, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while (nSent == -1 && errno == EINTR);
+
+        if (nSent < 0) {
+            int error = errno;
+#if DEBUG_CHANNEL_MESSAGES
+            ALOGD("channel '%s' ~ error sending message of type %d, %s", mName.c_str(),
+                  first->header.type, strerror(error));
+#endif
+            return sendErrorToStatus(error);
+        }
+        for (int i = 0; i < nSent; i++) {
+            if (headers[i].msg_len != iovs[i].iov_len) {
+#if DEBUG_CHANNEL_MESSAGES
+                ALOGD("channel '%s' ~ error sending message type %d, send was incomplete",
+                      mName.c_str(), first[i].header.type);
+#endif
+                return DEAD_OBJECT;
+            }
+            (*outSentCount)++;
+        }
+        // If fewer messages were sent, sending the next one again reports why.
+    }
+
+#if DEBUG_CHANNEL_MESSAGES
+    ALOGD("channel '%s' ~ sent %zu messages", mName.c_str(), count);
+#endif
+    return OK;
+}
+
 status_t InputChannel::receiveMessage(InputMessage* msg) {
     ssize_t nRead;
     do {
@@ -525,7 +584,7 @@ status_t InputPublisher::publishKeyEvent(uint32_t seq, int32_t eventId, int32_t
     msg.body.key.repeatCount = repeatCount;
     msg.body.key.downTime = downTime;
     msg.body.key.eventTime = eventTime;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishMotionEvent(
@@ -603,7 +662,7 @@ status_t InputPublisher::publishMotionEvent(
         msg.body.motion.pointers[i].coords.copyFrom(pointerCoords[i]);
     }
 
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool hasFocus,
@@ -622,7 +681,7 @@ status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool h
     msg.body.focus.eventId = eventId;
     msg.body.focus.hasFocus = hasFocus;
     msg.body.focus.inTouchMode = inTouchMode;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
@@ -639,7 +698,7 @@ status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
     msg.header.seq = seq;
     msg.body.capture.eventId = eventId;
     msg.body.capture.pointerCaptureEnabled = pointerCaptureEnabled;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x, float y,
@@ -658,7 +717,7 @@ status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x
     msg.body.drag.isExiting = isExiting;
     msg.body.drag.x = x;
     msg.body.drag.y = y;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 android::base::Result<InputPublisher::ConsumerResponse> InputPublisher::receiveConsumerResponse() {
@@ -691,10 +750,38 @@ android::base::Result<InputPublisher::ConsumerResponse> InputPublisher::receiveC
     return android::base::Error(UNKNOWN_ERROR);
 }
 
+void InputPublisher::beginBatch() {
+    mBatching = true;
+}
+
+status_t InputPublisher::flush(size_t* outPublishedCount) {
+    mBatching = false;
+    status_t result = mChannel->sendMessages(mBatchedMessages.data(), mBatchedMessages.size(),
+                                             outPublishedCount);
+    if (DEBUG_TRANSPORT_ACTIONS) {
+        ALOGD("channel '%s' publisher ~ flush: published %zu of %zu events, result=%d",
+              mChannel->getName().c_str(), *outPublishedCount, mBatchedMessages.size(), result);
+    }
+    // Keep the capacity for the next batch.
+    mBatchedMessages.clear();
+    return result;
+}
+
+status_t InputPublisher::sendMessage(const InputMessage& msg) {
+    if (mBatching) {
+        mBatchedMessages.push_back(msg);
+        return OK;
+    }
+    return mChannel->sendMessage(&msg);
+}
+
 // --- InputConsumer ---
 
 InputConsumer::InputConsumer(const std::shared_ptr<InputChannel>& channel)
-      : mResampleTouch(isTouchResamplingEnabled()), mChannel(channel), mMsgDeferred(false) {}
+      : mResampleTouch(isTouchResamplingEnabled()),
+        mResamplingMode(ResamplingMode::INTERPOLATE),
+        mChannel(channel),
+        mMsgDeferred(false) {}
 
 InputConsumer::~InputConsumer() {
 }
@@ -761,8 +848,8 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                 ssize_t batchIndex = findBatch(mMsg.body.motion.deviceId, mMsg.body.motion.source);
                 if (batchIndex >= 0) {
                     Batch& batch = mBatches[batchIndex];
-                    if (canAddSample(batch, &mMsg)) {
-                        batch.samples.push_back(mMsg);
+                    if (!batch.isFull() && canAddSample(batch, &mMsg)) {
+                        batch.push(mMsg);
                         if (DEBUG_TRANSPORT_ACTIONS) {
                             ALOGD("channel '%s' consumer ~ appended to batch event",
                                   mChannel->getName().c_str());
@@ -771,20 +858,18 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                     } else if (isPointerEvent(mMsg.body.motion.source) &&
                                mMsg.body.motion.action == AMOTION_EVENT_ACTION_CANCEL) {
                         // No need to process events that we are going to cancel anyways
-                        const size_t count = batch.samples.size();
+                        const size_t count = batch.count;
                         for (size_t i = 0; i < count; i++) {
-                            const InputMessage& msg = batch.samples[i];
+                            const InputMessage& msg = batch.sample(i);
                             sendFinishedSignal(msg.header.seq, false);
                         }
-                        batch.samples.erase(batch.samples.begin(), batch.samples.begin() + count);
-                        mBatches.erase(mBatches.begin() + batchIndex);
+                        batch.pop(count);
                     } else {
                         // We cannot append to the batch in progress, so we need to consume
                         // the previous batch right now and defer the new message until later.
                         mMsgDeferred = true;
-                        status_t result = consumeSamples(factory, batch, batch.samples.size(),
-                                                         outSeq, outEvent);
-                        mBatches.erase(mBatches.begin() + batchIndex);
+                        status_t result =
+                                consumeSamples(factory, batch, batch.count, outSeq, outEvent);
                         if (result) {
                             return result;
                         }
@@ -800,9 +885,7 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                 // Start a new batch if needed.
                 if (mMsg.body.motion.action == AMOTION_EVENT_ACTION_MOVE ||
                     mMsg.body.motion.action == AMOTION_EVENT_ACTION_HOVER_MOVE) {
-                    Batch batch;
-                    batch.samples.push_back(mMsg);
-                    mBatches.push_back(batch);
+                    obtainBatch().push(mMsg);
                     if (DEBUG_TRANSPORT_ACTIONS) {
                         ALOGD("channel '%s' consumer ~ started batch event",
                               mChannel->getName().c_str());
@@ -873,14 +956,15 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
     for (size_t i = mBatches.size(); i > 0; ) {
         i--;
         Batch& batch = mBatches[i];
+        if (batch.empty()) {
+            continue;
+        }
         if (frameTime < 0) {
-            result = consumeSamples(factory, batch, batch.samples.size(), outSeq, outEvent);
-            mBatches.erase(mBatches.begin() + i);
-            return result;
+            return consumeSamples(factory, batch, batch.count, outSeq, outEvent);
         }
 
         nsecs_t sampleTime = frameTime;
-        if (mResampleTouch) {
+        if (mResampleTouch && mResamplingMode == ResamplingMode::INTERPOLATE) {
             sampleTime -= RESAMPLE_LATENCY;
         }
         ssize_t split = findSampleNoLaterThan(batch, sampleTime);
@@ -889,13 +973,7 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         }
 
         result = consumeSamples(factory, batch, split + 1, outSeq, outEvent);
-        const InputMessage* next;
-        if (batch.samples.empty()) {
-            mBatches.erase(mBatches.begin() + i);
-            next = nullptr;
-        } else {
-            next = &batch.samples[0];
-        }
+        const InputMessage* next = batch.empty() ? nullptr : &batch.sample(0);
         if (!result && mResampleTouch) {
             resampleTouchState(sampleTime, static_cast<MotionEvent*>(*outEvent), next);
         }
@@ -912,7 +990,7 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
 
     uint32_t chain = 0;
     for (size_t i = 0; i < count; i++) {
-        InputMessage& msg = batch.samples[i];
+        InputMessage& msg = batch.sample(i);
         updateTouchState(msg);
         if (i) {
             SeqChain seqChain;
@@ -925,7 +1003,7 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
         }
         chain = msg.header.seq;
     }
-    batch.samples.erase(batch.samples.begin(), batch.samples.begin() + count);
+    batch.pop(count);
 
     *outSeq = chain;
     *outEvent = motionEvent;
@@ -1286,23 +1364,30 @@ bool InputConsumer::hasDeferredEvent() const {
 }
 
 bool InputConsumer::hasPendingBatch() const {
-    return !mBatches.empty();
+    return std::any_of(mBatches.begin(), mBatches.end(),
+                       [](const Batch& batch) { return !batch.empty(); });
 }
 
 int32_t InputConsumer::getPendingBatchSource() const {
-    if (mBatches.empty()) {
-        return AINPUT_SOURCE_CLASS_NONE;
+    for (const Batch& batch : mBatches) {
+        if (!batch.empty()) {
+            return batch.sample(0).body.motion.source;
+        }
     }
+    return AINPUT_SOURCE_CLASS_NONE;
+}
 
-    const Batch& batch = mBatches[0];
-    const InputMessage& head = batch.samples[0];
-    return head.body.motion.source;
+void InputConsumer::setResamplingMode(ResamplingMode mode) {
+    mResamplingMode = mode;
 }
 
 ssize_t InputConsumer::findBatch(int32_t deviceId, int32_t source) const {
     for (size_t i = 0; i < mBatches.size(); i++) {
         const Batch& batch = mBatches[i];
-        const InputMessage& head = batch.samples[0];
+        if (batch.empty()) {
+            continue;
+        }
+        const InputMessage& head = batch.sample(0);
         if (head.body.motion.deviceId == deviceId && head.body.motion.source == source) {
             return i;
         }
@@ -1310,6 +1395,15 @@ ssize_t InputConsumer::findBatch(int32_t deviceId, int32_t source) const {
     return -1;
 }
 
+InputConsumer::Batch& InputConsumer::obtainBatch() {
+    for (Batch& batch : mBatches) {
+        if (batch.empty()) {
+            return batch;
+        }
+    }
+    return mBatches.emplace_back();
+}
+
 ssize_t InputConsumer::findTouchState(int32_t deviceId, int32_t source) const {
     for (size_t i = 0; i < mTouchStates.size(); i++) {
         const TouchState& touchState = mTouchStates[i];
@@ -1378,7 +1472,7 @@ void InputConsumer::addSample(MotionEvent* event, const InputMessage* msg) {
 }
 
 bool InputConsumer::canAddSample(const Batch& batch, const InputMessage *msg) {
-    const InputMessage& head = batch.samples[0];
+    const InputMessage& head = batch.sample(0);
     uint32_t pointerCount = msg->body.motion.pointerCount;
     if (head.body.motion.pointerCount != pointerCount
             || head.body.motion.action != msg->body.motion.action) {
@@ -1394,9 +1488,9 @@ bool InputConsumer::canAddSample(const Batch& batch, const InputMessage *msg) {
 }
 
 ssize_t InputConsumer::findSampleNoLaterThan(const Batch& batch, nsecs_t time) {
-    size_t numSamples = batch.samples.size();
+    size_t numSamples = batch.count;
     size_t index = 0;
-    while (index < numSamples && batch.samples[index].body.motion.eventTime <= time) {
+    while (index < numSamples && batch.sample(index).body.motion.eventTime <= time) {
         index += 1;
     }
     return ssize_t(index) - 1;
@@ -1405,6 +1499,7 @@ ssize_t InputConsumer::findSampleNoLaterThan(const Batch& batch, nsecs_t time) {
 std::string InputConsumer::dump() const {
     std::string out;
     out = out + "mResampleTouch = " + toString(mResampleTouch) + "\n";
+    out = out + "mResamplingMode = " + NamedEnum::string(mResamplingMode) + "\n";
     out = out + "mChannel = " + mChannel->getName() + "\n";
     out = out + "mMsgDeferred: " + toString(mMsgDeferred) + "\n";
     if (mMsgDeferred) {
@@ -1412,8 +1507,12 @@ std::string InputConsumer::dump() const {
     }
     out += "Batches:\n";
     for (const Batch& batch : mBatches) {
+        if (batch.empty()) {
+            continue;
+        }
         out += "    Batch:\n";
-        for (const InputMessage& msg : batch.samples) {
+        for (size_t index = 0; index < batch.count; index++) {
+            const InputMessage& msg = batch.sample(index);
             out += android::base::StringPrintf("        Message %" PRIu32 ": %s ", msg.header.seq,
                                                NamedEnum::string(msg.header.type).c_str());
             switch (msg.header.type) {
@@ -1476,7 +1575,7 @@ std::string InputConsumer::dump() const {
             out += "\n";
         }
     }
-    if (mBatches.empty()) {
+    if (!hasPendingBatch()) {
         out += "    <empty>\n";
     }
     out += "mSeqChains:\n";
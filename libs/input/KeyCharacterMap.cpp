@@ -33,6 +33,8 @@
 #include <utils/Tokenizer.h>
 #include <utils/Timers.h>
 
+#include "ParsedFileCache.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -94,6 +96,7 @@ KeyCharacterMap::KeyCharacterMap(const KeyCharacterMap& other)
     for (size_t i = 0; i < other.mKeys.size(); i++) {
         mKeys.add(other.mKeys.keyAt(i), new Key(*other.mKeys.valueAt(i)));
     }
+    buildLookupTables();
 }
 
 KeyCharacterMap::~KeyCharacterMap() {
@@ -147,6 +150,18 @@ bool KeyCharacterMap::operator==(const KeyCharacterMap& other) const {
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::string& filename,
                                                                      Format format) {
+    // Overlays can be combined into the map returned, so each caller gets its own copy.
+    static ParsedFileCache<KeyCharacterMap> sCaches[static_cast<size_t>(Format::ANY) + 1];
+    ParsedFileCache<KeyCharacterMap>& cache = sCaches[static_cast<size_t>(format)];
+    std::optional<FileStamp> stamp = FileStamp::of(filename);
+    if (stamp) {
+        if (std::shared_ptr<KeyCharacterMap> map = cache.get(filename, *stamp)) {
+            std::shared_ptr<KeyCharacterMap> copy = std::make_shared<KeyCharacterMap>(*map);
+            copy->mLoadFileName = filename;
+            return copy;
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
     if (status) {
@@ -156,6 +171,9 @@ base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::
     auto ret = load(t.get(), format);
     if (ret.ok()) {
         (*ret)->mLoadFileName = filename;
+        if (stamp) {
+            cache.put(filename, *stamp, std::make_shared<KeyCharacterMap>(**ret));
+        }
     }
     return ret;
 }
@@ -195,6 +213,7 @@ base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(Tokenizer*
           tokenizer->getFilename().string(), tokenizer->getLineNumber(), elapsedTime / 1000000.0);
 #endif
     if (status == OK) {
+        map->buildLookupTables();
         return map;
     }
 
@@ -224,6 +243,36 @@ void KeyCharacterMap::combine(const KeyCharacterMap& overlay) {
                                          overlay.mKeysByUsageCode.valueAt(i));
     }
     mLoadFileName = overlay.mLoadFileName;
+    buildLookupTables();
+}
+
+void KeyCharacterMap::buildLookupTables() {
+    mKeysByKeyCode.clear();
+    mKeysByCharacter.clear();
+    for (size_t i = 0; i < mKeys.size(); i++) {
+        int32_t keyCode = mKeys.keyAt(i);
+        const Key* key = mKeys.valueAt(i);
+        if (keyCode >= 0 && keyCode < MAX_KEYS) {
+            if (static_cast<size_t>(keyCode) >= mKeysByKeyCode.size()) {
+                mKeysByKeyCode.resize(keyCode + 1, nullptr);
+            }
+            mKeysByKeyCode[keyCode] = key;
+        }
+
+        // The first key, by key code, that generates a character is the one used to type it,
+        // with the most general of its behaviors generating that character. For example, the
+        // base key behavior will usually be last in the list.
+        for (const Behavior* behavior = key->firstBehavior; behavior; behavior = behavior->next) {
+            if (!behavior->character) {
+                continue;
+            }
+            auto [it, inserted] = mKeysByCharacter.try_emplace(behavior->character, keyCode,
+                                                               behavior->metaState);
+            if (!inserted && it->second.first == keyCode) {
+                it->second.second = behavior->metaState;
+            }
+        }
+    }
 }
 
 KeyCharacterMap::KeyboardType KeyCharacterMap::getKeyboardType() const {
@@ -432,6 +481,14 @@ void KeyCharacterMap::tryRemapKey(int32_t keyCode, int32_t metaState,
 }
 
 bool KeyCharacterMap::getKey(int32_t keyCode, const Key** outKey) const {
+    if (keyCode >= 0 && static_cast<size_t>(keyCode) < mKeysByKeyCode.size()) {
+        const Key* key = mKeysByKeyCode[keyCode];
+        if (key) {
+            *outKey = key;
+            return true;
+        }
+        return false;
+    }
     ssize_t index = mKeys.indexOfKey(keyCode);
     if (index >= 0) {
         *outKey = mKeys.valueAt(index);
@@ -493,24 +550,13 @@ bool KeyCharacterMap::findKey(char16_t ch, int32_t* outKeyCode, int32_t* outMeta
         return false;
     }
 
-    for (size_t i = 0; i < mKeys.size(); i++) {
-        const Key* key = mKeys.valueAt(i);
-
-        // Try to find the most general behavior that maps to this character.
-        // For example, the base key behavior will usually be last in the list.
-        const Behavior* found = nullptr;
-        for (const Behavior* behavior = key->firstBehavior; behavior; behavior = behavior->next) {
-            if (behavior->character == ch) {
-                found = behavior;
-            }
-        }
-        if (found) {
-            *outKeyCode = mKeys.keyAt(i);
-            *outMetaState = found->metaState;
-            return true;
-        }
+    auto it = mKeysByCharacter.find(ch);
+    if (it == mKeysByCharacter.end()) {
+        return false;
     }
-    return false;
+    *outKeyCode = it->second.first;
+    *outMetaState = it->second.second;
+    return true;
 }
 
 void KeyCharacterMap::addKey(Vector<KeyEvent>& outEvents,
@@ -686,6 +732,7 @@ std::shared_ptr<KeyCharacterMap> KeyCharacterMap::readFromParcel(Parcel* parcel)
             return nullptr;
         }
     }
+    map->buildLookupTables();
     return map;
 }
 
@@ -28,6 +28,8 @@
 #include <utils/Timers.h>
 #include <utils/Tokenizer.h>
 
+#include "ParsedFileCache.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -87,6 +89,15 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::loadContents(const std
 }
 
 base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string& filename) {
+    // Key layout maps are immutable, so the devices using the same file share a single one.
+    static ParsedFileCache<KeyLayoutMap> sCache;
+    std::optional<FileStamp> stamp = FileStamp::of(filename);
+    if (stamp) {
+        if (std::shared_ptr<KeyLayoutMap> map = sCache.get(filename, *stamp)) {
+            return map;
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
     if (status) {
@@ -97,6 +108,9 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string
     auto ret = load(t.get());
     if (ret.ok()) {
         (*ret)->mLoadFileName = filename;
+        if (stamp) {
+            sCache.put(filename, *stamp, *ret);
+        }
     }
     return ret;
 }
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LIBINPUT_PARSED_FILE_CACHE_H
+#define _LIBINPUT_PARSED_FILE_CACHE_H
+
+#include <sys/stat.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace android {
+
+/**
+ * Identifies the version of a file that was parsed: a file replaced or modified since has another
+ * stamp, unless it was rewritten with the same size within the same modification time.
+ */
+struct FileStamp {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    int64_t modifiedNanos;
+
+    static std::optional<FileStamp> of(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st)) {
+            return std::nullopt;
+        }
+#ifdef __APPLE__
+        const struct timespec& modified = st.st_mtimespec;
+#else
+        const struct timespec& modified = st.st_mtim;
+#endif
+        return FileStamp{st.st_dev, st.st_ino, st.st_size,
+                         modified.tv_sec * 1000000000LL + modified.tv_nsec};
+    }
+
+    bool operator==(const FileStamp& other) const {
+        return device == other.device && inode == other.inode && size == other.size &&
+                modifiedNanos == other.modifiedNanos;
+    }
+};
+
+/**
+ * Keeps what was parsed from input device configuration files by path, so that the devices that
+ * share a file, or that are added again, don't parse it again while it is unchanged. Values are
+ * shared with every caller, so types that can be modified after loading are handed out as copies.
+ */
+template <typename T>
+class ParsedFileCache {
+public:
+    std::shared_ptr<T> get(const std::string& path, const FileStamp& stamp) {
+        std::scoped_lock lock(mLock);
+        auto it = mEntries.find(path);
+        if (it == mEntries.end() || !(it->second.stamp == stamp)) {
+            return nullptr;
+        }
+        return it->second.value;
+    }
+
+    void put(const std::string& path, const FileStamp& stamp, std::shared_ptr<T> value) {
+        std::scoped_lock lock(mLock);
+        mEntries[path] = Entry{stamp, std::move(value)};
+    }
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        std::shared_ptr<T> value;
+    };
+
+    std::mutex mLock;
+    std::unordered_map<std::string, Entry> mEntries;
+};
+
+} // namespace android
+
+#endif // _LIBINPUT_PARSED_FILE_CACHE_H
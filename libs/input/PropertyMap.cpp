@@ -18,6 +18,8 @@
 
 #include <input/PropertyMap.h>
 
+#include "ParsedFileCache.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -108,6 +110,15 @@ void PropertyMap::addAll(const PropertyMap* map) {
 }
 
 android::base::Result<std::unique_ptr<PropertyMap>> PropertyMap::load(const char* filename) {
+    // Devices add their own properties to the map returned, so each caller gets its own copy.
+    static ParsedFileCache<PropertyMap> sCache;
+    std::optional<FileStamp> stamp = FileStamp::of(filename);
+    if (stamp) {
+        if (std::shared_ptr<PropertyMap> map = sCache.get(filename, *stamp)) {
+            return std::make_unique<PropertyMap>(*map);
+        }
+    }
+
     std::unique_ptr<PropertyMap> outMap = std::make_unique<PropertyMap>();
     if (outMap == nullptr) {
         return android::base::Error(NO_MEMORY) << "Error allocating property map.";
@@ -133,6 +144,9 @@ android::base::Result<std::unique_ptr<PropertyMap>> PropertyMap::load(const char
             if (status) {
                 return android::base::Error(BAD_VALUE) << "Could not parse " << filename;
             }
+            if (stamp) {
+                sCache.put(filename, *stamp, std::make_shared<PropertyMap>(*outMap));
+            }
     }
     return std::move(outMap);
 }
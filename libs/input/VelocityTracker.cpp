@@ -416,15 +416,13 @@ void LeastSquaresVelocityTrackerStrategy::addMovement(
  * http://en.wikipedia.org/wiki/Numerical_methods_for_linear_least_squares
  * http://en.wikipedia.org/wiki/Gram-Schmidt
  */
-static bool solveLeastSquares(const std::vector<float>& x, const std::vector<float>& y,
-                              const std::vector<float>& w, uint32_t n, float* outB, float* outDet) {
-    const size_t m = x.size();
+static bool solveLeastSquares(const float* x, const float* y, const float* w, uint32_t m,
+                              uint32_t n, float* outB, float* outDet) {
 #if DEBUG_STRATEGY
     ALOGD("solveLeastSquares: m=%d, n=%d, x=%s, y=%s, w=%s", int(m), int(n),
             vectorToString(x, m).c_str(), vectorToString(y, m).c_str(),
             vectorToString(w, m).c_str());
 #endif
-    LOG_ALWAYS_FATAL_IF(m != y.size() || m != w.size(), "Mismatched vector sizes");
 
     // Expand the X vector to a matrix A, pre-multiplied by the weights.
     float a[n][m]; // column-major order
@@ -537,39 +535,29 @@ static bool solveLeastSquares(const std::vector<float>& x, const std::vector<flo
 }
 
 /*
- * Optimized unweighted second-order least squares fit. About 2x speed improvement compared to
- * the default implementation
+ * Sums of the powers of the sample times of an unweighted second-order least squares fit.
+ * They do not depend on the positions, so they are shared by the fits of both axes.
  */
-static std::optional<std::array<float, 3>> solveUnweightedLeastSquaresDeg2(
-        const std::vector<float>& x, const std::vector<float>& y) {
-    const size_t count = x.size();
-    LOG_ALWAYS_FATAL_IF(count != y.size(), "Mismatching array sizes");
-    // Solving y = a*x^2 + b*x + c
-    float sxi = 0, sxiyi = 0, syi = 0, sxi2 = 0, sxi3 = 0, sxi2yi = 0, sxi4 = 0;
+struct Deg2TimeSums {
+    float sxi = 0, sxi2 = 0, sxi3 = 0, sxi4 = 0;
+};
 
-    for (size_t i = 0; i < count; i++) {
-        float xi = x[i];
-        float yi = y[i];
-        float xi2 = xi*xi;
-        float xi3 = xi2*xi;
-        float xi4 = xi3*xi;
-        float xiyi = xi*yi;
-        float xi2yi = xi2*yi;
-
-        sxi += xi;
-        sxi2 += xi2;
-        sxiyi += xiyi;
-        sxi2yi += xi2yi;
-        syi += yi;
-        sxi3 += xi3;
-        sxi4 += xi4;
-    }
+/*
+ * Sums of the positions of one axis of an unweighted second-order least squares fit.
+ */
+struct Deg2AxisSums {
+    float syi = 0, sxiyi = 0, sxi2yi = 0;
+};
 
-    float Sxx = sxi2 - sxi*sxi / count;
-    float Sxy = sxiyi - sxi*syi / count;
-    float Sxx2 = sxi3 - sxi*sxi2 / count;
-    float Sx2y = sxi2yi - sxi2*syi / count;
-    float Sx2x2 = sxi4 - sxi2*sxi2 / count;
+static std::optional<std::array<float, 3>> fitUnweightedDeg2(const Deg2TimeSums& t,
+                                                             const Deg2AxisSums& a,
+                                                             size_t count) {
+    // Solving y = a*x^2 + b*x + c
+    float Sxx = t.sxi2 - t.sxi*t.sxi / count;
+    float Sxy = a.sxiyi - t.sxi*a.syi / count;
+    float Sxx2 = t.sxi3 - t.sxi*t.sxi2 / count;
+    float Sx2y = a.sxi2yi - t.sxi2*a.syi / count;
+    float Sx2x2 = t.sxi4 - t.sxi2*t.sxi2 / count;
 
     float denominator = Sxx*Sx2x2 - Sxx2*Sxx2;
     if (denominator == 0) {
@@ -578,16 +566,56 @@ static std::optional<std::array<float, 3>> solveUnweightedLeastSquaresDeg2(
     }
     // Compute a
     float numerator = Sx2y*Sxx - Sxy*Sxx2;
-    float a = numerator / denominator;
+    float coeffA = numerator / denominator;
 
     // Compute b
     numerator = Sxy*Sx2x2 - Sx2y*Sxx2;
-    float b = numerator / denominator;
+    float coeffB = numerator / denominator;
 
     // Compute c
-    float c = syi/count - b * sxi/count - a * sxi2/count;
+    float coeffC = a.syi/count - coeffB * t.sxi/count - coeffA * t.sxi2/count;
 
-    return std::make_optional(std::array<float, 3>({c, b, a}));
+    return std::make_optional(std::array<float, 3>({coeffC, coeffB, coeffA}));
+}
+
+/*
+ * Optimized unweighted second-order least squares fit of both axes. About 2x speed improvement
+ * compared to the default implementation. All the sums are accumulated in a single pass over the
+ * samples, and the sums of the powers of the time are only computed once for both axes.
+ */
+static bool solveUnweightedLeastSquaresDeg2(const float* time, const float* x, const float* y,
+                                            size_t count, std::array<float, 3>* outXCoeff,
+                                            std::array<float, 3>* outYCoeff) {
+    Deg2TimeSums t;
+    Deg2AxisSums xs, ys;
+    for (size_t i = 0; i < count; i++) {
+        float xi = time[i];
+        float xi2 = xi*xi;
+        float xi3 = xi2*xi;
+        float xi4 = xi3*xi;
+
+        t.sxi += xi;
+        t.sxi2 += xi2;
+        t.sxi3 += xi3;
+        t.sxi4 += xi4;
+
+        xs.syi += x[i];
+        xs.sxiyi += xi*x[i];
+        xs.sxi2yi += xi2*x[i];
+
+        ys.syi += y[i];
+        ys.sxiyi += xi*y[i];
+        ys.sxi2yi += xi2*y[i];
+    }
+
+    std::optional<std::array<float, 3>> xCoeff = fitUnweightedDeg2(t, xs, count);
+    std::optional<std::array<float, 3>> yCoeff = fitUnweightedDeg2(t, ys, count);
+    if (!xCoeff || !yCoeff) {
+        return false;
+    }
+    *outXCoeff = *xCoeff;
+    *outYCoeff = *yCoeff;
+    return true;
 }
 
 bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
@@ -595,11 +623,11 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
     outEstimator->clear();
 
     // Iterate over movement samples in reverse time order and collect samples.
-    std::vector<float> x;
-    std::vector<float> y;
-    std::vector<float> w;
-    std::vector<float> time;
-
+    float x[HISTORY_SIZE];
+    float y[HISTORY_SIZE];
+    float w[HISTORY_SIZE];
+    float time[HISTORY_SIZE];
+    uint32_t m = 0; // number of points that will be used for fitting
     uint32_t index = mIndex;
     const Movement& newestMovement = mMovements[mIndex];
     do {
@@ -614,14 +642,13 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
         }
 
         const VelocityTracker::Position& position = movement.getPosition(id);
-        x.push_back(position.x);
-        y.push_back(position.y);
-        w.push_back(chooseWeight(index));
-        time.push_back(-age * 0.000000001f);
+        x[m] = position.x;
+        y[m] = position.y;
+        w[m] = chooseWeight(index);
+        time[m] = -age * 0.000000001f;
         index = (index == 0 ? HISTORY_SIZE : index) - 1;
-    } while (x.size() < HISTORY_SIZE);
+    } while (++m < HISTORY_SIZE);
 
-    const size_t m = x.size();
     if (m == 0) {
         return false; // no data
     }
@@ -634,15 +661,15 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
 
     if (degree == 2 && mWeighting == WEIGHTING_NONE) {
         // Optimize unweighted, quadratic polynomial fit
-        std::optional<std::array<float, 3>> xCoeff = solveUnweightedLeastSquaresDeg2(time, x);
-        std::optional<std::array<float, 3>> yCoeff = solveUnweightedLeastSquaresDeg2(time, y);
-        if (xCoeff && yCoeff) {
+        std::array<float, 3> xCoeff;
+        std::array<float, 3> yCoeff;
+        if (solveUnweightedLeastSquaresDeg2(time, x, y, m, &xCoeff, &yCoeff)) {
             outEstimator->time = newestMovement.eventTime;
             outEstimator->degree = 2;
             outEstimator->confidence = 1;
             for (size_t i = 0; i <= outEstimator->degree; i++) {
-                outEstimator->xCoeff[i] = (*xCoeff)[i];
-                outEstimator->yCoeff[i] = (*yCoeff)[i];
+                outEstimator->xCoeff[i] = xCoeff[i];
+                outEstimator->yCoeff[i] = yCoeff[i];
             }
             return true;
         }
@@ -650,8 +677,8 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
         // General case for an Nth degree polynomial fit
         float xdet, ydet;
         uint32_t n = degree + 1;
-        if (solveLeastSquares(time, x, w, n, outEstimator->xCoeff, &xdet) &&
-            solveLeastSquares(time, y, w, n, outEstimator->yCoeff, &ydet)) {
+        if (solveLeastSquares(time, x, w, m, n, outEstimator->xCoeff, &xdet) &&
+            solveLeastSquares(time, y, w, m, n, outEstimator->yCoeff, &ydet)) {
             outEstimator->time = newestMovement.eventTime;
             outEstimator->degree = degree;
             outEstimator->confidence = xdet * ydet;
@@ -1093,13 +1120,20 @@ static float kineticEnergyToVelocity(float work) {
     return (work < 0 ? -1.0 : 1.0) * sqrtf(fabsf(work)) * sqrt2;
 }
 
-static float calculateImpulseVelocity(const nsecs_t* t, const float* x, size_t count) {
+/*
+ * Calculates the impulse velocity of both axes. The time deltas, and the checks on them, are
+ * shared by both axes, so they are computed in a single pass over the samples.
+ */
+static void calculateImpulseVelocity(const nsecs_t* t, const float* x, const float* y,
+                                     size_t count, float* outVx, float* outVy) {
     // The input should be in reversed time order (most recent sample at index i=0)
     // t[i] is in nanoseconds, but due to FP arithmetic, convert to seconds inside this function
     static constexpr float SECONDS_PER_NANO = 1E-9;
 
+    *outVx = 0;
+    *outVy = 0;
     if (count < 2) {
-        return 0; // if 0 or 1 points, velocity is zero
+        return; // if 0 or 1 points, velocity is zero
     }
     if (t[1] > t[0]) { // Algorithm will still work, but not perfectly
         ALOGE("Samples provided to calculateImpulseVelocity in the wrong order");
@@ -1107,25 +1141,36 @@ static float calculateImpulseVelocity(const nsecs_t* t, const float* x, size_t c
     if (count == 2) { // if 2 points, basic linear calculation
         if (t[1] == t[0]) {
             ALOGE("Events have identical time stamps t=%" PRId64 ", setting velocity = 0", t[0]);
-            return 0;
+            return;
         }
-        return (x[1] - x[0]) / (SECONDS_PER_NANO * (t[1] - t[0]));
+        const float dt = SECONDS_PER_NANO * (t[1] - t[0]);
+        *outVx = (x[1] - x[0]) / dt;
+        *outVy = (y[1] - y[0]) / dt;
+        return;
     }
     // Guaranteed to have at least 3 points here
-    float work = 0;
+    float workX = 0;
+    float workY = 0;
     for (size_t i = count - 1; i > 0 ; i--) { // start with the oldest sample and go forward in time
         if (t[i] == t[i-1]) {
             ALOGE("Events have identical time stamps t=%" PRId64 ", skipping sample", t[i]);
             continue;
         }
-        float vprev = kineticEnergyToVelocity(work); // v[i-1]
-        float vcurr = (x[i] - x[i-1]) / (SECONDS_PER_NANO * (t[i] - t[i-1])); // v[i]
-        work += (vcurr - vprev) * fabsf(vcurr);
+        const float dt = SECONDS_PER_NANO * (t[i] - t[i-1]);
+        float vprevX = kineticEnergyToVelocity(workX); // v[i-1]
+        float vprevY = kineticEnergyToVelocity(workY);
+        float vcurrX = (x[i] - x[i-1]) / dt; // v[i]
+        float vcurrY = (y[i] - y[i-1]) / dt;
+        workX += (vcurrX - vprevX) * fabsf(vcurrX);
+        workY += (vcurrY - vprevY) * fabsf(vcurrY);
         if (i == count - 1) {
-            work *= 0.5; // initial condition, case 2) above
+            // initial condition, case 2) above
+            workX *= 0.5;
+            workY *= 0.5;
         }
     }
-    return kineticEnergyToVelocity(work);
+    *outVx = kineticEnergyToVelocity(workX);
+    *outVy = kineticEnergyToVelocity(workY);
 }
 
 bool ImpulseVelocityTrackerStrategy::getEstimator(uint32_t id,
@@ -1162,8 +1207,7 @@ bool ImpulseVelocityTrackerStrategy::getEstimator(uint32_t id,
     }
     outEstimator->xCoeff[0] = 0;
     outEstimator->yCoeff[0] = 0;
-    outEstimator->xCoeff[1] = calculateImpulseVelocity(time, x, m);
-    outEstimator->yCoeff[1] = calculateImpulseVelocity(time, y, m);
+    calculateImpulseVelocity(time, x, y, m, &outEstimator->xCoeff[1], &outEstimator->yCoeff[1]);
     outEstimator->xCoeff[2] = 0;
     outEstimator->yCoeff[2] = 0;
     outEstimator->time = newestMovement.eventTime;
@@ -163,6 +163,55 @@ TEST_F(InputChannelTest, SendSignal_WhenPeerClosed_ReturnsAnError) {
             << "sendMessage should have returned DEAD_OBJECT";
 }
 
+TEST_F(InputChannelTest, SendMessages_SendsMessagesInOrder) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result = InputChannel::openInputChannelPair("channel name",
+            serverChannel, clientChannel);
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+
+    // More messages than a single system call sends, and more than the channel may hold.
+    std::vector<InputMessage> serverMsgs(100);
+    for (size_t i = 0; i < serverMsgs.size(); i++) {
+        serverMsgs[i].header.type = InputMessage::Type::KEY;
+        serverMsgs[i].header.seq = i + 1;
+    }
+    size_t sentCount;
+    result = serverChannel->sendMessages(serverMsgs.data(), serverMsgs.size(), &sentCount);
+    if (sentCount == serverMsgs.size()) {
+        EXPECT_EQ(OK, result);
+    } else {
+        EXPECT_EQ(WOULD_BLOCK, result) << "sendMessages should only stop when the channel is full";
+    }
+    ASSERT_GT(sentCount, 0u);
+
+    InputMessage clientMsg;
+    for (size_t i = 0; i < sentCount; i++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg));
+        EXPECT_EQ(InputMessage::Type::KEY, clientMsg.header.type);
+        EXPECT_EQ(i + 1, clientMsg.header.seq);
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&clientMsg))
+            << "only the messages that were sent should be received";
+}
+
+TEST_F(InputChannelTest, SendMessages_WhenPeerClosed_ReturnsAnError) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result = InputChannel::openInputChannelPair("channel name",
+            serverChannel, clientChannel);
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+
+    serverChannel.reset(); // close server channel
+
+    InputMessage msg = {};
+    msg.header.type = InputMessage::Type::KEY;
+    size_t sentCount;
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->sendMessages(&msg, 1, &sentCount))
+            << "sendMessages should have returned DEAD_OBJECT";
+    EXPECT_EQ(0u, sentCount);
+}
+
 TEST_F(InputChannelTest, SendAndReceive_MotionClassification) {
     std::unique_ptr<InputChannel> serverChannel, clientChannel;
     status_t result = InputChannel::openInputChannelPair("channel name",
@@ -82,4 +82,42 @@ TEST_F(InputDeviceKeyMapTest, keyCharacterMapParcelingTest) {
     ASSERT_EQ(*map, *mKeyMap.keyCharacterMap);
 }
 
+TEST_F(InputDeviceKeyMapTest, keyCharacterMapLookupsAfterParcelingTest) {
+    Parcel parcel;
+    mKeyMap.keyCharacterMap->writeToParcel(&parcel);
+    parcel.setDataPosition(0);
+    std::shared_ptr<KeyCharacterMap> map = KeyCharacterMap::readFromParcel(&parcel);
+    ASSERT_NE(nullptr, map);
+    for (int32_t keyCode = 0; keyCode <= AKEYCODE_PROFILE_SWITCH; keyCode++) {
+        ASSERT_EQ(mKeyMap.keyCharacterMap->getDisplayLabel(keyCode), map->getDisplayLabel(keyCode));
+        ASSERT_EQ(mKeyMap.keyCharacterMap->getCharacter(keyCode, AMETA_SHIFT_ON),
+                  map->getCharacter(keyCode, AMETA_SHIFT_ON));
+    }
+
+    const char16_t chars[] = {u'a'};
+    Vector<KeyEvent> events;
+    ASSERT_TRUE(map->getEvents(/*deviceId=*/1, chars, 1, events));
+    ASSERT_EQ(2u, events.size());
+    ASSERT_EQ(AKEYCODE_A, events[0].getKeyCode());
+    ASSERT_EQ(AKEY_EVENT_ACTION_DOWN, events[0].getAction());
+    ASSERT_EQ(AKEYCODE_A, events[1].getKeyCode());
+    ASSERT_EQ(AKEY_EVENT_ACTION_UP, events[1].getAction());
+}
+
+TEST_F(InputDeviceKeyMapTest, keyLayoutMapIsSharedWhileFileIsUnchanged) {
+    base::Result<std::shared_ptr<KeyLayoutMap>> ret = KeyLayoutMap::load(mKeyMap.keyLayoutFile);
+    ASSERT_TRUE(ret.ok()) << "Cannot load KeyLayout at " << mKeyMap.keyLayoutFile;
+    ASSERT_EQ(mKeyMap.keyLayoutMap, *ret);
+}
+
+TEST_F(InputDeviceKeyMapTest, keyCharacterMapIsCopiedWhileFileIsUnchanged) {
+    base::Result<std::shared_ptr<KeyCharacterMap>> ret =
+            KeyCharacterMap::load(mKeyMap.keyCharacterMapFile, KeyCharacterMap::Format::BASE);
+    ASSERT_TRUE(ret.ok()) << "Cannot load KeyCharacterMap at " << mKeyMap.keyCharacterMapFile;
+    // Overlays are combined into the map of each device, so it can't be shared.
+    ASSERT_NE(mKeyMap.keyCharacterMap, *ret);
+    ASSERT_EQ(*mKeyMap.keyCharacterMap, **ret);
+    ASSERT_EQ(mKeyMap.keyCharacterMapFile, (*ret)->getLoadFileName());
+}
+
 } // namespace android
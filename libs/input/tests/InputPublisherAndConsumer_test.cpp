@@ -55,8 +55,30 @@ protected:
     void PublishAndConsumeFocusEvent();
     void PublishAndConsumeCaptureEvent();
     void PublishAndConsumeDragEvent();
+    void PublishTouchEvent(uint32_t seq, int32_t action, nsecs_t eventTime, float x);
 };
 
+void InputPublisherAndConsumerTest::PublishTouchEvent(uint32_t seq, int32_t action,
+                                                      nsecs_t eventTime, float x) {
+    PointerProperties pointerProperties;
+    pointerProperties.clear();
+    pointerProperties.toolType = AMOTION_EVENT_TOOL_TYPE_FINGER;
+    PointerCoords pointerCoords;
+    pointerCoords.clear();
+    pointerCoords.setAxisValue(AMOTION_EVENT_AXIS_X, x);
+    pointerCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, 0);
+
+    ui::Transform identityTransform;
+    ASSERT_EQ(OK,
+              mPublisher->publishMotionEvent(seq, InputEvent::nextId(), 1,
+                                             AINPUT_SOURCE_TOUCHSCREEN, ADISPLAY_ID_DEFAULT,
+                                             INVALID_HMAC, action, 0, 0, 0, 0, 0,
+                                             MotionClassification::NONE, identityTransform, 0, 0,
+                                             AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                             AMOTION_EVENT_INVALID_CURSOR_POSITION, 0, 0, 0,
+                                             eventTime, 1, &pointerProperties, &pointerCoords));
+}
+
 TEST_F(InputPublisherAndConsumerTest, GetChannel_ReturnsTheChannel) {
     ASSERT_NE(nullptr, mPublisher->getChannel());
     ASSERT_NE(nullptr, mConsumer->getChannel());
@@ -503,6 +525,118 @@ TEST_F(InputPublisherAndConsumerTest,
             << "publisher publishMotionEvent should return BAD_VALUE";
 }
 
+TEST_F(InputPublisherAndConsumerTest, PublishBatch_SendsEventsOnFlush) {
+    mPublisher->beginBatch();
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(1, InputEvent::nextId(), true, true));
+    ASSERT_EQ(OK, mPublisher->publishCaptureEvent(2, InputEvent::nextId(), true));
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(WOULD_BLOCK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event))
+            << "events should not be sent before the batch is flushed";
+
+    size_t publishedCount;
+    ASSERT_EQ(OK, mPublisher->flush(&publishedCount));
+    EXPECT_EQ(2u, publishedCount);
+
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event));
+    EXPECT_EQ(AINPUT_EVENT_TYPE_FOCUS, event->getType());
+    EXPECT_EQ(1u, consumeSeq);
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event));
+    EXPECT_EQ(AINPUT_EVENT_TYPE_CAPTURE, event->getType());
+    EXPECT_EQ(2u, consumeSeq);
+
+    // Events published after the flush are sent right away.
+    ASSERT_NO_FATAL_FAILURE(PublishAndConsumeKeyEvent());
+}
+
+TEST_F(InputPublisherAndConsumerTest, PublishBatch_WhenPeerClosed_ReturnsAnError) {
+    mPublisher->beginBatch();
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(1, InputEvent::nextId(), true, true));
+    mConsumer.reset();
+    mClientChannel.reset();
+
+    size_t publishedCount;
+    EXPECT_EQ(DEAD_OBJECT, mPublisher->flush(&publishedCount));
+    EXPECT_EQ(0u, publishedCount);
+}
+
+TEST_F(InputPublisherAndConsumerTest, ConsumeBatch_WhenManyMoves_ConsumesAllSamples) {
+    constexpr uint32_t moveCount = 40;
+    ASSERT_NO_FATAL_FAILURE(PublishTouchEvent(1, AMOTION_EVENT_ACTION_DOWN, 0, 0));
+    for (uint32_t i = 1; i <= moveCount; i++) {
+        ASSERT_NO_FATAL_FAILURE(
+                PublishTouchEvent(i + 1, AMOTION_EVENT_ACTION_MOVE, i * 1000000, i));
+    }
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq, &event));
+    EXPECT_EQ(1u, consumeSeq);
+
+    size_t sampleCount = 0;
+    nsecs_t lastEventTime = 0;
+    while (mConsumer->consume(&mEventFactory, true /*consumeBatches*/, -1, &consumeSeq,
+                              &event) == OK) {
+        ASSERT_EQ(AINPUT_EVENT_TYPE_MOTION, event->getType());
+        const MotionEvent& motionEvent = static_cast<const MotionEvent&>(*event);
+        EXPECT_EQ(AMOTION_EVENT_ACTION_MOVE, motionEvent.getAction());
+        EXPECT_LT(lastEventTime, motionEvent.getHistoricalEventTime(0));
+        lastEventTime = motionEvent.getEventTime();
+        sampleCount += motionEvent.getHistorySize() + 1;
+    }
+    EXPECT_EQ(moveCount, sampleCount);
+    EXPECT_EQ(moveCount * 1000000, lastEventTime);
+    EXPECT_FALSE(mConsumer->hasPendingBatch());
+}
+
+TEST_F(InputPublisherAndConsumerTest, ConsumeBatch_ResamplesToFrameTime) {
+    ASSERT_NO_FATAL_FAILURE(PublishTouchEvent(1, AMOTION_EVENT_ACTION_DOWN, 0, 0));
+    ASSERT_NO_FATAL_FAILURE(PublishTouchEvent(2, AMOTION_EVENT_ACTION_MOVE, 10000000, 10));
+    ASSERT_NO_FATAL_FAILURE(PublishTouchEvent(3, AMOTION_EVENT_ACTION_MOVE, 20000000, 20));
+    ASSERT_EQ(InputConsumer::ResamplingMode::INTERPOLATE, mConsumer->getResamplingMode());
+
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, false /*consumeBatches*/, -1, &consumeSeq,
+                                 &event));
+    EXPECT_EQ(1u, consumeSeq);
+    ASSERT_EQ(WOULD_BLOCK,
+              mConsumer->consume(&mEventFactory, false /*consumeBatches*/, -1, &consumeSeq,
+                                 &event));
+    ASSERT_TRUE(mConsumer->hasPendingBatch());
+
+    // Interpolation resamples behind the frame time, and keeps the later sample for the next
+    // frame.
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, 24000000, &consumeSeq,
+                                 &event));
+    const MotionEvent* motionEvent = static_cast<const MotionEvent*>(event);
+    EXPECT_EQ(2u, consumeSeq);
+    EXPECT_EQ(19000000, motionEvent->getEventTime());
+    EXPECT_FLOAT_EQ(19, motionEvent->getX(0));
+    EXPECT_TRUE(mConsumer->hasPendingBatch());
+
+    ASSERT_NO_FATAL_FAILURE(PublishTouchEvent(4, AMOTION_EVENT_ACTION_MOVE, 30000000, 30));
+    mConsumer->setResamplingMode(InputConsumer::ResamplingMode::PREDICT);
+
+    // Prediction consumes every sample up to the frame time and extrapolates to it.
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, true /*consumeBatches*/, 34000000, &consumeSeq,
+                                 &event));
+    motionEvent = static_cast<const MotionEvent*>(event);
+    EXPECT_EQ(4u, consumeSeq);
+    EXPECT_EQ(2u, motionEvent->getHistorySize());
+    EXPECT_EQ(34000000, motionEvent->getEventTime());
+    EXPECT_FLOAT_EQ(34, motionEvent->getX(0));
+    EXPECT_FALSE(mConsumer->hasPendingBatch());
+}
+
 TEST_F(InputPublisherAndConsumerTest, PublishMultipleEvents_EndToEnd) {
     ASSERT_NO_FATAL_FAILURE(PublishAndConsumeMotionEvent());
     ASSERT_NO_FATAL_FAILURE(PublishAndConsumeKeyEvent());
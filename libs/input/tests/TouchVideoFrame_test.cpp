@@ -68,6 +68,18 @@ TEST(TouchVideoFrame, Equality) {
     ASSERT_FALSE(frame == changedTimestampFrame);
 }
 
+TEST(TouchVideoFrame, CopiesShareDataUntilRotated) {
+    const std::vector<int16_t> data = {1, 2, 3, 4, 5, 6};
+    TouchVideoFrame frame(3, 2, data, TIMESTAMP);
+
+    TouchVideoFrame copy(frame);
+    ASSERT_EQ(frame.getData().data(), copy.getData().data());
+
+    copy.rotate(DISPLAY_ORIENTATION_180);
+    ASSERT_EQ(data, frame.getData());
+    ASSERT_EQ((std::vector<int16_t>{6, 5, 4, 3, 2, 1}), copy.getData());
+}
+
 // --- Rotate 90 degrees ---
 
 TEST(TouchVideoFrame, Rotate90_0x0) {
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <input/VelocityTracker.h>
+
+#include <vector>
+
+// Usage: atest libinput_benchmarks
+
+namespace android {
+namespace {
+
+// The number of movements held by the strategies that keep a history.
+constexpr size_t MOVEMENT_COUNT = 20;
+
+constexpr nsecs_t MOVEMENT_INTERVAL = 4 * 1000000; // 4 ms, as on a 240Hz touchscreen
+
+// Fills a velocity tracker with a fling of the requested number of pointers, then queries the
+// velocity of every pointer, as an app does when the fling ends.
+void benchmarkGetVelocity(benchmark::State& state, VelocityTracker::Strategy strategy) {
+    const uint32_t pointerCount = static_cast<uint32_t>(state.range(0));
+    VelocityTracker tracker(strategy);
+    BitSet32 idBits;
+    for (uint32_t id = 0; id < pointerCount; id++) {
+        idBits.markBit(id);
+    }
+    std::vector<VelocityTracker::Position> positions(pointerCount);
+    for (size_t i = 0; i < MOVEMENT_COUNT; i++) {
+        for (uint32_t id = 0; id < pointerCount; id++) {
+            // Accelerate, so that the polynomial fits are not degenerate.
+            positions[id].x = 100 + id * 50 + i * i * 2.5f;
+            positions[id].y = 1500 - id * 50 - i * i * 4.0f;
+        }
+        tracker.addMovement(i * MOVEMENT_INTERVAL, idBits, positions);
+    }
+
+    for (auto _ : state) {
+        for (uint32_t id = 0; id < pointerCount; id++) {
+            float vx, vy;
+            tracker.getVelocity(id, &vx, &vy);
+            benchmark::DoNotOptimize(vx);
+            benchmark::DoNotOptimize(vy);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * pointerCount);
+}
+
+// The default strategy, an unweighted second-degree fit.
+void benchmarkGetVelocityLsq2(benchmark::State& state) {
+    benchmarkGetVelocity(state, VelocityTracker::Strategy::LSQ2);
+}
+BENCHMARK(benchmarkGetVelocityLsq2)->Arg(1)->Arg(10);
+
+// A weighted second-degree fit, which uses the general least squares solver.
+void benchmarkGetVelocityWlsq2Delta(benchmark::State& state) {
+    benchmarkGetVelocity(state, VelocityTracker::Strategy::WLSQ2_DELTA);
+}
+BENCHMARK(benchmarkGetVelocityWlsq2Delta)->Arg(1)->Arg(10);
+
+void benchmarkGetVelocityLsq3(benchmark::State& state) {
+    benchmarkGetVelocity(state, VelocityTracker::Strategy::LSQ3);
+}
+BENCHMARK(benchmarkGetVelocityLsq3)->Arg(1)->Arg(10);
+
+void benchmarkGetVelocityImpulse(benchmark::State& state) {
+    benchmarkGetVelocity(state, VelocityTracker::Strategy::IMPULSE);
+}
+BENCHMARK(benchmarkGetVelocityImpulse)->Arg(1)->Arg(10);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
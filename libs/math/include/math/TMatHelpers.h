@@ -24,6 +24,7 @@
 #include <exception>
 #include <iomanip>
 #include <stdexcept>
+#include <type_traits>
 
 #include <math/quat.h>
 #include <math/TVecHelpers.h>
@@ -49,6 +50,14 @@
 #define CONSTEXPR
 #endif
 
+// Products of 4x4 float matrices are written with vector extensions, which compile to NEON or
+// SSE, unless they are constant evaluated.
+#if __cplusplus >= 201703L && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated) && (defined(__ARM_NEON) || defined(__SSE2__))
+#define SIMD_DEFINED_LOCAL
+#endif
+#endif
+
 namespace android {
 namespace details {
 // -------------------------------------------------------------------------------------
@@ -66,6 +75,52 @@ namespace details {
 
 namespace matrix {
 
+#ifdef SIMD_DEFINED_LOCAL
+namespace simd {
+
+typedef float v4sf __attribute__((vector_size(16)));
+
+template <typename MATRIX>
+struct is_mat44f : std::integral_constant<bool,
+        MATRIX::NUM_COLS == 4 && MATRIX::NUM_ROWS == 4 &&
+        std::is_same<typename MATRIX::value_type, float>::value> {};
+
+// Matrices and vectors are only aligned to their elements, so these compile to unaligned
+// loads and stores.
+inline v4sf load(const float* p) {
+    v4sf v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store(float* p, v4sf v) {
+    __builtin_memcpy(p, &v, sizeof(v));
+}
+
+// Sums the columns c0 to c3 scaled by the elements of v, in the order of the generic code.
+inline v4sf combine(v4sf c0, v4sf c1, v4sf c2, v4sf c3, const float* v) {
+    return c0 * v[0] + c1 * v[1] + c2 * v[2] + c3 * v[3];
+}
+
+// result = lhs * rhs, for column-major 4x4 matrices. result may alias rhs but not lhs.
+inline void multiply(const float* lhs, const float* rhs, float* result) {
+    const v4sf c0 = load(lhs);
+    const v4sf c1 = load(lhs + 4);
+    const v4sf c2 = load(lhs + 8);
+    const v4sf c3 = load(lhs + 12);
+    for (size_t col = 0; col < 4; ++col) {
+        store(result + col * 4, combine(c0, c1, c2, c3, rhs + col * 4));
+    }
+}
+
+// result = m * v, for a column-major 4x4 matrix.
+inline void transform(const float* m, const float* v, float* result) {
+    store(result, combine(load(m), load(m + 4), load(m + 8), load(m + 12), v));
+}
+
+}  // namespace simd
+#endif  // SIMD_DEFINED_LOCAL
+
 inline constexpr int     transpose(int v)    { return v; }
 inline constexpr float   transpose(float v)  { return v; }
 inline constexpr double  transpose(double v) { return v; }
@@ -224,6 +279,57 @@ CONSTEXPR MATRIX PURE fastInverse3(const MATRIX& x) {
     return inverted;
 }
 
+//------------------------------------------------------------------------------
+// Cofactor expansion over the 2x2 minors of the first two and last two columns, as
+// described in "The Laplace Expansion Theorem: Computing the Determinants and Inverses
+// of Matrices" by David Eberly. Unlike the generic Gauss-Jordan elimination, this has
+// no branches nor divisions but the last one, so it is faster and vectorizes well.
+template <typename MATRIX>
+CONSTEXPR MATRIX PURE fastInverse4(const MATRIX& x) {
+    typedef typename MATRIX::value_type T;
+
+    // The expansion holds for the transpose too, so the column-major elements can be used
+    // as if they were row-major.
+    const T s0 = x[0][0] * x[1][1] - x[1][0] * x[0][1];
+    const T s1 = x[0][0] * x[1][2] - x[1][0] * x[0][2];
+    const T s2 = x[0][0] * x[1][3] - x[1][0] * x[0][3];
+    const T s3 = x[0][1] * x[1][2] - x[1][1] * x[0][2];
+    const T s4 = x[0][1] * x[1][3] - x[1][1] * x[0][3];
+    const T s5 = x[0][2] * x[1][3] - x[1][2] * x[0][3];
+
+    const T c5 = x[2][2] * x[3][3] - x[3][2] * x[2][3];
+    const T c4 = x[2][1] * x[3][3] - x[3][1] * x[2][3];
+    const T c3 = x[2][1] * x[3][2] - x[3][1] * x[2][2];
+    const T c2 = x[2][0] * x[3][3] - x[3][0] * x[2][3];
+    const T c1 = x[2][0] * x[3][2] - x[3][0] * x[2][2];
+    const T c0 = x[2][0] * x[3][1] - x[3][0] * x[2][1];
+
+    const T det(s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+    const T invdet = T(1) / det;
+
+    MATRIX inverted(MATRIX::NO_INIT);
+    inverted[0][0] = ( x[1][1] * c5 - x[1][2] * c4 + x[1][3] * c3) * invdet;
+    inverted[0][1] = (-x[0][1] * c5 + x[0][2] * c4 - x[0][3] * c3) * invdet;
+    inverted[0][2] = ( x[3][1] * s5 - x[3][2] * s4 + x[3][3] * s3) * invdet;
+    inverted[0][3] = (-x[2][1] * s5 + x[2][2] * s4 - x[2][3] * s3) * invdet;
+
+    inverted[1][0] = (-x[1][0] * c5 + x[1][2] * c2 - x[1][3] * c1) * invdet;
+    inverted[1][1] = ( x[0][0] * c5 - x[0][2] * c2 + x[0][3] * c1) * invdet;
+    inverted[1][2] = (-x[3][0] * s5 + x[3][2] * s2 - x[3][3] * s1) * invdet;
+    inverted[1][3] = ( x[2][0] * s5 - x[2][2] * s2 + x[2][3] * s1) * invdet;
+
+    inverted[2][0] = ( x[1][0] * c4 - x[1][1] * c2 + x[1][3] * c0) * invdet;
+    inverted[2][1] = (-x[0][0] * c4 + x[0][1] * c2 - x[0][3] * c0) * invdet;
+    inverted[2][2] = ( x[3][0] * s4 - x[3][1] * s2 + x[3][3] * s0) * invdet;
+    inverted[2][3] = (-x[2][0] * s4 + x[2][1] * s2 - x[2][3] * s0) * invdet;
+
+    inverted[3][0] = (-x[1][0] * c3 + x[1][1] * c1 - x[1][2] * c0) * invdet;
+    inverted[3][1] = ( x[0][0] * c3 - x[0][1] * c1 + x[0][2] * c0) * invdet;
+    inverted[3][2] = (-x[3][0] * s3 + x[3][1] * s1 - x[3][2] * s0) * invdet;
+    inverted[3][3] = ( x[2][0] * s3 - x[2][1] * s1 + x[2][2] * s0) * invdet;
+    return inverted;
+}
+
 /**
  * Inversion function which switches on the matrix size.
  * @warning This function assumes the matrix is invertible. The result is
@@ -235,7 +341,8 @@ inline constexpr MATRIX PURE inverse(const MATRIX& matrix) {
     static_assert(MATRIX::NUM_ROWS == MATRIX::NUM_COLS, "only square matrices can be inverted");
     return (MATRIX::NUM_ROWS == 2) ? fastInverse2<MATRIX>(matrix) :
           ((MATRIX::NUM_ROWS == 3) ? fastInverse3<MATRIX>(matrix) :
-                    gaussJordanInverse<MATRIX>(matrix));
+          ((MATRIX::NUM_ROWS == 4) ? fastInverse4<MATRIX>(matrix) :
+                    gaussJordanInverse<MATRIX>(matrix)));
 }
 
 template<typename MATRIX_R, typename MATRIX_A, typename MATRIX_B>
@@ -253,12 +360,42 @@ CONSTEXPR MATRIX_R PURE multiply(const MATRIX_A& lhs, const MATRIX_B& rhs) {
             "invalid dimension of matrix multiply result.");
 
     MATRIX_R res(MATRIX_R::NO_INIT);
+#ifdef SIMD_DEFINED_LOCAL
+    if constexpr (simd::is_mat44f<MATRIX_R>::value && simd::is_mat44f<MATRIX_A>::value &&
+                  simd::is_mat44f<MATRIX_B>::value) {
+        if (!__builtin_is_constant_evaluated()) {
+            simd::multiply(lhs.asArray(), rhs.asArray(), &res[0][0]);
+            return res;
+        }
+    }
+#endif
     for (size_t col = 0; col < MATRIX_R::NUM_COLS; ++col) {
         res[col] = lhs * rhs[col];
     }
     return res;
 }
 
+// matrix * column-vector, for square matrices whose columns are VECTOR
+template<typename VECTOR, typename MATRIX, typename V>
+CONSTEXPR VECTOR PURE transform(const MATRIX& lhs, const V& rhs) {
+#ifdef SIMD_DEFINED_LOCAL
+    if constexpr (simd::is_mat44f<MATRIX>::value &&
+                  std::is_same<typename V::value_type, float>::value) {
+        if (!__builtin_is_constant_evaluated()) {
+            VECTOR result(VECTOR::NO_INIT);
+            simd::transform(lhs.asArray(), &rhs[0], &result[0]);
+            return result;
+        }
+    }
+#endif
+    // Result is initialized to zero.
+    VECTOR result;
+    for (size_t col = 0; col < MATRIX::NUM_COLS; ++col) {
+        result += lhs[col] * rhs[col];
+    }
+    return result;
+}
+
 // transpose. this handles matrices of matrices
 template <typename MATRIX>
 CONSTEXPR MATRIX PURE transpose(const MATRIX& m) {
@@ -640,5 +777,9 @@ public:
 #undef UNLIKELY
 #endif //LIKELY_DEFINED_LOCAL
 
+#ifdef SIMD_DEFINED_LOCAL
+#undef SIMD_DEFINED_LOCAL
+#endif
+
 #undef PURE
 #undef CONSTEXPR
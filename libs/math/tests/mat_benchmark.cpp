@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math/mat4.h>
+
+#include <vector>
+
+// Usage: atest mat_benchmark
+
+namespace android {
+namespace {
+
+// A color matrix, like the ones that SurfaceFlinger composes for each layer.
+const mat4 kColorMatrix(0.8f, 0.1f, 0.1f, 0.0f,
+                        0.2f, 0.7f, 0.1f, 0.0f,
+                        0.1f, 0.1f, 0.8f, 0.0f,
+                        0.01f, 0.02f, 0.03f, 1.0f);
+
+// A transform with a rotation, a scale and a translation.
+const mat4 kTransform = mat4::translate(vec4(100.0f, 200.0f, 0.0f, 1.0f)) *
+        mat4::rotate(0.5f, vec3(0.0f, 0.0f, 1.0f)) * mat4::scale(vec4(2.0f, 3.0f, 1.0f, 1.0f));
+
+// The generic element by element product, as a baseline.
+mat4 scalarMultiply(const mat4& lhs, const mat4& rhs) {
+    mat4 result(mat4::NO_INIT);
+    for (size_t col = 0; col < 4; ++col) {
+        for (size_t row = 0; row < 4; ++row) {
+            float sum = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                sum += lhs[i][row] * rhs[col][i];
+            }
+            result[col][row] = sum;
+        }
+    }
+    return result;
+}
+
+void BM_Mat4Multiply(benchmark::State& state) {
+    mat4 m = kColorMatrix;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(m * kTransform);
+    }
+}
+BENCHMARK(BM_Mat4Multiply);
+
+void BM_Mat4MultiplyScalar(benchmark::State& state) {
+    mat4 m = kColorMatrix;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(scalarMultiply(m, kTransform));
+    }
+}
+BENCHMARK(BM_Mat4MultiplyScalar);
+
+// Transforms a batch of points, like the corners of the layers of a frame.
+void BM_Mat4Transform(benchmark::State& state) {
+    std::vector<vec4> points(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = vec4(float(i), float(i * 2), 0.0f, 1.0f);
+    }
+    for (auto _ : state) {
+        for (const vec4& point : points) {
+            benchmark::DoNotOptimize(kTransform * point);
+        }
+    }
+}
+BENCHMARK(BM_Mat4Transform)->Arg(4)->Arg(64);
+
+void BM_Mat4Inverse(benchmark::State& state) {
+    mat4 m = kTransform;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(inverse(m));
+    }
+}
+BENCHMARK(BM_Mat4Inverse);
+
+// The generic Gauss-Jordan elimination with partial pivoting, as a baseline.
+void BM_Mat4InverseGaussJordan(benchmark::State& state) {
+    mat4 m = kTransform;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(details::matrix::gaussJordanInverse(m));
+    }
+}
+BENCHMARK(BM_Mat4InverseGaussJordan);
+
+}  // namespace
+}  // namespace android
+
+BENCHMARK_MAIN();
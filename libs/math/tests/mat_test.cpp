@@ -421,6 +421,50 @@ TYPED_TEST(MatTestT, Inverse4) {
     TEST_MATRIX_INVERSE(m5, 20.0 * std::numeric_limits<TypeParam>::epsilon());
 }
 
+//------------------------------------------------------------------------------
+// The products and inverse of 4x4 float matrices have their own code, so check them
+// against the double ones.
+TEST_F(MatTest, Mat4MatchesMat4d) {
+    std::default_random_engine generator(1);
+    std::uniform_real_distribution<float> distribution(-10, 10);
+
+    for (size_t i = 0; i < 100; ++i) {
+        float a[16], b[16];
+        for (size_t j = 0; j < 16; ++j) {
+            a[j] = distribution(generator);
+            b[j] = distribution(generator);
+        }
+        // Keep a well conditioned to invert it.
+        for (size_t j = 0; j < 16; j += 5) {
+            a[j] += 40;
+        }
+
+        // Pointers, not arrays, select the raw array constructor.
+        const float* pa = a;
+        const float* pb = b;
+        const mat4 fa(pa), fb(pb);
+        const mat4d da(pa), db(pb);
+        const vec4 fv = fb[0];
+        const double4 dv(fv);
+
+        const mat4 product = fa * fb;
+        const mat4d expectedProduct = da * db;
+        const vec4 transformed = fa * fv;
+        const double4 expectedTransformed = da * dv;
+        const mat4 inverted = inverse(fa);
+        const mat4d expectedInverted = inverse(da);
+        const mat4 identity = fa * inverted;
+        for (size_t col = 0; col < 4; ++col) {
+            EXPECT_NEAR(transformed[col], expectedTransformed[col], 1e-3);
+            for (size_t row = 0; row < 4; ++row) {
+                EXPECT_NEAR(product[col][row], expectedProduct[col][row], 1e-3);
+                EXPECT_NEAR(inverted[col][row], expectedInverted[col][row], 1e-6);
+                EXPECT_NEAR(identity[col][row], col == row ? 1 : 0, 1e-5);
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 TYPED_TEST(MatTestT, Inverse3) {
     typedef ::android::details::TMat33<TypeParam> M33T;
@@ -26,11 +26,12 @@
 #include <utils/Looper.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <mutex>
 #include <optional>
-#include <queue>
 #include <thread>
+#include <vector>
 
 namespace {
 struct {
@@ -80,12 +81,6 @@ struct FrameCallback {
     AChoreographer_frameCallback64 callback64;
     void* data;
     nsecs_t dueTime;
-
-    inline bool operator<(const FrameCallback& rhs) const {
-        // Note that this is intentionally flipped because we want callbacks due sooner to be at
-        // the head of the queue
-        return dueTime > rhs.dueTime;
-    }
 };
 
 struct RefreshRateCallback {
@@ -147,10 +142,15 @@ private:
     void scheduleCallbacks();
 
     std::mutex mLock;
-    // Protected by mLock
-    std::priority_queue<FrameCallback> mFrameCallbacks;
+    // Protected by mLock. Sorted by due time, callbacks due at the same time in the order they
+    // were posted. Most are posted for the next frame and just appended, and the vector keeps
+    // its capacity from frame to frame, so posting doesn't allocate.
+    std::vector<FrameCallback> mFrameCallbacks;
     std::vector<RefreshRateCallback> mRefreshRateCallbacks;
 
+    // The callbacks being dispatched, only used by dispatchVsync; kept to reuse its capacity.
+    std::vector<FrameCallback> mDispatchedCallbacks;
+
     nsecs_t mLatestVsyncPeriod = -1;
     VsyncEventData mLastVsyncEventData;
 
@@ -217,7 +217,11 @@ void Choreographer::postFrameCallbackDelayed(
     FrameCallback callback{cb, cb64, data, now + delay};
     {
         std::lock_guard<std::mutex> _l{mLock};
-        mFrameCallbacks.push(callback);
+        auto it = std::upper_bound(mFrameCallbacks.begin(), mFrameCallbacks.end(), callback,
+                                   [](const FrameCallback& lhs, const FrameCallback& rhs) {
+                                       return lhs.dueTime < rhs.dueTime;
+                                   });
+        mFrameCallbacks.insert(it, callback);
     }
     if (callback.dueTime <= now) {
         if (std::this_thread::get_id() != mThreadId) {
@@ -321,7 +325,7 @@ void Choreographer::scheduleCallbacks() {
         if (mFrameCallbacks.empty()) {
             return;
         }
-        dueTime = mFrameCallbacks.top().dueTime;
+        dueTime = mFrameCallbacks.front().dueTime;
     }
 
     if (dueTime <= now) {
@@ -358,14 +362,15 @@ void Choreographer::handleRefreshRateUpdates() {
 // the internal display implicitly.
 void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t,
                                   VsyncEventData vsyncEventData) {
-    std::vector<FrameCallback> callbacks{};
+    // Taken rather than used in place, in case a callback dispatches events itself.
+    std::vector<FrameCallback> callbacks = std::move(mDispatchedCallbacks);
     {
         std::lock_guard<std::mutex> _l{mLock};
         nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
-        while (!mFrameCallbacks.empty() && mFrameCallbacks.top().dueTime < now) {
-            callbacks.push_back(mFrameCallbacks.top());
-            mFrameCallbacks.pop();
-        }
+        auto due = std::find_if(mFrameCallbacks.begin(), mFrameCallbacks.end(),
+                                [now](const FrameCallback& cb) { return cb.dueTime >= now; });
+        callbacks.assign(mFrameCallbacks.begin(), due);
+        mFrameCallbacks.erase(mFrameCallbacks.begin(), due);
     }
     mLastVsyncEventData = vsyncEventData;
     for (const auto& cb : callbacks) {
@@ -375,6 +380,8 @@ void Choreographer::dispatchVsync(nsecs_t timestamp, PhysicalDisplayId, uint32_t
             cb.callback(timestamp, cb.data);
         }
     }
+    callbacks.clear();
+    mDispatchedCallbacks = std::move(callbacks);
 }
 
 void Choreographer::dispatchHotplug(nsecs_t, PhysicalDisplayId displayId, bool connected) {
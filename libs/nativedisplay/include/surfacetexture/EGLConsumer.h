@@ -23,6 +23,8 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/Mutex.h>
 
+#include <unordered_map>
+
 namespace android {
 
 class SurfaceTexture;
@@ -167,6 +169,14 @@ protected:
     public:
         EglImage(sp<GraphicBuffer> graphicBuffer);
 
+        /**
+         * getOrCreate returns the EglImage of graphicBuffer that is shared by
+         * all the EGLConsumers of the process, so that a buffer that comes back
+         * to a slot, is attached again or is consumed by another SurfaceTexture
+         * reuses its EGLImage instead of creating a new one.
+         */
+        static sp<EglImage> getOrCreate(const sp<GraphicBuffer>& graphicBuffer);
+
         /**
          * createIfNeeded creates an EGLImage if required (we haven't created
          * one yet, or the EGLDisplay or crop-rect has changed).
@@ -199,6 +209,10 @@ protected:
         // mGraphicBuffer is the buffer that was used to create this image.
         sp<GraphicBuffer> mGraphicBuffer;
 
+        // mMutex protects mEglImage and mEglDisplay, since an EglImage from
+        // getOrCreate may be used by EGLConsumers on different threads.
+        Mutex mMutex;
+
         // mEglImage is the EGLImage created from mGraphicBuffer.
         EGLImageKHR mEglImage;
 
@@ -298,6 +312,15 @@ protected:
      */
     static Mutex sStaticInitLock;
 
+    /**
+     * sEglImageCache holds the EglImages handed out by EglImage::getOrCreate,
+     * by buffer id. It only holds weak references, so that an EglImage and
+     * its buffer go away with the last slot that uses them, which also
+     * removes it from the cache.
+     */
+    static Mutex sEglImageCacheLock;
+    static std::unordered_map<uint64_t, wp<EglImage>> sEglImageCache;
+
     /**
      * mReleasedTexImageBuffer is a dummy buffer used when in single buffer
      * mode and releaseTexImage() has been called
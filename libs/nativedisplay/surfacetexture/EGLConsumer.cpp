@@ -62,6 +62,8 @@ static const struct {
 
 Mutex EGLConsumer::sStaticInitLock;
 sp<GraphicBuffer> EGLConsumer::sReleasedTexImageBuffer;
+Mutex EGLConsumer::sEglImageCacheLock;
+std::unordered_map<uint64_t, wp<EGLConsumer::EglImage>> EGLConsumer::sEglImageCache;
 
 static bool hasEglProtectedContentImpl() {
     EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
@@ -217,7 +219,7 @@ void EGLConsumer::onAcquireBufferLocked(BufferItem* item, SurfaceTexture& st) {
     // replaces any old EglImage with a new one (using the new buffer).
     int slot = item->mSlot;
     if (item->mGraphicBuffer != nullptr || mEglSlots[slot].mEglImage.get() == nullptr) {
-        mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+        mEglSlots[slot].mEglImage = EglImage::getOrCreate(st.mSlots[slot].mGraphicBuffer);
     }
 }
 
@@ -434,7 +436,7 @@ status_t EGLConsumer::attachToContext(uint32_t tex, SurfaceTexture& st) {
     int slot = st.mCurrentTexture;
     if (slot != BufferItem::INVALID_BUFFER_SLOT) {
         if (!mEglSlots[slot].mEglImage.get()) {
-            mEglSlots[slot].mEglImage = new EglImage(st.mSlots[slot].mGraphicBuffer);
+            mEglSlots[slot].mEglImage = EglImage::getOrCreate(st.mSlots[slot].mGraphicBuffer);
         }
         mCurrentTextureImage = mEglSlots[slot].mEglImage;
     }
@@ -603,7 +605,31 @@ void EGLConsumer::onAbandonLocked() {
 EGLConsumer::EglImage::EglImage(sp<GraphicBuffer> graphicBuffer)
       : mGraphicBuffer(graphicBuffer), mEglImage(EGL_NO_IMAGE_KHR), mEglDisplay(EGL_NO_DISPLAY) {}
 
+sp<EGLConsumer::EglImage> EGLConsumer::EglImage::getOrCreate(
+        const sp<GraphicBuffer>& graphicBuffer) {
+    if (graphicBuffer == nullptr) {
+        return new EglImage(graphicBuffer);
+    }
+    Mutex::Autolock lock(sEglImageCacheLock);
+    wp<EglImage>& entry = sEglImageCache[graphicBuffer->getId()];
+    // An EglImage whose last slot is letting it go can't be promoted, and
+    // its destructor leaves the new one in the cache.
+    sp<EglImage> image = entry.promote();
+    if (image == nullptr) {
+        image = new EglImage(graphicBuffer);
+        entry = image;
+    }
+    return image;
+}
+
 EGLConsumer::EglImage::~EglImage() {
+    if (mGraphicBuffer != nullptr) {
+        Mutex::Autolock lock(sEglImageCacheLock);
+        const auto it = sEglImageCache.find(mGraphicBuffer->getId());
+        if (it != sEglImageCache.end() && it->second.unsafe_get() == this) {
+            sEglImageCache.erase(it);
+        }
+    }
     if (mEglImage != EGL_NO_IMAGE_KHR) {
         if (!eglDestroyImageKHR(mEglDisplay, mEglImage)) {
             ALOGE("~EglImage: eglDestroyImageKHR failed");
@@ -613,6 +639,7 @@ EGLConsumer::EglImage::~EglImage() {
 }
 
 status_t EGLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay, bool forceCreation) {
+    Mutex::Autolock lock(mMutex);
     // If there's an image and it's no longer valid, destroy it.
     bool haveImage = mEglImage != EGL_NO_IMAGE_KHR;
     bool displayInvalid = mEglDisplay != eglDisplay;
@@ -645,6 +672,7 @@ status_t EGLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay, bool force
 }
 
 void EGLConsumer::EglImage::bindToTextureTarget(uint32_t texTarget) {
+    Mutex::Autolock lock(mMutex);
     glEGLImageTargetTexture2DOES(texTarget, static_cast<GLeglImageOES>(mEglImage));
 }
 
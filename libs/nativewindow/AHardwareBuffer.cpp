@@ -21,10 +21,12 @@
 #include <errno.h>
 #include <sys/socket.h>
 #include <memory>
+#include <vector>
 
 #include <cutils/native_handle.h>
 #include <log/log.h>
 #include <utils/StrongPointer.h>
+#include <ui/Fence.h>
 #include <ui/GraphicBuffer.h>
 #include <system/graphics.h>
 
@@ -67,6 +69,34 @@ int AHardwareBuffer_allocate(const AHardwareBuffer_Desc* desc, AHardwareBuffer**
     return NO_ERROR;
 }
 
+int AHardwareBuffer_allocateMultiple(const AHardwareBuffer_Desc* desc, uint32_t count,
+                                     AHardwareBuffer** outBuffers) {
+    if (!outBuffers || !desc || count == 0) return BAD_VALUE;
+    if (!AHardwareBuffer_isValidDescription(desc, /*log=*/true)) return BAD_VALUE;
+
+    int format = AHardwareBuffer_convertToPixelFormat(desc->format);
+    uint64_t usage = AHardwareBuffer_convertToGrallocUsageBits(desc->usage);
+    std::vector<sp<GraphicBuffer>> gbuffers;
+    status_t err = GraphicBuffer::allocateBuffers(
+            desc->width, desc->height, format, desc->layers, usage, count,
+            std::string("AHardwareBuffer pid [") + std::to_string(getpid()) + "]", &gbuffers);
+    if (err != NO_ERROR) {
+        if (err == NO_MEMORY) {
+            GraphicBuffer::dumpAllocationsToSystemLog();
+        }
+        ALOGE("GraphicBuffer::allocateBuffers(count=%u, w=%u, h=%u, lc=%u) failed (%s)", count,
+              desc->width, desc->height, desc->layers, strerror(-err));
+        return err;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        outBuffers[i] = AHardwareBuffer_from_GraphicBuffer(gbuffers[i].get());
+        // Ensure the buffers don't get destroyed when the sp<>s go away.
+        AHardwareBuffer_acquire(outBuffers[i]);
+    }
+    return NO_ERROR;
+}
+
 void AHardwareBuffer_acquire(AHardwareBuffer* buffer) {
     // incStrong/decStrong token must be the same, doesn't matter what it is
     AHardwareBuffer_to_GraphicBuffer(buffer)->incStrong((void*)AHardwareBuffer_acquire);
@@ -180,6 +210,32 @@ int AHardwareBuffer_lock(AHardwareBuffer* buffer, uint64_t usage,
     return gbuffer->lockAsync(usage, usage, bounds, outVirtualAddress, fence, &bytesPerPixel, &bytesPerStride);
 }
 
+int AHardwareBuffer_lockMultiple(AHardwareBuffer* const* buffers, uint32_t count, uint64_t usage,
+                                 int32_t fence, void** outVirtualAddresses) {
+    // Waits once here rather than in every lock call.
+    sp<Fence> acquireFence = new Fence(fence);
+    if (!buffers || !outVirtualAddresses) return BAD_VALUE;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!buffers[i]) return BAD_VALUE;
+    }
+
+    status_t err = acquireFence->waitForever("AHardwareBuffer_lockMultiple");
+    if (err != NO_ERROR) {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        err = AHardwareBuffer_lock(buffers[i], usage, -1, nullptr, &outVirtualAddresses[i]);
+        if (err != NO_ERROR) {
+            while (i-- > 0) {
+                AHardwareBuffer_unlock(buffers[i], nullptr);
+            }
+            return err;
+        }
+    }
+    return NO_ERROR;
+}
+
 int AHardwareBuffer_lockPlanes(AHardwareBuffer* buffer, uint64_t usage,
         int32_t fence, const ARect* rect, AHardwareBuffer_Planes* outPlanes) {
     if (!buffer || !outPlanes) return BAD_VALUE;
@@ -238,6 +294,40 @@ int AHardwareBuffer_unlock(AHardwareBuffer* buffer, int32_t* fence) {
         return gBuffer->unlockAsync(fence);
 }
 
+int AHardwareBuffer_unlockMultiple(AHardwareBuffer* const* buffers, uint32_t count,
+                                   int32_t* fence) {
+    if (fence) *fence = -1;
+    if (!buffers) return BAD_VALUE;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!buffers[i]) return BAD_VALUE;
+    }
+
+    status_t result = NO_ERROR;
+    std::vector<sp<Fence>> releaseFences;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t releaseFence = -1;
+        status_t err = AHardwareBuffer_unlock(buffers[i], fence ? &releaseFence : nullptr);
+        if (err != NO_ERROR && result == NO_ERROR) {
+            result = err;
+        }
+        if (releaseFence >= 0) {
+            releaseFences.push_back(new Fence(releaseFence));
+        }
+    }
+
+    // The buffers are all unlocked once the merged fence signals. If the fences can't be merged,
+    // this waits for them like the NULL fence case does.
+    sp<Fence> releaseFence = Fence::merge("AHardwareBuffer_unlockMultiple", releaseFences);
+    if (releaseFence->isValid()) {
+        *fence = releaseFence->dup();
+    } else {
+        for (const sp<Fence>& unmergedFence : releaseFences) {
+            unmergedFence->waitForever("AHardwareBuffer_unlockMultiple");
+        }
+    }
+    return result;
+}
+
 int AHardwareBuffer_sendHandleToUnixSocket(const AHardwareBuffer* buffer, int socketFd) {
     if (!buffer) return BAD_VALUE;
     const GraphicBuffer* gBuffer = AHardwareBuffer_to_GraphicBuffer(buffer);
@@ -567,6 +567,58 @@ int AHardwareBuffer_lockAndGetInfo(AHardwareBuffer* _Nonnull buffer, uint64_t us
 int AHardwareBuffer_getId(const AHardwareBuffer* _Nonnull buffer, uint64_t* _Nonnull outId)
         __INTRODUCED_IN(31);
 
+/**
+ * Allocates \a count buffers matching the passed AHardwareBuffer_Desc with a single
+ * allocation request.
+ *
+ * Either all the buffers are allocated, with one reference each, or none is.
+ *
+ * Available since API level 32.
+ *
+ * \return 0 on success, -EINVAL if \a desc or \a outBuffers is NULL, \a count is 0 or the
+ * description is invalid, or an error number if the allocation fails for any reason.
+ */
+int AHardwareBuffer_allocateMultiple(const AHardwareBuffer_Desc* _Nonnull desc, uint32_t count,
+                                     AHardwareBuffer* _Nullable* _Nonnull outBuffers)
+        __INTRODUCED_IN(32);
+
+/**
+ * Locks \a count AHardwareBuffers for direct CPU access, as AHardwareBuffer_lock does for each
+ * of them with a NULL rect.
+ *
+ * \a fence is waited on once for all the buffers, and is closed by this function. The address
+ * of each locked buffer is returned at the same index in \a outVirtualAddresses. Either all the
+ * buffers are locked or none is.
+ *
+ * Available since API level 32.
+ *
+ * \return 0 on success. -EINVAL if \a buffers, any of the buffers or \a outVirtualAddresses
+ * is NULL, or the usage flags are not a combination of AHARDWAREBUFFER_USAGE_CPU_*.
+ * INVALID_OPERATION if any buffer has more than one layer. Error number if a lock fails for any
+ * other reason.
+ */
+int AHardwareBuffer_lockMultiple(AHardwareBuffer* _Nonnull const* _Nonnull buffers,
+                                 uint32_t count, uint64_t usage, int32_t fence,
+                                 void* _Nullable* _Nonnull outVirtualAddresses)
+        __INTRODUCED_IN(32);
+
+/**
+ * Unlocks \a count AHardwareBuffers locked for direct CPU access.
+ *
+ * If \a fence is NULL, the function blocks until all the buffers are unlocked. Otherwise
+ * \a fence is set to a single file descriptor that becomes signaled once all of them are
+ * unlocked, or to -1 if they already are, as with AHardwareBuffer_unlock.
+ *
+ * Every buffer is unlocked even if unlocking one of them fails.
+ *
+ * Available since API level 32.
+ *
+ * \return 0 on success. -EINVAL if \a buffers or any of the buffers is NULL. The error number
+ * of the first unlock that fails otherwise.
+ */
+int AHardwareBuffer_unlockMultiple(AHardwareBuffer* _Nonnull const* _Nonnull buffers,
+                                   uint32_t count, int32_t* _Nullable fence) __INTRODUCED_IN(32);
+
 __END_DECLS
 
 #endif // ANDROID_HARDWARE_BUFFER_H
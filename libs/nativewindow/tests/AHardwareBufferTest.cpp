@@ -17,6 +17,8 @@
 #define LOG_TAG "AHardwareBuffer_test"
 //#define LOG_NDEBUG 0
 
+#include <unistd.h>
+
 #include <android/hardware/graphics/common/1.0/types.h>
 #include <gtest/gtest.h>
 #include <private/android/AHardwareBufferHelpers.h>
@@ -170,3 +172,42 @@ TEST(AHardwareBufferTest, GetIdTest) {
 
     EXPECT_NE(id1, id2);
 }
+
+TEST(AHardwareBufferTest, AllocateLockAndUnlockMultiple) {
+    constexpr uint32_t kBufferCount = 3;
+    const AHardwareBuffer_Desc desc = {
+            .width = 64,
+            .height = 1,
+            .layers = 1,
+            .format = AHARDWAREBUFFER_FORMAT_BLOB,
+            .usage = AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN | AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN,
+    };
+
+    AHardwareBuffer* buffers[kBufferCount] = {};
+    ASSERT_EQ(NO_ERROR, AHardwareBuffer_allocateMultiple(&desc, kBufferCount, buffers));
+    uint64_t ids[kBufferCount];
+    for (uint32_t i = 0; i < kBufferCount; i++) {
+        ASSERT_NE(nullptr, buffers[i]);
+        EXPECT_EQ(0, AHardwareBuffer_getId(buffers[i], &ids[i]));
+    }
+    EXPECT_NE(ids[0], ids[1]);
+    EXPECT_NE(ids[1], ids[2]);
+
+    void* addresses[kBufferCount] = {};
+    ASSERT_EQ(NO_ERROR,
+              AHardwareBuffer_lockMultiple(buffers, kBufferCount,
+                                           AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, -1, addresses));
+    for (uint32_t i = 0; i < kBufferCount; i++) {
+        ASSERT_NE(nullptr, addresses[i]);
+        static_cast<uint8_t*>(addresses[i])[0] = static_cast<uint8_t>(i);
+    }
+    int32_t fence = -1;
+    EXPECT_EQ(NO_ERROR, AHardwareBuffer_unlockMultiple(buffers, kBufferCount, &fence));
+    if (fence >= 0) {
+        close(fence);
+    }
+
+    for (AHardwareBuffer* buffer : buffers) {
+        AHardwareBuffer_release(buffer);
+    }
+}
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <functional>
+#include <map>
 #include <mutex>
+#include <vector>
 #include <binder/AppOpsManager.h>
 #include <binder/Binder.h>
 #include <binder/IServiceManager.h>
@@ -43,8 +46,63 @@ static const sp<IBinder>& getClientId() {
     return gClientId;
 }
 
-AppOpsManager::AppOpsManager()
+// The modes cached by checkOpCached, for each op and package that a callback watches.
+struct AppOpsManager::ModeCache {
+    // more ops and packages than this are checked without being cached
+    static constexpr size_t kMaxWatched = 64;
+
+    struct Watched {
+        sp<IAppOpsCallback> watcher;
+        std::map<int32_t, int32_t> modes; // by uid
+    };
+
+    std::mutex lock;
+    // the service the watchers are registered with
+    wp<IBinder> service;
+    std::map<std::pair<int32_t, String16>, Watched> watched;
+    // incremented by every change, so that a mode checked during one isn't cached
+    uint64_t generation = 0;
+};
+
+namespace {
+
+class ModeWatcher : public BnAppOpsCallback {
+public:
+    ModeWatcher(std::function<void(int32_t, const String16&)> onChanged)
+          : mOnChanged(std::move(onChanged)) {}
+
+    void opChanged(int32_t op, const String16& packageName) override {
+        mOnChanged(op, packageName);
+    }
+
+private:
+    const std::function<void(int32_t, const String16&)> mOnChanged;
+};
+
+} // namespace
+
+AppOpsManager::AppOpsManager() : mModeCache(std::make_shared<ModeCache>())
+{
+}
+
+AppOpsManager::~AppOpsManager()
 {
+    std::vector<sp<IAppOpsCallback>> watchers;
+    {
+        std::lock_guard<std::mutex> lock(mModeCache->lock);
+        for (const auto& [key, watched] : mModeCache->watched) {
+            watchers.push_back(watched.watcher);
+        }
+        mModeCache->watched.clear();
+    }
+    if (watchers.empty()) return;
+
+    sp<IAppOpsService> service = mService;
+    if (service != nullptr && IInterface::asBinder(service)->isBinderAlive()) {
+        for (const sp<IAppOpsCallback>& watcher : watchers) {
+            service->stopWatchingMode(watcher);
+        }
+    }
 }
 
 sp<IAppOpsService> AppOpsManager::getService()
@@ -83,6 +141,80 @@ int32_t AppOpsManager::checkOp(int32_t op, int32_t uid, const String16& callingP
             : AppOpsManager::MODE_IGNORED;
 }
 
+int32_t AppOpsManager::checkOpCached(int32_t op, int32_t uid, const String16& callingPackage)
+{
+    sp<IAppOpsService> service = getService();
+    if (service == nullptr) {
+        return AppOpsManager::MODE_IGNORED;
+    }
+    const sp<IBinder> serviceBinder = IInterface::asBinder(service);
+    const std::pair<int32_t, String16> key(op, callingPackage);
+
+    ModeCache& cache = *mModeCache;
+    bool watch = false;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+        if (cache.service != serviceBinder) {
+            // the service restarted, and the watchers went away with the old one
+            cache.watched.clear();
+            cache.service = serviceBinder;
+        }
+        if (auto it = cache.watched.find(key); it != cache.watched.end()) {
+            if (auto modeIt = it->second.modes.find(uid); modeIt != it->second.modes.end()) {
+                return modeIt->second;
+            }
+        } else if (cache.watched.size() < ModeCache::kMaxWatched) {
+            watch = true;
+        }
+        generation = cache.generation;
+    }
+
+    // start watching before checking, so that a change after the check can't be missed
+    sp<IAppOpsCallback> watcher;
+    if (watch) {
+        watcher = sp<ModeWatcher>::make(
+                [weakCache = std::weak_ptr<ModeCache>(mModeCache)](
+                        int32_t changedOp, const String16& packageName) {
+                    std::shared_ptr<ModeCache> cache = weakCache.lock();
+                    if (cache == nullptr) return;
+                    std::lock_guard<std::mutex> lock(cache->lock);
+                    cache->generation++;
+                    if (auto it = cache->watched.find({changedOp, packageName});
+                        it != cache->watched.end()) {
+                        it->second.modes.clear();
+                    }
+                });
+        service->startWatchingMode(op, callingPackage, watcher);
+    }
+
+    const int32_t mode = service->checkOperation(op, uid, callingPackage);
+
+    bool redundantWatcher = false;
+    {
+        std::lock_guard<std::mutex> lock(cache.lock);
+        if (cache.service == serviceBinder) {
+            auto it = cache.watched.find(key);
+            if (it == cache.watched.end() && watcher != nullptr) {
+                it = cache.watched.emplace(key, ModeCache::Watched{watcher, {}}).first;
+            } else {
+                // another thread started watching first
+                redundantWatcher = watcher != nullptr;
+            }
+            if (it != cache.watched.end() && cache.generation == generation) {
+                it->second.modes[uid] = mode;
+            }
+        } else {
+            redundantWatcher = watcher != nullptr;
+        }
+    }
+    if (redundantWatcher) {
+        service->stopWatchingMode(watcher);
+    }
+
+    return mode;
+}
+
 int32_t AppOpsManager::checkAudioOpNoThrow(int32_t op, int32_t usage, int32_t uid,
         const String16& callingPackage) {
     sp<IAppOpsService> service = getService();
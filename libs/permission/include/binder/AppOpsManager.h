@@ -20,6 +20,7 @@
 
 #include <utils/threads.h>
 
+#include <memory>
 #include <optional>
 
 #ifdef __ANDROID_VNDK__
@@ -151,8 +152,14 @@ public:
     };
 
     AppOpsManager();
+    ~AppOpsManager();
 
     int32_t checkOp(int32_t op, int32_t uid, const String16& callingPackage);
+    // Like checkOp, but the mode is kept and returned again without a call to the app ops
+    // service until the service reports that the mode of the op changed for the package.
+    // Changes of a foreground dependent mode as the uid moves between the foreground and the
+    // background are not reported, so this is only for ops which don't have one.
+    int32_t checkOpCached(int32_t op, int32_t uid, const String16& callingPackage);
     int32_t checkAudioOpNoThrow(int32_t op, int32_t usage, int32_t uid,
             const String16& callingPackage);
     // @Deprecated, use noteOp(int32_t, int32_t uid, const String16&, const String16&,
@@ -178,8 +185,12 @@ public:
     void setCameraAudioRestriction(int32_t mode);
 
 private:
+    struct ModeCache;
+
     Mutex mLock;
     sp<IAppOpsService> mService;
+    // shared with the callbacks watching the cached modes, which may outlive this object
+    std::shared_ptr<ModeCache> mModeCache;
 
     sp<IAppOpsService> getService();
     bool shouldCollectNotes(int32_t opCode);
@@ -24,6 +24,11 @@ namespace android::renderengine {
 
 ExternalTexture::ExternalTexture(const sp<GraphicBuffer>& buffer, RenderEngine& renderEngine,
                                  uint32_t usage)
+      : ExternalTexture(buffer, renderEngine, usage,
+                        usage & Usage::WRITEABLE ? Owner::OUTPUT : Owner::LAYER) {}
+
+ExternalTexture::ExternalTexture(const sp<GraphicBuffer>& buffer, RenderEngine& renderEngine,
+                                 uint32_t usage, Owner owner)
       : mBuffer(buffer), mRenderEngine(renderEngine) {
     LOG_ALWAYS_FATAL_IF(buffer == nullptr,
                         "Attempted to bind a null buffer to an external texture!");
@@ -33,7 +38,7 @@ ExternalTexture::ExternalTexture(const sp<GraphicBuffer>& buffer, RenderEngine&
          mRenderEngine.getRenderEngineType() == RenderEngine::RenderEngineType::THREADED)) {
         return;
     }
-    mRenderEngine.mapExternalTextureBuffer(mBuffer, usage & Usage::WRITEABLE);
+    mRenderEngine.mapExternalTextureBuffer(mBuffer, usage & Usage::WRITEABLE, owner);
 }
 
 ExternalTexture::~ExternalTexture() {
@@ -16,6 +16,8 @@
 
 #include <renderengine/RenderEngine.h>
 
+#include <algorithm>
+
 #include <cutils/properties.h>
 #include <log/log.h>
 #include "gl/GLESRenderEngine.h"
@@ -74,7 +76,8 @@ std::unique_ptr<RenderEngine> RenderEngine::create(const RenderEngineCreationArg
                     [skiaArgs]() {
                         return android::renderengine::skia::SkiaGLRenderEngine::create(skiaArgs);
                     },
-                    renderEngineType);
+                    renderEngineType,
+                    property_get_bool(PROPERTY_DEBUG_RENDERENGINE_INTERLEAVE_PRIME_CACHE, false));
         }
         case RenderEngineType::GLES:
         default:
@@ -85,6 +88,32 @@ std::unique_ptr<RenderEngine> RenderEngine::create(const RenderEngineCreationArg
 
 RenderEngine::~RenderEngine() = default;
 
+void RenderEngine::drawLayersAsync(const DisplaySettings& display,
+                                   std::vector<LayerSettings>&& layers,
+                                   const std::shared_ptr<ExternalTexture>& buffer,
+                                   const bool useFramebufferCache, base::unique_fd&& bufferFence,
+                                   DrawLayersCallback&& onDrawn) {
+    std::vector<const LayerSettings*> layerPointers(layers.size());
+    std::transform(layers.begin(), layers.end(), layerPointers.begin(),
+                   std::pointer_traits<LayerSettings*>::pointer_to);
+    base::unique_fd drawFence;
+    const status_t status = drawLayers(display, layerPointers, buffer, useFramebufferCache,
+                                       std::move(bufferFence), &drawFence);
+    onDrawn(status, std::move(drawFence));
+}
+
+std::vector<RenderEngine::DrawLayersResult> RenderEngine::drawLayersBatch(
+        std::vector<DrawLayersRequest>&& requests) {
+    std::vector<DrawLayersResult> results(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        DrawLayersRequest& request = requests[i];
+        results[i].status = drawLayers(request.display, request.layers, request.buffer,
+                                       request.useFramebufferCache, std::move(request.bufferFence),
+                                       &results[i].drawFence);
+    }
+    return results;
+}
+
 void RenderEngine::validateInputBufferUsage(const sp<GraphicBuffer>& buffer) {
     LOG_ALWAYS_FATAL_IF(!(buffer->getUsage() & GraphicBuffer::USAGE_HW_TEXTURE),
                         "input buffer not gpu readable");
@@ -28,6 +28,7 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
@@ -222,6 +223,25 @@ static status_t selectEGLConfig(EGLDisplay display, EGLint format, EGLint render
     return err;
 }
 
+static constexpr char kProgramBinaryPath[] = "/data/misc/surfaceflinger/renderengine_gl_programs";
+
+static std::string getProgramBinaryPath() {
+    return base::GetBoolProperty(PROPERTY_DEBUG_RENDERENGINE_PERSISTENT_SHADER_CACHE, true)
+            ? kProgramBinaryPath
+            : "";
+}
+
+// Program binaries can only be reused by the same build and GPU driver. Must be called with GL
+// current.
+static std::string getProgramBinaryFingerprint() {
+    const auto glString = [](GLenum name) {
+        const char* string = reinterpret_cast<const char*>(glGetString(name));
+        return string ? string : "";
+    };
+    return base::StringPrintf("%s|%s|%s|%s", base::GetProperty("ro.build.fingerprint", "").c_str(),
+                              glString(GL_VENDOR), glString(GL_RENDERER), glString(GL_VERSION));
+}
+
 std::optional<RenderEngine::ContextPriority> GLESRenderEngine::createContextPriority(
         const RenderEngineCreationArgs& args) {
     if (!GLExtensions::getInstance().hasContextPriority()) {
@@ -327,6 +347,12 @@ std::unique_ptr<GLESRenderEngine> GLESRenderEngine::create(const RenderEngineCre
             break;
     }
 
+    // Program binaries can't be retrieved from OpenGL ES 2.0 contexts.
+    if (version == GLES_VERSION_3_0) {
+        ProgramCache::getInstance().loadProgramBinaries(getProgramBinaryPath(),
+                                                        getProgramBinaryFingerprint());
+    }
+
     ALOGI("OpenGL ES informations:");
     ALOGI("vendor    : %s", extensions.getVendor());
     ALOGI("renderer  : %s", extensions.getRenderer());
@@ -518,6 +544,8 @@ Framebuffer* GLESRenderEngine::getFramebufferForDrawing() {
 std::future<void> GLESRenderEngine::primeCache() {
     ProgramCache::getInstance().primeCache(mInProtectedContext ? mProtectedEGLContext : mEGLContext,
                                            mUseColorManagement, mPrecacheToneMapperShaderOnly);
+    // Persist what priming had to compile, so that the next boot can skip it.
+    ProgramCache::getInstance().saveProgramBinaries();
     return {};
 }
 
@@ -690,6 +718,10 @@ void GLESRenderEngine::bindExternalTextureBuffer(uint32_t texName, const sp<Grap
         std::lock_guard<std::mutex> lock(mRenderingMutex);
         auto cachedImage = mImageCache.find(buffer->getId());
         found = (cachedImage != mImageCache.end());
+        mBufferBindCount++;
+        if (!found) {
+            mSynchronousImageCount++;
+        }
     }
 
     // If we couldn't find the image in the cache at this time, then either
@@ -748,7 +780,8 @@ void GLESRenderEngine::bindExternalTextureBuffer(uint32_t texName, const sp<Grap
 }
 
 void GLESRenderEngine::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
-                                                bool /*isRenderable*/) {
+                                                bool /*isRenderable*/,
+                                                ExternalTexture::Owner /*owner*/) {
     ATRACE_CALL();
     mImageManager->cacheAsync(buffer, nullptr);
 }
@@ -1598,6 +1631,8 @@ void GLESRenderEngine::dump(std::string& result) {
     {
         std::lock_guard<std::mutex> lock(mRenderingMutex);
         StringAppendF(&result, "RenderEngine image cache size: %zu\n", mImageCache.size());
+        StringAppendF(&result, "RenderEngine images created while drawing: %zu of %zu buffers\n",
+                      mSynchronousImageCount, mBufferBindCount);
         StringAppendF(&result, "Dumping buffer ids...\n");
         for (const auto& [id, unused] : mImageCache) {
             StringAppendF(&result, "0x%" PRIx64 "\n", id);
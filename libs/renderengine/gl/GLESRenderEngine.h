@@ -103,8 +103,8 @@ protected:
             EXCLUDES(mFramebufferImageCacheMutex);
     size_t getMaxTextureSize() const override;
     size_t getMaxViewportDims() const override;
-    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable)
-            EXCLUDES(mRenderingMutex);
+    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable,
+                                  ExternalTexture::Owner owner) EXCLUDES(mRenderingMutex);
     void unmapExternalTextureBuffer(const sp<GraphicBuffer>& buffer) EXCLUDES(mRenderingMutex);
     bool canSkipPostRenderCleanup() const override;
 
@@ -246,6 +246,10 @@ private:
 
     // Cache of GL images that we'll store per GraphicBuffer ID
     std::unordered_map<uint64_t, std::unique_ptr<Image>> mImageCache GUARDED_BY(mRenderingMutex);
+    // How many buffers drawLayers bound, and how many of them had no image yet, which then had to
+    // be created while drawing.
+    size_t mBufferBindCount GUARDED_BY(mRenderingMutex) = 0;
+    size_t mSynchronousImageCount GUARDED_BY(mRenderingMutex) = 0;
     std::unordered_map<uint32_t, std::optional<uint64_t>> mTextureView;
 
     // Mutex guarding rendering operations, so that:
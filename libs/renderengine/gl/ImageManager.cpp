@@ -21,6 +21,9 @@
 
 #include <pthread.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <processgroup/sched_policy.h>
 #include <utils/Trace.h>
 #include "GLESRenderEngine.h"
@@ -73,7 +76,12 @@ void ImageManager::cacheAsync(const sp<GraphicBuffer>& buffer,
 status_t ImageManager::cache(const sp<GraphicBuffer>& buffer) {
     ATRACE_CALL();
     auto barrier = std::make_shared<Barrier>();
-    cacheAsync(buffer, barrier);
+    if (buffer == nullptr) {
+        cacheAsync(buffer, barrier);
+    } else {
+        QueueEntry entry = {QueueEntry::Operation::Insert, buffer, buffer->getId(), barrier};
+        queueOperation(std::move(entry), true /* urgent */);
+    }
     std::lock_guard<std::mutex> lock(barrier->mutex);
     barrier->condition.wait(barrier->mutex,
                             [&]() REQUIRES(barrier->mutex) { return barrier->isOpen; });
@@ -86,10 +94,21 @@ void ImageManager::releaseAsync(uint64_t bufferId, const std::shared_ptr<Barrier
     queueOperation(std::move(entry));
 }
 
-void ImageManager::queueOperation(const QueueEntry&& entry) {
+void ImageManager::queueOperation(const QueueEntry&& entry, bool urgent) {
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mQueue.emplace(entry);
+        // A queued release of the same buffer must still happen before it is cached again.
+        const bool releasePending =
+                std::any_of(mQueue.begin(), mQueue.end(), [&](const QueueEntry& queued) {
+                    return queued.op == QueueEntry::Operation::Delete &&
+                            queued.bufferId == entry.bufferId;
+                });
+        if (urgent && !releasePending) {
+            mQueue.emplace(mQueue.begin() + mUrgentCount, entry);
+            mUrgentCount++;
+        } else {
+            mQueue.emplace_back(entry);
+        }
         ATRACE_INT("ImageManagerQueueDepth", mQueue.size());
     }
     mCondition.notify_one();
@@ -102,8 +121,9 @@ void ImageManager::threadMain() {
         std::lock_guard<std::mutex> lock(mMutex);
         run = mRunning;
     }
+    std::vector<QueueEntry> batch;
+    batch.reserve(kMaxBatchSize);
     while (run) {
-        QueueEntry entry;
         {
             std::lock_guard<std::mutex> lock(mMutex);
             mCondition.wait(mMutex,
@@ -116,28 +136,37 @@ void ImageManager::threadMain() {
                 break;
             }
 
-            entry = mQueue.front();
-            mQueue.pop();
+            // Take several entries at once, so that e.g. the buffers of a new surface don't each
+            // wait for a wakeup of their own.
+            while (!mQueue.empty() && batch.size() < kMaxBatchSize) {
+                batch.push_back(std::move(mQueue.front()));
+                mQueue.pop_front();
+            }
+            mUrgentCount -= std::min(mUrgentCount, batch.size());
             ATRACE_INT("ImageManagerQueueDepth", mQueue.size());
         }
 
-        status_t result = NO_ERROR;
-        switch (entry.op) {
-            case QueueEntry::Operation::Delete:
-                mEngine->unbindExternalTextureBufferInternal(entry.bufferId);
-                break;
-            case QueueEntry::Operation::Insert:
-                result = mEngine->cacheExternalTextureBufferInternal(entry.buffer);
-                break;
-        }
-        if (entry.barrier != nullptr) {
-            {
-                std::lock_guard<std::mutex> entryLock(entry.barrier->mutex);
-                entry.barrier->result = result;
-                entry.barrier->isOpen = true;
+        ATRACE_INT("ImageManagerBatchSize", batch.size());
+        for (const QueueEntry& entry : batch) {
+            status_t result = NO_ERROR;
+            switch (entry.op) {
+                case QueueEntry::Operation::Delete:
+                    mEngine->unbindExternalTextureBufferInternal(entry.bufferId);
+                    break;
+                case QueueEntry::Operation::Insert:
+                    result = mEngine->cacheExternalTextureBufferInternal(entry.buffer);
+                    break;
+            }
+            if (entry.barrier != nullptr) {
+                {
+                    std::lock_guard<std::mutex> entryLock(entry.barrier->mutex);
+                    entry.barrier->result = result;
+                    entry.barrier->isOpen = true;
+                }
+                entry.barrier->condition.notify_one();
             }
-            entry.barrier->condition.notify_one();
         }
+        batch.clear();
     }
 
     ALOGD("Reached end of threadMain, terminating ImageManager thread!");
@@ -17,8 +17,8 @@
 #pragma once
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <thread>
 
 #include <ui/GraphicBuffer.h>
@@ -45,6 +45,8 @@ public:
     void initThread();
     void cacheAsync(const sp<GraphicBuffer>& buffer, const std::shared_ptr<Barrier>& barrier)
             EXCLUDES(mMutex);
+    // Creates the image ahead of the queued requests, for a buffer that is needed right away, and
+    // waits for it.
     status_t cache(const sp<GraphicBuffer>& buffer);
     void releaseAsync(uint64_t bufferId, const std::shared_ptr<Barrier>& barrier) EXCLUDES(mMutex);
 
@@ -58,13 +60,18 @@ private:
         std::shared_ptr<Barrier> barrier = nullptr;
     };
 
-    void queueOperation(const QueueEntry&& entry);
+    // Bounds how long a request that jumps the queue can wait for the batch being processed.
+    static constexpr size_t kMaxBatchSize = 4;
+
+    void queueOperation(const QueueEntry&& entry, bool urgent = false);
     void threadMain();
     GLESRenderEngine* const mEngine;
     std::thread mThread;
     std::condition_variable_any mCondition;
     std::mutex mMutex;
-    std::queue<QueueEntry> mQueue GUARDED_BY(mMutex);
+    std::deque<QueueEntry> mQueue GUARDED_BY(mMutex);
+    // Number of entries at the front of mQueue that jumped the queue.
+    size_t mUrgentCount GUARDED_BY(mMutex) = 0;
 
     bool mRunning GUARDED_BY(mMutex) = true;
 };
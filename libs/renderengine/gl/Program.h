@@ -18,6 +18,7 @@
 #define SF_RENDER_ENGINE_PROGRAM_H
 
 #include <stdint.h>
+#include <vector>
 
 #include <GLES2/gl2.h>
 #include <renderengine/private/Description.h>
@@ -54,11 +55,18 @@ public:
     };
 
     Program(const ProgramCache::Key& needs, const char* vertex, const char* fragment);
+    /* links the program from a binary returned by getBinary(); the program is invalid if the
+     * driver rejects the binary */
+    Program(const ProgramCache::Key& needs, GLenum binaryFormat,
+            const std::vector<uint8_t>& binary);
     ~Program();
 
     /* whether this object is usable */
     bool isValid() const;
 
+    /* Returns the binary of the linked program, false if the driver doesn't provide one */
+    bool getBinary(GLenum* binaryFormat, std::vector<uint8_t>* binary) const;
+
     /* Binds this program to the GLES context */
     void use();
 
@@ -74,6 +82,9 @@ public:
 private:
     GLuint buildShader(const char* source, GLenum type);
 
+    /* looks up the uniforms of the linked program and sets their defaults */
+    void initialize(GLuint programId);
+
     // whether the initialization succeeded
     bool mInitialized;
 
@@ -20,10 +20,16 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+#include <android-base/file.h>
 #include <log/log.h>
 #include <renderengine/private/Description.h>
+#include <unistd.h>
 #include <utils/String8.h>
 #include <utils/Trace.h>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
 #include "Program.h"
 
 ANDROID_SINGLETON_STATIC_INSTANCE(android::renderengine::gl::ProgramCache)
@@ -77,6 +83,147 @@ Formatter& dedent(Formatter& f) {
     return f;
 }
 
+namespace {
+
+constexpr uint32_t kBinaryMagic = 0x43504752; // 'RGPC'
+constexpr uint32_t kBinaryVersion = 1;
+
+void appendU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendBytes(std::string& out, const void* bytes, size_t size) {
+    appendU32(out, static_cast<uint32_t>(size));
+    out.append(static_cast<const char*>(bytes), size);
+}
+
+// Bounds-checked reads from the binary file contents.
+class Reader {
+public:
+    explicit Reader(const std::string& contents) : mContents(contents) {}
+
+    bool readU32(uint32_t* value) {
+        if (mContents.size() - mOffset < sizeof(*value)) return false;
+        memcpy(value, mContents.data() + mOffset, sizeof(*value));
+        mOffset += sizeof(*value);
+        return true;
+    }
+
+    bool readBytes(const char** bytes, size_t* size) {
+        uint32_t length;
+        if (!readU32(&length) || mContents.size() - mOffset < length) return false;
+        *bytes = mContents.data() + mOffset;
+        *size = length;
+        mOffset += length;
+        return true;
+    }
+
+private:
+    const std::string& mContents;
+    size_t mOffset = 0;
+};
+
+} // namespace
+
+void ProgramCache::loadProgramBinaries(std::string path, std::string fingerprint) {
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (path.empty() || formatCount <= 0) {
+        return;
+    }
+
+    mBinaryPath = std::move(path);
+    mBinaryFingerprint = std::move(fingerprint);
+    // Only the programs that are needed before reading is done wait for it.
+    mPendingBinaries = std::async(std::launch::async, &ProgramCache::readProgramBinaries,
+                                  mBinaryPath, mBinaryFingerprint);
+}
+
+ProgramCache::ProgramBinaries ProgramCache::readProgramBinaries(const std::string& path,
+                                                                const std::string& fingerprint) {
+    ATRACE_CALL();
+
+    std::string contents;
+    if (!base::ReadFileToString(path, &contents)) {
+        ALOGD("No program binaries at %s", path.c_str());
+        return {};
+    }
+
+    Reader reader(contents);
+    uint32_t magic, version, count;
+    const char* savedFingerprint;
+    size_t fingerprintSize;
+    if (!reader.readU32(&magic) || magic != kBinaryMagic || !reader.readU32(&version) ||
+        version != kBinaryVersion || !reader.readBytes(&savedFingerprint, &fingerprintSize) ||
+        std::string_view(savedFingerprint, fingerprintSize) != fingerprint ||
+        !reader.readU32(&count)) {
+        ALOGI("Discarding stale program binaries at %s", path.c_str());
+        return {};
+    }
+
+    ProgramBinaries binaries;
+    for (uint32_t i = 0; i < count; i++) {
+        Key key;
+        uint32_t format;
+        const char* data;
+        size_t size;
+        if (!reader.readU32(&key.mKey) || !reader.readU32(&format) ||
+            !reader.readBytes(&data, &size)) {
+            ALOGW("Discarding truncated program binaries at %s", path.c_str());
+            return {};
+        }
+        binaries.insert_or_assign(key,
+                                  ProgramBinary{format, std::vector<uint8_t>(data, data + size)});
+    }
+    ALOGD("Loaded %zu program binaries from %s", binaries.size(), path.c_str());
+    return binaries;
+}
+
+void ProgramCache::takePendingBinaries() {
+    if (!mPendingBinaries.valid()) {
+        return;
+    }
+    mBinaries = mPendingBinaries.get();
+    mBinaryBytes = 0;
+    for (const auto& [key, binary] : mBinaries) {
+        mBinaryBytes += binary.data.size();
+    }
+}
+
+bool ProgramCache::saveProgramBinaries() {
+    ATRACE_CALL();
+
+    takePendingBinaries();
+    if (mBinaryPath.empty() || !mBinariesDirty) {
+        return true;
+    }
+
+    std::string contents;
+    appendU32(contents, kBinaryMagic);
+    appendU32(contents, kBinaryVersion);
+    appendBytes(contents, mBinaryFingerprint.data(), mBinaryFingerprint.size());
+    appendU32(contents, static_cast<uint32_t>(mBinaries.size()));
+    for (const auto& [key, binary] : mBinaries) {
+        appendU32(contents, key.mKey);
+        appendU32(contents, binary.format);
+        appendBytes(contents, binary.data.data(), binary.data.size());
+    }
+
+    // Write to a temporary file and rename it, so that a crash can't leave a partial file behind.
+    const std::string tempPath = mBinaryPath + ".tmp";
+    if (!base::WriteStringToFile(contents, tempPath) ||
+        rename(tempPath.c_str(), mBinaryPath.c_str()) != 0) {
+        ALOGW("Failed to write program binaries to %s: %s", mBinaryPath.c_str(),
+              strerror(errno));
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    mBinariesDirty = false;
+    ALOGD("Saved %zu program binaries to %s", mBinaries.size(), mBinaryPath.c_str());
+    return true;
+}
+
 void ProgramCache::primeCache(
         EGLContext context, bool useColorManagement, bool toneMapperShaderOnly) {
     auto& cache = mCaches[context];
@@ -791,13 +938,39 @@ String8 ProgramCache::generateFragmentShader(const Key& needs) {
 std::unique_ptr<Program> ProgramCache::generateProgram(const Key& needs) {
     ATRACE_CALL();
 
+    takePendingBinaries();
+    auto binary = mBinaries.find(needs);
+    if (binary != mBinaries.end()) {
+        auto program = std::make_unique<Program>(needs, binary->second.format, binary->second.data);
+        if (program->isValid()) {
+            return program;
+        }
+    }
+
     // vertex shader
     String8 vs = generateVertexShader(needs);
 
     // fragment shader
     String8 fs = generateFragmentShader(needs);
 
-    return std::make_unique<Program>(needs, vs.string(), fs.string());
+    auto program = std::make_unique<Program>(needs, vs.string(), fs.string());
+    if (!mBinaryPath.empty() && program->isValid()) {
+        ProgramBinary programBinary;
+        if (program->getBinary(&programBinary.format, &programBinary.data)) {
+            // A rejected binary is replaced, e.g. after the driver changed its format.
+            if (binary != mBinaries.end()) {
+                mBinaryBytes -= binary->second.data.size();
+                mBinaries.erase(binary);
+                mBinariesDirty = true;
+            }
+            if (mBinaryBytes + programBinary.data.size() <= kMaxBinaryBytes) {
+                mBinaryBytes += programBinary.data.size();
+                mBinaries.emplace(needs, std::move(programBinary));
+                mBinariesDirty = true;
+            }
+        }
+    }
+    return program;
 }
 
 void ProgramCache::useProgram(EGLContext context, const Description& description) {
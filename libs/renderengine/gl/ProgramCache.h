@@ -17,8 +17,11 @@
 #ifndef SF_RENDER_ENGINE_PROGRAMCACHE_H
 #define SF_RENDER_ENGINE_PROGRAMCACHE_H
 
+#include <future>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
@@ -205,7 +208,27 @@ public:
 
     void purgeCaches() { mCaches.clear(); }
 
+    // Starts reading, in the background, the program binaries saved to path by an earlier run.
+    // Programs are then loaded from their binary instead of compiled, when there is one. The
+    // fingerprint identifies the build and GPU driver, and binaries saved under another one are
+    // discarded. Must be called with an OpenGL ES 3.0 context current.
+    void loadProgramBinaries(std::string path, std::string fingerprint);
+
+    // Writes the binaries of the programs compiled since they were loaded, if any. Returns false
+    // if writing failed.
+    bool saveProgramBinaries();
+
 private:
+    struct ProgramBinary {
+        GLenum format;
+        std::vector<uint8_t> data;
+    };
+    using ProgramBinaries = std::unordered_map<Key, ProgramBinary, Key::Hash>;
+
+    static ProgramBinaries readProgramBinaries(const std::string& path,
+                                               const std::string& fingerprint);
+    // Waits for the binaries being read, if any, and starts using them.
+    void takePendingBinaries();
     // compute a cache Key from a Description
     static Key computeKey(const Description& description);
     // Generate EOTF based from Key.
@@ -216,8 +239,8 @@ private:
     static void generateOOTF(Formatter& fs, const Key& needs);
     // Generate OETF based from Key.
     static void generateOETF(Formatter& fs, const Key& needs);
-    // generates a program from the Key
-    static std::unique_ptr<Program> generateProgram(const Key& needs);
+    // generates a program from the Key, or loads it from its saved binary
+    std::unique_ptr<Program> generateProgram(const Key& needs);
     // generates the vertex shader from the Key
     static String8 generateVertexShader(const Key& needs);
     // generates the fragment shader from the Key
@@ -227,6 +250,18 @@ private:
     // is never shrunk (and the GL program objects are never deleted).
     std::unordered_map<EGLContext, std::unordered_map<Key, std::unique_ptr<Program>, Key::Hash>>
             mCaches;
+
+    // Bounds the file that is read back on every boot.
+    static constexpr size_t kMaxBinaryBytes = 4 * 1024 * 1024;
+
+    // Binaries of the programs compiled or loaded for each Key, which are the same for all the
+    // contexts. mBinaryPath is empty when binaries are not used.
+    std::string mBinaryPath;
+    std::string mBinaryFingerprint;
+    std::future<ProgramBinaries> mPendingBinaries;
+    ProgramBinaries mBinaries;
+    size_t mBinaryBytes = 0;
+    bool mBinariesDirty = false;
 };
 
 } // namespace gl
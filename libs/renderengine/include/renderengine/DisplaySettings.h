@@ -63,6 +63,12 @@ struct DisplaySettings {
 
     // SDR white point, -1f if unknown
     float sdrWhitePointNits = -1.f;
+
+    // Region to draw, when the output buffer already holds the other pixels of the frame, e.g.
+    // because it holds a recent frame and only the damage since then has to be drawn. Everything
+    // is drawn if it is empty. This is specified in layer-stack space. Backends may draw outside
+    // of it.
+    Region damage = Region();
 };
 
 static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings& rhs) {
@@ -86,6 +92,8 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
     *os << "\n    .clearRegion = ";
     PrintTo(settings.clearRegion, os);
     *os << "\n    .orientation = " << settings.orientation;
+    *os << "\n    .damage = ";
+    PrintTo(settings.damage, os);
     *os << "\n}";
 }
 
@@ -43,9 +43,26 @@ public:
         // external texture
         WRITEABLE = 1 << 1,
     };
+
+    // Owner tells RenderEngine what the buffer is used for, so that it can account for the GPU
+    // memory it keeps mapped on behalf of each of its clients.
+    enum class Owner : uint32_t {
+        // Buffers drawn by layers.
+        LAYER,
+        // Buffers RenderEngine composes displays into.
+        OUTPUT,
+        // Buffers the planner renders CachedSets into.
+        CACHED_SET,
+        // Buffers RenderEngine draws screenshots or region samples into.
+        SCREENSHOT,
+    };
+
     // Creates an ExternalTexture for the provided buffer and RenderEngine instance, with the given
-    // usage hint of type Usage.
+    // usage hint of type Usage. Unless specified, the owner is OUTPUT for buffers that are
+    // WRITEABLE, and LAYER for the others.
     ExternalTexture(const sp<GraphicBuffer>& buffer, RenderEngine& renderEngine, uint32_t usage);
+    ExternalTexture(const sp<GraphicBuffer>& buffer, RenderEngine& renderEngine, uint32_t usage,
+                    Owner owner);
 
     ~ExternalTexture();
 
@@ -29,8 +29,10 @@
 #include <ui/GraphicTypes.h>
 #include <ui/Transform.h>
 
+#include <functional>
 #include <future>
 #include <memory>
+#include <optional>
 
 /**
  * Allows to set RenderEngine backend to GLES (default) or SkiaGL (NOT yet supported).
@@ -54,6 +56,27 @@
  */
 #define PROPERTY_SKIA_ATRACE_ENABLED "debug.renderengine.skia_atrace_enabled"
 
+/**
+ * Allows saving the programs compiled by SkiaGL, or by the GLES backend, to disk, so that they are
+ * reloaded on the next boot instead of compiled again. Enabled by default.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_PERSISTENT_SHADER_CACHE \
+    "debug.renderengine.persistent_shader_cache"
+
+/**
+ * Allows the threaded RenderEngine to run work queued behind primeCache() between the priming
+ * draws, so that composition doesn't wait for priming to complete. Disabled by default.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_INTERLEAVE_PRIME_CACHE \
+    "debug.renderengine.interleave_prime_cache"
+
+/**
+ * Sets the memory budget, in megabytes, of the textures SkiaGL keeps for buffers that are no
+ * longer mapped. By default, the budget scales with the size of the primary display.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB \
+    "debug.renderengine.texture_cache_budget_mb"
+
 struct ANativeWindowBuffer;
 
 namespace android {
@@ -168,6 +191,43 @@ public:
                                 const bool useFramebufferCache, base::unique_fd&& bufferFence,
                                 base::unique_fd* drawFence) = 0;
 
+    // Called with the result of drawLayersAsync, and the fence that fires once the buffer has
+    // been drawn to.
+    using DrawLayersCallback = std::function<void(status_t, base::unique_fd&& drawFence)>;
+
+    // Like drawLayers, but the display and layer settings are copied, so that a threaded
+    // implementation can return without waiting for the layers to be drawn. onDrawn is called,
+    // possibly on another thread, once they are. Calls made to this RenderEngine after this one
+    // are still ordered after it. By default, the layers are drawn before returning.
+    virtual void drawLayersAsync(const DisplaySettings& display,
+                                 std::vector<LayerSettings>&& layers,
+                                 const std::shared_ptr<ExternalTexture>& buffer,
+                                 const bool useFramebufferCache, base::unique_fd&& bufferFence,
+                                 DrawLayersCallback&& onDrawn);
+
+    // One of the independent requests passed to drawLayersBatch, with the same meaning as the
+    // drawLayers parameters.
+    struct DrawLayersRequest {
+        DisplaySettings display;
+        std::vector<const LayerSettings*> layers;
+        std::shared_ptr<ExternalTexture> buffer;
+        bool useFramebufferCache = false;
+        base::unique_fd bufferFence;
+    };
+
+    struct DrawLayersResult {
+        status_t status = NO_ERROR;
+        // Fires once the request's buffer has been drawn to.
+        base::unique_fd drawFence;
+    };
+
+    // Draws each of the requests as drawLayers would, in order, and returns one result per
+    // request. A threaded implementation hands all of them over to its thread at once, and an
+    // implementation may submit the GPU work of all of them together, in which case their fences
+    // fire together. By default, the requests are drawn one at a time.
+    virtual std::vector<DrawLayersResult> drawLayersBatch(
+            std::vector<DrawLayersRequest>&& requests);
+
     // Clean-up method that should be called on the main thread after the
     // drawFence returned by drawLayers fires. This method will free up
     // resources used by the most recently drawn frame. If the frame is still
@@ -185,6 +245,10 @@ public:
     // query is required to be thread safe.
     virtual bool supportsBackgroundBlur() = 0;
 
+    // Returns the id of the thread doing the GPU work, if it isn't done on the calling thread,
+    // so that it can be scheduled along with the caller's.
+    virtual std::optional<pid_t> getRenderEngineTid() const { return std::nullopt; }
+
     // Returns the current type of RenderEngine instance that was created.
     // TODO(b/180767535): This is only implemented to allow for backend-specific behavior, which
     // we should not allow in general, so remove this.
@@ -211,7 +275,9 @@ protected:
     // implementation supports protected context, then GPU resources may be mapped into both the
     // protected and unprotected contexts.
     // If the buffer may ever be written to by RenderEngine, then isRenderable must be true.
-    virtual void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable) = 0;
+    // owner is what the buffer is used for, which RenderEngine may use for memory accounting.
+    virtual void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable,
+                                          ExternalTexture::Owner owner) = 0;
     // Unmaps GPU resources used by this buffer. This method should be
     // invoked when the caller will no longer hold a reference to a GraphicBuffer
     // and needs to clean up its resources.
@@ -228,6 +294,11 @@ protected:
     // avoid any thread synchronization that may be required by directly calling postRenderCleanup.
     virtual bool canSkipPostRenderCleanup() const = 0;
 
+    // Sets a function that primeCache() calls between the draws it makes, so that the caller can
+    // run other work on the RenderEngine thread before priming completes. Implementations that
+    // prime in a single step may ignore it.
+    virtual void setPrimeCacheYieldCallback(std::function<void()> /*callback*/) {}
+
     friend class ExternalTexture;
     friend class threaded::RenderEngineThreaded;
     friend class RenderEngineTest_cleanupPostRender_cleansUpOnce_Test;
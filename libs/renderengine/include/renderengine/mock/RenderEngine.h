@@ -51,14 +51,17 @@ public:
                  status_t(const DisplaySettings&, const std::vector<const LayerSettings*>&,
                           const std::shared_ptr<ExternalTexture>&, const bool, base::unique_fd&&,
                           base::unique_fd*));
+    MOCK_METHOD1(drawLayersBatch,
+                 std::vector<DrawLayersResult>(std::vector<DrawLayersRequest>&&));
     MOCK_METHOD0(cleanFramebufferCache, void());
     MOCK_METHOD0(getContextPriority, int());
     MOCK_METHOD0(supportsBackgroundBlur, bool());
     MOCK_METHOD1(onPrimaryDisplaySizeChanged, void(ui::Size));
+    MOCK_METHOD1(setPrimeCacheYieldCallback, void(std::function<void()>));
 
 protected:
     // mock renderengine still needs to implement these, but callers should never need to call them.
-    void mapExternalTextureBuffer(const sp<GraphicBuffer>&, bool) {}
+    void mapExternalTextureBuffer(const sp<GraphicBuffer>&, bool, ExternalTexture::Owner) {}
     void unmapExternalTextureBuffer(const sp<GraphicBuffer>&) {}
 };
 
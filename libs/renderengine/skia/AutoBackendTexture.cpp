@@ -24,6 +24,8 @@
 #include "log/log_main.h"
 #include "utils/Trace.h"
 
+#include <algorithm>
+
 namespace android {
 namespace renderengine {
 namespace skia {
@@ -58,7 +60,7 @@ AutoBackendTexture::~AutoBackendTexture() {
 
 void AutoBackendTexture::unref(bool releaseLocalResources) {
     if (releaseLocalResources) {
-        mSurface = nullptr;
+        mSurfaces.clear();
         mImage = nullptr;
     }
 
@@ -106,7 +108,6 @@ sk_sp<SkImage> AutoBackendTexture::makeImage(ui::Dataspace dataspace, SkAlphaTyp
     }
 
     mImage = image;
-    mDataspace = dataspace;
     LOG_ALWAYS_FATAL_IF(mImage == nullptr,
                         "Unable to generate SkImage. isTextureValid:%d dataspace:%d",
                         mBackendTexture.isValid(), dataspace);
@@ -117,24 +118,30 @@ sk_sp<SkSurface> AutoBackendTexture::getOrCreateSurface(ui::Dataspace dataspace,
                                                         GrDirectContext* context) {
     ATRACE_CALL();
     LOG_ALWAYS_FATAL_IF(!mIsOutputBuffer, "You can't generate a SkSurface for a read-only texture");
-    if (!mSurface.get() || mDataspace != dataspace) {
-        sk_sp<SkSurface> surface =
-                SkSurface::MakeFromBackendTexture(context, mBackendTexture,
-                                                  kTopLeft_GrSurfaceOrigin, 0, mColorType,
-                                                  toSkColorSpace(dataspace), nullptr,
-                                                  releaseSurfaceProc, this);
-        if (surface.get()) {
-            // The following ref will be counteracted by releaseProc, when SkSurface is discarded.
-            ref();
-        }
-        mSurface = surface;
+    auto cached = std::find_if(mSurfaces.begin(), mSurfaces.end(),
+                               [dataspace](const CachedSurface& cachedSurface) {
+                                   return cachedSurface.dataspace == dataspace;
+                               });
+    if (cached != mSurfaces.end()) {
+        std::rotate(mSurfaces.begin(), cached, cached + 1);
+        return mSurfaces.front().surface;
     }
 
-    mDataspace = dataspace;
-    LOG_ALWAYS_FATAL_IF(mSurface == nullptr,
+    sk_sp<SkSurface> surface =
+            SkSurface::MakeFromBackendTexture(context, mBackendTexture, kTopLeft_GrSurfaceOrigin, 0,
+                                              mColorType, toSkColorSpace(dataspace), nullptr,
+                                              releaseSurfaceProc, this);
+    LOG_ALWAYS_FATAL_IF(surface == nullptr,
                         "Unable to generate SkSurface. isTextureValid:%d dataspace:%d",
                         mBackendTexture.isValid(), dataspace);
-    return mSurface;
+    // The following ref will be counteracted by releaseProc, when SkSurface is discarded.
+    ref();
+
+    if (mSurfaces.size() == kMaxCachedSurfaces) {
+        mSurfaces.pop_back();
+    }
+    mSurfaces.insert(mSurfaces.begin(), CachedSurface{dataspace, surface});
+    return surface;
 }
 
 } // namespace skia
@@ -100,7 +100,7 @@ public:
             return mTexture->makeImage(dataspace, alphaType, context);
         }
 
-        // Makes a new SkSurface from the texture content, if needed.
+        // Makes a new SkSurface from the texture content, if there is none for the dataspace.
         sk_sp<SkSurface> getOrCreateSurface(ui::Dataspace dataspace, GrDirectContext* context) {
             return mTexture->getOrCreateSurface(dataspace, context);
         }
@@ -133,9 +133,19 @@ private:
     sk_sp<SkImage> makeImage(ui::Dataspace dataspace, SkAlphaType alphaType,
                              GrDirectContext* context);
 
-    // Makes a new SkSurface from the texture content, if needed.
+    // Makes a new SkSurface from the texture content, if there is none for the dataspace.
     sk_sp<SkSurface> getOrCreateSurface(ui::Dataspace dataspace, GrDirectContext* context);
 
+    // Output buffers drawn in alternating dataspaces, for instance when mixed content switches
+    // the display between them, keep a surface for each so that they are not rewrapped every
+    // frame. Each of them holds a ref on this texture until the local resources are released.
+    static constexpr size_t kMaxCachedSurfaces = 2;
+
+    struct CachedSurface {
+        ui::Dataspace dataspace;
+        sk_sp<SkSurface> surface;
+    };
+
     GrBackendTexture mBackendTexture;
     GrAHardwareBufferUtils::DeleteImageProc mDeleteProc;
     GrAHardwareBufferUtils::UpdateImageProc mUpdateProc;
@@ -150,8 +160,8 @@ private:
 
     const bool mIsOutputBuffer;
     sk_sp<SkImage> mImage = nullptr;
-    sk_sp<SkSurface> mSurface = nullptr;
-    ui::Dataspace mDataspace = ui::Dataspace::UNKNOWN;
+    // Most recently used first.
+    std::vector<CachedSurface> mSurfaces;
     SkColorType mColorType = kUnknown_SkColorType;
 };
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlurCache.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+void BlurCache::beginFrame(const GrRecordingContext* context, const DisplaySettings& display,
+                           const SkImageInfo& targetInfo,
+                           const std::vector<const LayerSettings*>& layers) {
+    mLayers = &layers;
+    mCurrent = Frame{.context = context, .display = display, .targetInfo = targetInfo};
+    mMatch = nullptr;
+    mUnchangedLayers = 0;
+
+    for (Frame& frame : mFrames) {
+        if (frame.blurs.empty() || frame.context != context || !(frame.display == display) ||
+            frame.targetInfo != targetInfo) {
+            continue;
+        }
+
+        size_t unchangedLayers = 0;
+        while (unchangedLayers < frame.layers.size() && unchangedLayers < layers.size() &&
+               isUnchanged(frame.layers[unchangedLayers], *layers[unchangedLayers])) {
+            unchangedLayers++;
+        }
+        if (!mMatch || unchangedLayers > mUnchangedLayers) {
+            mMatch = &frame;
+            mUnchangedLayers = unchangedLayers;
+        }
+    }
+}
+
+sk_sp<SkImage> BlurCache::get(size_t layerIndex, uint32_t radius, const SkRect& blurRect) {
+    // The blur of a layer only depends on the layers below it.
+    if (mMatch && layerIndex <= mUnchangedLayers) {
+        for (const Blur& blur : mMatch->blurs) {
+            if (blur.layerIndex == layerIndex && blur.radius == radius &&
+                blur.blurRect == blurRect) {
+                mHits++;
+                return blur.image;
+            }
+        }
+    }
+    mMisses++;
+    return nullptr;
+}
+
+void BlurCache::put(size_t layerIndex, uint32_t radius, const SkRect& blurRect,
+                    sk_sp<SkImage> image) {
+    mCurrent.blurs.push_back({layerIndex, radius, blurRect, std::move(image)});
+}
+
+void BlurCache::endFrame() {
+    if (!mCurrent.blurs.empty() && mLayers) {
+        const auto topmost = std::max_element(mCurrent.blurs.begin(), mCurrent.blurs.end(),
+                                              [](const Blur& lhs, const Blur& rhs) {
+                                                  return lhs.layerIndex < rhs.layerIndex;
+                                              });
+        mCurrent.layers.reserve(topmost->layerIndex + 1);
+        for (size_t i = 0; i <= topmost->layerIndex && i < mLayers->size(); i++) {
+            mCurrent.layers.push_back(*(*mLayers)[i]);
+        }
+
+        // Replace the frame this one was drawn over, e.g. the previous frame of the same display.
+        Frame* slot = mMatch;
+        if (!slot) {
+            slot = std::min_element(mFrames.begin(), mFrames.end(),
+                                    [](const Frame& lhs, const Frame& rhs) {
+                                        return lhs.lastUse < rhs.lastUse;
+                                    });
+        }
+        *slot = std::move(mCurrent);
+        slot->lastUse = ++mUseCount;
+    }
+
+    mLayers = nullptr;
+    mCurrent = {};
+    mMatch = nullptr;
+    mUnchangedLayers = 0;
+}
+
+void BlurCache::clear() {
+    mFrames = {};
+    mLayers = nullptr;
+    mCurrent = {};
+    mMatch = nullptr;
+    mUnchangedLayers = 0;
+}
+
+size_t BlurCache::size() const {
+    size_t blurs = 0;
+    for (const Frame& frame : mFrames) {
+        blurs += frame.blurs.size();
+    }
+    return blurs;
+}
+
+bool BlurCache::isUnchanged(const LayerSettings& cached, const LayerSettings& layer) {
+    if (!(cached == layer)) {
+        return false;
+    }
+    const Buffer& buffer = layer.source.buffer;
+    return buffer.buffer == nullptr || (buffer.fence != nullptr && buffer.fence->isValid());
+}
+
+void BlurCache::dump(std::string& result) const {
+    using base::StringAppendF;
+
+    size_t frames = 0;
+    for (const Frame& frame : mFrames) {
+        if (!frame.blurs.empty()) {
+            frames++;
+        }
+    }
+    StringAppendF(&result, "Blur cache: %zu frames, %zu blurs, %zu hits, %zu misses\n", frames,
+                  size(), mHits, mMisses);
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkImage.h>
+#include <SkImageInfo.h>
+#include <SkRect.h>
+#include <renderengine/DisplaySettings.h>
+#include <renderengine/LayerSettings.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+class GrRecordingContext;
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * BlurCache keeps the blurred images generated by the BlurFilter for the last few frames that had
+ * blurs, so that a blur is only generated again once the content beneath it changes.
+ *
+ * The content beneath the blur of a layer is the output of the layers below it, so the blur can
+ * be reused by a later frame drawn with the same display settings and target format, if all those
+ * layers are unchanged. A layer with a buffer is only known to be unchanged if it is drawn with
+ * the same valid acquire fence, as buffers are reused across frames and a fence is created for
+ * each of them.
+ *
+ * BlurCache is not thread-safe.
+ */
+class BlurCache {
+public:
+    // Starts drawing a frame, looking for the cached frame that shares the most unchanged layers
+    // with it.
+    void beginFrame(const GrRecordingContext* context, const DisplaySettings& display,
+                    const SkImageInfo& targetInfo, const std::vector<const LayerSettings*>& layers);
+
+    // Returns the blur of the layer at layerIndex in the frame being drawn, if its content is
+    // unchanged since it was cached, or nullptr.
+    sk_sp<SkImage> get(size_t layerIndex, uint32_t radius, const SkRect& blurRect);
+
+    // Adds a blur generated for the layer at layerIndex in the frame being drawn.
+    void put(size_t layerIndex, uint32_t radius, const SkRect& blurRect, sk_sp<SkImage> image);
+
+    // Caches the blurs of the frame being drawn, in place of the frame it was matched with or of
+    // the least recently used one.
+    void endFrame();
+
+    // Drops all the blurs, so that the frames are drawn from scratch.
+    void clear();
+
+    size_t size() const;
+    void dump(std::string& result) const;
+
+private:
+    static constexpr size_t kMaxFrames = 4;
+
+    struct Blur {
+        size_t layerIndex;
+        uint32_t radius;
+        SkRect blurRect;
+        sk_sp<SkImage> image;
+    };
+
+    struct Frame {
+        const GrRecordingContext* context = nullptr;
+        DisplaySettings display;
+        SkImageInfo targetInfo;
+        // The layers up to the topmost one with a blur.
+        std::vector<LayerSettings> layers;
+        std::vector<Blur> blurs;
+        uint64_t lastUse = 0;
+    };
+
+    static bool isUnchanged(const LayerSettings& cached, const LayerSettings& layer);
+
+    std::array<Frame, kMaxFrames> mFrames;
+    uint64_t mUseCount = 0;
+
+    // The frame being drawn, and the cached frame it was matched with, if any.
+    const std::vector<const LayerSettings*>* mLayers = nullptr;
+    Frame mCurrent;
+    Frame* mMatch = nullptr;
+    // Number of bottom layers that are unchanged since the matched frame was cached.
+    size_t mUnchangedLayers = 0;
+
+    size_t mHits = 0;
+    size_t mMisses = 0;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -52,6 +52,15 @@ constexpr auto kDestDataSpace = ui::Dataspace::SRGB;
 constexpr auto kOtherDataSpace = ui::Dataspace::DISPLAY_P3;
 } // namespace
 
+// Draws one set of priming layers, then lets the work queued behind priming run, if any.
+static void drawPrimingLayers(SkiaRenderEngine* renderengine, const DisplaySettings& display,
+                              const std::vector<const LayerSettings*>& layers,
+                              const std::shared_ptr<ExternalTexture>& dstTexture) {
+    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache, base::unique_fd(),
+                             nullptr);
+    renderengine->yieldPrimeCache();
+}
+
 static void drawShadowLayers(SkiaRenderEngine* renderengine, const DisplaySettings& display,
                              const std::shared_ptr<ExternalTexture>& dstTexture) {
     // Somewhat arbitrary dimensions, but on screen and slightly shorter, based
@@ -110,8 +119,7 @@ static void drawShadowLayers(SkiaRenderEngine* renderengine, const DisplaySettin
             caster.geometry.positionTransform = transform;
             for (bool translucent : {false, true}){
                 layer.shadow.casterIsTranslucent = translucent;
-                renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                                        base::unique_fd(), nullptr);
+                drawPrimingLayers(renderengine, display, layers, dstTexture);
             }
         }
     }
@@ -150,8 +158,7 @@ static void drawImageLayers(SkiaRenderEngine* renderengine, const DisplaySetting
                 layer.source.buffer.isOpaque = isOpaque;
                 for (auto alpha : {half(.2f), half(1.0f)}) {
                     layer.alpha = alpha;
-                    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                                             base::unique_fd(), nullptr);
+                    drawPrimingLayers(renderengine, display, layers, dstTexture);
                 }
             }
         }
@@ -179,8 +186,7 @@ static void drawSolidLayers(SkiaRenderEngine* renderengine, const DisplaySetting
         layer.geometry.positionTransform = transform;
         for (float roundedCornersRadius : {0.0f, 50.f}) {
             layer.geometry.roundedCornersRadius = roundedCornersRadius;
-            renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                                     base::unique_fd(), nullptr);
+            drawPrimingLayers(renderengine, display, layers, dstTexture);
         }
     }
 }
@@ -203,8 +209,7 @@ static void drawBlurLayers(SkiaRenderEngine* renderengine, const DisplaySettings
     // Different blur code is invoked for radii less and greater than 30 pixels
     for (int radius : {9, 60}) {
         layer.backgroundBlurRadius = radius;
-        renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                                 base::unique_fd(), nullptr);
+        drawPrimingLayers(renderengine, display, layers, dstTexture);
     }
 }
 
@@ -250,8 +255,7 @@ static void drawClippedLayers(SkiaRenderEngine* renderengine, const DisplaySetti
                 layer.geometry.positionTransform = transform;
                 for (float alpha : {0.5f, 1.f}) {
                     layer.alpha = alpha,
-                    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                                             base::unique_fd(), nullptr);
+                    drawPrimingLayers(renderengine, display, layers, dstTexture);
                 }
             }
         }
@@ -288,8 +292,7 @@ static void drawPIPImageLayer(SkiaRenderEngine* renderengine, const DisplaySetti
     };
 
     auto layers = std::vector<const LayerSettings*>{&layer};
-    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                             base::unique_fd(), nullptr);
+    drawPrimingLayers(renderengine, display, layers, dstTexture);
 }
 
 static void drawHolePunchLayer(SkiaRenderEngine* renderengine, const DisplaySettings& display,
@@ -317,8 +320,7 @@ static void drawHolePunchLayer(SkiaRenderEngine* renderengine, const DisplaySett
     };
 
     auto layers = std::vector<const LayerSettings*>{&layer};
-    renderengine->drawLayers(display, layers, dstTexture, kUseFrameBufferCache,
-                            base::unique_fd(), nullptr);
+    drawPrimingLayers(renderengine, display, layers, dstTexture);
 }
 
 //
@@ -16,41 +16,65 @@
 
 #include "ColorSpaces.h"
 
+#include <array>
+#include <iterator>
+
 namespace android {
 namespace renderengine {
 namespace skia {
 
-sk_sp<SkColorSpace> toSkColorSpace(ui::Dataspace dataspace) {
-    skcms_Matrix3x3 gamut;
+// The gamuts and transfer functions that dataspaces map to, indexed as returned below.
+static const skcms_Matrix3x3 kGamuts[] = {SkNamedGamut::kSRGB, SkNamedGamut::kRec2020,
+                                          SkNamedGamut::kDisplayP3};
+static const skcms_TransferFunction kTransferFns[] = {SkNamedTransferFn::kSRGB,
+                                                      SkNamedTransferFn::kLinear,
+                                                      SkNamedTransferFn::kPQ,
+                                                      SkNamedTransferFn::kHLG};
+
+static size_t toGamutIndex(ui::Dataspace dataspace) {
     switch (dataspace & HAL_DATASPACE_STANDARD_MASK) {
         case HAL_DATASPACE_STANDARD_BT709:
-            gamut = SkNamedGamut::kSRGB;
-            break;
+            return 0;
         case HAL_DATASPACE_STANDARD_BT2020:
-            gamut = SkNamedGamut::kRec2020;
-            break;
+            return 1;
         case HAL_DATASPACE_STANDARD_DCI_P3:
-            gamut = SkNamedGamut::kDisplayP3;
-            break;
+            return 2;
         default:
-            gamut = SkNamedGamut::kSRGB;
-            break;
+            return 0;
     }
+}
 
+static size_t toTransferFnIndex(ui::Dataspace dataspace) {
     switch (dataspace & HAL_DATASPACE_TRANSFER_MASK) {
-        case HAL_DATASPACE_TRANSFER_LINEAR:
-            return SkColorSpace::MakeRGB(SkNamedTransferFn::kLinear, gamut);
         case HAL_DATASPACE_TRANSFER_SRGB:
-            return SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, gamut);
+            return 0;
+        case HAL_DATASPACE_TRANSFER_LINEAR:
+            return 1;
         case HAL_DATASPACE_TRANSFER_ST2084:
-            return SkColorSpace::MakeRGB(SkNamedTransferFn::kPQ, gamut);
+            return 2;
         case HAL_DATASPACE_TRANSFER_HLG:
-            return SkColorSpace::MakeRGB(SkNamedTransferFn::kHLG, gamut);
+            return 3;
         default:
-            return SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, gamut);
+            return 0;
     }
 }
 
+sk_sp<SkColorSpace> toSkColorSpace(ui::Dataspace dataspace) {
+    // Color spaces are immutable, so the few that dataspaces map to are made once and shared,
+    // rather than made again for each layer of each frame.
+    static const auto kColorSpaces = [] {
+        std::array<std::array<sk_sp<SkColorSpace>, std::size(kTransferFns)>, std::size(kGamuts)>
+                colorSpaces;
+        for (size_t i = 0; i < std::size(kGamuts); i++) {
+            for (size_t j = 0; j < std::size(kTransferFns); j++) {
+                colorSpaces[i][j] = SkColorSpace::MakeRGB(kTransferFns[j], kGamuts[i]);
+            }
+        }
+        return colorSpaces;
+    }();
+    return kColorSpaces[toGamutIndex(dataspace)][toTransferFnIndex(dataspace)];
+}
+
 } // namespace skia
 } // namespace renderengine
 } // namespace android
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "PersistentShaderCache.h"
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <log/log.h>
+#include <utils/Trace.h>
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+namespace {
+
+void appendU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendBytes(std::string& out, const void* bytes, size_t size) {
+    appendU32(out, static_cast<uint32_t>(size));
+    out.append(static_cast<const char*>(bytes), size);
+}
+
+// Bounds-checked reads from the cache file contents.
+class Reader {
+public:
+    explicit Reader(const std::string& contents) : mContents(contents) {}
+
+    bool readU32(uint32_t* value) {
+        if (mContents.size() - mOffset < sizeof(*value)) return false;
+        memcpy(value, mContents.data() + mOffset, sizeof(*value));
+        mOffset += sizeof(*value);
+        return true;
+    }
+
+    bool readBytes(const char** bytes, size_t* size) {
+        uint32_t length;
+        if (!readU32(&length) || mContents.size() - mOffset < length) return false;
+        *bytes = mContents.data() + mOffset;
+        *size = length;
+        mOffset += length;
+        return true;
+    }
+
+private:
+    const std::string& mContents;
+    size_t mOffset = 0;
+};
+
+} // namespace
+
+PersistentShaderCache::PersistentShaderCache(std::string path, std::string fingerprint)
+      : mPath(std::move(path)), mFingerprint(std::move(fingerprint)) {}
+
+size_t PersistentShaderCache::loadFromFile() {
+    ATRACE_CALL();
+
+    if (mPath.empty()) {
+        return 0;
+    }
+
+    std::string contents;
+    if (!base::ReadFileToString(mPath, &contents)) {
+        ALOGD("No shader cache at %s", mPath.c_str());
+        return 0;
+    }
+
+    Reader reader(contents);
+    uint32_t magic, version, count;
+    const char* fingerprint;
+    size_t fingerprintSize;
+    if (!reader.readU32(&magic) || magic != kMagic || !reader.readU32(&version) ||
+        version != kVersion || !reader.readBytes(&fingerprint, &fingerprintSize) ||
+        std::string_view(fingerprint, fingerprintSize) != mFingerprint ||
+        !reader.readU32(&count)) {
+        ALOGI("Discarding stale shader cache at %s", mPath.c_str());
+        return 0;
+    }
+
+    std::unordered_map<std::string, sk_sp<SkData>> entries;
+    size_t totalBytes = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const char* key;
+        const char* data;
+        size_t keySize, dataSize;
+        if (!reader.readBytes(&key, &keySize) || !reader.readBytes(&data, &dataSize)) {
+            ALOGW("Discarding truncated shader cache at %s", mPath.c_str());
+            return 0;
+        }
+        entries.insert_or_assign(std::string(key, keySize), SkData::MakeWithCopy(data, dataSize));
+        totalBytes += keySize + dataSize;
+    }
+
+    mEntries = std::move(entries);
+    mTotalBytes = totalBytes;
+    mDirty = false;
+    ALOGD("Loaded %zu shaders from %s", mEntries.size(), mPath.c_str());
+    return mEntries.size();
+}
+
+bool PersistentShaderCache::saveToFile() {
+    ATRACE_CALL();
+
+    if (mPath.empty() || !mDirty) {
+        return true;
+    }
+
+    std::string contents;
+    contents.reserve(mTotalBytes + mEntries.size() * 2 * sizeof(uint32_t) + mFingerprint.size() +
+                     4 * sizeof(uint32_t));
+    appendU32(contents, kMagic);
+    appendU32(contents, kVersion);
+    appendBytes(contents, mFingerprint.data(), mFingerprint.size());
+    appendU32(contents, static_cast<uint32_t>(mEntries.size()));
+    for (const auto& [key, data] : mEntries) {
+        appendBytes(contents, key.data(), key.size());
+        appendBytes(contents, data->data(), data->size());
+    }
+
+    // Write to a temporary file and rename it, so that a crash can't leave a partial cache behind.
+    const std::string tempPath = mPath + ".tmp";
+    if (!base::WriteStringToFile(contents, tempPath) ||
+        rename(tempPath.c_str(), mPath.c_str()) != 0) {
+        ALOGW("Failed to write shader cache to %s: %s", mPath.c_str(), strerror(errno));
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    mDirty = false;
+    ALOGD("Saved %zu shaders to %s", mEntries.size(), mPath.c_str());
+    return true;
+}
+
+sk_sp<SkData> PersistentShaderCache::load(const SkData& key) {
+    if (mPath.empty()) {
+        return nullptr;
+    }
+
+    const auto it = mEntries.find(std::string(static_cast<const char*>(key.data()), key.size()));
+    if (it == mEntries.end()) {
+        mMisses++;
+        return nullptr;
+    }
+    mHits++;
+    return it->second;
+}
+
+void PersistentShaderCache::store(const SkData& key, const SkData& data,
+                                  const SkString& description) {
+    mShadersCachedSinceLastCall++;
+    if (mCompilingOnDemand) {
+        mOnDemandCompiles++;
+        if (ATRACE_ENABLED()) {
+            ATRACE_NAME(base::StringPrintf("Shader compiled on demand: %s", description.c_str())
+                                .c_str());
+        }
+    }
+    if (mPath.empty()) {
+        return;
+    }
+
+    std::string keyString(static_cast<const char*>(key.data()), key.size());
+    if (const auto it = mEntries.find(keyString); it != mEntries.end()) {
+        // The cached program was rejected, e.g. by a driver that can't load it anymore.
+        mTotalBytes -= it->second->size();
+        it->second = SkData::MakeWithCopy(data.data(), data.size());
+        mTotalBytes += data.size();
+        mDirty = true;
+        return;
+    }
+
+    if (mTotalBytes + key.size() + data.size() > kMaxTotalBytes) {
+        return;
+    }
+
+    mTotalBytes += key.size() + data.size();
+    mEntries.emplace(std::move(keyString), SkData::MakeWithCopy(data.data(), data.size()));
+    mDirty = true;
+}
+
+std::string PersistentShaderCache::dump() const {
+    if (mPath.empty()) {
+        return base::StringPrintf("Persistent shader cache: disabled, %zu compiled on demand\n",
+                                  mOnDemandCompiles);
+    }
+    return base::StringPrintf("Persistent shader cache (%s): %zu entries, %zu bytes, %zu hits, "
+                              "%zu misses, %zu compiled on demand\n",
+                              mPath.c_str(), mEntries.size(), mTotalBytes, mHits, mMisses,
+                              mOnDemandCompiles);
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
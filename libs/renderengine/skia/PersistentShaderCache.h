@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <GrContextOptions.h>
+#include <SkData.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * PersistentShaderCache keeps the programs that Skia compiles, and saves them to a file so that
+ * they can be reloaded instead of compiled again on the next boot. The file is versioned and
+ * tagged with a fingerprint of the build and GPU driver, and is discarded if either differs.
+ *
+ * Skia calls into the cache on the thread that owns the GrContext, so the cache is not
+ * thread-safe, and loadFromFile() and saveToFile() must be called on that thread too.
+ */
+class PersistentShaderCache : public GrContextOptions::PersistentCache {
+public:
+    // With an empty path nothing is cached, and the cache only counts the shaders Skia compiles.
+    PersistentShaderCache(std::string path, std::string fingerprint);
+    ~PersistentShaderCache() override = default;
+
+    // Reads the cache file, if it exists and matches the version and fingerprint. Returns the
+    // number of entries loaded.
+    size_t loadFromFile();
+
+    // Writes the cache file if any entry was stored since it was last loaded or saved. Returns
+    // false if writing failed.
+    bool saveToFile();
+
+    // GrContextOptions::PersistentCache
+    sk_sp<SkData> load(const SkData& key) override;
+    void store(const SkData& key, const SkData& data, const SkString& description) override;
+
+    // Returns the number of entries stored, i.e. shaders that had to be compiled, since the last
+    // call.
+    int shadersCachedSinceLastCall() {
+        const int shadersCachedSinceLastCall = mShadersCachedSinceLastCall;
+        mShadersCachedSinceLastCall = 0;
+        return shadersCachedSinceLastCall;
+    }
+
+    // Sets whether the shaders stored from now on are compiled on demand by composition, rather
+    // than ahead of time by priming. Those are traced with their description.
+    void setCompilingOnDemand(bool onDemand) { mCompilingOnDemand = onDemand; }
+
+    size_t size() const { return mEntries.size(); }
+    std::string dump() const;
+
+private:
+    static constexpr uint32_t kMagic = 0x53435352; // 'RSCS'
+    static constexpr uint32_t kVersion = 1;
+    // Bounds the file that is read back on every boot.
+    static constexpr size_t kMaxTotalBytes = 8 * 1024 * 1024;
+
+    const std::string mPath;
+    const std::string mFingerprint;
+
+    std::unordered_map<std::string, sk_sp<SkData>> mEntries;
+    size_t mTotalBytes = 0;
+    bool mDirty = false;
+
+    bool mCompilingOnDemand = true;
+    int mShadersCachedSinceLastCall = 0;
+    size_t mOnDemandCompiles = 0;
+    size_t mHits = 0;
+    size_t mMisses = 0;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -31,9 +31,11 @@
 #include <SkGraphics.h>
 #include <SkImage.h>
 #include <SkImageFilters.h>
+#include <SkPath.h>
 #include <SkRegion.h>
 #include <SkShadowUtils.h>
 #include <SkSurface.h>
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <gl/GrGLInterface.h>
 #include <gui/TraceUtils.h>
@@ -43,6 +45,7 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -236,7 +239,11 @@ std::unique_ptr<SkiaGLRenderEngine> SkiaGLRenderEngine::create(
 }
 
 std::future<void> SkiaGLRenderEngine::primeCache() {
+    mShaderCache.setCompilingOnDemand(false);
     Cache::primeShaderCache(this);
+    mShaderCache.setCompilingOnDemand(true);
+    // Persist what priming had to compile, so that the next boot can skip it.
+    mShaderCache.saveToFile();
     return {};
 }
 
@@ -279,25 +286,43 @@ EGLConfig SkiaGLRenderEngine::chooseEglConfig(EGLDisplay display, int format, bo
     return config;
 }
 
-sk_sp<SkData> SkiaGLRenderEngine::SkSLCacheMonitor::load(const SkData& key) {
-    // This "cache" does not actually cache anything. It just allows us to
-    // monitor Skia's internal cache. So this method always returns null.
-    return nullptr;
+static constexpr char kShaderCachePath[] = "/data/misc/surfaceflinger/renderengine_shader_cache";
+
+static std::string getShaderCachePath() {
+    return base::GetBoolProperty(PROPERTY_DEBUG_RENDERENGINE_PERSISTENT_SHADER_CACHE, true)
+            ? kShaderCachePath
+            : "";
 }
 
-void SkiaGLRenderEngine::SkSLCacheMonitor::store(const SkData& key, const SkData& data,
-                                                 const SkString& description) {
-    mShadersCachedSinceLastCall++;
+// Program binaries can only be reused by the same build and GPU driver. Must be called with GL
+// current.
+static std::string getShaderCacheFingerprint() {
+    const auto glString = [](GLenum name) {
+        const char* string = reinterpret_cast<const char*>(glGetString(name));
+        return string ? string : "";
+    };
+    return base::StringPrintf("%s|%s|%s|%s", base::GetProperty("ro.build.fingerprint", "").c_str(),
+                              glString(GL_VENDOR), glString(GL_RENDERER), glString(GL_VERSION));
 }
 
 void SkiaGLRenderEngine::assertShadersCompiled(int numShaders) {
-    const int cached = mSkSLCacheMonitor.shadersCachedSinceLastCall();
+    const int cached = mShaderCache.shadersCachedSinceLastCall();
     LOG_ALWAYS_FATAL_IF(cached != numShaders, "Attempted to cache %i shaders; cached %i",
                         numShaders, cached);
 }
 
 int SkiaGLRenderEngine::reportShadersCompiled() {
-    return mSkSLCacheMonitor.shadersCachedSinceLastCall();
+    return mShaderCache.shadersCachedSinceLastCall();
+}
+
+void SkiaGLRenderEngine::yieldPrimeCache() {
+    if (!mPrimeCacheYieldCallback) {
+        return;
+    }
+    // The work run here draws with whatever priming hasn't compiled yet.
+    mShaderCache.setCompilingOnDemand(true);
+    mPrimeCacheYieldCallback();
+    mShaderCache.setCompilingOnDemand(false);
 }
 
 SkiaGLRenderEngine::SkiaGLRenderEngine(const RenderEngineCreationArgs& args, EGLDisplay display,
@@ -310,15 +335,23 @@ SkiaGLRenderEngine::SkiaGLRenderEngine(const RenderEngineCreationArgs& args, EGL
         mProtectedEGLContext(protectedContext),
         mProtectedPlaceholderSurface(protectedPlaceholder),
         mDefaultPixelFormat(static_cast<PixelFormat>(args.pixelFormat)),
-        mUseColorManagement(args.useColorManagement) {
+        mUseColorManagement(args.useColorManagement),
+        mTextureCacheBudgetOverride(
+                static_cast<size_t>(base::GetUintProperty<uint32_t>(
+                        PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB, 0)) *
+                1024 * 1024),
+        mShaderCache(getShaderCachePath(), getShaderCacheFingerprint()) {
     sk_sp<const GrGLInterface> glInterface(GrGLCreateNativeInterface());
     LOG_ALWAYS_FATAL_IF(!glInterface.get());
 
+    mShaderCache.loadFromFile();
+
     GrContextOptions options;
     options.fDisableDriverCorrectnessWorkarounds = true;
     options.fDisableDistanceFieldPaths = true;
     options.fReducedShaderVariations = true;
-    options.fPersistentCache = &mSkSLCacheMonitor;
+    options.fPersistentCache = &mShaderCache;
+    options.fShaderCacheStrategy = GrContextOptions::ShaderCacheStrategy::kBackendBinary;
     mGrContext = GrDirectContext::MakeGL(glInterface, options);
     if (supportsProtectedContent()) {
         useProtectedContext(true);
@@ -335,6 +368,7 @@ SkiaGLRenderEngine::SkiaGLRenderEngine(const RenderEngineCreationArgs& args, EGL
 
 SkiaGLRenderEngine::~SkiaGLRenderEngine() {
     std::lock_guard<std::mutex> lock(mRenderingMutex);
+    mBlurCache.clear();
     if (mBlurFilter) {
         delete mBlurFilter;
     }
@@ -498,8 +532,15 @@ static bool needsToneMapping(ui::Dataspace sourceDataspace, ui::Dataspace destin
             sourceTransfer != destTransfer;
 }
 
+// Estimates the memory used by the buffer, for texture cache accounting.
+static size_t getBufferBytes(const sp<GraphicBuffer>& buffer) {
+    const size_t pixelBytes = std::max(bytesPerPixel(buffer->getPixelFormat()), 1u);
+    return static_cast<size_t>(buffer->getStride()) * buffer->getHeight() * pixelBytes;
+}
+
 void SkiaGLRenderEngine::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
-                                                  bool isRenderable) {
+                                                  bool isRenderable,
+                                                  ExternalTexture::Owner owner) {
     // Only run this if RE is running on its own thread. This way the access to GL
     // operations is guaranteed to be happening on the same thread.
     if (mRenderEngineType != RenderEngineType::SKIA_GL_THREADED) {
@@ -519,69 +560,79 @@ void SkiaGLRenderEngine::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffe
     // the texture in either GL context because they are initialized with the same share_context
     // which allows the texture state to be shared between them.
     auto grContext = getActiveGrContext();
-    auto& cache = mTextureCache;
 
     std::lock_guard<std::mutex> lock(mRenderingMutex);
-    mGraphicBufferExternalRefs[buffer->getId()]++;
-
-    if (const auto& iter = cache.find(buffer->getId()); iter == cache.end()) {
-        std::shared_ptr<AutoBackendTexture::LocalRef> imageTextureRef =
-                std::make_shared<AutoBackendTexture::LocalRef>(grContext,
-                                                               buffer->toAHardwareBuffer(),
-                                                               isRenderable, mTextureCleanupMgr);
-        cache.insert({buffer->getId(), imageTextureRef});
-    }
+    auto& cleanupMgr = mTextureCleanupMgr;
+    mTextureCache.ref(buffer->getId(), getBufferBytes(buffer), owner, isRenderable, [&] {
+        return std::make_shared<AutoBackendTexture::LocalRef>(grContext,
+                                                              buffer->toAHardwareBuffer(),
+                                                              isRenderable, cleanupMgr);
+    });
 }
 
 void SkiaGLRenderEngine::unmapExternalTextureBuffer(const sp<GraphicBuffer>& buffer) {
     ATRACE_CALL();
     std::lock_guard<std::mutex> lock(mRenderingMutex);
-    if (const auto& iter = mGraphicBufferExternalRefs.find(buffer->getId());
-        iter != mGraphicBufferExternalRefs.end()) {
-        if (iter->second == 0) {
-            ALOGW("Attempted to unmap GraphicBuffer <id: %" PRId64
-                  "> from RenderEngine texture, but the "
-                  "ref count was already zero!",
-                  buffer->getId());
-            mGraphicBufferExternalRefs.erase(buffer->getId());
-            return;
-        }
+    // Buffers are not mapped unless RenderEngine runs on its own thread, so there may be nothing
+    // to unref.
+    if (!mTextureCache.contains(buffer->getId())) {
+        return;
+    }
+    if (!mTextureCache.isReferenced(buffer->getId())) {
+        ALOGW("Attempted to unmap GraphicBuffer <id: %" PRId64
+              "> from RenderEngine texture, but the "
+              "ref count was already zero!",
+              buffer->getId());
+        return;
+    }
 
-        iter->second--;
+    const bool isProtectedBuffer = buffer->getUsage() & GRALLOC_USAGE_PROTECTED;
+    if (!isProtectedBuffer) {
+        // The texture is kept for a few frames, within the cache budget, in case the buffer is
+        // mapped again.
+        mTextureCache.unref(buffer->getId(), /*retain=*/true);
+        return;
+    }
 
-        // Swap contexts if needed prior to deleting this buffer
-        // See Issue 1 of
-        // https://www.khronos.org/registry/EGL/extensions/EXT/EGL_EXT_protected_content.txt: even
-        // when a protected context and an unprotected context are part of the same share group,
-        // protected surfaces may not be accessed by an unprotected context, implying that protected
-        // surfaces may only be freed when a protected context is active.
-        const bool inProtected = mInProtectedContext;
-        useProtectedContext(buffer->getUsage() & GRALLOC_USAGE_PROTECTED);
+    // Swap contexts if needed prior to deleting this buffer
+    // See Issue 1 of
+    // https://www.khronos.org/registry/EGL/extensions/EXT/EGL_EXT_protected_content.txt: even
+    // when a protected context and an unprotected context are part of the same share group,
+    // protected surfaces may not be accessed by an unprotected context, implying that protected
+    // surfaces may only be freed when a protected context is active.
+    const bool inProtected = mInProtectedContext;
+    useProtectedContext(true);
 
-        if (iter->second == 0) {
-            mTextureCache.erase(buffer->getId());
-            mGraphicBufferExternalRefs.erase(buffer->getId());
-        }
+    mTextureCache.unref(buffer->getId(), /*retain=*/false);
 
-        // Swap back to the previous context so that cached values of isProtected in SurfaceFlinger
-        // are up-to-date.
-        if (inProtected != mInProtectedContext) {
-            useProtectedContext(inProtected);
-        }
+    // Swap back to the previous context so that cached values of isProtected in SurfaceFlinger
+    // are up-to-date.
+    if (inProtected != mInProtectedContext) {
+        useProtectedContext(inProtected);
     }
 }
 
 bool SkiaGLRenderEngine::canSkipPostRenderCleanup() const {
     std::lock_guard<std::mutex> lock(mRenderingMutex);
-    return mTextureCleanupMgr.isEmpty();
+    // The unreferenced textures expire in cleanupPostRender.
+    return mTextureCleanupMgr.isEmpty() && !mTextureCache.hasUnreferenced();
 }
 
 void SkiaGLRenderEngine::cleanupPostRender() {
     ATRACE_CALL();
     std::lock_guard<std::mutex> lock(mRenderingMutex);
+    mTextureCache.endFrame();
     mTextureCleanupMgr.cleanup();
 }
 
+void SkiaGLRenderEngine::cleanFramebufferCache() {
+    ATRACE_CALL();
+    // The buffers of a display are gone once its surface is replaced, so the textures kept for
+    // buffers that are no longer mapped are released with them.
+    std::lock_guard<std::mutex> lock(mRenderingMutex);
+    mTextureCache.releaseUnreferenced();
+}
+
 // Helper class intended to be used on the stack to ensure that texture cleanup
 // is deferred until after this class goes out of scope.
 class DeferTextureCleanup final {
@@ -614,10 +665,10 @@ sk_sp<SkShader> SkiaGLRenderEngine::createRuntimeEffectShader(
     }
 
     if (requiresLinearEffect) {
-        const ui::Dataspace inputDataspace =
-                mUseColorManagement ? layer->sourceDataspace : ui::Dataspace::V0_SRGB_LINEAR;
-        const ui::Dataspace outputDataspace =
-                mUseColorManagement ? display.outputDataspace : ui::Dataspace::V0_SRGB_LINEAR;
+        const ui::Dataspace inputDataspace = toLinearEffectDataspace(
+                mUseColorManagement ? layer->sourceDataspace : ui::Dataspace::V0_SRGB_LINEAR);
+        const ui::Dataspace outputDataspace = toLinearEffectDataspace(
+                mUseColorManagement ? display.outputDataspace : ui::Dataspace::V0_SRGB_LINEAR);
 
         LinearEffect effect = LinearEffect{.inputDataspace = inputDataspace,
                                            .outputDataspace = outputDataspace,
@@ -726,6 +777,52 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
         return NO_ERROR;
     }
 
+    if (const status_t status = drawLayersLocked(display, layers, buffer, std::move(bufferFence));
+        status != NO_ERROR) {
+        return status;
+    }
+    return submitLocked(drawFence);
+}
+
+std::vector<RenderEngine::DrawLayersResult> SkiaGLRenderEngine::drawLayersBatch(
+        std::vector<DrawLayersRequest>&& requests) {
+    ATRACE_NAME("SkiaGL::drawLayersBatch");
+
+    std::lock_guard<std::mutex> lock(mRenderingMutex);
+    std::vector<DrawLayersResult> results(requests.size());
+    std::vector<size_t> drawn;
+    for (size_t i = 0; i < requests.size(); i++) {
+        DrawLayersRequest& request = requests[i];
+        if (request.layers.empty()) {
+            ALOGV("Drawing empty layer stack");
+            continue;
+        }
+        results[i].status = drawLayersLocked(request.display, request.layers, request.buffer,
+                                             std::move(request.bufferFence));
+        if (results[i].status == NO_ERROR) {
+            drawn.push_back(i);
+        }
+    }
+    if (drawn.empty()) {
+        return results;
+    }
+
+    // The requests are submitted with a single flush, so they share its fence.
+    base::unique_fd drawFence;
+    const status_t status = submitLocked(&drawFence);
+    for (const size_t i : drawn) {
+        results[i].status = status;
+        if (status == NO_ERROR && drawFence.get() >= 0) {
+            results[i].drawFence.reset(dup(drawFence.get()));
+        }
+    }
+    return results;
+}
+
+status_t SkiaGLRenderEngine::drawLayersLocked(const DisplaySettings& display,
+                                              const std::vector<const LayerSettings*>& layers,
+                                              const std::shared_ptr<ExternalTexture>& buffer,
+                                              base::unique_fd&& bufferFence) {
     if (bufferFence.get() >= 0) {
         // Duplicate the fence for passing to waitFence.
         base::unique_fd bufferFenceDup(dup(bufferFence.get()));
@@ -742,15 +839,13 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
     validateOutputBufferUsage(buffer->getBuffer());
 
     auto grContext = getActiveGrContext();
-    auto& cache = mTextureCache;
 
     // any AutoBackendTexture deletions will now be deferred until cleanupPostRender is called
     DeferTextureCleanup dtc(mTextureCleanupMgr);
 
-    std::shared_ptr<AutoBackendTexture::LocalRef> surfaceTextureRef;
-    if (const auto& it = cache.find(buffer->getBuffer()->getId()); it != cache.end()) {
-        surfaceTextureRef = it->second;
-    } else {
+    std::shared_ptr<AutoBackendTexture::LocalRef> surfaceTextureRef =
+            mTextureCache.get(buffer->getBuffer()->getId());
+    if (!surfaceTextureRef) {
         surfaceTextureRef =
                 std::make_shared<AutoBackendTexture::LocalRef>(grContext,
                                                                buffer->getBuffer()
@@ -807,10 +902,28 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
         }
     }
 
+    // Only draw the damage if the rest of the buffer is up to date. Blurs sample the pixels around
+    // them though, so everything is drawn if there are any.
+    const bool drawDamageOnly = !display.damage.isEmpty() &&
+            !(mBlurFilter && std::any_of(layers.begin(), layers.end(), [&](const auto* layer) {
+                return layerHasBlur(layer, ctModifiesAlpha);
+            }));
+
     AutoSaveRestore surfaceAutoSaveRestore(canvas);
-    // Clear the entire canvas with a transparent black to prevent ghost images.
-    canvas->clear(SK_ColorTRANSPARENT);
+    // Clear the entire canvas with a transparent black to prevent ghost images, or only the damage
+    // if that is all that is drawn.
+    if (!drawDamageOnly) {
+        canvas->clear(SK_ColorTRANSPARENT);
+    }
     initCanvas(canvas, display);
+    if (drawDamageOnly) {
+        SkPath damage;
+        for (const Rect& rect : display.damage) {
+            damage.addRect(getSkRect(rect));
+        }
+        canvas->clipPath(damage);
+        canvas->clear(SK_ColorTRANSPARENT);
+    }
 
     // TODO: clearRegion was required for SurfaceView when a buffer is not yet available but the
     // view is still on-screen. The clear region could be re-specified as a black color layer,
@@ -834,7 +947,12 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
         canvas->drawRegion(clearRegion, paint);
     }
 
-    for (const auto& layer : layers) {
+    if (mBlurFilter) {
+        mBlurCache.beginFrame(grContext, display, dstSurface->imageInfo(), layers);
+    }
+
+    for (size_t layerIndex = 0; layerIndex < layers.size(); layerIndex++) {
+        const auto& layer = layers[layerIndex];
         ATRACE_FORMAT("DrawLayer: %s", layer->name.c_str());
 
         if (kPrintLayerSettings) {
@@ -921,9 +1039,9 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
             if (blurRect.width() > 0 && blurRect.height() > 0) {
                 if (layer->backgroundBlurRadius > 0) {
                     ATRACE_NAME("BackgroundBlur");
-                    auto blurredImage =
-                            mBlurFilter->generate(grContext, layer->backgroundBlurRadius, blurInput,
-                                                  blurRect);
+                    auto blurredImage = generateBlur(grContext, layerIndex,
+                                                     layer->backgroundBlurRadius, blurInput,
+                                                     blurRect);
 
                     cachedBlurs[layer->backgroundBlurRadius] = blurredImage;
 
@@ -936,8 +1054,8 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
                     if (cachedBlurs[region.blurRadius] == nullptr) {
                         ATRACE_NAME("BlurRegion");
                         cachedBlurs[region.blurRadius] =
-                                mBlurFilter->generate(grContext, region.blurRadius, blurInput,
-                                                      blurRect);
+                                generateBlur(grContext, layerIndex, region.blurRadius, blurInput,
+                                             blurRect);
                     }
 
                     mBlurFilter->drawBlurRegion(canvas, getBlurRRect(region), region.blurRadius,
@@ -998,12 +1116,9 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
             ATRACE_NAME("DrawImage");
             validateInputBufferUsage(layer->source.buffer.buffer->getBuffer());
             const auto& item = layer->source.buffer;
-            std::shared_ptr<AutoBackendTexture::LocalRef> imageTextureRef = nullptr;
-
-            if (const auto& iter = cache.find(item.buffer->getBuffer()->getId());
-                iter != cache.end()) {
-                imageTextureRef = iter->second;
-            } else {
+            std::shared_ptr<AutoBackendTexture::LocalRef> imageTextureRef =
+                    mTextureCache.get(item.buffer->getBuffer()->getId());
+            if (!imageTextureRef) {
                 // If we didn't find the image in the cache, then create a local ref but don't cache
                 // it. If we're using skia, we're guaranteed to run on a dedicated GPU thread so if
                 // we didn't find anything in the cache then we intentionally did not cache this
@@ -1109,13 +1224,20 @@ status_t SkiaGLRenderEngine::drawLayers(const DisplaySettings& display,
         }
     }
     surfaceAutoSaveRestore.restore();
+    if (mBlurFilter) {
+        mBlurCache.endFrame();
+    }
     mCapture->endCapture();
     {
         ATRACE_NAME("flush surface");
         LOG_ALWAYS_FATAL_IF(activeSurface != dstSurface);
         activeSurface->flush();
     }
+    return NO_ERROR;
+}
 
+status_t SkiaGLRenderEngine::submitLocked(base::unique_fd* drawFence) {
+    auto grContext = getActiveGrContext();
     if (drawFence != nullptr) {
         *drawFence = flush();
     }
@@ -1281,6 +1403,18 @@ void SkiaGLRenderEngine::drawShadow(SkCanvas* canvas, const SkRRect& casterRRect
                               flags);
 }
 
+sk_sp<SkImage> SkiaGLRenderEngine::generateBlur(GrRecordingContext* context, size_t layerIndex,
+                                                uint32_t radius, const sk_sp<SkImage>& input,
+                                                const SkRect& blurRect) {
+    if (sk_sp<SkImage> blurredImage = mBlurCache.get(layerIndex, radius, blurRect)) {
+        ATRACE_NAME("Cached blur");
+        return blurredImage;
+    }
+    sk_sp<SkImage> blurredImage = mBlurFilter->generate(context, radius, input, blurRect);
+    mBlurCache.put(layerIndex, radius, blurRect, blurredImage);
+    return blurredImage;
+}
+
 EGLContext SkiaGLRenderEngine::createEglContext(EGLDisplay display, EGLConfig config,
                                                 EGLContext shareContext,
                                                 std::optional<ContextPriority> contextPriority,
@@ -1398,6 +1532,9 @@ int SkiaGLRenderEngine::getContextPriority() {
     return value;
 }
 
+// Unmapped buffers are kept up to this many screens' worth of memory, on top of the mapped ones.
+static constexpr size_t kTextureCacheBudgetScreens = 1;
+
 void SkiaGLRenderEngine::onPrimaryDisplaySizeChanged(ui::Size size) {
     // This cache multiplier was selected based on review of cache sizes relative
     // to the screen resolution. Looking at the worst case memory needed by blur (~1.5x),
@@ -1409,6 +1546,15 @@ void SkiaGLRenderEngine::onPrimaryDisplaySizeChanged(ui::Size size) {
     // start by resizing the current context
     getActiveGrContext()->setResourceCacheLimit(maxResourceBytes);
 
+    {
+        std::lock_guard<std::mutex> lock(mRenderingMutex);
+        mTextureCache.setBudget(mTextureCacheBudgetOverride > 0
+                                        ? mTextureCacheBudgetOverride
+                                        : static_cast<size_t>(size.width * size.height) *
+                                                kTextureCacheBudgetScreens *
+                                                bytesPerPixel(mDefaultPixelFormat));
+    }
+
     // if it is possible to switch contexts then we will resize the other context
     const bool originalProtectedState = mInProtectedContext;
     useProtectedContext(!mInProtectedContext);
@@ -1432,7 +1578,8 @@ void SkiaGLRenderEngine::dump(std::string& result) {
                   supportsProtectedContent());
     StringAppendF(&result, "RenderEngine is in protected context: %d\n", mInProtectedContext);
     StringAppendF(&result, "RenderEngine shaders cached since last dump/primeCache: %d\n",
-                  mSkSLCacheMonitor.shadersCachedSinceLastCall());
+                  mShaderCache.shadersCachedSinceLastCall());
+    result.append(mShaderCache.dump());
 
     std::vector<ResourcePair> cpuResourceMap = {
             {"skia/sk_resource_cache/bitmap_", "Bitmaps"},
@@ -1464,20 +1611,10 @@ void SkiaGLRenderEngine::dump(std::string& result) {
         StringAppendF(&result, "Skia's Wrapped Objects:\n");
         gpuReporter.logOutput(result, true);
 
-        StringAppendF(&result, "RenderEngine tracked buffers: %zu\n",
-                      mGraphicBufferExternalRefs.size());
-        StringAppendF(&result, "Dumping buffer ids...\n");
-        for (const auto& [id, refCounts] : mGraphicBufferExternalRefs) {
-            StringAppendF(&result, "- 0x%" PRIx64 " - %d refs \n", id, refCounts);
-        }
-        StringAppendF(&result, "RenderEngine AHB/BackendTexture cache size: %zu\n",
-                      mTextureCache.size());
-        StringAppendF(&result, "Dumping buffer ids...\n");
-        // TODO(178539829): It would be nice to know which layer these are coming from and what
-        // the texture sizes are.
-        for (const auto& [id, unused] : mTextureCache) {
-            StringAppendF(&result, "- 0x%" PRIx64 "\n", id);
-        }
+        StringAppendF(&result, "RenderEngine AHB/BackendTexture cache:\n");
+        mTextureCache.dump(result);
+        StringAppendF(&result, "\n");
+        mBlurCache.dump(result);
         StringAppendF(&result, "\n");
 
         SkiaMemoryReporter gpuProtectedReporter(gpuResourceMap, true);
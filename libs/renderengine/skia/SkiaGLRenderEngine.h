@@ -31,10 +31,13 @@
 #include <unordered_map>
 
 #include "AutoBackendTexture.h"
+#include "BlurCache.h"
 #include "EGL/egl.h"
 #include "GrContextOptions.h"
+#include "PersistentShaderCache.h"
 #include "SkImageInfo.h"
 #include "SkiaRenderEngine.h"
+#include "TextureCache.h"
 #include "android-base/macros.h"
 #include "debug/SkiaCapture.h"
 #include "filters/BlurFilter.h"
@@ -59,8 +62,10 @@ public:
                         const std::shared_ptr<ExternalTexture>& buffer,
                         const bool useFramebufferCache, base::unique_fd&& bufferFence,
                         base::unique_fd* drawFence) override;
+    std::vector<DrawLayersResult> drawLayersBatch(
+            std::vector<DrawLayersRequest>&& requests) override;
     void cleanupPostRender() override;
-    void cleanFramebufferCache() override{};
+    void cleanFramebufferCache() override;
     int getContextPriority() override;
     bool isProtected() const override { return mInProtectedContext; }
     bool supportsProtectedContent() const override;
@@ -69,14 +74,19 @@ public:
     void assertShadersCompiled(int numShaders) override;
     void onPrimaryDisplaySizeChanged(ui::Size size) override;
     int reportShadersCompiled() override;
+    void yieldPrimeCache() override;
 
 protected:
     void dump(std::string& result) override;
     size_t getMaxTextureSize() const override;
     size_t getMaxViewportDims() const override;
-    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable) override;
+    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable,
+                                  ExternalTexture::Owner owner) override;
     void unmapExternalTextureBuffer(const sp<GraphicBuffer>& buffer) override;
     bool canSkipPostRenderCleanup() const override;
+    void setPrimeCacheYieldCallback(std::function<void()> callback) override {
+        mPrimeCacheYieldCallback = std::move(callback);
+    }
 
 private:
     static EGLConfig chooseEglConfig(EGLDisplay display, int format, bool logConfig);
@@ -98,9 +108,21 @@ private:
     inline SkPoint3 getSkPoint3(const vec3& vector);
     inline GrDirectContext* getActiveGrContext() const;
 
+    // Draws the layers, without submitting the GPU work.
+    status_t drawLayersLocked(const DisplaySettings& display,
+                              const std::vector<const LayerSettings*>& layers,
+                              const std::shared_ptr<ExternalTexture>& buffer,
+                              base::unique_fd&& bufferFence) REQUIRES(mRenderingMutex);
+    // Submits the GPU work drawn since the last submission. If drawFence is not null, it is set
+    // to a fence that fires once that work completes.
+    status_t submitLocked(base::unique_fd* drawFence) REQUIRES(mRenderingMutex);
     base::unique_fd flush();
     bool waitFence(base::unique_fd fenceFd);
     void initCanvas(SkCanvas* canvas, const DisplaySettings& display);
+    // Returns the blur of the layer at layerIndex from the blur cache, or generates it.
+    sk_sp<SkImage> generateBlur(GrRecordingContext* context, size_t layerIndex, uint32_t radius,
+                                const sk_sp<SkImage>& input, const SkRect& blurRect)
+            REQUIRES(mRenderingMutex);
     void drawShadow(SkCanvas* canvas, const SkRRect& casterRRect,
                     const ShadowSettings& shadowSettings);
     // If requiresLinearEffect is true or the layer has a stretchEffect a new shader is returned.
@@ -125,14 +147,16 @@ private:
     // textures or shaders
     using GraphicBufferId = uint64_t;
 
-    // Number of external holders of ExternalTexture references, per GraphicBuffer ID.
-    std::unordered_map<GraphicBufferId, int32_t> mGraphicBufferExternalRefs
-            GUARDED_BY(mRenderingMutex);
-    // Cache of GL textures that we'll store per GraphicBuffer ID, shared between GPU contexts.
-    std::unordered_map<GraphicBufferId, std::shared_ptr<AutoBackendTexture::LocalRef>> mTextureCache
-            GUARDED_BY(mRenderingMutex);
+    // Cache of GL textures that we'll store per GraphicBuffer ID, shared between GPU contexts,
+    // along with the number of external holders of ExternalTexture references.
+    TextureCache mTextureCache GUARDED_BY(mRenderingMutex);
+    // Budget of the texture cache set by PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB, if
+    // any. Otherwise, the budget scales with the primary display size.
+    const size_t mTextureCacheBudgetOverride;
     std::unordered_map<LinearEffect, sk_sp<SkRuntimeEffect>, LinearEffectHasher> mRuntimeEffects;
     AutoBackendTexture::CleanupManager mTextureCleanupMgr GUARDED_BY(mRenderingMutex);
+    // Blurs of the last frames that had any, reused while the content beneath them is unchanged.
+    BlurCache mBlurCache GUARDED_BY(mRenderingMutex);
 
     StretchShaderFactory mStretchShaderFactory;
     // Mutex guarding rendering operations, so that:
@@ -152,28 +176,10 @@ private:
     // Object to capture commands send to Skia.
     std::unique_ptr<SkiaCapture> mCapture;
 
-    // Implements PersistentCache as a way to monitor what SkSL shaders Skia has
-    // cached.
-    class SkSLCacheMonitor : public GrContextOptions::PersistentCache {
-    public:
-        SkSLCacheMonitor() = default;
-        ~SkSLCacheMonitor() override = default;
-
-        sk_sp<SkData> load(const SkData& key) override;
-
-        void store(const SkData& key, const SkData& data, const SkString& description) override;
-
-        int shadersCachedSinceLastCall() {
-            const int shadersCachedSinceLastCall = mShadersCachedSinceLastCall;
-            mShadersCachedSinceLastCall = 0;
-            return shadersCachedSinceLastCall;
-        }
-
-    private:
-        int mShadersCachedSinceLastCall = 0;
-    };
-
-    SkSLCacheMonitor mSkSLCacheMonitor;
+    // Holds the programs Skia compiles, persisted across boots. Also monitors how many shaders
+    // Skia had to compile.
+    PersistentShaderCache mShaderCache;
+    std::function<void()> mPrimeCacheYieldCallback;
 };
 
 } // namespace skia
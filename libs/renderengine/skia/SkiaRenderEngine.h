@@ -55,10 +55,13 @@ public:
     virtual int getContextPriority() override { return 0; }
     virtual void assertShadersCompiled(int numShaders) {}
     virtual int reportShadersCompiled() { return 0; }
+    // Called by Cache between its priming draws.
+    virtual void yieldPrimeCache() {}
 
 protected:
     virtual void mapExternalTextureBuffer(const sp<GraphicBuffer>& /*buffer*/,
-                                          bool /*isRenderable*/) override = 0;
+                                          bool /*isRenderable*/,
+                                          ExternalTexture::Owner /*owner*/) override = 0;
     virtual void unmapExternalTextureBuffer(const sp<GraphicBuffer>& /*buffer*/) override = 0;
 };
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCache.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+namespace {
+
+const char* toString(ExternalTexture::Owner owner) {
+    switch (owner) {
+        case ExternalTexture::Owner::LAYER:
+            return "layer";
+        case ExternalTexture::Owner::OUTPUT:
+            return "output";
+        case ExternalTexture::Owner::CACHED_SET:
+            return "cached set";
+        case ExternalTexture::Owner::SCREENSHOT:
+            return "screenshot";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+void TextureCache::ref(BufferId id, size_t bytes, Owner owner, bool isRenderable,
+                       const std::function<Texture()>& createTexture) {
+    auto it = mEntries.find(id);
+    const bool isNew = it == mEntries.end();
+    if (isNew) {
+        it = mEntries.try_emplace(id).first;
+        it->second.bytes = bytes;
+        it->second.owner = owner;
+        mTotalBytes += bytes;
+        statsFor(owner).entries++;
+        statsFor(owner).bytes += bytes;
+    } else if (it->second.refs == 0) {
+        mUnreferencedBytes -= it->second.bytes;
+        mUnreferencedCount--;
+        mReused++;
+    }
+
+    Entry& entry = it->second;
+    if (isNew || (isRenderable && !entry.isRenderable)) {
+        entry.texture = createTexture();
+        entry.isRenderable = isRenderable;
+    }
+    entry.refs++;
+    entry.lastUse = ++mUseCount;
+
+    evictToBudget();
+}
+
+bool TextureCache::unref(BufferId id, bool retain) {
+    const auto it = mEntries.find(id);
+    if (it == mEntries.end() || it->second.refs == 0) {
+        return false;
+    }
+
+    Entry& entry = it->second;
+    if (--entry.refs > 0) {
+        return true;
+    }
+
+    if (retain) {
+        mUnreferencedBytes += entry.bytes;
+        mUnreferencedCount++;
+        entry.unreferencedFrame = mFrame;
+        evictToBudget();
+    } else {
+        erase(it);
+    }
+    return true;
+}
+
+TextureCache::Texture TextureCache::get(BufferId id) {
+    const auto it = mEntries.find(id);
+    if (it == mEntries.end()) {
+        mMisses++;
+        return nullptr;
+    }
+    mHits++;
+    it->second.lastUse = ++mUseCount;
+    return it->second.texture;
+}
+
+void TextureCache::setBudget(size_t bytes) {
+    mBudget = bytes;
+    evictToBudget();
+}
+
+void TextureCache::endFrame() {
+    mFrame++;
+    releaseUnreferencedIf([this](const Entry& entry) {
+        return mFrame - entry.unreferencedFrame >= kMaxUnreferencedFrames;
+    });
+}
+
+void TextureCache::releaseUnreferenced() {
+    releaseUnreferencedIf([](const Entry&) { return true; });
+}
+
+template <typename Predicate>
+void TextureCache::releaseUnreferencedIf(Predicate predicate) {
+    for (auto it = mEntries.begin(); mUnreferencedCount > 0 && it != mEntries.end();) {
+        if (it->second.refs == 0 && predicate(it->second)) {
+            erase(it++);
+            mReleases++;
+        } else {
+            it++;
+        }
+    }
+}
+
+void TextureCache::erase(std::unordered_map<BufferId, Entry>::iterator it) {
+    const Entry& entry = it->second;
+    if (entry.refs == 0) {
+        mUnreferencedBytes -= entry.bytes;
+        mUnreferencedCount--;
+    }
+    mTotalBytes -= entry.bytes;
+    statsFor(entry.owner).entries--;
+    statsFor(entry.owner).bytes -= entry.bytes;
+    mEntries.erase(it);
+}
+
+void TextureCache::evictToBudget() {
+    while (mUnreferencedBytes > mBudget) {
+        auto lru = mEntries.end();
+        for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+            if (it->second.refs == 0 &&
+                (lru == mEntries.end() || it->second.lastUse < lru->second.lastUse)) {
+                lru = it;
+            }
+        }
+        if (lru == mEntries.end()) {
+            break;
+        }
+        erase(lru);
+        mEvictions++;
+    }
+}
+
+void TextureCache::dump(std::string& result) const {
+    using base::StringAppendF;
+
+    const size_t lookups = mHits + mMisses;
+    const float hitRate =
+            lookups ? 100.f * static_cast<float>(mHits) / static_cast<float>(lookups) : 0.f;
+    StringAppendF(&result,
+                  "Texture cache: %zu entries, %zu bytes (%zu unreferenced, budget %zu bytes)\n",
+                  mEntries.size(), mTotalBytes, mUnreferencedBytes, mBudget);
+    StringAppendF(&result,
+                  "  %zu hits, %zu misses (hit rate %.1f%%), %zu reused, %zu evicted, %zu "
+                  "released\n",
+                  mHits, mMisses, hitRate, mReused, mEvictions, mReleases);
+    for (size_t i = 0; i < kNumOwners; i++) {
+        StringAppendF(&result, "  %s: %zu entries, %zu bytes\n",
+                      toString(static_cast<Owner>(i)), mOwnerStats[i].entries,
+                      mOwnerStats[i].bytes);
+    }
+    for (const auto& [id, entry] : mEntries) {
+        StringAppendF(&result, "- 0x%" PRIx64 " - %s, %zu bytes, %d refs\n", id,
+                      toString(entry.owner), entry.bytes, entry.refs);
+    }
+}
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <renderengine/ExternalTexture.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "AutoBackendTexture.h"
+
+namespace android {
+namespace renderengine {
+namespace skia {
+
+/**
+ * TextureCache keeps the textures of the buffers mapped into RenderEngine, per GraphicBuffer ID.
+ *
+ * When the last external reference to a buffer is dropped, its texture is kept for a few frames so
+ * that mapping the buffer again doesn't import it again. As the texture keeps the buffer alive,
+ * the unreferenced textures are bounded by the memory budget, and the least recently used of them
+ * are evicted first. A buffer that isn't mapped again within kMaxUnreferencedFrames is considered
+ * removed, and its texture is released. The textures of referenced buffers are never evicted.
+ *
+ * TextureCache is not thread-safe.
+ */
+class TextureCache {
+public:
+    using BufferId = uint64_t;
+    using Texture = std::shared_ptr<AutoBackendTexture::LocalRef>;
+    using Owner = ExternalTexture::Owner;
+
+    // Adds an external reference to the buffer. If its texture isn't cached, or can't be rendered
+    // to while isRenderable is set, the texture is created with createTexture.
+    void ref(BufferId id, size_t bytes, Owner owner, bool isRenderable,
+             const std::function<Texture()>& createTexture);
+
+    // Drops an external reference to the buffer. Once there are none left, its texture is kept
+    // until it expires or the budget requires evicting it, unless retain is false. Returns false
+    // if the buffer wasn't referenced.
+    bool unref(BufferId id, bool retain);
+
+    // Returns the texture of the buffer, or nullptr if it isn't cached, and counts the hit or miss.
+    Texture get(BufferId id);
+
+    // Sets the budget of the unreferenced textures, evicting them until they fit in it.
+    void setBudget(size_t bytes);
+    size_t getBudget() const { return mBudget; }
+
+    // Called once per frame. Releases the textures of the buffers that have been unreferenced for
+    // kMaxUnreferencedFrames.
+    void endFrame();
+    // Releases all the unreferenced textures, such as when the buffers are known to be gone.
+    void releaseUnreferenced();
+    bool hasUnreferenced() const { return mUnreferencedCount > 0; }
+
+    bool contains(BufferId id) const { return mEntries.count(id) > 0; }
+    bool isReferenced(BufferId id) const {
+        const auto it = mEntries.find(id);
+        return it != mEntries.end() && it->second.refs > 0;
+    }
+    size_t size() const { return mEntries.size(); }
+    size_t getTotalBytes() const { return mTotalBytes; }
+
+    void dump(std::string& result) const;
+
+private:
+    static constexpr size_t kNumOwners = static_cast<size_t>(Owner::SCREENSHOT) + 1;
+    // Long enough for a client that sends its buffers without caching them to send them again.
+    static constexpr uint64_t kMaxUnreferencedFrames = 4;
+
+    struct Entry {
+        Texture texture;
+        size_t bytes = 0;
+        Owner owner = Owner::LAYER;
+        bool isRenderable = false;
+        int32_t refs = 0;
+        uint64_t lastUse = 0;
+        // The frame in which the last reference was dropped.
+        uint64_t unreferencedFrame = 0;
+    };
+
+    struct OwnerStats {
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    OwnerStats& statsFor(Owner owner) { return mOwnerStats[static_cast<size_t>(owner)]; }
+    void erase(std::unordered_map<BufferId, Entry>::iterator it);
+    void evictToBudget();
+    template <typename Predicate>
+    void releaseUnreferencedIf(Predicate predicate);
+
+    std::unordered_map<BufferId, Entry> mEntries;
+    size_t mBudget = 0;
+    size_t mTotalBytes = 0;
+    size_t mUnreferencedBytes = 0;
+    size_t mUnreferencedCount = 0;
+    uint64_t mUseCount = 0;
+    uint64_t mFrame = 0;
+
+    std::array<OwnerStats, kNumOwners> mOwnerStats;
+    size_t mHits = 0;
+    size_t mMisses = 0;
+    // Mappings that found the texture of an unreferenced buffer still cached.
+    size_t mReused = 0;
+    size_t mEvictions = 0;
+    // Unreferenced textures released because they expired or their buffers were gone.
+    size_t mReleases = 0;
+};
+
+} // namespace skia
+} // namespace renderengine
+} // namespace android
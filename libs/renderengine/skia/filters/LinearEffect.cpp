@@ -411,23 +411,38 @@ static void generateEffectiveOOTF(bool undoPremultipliedAlpha, SkString& shader)
         }
     )");
 }
-static ColorSpace toColorSpace(ui::Dataspace dataspace) {
+
+// The conversions between the linear RGB of a color space and XYZ.
+struct ColorSpaceMatrices {
+    explicit ColorSpaceMatrices(const ColorSpace& colorSpace)
+          : rgbToXyz(colorSpace.getRGBtoXYZ()), xyzToRgb(colorSpace.getXYZtoRGB()) {}
+
+    const mat4 rgbToXyz;
+    const mat4 xyzToRgb;
+};
+
+// Each shader draws with the matrices of its dataspaces, so they are only computed once.
+static const ColorSpaceMatrices& getColorSpaceMatrices(ui::Dataspace dataspace) {
+    static const ColorSpaceMatrices kSrgb(ColorSpace::sRGB());
+    static const ColorSpaceMatrices kDisplayP3(ColorSpace::DisplayP3());
+    static const ColorSpaceMatrices kBt2020(ColorSpace::BT2020());
     switch (dataspace & HAL_DATASPACE_STANDARD_MASK) {
         case HAL_DATASPACE_STANDARD_BT709:
-            return ColorSpace::sRGB();
-            break;
+            return kSrgb;
         case HAL_DATASPACE_STANDARD_DCI_P3:
-            return ColorSpace::DisplayP3();
-            break;
+            return kDisplayP3;
         case HAL_DATASPACE_STANDARD_BT2020:
-            return ColorSpace::BT2020();
-            break;
+            return kBt2020;
         default:
-            return ColorSpace::sRGB();
-            break;
+            return kSrgb;
     }
 }
 
+ui::Dataspace toLinearEffectDataspace(ui::Dataspace dataspace) {
+    return static_cast<ui::Dataspace>(
+            dataspace & (HAL_DATASPACE_STANDARD_MASK | HAL_DATASPACE_TRANSFER_MASK));
+}
+
 sk_sp<SkRuntimeEffect> buildRuntimeEffect(const LinearEffect& linearEffect) {
     ATRACE_CALL();
     SkString shaderString;
@@ -457,12 +472,10 @@ sk_sp<SkShader> createLinearEffectShader(sk_sp<SkShader> shader, const LinearEff
         effectBuilder.uniform("in_rgbToXyz") = mat4();
         effectBuilder.uniform("in_xyzToRgb") = colorTransform;
     } else {
-        ColorSpace inputColorSpace = toColorSpace(linearEffect.inputDataspace);
-        ColorSpace outputColorSpace = toColorSpace(linearEffect.outputDataspace);
-
-        effectBuilder.uniform("in_rgbToXyz") = mat4(inputColorSpace.getRGBtoXYZ());
+        effectBuilder.uniform("in_rgbToXyz") =
+                getColorSpaceMatrices(linearEffect.inputDataspace).rgbToXyz;
         effectBuilder.uniform("in_xyzToRgb") =
-                colorTransform * mat4(outputColorSpace.getXYZtoRGB());
+                colorTransform * getColorSpaceMatrices(linearEffect.outputDataspace).xyzToRgb;
     }
 
     effectBuilder.uniform("in_displayMaxLuminance") = maxDisplayLuminance;
@@ -82,6 +82,10 @@ struct LinearEffectHasher {
     }
 };
 
+// Keeps the parts of a dataspace that a linear effect depends on, its standard and transfer, so
+// that the dataspaces which only differ otherwise, such as in range, share the same effect.
+ui::Dataspace toLinearEffectDataspace(ui::Dataspace dataspace);
+
 sk_sp<SkRuntimeEffect> buildRuntimeEffect(const LinearEffect& linearEffect);
 
 // Generates a shader resulting from applying the a linear effect created from
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SkSurface.h>
+#include <fcntl.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <renderengine/mock/RenderEngine.h>
+
+#include "../skia/BlurCache.h"
+
+namespace android {
+namespace renderengine {
+namespace skia {
+namespace {
+
+constexpr uint32_t kRadius = 30;
+const SkRect kBlurRect = SkRect::MakeWH(100, 100);
+const SkImageInfo kTargetInfo = SkImageInfo::MakeN32Premul(100, 100);
+
+class BlurCacheTest : public testing::Test {
+protected:
+    BlurCacheTest() {
+        mBackground.source.solidColor = half3(1.0f, 0.0f, 0.0f);
+        mBlurLayer.backgroundBlurRadius = kRadius;
+        mLayers = {&mBackground, &mBlurLayer};
+    }
+
+    static sk_sp<SkImage> makeImage() {
+        return SkSurface::MakeRaster(SkImageInfo::MakeN32Premul(1, 1))->makeImageSnapshot();
+    }
+
+    // Draws a frame with the cache, as SkiaGLRenderEngine does, and returns the blur it used.
+    sk_sp<SkImage> drawFrame() {
+        mCache.beginFrame(nullptr, mDisplay, kTargetInfo, mLayers);
+        sk_sp<SkImage> blur = mCache.get(1, kRadius, kBlurRect);
+        if (!blur) {
+            blur = makeImage();
+            mCache.put(1, kRadius, kBlurRect, blur);
+        }
+        mCache.endFrame();
+        return blur;
+    }
+
+    // Outlives the textures of the layers cached.
+    mock::RenderEngine mRenderEngine;
+    DisplaySettings mDisplay;
+    LayerSettings mBackground;
+    LayerSettings mBlurLayer;
+    std::vector<const LayerSettings*> mLayers;
+    BlurCache mCache;
+};
+
+TEST_F(BlurCacheTest, reusesBlurOfUnchangedContent) {
+    const sk_sp<SkImage> blur = drawFrame();
+    EXPECT_EQ(blur, drawFrame());
+    EXPECT_EQ(1u, mCache.size());
+}
+
+TEST_F(BlurCacheTest, reusesBlurIfLayersAboveChanged) {
+    LayerSettings overlay;
+    mLayers.push_back(&overlay);
+    const sk_sp<SkImage> blur = drawFrame();
+
+    overlay.alpha = 0.5f;
+    EXPECT_EQ(blur, drawFrame());
+}
+
+TEST_F(BlurCacheTest, generatesBlurIfLayerBelowChanged) {
+    const sk_sp<SkImage> blur = drawFrame();
+
+    mBackground.source.solidColor = half3(0.0f, 1.0f, 0.0f);
+    EXPECT_NE(blur, drawFrame());
+}
+
+TEST_F(BlurCacheTest, generatesBlurIfRectOrRadiusChanged) {
+    drawFrame();
+    mCache.beginFrame(nullptr, mDisplay, kTargetInfo, mLayers);
+    EXPECT_EQ(nullptr, mCache.get(1, kRadius, SkRect::MakeWH(50, 50)));
+    EXPECT_EQ(nullptr, mCache.get(1, kRadius + 1, kBlurRect));
+    EXPECT_NE(nullptr, mCache.get(1, kRadius, kBlurRect));
+    mCache.endFrame();
+}
+
+TEST_F(BlurCacheTest, generatesBlurIfDisplayChanged) {
+    const sk_sp<SkImage> blur = drawFrame();
+
+    mDisplay.clip = Rect(50, 50);
+    EXPECT_NE(blur, drawFrame());
+}
+
+TEST_F(BlurCacheTest, generatesBlurIfBufferHasNoFence) {
+    mBackground.source.buffer.buffer =
+            std::make_shared<ExternalTexture>(new GraphicBuffer(), mRenderEngine,
+                                              ExternalTexture::Usage::READABLE);
+    const sk_sp<SkImage> blur = drawFrame();
+
+    // Without a fence the buffer may have been written to since.
+    EXPECT_NE(blur, drawFrame());
+
+    mBackground.source.buffer.fence = new Fence(open("/dev/null", O_RDONLY));
+    const sk_sp<SkImage> fencedBlur = drawFrame();
+    EXPECT_EQ(fencedBlur, drawFrame());
+
+    mBackground.source.buffer.fence = new Fence(open("/dev/null", O_RDONLY));
+    EXPECT_NE(fencedBlur, drawFrame());
+}
+
+TEST_F(BlurCacheTest, keepsFramesOfEachDisplay) {
+    DisplaySettings otherDisplay;
+    otherDisplay.clip = Rect(50, 50);
+
+    const sk_sp<SkImage> blur = drawFrame();
+    std::swap(mDisplay, otherDisplay);
+    const sk_sp<SkImage> otherBlur = drawFrame();
+    std::swap(mDisplay, otherDisplay);
+
+    EXPECT_NE(blur, otherBlur);
+    EXPECT_EQ(blur, drawFrame());
+    EXPECT_EQ(2u, mCache.size());
+}
+
+TEST_F(BlurCacheTest, clearDropsBlurs) {
+    const sk_sp<SkImage> blur = drawFrame();
+    mCache.clear();
+    EXPECT_EQ(0u, mCache.size());
+    EXPECT_NE(blur, drawFrame());
+}
+
+} // namespace
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include "../skia/PersistentShaderCache.h"
+
+namespace android {
+namespace renderengine {
+namespace skia {
+namespace {
+
+sk_sp<SkData> makeData(const char* string) {
+    return SkData::MakeWithCString(string);
+}
+
+class PersistentShaderCacheTest : public testing::Test {
+protected:
+    std::string cachePath() const { return std::string(mDir.path) + "/shader_cache"; }
+
+    TemporaryDir mDir;
+};
+
+TEST_F(PersistentShaderCacheTest, reloadsSavedShaders) {
+    PersistentShaderCache cache(cachePath(), "fingerprint");
+    EXPECT_EQ(0u, cache.loadFromFile());
+    EXPECT_EQ(nullptr, cache.load(*makeData("key")));
+
+    cache.store(*makeData("key"), *makeData("program"), SkString());
+    EXPECT_EQ(1, cache.shadersCachedSinceLastCall());
+    ASSERT_TRUE(cache.saveToFile());
+
+    PersistentShaderCache reloaded(cachePath(), "fingerprint");
+    EXPECT_EQ(1u, reloaded.loadFromFile());
+    const sk_sp<SkData> program = reloaded.load(*makeData("key"));
+    ASSERT_NE(nullptr, program);
+    EXPECT_TRUE(program->equals(makeData("program").get()));
+    EXPECT_EQ(0, reloaded.shadersCachedSinceLastCall());
+}
+
+TEST_F(PersistentShaderCacheTest, discardsShadersFromOtherFingerprint) {
+    PersistentShaderCache cache(cachePath(), "fingerprint");
+    cache.store(*makeData("key"), *makeData("program"), SkString());
+    ASSERT_TRUE(cache.saveToFile());
+
+    PersistentShaderCache reloaded(cachePath(), "other fingerprint");
+    EXPECT_EQ(0u, reloaded.loadFromFile());
+    EXPECT_EQ(nullptr, reloaded.load(*makeData("key")));
+}
+
+TEST_F(PersistentShaderCacheTest, discardsTruncatedFile) {
+    PersistentShaderCache cache(cachePath(), "fingerprint");
+    cache.store(*makeData("key"), *makeData("program"), SkString());
+    ASSERT_TRUE(cache.saveToFile());
+
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(cachePath(), &contents));
+    contents.resize(contents.size() - 1);
+    ASSERT_TRUE(base::WriteStringToFile(contents, cachePath()));
+
+    PersistentShaderCache reloaded(cachePath(), "fingerprint");
+    EXPECT_EQ(0u, reloaded.loadFromFile());
+}
+
+TEST_F(PersistentShaderCacheTest, onlyCountsShadersWithoutPath) {
+    PersistentShaderCache cache("", "fingerprint");
+    cache.store(*makeData("key"), *makeData("program"), SkString());
+
+    EXPECT_EQ(1, cache.shadersCachedSinceLastCall());
+    EXPECT_EQ(nullptr, cache.load(*makeData("key")));
+    EXPECT_EQ(0u, cache.size());
+}
+
+} // namespace
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -1392,6 +1392,44 @@ TEST_P(RenderEngineTest, drawLayers_doesNotCacheFramebuffer) {
     expectBufferColor(fullscreenRect(), 255, 0, 0, 255);
 }
 
+TEST_P(RenderEngineTest, drawLayersBatch_drawsEachRequest) {
+    initializeRenderEngine();
+
+    renderengine::DisplaySettings settings;
+    settings.outputDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+    settings.physicalDisplay = fullscreenRect();
+    settings.clip = fullscreenRect();
+
+    renderengine::LayerSettings redLayer;
+    redLayer.geometry.boundaries = fullscreenRect().toFloatRect();
+    ColorSourceVariant::fillColor(redLayer, 1.0f, 0.0f, 0.0f, this);
+    redLayer.alpha = 1.0;
+    renderengine::LayerSettings greenLayer = redLayer;
+    ColorSourceVariant::fillColor(greenLayer, 0.0f, 1.0f, 0.0f, this);
+
+    const auto greenBuffer = allocateDefaultBuffer();
+    std::vector<renderengine::RenderEngine::DrawLayersRequest> requests(2);
+    requests[0].display = settings;
+    requests[0].layers = {&redLayer};
+    requests[0].buffer = mBuffer;
+    requests[1].display = settings;
+    requests[1].layers = {&greenLayer};
+    requests[1].buffer = greenBuffer;
+
+    auto results = mRE->drawLayersBatch(std::move(requests));
+    ASSERT_EQ(2u, results.size());
+    for (auto& result : results) {
+        ASSERT_EQ(NO_ERROR, result.status);
+        if (result.drawFence.get() >= 0) {
+            sync_wait(result.drawFence.get(), -1);
+        }
+    }
+
+    expectBufferColor(fullscreenRect(), 255, 0, 0, 255);
+    mBuffer = greenBuffer;
+    expectBufferColor(fullscreenRect(), 0, 255, 0, 255);
+}
+
 TEST_P(RenderEngineTest, drawLayers_fillRedBuffer_colorSource) {
     initializeRenderEngine();
     fillRedBuffer<ColorSourceVariant>();
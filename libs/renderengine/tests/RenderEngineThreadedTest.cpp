@@ -26,6 +26,7 @@ using testing::_;
 using testing::Eq;
 using testing::Mock;
 using testing::Return;
+using testing::SaveArg;
 
 struct RenderEngineThreadedTest : public ::testing::Test {
     ~RenderEngineThreadedTest() {}
@@ -54,6 +55,35 @@ TEST_F(RenderEngineThreadedTest, primeCache) {
     mThreadedRE->getContextPriority();
 }
 
+TEST_F(RenderEngineThreadedTest, primeCache_runsQueuedWorkBetweenDrawsIfInterleaved) {
+    auto* renderEngine = new renderengine::mock::RenderEngine();
+    std::function<void()> yieldCallback;
+    EXPECT_CALL(*renderEngine, setPrimeCacheYieldCallback(_))
+            .WillOnce(SaveArg<0>(&yieldCallback));
+    auto threadedRE = renderengine::threaded::RenderEngineThreaded::create(
+            [renderEngine]() { return std::unique_ptr<renderengine::RenderEngine>(renderEngine); },
+            renderengine::RenderEngine::RenderEngineType::THREADED,
+            /*interleavePrimeCache=*/true);
+
+    // Priming only completes once the work queued behind it has run.
+    std::atomic<bool> ranQueuedWork = false;
+    EXPECT_CALL(*renderEngine, getContextPriority()).WillOnce([&ranQueuedWork] {
+        ranQueuedWork = true;
+        return 2;
+    });
+    EXPECT_CALL(*renderEngine, primeCache()).WillOnce([&] {
+        while (!ranQueuedWork) {
+            yieldCallback();
+            std::this_thread::yield();
+        }
+        return std::future<void>();
+    });
+
+    auto future = threadedRE->primeCache();
+    ASSERT_EQ(2, threadedRE->getContextPriority());
+    future.wait();
+}
+
 TEST_F(RenderEngineThreadedTest, genTextures) {
     uint32_t texName;
     EXPECT_CALL(*mRenderEngine, genTextures(1, &texName));
@@ -190,4 +220,47 @@ TEST_F(RenderEngineThreadedTest, drawLayers) {
     ASSERT_EQ(NO_ERROR, result);
 }
 
+TEST_F(RenderEngineThreadedTest, drawLayersAsync) {
+    renderengine::DisplaySettings settings;
+    std::vector<renderengine::LayerSettings> layers(2);
+    std::shared_ptr<renderengine::ExternalTexture> buffer = std::make_shared<
+            renderengine::ExternalTexture>(new GraphicBuffer(), *mRenderEngine,
+                                           renderengine::ExternalTexture::Usage::READABLE |
+                                                   renderengine::ExternalTexture::Usage::WRITEABLE);
+    base::unique_fd bufferFence;
+
+    EXPECT_CALL(*mRenderEngine, drawLayers)
+            .WillOnce([](const renderengine::DisplaySettings&,
+                         const std::vector<const renderengine::LayerSettings*>& layers,
+                         const std::shared_ptr<renderengine::ExternalTexture>&, const bool,
+                         base::unique_fd&&, base::unique_fd*) -> status_t {
+                EXPECT_EQ(2u, layers.size());
+                return NO_ERROR;
+            });
+
+    std::promise<status_t> resultPromise;
+    mThreadedRE->drawLayersAsync(settings, std::move(layers), buffer, false,
+                                 std::move(bufferFence),
+                                 [&resultPromise](status_t status, base::unique_fd&&) {
+                                     resultPromise.set_value(status);
+                                 });
+    ASSERT_EQ(NO_ERROR, resultPromise.get_future().get());
+}
+
+TEST_F(RenderEngineThreadedTest, drawLayersBatch) {
+    std::vector<renderengine::RenderEngine::DrawLayersRequest> requests(3);
+
+    EXPECT_CALL(*mRenderEngine, drawLayersBatch)
+            .WillOnce([](std::vector<renderengine::RenderEngine::DrawLayersRequest>&& requests) {
+                EXPECT_EQ(3u, requests.size());
+                return std::vector<renderengine::RenderEngine::DrawLayersResult>(requests.size());
+            });
+
+    const auto results = mThreadedRE->drawLayersBatch(std::move(requests));
+    ASSERT_EQ(3u, results.size());
+    for (const auto& result : results) {
+        EXPECT_EQ(NO_ERROR, result.status);
+    }
+}
+
 } // namespace android
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../skia/TextureCache.h"
+
+namespace android {
+namespace renderengine {
+namespace skia {
+namespace {
+
+using Owner = ExternalTexture::Owner;
+
+constexpr TextureCache::BufferId kBuffer = 1;
+constexpr TextureCache::BufferId kOtherBuffer = 2;
+constexpr TextureCache::BufferId kThirdBuffer = 3;
+
+class TextureCacheTest : public testing::Test {
+protected:
+    // The cache never dereferences textures, so they are left null.
+    void ref(TextureCache::BufferId id, size_t bytes, bool isRenderable = false) {
+        mCache.ref(id, bytes, Owner::LAYER, isRenderable, [this] {
+            mTexturesCreated++;
+            return TextureCache::Texture();
+        });
+    }
+
+    TextureCache mCache;
+    int mTexturesCreated = 0;
+};
+
+TEST_F(TextureCacheTest, keepsUnreferencedTextureWithinBudget) {
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    EXPECT_TRUE(mCache.unref(kBuffer, /*retain=*/true));
+    EXPECT_TRUE(mCache.contains(kBuffer));
+
+    ref(kBuffer, 40);
+    EXPECT_EQ(1, mTexturesCreated);
+}
+
+TEST_F(TextureCacheTest, evictsLeastRecentlyUsedUnreferencedTexture) {
+    mCache.setBudget(60);
+    ref(kBuffer, 40);
+    ref(kOtherBuffer, 40);
+    mCache.get(kBuffer);
+    mCache.unref(kBuffer, /*retain=*/true);
+    mCache.unref(kOtherBuffer, /*retain=*/true);
+
+    EXPECT_TRUE(mCache.contains(kBuffer));
+    EXPECT_FALSE(mCache.contains(kOtherBuffer));
+    EXPECT_EQ(40u, mCache.getTotalBytes());
+}
+
+TEST_F(TextureCacheTest, budgetOnlyBoundsUnreferencedTextures) {
+    mCache.setBudget(50);
+    ref(kBuffer, 1000);
+    ref(kOtherBuffer, 40);
+    mCache.unref(kOtherBuffer, /*retain=*/true);
+
+    EXPECT_TRUE(mCache.contains(kBuffer));
+    EXPECT_TRUE(mCache.contains(kOtherBuffer));
+    EXPECT_EQ(1040u, mCache.getTotalBytes());
+}
+
+TEST_F(TextureCacheTest, releasesUnreferencedTextureAfterFewFrames) {
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    ref(kOtherBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/true);
+    EXPECT_TRUE(mCache.hasUnreferenced());
+
+    for (int i = 0; i < 3; i++) {
+        mCache.endFrame();
+    }
+    EXPECT_TRUE(mCache.contains(kBuffer));
+    mCache.endFrame();
+    EXPECT_FALSE(mCache.contains(kBuffer));
+    EXPECT_TRUE(mCache.contains(kOtherBuffer));
+    EXPECT_FALSE(mCache.hasUnreferenced());
+}
+
+TEST_F(TextureCacheTest, mappingAgainKeepsTexture) {
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/true);
+    mCache.endFrame();
+    ref(kBuffer, 40);
+
+    for (int i = 0; i < 8; i++) {
+        mCache.endFrame();
+    }
+    EXPECT_TRUE(mCache.contains(kBuffer));
+    EXPECT_EQ(1, mTexturesCreated);
+}
+
+TEST_F(TextureCacheTest, releaseUnreferencedKeepsReferencedTextures) {
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    ref(kOtherBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/true);
+
+    mCache.releaseUnreferenced();
+    EXPECT_FALSE(mCache.contains(kBuffer));
+    EXPECT_TRUE(mCache.contains(kOtherBuffer));
+    EXPECT_EQ(40u, mCache.getTotalBytes());
+}
+
+TEST_F(TextureCacheTest, neverEvictsReferencedTextures) {
+    ref(kBuffer, 40);
+    ref(kOtherBuffer, 40);
+    EXPECT_EQ(2u, mCache.size());
+    EXPECT_EQ(80u, mCache.getTotalBytes());
+
+    mCache.unref(kBuffer, /*retain=*/true);
+    EXPECT_FALSE(mCache.contains(kBuffer));
+    EXPECT_TRUE(mCache.contains(kOtherBuffer));
+}
+
+TEST_F(TextureCacheTest, keepsTextureUntilLastUnref) {
+    ref(kBuffer, 40);
+    ref(kBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/false);
+    EXPECT_TRUE(mCache.contains(kBuffer));
+    mCache.unref(kBuffer, /*retain=*/false);
+    EXPECT_FALSE(mCache.contains(kBuffer));
+}
+
+TEST_F(TextureCacheTest, unrefWithoutRefFails) {
+    EXPECT_FALSE(mCache.unref(kBuffer, /*retain=*/true));
+
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/true);
+    EXPECT_FALSE(mCache.unref(kBuffer, /*retain=*/true));
+}
+
+TEST_F(TextureCacheTest, recreatesTextureToRenderToIt) {
+    ref(kBuffer, 40);
+    ref(kBuffer, 40, /*isRenderable=*/true);
+    ref(kBuffer, 40);
+    EXPECT_EQ(2, mTexturesCreated);
+}
+
+TEST_F(TextureCacheTest, shrinkingBudgetEvicts) {
+    mCache.setBudget(100);
+    ref(kBuffer, 40);
+    mCache.unref(kBuffer, /*retain=*/true);
+
+    mCache.setBudget(20);
+    EXPECT_FALSE(mCache.contains(kBuffer));
+    EXPECT_EQ(0u, mCache.getTotalBytes());
+}
+
+TEST_F(TextureCacheTest, countsHitsAndMisses) {
+    ref(kBuffer, 40);
+    mCache.get(kBuffer);
+    mCache.get(kOtherBuffer);
+
+    std::string result;
+    mCache.dump(result);
+    EXPECT_NE(std::string::npos, result.find("1 hits, 1 misses (hit rate 50.0%)"));
+    EXPECT_NE(std::string::npos, result.find("layer: 1 entries, 40 bytes"));
+}
+
+} // namespace
+} // namespace skia
+} // namespace renderengine
+} // namespace android
@@ -19,6 +19,7 @@
 #include "RenderEngineThreaded.h"
 
 #include <sched.h>
+#include <unistd.h>
 #include <chrono>
 #include <future>
 
@@ -36,12 +37,14 @@ namespace renderengine {
 namespace threaded {
 
 std::unique_ptr<RenderEngineThreaded> RenderEngineThreaded::create(CreateInstanceFactory factory,
-                                                                   RenderEngineType type) {
-    return std::make_unique<RenderEngineThreaded>(std::move(factory), type);
+                                                                   RenderEngineType type,
+                                                                   bool interleavePrimeCache) {
+    return std::make_unique<RenderEngineThreaded>(std::move(factory), type, interleavePrimeCache);
 }
 
-RenderEngineThreaded::RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type)
-      : RenderEngine(type) {
+RenderEngineThreaded::RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type,
+                                           bool interleavePrimeCache)
+      : RenderEngine(type), mInterleavePrimeCache(interleavePrimeCache) {
     ATRACE_CALL();
 
     std::lock_guard lockThread(mThreadMutex);
@@ -91,8 +94,12 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
 
     mRenderEngine = factory();
     mIsProtected = mRenderEngine->isProtected();
+    if (mInterleavePrimeCache) {
+        mRenderEngine->setPrimeCacheYieldCallback([this] { runQueuedWorkDuringPrimeCache(); });
+    }
 
     pthread_setname_np(pthread_self(), mThreadName);
+    mThreadTid = gettid();
 
     {
         std::scoped_lock lock(mInitializedMutex);
@@ -101,17 +108,7 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
     mInitializedCondition.notify_all();
 
     while (mRunning) {
-        const auto getNextTask = [this]() -> std::optional<Work> {
-            std::scoped_lock lock(mThreadMutex);
-            if (!mFunctionCalls.empty()) {
-                Work task = mFunctionCalls.front();
-                mFunctionCalls.pop();
-                return std::make_optional<Work>(task);
-            }
-            return std::nullopt;
-        };
-
-        const auto task = getNextTask();
+        const auto task = popNextTask();
 
         if (task) {
             (*task)(*mRenderEngine);
@@ -127,6 +124,37 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
     mRenderEngine.reset();
 }
 
+std::optional<RenderEngineThreaded::Work> RenderEngineThreaded::popNextTask() {
+    std::scoped_lock lock(mThreadMutex);
+    if (!mFunctionCalls.empty()) {
+        Work task = mFunctionCalls.front();
+        mFunctionCalls.pop();
+        return std::make_optional<Work>(task);
+    }
+    return std::nullopt;
+}
+
+// Called by primeCache() between its draws, so that the work queued behind it, e.g. the first
+// compositions, doesn't wait for priming to complete. Priming runs as SCHED_OTHER, so the work
+// is bracketed with SCHED_FIFO as it would run outside of priming.
+void RenderEngineThreaded::runQueuedWorkDuringPrimeCache() {
+    auto task = popNextTask();
+    if (!task) {
+        return;
+    }
+
+    ATRACE_NAME("REThreaded::runQueuedWorkDuringPrimeCache");
+    if (setSchedFifo(true) != NO_ERROR) {
+        ALOGW("Couldn't set SCHED_FIFO during primeCache");
+    }
+    do {
+        (*task)(*mRenderEngine);
+    } while ((task = popNextTask()));
+    if (setSchedFifo(false) != NO_ERROR) {
+        ALOGW("Couldn't set SCHED_OTHER for primeCache");
+    }
+}
+
 void RenderEngineThreaded::waitUntilInitialized() const {
     std::unique_lock<std::mutex> lock(mInitializedMutex);
     mInitializedCondition.wait(lock, [=] { return mIsInitialized; });
@@ -209,7 +237,8 @@ void RenderEngineThreaded::deleteTextures(size_t count, uint32_t const* names) {
 }
 
 void RenderEngineThreaded::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
-                                                    bool isRenderable) {
+                                                    bool isRenderable,
+                                                    ExternalTexture::Owner owner) {
     ATRACE_CALL();
     // This function is designed so it can run asynchronously, so we do not need to wait
     // for the futures.
@@ -217,7 +246,7 @@ void RenderEngineThreaded::mapExternalTextureBuffer(const sp<GraphicBuffer>& buf
         std::lock_guard lock(mThreadMutex);
         mFunctionCalls.push([=](renderengine::RenderEngine& instance) {
             ATRACE_NAME("REThreaded::mapExternalTextureBuffer");
-            instance.mapExternalTextureBuffer(buffer, isRenderable);
+            instance.mapExternalTextureBuffer(buffer, isRenderable, owner);
         });
     }
     mCondition.notify_one();
@@ -327,6 +356,50 @@ status_t RenderEngineThreaded::drawLayers(const DisplaySettings& display,
     return resultFuture.get();
 }
 
+void RenderEngineThreaded::drawLayersAsync(const DisplaySettings& display,
+                                           std::vector<LayerSettings>&& layers,
+                                           const std::shared_ptr<ExternalTexture>& buffer,
+                                           const bool useFramebufferCache,
+                                           base::unique_fd&& bufferFence,
+                                           DrawLayersCallback&& onDrawn) {
+    ATRACE_CALL();
+    // Work must be copyable, so the fence is passed as a shared handle.
+    auto sharedBufferFence = std::make_shared<base::unique_fd>(std::move(bufferFence));
+    {
+        std::lock_guard lock(mThreadMutex);
+        mFunctionCalls.push([display, layers = std::move(layers), buffer, useFramebufferCache,
+                             sharedBufferFence, onDrawn = std::move(onDrawn)](
+                                    renderengine::RenderEngine& instance) {
+            ATRACE_NAME("REThreaded::drawLayersAsync");
+            std::vector<const LayerSettings*> layerPointers(layers.size());
+            std::transform(layers.begin(), layers.end(), layerPointers.begin(),
+                           [](const LayerSettings& settings) { return &settings; });
+            base::unique_fd drawFence;
+            status_t status =
+                    instance.drawLayers(display, layerPointers, buffer, useFramebufferCache,
+                                        std::move(*sharedBufferFence), &drawFence);
+            onDrawn(status, std::move(drawFence));
+        });
+    }
+    mCondition.notify_one();
+}
+
+std::vector<RenderEngine::DrawLayersResult> RenderEngineThreaded::drawLayersBatch(
+        std::vector<DrawLayersRequest>&& requests) {
+    ATRACE_CALL();
+    std::promise<std::vector<DrawLayersResult>> resultPromise;
+    std::future<std::vector<DrawLayersResult>> resultFuture = resultPromise.get_future();
+    {
+        std::lock_guard lock(mThreadMutex);
+        mFunctionCalls.push([&resultPromise, &requests](renderengine::RenderEngine& instance) {
+            ATRACE_NAME("REThreaded::drawLayersBatch");
+            resultPromise.set_value(instance.drawLayersBatch(std::move(requests)));
+        });
+    }
+    mCondition.notify_one();
+    return resultFuture.get();
+}
+
 void RenderEngineThreaded::cleanFramebufferCache() {
     ATRACE_CALL();
     // This function is designed so it can run asynchronously, so we do not need to wait
@@ -361,6 +434,11 @@ bool RenderEngineThreaded::supportsBackgroundBlur() {
     return mRenderEngine->supportsBackgroundBlur();
 }
 
+std::optional<pid_t> RenderEngineThreaded::getRenderEngineTid() const {
+    waitUntilInitialized();
+    return mThreadTid;
+}
+
 void RenderEngineThreaded::onPrimaryDisplaySizeChanged(ui::Size size) {
     // This function is designed so it can run asynchronously, so we do not need to wait
     // for the futures.
@@ -19,6 +19,7 @@
 #include <android-base/thread_annotations.h>
 #include <condition_variable>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 
@@ -34,13 +35,18 @@ using CreateInstanceFactory = std::function<std::unique_ptr<renderengine::Render
  * This class extends a basic RenderEngine class. It contains a thread. Each time a function of
  * this class is called, we create a lambda function that is put on a queue. The main thread then
  * executes the functions in order.
+ *
+ * If interleavePrimeCache is set, the functions queued while primeCache() runs are executed
+ * between its priming draws, instead of after it completes.
  */
 class RenderEngineThreaded : public RenderEngine {
 public:
     static std::unique_ptr<RenderEngineThreaded> create(CreateInstanceFactory factory,
-                                                        RenderEngineType type);
+                                                        RenderEngineType type,
+                                                        bool interleavePrimeCache = false);
 
-    RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type);
+    RenderEngineThreaded(CreateInstanceFactory factory, RenderEngineType type,
+                         bool interleavePrimeCache = false);
     ~RenderEngineThreaded() override;
     std::future<void> primeCache() override;
 
@@ -61,19 +67,28 @@ public:
                         const std::shared_ptr<ExternalTexture>& buffer,
                         const bool useFramebufferCache, base::unique_fd&& bufferFence,
                         base::unique_fd* drawFence) override;
+    void drawLayersAsync(const DisplaySettings& display, std::vector<LayerSettings>&& layers,
+                         const std::shared_ptr<ExternalTexture>& buffer,
+                         const bool useFramebufferCache, base::unique_fd&& bufferFence,
+                         DrawLayersCallback&& onDrawn) override;
+    std::vector<DrawLayersResult> drawLayersBatch(
+            std::vector<DrawLayersRequest>&& requests) override;
 
     void cleanFramebufferCache() override;
     int getContextPriority() override;
     bool supportsBackgroundBlur() override;
     void onPrimaryDisplaySizeChanged(ui::Size size) override;
+    std::optional<pid_t> getRenderEngineTid() const override;
 
 protected:
-    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable) override;
+    void mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer, bool isRenderable,
+                                  ExternalTexture::Owner owner) override;
     void unmapExternalTextureBuffer(const sp<GraphicBuffer>& buffer) override;
     bool canSkipPostRenderCleanup() const override;
 
 private:
     void threadMain(CreateInstanceFactory factory);
+    void runQueuedWorkDuringPrimeCache();
     void waitUntilInitialized() const;
     static status_t setSchedFifo(bool enabled);
 
@@ -85,10 +100,15 @@ private:
     mutable std::mutex mThreadMutex;
     std::thread mThread GUARDED_BY(mThreadMutex);
     std::atomic<bool> mRunning = true;
+    // Set by the thread before it is initialized.
+    pid_t mThreadTid = 0;
 
     using Work = std::function<void(renderengine::RenderEngine&)>;
     mutable std::queue<Work> mFunctionCalls GUARDED_BY(mThreadMutex);
     mutable std::condition_variable mCondition;
+    std::optional<Work> popNextTask() EXCLUDES(mThreadMutex);
+
+    const bool mInterleavePrimeCache;
 
     // Used to allow select thread safe methods to be accessed without requiring the
     // method to be invoked on the RenderEngine thread
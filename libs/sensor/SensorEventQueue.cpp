@@ -27,6 +27,7 @@
 #include <sensor/Sensor.h>
 #include <sensor/BitTube.h>
 #include <sensor/ISensorEventConnection.h>
+#include <sensor/SensorEventRing.h>
 
 #include <android/sensor.h>
 #include <hardware/sensors-base.h>
@@ -50,6 +51,7 @@ SensorEventQueue::~SensorEventQueue() {
 void SensorEventQueue::onFirstRef()
 {
     mSensorChannel = mSensorEventConnection->getSensorChannel();
+    mEventRing = mSensorEventConnection->getSensorEventRing();
 }
 
 int SensorEventQueue::getFd() const
@@ -63,6 +65,11 @@ ssize_t SensorEventQueue::write(const sp<BitTube>& tube,
     return BitTube::sendObjects(tube, events, numEvents);
 }
 
+ssize_t SensorEventQueue::write(const sp<BitTube>& tube,
+        struct iovec const* events, size_t iovcnt) {
+    return BitTube::sendObjectsv<ASensorEvent>(tube, events, iovcnt);
+}
+
 ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
     if (mAvailable == 0) {
         ssize_t err = BitTube::recvObjects(mSensorChannel,
@@ -73,10 +80,31 @@ ssize_t SensorEventQueue::read(ASensorEvent* events, size_t numEvents) {
         mAvailable = static_cast<size_t>(err);
         mConsumed = 0;
     }
-    size_t count = min(numEvents, mAvailable);
-    memcpy(events, mRecBuffer + mConsumed, count * sizeof(ASensorEvent));
-    mAvailable -= count;
-    mConsumed += count;
+    if (mEventRing == nullptr) {
+        size_t count = min(numEvents, mAvailable);
+        memcpy(events, mRecBuffer + mConsumed, count * sizeof(ASensorEvent));
+        mAvailable -= count;
+        mConsumed += count;
+        return static_cast<ssize_t>(count);
+    }
+
+    // Replace each doorbell event by the events it announces, which may take several calls when
+    // they don't all fit in the caller's buffer.
+    size_t count = 0;
+    while (count < numEvents && mAvailable > 0) {
+        const ASensorEvent& event = mRecBuffer[mConsumed];
+        if (event.type == SensorEventRing::DOORBELL_EVENT_TYPE) {
+            const uint64_t endIndex = event.u64.data[0];
+            count += mEventRing->read(events + count, numEvents - count, endIndex);
+            if (mEventRing->getReadIndex() != endIndex) {
+                break;
+            }
+        } else {
+            events[count++] = event;
+        }
+        mAvailable--;
+        mConsumed++;
+    }
     return static_cast<ssize_t>(count);
 }
 
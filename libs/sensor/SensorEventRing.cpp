@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sensor/SensorEventRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <new>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+#include <unistd.h>
+
+#include <android/sensor.h>
+#include <binder/Parcel.h>
+#include <cutils/ashmem.h>
+#include <log/log.h>
+
+namespace android {
+// ----------------------------------------------------------------------------
+
+// The header is followed by the event slots. It is written by the reader only, and has a cache
+// line to itself so that the reader doesn't contend with the writer filling the first slots.
+struct alignas(64) SensorEventRing::Header {
+    std::atomic<uint64_t> readIndex;
+};
+
+SensorEventRing::SensorEventRing(size_t capacity)
+    : mFd(-1), mCapacity(capacity), mSize(0), mBase(nullptr), mHeader(nullptr),
+      mEvents(nullptr), mWriteIndex(0), mReadIndex(0)
+{
+    const size_t size = sizeof(Header) + capacity * sizeof(ASensorEvent);
+    mFd = ashmem_create_region("SensorEventRing", size);
+    if (mFd < 0) {
+        ALOGE("SensorEventRing: can't create ashmem region (%s)", strerror(errno));
+        return;
+    }
+    map(size);
+    if (mHeader != nullptr) {
+        new (mHeader) Header();
+    }
+}
+
+SensorEventRing::SensorEventRing(const Parcel& data)
+    : mFd(-1), mCapacity(0), mSize(0), mBase(nullptr), mHeader(nullptr),
+      mEvents(nullptr), mWriteIndex(0), mReadIndex(0)
+{
+    mFd = dup(data.readFileDescriptor());
+    if (mFd < 0) {
+        ALOGE("SensorEventRing(Parcel): can't dup filedescriptor (%s)", strerror(errno));
+        return;
+    }
+    const int size = ashmem_get_size_region(mFd);
+    if (size <= static_cast<int>(sizeof(Header))) {
+        ALOGE("SensorEventRing(Parcel): invalid region size %d", size);
+        return;
+    }
+    mCapacity = (size - sizeof(Header)) / sizeof(ASensorEvent);
+    map(size);
+    if (mHeader != nullptr) {
+        mReadIndex = mHeader->readIndex.load(std::memory_order_relaxed);
+    }
+}
+
+SensorEventRing::~SensorEventRing()
+{
+    if (mBase != nullptr)
+        munmap(mBase, mSize);
+
+    if (mFd >= 0)
+        close(mFd);
+}
+
+void SensorEventRing::map(size_t size) {
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("SensorEventRing: can't map ashmem region (%s)", strerror(errno));
+        return;
+    }
+    mBase = base;
+    mSize = size;
+    mHeader = static_cast<Header*>(base);
+    mEvents = reinterpret_cast<ASensorEvent*>(static_cast<uint8_t*>(base) + sizeof(Header));
+}
+
+status_t SensorEventRing::initCheck() const
+{
+    if (mHeader == nullptr || mCapacity == 0) {
+        return NO_INIT;
+    }
+    return NO_ERROR;
+}
+
+status_t SensorEventRing::write(struct iovec const* iov, size_t iovcnt, uint64_t* endIndex)
+{
+    if (initCheck() != NO_ERROR) {
+        return NO_INIT;
+    }
+
+    // The read index comes from the client, so an index it can't have reached leaves no space
+    // rather than letting it overwrite events it hasn't read yet.
+    const uint64_t readIndex = mHeader->readIndex.load(std::memory_order_acquire);
+    const uint64_t used = (readIndex <= mWriteIndex && mWriteIndex - readIndex <= mCapacity)
+            ? mWriteIndex - readIndex : mCapacity;
+
+    size_t count = 0;
+    for (size_t i = 0; i < iovcnt; i++) {
+        count += iov[i].iov_len / sizeof(ASensorEvent);
+    }
+    if (count > mCapacity - used) {
+        return WOULD_BLOCK;
+    }
+
+    uint64_t index = mWriteIndex;
+    for (size_t i = 0; i < iovcnt; i++) {
+        ASensorEvent const* events = static_cast<ASensorEvent const*>(iov[i].iov_base);
+        size_t remaining = iov[i].iov_len / sizeof(ASensorEvent);
+        while (remaining > 0) {
+            const size_t slot = index % mCapacity;
+            const size_t n = std::min(remaining, mCapacity - slot);
+            memcpy(mEvents + slot, events, n * sizeof(ASensorEvent));
+            events += n;
+            remaining -= n;
+            index += n;
+        }
+    }
+    // Make the events visible before the doorbell announcing them is sent.
+    std::atomic_thread_fence(std::memory_order_release);
+    *endIndex = index;
+    return NO_ERROR;
+}
+
+void SensorEventRing::commit(uint64_t endIndex)
+{
+    mWriteIndex = endIndex;
+}
+
+size_t SensorEventRing::read(ASensorEvent* events, size_t count, uint64_t endIndex)
+{
+    if (initCheck() != NO_ERROR) {
+        return 0;
+    }
+    if (endIndex < mReadIndex || endIndex - mReadIndex > mCapacity) {
+        ALOGE("SensorEventRing: invalid doorbell index %" PRIu64 " (read index %" PRIu64 ")",
+                endIndex, mReadIndex);
+        mReadIndex = endIndex;
+        mHeader->readIndex.store(mReadIndex, std::memory_order_release);
+        return 0;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t remaining = std::min(count, static_cast<size_t>(endIndex - mReadIndex));
+    const size_t total = remaining;
+    while (remaining > 0) {
+        const size_t slot = mReadIndex % mCapacity;
+        const size_t n = std::min(remaining, mCapacity - slot);
+        memcpy(events, mEvents + slot, n * sizeof(ASensorEvent));
+        events += n;
+        remaining -= n;
+        mReadIndex += n;
+    }
+    // Release the slots only once the events have been copied out of them.
+    mHeader->readIndex.store(mReadIndex, std::memory_order_release);
+    return total;
+}
+
+uint64_t SensorEventRing::getReadIndex() const
+{
+    return mReadIndex;
+}
+
+status_t SensorEventRing::writeToParcel(Parcel* reply) const
+{
+    if (mFd < 0)
+        return -EINVAL;
+
+    return reply->writeDupFileDescriptor(mFd);
+}
+
+// ----------------------------------------------------------------------------
+}; // namespace android
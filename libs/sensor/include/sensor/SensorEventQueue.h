@@ -43,6 +43,7 @@ namespace android {
 
 class ISensorEventConnection;
 class Sensor;
+class SensorEventRing;
 class Looper;
 
 // ----------------------------------------------------------------------------
@@ -74,6 +75,11 @@ public:
     static ssize_t write(const sp<BitTube>& tube,
             ASensorEvent const* events, size_t numEvents);
 
+    // Writes the events held by several buffers as one packet. Each iovec must hold a whole
+    // number of events.
+    static ssize_t write(const sp<BitTube>& tube,
+            struct iovec const* events, size_t iovcnt);
+
     ssize_t read(ASensorEvent* events, size_t numEvents);
 
     status_t waitForEvent() const;
@@ -104,6 +110,9 @@ private:
     sp<Looper> getLooper() const;
     sp<ISensorEventConnection> mSensorEventConnection;
     sp<BitTube> mSensorChannel;
+    // Ring the events announced by doorbell events on mSensorChannel are read from, or nullptr if
+    // all the events are sent on mSensorChannel.
+    sp<SensorEventRing> mEventRing;
     mutable Mutex mLock;
     mutable sp<Looper> mLooper;
     ASensorEvent* mRecBuffer;
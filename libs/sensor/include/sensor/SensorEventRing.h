@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+
+struct ASensorEvent;
+
+namespace android {
+// ----------------------------------------------------------------------------
+class Parcel;
+
+// A single producer, single consumer ring of sensor events in shared memory. The sensor service
+// copies the events of a connection into the ring and then sends a doorbell event on the
+// connection's BitTube, which tells the client how far the ring has been filled. Events are
+// thus read in the same order as the BitTube messages, and the BitTube keeps being used for
+// polling and wake-up acknowledgements.
+class SensorEventRing : public RefBase
+{
+public:
+
+    // type of the doorbell events sent on the BitTube. data.u64.data[0] holds the index that
+    // follows the last event written to the ring.
+    static constexpr int32_t DOORBELL_EVENT_TYPE = -1;
+
+    // creates a ring holding up to capacity events in a new ashmem region (sensor service side)
+    explicit SensorEventRing(size_t capacity);
+
+    // maps the ring parceled by writeToParcel (client side)
+    explicit SensorEventRing(const Parcel& data);
+    virtual ~SensorEventRing();
+
+    // check state after construction
+    status_t initCheck() const;
+
+    // copies the events gathered from several buffers at the write index, without making them
+    // visible to the reader. Each iovec must hold a whole number of events. Returns NO_ERROR and
+    // the index to pass to commit and to the reader, or WOULD_BLOCK if the events don't fit.
+    status_t write(struct iovec const* iov, size_t iovcnt, uint64_t* endIndex);
+
+    // moves the write index to the endIndex returned by the last write.
+    void commit(uint64_t endIndex);
+
+    // copies up to count events that precede endIndex, as received in a doorbell event, to
+    // events and releases their slots to the writer. Returns the number of events copied.
+    size_t read(ASensorEvent* events, size_t count, uint64_t endIndex);
+
+    // index of the next event to read
+    uint64_t getReadIndex() const;
+
+    // parcels this SensorEventRing
+    status_t writeToParcel(Parcel* reply) const;
+
+private:
+    struct Header;
+
+    void map(size_t size);
+
+    int mFd;
+    size_t mCapacity;
+    size_t mSize;
+    void* mBase;
+    Header* mHeader;
+    ASensorEvent* mEvents;
+
+    // writer side: index of the next event to write
+    uint64_t mWriteIndex;
+
+    // reader side: index of the next event to read
+    uint64_t mReadIndex;
+};
+
+// ----------------------------------------------------------------------------
+}; // namespace android
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include <android/sensor.h>
+#include <sensor/SensorEventRing.h>
+
+namespace android {
+
+class SensorEventRingTest : public ::testing::Test {
+protected:
+    static constexpr size_t kCapacity = 8;
+
+    virtual void SetUp() override {
+        mRing = new SensorEventRing(kCapacity);
+        ASSERT_EQ(NO_ERROR, mRing->initCheck());
+    }
+
+    // Writes count events with timestamps starting at first and commits them.
+    uint64_t writeEvents(int64_t first, size_t count) {
+        std::vector<ASensorEvent> events(count);
+        for (size_t i = 0; i < count; i++) {
+            events[i].timestamp = first + i;
+        }
+        iovec iov = {events.data(), count * sizeof(ASensorEvent)};
+        uint64_t endIndex = 0;
+        EXPECT_EQ(NO_ERROR, mRing->write(&iov, 1, &endIndex));
+        mRing->commit(endIndex);
+        return endIndex;
+    }
+
+    sp<SensorEventRing> mRing;
+};
+
+TEST_F(SensorEventRingTest, ReadsWrittenEvents) {
+    const uint64_t endIndex = writeEvents(100, 3);
+    EXPECT_EQ(3u, endIndex);
+
+    ASensorEvent events[kCapacity];
+    ASSERT_EQ(3u, mRing->read(events, kCapacity, endIndex));
+    EXPECT_EQ(100, events[0].timestamp);
+    EXPECT_EQ(101, events[1].timestamp);
+    EXPECT_EQ(102, events[2].timestamp);
+    EXPECT_EQ(endIndex, mRing->getReadIndex());
+}
+
+TEST_F(SensorEventRingTest, ReadsInSeveralCalls) {
+    const uint64_t endIndex = writeEvents(0, 5);
+
+    ASensorEvent events[kCapacity];
+    ASSERT_EQ(2u, mRing->read(events, 2, endIndex));
+    EXPECT_EQ(1, events[1].timestamp);
+    ASSERT_EQ(3u, mRing->read(events, kCapacity, endIndex));
+    EXPECT_EQ(2, events[0].timestamp);
+    EXPECT_EQ(4, events[2].timestamp);
+    EXPECT_EQ(endIndex, mRing->getReadIndex());
+}
+
+TEST_F(SensorEventRingTest, WrapsAround) {
+    ASensorEvent events[kCapacity];
+    mRing->read(events, kCapacity, writeEvents(0, 6));
+
+    const uint64_t endIndex = writeEvents(6, 6);
+    EXPECT_EQ(12u, endIndex);
+    ASSERT_EQ(6u, mRing->read(events, kCapacity, endIndex));
+    for (size_t i = 0; i < 6; i++) {
+        EXPECT_EQ(static_cast<int64_t>(6 + i), events[i].timestamp);
+    }
+}
+
+TEST_F(SensorEventRingTest, FullRingRejectsWrite) {
+    writeEvents(0, kCapacity);
+
+    ASensorEvent event = {};
+    iovec iov = {&event, sizeof(event)};
+    uint64_t endIndex = 0;
+    EXPECT_EQ(WOULD_BLOCK, mRing->write(&iov, 1, &endIndex));
+
+    ASensorEvent events[kCapacity];
+    mRing->read(events, 1, kCapacity);
+    EXPECT_EQ(NO_ERROR, mRing->write(&iov, 1, &endIndex));
+    EXPECT_EQ(kCapacity + 1, endIndex);
+}
+
+TEST_F(SensorEventRingTest, UncommittedEventsAreOverwritten) {
+    ASensorEvent event = {};
+    event.timestamp = 1;
+    iovec iov = {&event, sizeof(event)};
+    uint64_t endIndex = 0;
+    ASSERT_EQ(NO_ERROR, mRing->write(&iov, 1, &endIndex));
+
+    EXPECT_EQ(1u, writeEvents(2, 1));
+    ASensorEvent events[kCapacity];
+    ASSERT_EQ(1u, mRing->read(events, kCapacity, 1));
+    EXPECT_EQ(2, events[0].timestamp);
+}
+
+TEST_F(SensorEventRingTest, InvalidDoorbellIndexIsSkipped) {
+    writeEvents(0, 2);
+
+    ASensorEvent events[kCapacity];
+    EXPECT_EQ(0u, mRing->read(events, kCapacity, kCapacity + 1));
+    EXPECT_EQ(kCapacity + 1, mRing->getReadIndex());
+}
+
+} // namespace android
@@ -118,6 +118,53 @@ sp<Fence> Fence::merge(const String8& name, const sp<Fence>& f1,
     return merge(name.string(), f1, f2);
 }
 
+sp<Fence> Fence::merge(const char* name, const std::vector<sp<Fence>>& fences) {
+    ATRACE_CALL();
+    std::vector<sp<Fence>> valid;
+    valid.reserve(fences.size());
+    for (const auto& fence : fences) {
+        if (fence != nullptr && fence->isValid()) {
+            valid.push_back(fence);
+        }
+    }
+    if (valid.empty()) {
+        return NO_FENCE;
+    }
+    if (valid.size() == 1) {
+        return valid.front();
+    }
+
+    std::vector<sp<Fence>> pending;
+    pending.reserve(valid.size());
+    for (const auto& fence : valid) {
+        if (fence->getStatus() != Status::Signaled) {
+            pending.push_back(fence);
+        }
+    }
+    // If all of them signaled, they're still merged so that the result has
+    // the latest signal time.
+    if (pending.empty()) {
+        pending = std::move(valid);
+    }
+
+    while (pending.size() > 1) {
+        size_t merged = 0;
+        for (size_t i = 0; i < pending.size(); i += 2) {
+            if (i + 1 == pending.size()) {
+                pending[merged++] = pending[i];
+                break;
+            }
+            sp<Fence> fence = merge(name, pending[i], pending[i + 1]);
+            if (fence == NO_FENCE) {
+                return NO_FENCE;
+            }
+            pending[merged++] = fence;
+        }
+        pending.resize(merged);
+    }
+    return pending.front();
+}
+
 int Fence::dup() const {
     return ::dup(mFenceFd);
 }
@@ -149,7 +149,13 @@ nsecs_t FenceTime::getSignalTime() {
         fence = mFence;
     }
 
-    // Make the system call without the lock held.
+    // Make the system calls without the lock held. Polling the fence is much
+    // cheaper than reading its signal time, so that's only done once it
+    // signaled. This keeps polling the pending fences at the front of a
+    // FenceTimeline every frame cheap.
+    if (fence->getStatus() == Fence::Status::Unsignaled) {
+        return Fence::SIGNAL_TIME_PENDING;
+    }
     signalTime = fence->getSignalTime();
 
     // Allow tests to override SIGNAL_TIME_INVALID behavior, since tests
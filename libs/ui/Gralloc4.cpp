@@ -150,10 +150,21 @@ status_t Gralloc4Mapper::importBuffer(const hardware::hidl_handle& rawHandle,
         *outBufferHandle = static_cast<buffer_handle_t>(tmpBuffer);
     });
 
+    if (ret.isOk() && error == Error::NONE) {
+        // Drops anything cached for a buffer that was freed behind our back at the same address.
+        std::lock_guard<std::mutex> lock(mImmutableMetadataMutex);
+        mImmutableMetadata.erase(*outBufferHandle);
+    }
+
     return static_cast<status_t>((ret.isOk()) ? error : kTransactionError);
 }
 
 void Gralloc4Mapper::freeBuffer(buffer_handle_t bufferHandle) const {
+    {
+        std::lock_guard<std::mutex> lock(mImmutableMetadataMutex);
+        mImmutableMetadata.erase(bufferHandle);
+    }
+
     auto buffer = const_cast<native_handle_t*>(bufferHandle);
     auto ret = mMapper->freeBuffer(buffer);
 
@@ -440,12 +451,15 @@ status_t Gralloc4Mapper::get(buffer_handle_t bufferHandle, const MetadataType& m
         return BAD_VALUE;
     }
 
-    hidl_vec<uint8_t> vec;
+    // Decodes straight from the reply, rather than copying it out of the callback first.
     Error error;
+    status_t decodeError = NO_ERROR;
     auto ret = mMapper->get(const_cast<native_handle_t*>(bufferHandle), metadataType,
                             [&](const auto& tmpError, const hidl_vec<uint8_t>& tmpVec) {
                                 error = tmpError;
-                                vec = tmpVec;
+                                if (error == Error::NONE) {
+                                    decodeError = decodeFunction(tmpVec, outMetadata);
+                                }
                             });
 
     if (!ret.isOk()) {
@@ -458,12 +472,41 @@ status_t Gralloc4Mapper::get(buffer_handle_t bufferHandle, const MetadataType& m
         return static_cast<status_t>(error);
     }
 
-    return decodeFunction(vec, outMetadata);
+    return decodeError;
+}
+
+template <class T>
+status_t Gralloc4Mapper::getImmutable(buffer_handle_t bufferHandle,
+                                      const MetadataType& metadataType,
+                                      DecodeFunction<T> decodeFunction,
+                                      std::optional<T> ImmutableMetadata::*cachedMetadata,
+                                      T* outMetadata) const {
+    if (!outMetadata) {
+        return BAD_VALUE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mImmutableMetadataMutex);
+        const auto it = mImmutableMetadata.find(bufferHandle);
+        if (it != mImmutableMetadata.end() && it->second.*cachedMetadata) {
+            *outMetadata = *(it->second.*cachedMetadata);
+            return NO_ERROR;
+        }
+    }
+
+    status_t error = get(bufferHandle, metadataType, decodeFunction, outMetadata);
+    if (error != NO_ERROR) {
+        return error;
+    }
+
+    std::lock_guard<std::mutex> lock(mImmutableMetadataMutex);
+    mImmutableMetadata[bufferHandle].*cachedMetadata = *outMetadata;
+    return NO_ERROR;
 }
 
 status_t Gralloc4Mapper::getBufferId(buffer_handle_t bufferHandle, uint64_t* outBufferId) const {
-    return get(bufferHandle, gralloc4::MetadataType_BufferId, gralloc4::decodeBufferId,
-               outBufferId);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_BufferId, gralloc4::decodeBufferId,
+                        &ImmutableMetadata::bufferId, outBufferId);
 }
 
 status_t Gralloc4Mapper::getName(buffer_handle_t bufferHandle, std::string* outName) const {
@@ -471,51 +514,59 @@ status_t Gralloc4Mapper::getName(buffer_handle_t bufferHandle, std::string* outN
 }
 
 status_t Gralloc4Mapper::getWidth(buffer_handle_t bufferHandle, uint64_t* outWidth) const {
-    return get(bufferHandle, gralloc4::MetadataType_Width, gralloc4::decodeWidth, outWidth);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_Width, gralloc4::decodeWidth,
+                        &ImmutableMetadata::width, outWidth);
 }
 
 status_t Gralloc4Mapper::getHeight(buffer_handle_t bufferHandle, uint64_t* outHeight) const {
-    return get(bufferHandle, gralloc4::MetadataType_Height, gralloc4::decodeHeight, outHeight);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_Height, gralloc4::decodeHeight,
+                        &ImmutableMetadata::height, outHeight);
 }
 
 status_t Gralloc4Mapper::getLayerCount(buffer_handle_t bufferHandle,
                                        uint64_t* outLayerCount) const {
-    return get(bufferHandle, gralloc4::MetadataType_LayerCount, gralloc4::decodeLayerCount,
-               outLayerCount);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_LayerCount, gralloc4::decodeLayerCount,
+                        &ImmutableMetadata::layerCount, outLayerCount);
 }
 
 status_t Gralloc4Mapper::getPixelFormatRequested(buffer_handle_t bufferHandle,
                                                  ui::PixelFormat* outPixelFormatRequested) const {
-    return get(bufferHandle, gralloc4::MetadataType_PixelFormatRequested,
-               gralloc4::decodePixelFormatRequested, outPixelFormatRequested);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_PixelFormatRequested,
+                        gralloc4::decodePixelFormatRequested,
+                        &ImmutableMetadata::pixelFormatRequested, outPixelFormatRequested);
 }
 
 status_t Gralloc4Mapper::getPixelFormatFourCC(buffer_handle_t bufferHandle,
                                               uint32_t* outPixelFormatFourCC) const {
-    return get(bufferHandle, gralloc4::MetadataType_PixelFormatFourCC,
-               gralloc4::decodePixelFormatFourCC, outPixelFormatFourCC);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_PixelFormatFourCC,
+                        gralloc4::decodePixelFormatFourCC,
+                        &ImmutableMetadata::pixelFormatFourCC, outPixelFormatFourCC);
 }
 
 status_t Gralloc4Mapper::getPixelFormatModifier(buffer_handle_t bufferHandle,
                                                 uint64_t* outPixelFormatModifier) const {
-    return get(bufferHandle, gralloc4::MetadataType_PixelFormatModifier,
-               gralloc4::decodePixelFormatModifier, outPixelFormatModifier);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_PixelFormatModifier,
+                        gralloc4::decodePixelFormatModifier,
+                        &ImmutableMetadata::pixelFormatModifier, outPixelFormatModifier);
 }
 
 status_t Gralloc4Mapper::getUsage(buffer_handle_t bufferHandle, uint64_t* outUsage) const {
-    return get(bufferHandle, gralloc4::MetadataType_Usage, gralloc4::decodeUsage, outUsage);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_Usage, gralloc4::decodeUsage,
+                        &ImmutableMetadata::usage, outUsage);
 }
 
 status_t Gralloc4Mapper::getAllocationSize(buffer_handle_t bufferHandle,
                                            uint64_t* outAllocationSize) const {
-    return get(bufferHandle, gralloc4::MetadataType_AllocationSize, gralloc4::decodeAllocationSize,
-               outAllocationSize);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_AllocationSize,
+                        gralloc4::decodeAllocationSize,
+                        &ImmutableMetadata::allocationSize, outAllocationSize);
 }
 
 status_t Gralloc4Mapper::getProtectedContent(buffer_handle_t bufferHandle,
                                              uint64_t* outProtectedContent) const {
-    return get(bufferHandle, gralloc4::MetadataType_ProtectedContent,
-               gralloc4::decodeProtectedContent, outProtectedContent);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_ProtectedContent,
+                        gralloc4::decodeProtectedContent,
+                        &ImmutableMetadata::protectedContent, outProtectedContent);
 }
 
 status_t Gralloc4Mapper::getCompression(buffer_handle_t bufferHandle,
@@ -589,8 +640,9 @@ status_t Gralloc4Mapper::getChromaSiting(buffer_handle_t bufferHandle,
 
 status_t Gralloc4Mapper::getPlaneLayouts(buffer_handle_t bufferHandle,
                                          std::vector<ui::PlaneLayout>* outPlaneLayouts) const {
-    return get(bufferHandle, gralloc4::MetadataType_PlaneLayouts, gralloc4::decodePlaneLayouts,
-               outPlaneLayouts);
+    return getImmutable(bufferHandle, gralloc4::MetadataType_PlaneLayouts,
+                        gralloc4::decodePlaneLayouts,
+                        &ImmutableMetadata::planeLayouts, outPlaneLayouts);
 }
 
 status_t Gralloc4Mapper::getDataspace(buffer_handle_t bufferHandle,
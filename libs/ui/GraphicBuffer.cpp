@@ -106,6 +106,38 @@ GraphicBuffer::GraphicBuffer(const native_handle_t* inHandle, HandleWrapMethod m
                                 inUsage, inStride);
 }
 
+status_t GraphicBuffer::allocateBuffers(uint32_t inWidth, uint32_t inHeight,
+                                        PixelFormat inFormat, uint32_t inLayerCount,
+                                        uint64_t inUsage, uint32_t bufferCount,
+                                        std::string requestorName,
+                                        std::vector<sp<GraphicBuffer>>* outBuffers) {
+    if (!outBuffers) {
+        return BAD_VALUE;
+    }
+
+    std::vector<buffer_handle_t> handles(bufferCount);
+    uint32_t outStride = 0;
+    status_t err = GraphicBufferAllocator::get().allocateBuffers(inWidth, inHeight, inFormat,
+                                                                 inLayerCount, inUsage,
+                                                                 bufferCount, handles.data(),
+                                                                 &outStride,
+                                                                 std::move(requestorName));
+    if (err != NO_ERROR) {
+        return err;
+    }
+
+    outBuffers->clear();
+    outBuffers->reserve(bufferCount);
+    for (buffer_handle_t handle : handles) {
+        sp<GraphicBuffer> buffer = new GraphicBuffer();
+        buffer->handle = handle;
+        buffer->initWithAllocatedHandle(inWidth, inHeight, inFormat, inLayerCount, inUsage,
+                                        outStride);
+        outBuffers->push_back(std::move(buffer));
+    }
+    return NO_ERROR;
+}
+
 GraphicBuffer::~GraphicBuffer()
 {
     ATRACE_CALL();
@@ -187,19 +219,25 @@ status_t GraphicBuffer::initWithSize(uint32_t inWidth, uint32_t inHeight,
             inUsage, &handle, &outStride, mId,
             std::move(requestorName));
     if (err == NO_ERROR) {
-        mBufferMapper.getTransportSize(handle, &mTransportNumFds, &mTransportNumInts);
-
-        width = static_cast<int>(inWidth);
-        height = static_cast<int>(inHeight);
-        format = inFormat;
-        layerCount = inLayerCount;
-        usage = inUsage;
-        usage_deprecated = int(usage);
-        stride = static_cast<int>(outStride);
+        initWithAllocatedHandle(inWidth, inHeight, inFormat, inLayerCount, inUsage, outStride);
     }
     return err;
 }
 
+void GraphicBuffer::initWithAllocatedHandle(uint32_t inWidth, uint32_t inHeight,
+                                            PixelFormat inFormat, uint32_t inLayerCount,
+                                            uint64_t inUsage, uint32_t inStride) {
+    mBufferMapper.getTransportSize(handle, &mTransportNumFds, &mTransportNumInts);
+
+    width = static_cast<int>(inWidth);
+    height = static_cast<int>(inHeight);
+    format = inFormat;
+    layerCount = inLayerCount;
+    usage = inUsage;
+    usage_deprecated = int(usage);
+    stride = static_cast<int>(inStride);
+}
+
 status_t GraphicBuffer::initWithHandle(const native_handle_t* inHandle, HandleWrapMethod method,
                                        uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
                                        uint32_t inLayerCount, uint64_t inUsage, uint32_t inStride) {
@@ -67,11 +67,13 @@ GraphicBufferAllocator::GraphicBufferAllocator() : mMapper(GraphicBufferMapper::
     LOG_ALWAYS_FATAL("gralloc-allocator is missing");
 }
 
-GraphicBufferAllocator::~GraphicBufferAllocator() {}
+GraphicBufferAllocator::~GraphicBufferAllocator() {
+    setPoolBudget(0, {});
+}
 
 uint64_t GraphicBufferAllocator::getTotalSize() const {
     Mutex::Autolock _l(sLock);
-    uint64_t total = 0;
+    uint64_t total = mPoolSize;
     for (size_t i = 0; i < sAllocList.size(); ++i) {
         total += sAllocList.valueAt(i).size;
     }
@@ -98,6 +100,13 @@ void GraphicBufferAllocator::dump(std::string& result, bool less) const {
     }
     StringAppendF(&result, "Total allocated by GraphicBufferAllocator (estimate): %.2f KB\n",
                   static_cast<double>(total) / 1024.0);
+    if (mPoolBudget > 0) {
+        StringAppendF(&result,
+                      "Buffer pool: %zu buffers, %.2f KB of %.2f KB budget, %" PRIu64
+                      " hits, %" PRIu64 " misses\n",
+                      mPool.size(), static_cast<double>(mPoolSize) / 1024.0,
+                      static_cast<double>(mPoolBudget) / 1024.0, mPoolHits, mPoolMisses);
+    }
 
     result.append(mAllocator->dumpDebugInfo(less));
 }
@@ -110,10 +119,15 @@ void GraphicBufferAllocator::dumpToSystemLog(bool less) {
 
 status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height, PixelFormat format,
                                                 uint32_t layerCount, uint64_t usage,
-                                                buffer_handle_t* handle, uint32_t* stride,
-                                                std::string requestorName, bool importBuffer) {
+                                                uint32_t bufferCount, buffer_handle_t* handles,
+                                                uint32_t* stride, std::string requestorName,
+                                                bool importBuffer) {
     ATRACE_CALL();
 
+    if (bufferCount < 1) {
+        return BAD_VALUE;
+    }
+
     // make sure to not allocate a N x 0 or 0 x N buffer, since this is
     // allowed from an API stand-point allocate a 1x1 buffer instead.
     if (!width || !height)
@@ -135,12 +149,20 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     // TODO(b/72323293, b/72703005): Remove these invalid bits from callers
     usage &= ~static_cast<uint64_t>((1 << 10) | (1 << 13));
 
+    if (importBuffer && bufferCount == 1) {
+        Mutex::Autolock _l(sLock);
+        if (takePooledBufferLocked(width, height, format, layerCount, usage, handles, stride,
+                                   requestorName)) {
+            return NO_ERROR;
+        }
+    }
+
     status_t error = mAllocator->allocate(requestorName, width, height, format, layerCount, usage,
-                                          1, stride, handle, importBuffer);
+                                          bufferCount, stride, handles, importBuffer);
     if (error != NO_ERROR) {
-        ALOGE("Failed to allocate (%u x %u) layerCount %u format %d "
+        ALOGE("Failed to allocate %u x (%u x %u) layerCount %u format %d "
               "usage %" PRIx64 ": %d",
-              width, height, layerCount, format, usage, error);
+              bufferCount, width, height, layerCount, format, usage, error);
         return error;
     }
 
@@ -169,7 +191,9 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     rec.usage = usage;
     rec.size = bufSize;
     rec.requestorName = std::move(requestorName);
-    list.add(*handle, rec);
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        list.add(handles[i], rec);
+    }
 
     return NO_ERROR;
 }
@@ -177,16 +201,25 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::allocateRawHandle(uint32_t width, uint32_t height,
                                                    PixelFormat format, uint32_t layerCount,
                                                    uint64_t usage, buffer_handle_t* handle,
                                                    uint32_t* stride, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          false);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, false);
+}
+
+status_t GraphicBufferAllocator::allocateBuffers(uint32_t width, uint32_t height,
+                                                 PixelFormat format, uint32_t layerCount,
+                                                 uint64_t usage, uint32_t bufferCount,
+                                                 buffer_handle_t* outHandles, uint32_t* stride,
+                                                 std::string requestorName) {
+    return allocateHelper(width, height, format, layerCount, usage, bufferCount, outHandles,
+                          stride, requestorName, true);
 }
 
 // DEPRECATED
@@ -194,14 +227,38 @@ status_t GraphicBufferAllocator::allocate(uint32_t width, uint32_t height, Pixel
                                           uint32_t layerCount, uint64_t usage,
                                           buffer_handle_t* handle, uint32_t* stride,
                                           uint64_t /*graphicBufferId*/, std::string requestorName) {
-    return allocateHelper(width, height, format, layerCount, usage, handle, stride, requestorName,
-                          true);
+    return allocateHelper(width, height, format, layerCount, usage, 1, handle, stride,
+                          requestorName, true);
 }
 
 status_t GraphicBufferAllocator::free(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        const ssize_t index = sAllocList.indexOfKey(handle);
+        if (mPoolBudget > 0 && index >= 0) {
+            const alloc_rec_t& rec = sAllocList.valueAt(index);
+            // Buffers of an unknown size can't be accounted against the budget.
+            if (!(rec.usage & GRALLOC_USAGE_PROTECTED) && rec.size > 0 &&
+                rec.size <= mPoolBudget && mPoolRequestors.count(rec.requestorName) > 0) {
+                mPool.push_back({handle, rec});
+                mPoolSize += rec.size;
+                sAllocList.removeItemsAt(index);
+                evicted = trimPoolLocked();
+                handle = nullptr;
+            }
+        }
+    }
+    for (buffer_handle_t evictedHandle : evicted) {
+        mMapper.freeBuffer(evictedHandle);
+    }
+    if (handle == nullptr) {
+        return NO_ERROR;
+    }
+
     // We allocated a buffer from the allocator and imported it into the
     // mapper to get the handle.  We just need to free the handle now.
     mMapper.freeBuffer(handle);
@@ -213,5 +270,71 @@ status_t GraphicBufferAllocator::free(buffer_handle_t handle)
     return NO_ERROR;
 }
 
+void GraphicBufferAllocator::setPoolBudget(uint64_t budgetBytes,
+                                           std::vector<std::string> requestorNames) {
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        mPoolBudget = budgetBytes;
+        mPoolRequestors = std::unordered_set<std::string>(requestorNames.begin(),
+                                                          requestorNames.end());
+        // The buffers of requestors that may no longer pool are not handed out again.
+        for (auto it = mPool.begin(); it != mPool.end();) {
+            if (mPoolRequestors.count(it->rec.requestorName) == 0) {
+                mPoolSize -= it->rec.size;
+                evicted.push_back(it->handle);
+                it = mPool.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto trimmed = trimPoolLocked();
+        evicted.insert(evicted.end(), trimmed.begin(), trimmed.end());
+    }
+    for (buffer_handle_t handle : evicted) {
+        mMapper.freeBuffer(handle);
+    }
+}
+
+bool GraphicBufferAllocator::takePooledBufferLocked(uint32_t width, uint32_t height,
+                                                    PixelFormat format, uint32_t layerCount,
+                                                    uint64_t usage, buffer_handle_t* handle,
+                                                    uint32_t* stride,
+                                                    const std::string& requestorName) {
+    if (mPoolBudget == 0) {
+        return false;
+    }
+    // Search from the most recently freed buffer, which is the likeliest to be hot in caches.
+    for (auto it = mPool.rbegin(); it != mPool.rend(); ++it) {
+        const alloc_rec_t& rec = it->rec;
+        // A buffer keeps its contents, so it only goes back to the requestor that freed it.
+        if (rec.width != width || rec.height != height || rec.format != format ||
+            rec.layerCount != layerCount || rec.usage != usage ||
+            rec.requestorName != requestorName) {
+            continue;
+        }
+        *handle = it->handle;
+        *stride = rec.stride;
+        alloc_rec_t reused = rec;
+        mPoolSize -= rec.size;
+        mPool.erase(std::next(it).base());
+        sAllocList.add(*handle, std::move(reused));
+        mPoolHits++;
+        return true;
+    }
+    mPoolMisses++;
+    return false;
+}
+
+std::vector<buffer_handle_t> GraphicBufferAllocator::trimPoolLocked() {
+    std::vector<buffer_handle_t> evicted;
+    while (mPoolSize > mPoolBudget && !mPool.empty()) {
+        mPoolSize -= mPool.front().rec.size;
+        evicted.push_back(mPool.front().handle);
+        mPool.pop_front();
+    }
+    return evicted;
+}
+
 // ---------------------------------------------------------------------------
 }; // namespace android
@@ -643,6 +643,80 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
     return result;
 }
 
+static inline bool containsRect(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top &&
+            outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+// Computes the operations whose result is empty, one of the operands or a
+// single rect from the bounds alone, without rasterizing the operands. Most
+// of the regions of a frame are made of a few rects that are either disjoint
+// or nested, so these are the common cases.
+// Returns false if the operation has to be rasterized.
+bool Region::trivial_boolean_operation(uint32_t op, Region& dst,
+        const Region& lhs, const Region& rhs, int dx, int dy)
+{
+    const Rect lhsBounds(lhs.getBounds());
+    Rect rhsBounds(rhs.getBounds());
+    rhsBounds.offsetBy(dx, dy);
+
+    const bool lhsEmpty = lhsBounds.isEmpty();
+    const bool rhsEmpty = rhsBounds.isEmpty();
+    if (lhsEmpty || rhsEmpty) {
+        if (op == op_and || (lhsEmpty && (rhsEmpty || op == op_nand))) {
+            dst.clear();
+        } else if (rhsEmpty) {
+            dst = lhs;
+        } else {
+            translate(dst, rhs, dx, dy);
+        }
+        return true;
+    }
+
+    Rect intersection;
+    if (!lhsBounds.intersect(rhsBounds, &intersection)) {
+        switch (op) {
+            case op_and:
+                dst.clear();
+                return true;
+            case op_nand:
+                dst = lhs;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    if (op == op_and && lhs.isRect() && rhs.isRect()) {
+        dst.set(intersection);
+        return true;
+    }
+    if (rhs.isRect() && containsRect(rhsBounds, lhsBounds)) {
+        switch (op) {
+            case op_and:
+                dst = lhs;
+                return true;
+            case op_or:
+                dst.set(rhsBounds);
+                return true;
+            case op_nand:
+                dst.clear();
+                return true;
+        }
+    }
+    if (lhs.isRect() && containsRect(lhsBounds, rhsBounds)) {
+        switch (op) {
+            case op_and:
+                translate(dst, rhs, dx, dy);
+                return true;
+            case op_or:
+                dst = lhs;
+                return true;
+        }
+    }
+    return false;
+}
+
 void Region::boolean_operation(uint32_t op, Region& dst,
         const Region& lhs,
         const Region& rhs, int dx, int dy)
@@ -653,6 +727,15 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     validate(dst, "boolean_operation (before): dst");
 #endif
 
+#if !VALIDATE_WITH_CORECG
+    if (trivial_boolean_operation(op, dst, lhs, rhs, dx, dy)) {
+#if defined(VALIDATE_REGIONS)
+        validate(dst, "trivial_boolean_operation: dst");
+#endif
+        return;
+    }
+#endif
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -767,6 +850,10 @@ void Region::boolean_operation(uint32_t op, Region& dst,
 #if VALIDATE_WITH_CORECG || defined(VALIDATE_REGIONS)
     boolean_operation(op, dst, lhs, Region(rhs), dx, dy);
 #else
+    if (trivial_boolean_operation(op, dst, lhs, Region(rhs), dx, dy)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
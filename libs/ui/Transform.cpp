@@ -19,6 +19,9 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <limits>
+
 #include <android-base/stringprintf.h>
 #include <cutils/compiler.h>
 #include <ui/Region.h>
@@ -51,6 +54,32 @@ bool Transform::absIsOne(float f) {
     return isZero(fabs(f) - 1.0f);
 }
 
+// whether f is a whole number that fits in an int32_t
+static bool isWhole(float f) {
+    return f == floorf(f) && fabsf(f) < 2147483648.0f;
+}
+
+static int32_t saturate(int64_t v) {
+    return static_cast<int32_t>(std::clamp<int64_t>(v, std::numeric_limits<int32_t>::min(),
+                                                    std::numeric_limits<int32_t>::max()));
+}
+
+bool Transform::isTranslation() const {
+    const mat33& M(mMatrix);
+    return type() <= TRANSLATE && isZero(M[0][2]) && isZero(M[1][2]) && M[2][2] == 1.0f;
+}
+
+bool Transform::isIntegral() const {
+    if (!preserveRects()) {
+        return false;
+    }
+    const mat33& M(mMatrix);
+    if (getOrientation() & ROT_90) {
+        return absIsOne(M[1][0]) && absIsOne(M[0][1]) && isWhole(M[2][0]) && isWhole(M[2][1]);
+    }
+    return absIsOne(M[0][0]) && absIsOne(M[1][1]) && isWhole(M[2][0]) && isWhole(M[2][1]);
+}
+
 bool Transform::operator==(const Transform& other) const {
     return mMatrix[0][0] == other.mMatrix[0][0] && mMatrix[0][1] == other.mMatrix[0][1] &&
             mMatrix[0][2] == other.mMatrix[0][2] && mMatrix[1][0] == other.mMatrix[1][0] &&
@@ -67,17 +96,34 @@ Transform Transform::operator*(const Transform& rhs) const {
     if (rhs.mType == IDENTITY)
         return r;
 
-    // TODO: we could use mType to optimize the matrix multiply
     const mat33& A(mMatrix);
     const mat33& B(rhs.mMatrix);
           mat33& D(r.mMatrix);
-    for (size_t i = 0; i < 3; i++) {
-        const float v0 = A[0][i];
-        const float v1 = A[1][i];
-        const float v2 = A[2][i];
-        D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
-        D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
-        D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+    if (isTranslation()) {
+        // B followed by the translation of A, e.g. a layer's position in its parent.
+        const float x = A[2][0];
+        const float y = A[2][1];
+        for (size_t i = 0; i < 3; i++) {
+            D[i][0] = B[i][0] + x*B[i][2];
+            D[i][1] = B[i][1] + y*B[i][2];
+            D[i][2] = B[i][2];
+        }
+    } else if (rhs.isTranslation()) {
+        // only the translation of A changes
+        const float x = B[2][0];
+        const float y = B[2][1];
+        for (size_t i = 0; i < 3; i++) {
+            D[2][i] = A[0][i]*x + A[1][i]*y + A[2][i];
+        }
+    } else {
+        for (size_t i = 0; i < 3; i++) {
+            const float v0 = A[0][i];
+            const float v1 = A[1][i];
+            const float v2 = A[2][i];
+            D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
+            D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
+            D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+        }
     }
     r.mType |= rhs.mType;
 
@@ -247,34 +293,88 @@ Rect Transform::makeBounds(int w, int h) const {
     return transform( Rect(w, h) );
 }
 
+Rect Transform::transformIntegral(const Rect& bounds) const {
+    // x only depends on y and y on x when rotated by 90 degrees, and the factors are 1 or -1.
+    const mat33& M(mMatrix);
+    const bool rot90 = getOrientation() & ROT_90;
+    const bool flipX = (rot90 ? M[1][0] : M[0][0]) < 0;
+    const bool flipY = (rot90 ? M[0][1] : M[1][1]) < 0;
+    const int64_t tx = static_cast<int64_t>(M[2][0]);
+    const int64_t ty = static_cast<int64_t>(M[2][1]);
+
+    int64_t x0 = rot90 ? bounds.top : bounds.left;
+    int64_t x1 = rot90 ? bounds.bottom : bounds.right;
+    int64_t y0 = rot90 ? bounds.left : bounds.top;
+    int64_t y1 = rot90 ? bounds.right : bounds.bottom;
+    x0 = tx + (flipX ? -x0 : x0);
+    x1 = tx + (flipX ? -x1 : x1);
+    y0 = ty + (flipY ? -y0 : y0);
+    y1 = ty + (flipY ? -y1 : y1);
+
+    return Rect(saturate(std::min(x0, x1)), saturate(std::min(y0, y1)),
+                saturate(std::max(x0, x1)), saturate(std::max(y0, y1)));
+}
+
 Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
-    Rect r;
-    vec2 lt( bounds.left,  bounds.top    );
-    vec2 rt( bounds.right, bounds.top    );
-    vec2 lb( bounds.left,  bounds.bottom );
-    vec2 rb( bounds.right, bounds.bottom );
+    float left, top, right, bottom;
+    if (preserveRects()) {
+        if (isIntegral()) {
+            return transformIntegral(bounds);
+        }
 
-    lt = transform(lt);
-    rt = transform(rt);
-    lb = transform(lb);
-    rb = transform(rb);
+        // axis aligned, so two opposite corners are enough
+        const vec2 lt = transform(vec2(bounds.left, bounds.top));
+        const vec2 rb = transform(vec2(bounds.right, bounds.bottom));
+        left   = std::min(lt[0], rb[0]);
+        top    = std::min(lt[1], rb[1]);
+        right  = std::max(lt[0], rb[0]);
+        bottom = std::max(lt[1], rb[1]);
+    } else {
+        vec2 lt( bounds.left,  bounds.top    );
+        vec2 rt( bounds.right, bounds.top    );
+        vec2 lb( bounds.left,  bounds.bottom );
+        vec2 rb( bounds.right, bounds.bottom );
+
+        lt = transform(lt);
+        rt = transform(rt);
+        lb = transform(lb);
+        rb = transform(rb);
+
+        left   = std::min({lt[0], rt[0], lb[0], rb[0]});
+        top    = std::min({lt[1], rt[1], lb[1], rb[1]});
+        right  = std::max({lt[0], rt[0], lb[0], rb[0]});
+        bottom = std::max({lt[1], rt[1], lb[1], rb[1]});
+    }
 
+    Rect r;
     if (roundOutwards) {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]})));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]})));
-        r.right  = static_cast<int32_t>(ceilf(std::max({lt[0], rt[0], lb[0], rb[0]})));
-        r.bottom = static_cast<int32_t>(ceilf(std::max({lt[1], rt[1], lb[1], rb[1]})));
+        r.left   = static_cast<int32_t>(floorf(left));
+        r.top    = static_cast<int32_t>(floorf(top));
+        r.right  = static_cast<int32_t>(ceilf(right));
+        r.bottom = static_cast<int32_t>(ceilf(bottom));
     } else {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
-        r.right  = static_cast<int32_t>(floorf(std::max({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.bottom = static_cast<int32_t>(floorf(std::max({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
+        r.left   = static_cast<int32_t>(floorf(left + 0.5f));
+        r.top    = static_cast<int32_t>(floorf(top + 0.5f));
+        r.right  = static_cast<int32_t>(floorf(right + 0.5f));
+        r.bottom = static_cast<int32_t>(floorf(bottom + 0.5f));
     }
 
     return r;
 }
 
 FloatRect Transform::transform(const FloatRect& bounds) const {
+    FloatRect r;
+    if (preserveRects()) {
+        // axis aligned, so two opposite corners are enough
+        const vec2 lt = transform(vec2(bounds.left, bounds.top));
+        const vec2 rb = transform(vec2(bounds.right, bounds.bottom));
+        r.left = std::min(lt[0], rb[0]);
+        r.top = std::min(lt[1], rb[1]);
+        r.right = std::max(lt[0], rb[0]);
+        r.bottom = std::max(lt[1], rb[1]);
+        return r;
+    }
+
     vec2 lt(bounds.left, bounds.top);
     vec2 rt(bounds.right, bounds.top);
     vec2 lb(bounds.left, bounds.bottom);
@@ -285,7 +385,6 @@ FloatRect Transform::transform(const FloatRect& bounds) const {
     lb = transform(lb);
     rb = transform(rb);
 
-    FloatRect r;
     r.left = std::min({lt[0], rt[0], lb[0], rb[0]});
     r.top = std::min({lt[1], rt[1], lb[1], rb[1]});
     r.right = std::max({lt[0], rt[0], lb[0], rb[0]});
@@ -294,14 +393,126 @@ FloatRect Transform::transform(const FloatRect& bounds) const {
     return r;
 }
 
+// Builds the region covered by rects, which must not overlap, band by band like the boolean
+// operations of Region do, but without merging the rects one by one.
+static Region fromDisjointRects(FatVector<Rect, 16>& rects) {
+    rects.erase(std::remove_if(rects.begin(), rects.end(),
+                               [](const Rect& r) { return r.isEmpty(); }),
+                rects.end());
+    if (rects.empty()) {
+        return Region();
+    }
+    if (rects.size() == 1) {
+        return Region(rects[0]);
+    }
+
+    // the bands are delimited by the top and bottom edges of all rects
+    FatVector<int32_t, 32> edges;
+    for (const Rect& r : rects) {
+        edges.push_back(r.top);
+        edges.push_back(r.bottom);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    std::sort(rects.begin(), rects.end(),
+              [](const Rect& lhs, const Rect& rhs) { return lhs.left < rhs.left; });
+
+    FatVector<Rect, 16> result;
+    size_t lastBand = 0;
+    for (size_t i = 0; i + 1 < edges.size(); i++) {
+        const int32_t top = edges[i];
+        const int32_t bottom = edges[i + 1];
+        const size_t band = result.size();
+        for (const Rect& r : rects) {
+            if (r.top > top || r.bottom < bottom) {
+                continue;
+            }
+            if (result.size() > band && result.back().right == r.left) {
+                result.back().right = r.right;
+            } else {
+                result.push_back(Rect(r.left, top, r.right, bottom));
+            }
+        }
+
+        // coalesce with the band above if it has the same spans
+        const size_t count = result.size() - band;
+        if (count > 0 && band - lastBand == count && result[lastBand].bottom == top &&
+            std::equal(result.begin() + lastBand, result.begin() + band, result.begin() + band,
+                       [](const Rect& lhs, const Rect& rhs) {
+                           return lhs.left == rhs.left && lhs.right == rhs.right;
+                       })) {
+            for (size_t j = lastBand; j < band; j++) {
+                result[j].bottom = bottom;
+            }
+            result.resize(band);
+        } else if (count > 0) {
+            lastBand = band;
+        }
+    }
+
+    Region out;
+    if (result.size() == 1) {
+        out.set(result[0]);
+        return out;
+    }
+    Rect bounds = result[0];
+    for (const Rect& r : result) {
+        bounds.left = std::min(bounds.left, r.left);
+        bounds.right = std::max(bounds.right, r.right);
+    }
+    bounds.bottom = result.back().bottom;
+    out.set(bounds);
+    for (const Rect& r : result) {
+        out.addRectUnchecked(r.left, r.top, r.right, r.bottom);
+    }
+    return out;
+}
+
 Region Transform::transform(const Region& reg) const {
     Region out;
     if (CC_UNLIKELY(type() > TRANSLATE)) {
         if (CC_LIKELY(preserveRects())) {
-            Region::const_iterator it = reg.begin();
-            Region::const_iterator const end = reg.end();
-            while (it != end) {
-                out.orSelf(transform(*it++));
+            if (reg.isEmpty()) {
+                return out;
+            }
+
+            size_t count;
+            const Rect* const rects = reg.getArray(&count);
+            const bool integral = isIntegral();
+            FatVector<Rect, 16> transformed;
+            transformed.reserve(count);
+            for (size_t i = 0; i < count; i++) {
+                transformed.push_back(integral ? transformIntegral(rects[i])
+                                               : transform(rects[i]));
+            }
+
+            const uint32_t orientation = getOrientation();
+            if (!integral || (orientation & ROT_90)) {
+                // rotating turns bands into columns, and rounding may make rects touch or empty
+                return fromDisjointRects(transformed);
+            }
+
+            // Flipping whole pixels only reverses the order of the bands and/or the order of
+            // the rects within them, so the region can be rebuilt as is.
+            if (count == 1) {
+                out.set(transformed[0]);
+                return out;
+            }
+            if (orientation & FLIP_V) {
+                std::reverse(transformed.begin(), transformed.end());
+            }
+            if (bool(orientation & FLIP_V) != bool(orientation & FLIP_H)) {
+                for (auto band = transformed.begin(); band != transformed.end();) {
+                    const auto top = band->top;
+                    const auto end = std::find_if(band, transformed.end(),
+                                                  [top](const Rect& r) { return r.top != top; });
+                    std::reverse(band, end);
+                    band = end;
+                }
+            }
+            out.set(transformIntegral(reg.bounds()));
+            for (const Rect& r : transformed) {
+                out.addRectUnchecked(r.left, r.top, r.right, r.bottom);
             }
         } else {
             out.set(transform(reg.bounds()));
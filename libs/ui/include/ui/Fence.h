@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <android-base/unique_fd.h>
 #include <utils/Flattenable.h>
 #include <utils/RefBase.h>
@@ -94,6 +96,15 @@ public:
     static sp<Fence> merge(const String8& name, const sp<Fence>& f1,
             const sp<Fence>& f2);
 
+    // merge combines any number of Fence objects into one that becomes
+    // signaled when all of them are signaled. Invalid fences are ignored, and
+    // a single valid fence is returned as is rather than duplicated. Fences
+    // that already signaled are dropped when others are still pending, as
+    // they can't change when the result signals. The rest are merged in
+    // pairs, level by level, so that each one is copied into log2(N)
+    // intermediate fences rather than up to N as in a chain of merges.
+    static sp<Fence> merge(const char* name, const std::vector<sp<Fence>>& fences);
+
     // Return a duplicate of the fence file descriptor. The caller is
     // responsible for closing the returned file descriptor. On error, -1 will
     // be returned and errno will indicate the problem.
@@ -26,7 +26,10 @@
 #include <ui/Rect.h>
 #include <utils/StrongPointer.h>
 
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace android {
 
@@ -165,6 +168,30 @@ private:
             const android::hardware::graphics::mapper::V4_0::IMapper::MetadataType& metadataType,
             DecodeFunction<T> decodeFunction, T* outMetadata) const;
 
+    // The metadata that can't change once a buffer is allocated, cached from the first get()
+    // until the buffer is freed.
+    struct ImmutableMetadata {
+        std::optional<uint64_t> bufferId;
+        std::optional<uint64_t> width;
+        std::optional<uint64_t> height;
+        std::optional<uint64_t> layerCount;
+        std::optional<ui::PixelFormat> pixelFormatRequested;
+        std::optional<uint32_t> pixelFormatFourCC;
+        std::optional<uint64_t> pixelFormatModifier;
+        std::optional<uint64_t> usage;
+        std::optional<uint64_t> allocationSize;
+        std::optional<uint64_t> protectedContent;
+        std::optional<std::vector<ui::PlaneLayout>> planeLayouts;
+    };
+
+    // Like get(), but returns the cached value of an immutable metadata type if there is one.
+    template <class T>
+    status_t getImmutable(
+            buffer_handle_t bufferHandle,
+            const android::hardware::graphics::mapper::V4_0::IMapper::MetadataType& metadataType,
+            DecodeFunction<T> decodeFunction, std::optional<T> ImmutableMetadata::*cachedMetadata,
+            T* outMetadata) const;
+
     template <class T>
     status_t getDefault(
             uint32_t width, uint32_t height, PixelFormat format, uint32_t layerCount,
@@ -182,6 +209,9 @@ private:
             std::ostringstream* outDump, uint64_t* outAllocationSize, bool less) const;
 
     sp<hardware::graphics::mapper::V4_0::IMapper> mMapper;
+
+    mutable std::mutex mImmutableMetadataMutex;
+    mutable std::unordered_map<buffer_handle_t, ImmutableMetadata> mImmutableMetadata;
 };
 
 class Gralloc4Allocator : public GrallocAllocator {
@@ -94,6 +94,13 @@ public:
             uint32_t inLayerCount, uint64_t inUsage,
             std::string requestorName = "<Unknown>");
 
+    // Create bufferCount GraphicBuffers like the constructor above, with a single allocation
+    // request to gralloc. Either all of the buffers are created or none is.
+    static status_t allocateBuffers(uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
+                                    uint32_t inLayerCount, uint64_t inUsage, uint32_t bufferCount,
+                                    std::string requestorName,
+                                    std::vector<sp<GraphicBuffer>>* outBuffers);
+
     // Create a GraphicBuffer from an existing handle.
     enum HandleWrapMethod : uint8_t {
         // Wrap and use the handle directly.  It assumes the handle has been
@@ -245,6 +252,10 @@ private:
             PixelFormat inFormat, uint32_t inLayerCount,
             uint64_t inUsage, std::string requestorName);
 
+    // Finishes initializing a buffer whose handle was just allocated for it.
+    void initWithAllocatedHandle(uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
+                                 uint32_t inLayerCount, uint64_t inUsage, uint32_t inStride);
+
     status_t initWithHandle(const native_handle_t* inHandle, HandleWrapMethod method,
                             uint32_t inWidth, uint32_t inHeight, PixelFormat inFormat,
                             uint32_t inLayerCount, uint64_t inUsage, uint32_t inStride);
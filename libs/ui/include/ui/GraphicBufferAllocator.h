@@ -20,8 +20,11 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <cutils/native_handle.h>
 
@@ -51,6 +54,16 @@ public:
                       uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
                       std::string requestorName);
 
+    /**
+     * Allocates and imports bufferCount gralloc buffers with one allocator call. All the buffers
+     * share the same stride. Either all of them are allocated or none is.
+     *
+     * Each handle must be freed with GraphicBufferAllocator::free() when no longer needed.
+     */
+    status_t allocateBuffers(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
+                             uint64_t usage, uint32_t bufferCount, buffer_handle_t* outHandles,
+                             uint32_t* stride, std::string requestorName);
+
     /**
      * Allocates and does NOT import a gralloc buffer. Buffers cannot be used until they have
      * been imported. This function is for advanced use cases only.
@@ -72,6 +85,18 @@ public:
 
     status_t free(buffer_handle_t handle);
 
+    /**
+     * Keeps up to budgetBytes of freed buffers of the given requestors, so that later allocations
+     * by the same requestor with the same dimensions, format, layer count and usage reuse them
+     * instead of calling gralloc. The oldest buffers are freed first when the budget is exceeded.
+     * A budget of 0, the default, disables the pool and frees the buffers it holds.
+     *
+     * A reused buffer keeps the contents it was freed with, so the requestors must only be ones
+     * whose buffers stay within the process and never hold the content of another client.
+     * Protected buffers are never pooled.
+     */
+    void setPoolBudget(uint64_t budgetBytes, std::vector<std::string> requestorNames);
+
     uint64_t getTotalSize() const;
 
     void dump(std::string& res, bool less = true) const;
@@ -89,13 +114,34 @@ protected:
         std::string requestorName;
     };
 
+    struct pooled_buffer_t {
+        buffer_handle_t handle;
+        alloc_rec_t rec;
+    };
+
     status_t allocateHelper(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
-                            uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
-                            std::string requestorName, bool importBuffer);
+                            uint64_t usage, uint32_t bufferCount, buffer_handle_t* handles,
+                            uint32_t* stride, std::string requestorName, bool importBuffer);
+
+    // Moves a pooled buffer matching the request to sAllocList, if there is one.
+    bool takePooledBufferLocked(uint32_t width, uint32_t height, PixelFormat format,
+                                uint32_t layerCount, uint64_t usage, buffer_handle_t* handle,
+                                uint32_t* stride, const std::string& requestorName);
+    // Removes the oldest pooled buffers until the pool fits its budget, and returns them to be
+    // freed once sLock is released.
+    std::vector<buffer_handle_t> trimPoolLocked();
 
     static Mutex sLock;
     static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
 
+    // The freed buffers kept for reuse, oldest first, guarded by sLock.
+    std::deque<pooled_buffer_t> mPool;
+    uint64_t mPoolBudget = 0;
+    std::unordered_set<std::string> mPoolRequestors;
+    uint64_t mPoolSize = 0;
+    uint64_t mPoolHits = 0;
+    uint64_t mPoolMisses = 0;
+
     friend class Singleton<GraphicBufferAllocator>;
     GraphicBufferAllocator();
     ~GraphicBufferAllocator();
@@ -161,6 +161,9 @@ private:
     const Region operation(const Region& rhs, uint32_t op) const;
     const Region operation(const Region& rhs, int dx, int dy, uint32_t op) const;
 
+    static bool trivial_boolean_operation(uint32_t op, Region& dst,
+            const Region& lhs, const Region& rhs, int dx, int dy);
+
     static void boolean_operation(uint32_t op, Region& dst,
             const Region& lhs, const Region& rhs, int dx, int dy);
     static void boolean_operation(uint32_t op, Region& dst,
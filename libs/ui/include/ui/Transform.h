@@ -127,6 +127,16 @@ private:
     static bool absIsOne(float f);
     static bool isZero(float f);
 
+    // whether this is a translation, possibly by zero, without projection
+    bool isTranslation() const;
+
+    // whether this maps pixels to pixels, i.e. it combines a translation by whole pixels with
+    // flips and 90 degree rotations
+    bool isIntegral() const;
+
+    // transforms bounds without floating point math, for an integral transform
+    Rect transformIntegral(const Rect& bounds) const;
+
     mat33               mMatrix;
     mutable uint32_t    mType;
 };
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/Fence.h>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace android {
+namespace {
+
+TEST(FenceTest, MergeOfInvalidFencesIsNoFence) {
+    EXPECT_EQ(Fence::NO_FENCE, Fence::merge("test", std::vector<sp<Fence>>{}));
+    EXPECT_EQ(Fence::NO_FENCE, Fence::merge("test", {Fence::NO_FENCE, new Fence(), nullptr}));
+}
+
+TEST(FenceTest, MergeReturnsSingleValidFence) {
+    // The fence isn't waited on, so any file descriptor will do.
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    close(fds[1]);
+    const sp<Fence> fence = new Fence(fds[0]);
+
+    EXPECT_EQ(fence, Fence::merge("test", {Fence::NO_FENCE, fence}));
+    EXPECT_EQ(fence, Fence::merge("test", {fence, nullptr}));
+}
+
+} // namespace
+} // namespace android
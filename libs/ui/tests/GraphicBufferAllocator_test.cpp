@@ -53,6 +53,11 @@ public:
                     allocate)
                 .WillOnce(DoAll(SetArgPointee<7>(stride), Return(err)));
     }
+    void setUpAllocateExpectations(status_t err, uint32_t stride, buffer_handle_t handle) {
+        EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(mAllocator.get())),
+                    allocate)
+                .WillOnce(DoAll(SetArgPointee<7>(stride), SetArgPointee<8>(handle), Return(err)));
+    }
     std::unique_ptr<const GrallocAllocator>& getAllocator() { return mAllocator; }
 };
 
@@ -113,4 +118,62 @@ TEST_F(GraphicBufferAllocatorTest, AllocateLargeStride) {
     ASSERT_EQ(NO_ERROR, err);
     ASSERT_EQ(expectedStride, stride);
 }
+
+TEST_F(GraphicBufferAllocatorTest, AllocateReusesPooledBuffer) {
+    android::PixelFormat format = PIXEL_FORMAT_RGBA_8888;
+    // The handle is never passed to the mapper, as the pool keeps it until it is reused.
+    const buffer_handle_t expectedHandle = reinterpret_cast<buffer_handle_t>(0x1234);
+    mAllocator.setPoolBudget(kTestWidth * kTestHeight * 4, {"GraphicBufferAllocatorTest"});
+
+    // Only the first allocation reaches gralloc.
+    mAllocator.setUpAllocateExpectations(NO_ERROR, kTestWidth, expectedHandle);
+    uint32_t stride = 0;
+    buffer_handle_t handle;
+    status_t err = mAllocator.allocate(kTestWidth, kTestHeight, format, kTestLayerCount, kTestUsage,
+                                       &handle, &stride, 0, "GraphicBufferAllocatorTest");
+    ASSERT_EQ(NO_ERROR, err);
+    ASSERT_EQ(expectedHandle, handle);
+    ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+
+    stride = 0;
+    handle = nullptr;
+    err = mAllocator.allocate(kTestWidth, kTestHeight, format, kTestLayerCount, kTestUsage, &handle,
+                              &stride, 0, "GraphicBufferAllocatorTest");
+    ASSERT_EQ(NO_ERROR, err);
+    EXPECT_EQ(expectedHandle, handle);
+    EXPECT_EQ(kTestWidth, stride);
+}
+
+TEST_F(GraphicBufferAllocatorTest, AllocateReusesPooledBufferOnlyForSameRequestor) {
+    android::PixelFormat format = PIXEL_FORMAT_RGBA_8888;
+    const buffer_handle_t pooledHandle = reinterpret_cast<buffer_handle_t>(0x1234);
+    const buffer_handle_t otherHandle = reinterpret_cast<buffer_handle_t>(0x5678);
+    mAllocator.setPoolBudget(kTestWidth * kTestHeight * 4, {"GraphicBufferAllocatorTest"});
+
+    // The allocation of another requestor reaches gralloc, although a matching buffer is pooled.
+    EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(
+                        mAllocator.getAllocator().get())),
+                allocate)
+            .WillOnce(DoAll(SetArgPointee<7>(kTestWidth), SetArgPointee<8>(pooledHandle),
+                            Return(NO_ERROR)))
+            .WillOnce(DoAll(SetArgPointee<7>(kTestWidth), SetArgPointee<8>(otherHandle),
+                            Return(NO_ERROR)));
+    uint32_t stride = 0;
+    buffer_handle_t handle;
+    ASSERT_EQ(NO_ERROR,
+              mAllocator.allocate(kTestWidth, kTestHeight, format, kTestLayerCount, kTestUsage,
+                                  &handle, &stride, 0, "GraphicBufferAllocatorTest"));
+    ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+
+    ASSERT_EQ(NO_ERROR,
+              mAllocator.allocate(kTestWidth, kTestHeight, format, kTestLayerCount, kTestUsage,
+                                  &handle, &stride, 0, "OtherClient"));
+    EXPECT_EQ(otherHandle, handle);
+
+    // The pooled buffer still goes back to its own requestor.
+    ASSERT_EQ(NO_ERROR,
+              mAllocator.allocate(kTestWidth, kTestHeight, format, kTestLayerCount, kTestUsage,
+                                  &handle, &stride, 0, "GraphicBufferAllocatorTest"));
+    EXPECT_EQ(pooledHandle, handle);
+}
 } // namespace android
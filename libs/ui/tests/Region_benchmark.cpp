@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+
+// Usage: atest Region_benchmark
+
+namespace android {
+namespace {
+
+const Rect kDisplay(0, 0, 1080, 2340);
+
+// A region of count overlapping windows, as the visible regions of a frame.
+Region makeRegion(int64_t count) {
+    Region region;
+    for (int32_t i = 0; i < count; i++) {
+        region.orSelf(Rect(i * 10, i * 40, 540 + i * 10, 1170 + i * 40));
+    }
+    return region;
+}
+
+// Merges count overlapping rects into a region.
+void BM_RegionMergeRects(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeRegion(state.range(0)));
+    }
+}
+BENCHMARK(BM_RegionMergeRects)->Arg(1)->Arg(4)->Arg(16);
+
+// Clips a region to the display that contains it.
+void BM_RegionIntersectContainingRect(benchmark::State& state) {
+    const Region region = makeRegion(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.intersect(kDisplay));
+    }
+}
+BENCHMARK(BM_RegionIntersectContainingRect)->Arg(1)->Arg(4)->Arg(16);
+
+// Subtracts a region from one it doesn't overlap.
+void BM_RegionSubtractDisjoint(benchmark::State& state) {
+    const Region region = makeRegion(state.range(0));
+    const Region other = makeRegion(state.range(0)).translate(0, 4000);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(other));
+    }
+}
+BENCHMARK(BM_RegionSubtractDisjoint)->Arg(1)->Arg(4)->Arg(16);
+
+// Subtracts overlapping regions, which is always rasterized.
+void BM_RegionSubtractOverlapping(benchmark::State& state) {
+    const Region region = makeRegion(state.range(0));
+    const Region other = makeRegion(state.range(0)).translate(100, 100);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtract(other));
+    }
+}
+BENCHMARK(BM_RegionSubtractOverlapping)->Arg(1)->Arg(4)->Arg(16);
+
+// Transforms a region to a display with the orientation of the argument.
+void BM_RegionTransform(benchmark::State& state) {
+    const Region region = makeRegion(16);
+    const ui::Transform transform(static_cast<uint32_t>(state.range(0)), kDisplay.getWidth(),
+                                  kDisplay.getHeight());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(transform.transform(region));
+    }
+}
+BENCHMARK(BM_RegionTransform)
+        ->Arg(ui::Transform::ROT_90)
+        ->Arg(ui::Transform::ROT_180)
+        ->Arg(ui::Transform::ROT_270);
+
+// Transforms a region to a scaled display.
+void BM_RegionTransformScale(benchmark::State& state) {
+    const Region region = makeRegion(16);
+    ui::Transform transform;
+    transform.set(0.5f, 0, 0, 0.5f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(transform.transform(region));
+    }
+}
+BENCHMARK(BM_RegionTransformScale);
+
+} // namespace
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -179,5 +179,46 @@ TEST_F(RegionTest, RegionHash) {
     EXPECT_NE(std::hash<Region>{}(region1), std::hash<Region>{}(region2));
 }
 
+TEST_F(RegionTest, OperationsWithEmptyRegion) {
+    const Region empty;
+    Region r(Rect(0, 0, 10, 10));
+    r.orSelf(Rect(20, 0, 30, 10));
+
+    EXPECT_TRUE(r.hasSameRects(r.merge(empty)));
+    EXPECT_TRUE(r.hasSameRects(r.mergeExclusive(empty)));
+    EXPECT_TRUE(r.hasSameRects(r.subtract(empty)));
+    EXPECT_TRUE(r.intersect(empty).isEmpty());
+    EXPECT_TRUE(empty.subtract(r).isEmpty());
+    EXPECT_TRUE(r.translate(5, 5).hasSameRects(empty.merge(r, 5, 5)));
+    EXPECT_EQ(Rect(0, 0), r.intersect(Region(Rect::INVALID_RECT)).getBounds());
+}
+
+TEST_F(RegionTest, OperationsWithDisjointRegion) {
+    Region r(Rect(0, 0, 10, 10));
+    r.orSelf(Rect(5, 10, 15, 20));
+    const Region other(Rect(20, 0, 30, 10));
+
+    EXPECT_TRUE(r.intersect(other).isEmpty());
+    EXPECT_TRUE(r.hasSameRects(r.subtract(other)));
+    EXPECT_TRUE(r.subtract(other, -20, 5).hasSameRects(r.subtract(Rect(0, 5, 10, 15))));
+}
+
+TEST_F(RegionTest, OperationsWithContainingRect) {
+    Region r(Rect(10, 10, 20, 20));
+    r.orSelf(Rect(15, 20, 25, 30));
+    const Region rect(Rect(0, 0, 40, 40));
+
+    EXPECT_TRUE(r.hasSameRects(r.intersect(rect)));
+    EXPECT_TRUE(r.hasSameRects(rect.intersect(r)));
+    EXPECT_TRUE(rect.hasSameRects(r.merge(rect)));
+    EXPECT_TRUE(rect.hasSameRects(rect.merge(r)));
+    EXPECT_TRUE(r.subtract(rect).isEmpty());
+    EXPECT_TRUE(r.translate(5, 5).hasSameRects(rect.intersect(r, 5, 5)));
+
+    const Region rects = Region(Rect(0, 0, 10, 10)).intersect(Region(Rect(5, 5, 20, 20)));
+    EXPECT_TRUE(rects.isRect());
+    EXPECT_EQ(Rect(5, 5, 10, 10), rects.getBounds());
+}
+
 }; // namespace android
 
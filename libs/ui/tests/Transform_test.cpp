@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace android::ui {
+namespace {
+
+constexpr uint32_t kOrientations[] = {Transform::ROT_0,   Transform::FLIP_H, Transform::FLIP_V,
+                                      Transform::ROT_90,  Transform::ROT_180,
+                                      Transform::ROT_270, Transform::ROT_90 | Transform::FLIP_H,
+                                      Transform::ROT_90 | Transform::FLIP_V};
+
+// The transforms that SurfaceFlinger applies to layers and displays.
+std::vector<Transform> makeTransforms() {
+    std::vector<Transform> transforms;
+    for (const uint32_t orientation : kOrientations) {
+        Transform rotation(orientation, 1080, 2340);
+        Transform translation;
+        translation.set(50, -20);
+        Transform subpixel;
+        subpixel.set(0.5f, 10.25f);
+        Transform scale;
+        scale.set(0.5f, 0, 0, 1.5f);
+
+        transforms.push_back(rotation);
+        transforms.push_back(translation * rotation);
+        transforms.push_back(rotation * translation);
+        transforms.push_back(subpixel * rotation);
+        transforms.push_back(scale * rotation);
+        transforms.push_back(rotation * scale * translation);
+    }
+    return transforms;
+}
+
+// Transforms the four corners, as the general case does.
+Rect transformCorners(const Transform& t, const Rect& r) {
+    const vec2 corners[] = {t.transform(vec2(r.left, r.top)), t.transform(vec2(r.right, r.top)),
+                            t.transform(vec2(r.left, r.bottom)),
+                            t.transform(vec2(r.right, r.bottom))};
+    float left = corners[0].x, top = corners[0].y, right = corners[0].x, bottom = corners[0].y;
+    for (const vec2& corner : corners) {
+        left = std::min(left, corner.x);
+        top = std::min(top, corner.y);
+        right = std::max(right, corner.x);
+        bottom = std::max(bottom, corner.y);
+    }
+    return Rect(static_cast<int32_t>(floorf(left + 0.5f)), static_cast<int32_t>(floorf(top + 0.5f)),
+                static_cast<int32_t>(floorf(right + 0.5f)),
+                static_cast<int32_t>(floorf(bottom + 0.5f)));
+}
+
+// Merges the transformed rects one by one.
+Region transformRects(const Transform& t, const Region& region) {
+    Region out;
+    for (const Rect& r : region) {
+        out.orSelf(t.transform(r));
+    }
+    return out;
+}
+
+// A region with several bands of several rects, as the visible region of stacked windows.
+Region makeRegion() {
+    Region region;
+    for (int32_t i = 0; i < 6; i++) {
+        region.orSelf(Rect(i * 70, i * 150, 400 + i * 70, 300 + i * 150));
+    }
+    region.subtractSelf(Rect(100, 100, 200, 1000));
+    return region;
+}
+
+TEST(TransformTest, composeMatchesMatrixProduct) {
+    const std::vector<Transform> transforms = makeTransforms();
+    for (const Transform& lhs : transforms) {
+        for (const Transform& rhs : transforms) {
+            const mat4 expected = lhs.asMatrix4() * rhs.asMatrix4();
+            const mat4 actual = (lhs * rhs).asMatrix4();
+            for (size_t col = 0; col < 4; col++) {
+                for (size_t row = 0; row < 4; row++) {
+                    EXPECT_NEAR(expected[col][row], actual[col][row], 1e-3f);
+                }
+            }
+        }
+    }
+}
+
+TEST(TransformTest, composeTranslations) {
+    Transform a;
+    a.set(10, 20);
+    Transform b;
+    b.set(-10, 5);
+
+    const Transform c = a * b;
+    EXPECT_EQ(Transform::TRANSLATE, c.getType());
+    EXPECT_EQ(0, c.tx());
+    EXPECT_EQ(25, c.ty());
+
+    Transform d;
+    d.set(0, -25);
+    EXPECT_EQ(Transform::IDENTITY, (c * d).getType());
+}
+
+TEST(TransformTest, transformRectMatchesCorners) {
+    const Rect rects[] = {Rect(0, 0, 1080, 2340), Rect(-30, 45, 17, 1001), Rect(3, 4, 3, 4)};
+    for (const Transform& t : makeTransforms()) {
+        for (const Rect& r : rects) {
+            EXPECT_EQ(transformCorners(t, r), t.transform(r));
+        }
+    }
+}
+
+TEST(TransformTest, transformRectSaturates) {
+    Transform t;
+    t.set(100, 0);
+    const Rect r = (Transform(Transform::FLIP_H) * t).transform(Rect(0, 0, INT32_MAX, 10));
+    EXPECT_EQ(INT32_MIN, r.left);
+    EXPECT_EQ(-100, r.right);
+}
+
+TEST(TransformTest, transformRegionMatchesRects) {
+    const Region region = makeRegion();
+    ASSERT_GT(region.end() - region.begin(), 4);
+
+    for (const Transform& t : makeTransforms()) {
+        const Region expected = transformRects(t, region);
+        const Region actual = t.transform(region);
+        EXPECT_TRUE(expected.hasSameRects(actual));
+        EXPECT_EQ(expected.getBounds(), actual.getBounds());
+    }
+}
+
+TEST(TransformTest, transformRegionRect) {
+    const Region region(Rect(10, 20, 30, 40));
+    for (const Transform& t : makeTransforms()) {
+        const Region actual = t.transform(region);
+        EXPECT_TRUE(actual.isRect());
+        EXPECT_EQ(t.transform(region.getBounds()), actual.getBounds());
+    }
+}
+
+TEST(TransformTest, transformEmptyRegion) {
+    for (const Transform& t : makeTransforms()) {
+        EXPECT_TRUE(t.transform(Region()).isEmpty());
+    }
+}
+
+} // namespace
+} // namespace android::ui
@@ -0,0 +1,34 @@
+#include "include/dvr/dvr_vsync.h"
+
+#include <errno.h>
+
+#include <dvr/dvr_shared_buffers.h>
+#include <private/dvr/shared_buffer_helpers.h>
+
+using android::dvr::CPUMappedBroadcastRing;
+using android::dvr::CPUUsageMode;
+using android::dvr::DvrGlobalBuffers;
+using android::dvr::DvrVsyncRing;
+
+struct DvrVsyncReader {
+  // Maps the ring published by the display service on first use.
+  CPUMappedBroadcastRing<DvrVsyncRing> vsync_ring{
+      DvrGlobalBuffers::kVsyncBuffer, CPUUsageMode::READ_OFTEN};
+};
+
+int dvrVsyncReaderCreate(DvrVsyncReader** reader_out) {
+  if (!reader_out)
+    return -EINVAL;
+
+  *reader_out = new DvrVsyncReader;
+  return 0;
+}
+
+void dvrVsyncReaderDestroy(DvrVsyncReader* reader) { delete reader; }
+
+int dvrVsyncReaderGetNewest(DvrVsyncReader* reader, DvrVsync* vsync_out) {
+  if (!reader || !vsync_out)
+    return -EINVAL;
+
+  return reader->vsync_ring.GetNewest(vsync_out) ? 0 : -EAGAIN;
+}
@@ -32,6 +32,8 @@ typedef struct DvrSurfaceState DvrSurfaceState;
 typedef struct DvrPoseClient DvrPoseClient;
 typedef struct DvrPoseDataCaptureRequest DvrPoseDataCaptureRequest;
 typedef struct DvrVSyncClient DvrVSyncClient;
+typedef struct DvrVsync DvrVsync;
+typedef struct DvrVsyncReader DvrVsyncReader;
 typedef struct DvrVirtualTouchpad DvrVirtualTouchpad;
 
 typedef struct DvrBuffer DvrBuffer;
@@ -264,6 +266,10 @@ typedef int (*DvrVSyncClientGetSchedInfoPtr)(DvrVSyncClient* client,
                                              int64_t* vsync_period_ns,
                                              int64_t* next_timestamp_ns,
                                              uint32_t* next_vsync_count);
+typedef int (*DvrVsyncReaderCreatePtr)(DvrVsyncReader** reader_out);
+typedef void (*DvrVsyncReaderDestroyPtr)(DvrVsyncReader* reader);
+typedef int (*DvrVsyncReaderGetNewestPtr)(DvrVsyncReader* reader,
+                                          DvrVsync* vsync_out);
 
 // libs/vr/libvrsensor/include/dvr/pose_client.h
 typedef DvrPoseClient* (*DvrPoseClientCreatePtr)();
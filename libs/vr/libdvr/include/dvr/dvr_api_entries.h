@@ -198,3 +198,8 @@ DVR_V1_API_ENTRY(TrackingSensorsCreate);
 DVR_V1_API_ENTRY(TrackingSensorsDestroy);
 DVR_V1_API_ENTRY(TrackingSensorsStart);
 DVR_V1_API_ENTRY(TrackingSensorsStop);
+
+// Vsync reader
+DVR_V1_API_ENTRY(VsyncReaderCreate);
+DVR_V1_API_ENTRY(VsyncReaderDestroy);
+DVR_V1_API_ENTRY(VsyncReaderGetNewest);
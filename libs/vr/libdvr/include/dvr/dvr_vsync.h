@@ -27,6 +27,24 @@ typedef struct __attribute__((packed, aligned(16))) DvrVsync {
   uint8_t padding[8];
 } DvrVsync;
 
+typedef struct DvrVsyncReader DvrVsyncReader;
+
+// Creates a reader for the vsync samples that the display service publishes
+// in a shared memory broadcast ring. Once the ring is mapped, reading a sample
+// copies it out of shared memory, without IPC or syscalls. A reader must not
+// be used from several threads at once.
+// @return 0 on success, or a negative error code.
+int dvrVsyncReaderCreate(DvrVsyncReader** reader_out);
+
+// Destroys a vsync reader.
+void dvrVsyncReaderDestroy(DvrVsyncReader* reader);
+
+// Copies the newest vsync sample to vsync_out. Until the ring is mapped, calls
+// try to map it a few times per second, so this can be polled from the start.
+// @return 0 on success, -EAGAIN if no sample is available yet, or another
+//     negative error code.
+int dvrVsyncReaderGetNewest(DvrVsyncReader* reader, DvrVsync* vsync_out);
+
 __END_DECLS
 
 #endif  // ANDROID_DVR_VSYNC_H_
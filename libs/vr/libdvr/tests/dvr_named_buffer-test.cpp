@@ -3,6 +3,7 @@
 #include <dvr/dvr_config.h>
 #include <dvr/dvr_shared_buffers.h>
 #include <dvr/dvr_surface.h>
+#include <dvr/dvr_vsync.h>
 #include <system/graphics.h>
 
 #include <gtest/gtest.h>
@@ -278,6 +279,58 @@ TEST(DvrGlobalBufferTest, TestVrflingerConfigBuffer) {
   dvrBufferDestroy(setup_buffer);
 }
 
+TEST(DvrGlobalBufferTest, TestVsyncReaderGetsNewestVsync) {
+  const DvrGlobalBufferKey buffer_name = DvrGlobalBuffers::kVsyncBuffer;
+
+  // Recreate the buffer so that only this test publishes to it.
+  dvrDeleteGlobalBuffer(buffer_name);
+
+  const uint64_t usage = AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN |
+                         AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN;
+  const size_t size = DvrVsyncRing::MemorySize();
+
+  DvrBuffer* setup_buffer = nullptr;
+  int e1 = dvrSetupGlobalBuffer(buffer_name, size, usage, &setup_buffer);
+  ASSERT_NE(nullptr, setup_buffer);
+  ASSERT_EQ(0, e1);
+
+  AHardwareBuffer* hardware_buffer = nullptr;
+  int e2 = dvrBufferGetAHardwareBuffer(setup_buffer, &hardware_buffer);
+  ASSERT_EQ(0, e2);
+  ASSERT_NE(nullptr, hardware_buffer);
+
+  void* buffer;
+  int e3 = AHardwareBuffer_lock(hardware_buffer, usage, -1, nullptr, &buffer);
+  ASSERT_EQ(0, e3);
+  ASSERT_NE(nullptr, buffer);
+
+  DvrVsyncRing ring = DvrVsyncRing::Create(buffer, size);
+  for (uint32_t vsync_count = 1; vsync_count <= 3; ++vsync_count) {
+    DvrVsync vsync = {};
+    vsync.vsync_count = vsync_count;
+    vsync.vsync_period_ns = 16666667;
+    ring.Put(vsync);
+  }
+
+  DvrVsyncReader* reader = nullptr;
+  ASSERT_EQ(0, dvrVsyncReaderCreate(&reader));
+  ASSERT_NE(nullptr, reader);
+
+  DvrVsync newest = {};
+  EXPECT_EQ(0, dvrVsyncReaderGetNewest(reader, &newest));
+  EXPECT_EQ(3U, newest.vsync_count);
+  EXPECT_EQ(16666667U, newest.vsync_period_ns);
+
+  dvrVsyncReaderDestroy(reader);
+
+  int32_t fence = -1;
+  int e4 = AHardwareBuffer_unlock(hardware_buffer, &fence);
+  ASSERT_EQ(0, e4);
+
+  dvrBufferDestroy(setup_buffer);
+  AHardwareBuffer_release(hardware_buffer);
+}
+
 }  // namespace
 
 }  // namespace dvr
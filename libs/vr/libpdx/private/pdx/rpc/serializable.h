@@ -90,8 +90,15 @@ struct SerializableMembersType {
 template <typename T>
 class SerializableTraits {
  public:
+  // Serialized size of every value of type T, or 0 if it depends on the value.
+  static constexpr std::size_t kFixedSerializedSize =
+      GetFixedArraySize(T::SerializableMembers::MemberCount,
+                        GetFixedMembersSize<typename T::SerializableMembers>());
+
   // Gets the serialized size of type T.
   static std::size_t GetSerializedSize(const T& value) {
+    if (kFixedSerializedSize != 0)
+      return kFixedSerializedSize;
     return GetEncodingSize(EncodeArrayType(SerializableMembers::MemberCount)) +
            GetMembersSize<SerializableMembers>(value);
   }
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <initializer_list>
 #include <iterator>
 #include <map>
 #include <numeric>
@@ -245,6 +246,100 @@ inline EnableIfEnum<T, std::size_t> GetSerializedSize(T v) {
   return GetSerializedSize(static_cast<std::underlying_type_t<T>>(v));
 }
 
+// Serialized size of every value of type T, or 0 when the size depends on the
+// value. Integers are encoded in as few bytes as their value allows and so
+// don't have a fixed size, but floating point numbers, bools, handles and
+// aggregates of these do. Arrays and maps of such types are sized from their
+// length instead of by visiting each element.
+template <typename T, typename Enabled = void>
+struct FixedSerializedSize : std::integral_constant<std::size_t, 0> {};
+
+// Returns the sum of the given fixed sizes, or 0 if any of them is 0.
+inline constexpr std::size_t SumFixedSizes(
+    std::initializer_list<std::size_t> sizes) {
+  std::size_t sum = 0;
+  for (const std::size_t size : sizes) {
+    if (size == 0)
+      return 0;
+    sum += size;
+  }
+  return sum;
+}
+
+// Returns the sum of the fixed sizes of the given types, or 0 if any of them
+// doesn't have a fixed size.
+template <typename... T>
+inline constexpr std::size_t GetFixedSizes() {
+  return SumFixedSizes({FixedSerializedSize<T>::value...});
+}
+
+// Returns the fixed size of an array with the given element sizes, or 0.
+inline constexpr std::size_t GetFixedArraySize(std::size_t count,
+                                               std::size_t elements_size) {
+  return elements_size == 0
+             ? 0
+             : GetEncodingSize(EncodeArrayType(count)) + elements_size;
+}
+
+template <>
+struct FixedSerializedSize<bool> : std::integral_constant<std::size_t, 1> {};
+template <>
+struct FixedSerializedSize<float>
+    : std::integral_constant<std::size_t, GetEncodingSize(EncodeType(0.0f))> {};
+template <>
+struct FixedSerializedSize<double>
+    : std::integral_constant<std::size_t, GetEncodingSize(EncodeType(0.0))> {};
+template <typename T>
+struct FixedSerializedSize<T, EnableIfEnum<T>>
+    : FixedSerializedSize<std::underlying_type_t<T>> {};
+template <FileHandleMode Mode>
+struct FixedSerializedSize<FileHandle<Mode>>
+    : std::integral_constant<std::size_t,
+                             GetEncodingSize(ENCODING_TYPE_FIXEXT2) +
+                                 sizeof(std::int16_t)> {};
+template <ChannelHandleMode Mode>
+struct FixedSerializedSize<ChannelHandle<Mode>>
+    : std::integral_constant<std::size_t,
+                             GetEncodingSize(ENCODING_TYPE_FIXEXT4) +
+                                 sizeof(std::int32_t)> {};
+template <typename T, std::size_t Size>
+struct FixedSerializedSize<std::array<T, Size>>
+    : std::integral_constant<
+          std::size_t,
+          GetFixedArraySize(Size, Size * FixedSerializedSize<T>::value)> {};
+template <typename T, typename U>
+struct FixedSerializedSize<std::pair<T, U>>
+    : std::integral_constant<std::size_t,
+                             GetFixedArraySize(2, GetFixedSizes<T, U>())> {};
+template <typename... T>
+struct FixedSerializedSize<std::tuple<T...>>
+    : std::integral_constant<std::size_t, GetFixedArraySize(
+                                              sizeof...(T),
+                                              GetFixedSizes<T...>())> {};
+template <typename T>
+struct FixedSerializedSize<T, EnableIfHasSerializableMembers<T>>
+    : std::integral_constant<std::size_t,
+                             SerializableTraits<T>::kFixedSerializedSize> {};
+
+// Type of a member described by a SerializableMembersType type.
+template <typename Members, std::size_t index>
+using MemberValueType = std::decay_t<decltype(
+    Members::template At<index>::Resolve(
+        std::declval<const typename Members::Type&>()))>;
+
+// Gets the fixed size of the members of a Serializable type, or 0 if the size
+// of any of them depends on its value.
+template <typename Members, std::size_t... index>
+inline constexpr std::size_t GetFixedMembersSize(
+    std::index_sequence<index...>) {
+  return GetFixedSizes<MemberValueType<Members, index>...>();
+}
+template <typename Members>
+inline constexpr std::size_t GetFixedMembersSize() {
+  return GetFixedMembersSize<Members>(
+      std::make_index_sequence<Members::MemberCount>());
+}
+
 // Forward declaration for nested definitions.
 inline std::size_t GetSerializedSize(const EmptyVariant&);
 template <typename... Types>
@@ -346,6 +441,9 @@ inline constexpr std::size_t GetSerializedSize(
 // Overload for standard vector types.
 template <typename T, typename Allocator>
 inline std::size_t GetSerializedSize(const std::vector<T, Allocator>& v) {
+  if (FixedSerializedSize<T>::value != 0)
+    return GetEncodingSize(EncodeType(v)) +
+           v.size() * FixedSerializedSize<T>::value;
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -356,6 +454,10 @@ inline std::size_t GetSerializedSize(const std::vector<T, Allocator>& v) {
 template <typename Key, typename T, typename Compare, typename Allocator>
 inline std::size_t GetSerializedSize(
     const std::map<Key, T, Compare, Allocator>& v) {
+  constexpr std::size_t kFixedEntrySize = SumFixedSizes(
+      {FixedSerializedSize<Key>::value, FixedSerializedSize<T>::value});
+  if (kFixedEntrySize != 0)
+    return GetEncodingSize(EncodeType(v)) + v.size() * kFixedEntrySize;
   return std::accumulate(
       v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
       [](const std::size_t& sum, const std::pair<Key, T>& object) {
@@ -369,6 +471,10 @@ template <typename Key, typename T, typename Hash, typename KeyEqual,
           typename Allocator>
 inline std::size_t GetSerializedSize(
     const std::unordered_map<Key, T, Hash, KeyEqual, Allocator>& v) {
+  constexpr std::size_t kFixedEntrySize = SumFixedSizes(
+      {FixedSerializedSize<Key>::value, FixedSerializedSize<T>::value});
+  if (kFixedEntrySize != 0)
+    return GetEncodingSize(EncodeType(v)) + v.size() * kFixedEntrySize;
   return std::accumulate(
       v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
       [](const std::size_t& sum, const std::pair<Key, T>& object) {
@@ -380,6 +486,9 @@ inline std::size_t GetSerializedSize(
 // Overload for ArrayWrapper types.
 template <typename T>
 inline std::size_t GetSerializedSize(const ArrayWrapper<T>& v) {
+  if (FixedSerializedSize<T>::value != 0)
+    return GetEncodingSize(EncodeType(v)) +
+           v.size() * FixedSerializedSize<T>::value;
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -389,6 +498,8 @@ inline std::size_t GetSerializedSize(const ArrayWrapper<T>& v) {
 // Overload for std::array types.
 template <typename T, std::size_t Size>
 inline std::size_t GetSerializedSize(const std::array<T, Size>& v) {
+  if (FixedSerializedSize<std::array<T, Size>>::value != 0)
+    return FixedSerializedSize<std::array<T, Size>>::value;
   return std::accumulate(v.begin(), v.end(), GetEncodingSize(EncodeType(v)),
                          [](const std::size_t& sum, const T& object) {
                            return sum + GetSerializedSize(object);
@@ -398,6 +509,8 @@ inline std::size_t GetSerializedSize(const std::array<T, Size>& v) {
 // Overload for std::pair.
 template <typename T, typename U>
 inline std::size_t GetSerializedSize(const std::pair<T, U>& p) {
+  if (FixedSerializedSize<std::pair<T, U>>::value != 0)
+    return FixedSerializedSize<std::pair<T, U>>::value;
   return GetEncodingSize(EncodeType(p)) + GetSerializedSize(p.first) +
          GetSerializedSize(p.second);
 }
@@ -419,6 +532,8 @@ inline std::size_t GetTupleSize(const std::tuple<T...>& tuple, Index<index>) {
 // through the elements.
 template <typename... T>
 inline std::size_t GetSerializedSize(const std::tuple<T...>& tuple) {
+  if (FixedSerializedSize<std::tuple<T...>>::value != 0)
+    return FixedSerializedSize<std::tuple<T...>>::value;
   return GetEncodingSize(EncodeType(tuple)) +
          GetTupleSize(tuple, Index<sizeof...(T)>());
 }
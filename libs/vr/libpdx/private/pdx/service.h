@@ -624,6 +624,13 @@ class Service : public std::enable_shared_from_this<Service> {
    */
   Status<void> ReceiveAndDispatch();
 
+  /*
+   * Dispatches a message received on this Service instance's endpoint to the
+   * handler of the service it targets. ReceiveAndDispatch() receives a message
+   * and calls this.
+   */
+  Status<void> Dispatch(Message& message);
+
  private:
   friend class Message;
 
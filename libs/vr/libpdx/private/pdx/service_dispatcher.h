@@ -8,6 +8,8 @@
 
 #include <pdx/file_handle.h>
 
+struct epoll_event;
+
 namespace android {
 namespace pdx {
 
@@ -87,6 +89,14 @@ class ServiceDispatcher {
   int ThreadEnter();
   void ThreadExit();
 
+  // Receives a message for a service that the epoll set reported as ready,
+  // re-arms its entry in the set and dispatches the message.
+  void ReceiveAndDispatchService(Service* service);
+
+  // Handles the events returned by the epoll set. Returns false if the
+  // dispatcher was canceled.
+  bool DispatchEvents(const epoll_event* events, int count);
+
   std::mutex mutex_;
   std::condition_variable condition_;
   std::atomic<bool> canceled_{false};
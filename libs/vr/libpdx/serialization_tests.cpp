@@ -80,6 +80,18 @@ struct TestTemplateType {
   PDX_SERIALIZABLE_MEMBERS(TestTemplateType<FileHandleType>, fd);
 };
 
+struct TestFixedType {
+  float a;
+  double b;
+  bool c;
+
+  TestFixedType() {}
+  TestFixedType(float a, double b, bool c) : a(a), b(b), c(c) {}
+
+ private:
+  PDX_SERIALIZABLE_MEMBERS(TestFixedType, a, b, c);
+};
+
 // Utilities to generate test maps and payloads.
 template <typename MapType>
 MapType MakeMap(std::size_t size) {
@@ -1233,6 +1245,52 @@ TEST(SerializationTest, Serializable) {
   EXPECT_EQ(expected, result);
 }
 
+TEST(SerializationTest, FixedSize) {
+  static_assert(FixedSerializedSize<bool>::value == 1, "");
+  static_assert(FixedSerializedSize<float>::value == 5, "");
+  static_assert(FixedSerializedSize<double>::value == 9, "");
+  static_assert(FixedSerializedSize<int>::value == 0, "");
+  static_assert(FixedSerializedSize<std::string>::value == 0, "");
+  static_assert(FixedSerializedSize<std::pair<float, bool>>::value == 7, "");
+  static_assert(FixedSerializedSize<std::pair<float, int>>::value == 0, "");
+  static_assert(FixedSerializedSize<std::tuple<double, LocalHandle>>::value ==
+                    14,
+                "");
+  static_assert(FixedSerializedSize<std::array<float, 16>>::value == 83, "");
+  static_assert(FixedSerializedSize<TestFixedType>::value == 16, "");
+  static_assert(FixedSerializedSize<TestType>::value == 0, "");
+
+  Payload result;
+
+  // The fixed sizes must match the sizes of the encodings.
+  std::vector<float> floats((1 << 4), 1.0f);
+  EXPECT_EQ(3u + (1 << 4) * 5u, GetSerializedSize(floats));
+  Serialize(floats, &result);
+  EXPECT_EQ(GetSerializedSize(floats), result.Size());
+  result.Clear();
+
+  std::map<float, bool> map = {{0.0f, true}, {1.0f, false}};
+  EXPECT_EQ(1u + 2 * 6u, GetSerializedSize(map));
+  Serialize(map, &result);
+  EXPECT_EQ(GetSerializedSize(map), result.Size());
+  result.Clear();
+
+  std::array<double, 3> array = {{0.0, 1.0, 2.0}};
+  Serialize(array, &result);
+  EXPECT_EQ(GetSerializedSize(array), result.Size());
+  result.Clear();
+
+  std::vector<TestFixedType> structs(3, TestFixedType{1.0f, 2.0, true});
+  EXPECT_EQ(1u + 3 * 16u, GetSerializedSize(structs));
+  Serialize(structs, &result);
+  EXPECT_EQ(GetSerializedSize(structs), result.Size());
+  result.Clear();
+
+  auto tuple = std::make_tuple(0.0f, std::make_pair(1.0, false));
+  Serialize(tuple, &result);
+  EXPECT_EQ(GetSerializedSize(tuple), result.Size());
+}
+
 TEST(SerializationTest, Variant) {
   Payload result;
   Payload expected;
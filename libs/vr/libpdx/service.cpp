@@ -650,6 +650,10 @@ Status<void> Service::ReceiveAndDispatch() {
     return status;
   }
 
+  return Dispatch(message);
+}
+
+Status<void> Service::Dispatch(Message& message) {
   std::shared_ptr<Service> service = message.GetService();
 
   if (!service) {
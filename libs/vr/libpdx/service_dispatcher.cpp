@@ -71,8 +71,11 @@ void ServiceDispatcher::ThreadExit() {
 int ServiceDispatcher::AddService(const std::shared_ptr<Service>& service) {
   std::lock_guard<std::mutex> autolock(mutex_);
 
+  // Services are one-shot entries: an endpoint stays readable until its
+  // message has been received, and a level-triggered entry would wake every
+  // dispatch thread for it, all but one of them to find nothing to receive.
   epoll_event event;
-  event.events = EPOLLIN;
+  event.events = EPOLLIN | EPOLLONESHOT;
   event.data.ptr = service.get();
 
   if (epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_ADD, service->endpoint()->epoll_fd(),
@@ -105,6 +108,44 @@ int ServiceDispatcher::RemoveService(const std::shared_ptr<Service>& service) {
   return 0;
 }
 
+void ServiceDispatcher::ReceiveAndDispatchService(Service* service) {
+  ALOGI_IF(TRACE, "Dispatching message: fd=%d\n",
+           service->endpoint()->epoll_fd());
+
+  Message message;
+  const auto status = service->endpoint()->MessageReceive(&message);
+
+  // Re-arm the service before dispatching the message, so that other threads
+  // can receive its next messages in the meantime.
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.ptr = service;
+  if (epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_MOD, service->endpoint()->epoll_fd(),
+                &event) < 0) {
+    ALOGE("Failed to re-arm service because: %s\n", strerror(errno));
+  }
+
+  if (!status) {
+    ALOGE_IF(status.error() != ETIMEDOUT, "Failed to receive message: %s\n",
+             status.GetErrorMessage().c_str());
+    return;
+  }
+  service->Dispatch(message);
+}
+
+bool ServiceDispatcher::DispatchEvents(const epoll_event* events, int count) {
+  // Every service event has to be handled even when the dispatcher is being
+  // canceled, as its entry is only re-armed once its message is received.
+  bool canceled = false;
+  for (int i = 0; i < count; i++) {
+    if (events[i].data.ptr == this)
+      canceled = true;
+    else
+      ReceiveAndDispatchService(static_cast<Service*>(events[i].data.ptr));
+  }
+  return !canceled;
+}
+
 int ServiceDispatcher::ReceiveAndDispatch() { return ReceiveAndDispatch(-1); }
 
 int ServiceDispatcher::ReceiveAndDispatch(int timeout) {
@@ -122,17 +163,9 @@ int ServiceDispatcher::ReceiveAndDispatch(int timeout) {
     return count < 0 ? -errno : -ETIMEDOUT;
   }
 
-  for (int i = 0; i < count; i++) {
-    if (events[i].data.ptr == this) {
-      ThreadExit();
-      return -EBUSY;
-    } else {
-      Service* service = static_cast<Service*>(events[i].data.ptr);
-
-      ALOGI_IF(TRACE, "Dispatching message: fd=%d\n",
-               service->endpoint()->epoll_fd());
-      service->ReceiveAndDispatch();
-    }
+  if (!DispatchEvents(events, count)) {
+    ThreadExit();
+    return -EBUSY;
   }
 
   ThreadExit();
@@ -154,17 +187,9 @@ int ServiceDispatcher::EnterDispatchLoop() {
       return -errno;
     }
 
-    for (int i = 0; i < count; i++) {
-      if (events[i].data.ptr == this) {
-        ThreadExit();
-        return -EBUSY;
-      } else {
-        Service* service = static_cast<Service*>(events[i].data.ptr);
-
-        ALOGI_IF(TRACE, "Dispatching message: fd=%d\n",
-                 service->endpoint()->epoll_fd());
-        service->ReceiveAndDispatch();
-      }
+    if (!DispatchEvents(events, count)) {
+      ThreadExit();
+      return -EBUSY;
     }
   }
 
@@ -14,8 +14,11 @@ AcquiredBuffer::AcquiredBuffer(const std::shared_ptr<ConsumerBuffer>& buffer,
 
 AcquiredBuffer::AcquiredBuffer(const std::shared_ptr<ConsumerBuffer>& buffer,
                                int* error) {
+  // The buffer state and acquire fence are in shared memory, so only a
+  // one-way message to bufferhubd is needed instead of a round trip.
   LocalHandle fence;
-  const int ret = buffer->Acquire(&fence);
+  DvrNativeBufferMetadata meta;
+  const int ret = buffer->AcquireAsync(&meta, &fence);
 
   if (error)
     *error = ret;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <functional>
 #include <map>
 #include <sstream>
@@ -50,6 +51,10 @@ const char kDvrPerformanceProperty[] = "sys.dvr.performance";
 
 const char kRightEyeOffsetProperty[] = "dvr.right_eye_offset_ns";
 
+// When positive, buffers are latched this long before the display time on top
+// of the estimated post time, instead of at the configured frame post offset.
+const char kLateLatchMarginProperty[] = "dvr.late_latch_margin_ns";
+
 // Surface flinger uses "VSYNC-sf" and "VSYNC-app" for its version of these
 // events. Name ours similarly.
 const char kVsyncTraceEventName[] = "VSYNC-vrflinger";
@@ -466,6 +471,18 @@ std::string HardwareComposer::Dump() {
 
   stream << "Post thread resumed: " << post_thread_resumed_ << std::endl;
   stream << "Active layers:       " << layers_.size() << std::endl;
+  stream << "Late latching:       "
+         << (late_latch_margin_ns_ > 0 ? "enabled" : "disabled") << std::endl;
+  stream << "Presented frames:    " << latch_stats_.frame_count << " ("
+         << latch_stats_.late_frame_count << " late)" << std::endl;
+  if (latch_stats_.frame_count > 0) {
+    stream << "Latch to scanout:    last="
+           << latch_stats_.last_latch_to_scanout_ns
+           << "ns min=" << latch_stats_.min_latch_to_scanout_ns << "ns avg="
+           << latch_stats_.total_latch_to_scanout_ns /
+                  static_cast<int64_t>(latch_stats_.frame_count)
+           << "ns" << std::endl;
+  }
   stream << std::endl;
 
   for (size_t i = 0; i < layers_.size(); i++) {
@@ -485,7 +502,7 @@ std::string HardwareComposer::Dump() {
   return stream.str();
 }
 
-void HardwareComposer::PostLayers(hwc2_display_t display) {
+bool HardwareComposer::PostLayers(hwc2_display_t display) {
   ATRACE_NAME("HardwareComposer::PostLayers");
 
   // Setup the hardware composer layers with current buffers.
@@ -518,7 +535,7 @@ void HardwareComposer::PostLayers(hwc2_display_t display) {
     for (auto& layer : layers_) {
       layer.Drop();
     }
-    return;
+    return false;
   } else {
     // Make the transition more obvious in systrace when the frame skip happens
     // above.
@@ -537,14 +554,14 @@ void HardwareComposer::PostLayers(hwc2_display_t display) {
   if (error != HWC::Error::None) {
     ALOGE("HardwareComposer::PostLayers: Validate failed: %s display=%" PRIu64,
           error.to_string().c_str(), display);
-    return;
+    return false;
   }
 
   error = Present(display);
   if (error != HWC::Error::None) {
     ALOGE("HardwareComposer::PostLayers: Present failed: %s",
           error.to_string().c_str());
-    return;
+    return false;
   }
 
   std::vector<Hwc2::Layer> out_layers;
@@ -564,6 +581,49 @@ void HardwareComposer::PostLayers(hwc2_display_t display) {
       }
     }
   }
+  return true;
+}
+
+int64_t HardwareComposer::GetFramePostOffsetNs() const {
+  const int64_t config_offset_ns = post_thread_config_.frame_post_offset_ns;
+  if (late_latch_margin_ns_ <= 0 || post_time_mean_ns_ == 0)
+    return config_offset_ns;
+
+  const int64_t estimated_offset_ns =
+      post_time_mean_ns_ + 4 * post_time_deviation_ns_ + late_latch_margin_ns_;
+  return std::min(config_offset_ns, estimated_offset_ns);
+}
+
+void HardwareComposer::UpdateLatchStats(int64_t latch_time_ns,
+                                        int64_t present_time_ns,
+                                        int64_t display_time_ns) {
+  // Moves the mean by 1/8 and the deviation by 1/4 of the difference, as TCP
+  // does for round-trip times.
+  const int64_t post_time_ns = present_time_ns - latch_time_ns;
+  if (post_time_mean_ns_ == 0) {
+    post_time_mean_ns_ = post_time_ns;
+    post_time_deviation_ns_ = post_time_ns / 2;
+  } else {
+    const int64_t difference_ns = post_time_ns - post_time_mean_ns_;
+    post_time_mean_ns_ += difference_ns / 8;
+    post_time_deviation_ns_ +=
+        (std::abs(difference_ns) - post_time_deviation_ns_) / 4;
+  }
+  ATRACE_INT64("post_time_estimate_ns", post_time_mean_ns_);
+
+  const int64_t latch_to_scanout_ns = display_time_ns - latch_time_ns;
+  ATRACE_INT64("latch_to_scanout_ns", latch_to_scanout_ns);
+
+  std::lock_guard<std::mutex> lock(post_thread_mutex_);
+  latch_stats_.last_latch_to_scanout_ns = latch_to_scanout_ns;
+  latch_stats_.min_latch_to_scanout_ns =
+      latch_stats_.frame_count == 0
+          ? latch_to_scanout_ns
+          : std::min(latch_stats_.min_latch_to_scanout_ns, latch_to_scanout_ns);
+  latch_stats_.total_latch_to_scanout_ns += latch_to_scanout_ns;
+  latch_stats_.frame_count++;
+  if (present_time_ns > display_time_ns)
+    latch_stats_.late_frame_count++;
 }
 
 void HardwareComposer::SetDisplaySurfaces(
@@ -761,6 +821,7 @@ void HardwareComposer::PostThread() {
   };
 
   VsyncEyeOffsets vsync_eye_offsets = get_vsync_eye_offsets();
+  late_latch_margin_ns_ = property_get_int64(kLateLatchMarginProperty, 0);
 
   while (1) {
     ATRACE_NAME("HardwareComposer::PostThread");
@@ -825,6 +886,12 @@ void HardwareComposer::PostThread() {
       last_vsync_timestamp_ = GetSystemClockNs();
       vsync_prediction_interval_ = 1;
       retire_fence_fds_.clear();
+
+      // The post time may differ on another display or after a pause.
+      post_time_mean_ns_ = 0;
+      post_time_deviation_ns_ = 0;
+      std::lock_guard<std::mutex> lock(post_thread_mutex_);
+      latch_stats_ = {};
     }
 
     int64_t vsync_timestamp = 0;
@@ -872,17 +939,18 @@ void HardwareComposer::PostThread() {
       vsync_ring_->Publish(vsync);
     }
 
+    const int64_t display_time_est_ns =
+        vsync_timestamp + target_display_->vsync_period_ns;
     {
       // Sleep until shortly before vsync.
       ATRACE_NAME("sleep");
 
-      const int64_t display_time_est_ns =
-          vsync_timestamp + target_display_->vsync_period_ns;
+      const int64_t frame_post_offset_ns = GetFramePostOffsetNs();
+      ATRACE_INT64("frame_post_offset_ns", frame_post_offset_ns);
       const int64_t now_ns = GetSystemClockNs();
-      const int64_t sleep_time_ns = display_time_est_ns - now_ns -
-                                    post_thread_config_.frame_post_offset_ns;
-      const int64_t wakeup_time_ns =
-          display_time_est_ns - post_thread_config_.frame_post_offset_ns;
+      const int64_t sleep_time_ns =
+          display_time_est_ns - now_ns - frame_post_offset_ns;
+      const int64_t wakeup_time_ns = display_time_est_ns - frame_post_offset_ns;
 
       ATRACE_INT64("sleep_time_ns", sleep_time_ns);
       if (sleep_time_ns > 0) {
@@ -897,6 +965,8 @@ void HardwareComposer::PostThread() {
       }
     }
 
+    // The buffers are latched right after waking up.
+    const int64_t latch_time_ns = GetSystemClockNs();
     {
       auto status = composer_callback_->GetVsyncTime(target_display_->id);
 
@@ -925,7 +995,9 @@ void HardwareComposer::PostThread() {
       }
     }
 
-    PostLayers(target_display_->id);
+    if (PostLayers(target_display_->id)) {
+      UpdateLatchStats(latch_time_ns, GetSystemClockNs(), display_time_est_ns);
+    }
   }
 }
 
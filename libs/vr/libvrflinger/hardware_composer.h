@@ -416,9 +416,22 @@ class HardwareComposer {
   HWC::Error Validate(hwc2_display_t display);
   HWC::Error Present(hwc2_display_t display);
 
-  void PostLayers(hwc2_display_t display);
+  // Returns true if the frame was presented, or false if it was dropped or
+  // failed.
+  bool PostLayers(hwc2_display_t display);
   void PostThread();
 
+  // Returns how long before the next display time the post thread wakes to
+  // latch buffers. With late latching, this is as late as the estimated post
+  // time allows, but never earlier than the configured frame_post_offset_ns.
+  int64_t GetFramePostOffsetNs() const;
+
+  // Records the timing of a frame that PostLayers presented, latched at
+  // latch_time_ns for display at display_time_ns, with Present returning at
+  // present_time_ns. Called only from the post thread.
+  void UpdateLatchStats(int64_t latch_time_ns, int64_t present_time_ns,
+                        int64_t display_time_ns);
+
   // The post thread has two controlling states:
   // 1. Idle: no work to do (no visible surfaces).
   // 2. Suspended: explicitly halted (system is not in VR mode).
@@ -543,6 +556,29 @@ class HardwareComposer {
   // Counter tracking the number of skipped frames.
   int frame_skip_count_ = 0;
 
+  // Margin on top of the estimated post time that late latching leaves before
+  // the display time, from kLateLatchMarginProperty. Late latching is off when
+  // it is not positive.
+  int64_t late_latch_margin_ns_ = 0;
+
+  // Smoothed time from latching buffers until Present returns, and its mean
+  // deviation, estimated like round-trip times in TCP. Zero until the first
+  // frame is presented. Only accessed from the post thread.
+  int64_t post_time_mean_ns_ = 0;
+  int64_t post_time_deviation_ns_ = 0;
+
+  // Timing of the presented frames since the post thread last resumed,
+  // reported by Dump. Protected by post_thread_mutex_.
+  struct LatchStats {
+    uint64_t frame_count = 0;
+    // Frames for which Present returned after the display time.
+    uint64_t late_frame_count = 0;
+    int64_t last_latch_to_scanout_ns = 0;
+    int64_t min_latch_to_scanout_ns = 0;
+    int64_t total_latch_to_scanout_ns = 0;
+  };
+  LatchStats latch_stats_;
+
   // Fd array for tracking retire fences that are returned by hwc. This allows
   // us to detect when the display driver begins queuing frames.
   std::vector<pdx::LocalHandle> retire_fence_fds_;
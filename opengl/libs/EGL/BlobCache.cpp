@@ -22,8 +22,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <log/log.h>
-
-#include <chrono>
+#include <string.h>
 
 namespace android {
 
@@ -36,23 +35,28 @@ static const uint32_t blobCacheVersion = 3;
 // BlobCache::Header::mDeviceVersion value
 static const uint32_t blobCacheDeviceVersion = 1;
 
+// keyOf returns the mCacheIndex key for the given key data.
+static inline std::string_view keyOf(const void* data, size_t size) {
+    return std::string_view(static_cast<const char*>(data), size);
+}
+
 BlobCache::BlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize)
       : mMaxTotalSize(maxTotalSize),
         mMaxKeySize(maxKeySize),
         mMaxValueSize(maxValueSize),
-        mTotalSize(0) {
-    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
-#ifdef _WIN32
-    srand(now);
-#else
-    mRandState[0] = (now >> 0) & 0xFFFF;
-    mRandState[1] = (now >> 16) & 0xFFFF;
-    mRandState[2] = (now >> 32) & 0xFFFF;
-#endif
-    ALOGV("initializing random seed using %lld", (unsigned long long)now);
-}
+        mTotalSize(0) {}
 
 void BlobCache::set(const void* key, size_t keySize, const void* value, size_t valueSize) {
+    setInternal(key, keySize, value, valueSize, true);
+}
+
+void BlobCache::setReference(const void* key, size_t keySize, const void* value,
+                             size_t valueSize) {
+    setInternal(key, keySize, value, valueSize, false);
+}
+
+void BlobCache::setInternal(const void* key, size_t keySize, const void* value, size_t valueSize,
+                            bool copyData) {
     if (mMaxKeySize < keySize) {
         ALOGV("set: not caching because the key is too large: %zu (limit: %zu)", keySize,
               mMaxKeySize);
@@ -78,57 +82,32 @@ void BlobCache::set(const void* key, size_t keySize, const void* value, size_t v
         return;
     }
 
-    std::shared_ptr<Blob> cacheKey(new Blob(key, keySize, false));
-    CacheEntry cacheEntry(cacheKey, nullptr);
-
-    while (true) {
-        auto index = std::lower_bound(mCacheEntries.begin(), mCacheEntries.end(), cacheEntry);
-        if (index == mCacheEntries.end() || cacheEntry < *index) {
-            // Create a new cache entry.
-            std::shared_ptr<Blob> keyBlob(new Blob(key, keySize, true));
-            std::shared_ptr<Blob> valueBlob(new Blob(value, valueSize, true));
-            size_t newTotalSize = mTotalSize + keySize + valueSize;
-            if (mMaxTotalSize < newTotalSize) {
-                if (isCleanable()) {
-                    // Clean the cache and try again.
-                    clean();
-                    continue;
-                } else {
-                    ALOGV("set: not caching new key/value pair because the "
-                          "total cache size limit would be exceeded: %zu "
-                          "(limit: %zu)",
-                          keySize + valueSize, mMaxTotalSize);
-                    break;
-                }
-            }
-            mCacheEntries.insert(index, CacheEntry(keyBlob, valueBlob));
-            mTotalSize = newTotalSize;
-            ALOGV("set: created new cache entry with %zu byte key and %zu byte value", keySize,
-                  valueSize);
-        } else {
-            // Update the existing cache entry.
-            std::shared_ptr<Blob> valueBlob(new Blob(value, valueSize, true));
-            std::shared_ptr<Blob> oldValueBlob(index->getValue());
-            size_t newTotalSize = mTotalSize + valueSize - oldValueBlob->getSize();
-            if (mMaxTotalSize < newTotalSize) {
-                if (isCleanable()) {
-                    // Clean the cache and try again.
-                    clean();
-                    continue;
-                } else {
-                    ALOGV("set: not caching new value because the total cache "
-                          "size limit would be exceeded: %zu (limit: %zu)",
-                          keySize + valueSize, mMaxTotalSize);
-                    break;
-                }
-            }
-            index->setValue(valueBlob);
-            mTotalSize = newTotalSize;
-            ALOGV("set: updated existing cache entry with %zu byte key and %zu byte "
-                  "value",
-                  keySize, valueSize);
-        }
-        break;
+    auto index = mCacheIndex.find(keyOf(key, keySize));
+    if (index == mCacheIndex.end()) {
+        // Create a new cache entry, evicting the least recently used entries
+        // until it fits.
+        evict(mMaxTotalSize - (keySize + valueSize));
+        std::shared_ptr<Blob> keyBlob(new Blob(key, keySize, copyData));
+        std::shared_ptr<Blob> valueBlob(new Blob(value, valueSize, copyData));
+        auto entry = mCacheEntries.emplace(mCacheEntries.end(), keyBlob, valueBlob);
+        entry->setPersisted(!copyData);
+        mCacheIndex.emplace(keyOf(keyBlob->getData(), keySize), entry);
+        mTotalSize += keySize + valueSize;
+        ALOGV("set: created new cache entry with %zu byte key and %zu byte value", keySize,
+              valueSize);
+    } else {
+        // Update the existing cache entry.  It is made the most recently used
+        // one first, so that making room for the new value never evicts it.
+        auto entry = index->second;
+        mCacheEntries.splice(mCacheEntries.end(), mCacheEntries, entry);
+        size_t oldValueSize = entry->getValue()->getSize();
+        evict(mMaxTotalSize + oldValueSize - valueSize);
+        entry->setValue(std::shared_ptr<Blob>(new Blob(value, valueSize, copyData)));
+        entry->setPersisted(!copyData);
+        mTotalSize += valueSize - oldValueSize;
+        ALOGV("set: updated existing cache entry with %zu byte key and %zu byte "
+              "value",
+              keySize, valueSize);
     }
 }
 
@@ -138,17 +117,19 @@ size_t BlobCache::get(const void* key, size_t keySize, void* value, size_t value
               mMaxKeySize);
         return 0;
     }
-    std::shared_ptr<Blob> cacheKey(new Blob(key, keySize, false));
-    CacheEntry cacheEntry(cacheKey, nullptr);
-    auto index = std::lower_bound(mCacheEntries.begin(), mCacheEntries.end(), cacheEntry);
-    if (index == mCacheEntries.end() || cacheEntry < *index) {
+    auto index = mCacheIndex.find(keyOf(key, keySize));
+    if (index == mCacheIndex.end()) {
         ALOGV("get: no cache entry found for key of size %zu", keySize);
+        mStats.misses++;
         return 0;
     }
 
-    // The key was found. Return the value if the caller's buffer is large
-    // enough.
-    std::shared_ptr<Blob> valueBlob(index->getValue());
+    // The key was found. Make it the most recently used entry and return the
+    // value if the caller's buffer is large enough.
+    auto entry = index->second;
+    mCacheEntries.splice(mCacheEntries.end(), mCacheEntries, entry);
+    mStats.hits++;
+    std::shared_ptr<Blob> valueBlob(entry->getValue());
     size_t valueBlobSize = valueBlob->getSize();
     if (valueBlobSize <= valueSize) {
         ALOGV("get: copying %zu bytes to caller's buffer", valueBlobSize);
@@ -227,7 +208,7 @@ int BlobCache::flatten(void* buffer, size_t size) const {
 
 int BlobCache::unflatten(void const* buffer, size_t size) {
     // All errors should result in the BlobCache being in an empty state.
-    mCacheEntries.clear();
+    clear();
 
     // Read the cache header
     if (size < sizeof(Header)) {
@@ -254,7 +235,7 @@ int BlobCache::unflatten(void const* buffer, size_t size) {
     size_t numEntries = header->mNumEntries;
     for (size_t i = 0; i < numEntries; i++) {
         if (byteOffset + sizeof(EntryHeader) > size) {
-            mCacheEntries.clear();
+            clear();
             ALOGE("unflatten: not enough room for cache entry headers");
             return -EINVAL;
         }
@@ -266,7 +247,7 @@ int BlobCache::unflatten(void const* buffer, size_t size) {
 
         size_t totalSize = align4(entrySize);
         if (byteOffset + totalSize > size) {
-            mCacheEntries.clear();
+            clear();
             ALOGE("unflatten: not enough room for cache entry headers");
             return -EINVAL;
         }
@@ -280,27 +261,27 @@ int BlobCache::unflatten(void const* buffer, size_t size) {
     return 0;
 }
 
-long int BlobCache::blob_random() {
-#ifdef _WIN32
-    return rand();
-#else
-    return nrand48(mRandState);
-#endif
+void BlobCache::clear() {
+    mCacheIndex.clear();
+    mCacheEntries.clear();
+    mTotalSize = 0;
 }
 
-void BlobCache::clean() {
-    // Remove a random cache entry until the total cache size gets below half
-    // the maximum total cache size.
-    while (mTotalSize > mMaxTotalSize / 2) {
-        size_t i = size_t(blob_random() % (mCacheEntries.size()));
-        const CacheEntry& entry(mCacheEntries[i]);
-        mTotalSize -= entry.getKey()->getSize() + entry.getValue()->getSize();
-        mCacheEntries.erase(mCacheEntries.begin() + i);
+void BlobCache::markPersisted() {
+    for (CacheEntry& e : mCacheEntries) {
+        e.setPersisted(true);
     }
 }
 
-bool BlobCache::isCleanable() const {
-    return mTotalSize > mMaxTotalSize / 2;
+void BlobCache::evict(size_t targetSize) {
+    while (mTotalSize > targetSize && !mCacheEntries.empty()) {
+        const CacheEntry& entry = mCacheEntries.front();
+        std::shared_ptr<Blob> keyBlob(entry.getKey());
+        mTotalSize -= keyBlob->getSize() + entry.getValue()->getSize();
+        mCacheIndex.erase(keyOf(keyBlob->getData(), keyBlob->getSize()));
+        mCacheEntries.pop_front();
+        mStats.evictions++;
+    }
 }
 
 BlobCache::Blob::Blob(const void* data, size_t size, bool copyData)
@@ -316,14 +297,6 @@ BlobCache::Blob::~Blob() {
     }
 }
 
-bool BlobCache::Blob::operator<(const Blob& rhs) const {
-    if (mSize == rhs.mSize) {
-        return memcmp(mData, rhs.mData, mSize) < 0;
-    } else {
-        return mSize < rhs.mSize;
-    }
-}
-
 const void* BlobCache::Blob::getData() const {
     return mData;
 }
@@ -332,21 +305,19 @@ size_t BlobCache::Blob::getSize() const {
     return mSize;
 }
 
-BlobCache::CacheEntry::CacheEntry() {}
+BlobCache::CacheEntry::CacheEntry() : mPersisted(false) {}
 
 BlobCache::CacheEntry::CacheEntry(const std::shared_ptr<Blob>& key,
                                   const std::shared_ptr<Blob>& value)
-      : mKey(key), mValue(value) {}
+      : mKey(key), mValue(value), mPersisted(false) {}
 
-BlobCache::CacheEntry::CacheEntry(const CacheEntry& ce) : mKey(ce.mKey), mValue(ce.mValue) {}
-
-bool BlobCache::CacheEntry::operator<(const CacheEntry& rhs) const {
-    return *mKey < *rhs.mKey;
-}
+BlobCache::CacheEntry::CacheEntry(const CacheEntry& ce)
+      : mKey(ce.mKey), mValue(ce.mValue), mPersisted(ce.mPersisted) {}
 
 const BlobCache::CacheEntry& BlobCache::CacheEntry::operator=(const CacheEntry& rhs) {
     mKey = rhs.mKey;
     mValue = rhs.mValue;
+    mPersisted = rhs.mPersisted;
     return *this;
 }
 
@@ -362,4 +333,12 @@ void BlobCache::CacheEntry::setValue(const std::shared_ptr<Blob>& value) {
     mValue = value;
 }
 
+bool BlobCache::CacheEntry::isPersisted() const {
+    return mPersisted;
+}
+
+void BlobCache::CacheEntry::setPersisted(bool persisted) {
+    mPersisted = persisted;
+}
+
 } // namespace android
@@ -19,14 +19,19 @@
 
 #include <stddef.h>
 
+#include <list>
 #include <memory>
-#include <vector>
+#include <string_view>
+#include <unordered_map>
 
 namespace android {
 
 // A BlobCache is an in-memory cache for binary key/value pairs.  A BlobCache
 // does NOT provide any thread-safety guarantees.
 //
+// Entries are looked up through a hash index, and when the cache is full the
+// least recently used entries are evicted until the new entry fits.
+//
 // The cache contents can be serialized to an in-memory buffer or mmap'd file
 // and then reloaded in a subsequent execution of the program.  This
 // serialization is non-portable and the data should only be used by the device
@@ -47,7 +52,8 @@ public:
     // put in the cache (based on the maxKeySize, maxValueSize, and maxTotalSize
     // values specified to the BlobCache constructor), then the key/value pair
     // will be in the cache after set returns.  Note, however, that a subsequent
-    // call to set may evict old key/value pairs from the cache.
+    // call to set may evict the least recently used key/value pairs from the
+    // cache.
     //
     // Preconditions:
     //   key != NULL
@@ -62,7 +68,8 @@ public:
     // is non-NULL and the size of the cached value is less than valueSize bytes
     // then the cached value is copied into the buffer pointed to by the value
     // argument.  If the key is not present in the cache then 0 is returned and
-    // the buffer pointed to by the value argument is not modified.
+    // the buffer pointed to by the value argument is not modified.  A key that
+    // is found becomes the most recently used one.
     //
     // Note that when calling get multiple times with the same key, the later
     // calls may fail, returning 0, even if earlier calls succeeded.  The return
@@ -81,7 +88,8 @@ public:
     // flatten serializes the current contents of the cache into the memory
     // pointed to by 'buffer'.  The serialized cache contents can later be
     // loaded into a BlobCache object using the unflatten method.  The contents
-    // of the BlobCache object will not be modified.
+    // of the BlobCache object will not be modified.  Entries are written from
+    // least to most recently used, so that unflatten restores their order.
     //
     // Preconditions:
     //   size >= this.getFlattenedSize()
@@ -97,7 +105,23 @@ public:
 
     // clear flushes out all contents of the cache then the BlobCache, leaving
     // it in an empty state.
-    void clear() { mCacheEntries.clear(); }
+    void clear();
+
+    // A Stats holds the number of lookups of the cache and of the entries it
+    // evicted since it was created.
+    struct Stats {
+        // hits is the number of calls to get that found their key.
+        size_t hits = 0;
+
+        // misses is the number of calls to get that did not find their key.
+        size_t misses = 0;
+
+        // evictions is the number of entries evicted to make room for others.
+        size_t evictions = 0;
+    };
+
+    // getStats returns the lookup and eviction counts of the cache.
+    Stats getStats() const { return mStats; }
 
 protected:
     // mMaxTotalSize is the maximum size that all cache entries can occupy. This
@@ -107,21 +131,41 @@ protected:
     // will be evicted from the cache to make room for the new entry.
     const size_t mMaxTotalSize;
 
+    // setReference behaves like set, except that the cache refers to the key
+    // and value data in place instead of copying them, and the entry is
+    // considered persisted.  The data must outlive the cache entry.
+    void setReference(const void* key, size_t keySize, const void* value, size_t valueSize);
+
+    // forEachEntry calls visitor(key, keySize, value, valueSize, persisted) for
+    // each entry in the cache, from the least to the most recently used.  An
+    // entry is persisted if its value was set by setReference, or if it has
+    // not been set again since the last call to markPersisted.
+    template <typename Visitor>
+    void forEachEntry(Visitor visitor) const {
+        for (const CacheEntry& e : mCacheEntries) {
+            const Blob& keyBlob = *e.getKey();
+            const Blob& valueBlob = *e.getValue();
+            visitor(keyBlob.getData(), keyBlob.getSize(), valueBlob.getData(),
+                    valueBlob.getSize(), e.isPersisted());
+        }
+    }
+
+    // markPersisted marks every entry in the cache as persisted.
+    void markPersisted();
+
 private:
     // Copying is disallowed.
     BlobCache(const BlobCache&);
     void operator=(const BlobCache&);
 
-    // A random function helper to get around MinGW not having nrand48()
-    long int blob_random();
-
-    // clean evicts a randomly chosen set of entries from the cache such that
-    // the total size of all remaining entries is less than mMaxTotalSize/2.
-    void clean();
+    // setInternal implements set and setReference.  The key and value data are
+    // copied into the cache if copyData is true, and referred to otherwise.
+    void setInternal(const void* key, size_t keySize, const void* value, size_t valueSize,
+                     bool copyData);
 
-    // isCleanable returns true if the cache is full enough for the clean method
-    // to have some effect, and false otherwise.
-    bool isCleanable() const;
+    // evict removes the least recently used entries from the cache until the
+    // total size of all remaining entries is at most targetSize.
+    void evict(size_t targetSize);
 
     // A Blob is an immutable sized unstructured data blob.
     class Blob {
@@ -129,8 +173,6 @@ private:
         Blob(const void* data, size_t size, bool copyData);
         ~Blob();
 
-        bool operator<(const Blob& rhs) const;
-
         const void* getData() const;
         size_t getSize() const;
 
@@ -157,7 +199,6 @@ private:
         CacheEntry(const std::shared_ptr<Blob>& key, const std::shared_ptr<Blob>& value);
         CacheEntry(const CacheEntry& ce);
 
-        bool operator<(const CacheEntry& rhs) const;
         const CacheEntry& operator=(const CacheEntry&);
 
         std::shared_ptr<Blob> getKey() const;
@@ -165,12 +206,19 @@ private:
 
         void setValue(const std::shared_ptr<Blob>& value);
 
+        bool isPersisted() const;
+        void setPersisted(bool persisted);
+
     private:
         // mKey is the key that identifies the cache entry.
         std::shared_ptr<Blob> mKey;
 
         // mValue is the cached data associated with the key.
         std::shared_ptr<Blob> mValue;
+
+        // mPersisted indicates whether mValue has been saved by the owner of
+        // the cache.
+        bool mPersisted;
     };
 
     // A Header is the header for the entire BlobCache serialization format. No
@@ -233,13 +281,17 @@ private:
     // the cache.
     size_t mTotalSize;
 
-    // mRandState is the pseudo-random number generator state. It is passed to
-    // nrand48 to generate random numbers when needed.
-    unsigned short mRandState[3];
+    // mCacheEntries stores all the cache entries that are resident in memory,
+    // from the least to the most recently used.  Cache entries are added to
+    // its end by the 'set' method and moved back there when they are accessed.
+    std::list<CacheEntry> mCacheEntries;
+
+    // mCacheIndex maps the key of each cache entry to the entry in
+    // mCacheEntries.  Its keys point into the key blobs owned by the entries.
+    std::unordered_map<std::string_view, std::list<CacheEntry>::iterator> mCacheIndex;
 
-    // mCacheEntries stores all the cache entries that are resident in memory.
-    // Cache entries are added to it by the 'set' method.
-    std::vector<CacheEntry> mCacheEntries;
+    // mStats counts the lookups and evictions of the cache.
+    Stats mStats;
 };
 
 } // namespace android
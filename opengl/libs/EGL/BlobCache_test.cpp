@@ -238,27 +238,55 @@ TEST_F(BlobCacheTest, CacheSizeDoesntExceedTotalLimit) {
     ASSERT_GE(MAX_TOTAL_SIZE / 2, numCached);
 }
 
-TEST_F(BlobCacheTest, ExceedingTotalLimitHalvesCacheSize) {
+TEST_F(BlobCacheTest, ExceedingTotalLimitEvictsLeastRecentlyUsedEntry) {
     // Fill up the entire cache with 1 char key/value pairs.
     const int maxEntries = MAX_TOTAL_SIZE / 2;
     for (int i = 0; i < maxEntries; i++) {
         uint8_t k = i;
         mBC->set(&k, 1, "x", 1);
     }
+    // Use the oldest entry, so that the second oldest is the least recently
+    // used one.
+    {
+        uint8_t k = 0;
+        ASSERT_EQ(size_t(1), mBC->get(&k, 1, nullptr, 0));
+    }
     // Insert one more entry, causing a cache overflow.
     {
         uint8_t k = maxEntries;
         mBC->set(&k, 1, "x", 1);
     }
-    // Count the number of entries in the cache.
-    int numCached = 0;
+    // Only the least recently used entry was evicted.
     for (int i = 0; i < maxEntries + 1; i++) {
+        SCOPED_TRACE(i);
         uint8_t k = i;
-        if (mBC->get(&k, 1, nullptr, 0) == 1) {
-            numCached++;
-        }
+        ASSERT_EQ(size_t(i == 1 ? 0 : 1), mBC->get(&k, 1, nullptr, 0));
     }
-    ASSERT_EQ(maxEntries / 2 + 1, numCached);
+    ASSERT_EQ(size_t(1), mBC->getStats().evictions);
+}
+
+TEST_F(BlobCacheTest, UpdatingValueEvictsOnlyOtherEntries) {
+    mBC->set("a", 1, "bcd", 3);
+    mBC->set("e", 1, "fgh", 3);
+    mBC->set("i", 1, "jkl", 3);
+    // Growing the value of the oldest entry evicts the next oldest entry only.
+    mBC->set("a", 1, "bcdefg", 6);
+    ASSERT_EQ(size_t(6), mBC->get("a", 1, nullptr, 0));
+    ASSERT_EQ(size_t(0), mBC->get("e", 1, nullptr, 0));
+    ASSERT_EQ(size_t(3), mBC->get("i", 1, nullptr, 0));
+}
+
+TEST_F(BlobCacheTest, CountsHitsMissesAndEvictions) {
+    mBC->set("ab", 2, "cd", 2);
+    mBC->get("ab", 2, nullptr, 0);
+    mBC->get("ab", 2, nullptr, 0);
+    mBC->get("ef", 2, nullptr, 0);
+    mBC->set("efghij", 6, "klmnop", 6);
+
+    BlobCache::Stats stats = mBC->getStats();
+    ASSERT_EQ(size_t(2), stats.hits);
+    ASSERT_EQ(size_t(1), stats.misses);
+    ASSERT_EQ(size_t(1), stats.evictions);
 }
 
 class BlobCacheFlattenTest : public BlobCacheTest {
@@ -314,6 +342,33 @@ TEST_F(BlobCacheFlattenTest, FlattenFullCache) {
     }
 }
 
+TEST_F(BlobCacheFlattenTest, FlattenKeepsRecencyOrder) {
+    // Fill up the entire cache with 1 char key/value pairs, and use the
+    // oldest entry.
+    const int maxEntries = MAX_TOTAL_SIZE / 2;
+    for (int i = 0; i < maxEntries; i++) {
+        uint8_t k = i;
+        mBC->set(&k, 1, &k, 1);
+    }
+    {
+        uint8_t k = 0;
+        ASSERT_EQ(size_t(1), mBC->get(&k, 1, nullptr, 0));
+    }
+
+    roundTrip();
+
+    // The deserialized cache evicts the same entry as the original would.
+    {
+        uint8_t k = maxEntries;
+        mBC2->set(&k, 1, &k, 1);
+    }
+    for (int i = 0; i < maxEntries + 1; i++) {
+        SCOPED_TRACE(i);
+        uint8_t k = i;
+        ASSERT_EQ(size_t(i == 1 ? 0 : 1), mBC2->get(&k, 1, nullptr, 0));
+    }
+}
+
 TEST_F(BlobCacheFlattenTest, FlattenDoesntChangeCache) {
     // Fill up the entire cache with 1 char key/value pairs.
     const int maxEntries = MAX_TOTAL_SIZE / 2;
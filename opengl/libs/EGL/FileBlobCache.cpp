@@ -19,41 +19,224 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <android-base/properties.h>
 #include <log/log.h>
 
-// Cache file header
-static const char* cacheFileMagic = "EGL$";
-static const size_t cacheFileHeaderSize = 8;
+#if defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#elif defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include <vector>
+
+// Cache file header magic.  It differs from the one of the earlier format,
+// which held a single serialized BlobCache, so that such files are discarded.
+static const char* cacheFileMagic = "EGL#";
+
+// Cache file format version
+static const uint32_t cacheFileVersion = 1;
 
 namespace android {
 
-static uint32_t crc32c(const uint8_t* buf, size_t len) {
-    const uint32_t polyBits = 0x82F63B78;
-    uint32_t r = 0;
-    for (size_t i = 0; i < len; i++) {
-        r ^= buf[i];
-        for (int j = 0; j < 8; j++) {
-            if (r & 1) {
-                r = (r >> 1) ^ polyBits;
-            } else {
-                r >>= 1;
+// A FileHeader is the header of the cache file.  It is followed by the build
+// id of the device that wrote the file, and then by the records, each starting
+// at a 4-byte aligned offset.
+struct FileHeader {
+    // mMagic must always contain cacheFileMagic.
+    char mMagic[4];
+
+    // mCrc is the CRC of the rest of the header, including the build id.
+    uint32_t mCrc;
+
+    // mVersion is the format version of the file.
+    uint32_t mVersion;
+
+    // mBuildIdLength is the length of mBuildId.  When an update to the build
+    // happens the build id changes, and the cache file is discarded.
+    uint32_t mBuildIdLength;
+    char mBuildId[];
+};
+
+// A RecordHeader is the header of a cache file record.  It is followed by the
+// key data and then the value data.  A record replaces any earlier record
+// with the same key.
+struct RecordHeader {
+    // mCrc is the CRC of the rest of the record, so that a record that was
+    // only partially appended to the file is detected.
+    uint32_t mCrc;
+
+    // mKeySize is the size of the key in bytes.
+    uint32_t mKeySize;
+
+    // mValueSize is the size of the value in bytes.
+    uint32_t mValueSize;
+
+    uint8_t mData[];
+};
+
+// crc32cTables holds the lookup tables of the slice-by-8 CRC-32C algorithm.
+// mTables[0] is the classic byte-at-a-time table, and mTables[k] advances the
+// CRC of a byte by k more zero bytes.
+static constexpr struct Crc32cTables {
+    uint32_t mTables[8][256];
+
+    constexpr Crc32cTables() : mTables() {
+        const uint32_t polyBits = 0x82F63B78;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t r = i;
+            for (int j = 0; j < 8; j++) {
+                r = (r & 1) ? (r >> 1) ^ polyBits : r >> 1;
+            }
+            mTables[0][i] = r;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t r = mTables[k - 1][i];
+                mTables[k][i] = (r >> 8) ^ mTables[0][r & 0xFF];
             }
         }
     }
+} crc32cTables;
+
+static inline uint32_t load32(const uint8_t* buf) {
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | (uint32_t(buf[3]) << 24);
+}
+
+static uint32_t crc32cSlicing(uint32_t r, const uint8_t* buf, size_t len) {
+    const auto& t = crc32cTables.mTables;
+    for (; len >= 8; buf += 8, len -= 8) {
+        uint32_t lo = r ^ load32(buf);
+        uint32_t hi = load32(buf + 4);
+        r = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; len > 0; buf++, len--) {
+        r = t[0][(r ^ *buf) & 0xFF] ^ (r >> 8);
+    }
     return r;
 }
 
+#if defined(__aarch64__) && defined(__clang__)
+#define HAVE_CRC32C_INSTRUCTIONS 1
+
+// The CRC32 instructions are optional before ARMv8.1, so they are only used
+// when the kernel reports them.
+static bool hasCrc32cInstructions() {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+__attribute__((target("crc"))) static uint32_t crc32cHardware(uint32_t r, const uint8_t* buf,
+                                                              size_t len) {
+    for (; len >= 8; buf += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        r = __builtin_arm_crc32cd(r, word);
+    }
+    for (; len > 0; buf++, len--) {
+        r = __builtin_arm_crc32cb(r, *buf);
+    }
+    return r;
+}
+#elif defined(__x86_64__)
+#define HAVE_CRC32C_INSTRUCTIONS 1
+
+static bool hasCrc32cInstructions() {
+    return __builtin_cpu_supports("sse4.2");
+}
+
+__attribute__((target("sse4.2"))) static uint32_t crc32cHardware(uint32_t r, const uint8_t* buf,
+                                                                 size_t len) {
+    uint64_t r64 = r;
+    for (; len >= 8; buf += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        r64 = _mm_crc32_u64(r64, word);
+    }
+    r = static_cast<uint32_t>(r64);
+    for (; len > 0; buf++, len--) {
+        r = _mm_crc32_u8(r, *buf);
+    }
+    return r;
+}
+#endif
+
+// crc32c returns the CRC-32C of buf, starting from 0 and without a final
+// inversion.  It uses the CRC32C instructions of the CPU when there are any.
+static uint32_t crc32c(const uint8_t* buf, size_t len) {
+#if HAVE_CRC32C_INSTRUCTIONS
+    static const bool useInstructions = hasCrc32cInstructions();
+    if (useInstructions) {
+        return crc32cHardware(0, buf, len);
+    }
+#endif
+    return crc32cSlicing(0, buf, len);
+}
+
+static inline size_t align4(size_t size) {
+    return (size + 3) & ~3;
+}
+
+static size_t getRecordSize(size_t keySize, size_t valueSize) {
+    return align4(sizeof(RecordHeader) + keySize + valueSize);
+}
+
+static uint32_t getRecordCrc(const RecordHeader* record, size_t recordSize) {
+    const size_t crcSize = sizeof(record->mCrc);
+    return crc32c(reinterpret_cast<const uint8_t*>(record) + crcSize, recordSize - crcSize);
+}
+
+// appendFileHeader appends the header of a cache file written by this device
+// to buf.
+static void appendFileHeader(std::vector<uint8_t>& buf) {
+    std::string buildId = base::GetProperty("ro.build.id", "");
+    size_t offset = buf.size();
+    size_t headerSize = align4(sizeof(FileHeader) + buildId.size());
+    buf.resize(offset + headerSize);
+
+    FileHeader* header = reinterpret_cast<FileHeader*>(&buf[offset]);
+    memcpy(header->mMagic, cacheFileMagic, 4);
+    header->mVersion = cacheFileVersion;
+    header->mBuildIdLength = buildId.size();
+    memcpy(header->mBuildId, buildId.c_str(), buildId.size());
+    header->mCrc = crc32c(reinterpret_cast<const uint8_t*>(&header->mVersion),
+                          headerSize - offsetof(FileHeader, mVersion));
+}
+
+// appendRecord appends a record of the given key/value pair to buf.
+static void appendRecord(std::vector<uint8_t>& buf, const void* key, size_t keySize,
+                         const void* value, size_t valueSize) {
+    size_t offset = buf.size();
+    size_t recordSize = getRecordSize(keySize, valueSize);
+    // resize zeroes the padding bytes, so that they have a reproducible CRC.
+    buf.resize(offset + recordSize);
+
+    RecordHeader* record = reinterpret_cast<RecordHeader*>(&buf[offset]);
+    record->mKeySize = keySize;
+    record->mValueSize = valueSize;
+    memcpy(record->mData, key, keySize);
+    memcpy(record->mData + keySize, value, valueSize);
+    record->mCrc = getRecordCrc(record, recordSize);
+}
+
 FileBlobCache::FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
         const std::string& filename)
         : BlobCache(maxKeySize, maxValueSize, maxTotalSize)
-        , mFilename(filename) {
+        , mFilename(filename)
+        , mFileSize(0)
+        , mFileDevice(0)
+        , mFileInode(0)
+        , mMappedFile(nullptr)
+        , mMappedSize(0) {
     if (mFilename.length() > 0) {
-        size_t headerSize = cacheFileHeaderSize;
-
         int fd = open(mFilename.c_str(), O_RDONLY, 0);
         if (fd == -1) {
             if (errno != ENOENT) {
@@ -63,6 +246,14 @@ FileBlobCache::FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxT
             return;
         }
 
+        // Other processes only append to the file under an exclusive lock, so
+        // the records aren't read while one is being written.
+        if (flock(fd, LOCK_SH) == -1) {
+            ALOGE("error locking cache file: %s (%d)", strerror(errno), errno);
+            close(fd);
+            return;
+        }
+
         struct stat statBuf;
         if (fstat(fd, &statBuf) == -1) {
             ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
@@ -72,6 +263,10 @@ FileBlobCache::FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxT
 
         // Check the size before trying to mmap it.
         size_t fileSize = statBuf.st_size;
+        if (fileSize == 0) {
+            close(fd);
+            return;
+        }
         if (fileSize > mMaxTotalSize * 2) {
             ALOGE("cache file is too large: %#" PRIx64,
                   static_cast<off64_t>(statBuf.st_size));
@@ -88,101 +283,242 @@ FileBlobCache::FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxT
             return;
         }
 
-        // Check the file magic and CRC
-        size_t cacheSize = fileSize - headerSize;
-        if (memcmp(buf, cacheFileMagic, 4) != 0) {
+        // Check the file magic and header CRC
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(buf);
+        if (fileSize < sizeof(FileHeader) || memcmp(header->mMagic, cacheFileMagic, 4) != 0) {
             ALOGE("cache file has bad mojo");
+            munmap(buf, fileSize);
             close(fd);
             return;
         }
-        uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
-        if (crc32c(buf + headerSize, cacheSize) != *crc) {
+        size_t headerSize = align4(sizeof(FileHeader) + header->mBuildIdLength);
+        if (header->mBuildIdLength > fileSize || headerSize > fileSize ||
+            crc32c(reinterpret_cast<const uint8_t*>(&header->mVersion),
+                   headerSize - offsetof(FileHeader, mVersion)) != header->mCrc) {
             ALOGE("cache file failed CRC check");
+            munmap(buf, fileSize);
             close(fd);
             return;
         }
-
-        int err = unflatten(buf + headerSize, cacheSize);
-        if (err < 0) {
-            ALOGE("error reading cache contents: %s (%d)", strerror(-err),
-                    -err);
+        auto buildId = base::GetProperty("ro.build.id", "");
+        if (header->mVersion != cacheFileVersion || buildId.size() != header->mBuildIdLength ||
+            strncmp(buildId.c_str(), header->mBuildId, buildId.size())) {
+            // We treat version mismatches as an empty cache.
             munmap(buf, fileSize);
             close(fd);
             return;
         }
 
-        munmap(buf, fileSize);
+        // Load the records in place.  Loading stops at the first damaged
+        // record, and the next write to the file compacts it instead.
+        size_t offset = headerSize;
+        while (fileSize - offset >= sizeof(RecordHeader)) {
+            const RecordHeader* record = reinterpret_cast<const RecordHeader*>(buf + offset);
+            if (record->mKeySize > fileSize || record->mValueSize > fileSize) {
+                break;
+            }
+            size_t recordSize = getRecordSize(record->mKeySize, record->mValueSize);
+            if (recordSize > fileSize - offset ||
+                getRecordCrc(record, recordSize) != record->mCrc) {
+                break;
+            }
+            setReference(record->mData, record->mKeySize, record->mData + record->mKeySize,
+                         record->mValueSize);
+            offset += recordSize;
+        }
+        if (offset != fileSize) {
+            ALOGW("cache file has a damaged record at offset %zu, ignoring the rest of it",
+                  offset);
+        }
+
+        // Closing the file releases the lock.  The loaded records are never
+        // truncated away by other processes, so they stay mapped.
         close(fd);
+
+        mFileSize = offset;
+        mFileDevice = statBuf.st_dev;
+        mFileInode = statBuf.st_ino;
+        mMappedFile = buf;
+        mMappedSize = fileSize;
+    }
+}
+
+FileBlobCache::~FileBlobCache() {
+    // Drop the entries that refer to the mapping before unmapping it.
+    clear();
+    if (mMappedFile != nullptr) {
+        munmap(mMappedFile, mMappedSize);
     }
 }
 
 void FileBlobCache::writeToFile() {
     if (mFilename.length() > 0) {
-        size_t cacheSize = getFlattenedSize();
-        size_t headerSize = cacheFileHeaderSize;
-        const char* fname = mFilename.c_str();
-
-        // Try to create the file with no permissions so we can write it
-        // without anyone trying to read it.
-        int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
-        if (fd == -1) {
-            if (errno == EEXIST) {
-                // The file exists, delete it and try again.
-                if (unlink(fname) == -1) {
-                    // No point in retrying if the unlink failed.
-                    ALOGE("error unlinking cache file %s: %s (%d)", fname,
-                            strerror(errno), errno);
-                    return;
-                }
-                // Retry now that we've unlinked the file.
-                fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+        // Collect the records of the entries that changed since the last
+        // write.
+        std::vector<uint8_t> records;
+        size_t liveSize = 0;
+        forEachEntry([&](const void* key, size_t keySize, const void* value, size_t valueSize,
+                         bool persisted) {
+            liveSize += getRecordSize(keySize, valueSize);
+            if (!persisted) {
+                appendRecord(records, key, keySize, value, valueSize);
             }
-            if (fd == -1) {
-                ALOGE("error creating cache file %s: %s (%d)", fname,
-                        strerror(errno), errno);
+        });
+        if (mFileSize > 0 && records.empty()) {
+            return;
+        }
+
+        // Append the records, unless the file would then mostly hold records
+        // of evicted or replaced entries or outgrow the size it is loaded at.
+        size_t newFileSize = mFileSize + records.size();
+        bool compact = mFileSize == 0 || newFileSize > 2 * liveSize ||
+                newFileSize > mMaxTotalSize * 2;
+        if (compact || !appendToFile(records.data(), records.size())) {
+            if (!compactFile()) {
                 return;
             }
         }
+        markPersisted();
+    }
+}
 
-        size_t fileSize = headerSize + cacheSize;
+bool FileBlobCache::appendToFile(const uint8_t* buf, size_t size) {
+    const char* fname = mFilename.c_str();
+    int fd = open(fname, O_WRONLY, 0);
+    if (fd == -1) {
+        ALOGE("error opening cache file %s: %s (%d)", fname, strerror(errno), errno);
+        return false;
+    }
 
-        uint8_t* buf = new uint8_t [fileSize];
-        if (!buf) {
-            ALOGE("error allocating buffer for cache contents: %s (%d)",
-                    strerror(errno), errno);
-            close(fd);
-            unlink(fname);
-            return;
-        }
+    // The lock keeps other processes from loading or appending to the file
+    // meanwhile.  Closing the file releases it.
+    if (flock(fd, LOCK_EX) == -1) {
+        ALOGE("error locking cache file: %s (%d)", strerror(errno), errno);
+        close(fd);
+        return false;
+    }
 
-        int err = flatten(buf + headerSize, cacheSize);
-        if (err < 0) {
-            ALOGE("error writing cache contents: %s (%d)", strerror(-err),
-                    -err);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
-            return;
-        }
+    // Another process may have replaced the file, or appended its own records
+    // to it, since this one loaded or wrote it.  The file is then compacted
+    // rather than appended to.  The same goes for a file with damaged records
+    // after the valid ones, which can't be truncated away: other processes may
+    // have mapped that part of the file, and would fault on it.
+    struct stat fdStat;
+    struct stat pathStat;
+    if (fstat(fd, &fdStat) == -1 || stat(fname, &pathStat) == -1 ||
+        fdStat.st_dev != mFileDevice || fdStat.st_ino != mFileInode ||
+        pathStat.st_dev != mFileDevice || pathStat.st_ino != mFileInode ||
+        static_cast<size_t>(fdStat.st_size) != mFileSize) {
+        close(fd);
+        return false;
+    }
 
-        // Write the file magic and CRC
-        memcpy(buf, cacheFileMagic, 4);
-        uint32_t* crc = reinterpret_cast<uint32_t*>(buf + 4);
-        *crc = crc32c(buf + headerSize, cacheSize);
+    if (lseek(fd, mFileSize, SEEK_SET) == -1) {
+        ALOGE("error seeking cache file: %s (%d)", strerror(errno), errno);
+        close(fd);
+        return false;
+    }
 
-        if (write(fd, buf, fileSize) == -1) {
-            ALOGE("error writing cache file: %s (%d)", strerror(errno),
-                    errno);
-            delete [] buf;
-            close(fd);
-            unlink(fname);
-            return;
+    if (write(fd, buf, size) != static_cast<ssize_t>(size)) {
+        ALOGE("error appending to cache file: %s (%d)", strerror(errno), errno);
+        // Only the part of the record that was just written is dropped.  No
+        // other process has loaded it, as the lock is still held.
+        ftruncate(fd, mFileSize);
+        close(fd);
+        return false;
+    }
+
+    close(fd);
+    mFileSize += size;
+    return true;
+}
+
+bool FileBlobCache::compactFile() {
+    std::vector<uint8_t> buf;
+    appendFileHeader(buf);
+    forEachEntry([&buf](const void* key, size_t keySize, const void* value, size_t valueSize,
+                        bool /*persisted*/) {
+        appendRecord(buf, key, keySize, value, valueSize);
+    });
+
+    // Write the new file next to the old one and then move it into place, so
+    // that the old file stays intact until the new one is complete.  Entries
+    // loaded from the old file keep referring to its mapping.
+    std::string tempFilename = mFilename + ".tmp";
+    const char* fname = tempFilename.c_str();
+
+    // Holding the lock of the current file until the new one replaces it keeps
+    // other processes from compacting at the same time, or from appending to
+    // the file that is about to be replaced.
+    int lockFd = open(mFilename.c_str(), O_RDONLY, 0);
+    if (lockFd != -1 && flock(lockFd, LOCK_EX) == -1) {
+        ALOGE("error locking cache file: %s (%d)", strerror(errno), errno);
+        close(lockFd);
+        return false;
+    }
+    auto unlockFile = [lockFd]() {
+        if (lockFd != -1) {
+            close(lockFd);
         }
+    };
 
-        delete [] buf;
-        fchmod(fd, S_IRUSR);
+    // Try to create the file with no permissions so we can write it
+    // without anyone trying to read it.
+    int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+    if (fd == -1) {
+        if (errno == EEXIST) {
+            // The file exists, delete it and try again.
+            if (unlink(fname) == -1) {
+                // No point in retrying if the unlink failed.
+                ALOGE("error unlinking cache file %s: %s (%d)", fname,
+                        strerror(errno), errno);
+                unlockFile();
+                return false;
+            }
+            // Retry now that we've unlinked the file.
+            fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+        }
+        if (fd == -1) {
+            ALOGE("error creating cache file %s: %s (%d)", fname,
+                    strerror(errno), errno);
+            unlockFile();
+            return false;
+        }
+    }
+
+    if (write(fd, buf.data(), buf.size()) != static_cast<ssize_t>(buf.size())) {
+        ALOGE("error writing cache file: %s (%d)", strerror(errno),
+                errno);
+        close(fd);
+        unlink(fname);
+        unlockFile();
+        return false;
+    }
+
+    // Records are appended to the file later on, so it stays writable.
+    fchmod(fd, S_IRUSR | S_IWUSR);
+    struct stat statBuf;
+    if (fstat(fd, &statBuf) == -1) {
+        ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
         close(fd);
+        unlink(fname);
+        unlockFile();
+        return false;
     }
+    close(fd);
+
+    if (rename(fname, mFilename.c_str()) == -1) {
+        ALOGE("error renaming cache file %s: %s (%d)", fname, strerror(errno), errno);
+        unlink(fname);
+        unlockFile();
+        return false;
+    }
+    unlockFile();
+
+    mFileSize = buf.size();
+    mFileDevice = statBuf.st_dev;
+    mFileInode = statBuf.st_ino;
+    return true;
 }
 
 }
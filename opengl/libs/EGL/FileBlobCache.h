@@ -18,10 +18,19 @@
 #define ANDROID_FILE_BLOB_CACHE_H
 
 #include "BlobCache.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
 #include <string>
 
 namespace android {
 
+// A FileBlobCache is a BlobCache that is saved to a file.  The file holds a
+// log of records, each with its own checksum.  New entries are appended to
+// it, and the whole file is rewritten only when most of its records are stale.
+// The file is mapped into memory when loaded, and the loaded entries refer to
+// the mapping rather than to copies of their data.
 class FileBlobCache : public BlobCache {
 public:
     // FileBlobCache attempts to load the saved cache contents from disk into
@@ -29,13 +38,45 @@ public:
     FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
             const std::string& filename);
 
-    // writeToFile attempts to save the current contents of BlobCache to
-    // disk.
+    ~FileBlobCache();
+
+    // writeToFile attempts to save the entries of BlobCache that have changed
+    // since the last save to disk.
     void writeToFile();
 
 private:
+    // appendToFile appends the records in buf to the end of the cache file.
+    // It fails, leaving the file untouched, if the file is no longer the one
+    // this cache loaded or last wrote, or if other records were written to it
+    // since.
+    bool appendToFile(const uint8_t* buf, size_t size);
+
+    // compactFile replaces the cache file with one holding exactly the current
+    // contents of BlobCache.
+    bool compactFile();
+
+    // Other processes map the same cache file, so it is only ever grown in
+    // place, under an exclusive flock, and otherwise replaced by a rename.
+
     // mFilename is the name of the file for storing cache contents.
     std::string mFilename;
+
+    // mFileSize is the size of the valid part of the cache file, or 0 if the
+    // file is missing or unusable and must be rewritten.
+    size_t mFileSize;
+
+    // mFileDevice and mFileInode identify the cache file that mFileSize is
+    // the size of.
+    dev_t mFileDevice;
+    ino_t mFileInode;
+
+    // mMappedFile is the read-only mapping of the cache file that was loaded
+    // by the constructor, or nullptr.  Entries loaded from the file refer to
+    // it, so it is kept until the cache is destroyed.
+    uint8_t* mMappedFile;
+
+    // mMappedSize is the size of mMappedFile in bytes.
+    size_t mMappedSize;
 };
 
 } // namespace android
@@ -80,6 +80,7 @@ static int do_android_unload_sphal_library(void* dso) {
 }
 
 Loader::driver_t::driver_t(void* gles)
+    : gles1Initialized(false)
 {
     dso[0] = gles;
     for (size_t i=1 ; i<NELEM(dso) ; i++)
@@ -313,6 +314,24 @@ void Loader::close(egl_connection_t* cnx)
     cnx->useAngle = false;
 }
 
+void Loader::init_gles1(egl_connection_t* cnx) {
+    std::lock_guard<std::mutex> lock(mGles1Lock);
+    driver_t* hnd = (driver_t*)cnx->dso;
+    if (!hnd || hnd->gles1Initialized) {
+        return;
+    }
+
+    ATRACE_CALL();
+    void* dso = hnd->dso[0];
+    if (hnd->loadGles1) {
+        dso = hnd->loadGles1();
+        hnd->set(dso, GLESv1_CM);
+        hnd->loadGles1 = nullptr;
+    }
+    initialize_api(dso, cnx, GLESv1_CM);
+    hnd->gles1Initialized = true;
+}
+
 void Loader::init_api(void* dso,
         char const * const * api,
         char const * const * ref_api,
@@ -541,9 +560,7 @@ Loader::driver_t* Loader::attempt_to_load_angle(egl_connection_t* cnx) {
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_angle("GLESv1_CM", ns);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        hnd->loadGles1 = [ns]() { return load_angle("GLESv1_CM", ns); };
 
         dso = load_angle("GLESv2", ns);
         initialize_api(dso, cnx, GLESv2);
@@ -576,7 +593,7 @@ Loader::driver_t* Loader::attempt_to_load_updated_driver(egl_connection_t* cnx)
     driver_t* hnd = nullptr;
     void* dso = load_updated_driver("GLES", ns);
     if (dso) {
-        initialize_api(dso, cnx, EGL | GLESv1_CM | GLESv2);
+        initialize_api(dso, cnx, EGL | GLESv2);
         hnd = new driver_t(dso);
         return hnd;
     }
@@ -586,9 +603,7 @@ Loader::driver_t* Loader::attempt_to_load_updated_driver(egl_connection_t* cnx)
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_updated_driver("GLESv1_CM", ns);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        hnd->loadGles1 = [ns]() { return load_updated_driver("GLESv1_CM", ns); };
 
         dso = load_updated_driver("GLESv2", ns);
         initialize_api(dso, cnx, GLESv2);
@@ -604,7 +619,7 @@ Loader::driver_t* Loader::attempt_to_load_system_driver(egl_connection_t* cnx, c
     driver_t* hnd = nullptr;
     void* dso = load_system_driver("GLES", suffix, exact);
     if (dso) {
-        initialize_api(dso, cnx, EGL | GLESv1_CM | GLESv2);
+        initialize_api(dso, cnx, EGL | GLESv2);
         hnd = new driver_t(dso);
         return hnd;
     }
@@ -613,9 +628,13 @@ Loader::driver_t* Loader::attempt_to_load_system_driver(egl_connection_t* cnx, c
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_system_driver("GLESv1_CM", suffix, exact);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        // suffix does not outlive this call, so loadGles1 keeps a copy of it.
+        const bool hasSuffix = suffix != nullptr;
+        std::string gles1Suffix = hasSuffix ? suffix : "";
+        hnd->loadGles1 = [hasSuffix, gles1Suffix, exact]() {
+            return load_system_driver("GLESv1_CM", hasSuffix ? gles1Suffix.c_str() : nullptr,
+                                      exact);
+        };
 
         dso = load_system_driver("GLESv2", suffix, exact);
         initialize_api(dso, cnx, GLESv2);
@@ -20,6 +20,9 @@
 #include <EGL/egl.h>
 #include <stdint.h>
 
+#include <functional>
+#include <mutex>
+
 namespace android {
 
 struct egl_connection_t;
@@ -39,10 +42,22 @@ class Loader {
         // returns -errno
         int set(void* hnd, int32_t api);
         void* dso[3];
+
+        // loadGles1 loads the separate GLESv1_CM driver library.  It is empty
+        // once that library has been loaded, and when dso[0] provides the
+        // GLESv1_CM API itself.
+        std::function<void*()> loadGles1;
+
+        // gles1Initialized indicates whether the GLESv1_CM entry points have
+        // been resolved into the GLESv1 hooks.
+        bool gles1Initialized;
     };
 
     getProcAddressType getProcAddress;
 
+    // mGles1Lock serializes the deferred initialization of the GLESv1_CM API.
+    std::mutex mGles1Lock;
+
 public:
     static Loader& getInstance();
     ~Loader();
@@ -50,6 +65,12 @@ public:
     void* open(egl_connection_t* cnx);
     void close(egl_connection_t* cnx);
 
+    // init_gles1 loads the GLESv1_CM driver library, if needed, and resolves
+    // its entry points into the GLESv1 hooks.  The GLESv1_CM API is rarely
+    // used, so this is deferred from open() until the first GLES 1.x context
+    // is created.
+    void init_gles1(egl_connection_t* cnx);
+
 private:
     Loader();
     driver_t* attempt_to_load_angle(egl_connection_t* cnx);
@@ -107,6 +107,9 @@ void egl_cache_t::initialize(egl_display_t* display) {
 void egl_cache_t::terminate() {
     std::lock_guard<std::mutex> lock(mMutex);
     if (mBlobCache) {
+        const BlobCache::Stats stats = mBlobCache->getStats();
+        ALOGV("terminate: %zu hits, %zu misses, %zu evictions", stats.hits, stats.misses,
+              stats.evictions);
         mBlobCache->writeToFile();
     }
     mBlobCache = nullptr;
@@ -161,6 +164,14 @@ void egl_cache_t::setCacheFilename(const char* filename) {
     mFilename = filename;
 }
 
+BlobCache::Stats egl_cache_t::getStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mBlobCache == nullptr) {
+        return {};
+    }
+    return mBlobCache->getStats();
+}
+
 BlobCache* egl_cache_t::getBlobCacheLocked() {
     if (mBlobCache == nullptr) {
         mBlobCache.reset(new FileBlobCache(maxKeySize, maxValueSize, maxTotalSize, mFilename));
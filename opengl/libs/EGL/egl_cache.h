@@ -64,6 +64,10 @@ public:
     // cache contents from one program invocation to another.
     void setCacheFilename(const char* filename);
 
+    // getStats returns the hit, miss and eviction counts of the BlobCache that
+    // is currently loaded, or all zeros if none is.
+    BlobCache::Stats getStats();
+
 private:
     // Creation and (the lack of) destruction is handled internally.
     egl_cache_t();
@@ -82,7 +82,8 @@ egl_display_t::egl_display_t()
         finishOnSwap(false),
         traceGpuCompletion(false),
         refs(0),
-        eglIsInitialized(false) {}
+        eglIsInitialized(false),
+        objects(std::make_shared<ObjectSet>()) {}
 
 egl_display_t::~egl_display_t() {
     magic = 0;
@@ -102,19 +103,47 @@ egl_display_t* egl_display_t::get(EGLDisplay dpy) {
     return search->second.get();
 }
 
+egl_display_t::ObjectSet::~ObjectSet() {
+    for (auto o : removed) {
+        o->destroy();
+    }
+}
+
+std::shared_ptr<egl_display_t::ObjectSet> egl_display_t::replaceObjectsLocked(
+        std::unordered_set<egl_object_t*> newObjects, std::vector<egl_object_t*> removed) {
+    auto next = std::make_shared<ObjectSet>();
+    next->objects = std::move(newObjects);
+    std::shared_ptr<ObjectSet> previous = std::atomic_load(&objects);
+    // getObject() only reads the objects of a set, so these can change while it is in use.
+    previous->removed = std::move(removed);
+    previous->next = next;
+    std::atomic_store(&objects, next);
+    return previous;
+}
+
 void egl_display_t::addObject(egl_object_t* object) {
+    std::shared_ptr<ObjectSet> previous;
     std::lock_guard<std::mutex> _l(lock);
-    objects.insert(object);
+    auto newObjects = std::atomic_load(&objects)->objects;
+    newObjects.insert(object);
+    previous = replaceObjectsLocked(std::move(newObjects), {});
 }
 
 void egl_display_t::removeObject(egl_object_t* object) {
+    std::shared_ptr<ObjectSet> previous;
     std::lock_guard<std::mutex> _l(lock);
-    objects.erase(object);
+    auto newObjects = std::atomic_load(&objects)->objects;
+    if (newObjects.erase(object) == 0) {
+        return;
+    }
+    previous = replaceObjectsLocked(std::move(newObjects), {object});
 }
 
 bool egl_display_t::getObject(egl_object_t* object) const {
-    std::lock_guard<std::mutex> _l(lock);
-    if (objects.find(object) != objects.end()) {
+    // The set holds a reference to each of its objects until it is released, so the object can't
+    // go away before the incRef() below, even if another thread removes it meanwhile.
+    const std::shared_ptr<const ObjectSet> current = std::atomic_load(&objects);
+    if (current->objects.find(object) != current->objects.end()) {
         if (object->getDisplay() == this) {
             object->incRef();
             return true;
@@ -413,6 +442,7 @@ EGLBoolean egl_display_t::terminate() {
     }
 
     EGLBoolean res = EGL_FALSE;
+    std::shared_ptr<ObjectSet> previous;
 
     { // scope for lock
         std::lock_guard<std::mutex> _l(lock);
@@ -438,15 +468,15 @@ EGLBoolean egl_display_t::terminate() {
 
         // Mark all objects remaining in the list as terminated, unless
         // there are no reference to them, it which case, we're free to
-        // delete them.
-        size_t count = objects.size();
+        // delete them once the set is released.
+        const std::shared_ptr<ObjectSet> remaining = std::atomic_load(&objects);
+        size_t count = remaining->objects.size();
         ALOGW_IF(count, "eglTerminate() called w/ %zu objects remaining", count);
-        for (auto o : objects) {
-            o->destroy();
-        }
 
         // this marks all object handles are "terminated"
-        objects.clear();
+        previous = replaceObjectsLocked({},
+                                        std::vector<egl_object_t*>(remaining->objects.begin(),
+                                                                   remaining->objects.end()));
     }
 
     { // scope for refLock
@@ -28,6 +28,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "../hooks.h"
 #include "egldefs.h"
@@ -67,6 +68,7 @@ public:
     // remove object from this display's list
     void removeObject(egl_object_t* object);
     // add reference to this object. returns true if this is a valid object.
+    // this doesn't take the lock, so that threads validating handles don't contend.
     bool getObject(egl_object_t* object) const;
 
     static egl_display_t* get(EGLDisplay dpy);
@@ -114,12 +116,32 @@ public:
     bool hasColorSpaceSupport;
 
 private:
+    // The handles of this display's objects. A set is never modified once published: writers
+    // replace it under the lock, while getObject() only loads the current one.
+    struct ObjectSet {
+        ~ObjectSet();
+
+        std::unordered_set<egl_object_t*> objects;
+        // The objects that the set replacing this one doesn't have any longer. Their reference
+        // for being on the display is released with this set, when getObject() can no longer
+        // find them in it.
+        std::vector<egl_object_t*> removed;
+        // Keeps the sets that replaced this one alive at least as long as it is, since the
+        // objects they remove can still be found in this one.
+        std::shared_ptr<ObjectSet> next;
+    };
+    // Publishes newObjects, and returns the set they replace so that it is released after the
+    // lock.
+    std::shared_ptr<ObjectSet> replaceObjectsLocked(std::unordered_set<egl_object_t*> newObjects,
+                                                    std::vector<egl_object_t*> removed);
+
     uint32_t refs;
     bool eglIsInitialized;
     mutable std::mutex lock;
     mutable std::mutex refLock;
     mutable std::condition_variable refCond;
-    std::unordered_set<egl_object_t*> objects;
+    // Only accessed with std::atomic_load and std::atomic_store.
+    std::shared_ptr<ObjectSet> objects;
     std::string mVendorString;
     std::string mVersionString;
     std::string mClientApiString;
@@ -155,7 +155,7 @@ LayerLoader& LayerLoader::getInstance() {
     // This function is mutex protected in egl_init_drivers_locked and eglGetProcAddressImpl
     static LayerLoader layer_loader;
 
-    if (!layer_loader.layers_loaded_) layer_loader.LoadLayers();
+    if (!layer_loader.layers_loaded_ && !layer_loader.layers_checked_) layer_loader.LoadLayers();
 
     return layer_loader;
 }
@@ -343,7 +343,12 @@ void LayerLoader::LoadLayers() {
     std::string debug_layers = GetDebugLayers();
 
     // If no layers are specified, we're done
-    if (debug_layers.empty()) return;
+    if (debug_layers.empty()) {
+        // Apps are forked from the zygote, which has no layers, and get theirs set up before the
+        // app namespace is, so the answer only holds for good from then on.
+        layers_checked_ = android::GraphicsEnv::getInstance().getAppNamespace() != nullptr;
+        return;
+    }
 
     // Only enable the system search path for non-user builds
     std::string system_path;
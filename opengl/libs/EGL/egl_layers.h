@@ -60,11 +60,15 @@ public:
 private:
     LayerLoader()
           : layers_loaded_(false),
+            layers_checked_(false),
             initialized_(false),
             current_layer_(0),
             dlhandle_(nullptr),
             native_bridge_(false){};
     bool layers_loaded_;
+    // Set once it is known for good that there are no layers to load, so that the settings and
+    // properties aren't read again on each driver initialization and eglGetProcAddress.
+    bool layers_checked_;
     bool initialized_;
     unsigned current_layer_;
     void* dlhandle_;
@@ -28,12 +28,9 @@ egl_object_t::egl_object_t(egl_display_t* disp) : display(disp), count(1) {
 egl_object_t::~egl_object_t() {}
 
 void egl_object_t::terminate() {
-    // this marks the object as "terminated"
+    // this marks the object as "terminated". the display releases the
+    // reference it holds once no other thread can be validating the handle.
     display->removeObject(this);
-    if (decRef() == 1) {
-        // shouldn't happen because this is called from LocalRef
-        ALOGE("egl_object_t::terminate() removed the last reference!");
-    }
 }
 
 void egl_object_t::destroy() {
@@ -38,6 +38,7 @@
 #include <unordered_map>
 
 #include "../egl_impl.h"
+#include "EGL/Loader.h"
 #include "EGL/egl.h"
 #include "EGL/eglext.h"
 #include "EGL/eglext_angle.h"
@@ -914,20 +915,25 @@ EGLContext eglCreateContextImpl(EGLDisplay dpy, EGLConfig config, EGLContext sha
                 }
             };
         }
+        // figure out if it's a GLESv1 or GLESv2
+        int version = egl_connection_t::GLESv1_INDEX;
+        if (attrib_list) {
+            const EGLint* attrib_ptr = attrib_list;
+            while (*attrib_ptr != EGL_NONE) {
+                GLint attr = *attrib_ptr++;
+                GLint value = *attrib_ptr++;
+                if (attr == EGL_CONTEXT_CLIENT_VERSION && (value == 2 || value == 3)) {
+                    version = egl_connection_t::GLESv2_INDEX;
+                }
+            };
+        }
+        if (version == egl_connection_t::GLESv1_INDEX) {
+            // The GLESv1_CM driver is only loaded once it is needed.
+            Loader::getInstance().init_gles1(cnx);
+        }
         EGLContext context =
                 cnx->egl.eglCreateContext(dp->disp.dpy, config, share_list, attrib_list);
         if (context != EGL_NO_CONTEXT) {
-            // figure out if it's a GLESv1 or GLESv2
-            int version = egl_connection_t::GLESv1_INDEX;
-            if (attrib_list) {
-                while (*attrib_list != EGL_NONE) {
-                    GLint attr = *attrib_list++;
-                    GLint value = *attrib_list++;
-                    if (attr == EGL_CONTEXT_CLIENT_VERSION && (value == 2 || value == 3)) {
-                        version = egl_connection_t::GLESv2_INDEX;
-                    }
-                };
-            }
             if (version == egl_connection_t::GLESv1_INDEX) {
                 android::GraphicsEnv::getInstance().setTargetStats(
                         android::GpuStatsInfo::Stats::GLES_1_IN_USE);
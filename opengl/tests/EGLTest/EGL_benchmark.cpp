@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the EGL calls that validate their handles on every frame, from several threads at
+// once, each with its own pbuffer surface and context on the same display.
+
+#include <EGL/egl.h>
+#include <android-base/logging.h>
+#include <benchmark/benchmark.h>
+
+static EGLDisplay gDisplay = EGL_NO_DISPLAY;
+static EGLConfig gConfig = nullptr;
+
+static constexpr int kMaxThreads = 8;
+
+// A surface and context for the calling thread, current while it is alive.
+class ThreadSurface {
+public:
+    ThreadSurface() {
+        const EGLint surfaceAttrs[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+        surface = eglCreatePbufferSurface(gDisplay, gConfig, surfaceAttrs);
+        CHECK(surface != EGL_NO_SURFACE);
+        const EGLint contextAttrs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        context = eglCreateContext(gDisplay, gConfig, EGL_NO_CONTEXT, contextAttrs);
+        CHECK(context != EGL_NO_CONTEXT);
+        CHECK(eglMakeCurrent(gDisplay, surface, surface, context));
+    }
+
+    ~ThreadSurface() {
+        eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(gDisplay, context);
+        eglDestroySurface(gDisplay, surface);
+        eglReleaseThread();
+    }
+
+    EGLSurface surface;
+    EGLContext context;
+};
+
+// Releases and makes current again the context of the thread, as a renderer sharing its thread
+// with other contexts does every frame.
+static void BM_makeCurrent(benchmark::State& state) {
+    ThreadSurface current;
+    for (auto _ : state) {
+        eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglMakeCurrent(gDisplay, current.surface, current.surface, current.context);
+    }
+}
+BENCHMARK(BM_makeCurrent)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+// Swapping a pbuffer surface has no effect, which leaves mostly the cost of the call itself.
+static void BM_swapBuffers(benchmark::State& state) {
+    ThreadSurface current;
+    for (auto _ : state) {
+        eglSwapBuffers(gDisplay, current.surface);
+    }
+}
+BENCHMARK(BM_swapBuffers)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+// Does little more than validate the surface and context handles.
+static void BM_querySurface(benchmark::State& state) {
+    ThreadSurface current;
+    EGLint width;
+    for (auto _ : state) {
+        eglQuerySurface(gDisplay, current.surface, EGL_WIDTH, &width);
+        benchmark::DoNotOptimize(width);
+    }
+}
+BENCHMARK(BM_querySurface)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    gDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    CHECK(gDisplay != EGL_NO_DISPLAY);
+    CHECK(eglInitialize(gDisplay, nullptr, nullptr));
+    const EGLint configAttrs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+                                  EGL_OPENGL_ES2_BIT, EGL_NONE};
+    EGLint numConfigs = 0;
+    CHECK(eglChooseConfig(gDisplay, configAttrs, &gConfig, 1, &numConfigs));
+    CHECK_GT(numConfigs, 0);
+
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    eglTerminate(gDisplay);
+    return 0;
+}
@@ -77,6 +77,21 @@ TEST_F(EGLCacheTest, TerminatedCacheAlwaysMisses) {
     ASSERT_EQ(0xee, buf[3]);
 }
 
+TEST_F(EGLCacheTest, InitializedCacheCountsLookups) {
+    uint8_t buf[4] = { 0xee, 0xee, 0xee, 0xee };
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "efgh", 4);
+    ASSERT_EQ(4, mCache->getBlob("abcd", 4, buf, 4));
+    ASSERT_EQ(0, mCache->getBlob("ijkl", 4, buf, 4));
+    BlobCache::Stats stats = mCache->getStats();
+    ASSERT_EQ(size_t(1), stats.hits);
+    ASSERT_EQ(size_t(1), stats.misses);
+    ASSERT_EQ(size_t(0), stats.evictions);
+
+    mCache->terminate();
+    ASSERT_EQ(size_t(0), mCache->getStats().hits);
+}
+
 class EGLCacheSerializationTest : public EGLCacheTest {
 
 protected:
@@ -108,4 +123,23 @@ TEST_F(EGLCacheSerializationTest, ReinitializedCacheContainsValues) {
     ASSERT_EQ('h', buf[3]);
 }
 
+TEST_F(EGLCacheSerializationTest, ReinitializedCacheContainsAppendedValues) {
+    uint8_t buf[4] = { 0xee, 0xee, 0xee, 0xee };
+    mCache->setCacheFilename(&mTempFile->path[0]);
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("abcd", 4, "efgh", 4);
+    mCache->terminate();
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    mCache->setBlob("ijkl", 4, "mnop", 4);
+    mCache->terminate();
+    mCache->initialize(egl_display_t::get(EGL_DEFAULT_DISPLAY));
+    ASSERT_EQ(4, mCache->getBlob("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ(4, mCache->getBlob("ijkl", 4, buf, 4));
+    ASSERT_EQ('m', buf[0]);
+    ASSERT_EQ('n', buf[1]);
+    ASSERT_EQ('o', buf[2]);
+    ASSERT_EQ('p', buf[3]);
+}
+
 }
@@ -91,7 +91,6 @@ void GpuStats::insertDriverStats(const std::string& driverPackageName,
                                  bool isDriverLoaded, int64_t driverLoadingTime) {
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mLock);
     registerStatsdCallbacksIfNeeded();
     ALOGV("Received:\n"
           "\tdriverPackageName[%s]\n"
@@ -107,22 +106,28 @@ void GpuStats::insertDriverStats(const std::string& driverPackageName,
           appPackageName.c_str(), vulkanVersion, static_cast<int32_t>(driver), isDriverLoaded,
           driverLoadingTime);
 
-    if (!mGlobalStats.count(driverVersionCode)) {
-        GpuStatsGlobalInfo globalInfo;
-        addLoadingCount(driver, isDriverLoaded, &globalInfo);
-        globalInfo.driverPackageName = driverPackageName;
-        globalInfo.driverVersionName = driverVersionName;
-        globalInfo.driverVersionCode = driverVersionCode;
-        globalInfo.driverBuildTime = driverBuildTime;
-        globalInfo.vulkanVersion = vulkanVersion;
-        mGlobalStats.insert({driverVersionCode, globalInfo});
-    } else {
-        addLoadingCount(driver, isDriverLoaded, &mGlobalStats[driverVersionCode]);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mGlobalStats.count(driverVersionCode)) {
+            GpuStatsGlobalInfo globalInfo;
+            addLoadingCount(driver, isDriverLoaded, &globalInfo);
+            globalInfo.driverPackageName = driverPackageName;
+            globalInfo.driverVersionName = driverVersionName;
+            globalInfo.driverVersionCode = driverVersionCode;
+            globalInfo.driverBuildTime = driverBuildTime;
+            globalInfo.vulkanVersion = vulkanVersion;
+            mGlobalStats.insert({driverVersionCode, globalInfo});
+        } else {
+            addLoadingCount(driver, isDriverLoaded, &mGlobalStats[driverVersionCode]);
+        }
     }
 
     const std::string appStatsKey = appPackageName + std::to_string(driverVersionCode);
-    if (!mAppStats.count(appStatsKey)) {
-        if (mAppStats.size() >= MAX_NUM_APP_RECORDS) {
+    AppStatsShard& shard = getAppStatsShard(appStatsKey);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    if (!shard.stats.count(appStatsKey)) {
+        if (mNumAppRecords.fetch_add(1) >= MAX_NUM_APP_RECORDS) {
+            mNumAppRecords--;
             ALOGV("GpuStatsAppInfo has reached maximum size. Ignore new stats.");
             return;
         }
@@ -131,11 +136,11 @@ void GpuStats::insertDriverStats(const std::string& driverPackageName,
         addLoadingTime(driver, driverLoadingTime, &appInfo);
         appInfo.appPackageName = appPackageName;
         appInfo.driverVersionCode = driverVersionCode;
-        mAppStats.insert({appStatsKey, appInfo});
+        shard.stats.insert({appStatsKey, appInfo});
         return;
     }
 
-    addLoadingTime(driver, driverLoadingTime, &mAppStats[appStatsKey]);
+    addLoadingTime(driver, driverLoadingTime, &shard.stats[appStatsKey]);
 }
 
 void GpuStats::insertTargetStats(const std::string& appPackageName,
@@ -145,21 +150,22 @@ void GpuStats::insertTargetStats(const std::string& appPackageName,
 
     const std::string appStatsKey = appPackageName + std::to_string(driverVersionCode);
 
-    std::lock_guard<std::mutex> lock(mLock);
     registerStatsdCallbacksIfNeeded();
-    if (!mAppStats.count(appStatsKey)) {
+    AppStatsShard& shard = getAppStatsShard(appStatsKey);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    if (!shard.stats.count(appStatsKey)) {
         return;
     }
 
     switch (stats) {
         case GpuStatsInfo::Stats::CPU_VULKAN_IN_USE:
-            mAppStats[appStatsKey].cpuVulkanInUse = true;
+            shard.stats[appStatsKey].cpuVulkanInUse = true;
             break;
         case GpuStatsInfo::Stats::FALSE_PREROTATION:
-            mAppStats[appStatsKey].falsePrerotation = true;
+            shard.stats[appStatsKey].falsePrerotation = true;
             break;
         case GpuStatsInfo::Stats::GLES_1_IN_USE:
-            mAppStats[appStatsKey].gles1InUse = true;
+            shard.stats[appStatsKey].gles1InUse = true;
             break;
         default:
             break;
@@ -176,14 +182,18 @@ void GpuStats::interceptSystemDriverStatsLocked() {
     mGlobalStats[0].glesVersion = property_get_int32("ro.opengles.version", 0);
 }
 
+GpuStats::AppStatsShard& GpuStats::getAppStatsShard(const std::string& appStatsKey) {
+    return mAppStats[std::hash<std::string>()(appStatsKey) % NUM_APP_STATS_SHARDS];
+}
+
 void GpuStats::registerStatsdCallbacksIfNeeded() {
-    if (!mStatsdRegistered) {
+    std::call_once(mStatsdRegisterOnce, [this]() {
         AStatsManager_setPullAtomCallback(android::util::GPU_STATS_GLOBAL_INFO, nullptr,
                                          GpuStats::pullAtomCallback, this);
         AStatsManager_setPullAtomCallback(android::util::GPU_STATS_APP_INFO, nullptr,
                                          GpuStats::pullAtomCallback, this);
         mStatsdRegistered = true;
-    }
+    });
 }
 
 void GpuStats::dump(const Vector<String16>& args, std::string* result) {
@@ -194,48 +204,24 @@ void GpuStats::dump(const Vector<String16>& args, std::string* result) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mLock);
-    bool dumpAll = true;
-
     std::unordered_set<std::string> argsSet;
     for (size_t i = 0; i < args.size(); i++) {
         argsSet.insert(String8(args[i]).c_str());
     }
 
+    const bool clear = argsSet.count("--clear") != 0;
     const bool dumpGlobal = argsSet.count("--global") != 0;
-    if (dumpGlobal) {
-        dumpGlobalLocked(result);
-        dumpAll = false;
-    }
-
     const bool dumpApp = argsSet.count("--app") != 0;
-    if (dumpApp) {
-        dumpAppLocked(result);
-        dumpAll = false;
-    }
+    const bool dumpAll = !dumpGlobal && !dumpApp;
 
-    if (dumpAll) {
+    if (dumpGlobal || dumpAll) {
+        std::lock_guard<std::mutex> lock(mLock);
         dumpGlobalLocked(result);
-        dumpAppLocked(result);
+        if (clear) mGlobalStats.clear();
     }
 
-    if (argsSet.count("--clear")) {
-        bool clearAll = true;
-
-        if (dumpGlobal) {
-            mGlobalStats.clear();
-            clearAll = false;
-        }
-
-        if (dumpApp) {
-            mAppStats.clear();
-            clearAll = false;
-        }
-
-        if (clearAll) {
-            mGlobalStats.clear();
-            mAppStats.clear();
-        }
+    if (dumpApp || dumpAll) {
+        dumpAppStats(result, clear);
     }
 }
 
@@ -248,10 +234,17 @@ void GpuStats::dumpGlobalLocked(std::string* result) {
     }
 }
 
-void GpuStats::dumpAppLocked(std::string* result) {
-    for (const auto& ele : mAppStats) {
-        result->append(ele.second.toString());
-        result->append("\n");
+void GpuStats::dumpAppStats(std::string* result, bool clear) {
+    for (auto& shard : mAppStats) {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        for (const auto& ele : shard.stats) {
+            result->append(ele.second.toString());
+            result->append("\n");
+        }
+        if (clear) {
+            mNumAppRecords -= shard.stats.size();
+            shard.stats.clear();
+        }
     }
 }
 
@@ -287,10 +280,17 @@ static std::string int64VectorToProtoByteString(const std::vector<int64_t>& valu
 AStatsManager_PullAtomCallbackReturn GpuStats::pullAppInfoAtom(AStatsEventList* data) {
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mLock);
+    for (auto& shard : mAppStats) {
+        // Take the stats out of the shard so that the events are built without holding its lock.
+        std::unordered_map<std::string, GpuStatsAppInfo> appStats;
+        {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            appStats.swap(shard.stats);
+            mNumAppRecords -= appStats.size();
+        }
+        if (!data) continue;
 
-    if (data) {
-        for (const auto& ele : mAppStats) {
+        for (const auto& ele : appStats) {
             std::string glDriverBytes = int64VectorToProtoByteString(
                 ele.second.glDriverLoadingTime);
             std::string vkDriverBytes = int64VectorToProtoByteString(
@@ -315,20 +315,22 @@ AStatsManager_PullAtomCallbackReturn GpuStats::pullAppInfoAtom(AStatsEventList*
         }
     }
 
-    mAppStats.clear();
-
     return AStatsManager_PULL_SUCCESS;
 }
 
 AStatsManager_PullAtomCallbackReturn GpuStats::pullGlobalInfoAtom(AStatsEventList* data) {
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mLock);
-    // flush cpuVulkanVersion and glesVersion to builtin driver stats
-    interceptSystemDriverStatsLocked();
+    std::unordered_map<uint64_t, GpuStatsGlobalInfo> globalStats;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        // flush cpuVulkanVersion and glesVersion to builtin driver stats
+        interceptSystemDriverStatsLocked();
+        globalStats.swap(mGlobalStats);
+    }
 
     if (data) {
-        for (const auto& ele : mGlobalStats) {
+        for (const auto& ele : globalStats) {
           android::util::addAStatsEvent(
                   data,
                   android::util::GPU_STATS_GLOBAL_INFO,
@@ -348,8 +350,6 @@ AStatsManager_PullAtomCallbackReturn GpuStats::pullGlobalInfoAtom(AStatsEventLis
         }
     }
 
-    mGlobalStats.clear();
-
     return AStatsManager_PULL_SUCCESS;
 }
 
@@ -22,6 +22,8 @@
 #include <utils/String16.h>
 #include <utils/Vector.h>
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -61,8 +63,8 @@ private:
     AStatsManager_PullAtomCallbackReturn pullAppInfoAtom(AStatsEventList* data);
     // Dump global stats
     void dumpGlobalLocked(std::string* result);
-    // Dump app stats
-    void dumpAppLocked(std::string* result);
+    // Dump app stats, then clear them if clear is true
+    void dumpAppStats(std::string* result, bool clear);
     // Append cpuVulkanVersion and glesVersion to system driver stats
     void interceptSystemDriverStatsLocked();
     // Registers statsd callbacks if they have not already been registered
@@ -71,14 +73,29 @@ private:
     // Below limits the memory usage of GpuStats to be less than 10KB. This is
     // the preferred number for statsd while maintaining nice data quality.
     static const size_t MAX_NUM_APP_RECORDS = 100;
-    // GpuStats access should be guarded by mLock.
+    // App stats are split in shards with a lock each, so that the driver loading of different
+    // apps doesn't serialize on a single lock.
+    static const size_t NUM_APP_STATS_SHARDS = 8;
+    struct AppStatsShard {
+        // Access to stats should be guarded by lock.
+        std::mutex lock;
+        // Key is <app package name>+<driver version code>.
+        std::unordered_map<std::string, GpuStatsAppInfo> stats;
+    };
+    // Returns the shard holding the app stats of appStatsKey.
+    AppStatsShard& getAppStatsShard(const std::string& appStatsKey);
+
+    // Global stats access should be guarded by mLock.
     std::mutex mLock;
+    // Guards the registration of the statsd callbacks.
+    std::once_flag mStatsdRegisterOnce;
     // True if statsd callbacks have been registered.
     bool mStatsdRegistered = false;
     // Key is driver version code.
     std::unordered_map<uint64_t, GpuStatsGlobalInfo> mGlobalStats;
-    // Key is <app package name>+<driver version code>.
-    std::unordered_map<std::string, GpuStatsAppInfo> mAppStats;
+    std::array<AppStatsShard, NUM_APP_STATS_SHARDS> mAppStats;
+    // Number of app stats records in all the shards.
+    std::atomic<size_t> mNumAppRecords = 0;
 };
 
 } // namespace android
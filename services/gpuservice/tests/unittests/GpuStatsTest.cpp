@@ -253,6 +253,33 @@ TEST_F(GpuStatsTest, canDumpAppBeforeClearApp) {
     EXPECT_FALSE(inputCommand(InputCommand::DUMP_GLOBAL).empty());
 }
 
+TEST_F(GpuStatsTest, appStatsLimitedToMaxRecords) {
+    const size_t maxNumAppRecords = TestableGpuStats::getMaxNumAppRecords();
+    auto insertApps = [this](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            mGpuStats->insertDriverStats(BUILTIN_DRIVER_PKG_NAME, BUILTIN_DRIVER_VER_NAME,
+                                         BUILTIN_DRIVER_VER_CODE, BUILTIN_DRIVER_BUILD_TIME,
+                                         "testapp" + std::to_string(i), VULKAN_VERSION,
+                                         GpuStatsInfo::Driver::GL, true, DRIVER_LOADING_TIME_1);
+        }
+    };
+    auto countApps = [](const std::string& dump) {
+        size_t count = 0;
+        for (size_t pos = dump.find("appPackageName = "); pos != std::string::npos;
+             pos = dump.find("appPackageName = ", pos + 1)) {
+            count++;
+        }
+        return count;
+    };
+
+    insertApps(maxNumAppRecords + 10);
+    EXPECT_EQ(maxNumAppRecords, countApps(inputCommand(InputCommand::DUMP_APP_THEN_CLEAR)));
+
+    // Clearing the app stats makes room for new records.
+    insertApps(1);
+    EXPECT_EQ(1u, countApps(inputCommand(InputCommand::DUMP_APP)));
+}
+
 TEST_F(GpuStatsTest, skipPullInvalidAtom) {
     TestableGpuStats testableGpuStats(mGpuStats.get());
     mGpuStats->insertDriverStats(BUILTIN_DRIVER_PKG_NAME, BUILTIN_DRIVER_VER_NAME,
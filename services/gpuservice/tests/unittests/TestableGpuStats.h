@@ -29,6 +29,8 @@ public:
         return mGpuStats->pullAtomCallback(atomTag, nullptr, mGpuStats);
     }
 
+    static size_t getMaxNumAppRecords() { return GpuStats::MAX_NUM_APP_RECORDS; }
+
 private:
     GpuStats *mGpuStats;
 };
@@ -48,6 +48,10 @@ namespace android {
 //Max number of elements to store in mEvents.
 static constexpr size_t MAX_EVENTS = 5;
 
+// Time after an event happened by which its classification should be back from the HAL, to be
+// applied to the events that follow within the same frame.
+static constexpr nsecs_t CLASSIFICATION_DEADLINE = ms2ns(8);
+
 template<class K, class V>
 static V getValueForKey(const std::unordered_map<K, V>& map, K key, V defaultValue) {
     auto it = map.find(key);
@@ -218,6 +222,10 @@ void MotionClassifier::enqueueEvent(ClassifierEvent&& event) {
     if (!eventAdded) {
         // If the queue is full, suspect the HAL is slow in processing the events.
         ALOGE("Could not add the event to the queue. Resetting");
+        {
+            std::scoped_lock lock(mLock);
+            mStats.overflowResets++;
+        }
         reset();
     }
 }
@@ -230,12 +238,19 @@ void MotionClassifier::requestExit() {
 void MotionClassifier::updateClassification(int32_t deviceId, nsecs_t eventTime,
         MotionClassification classification) {
     std::scoped_lock lock(mLock);
+    const nsecs_t latency = systemTime(SYSTEM_TIME_MONOTONIC) - eventTime;
+    mStats.classified++;
+    mStats.maxLatency = std::max(mStats.maxLatency, latency);
+    if (latency > CLASSIFICATION_DEADLINE) {
+        mStats.missedDeadline++;
+    }
     const nsecs_t lastDownTime = getValueForKey(mLastDownTimes, deviceId, static_cast<nsecs_t>(0));
     if (eventTime < lastDownTime) {
         // HAL just finished processing an event that belonged to an earlier gesture,
         // but new gesture is already in progress. Drop this classification.
         ALOGW("Received late classification. Late by at least %" PRId64 " ms.",
                 nanoseconds_to_milliseconds(lastDownTime - eventTime));
+        mStats.dropped++;
         return;
     }
     mClassifications[deviceId] = classification;
@@ -297,7 +312,7 @@ void MotionClassifier::reset(const NotifyDeviceResetArgs& args) {
     enqueueEvent(std::make_unique<NotifyDeviceResetArgs>(args));
 }
 
-const char* MotionClassifier::getServiceStatus() REQUIRES(mLock) {
+const char* MotionClassifier::getServiceStatus() EXCLUDES(mLock) {
     if (!mService) {
         return "null";
     }
@@ -308,10 +323,19 @@ const char* MotionClassifier::getServiceStatus() REQUIRES(mLock) {
 }
 
 void MotionClassifier::dump(std::string& dump) {
-    std::scoped_lock lock(mLock);
+    // The HAL is pinged before taking mLock, which notifyMotion would otherwise wait on.
     dump += StringPrintf(INDENT2 "mService status: %s\n", getServiceStatus());
+    std::scoped_lock lock(mLock);
     dump += StringPrintf(INDENT2 "mEvents: %zu element(s) (max=%zu)\n",
             mEvents.size(), MAX_EVENTS);
+    dump += StringPrintf(INDENT2 "Classifications: %" PRIu64 ", %" PRIu64
+                                 " later than the %" PRId64 "ms deadline, %" PRIu64
+                                 " dropped as late; max latency %" PRId64 "us\n",
+                         mStats.classified, mStats.missedDeadline,
+                         nanoseconds_to_milliseconds(CLASSIFICATION_DEADLINE), mStats.dropped,
+                         nanoseconds_to_microseconds(mStats.maxLatency));
+    dump += StringPrintf(INDENT2 "Resets because the HAL fell behind: %" PRIu64 "\n",
+                         mStats.overflowResets);
     dump += INDENT2 "mClassifications, mLastDownTimes:\n";
     dump += INDENT3 "Device Id\tClassification\tLast down time";
     // Combine mClassifications and mLastDownTimes into a single table.
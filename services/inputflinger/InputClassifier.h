@@ -202,6 +202,22 @@ private:
 
     void updateLastDownTime(int32_t deviceId, nsecs_t downTime);
 
+    /**
+     * How well the HAL keeps up with the events, for dumpsys. Events are never held back for
+     * their classification, so an event whose classification comes back later than the deadline
+     * after it happened, and the events that came meanwhile, went on with the previous one.
+     */
+    struct Stats {
+        uint64_t classified = 0;
+        uint64_t missedDeadline = 0;
+        // Classifications dropped because they came back after their gesture had ended.
+        uint64_t dropped = 0;
+        // Times the queue of events to the HAL got full, and the HAL was reset.
+        uint64_t overflowResets = 0;
+        nsecs_t maxLatency = 0;
+    };
+    Stats mStats GUARDED_BY(mLock);
+
     void clearDeviceState(int32_t deviceId);
 
     /**
@@ -210,9 +226,9 @@ private:
      */
     void requestExit();
     /**
-     * Return string status of mService
+     * Return string status of mService. This calls the HAL, so mLock must not be held.
      */
-    const char* getServiceStatus() REQUIRES(mLock);
+    const char* getServiceStatus() EXCLUDES(mLock);
 };
 
 /**
@@ -24,8 +24,10 @@
 
 #include <binder/IPCThreadState.h>
 
+#include <inttypes.h>
 #include <log/log.h>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <private/android_filesystem_config.h>
 
@@ -122,12 +124,16 @@ public:
 binder::Status InputManager::setInputWindows(
         const std::vector<InputWindowInfo>& infos,
         const sp<ISetInputWindowsListener>& setInputWindowsListener) {
+    std::scoped_lock _l(mInputWindowsLock);
     std::unordered_map<int32_t, std::vector<sp<InputWindowHandle>>> handlesPerDisplay;
 
-    std::vector<sp<InputWindowHandle>> handles;
+    mInputWindowHandlesById.clear();
+    mInputWindowIdsByDisplay.clear();
     for (const auto& info : infos) {
-        handlesPerDisplay.emplace(info.displayId, std::vector<sp<InputWindowHandle>>());
-        handlesPerDisplay[info.displayId].push_back(new BinderWindowHandle(info));
+        sp<InputWindowHandle> handle = new BinderWindowHandle(info);
+        handlesPerDisplay[info.displayId].push_back(handle);
+        mInputWindowHandlesById.emplace(info.id, handle);
+        mInputWindowIdsByDisplay[info.displayId].push_back(info.id);
     }
     mDispatcher->setInputWindows(handlesPerDisplay);
 
@@ -137,6 +143,71 @@ binder::Status InputManager::setInputWindows(
     return binder::Status::ok();
 }
 
+binder::Status InputManager::updateInputWindows(
+        const std::vector<InputWindowInfo>& changedInfos, const std::vector<int32_t>& ids,
+        const sp<ISetInputWindowsListener>& setInputWindowsListener) {
+    std::scoped_lock _l(mInputWindowsLock);
+
+    // The handles are shared with the dispatcher, so a changed window gets a new handle rather
+    // than having its handle updated in place.
+    std::unordered_set<int32_t> changedDisplayIds;
+    for (const auto& info : changedInfos) {
+        sp<InputWindowHandle>& handle = mInputWindowHandlesById[info.id];
+        if (handle != nullptr) {
+            changedDisplayIds.insert(handle->getInfo()->displayId);
+        }
+        handle = new BinderWindowHandle(info);
+        changedDisplayIds.insert(info.displayId);
+    }
+
+    const std::unordered_set<int32_t> idSet(ids.begin(), ids.end());
+    for (auto it = mInputWindowHandlesById.begin(); it != mInputWindowHandlesById.end();) {
+        it = idSet.count(it->first) ? std::next(it) : mInputWindowHandlesById.erase(it);
+    }
+    std::unordered_map<int32_t, std::vector<int32_t>> idsByDisplay;
+    for (int32_t id : ids) {
+        auto it = mInputWindowHandlesById.find(id);
+        if (it == mInputWindowHandlesById.end()) {
+            ALOGE("Input window %" PRId32 " was never set, ignoring it", id);
+            continue;
+        }
+        idsByDisplay[it->second->getInfo()->displayId].push_back(id);
+    }
+
+    // Only the displays whose windows were added, removed, reordered or changed are updated.
+    for (const auto& [displayId, oldIds] : mInputWindowIdsByDisplay) {
+        auto it = idsByDisplay.find(displayId);
+        if (it == idsByDisplay.end() || it->second != oldIds) {
+            changedDisplayIds.insert(displayId);
+        }
+    }
+    for (const auto& [displayId, newIds] : idsByDisplay) {
+        if (mInputWindowIdsByDisplay.find(displayId) == mInputWindowIdsByDisplay.end()) {
+            changedDisplayIds.insert(displayId);
+        }
+    }
+    std::unordered_map<int32_t, std::vector<sp<InputWindowHandle>>> handlesPerDisplay;
+    for (int32_t displayId : changedDisplayIds) {
+        // A display without windows left gets an empty list, which removes its windows.
+        std::vector<sp<InputWindowHandle>>& handles = handlesPerDisplay[displayId];
+        auto it = idsByDisplay.find(displayId);
+        if (it != idsByDisplay.end()) {
+            for (int32_t id : it->second) {
+                handles.push_back(mInputWindowHandlesById[id]);
+            }
+        }
+    }
+    mInputWindowIdsByDisplay = std::move(idsByDisplay);
+    if (!handlesPerDisplay.empty()) {
+        mDispatcher->setInputWindows(handlesPerDisplay);
+    }
+
+    if (setInputWindowsListener) {
+        setInputWindowsListener->onSetInputWindowsFinished();
+    }
+    return binder::Status::ok();
+}
+
 // Used by tests only.
 binder::Status InputManager::createInputChannel(const std::string& name, InputChannel* outChannel) {
     IPCThreadState* ipc = IPCThreadState::self();
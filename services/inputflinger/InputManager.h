@@ -37,6 +37,10 @@
 #include <utils/Timers.h>
 #include <utils/Vector.h>
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 using android::os::BnInputFlinger;
 using android::os::ISetInputWindowsListener;
 
@@ -107,6 +111,9 @@ public:
     binder::Status setInputWindows(
             const std::vector<InputWindowInfo>& handles,
             const sp<ISetInputWindowsListener>& setInputWindowsListener) override;
+    binder::Status updateInputWindows(
+            const std::vector<InputWindowInfo>& changedInfos, const std::vector<int32_t>& ids,
+            const sp<ISetInputWindowsListener>& setInputWindowsListener) override;
 
     binder::Status createInputChannel(const std::string& name, InputChannel* outChannel) override;
     binder::Status removeInputChannel(const sp<IBinder>& connectionToken) override;
@@ -118,6 +125,11 @@ private:
     sp<InputClassifierInterface> mClassifier;
 
     sp<InputDispatcherInterface> mDispatcher;
+
+    // The input windows last set by SurfaceFlinger, that updateInputWindows applies changes to.
+    std::mutex mInputWindowsLock;
+    std::unordered_map<int32_t /*id*/, sp<InputWindowHandle>> mInputWindowHandlesById;
+    std::unordered_map<int32_t /*displayId*/, std::vector<int32_t>> mInputWindowIdsByDisplay;
 };
 
 } // namespace android
@@ -208,6 +208,10 @@ public:
         return true;
     }
 
+    void setFrame(const Rect& frame) { mFrame = frame; }
+
+    void setFlags(Flags<InputWindowInfo::Flag> flags) { mInfo.flags = flags; }
+
 protected:
     Rect mFrame;
 };
@@ -281,6 +285,7 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
     dispatcher->setInputWindows({{ADISPLAY_ID_DEFAULT, {window}}});
 
     NotifyMotionArgs motionArgs = generateMotionArgs();
+    const uint64_t entryHeapAllocations = EntryPool::getHeapAllocationCount();
 
     for (auto _ : state) {
         // Send ACTION_DOWN
@@ -298,6 +303,10 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
         window->consumeEvent();
     }
 
+    // Event and dispatch entries come from pools, so this should only count the first iterations.
+    state.counters["EntryHeapAllocations"] =
+            benchmark::Counter(EntryPool::getHeapAllocationCount() - entryHeapAllocations,
+                               benchmark::Counter::kAvgIterations);
     dispatcher->stop();
 }
 
@@ -334,8 +343,56 @@ static void benchmarkInjectMotion(benchmark::State& state) {
     dispatcher->stop();
 }
 
+static void benchmarkNotifyMotionManyWindows(benchmark::State& state) {
+    // Create dispatcher
+    sp<FakeInputDispatcherPolicy> fakePolicy = new FakeInputDispatcherPolicy();
+    sp<InputDispatcher> dispatcher = new InputDispatcher(fakePolicy);
+    dispatcher->setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher->start();
+
+    // Create a window that will receive motion events, behind rows of small windows that do
+    // not contain the touch, as a launcher or a dense app would have.
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window = new FakeWindowHandle(application, dispatcher, "Fake Window");
+    std::vector<sp<InputWindowHandle>> windowHandles;
+    constexpr int32_t TILE_SIZE = 50;
+    constexpr int32_t TILES_PER_ROW = 20;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        sp<FakeWindowHandle> tile = new FakeWindowHandle(application, dispatcher, "Fake Tile");
+        const int32_t left = (i % TILES_PER_ROW) * TILE_SIZE;
+        const int32_t top = FakeWindowHandle::HEIGHT + (i / TILES_PER_ROW) * TILE_SIZE;
+        tile->setFrame(Rect(left, top, left + TILE_SIZE, top + TILE_SIZE));
+        tile->setFlags(InputWindowInfo::Flag::NOT_TOUCH_MODAL);
+        windowHandles.push_back(tile);
+    }
+    windowHandles.push_back(window);
+
+    dispatcher->setInputWindows({{ADISPLAY_ID_DEFAULT, windowHandles}});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    for (auto _ : state) {
+        // Send ACTION_DOWN
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher->notifyMotion(&motionArgs);
+
+        // Send ACTION_UP
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher->notifyMotion(&motionArgs);
+
+        window->consumeEvent();
+        window->consumeEvent();
+    }
+
+    dispatcher->stop();
+}
+
 BENCHMARK(benchmarkNotifyMotion);
 BENCHMARK(benchmarkInjectMotion);
+BENCHMARK(benchmarkNotifyMotionManyWindows)->Arg(8)->Arg(64)->Arg(256);
 
 } // namespace android::inputdispatcher
 
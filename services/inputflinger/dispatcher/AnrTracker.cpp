@@ -18,13 +18,15 @@
 
 namespace android::inputdispatcher {
 
-template <typename T>
-static T max(const T& a, const T& b) {
-    return a < b ? b : a;
-}
-
 void AnrTracker::insert(nsecs_t timeoutTime, sp<IBinder> token) {
-    mAnrTimeouts.insert(std::make_pair(timeoutTime, std::move(token)));
+    std::multiset<nsecs_t>& timeouts = mTimeoutsByToken[token];
+    if (timeouts.empty() || timeoutTime < *timeouts.begin()) {
+        if (!timeouts.empty()) {
+            mFirstTimeouts.erase(std::make_pair(*timeouts.begin(), token));
+        }
+        mFirstTimeouts.insert(std::make_pair(timeoutTime, token));
+    }
+    timeouts.insert(timeoutTime);
 }
 
 /**
@@ -32,42 +34,57 @@ void AnrTracker::insert(nsecs_t timeoutTime, sp<IBinder> token) {
  * (same time, same connection), then only remove one of them.
  */
 void AnrTracker::erase(nsecs_t timeoutTime, const sp<IBinder>& token) {
-    auto pair = std::make_pair(timeoutTime, token);
-    auto it = mAnrTimeouts.find(pair);
-    if (it != mAnrTimeouts.end()) {
-        mAnrTimeouts.erase(it);
+    auto timeoutsIt = mTimeoutsByToken.find(token);
+    if (timeoutsIt == mTimeoutsByToken.end()) {
+        return;
+    }
+    std::multiset<nsecs_t>& timeouts = timeoutsIt->second;
+    auto it = timeouts.find(timeoutTime);
+    if (it == timeouts.end()) {
+        return;
+    }
+    if (it != timeouts.begin()) {
+        timeouts.erase(it);
+        return;
+    }
+    mFirstTimeouts.erase(std::make_pair(timeoutTime, token));
+    timeouts.erase(it);
+    if (timeouts.empty()) {
+        mTimeoutsByToken.erase(timeoutsIt);
+    } else {
+        mFirstTimeouts.insert(std::make_pair(*timeouts.begin(), token));
     }
 }
 
 void AnrTracker::eraseToken(const sp<IBinder>& token) {
-    for (auto it = mAnrTimeouts.begin(); it != mAnrTimeouts.end();) {
-        if (it->second == token) {
-            it = mAnrTimeouts.erase(it);
-        } else {
-            ++it;
-        }
+    auto timeoutsIt = mTimeoutsByToken.find(token);
+    if (timeoutsIt == mTimeoutsByToken.end()) {
+        return;
     }
+    mFirstTimeouts.erase(std::make_pair(*timeoutsIt->second.begin(), token));
+    mTimeoutsByToken.erase(timeoutsIt);
 }
 
 bool AnrTracker::empty() const {
-    return mAnrTimeouts.empty();
+    return mFirstTimeouts.empty();
 }
 
 // If empty() is false, return the time at which the next connection should cause an ANR
 // If empty() is true, return LONG_LONG_MAX
 nsecs_t AnrTracker::firstTimeout() const {
-    if (mAnrTimeouts.empty()) {
+    if (mFirstTimeouts.empty()) {
         return std::numeric_limits<nsecs_t>::max();
     }
-    return mAnrTimeouts.begin()->first;
+    return mFirstTimeouts.begin()->first;
 }
 
 const sp<IBinder>& AnrTracker::firstToken() const {
-    return mAnrTimeouts.begin()->second;
+    return mFirstTimeouts.begin()->second;
 }
 
 void AnrTracker::clear() {
-    mAnrTimeouts.clear();
+    mTimeoutsByToken.clear();
+    mFirstTimeouts.clear();
 }
 
 } // namespace android::inputdispatcher
@@ -20,6 +20,7 @@
 #include <binder/IBinder.h>
 #include <utils/Timers.h>
 #include <set>
+#include <unordered_map>
 
 namespace android::inputdispatcher {
 
@@ -43,16 +44,26 @@ public:
     const sp<IBinder>& firstToken() const;
 
 private:
-    // Optimization: use a multiset to keep track of the event timeouts. When an event is sent
-    // to the InputConsumer, we add an entry to this structure. We look at the smallest value to
-    // determine if any of the connections is unresponsive, and to determine when we should wake
-    // next for the future ANR check.
-    // Using a multiset helps quickly look up the next timeout due.
+    struct IBinderHash {
+        std::size_t operator()(const sp<IBinder>& b) const {
+            return std::hash<IBinder*>{}(b.get());
+        }
+    };
+
+    // Optimization: the event timeouts are kept per connection. When an event is sent to the
+    // InputConsumer, we add its timeout to the connection's multiset, and only the earliest
+    // timeout of each connection is kept in mFirstTimeouts. We look at the smallest value there
+    // to determine if any of the connections is unresponsive, and to determine when we should
+    // wake next for the future ANR check. Removing an entry, or all the entries of a connection,
+    // then only touches that connection's timeouts, however many events the others are waiting
+    // on.
     //
     // We must use a multi-set, because it is plausible (although highly unlikely) to have entries
     // from the same connection and same timestamp, but different sequence numbers.
     // We are not tracking sequence numbers, and just allow duplicates to exist.
-    std::multiset<std::pair<nsecs_t /*timeoutTime*/, sp<IBinder> /*connectionToken*/>> mAnrTimeouts;
+    std::unordered_map<sp<IBinder>, std::multiset<nsecs_t /*timeoutTime*/>, IBinderHash>
+            mTimeoutsByToken;
+    std::set<std::pair<nsecs_t /*timeoutTime*/, sp<IBinder> /*connectionToken*/>> mFirstTimeouts;
 };
 
 } // namespace android::inputdispatcher
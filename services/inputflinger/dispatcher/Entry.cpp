@@ -22,6 +22,8 @@
 #include <android-base/stringprintf.h>
 #include <cutils/atomic.h>
 #include <inttypes.h>
+#include <log/log.h>
+#include <atomic>
 
 using android::base::GetBoolProperty;
 using android::base::StringPrintf;
@@ -55,6 +57,42 @@ VerifiedMotionEvent verifiedMotionEventFromMotionEntry(const MotionEntry& entry)
             entry.buttonState};
 }
 
+// --- EntryPool ---
+
+static std::atomic<uint64_t> sEntryPoolHeapAllocationCount(0);
+
+EntryPool::EntryPool(size_t blockSize) : mBlockSize(blockSize) {
+    mFreeBlocks.reserve(MAX_FREE_BLOCKS);
+}
+
+void* EntryPool::allocate() {
+    {
+        std::scoped_lock _l(mLock);
+        if (!mFreeBlocks.empty()) {
+            void* block = mFreeBlocks.back();
+            mFreeBlocks.pop_back();
+            return block;
+        }
+    }
+    sEntryPoolHeapAllocationCount++;
+    return ::operator new(mBlockSize);
+}
+
+void EntryPool::deallocate(void* block) {
+    {
+        std::scoped_lock _l(mLock);
+        if (mFreeBlocks.size() < MAX_FREE_BLOCKS) {
+            mFreeBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+uint64_t EntryPool::getHeapAllocationCount() {
+    return sEntryPoolHeapAllocationCount;
+}
+
 // --- EventEntry ---
 
 EventEntry::EventEntry(int32_t id, Type type, nsecs_t eventTime, uint32_t policyFlags)
@@ -307,6 +345,16 @@ DispatchEntry::DispatchEntry(std::shared_ptr<EventEntry> eventEntry, int32_t tar
         resolvedAction(0),
         resolvedFlags(0) {}
 
+void* DispatchEntry::operator new(size_t size) {
+    LOG_ALWAYS_FATAL_IF(size != sizeof(DispatchEntry), "Unexpected size %zu for a DispatchEntry",
+                        size);
+    return EntryPool::get<DispatchEntry>().allocate();
+}
+
+void DispatchEntry::operator delete(void* dispatchEntry) {
+    EntryPool::get<DispatchEntry>().deallocate(dispatchEntry);
+}
+
 uint32_t DispatchEntry::nextSeq() {
     // Sequence number 0 is reserved and will never be returned.
     uint32_t seq;
@@ -20,15 +20,88 @@
 #include "InjectionState.h"
 #include "InputTarget.h"
 
+#include <android-base/thread_annotations.h>
 #include <input/Input.h>
 #include <input/InputApplication.h>
 #include <stdint.h>
 #include <utils/Timers.h>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace android::inputdispatcher {
 
+// A pool of memory blocks of one size, that keeps freed blocks for reuse so that the entries
+// created for a steady stream of events don't need to be allocated from the heap.
+class EntryPool {
+public:
+    explicit EntryPool(size_t blockSize);
+
+    void* allocate();
+    void deallocate(void* block);
+
+    // Returns the pool for objects of type T. Pools are never destroyed, so that entries may be
+    // freed at any time.
+    template <typename T>
+    static EntryPool& get() {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        static EntryPool* pool = new EntryPool(sizeof(T));
+        return *pool;
+    }
+
+    // Returns how many blocks all the pools have allocated from the heap.
+    static uint64_t getHeapAllocationCount();
+
+private:
+    static constexpr size_t MAX_FREE_BLOCKS = 256;
+
+    const size_t mBlockSize;
+    std::mutex mLock;
+    std::vector<void*> mFreeBlocks GUARDED_BY(mLock);
+};
+
+// An allocator that takes single objects from an EntryPool.
+template <typename T>
+struct EntryAllocator {
+    using value_type = T;
+
+    EntryAllocator() = default;
+    template <typename U>
+    EntryAllocator(const EntryAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(EntryPool::get<T>().allocate());
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n != 1) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        EntryPool::get<T>().deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const EntryAllocator<U>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const EntryAllocator<U>&) const {
+        return false;
+    }
+};
+
+// Creates an entry in a single block, shared with its control block, taken from an EntryPool.
+template <typename T, typename... Args>
+std::shared_ptr<T> createPooledEntry(Args&&... args) {
+    return std::allocate_shared<T>(EntryAllocator<T>(), std::forward<Args>(args)...);
+}
+
 struct EventEntry {
     enum class Type {
         CONFIGURATION_CHANGED,
@@ -234,6 +307,10 @@ struct DispatchEntry {
 
     inline bool isSplit() const { return targetFlags & InputTarget::FLAG_SPLIT; }
 
+    // Dispatch entries are created for every target of every event, so they come from a pool.
+    static void* operator new(size_t size);
+    static void operator delete(void* dispatchEntry);
+
 private:
     static volatile int32_t sNextSeqAtomic;
 
@@ -274,7 +351,7 @@ struct CommandEntry {
     sp<Connection> connection;
     nsecs_t eventTime;
     std::shared_ptr<KeyEntry> keyEntry;
-    std::shared_ptr<SensorEntry> sensorEntry;
+    std::vector<std::shared_ptr<SensorEntry>> sensorEntries;
     std::shared_ptr<InputApplicationHandle> inputApplicationHandle;
     std::string reason;
     int32_t userActivityEventType;
@@ -49,6 +49,7 @@ static constexpr bool DEBUG_TOUCH_OCCLUSION = true;
 
 #include <android-base/chrono_utils.h>
 #include <android-base/properties.h>
+#include <android-base/scopeguard.h>
 #include <android-base/stringprintf.h>
 #include <android/os/IInputConstants.h>
 #include <binder/Binder.h>
@@ -126,6 +127,12 @@ constexpr std::chrono::nanoseconds KEY_WAITING_FOR_EVENTS_TIMEOUT = 500ms;
 // Number of recent events to keep for debugging purposes.
 constexpr size_t RECENT_QUEUE_MAX_SIZE = 10;
 
+// Minimum number of windows on a display for hit tests to use a WindowSpatialIndex.
+constexpr size_t MIN_WINDOWS_FOR_SPATIAL_INDEX = 32;
+
+// Maximum number of events published to a connection with a single write.
+constexpr size_t MAX_PUBLISH_BATCH_SIZE = 16;
+
 // Event log tags. See EventLogTags.logtags for reference
 constexpr int LOGTAG_INPUT_INTERACTION = 62000;
 constexpr int LOGTAG_INPUT_FOCUS = 62001;
@@ -509,6 +516,7 @@ static bool shouldReportFinishedEvent(const DispatchEntry& dispatchEntry,
 InputDispatcher::InputDispatcher(const sp<InputDispatcherPolicyInterface>& policy)
       : mPolicy(policy),
         mPendingEvent(nullptr),
+        mStagedInputFilterEnabled(false),
         mLastDropReason(DropReason::NOT_DROPPED),
         mIdGenerator(IdGenerator::Source::INPUT_DISPATCHER),
         mAppSwitchSawKeyDown(false),
@@ -683,6 +691,9 @@ std::chrono::nanoseconds InputDispatcher::getDispatchingTimeoutLocked(const sp<I
 void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
     nsecs_t currentTime = now();
 
+    // Pick up the events that were notified while the lock was held.
+    moveStagedInboundEventsLocked();
+
     // Reset the key repeat timer whenever normal dispatch is suspended while the
     // device is in a non-interactive state.  This is to ensure that we abort a key
     // repeat if the device is just coming out of sleep.
@@ -927,7 +938,62 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
     return false;
 }
 
-bool InputDispatcher::enqueueInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
+bool InputDispatcher::enqueueInboundEventLocked(std::shared_ptr<EventEntry> newEntry) {
+    // The staged events were notified before this one, so they must be enqueued first.
+    bool needWake = moveStagedInboundEventsLocked();
+    return appendInboundEventLocked(std::move(newEntry)) || needWake;
+}
+
+bool InputDispatcher::stageInboundEventLocked(std::shared_ptr<EventEntry> newEntry,
+                                              nsecs_t readTime) {
+    // The dispatcher thread only needs to be woken by the first staged event. It moves all of the
+    // staged events at once.
+    bool needWake = mStagedInboundEvents.empty();
+    mStagedInboundEvents.push_back({std::move(newEntry), readTime});
+    return needWake;
+}
+
+bool InputDispatcher::moveStagedInboundEventsLocked() {
+    {
+        std::scoped_lock _l(mStagedInboundLock);
+        if (mStagedInboundEvents.empty()) {
+            return false;
+        }
+        // Swap the buffers rather than moving the events, so that neither of them reallocates
+        // in the steady state.
+        mMovingInboundEvents.swap(mStagedInboundEvents);
+    }
+
+    bool needWake = false;
+    for (StagedInboundEvent& stagedEvent : mMovingInboundEvents) {
+        trackInboundEventLatencyLocked(*stagedEvent.entry, stagedEvent.readTime);
+        needWake |= appendInboundEventLocked(std::move(stagedEvent.entry));
+    }
+    mMovingInboundEvents.clear();
+    return needWake;
+}
+
+void InputDispatcher::trackInboundEventLatencyLocked(const EventEntry& entry, nsecs_t readTime) {
+    // Only track the events that come straight from the hardware.
+    if (entry.id == android::os::IInputConstants::INVALID_INPUT_EVENT_ID ||
+        IdGenerator::getSource(entry.id) != IdGenerator::Source::INPUT_READER ||
+        (entry.policyFlags & POLICY_FLAG_FILTERED)) {
+        return;
+    }
+    if (entry.type == EventEntry::Type::KEY) {
+        const KeyEntry& keyEntry = static_cast<const KeyEntry&>(entry);
+        const bool isDown = keyEntry.action == AKEY_EVENT_ACTION_DOWN;
+        mLatencyTracker.trackListener(entry.id, isDown, entry.eventTime, readTime,
+                                      keyEntry.deviceId);
+    } else if (entry.type == EventEntry::Type::MOTION) {
+        const MotionEntry& motionEntry = static_cast<const MotionEntry&>(entry);
+        const bool isDown = motionEntry.action == AMOTION_EVENT_ACTION_DOWN;
+        mLatencyTracker.trackListener(entry.id, isDown, entry.eventTime, readTime,
+                                      motionEntry.deviceId);
+    }
+}
+
+bool InputDispatcher::appendInboundEventLocked(std::shared_ptr<EventEntry> newEntry) {
     bool needWake = mInboundQueue.empty();
     mInboundQueue.push_back(std::move(newEntry));
     EventEntry& entry = *(mInboundQueue.back());
@@ -1001,7 +1067,8 @@ sp<InputWindowHandle> InputDispatcher::findTouchedWindowAtLocked(int32_t display
     }
     // Traverse windows from front to back to find touched window.
     const std::vector<sp<InputWindowHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<InputWindowHandle>& windowHandle : windowHandles) {
+    for (size_t i : getWindowIndexesAtLocked(displayId, x, y)) {
+        const sp<InputWindowHandle>& windowHandle = windowHandles[i];
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
         }
@@ -1179,6 +1246,7 @@ void InputDispatcher::postCommandLocked(std::unique_ptr<CommandEntry> commandEnt
 }
 
 void InputDispatcher::drainInboundQueueLocked() {
+    moveStagedInboundEventsLocked();
     while (!mInboundQueue.empty()) {
         std::shared_ptr<EventEntry> entry = mInboundQueue.front();
         mInboundQueue.pop_front();
@@ -1221,10 +1289,10 @@ std::shared_ptr<KeyEntry> InputDispatcher::synthesizeKeyRepeatLocked(nsecs_t cur
             (POLICY_FLAG_RAW_MASK | POLICY_FLAG_PASS_TO_USER | POLICY_FLAG_TRUSTED);
 
     std::shared_ptr<KeyEntry> newEntry =
-            std::make_unique<KeyEntry>(mIdGenerator.nextId(), currentTime, entry->deviceId,
-                                       entry->source, entry->displayId, policyFlags, entry->action,
-                                       entry->flags, entry->keyCode, entry->scanCode,
-                                       entry->metaState, entry->repeatCount + 1, entry->downTime);
+            createPooledEntry<KeyEntry>(mIdGenerator.nextId(), currentTime, entry->deviceId,
+                                        entry->source, entry->displayId, policyFlags, entry->action,
+                                        entry->flags, entry->keyCode, entry->scanCode,
+                                        entry->metaState, entry->repeatCount + 1, entry->downTime);
 
     newEntry->syntheticRepeat = true;
     mKeyRepeatState.lastKeyEntry = newEntry;
@@ -1484,12 +1552,13 @@ void InputDispatcher::logOutboundKeyDetails(const char* prefix, const KeyEntry&
 void InputDispatcher::doNotifySensorLockedInterruptible(CommandEntry* commandEntry) {
     mLock.unlock();
 
-    const std::shared_ptr<SensorEntry>& entry = commandEntry->sensorEntry;
-    if (entry->accuracyChanged) {
-        mPolicy->notifySensorAccuracy(entry->deviceId, entry->sensorType, entry->accuracy);
+    for (const std::shared_ptr<SensorEntry>& entry : commandEntry->sensorEntries) {
+        if (entry->accuracyChanged) {
+            mPolicy->notifySensorAccuracy(entry->deviceId, entry->sensorType, entry->accuracy);
+        }
+        mPolicy->notifySensorEvent(entry->deviceId, entry->sensorType, entry->accuracy,
+                                   entry->hwTimestamp, entry->values);
     }
-    mPolicy->notifySensorEvent(entry->deviceId, entry->sensorType, entry->accuracy,
-                               entry->hwTimestamp, entry->values);
     mLock.lock();
 }
 
@@ -1503,7 +1572,21 @@ void InputDispatcher::dispatchSensorLocked(nsecs_t currentTime, std::shared_ptr<
 #endif
     std::unique_ptr<CommandEntry> commandEntry =
             std::make_unique<CommandEntry>(&InputDispatcher::doNotifySensorLockedInterruptible);
-    commandEntry->sensorEntry = entry;
+    commandEntry->sensorEntries.push_back(entry);
+    if (*dropReason == DropReason::NOT_DROPPED) {
+        // Sensors can report samples at a high rate, so the samples queued right behind this one
+        // go to the policy with it rather than each in a command of their own.
+        const nsecs_t bootTime = systemTime(SYSTEM_TIME_BOOTTIME);
+        while (!mInboundQueue.empty() && mInboundQueue.front()->type == EventEntry::Type::SENSOR &&
+               !isStaleEvent(bootTime, *mInboundQueue.front())) {
+            std::shared_ptr<SensorEntry> sensorEntry =
+                    std::static_pointer_cast<SensorEntry>(mInboundQueue.front());
+            mInboundQueue.pop_front();
+            releaseInboundEventLocked(sensorEntry);
+            commandEntry->sensorEntries.push_back(std::move(sensorEntry));
+        }
+        traceInboundQueueLengthLocked();
+    }
     postCommandLocked(std::move(commandEntry));
 }
 
@@ -1515,13 +1598,19 @@ bool InputDispatcher::flushSensor(int deviceId, InputDeviceSensorType sensorType
     { // acquire lock
         std::scoped_lock _l(mLock);
 
-        for (auto it = mInboundQueue.begin(); it != mInboundQueue.end(); it++) {
+        for (auto it = mInboundQueue.begin(); it != mInboundQueue.end();) {
             std::shared_ptr<EventEntry> entry = *it;
             if (entry->type == EventEntry::Type::SENSOR) {
-                it = mInboundQueue.erase(it);
-                releaseInboundEventLocked(entry);
+                const SensorEntry& sensorEntry = static_cast<const SensorEntry&>(*entry);
+                if (sensorEntry.deviceId == deviceId && sensorEntry.sensorType == sensorType) {
+                    it = mInboundQueue.erase(it);
+                    releaseInboundEventLocked(entry);
+                    continue;
+                }
             }
+            it++;
         }
+        traceInboundQueueLengthLocked();
     }
     return true;
 }
@@ -1923,7 +2012,11 @@ InputEventInjectionResult InputDispatcher::findTouchedWindowTargetsLocked(
     // This state will be used to update mTouchStatesByDisplay at the end of this function.
     // If no state for the specified display exists, then our initial state will be empty.
     const TouchState* oldState = nullptr;
-    TouchState tempTouchState;
+    TouchState& tempTouchState = mTempTouchState;
+    // Releases the window handles, but not the storage, once the event is handled.
+    auto resetTempTouchState = android::base::make_scope_guard([&tempTouchState] {
+        tempTouchState.reset();
+    });
     std::unordered_map<int32_t, TouchState>::iterator oldStateIt =
             mTouchStatesByDisplay.find(displayId);
     if (oldStateIt != mTouchStatesByDisplay.end()) {
@@ -2564,10 +2657,9 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
     info.obscuringOpacity = 0;
     info.obscuringUid = -1;
     std::map<int32_t, float> opacityByUid;
-    for (const sp<InputWindowHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
+    // Only the windows above us are returned.
+    for (size_t i : getWindowIndexesAtLocked(displayId, x, y, windowHandle)) {
+        const sp<InputWindowHandle>& otherHandle = windowHandles[i];
         const InputWindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) && otherInfo->frameContainsPoint(x, y) &&
             !haveSameApplicationToken(windowInfo, otherInfo)) {
@@ -2645,10 +2737,9 @@ bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<InputWindowHandle>&
                                                     int32_t x, int32_t y) const {
     int32_t displayId = windowHandle->getInfo()->displayId;
     const std::vector<sp<InputWindowHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<InputWindowHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
+    // Only the windows above us are returned.
+    for (size_t i : getWindowIndexesAtLocked(displayId, x, y, windowHandle)) {
+        const sp<InputWindowHandle>& otherHandle = windowHandles[i];
         const InputWindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) &&
             otherInfo->frameContainsPoint(x, y)) {
@@ -3081,125 +3172,43 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
     ALOGD("channel '%s' ~ startDispatchCycle", connection->getInputChannelName().c_str());
 #endif
 
+    const std::chrono::nanoseconds timeout =
+            getDispatchingTimeoutLocked(connection->inputChannel->getConnectionToken());
     while (connection->status == Connection::STATUS_NORMAL && !connection->outboundQueue.empty()) {
-        DispatchEntry* dispatchEntry = connection->outboundQueue.front();
-        dispatchEntry->deliveryTime = currentTime;
-        const std::chrono::nanoseconds timeout =
-                getDispatchingTimeoutLocked(connection->inputChannel->getConnectionToken());
-        dispatchEntry->timeoutTime = currentTime + timeout.count();
-
-        // Publish the event.
-        status_t status;
-        const EventEntry& eventEntry = *(dispatchEntry->eventEntry);
-        switch (eventEntry.type) {
-            case EventEntry::Type::KEY: {
-                const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
-                std::array<uint8_t, 32> hmac = getSignature(keyEntry, *dispatchEntry);
-
-                // Publish the key event.
-                status = connection->inputPublisher
-                                 .publishKeyEvent(dispatchEntry->seq,
-                                                  dispatchEntry->resolvedEventId, keyEntry.deviceId,
-                                                  keyEntry.source, keyEntry.displayId,
-                                                  std::move(hmac), dispatchEntry->resolvedAction,
-                                                  dispatchEntry->resolvedFlags, keyEntry.keyCode,
-                                                  keyEntry.scanCode, keyEntry.metaState,
-                                                  keyEntry.repeatCount, keyEntry.downTime,
-                                                  keyEntry.eventTime);
-                break;
-            }
-
-            case EventEntry::Type::MOTION: {
-                const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
-
-                PointerCoords scaledCoords[MAX_POINTERS];
-                const PointerCoords* usingCoords = motionEntry.pointerCoords;
-
-                // Set the X and Y offset and X and Y scale depending on the input source.
-                if ((motionEntry.source & AINPUT_SOURCE_CLASS_POINTER) &&
-                    !(dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS)) {
-                    float globalScaleFactor = dispatchEntry->globalScaleFactor;
-                    if (globalScaleFactor != 1.0f) {
-                        for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
-                            scaledCoords[i] = motionEntry.pointerCoords[i];
-                            // Don't apply window scale here since we don't want scale to affect raw
-                            // coordinates. The scale will be sent back to the client and applied
-                            // later when requesting relative coordinates.
-                            scaledCoords[i].scale(globalScaleFactor, 1 /* windowXScale */,
-                                                  1 /* windowYScale */);
-                        }
-                        usingCoords = scaledCoords;
-                    }
-                } else {
-                    // We don't want the dispatch target to know.
-                    if (dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS) {
-                        for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
-                            scaledCoords[i].clear();
-                        }
-                        usingCoords = scaledCoords;
-                    }
-                }
-
-                std::array<uint8_t, 32> hmac = getSignature(motionEntry, *dispatchEntry);
-
-                // Publish the motion event.
-                status = connection->inputPublisher
-                                 .publishMotionEvent(dispatchEntry->seq,
-                                                     dispatchEntry->resolvedEventId,
-                                                     motionEntry.deviceId, motionEntry.source,
-                                                     motionEntry.displayId, std::move(hmac),
-                                                     dispatchEntry->resolvedAction,
-                                                     motionEntry.actionButton,
-                                                     dispatchEntry->resolvedFlags,
-                                                     motionEntry.edgeFlags, motionEntry.metaState,
-                                                     motionEntry.buttonState,
-                                                     motionEntry.classification,
-                                                     dispatchEntry->transform,
-                                                     motionEntry.xPrecision, motionEntry.yPrecision,
-                                                     motionEntry.xCursorPosition,
-                                                     motionEntry.yCursorPosition,
-                                                     dispatchEntry->displaySize.x,
-                                                     dispatchEntry->displaySize.y,
-                                                     motionEntry.downTime, motionEntry.eventTime,
-                                                     motionEntry.pointerCount,
-                                                     motionEntry.pointerProperties, usingCoords);
-                break;
-            }
-
-            case EventEntry::Type::FOCUS: {
-                const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
-                status = connection->inputPublisher.publishFocusEvent(dispatchEntry->seq,
-                                                                      focusEntry.id,
-                                                                      focusEntry.hasFocus,
-                                                                      mInTouchMode);
-                break;
-            }
-
-            case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
-                const auto& captureEntry =
-                        static_cast<const PointerCaptureChangedEntry&>(eventEntry);
-                status = connection->inputPublisher
-                                 .publishCaptureEvent(dispatchEntry->seq, captureEntry.id,
-                                                      captureEntry.pointerCaptureEnabled);
+        // Publish the events at the front of the outbound queue with a single write.
+        connection->inputPublisher.beginBatch();
+        status_t status = OK;
+        size_t batchSize = 0;
+        for (DispatchEntry* dispatchEntry : connection->outboundQueue) {
+            if (batchSize == MAX_PUBLISH_BATCH_SIZE) {
                 break;
             }
-
-            case EventEntry::Type::DRAG: {
-                const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
-                status = connection->inputPublisher.publishDragEvent(dispatchEntry->seq,
-                                                                     dragEntry.id, dragEntry.x,
-                                                                     dragEntry.y,
-                                                                     dragEntry.isExiting);
+            dispatchEntry->deliveryTime = currentTime;
+            dispatchEntry->timeoutTime = currentTime + timeout.count();
+            status = publishDispatchEntryLocked(connection, dispatchEntry);
+            if (status) {
                 break;
             }
+            batchSize++;
+        }
+        size_t publishedCount;
+        const status_t flushStatus = connection->inputPublisher.flush(&publishedCount);
+        if (flushStatus) {
+            // The first event that could not be sent comes before any that failed to publish.
+            status = flushStatus;
+        }
 
-            case EventEntry::Type::CONFIGURATION_CHANGED:
-            case EventEntry::Type::DEVICE_RESET:
-            case EventEntry::Type::SENSOR: {
-                LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
-                                 NamedEnum::string(eventEntry.type).c_str());
-                return;
+        // Re-enqueue the published events on the wait queue.
+        for (size_t i = 0; i < publishedCount; i++) {
+            DispatchEntry* dispatchEntry = connection->outboundQueue.front();
+            connection->outboundQueue.pop_front();
+            traceOutboundQueueLength(*connection);
+            connection->waitQueue.push_back(dispatchEntry);
+            if (connection->responsive) {
+                mAnrTracker.insert(dispatchEntry->timeoutTime,
+                                   connection->inputChannel->getConnectionToken());
             }
+            traceWaitQueueLength(*connection);
         }
 
         // Check the result.
@@ -3231,19 +3240,124 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
             }
             return;
         }
+    }
+}
 
-        // Re-enqueue the event on the wait queue.
-        connection->outboundQueue.erase(std::remove(connection->outboundQueue.begin(),
-                                                    connection->outboundQueue.end(),
-                                                    dispatchEntry));
-        traceOutboundQueueLength(*connection);
-        connection->waitQueue.push_back(dispatchEntry);
-        if (connection->responsive) {
-            mAnrTracker.insert(dispatchEntry->timeoutTime,
-                               connection->inputChannel->getConnectionToken());
+status_t InputDispatcher::publishDispatchEntryLocked(const sp<Connection>& connection,
+                                                     DispatchEntry* dispatchEntry) {
+    status_t status;
+    const EventEntry& eventEntry = *(dispatchEntry->eventEntry);
+    switch (eventEntry.type) {
+        case EventEntry::Type::KEY: {
+            const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
+            std::array<uint8_t, 32> hmac = getSignature(keyEntry, *dispatchEntry);
+
+            // Publish the key event.
+            status = connection->inputPublisher
+                             .publishKeyEvent(dispatchEntry->seq,
+                                              dispatchEntry->resolvedEventId, keyEntry.deviceId,
+                                              keyEntry.source, keyEntry.displayId,
+                                              std::move(hmac), dispatchEntry->resolvedAction,
+                                              dispatchEntry->resolvedFlags, keyEntry.keyCode,
+                                              keyEntry.scanCode, keyEntry.metaState,
+                                              keyEntry.repeatCount, keyEntry.downTime,
+                                              keyEntry.eventTime);
+            break;
+        }
+
+        case EventEntry::Type::MOTION: {
+            const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
+
+            PointerCoords scaledCoords[MAX_POINTERS];
+            const PointerCoords* usingCoords = motionEntry.pointerCoords;
+
+            // Set the X and Y offset and X and Y scale depending on the input source.
+            if ((motionEntry.source & AINPUT_SOURCE_CLASS_POINTER) &&
+                !(dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS)) {
+                float globalScaleFactor = dispatchEntry->globalScaleFactor;
+                if (globalScaleFactor != 1.0f) {
+                    for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
+                        scaledCoords[i] = motionEntry.pointerCoords[i];
+                        // Don't apply window scale here since we don't want scale to affect raw
+                        // coordinates. The scale will be sent back to the client and applied
+                        // later when requesting relative coordinates.
+                        scaledCoords[i].scale(globalScaleFactor, 1 /* windowXScale */,
+                                              1 /* windowYScale */);
+                    }
+                    usingCoords = scaledCoords;
+                }
+            } else {
+                // We don't want the dispatch target to know.
+                if (dispatchEntry->targetFlags & InputTarget::FLAG_ZERO_COORDS) {
+                    for (uint32_t i = 0; i < motionEntry.pointerCount; i++) {
+                        scaledCoords[i].clear();
+                    }
+                    usingCoords = scaledCoords;
+                }
+            }
+
+            std::array<uint8_t, 32> hmac = getSignature(motionEntry, *dispatchEntry);
+
+            // Publish the motion event.
+            status = connection->inputPublisher
+                             .publishMotionEvent(dispatchEntry->seq,
+                                                 dispatchEntry->resolvedEventId,
+                                                 motionEntry.deviceId, motionEntry.source,
+                                                 motionEntry.displayId, std::move(hmac),
+                                                 dispatchEntry->resolvedAction,
+                                                 motionEntry.actionButton,
+                                                 dispatchEntry->resolvedFlags,
+                                                 motionEntry.edgeFlags, motionEntry.metaState,
+                                                 motionEntry.buttonState,
+                                                 motionEntry.classification,
+                                                 dispatchEntry->transform,
+                                                 motionEntry.xPrecision, motionEntry.yPrecision,
+                                                 motionEntry.xCursorPosition,
+                                                 motionEntry.yCursorPosition,
+                                                 dispatchEntry->displaySize.x,
+                                                 dispatchEntry->displaySize.y,
+                                                 motionEntry.downTime, motionEntry.eventTime,
+                                                 motionEntry.pointerCount,
+                                                 motionEntry.pointerProperties, usingCoords);
+            break;
+        }
+
+        case EventEntry::Type::FOCUS: {
+            const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
+            status = connection->inputPublisher.publishFocusEvent(dispatchEntry->seq,
+                                                                  focusEntry.id,
+                                                                  focusEntry.hasFocus,
+                                                                  mInTouchMode);
+            break;
+        }
+
+        case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
+            const auto& captureEntry =
+                    static_cast<const PointerCaptureChangedEntry&>(eventEntry);
+            status = connection->inputPublisher
+                             .publishCaptureEvent(dispatchEntry->seq, captureEntry.id,
+                                                  captureEntry.pointerCaptureEnabled);
+            break;
+        }
+
+        case EventEntry::Type::DRAG: {
+            const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
+            status = connection->inputPublisher.publishDragEvent(dispatchEntry->seq,
+                                                                 dragEntry.id, dragEntry.x,
+                                                                 dragEntry.y,
+                                                                 dragEntry.isExiting);
+            break;
+        }
+
+        case EventEntry::Type::CONFIGURATION_CHANGED:
+        case EventEntry::Type::DEVICE_RESET:
+        case EventEntry::Type::SENSOR: {
+            LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
+                             NamedEnum::string(eventEntry.type).c_str());
+            return BAD_VALUE;
         }
-        traceWaitQueueLength(*connection);
     }
+    return status;
 }
 
 std::array<uint8_t, 32> InputDispatcher::sign(const VerifiedInputEvent& event) const {
@@ -3782,27 +3896,27 @@ void InputDispatcher::notifyKey(const NotifyKeyArgs* args) {
 
     bool needWake;
     { // acquire lock
-        mLock.lock();
+        mStagedInboundLock.lock();
 
         if (shouldSendKeyToInputFilterLocked(args)) {
-            mLock.unlock();
+            mStagedInboundLock.unlock();
 
             policyFlags |= POLICY_FLAG_FILTERED;
             if (!mPolicy->filterInputEvent(&event, policyFlags)) {
                 return; // event was consumed by the filter
             }
 
-            mLock.lock();
+            mStagedInboundLock.lock();
         }
 
-        std::unique_ptr<KeyEntry> newEntry =
-                std::make_unique<KeyEntry>(args->id, args->eventTime, args->deviceId, args->source,
-                                           args->displayId, policyFlags, args->action, flags,
-                                           keyCode, args->scanCode, metaState, repeatCount,
-                                           args->downTime);
+        std::shared_ptr<KeyEntry> newEntry =
+                createPooledEntry<KeyEntry>(args->id, args->eventTime, args->deviceId,
+                                            args->source, args->displayId, policyFlags,
+                                            args->action, flags, keyCode, args->scanCode,
+                                            metaState, repeatCount, args->downTime);
 
-        needWake = enqueueInboundEventLocked(std::move(newEntry));
-        mLock.unlock();
+        needWake = stageInboundEventLocked(std::move(newEntry), args->readTime);
+        mStagedInboundLock.unlock();
     } // release lock
 
     if (needWake) {
@@ -3811,7 +3925,7 @@ void InputDispatcher::notifyKey(const NotifyKeyArgs* args) {
 }
 
 bool InputDispatcher::shouldSendKeyToInputFilterLocked(const NotifyKeyArgs* args) {
-    return mInputFilterEnabled;
+    return mStagedInputFilterEnabled;
 }
 
 void InputDispatcher::notifyMotion(const NotifyMotionArgs* args) {
@@ -3859,10 +3973,10 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs* args) {
 
     bool needWake;
     { // acquire lock
-        mLock.lock();
+        mStagedInboundLock.lock();
 
         if (shouldSendMotionToInputFilterLocked(args)) {
-            mLock.unlock();
+            mStagedInboundLock.unlock();
 
             MotionEvent event;
             ui::Transform transform;
@@ -3879,23 +3993,23 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs* args) {
                 return; // event was consumed by the filter
             }
 
-            mLock.lock();
+            mStagedInboundLock.lock();
         }
 
-        // Just enqueue a new motion event.
-        std::unique_ptr<MotionEntry> newEntry =
-                std::make_unique<MotionEntry>(args->id, args->eventTime, args->deviceId,
-                                              args->source, args->displayId, policyFlags,
-                                              args->action, args->actionButton, args->flags,
-                                              args->metaState, args->buttonState,
-                                              args->classification, args->edgeFlags,
-                                              args->xPrecision, args->yPrecision,
-                                              args->xCursorPosition, args->yCursorPosition,
-                                              args->downTime, args->pointerCount,
-                                              args->pointerProperties, args->pointerCoords, 0, 0);
+        // Just stage a new motion event.
+        std::shared_ptr<MotionEntry> newEntry =
+                createPooledEntry<MotionEntry>(args->id, args->eventTime, args->deviceId,
+                                               args->source, args->displayId, policyFlags,
+                                               args->action, args->actionButton, args->flags,
+                                               args->metaState, args->buttonState,
+                                               args->classification, args->edgeFlags,
+                                               args->xPrecision, args->yPrecision,
+                                               args->xCursorPosition, args->yCursorPosition,
+                                               args->downTime, args->pointerCount,
+                                               args->pointerProperties, args->pointerCoords, 0, 0);
 
-        needWake = enqueueInboundEventLocked(std::move(newEntry));
-        mLock.unlock();
+        needWake = stageInboundEventLocked(std::move(newEntry), args->readTime);
+        mStagedInboundLock.unlock();
     } // release lock
 
     if (needWake) {
@@ -3940,7 +4054,7 @@ void InputDispatcher::notifyVibratorState(const NotifyVibratorStateArgs* args) {
 }
 
 bool InputDispatcher::shouldSendMotionToInputFilterLocked(const NotifyMotionArgs* args) {
-    return mInputFilterEnabled;
+    return mStagedInputFilterEnabled;
 }
 
 void InputDispatcher::notifySwitch(const NotifySwitchArgs* args) {
@@ -4322,6 +4436,26 @@ const std::vector<sp<InputWindowHandle>>& InputDispatcher::getWindowHandlesLocke
     return it != mWindowHandlesByDisplay.end() ? it->second : EMPTY_WINDOW_HANDLES;
 }
 
+std::vector<size_t> InputDispatcher::getWindowIndexesAtLocked(
+        int32_t displayId, int32_t x, int32_t y,
+        const sp<InputWindowHandle>& aboveWindowHandle) const {
+    auto it = mWindowSpatialIndexByDisplay.find(displayId);
+    if (it != mWindowSpatialIndexByDisplay.end()) {
+        return it->second.getWindowIndexesAt(x, y, aboveWindowHandle);
+    }
+
+    const std::vector<sp<InputWindowHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    std::vector<size_t> indexes;
+    indexes.reserve(windowHandles.size());
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        if (windowHandles[i] == aboveWindowHandle) {
+            break; // All future windows are below it.
+        }
+        indexes.push_back(i);
+    }
+    return indexes;
+}
+
 sp<InputWindowHandle> InputDispatcher::getWindowHandleLocked(
         const sp<IBinder>& windowHandleToken) const {
     if (windowHandleToken == nullptr) {
@@ -4415,6 +4549,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (inputWindowHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mWindowSpatialIndexByDisplay.erase(displayId);
         return;
     }
 
@@ -4463,6 +4598,14 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
         }
     }
 
+    // Displays with few windows are hit tested by visiting every window, which is faster than
+    // building and querying an index.
+    if (newHandles.size() >= MIN_WINDOWS_FOR_SPATIAL_INDEX) {
+        mWindowSpatialIndexByDisplay.insert_or_assign(displayId, WindowSpatialIndex(newHandles));
+    } else {
+        mWindowSpatialIndexByDisplay.erase(displayId);
+    }
+
     // Insert or replace
     mWindowHandlesByDisplay[displayId] = newHandles;
 }
@@ -4749,6 +4892,10 @@ void InputDispatcher::setInputFilterEnabled(bool enabled) {
         }
 
         mInputFilterEnabled = enabled;
+        {
+            std::scoped_lock _l2(mStagedInboundLock);
+            mStagedInputFilterEnabled = enabled;
+        }
         resetAndDropEverythingLocked("input filter is being enabled or disabled");
     } // release lock
 
@@ -5108,6 +5255,10 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) {
     } else {
         dump += INDENT "InboundQueue: <empty>\n";
     }
+    {
+        std::scoped_lock _l(mStagedInboundLock);
+        dump += StringPrintf(INDENT "StagedInboundEvents: %zu\n", mStagedInboundEvents.size());
+    }
 
     if (!mReplacedKeys.empty()) {
         dump += INDENT "ReplacedKeys:\n";
@@ -5165,6 +5316,11 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) {
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
+    auto getConnectionName = [this](const sp<IBinder>& token) REQUIRES(mLock) {
+        sp<Connection> connection = getConnectionLocked(token);
+        return connection != nullptr ? connection->getWindowName() : std::string("<removed>");
+    };
+    dump += mLatencyAggregator.dumpHistograms(INDENT2, getConnectionName);
 }
 
 void InputDispatcher::dumpMonitors(std::string& dump, const std::vector<Monitor>& monitors) {
@@ -5291,6 +5447,7 @@ status_t InputDispatcher::removeInputChannelLocked(const sp<IBinder>& connection
     }
 
     removeConnectionLocked(connection);
+    mLatencyAggregator.removeConnection(connectionToken);
 
     if (connection->monitor) {
         removeMonitorChannelLocked(connectionToken);
@@ -34,6 +34,7 @@
 #include "Monitor.h"
 #include "TouchState.h"
 #include "TouchedWindow.h"
+#include "WindowSpatialIndex.h"
 
 #include <attestation/HmacKeyManager.h>
 #include <com/android/internal/compat/IPlatformCompatNative.h>
@@ -166,6 +167,23 @@ private:
 
     std::shared_ptr<EventEntry> mPendingEvent GUARDED_BY(mLock);
     std::deque<std::shared_ptr<EventEntry>> mInboundQueue GUARDED_BY(mLock);
+
+    // Key and motion events notified by the reader are staged here rather than enqueued into
+    // mInboundQueue, so that notifyKey and notifyMotion never wait for mLock while the dispatcher
+    // thread holds it. The dispatcher thread moves them, in order, into mInboundQueue before it
+    // looks at the queue. mStagedInboundLock may be acquired while holding mLock, never the
+    // other way around.
+    std::mutex mStagedInboundLock;
+    struct StagedInboundEvent {
+        std::shared_ptr<EventEntry> entry;
+        // The time at which InputReader read the event, for mLatencyTracker.
+        nsecs_t readTime;
+    };
+    std::vector<StagedInboundEvent> mStagedInboundEvents GUARDED_BY(mStagedInboundLock);
+    // A copy of mInputFilterEnabled that is read when events are staged.
+    bool mStagedInputFilterEnabled GUARDED_BY(mStagedInboundLock);
+    // The staged events that are being moved into mInboundQueue.
+    std::vector<StagedInboundEvent> mMovingInboundEvents GUARDED_BY(mLock);
     std::deque<std::shared_ptr<EventEntry>> mRecentQueue GUARDED_BY(mLock);
     std::deque<std::unique_ptr<CommandEntry>> mCommandQueue GUARDED_BY(mLock);
 
@@ -181,7 +199,19 @@ private:
     void dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) REQUIRES(mLock);
 
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
-    bool enqueueInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
+    bool enqueueInboundEventLocked(std::shared_ptr<EventEntry> entry) REQUIRES(mLock);
+    bool appendInboundEventLocked(std::shared_ptr<EventEntry> entry) REQUIRES(mLock);
+
+    // Stages an inbound event for the dispatcher thread. Returns true if mLooper->wake() should
+    // be called.
+    bool stageInboundEventLocked(std::shared_ptr<EventEntry> entry, nsecs_t readTime)
+            REQUIRES(mStagedInboundLock);
+    // Starts tracking the latency of an event from InputReader.
+    void trackInboundEventLatencyLocked(const EventEntry& entry, nsecs_t readTime)
+            REQUIRES(mLock);
+    // Moves the staged events into mInboundQueue. Returns true if mLooper->wake() should be
+    // called.
+    bool moveStagedInboundEventsLocked() REQUIRES(mLock) EXCLUDES(mStagedInboundLock);
 
     // Cleans up input state when dropping an inbound event.
     void dropInboundEventLocked(const EventEntry& entry, DropReason dropReason) REQUIRES(mLock);
@@ -298,8 +328,10 @@ private:
     std::chrono::nanoseconds getDispatchingTimeoutLocked(const sp<IBinder>& token) REQUIRES(mLock);
 
     // Input filter processing.
-    bool shouldSendKeyToInputFilterLocked(const NotifyKeyArgs* args) REQUIRES(mLock);
-    bool shouldSendMotionToInputFilterLocked(const NotifyMotionArgs* args) REQUIRES(mLock);
+    bool shouldSendKeyToInputFilterLocked(const NotifyKeyArgs* args)
+            REQUIRES(mStagedInboundLock);
+    bool shouldSendMotionToInputFilterLocked(const NotifyMotionArgs* args)
+            REQUIRES(mStagedInboundLock);
 
     // Inbound event processing.
     void drainInboundQueueLocked() REQUIRES(mLock);
@@ -323,6 +355,15 @@ private:
             REQUIRES(mLock);
     sp<InputWindowHandle> getWindowHandleLocked(const sp<IBinder>& windowHandleToken) const
             REQUIRES(mLock);
+    // Spatial indexes of the displays with many windows, rebuilt whenever their windows change.
+    std::unordered_map<int32_t, WindowSpatialIndex> mWindowSpatialIndexByDisplay
+            GUARDED_BY(mLock);
+    // Returns, front to back, the indexes into getWindowHandlesLocked(displayId) of the windows
+    // that may contain the point. If aboveWindowHandle is on the display, only the windows in
+    // front of it are returned.
+    std::vector<size_t> getWindowIndexesAtLocked(
+            int32_t displayId, int32_t x, int32_t y,
+            const sp<InputWindowHandle>& aboveWindowHandle = nullptr) const REQUIRES(mLock);
 
     // Same function as above, but faster. Since displayId is provided, this avoids the need
     // to loop through all displays.
@@ -343,6 +384,9 @@ private:
             REQUIRES(mLock);
 
     std::unordered_map<int32_t, TouchState> mTouchStatesByDisplay GUARDED_BY(mLock);
+    // The touch state that findTouchedWindowTargetsLocked works on. It is reset after each event,
+    // but kept as a member so that its vectors keep their storage from one event to the next.
+    TouchState mTempTouchState GUARDED_BY(mLock);
     std::unique_ptr<DragState> mDragState GUARDED_BY(mLock);
 
     void setFocusedApplicationLocked(
@@ -543,6 +587,8 @@ private:
             REQUIRES(mLock);
     void startDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection)
             REQUIRES(mLock);
+    status_t publishDispatchEntryLocked(const sp<Connection>& connection,
+                                        DispatchEntry* dispatchEntry) REQUIRES(mLock);
     void finishDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection,
                                    uint32_t seq, bool handled, nsecs_t consumeTime) REQUIRES(mLock);
     void abortBrokenDispatchCycleLocked(nsecs_t currentTime, const sp<Connection>& connection,
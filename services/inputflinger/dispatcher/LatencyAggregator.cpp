@@ -123,6 +123,35 @@ AStatsManager_PullAtomCallbackReturn LatencyAggregator::pullAtomCallback(int32_t
 void LatencyAggregator::processTimeline(const InputEventTimeline& timeline) {
     processStatistics(timeline);
     processSlowEvent(timeline);
+    processHistograms(timeline);
+}
+
+void LatencyAggregator::LatencyHistograms::add(const InputEventTimeline& timeline,
+                                               const ConnectionTimeline& connectionTimeline) {
+    const nsecs_t presentTime = connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+    readToDeliver.add(connectionTimeline.deliveryTime - timeline.readTime);
+    deliverToFinish.add(connectionTimeline.finishTime - connectionTimeline.deliveryTime);
+    finishToPresent.add(presentTime - connectionTimeline.finishTime);
+}
+
+std::string LatencyAggregator::LatencyHistograms::dump(const char* prefix) const {
+    return StringPrintf("%sreadToDeliver: %s\n", prefix, readToDeliver.dump().c_str()) +
+            StringPrintf("%sdeliverToFinish: %s\n", prefix, deliverToFinish.dump().c_str()) +
+            StringPrintf("%sfinishToPresent: %s\n", prefix, finishToPresent.dump().c_str());
+}
+
+void LatencyAggregator::processHistograms(const InputEventTimeline& timeline) {
+    for (const auto& [connectionToken, connectionTimeline] : timeline.connectionTimelines) {
+        if (!connectionTimeline.isComplete()) {
+            continue;
+        }
+        mHistogramsByDevice[timeline.deviceId].add(timeline, connectionTimeline);
+        mHistogramsByConnection[connectionToken].add(timeline, connectionTimeline);
+    }
+}
+
+void LatencyAggregator::removeConnection(const sp<IBinder>& connectionToken) {
+    mHistogramsByConnection.erase(connectionToken);
 }
 
 void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
@@ -279,4 +308,25 @@ std::string LatencyAggregator::dump(const char* prefix) {
             StringPrintf("%s  mNumSkippedSlowEvents = %zu\n", prefix, mNumSkippedSlowEvents);
 }
 
+std::string LatencyAggregator::dumpHistograms(
+        const char* prefix,
+        const std::function<std::string(const sp<IBinder>&)>& getConnectionName) const {
+    std::string dump = StringPrintf("%sLatencyHistograms:\n", prefix);
+    if (mHistogramsByDevice.empty()) {
+        dump += StringPrintf("%s  <none>\n", prefix);
+        return dump;
+    }
+    const std::string histogramPrefix = StringPrintf("%s    ", prefix);
+    for (const auto& [deviceId, histograms] : mHistogramsByDevice) {
+        dump += StringPrintf("%s  Device %" PRId32 ":\n", prefix, deviceId);
+        dump += histograms.dump(histogramPrefix.c_str());
+    }
+    for (const auto& [connectionToken, histograms] : mHistogramsByConnection) {
+        dump += StringPrintf("%s  Connection '%s':\n", prefix,
+                             getConnectionName(connectionToken).c_str());
+        dump += histograms.dump(histogramPrefix.c_str());
+    }
+    return dump;
+}
+
 } // namespace android::inputdispatcher
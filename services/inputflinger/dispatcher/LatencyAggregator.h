@@ -21,7 +21,11 @@
 #include <statslog.h>
 #include <utils/Timers.h>
 
+#include <functional>
+#include <map>
+
 #include "InputEventTimeline.h"
+#include "LatencyHistogram.h"
 
 namespace android::inputdispatcher {
 
@@ -59,6 +63,19 @@ public:
 
     std::string dump(const char* prefix);
 
+    /**
+     * Forget the latencies of a connection, once it has been removed.
+     */
+    void removeConnection(const sp<IBinder>& connectionToken);
+
+    /**
+     * Dump the latency percentiles of every input device and every connection. The names of the
+     * connections are provided by getConnectionName.
+     */
+    std::string dumpHistograms(
+            const char* prefix,
+            const std::function<std::string(const sp<IBinder>&)>& getConnectionName) const;
+
     ~LatencyAggregator();
 
 private:
@@ -83,6 +100,22 @@ private:
             mMoveSketches;
     // How many events have been processed so far
     size_t mNumSketchEventsProcessed = 0;
+
+    // ---------- Histogram handling ----------
+    // Unlike the sketches, the histograms are never reset by a statsd pull, so that they give a
+    // live view of the latencies in dumpsys.
+    struct LatencyHistograms {
+        LatencyHistogram readToDeliver;
+        LatencyHistogram deliverToFinish;
+        LatencyHistogram finishToPresent;
+
+        void add(const InputEventTimeline& timeline, const ConnectionTimeline& connectionTimeline);
+        std::string dump(const char* prefix) const;
+    };
+    void processHistograms(const InputEventTimeline& timeline);
+    std::map<int32_t /*deviceId*/, LatencyHistograms> mHistogramsByDevice;
+    std::unordered_map<sp<IBinder>, LatencyHistograms, InputEventTimeline::IBinderHash>
+            mHistogramsByConnection;
 };
 
 } // namespace android::inputdispatcher
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+// The upper bound of the first bucket.
+static constexpr nsecs_t FIRST_BUCKET_UPPER_BOUND = 100000; // 100 us
+
+// The number of buckets per doubling of the latency.
+static constexpr int BUCKETS_PER_OCTAVE = 4;
+
+nsecs_t LatencyHistogram::getBucketUpperBound(size_t bucket) {
+    return static_cast<nsecs_t>(FIRST_BUCKET_UPPER_BOUND *
+                                exp2(static_cast<double>(bucket) / BUCKETS_PER_OCTAVE));
+}
+
+size_t LatencyHistogram::getBucket(nsecs_t latency) {
+    if (latency < FIRST_BUCKET_UPPER_BOUND) {
+        return 0;
+    }
+    const double octaves = log2(static_cast<double>(latency) / FIRST_BUCKET_UPPER_BOUND);
+    const size_t bucket = static_cast<size_t>(octaves * BUCKETS_PER_OCTAVE) + 1;
+    return std::min(bucket, BUCKET_COUNT - 1);
+}
+
+void LatencyHistogram::add(nsecs_t latency) {
+    mBuckets[getBucket(std::max(latency, nsecs_t(0)))]++;
+    mCount++;
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    // The rank of the percentile, starting from 1.
+    const size_t rank = std::max(size_t(1), static_cast<size_t>(ceil(percentile / 100 * mCount)));
+    size_t count = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        count += mBuckets[bucket];
+        if (count >= rank) {
+            return getBucketUpperBound(bucket);
+        }
+    }
+    return getBucketUpperBound(BUCKET_COUNT - 1);
+}
+
+std::string LatencyHistogram::dump() const {
+    return StringPrintf("count=%zu p50=%.1fms p90=%.1fms p99=%.1fms", mCount,
+                        getPercentile(50) * 1E-6, getPercentile(90) * 1E-6,
+                        getPercentile(99) * 1E-6);
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+
+#include <utils/Timers.h>
+
+namespace android::inputdispatcher {
+
+/**
+ * A histogram of latencies with fixed, exponentially growing buckets, from which percentiles can
+ * be estimated. Adding a latency takes constant time and never allocates, so that a histogram can
+ * be updated for every event.
+ *
+ * Each bucket is a quarter of an octave wide, so an estimated percentile is at most 19% above the
+ * exact one. The first bucket holds the latencies under 100us and the last one the latencies over
+ * about 5 seconds.
+ *
+ * LatencyHistogram is not thread-safe.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 64;
+
+    /**
+     * Record a latency. Negative latencies are recorded as zero.
+     */
+    void add(nsecs_t latency);
+
+    /**
+     * The number of latencies recorded so far.
+     */
+    size_t getCount() const { return mCount; }
+
+    /**
+     * Estimate the given percentile, between 0 and 100, of the recorded latencies. The estimate is
+     * the upper bound of the bucket that holds the percentile. Returns 0 if no latency was
+     * recorded.
+     */
+    nsecs_t getPercentile(float percentile) const;
+
+    /**
+     * The latency count and its 50th, 90th and 99th percentiles, on one line.
+     */
+    std::string dump() const;
+
+    /**
+     * The upper bound of the latencies held by the given bucket.
+     */
+    static nsecs_t getBucketUpperBound(size_t bucket);
+
+private:
+    static size_t getBucket(nsecs_t latency);
+
+    std::array<uint32_t, BUCKET_COUNT> mBuckets{};
+    size_t mCount = 0;
+};
+
+} // namespace android::inputdispatcher
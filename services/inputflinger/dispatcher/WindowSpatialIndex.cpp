@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+
+#include "WindowSpatialIndex.h"
+
+namespace android::inputdispatcher {
+
+static bool isUnbounded(const InputWindowInfo& info) {
+    const bool isTouchModal = !info.flags.test(InputWindowInfo::Flag::NOT_TOUCHABLE) &&
+            !info.flags.test(InputWindowInfo::Flag::NOT_FOCUSABLE) &&
+            !info.flags.test(InputWindowInfo::Flag::NOT_TOUCH_MODAL);
+    return isTouchModal || info.flags.test(InputWindowInfo::Flag::WATCH_OUTSIDE_TOUCH);
+}
+
+WindowSpatialIndex::WindowSpatialIndex(const std::vector<sp<InputWindowHandle>>& windowHandles)
+      : mBounds{std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(),
+                std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min()} {
+    // The union of the frame and of the touchable region of each window, or nullopt for the
+    // windows that are always candidates or that cannot contain any point.
+    std::vector<std::optional<Bounds>> windowBounds;
+    windowBounds.reserve(windowHandles.size());
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const InputWindowInfo& info = *windowHandles[i]->getInfo();
+        mIndexByWindowHandle[windowHandles[i].get()] = i;
+        if (isUnbounded(info)) {
+            mUnboundedWindows.push_back(i);
+            windowBounds.push_back(std::nullopt);
+            continue;
+        }
+
+        std::optional<Bounds> bounds;
+        if (info.frameLeft < info.frameRight && info.frameTop < info.frameBottom) {
+            bounds = Bounds{info.frameLeft, info.frameTop, info.frameRight, info.frameBottom};
+        }
+        const Rect touchableBounds = info.touchableRegion.getBounds();
+        if (!touchableBounds.isEmpty()) {
+            if (!bounds) {
+                bounds = Bounds{touchableBounds.left, touchableBounds.top, touchableBounds.right,
+                                touchableBounds.bottom};
+            } else {
+                bounds->left = std::min(bounds->left, touchableBounds.left);
+                bounds->top = std::min(bounds->top, touchableBounds.top);
+                bounds->right = std::max(bounds->right, touchableBounds.right);
+                bounds->bottom = std::max(bounds->bottom, touchableBounds.bottom);
+            }
+        }
+        if (bounds) {
+            mBounds.left = std::min(mBounds.left, bounds->left);
+            mBounds.top = std::min(mBounds.top, bounds->top);
+            mBounds.right = std::max(mBounds.right, bounds->right);
+            mBounds.bottom = std::max(mBounds.bottom, bounds->bottom);
+        }
+        windowBounds.push_back(bounds);
+    }
+
+    if (mBounds.left >= mBounds.right || mBounds.top >= mBounds.bottom) {
+        // No window can contain a point, other than the unbounded ones.
+        return;
+    }
+    mCells.resize(GRID_SIZE * GRID_SIZE);
+    for (size_t i = 0; i < windowBounds.size(); i++) {
+        if (!windowBounds[i]) {
+            continue;
+        }
+        const Bounds& bounds = *windowBounds[i];
+        const int32_t lastColumn = getColumn(bounds.right - 1);
+        const int32_t lastRow = getRow(bounds.bottom - 1);
+        for (int32_t row = getRow(bounds.top); row <= lastRow; row++) {
+            for (int32_t column = getColumn(bounds.left); column <= lastColumn; column++) {
+                mCells[row * GRID_SIZE + column].push_back(i);
+            }
+        }
+    }
+}
+
+int32_t WindowSpatialIndex::getColumn(int32_t x) const {
+    // Use 64-bit arithmetic, since windows may extend to the limits of int32_t.
+    return static_cast<int32_t>((int64_t(x) - mBounds.left) * GRID_SIZE /
+                                (int64_t(mBounds.right) - mBounds.left));
+}
+
+int32_t WindowSpatialIndex::getRow(int32_t y) const {
+    return static_cast<int32_t>((int64_t(y) - mBounds.top) * GRID_SIZE /
+                                (int64_t(mBounds.bottom) - mBounds.top));
+}
+
+std::vector<size_t> WindowSpatialIndex::getWindowIndexesAt(
+        int32_t x, int32_t y, const sp<InputWindowHandle>& aboveWindowHandle) const {
+    size_t end = std::numeric_limits<size_t>::max();
+    if (aboveWindowHandle != nullptr) {
+        auto it = mIndexByWindowHandle.find(aboveWindowHandle.get());
+        if (it != mIndexByWindowHandle.end()) {
+            end = it->second;
+        }
+    }
+
+    static const std::vector<size_t> EMPTY_CELL;
+    const std::vector<size_t>* cell = &EMPTY_CELL;
+    if (!mCells.empty() && x >= mBounds.left && x < mBounds.right && y >= mBounds.top &&
+        y < mBounds.bottom) {
+        cell = &mCells[getRow(y) * GRID_SIZE + getColumn(x)];
+    }
+
+    // Both lists are sorted front to back, and no window is in both of them.
+    std::vector<size_t> indexes;
+    indexes.reserve(cell->size() + mUnboundedWindows.size());
+    std::merge(cell->begin(), std::lower_bound(cell->begin(), cell->end(), end),
+               mUnboundedWindows.begin(),
+               std::lower_bound(mUnboundedWindows.begin(), mUnboundedWindows.end(), end),
+               std::back_inserter(indexes));
+    return indexes;
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include <input/InputWindow.h>
+
+namespace android::inputdispatcher {
+
+// A uniform grid over the windows of a display, used to hit test displays with many windows
+// without visiting every window. Each cell lists, front to back, the windows whose frame or
+// touchable region overlaps it. Windows that can take a touch anywhere on the display (touch
+// modal windows, and windows that watch outside touches) are not stored in the cells but are
+// always candidates.
+//
+// The index only narrows down the windows to test: callers still check the window info exactly,
+// so a candidate may not actually contain the point. It holds a snapshot of the window bounds, and
+// has to be rebuilt whenever the window handles of the display are updated.
+class WindowSpatialIndex {
+public:
+    // The window handles are ordered front to back, as in InputDispatcher.
+    explicit WindowSpatialIndex(const std::vector<sp<InputWindowHandle>>& windowHandles);
+
+    // Returns, front to back, the indexes of the windows that may contain the point. If
+    // aboveWindowHandle is in the index, only the windows in front of it are returned.
+    std::vector<size_t> getWindowIndexesAt(int32_t x, int32_t y,
+                                           const sp<InputWindowHandle>& aboveWindowHandle) const;
+
+private:
+    static constexpr int32_t GRID_SIZE = 16;
+
+    struct Bounds {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+    };
+
+    int32_t getColumn(int32_t x) const;
+    int32_t getRow(int32_t y) const;
+
+    Bounds mBounds;
+    std::vector<std::vector<size_t>> mCells;
+    std::vector<size_t> mUnboundedWindows;
+    std::unordered_map<const InputWindowHandle*, size_t> mIndexByWindowHandle;
+};
+
+} // namespace android::inputdispatcher
@@ -48,6 +48,11 @@ public:
                                    const sp<ISetInputWindowsListener>&) override {
         return binder::Status::ok();
     }
+    binder::Status updateInputWindows(const std::vector<InputWindowInfo>&,
+                                      const std::vector<int32_t>&,
+                                      const sp<ISetInputWindowsListener>&) override {
+        return binder::Status::ok();
+    }
     binder::Status createInputChannel(const std::string&, InputChannel*) override {
         return binder::Status::ok();
     }
@@ -49,6 +49,7 @@
 #include <utils/Log.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <regex>
 
@@ -367,6 +368,7 @@ EventHub::Device::Device(int fd, int32_t id, const std::string& path,
         ffEffectId(-1),
         associatedDevice(nullptr),
         controllerNumber(0),
+        usingMonotonicClock(false),
         enabled(true),
         isVirtual(fd < 0) {}
 
@@ -442,6 +444,7 @@ void EventHub::Device::configureFd() {
     }
     bool usingClockIoctl = !ioctl(fd, EVIOCSCLOCKID, &clockId);
     ALOGI("usingClockIoctl=%s", toString(usingClockIoctl));
+    usingMonotonicClock = usingClockIoctl && clockId == CLOCK_MONOTONIC;
 }
 
 bool EventHub::Device::hasKeycodeLocked(int keycode) const {
@@ -1620,12 +1623,15 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
                     ALOGE("could not get event (wrong size: %d)", readSize);
                 } else {
                     int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
+                    // All the events of a read were read at the same time.
+                    const nsecs_t readTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
                     size_t count = size_t(readSize) / sizeof(struct input_event);
+                    recordReadLocked(*device, readBuffer, count, readTime);
                     for (size_t i = 0; i < count; i++) {
                         struct input_event& iev = readBuffer[i];
                         event->when = processEventTimestamp(iev);
-                        event->readTime = systemTime(SYSTEM_TIME_MONOTONIC);
+                        event->readTime = readTime;
                         event->deviceId = deviceId;
                         event->type = iev.type;
                         event->code = iev.code;
@@ -1715,6 +1721,20 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
     return event - buffer;
 }
 
+void EventHub::recordReadLocked(Device& device, const struct input_event* events, size_t count,
+                                nsecs_t readTime) {
+    Device::ReadStats& stats = device.readStats;
+    stats.readCount++;
+    stats.eventCount += count;
+    stats.maxEventsPerRead = std::max(stats.maxEventsPerRead, count);
+    if (count > 0 && device.usingMonotonicClock) {
+        // The oldest event of the read waited the longest.
+        const nsecs_t latency = readTime - processEventTimestamp(events[0]);
+        stats.totalLatency += latency;
+        stats.maxLatency = std::max(stats.maxLatency, latency);
+    }
+}
+
 std::vector<TouchVideoFrame> EventHub::getVideoFrames(int32_t deviceId) {
     std::scoped_lock _l(mLock);
 
@@ -2448,6 +2468,17 @@ void EventHub::dump(std::string& dump) {
                                  device->keyMap.keyCharacterMapFile.c_str());
             dump += StringPrintf(INDENT3 "ConfigurationFile: %s\n",
                                  device->configurationFile.c_str());
+            const Device::ReadStats& stats = device->readStats;
+            dump += StringPrintf(INDENT3 "Reads: count=%" PRIu64 ", events=%" PRIu64
+                                         ", maxEventsPerRead=%zu",
+                                 stats.readCount, stats.eventCount, stats.maxEventsPerRead);
+            if (device->usingMonotonicClock && stats.readCount > 0) {
+                const double meanLatency =
+                        static_cast<double>(stats.totalLatency) / stats.readCount;
+                dump += StringPrintf(", meanLatency=%.3fms, maxLatency=%.3fms", meanLatency * 1e-6,
+                                     stats.maxLatency * 1e-6);
+            }
+            dump += "\n";
             dump += INDENT3 "VideoDevice: ";
             if (device->videoDevice) {
                 dump += device->videoDevice->dump() + "\n";
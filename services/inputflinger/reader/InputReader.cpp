@@ -106,14 +106,32 @@ void InputReader::loopOnce() {
     } // release lock
 
     size_t count = mEventHub->getEvents(timeoutMillis, mEventBuffer, EVENT_BUFFER_SIZE);
+    const RawEvent* rawEvents = mEventBuffer;
 
     { // acquire lock
         std::scoped_lock _l(mLock);
         mReaderIsAliveCondition.notify_all();
 
-        if (count) {
-            processEventsLocked(mEventBuffer, count);
-        }
+        size_t processed = processEventsLocked(rawEvents, count, oldGeneration);
+        rawEvents += processed;
+        count -= processed;
+    } // release lock
+
+    // The events of each device are flushed out before the next device is processed, so that they
+    // don't wait for the mapping of all the events read, such as a heavy touch sync of another
+    // device. This stops once an input device changes, so that the policy hears of the change
+    // before the events that follow it are sent.
+    while (count) {
+        mQueuedListener->flush();
+
+        std::scoped_lock _l(mLock);
+        size_t processed = processEventsLocked(rawEvents, count, oldGeneration);
+        rawEvents += processed;
+        count -= processed;
+    }
+
+    { // acquire lock
+        std::scoped_lock _l(mLock);
 
         if (mNextTimeout != LLONG_MAX) {
             nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
@@ -147,7 +165,9 @@ void InputReader::loopOnce() {
     mQueuedListener->flush();
 }
 
-void InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count) {
+size_t InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count,
+                                        int32_t generation) {
+    size_t processed = 0;
     for (const RawEvent* rawEvent = rawEvents; count;) {
         int32_t type = rawEvent->type;
         size_t batchSize = 1;
@@ -164,6 +184,9 @@ void InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count) {
             ALOGD("BatchSize: %zu Count: %zu", batchSize, count);
 #endif
             processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            if (batchSize < count && mGeneration == generation) {
+                return processed + batchSize;
+            }
         } else {
             switch (rawEvent->type) {
                 case EventHubInterface::DEVICE_ADDED:
@@ -182,7 +205,9 @@ void InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count) {
         }
         count -= batchSize;
         rawEvent += batchSize;
+        processed += batchSize;
     }
+    return processed;
 }
 
 void InputReader::addDeviceLocked(nsecs_t when, int32_t eventHubId) {
@@ -201,9 +201,10 @@ std::optional<TouchVideoFrame> TouchVideoDevice::readFrame() {
         ALOGW("The timestamp %ld.%ld was not acquired using CLOCK_MONOTONIC", buf.timestamp.tv_sec,
               buf.timestamp.tv_usec);
     }
-    std::vector<int16_t> data(mHeight * mWidth);
+    // This is the only copy of the frame: the buffer goes back to the driver right away, and the
+    // copies of the frame made on the way to InputClassifier share this data.
     const int16_t* readFrom = mReadLocations[buf.index];
-    std::copy(readFrom, readFrom + mHeight * mWidth, data.begin());
+    std::vector<int16_t> data(readFrom, readFrom + mHeight * mWidth);
     TouchVideoFrame frame(mHeight, mWidth, std::move(data), buf.timestamp);
 
     result = ioctl(mFd.get(), VIDIOC_QBUF, &buf);
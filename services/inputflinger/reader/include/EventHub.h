@@ -579,6 +579,21 @@ private:
 
         int32_t controllerNumber;
 
+        // Whether the kernel timestamps the events of the device with the monotonic clock, the
+        // time base of readTime. Set once when the fd is configured.
+        bool usingMonotonicClock;
+
+        // Statistics about the reads of the device, to measure how many events arrive together
+        // and how long the oldest of them waited to be read.
+        struct ReadStats {
+            uint64_t readCount = 0;
+            uint64_t eventCount = 0;
+            size_t maxEventsPerRead = 0;
+            nsecs_t totalLatency = 0;
+            nsecs_t maxLatency = 0;
+        };
+        ReadStats readStats;
+
         Device(int fd, int32_t id, const std::string& path,
                const InputDeviceIdentifier& identifier);
         ~Device();
@@ -629,6 +644,8 @@ private:
     void closeDeviceByPathLocked(const std::string& devicePath) REQUIRES(mLock);
     void closeVideoDeviceByPathLocked(const std::string& devicePath) REQUIRES(mLock);
     void closeDeviceLocked(Device& device) REQUIRES(mLock);
+    void recordReadLocked(Device& device, const struct input_event* events, size_t count,
+                          nsecs_t readTime) REQUIRES(mLock);
     void closeAllDevicesLocked() REQUIRES(mLock);
 
     status_t registerFdForEpoll(int fd);
@@ -183,7 +183,11 @@ private:
             mDeviceToEventHubIdsMap GUARDED_BY(mLock);
 
     // low-level input event decoding and device management
-    void processEventsLocked(const RawEvent* rawEvents, size_t count) REQUIRES(mLock);
+    // Processes the raw events in order, and returns how many were processed. Stops early, after
+    // the events of a device, when more follow and no input device has changed since the given
+    // generation, so that the caller can flush the events mapped so far without the lock.
+    size_t processEventsLocked(const RawEvent* rawEvents, size_t count, int32_t generation)
+            REQUIRES(mLock);
 
     void addDeviceLocked(nsecs_t when, int32_t eventHubId) REQUIRES(mLock);
     void removeDeviceLocked(nsecs_t when, int32_t eventHubId) REQUIRES(mLock);
@@ -2072,6 +2072,47 @@ const BitSet32& TouchInputMapper::findActiveIdBits(const CookedPointerData& cook
     return cookedPointerData.hoveringIdBits;
 }
 
+void TouchInputMapper::cookCoverage(const RawPointerData::Pointer& in, PointerCoords& out) const {
+    int32_t rawLeft = (in.toolMinor & 0xffff0000) >> 16;
+    int32_t rawRight = in.toolMinor & 0x0000ffff;
+    int32_t rawBottom = in.toolMajor & 0x0000ffff;
+    int32_t rawTop = (in.toolMajor & 0xffff0000) >> 16;
+
+    // Adjust coverage coords for surface orientation.
+    float left, top, right, bottom;
+    switch (mSurfaceOrientation) {
+        case DISPLAY_ORIENTATION_90:
+            left = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
+            right = float(rawBottom - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
+            bottom = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale + mXTranslate;
+            top = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale + mXTranslate;
+            break;
+        case DISPLAY_ORIENTATION_180:
+            left = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale;
+            right = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale;
+            bottom = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale + mYTranslate;
+            top = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale + mYTranslate;
+            break;
+        case DISPLAY_ORIENTATION_270:
+            left = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale;
+            right = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale;
+            bottom = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
+            top = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
+            break;
+        default:
+            left = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
+            right = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
+            bottom = float(rawBottom - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
+            top = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
+            break;
+    }
+
+    out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_1, left);
+    out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_2, top);
+    out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_3, right);
+    out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_4, bottom);
+}
+
 void TouchInputMapper::cookPointerData() {
     uint32_t currentPointerCount = mCurrentRawState.rawPointerData.pointerCount;
 
@@ -2090,6 +2131,18 @@ void TouchInputMapper::cookPointerData() {
         mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
     }
 
+    // The calibration only changes when the device is reconfigured, so the choices that do not
+    // depend on the pointer are made once per sync rather than once per pointer.
+    uint32_t sizeDivisor = 1;
+    if (mCalibration.haveSizeIsSummed && mCalibration.sizeIsSummed) {
+        const uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
+        if (touchingCount > 1) {
+            sizeDivisor = touchingCount;
+        }
+    }
+    const bool haveCoverage =
+            mCalibration.coverageCalibration == Calibration::CoverageCalibration::BOX;
+
     // Walk through the the active pointers and map device coordinates onto
     // surface coordinates and adjust for display orientation.
     for (uint32_t i = 0; i < currentPointerCount; i++) {
@@ -2132,15 +2185,12 @@ void TouchInputMapper::cookPointerData() {
                     size = 0;
                 }
 
-                if (mCalibration.haveSizeIsSummed && mCalibration.sizeIsSummed) {
-                    uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
-                    if (touchingCount > 1) {
-                        touchMajor /= touchingCount;
-                        touchMinor /= touchingCount;
-                        toolMajor /= touchingCount;
-                        toolMinor /= touchingCount;
-                        size /= touchingCount;
-                    }
+                if (sizeDivisor > 1) {
+                    touchMajor /= sizeDivisor;
+                    touchMinor /= sizeDivisor;
+                    toolMajor /= sizeDivisor;
+                    toolMinor /= sizeDivisor;
+                    size /= sizeDivisor;
                 }
 
                 if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
@@ -2231,35 +2281,15 @@ void TouchInputMapper::cookPointerData() {
                 distance = 0;
         }
 
-        // Coverage
-        int32_t rawLeft, rawTop, rawRight, rawBottom;
-        switch (mCalibration.coverageCalibration) {
-            case Calibration::CoverageCalibration::BOX:
-                rawLeft = (in.toolMinor & 0xffff0000) >> 16;
-                rawRight = in.toolMinor & 0x0000ffff;
-                rawBottom = in.toolMajor & 0x0000ffff;
-                rawTop = (in.toolMajor & 0xffff0000) >> 16;
-                break;
-            default:
-                rawLeft = rawTop = rawRight = rawBottom = 0;
-                break;
-        }
-
         // Adjust X,Y coords for device calibration
         // TODO: Adjust coverage coords?
         float xTransformed = in.x, yTransformed = in.y;
         mAffineTransform.applyTo(xTransformed, yTransformed);
         rotateAndScale(xTransformed, yTransformed);
 
-        // Adjust X, Y, and coverage coords for surface orientation.
-        float left, top, right, bottom;
-
+        // Adjust orientation for surface orientation.
         switch (mSurfaceOrientation) {
             case DISPLAY_ORIENTATION_90:
-                left = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-                right = float(rawBottom - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-                bottom = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale + mXTranslate;
-                top = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale + mXTranslate;
                 orientation -= M_PI_2;
                 if (mOrientedRanges.haveOrientation &&
                     orientation < mOrientedRanges.orientation.min) {
@@ -2268,10 +2298,6 @@ void TouchInputMapper::cookPointerData() {
                 }
                 break;
             case DISPLAY_ORIENTATION_180:
-                left = float(mRawPointerAxes.x.maxValue - rawRight) * mXScale;
-                right = float(mRawPointerAxes.x.maxValue - rawLeft) * mXScale;
-                bottom = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale + mYTranslate;
-                top = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale + mYTranslate;
                 orientation -= M_PI;
                 if (mOrientedRanges.haveOrientation &&
                     orientation < mOrientedRanges.orientation.min) {
@@ -2280,10 +2306,6 @@ void TouchInputMapper::cookPointerData() {
                 }
                 break;
             case DISPLAY_ORIENTATION_270:
-                left = float(mRawPointerAxes.y.maxValue - rawBottom) * mYScale;
-                right = float(mRawPointerAxes.y.maxValue - rawTop) * mYScale;
-                bottom = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-                top = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
                 orientation += M_PI_2;
                 if (mOrientedRanges.haveOrientation &&
                     orientation > mOrientedRanges.orientation.max) {
@@ -2292,14 +2314,11 @@ void TouchInputMapper::cookPointerData() {
                 }
                 break;
             default:
-                left = float(rawLeft - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-                right = float(rawRight - mRawPointerAxes.x.minValue) * mXScale + mXTranslate;
-                bottom = float(rawBottom - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
-                top = float(rawTop - mRawPointerAxes.y.minValue) * mYScale + mYTranslate;
                 break;
         }
 
-        // Write output coords.
+        // Write output coords, in increasing axis order so that PointerCoords never has to
+        // shift the values that are already set.
         PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
         out.clear();
         out.setAxisValue(AMOTION_EVENT_AXIS_X, xTransformed);
@@ -2308,18 +2327,16 @@ void TouchInputMapper::cookPointerData() {
         out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
-        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
-        if (mCalibration.coverageCalibration == Calibration::CoverageCalibration::BOX) {
-            out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_1, left);
-            out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_2, top);
-            out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_3, right);
-            out.setAxisValue(AMOTION_EVENT_AXIS_GENERIC_4, bottom);
-        } else {
+        if (!haveCoverage) {
             out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
             out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
         }
+        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
+        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
+        if (haveCoverage) {
+            cookCoverage(in, out);
+        }
 
         // Write output relative fields if applicable.
         uint32_t id = in.id;
@@ -741,6 +741,7 @@ private:
     void dispatchButtonPress(nsecs_t when, nsecs_t readTime, uint32_t policyFlags);
     const BitSet32& findActiveIdBits(const CookedPointerData& cookedPointerData);
     void cookPointerData();
+    void cookCoverage(const RawPointerData::Pointer& in, PointerCoords& out) const;
     void abortTouches(nsecs_t when, nsecs_t readTime, uint32_t policyFlags);
 
     void dispatchPointerUsage(nsecs_t when, nsecs_t readTime, uint32_t policyFlags,
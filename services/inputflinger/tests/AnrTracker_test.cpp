@@ -54,6 +54,29 @@ TEST(AnrTrackerTest, MultipleEntries_RemoveToken) {
     ASSERT_EQ(2, tracker.firstTimeout());
 }
 
+TEST(AnrTrackerTest, MultipleTokens_RemoveFirstEntry) {
+    AnrTracker tracker;
+
+    sp<IBinder> token1 = new BBinder();
+    sp<IBinder> token2 = new BBinder();
+
+    tracker.insert(1, token1);
+    tracker.insert(4, token1);
+    tracker.insert(3, token2);
+
+    // The next entry of the token now decides when it's due.
+    tracker.erase(1, token1);
+    ASSERT_EQ(3, tracker.firstTimeout());
+    ASSERT_EQ(token2, tracker.firstToken());
+
+    tracker.erase(3, token2);
+    ASSERT_EQ(4, tracker.firstTimeout());
+    ASSERT_EQ(token1, tracker.firstToken());
+
+    tracker.eraseToken(token1);
+    ASSERT_TRUE(tracker.empty());
+}
+
 TEST(AnrTrackerTest, AddAndRemove_Empty) {
     AnrTracker tracker;
 
@@ -258,6 +258,19 @@ TEST_F(MotionClassifierTest, Classify_TwoVideoFrames) {
     ASSERT_NO_FATAL_FAILURE(mMotionClassifier->classify(motionArgs));
 }
 
+/**
+ * Make sure the dump reports how the HAL keeps up, without waiting for the classification.
+ */
+TEST_F(MotionClassifierTest, Dump_ReportsDeadline) {
+    NotifyMotionArgs motionArgs = generateBasicMotionArgs();
+    mMotionClassifier->classify(motionArgs);
+
+    std::string dump;
+    mMotionClassifier->dump(dump);
+    ASSERT_NE(std::string::npos, dump.find("deadline")) << dump;
+    ASSERT_NE(std::string::npos, dump.find("Resets because the HAL fell behind: 0")) << dump;
+}
+
 /**
  * Make sure MotionClassifier does not crash when it is reset.
  */
@@ -95,6 +95,12 @@ public:
         ASSERT_EQ(nullptr, mFilteredEvent);
     }
 
+    void assertNotifySensorEventWasCalledWithTimestamps(const std::vector<nsecs_t>& timestamps) {
+        std::scoped_lock lock(mLock);
+        ASSERT_EQ(timestamps, mSensorEventTimestamps);
+        mSensorEventTimestamps.clear();
+    }
+
     void assertNotifyConfigurationChangedWasCalled(nsecs_t when) {
         std::scoped_lock lock(mLock);
         ASSERT_TRUE(mConfigurationChangedTime)
@@ -279,6 +285,7 @@ private:
     std::optional<nsecs_t> mConfigurationChangedTime GUARDED_BY(mLock);
     sp<IBinder> mOnPointerDownToken GUARDED_BY(mLock);
     std::optional<NotifySwitchArgs> mLastNotifySwitch GUARDED_BY(mLock);
+    std::vector<nsecs_t> mSensorEventTimestamps GUARDED_BY(mLock);
 
     std::condition_variable mPointerCaptureChangedCondition;
     std::optional<bool> mPointerCaptureEnabled GUARDED_BY(mLock);
@@ -337,7 +344,10 @@ private:
     void notifyUntrustedTouch(const std::string& obscuringPackage) override {}
     void notifySensorEvent(int32_t deviceId, InputDeviceSensorType sensorType,
                            InputDeviceSensorAccuracy accuracy, nsecs_t timestamp,
-                           const std::vector<float>& values) override {}
+                           const std::vector<float>& values) override {
+        std::scoped_lock lock(mLock);
+        mSensorEventTimestamps.push_back(timestamp);
+    }
 
     void notifySensorAccuracy(int deviceId, InputDeviceSensorType sensorType,
                               InputDeviceSensorAccuracy accuracy) override {}
@@ -673,6 +683,23 @@ TEST_F(InputDispatcherTest, NotifySwitch_CallsPolicy) {
     mFakePolicy->assertNotifySwitchWasCalled(args);
 }
 
+TEST_F(InputDispatcherTest, NotifySensor_CallsPolicyForEachSampleInOrder) {
+    const nsecs_t eventTime = systemTime(SYSTEM_TIME_BOOTTIME);
+    const std::vector<float> values = {1.0f, 2.0f, 3.0f};
+    std::vector<nsecs_t> timestamps;
+    for (nsecs_t hwTimestamp = 1000; hwTimestamp <= 5000; hwTimestamp += 1000) {
+        NotifySensorArgs args(10 /*id*/, eventTime, DEVICE_ID, AINPUT_SOURCE_SENSOR,
+                              InputDeviceSensorType::ACCELEROMETER,
+                              InputDeviceSensorAccuracy::ACCURACY_HIGH,
+                              false /*accuracyChanged*/, hwTimestamp, values);
+        mDispatcher->notifySensor(&args);
+        timestamps.push_back(hwTimestamp);
+    }
+    ASSERT_TRUE(mDispatcher->waitForIdle());
+
+    mFakePolicy->assertNotifySensorEventWasCalledWithTimestamps(timestamps);
+}
+
 // --- InputDispatcherTest SetInputWindowTest ---
 static constexpr std::chrono::duration INJECT_EVENT_TIMEOUT = 500ms;
 static constexpr std::chrono::nanoseconds DISPATCHING_TIMEOUT = 5s;
@@ -103,6 +103,8 @@ public:
 protected:
     void InitializeInputFlinger();
     void setInputWindowsByInfos(const std::vector<InputWindowInfo>& infos);
+    void updateInputWindowsByInfos(const std::vector<InputWindowInfo>& changedInfos,
+                                   const std::vector<int32_t>& ids);
     void setFocusedWindow(const sp<IBinder> token, const sp<IBinder> focusedToken,
                           nsecs_t timestampNanos);
 
@@ -145,6 +147,9 @@ public:
     binder::Status setInputWindows(
             const std::vector<InputWindowInfo>& handles,
             const sp<ISetInputWindowsListener>& setInputWindowsListener) override;
+    binder::Status updateInputWindows(
+            const std::vector<InputWindowInfo>& changedInfos, const std::vector<int32_t>& ids,
+            const sp<ISetInputWindowsListener>& setInputWindowsListener) override;
 
     binder::Status createInputChannel(const std::string& name, InputChannel* outChannel) override;
     binder::Status removeInputChannel(const sp<IBinder>& connectionToken) override;
@@ -211,6 +216,31 @@ binder::Status TestInputManager::setInputWindows(
     return binder::Status::ok();
 }
 
+binder::Status TestInputManager::updateInputWindows(
+        const std::vector<InputWindowInfo>& changedInfos, const std::vector<int32_t>& ids,
+        const sp<ISetInputWindowsListener>& setInputWindowsListener) {
+    AutoMutex _l(mLock);
+
+    std::unordered_map<int32_t, InputWindowInfo> infosById;
+    for (const auto& [displayId, handles] : mHandlesPerDisplay) {
+        for (const sp<InputWindowHandle>& handle : handles) {
+            infosById[handle->getId()] = *handle->getInfo();
+        }
+    }
+    for (const auto& info : changedInfos) {
+        infosById[info.id] = info;
+    }
+    mHandlesPerDisplay.clear();
+    for (int32_t id : ids) {
+        const InputWindowInfo& info = infosById[id];
+        mHandlesPerDisplay[info.displayId].push_back(new InputWindowHandle(info));
+    }
+    if (setInputWindowsListener) {
+        setInputWindowsListener->onSetInputWindowsFinished();
+    }
+    return binder::Status::ok();
+}
+
 binder::Status TestInputManager::createInputChannel(const std::string& name,
                                                     InputChannel* outChannel) {
     AutoMutex _l(mLock);
@@ -352,6 +382,14 @@ void InputFlingerServiceTest::setInputWindowsByInfos(const std::vector<InputWind
     EXPECT_NE(mSetInputWindowsFinishedCondition.wait_for(lock, 1s), std::cv_status::timeout);
 }
 
+void InputFlingerServiceTest::updateInputWindowsByInfos(
+        const std::vector<InputWindowInfo>& changedInfos, const std::vector<int32_t>& ids) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mService->updateInputWindows(changedInfos, ids, mSetInputWindowsListener);
+    // Verify listener call
+    EXPECT_NE(mSetInputWindowsFinishedCondition.wait_for(lock, 1s), std::cv_status::timeout);
+}
+
 void InputFlingerServiceTest::setFocusedWindow(const sp<IBinder> token,
                                                const sp<IBinder> focusedToken,
                                                nsecs_t timestampNanos) {
@@ -379,6 +417,24 @@ TEST_F(InputFlingerServiceTest, InputWindow_SetInputWindows) {
     }
 }
 
+/**
+ *  Test InputFlinger service interface updateInputWindows
+ */
+TEST_F(InputFlingerServiceTest, InputWindow_UpdateInputWindows) {
+    updateInputWindowsByInfos({getInfo()}, {getInfo().id});
+
+    std::vector<::android::InputWindowInfo> windowInfos;
+    mQuery->getInputWindows(&windowInfos);
+    ASSERT_EQ(1u, windowInfos.size());
+    verifyInputWindowInfo(windowInfos[0]);
+
+    // Windows missing from the ids are removed.
+    updateInputWindowsByInfos({}, {});
+    windowInfos.clear();
+    mQuery->getInputWindows(&windowInfos);
+    EXPECT_TRUE(windowInfos.empty());
+}
+
 /**
  *  Test InputFlinger service interface createInputChannel
  */
@@ -1798,6 +1798,34 @@ TEST_F(InputReaderTest, LoopOnce_ForwardsRawEventsToMappers) {
     ASSERT_EQ(1, event.value);
 }
 
+TEST_F(InputReaderTest, LoopOnce_ForwardsRawEventsOfSeveralDevicesToMappers) {
+    constexpr Flags<InputDeviceClass> deviceClass = InputDeviceClass::KEYBOARD;
+    constexpr nsecs_t when = 0;
+    constexpr nsecs_t readTime = 2;
+    FakeInputMapper& mapper1 =
+            addDeviceWithFakeInputMapper(END_RESERVED_ID + 1000, 1, "fake1", deviceClass,
+                                         AINPUT_SOURCE_KEYBOARD, nullptr);
+    FakeInputMapper& mapper2 =
+            addDeviceWithFakeInputMapper(END_RESERVED_ID + 1001, 2, "fake2", deviceClass,
+                                         AINPUT_SOURCE_KEYBOARD, nullptr);
+
+    // The events queued by each device are flushed before the next device is processed, and all
+    // of the events read together are still processed in the same loop.
+    mFakeEventHub->enqueueEvent(when, readTime, 1, EV_KEY, KEY_A, 1);
+    mFakeEventHub->enqueueEvent(when, readTime, 2, EV_KEY, KEY_B, 1);
+    mFakeEventHub->enqueueEvent(when, readTime, 1, EV_KEY, KEY_A, 0);
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mFakeEventHub->assertQueueIsEmpty());
+
+    RawEvent event;
+    ASSERT_NO_FATAL_FAILURE(mapper1.assertProcessWasCalled(&event));
+    ASSERT_EQ(KEY_A, event.code);
+    ASSERT_EQ(0, event.value);
+    ASSERT_NO_FATAL_FAILURE(mapper2.assertProcessWasCalled(&event));
+    ASSERT_EQ(KEY_B, event.code);
+    ASSERT_EQ(1, event.value);
+}
+
 TEST_F(InputReaderTest, DeviceReset_RandomId) {
     constexpr int32_t deviceId = END_RESERVED_ID + 1000;
     constexpr Flags<InputDeviceClass> deviceClass = InputDeviceClass::KEYBOARD;
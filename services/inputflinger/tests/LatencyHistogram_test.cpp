@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../dispatcher/LatencyHistogram.h"
+
+// atest inputflinger_tests:LatencyHistogramTest
+
+namespace android::inputdispatcher {
+
+static constexpr nsecs_t MS = 1000000;
+
+TEST(LatencyHistogramTest, EmptyHistogram_HasNoPercentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.getCount());
+    EXPECT_EQ(0, histogram.getPercentile(50));
+    EXPECT_EQ(0, histogram.getPercentile(99));
+}
+
+TEST(LatencyHistogramTest, Percentiles_AreUpperBoundsOfTheRecordedLatencies) {
+    LatencyHistogram histogram;
+    for (nsecs_t latency = 1; latency <= 100; latency++) {
+        histogram.add(latency * MS);
+    }
+    EXPECT_EQ(100u, histogram.getCount());
+
+    for (float percentile : {1.f, 50.f, 90.f, 99.f, 100.f}) {
+        const nsecs_t exact = static_cast<nsecs_t>(percentile) * MS;
+        const nsecs_t estimate = histogram.getPercentile(percentile);
+        EXPECT_GE(estimate, exact) << "p" << percentile;
+        // A bucket is a quarter of an octave wide.
+        EXPECT_LE(estimate, exact * 1.19 + 1) << "p" << percentile;
+    }
+}
+
+TEST(LatencyHistogramTest, NegativeAndHugeLatencies_AreClamped) {
+    LatencyHistogram histogram;
+    histogram.add(-5 * MS);
+    EXPECT_EQ(LatencyHistogram::getBucketUpperBound(0), histogram.getPercentile(100));
+
+    histogram.add(3600 * 1000 * MS);
+    EXPECT_EQ(2u, histogram.getCount());
+    EXPECT_EQ(LatencyHistogram::getBucketUpperBound(LatencyHistogram::BUCKET_COUNT - 1),
+              histogram.getPercentile(100));
+}
+
+} // namespace android::inputdispatcher
@@ -32,7 +32,8 @@ InputEventTimeline getTestTimeline() {
     InputEventTimeline t(
             /*isDown*/ true,
             /*eventTime*/ 2,
-            /*readTime*/ 3);
+            /*readTime*/ 3,
+            /*deviceId*/ 4);
     ConnectionTimeline expectedCT(/*deliveryTime*/ 6, /* consumeTime*/ 7, /*finishTime*/ 8);
     std::array<nsecs_t, GraphicsTimeline::SIZE> graphicsTimeline;
     graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME] = 9;
@@ -120,8 +121,9 @@ void LatencyTrackerTest::assertReceivedTimelines(const std::vector<InputEventTim
  * any additional ConnectionTimeline's.
  */
 TEST_F(LatencyTrackerTest, TrackListener_DoesNotTriggerReporting) {
-    mTracker->trackListener(1 /*inputEventId*/, false /*isDown*/, 2 /*eventTime*/, 3 /*readTime*/);
-    assertReceivedTimeline(InputEventTimeline{false, 2, 3});
+    mTracker->trackListener(1 /*inputEventId*/, false /*isDown*/, 2 /*eventTime*/, 3 /*readTime*/,
+                            4 /*deviceId*/);
+    assertReceivedTimeline(InputEventTimeline{false, 2, 3, 4});
 }
 
 /**
@@ -150,7 +152,8 @@ TEST_F(LatencyTrackerTest, TrackAllParameters_ReportsFullTimeline) {
 
     const auto& [connectionToken, expectedCT] = *expected.connectionTimelines.begin();
 
-    mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime);
+    mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime,
+                            expected.deviceId);
     mTracker->trackFinishedEvent(inputEventId, connectionToken, expectedCT.deliveryTime,
                                  expectedCT.consumeTime, expectedCT.finishTime);
     mTracker->trackGraphicsLatency(inputEventId, connectionToken, expectedCT.graphicsTimeline);
@@ -163,7 +166,8 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
     InputEventTimeline timeline1(
             /*isDown*/ true,
             /*eventTime*/ 2,
-            /*readTime*/ 3);
+            /*readTime*/ 3,
+            /*deviceId*/ 4);
     timeline1.connectionTimelines.emplace(connection1,
                                           ConnectionTimeline(/*deliveryTime*/ 6, /*consumeTime*/ 7,
                                                              /*finishTime*/ 8));
@@ -177,7 +181,8 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
     InputEventTimeline timeline2(
             /*isDown*/ false,
             /*eventTime*/ 20,
-            /*readTime*/ 30);
+            /*readTime*/ 30,
+            /*deviceId*/ 40);
     timeline2.connectionTimelines.emplace(connection2,
                                           ConnectionTimeline(/*deliveryTime*/ 60,
                                                              /*consumeTime*/ 70,
@@ -190,10 +195,10 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
 
     // Start processing first event
     mTracker->trackListener(inputEventId1, timeline1.isDown, timeline1.eventTime,
-                            timeline1.readTime);
+                            timeline1.readTime, timeline1.deviceId);
     // Start processing second event
     mTracker->trackListener(inputEventId2, timeline2.isDown, timeline2.eventTime,
-                            timeline2.readTime);
+                            timeline2.readTime, timeline2.deviceId);
     mTracker->trackFinishedEvent(inputEventId1, connection1, connectionTimeline1.deliveryTime,
                                  connectionTimeline1.consumeTime, connectionTimeline1.finishTime);
 
@@ -218,9 +223,9 @@ TEST_F(LatencyTrackerTest, IncompleteEvents_AreHandledConsistently) {
 
     for (size_t i = 1; i <= 100; i++) {
         mTracker->trackListener(i /*inputEventId*/, timeline.isDown, timeline.eventTime,
-                                timeline.readTime);
-        expectedTimelines.push_back(
-                InputEventTimeline{timeline.isDown, timeline.eventTime, timeline.readTime});
+                                timeline.readTime, timeline.deviceId);
+        expectedTimelines.push_back(InputEventTimeline{timeline.isDown, timeline.eventTime,
+                                                       timeline.readTime, timeline.deviceId});
     }
     // Now, complete the first event that was sent.
     mTracker->trackFinishedEvent(1 /*inputEventId*/, token, expectedCT.deliveryTime,
@@ -245,9 +250,10 @@ TEST_F(LatencyTrackerTest, EventsAreTracked_WhenTrackListenerIsCalledFirst) {
                                  expectedCT.consumeTime, expectedCT.finishTime);
     mTracker->trackGraphicsLatency(inputEventId, connection1, expectedCT.graphicsTimeline);
 
-    mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime);
-    assertReceivedTimeline(
-            InputEventTimeline{expected.isDown, expected.eventTime, expected.readTime});
+    mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime,
+                            expected.deviceId);
+    assertReceivedTimeline(InputEventTimeline{expected.isDown, expected.eventTime,
+                                              expected.readTime, expected.deviceId});
 }
 
 } // namespace android::inputdispatcher
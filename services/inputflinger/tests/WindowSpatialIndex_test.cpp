@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../WindowSpatialIndex.h"
+
+// atest inputflinger_tests:WindowSpatialIndexTest
+
+namespace android::inputdispatcher {
+
+using namespace android::flag_operators;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace {
+
+class FakeWindowHandle : public InputWindowHandle {
+public:
+    FakeWindowHandle(const Rect& frame, Flags<InputWindowInfo::Flag> flags) {
+        mInfo.frameLeft = frame.left;
+        mInfo.frameTop = frame.top;
+        mInfo.frameRight = frame.right;
+        mInfo.frameBottom = frame.bottom;
+        mInfo.touchableRegion = Region(frame);
+        mInfo.flags = flags;
+    }
+
+    bool updateInfo() { return true; }
+    void addTouchableRegion(const Rect& region) { mInfo.addTouchableRegion(region); }
+};
+
+static sp<FakeWindowHandle> createWindow(const Rect& frame) {
+    return new FakeWindowHandle(frame, InputWindowInfo::Flag::NOT_TOUCH_MODAL);
+}
+
+} // namespace
+
+TEST(WindowSpatialIndexTest, ReturnsWindowsContainingPointFrontToBack) {
+    std::vector<sp<InputWindowHandle>> windows;
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    windows.push_back(createWindow(Rect(1000, 2000, 1100, 2100)));
+    windows.push_back(createWindow(Rect(0, 0, 1100, 2100)));
+    WindowSpatialIndex index(windows);
+
+    EXPECT_THAT(index.getWindowIndexesAt(50, 50, nullptr), ElementsAre(0, 2));
+    EXPECT_THAT(index.getWindowIndexesAt(1050, 2050, nullptr), ElementsAre(1, 2));
+    EXPECT_THAT(index.getWindowIndexesAt(2000, 50, nullptr), IsEmpty());
+    EXPECT_THAT(index.getWindowIndexesAt(-1, 50, nullptr), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, IndexesTouchableRegionOutsideFrame) {
+    sp<FakeWindowHandle> window = createWindow(Rect(0, 0, 100, 100));
+    window->addTouchableRegion(Rect(500, 500, 600, 600));
+    std::vector<sp<InputWindowHandle>> windows;
+    windows.push_back(createWindow(Rect(0, 0, 1000, 1000)));
+    windows.push_back(window);
+    WindowSpatialIndex index(windows);
+
+    EXPECT_THAT(index.getWindowIndexesAt(550, 550, nullptr), ElementsAre(0, 1));
+}
+
+TEST(WindowSpatialIndexTest, AlwaysReturnsTouchModalAndOutsideWatchingWindows) {
+    std::vector<sp<InputWindowHandle>> windows;
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    windows.push_back(new FakeWindowHandle(Rect(0, 0, 10, 10), {}));
+    windows.push_back(new FakeWindowHandle(Rect(0, 0, 10, 10),
+                                           InputWindowInfo::Flag::NOT_TOUCH_MODAL |
+                                                   InputWindowInfo::Flag::WATCH_OUTSIDE_TOUCH));
+    windows.push_back(createWindow(Rect(0, 0, 1000, 1000)));
+    WindowSpatialIndex index(windows);
+
+    EXPECT_THAT(index.getWindowIndexesAt(500, 500, nullptr), ElementsAre(1, 2, 3));
+    EXPECT_THAT(index.getWindowIndexesAt(5000, 5000, nullptr), ElementsAre(1, 2));
+}
+
+TEST(WindowSpatialIndexTest, ReturnsOnlyWindowsAboveGivenWindow) {
+    std::vector<sp<InputWindowHandle>> windows;
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    windows.push_back(new FakeWindowHandle(Rect(0, 0, 10, 10), {}));
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    WindowSpatialIndex index(windows);
+
+    EXPECT_THAT(index.getWindowIndexesAt(50, 50, windows[2]), ElementsAre(0, 1));
+    EXPECT_THAT(index.getWindowIndexesAt(50, 50, windows[0]), IsEmpty());
+    EXPECT_THAT(index.getWindowIndexesAt(50, 50, createWindow(Rect(0, 0, 100, 100))),
+                ElementsAre(0, 1, 2, 3));
+}
+
+TEST(WindowSpatialIndexTest, HandlesWindowsSpanningWholeCoordinateRange) {
+    std::vector<sp<InputWindowHandle>> windows;
+    windows.push_back(createWindow(Rect(0, 0, 100, 100)));
+    windows.push_back(createWindow(Rect(INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX)));
+    WindowSpatialIndex index(windows);
+
+    EXPECT_THAT(index.getWindowIndexesAt(50, 50, nullptr), ElementsAre(0, 1));
+    EXPECT_THAT(index.getWindowIndexesAt(INT32_MIN, INT32_MAX - 1, nullptr), ElementsAre(1));
+}
+
+} // namespace android::inputdispatcher
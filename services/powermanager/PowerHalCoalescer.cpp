@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *                        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PowerHalCoalescer"
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/Mode.h>
+#include <powermanager/PowerHalCoalescer.h>
+#include <powermanager/PowerHalController.h>
+#include <pthread.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace android::hardware::power;
+
+namespace android {
+
+namespace power {
+
+// -------------------------------------------------------------------------------------------------
+
+PowerHalCoalescer::PowerHalCoalescer()
+      : PowerHalCoalescer(std::make_unique<PowerHalController>()) {}
+
+PowerHalCoalescer::PowerHalCoalescer(std::unique_ptr<HalWrapper> hal)
+      : mHal(std::move(hal)), mThread(&PowerHalCoalescer::threadMain, this) {}
+
+PowerHalCoalescer::~PowerHalCoalescer() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+HalResult<void> PowerHalCoalescer::setBoost(Boost boost, int32_t durationMs) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto pending = mPendingBoosts.find(boost);
+    if (pending != mPendingBoosts.end()) {
+        pending->second = std::max(pending->second, durationMs);
+        return HalResult<void>::ok();
+    }
+    auto active = mActiveBoosts.find(boost);
+    if (durationMs > 0 && active != mActiveBoosts.end() &&
+        active->second >= Clock::now() + std::chrono::milliseconds(durationMs)) {
+        return HalResult<void>::ok();
+    }
+    mPendingBoosts.emplace(boost, durationMs);
+    mCondition.notify_all();
+    return HalResult<void>::ok();
+}
+
+HalResult<void> PowerHalCoalescer::setMode(Mode mode, bool enabled) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto sent = mSentModes.find(mode);
+    if (sent != mSentModes.end() && sent->second == enabled) {
+        // Cancels a change to the other state that is still waiting to be sent, if any.
+        mPendingModes.erase(mode);
+        return HalResult<void>::ok();
+    }
+    mPendingModes[mode] = enabled;
+    mCondition.notify_all();
+    return HalResult<void>::ok();
+}
+
+HalResult<sp<IPowerHintSession>> PowerHalCoalescer::createHintSession(
+        int32_t tgid, int32_t uid, const std::vector<int32_t>& threadIds, int64_t durationNanos) {
+    return mHal->createHintSession(tgid, uid, threadIds, durationNanos);
+}
+
+HalResult<int64_t> PowerHalCoalescer::getHintSessionPreferredRate() {
+    return mHal->getHintSessionPreferredRate();
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void PowerHalCoalescer::flush() NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mMutex);
+    // What is pending now goes out in the round after the one being sent, if any.
+    const bool hasPending = !mPendingBoosts.empty() || !mPendingModes.empty();
+    const uint64_t generation = mSentGeneration + (mSending ? 1 : 0) + (hasPending ? 1 : 0);
+    mCondition.wait(lock, [this, generation]() NO_THREAD_SAFETY_ANALYSIS {
+        return mSentGeneration >= generation;
+    });
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void PowerHalCoalescer::threadMain() NO_THREAD_SAFETY_ANALYSIS {
+    pthread_setname_np(pthread_self(), "PowerHalHints");
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this]() NO_THREAD_SAFETY_ANALYSIS {
+            return !mRunning || !mPendingBoosts.empty() || !mPendingModes.empty();
+        });
+        if (mPendingBoosts.empty() && mPendingModes.empty()) {
+            // Stopping, with everything sent.
+            break;
+        }
+
+        std::map<Boost, int32_t> boosts;
+        std::map<Mode, bool> modes;
+        boosts.swap(mPendingBoosts);
+        modes.swap(mPendingModes);
+        mSending = true;
+        lock.unlock();
+
+        // The results of the calls only change the state once the lock is back.
+        std::vector<std::pair<Mode, bool>> sentModes;
+        std::vector<Mode> failedModes;
+        for (const auto& [mode, enabled] : modes) {
+            if (mHal->setMode(mode, enabled).isOk()) {
+                sentModes.emplace_back(mode, enabled);
+            } else {
+                failedModes.push_back(mode);
+            }
+        }
+        std::vector<std::pair<Boost, Clock::time_point>> activeBoosts;
+        for (const auto& [boost, durationMs] : boosts) {
+            if (mHal->setBoost(boost, durationMs).isOk() && durationMs > 0) {
+                activeBoosts.emplace_back(boost,
+                                          Clock::now() + std::chrono::milliseconds(durationMs));
+            }
+        }
+
+        lock.lock();
+        for (const auto& [mode, enabled] : sentModes) {
+            mSentModes[mode] = enabled;
+        }
+        // The state of the HAL is unknown after a failure, so the next change is always sent.
+        for (Mode mode : failedModes) {
+            mSentModes.erase(mode);
+        }
+        for (const auto& [boost, end] : activeBoosts) {
+            mActiveBoosts[boost] = end;
+        }
+        mSending = false;
+        mSentGeneration++;
+        mCondition.notify_all();
+    }
+}
+
+} // namespace power
+
+} // namespace android
@@ -19,6 +19,7 @@
 #include <android/hardware/power/Boost.h>
 #include <android/hardware/power/Mode.h>
 #include <benchmark/benchmark.h>
+#include <powermanager/PowerHalCoalescer.h>
 #include <powermanager/PowerHalController.h>
 #include <testUtil.h>
 #include <chrono>
@@ -26,6 +27,7 @@
 using android::hardware::power::Boost;
 using android::hardware::power::Mode;
 using android::power::HalResult;
+using android::power::PowerHalCoalescer;
 using android::power::PowerHalController;
 
 using namespace android;
@@ -71,6 +73,31 @@ static void runCachedBenchmark(benchmark::State& state,
     }
 }
 
+template <typename T, class... Args0, class... Args1>
+static void runCoalescedBenchmark(benchmark::State& state,
+                                  HalResult<T> (PowerHalCoalescer::*fn)(Args0...),
+                                  Args1&&... args1) {
+    PowerHalCoalescer coalescer;
+    // First call out of test, to cache HAL service and isSupported result.
+    (coalescer.*fn)(std::forward<Args1>(args1)...);
+    coalescer.flush();
+
+    while (state.KeepRunning()) {
+        HalResult<T> ret = (coalescer.*fn)(std::forward<Args1>(args1)...);
+        state.PauseTiming();
+        if (ret.isFailed()) {
+            state.SkipWithError("Power HAL request failed");
+        }
+        testDelaySpin(
+                std::chrono::duration_cast<std::chrono::duration<float>>(ONEWAY_API_DELAY).count());
+        state.ResumeTiming();
+    }
+
+    state.PauseTiming();
+    coalescer.flush();
+    state.ResumeTiming();
+}
+
 static void BM_PowerHalControllerBenchmarks_init(benchmark::State& state) {
     while (state.KeepRunning()) {
         PowerHalController controller;
@@ -98,6 +125,18 @@ static void BM_PowerHalControllerBenchmarks_setBoostCached(benchmark::State& sta
     runCachedBenchmark(state, &PowerHalController::setBoost, boost, 0);
 }
 
+static void BM_PowerHalControllerBenchmarks_setBoostCoalesced(benchmark::State& state) {
+    Boost boost = static_cast<Boost>(state.range(0));
+    runCoalescedBenchmark(state, &PowerHalCoalescer::setBoost, boost, 0);
+}
+
+static void BM_PowerHalControllerBenchmarks_setBoostWithDurationCoalesced(
+        benchmark::State& state) {
+    Boost boost = static_cast<Boost>(state.range(0));
+    // Every call after the first one comes while the boost is still active.
+    runCoalescedBenchmark(state, &PowerHalCoalescer::setBoost, boost, 60000);
+}
+
 static void BM_PowerHalControllerBenchmarks_setMode(benchmark::State& state) {
     Mode mode = static_cast<Mode>(state.range(0));
     runBenchmark(state, &PowerHalController::setMode, mode, false);
@@ -108,9 +147,19 @@ static void BM_PowerHalControllerBenchmarks_setModeCached(benchmark::State& stat
     runCachedBenchmark(state, &PowerHalController::setMode, mode, false);
 }
 
+static void BM_PowerHalControllerBenchmarks_setModeCoalesced(benchmark::State& state) {
+    Mode mode = static_cast<Mode>(state.range(0));
+    runCoalescedBenchmark(state, &PowerHalCoalescer::setMode, mode, false);
+}
+
 BENCHMARK(BM_PowerHalControllerBenchmarks_init);
 BENCHMARK(BM_PowerHalControllerBenchmarks_initCached);
 BENCHMARK(BM_PowerHalControllerBenchmarks_setBoost)->DenseRange(FIRST_BOOST, LAST_BOOST, 1);
 BENCHMARK(BM_PowerHalControllerBenchmarks_setBoostCached)->DenseRange(FIRST_BOOST, LAST_BOOST, 1);
+BENCHMARK(BM_PowerHalControllerBenchmarks_setBoostCoalesced)
+        ->DenseRange(FIRST_BOOST, LAST_BOOST, 1);
+BENCHMARK(BM_PowerHalControllerBenchmarks_setBoostWithDurationCoalesced)
+        ->DenseRange(FIRST_BOOST, LAST_BOOST, 1);
 BENCHMARK(BM_PowerHalControllerBenchmarks_setMode)->DenseRange(FIRST_MODE, LAST_MODE, 1);
 BENCHMARK(BM_PowerHalControllerBenchmarks_setModeCached)->DenseRange(FIRST_MODE, LAST_MODE, 1);
+BENCHMARK(BM_PowerHalControllerBenchmarks_setModeCoalesced)->DenseRange(FIRST_MODE, LAST_MODE, 1);
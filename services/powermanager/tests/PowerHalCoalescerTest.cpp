@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *            http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "PowerHalCoalescerTest"
+
+#include <android/hardware/power/Boost.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/Mode.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <powermanager/PowerHalCoalescer.h>
+#include <utils/Log.h>
+
+#include <future>
+
+using android::hardware::power::Boost;
+using android::hardware::power::IPowerHintSession;
+using android::hardware::power::Mode;
+
+using namespace android;
+using namespace android::power;
+using namespace testing;
+
+// -------------------------------------------------------------------------------------------------
+
+class MockHalWrapper : public HalWrapper {
+public:
+    MOCK_METHOD(HalResult<void>, setBoost, (Boost boost, int32_t durationMs), (override));
+    MOCK_METHOD(HalResult<void>, setMode, (Mode mode, bool enabled), (override));
+    MOCK_METHOD(HalResult<sp<IPowerHintSession>>, createHintSession,
+                (int32_t tgid, int32_t uid, const std::vector<int32_t>& threadIds,
+                 int64_t durationNanos),
+                (override));
+    MOCK_METHOD(HalResult<int64_t>, getHintSessionPreferredRate, (), (override));
+};
+
+// -------------------------------------------------------------------------------------------------
+
+class PowerHalCoalescerTest : public Test {
+public:
+    void SetUp() override {
+        std::unique_ptr<StrictMock<MockHalWrapper>> hal =
+                std::make_unique<StrictMock<MockHalWrapper>>();
+        mMockHal = hal.get();
+        mCoalescer = std::make_unique<PowerHalCoalescer>(std::move(hal));
+    }
+
+protected:
+    StrictMock<MockHalWrapper>* mMockHal = nullptr;
+    std::unique_ptr<PowerHalCoalescer> mCoalescer = nullptr;
+
+    // Keeps the thread of the coalescer busy sending a boost until the returned promise is set,
+    // so that the hints sent in the meantime are all pending together.
+    std::promise<void> blockHalThread() {
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::promise<void> blocked;
+        std::future<void> isBlocked = blocked.get_future();
+        EXPECT_CALL(*mMockHal, setBoost(Eq(Boost::CAMERA_LAUNCH), Eq(0)))
+                .WillOnce(DoAll(InvokeWithoutArgs([&blocked, released]() {
+                                    blocked.set_value();
+                                    released.wait();
+                                }),
+                                Return(HalResult<void>::ok())));
+        mCoalescer->setBoost(Boost::CAMERA_LAUNCH, 0);
+        isBlocked.wait();
+        return release;
+    }
+};
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_F(PowerHalCoalescerTest, TestSetBoostDropsPendingDuplicates) {
+    std::promise<void> release = blockHalThread();
+    EXPECT_CALL(*mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(1000)))
+            .WillOnce(Return(HalResult<void>::ok()));
+
+    ASSERT_TRUE(mCoalescer->setBoost(Boost::INTERACTION, 100).isOk());
+    ASSERT_TRUE(mCoalescer->setBoost(Boost::INTERACTION, 1000).isOk());
+    ASSERT_TRUE(mCoalescer->setBoost(Boost::INTERACTION, 10).isOk());
+    release.set_value();
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestSetBoostDropsDuplicatesWhileActive) {
+    EXPECT_CALL(*mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(10000)))
+            .WillOnce(Return(HalResult<void>::ok()));
+    EXPECT_CALL(*mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(20000)))
+            .WillOnce(Return(HalResult<void>::ok()));
+
+    mCoalescer->setBoost(Boost::INTERACTION, 10000);
+    mCoalescer->flush();
+    // Ends before the active boost does.
+    mCoalescer->setBoost(Boost::INTERACTION, 5000);
+    mCoalescer->flush();
+    // Ends after it.
+    mCoalescer->setBoost(Boost::INTERACTION, 20000);
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestSetBoostWithoutDurationIsSentAgain) {
+    EXPECT_CALL(*mMockHal, setBoost(Eq(Boost::INTERACTION), Eq(0)))
+            .Times(Exactly(2))
+            .WillRepeatedly(Return(HalResult<void>::ok()));
+
+    mCoalescer->setBoost(Boost::INTERACTION, 0);
+    mCoalescer->flush();
+    mCoalescer->setBoost(Boost::INTERACTION, 0);
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestSetModeSendsLastPendingState) {
+    std::promise<void> release = blockHalThread();
+    EXPECT_CALL(*mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+            .WillOnce(Return(HalResult<void>::ok()));
+    EXPECT_CALL(*mMockHal, setMode(Eq(Mode::INTERACTIVE), Eq(false)))
+            .WillOnce(Return(HalResult<void>::ok()));
+
+    ASSERT_TRUE(mCoalescer->setMode(Mode::LAUNCH, true).isOk());
+    ASSERT_TRUE(mCoalescer->setMode(Mode::INTERACTIVE, false).isOk());
+    ASSERT_TRUE(mCoalescer->setMode(Mode::LAUNCH, false).isOk());
+    ASSERT_TRUE(mCoalescer->setMode(Mode::LAUNCH, true).isOk());
+    release.set_value();
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestSetModeSkipsStateAlreadySent) {
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+                .WillOnce(Return(HalResult<void>::ok()));
+        EXPECT_CALL(*mMockHal, setMode(Eq(Mode::LAUNCH), Eq(false)))
+                .WillOnce(Return(HalResult<void>::ok()));
+    }
+
+    mCoalescer->setMode(Mode::LAUNCH, true);
+    mCoalescer->flush();
+    mCoalescer->setMode(Mode::LAUNCH, true);
+    mCoalescer->flush();
+    mCoalescer->setMode(Mode::LAUNCH, false);
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestSetModeIsSentAgainAfterFailure) {
+    EXPECT_CALL(*mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+            .WillOnce(Return(HalResult<void>::failed("Unable to set mode")))
+            .WillOnce(Return(HalResult<void>::ok()));
+
+    mCoalescer->setMode(Mode::LAUNCH, true);
+    mCoalescer->flush();
+    mCoalescer->setMode(Mode::LAUNCH, true);
+    mCoalescer->flush();
+}
+
+TEST_F(PowerHalCoalescerTest, TestPendingHintsAreSentOnDestruction) {
+    std::promise<void> release = blockHalThread();
+    EXPECT_CALL(*mMockHal, setMode(Eq(Mode::LAUNCH), Eq(true)))
+            .WillOnce(Return(HalResult<void>::ok()));
+
+    mCoalescer->setMode(Mode::LAUNCH, true);
+    release.set_value();
+    mCoalescer = nullptr;
+}
+
+TEST_F(PowerHalCoalescerTest, TestHintSessionCallsAreForwarded) {
+    std::vector<int32_t> threadIds = {1, 2};
+    EXPECT_CALL(*mMockHal, createHintSession(Eq(1), Eq(2), Eq(threadIds), Eq(16666666L)))
+            .WillOnce(Return(HalResult<sp<IPowerHintSession>>::ok(nullptr)));
+    EXPECT_CALL(*mMockHal, getHintSessionPreferredRate())
+            .WillOnce(Return(HalResult<int64_t>::ok(1000)));
+
+    ASSERT_TRUE(mCoalescer->createHintSession(1, 2, threadIds, 16666666L).isOk());
+    auto rate = mCoalescer->getHintSessionPreferredRate();
+    ASSERT_TRUE(rate.isOk());
+    EXPECT_EQ(1000, rate.value());
+}
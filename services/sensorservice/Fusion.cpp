@@ -317,6 +317,12 @@ void Fusion::handleGyro(const vec3_t& w, float dT) {
     predict(w, dT);
 }
 
+void Fusion::handleGyro(const vec3_t* w, const float* dT, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        handleGyro(w[i], dT[i]);
+    }
+}
+
 status_t Fusion::handleAcc(const vec3_t& a, float dT) {
     if (!checkInitComplete(ACC, a, dT))
         return BAD_VALUE;
@@ -487,7 +493,25 @@ void Fusion::predict(const vec3_t& w, float dT) {
     if (x0.w < 0)
         x0 = -x0;
 
-    P = Phi*P*transpose(Phi) + GQGt;
+    // P = Phi*P*transpose(Phi) + GQGt, using the structure of Phi:
+    //
+    //  Phi*P*Phi' = | Phi00 Phi10 | * | P00  P10 | * | Phi00' 0 |
+    //               |   0     1   |   | P10t P11 |   | Phi10' 1 |
+    //
+    //             = | U*Phi00' + T*Phi10'  T   |
+    //               | Tt                   P11 |
+    //
+    //  with U = Phi00*P00 + Phi10*P10t and T = Phi00*P10 + Phi10*P11
+    //
+    // which takes 6 3x3 products instead of the 16 of the generic product.
+    const mat33_t& Phi00(Phi[0][0]);
+    const mat33_t& Phi10(Phi[1][0]);
+    const mat33_t U(Phi00*P[0][0] + Phi10*transpose(P[1][0]));
+    const mat33_t T(Phi00*P[1][0] + Phi10*P[1][1]);
+    P[0][0] = U*transpose(Phi00) + T*transpose(Phi10) + GQGt[0][0];
+    P[1][0] = T + GQGt[1][0];
+    P[0][1] = transpose(P[1][0]);
+    P[1][1] += GQGt[1][1];
 
     checkState();
 }
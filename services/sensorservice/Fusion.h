@@ -64,6 +64,8 @@ public:
     Fusion();
     void init(int mode = FUSION_9AXIS);
     void handleGyro(const vec3_t& w, float dT);
+    // same as calling handleGyro for each of the count samples in order
+    void handleGyro(const vec3_t* w, const float* dT, size_t count);
     status_t handleAcc(const vec3_t& a, float dT);
     status_t handleMag(const vec3_t& m);
     vec4_t getAttitude() const;
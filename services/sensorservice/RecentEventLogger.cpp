@@ -21,6 +21,7 @@
 #include <frameworks/base/core/proto/android/service/sensor_service.proto.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
 #include <inttypes.h>
 
 namespace android {
@@ -32,25 +33,35 @@ namespace {
     constexpr size_t LOG_SIZE_LARGE = 50;  // larger samples for debugging
 }// unnamed namespace
 
-RecentEventLogger::RecentEventLogger(int sensorType) :
+RecentEventLogger::RecentEventLogger(int sensorType, size_t sampleInterval) :
         mSensorType(sensorType), mEventSize(eventSizeBySensorType(mSensorType)),
-        mRecentEvents(logSizeBySensorType(sensorType)), mMaskData(false),
-        mIsLastEventCurrent(false) {
+        mSampleInterval(std::max<size_t>(sampleInterval, 1)),
+        mRecentEvents(logSizeBySensorType(sensorType)), mEventsSinceSample(0),
+        mLastEventSeq(0), mMaskData(false), mIsLastEventCurrent(false) {
     // blank
 }
 
 void RecentEventLogger::addEvent(const sensors_event_t& event) {
-    std::lock_guard<std::mutex> lk(mLock);
-    mRecentEvents.emplace(event);
+    const uint32_t seq = mLastEventSeq.load(std::memory_order_relaxed);
+    mLastEventSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mLastEvent = event;
+    mLastEventSeq.store(seq + 2, std::memory_order_release);
     mIsLastEventCurrent = true;
+
+    if (++mEventsSinceSample >= mSampleInterval) {
+        mEventsSinceSample = 0;
+        std::lock_guard<std::mutex> lk(mLock);
+        mRecentEvents.emplace(event);
+    }
 }
 
 bool RecentEventLogger::isEmpty() const {
+    std::lock_guard<std::mutex> lk(mLock);
     return mRecentEvents.size() == 0;
 }
 
 void RecentEventLogger::setLastEventStale() {
-    std::lock_guard<std::mutex> lk(mLock);
     mIsLastEventCurrent = false;
 }
 
@@ -60,7 +71,11 @@ std::string RecentEventLogger::dump() const {
     //TODO: replace String8 with std::string completely in this function
     String8 buffer;
 
-    buffer.appendFormat("last %zu events\n", mRecentEvents.size());
+    if (mSampleInterval > 1) {
+        buffer.appendFormat("last %zu events (1 in %zu)\n", mRecentEvents.size(), mSampleInterval);
+    } else {
+        buffer.appendFormat("last %zu events\n", mRecentEvents.size());
+    }
     int j = 0;
     for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
         const auto& ev = mRecentEvents[i];
@@ -129,15 +144,21 @@ void RecentEventLogger::setFormat(std::string format) {
 }
 
 bool RecentEventLogger::populateLastEventIfCurrent(sensors_event_t *event) const {
-    std::lock_guard<std::mutex> lk(mLock);
-
-    if (mIsLastEventCurrent && mRecentEvents.size()) {
-        // Index 0 contains the latest event emplace()'ed
-        *event = mRecentEvents[0].mEvent;
-        return true;
-    } else {
+    if (!mIsLastEventCurrent) {
         return false;
     }
+
+    // Retry until the event is copied while no event is being added.
+    uint32_t seq;
+    do {
+        seq = mLastEventSeq.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return false;
+        }
+        *event = mLastEvent;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != mLastEventSeq.load(std::memory_order_relaxed));
+    return true;
 }
 
 
@@ -23,6 +23,7 @@
 #include <hardware/sensors.h>
 #include <utils/String8.h>
 
+#include <atomic>
 #include <mutex>
 
 namespace android {
@@ -33,9 +34,13 @@ namespace SensorServiceUtil {
 // generated from the sensor are stored in this buffer.  The buffer is NOT cleared when the sensor
 // unregisters and as a result very old data in the dumpsys output can be seen, which is an intended
 // behavior.
+//
+// Events are added by a single thread without locking, except for the events sampled into the
+// buffer: only one in sampleInterval events is stored there. The last event is always kept, so
+// that populateLastEventIfCurrent does not depend on the sampling.
 class RecentEventLogger : public Dumpable {
 public:
-    explicit RecentEventLogger(int sensorType);
+    explicit RecentEventLogger(int sensorType, size_t sampleInterval = 1);
     void addEvent(const sensors_event_t& event);
 
     // Populate event with the last recorded sensor event if it is not stale. An event is
@@ -60,12 +65,23 @@ protected:
 
     const int mSensorType;
     const size_t mEventSize;
+    const size_t mSampleInterval;
 
+    // Protects mRecentEvents.
     mutable std::mutex mLock;
     RingBuffer<SensorEventLog> mRecentEvents;
 
+    // Number of events added since the last one stored in mRecentEvents. Only used by the thread
+    // adding events.
+    size_t mEventsSinceSample;
+
+    // The last event added, guarded by a sequence lock: mLastEventSeq is odd while mLastEvent is
+    // being written, and 0 until the first event is added.
+    std::atomic<uint32_t> mLastEventSeq;
+    sensors_event_t mLastEvent;
+
     bool mMaskData;
-    bool mIsLastEventCurrent;
+    std::atomic_bool mIsLastEventCurrent;
 
 private:
     static size_t logSizeBySensorType(int sensorType);
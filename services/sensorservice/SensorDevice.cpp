@@ -120,6 +120,7 @@ SensorDevice::SensorDevice()
           mRestartWaiter(new HidlServiceRegistrationWaiter()),
           mEventQueueFlag(nullptr),
           mWakeLockQueueFlag(nullptr),
+          mPendingWakeLockHandled(0),
           mReconnecting(false) {
     if (!connectHidlService()) {
         return;
@@ -281,6 +282,7 @@ SensorDevice::HalConnectionStatus SensorDevice::initializeHidlServiceV2_X() {
     mWakeLockQueue = std::make_unique<WakeLockQueue>(
             SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT,
             true /* configureEventFlagWord */);
+    mPendingWakeLockHandled = 0;
 
     hardware::EventFlag::deleteEventFlag(&mEventQueueFlag);
     hardware::EventFlag::createEventFlag(mSensors->getEventQueue()->getEventFlagWord(), &mEventQueueFlag);
@@ -599,9 +601,8 @@ ssize_t SensorDevice::pollFmq(sensors_event_t* buffer, size_t maxNumEventsToRead
 
             for (size_t i = 0; i < eventsToRead; i++) {
                 convertToSensorEvent(mEventBuffer[i], &buffer[i]);
-                android::SensorDeviceUtils::quantizeSensorEventValues(&buffer[i],
-                        getResolutionForSensor(buffer[i].sensor));
             }
+            quantizeSensorEvents(buffer, eventsToRead);
             eventsRead = eventsToRead;
         } else {
             ALOGW("Failed to read %zu events, currently %zu events available",
@@ -641,10 +642,16 @@ Return<void> SensorDevice::onDynamicSensorsDisconnected(
 
 void SensorDevice::writeWakeLockHandled(uint32_t count) {
     if (mSensors != nullptr && mSensors->supportsMessageQueues()) {
-        if (mWakeLockQueue->write(&count)) {
+        // The HAL holds its wake lock until it hears of every wake up event, so a count that could
+        // not be written goes out with the next one rather than being lost.
+        uint32_t handled = mPendingWakeLockHandled + count;
+        if (mWakeLockQueue->write(&handled)) {
+            mPendingWakeLockHandled = 0;
             mWakeLockQueueFlag->wake(asBaseType(WakeLockQueueFlagBits::DATA_WRITTEN));
         } else {
-            ALOGW("Failed to write wake lock handled");
+            ALOGW("Failed to write wake lock handled, retrying %" PRIu32 " with the next events",
+                  handled);
+            mPendingWakeLockHandled = handled;
         }
     }
 }
@@ -1197,8 +1204,21 @@ void SensorDevice::convertToSensorEventsAndQuantize(
 
     for (size_t i = 0; i < src.size(); ++i) {
         V2_1::implementation::convertToSensorEvent(src[i], &dst[i]);
-        android::SensorDeviceUtils::quantizeSensorEventValues(&dst[i],
-                getResolutionForSensor(dst[i].sensor));
+    }
+    quantizeSensorEvents(dst, src.size());
+}
+
+void SensorDevice::quantizeSensorEvents(sensors_event_t* events, size_t count) {
+    // Batches mostly hold runs of events from the same sensor, so this saves searching the
+    // sensor list for every event.
+    int lastHandle = 0;
+    float resolution = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0 || events[i].sensor != lastHandle) {
+            lastHandle = events[i].sensor;
+            resolution = getResolutionForSensor(lastHandle);
+        }
+        android::SensorDeviceUtils::quantizeSensorEventValues(&events[i], resolution);
     }
 }
 
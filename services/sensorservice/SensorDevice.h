@@ -278,6 +278,10 @@ private:
 
     float getResolutionForSensor(int sensorHandle);
 
+    // Quantizes the values of consecutive events, looking up the resolution of a sensor once for
+    // each run of its events.
+    void quantizeSensorEvents(sensors_event_t* events, size_t count);
+
     bool mIsDirectReportSupported;
 
     typedef hardware::MessageQueue<uint32_t, hardware::kSynchronizedReadWrite> WakeLockQueue;
@@ -285,6 +289,9 @@ private:
 
     hardware::EventFlag* mEventQueueFlag;
     hardware::EventFlag* mWakeLockQueueFlag;
+    // Handled wake up events that could not be written to mWakeLockQueue yet, to be added to the
+    // next count written. Only accessed by the thread that polls.
+    uint32_t mPendingWakeLockHandled;
 
     std::array<Event, SensorEventQueue::MAX_RECEIVE_BUFFER_EVENT_COUNT> mEventBuffer;
 
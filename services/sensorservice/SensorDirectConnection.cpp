@@ -19,6 +19,7 @@
 #include <android/util/ProtoOutputStream.h>
 #include <frameworks/base/core/proto/android/service/sensor_service.proto.h>
 #include <hardware/sensors.h>
+#include <cinttypes>
 
 #define UNUSED(x) (void)(x)
 
@@ -63,8 +64,10 @@ void SensorService::SensorDirectConnection::onFirstRef() {
 
 void SensorService::SensorDirectConnection::dump(String8& result) const {
     Mutex::Autolock _l(mConnectionLock);
-    result.appendFormat("\tPackage %s, HAL channel handle %d, total sensor activated %zu\n",
-            String8(mOpPackageName).string(), getHalChannelHandle(), mActivated.size());
+    result.appendFormat("\tPackage %s, HAL channel handle %d, total sensor activated %zu, "
+            "unchanged configs skipped %" PRIu64 "\n",
+            String8(mOpPackageName).string(), getHalChannelHandle(), mActivated.size(),
+            mUnchangedConfigsSkipped);
     for (auto &i : mActivated) {
         result.appendFormat("\t\tSensor %#08x, rate %d\n", i.first, i.second);
     }
@@ -95,6 +98,11 @@ sp<BitTube> SensorService::SensorDirectConnection::getSensorChannel() const {
     return nullptr;
 }
 
+sp<SensorEventRing> SensorService::SensorDirectConnection::getSensorEventRing() {
+    // SensorDirectConnection writes to the channels registered by the client instead
+    return nullptr;
+}
+
 void SensorService::SensorDirectConnection::onSensorAccessChanged(bool hasAccess) {
     if (!hasAccess) {
         stopAll(true /* backupRecord */);
@@ -181,6 +189,18 @@ int32_t SensorService::SensorDirectConnection::configureChannel(int handle, int
     };
 
     Mutex::Autolock _l(mConnectionLock);
+    // Apps often configure a sensor again at the rate it already reports at, which would only
+    // have the HAL redo the same work.
+    if (rateLevel != SENSOR_DIRECT_RATE_STOP && rateLevel == requestedRateLevel) {
+        auto activated = mActivated.find(handle);
+        auto token = mReportTokens.find(handle);
+        if (activated != mActivated.end() && activated->second == rateLevel &&
+                token != mReportTokens.end()) {
+            mUnchangedConfigsSkipped++;
+            return token->second;
+        }
+    }
+
     SensorDevice& dev(SensorDevice::getInstance());
     int ret = dev.configureDirectChannel(handle, getHalChannelHandle(), &config);
 
@@ -188,12 +208,14 @@ int32_t SensorService::SensorDirectConnection::configureChannel(int handle, int
         if (ret == NO_ERROR) {
             mActivated.erase(handle);
             mMicRateBackup.erase(handle);
+            mReportTokens.erase(handle);
         } else if (ret > 0) {
             ret = UNKNOWN_ERROR;
         }
     } else {
         if (ret > 0) {
             mActivated[handle] = rateLevel;
+            mReportTokens[handle] = ret;
             if (mService->isSensorInCappedSet(s.getType())) {
                 // Back up the rates that the app is allowed to have if the mic toggle is off
                 // This is used in the uncapRates() function.
@@ -219,6 +241,7 @@ void SensorService::SensorDirectConnection::capRates() {
     const struct sensors_direct_cfg_t stopConfig = {
         .rate_level = SENSOR_DIRECT_RATE_STOP
     };
+    mReportTokens.clear();
 
     // If our requests are in the backup, then we shouldn't activate sensors from here
     bool temporarilyStopped = mActivated.empty() && !mActivatedBackup.empty();
@@ -250,6 +273,7 @@ void SensorService::SensorDirectConnection::capRates() {
 
 void SensorService::SensorDirectConnection::uncapRates() {
     Mutex::Autolock _l(mConnectionLock);
+    mReportTokens.clear();
 
     // If our requests are in the backup, then we shouldn't activate sensors from here
     bool temporarilyStopped = mActivated.empty() && !mActivatedBackup.empty();
@@ -300,6 +324,7 @@ void SensorService::SensorDirectConnection::stopAllLocked(bool backupRecord) {
         mActivatedBackup = mActivated;
     }
     mActivated.clear();
+    mReportTokens.clear();
 }
 
 void SensorService::SensorDirectConnection::recoverAll() {
@@ -63,6 +63,7 @@ protected:
     virtual status_t setEventRate(int handle, nsecs_t samplingPeriodNs);
     virtual status_t flush();
     virtual int32_t configureChannel(int handle, int rateLevel);
+    virtual sp<SensorEventRing> getSensorEventRing();
     virtual void destroy();
 private:
     bool hasSensorAccess() const;
@@ -99,6 +100,11 @@ private:
     std::unordered_map<int, int> mActivated;
     std::unordered_map<int, int> mActivatedBackup;
     std::unordered_map<int, int> mMicRateBackup;
+    // Report tokens the HAL returned for the sensors configured through configureChannel(), by
+    // handle. Cleared whenever the sensors are configured otherwise.
+    std::unordered_map<int, int32_t> mReportTokens;
+    // Configurations at the rate a sensor already reported at, which were not sent to the HAL.
+    uint64_t mUnchangedConfigsSkipped = 0;
 
     std::atomic_bool mIsRateCappedBasedOnPermission;
     mutable Mutex mDestroyLock;
@@ -297,7 +297,13 @@ status_t SensorService::SensorEventConnection::sendEvents(
 
     int count = 0;
     Mutex::Autolock _l(mConnectionLock);
-    if (scratch) {
+    // When filtering, the events for this connection are collected as ranges of the shared buffer
+    // in mEventRanges and written from there. They are only copied to scratch when they have to be
+    // cached.
+    const bool useEventRanges = scratch != nullptr;
+    if (useEventRanges) {
+        mEventRanges.clear();
+        const bool hasAccess = hasSensorAccess();
         size_t i=0;
         while (i<numEvents) {
             int32_t sensor_handle = buffer[i].sensor;
@@ -312,12 +318,13 @@ status_t SensorService::SensorEventConnection::sendEvents(
 
             // Check if this connection has registered for this sensor. If not continue to the
             // next sensor_event.
-            if (mSensorInfo.count(sensor_handle) == 0) {
+            auto info = mSensorInfo.find(sensor_handle);
+            if (info == mSensorInfo.end()) {
                 ++i;
                 continue;
             }
 
-            FlushInfo& flushInfo = mSensorInfo[sensor_handle];
+            FlushInfo& flushInfo = info->second;
             // Check if there is a pending flush_complete event for this sensor on this connection.
             if (buffer[i].type == SENSOR_TYPE_META_DATA && flushInfo.mFirstFlushPending == true &&
                     mapFlushEventsToConnections[i] == this) {
@@ -336,19 +343,20 @@ status_t SensorService::SensorEventConnection::sendEvents(
             }
 
             do {
-                // Keep copying events into the scratch buffer as long as they are regular
-                // sensor_events are from the same sensor_handle OR they are flush_complete_events
-                // from the same sensor_handle AND the current connection is mapped to the
-                // corresponding flush_complete_event.
+                // Keep adding events to the ranges as long as they are regular sensor_events
+                // are from the same sensor_handle OR they are flush_complete_events from the same
+                // sensor_handle AND the current connection is mapped to the corresponding
+                // flush_complete_event.
                 if (buffer[i].type == SENSOR_TYPE_META_DATA) {
                     if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
+                        appendEventRangeLocked(buffer[i]);
+                        count++;
                     }
                 } else {
-                    // Regular sensor event, just copy it to the scratch buffer after checking
-                    // the AppOp.
-                    if (hasSensorAccess() && noteOpIfRequired(buffer[i])) {
-                        scratch[count++] = buffer[i];
+                    // Regular sensor event, just add it to the ranges after checking the AppOp.
+                    if (hasAccess && noteOpIfRequired(buffer[i])) {
+                        appendEventRangeLocked(buffer[i]);
+                        count++;
                     }
                 }
                 i++;
@@ -384,15 +392,20 @@ status_t SensorService::SensorEventConnection::sendEvents(
     if (mCacheSize != 0) {
         // There are some events in the cache which need to be sent first. Copy this buffer to
         // the end of cache.
+        if (useEventRanges) {
+            copyEventRangesLocked(scratch);
+        }
         appendEventsToCacheLocked(scratch, count);
         return status_t(NO_ERROR);
     }
 
     int index_wake_up_event = -1;
     if (hasSensorAccess()) {
-        index_wake_up_event = findWakeUpSensorEventLocked(scratch, count);
+        index_wake_up_event = useEventRanges ? findWakeUpSensorEventInRangesLocked()
+                                             : findWakeUpSensorEventLocked(scratch, count);
         if (index_wake_up_event >= 0) {
-            scratch[index_wake_up_event].flags |= WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
+            (useEventRanges ? mWakeUpEvent : scratch[index_wake_up_event]).flags |=
+                    WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
             ++mWakeLockRefCount;
 #if DEBUG_CONNECTIONS
             ++mTotalAcksNeeded;
@@ -401,13 +414,21 @@ status_t SensorService::SensorEventConnection::sendEvents(
     }
 
     // NOTE: ASensorEvent and sensors_event_t are the same type.
-    ssize_t size = SensorEventQueue::write(mChannel,
-                                    reinterpret_cast<ASensorEvent const*>(scratch), count);
+    ssize_t size;
+    if (useEventRanges && mEventRing != nullptr) {
+        size = writeToEventRingLocked();
+    } else {
+        size = useEventRanges
+                ? SensorEventQueue::write(mChannel, mEventRanges.data(), mEventRanges.size())
+                : SensorEventQueue::write(mChannel,
+                                          reinterpret_cast<ASensorEvent const*>(scratch), count);
+    }
     if (size < 0) {
         // Write error, copy events to local cache.
         if (index_wake_up_event >= 0) {
             // If there was a wake_up sensor_event, reset the flag.
-            scratch[index_wake_up_event].flags &= ~WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
+            (useEventRanges ? mWakeUpEvent : scratch[index_wake_up_event]).flags &=
+                    ~WAKE_UP_SENSOR_EVENT_NEEDS_ACK;
             if (mWakeLockRefCount > 0) {
                 --mWakeLockRefCount;
             }
@@ -421,6 +442,9 @@ status_t SensorService::SensorEventConnection::sendEvents(
             mCacheSize = 0;
         }
         // Save the events so that they can be written later
+        if (useEventRanges) {
+            copyEventRangesLocked(scratch);
+        }
         appendEventsToCacheLocked(scratch, count);
 
         // Add this file descriptor to the looper to get a callback when this fd is available for
@@ -438,6 +462,26 @@ status_t SensorService::SensorEventConnection::sendEvents(
     return size < 0 ? status_t(size) : status_t(NO_ERROR);
 }
 
+ssize_t SensorService::SensorEventConnection::writeToEventRingLocked() {
+    uint64_t endIndex;
+    if (mEventRing->write(mEventRanges.data(), mEventRanges.size(), &endIndex) != NO_ERROR) {
+        return SensorEventQueue::write(mChannel, mEventRanges.data(), mEventRanges.size());
+    }
+
+    sensors_event_t doorbell = {};
+    doorbell.version = sizeof(sensors_event_t);
+    doorbell.type = SensorEventRing::DOORBELL_EVENT_TYPE;
+    doorbell.u64.data[0] = endIndex;
+    ssize_t size = SensorEventQueue::write(mChannel,
+                                           reinterpret_cast<ASensorEvent const*>(&doorbell), 1);
+    if (size >= 0) {
+        // The events only belong to the client once it has been told about them. Otherwise they
+        // are cached by the caller and the next write overwrites them in the ring.
+        mEventRing->commit(endIndex);
+    }
+    return size;
+}
+
 bool SensorService::SensorEventConnection::hasSensorAccess() {
     return mService->isUidActive(mUid)
         && !mService->mSensorPrivacyPolicy->isSensorPrivacyEnabled();
@@ -661,6 +705,56 @@ void SensorService::SensorEventConnection::countFlushCompleteEventsLocked(
     return;
 }
 
+void SensorService::SensorEventConnection::appendEventRangeLocked(sensors_event_t const& event) {
+    if (!mEventRanges.empty()) {
+        iovec& last = mEventRanges.back();
+        if (static_cast<char*>(last.iov_base) + last.iov_len ==
+                reinterpret_cast<char const*>(&event)) {
+            last.iov_len += sizeof(sensors_event_t);
+            return;
+        }
+    }
+    mEventRanges.push_back({const_cast<sensors_event_t*>(&event), sizeof(sensors_event_t)});
+}
+
+void SensorService::SensorEventConnection::copyEventRangesLocked(sensors_event_t* scratch) const {
+    char* dst = reinterpret_cast<char*>(scratch);
+    for (const iovec& range : mEventRanges) {
+        memcpy(dst, range.iov_base, range.iov_len);
+        dst += range.iov_len;
+    }
+}
+
+int SensorService::SensorEventConnection::findWakeUpSensorEventInRangesLocked() {
+    int index = 0;
+    for (size_t r = 0; r < mEventRanges.size(); ++r) {
+        sensors_event_t* events = static_cast<sensors_event_t*>(mEventRanges[r].iov_base);
+        const size_t numEvents = mEventRanges[r].iov_len / sizeof(sensors_event_t);
+        for (size_t i = 0; i < numEvents; ++i, ++index) {
+            if (!mService->isWakeUpSensorEvent(events[i])) {
+                continue;
+            }
+            // The buffer is shared by all connections, so the event is replaced with a copy in
+            // mWakeUpEvent whose flags can be changed for this connection.
+            mWakeUpEvent = events[i];
+            iovec pieces[3];
+            size_t numPieces = 0;
+            if (i > 0) {
+                pieces[numPieces++] = {events, i * sizeof(sensors_event_t)};
+            }
+            pieces[numPieces++] = {&mWakeUpEvent, sizeof(sensors_event_t)};
+            if (i + 1 < numEvents) {
+                pieces[numPieces++] = {events + i + 1,
+                                       (numEvents - i - 1) * sizeof(sensors_event_t)};
+            }
+            mEventRanges.erase(mEventRanges.begin() + r);
+            mEventRanges.insert(mEventRanges.begin() + r, pieces, pieces + numPieces);
+            return index;
+        }
+    }
+    return -1;
+}
+
 int SensorService::SensorEventConnection::findWakeUpSensorEventLocked(
                        sensors_event_t const* scratch, const int count) {
     for (int i = 0; i < count; ++i) {
@@ -676,6 +770,21 @@ sp<BitTube> SensorService::SensorEventConnection::getSensorChannel() const
     return mChannel;
 }
 
+sp<SensorEventRing> SensorService::SensorEventConnection::getSensorEventRing()
+{
+    Mutex::Autolock _l(mConnectionLock);
+    if (mEventRing == nullptr) {
+        // Size the ring like the socket buffer, which it takes over from.
+        sp<SensorEventRing> ring =
+                new SensorEventRing(mService->mSocketBufferSize / sizeof(sensors_event_t));
+        if (ring->initCheck() != NO_ERROR) {
+            return nullptr;
+        }
+        mEventRing = ring;
+    }
+    return mEventRing;
+}
+
 status_t SensorService::SensorEventConnection::enableDisable(
         int handle, bool enabled, nsecs_t samplingPeriodNs, nsecs_t maxBatchReportLatencyNs,
         int reservedFlags)
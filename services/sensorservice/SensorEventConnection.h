@@ -20,7 +20,9 @@
 #include <atomic>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unordered_map>
+#include <vector>
 
 #include <utils/Vector.h>
 #include <utils/SortedVector.h>
@@ -34,6 +36,7 @@
 
 #include <sensor/Sensor.h>
 #include <sensor/BitTube.h>
+#include <sensor/SensorEventRing.h>
 #include <sensor/ISensorServer.h>
 #include <sensor/ISensorEventConnection.h>
 
@@ -82,6 +85,7 @@ private:
     virtual status_t setEventRate(int handle, nsecs_t samplingPeriodNs);
     virtual status_t flush();
     virtual int32_t configureChannel(int handle, int rateLevel);
+    virtual sp<SensorEventRing> getSensorEventRing();
     virtual void destroy();
 
     // Count the number of flush complete events which are about to be dropped in the buffer.
@@ -95,6 +99,23 @@ private:
     // flag set. SOCK_SEQPACKET ensures that either the entire packet is read or dropped.
     int findWakeUpSensorEventLocked(sensors_event_t const* scratch, int count);
 
+    // Same as findWakeUpSensorEventLocked for the events in mEventRanges. The wake_up sensor event
+    // is copied to mWakeUpEvent and its range is split so that the copy is written in its place,
+    // which lets its flags be changed without modifying the buffer shared by all connections.
+    int findWakeUpSensorEventInRangesLocked();
+
+    // Add an event of the buffer passed to sendEvents to mEventRanges, extending the last range
+    // when the event directly follows it.
+    void appendEventRangeLocked(sensors_event_t const& event);
+
+    // Copy the events in mEventRanges to scratch, which must hold all of them.
+    void copyEventRangesLocked(sensors_event_t* scratch) const;
+
+    // Write the events in mEventRanges to mEventRing and send a doorbell event announcing them on
+    // the socket. If the ring is full, the events are written to the socket instead, so that they
+    // are still read after the ones the client has yet to read from the ring.
+    ssize_t writeToEventRingLocked();
+
     // Send pending flush_complete events. There may have been flush_complete_events that are
     // dropped which need to be sent separately before other events. On older HALs (1_0) this method
     // emulates the behavior of flush().
@@ -147,6 +168,9 @@ private:
     void uncapRates();
     sp<SensorService> const mService;
     sp<BitTube> mChannel;
+    // Shared-memory ring the events are written to once the client has asked for it with
+    // getSensorEventRing. Protected by mConnectionLock.
+    sp<SensorEventRing> mEventRing;
     uid_t mUid;
     std::atomic_bool mIsRateCappedBasedOnPermission;
     mutable Mutex mConnectionLock;
@@ -181,6 +205,12 @@ private:
 
     sensors_event_t *mEventCache;
     int mCacheSize, mMaxCacheSize;
+
+    // The events that sendEvents accepted for this connection, as ranges of the buffer it was
+    // passed, plus mWakeUpEvent. Kept across calls so that its storage is reused. Protected by
+    // mConnectionLock.
+    std::vector<iovec> mEventRanges;
+    sensors_event_t mWakeUpEvent;
     int64_t mTimeOfLastEventDrop;
     int mEventsDropped;
     String8 mPackageName;
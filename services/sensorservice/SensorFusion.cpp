@@ -71,21 +71,57 @@ SensorFusion::SensorFusion()
     }
 }
 
+bool SensorFusion::updateGyroTime(const sensors_event_t& event, float* dT) {
+    bool valid = false;
+    if ( event.timestamp - mGyroTime> 0 &&
+         event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
+
+        *dT = (event.timestamp - mGyroTime) / 1000000000.0f;
+        // here we estimate the gyro rate (useful for debugging)
+        const float freq = 1 / *dT;
+        if (freq >= 100 && freq<1000) { // filter values obviously wrong
+            const float alpha = 1 / (1 + *dT); // 1s time-constant
+            mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
+        }
+        valid = true;
+    }
+    mGyroTime = event.timestamp;
+    return valid;
+}
+
+void SensorFusion::process(const sensors_event_t* events, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        if (events[i].type != mGyro.getType()) {
+            process(events[i++]);
+            continue;
+        }
+
+        // Consecutive gyro samples only depend on each other, so each fusion mode integrates
+        // all of them in one go.
+        vec3_t gyros[MAX_GYRO_BATCH_SIZE];
+        float dTs[MAX_GYRO_BATCH_SIZE];
+        size_t n = 0;
+        while (i < count && events[i].type == mGyro.getType() && n < MAX_GYRO_BATCH_SIZE) {
+            if (updateGyroTime(events[i], &dTs[n])) {
+                gyros[n++] = vec3_t(events[i].data);
+            }
+            i++;
+        }
+        for (int j = 0; j<NUM_FUSION_MODE; ++j) {
+            if (mEnabled[j]) {
+                // fusion in no gyro mode will ignore
+                mFusions[j].handleGyro(gyros, dTs, n);
+            }
+        }
+    }
+}
+
 void SensorFusion::process(const sensors_event_t& event) {
 
     if (event.type == mGyro.getType()) {
         float dT;
-        if ( event.timestamp - mGyroTime> 0 &&
-             event.timestamp - mGyroTime< (int64_t)(5e7) ) { //0.05sec
-
-            dT = (event.timestamp - mGyroTime) / 1000000000.0f;
-            // here we estimate the gyro rate (useful for debugging)
-            const float freq = 1 / dT;
-            if (freq >= 100 && freq<1000) { // filter values obviously wrong
-                const float alpha = 1 / (1 + dT); // 1s time-constant
-                mEstimatedGyroRate = freq + (mEstimatedGyroRate - freq)*alpha;
-            }
-
+        if (updateGyroTime(event, &dT)) {
             const vec3_t gyro(event.data);
             for (int i = 0; i<NUM_FUSION_MODE; ++i) {
                 if (mEnabled[i]) {
@@ -94,7 +130,6 @@ void SensorFusion::process(const sensors_event_t& event) {
                 }
             }
         }
-        mGyroTime = event.timestamp;
     } else if (event.type == SENSOR_TYPE_MAGNETIC_FIELD) {
         const vec3_t mag(event.data);
         for (int i = 0; i<NUM_FUSION_MODE; ++i) {
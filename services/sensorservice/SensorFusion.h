@@ -58,10 +58,19 @@ class SensorFusion : public Singleton<SensorFusion> {
     nsecs_t mGyroTime;
     nsecs_t mAccTime;
 
+    // maximum number of consecutive gyro samples handed to the fusions at once
+    enum { MAX_GYRO_BATCH_SIZE = 64 };
+
     SensorFusion();
 
+    // Updates mGyroTime and the estimated gyro rate with a gyro event. Returns true and the time
+    // since the previous gyro event in dT if the event should be fused.
+    bool updateGyroTime(const sensors_event_t& event, float* dT);
+
 public:
     void process(const sensors_event_t& event);
+    // same as calling process for each of the count events in order
+    void process(const sensors_event_t* events, size_t count);
 
     bool isEnabled() const {
         return mEnabled[FUSION_9AXIS] ||
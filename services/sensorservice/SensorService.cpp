@@ -104,6 +104,8 @@ static const String16 sManageSensorsPermission("android.permission.MANAGE_SENSOR
 SensorService::SensorService()
     : mInitCheck(NO_INIT), mSocketBufferSize(SOCKET_BUFFER_SIZE_NON_BATCHED),
       mWakeLockAcquired(false), mProximityActiveCount(0) {
+    mRecentEventSampleInterval =
+            std::max(property_get_int32("debug.sensors.recent_event_sample_interval", 1), 1);
     mUidPolicy = new UidPolicy(this);
     mSensorPrivacyPolicy = new SensorPrivacyPolicy(this);
 }
@@ -347,7 +349,8 @@ const Sensor& SensorService::registerSensor(SensorInterface* s, bool isDebug, bo
     int handle = s->getSensor().getHandle();
     int type = s->getSensor().getType();
     if (mSensors.add(handle, s, isDebug, isVirtual)){
-        mRecentEvent.emplace(handle, new SensorServiceUtil::RecentEventLogger(type));
+        mRecentEvent.emplace(handle, new SensorServiceUtil::RecentEventLogger(type,
+                mRecentEventSampleInterval));
         return s->getSensor();
     } else {
         return mSensors.getNonSensor();
@@ -955,9 +958,7 @@ bool SensorService::threadLoop() {
                 size_t k = 0;
                 SensorFusion& fusion(SensorFusion::getInstance());
                 if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
-                    }
+                    fusion.process(event, size_t(count));
                 }
                 for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
                     for (int handle : mActiveVirtualSensors) {
@@ -1959,7 +1960,7 @@ bool SensorService::canAccessSensor(const Sensor& sensor, const char* operation,
     } else if (hasPermissionForSensor(sensor)) {
         // Ensure that the AppOp is allowed, or that there is no necessary app op for the sensor
         if (opCode >= 0) {
-            const int32_t appOpMode = sAppOpsManager.checkOp(opCode,
+            const int32_t appOpMode = sAppOpsManager.checkOpCached(opCode,
                     IPCThreadState::self()->getCallingUid(), opPackageName);
             canAccess = (appOpMode == AppOpsManager::MODE_ALLOWED);
         } else {
@@ -472,6 +472,9 @@ private:
     // modification to add support for them in ConnectionSafeAutolock
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
     std::unordered_map<int, SensorServiceUtil::RecentEventLogger*> mRecentEvent;
+    // Only one in mRecentEventSampleInterval events is kept for dumpsys by the loggers in
+    // mRecentEvent. Set with the debug.sensors.recent_event_sample_interval property.
+    size_t mRecentEventSampleInterval;
     Mode mCurrentOperatingMode;
 
     // This packagaName is set when SensorService is in RESTRICTED or DATA_INJECTION mode. Only
@@ -457,6 +457,8 @@ void BufferLayer::gatherBufferInfo() {
     mBufferInfo.mPixelFormat =
             !mBufferInfo.mBuffer ? PIXEL_FORMAT_NONE : mBufferInfo.mBuffer->getBuffer()->format;
     mBufferInfo.mFrameLatencyNeeded = true;
+    // The source bounds depend on the buffer.
+    invalidateBounds();
 }
 
 bool BufferLayer::shouldPresentNow(nsecs_t expectedPresentTime) const {
@@ -833,6 +835,9 @@ void BufferLayer::updateCloneBufferInfo() {
     mDrawingState.zOrderRelativeOf = tmpZOrderRelativeOf;
     mDrawingState.zOrderRelatives = tmpZOrderRelatives;
     mDrawingState.inputInfo = tmpInputInfo;
+    invalidateBounds();
+    // The copied state can move the clone in Z.
+    invalidateTraversalLists();
 }
 
 void BufferLayer::setTransformHint(ui::Transform::RotationFlags displayTransformHint) {
@@ -663,6 +663,8 @@ bool BufferStateLayer::onPreComposition(nsecs_t refreshStartTime) {
     for (const auto& handle : mDrawingState.callbackHandles) {
         handle->refreshStartTime = refreshStartTime;
     }
+    // The composition state keeps them for the outputs composed this frame.
+    editCompositionState()->bufferSlotsToClear = mHwcSlotGenerator->takeSlotsToClear();
     return BufferLayer::onPreComposition(refreshStartTime);
 }
 
@@ -825,11 +827,18 @@ uint32_t BufferStateLayer::HwcSlotGenerator::getHwcCacheSlot(const client_cache_
     if (itr == mCachedBuffers.end()) {
         return addCachedBuffer(clientCacheId);
     }
-    auto& [hwcCacheSlot, counter] = itr->second;
-    counter = mCounter++;
+    auto& [hwcCacheSlot, lruPosition] = itr->second;
+    mLruBuffers.splice(mLruBuffers.end(), mLruBuffers, lruPosition);
     return hwcCacheSlot;
 }
 
+std::vector<uint32_t> BufferStateLayer::HwcSlotGenerator::takeSlotsToClear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<uint32_t> slots;
+    slots.swap(mSlotsToClear);
+    return slots;
+}
+
 uint32_t BufferStateLayer::HwcSlotGenerator::addCachedBuffer(const client_cache_t& clientCacheId)
         REQUIRES(mMutex) {
     if (!clientCacheId.isValid()) {
@@ -840,7 +849,8 @@ uint32_t BufferStateLayer::HwcSlotGenerator::addCachedBuffer(const client_cache_
     ClientCache::getInstance().registerErasedRecipient(clientCacheId, wp<ErasedRecipient>(this));
 
     uint32_t hwcCacheSlot = getFreeHwcCacheSlot();
-    mCachedBuffers[clientCacheId] = {hwcCacheSlot, mCounter++};
+    mCachedBuffers[clientCacheId] = {hwcCacheSlot,
+                                     mLruBuffers.insert(mLruBuffers.end(), clientCacheId)};
     return hwcCacheSlot;
 }
 
@@ -855,18 +865,11 @@ uint32_t BufferStateLayer::HwcSlotGenerator::getFreeHwcCacheSlot() REQUIRES(mMut
 }
 
 void BufferStateLayer::HwcSlotGenerator::evictLeastRecentlyUsed() REQUIRES(mMutex) {
-    uint64_t minCounter = UINT_MAX;
-    client_cache_t minClientCacheId = {};
-    for (const auto& [clientCacheId, slotCounter] : mCachedBuffers) {
-        const auto& [hwcCacheSlot, counter] = slotCounter;
-        if (counter < minCounter) {
-            minCounter = counter;
-            minClientCacheId = clientCacheId;
-        }
-    }
-    eraseBufferLocked(minClientCacheId);
+    // Copied, as erasing the buffer removes it from the list.
+    const client_cache_t lruClientCacheId = mLruBuffers.front();
+    eraseBufferLocked(lruClientCacheId);
 
-    ClientCache::getInstance().unregisterErasedRecipient(minClientCacheId, this);
+    ClientCache::getInstance().unregisterErasedRecipient(lruClientCacheId, this);
 }
 
 void BufferStateLayer::HwcSlotGenerator::eraseBufferLocked(const client_cache_t& clientCacheId)
@@ -875,12 +878,12 @@ void BufferStateLayer::HwcSlotGenerator::eraseBufferLocked(const client_cache_t&
     if (itr == mCachedBuffers.end()) {
         return;
     }
-    auto& [hwcCacheSlot, counter] = itr->second;
-
-    // TODO send to hwc cache and resources
+    auto& [hwcCacheSlot, lruPosition] = itr->second;
 
     mFreeHwcCacheSlots.push(hwcCacheSlot);
-    mCachedBuffers.erase(clientCacheId);
+    mSlotsToClear.push_back(hwcCacheSlot);
+    mLruBuffers.erase(lruPosition);
+    mCachedBuffers.erase(itr);
 }
 
 void BufferStateLayer::gatherBufferInfo() {
@@ -24,6 +24,7 @@
 #include <system/window.h>
 #include <utils/String8.h>
 
+#include <list>
 #include <stack>
 
 namespace android {
@@ -186,6 +187,9 @@ private:
 
         uint32_t getHwcCacheSlot(const client_cache_t& clientCacheId);
 
+        // Returns the slots freed since the last call, whose buffers the HAL can release.
+        std::vector<uint32_t> takeSlotsToClear();
+
     private:
         friend class SlotGenerationTest;
         uint32_t addCachedBuffer(const client_cache_t& clientCacheId) REQUIRES(mMutex);
@@ -201,15 +205,15 @@ private:
 
         std::mutex mMutex;
 
+        // The buffers from the least to the most recently used.
+        std::list<client_cache_t> mLruBuffers GUARDED_BY(mMutex);
         std::unordered_map<client_cache_t,
-                           std::pair<uint32_t /*HwcCacheSlot*/, uint32_t /*counter*/>,
+                           std::pair<uint32_t /*HwcCacheSlot*/,
+                                     std::list<client_cache_t>::iterator /*lruPosition*/>,
                            CachedBufferHash>
                 mCachedBuffers GUARDED_BY(mMutex);
         std::stack<uint32_t /*HwcCacheSlot*/> mFreeHwcCacheSlots GUARDED_BY(mMutex);
-
-        // The cache increments this counter value when a slot is updated or used.
-        // Used to track the least recently-used buffer
-        uint64_t mCounter = 0;
+        std::vector<uint32_t /*HwcCacheSlot*/> mSlotsToClear GUARDED_BY(mMutex);
     };
 
     sp<HwcSlotGenerator> mHwcSlotGenerator;
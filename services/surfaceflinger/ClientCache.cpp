@@ -21,6 +21,8 @@
 
 #include <cinttypes>
 
+#include <gui/ITransactionCompletedListener.h>
+
 #include "ClientCache.h"
 
 namespace android {
@@ -38,13 +40,13 @@ bool ClientCache::getBuffer(const client_cache_t& cacheId,
         ALOGE("failed to get buffer, invalid (nullptr) process token");
         return false;
     }
-    auto it = mBuffers.find(processToken);
-    if (it == mBuffers.end()) {
+    auto it = mProcesses.find(processToken.unsafe_get());
+    if (it == mProcesses.end()) {
         ALOGE("failed to get buffer, invalid process token");
         return false;
     }
 
-    auto& processBuffers = it->second.second;
+    auto& processBuffers = it->second.buffers;
 
     auto bufItr = processBuffers.find(id);
     if (bufItr == processBuffers.end()) {
@@ -57,58 +59,109 @@ bool ClientCache::getBuffer(const client_cache_t& cacheId,
     return true;
 }
 
-bool ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer) {
+std::shared_ptr<renderengine::ExternalTexture> ClientCache::add(const client_cache_t& cacheId,
+                                                                const sp<GraphicBuffer>& buffer) {
     auto& [processToken, id] = cacheId;
     if (processToken == nullptr) {
         ALOGE("failed to cache buffer: invalid process token");
-        return false;
+        return nullptr;
     }
 
     if (!buffer) {
         ALOGE("failed to cache buffer: invalid buffer");
-        return false;
+        return nullptr;
     }
 
-    std::lock_guard lock(mMutex);
+    std::shared_ptr<renderengine::ExternalTexture> texture;
+    std::vector<std::pair<sp<ErasedRecipient>, client_cache_t>> pendingErase;
+    std::vector<uint64_t> evictedIds;
     sp<IBinder> token;
+    {
+        std::lock_guard lock(mMutex);
 
-    // If this is a new process token, set a death recipient. If the client process dies, we will
-    // get a callback through binderDied.
-    auto it = mBuffers.find(processToken);
-    if (it == mBuffers.end()) {
-        token = processToken.promote();
-        if (!token) {
-            ALOGE("failed to cache buffer: invalid token");
-            return false;
-        }
+        // If this is a new process token, set a death recipient. If the client process dies, we
+        // will get a callback through binderDied.
+        auto it = mProcesses.find(processToken.unsafe_get());
+        if (it == mProcesses.end()) {
+            token = processToken.promote();
+            if (!token) {
+                ALOGE("failed to cache buffer: invalid token");
+                return nullptr;
+            }
 
-        status_t err = token->linkToDeath(mDeathRecipient);
-        if (err != NO_ERROR) {
-            ALOGE("failed to cache buffer: could not link to death");
-            return false;
+            status_t err = token->linkToDeath(mDeathRecipient);
+            if (err != NO_ERROR) {
+                ALOGE("failed to cache buffer: could not link to death");
+                return nullptr;
+            }
+            auto [itr, success] = mProcesses.try_emplace(token.get());
+            LOG_ALWAYS_FATAL_IF(!success, "failed to insert new process into client cache");
+            itr->second.token = token;
+            it = itr;
         }
-        auto [itr, success] =
-                mBuffers.emplace(processToken,
-                                 std::make_pair(token,
-                                                std::unordered_map<uint64_t, ClientCacheBuffer>()));
-        LOG_ALWAYS_FATAL_IF(!success, "failed to insert new process into client cache");
-        it = itr;
+
+        auto& process = it->second;
+        token = process.token;
+
+        LOG_ALWAYS_FATAL_IF(mRenderEngine == nullptr,
+                            "Attempted to build the ClientCache before a RenderEngine instance "
+                            "was ready!");
+        texture = std::make_shared<
+                renderengine::ExternalTexture>(buffer, *mRenderEngine,
+                                               renderengine::ExternalTexture::Usage::READABLE);
+
+        ClientCacheBuffer& buf = process.buffers[id];
+        process.bytes -= buf.size;
+        buf.buffer = texture;
+        buf.size = clientCacheBufferSize(buffer);
+        buf.lastUsed = mUseCounter++;
+        process.bytes += buf.size;
+        mMisses++;
+
+        evictLocked(processToken, process, id, &pendingErase, &evictedIds);
     }
 
-    auto& processBuffers = it->second.second;
+    for (auto& [recipient, erasedId] : pendingErase) {
+        recipient->bufferErased(erasedId);
+    }
 
-    if (processBuffers.size() > BUFFER_CACHE_MAX_SIZE) {
-        ALOGE("failed to cache buffer: cache is full");
-        return false;
+    if (!evictedIds.empty()) {
+        sp<ITransactionCompletedListener> listener =
+                interface_cast<ITransactionCompletedListener>(token);
+        for (uint64_t evictedId : evictedIds) {
+            listener->onBufferEvicted(evictedId);
+        }
     }
+    return texture;
+}
 
-    LOG_ALWAYS_FATAL_IF(mRenderEngine == nullptr,
-                        "Attempted to build the ClientCache before a RenderEngine instance was "
-                        "ready!");
-    processBuffers[id].buffer = std::make_shared<
-            renderengine::ExternalTexture>(buffer, *mRenderEngine,
-                                           renderengine::ExternalTexture::Usage::READABLE);
-    return true;
+void ClientCache::evictLocked(
+        const wp<IBinder>& processToken, ProcessBuffers& process, uint64_t keepId,
+        std::vector<std::pair<sp<ErasedRecipient>, client_cache_t>>* pendingErase,
+        std::vector<uint64_t>* evictedIds) {
+    while (process.buffers.size() > 1 &&
+           (process.buffers.size() > kMaxBuffersPerProcess ||
+            process.bytes > kMaxBytesPerProcess)) {
+        auto lru = process.buffers.end();
+        for (auto itr = process.buffers.begin(); itr != process.buffers.end(); itr++) {
+            if (itr->first != keepId &&
+                (lru == process.buffers.end() || itr->second.lastUsed < lru->second.lastUsed)) {
+                lru = itr;
+            }
+        }
+
+        client_cache_t cacheId = {processToken, lru->first};
+        for (auto& recipient : lru->second.recipients) {
+            sp<ErasedRecipient> erasedRecipient = recipient.promote();
+            if (erasedRecipient) {
+                pendingErase->emplace_back(erasedRecipient, cacheId);
+            }
+        }
+        evictedIds->push_back(lru->first);
+        process.bytes -= lru->second.size;
+        process.buffers.erase(lru);
+        mEvictions++;
+    }
 }
 
 void ClientCache::erase(const client_cache_t& cacheId) {
@@ -129,7 +182,9 @@ void ClientCache::erase(const client_cache_t& cacheId) {
             }
         }
 
-        mBuffers[processToken].second.erase(id);
+        auto& process = mProcesses.at(processToken.unsafe_get());
+        process.bytes -= buf->size;
+        process.buffers.erase(id);
     }
 
     for (auto& recipient : pendingErase) {
@@ -138,14 +193,17 @@ void ClientCache::erase(const client_cache_t& cacheId) {
 }
 
 std::shared_ptr<renderengine::ExternalTexture> ClientCache::get(const client_cache_t& cacheId) {
-    std::lock_guard lock(mMutex);
+    std::shared_lock lock(mMutex);
 
     ClientCacheBuffer* buf = nullptr;
     if (!getBuffer(cacheId, &buf)) {
         ALOGE("failed to get buffer, could not retrieve buffer");
+        mLostLookups++;
         return nullptr;
     }
 
+    buf->lastUsed.store(mUseCounter++, std::memory_order_relaxed);
+    mHits++;
     return buf->buffer;
 }
 
@@ -183,13 +241,13 @@ void ClientCache::removeProcess(const wp<IBinder>& processToken) {
             return;
         }
         std::lock_guard lock(mMutex);
-        auto itr = mBuffers.find(processToken);
-        if (itr == mBuffers.end()) {
+        auto itr = mProcesses.find(processToken.unsafe_get());
+        if (itr == mProcesses.end()) {
             ALOGE("failed to remove process, could not find process");
             return;
         }
 
-        for (auto& [id, clientCacheBuffer] : itr->second.second) {
+        for (auto& [id, clientCacheBuffer] : itr->second.buffers) {
             client_cache_t cacheId = {processToken, id};
             for (auto& recipient : clientCacheBuffer.recipients) {
                 sp<ErasedRecipient> erasedRecipient = recipient.promote();
@@ -198,7 +256,7 @@ void ClientCache::removeProcess(const wp<IBinder>& processToken) {
                 }
             }
         }
-        mBuffers.erase(itr);
+        mProcesses.erase(itr);
     }
 
     for (auto& [recipient, cacheId] : pendingErase) {
@@ -212,11 +270,14 @@ void ClientCache::CacheDeathRecipient::binderDied(const wp<IBinder>& who) {
 
 void ClientCache::dump(std::string& result) {
     std::lock_guard lock(mMutex);
-    for (auto i : mBuffers) {
-        const sp<IBinder>& cacheOwner = i.second.first;
-        StringAppendF(&result," Cache owner: %p\n", cacheOwner.get());
-        auto &buffers = i.second.second;
-        for (auto& [id, clientCacheBuffer] : buffers) {
+    StringAppendF(&result,
+                  " Hits: %" PRIu64 ", misses: %" PRIu64 ", lost lookups: %" PRIu64
+                  ", evictions: %" PRIu64 "\n",
+                  mHits.load(), mMisses.load(), mLostLookups.load(), mEvictions.load());
+    for (auto& [cacheOwner, process] : mProcesses) {
+        StringAppendF(&result, " Cache owner: %p, %zu buffers, %zu KiB\n", cacheOwner,
+                      process.buffers.size(), process.bytes / 1024);
+        for (auto& [id, clientCacheBuffer] : process.buffers) {
             StringAppendF(&result, "\t ID: %d, Width/Height: %d,%d\n", (int)id,
                           (int)clientCacheBuffer.buffer->getBuffer()->getWidth(),
                           (int)clientCacheBuffer.buffer->getBuffer()->getHeight());
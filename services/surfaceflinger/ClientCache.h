@@ -24,20 +24,31 @@
 #include <utils/RefBase.h>
 #include <utils/Singleton.h>
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
 
-#define BUFFER_CACHE_MAX_SIZE 64
-
 namespace android {
 
 class ClientCache : public Singleton<ClientCache> {
 public:
+    // Limits on the buffers cached for each process, with the sizes counted by
+    // clientCacheBufferSize. The cache in SurfaceComposerClient evicts its least recently used
+    // buffers before reaching its own, lower, limits, so these only apply to clients that don't
+    // keep to them. The buffers evicted here are reported to the client, which then sends them
+    // again.
+    static constexpr size_t kMaxBuffersPerProcess = 320;
+    static constexpr size_t kMaxBytesPerProcess = 320 * 1024 * 1024;
+
     ClientCache();
 
-    bool add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer);
+    // Caches the buffer, evicting the least recently used buffers of the process if it goes over
+    // its limits, and returns it ready to be used, or nullptr on failure.
+    std::shared_ptr<renderengine::ExternalTexture> add(const client_cache_t& cacheId,
+                                                       const sp<GraphicBuffer>& buffer);
     void erase(const client_cache_t& cacheId);
 
     std::shared_ptr<renderengine::ExternalTexture> get(const client_cache_t& cacheId);
@@ -61,16 +72,31 @@ public:
     void dump(std::string& result);
 
 private:
-    std::mutex mMutex;
+    // get() only takes a shared lock, so that the lookups of concurrent transactions don't
+    // serialize. The state below is guarded by mMutex, and lastUsed and the counters can also be
+    // updated under a shared lock. GUARDED_BY isn't used as std::shared_lock isn't annotated.
+    std::shared_mutex mMutex;
 
     struct ClientCacheBuffer {
         std::shared_ptr<renderengine::ExternalTexture> buffer;
         std::set<wp<ErasedRecipient>> recipients;
+        size_t size = 0;
+        // Value of mUseCounter when the buffer was last added or looked up, for LRU eviction.
+        std::atomic<uint64_t> lastUsed{0};
+    };
+    struct ProcessBuffers {
+        sp<IBinder> token; // strong ref to caching process
+        std::unordered_map<uint64_t /*cache id*/, ClientCacheBuffer> buffers;
+        size_t bytes = 0;
     };
-    std::map<wp<IBinder> /*caching process*/,
-             std::pair<sp<IBinder> /*strong ref to caching process*/,
-                       std::unordered_map<uint64_t /*cache id*/, ClientCacheBuffer>>>
-            mBuffers GUARDED_BY(mMutex);
+    // Processes are keyed by their token, which stays alive while they are in the map.
+    std::unordered_map<IBinder* /*caching process*/, ProcessBuffers> mProcesses;
+
+    std::atomic<uint64_t> mUseCounter = 0;
+    std::atomic<uint64_t> mHits = 0;
+    std::atomic<uint64_t> mMisses = 0;
+    std::atomic<uint64_t> mLostLookups = 0;
+    std::atomic<uint64_t> mEvictions = 0;
 
     class CacheDeathRecipient : public IBinder::DeathRecipient {
     public:
@@ -80,8 +106,14 @@ private:
     sp<CacheDeathRecipient> mDeathRecipient;
     renderengine::RenderEngine* mRenderEngine = nullptr;
 
-    bool getBuffer(const client_cache_t& cacheId, ClientCacheBuffer** outClientCacheBuffer)
-            REQUIRES(mMutex);
+    bool getBuffer(const client_cache_t& cacheId, ClientCacheBuffer** outClientCacheBuffer);
+
+    // Evicts the least recently used buffers of the process, other than keepId, until it is
+    // within its limits. Their recipients and the evicted buffers are appended to the vectors,
+    // to be notified once the lock is released.
+    void evictLocked(const wp<IBinder>& processToken, ProcessBuffers& process, uint64_t keepId,
+                     std::vector<std::pair<sp<ErasedRecipient>, client_cache_t>>* pendingErase,
+                     std::vector<uint64_t>* evictedIds);
 };
 
 }; // namespace android
@@ -17,12 +17,14 @@
 #pragma once
 
 #include <chrono>
+#include <mutex>
 #include <optional>
 #include <vector>
 
 #include <compositionengine/Display.h>
 #include <compositionengine/LayerFE.h>
 #include <compositionengine/OutputColorSetting.h>
+#include <compositionengine/WorkerPool.h>
 #include <math/mat4.h>
 #include <ui/FenceTime.h>
 #include <ui/Transform.h>
@@ -90,6 +92,26 @@ struct CompositionRefreshArgs {
 
     // The predicted next invalidation time
     std::optional<std::chrono::steady_clock::time_point> nextInvalidateTime;
+
+    // If set, the outputs determine which layers are visible on them in parallel
+    // on these threads
+    WorkerPool* workerPool{nullptr};
+
+    // If true, and workerPool is set, the outputs are also presented in
+    // parallel. Only valid if RenderEngine can be called from any thread.
+    bool presentOutputsInParallel{false};
+
+    // If true, and workerPool is set, an output whose planner confidently predicts client
+    // composition starts drawing it on those threads while the HWC validates the frame. Only
+    // valid if RenderEngine can be called from any thread.
+    bool predictClientComposition{false};
+
+    // Set by CompositionEngine while the outputs are presented in parallel.
+    // An output holds hwcMutex while it uses the HWC, and renderMutex while it
+    // renders with RenderEngine, so the HWC work of one output overlaps the
+    // client composition of another.
+    std::mutex* hwcMutex{nullptr};
+    std::mutex* renderMutex{nullptr};
 };
 
 } // namespace android::compositionengine
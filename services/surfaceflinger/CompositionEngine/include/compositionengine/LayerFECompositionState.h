@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include <gui/HdrMetadata.h>
 #include <math/mat4.h>
@@ -162,6 +163,8 @@ struct LayerFECompositionState {
     // The buffer and related state
     sp<GraphicBuffer> buffer;
     int bufferSlot{BufferQueue::INVALID_BUFFER_SLOT};
+    // The slots whose buffers were freed by the producer, and can be released by the HAL
+    std::vector<uint32_t> bufferSlotsToClear;
     sp<Fence> acquireFence;
     Region surfaceDamage;
 
@@ -166,6 +166,10 @@ public:
     // Enables (or disables) layer caching on this output
     virtual void setLayerCachingEnabled(bool) = 0;
 
+    // Enables (or disables) drawing only the damage of the frame with client composition, when
+    // the render surface buffer holds a recent frame
+    virtual void setPartialClientCompositionEnabled(bool) = 0;
+
     // Sets the projection state to use
     virtual void setProjection(ui::Rotation orientation, const Rect& layerStackSpaceRect,
                                const Rect& orientedDisplaySpaceRect) = 0;
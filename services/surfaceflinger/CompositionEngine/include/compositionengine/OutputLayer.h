@@ -99,6 +99,13 @@ public:
     virtual void writeStateToHWC(bool includeGeometry, bool skipLayer, uint32_t z,
                                  bool zIsOverridden, bool isPeekingThrough) = 0;
 
+    // Writes only the buffer state, i.e. the buffer, its damage and its metadata, to the HWC
+    // when the rest of the state written by the last call to writeStateToHWC is known to be
+    // unchanged. Returns false without writing anything if the HWC layer needs more than that,
+    // e.g. because the HWC changed its composition type, in which case writeStateToHWC has to
+    // be called instead.
+    virtual bool writeBufferStateOnlyToHWC() = 0;
+
     // Updates the cursor position with the HWC
     virtual void writeCursorPositionToHWC() const = 0;
 
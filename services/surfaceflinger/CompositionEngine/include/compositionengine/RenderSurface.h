@@ -84,10 +84,21 @@ public:
     virtual std::shared_ptr<renderengine::ExternalTexture> dequeueBuffer(
             base::unique_fd* bufferFence) = 0;
 
+    // Returns the age of the buffer last dequeued, i.e. how many frames ago its contents were
+    // queued, or 0 if they are unknown.
+    virtual int32_t getBufferAge() const = 0;
+
     // Queues the drawn buffer for consumption by HWC. readyFence is the fence
     // which will fire when the buffer is ready for consumption.
     virtual void queueBuffer(base::unique_fd readyFence) = 0;
 
+    // Returns true if a buffer can be dequeued for a frame before prepareFrame is called for it.
+    virtual bool canDequeueBeforePrepareFrame() const = 0;
+
+    // Returns the buffer last dequeued to the queue without consuming it, e.g. when it turns out
+    // not to be needed for the frame. fence fires when the buffer is no longer written to.
+    virtual void cancelBuffer(base::unique_fd fence) = 0;
+
     // Called after the HWC calls are made to present the display
     virtual void onPresentDisplayCompleted() = 0;
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::compositionengine {
+
+/**
+ * A few threads to spread independent parts of the work for a frame across,
+ * e.g. one part per output. The calling thread does its share of the work, so
+ * a pool of N threads runs up to N + 1 parts at once.
+ *
+ * The threads are created by the constructor and inherit its caller's
+ * scheduling policy.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t getThreadCount() const { return mThreads.size(); }
+
+    // Calls task(i) once for each i in [0, count), and returns once all of
+    // those calls have. The calls run in no particular order, so they must not
+    // depend on each other, and anything they produce should be stored by i
+    // for the caller to combine in order.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void threadMain();
+    void runTasks(const std::function<void(size_t)>& task, size_t count);
+
+    std::vector<std::thread> mThreads;
+
+    // Held for the whole of parallelFor, so only one runs at a time
+    std::mutex mParallelForMutex;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkersIdle;
+    bool mStopping = false;
+    uint64_t mJobSequence = 0;
+    // The current job, null once parallelFor has returned for it
+    const std::function<void(size_t)>* mTask = nullptr;
+    size_t mCount = 0;
+    size_t mBusyWorkers = 0;
+
+    std::atomic<size_t> mNextIndex = 0;
+};
+
+} // namespace android::compositionengine
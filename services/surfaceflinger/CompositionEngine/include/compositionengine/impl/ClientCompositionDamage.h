@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <compositionengine/LayerFE.h>
+#include <renderengine/DisplaySettings.h>
+#include <ui/Region.h>
+#include <utils/RefBase.h>
+
+namespace android::compositionengine::impl {
+
+// Tracks the damage of the frames composed by the client, so that a buffer dequeued from the
+// render surface can be brought up to date by only drawing what changed since it was last drawn,
+// which the buffer age tells.
+//
+// The damage reported by the front end only covers the layers it changed, so it is only used while
+// the display settings and the layers composed by the client stay the same. A layer switching to
+// client composition, or to a cached set, changes the client target outside of that damage, and a
+// frame that does so is drawn in full.
+class ClientCompositionDamage {
+public:
+    // A layer as it takes part in client composition.
+    struct Layer {
+        wp<LayerFE> layerFE;
+        bool clientComposition = false;
+        bool clearClientTarget = false;
+        // The ID of the cached set buffer drawn in place of the layer, if any.
+        uint64_t overrideBufferId = 0;
+
+        bool operator==(const Layer& other) const {
+            return layerFE == other.layerFE && clientComposition == other.clientComposition &&
+                    clearClientTarget == other.clearClientTarget &&
+                    overrideBufferId == other.overrideBufferId;
+        }
+    };
+
+    // Records a frame with the given damage in layer stack space, and returns the region of a
+    // buffer of bufferAge that has to be drawn for it, or an empty region if the whole viewport
+    // has to be drawn, e.g. because the buffer doesn't hold one of the last frames recorded.
+    Region onFrame(const renderengine::DisplaySettings& display, std::vector<Layer> layers,
+                   const Region& damage, int32_t bufferAge);
+
+    // Forgets the frames recorded, e.g. when the render surface buffers hold a frame that wasn't
+    // composed by the client, so that the next one is drawn in full.
+    void invalidate();
+
+    void dump(std::string& result) const;
+
+private:
+    // Buffer queues rarely hold more buffers than this.
+    static constexpr size_t kMaxBufferAge = 4;
+
+    bool mHasLastFrame = false;
+    renderengine::DisplaySettings mLastDisplay;
+    std::vector<Layer> mLastLayers;
+    // The damage of the last frames, newest first.
+    std::deque<Region> mHistory;
+
+    size_t mFrames = 0;
+    size_t mPartialFrames = 0;
+    uint64_t mPixelsDrawn = 0;
+    uint64_t mViewportPixels = 0;
+};
+
+} // namespace android::compositionengine::impl
@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <deque>
+#include <optional>
+#include <string>
 
 #include <compositionengine/LayerFE.h>
 #include <renderengine/DisplaySettings.h>
@@ -37,29 +39,68 @@ namespace compositionengine::impl {
 // the composition request. We need to make sure the request, including the order of the
 // layers, do not change from call to call. The snapshot removes strong references to the
 // client buffer id so we don't extend the lifetime of the buffer by storing it in the cache.
+//
+// The geometry boundaries and the alpha of the layers are compared after quantizing them to a
+// fraction of a pixel and of an output code value, so that float noise in the front end, e.g.
+// at the end of an animation, doesn't defeat the cache while the same pixels would be drawn.
+// Each request also keeps a hash of its quantized layers, which rules out most changed requests
+// without comparing all of their settings.
 class ClientCompositionRequestCache {
 public:
+    // Why a request wasn't found in the cache.
+    enum class MissReason {
+        NotCached,
+        DisplayChanged,
+        LayerCountChanged,
+        LayersChanged,
+    };
+
     explicit ClientCompositionRequestCache(uint32_t cacheSize) : mMaxCacheSize(cacheSize){};
     ~ClientCompositionRequestCache() = default;
+    // Returns whether the request was rendered into the buffer, counting the lookup as a hit or
+    // a miss.
     bool exists(uint64_t bufferId, const renderengine::DisplaySettings& display,
-                const std::vector<LayerFE::LayerSettings>& layerSettings) const;
+                const std::vector<LayerFE::LayerSettings>& layerSettings);
     void add(uint64_t bufferId, const renderengine::DisplaySettings& display,
              const std::vector<LayerFE::LayerSettings>& layerSettings);
     void remove(uint64_t bufferId);
 
+    size_t getHitCount() const { return mHits; }
+    size_t getMissCount(MissReason reason) const;
+
+    void dump(std::string& result) const;
+
 private:
+    // Geometry is compared to 1/256th of a pixel, finer than GPUs rasterize edges.
+    static constexpr float kGeometryStepsPerPixel = 256.f;
+    // Alpha is compared to 1/1024th, finer than a 10-bit output can show.
+    static constexpr float kAlphaSteps = 1024.f;
+
+    static float quantizeGeometry(float value);
+    static float quantizeAlpha(float value);
+    static bool quantizedEqual(const LayerFE::LayerSettings& lhs,
+                               const LayerFE::LayerSettings& rhs);
+    static size_t hashLayers(const std::vector<LayerFE::LayerSettings>& layerSettings);
+
     uint32_t mMaxCacheSize;
     struct ClientCompositionRequest {
         renderengine::DisplaySettings display;
         std::vector<LayerFE::LayerSettings> layerSettings;
+        size_t layersHash;
         ClientCompositionRequest(const renderengine::DisplaySettings& _display,
                                  const std::vector<LayerFE::LayerSettings>& _layerSettings);
-        bool equals(const renderengine::DisplaySettings& _display,
-                    const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
+        // Returns std::nullopt if the requests are equal, or else why they aren't.
+        std::optional<MissReason> compare(
+                const renderengine::DisplaySettings& _display,
+                const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
     };
 
     // Cache of requests, keyed by corresponding GraphicBuffer ID.
     std::deque<std::pair<uint64_t /* bufferId */, ClientCompositionRequest>> mCache;
+
+    size_t mHits = 0;
+    size_t mMisses[static_cast<size_t>(MissReason::LayersChanged) + 1] = {};
+    size_t mEvictions = 0;
 };
 
 } // namespace compositionengine::impl
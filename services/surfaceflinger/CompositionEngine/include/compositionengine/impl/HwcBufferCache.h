@@ -57,6 +57,10 @@ public:
     void getHwcBuffer(int slot, const sp<GraphicBuffer>& buffer, uint32_t* outSlot,
                       sp<GraphicBuffer>* outBuffer);
 
+    // Forgets the buffers cached in the given slots, other than activeSlot, and returns the slots
+    // that held one, for the HAL to release them as well.
+    std::vector<uint32_t> clearSlots(const std::vector<uint32_t>& slots, uint32_t activeSlot);
+
     // Special caching slot for the layer caching feature.
     static const constexpr size_t FLATTENER_CACHING_SLOT = BufferQueue::NUM_BUFFER_SLOTS;
 
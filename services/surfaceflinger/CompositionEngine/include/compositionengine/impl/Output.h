@@ -18,6 +18,7 @@
 
 #include <compositionengine/CompositionEngine.h>
 #include <compositionengine/Output.h>
+#include <compositionengine/impl/ClientCompositionDamage.h>
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
 #include <compositionengine/impl/OutputCompositionState.h>
 #include <compositionengine/impl/planner/Planner.h>
@@ -41,6 +42,7 @@ public:
     std::optional<DisplayId> getDisplayId() const override;
     void setCompositionEnabled(bool) override;
     void setLayerCachingEnabled(bool) override;
+    void setPartialClientCompositionEnabled(bool) override;
     void setProjection(ui::Rotation orientation, const Rect& layerStackSpaceRect,
                        const Rect& orientedDisplaySpaceRect) override;
     void setDisplaySize(const ui::Size&) override;
@@ -125,7 +127,25 @@ protected:
     virtual void dumpState(std::string& out) const = 0;
 
 private:
+    // The client composition of a frame drawn with the composition types the planner predicted,
+    // while the HWC validates the frame.
+    struct PredictedClientComposition {
+        std::shared_ptr<renderengine::ExternalTexture> buffer;
+        base::unique_fd bufferFence;
+        bool useFramebufferCache = false;
+        renderengine::DisplaySettings display;
+        std::vector<LayerFE::LayerSettings> layers;
+        status_t status = NO_ERROR;
+        base::unique_fd readyFence;
+    };
+
     void dirtyEntireOutput();
+    bool isGeometryUnchanged(const compositionengine::CompositionRefreshArgs&);
+    renderengine::DisplaySettings generateClientCompositionDisplaySettings() const;
+    bool predictClientComposition(const compositionengine::CompositionRefreshArgs&);
+    void drawPredictedClientComposition();
+    void discardPredictedClientComposition(PredictedClientComposition&);
+    std::vector<ClientCompositionDamage::Layer> getClientCompositionDamageLayers() const;
     compositionengine::OutputLayer* findLayerRequestingBackgroundComposition() const;
     ui::Dataspace getBestDataspace(ui::Dataspace*, bool*) const;
     compositionengine::Output::ColorProfile pickColorProfile(
@@ -139,7 +159,18 @@ private:
     ReleasedLayers mReleasedLayers;
     OutputLayer* mLayerRequestingBackgroundBlur = nullptr;
     std::unique_ptr<ClientCompositionRequestCache> mClientCompositionRequestCache;
+    std::unique_ptr<ClientCompositionDamage> mClientCompositionDamage;
     std::unique_ptr<planner::Planner> mPlanner;
+
+    // The planner hash of the last frame written to the HWC, if its geometry may be reused.
+    std::optional<planner::NonBufferHash> mLastWrittenHash;
+    size_t mBufferOnlyFrames = 0;
+    size_t mFramesWritten = 0;
+
+    // Set from prepareFrame until composeSurfaces uses or discards it.
+    std::optional<PredictedClientComposition> mPredictedClientComposition;
+    size_t mPredictedClientCompositionHits = 0;
+    size_t mPredictedClientCompositionMisses = 0;
 };
 
 // This template factory function standardizes the implementation details of the
@@ -60,7 +60,10 @@ public:
     void prepareFrame(bool usesClientComposition, bool usesDeviceComposition) override;
     std::shared_ptr<renderengine::ExternalTexture> dequeueBuffer(
             base::unique_fd* bufferFence) override;
+    int32_t getBufferAge() const override;
     void queueBuffer(base::unique_fd readyFence) override;
+    bool canDequeueBeforePrepareFrame() const override;
+    void cancelBuffer(base::unique_fd fence) override;
     void onPresentDisplayCompleted() override;
     void flip() override;
 
@@ -73,17 +73,27 @@ public:
         mTexturePool.setDisplaySize(size);
     }
 
+    // If isPredictedStack is set, the layer stack is expected to settle, so its layers are
+    // flattened after a shorter time without updates.
     NonBufferHash flattenLayers(const std::vector<const LayerState*>& layers, NonBufferHash,
-                                std::chrono::steady_clock::time_point now);
+                                std::chrono::steady_clock::time_point now,
+                                bool isPredictedStack = false);
 
     // Renders the newest cached sets with the supplied output composition state
     void renderCachedSets(const OutputCompositionState& outputState,
                           std::optional<std::chrono::steady_clock::time_point> renderDeadline);
 
+    // Drops the cached sets and the texture pool, e.g. when the display is turned off
+    void releaseTextures();
+
     void dump(std::string& result) const;
     void dumpLayers(std::string& result) const;
 
     const std::optional<CachedSet>& getNewCachedSetForTesting() const { return mNewCachedSet; }
+    size_t getPredictedCachedSetHitCountForTesting() const { return mPredictedCachedSetHitCount; }
+    size_t getPredictedCachedSetMissCountForTesting() const {
+        return mPredictedCachedSetMissCount;
+    }
 
 private:
     size_t calculateDisplayCost(const std::vector<const LayerState*>& layers) const;
@@ -168,11 +178,12 @@ private:
         friend class Builder;
     };
 
-    std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now) const;
+    std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now,
+                                       std::chrono::nanoseconds activeLayerTimeout) const;
 
     std::optional<Run> findBestRun(std::vector<Run>& runs) const;
 
-    void buildCachedSets(std::chrono::steady_clock::time_point now);
+    void buildCachedSets(std::chrono::steady_clock::time_point now, bool isPredictedStack);
 
     renderengine::RenderEngine& mRenderEngine;
     const bool mEnableHolePunch;
@@ -183,6 +194,8 @@ private:
 protected:
     // mNewCachedSet must be destroyed before mTexturePool is.
     std::optional<CachedSet> mNewCachedSet;
+    // True if mNewCachedSet was only built because its layer stack was predicted to settle.
+    bool mNewCachedSetIsPredicted = false;
 
 private:
     ui::Size mDisplaySize;
@@ -200,9 +213,14 @@ private:
     size_t mCachedSetCreationCount = 0;
     size_t mCachedSetCreationCost = 0;
     std::unordered_map<size_t, size_t> mInvalidatedCachedSetAges;
+    // Predicted cached sets that were used, and that were dropped before being used
+    size_t mPredictedCachedSetHitCount = 0;
+    size_t mPredictedCachedSetMissCount = 0;
     std::chrono::nanoseconds mActiveLayerTimeout = kActiveLayerTimeout;
+    std::chrono::nanoseconds mPredictedActiveLayerTimeout = kPredictedActiveLayerTimeout;
 
     static constexpr auto kActiveLayerTimeout = std::chrono::nanoseconds(150ms);
+    static constexpr auto kPredictedActiveLayerTimeout = std::chrono::nanoseconds(50ms);
 };
 
 } // namespace compositionengine::impl::planner
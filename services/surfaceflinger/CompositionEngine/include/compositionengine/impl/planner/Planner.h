@@ -64,6 +64,19 @@ public:
     void renderCachedSets(const OutputCompositionState& outputState,
                           std::optional<std::chrono::steady_clock::time_point> renderDeadline);
 
+    // Releases the textures held for layer caching, e.g. when the display is turned off.
+    void releaseTextures();
+
+    // Returns the hash of everything but the buffers of the layers planned last, as they are
+    // drawn once flattened.
+    NonBufferHash getFlattenedHash() const { return mFlattenedHash; }
+
+    // Returns the plan predicted for the layers planned last, if the predictor is enabled and has
+    // seen them before.
+    const std::optional<Predictor::PredictedPlan>& getPredictedPlan() const {
+        return mPredictedPlan;
+    }
+
     void dump(const Vector<String16>& args, std::string&);
 
 private:
@@ -113,6 +113,10 @@ public:
         mLayerTypes.emplace_back(type);
     }
 
+    const std::vector<hardware::graphics::composer::hal::Composition>& getLayerTypes() const {
+        return mLayerTypes;
+    }
+
     friend std::string to_string(const Plan& plan);
 
     friend bool operator==(const Plan& lhs, const Plan& rhs) {
@@ -240,6 +244,10 @@ public:
     std::optional<PredictedPlan> getPredictedPlan(const std::vector<const LayerState*>& layers,
                                                   NonBufferHash hash) const;
 
+    // Whether the exact layer stack has been seen often enough, and always with the same plan, to
+    // be expected to settle again. Such a stack is worth flattening before its layers time out.
+    bool isConfidentExactMatch(NonBufferHash) const;
+
     // Records a comparison between the predicted plan and the resulting plan, alongside the layer
     // stack we used.
     //
@@ -278,6 +286,7 @@ private:
     };
 
     static constexpr const size_t MAX_CANDIDATES = 4;
+    static constexpr const size_t MIN_HITS_FOR_CONFIDENT_MATCH = 30;
     std::deque<PromotionCandidate> mCandidates;
     decltype(mCandidates)::const_iterator getCandidateEntryByHash(NonBufferHash hash) const {
         const auto candidateMatches = [&](const PromotionCandidate& candidate) {
@@ -31,8 +31,9 @@ namespace android::compositionengine::impl::planner {
 // While it is possible to define a texture pool supporting variable-sized textures to save on
 // memory, it is a simpler implementation to only manage screen-sized textures. The texture pool is
 // unbounded - there are a minimum number of textures preallocated. Under heavy system load, new
-// textures may be allocated, but only a maximum number of retained once those textures are no
-// longer necessary.
+// textures may be allocated, and the pool grows to retain more of them, up to a maximum, once
+// those textures are no longer necessary. Textures that stay unused for a while are released, and
+// the pool shrinks back to its minimum size.
 class TexturePool {
 public:
     // RAII class helping with managing textures from the texture pool
@@ -78,18 +79,33 @@ public:
     // to the pool.
     std::shared_ptr<AutoTexture> borrowTexture();
 
+    // Releases the textures in the pool that have not been borrowed since idleTimeout before now,
+    // and shrinks the pool back to its minimum size. Textures are allocated again when needed.
+    void releaseIdleTextures(std::chrono::steady_clock::time_point now,
+                             std::chrono::nanoseconds idleTimeout = kIdleTimeout);
+
+    // Releases all textures in the pool, e.g. when the display is turned off.
+    void releaseTextures();
+
+    void dump(std::string& result) const;
+
 protected:
     // Proteted visibility so that they can be used for testing
     const static constexpr size_t kMinPoolSize = 3;
     const static constexpr size_t kMaxPoolSize = 4;
+    const static constexpr std::chrono::nanoseconds kIdleTimeout = std::chrono::seconds(10);
 
     struct Entry {
         std::shared_ptr<renderengine::ExternalTexture> texture;
         sp<Fence> fence;
+        std::chrono::steady_clock::time_point lastUsed;
     };
 
     std::deque<Entry> mPool;
 
+    // The number of textures kept once returned, grown from kMinPoolSize when the pool is starved.
+    size_t mTargetPoolSize = kMinPoolSize;
+
 private:
     std::shared_ptr<renderengine::ExternalTexture> genTexture();
     // Returns a previously borrowed texture to the pool.
@@ -97,6 +113,11 @@ private:
                        const sp<Fence>& fence);
     renderengine::RenderEngine& mRenderEngine;
     ui::Size mSize;
+
+    // Statistics
+    size_t mHitCount = 0;
+    size_t mMissCount = 0;
+    size_t mReleasedCount = 0;
 };
 
 } // namespace android::compositionengine::impl::planner
@@ -40,7 +40,10 @@ public:
     MOCK_METHOD1(beginFrame, status_t(bool mustRecompose));
     MOCK_METHOD2(prepareFrame, void(bool, bool));
     MOCK_METHOD1(dequeueBuffer, std::shared_ptr<renderengine::ExternalTexture>(base::unique_fd*));
+    MOCK_CONST_METHOD0(getBufferAge, int32_t());
     MOCK_METHOD1(queueBuffer, void(base::unique_fd));
+    MOCK_CONST_METHOD0(canDequeueBeforePrepareFrame, bool());
+    MOCK_METHOD1(cancelBuffer, void(base::unique_fd));
     MOCK_METHOD0(onPresentDisplayCompleted, void());
     MOCK_METHOD0(flip, void());
     MOCK_CONST_METHOD1(dump, void(std::string& result));
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/ClientCompositionDamage.h>
+
+namespace android::compositionengine::impl {
+
+namespace {
+
+uint64_t getArea(const Region& region) {
+    uint64_t area = 0;
+    for (const Rect& rect : region) {
+        area += static_cast<uint64_t>(rect.width()) * static_cast<uint64_t>(rect.height());
+    }
+    return area;
+}
+
+} // namespace
+
+Region ClientCompositionDamage::onFrame(const renderengine::DisplaySettings& display,
+                                        std::vector<Layer> layers, const Region& damage,
+                                        int32_t bufferAge) {
+    const Region viewport(display.clip);
+    const bool sameLayers = mHasLastFrame && display == mLastDisplay && layers == mLastLayers;
+    const Region frameDamage = sameLayers ? damage.intersect(viewport) : viewport;
+
+    // A buffer of age N holds the frame from N frames ago, and misses the damage of the N - 1
+    // frames since then, on top of the damage of this one.
+    Region regionToDraw = viewport;
+    if (bufferAge > 0 && static_cast<size_t>(bufferAge) <= kMaxBufferAge &&
+        static_cast<size_t>(bufferAge) - 1 <= mHistory.size()) {
+        regionToDraw = frameDamage;
+        for (size_t i = 0; i < static_cast<size_t>(bufferAge) - 1; i++) {
+            regionToDraw.orSelf(mHistory[i]);
+        }
+    }
+
+    mHistory.push_front(frameDamage);
+    if (mHistory.size() > kMaxBufferAge) {
+        mHistory.pop_back();
+    }
+    mHasLastFrame = true;
+    mLastDisplay = display;
+    mLastLayers = std::move(layers);
+
+    const uint64_t viewportPixels = getArea(viewport);
+    const uint64_t pixelsToDraw = getArea(regionToDraw);
+    mFrames++;
+    mViewportPixels += viewportPixels;
+    if (pixelsToDraw == 0 || pixelsToDraw >= viewportPixels) {
+        mPixelsDrawn += viewportPixels;
+        return Region();
+    }
+    mPartialFrames++;
+    mPixelsDrawn += pixelsToDraw;
+    return regionToDraw;
+}
+
+void ClientCompositionDamage::invalidate() {
+    mHasLastFrame = false;
+    mLastLayers.clear();
+    mHistory.clear();
+}
+
+void ClientCompositionDamage::dump(std::string& result) const {
+    const float drawnPercent = mViewportPixels
+            ? 100.f * static_cast<float>(mPixelsDrawn) / static_cast<float>(mViewportPixels)
+            : 0.f;
+    base::StringAppendF(&result,
+                        "   Partial client composition: %zu of %zu frames partial, "
+                        "%.1f%% of pixels drawn\n",
+                        mPartialFrames, mFrames, drawnPercent);
+}
+
+} // namespace android::compositionengine::impl
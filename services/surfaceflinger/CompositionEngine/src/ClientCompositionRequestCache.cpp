@@ -15,8 +15,11 @@
  */
 
 #include <algorithm>
+#include <cmath>
 
+#include <android-base/stringprintf.h>
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <math/HashCombine.h>
 #include <renderengine/DisplaySettings.h>
 #include <renderengine/LayerSettings.h>
 
@@ -30,10 +33,10 @@ LayerFE::LayerSettings getLayerSettingsSnapshot(const LayerFE::LayerSettings& se
     return snapshot;
 }
 
+// The geometry and the alpha are compared quantized by the cache.
 inline bool equalIgnoringSource(const renderengine::LayerSettings& lhs,
                                 const renderengine::LayerSettings& rhs) {
-    return lhs.geometry == rhs.geometry && lhs.alpha == rhs.alpha &&
-            lhs.sourceDataspace == rhs.sourceDataspace &&
+    return lhs.sourceDataspace == rhs.sourceDataspace &&
             lhs.colorTransform == rhs.colorTransform &&
             lhs.disableBlending == rhs.disableBlending && lhs.shadow == rhs.shadow &&
             lhs.backgroundBlurRadius == rhs.backgroundBlurRadius &&
@@ -61,39 +64,109 @@ inline bool equalIgnoringBuffer(const renderengine::LayerSettings& lhs,
             equalIgnoringBuffer(lhs.source.buffer, rhs.source.buffer);
 }
 
-bool layerSettingsAreEqual(const LayerFE::LayerSettings& lhs, const LayerFE::LayerSettings& rhs) {
-    return lhs.bufferId == rhs.bufferId && lhs.frameNumber == rhs.frameNumber &&
-            equalIgnoringBuffer(lhs, rhs);
+const char* toString(ClientCompositionRequestCache::MissReason reason) {
+    switch (reason) {
+        case ClientCompositionRequestCache::MissReason::NotCached:
+            return "not cached";
+        case ClientCompositionRequestCache::MissReason::DisplayChanged:
+            return "display changed";
+        case ClientCompositionRequestCache::MissReason::LayerCountChanged:
+            return "layer count changed";
+        case ClientCompositionRequestCache::MissReason::LayersChanged:
+            return "layers changed";
+    }
+    return "unknown";
 }
 
 } // namespace
 
+float ClientCompositionRequestCache::quantizeGeometry(float value) {
+    return std::round(value * kGeometryStepsPerPixel);
+}
+
+float ClientCompositionRequestCache::quantizeAlpha(float value) {
+    return std::round(value * kAlphaSteps);
+}
+
+bool ClientCompositionRequestCache::quantizedEqual(const LayerFE::LayerSettings& lhs,
+                                                   const LayerFE::LayerSettings& rhs) {
+    const auto rectsEqual = [](const FloatRect& lhsRect, const FloatRect& rhsRect) {
+        return quantizeGeometry(lhsRect.left) == quantizeGeometry(rhsRect.left) &&
+                quantizeGeometry(lhsRect.top) == quantizeGeometry(rhsRect.top) &&
+                quantizeGeometry(lhsRect.right) == quantizeGeometry(rhsRect.right) &&
+                quantizeGeometry(lhsRect.bottom) == quantizeGeometry(rhsRect.bottom);
+    };
+    const renderengine::Geometry& lhsGeometry = lhs.geometry;
+    const renderengine::Geometry& rhsGeometry = rhs.geometry;
+    return lhs.bufferId == rhs.bufferId && lhs.frameNumber == rhs.frameNumber &&
+            rectsEqual(lhsGeometry.boundaries, rhsGeometry.boundaries) &&
+            lhsGeometry.positionTransform == rhsGeometry.positionTransform &&
+            quantizeGeometry(lhsGeometry.roundedCornersRadius) ==
+            quantizeGeometry(rhsGeometry.roundedCornersRadius) &&
+            rectsEqual(lhsGeometry.roundedCornersCrop, rhsGeometry.roundedCornersCrop) &&
+            quantizeAlpha(lhs.alpha) == quantizeAlpha(rhs.alpha) && equalIgnoringBuffer(lhs, rhs);
+}
+
+size_t ClientCompositionRequestCache::hashLayers(
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    size_t hash = 0;
+    for (const LayerFE::LayerSettings& settings : layerSettings) {
+        const FloatRect& boundaries = settings.geometry.boundaries;
+        hashCombineSingleHashed(hash,
+                                hashCombine(settings.bufferId, settings.frameNumber,
+                                            quantizeGeometry(boundaries.left),
+                                            quantizeGeometry(boundaries.top),
+                                            quantizeGeometry(boundaries.right),
+                                            quantizeGeometry(boundaries.bottom),
+                                            quantizeAlpha(settings.alpha)));
+    }
+    return hash;
+}
+
 ClientCompositionRequestCache::ClientCompositionRequest::ClientCompositionRequest(
         const renderengine::DisplaySettings& initDisplay,
         const std::vector<LayerFE::LayerSettings>& initLayerSettings)
-      : display(initDisplay) {
+      : display(initDisplay), layersHash(hashLayers(initLayerSettings)) {
     layerSettings.reserve(initLayerSettings.size());
     for (const LayerFE::LayerSettings& settings : initLayerSettings) {
         layerSettings.push_back(getLayerSettingsSnapshot(settings));
     }
 }
 
-bool ClientCompositionRequestCache::ClientCompositionRequest::equals(
+std::optional<ClientCompositionRequestCache::MissReason>
+ClientCompositionRequestCache::ClientCompositionRequest::compare(
         const renderengine::DisplaySettings& newDisplay,
         const std::vector<LayerFE::LayerSettings>& newLayerSettings) const {
-    return newDisplay == display &&
-            std::equal(layerSettings.begin(), layerSettings.end(), newLayerSettings.begin(),
-                       newLayerSettings.end(), layerSettingsAreEqual);
+    if (!(newDisplay == display)) {
+        return MissReason::DisplayChanged;
+    }
+    if (newLayerSettings.size() != layerSettings.size()) {
+        return MissReason::LayerCountChanged;
+    }
+    if (hashLayers(newLayerSettings) != layersHash ||
+        !std::equal(layerSettings.begin(), layerSettings.end(), newLayerSettings.begin(),
+                    quantizedEqual)) {
+        return MissReason::LayersChanged;
+    }
+    return std::nullopt;
 }
 
 bool ClientCompositionRequestCache::exists(
         uint64_t bufferId, const renderengine::DisplaySettings& display,
-        const std::vector<LayerFE::LayerSettings>& layerSettings) const {
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    std::optional<MissReason> missReason = MissReason::NotCached;
     for (const auto& [cachedBufferId, cachedRequest] : mCache) {
         if (cachedBufferId == bufferId) {
-            return cachedRequest.equals(display, layerSettings);
+            missReason = cachedRequest.compare(display, layerSettings);
+            break;
         }
     }
+
+    if (!missReason) {
+        mHits++;
+        return true;
+    }
+    mMisses[static_cast<size_t>(*missReason)]++;
     return false;
 }
 
@@ -110,6 +183,7 @@ void ClientCompositionRequestCache::add(uint64_t bufferId,
 
     if (mCache.size() >= mMaxCacheSize) {
         mCache.pop_front();
+        mEvictions++;
     }
 
     mCache.emplace_back(bufferId, std::move(request));
@@ -124,4 +198,28 @@ void ClientCompositionRequestCache::remove(uint64_t bufferId) {
     }
 }
 
+size_t ClientCompositionRequestCache::getMissCount(MissReason reason) const {
+    return mMisses[static_cast<size_t>(reason)];
+}
+
+void ClientCompositionRequestCache::dump(std::string& result) const {
+    size_t misses = 0;
+    for (size_t count : mMisses) {
+        misses += count;
+    }
+    base::StringAppendF(&result,
+                        "   Client composition cache: %zu of %u requests, %zu hits, %zu misses, "
+                        "%zu evictions\n",
+                        mCache.size(), mMaxCacheSize, mHits, misses, mEvictions);
+    if (misses == 0) {
+        return;
+    }
+    result.append("      misses:");
+    for (MissReason reason : {MissReason::NotCached, MissReason::DisplayChanged,
+                              MissReason::LayerCountChanged, MissReason::LayersChanged}) {
+        base::StringAppendF(&result, " %s=%zu", toString(reason), getMissCount(reason));
+    }
+    result.append("\n");
+}
+
 } // namespace android::compositionengine::impl
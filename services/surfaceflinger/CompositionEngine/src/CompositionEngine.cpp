@@ -100,15 +100,44 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
         // needed for anything else.
         LayerFESet latchedLayers;
 
-        for (const auto& output : args.outputs) {
-            output->prepare(args, latchedLayers);
+        if (args.workerPool != nullptr && args.outputs.size() > 1 &&
+            args.updatingOutputGeometryThisFrame) {
+            // Each output would latch any layer not latched yet. Do all of
+            // them first, so the outputs only read latchedLayers, and each
+            // output's layers are then independent of the other outputs.
+            for (const auto& layer : args.layers) {
+                if (latchedLayers.insert(layer).second) {
+                    layer->prepareCompositionState(LayerFE::StateSubset::BasicGeometry);
+                }
+            }
+            args.workerPool->parallelFor(args.outputs.size(), [&](size_t i) {
+                args.outputs[i]->prepare(args, latchedLayers);
+            });
+        } else {
+            for (const auto& output : args.outputs) {
+                output->prepare(args, latchedLayers);
+            }
         }
     }
 
     updateLayerStateFromFE(args);
 
-    for (const auto& output : args.outputs) {
-        output->present(args);
+    // The flash of the dirty regions composes and presents outside the
+    // phases that the outputs lock, so it always presents serially.
+    if (args.workerPool != nullptr && args.presentOutputsInParallel && args.outputs.size() > 1 &&
+        !args.devOptFlashDirtyRegionsDelay) {
+        std::mutex hwcMutex;
+        std::mutex renderMutex;
+        args.hwcMutex = &hwcMutex;
+        args.renderMutex = &renderMutex;
+        args.workerPool->parallelFor(args.outputs.size(),
+                                     [&](size_t i) { args.outputs[i]->present(args); });
+        args.hwcMutex = nullptr;
+        args.renderMutex = nullptr;
+    } else {
+        for (const auto& output : args.outputs) {
+            output->present(args);
+        }
     }
 }
 
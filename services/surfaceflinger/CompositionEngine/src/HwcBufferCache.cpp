@@ -55,4 +55,18 @@ void HwcBufferCache::getHwcBuffer(int slot, const sp<GraphicBuffer>& buffer, uin
     }
 }
 
+std::vector<uint32_t> HwcBufferCache::clearSlots(const std::vector<uint32_t>& slots,
+                                                 uint32_t activeSlot) {
+    std::vector<uint32_t> clearedSlots;
+    for (uint32_t slot : slots) {
+        if (slot == activeSlot || slot >= kMaxLayerBufferCount ||
+            mBuffers[slot].unsafe_get() == nullptr) {
+            continue;
+        }
+        mBuffers[slot].clear();
+        clearedSlots.push_back(slot);
+    }
+    return clearedSlots;
+}
+
 } // namespace android::compositionengine::impl
@@ -87,6 +87,11 @@ ScaleVector getScale(const Rect& from, const Rect& to) {
             .y = static_cast<float>(to.height()) / from.height()};
 }
 
+// Takes the lock only if the outputs are being presented in parallel.
+std::unique_lock<std::mutex> lockIfPresentingInParallel(std::mutex* mutex) {
+    return mutex ? std::unique_lock<std::mutex>(*mutex) : std::unique_lock<std::mutex>();
+}
+
 } // namespace
 
 std::shared_ptr<Output> createOutput(
@@ -121,6 +126,24 @@ void Output::setCompositionEnabled(bool enabled) {
 
     outputState.isEnabled = enabled;
     dirtyEntireOutput();
+    mLastWrittenHash.reset();
+
+    // Nothing is flattened while the output is disabled, so don't hold on to the textures
+    if (!enabled && mPlanner) {
+        mPlanner->releaseTextures();
+    }
+}
+
+void Output::setPartialClientCompositionEnabled(bool enabled) {
+    if (enabled == (mClientCompositionDamage != nullptr)) {
+        return;
+    }
+
+    if (enabled) {
+        mClientCompositionDamage = std::make_unique<ClientCompositionDamage>();
+    } else {
+        mClientCompositionDamage.reset();
+    }
 }
 
 void Output::setLayerCachingEnabled(bool enabled) {
@@ -136,6 +159,7 @@ void Output::setLayerCachingEnabled(bool enabled) {
     } else {
         mPlanner.reset();
     }
+    mLastWrittenHash.reset();
 
     for (auto* outputLayer : getOutputLayersOrderedByZ()) {
         if (!outputLayer) {
@@ -304,6 +328,23 @@ void Output::dumpBase(std::string& out) const {
         out.append("    No render surface!\n");
     }
 
+    if (mClientCompositionRequestCache) {
+        mClientCompositionRequestCache->dump(out);
+    }
+
+    if (mPlanner) {
+        android::base::StringAppendF(&out, "   HWC buffer-only frames: %zu of %zu\n",
+                                     mBufferOnlyFrames, mFramesWritten);
+        android::base::StringAppendF(&out,
+                                     "   Predicted client composition: %zu used, %zu discarded\n",
+                                     mPredictedClientCompositionHits,
+                                     mPredictedClientCompositionMisses);
+    }
+
+    if (mClientCompositionDamage) {
+        mClientCompositionDamage->dump(out);
+    }
+
     android::base::StringAppendF(&out, "\n   %zu Layers\n", getOutputLayerCount());
     for (const auto* outputLayer : getOutputLayersOrderedByZ()) {
         if (!outputLayer) {
@@ -424,16 +465,34 @@ void Output::present(const compositionengine::CompositionRefreshArgs& refreshArg
     ATRACE_CALL();
     ALOGV(__FUNCTION__);
 
+    // finishFrame() releases this while it uses RenderEngine.
+    auto hwcLock = lockIfPresentingInParallel(refreshArgs.hwcMutex);
     updateColorProfile(refreshArgs);
     updateCompositionState(refreshArgs);
     planComposition();
     writeCompositionState(refreshArgs);
     setColorTransform(refreshArgs);
     beginFrame();
-    prepareFrame();
+    if (predictClientComposition(refreshArgs)) {
+        // Draw the predicted client composition while the HWC validates.
+        refreshArgs.workerPool->parallelFor(2, [this](size_t i) {
+            if (i == 0) {
+                prepareFrame();
+            } else {
+                drawPredictedClientComposition();
+            }
+        });
+    } else {
+        prepareFrame();
+    }
     devOptRepaintFlash(refreshArgs);
     finishFrame(refreshArgs);
     postFramebuffer();
+    if (hwcLock.owns_lock()) {
+        hwcLock.unlock();
+    }
+
+    auto renderLock = lockIfPresentingInParallel(refreshArgs.renderMutex);
     renderCachedSets(refreshArgs);
 }
 
@@ -731,6 +790,10 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
     editState().earliestPresentTime = refreshArgs.earliestPresentTime;
     editState().previousPresentFence = refreshArgs.previousPresentFence;
 
+    // Layers whose state is unchanged but for their buffers only have those written.
+    const bool geometryUnchanged = isGeometryUnchanged(refreshArgs);
+    bool buffersOnly = geometryUnchanged;
+
     compositionengine::OutputLayer* peekThroughLayer = nullptr;
     sp<GraphicBuffer> previousOverride = nullptr;
     bool includeGeometry = refreshArgs.updatingGeometryThisFrame;
@@ -762,17 +825,42 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
                     constexpr bool isPeekingThrough = true;
                     peekThroughLayer->writeStateToHWC(includeGeometry, false, z++, overrideZ,
                                                       isPeekingThrough);
+                    buffersOnly = false;
                 }
 
                 previousOverride = overrideInfo.buffer->getBuffer();
             }
         }
 
+        const uint32_t layerZ = z++;
+        if (geometryUnchanged && !skipLayer && !overrideZ && layer->writeBufferStateOnlyToHWC()) {
+            continue;
+        }
         constexpr bool isPeekingThrough = false;
-        layer->writeStateToHWC(includeGeometry, skipLayer, z++, overrideZ, isPeekingThrough);
+        layer->writeStateToHWC(includeGeometry, skipLayer, layerZ, overrideZ, isPeekingThrough);
+        buffersOnly = false;
+    }
+
+    mFramesWritten++;
+    if (buffersOnly) {
+        mBufferOnlyFrames++;
     }
 }
 
+bool Output::isGeometryUnchanged(const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    // The planner hash covers the order and the state of the layers but for their buffers, after
+    // flattening. Without a planner nothing tells that the state is unchanged.
+    if (!mPlanner || refreshArgs.updatingGeometryThisFrame) {
+        mLastWrittenHash.reset();
+        return false;
+    }
+
+    const planner::NonBufferHash hash = mPlanner->getFlattenedHash();
+    const bool unchanged = mLastWrittenHash == hash;
+    mLastWrittenHash = hash;
+    return unchanged;
+}
+
 compositionengine::OutputLayer* Output::findLayerRequestingBackgroundComposition() const {
     compositionengine::OutputLayer* layerRequestingBgComposition = nullptr;
     for (auto* layer : getOutputLayersOrderedByZ()) {
@@ -948,6 +1036,132 @@ void Output::prepareFrame() {
                                  outputState.usesDeviceComposition);
 }
 
+bool Output::predictClientComposition(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    if (mPredictedClientComposition) {
+        // The last frame didn't compose its surfaces, e.g. because it bailed out.
+        discardPredictedClientComposition(*mPredictedClientComposition);
+        mRenderSurface->cancelBuffer(std::move(mPredictedClientComposition->readyFence));
+        mPredictedClientComposition.reset();
+    }
+
+    const auto& outputState = getState();
+    // Nested in a parallel present, the worker pool is busy. Flashing the dirty regions draws
+    // the client composition before the frame does.
+    if (!refreshArgs.predictClientComposition || !refreshArgs.workerPool || refreshArgs.hwcMutex ||
+        refreshArgs.devOptFlashDirtyRegionsDelay || !outputState.isEnabled) {
+        return false;
+    }
+
+    // The buffer is dequeued before prepareFrame, which not every surface allows.
+    if (!mRenderSurface->canDequeueBeforePrepareFrame()) {
+        return false;
+    }
+
+    // Only a layer stack seen with the same plan often enough is predicted.
+    if (!mPlanner) {
+        return false;
+    }
+    const auto& predictedPlan = mPlanner->getPredictedPlan();
+    if (!predictedPlan || predictedPlan->type != planner::Prediction::Type::Exact) {
+        return false;
+    }
+    const auto& predictedTypes = predictedPlan->plan.getLayerTypes();
+    if (predictedTypes.size() != getOutputLayerCount() ||
+        std::none_of(predictedTypes.begin(), predictedTypes.end(),
+                     [](auto type) { return type == hal::Composition::CLIENT; })) {
+        return false;
+    }
+
+    // Switching the protected context must not overlap another draw.
+    auto& renderEngine = getCompositionEngine().getRenderEngine();
+    const bool supportsProtectedContent = renderEngine.supportsProtectedContent();
+    if ((outputState.isSecure && supportsProtectedContent) || renderEngine.isProtected()) {
+        return false;
+    }
+
+    ATRACE_CALL();
+
+    // Generate the requests as if the HWC had chosen the predicted types, and restore the types
+    // the HWC last chose for it to validate the frame.
+    auto& state = editState();
+    const bool usesClientComposition = state.usesClientComposition;
+    const bool usesDeviceComposition = state.usesDeviceComposition;
+    std::vector<std::optional<hal::Composition>> hwcCompositionTypes;
+    hwcCompositionTypes.reserve(predictedTypes.size());
+    size_t layerIndex = 0;
+    for (auto* layer : getOutputLayersOrderedByZ()) {
+        auto& hwcState = layer->editState().hwc;
+        hwcCompositionTypes.push_back(hwcState ? std::make_optional(hwcState->hwcCompositionType)
+                                               : std::nullopt);
+        if (hwcState) {
+            hwcState->hwcCompositionType = predictedTypes[layerIndex];
+        }
+        layerIndex++;
+    }
+    state.usesClientComposition = true;
+    state.usesDeviceComposition =
+            std::any_of(predictedTypes.begin(), predictedTypes.end(),
+                        [](auto type) { return type != hal::Composition::CLIENT; });
+
+    PredictedClientComposition predicted;
+    predicted.display = generateClientCompositionDisplaySettings();
+    predicted.layers = generateClientCompositionRequests(supportsProtectedContent,
+                                                         predicted.display.clearRegion,
+                                                         predicted.display.outputDataspace);
+
+    layerIndex = 0;
+    for (auto* layer : getOutputLayersOrderedByZ()) {
+        if (auto& hwcState = layer->editState().hwc) {
+            hwcState->hwcCompositionType = *hwcCompositionTypes[layerIndex];
+        }
+        layerIndex++;
+    }
+    state.usesClientComposition = usesClientComposition;
+    state.usesDeviceComposition = usesDeviceComposition;
+
+    if (predicted.layers.empty()) {
+        return false;
+    }
+    predicted.buffer = mRenderSurface->dequeueBuffer(&predicted.bufferFence);
+    if (predicted.buffer == nullptr) {
+        return false;
+    }
+    predicted.useFramebufferCache = outputState.layerStackInternal;
+    mPredictedClientComposition = std::move(predicted);
+    return true;
+}
+
+void Output::drawPredictedClientComposition() {
+    ATRACE_CALL();
+
+    auto& predicted = *mPredictedClientComposition;
+    std::vector<const renderengine::LayerSettings*> layerPointers;
+    layerPointers.reserve(predicted.layers.size());
+    std::transform(predicted.layers.begin(), predicted.layers.end(),
+                   std::back_inserter(layerPointers),
+                   [](const LayerFE::LayerSettings& settings)
+                           -> const renderengine::LayerSettings* { return &settings; });
+    predicted.status =
+            getCompositionEngine().getRenderEngine().drawLayers(predicted.display, layerPointers,
+                                                                predicted.buffer,
+                                                                predicted.useFramebufferCache,
+                                                                std::move(predicted.bufferFence),
+                                                                &predicted.readyFence);
+}
+
+void Output::discardPredictedClientComposition(PredictedClientComposition& predicted) {
+    mPredictedClientCompositionMisses++;
+
+    // The buffer now holds a frame that was never presented.
+    if (mClientCompositionRequestCache) {
+        mClientCompositionRequestCache->remove(predicted.buffer->getBuffer()->getId());
+    }
+    if (mClientCompositionDamage) {
+        mClientCompositionDamage->invalidate();
+    }
+}
+
 void Output::devOptRepaintFlash(const compositionengine::CompositionRefreshArgs& refreshArgs) {
     if (CC_LIKELY(!refreshArgs.devOptFlashDirtyRegionsDelay)) {
         return;
@@ -981,8 +1195,19 @@ void Output::finishFrame(const compositionengine::CompositionRefreshArgs& refres
     }
 
     // Repaint the framebuffer (if needed), getting the optional fence for when
-    // the composition completes.
-    auto optReadyFence = composeSurfaces(Region::INVALID_REGION, refreshArgs);
+    // the composition completes. When presenting in parallel, present() holds
+    // hwcMutex, which other outputs may use in the meantime.
+    std::optional<base::unique_fd> optReadyFence;
+    if (refreshArgs.hwcMutex) {
+        refreshArgs.hwcMutex->unlock();
+        {
+            std::lock_guard renderLock(*refreshArgs.renderMutex);
+            optReadyFence = composeSurfaces(Region::INVALID_REGION, refreshArgs);
+        }
+        refreshArgs.hwcMutex->lock();
+    } else {
+        optReadyFence = composeSurfaces(Region::INVALID_REGION, refreshArgs);
+    }
     if (!optReadyFence) {
         return;
     }
@@ -1003,6 +1228,8 @@ std::optional<base::unique_fd> Output::composeSurfaces(
 
     auto& renderEngine = getCompositionEngine().getRenderEngine();
     const bool supportsProtectedContent = renderEngine.supportsProtectedContent();
+    std::optional<PredictedClientComposition> predicted =
+            std::exchange(mPredictedClientComposition, std::nullopt);
 
     // If we the display is secure, protected content support is enabled, and at
     // least one layer has protected content, we need to use a secure back
@@ -1030,47 +1257,46 @@ std::optional<base::unique_fd> Output::composeSurfaces(
     // If we aren't doing client composition on this output, but do have a
     // flipClientTarget request for this frame on this output, we still need to
     // dequeue a buffer.
-    if (hasClientComposition || outputState.flipClientTarget) {
+    if (predicted && (hasClientComposition || outputState.flipClientTarget)) {
+        // Anything drawn into the buffer waits for the predicted composition.
+        tex = predicted->buffer;
+        fd = base::unique_fd(dup(predicted->readyFence.get()));
+    } else if (predicted) {
+        // The HWC composes all of the layers after all.
+        discardPredictedClientComposition(*predicted);
+        mRenderSurface->cancelBuffer(std::move(predicted->readyFence));
+        predicted.reset();
+    } else if (hasClientComposition || outputState.flipClientTarget) {
         tex = mRenderSurface->dequeueBuffer(&fd);
         if (tex == nullptr) {
             ALOGW("Dequeuing buffer for display [%s] failed, bailing out of "
                   "client composition for this frame",
                   mName.c_str());
+            if (mClientCompositionDamage) {
+                mClientCompositionDamage->invalidate();
+            }
             return {};
         }
     }
 
     base::unique_fd readyFence;
     if (!hasClientComposition) {
+        if (mClientCompositionDamage) {
+            mClientCompositionDamage->invalidate();
+        }
+        if (predicted) {
+            // The client target is only flipped, and has to wait for the predicted composition.
+            discardPredictedClientComposition(*predicted);
+            readyFence = std::move(predicted->readyFence);
+        }
         setExpensiveRenderingExpected(false);
         return readyFence;
     }
 
     ALOGV("hasClientComposition");
 
-    renderengine::DisplaySettings clientCompositionDisplay;
-    clientCompositionDisplay.physicalDisplay = outputState.framebufferSpace.content;
-    clientCompositionDisplay.clip = outputState.layerStackSpace.content;
-    clientCompositionDisplay.orientation =
-            ui::Transform::toRotationFlags(outputState.displaySpace.orientation);
-    clientCompositionDisplay.outputDataspace = mDisplayColorProfile->hasWideColorGamut()
-            ? outputState.dataspace
-            : ui::Dataspace::UNKNOWN;
-
-    // If we have a valid current display brightness use that, otherwise fall back to the
-    // display's max desired
-    clientCompositionDisplay.maxLuminance = outputState.displayBrightnessNits > 0.f
-            ? outputState.displayBrightnessNits
-            : mDisplayColorProfile->getHdrCapabilities().getDesiredMaxLuminance();
-    clientCompositionDisplay.sdrWhitePointNits = outputState.sdrWhitePointNits;
-
-    // Compute the global color transform matrix.
-    if (!outputState.usesDeviceComposition && !getSkipColorTransform()) {
-        clientCompositionDisplay.colorTransform = outputState.colorTransformMatrix;
-    }
-
-    // Note: Updated by generateClientCompositionRequests
-    clientCompositionDisplay.clearRegion = Region::INVALID_REGION;
+    renderengine::DisplaySettings clientCompositionDisplay =
+            generateClientCompositionDisplaySettings();
 
     // Generate the client composition requests for the layers on this output.
     std::vector<LayerFE::LayerSettings> clientCompositionLayers =
@@ -1079,6 +1305,37 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                               clientCompositionDisplay.outputDataspace);
     appendRegionFlashRequests(debugRegion, clientCompositionLayers);
 
+    // The predicted composition is used if the HWC chose the predicted types, or any others that
+    // lead to the same draw.
+    const bool usePredicted = predicted && predicted->status == NO_ERROR &&
+            predicted->display == clientCompositionDisplay &&
+            predicted->layers == clientCompositionLayers;
+    if (usePredicted) {
+        mPredictedClientCompositionHits++;
+    } else if (predicted) {
+        discardPredictedClientComposition(*predicted);
+    }
+
+    if (mClientCompositionDamage) {
+        // Blurs change pixels outside of the damage, and a frame flashing the damage leaves the
+        // flash in the buffer, so those frames are drawn in full.
+        const bool hasBlurs = std::any_of(clientCompositionLayers.begin(),
+                                          clientCompositionLayers.end(), [](const auto& layer) {
+                                              return layer.backgroundBlurRadius > 0 ||
+                                                      !layer.blurRegions.empty();
+                                          });
+        if (!debugRegion.isEmpty()) {
+            mClientCompositionDamage->invalidate();
+        } else {
+            const Region damage = hasBlurs ? Region(outputState.layerStackSpace.content)
+                                           : getDirtyRegion(refreshArgs.repaintEverything);
+            clientCompositionDisplay.damage =
+                    mClientCompositionDamage->onFrame(clientCompositionDisplay,
+                                                      getClientCompositionDamageLayers(), damage,
+                                                      mRenderSurface->getBufferAge());
+        }
+    }
+
     // Check if the client composition requests were rendered into the provided graphic buffer. If
     // so, we can reuse the buffer and avoid client composition.
     if (mClientCompositionRequestCache) {
@@ -1087,6 +1344,9 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                                    clientCompositionLayers)) {
             outputCompositionState.reusedClientComposition = true;
             setExpensiveRenderingExpected(false);
+            if (predicted) {
+                readyFence = std::move(predicted->readyFence);
+            }
             return readyFence;
         }
         mClientCompositionRequestCache->add(tex->getBuffer()->getId(), clientCompositionDisplay,
@@ -1121,14 +1381,21 @@ std::optional<base::unique_fd> Output::composeSurfaces(
     // probably to encapsulate the output buffer into a structure that dispatches resource cleanup
     // over to RenderEngine, in which case this flag can be removed from the drawLayers interface.
     const bool useFramebufferCache = outputState.layerStackInternal;
-    status_t status =
-            renderEngine.drawLayers(clientCompositionDisplay, clientCompositionLayerPointers, tex,
-                                    useFramebufferCache, std::move(fd), &readyFence);
+    status_t status = NO_ERROR;
+    if (usePredicted) {
+        readyFence = std::move(predicted->readyFence);
+    } else {
+        status = renderEngine.drawLayers(clientCompositionDisplay, clientCompositionLayerPointers,
+                                         tex, useFramebufferCache, std::move(fd), &readyFence);
+    }
 
     if (status != NO_ERROR && mClientCompositionRequestCache) {
         // If rendering was not successful, remove the request from the cache.
         mClientCompositionRequestCache->remove(tex->getBuffer()->getId());
     }
+    if (status != NO_ERROR && mClientCompositionDamage) {
+        mClientCompositionDamage->invalidate();
+    }
 
     auto& timeStats = getCompositionEngine().getTimeStats();
     if (readyFence.get() < 0) {
@@ -1142,6 +1409,35 @@ std::optional<base::unique_fd> Output::composeSurfaces(
     return readyFence;
 }
 
+renderengine::DisplaySettings Output::generateClientCompositionDisplaySettings() const {
+    const auto& outputState = getState();
+
+    renderengine::DisplaySettings clientCompositionDisplay;
+    clientCompositionDisplay.physicalDisplay = outputState.framebufferSpace.content;
+    clientCompositionDisplay.clip = outputState.layerStackSpace.content;
+    clientCompositionDisplay.orientation =
+            ui::Transform::toRotationFlags(outputState.displaySpace.orientation);
+    clientCompositionDisplay.outputDataspace = mDisplayColorProfile->hasWideColorGamut()
+            ? outputState.dataspace
+            : ui::Dataspace::UNKNOWN;
+
+    // If we have a valid current display brightness use that, otherwise fall back to the
+    // display's max desired
+    clientCompositionDisplay.maxLuminance = outputState.displayBrightnessNits > 0.f
+            ? outputState.displayBrightnessNits
+            : mDisplayColorProfile->getHdrCapabilities().getDesiredMaxLuminance();
+    clientCompositionDisplay.sdrWhitePointNits = outputState.sdrWhitePointNits;
+
+    // Compute the global color transform matrix.
+    if (!outputState.usesDeviceComposition && !getSkipColorTransform()) {
+        clientCompositionDisplay.colorTransform = outputState.colorTransformMatrix;
+    }
+
+    // Note: Updated by generateClientCompositionRequests
+    clientCompositionDisplay.clearRegion = Region::INVALID_REGION;
+    return clientCompositionDisplay;
+}
+
 std::vector<LayerFE::LayerSettings> Output::generateClientCompositionRequests(
         bool supportsProtectedContent, Region& clearRegion, ui::Dataspace outputDataspace) {
     std::vector<LayerFE::LayerSettings> clientCompositionLayers;
@@ -1237,6 +1533,25 @@ std::vector<LayerFE::LayerSettings> Output::generateClientCompositionRequests(
     return clientCompositionLayers;
 }
 
+std::vector<ClientCompositionDamage::Layer> Output::getClientCompositionDamageLayers() const {
+    std::vector<ClientCompositionDamage::Layer> layers;
+    const auto& outputState = getState();
+    const Region viewportRegion(outputState.layerStackSpace.content);
+    for (auto* layer : getOutputLayersOrderedByZ()) {
+        const auto& layerState = layer->getState();
+        if (viewportRegion.intersect(layerState.visibleRegion).isEmpty()) {
+            continue;
+        }
+        const auto& overrideBuffer = layerState.overrideInfo.buffer;
+        layers.push_back({.layerFE = &layer->getLayerFE(),
+                          .clientComposition = layer->requiresClientComposition(),
+                          .clearClientTarget = layerState.clearClientTarget,
+                          .overrideBufferId =
+                                  overrideBuffer ? overrideBuffer->getBuffer()->getId() : 0});
+    }
+    return layers;
+}
+
 void Output::appendRegionFlashRequests(
         const Region& flashRegion, std::vector<LayerFE::LayerSettings>& clientCompositionLayers) {
     if (flashRegion.isEmpty()) {
@@ -1292,9 +1607,11 @@ void Output::postFramebuffer() {
         // client target acquire fence when it is available, even though
         // this is suboptimal.
         // TODO(b/121291683): Track previous frame client target acquire fence.
+        // The merge reuses either fence if the other one is invalid or has
+        // already signaled, instead of creating a new fence for each layer.
         if (outputState.usesClientComposition) {
             releaseFence =
-                    Fence::merge("LayerRelease", releaseFence, frame.clientTargetAcquireFence);
+                    Fence::merge("LayerRelease", {releaseFence, frame.clientTargetAcquireFence});
         }
 
         layer->getLayerFE().onLayerDisplayed(releaseFence);
@@ -371,6 +371,43 @@ void OutputLayer::writeStateToHWC(bool includeGeometry, bool skipLayer, uint32_t
     editState().hwc->layerSkipped = skipLayer;
 }
 
+bool OutputLayer::writeBufferStateOnlyToHWC() {
+    const auto& state = getState();
+    if (!state.hwc || !state.hwc->hwcLayer) {
+        return false;
+    }
+
+    const auto* outputIndependentState = getLayerFE().getCompositionState();
+    if (!outputIndependentState) {
+        return false;
+    }
+
+    // Overridden and skipped layers have their geometry written every frame, and a composition
+    // type the HWC changed, or one that is now forced, has to be written again.
+    constexpr bool isPeekingThrough = false;
+    const auto requestedCompositionType = isClientCompositionForced(isPeekingThrough)
+            ? hal::Composition::CLIENT
+            : outputIndependentState->compositionType;
+    if (state.overrideInfo.buffer != nullptr || state.hwc->stateOverridden ||
+        state.hwc->layerSkipped || state.hwc->hwcCompositionType != requestedCompositionType) {
+        return false;
+    }
+
+    HWC2::Layer* hwcLayer = state.hwc->hwcLayer.get();
+    if (auto error = hwcLayer->setSurfaceDamage(outputIndependentState->surfaceDamage);
+        error != hal::Error::NONE) {
+        ALOGE("[%s] Failed to set surface damage: %s (%d)", getLayerFE().getDebugName(),
+              to_string(error).c_str(), static_cast<int32_t>(error));
+    }
+
+    if (outputIndependentState->compositionType == hal::Composition::DEVICE ||
+        outputIndependentState->compositionType == hal::Composition::CURSOR) {
+        constexpr bool skipLayer = false;
+        writeBufferStateToHWC(hwcLayer, *outputIndependentState, skipLayer);
+    }
+    return true;
+}
+
 void OutputLayer::writeOutputDependentGeometryStateToHWC(HWC2::Layer* hwcLayer,
                                                          hal::Composition requestedCompositionType,
                                                          uint32_t z) {
@@ -580,6 +617,19 @@ void OutputLayer::writeBufferStateToHWC(HWC2::Layer* hwcLayer,
     // though otherwise the buffer is not output-dependent.
     editState().hwc->hwcBufferCache.getHwcBuffer(slot, buffer, &hwcSlot, &hwcBuffer);
 
+    // Lets the HAL release the freed buffers now, rather than when their slots are reused. This
+    // goes before setBuffer, as clearing selects the active slot again without a fence.
+    const std::vector<uint32_t> slotsToClear =
+            editState().hwc->hwcBufferCache.clearSlots(outputIndependentState.bufferSlotsToClear,
+                                                       hwcSlot);
+    if (!slotsToClear.empty()) {
+        if (auto error = hwcLayer->setBufferSlotsToClear(slotsToClear, hwcSlot);
+            error != hal::Error::NONE) {
+            ALOGE("[%s] Failed to clear %zu buffer slots: %s (%d)", getLayerFE().getDebugName(),
+                  slotsToClear.size(), to_string(error).c_str(), static_cast<int32_t>(error));
+        }
+    }
+
     if (auto error = hwcLayer->setBuffer(hwcSlot, hwcBuffer, acquireFence);
         error != hal::Error::NONE) {
         ALOGE("[%s] Failed to set buffer %p: %s (%d)", getLayerFE().getDebugName(), buffer->handle,
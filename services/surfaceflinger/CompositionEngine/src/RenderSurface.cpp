@@ -197,6 +197,14 @@ std::shared_ptr<renderengine::ExternalTexture> RenderSurface::dequeueBuffer(
     return mTexture;
 }
 
+int32_t RenderSurface::getBufferAge() const {
+    int age = 0;
+    if (mNativeWindow->query(mNativeWindow.get(), NATIVE_WINDOW_BUFFER_AGE, &age) != NO_ERROR) {
+        return 0;
+    }
+    return age;
+}
+
 void RenderSurface::queueBuffer(base::unique_fd readyFence) {
     auto& state = mDisplay.getState();
 
@@ -246,6 +254,27 @@ void RenderSurface::queueBuffer(base::unique_fd readyFence) {
     }
 }
 
+bool RenderSurface::canDequeueBeforePrepareFrame() const {
+    // The surface of a virtual display chooses the queue to dequeue from in prepareFrame, from
+    // the composition type of the frame.
+    return !mDisplay.isVirtual();
+}
+
+void RenderSurface::cancelBuffer(base::unique_fd fence) {
+    if (mTexture == nullptr) {
+        return;
+    }
+
+    if (status_t result =
+                mNativeWindow->cancelBuffer(mNativeWindow.get(),
+                                            mTexture->getBuffer()->getNativeBuffer(), dup(fence));
+        result != NO_ERROR) {
+        ALOGE("Error when cancelling buffer for display [%s]: %d", mDisplay.getName().c_str(),
+              result);
+    }
+    mTexture = nullptr;
+}
+
 void RenderSurface::onPresentDisplayCompleted() {
     mDisplaySurface->onFrameCommitted();
 }
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/WorkerPool.h>
+
+#include <pthread.h>
+
+#include <android-base/stringprintf.h>
+#include <utils/Trace.h>
+
+namespace android::compositionengine {
+
+WorkerPool::WorkerPool(size_t threadCount) {
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        mThreads.emplace_back([this]() { threadMain(); });
+        pthread_setname_np(mThreads.back().native_handle(),
+                           base::StringPrintf("CompositionWk%zu", i).c_str());
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count <= 1 || mThreads.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    ATRACE_CALL();
+    std::lock_guard parallelForLock(mParallelForMutex);
+    {
+        std::lock_guard lock(mMutex);
+        mTask = &task;
+        mCount = count;
+        mNextIndex = 0;
+        mJobSequence++;
+    }
+    mWorkAvailable.notify_all();
+
+    runTasks(task, count);
+
+    // Every index has been taken, but workers may still be running theirs.
+    std::unique_lock lock(mMutex);
+    mWorkersIdle.wait(lock, [this]() { return mBusyWorkers == 0; });
+    mTask = nullptr;
+}
+
+void WorkerPool::runTasks(const std::function<void(size_t)>& task, size_t count) {
+    for (size_t i = mNextIndex++; i < count; i = mNextIndex++) {
+        task(i);
+    }
+}
+
+void WorkerPool::threadMain() {
+    uint64_t lastJobSequence = 0;
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWorkAvailable.wait(lock,
+                            [&]() { return mStopping || mJobSequence != lastJobSequence; });
+        if (mStopping) return;
+
+        lastJobSequence = mJobSequence;
+        // A worker which wakes up after parallelFor returned has nothing to do.
+        if (mTask == nullptr) continue;
+
+        const auto* task = mTask;
+        const size_t count = mCount;
+        mBusyWorkers++;
+        lock.unlock();
+
+        runTasks(*task, count);
+
+        lock.lock();
+        if (--mBusyWorkers == 0) {
+            mWorkersIdle.notify_all();
+        }
+    }
+}
+
+} // namespace android::compositionengine
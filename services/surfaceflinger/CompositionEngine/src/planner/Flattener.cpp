@@ -72,11 +72,20 @@ Flattener::Flattener(
     if (timeoutInMs != 0) {
         mActiveLayerTimeout = std::chrono::milliseconds(timeoutInMs);
     }
+
+    const int predictedTimeoutInMs = base::GetIntProperty(
+            std::string("debug.sf.layer_caching_predicted_active_layer_timeout_ms"), 0);
+    if (predictedTimeoutInMs != 0) {
+        mPredictedActiveLayerTimeout = std::chrono::milliseconds(predictedTimeoutInMs);
+    }
 }
 
 NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& layers,
-                                       NonBufferHash hash, time_point now) {
+                                       NonBufferHash hash, time_point now,
+                                       bool isPredictedStack) {
     ATRACE_CALL();
+    mTexturePool.releaseIdleTextures(now);
+
     const size_t unflattenedDisplayCost = calculateDisplayCost(layers);
     mUnflattenedDisplayCost += unflattenedDisplayCost;
 
@@ -101,7 +110,7 @@ NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& lay
     ++mFinalLayerCounts[mLayers.size()];
 
     if (alreadyHadCachedSets) {
-        buildCachedSets(now);
+        buildCachedSets(now, isPredictedStack);
         hash = computeLayersHash();
     }
 
@@ -150,6 +159,12 @@ void Flattener::renderCachedSets(
     mNewCachedSet->render(mRenderEngine, mTexturePool, outputState);
 }
 
+void Flattener::releaseTextures() {
+    // The cached sets return their textures to the pool as they are destroyed
+    resetActivities(0, std::chrono::steady_clock::now());
+    mTexturePool.releaseTextures();
+}
+
 void Flattener::dumpLayers(std::string& result) const {
     result.append("  Current layers:");
     for (const CachedSet& layer : mLayers) {
@@ -198,6 +213,9 @@ void Flattener::dump(std::string& result) const {
     base::StringAppendF(&result, "\n    Cached sets created: %zd\n", mCachedSetCreationCount);
     base::StringAppendF(&result, "    Cost: %.2f\n",
                         static_cast<float>(mCachedSetCreationCost) / displayArea);
+    base::StringAppendF(&result, "    Predicted: %zd used, %zd dropped\n",
+                        mPredictedCachedSetHitCount, mPredictedCachedSetMissCount);
+    mTexturePool.dump(result);
 
     const auto lastUpdate =
             std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastGeometryUpdate);
@@ -249,6 +267,9 @@ void Flattener::resetActivities(NonBufferHash hash, time_point now) {
 
     if (mNewCachedSet) {
         ++mInvalidatedCachedSetAges[mNewCachedSet->getAge()];
+        if (mNewCachedSetIsPredicted) {
+            ++mPredictedCachedSetMissCount;
+        }
         mNewCachedSet = std::nullopt;
     }
 }
@@ -308,9 +329,15 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
             if (mNewCachedSet->hasBufferUpdate()) {
                 ALOGV("[%s] Dropping new cached set", __func__);
                 ++mInvalidatedCachedSetAges[0];
+                if (mNewCachedSetIsPredicted) {
+                    ++mPredictedCachedSetMissCount;
+                }
                 mNewCachedSet = std::nullopt;
             } else if (mNewCachedSet->hasReadyBuffer()) {
                 ALOGV("[%s] Found ready buffer", __func__);
+                if (mNewCachedSetIsPredicted) {
+                    ++mPredictedCachedSetHitCount;
+                }
                 size_t skipCount = mNewCachedSet->getLayerCount();
                 while (skipCount != 0) {
                     auto* peekThroughLayer = mNewCachedSet->getHolePunchLayer();
@@ -408,7 +435,8 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
     return true;
 }
 
-std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
+std::vector<Flattener::Run> Flattener::findCandidateRuns(
+        time_point now, std::chrono::nanoseconds activeLayerTimeout) const {
     ATRACE_CALL();
     std::vector<Run> runs;
     bool isPartOfRun = false;
@@ -417,7 +445,7 @@ std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
     bool runHasFirstLayer = false;
 
     for (auto currentSet = mLayers.cbegin(); currentSet != mLayers.cend(); ++currentSet) {
-        const bool layerIsInactive = now - currentSet->getLastUpdate() > mActiveLayerTimeout;
+        const bool layerIsInactive = now - currentSet->getLastUpdate() > activeLayerTimeout;
         const bool layerHasBlur = currentSet->hasBlurBehind();
         if (layerIsInactive && (firstLayer || runHasFirstLayer || !layerHasBlur) &&
             !currentSet->hasUnsupportedDataspace()) {
@@ -479,7 +507,7 @@ std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>
     return runs[0];
 }
 
-void Flattener::buildCachedSets(time_point now) {
+void Flattener::buildCachedSets(time_point now, bool isPredictedStack) {
     ATRACE_CALL();
     if (mLayers.empty()) {
         ALOGV("[%s] No layers found, returning", __func__);
@@ -499,10 +527,19 @@ void Flattener::buildCachedSets(time_point now) {
         }
     }
 
-    std::vector<Run> runs = findCandidateRuns(now);
+    std::vector<Run> runs = findCandidateRuns(now, mActiveLayerTimeout);
 
     std::optional<Run> bestRun = findBestRun(runs);
 
+    // If the stack is expected to settle, flatten it before its layers time out, so that the
+    // cached set is rendered while RenderEngine is idle, and used as soon as it is ready.
+    mNewCachedSetIsPredicted = false;
+    if (!bestRun && isPredictedStack && mPredictedActiveLayerTimeout < mActiveLayerTimeout) {
+        runs = findCandidateRuns(now, mPredictedActiveLayerTimeout);
+        bestRun = findBestRun(runs);
+        mNewCachedSetIsPredicted = bestRun.has_value();
+    }
+
     if (!bestRun) {
         return;
     }
@@ -123,8 +123,10 @@ void Planner::plan(
                    });
 
     const NonBufferHash hash = getNonBufferHash(mCurrentLayers);
-    mFlattenedHash =
-            mFlattener.flattenLayers(mCurrentLayers, hash, std::chrono::steady_clock::now());
+    // A stack that keeps coming back with the same plan is likely to settle again
+    const bool isPredictedStack = mPredictorEnabled && mPredictor.isConfidentExactMatch(hash);
+    mFlattenedHash = mFlattener.flattenLayers(mCurrentLayers, hash,
+                                              std::chrono::steady_clock::now(), isPredictedStack);
     const bool layersWereFlattened = hash != mFlattenedHash;
 
     ALOGV("[%s] Initial hash %zx flattened hash %zx", __func__, hash, mFlattenedHash);
@@ -191,6 +193,10 @@ void Planner::reportFinalPlan(
                             finalPlan);
 }
 
+void Planner::releaseTextures() {
+    mFlattener.releaseTextures();
+}
+
 void Planner::renderCachedSets(
         const OutputCompositionState& outputState,
         std::optional<std::chrono::steady_clock::time_point> renderDeadline) {
@@ -177,6 +177,18 @@ std::optional<Predictor::PredictedPlan> Predictor::getPredictedPlan(
     return std::nullopt;
 }
 
+bool Predictor::isConfidentExactMatch(NonBufferHash hash) const {
+    // Candidates have not been seen often enough, so only check the promoted predictions
+    const auto predictionEntry = mPredictions.find(hash);
+    if (predictionEntry == mPredictions.end()) {
+        return false;
+    }
+
+    const auto& [_, prediction] = *predictionEntry;
+    return prediction.getMissCount(Prediction::Type::Exact) == 0 &&
+            prediction.getHitCount(Prediction::Type::Exact) >= MIN_HITS_FOR_CONFIDENT_MATCH;
+}
+
 void Predictor::recordResult(std::optional<PredictedPlan> predictedPlan,
                              NonBufferHash flattenedHash,
                              const std::vector<const LayerState*>& layers, bool hasSkippedLayers,
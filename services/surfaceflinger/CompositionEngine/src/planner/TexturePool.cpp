@@ -19,6 +19,7 @@
 #undef LOG_TAG
 #define LOG_TAG "Planner"
 
+#include <android-base/stringprintf.h>
 #include <compositionengine/impl/planner/TexturePool.h>
 #include <utils/Log.h>
 
@@ -31,19 +32,49 @@ void TexturePool::setDisplaySize(ui::Size size) {
     mSize = size;
     mPool.clear();
     mPool.resize(kMinPoolSize);
-    std::generate_n(mPool.begin(), kMinPoolSize, [&]() { return Entry{genTexture(), nullptr}; });
+    const auto now = std::chrono::steady_clock::now();
+    std::generate_n(mPool.begin(), kMinPoolSize,
+                    [&]() { return Entry{genTexture(), nullptr, now}; });
 }
 
 std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
     if (mPool.empty()) {
+        // Keep one more texture around next time, as the current pool is too small for the demand.
+        ++mMissCount;
+        mTargetPoolSize = std::min(mTargetPoolSize + 1, kMaxPoolSize);
         return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
     }
 
+    ++mHitCount;
     const auto entry = mPool.front();
     mPool.pop_front();
     return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
 }
 
+void TexturePool::releaseIdleTextures(std::chrono::steady_clock::time_point now,
+                                      std::chrono::nanoseconds idleTimeout) {
+    // Textures are returned to the back, so the least recently used ones are at the front.
+    while (!mPool.empty() && now - mPool.front().lastUsed > idleTimeout) {
+        ALOGV("Deallocating texture from Planner's pool - idle");
+        mPool.pop_front();
+        ++mReleasedCount;
+        mTargetPoolSize = kMinPoolSize;
+    }
+}
+
+void TexturePool::releaseTextures() {
+    mReleasedCount += mPool.size();
+    mPool.clear();
+    mTargetPoolSize = kMinPoolSize;
+}
+
+void TexturePool::dump(std::string& result) const {
+    base::StringAppendF(&result,
+                        "    Texture pool: %zu textures (retaining up to %zu), %zu hits, %zu misses, "
+                        "%zu released\n",
+                        mPool.size(), mTargetPoolSize, mHitCount, mMissCount, mReleasedCount);
+}
+
 void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
                                 const sp<Fence>& fence) {
     // Drop the texture on the floor if the pool is no longer tracking textures of the same size.
@@ -56,14 +87,14 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
         return;
     }
 
-    // Also ensure the pool does not grow beyond a maximum size.
-    if (mPool.size() == kMaxPoolSize) {
-        ALOGD("Deallocating texture from Planner's pool - max size [%" PRIu64 "] reached",
-              static_cast<uint64_t>(kMaxPoolSize));
+    // Also ensure the pool does not grow beyond the size the demand has required.
+    if (mPool.size() >= mTargetPoolSize) {
+        ALOGD("Deallocating texture from Planner's pool - target size [%" PRIu64 "] reached",
+              static_cast<uint64_t>(mTargetPoolSize));
         return;
     }
 
-    mPool.push_back({std::move(texture), fence});
+    mPool.push_back({std::move(texture), fence, std::chrono::steady_clock::now()});
 }
 
 std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
@@ -78,7 +109,8 @@ std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
                                                         "Planner"),
                                            mRenderEngine,
                                            renderengine::ExternalTexture::Usage::READABLE |
-                                                   renderengine::ExternalTexture::Usage::WRITEABLE);
+                                                   renderengine::ExternalTexture::Usage::WRITEABLE,
+                                           renderengine::ExternalTexture::Owner::CACHED_SET);
 }
 
 } // namespace android::compositionengine::impl::planner
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/ClientCompositionDamage.h>
+#include <compositionengine/mock/LayerFE.h>
+#include <gtest/gtest.h>
+
+#include "RegionMatcher.h"
+
+namespace android::compositionengine {
+namespace {
+
+using testing::StrictMock;
+
+const Rect kViewport{0, 0, 100, 200};
+const Region kDamage{Rect{10, 10, 20, 20}};
+const Region kOtherDamage{Rect{50, 50, 60, 60}};
+
+class ClientCompositionDamageTest : public testing::Test {
+public:
+    ClientCompositionDamageTest() {
+        mDisplay.clip = kViewport;
+        mLayers = {{.layerFE = mLayerFE, .clientComposition = true}};
+    }
+
+    Region onFrame(const Region& damage, int32_t bufferAge) {
+        return mDamage.onFrame(mDisplay, mLayers, damage, bufferAge);
+    }
+
+    sp<mock::LayerFE> mLayerFE = new StrictMock<mock::LayerFE>();
+    renderengine::DisplaySettings mDisplay;
+    std::vector<impl::ClientCompositionDamage::Layer> mLayers;
+    impl::ClientCompositionDamage mDamage;
+};
+
+TEST_F(ClientCompositionDamageTest, drawsFirstFrameInFull) {
+    EXPECT_TRUE(onFrame(kDamage, 1).isEmpty());
+}
+
+TEST_F(ClientCompositionDamageTest, drawsDamageIntoBufferHoldingLastFrame) {
+    onFrame(kDamage, 0);
+    EXPECT_THAT(onFrame(kOtherDamage, 1), RegionEq(kOtherDamage));
+}
+
+TEST_F(ClientCompositionDamageTest, drawsDamageSinceBufferWasDrawn) {
+    onFrame(Region(kViewport), 0);
+    onFrame(kDamage, 0);
+    EXPECT_THAT(onFrame(kOtherDamage, 2), RegionEq(kDamage.merge(kOtherDamage)));
+}
+
+TEST_F(ClientCompositionDamageTest, drawsInFullForUnknownOrOldBuffer) {
+    for (int i = 0; i < 8; i++) {
+        onFrame(kDamage, 0);
+    }
+    EXPECT_TRUE(onFrame(kDamage, 0).isEmpty());
+    EXPECT_TRUE(onFrame(kDamage, 8).isEmpty());
+}
+
+TEST_F(ClientCompositionDamageTest, clipsDamageToViewport) {
+    onFrame(kDamage, 0);
+    EXPECT_THAT(onFrame(Region(Rect{90, 190, 110, 210}), 1),
+                RegionEq(Region(Rect{90, 190, 100, 200})));
+}
+
+TEST_F(ClientCompositionDamageTest, drawsInFullIfLayersChanged) {
+    onFrame(kDamage, 0);
+    mLayers[0].clientComposition = false;
+    EXPECT_TRUE(onFrame(kDamage, 1).isEmpty());
+
+    // The buffer holding the frame before the change misses more than the damage.
+    onFrame(kDamage, 1);
+    EXPECT_TRUE(onFrame(kDamage, 3).isEmpty());
+    EXPECT_THAT(onFrame(kDamage, 2), RegionEq(kDamage));
+}
+
+TEST_F(ClientCompositionDamageTest, drawsInFullIfDisplayChanged) {
+    onFrame(kDamage, 0);
+    mDisplay.outputDataspace = ui::Dataspace::DISPLAY_P3;
+    EXPECT_TRUE(onFrame(kDamage, 1).isEmpty());
+}
+
+TEST_F(ClientCompositionDamageTest, drawsInFullAfterInvalidate) {
+    onFrame(kDamage, 0);
+    mDamage.invalidate();
+    EXPECT_TRUE(onFrame(kDamage, 1).isEmpty());
+    EXPECT_THAT(onFrame(kDamage, 1), RegionEq(kDamage));
+}
+
+} // namespace
+} // namespace android::compositionengine
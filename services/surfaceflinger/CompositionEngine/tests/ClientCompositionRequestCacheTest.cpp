@@ -0,0 +1,117 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using MissReason = impl::ClientCompositionRequestCache::MissReason;
+
+constexpr uint64_t kBufferId = 1;
+constexpr uint64_t kOtherBufferId = 2;
+
+class ClientCompositionRequestCacheTest : public testing::Test {
+public:
+    ClientCompositionRequestCacheTest() {
+        mDisplay.clip = Rect(100, 200);
+        LayerFE::LayerSettings layer;
+        layer.geometry.boundaries = FloatRect(10.f, 10.f, 50.f, 50.f);
+        layer.alpha = 0.5f;
+        layer.bufferId = 3;
+        layer.frameNumber = 4;
+        mLayers = {layer};
+    }
+
+    bool exists(uint64_t bufferId = kBufferId) {
+        return mCache.exists(bufferId, mDisplay, mLayers);
+    }
+
+    void add(uint64_t bufferId = kBufferId) { mCache.add(bufferId, mDisplay, mLayers); }
+
+    renderengine::DisplaySettings mDisplay;
+    std::vector<LayerFE::LayerSettings> mLayers;
+    impl::ClientCompositionRequestCache mCache{2};
+};
+
+TEST_F(ClientCompositionRequestCacheTest, findsRequestRenderedIntoBuffer) {
+    EXPECT_FALSE(exists());
+    add();
+    EXPECT_TRUE(exists());
+    EXPECT_FALSE(exists(kOtherBufferId));
+
+    EXPECT_EQ(1u, mCache.getHitCount());
+    EXPECT_EQ(2u, mCache.getMissCount(MissReason::NotCached));
+}
+
+TEST_F(ClientCompositionRequestCacheTest, ignoresChangesSmallerThanQuantization) {
+    add();
+    mLayers[0].geometry.boundaries.left += 0.0001f;
+    mLayers[0].alpha += 0.0001f;
+    EXPECT_TRUE(exists());
+}
+
+TEST_F(ClientCompositionRequestCacheTest, missesIfGeometryMoved) {
+    add();
+    mLayers[0].geometry.boundaries.left += 0.5f;
+    EXPECT_FALSE(exists());
+    EXPECT_EQ(1u, mCache.getMissCount(MissReason::LayersChanged));
+}
+
+TEST_F(ClientCompositionRequestCacheTest, missesIfAlphaOrBufferChanged) {
+    add();
+    mLayers[0].alpha = 0.6f;
+    EXPECT_FALSE(exists());
+
+    mLayers[0].alpha = 0.5f;
+    mLayers[0].frameNumber++;
+    EXPECT_FALSE(exists());
+    EXPECT_EQ(2u, mCache.getMissCount(MissReason::LayersChanged));
+}
+
+TEST_F(ClientCompositionRequestCacheTest, countsWhyRequestsMissed) {
+    add();
+    mDisplay.outputDataspace = ui::Dataspace::DISPLAY_P3;
+    EXPECT_FALSE(exists());
+    EXPECT_EQ(1u, mCache.getMissCount(MissReason::DisplayChanged));
+
+    mDisplay.outputDataspace = ui::Dataspace::UNKNOWN;
+    mLayers.push_back(mLayers[0]);
+    EXPECT_FALSE(exists());
+    EXPECT_EQ(1u, mCache.getMissCount(MissReason::LayerCountChanged));
+}
+
+TEST_F(ClientCompositionRequestCacheTest, evictsOldestRequest) {
+    add(kBufferId);
+    add(kOtherBufferId);
+    add(kOtherBufferId + 1);
+    EXPECT_FALSE(exists(kBufferId));
+    EXPECT_TRUE(exists(kOtherBufferId));
+
+    std::string dump;
+    mCache.dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("1 evictions"));
+}
+
+TEST_F(ClientCompositionRequestCacheTest, removeDropsRequest) {
+    add();
+    mCache.remove(kBufferId);
+    EXPECT_FALSE(exists());
+}
+
+} // namespace
+} // namespace android::compositionengine
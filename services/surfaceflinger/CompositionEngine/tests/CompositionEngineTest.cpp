@@ -32,6 +32,7 @@ namespace {
 using ::testing::_;
 using ::testing::DoAll;
 using ::testing::InSequence;
+using ::testing::Invoke;
 using ::testing::Ref;
 using ::testing::Return;
 using ::testing::ReturnRef;
@@ -123,6 +124,68 @@ TEST_F(CompositionEnginePresentTest, worksAsExpected) {
     mEngine.present(mRefreshArgs);
 }
 
+TEST_F(CompositionEnginePresentTest, preparesOutputsOnWorkerPool) {
+    WorkerPool workerPool(2);
+    sp<StrictMock<mock::LayerFE>> layer1 = sp<StrictMock<mock::LayerFE>>::make();
+    sp<StrictMock<mock::LayerFE>> layer2 = sp<StrictMock<mock::LayerFE>>::make();
+
+    EXPECT_CALL(mEngine, preComposition(Ref(mRefreshArgs)));
+
+    // Every layer is latched once, before any output is prepared, so that the
+    // outputs don't need to change latchedLayers.
+    auto expectAllLatched = [](const CompositionRefreshArgs&, LayerFESet& latchedLayers) {
+        EXPECT_EQ(2u, latchedLayers.size());
+    };
+    EXPECT_CALL(*layer1, prepareCompositionState(LayerFE::StateSubset::BasicGeometry));
+    EXPECT_CALL(*layer2, prepareCompositionState(LayerFE::StateSubset::BasicGeometry));
+    EXPECT_CALL(*mOutput1, prepare(Ref(mRefreshArgs), _)).WillOnce(Invoke(expectAllLatched));
+    EXPECT_CALL(*mOutput2, prepare(Ref(mRefreshArgs), _)).WillOnce(Invoke(expectAllLatched));
+    EXPECT_CALL(*mOutput3, prepare(Ref(mRefreshArgs), _)).WillOnce(Invoke(expectAllLatched));
+
+    EXPECT_CALL(*mOutput1, updateLayerStateFromFE(Ref(mRefreshArgs)));
+    EXPECT_CALL(*mOutput2, updateLayerStateFromFE(Ref(mRefreshArgs)));
+    EXPECT_CALL(*mOutput3, updateLayerStateFromFE(Ref(mRefreshArgs)));
+
+    EXPECT_CALL(*mOutput1, present(Ref(mRefreshArgs)));
+    EXPECT_CALL(*mOutput2, present(Ref(mRefreshArgs)));
+    EXPECT_CALL(*mOutput3, present(Ref(mRefreshArgs)));
+
+    mRefreshArgs.outputs = {mOutput1, mOutput2, mOutput3};
+    mRefreshArgs.layers = {layer1, layer2};
+    mRefreshArgs.updatingOutputGeometryThisFrame = true;
+    mRefreshArgs.workerPool = &workerPool;
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEnginePresentTest, presentsOutputsOnWorkerPool) {
+    WorkerPool workerPool(2);
+
+    EXPECT_CALL(mEngine, preComposition(Ref(mRefreshArgs)));
+
+    EXPECT_CALL(*mOutput1, prepare(Ref(mRefreshArgs), _));
+    EXPECT_CALL(*mOutput2, prepare(Ref(mRefreshArgs), _));
+
+    EXPECT_CALL(*mOutput1, updateLayerStateFromFE(Ref(mRefreshArgs)));
+    EXPECT_CALL(*mOutput2, updateLayerStateFromFE(Ref(mRefreshArgs)));
+
+    // The outputs are given the locks to serialize their HWC and RenderEngine
+    // work with.
+    auto expectLocks = [](const CompositionRefreshArgs& args) {
+        EXPECT_NE(nullptr, args.hwcMutex);
+        EXPECT_NE(nullptr, args.renderMutex);
+    };
+    EXPECT_CALL(*mOutput1, present(Ref(mRefreshArgs))).WillOnce(Invoke(expectLocks));
+    EXPECT_CALL(*mOutput2, present(Ref(mRefreshArgs))).WillOnce(Invoke(expectLocks));
+
+    mRefreshArgs.outputs = {mOutput1, mOutput2};
+    mRefreshArgs.workerPool = &workerPool;
+    mRefreshArgs.presentOutputsInParallel = true;
+    mEngine.present(mRefreshArgs);
+
+    EXPECT_EQ(nullptr, mRefreshArgs.hwcMutex);
+    EXPECT_EQ(nullptr, mRefreshArgs.renderMutex);
+}
+
 /*
  * CompositionEngine::updateCursorAsync
  */
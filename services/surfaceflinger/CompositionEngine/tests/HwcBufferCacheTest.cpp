@@ -82,5 +82,22 @@ TEST_F(HwcBufferCacheTest, cacheMapsNegativeSlotToZero) {
     testSlot(-123, 0);
 }
 
+TEST_F(HwcBufferCacheTest, clearSlotsSkipsActiveAndEmptySlots) {
+    uint32_t outSlot;
+    sp<GraphicBuffer> outBuffer;
+    mCache.getHwcBuffer(0, mBuffer1, &outSlot, &outBuffer);
+    mCache.getHwcBuffer(1, mBuffer2, &outSlot, &outBuffer);
+
+    EXPECT_EQ(std::vector<uint32_t>{0}, mCache.clearSlots({0, 1, 2}, 1));
+    // Cleared slots are empty, so they aren't cleared again.
+    EXPECT_EQ(std::vector<uint32_t>{}, mCache.clearSlots({0}, 1));
+
+    // The buffer of a cleared slot is sent again.
+    mCache.getHwcBuffer(0, mBuffer1, &outSlot, &outBuffer);
+    EXPECT_EQ(mBuffer1, outBuffer);
+    mCache.getHwcBuffer(1, mBuffer2, &outSlot, &outBuffer);
+    EXPECT_EQ(nullptr, outBuffer.get());
+}
+
 } // namespace
 } // namespace android::compositionengine
@@ -82,6 +82,11 @@ public:
     MOCK_METHOD4(setDisplayContentSamplingEnabled, status_t(HalDisplayId, bool, uint8_t, uint64_t));
     MOCK_METHOD4(getDisplayedContentSample,
                  status_t(HalDisplayId, uint64_t, uint64_t, DisplayedFrameStats*));
+    MOCK_METHOD3(getReadbackBufferAttributes,
+                 status_t(PhysicalDisplayId, ui::PixelFormat*, ui::Dataspace*));
+    MOCK_METHOD3(setReadbackBuffer,
+                 status_t(PhysicalDisplayId, const sp<GraphicBuffer>&, const sp<Fence>&));
+    MOCK_METHOD2(getReadbackBufferFence, status_t(PhysicalDisplayId, sp<Fence>*));
     MOCK_METHOD2(setDisplayBrightness, std::future<status_t>(PhysicalDisplayId, float));
     MOCK_METHOD2(getDisplayBrightnessSupport, status_t(PhysicalDisplayId, bool*));
 
@@ -1023,6 +1023,37 @@ TEST_F(OutputLayerWriteStateToHWCTest, compositionTypeIsNotSetIfUnchanged) {
                                  /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
 }
 
+TEST_F(OutputLayerWriteStateToHWCTest, writesBufferStateOnlyIfCompositionTypeUnchanged) {
+    (*mOutputLayer.editState().hwc).hwcCompositionType = Hwc2::IComposerClient::Composition::DEVICE;
+    mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
+
+    EXPECT_CALL(*mHwcLayer, setSurfaceDamage(RegionEq(kSurfaceDamage))).WillOnce(Return(kError));
+    expectSetHdrMetadataAndBufferCalls();
+    EXPECT_CALL(*mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+
+    EXPECT_TRUE(mOutputLayer.writeBufferStateOnlyToHWC());
+}
+
+TEST_F(OutputLayerWriteStateToHWCTest, doesNotWriteBufferStateOnlyIfCompositionTypeChanged) {
+    // The HWC switched the layer to client composition when validating.
+    (*mOutputLayer.editState().hwc).hwcCompositionType = Hwc2::IComposerClient::Composition::CLIENT;
+    mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
+
+    EXPECT_CALL(*mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+
+    EXPECT_FALSE(mOutputLayer.writeBufferStateOnlyToHWC());
+}
+
+TEST_F(OutputLayerWriteStateToHWCTest, doesNotWriteBufferStateOnlyIfOverridden) {
+    (*mOutputLayer.editState().hwc).hwcCompositionType = Hwc2::IComposerClient::Composition::DEVICE;
+    mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
+    includeOverrideInfo();
+
+    EXPECT_CALL(*mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+
+    EXPECT_FALSE(mOutputLayer.writeBufferStateOnlyToHWC());
+}
+
 TEST_F(OutputLayerWriteStateToHWCTest, compositionTypeIsSetToClientIfColorTransformNotSupported) {
     mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::SOLID_COLOR;
 
@@ -1109,6 +1140,51 @@ TEST_F(OutputLayerWriteStateToHWCTest, includesOverrideInfoIfPresent) {
                                  /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
 }
 
+TEST_F(OutputLayerWriteStateToHWCTest, clearsFreedBufferSlotsOtherThanActiveOne) {
+    mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
+    mLayerFEState.bufferSlotsToClear = {kExpectedHwcSlot, 1, 2};
+    uint32_t hwcSlot;
+    sp<GraphicBuffer> hwcBuffer;
+    mOutputLayer.editState().hwc->hwcBufferCache.getHwcBuffer(1, kOverrideBuffer, &hwcSlot,
+                                                              &hwcBuffer);
+
+    expectPerFrameCommonCalls();
+    expectSetHdrMetadataAndBufferCalls();
+    const uint32_t activeSlot = kExpectedHwcSlot;
+    EXPECT_CALL(*mHwcLayer, setBufferSlotsToClear(std::vector<uint32_t>{1}, activeSlot));
+    expectSetCompositionTypeCall(Hwc2::IComposerClient::Composition::DEVICE);
+    EXPECT_CALL(*mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+}
+
+TEST_F(OutputLayerWriteStateToHWCTest, setsBufferWithItsFenceAfterClearingSlots) {
+    mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
+    mLayerFEState.bufferSlotsToClear = {1};
+    const sp<Fence> acquireFence = sp<Fence>::make();
+    mLayerFEState.acquireFence = acquireFence;
+    uint32_t hwcSlot;
+    sp<GraphicBuffer> hwcBuffer;
+    mOutputLayer.editState().hwc->hwcBufferCache.getHwcBuffer(1, kOverrideBuffer, &hwcSlot,
+                                                              &hwcBuffer);
+
+    expectPerFrameCommonCalls();
+    EXPECT_CALL(*mHwcLayer, setPerFrameMetadata(kSupportedPerFrameMetadata, kHdrMetadata));
+    {
+        // Clearing selects the active slot again without a fence, so the buffer has to be set,
+        // with its acquire fence, last.
+        InSequence seq;
+        EXPECT_CALL(*mHwcLayer, setBufferSlotsToClear(std::vector<uint32_t>{1}, kExpectedHwcSlot));
+        EXPECT_CALL(*mHwcLayer, setBuffer(kExpectedHwcSlot, kBuffer, acquireFence));
+    }
+    expectSetCompositionTypeCall(Hwc2::IComposerClient::Composition::DEVICE);
+    EXPECT_CALL(*mLayerFE, hasRoundedCorners()).WillOnce(Return(false));
+
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+}
+
 TEST_F(OutputLayerWriteStateToHWCTest, previousOverriddenLayerSendsSurfaceDamage) {
     mLayerFEState.compositionType = Hwc2::IComposerClient::Composition::DEVICE;
     mOutputLayer.editState().hwc->stateOverridden = true;
@@ -16,6 +16,7 @@
 
 #include <android-base/stringprintf.h>
 #include <compositionengine/LayerFECompositionState.h>
+#include <compositionengine/WorkerPool.h>
 #include <compositionengine/impl/Output.h>
 #include <compositionengine/impl/OutputCompositionState.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
@@ -56,6 +57,7 @@ using testing::Property;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
+using testing::SaveArg;
 using testing::SetArgPointee;
 using testing::StrictMock;
 
@@ -891,6 +893,34 @@ TEST_F(OutputUpdateAndWriteCompositionStateTest, updatesLayerGeometryAndContentF
     mOutput->writeCompositionState(args);
 }
 
+TEST_F(OutputUpdateAndWriteCompositionStateTest, writesOnlyBuffersWhilePlannedLayersUnchanged) {
+    InjectedLayer layer1;
+    InjectedLayer layer2;
+
+    const auto kSize = ui::Size(1, 1);
+    EXPECT_CALL(*mRenderSurface, getSize()).WillRepeatedly(ReturnRef(kSize));
+    mOutput->setLayerCachingEnabled(true);
+    injectOutputLayer(layer1);
+    injectOutputLayer(layer2);
+    mOutput->editState().isEnabled = true;
+
+    // The first frame has nothing to compare against, and a layer whose HWC state needs more than
+    // its buffer is written in full.
+    EXPECT_CALL(*layer1.outputLayer,
+                writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0u,
+                                /*zIsOverridden*/ false, /*isPeekingThrough*/ false))
+            .Times(2);
+    EXPECT_CALL(*layer2.outputLayer,
+                writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 1u,
+                                /*zIsOverridden*/ false, /*isPeekingThrough*/ false));
+    EXPECT_CALL(*layer1.outputLayer, writeBufferStateOnlyToHWC()).WillOnce(Return(false));
+    EXPECT_CALL(*layer2.outputLayer, writeBufferStateOnlyToHWC()).WillOnce(Return(true));
+
+    CompositionRefreshArgs args;
+    mOutput->writeCompositionState(args);
+    mOutput->writeCompositionState(args);
+}
+
 TEST_F(OutputUpdateAndWriteCompositionStateTest, forcesClientCompositionForAllLayers) {
     InjectedLayer layer1;
     InjectedLayer layer2;
@@ -1792,6 +1822,37 @@ TEST_F(OutputPresentTest, justInvokesChildFunctionsInSequence) {
     mOutput.present(args);
 }
 
+TEST_F(OutputPresentTest, preparesFrameBeforeDequeuingWhenRenderSurfaceRequiresIt) {
+    mock::RenderSurface* renderSurface = new StrictMock<mock::RenderSurface>();
+    mOutput.setRenderSurfaceForTest(std::unique_ptr<RenderSurface>(renderSurface));
+    mOutput.editState().isEnabled = true;
+
+    WorkerPool workerPool(1);
+    CompositionRefreshArgs args;
+    args.workerPool = &workerPool;
+    args.predictClientComposition = true;
+
+    // A virtual display surface picks its buffer queue in prepareFrame, so no buffer is
+    // dequeued for a predicted client composition before it.
+    EXPECT_CALL(*renderSurface, canDequeueBeforePrepareFrame()).WillOnce(Return(false));
+    EXPECT_CALL(*renderSurface, dequeueBuffer(_)).Times(0);
+
+    InSequence seq;
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, setColorTransform(Ref(args)));
+    EXPECT_CALL(mOutput, beginFrame());
+    EXPECT_CALL(mOutput, prepareFrame());
+    EXPECT_CALL(mOutput, devOptRepaintFlash(Ref(args)));
+    EXPECT_CALL(mOutput, finishFrame(Ref(args)));
+    EXPECT_CALL(mOutput, postFramebuffer());
+    EXPECT_CALL(mOutput, renderCachedSets(Ref(args)));
+
+    mOutput.present(args);
+}
+
 /*
  * Output::updateColorProfile()
  */
@@ -3335,6 +3396,38 @@ TEST_F(OutputComposeSurfacesTest, clientCompositionIfRequestChanges) {
     EXPECT_FALSE(mOutput.mState.reusedClientComposition);
 }
 
+TEST_F(OutputComposeSurfacesTest, drawsOnlyDamageIfPartialClientCompositionEnabled) {
+    const Region kDamage{Rect{1005, 1006, 1006, 1007}};
+    mOutput.cacheClientCompositionRequests(0);
+    mOutput.setPartialClientCompositionEnabled(true);
+    mOutput.mState.dirtyRegion = kDamage;
+
+    EXPECT_CALL(mOutput, getSkipColorTransform()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplayColorProfile, hasWideColorGamut()).WillRepeatedly(Return(true));
+    EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mRenderEngine, isProtected()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mOutput, generateClientCompositionRequests(_, _, kDefaultOutputDataspace))
+            .WillRepeatedly(Return(std::vector<LayerFE::LayerSettings>{}));
+    EXPECT_CALL(mOutput, appendRegionFlashRequests(_, _)).WillRepeatedly(Return());
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+
+    EXPECT_CALL(*mRenderSurface, dequeueBuffer(_)).WillRepeatedly(Return(mOutputBuffer));
+    EXPECT_CALL(*mRenderSurface, getBufferAge()).WillRepeatedly(Return(1));
+
+    // The first frame is drawn in full, and the next one only where it is damaged.
+    renderengine::DisplaySettings firstDisplay;
+    renderengine::DisplaySettings secondDisplay;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, false, _, _))
+            .WillOnce(DoAll(SaveArg<0>(&firstDisplay), Return(NO_ERROR)))
+            .WillOnce(DoAll(SaveArg<0>(&secondDisplay), Return(NO_ERROR)));
+
+    mOutput.composeSurfaces(Region::INVALID_REGION, kDefaultRefreshArgs);
+    mOutput.composeSurfaces(Region::INVALID_REGION, kDefaultRefreshArgs);
+
+    EXPECT_TRUE(firstDisplay.damage.isEmpty());
+    EXPECT_THAT(secondDisplay.damage, RegionEq(kDamage));
+}
+
 struct OutputComposeSurfacesTest_UsesExpectedDisplaySettings : public OutputComposeSurfacesTest {
     OutputComposeSurfacesTest_UsesExpectedDisplaySettings() {
         EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
@@ -245,6 +245,23 @@ TEST_F(RenderSurfaceTest, dequeueBufferObtainsABuffer) {
     EXPECT_EQ(buffer.get(), mSurface.mutableTextureForTest()->getBuffer().get());
 }
 
+/*
+ * RenderSurface::getBufferAge()
+ */
+
+TEST_F(RenderSurfaceTest, getBufferAgeQueriesNativeWindow) {
+    EXPECT_CALL(*mNativeWindow, query(NATIVE_WINDOW_BUFFER_AGE, _))
+            .WillOnce(DoAll(SetArgPointee<1>(2), Return(NO_ERROR)));
+
+    EXPECT_EQ(2, mSurface.getBufferAge());
+}
+
+TEST_F(RenderSurfaceTest, getBufferAgeReturnsZeroIfQueryFails) {
+    EXPECT_CALL(*mNativeWindow, query(NATIVE_WINDOW_BUFFER_AGE, _)).WillOnce(Return(BAD_VALUE));
+
+    EXPECT_EQ(0, mSurface.getBufferAge());
+}
+
 /*
  * RenderSurface::queueBuffer()
  */
@@ -347,6 +364,44 @@ TEST_F(RenderSurfaceTest, queueBufferHandlesNativeWindowQueueBufferFailureOnVirt
     EXPECT_EQ(nullptr, mSurface.mutableTextureForTest().get());
 }
 
+/*
+ * RenderSurface::canDequeueBeforePrepareFrame()
+ */
+
+TEST_F(RenderSurfaceTest, canDequeueBeforePrepareFrameForPhysicalDisplay) {
+    EXPECT_CALL(mDisplay, isVirtual()).WillOnce(Return(false));
+
+    EXPECT_TRUE(mSurface.canDequeueBeforePrepareFrame());
+}
+
+TEST_F(RenderSurfaceTest, cannotDequeueBeforePrepareFrameForVirtualDisplay) {
+    EXPECT_CALL(mDisplay, isVirtual()).WillOnce(Return(true));
+
+    EXPECT_FALSE(mSurface.canDequeueBeforePrepareFrame());
+}
+
+/*
+ * RenderSurface::cancelBuffer()
+ */
+
+TEST_F(RenderSurfaceTest, cancelBufferReturnsDequeuedBuffer) {
+    const auto buffer = std::make_shared<
+            renderengine::ExternalTexture>(new GraphicBuffer(), mRenderEngine,
+                                           renderengine::ExternalTexture::Usage::WRITEABLE);
+    mSurface.mutableTextureForTest() = buffer;
+
+    EXPECT_CALL(*mNativeWindow, cancelBuffer(buffer->getBuffer()->getNativeBuffer(), -1))
+            .WillOnce(Return(NO_ERROR));
+
+    mSurface.cancelBuffer(base::unique_fd());
+
+    EXPECT_EQ(nullptr, mSurface.mutableTextureForTest().get());
+}
+
+TEST_F(RenderSurfaceTest, cancelBufferDoesNothingWithoutBuffer) {
+    mSurface.cancelBuffer(base::unique_fd());
+}
+
 /*
  * RenderSurface::onPresentDisplayCompleted()
  */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/WorkerPool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+namespace android::compositionengine {
+namespace {
+
+void expectEachIndexOnce(WorkerPool& pool, size_t count) {
+    std::vector<std::atomic<int>> calls(count);
+    pool.parallelFor(count, [&](size_t i) { calls[i]++; });
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(1, calls[i]) << "index " << i << " of " << count;
+    }
+}
+
+TEST(WorkerPoolTest, runsInlineWithoutThreads) {
+    WorkerPool pool(0);
+    EXPECT_EQ(0u, pool.getThreadCount());
+
+    const auto caller = std::this_thread::get_id();
+    pool.parallelFor(3, [&](size_t) { EXPECT_EQ(caller, std::this_thread::get_id()); });
+    expectEachIndexOnce(pool, 5);
+}
+
+TEST(WorkerPoolTest, runsEachIndexOnce) {
+    WorkerPool pool(3);
+    EXPECT_EQ(3u, pool.getThreadCount());
+
+    for (size_t count = 0; count < 50; count++) {
+        expectEachIndexOnce(pool, count);
+    }
+}
+
+TEST(WorkerPoolTest, usesWorkerThreads) {
+    WorkerPool pool(1);
+
+    // Each task waits for the other, which only the worker can run.
+    std::atomic<int> started = 0;
+    pool.parallelFor(2, [&](size_t) {
+        started++;
+        while (started < 2) {
+            std::this_thread::yield();
+        }
+    });
+    EXPECT_EQ(2, started);
+}
+
+} // namespace
+} // namespace android::compositionengine
@@ -237,6 +237,67 @@ TEST_F(FlattenerTest, flattenLayers_basicFlatten) {
     expectAllLayersFlattened(layers);
 }
 
+TEST_F(FlattenerTest, flattenLayers_predictedStackIsFlattenedEarly) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    auto& layerState2 = mTestLayers[1]->layerState;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // the layers are still active, but the layer stack is expected to settle
+    mTime += 100ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _, _, _)).WillOnce(Return(NO_ERROR));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime, true));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt);
+
+    initializeOverrideBuffer(layers);
+    EXPECT_NE(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime, true));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt);
+
+    const auto buffer = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+    EXPECT_NE(nullptr, buffer);
+    EXPECT_EQ(buffer, layerState2->getOutputLayer()->getState().overrideInfo.buffer);
+    EXPECT_EQ(1u, mFlattener->getPredictedCachedSetHitCountForTesting());
+    EXPECT_EQ(0u, mFlattener->getPredictedCachedSetMissCountForTesting());
+}
+
+TEST_F(FlattenerTest, flattenLayers_predictedCachedSetIsDroppedOnBufferUpdate) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    auto& layerState2 = mTestLayers[1]->layerState;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    mTime += 100ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _, _, _)).WillOnce(Return(NO_ERROR));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime, true));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt);
+
+    // the prediction was wrong, and layer 1 posted a buffer before the cached set was used
+    layerState1->resetFramesSinceBufferUpdate();
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime, true));
+
+    EXPECT_EQ(nullptr, layerState1->getOutputLayer()->getState().overrideInfo.buffer);
+    EXPECT_EQ(nullptr, layerState2->getOutputLayer()->getState().overrideInfo.buffer);
+    EXPECT_EQ(0u, mFlattener->getPredictedCachedSetHitCountForTesting());
+    EXPECT_EQ(1u, mFlattener->getPredictedCachedSetMissCountForTesting());
+}
+
 TEST_F(FlattenerTest, flattenLayers_FlattenedLayersStayFlattenWhenNoUpdate) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -546,5 +546,34 @@ TEST_F(PredictorTest, recordMissedPlan_skipsApproximateMatch) {
     EXPECT_FALSE(predictedPlanTwo);
 }
 
+TEST_F(PredictorTest, isConfidentExactMatch_requiresRepeatedExactHits) {
+    mock::OutputLayer outputLayerOne;
+    mock::LayerFE layerFEOne;
+    OutputLayerCompositionState outputLayerCompositionStateOne;
+    LayerFECompositionState layerFECompositionStateOne;
+    layerFECompositionStateOne.compositionType = hal::Composition::DEVICE;
+    setupMocksForLayer(outputLayerOne, layerFEOne, outputLayerCompositionStateOne,
+                       layerFECompositionStateOne);
+    LayerState layerStateOne(&outputLayerOne);
+
+    Plan plan;
+    plan.addLayerType(hal::Composition::DEVICE);
+
+    Predictor predictor;
+
+    NonBufferHash hash = getNonBufferHash({&layerStateOne});
+
+    predictor.recordResult(std::nullopt, hash, {&layerStateOne}, false, plan);
+    EXPECT_FALSE(predictor.isConfidentExactMatch(hash));
+
+    // A prediction needs 30 exact hits to be confident
+    for (size_t i = 0; i < 30; i++) {
+        EXPECT_FALSE(predictor.isConfidentExactMatch(hash));
+        auto predictedPlan = predictor.getPredictedPlan({}, hash);
+        predictor.recordResult(predictedPlan, hash, {&layerStateOne}, false, plan);
+    }
+    EXPECT_TRUE(predictor.isConfidentExactMatch(hash));
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
@@ -25,6 +25,8 @@
 namespace android::compositionengine::impl::planner {
 namespace {
 
+using namespace std::chrono_literals;
+
 const ui::Size kDisplaySize(1, 1);
 const ui::Size kDisplaySizeTwo(2, 2);
 
@@ -109,6 +111,39 @@ TEST_F(TexturePoolTest, goesPastMaxSizeAndRebounds) {
     EXPECT_EQ(mTexturePool.getMaxPoolSize(), newBufferIds.size());
 }
 
+TEST_F(TexturePoolTest, retainsMoreTexturesAfterMisses) {
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < mTexturePool.getMinPoolSize() + 1; i++) {
+        textures.emplace_back(mTexturePool.borrowTexture());
+    }
+
+    // The pool was starved, so it now keeps every returned texture.
+    textures.clear();
+    EXPECT_EQ(mTexturePool.getMinPoolSize() + 1, mTexturePool.getPoolSize());
+}
+
+TEST_F(TexturePoolTest, releasesIdleTextures) {
+    const auto now = std::chrono::steady_clock::now();
+
+    // Textures that were recently used are kept.
+    mTexturePool.releaseIdleTextures(now, 1s);
+    EXPECT_EQ(mTexturePool.getMinPoolSize(), mTexturePool.getPoolSize());
+
+    mTexturePool.releaseIdleTextures(now + 2s, 1s);
+    EXPECT_EQ(0u, mTexturePool.getPoolSize());
+
+    // A texture is allocated again when needed.
+    auto texture = mTexturePool.borrowTexture();
+    EXPECT_NE(nullptr, texture->get());
+    texture.reset();
+    EXPECT_EQ(1u, mTexturePool.getPoolSize());
+}
+
+TEST_F(TexturePoolTest, releasesAllTextures) {
+    mTexturePool.releaseTextures();
+    EXPECT_EQ(0u, mTexturePool.getPoolSize());
+}
+
 TEST_F(TexturePoolTest, reallocatesWhenDisplaySizeChanges) {
     auto texture = mTexturePool.borrowTexture();
 
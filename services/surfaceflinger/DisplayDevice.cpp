@@ -79,10 +79,16 @@ DisplayDevice::DisplayDevice(DisplayDeviceCreationArgs& args)
                             static_cast<size_t>(SurfaceFlinger::maxFrameBufferAcquiredBuffers))
                     .build());
 
-    if (!mFlinger->mDisableClientCompositionCache &&
-        SurfaceFlinger::maxFrameBufferAcquiredBuffers > 0) {
+    const int64_t clientCompositionCacheSize = mFlinger->mClientCompositionCacheSize > 0
+            ? mFlinger->mClientCompositionCacheSize
+            : SurfaceFlinger::maxFrameBufferAcquiredBuffers;
+    if (!mFlinger->mDisableClientCompositionCache && clientCompositionCacheSize > 0) {
         mCompositionDisplay->createClientCompositionCache(
-                static_cast<uint32_t>(SurfaceFlinger::maxFrameBufferAcquiredBuffers));
+                static_cast<uint32_t>(clientCompositionCacheSize));
+    }
+
+    if (mFlinger->mPartialClientComposition) {
+        mCompositionDisplay->setPartialClientCompositionEnabled(true);
     }
 
     mCompositionDisplay->createDisplayColorProfile(
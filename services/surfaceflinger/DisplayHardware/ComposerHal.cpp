@@ -159,6 +159,16 @@ Composer::Composer(const std::string& serviceName) : mWriter(kWriterInitialSize)
     if (mClient == nullptr) {
         LOG_ALWAYS_FATAL("failed to create composer client");
     }
+
+    mClearSlotBuffer = sp<GraphicBuffer>::make(1, 1, PIXEL_FORMAT_RGBX_8888,
+                                               GraphicBuffer::USAGE_HW_COMPOSER |
+                                                       GraphicBuffer::USAGE_SW_READ_OFTEN |
+                                                       GraphicBuffer::USAGE_SW_WRITE_OFTEN,
+                                               "Composer::mClearSlotBuffer");
+    if (mClearSlotBuffer->initCheck() != NO_ERROR) {
+        ALOGE("failed to allocate the buffer to clear layer buffer slots with");
+        mClearSlotBuffer = nullptr;
+    }
 }
 
 Composer::~Composer() = default;
@@ -648,6 +658,22 @@ Error Composer::setLayerBuffer(Display display, Layer layer,
     return Error::NONE;
 }
 
+Error Composer::setLayerBufferSlotsToClear(Display display, Layer layer,
+                                           const std::vector<uint32_t>& slotsToClear,
+                                           uint32_t activeBufferSlot) {
+    if (slotsToClear.empty() || mClearSlotBuffer == nullptr) {
+        return Error::NONE;
+    }
+    mWriter.selectDisplay(display);
+    mWriter.selectLayer(layer);
+    for (uint32_t slot : slotsToClear) {
+        mWriter.setLayerBuffer(slot, mClearSlotBuffer->getNativeBuffer()->handle, -1);
+    }
+    // Sets the active buffer back, which is still in its slot.
+    mWriter.setLayerBuffer(activeBufferSlot, nullptr, -1);
+    return Error::NONE;
+}
+
 Error Composer::setLayerSurfaceDamage(Display display, Layer layer,
         const std::vector<IComposerClient::Rect>& damage)
 {
@@ -951,6 +977,74 @@ Error Composer::getDataspaceSaturationMatrix(Dataspace dataspace, mat4* outMatri
     return error;
 }
 
+Error Composer::getReadbackBufferAttributes(Display display, PixelFormat* outFormat,
+                                            Dataspace* outDataspace) {
+    if (!outFormat || !outDataspace) {
+        return Error::BAD_PARAMETER;
+    }
+
+    Error error = kDefaultError;
+    if (mClient_2_3) {
+        mClient_2_3->getReadbackBufferAttributes_2_3(display,
+                                                     [&](const auto tmpError,
+                                                         const auto& tmpFormat,
+                                                         const auto& tmpDataspace) {
+                                                         error = tmpError;
+                                                         if (error == Error::NONE) {
+                                                             *outFormat = tmpFormat;
+                                                             *outDataspace = tmpDataspace;
+                                                         }
+                                                     });
+    } else if (mClient_2_2) {
+        mClient_2_2->getReadbackBufferAttributes(display,
+                                                 [&](const auto tmpError, const auto& tmpFormat,
+                                                     const auto& tmpDataspace) {
+                                                     error = tmpError;
+                                                     if (error == Error::NONE) {
+                                                         *outFormat = static_cast<PixelFormat>(
+                                                                 tmpFormat);
+                                                         *outDataspace =
+                                                                 static_cast<Dataspace>(
+                                                                         tmpDataspace);
+                                                     }
+                                                 });
+    } else {
+        return Error::UNSUPPORTED;
+    }
+
+    return error;
+}
+
+Error Composer::setReadbackBuffer(Display display, const native_handle_t* buffer,
+                                  int releaseFence) {
+    if (!mClient_2_2) {
+        return Error::UNSUPPORTED;
+    }
+
+    // The fence is only borrowed for the call, the caller keeps owning it.
+    const FenceHandle fence(releaseFence, false);
+    return mClient_2_2->setReadbackBuffer(display, BufferHandle(buffer), fence);
+}
+
+Error Composer::getReadbackBufferFence(Display display, int* outFence) {
+    if (!mClient_2_2) {
+        return Error::UNSUPPORTED;
+    }
+
+    Error error = kDefaultError;
+    mClient_2_2->getReadbackBufferFence(display, [&](const auto tmpError, const auto& tmpFence) {
+        error = tmpError;
+        if (error != Error::NONE) {
+            return;
+        }
+        // The handle is only valid for the duration of the callback.
+        const native_handle_t* fenceHandle = tmpFence.getNativeHandle();
+        *outFence = (fenceHandle && fenceHandle->numFds == 1) ? dup(fenceHandle->data[0]) : -1;
+    });
+
+    return error;
+}
+
 // Composer HAL 2.3
 
 Error Composer::getDisplayIdentificationData(Display display, uint8_t* outPort,
@@ -633,6 +633,17 @@ Error Layer::setBuffer(uint32_t slot, const sp<GraphicBuffer>& buffer,
     return static_cast<Error>(intError);
 }
 
+Error Layer::setBufferSlotsToClear(const std::vector<uint32_t>& slotsToClear,
+                                   uint32_t activeBufferSlot) {
+    if (CC_UNLIKELY(!mDisplay)) {
+        return Error::BAD_DISPLAY;
+    }
+
+    auto intError = mComposer.setLayerBufferSlotsToClear(mDisplay->getId(), mId, slotsToClear,
+                                                         activeBufferSlot);
+    return static_cast<Error>(intError);
+}
+
 Error Layer::setSurfaceDamage(const Region& damage)
 {
     if (CC_UNLIKELY(!mDisplay)) {
@@ -673,8 +684,13 @@ Error Layer::setBlendMode(BlendMode mode)
         return Error::BAD_DISPLAY;
     }
 
+    if (mBlendMode == mode) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBlendMode(mDisplay->getId(), mId, mode);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mBlendMode = error == Error::NONE ? std::make_optional(mode) : std::nullopt;
+    return error;
 }
 
 Error Layer::setColor(Color color) {
@@ -682,8 +698,13 @@ Error Layer::setColor(Color color) {
         return Error::BAD_DISPLAY;
     }
 
+    if (mColor == color) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerColor(mDisplay->getId(), mId, color);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mColor = error == Error::NONE ? std::make_optional(color) : std::nullopt;
+    return error;
 }
 
 Error Layer::setCompositionType(Composition type)
@@ -783,10 +804,15 @@ Error Layer::setDisplayFrame(const Rect& frame)
         return Error::BAD_DISPLAY;
     }
 
+    if (mDisplayFrame == frame) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::Rect hwcRect{frame.left, frame.top,
         frame.right, frame.bottom};
     auto intError = mComposer.setLayerDisplayFrame(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mDisplayFrame = error == Error::NONE ? std::make_optional(frame) : std::nullopt;
+    return error;
 }
 
 Error Layer::setPlaneAlpha(float alpha)
@@ -795,8 +821,13 @@ Error Layer::setPlaneAlpha(float alpha)
         return Error::BAD_DISPLAY;
     }
 
+    if (mPlaneAlpha == alpha) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerPlaneAlpha(mDisplay->getId(), mId, alpha);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mPlaneAlpha = error == Error::NONE ? std::make_optional(alpha) : std::nullopt;
+    return error;
 }
 
 Error Layer::setSidebandStream(const native_handle_t* stream)
@@ -820,10 +851,15 @@ Error Layer::setSourceCrop(const FloatRect& crop)
         return Error::BAD_DISPLAY;
     }
 
+    if (mSourceCrop == crop) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::FRect hwcRect{
         crop.left, crop.top, crop.right, crop.bottom};
     auto intError = mComposer.setLayerSourceCrop(mDisplay->getId(), mId, hwcRect);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mSourceCrop = error == Error::NONE ? std::make_optional(crop) : std::nullopt;
+    return error;
 }
 
 Error Layer::setTransform(Transform transform)
@@ -832,9 +868,14 @@ Error Layer::setTransform(Transform transform)
         return Error::BAD_DISPLAY;
     }
 
+    if (mTransform == transform) {
+        return Error::NONE;
+    }
     auto intTransform = static_cast<Hwc2::Transform>(transform);
     auto intError = mComposer.setLayerTransform(mDisplay->getId(), mId, intTransform);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mTransform = error == Error::NONE ? std::make_optional(transform) : std::nullopt;
+    return error;
 }
 
 Error Layer::setVisibleRegion(const Region& region)
@@ -868,8 +909,13 @@ Error Layer::setZOrder(uint32_t z)
         return Error::BAD_DISPLAY;
     }
 
+    if (mZOrder == z) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerZOrder(mDisplay->getId(), mId, z);
-    return static_cast<Error>(intError);
+    Error error = static_cast<Error>(intError);
+    mZOrder = error == Error::NONE ? std::make_optional(z) : std::nullopt;
+    return error;
 }
 
 // Composer HAL 2.3
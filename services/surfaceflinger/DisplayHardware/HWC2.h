@@ -28,6 +28,7 @@
 
 #include <functional>
 #include <future>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -259,6 +260,8 @@ public:
     [[clang::warn_unused_result]] virtual hal::Error setBuffer(
             uint32_t slot, const android::sp<android::GraphicBuffer>& buffer,
             const android::sp<android::Fence>& acquireFence) = 0;
+    [[clang::warn_unused_result]] virtual hal::Error setBufferSlotsToClear(
+            const std::vector<uint32_t>& slotsToClear, uint32_t activeBufferSlot) = 0;
     [[clang::warn_unused_result]] virtual hal::Error setSurfaceDamage(
             const android::Region& damage) = 0;
 
@@ -307,6 +310,8 @@ public:
     hal::Error setCursorPosition(int32_t x, int32_t y) override;
     hal::Error setBuffer(uint32_t slot, const android::sp<android::GraphicBuffer>& buffer,
                          const android::sp<android::Fence>& acquireFence) override;
+    hal::Error setBufferSlotsToClear(const std::vector<uint32_t>& slotsToClear,
+                                     uint32_t activeBufferSlot) override;
     hal::Error setSurfaceDamage(const android::Region& damage) override;
 
     hal::Error setBlendMode(hal::BlendMode mode) override;
@@ -348,6 +353,14 @@ private:
     android::HdrMetadata mHdrMetadata;
     android::mat4 mColorMatrix;
     uint32_t mBufferSlot;
+    // The composition type isn't cached, as the device may change it when validating.
+    std::optional<hal::BlendMode> mBlendMode;
+    std::optional<hal::Color> mColor;
+    std::optional<android::Rect> mDisplayFrame;
+    std::optional<float> mPlaneAlpha;
+    std::optional<android::FloatRect> mSourceCrop;
+    std::optional<hal::Transform> mTransform;
+    std::optional<uint32_t> mZOrder;
 };
 
 } // namespace impl
@@ -26,6 +26,8 @@
 
 #include "HWComposer.h"
 
+#include <algorithm>
+
 #include <android-base/properties.h>
 #include <compositionengine/Output.h>
 #include <compositionengine/OutputLayer.h>
@@ -331,11 +333,21 @@ bool HWComposer::isConnected(PhysicalDisplayId displayId) const {
 std::vector<HWComposer::HWCDisplayMode> HWComposer::getModes(PhysicalDisplayId displayId) const {
     RETURN_IF_INVALID_DISPLAY(displayId, {});
 
-    const auto hwcDisplayId = mDisplayData.at(displayId).hwcDisplay->getId();
+    const auto& displayData = mDisplayData.at(displayId);
+    const auto hwcDisplayId = displayData.hwcDisplay->getId();
     std::vector<hal::HWConfigId> configIds;
     auto error = static_cast<hal::Error>(mComposer->getDisplayConfigs(hwcDisplayId, &configIds));
     RETURN_IF_HWC_ERROR_FOR("getDisplayConfigs", error, *toPhysicalDisplayId(hwcDisplayId), {});
 
+    // Configs only change on hotplug, so a monitor with the same EDID reporting the same configs
+    // on a new connection is taken to have the same modes as before.
+    const auto& identificationData = displayData.identificationData;
+    if (const auto it = mCachedModes.find(displayId); it != mCachedModes.end() &&
+        !identificationData.empty() && it->second.identificationData == identificationData &&
+        it->second.configIds == configIds) {
+        return it->second.modes;
+    }
+
     std::vector<HWCDisplayMode> modes;
     modes.reserve(configIds.size());
     for (auto configId : configIds) {
@@ -350,6 +362,12 @@ std::vector<HWComposer::HWCDisplayMode> HWComposer::getModes(PhysicalDisplayId d
         });
     }
 
+    const bool isComplete = std::all_of(modes.begin(), modes.end(), [](const auto& mode) {
+        return mode.width >= 0 && mode.height >= 0 && mode.vsyncPeriod >= 0;
+    });
+    if (!identificationData.empty() && isComplete) {
+        mCachedModes[displayId] = CachedModes{identificationData, configIds, modes};
+    }
     return modes;
 }
 
@@ -784,6 +802,43 @@ status_t HWComposer::getDisplayedContentSample(HalDisplayId displayId, uint64_t
     return NO_ERROR;
 }
 
+status_t HWComposer::getReadbackBufferAttributes(PhysicalDisplayId displayId,
+                                                 ui::PixelFormat* outFormat,
+                                                 ui::Dataspace* outDataspace) {
+    RETURN_IF_INVALID_DISPLAY(displayId, BAD_INDEX);
+    const auto hwcId = *fromPhysicalDisplayId(displayId);
+    const auto error = static_cast<hal::Error>(
+            mComposer->getReadbackBufferAttributes(hwcId, outFormat, outDataspace));
+    // Not logged, since it is asked for each screen capture and most composers lack readback.
+    if (error == hal::Error::UNSUPPORTED) return INVALID_OPERATION;
+    RETURN_IF_HWC_ERROR(error, displayId, UNKNOWN_ERROR);
+    return NO_ERROR;
+}
+
+status_t HWComposer::setReadbackBuffer(PhysicalDisplayId displayId,
+                                       const sp<GraphicBuffer>& buffer,
+                                       const sp<Fence>& releaseFence) {
+    RETURN_IF_INVALID_DISPLAY(displayId, BAD_INDEX);
+    const auto hwcId = *fromPhysicalDisplayId(displayId);
+    const native_handle_t* handle = buffer ? buffer->getNativeBuffer()->handle : nullptr;
+    const int fenceFd = releaseFence ? releaseFence->get() : -1;
+    const auto error =
+            static_cast<hal::Error>(mComposer->setReadbackBuffer(hwcId, handle, fenceFd));
+    RETURN_IF_HWC_ERROR(error, displayId, UNKNOWN_ERROR);
+    return NO_ERROR;
+}
+
+status_t HWComposer::getReadbackBufferFence(PhysicalDisplayId displayId, sp<Fence>* outFence) {
+    RETURN_IF_INVALID_DISPLAY(displayId, BAD_INDEX);
+    const auto hwcId = *fromPhysicalDisplayId(displayId);
+    int fenceFd = -1;
+    const auto error =
+            static_cast<hal::Error>(mComposer->getReadbackBufferFence(hwcId, &fenceFd));
+    RETURN_IF_HWC_ERROR(error, displayId, UNKNOWN_ERROR);
+    *outFence = fenceFd >= 0 ? sp<Fence>::make(fenceFd) : Fence::NO_FENCE;
+    return NO_ERROR;
+}
+
 std::future<status_t> HWComposer::setDisplayBrightness(PhysicalDisplayId displayId,
                                                        float brightness) {
     RETURN_IF_INVALID_DISPLAY(displayId, ftl::yield<status_t>(BAD_INDEX));
@@ -885,6 +940,7 @@ bool HWComposer::shouldIgnoreHotplugConnect(hal::HWDisplayId hwcDisplayId,
 std::optional<DisplayIdentificationInfo> HWComposer::onHotplugConnect(
         hal::HWDisplayId hwcDisplayId) {
     std::optional<DisplayIdentificationInfo> info;
+    DisplayIdentificationData identificationData;
     if (const auto displayId = toPhysicalDisplayId(hwcDisplayId)) {
         info = DisplayIdentificationInfo{.id = *displayId,
                                          .name = std::string(),
@@ -895,6 +951,9 @@ std::optional<DisplayIdentificationInfo> HWComposer::onHotplugConnect(
             getDisplayIdentificationData(hwcDisplayId, &port, &data);
             if (auto newInfo = parseDisplayIdentificationData(port, data)) {
                 info->deviceProductInfo = std::move(newInfo->deviceProductInfo);
+                if (newInfo->id == info->id) {
+                    identificationData = std::move(data);
+                }
             } else {
                 ALOGE("Failed to parse identification data for display %" PRIu64, hwcDisplayId);
             }
@@ -914,10 +973,12 @@ std::optional<DisplayIdentificationInfo> HWComposer::onHotplugConnect(
             return {};
         }
 
-        info = [this, hwcDisplayId, &port, &data, hasDisplayIdentificationData] {
+        info = [this, hwcDisplayId, &port, &data, &identificationData,
+                hasDisplayIdentificationData] {
             const bool isPrimary = !mInternalHwcDisplayId;
             if (mHasMultiDisplaySupport) {
                 if (const auto info = parseDisplayIdentificationData(port, data)) {
+                    identificationData = data;
                     return *info;
                 }
                 ALOGE("Failed to parse identification data for display %" PRIu64, hwcDisplayId);
@@ -937,6 +998,8 @@ std::optional<DisplayIdentificationInfo> HWComposer::onHotplugConnect(
     if (!isConnected(info->id)) {
         allocatePhysicalDisplay(hwcDisplayId, info->id);
     }
+    // Modes are only reused for a display whose EDID was read again on this connection.
+    mDisplayData[info->id].identificationData = std::move(identificationData);
     return info;
 }
 
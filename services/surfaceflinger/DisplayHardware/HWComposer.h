@@ -188,6 +188,15 @@ public:
     virtual status_t getDisplayedContentSample(HalDisplayId, uint64_t maxFrames, uint64_t timestamp,
                                                DisplayedFrameStats* outStats) = 0;
 
+    // Readback of the composed frame. The buffer, which must have the attributes returned for the
+    // display and the size of its active mode, is filled in by the next present, and the fence
+    // returned after it signals once the content can be read.
+    virtual status_t getReadbackBufferAttributes(PhysicalDisplayId, ui::PixelFormat* outFormat,
+                                                 ui::Dataspace* outDataspace) = 0;
+    virtual status_t setReadbackBuffer(PhysicalDisplayId, const sp<GraphicBuffer>&,
+                                       const sp<Fence>& releaseFence) = 0;
+    virtual status_t getReadbackBufferFence(PhysicalDisplayId, sp<Fence>* outFence) = 0;
+
     // Sets the brightness of a display.
     virtual std::future<status_t> setDisplayBrightness(PhysicalDisplayId, float brightness) = 0;
 
@@ -329,6 +338,11 @@ public:
                                               uint64_t maxFrames) override;
     status_t getDisplayedContentSample(HalDisplayId, uint64_t maxFrames, uint64_t timestamp,
                                        DisplayedFrameStats* outStats) override;
+    status_t getReadbackBufferAttributes(PhysicalDisplayId, ui::PixelFormat* outFormat,
+                                         ui::Dataspace* outDataspace) override;
+    status_t setReadbackBuffer(PhysicalDisplayId, const sp<GraphicBuffer>&,
+                               const sp<Fence>& releaseFence) override;
+    status_t getReadbackBufferFence(PhysicalDisplayId, sp<Fence>* outFence) override;
     std::future<status_t> setDisplayBrightness(PhysicalDisplayId, float brightness) override;
 
     // Events handling ---------------------------------------------------------
@@ -403,6 +417,9 @@ private:
         hal::Vsync vsyncEnabled GUARDED_BY(vsyncEnabledLock) = hal::Vsync::DISABLE;
 
         nsecs_t lastHwVsync = 0;
+
+        // The EDID the display was identified by, if any.
+        DisplayIdentificationData identificationData;
     };
 
     std::optional<DisplayIdentificationInfo> onHotplugConnect(hal::HWDisplayId);
@@ -423,6 +440,16 @@ private:
     bool mRegisteredCallback = false;
 
     std::unordered_map<hal::HWDisplayId, PhysicalDisplayId> mPhysicalDisplayIdMap;
+
+    // The modes last read for each display identified by its EDID. They outlive the display, so
+    // that reconnecting the same monitor with the same configs doesn't query every attribute of
+    // every config again.
+    struct CachedModes {
+        DisplayIdentificationData identificationData;
+        std::vector<hal::HWConfigId> configIds;
+        std::vector<HWCDisplayMode> modes;
+    };
+    mutable std::unordered_map<PhysicalDisplayId, CachedModes> mCachedModes;
     std::optional<hal::HWDisplayId> mInternalHwcDisplayId;
     std::optional<hal::HWDisplayId> mExternalHwcDisplayId;
     bool mHasMultiDisplaySupport = false;
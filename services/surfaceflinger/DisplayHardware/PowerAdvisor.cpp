@@ -18,15 +18,21 @@
 
 #undef LOG_TAG
 #define LOG_TAG "PowerAdvisor"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <cinttypes>
+#include <cstring>
+#include <unistd.h>
 
 #include <android-base/properties.h>
 #include <utils/Log.h>
 #include <utils/Mutex.h>
+#include <utils/Trace.h>
 
 #include <android/hardware/power/1.3/IPower.h>
 #include <android/hardware/power/IPower.h>
+#include <android/hardware/power/IPowerHintSession.h>
+#include <android/hardware/power/WorkDuration.h>
 #include <binder/IServiceManager.h>
 
 #include "../SurfaceFlingerProperties.h"
@@ -47,8 +53,12 @@ using V1_3::PowerHint;
 
 using android::hardware::power::Boost;
 using android::hardware::power::IPower;
+using android::hardware::power::IPowerHintSession;
 using android::hardware::power::Mode;
+using android::hardware::power::WorkDuration;
+using base::GetBoolProperty;
 using base::GetIntProperty;
+using base::GetUintProperty;
 using scheduler::OneShotTimer;
 
 PowerAdvisor::~PowerAdvisor() = default;
@@ -60,9 +70,19 @@ int32_t getUpdateTimeout() {
     return timeout;
 }
 
+// A frame that takes most of its work duration is likely followed by a late one.
+constexpr int32_t kUclampBoostPercent = 90;
+// The boost is dropped once enough frames in a row finish well within their work duration.
+constexpr int32_t kUclampHeadroomPercent = 60;
+constexpr int32_t kUclampHeadroomFrames = 10;
+
 } // namespace
 
 PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger)
+      : PowerAdvisor(flinger, GetUintProperty<uint32_t>("ro.surface_flinger.uclamp.min", 0U),
+                     GetUintProperty<uint32_t>("ro.surface_flinger.uclamp.boost", 0U)) {}
+
+PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger, uint32_t uclampMin, uint32_t uclampBoost)
       : mFlinger(flinger),
         mUseScreenUpdateTimer(getUpdateTimeout() > 0),
         mScreenUpdateTimer(
@@ -72,7 +92,10 @@ PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger)
                 [this] {
                     mSendUpdateImminent.store(true);
                     mFlinger.disableExpensiveRendering();
-                }) {}
+                }),
+        mPowerHintSessionEnabled(GetBoolProperty("debug.sf.enable_adpf_cpu_hint", true)),
+        mUclampMin(uclampMin),
+        mUclampBoost(uclampBoost) {}
 
 void PowerAdvisor::init() {
     // Defer starting the screen update timer until SurfaceFlinger finishes construction.
@@ -136,6 +159,150 @@ void PowerAdvisor::notifyDisplayUpdateImminent() {
     }
 }
 
+bool PowerAdvisor::usePowerHintSession() {
+    // Like the other hints, sessions wait for the system to have booted
+    if (!mPowerHintSessionEnabled || !mBootFinished.load()) {
+        return false;
+    }
+
+    std::lock_guard lock(mPowerHalMutex);
+    HalWrapper* const halWrapper = getPowerHal();
+    return halWrapper != nullptr && halWrapper->supportsPowerHintSession();
+}
+
+void PowerAdvisor::setPowerHintSessionThreadIds(const std::vector<int32_t>& threadIds) {
+    std::lock_guard lock(mPowerHalMutex);
+    mPowerHintSessionThreadIds = threadIds;
+}
+
+void PowerAdvisor::setTargetWorkDuration(nsecs_t targetDuration) {
+    std::lock_guard lock(mPowerHalMutex);
+    mTargetDuration = targetDuration;
+    HalWrapper* const halWrapper = getPowerHintSessionHal();
+    if (halWrapper == nullptr) {
+        return;
+    }
+
+    if (!halWrapper->setTargetWorkDuration(targetDuration)) {
+        // The HAL has become unavailable; attempt to reconnect later
+        mReconnectPowerHal = true;
+    }
+}
+
+void PowerAdvisor::sendActualWorkDuration(nsecs_t actualDuration, nsecs_t timestamp) {
+    std::lock_guard lock(mPowerHalMutex);
+    HalWrapper* const halWrapper = getPowerHintSessionHal();
+    if (halWrapper == nullptr) {
+        updateUclampBoost(actualDuration);
+        return;
+    }
+
+    // The session clocks the threads from now on.
+    setUclampBoosted(false);
+    if (!halWrapper->sendActualWorkDuration(actualDuration, timestamp)) {
+        // The HAL has become unavailable; attempt to reconnect later
+        mReconnectPowerHal = true;
+    }
+}
+
+PowerAdvisor::HalWrapper* PowerAdvisor::getPowerHintSessionHal() {
+    if (!mPowerHintSessionEnabled || !mBootFinished.load() || mPowerHintSessionThreadIds.empty() ||
+        mTargetDuration <= 0) {
+        return nullptr;
+    }
+
+    HalWrapper* const halWrapper = getPowerHal();
+    if (halWrapper == nullptr || !halWrapper->supportsPowerHintSession()) {
+        return nullptr;
+    }
+
+    // A reconnected HAL starts without a session
+    if (!halWrapper->isPowerHintSessionRunning() &&
+        !halWrapper->startPowerHintSession(mPowerHintSessionThreadIds, mTargetDuration)) {
+        return nullptr;
+    }
+    return halWrapper;
+}
+
+void PowerAdvisor::setUclampFloorEnabled(bool enabled) {
+    if (mUclampMin == 0 && !useAdaptiveUclamp()) {
+        return;
+    }
+
+    std::lock_guard lock(mPowerHalMutex);
+    setUclampBoosted(false);
+    mUclampFloorEnabled = enabled;
+    if (mPowerHintSessionThreadIds.empty()) {
+        return;
+    }
+
+    const int32_t tid = mPowerHintSessionThreadIds.front();
+    const uint32_t uclampMin = enabled ? mUclampMin : 0;
+    if (const status_t status = SurfaceFlinger::setUclampMin(tid, uclampMin); status != NO_ERROR) {
+        ALOGW("Couldn't set uclamp.min of %d to %u: %s", tid, uclampMin, strerror(-status));
+    }
+}
+
+void PowerAdvisor::updateUclampBoost(nsecs_t actualDuration) {
+    // Frames composed while the displays are off don't raise the threads above the 0 they get.
+    if (!useAdaptiveUclamp() || !mUclampFloorEnabled || mTargetDuration <= 0) {
+        return;
+    }
+
+    ATRACE_INT64("FrameWorkDuration", actualDuration);
+    const int64_t percent = actualDuration * 100 / mTargetDuration;
+    if (percent >= kUclampBoostPercent) {
+        mFramesWithHeadroom = 0;
+        setUclampBoosted(true);
+    } else if (mUclampBoosted && percent < kUclampHeadroomPercent) {
+        if (++mFramesWithHeadroom >= kUclampHeadroomFrames) {
+            setUclampBoosted(false);
+        }
+    } else {
+        mFramesWithHeadroom = 0;
+    }
+}
+
+void PowerAdvisor::setUclampBoosted(bool boosted) {
+    if (mUclampBoosted == boosted) {
+        return;
+    }
+
+    if (boosted) {
+        // Each thread gets back the uclamp.min it has now once the boost ends.
+        mUnboostedUclampMins.assign(mPowerHintSessionThreadIds.size(), std::nullopt);
+        for (size_t i = 0; i < mPowerHintSessionThreadIds.size(); ++i) {
+            const int32_t tid = mPowerHintSessionThreadIds[i];
+            uint32_t uclampMin = 0;
+            if (const status_t status = SurfaceFlinger::getUclampMin(tid, &uclampMin);
+                status != NO_ERROR) {
+                ALOGW("Couldn't get uclamp.min of %d, not boosting it: %s", tid,
+                      strerror(-status));
+                continue;
+            }
+            mUnboostedUclampMins[i] = uclampMin;
+        }
+    }
+
+    for (size_t i = 0; i < mUnboostedUclampMins.size(); ++i) {
+        if (!mUnboostedUclampMins[i]) {
+            continue;
+        }
+        const int32_t tid = mPowerHintSessionThreadIds[i];
+        const uint32_t uclampMin = boosted ? mUclampBoost : *mUnboostedUclampMins[i];
+        if (const status_t status = SurfaceFlinger::setUclampMin(tid, uclampMin);
+            status != NO_ERROR) {
+            ALOGW("Couldn't set uclamp.min of %d to %u: %s", tid, uclampMin, strerror(-status));
+        }
+    }
+    if (!boosted) {
+        mUnboostedUclampMins.clear();
+    }
+    mUclampBoosted = boosted;
+    mFramesWithHeadroom = 0;
+    ATRACE_INT("UclampMinBoosted", boosted);
+}
+
 class HidlPowerHalWrapper : public PowerAdvisor::HalWrapper {
 public:
     HidlPowerHalWrapper(sp<V1_3::IPower> powerHal) : mPowerHal(std::move(powerHal)) {}
@@ -178,6 +345,18 @@ public:
         return true;
     }
 
+    // Power HAL 1.x doesn't have hint sessions
+    bool supportsPowerHintSession() override { return false; }
+    bool isPowerHintSessionRunning() override { return false; }
+    bool startPowerHintSession(const std::vector<int32_t>& /*threadIds*/,
+                               int64_t /*targetDuration*/) override {
+        return false;
+    }
+    bool setTargetWorkDuration(int64_t /*targetDuration*/) override { return true; }
+    bool sendActualWorkDuration(int64_t /*actualDuration*/, nsecs_t /*timestamp*/) override {
+        return true;
+    }
+
 private:
     const sp<V1_3::IPower> mPowerHal = nullptr;
 };
@@ -195,9 +374,17 @@ public:
         if (!ret.isOk()) {
             mHasDisplayUpdateImminent = false;
         }
+
+        // Only the HALs with hint sessions have a preferred reporting rate
+        ret = mPowerHal->getHintSessionPreferredRate(&mPreferredReportingRate);
+        mHasPowerHintSession = ret.isOk() && mPreferredReportingRate > 0;
     }
 
-    ~AidlPowerHalWrapper() override = default;
+    ~AidlPowerHalWrapper() override {
+        if (mPowerHintSession != nullptr) {
+            mPowerHintSession->close();
+        }
+    }
 
     static std::unique_ptr<HalWrapper> connect() {
         // This only waits if the service is actually declared
@@ -232,10 +419,65 @@ public:
         return ret.isOk();
     }
 
+    bool supportsPowerHintSession() override { return mHasPowerHintSession; }
+
+    bool isPowerHintSessionRunning() override { return mPowerHintSession != nullptr; }
+
+    bool startPowerHintSession(const std::vector<int32_t>& threadIds,
+                               int64_t targetDuration) override {
+        auto ret = mPowerHal->createHintSession(getpid(), static_cast<int32_t>(getuid()),
+                                                threadIds, targetDuration, &mPowerHintSession);
+        if (!ret.isOk() || mPowerHintSession == nullptr) {
+            ALOGW("Failed to create power hint session, disabling them: %s",
+                  ret.exceptionMessage().c_str());
+            mHasPowerHintSession = false;
+            mPowerHintSession = nullptr;
+            return false;
+        }
+        ALOGI("Started power hint session for %zu threads", threadIds.size());
+        mTargetDuration = targetDuration;
+        return true;
+    }
+
+    bool setTargetWorkDuration(int64_t targetDuration) override {
+        if (targetDuration == mTargetDuration) {
+            return true;
+        }
+        ALOGV("AIDL setTargetWorkDuration %" PRId64, targetDuration);
+        mTargetDuration = targetDuration;
+        auto ret = mPowerHintSession->updateTargetWorkDuration(targetDuration);
+        return ret.isOk();
+    }
+
+    bool sendActualWorkDuration(int64_t actualDuration, nsecs_t timestamp) override {
+        WorkDuration duration;
+        duration.durationNanos = actualDuration;
+        duration.timeStampNanos = timestamp;
+        mPendingDurations.push_back(duration);
+
+        // Frames over their target are reported right away, so that the clocks ramp up before
+        // the next deadline. The others are batched at the rate the HAL prefers.
+        if (actualDuration <= mTargetDuration &&
+            timestamp - mPendingDurations.front().timeStampNanos < mPreferredReportingRate) {
+            return true;
+        }
+
+        ALOGV("AIDL sendActualWorkDuration %zu durations", mPendingDurations.size());
+        auto ret = mPowerHintSession->reportActualWorkDuration(mPendingDurations);
+        mPendingDurations.clear();
+        return ret.isOk();
+    }
+
 private:
     const sp<IPower> mPowerHal = nullptr;
     bool mHasExpensiveRendering = false;
     bool mHasDisplayUpdateImminent = false;
+
+    bool mHasPowerHintSession = false;
+    int64_t mPreferredReportingRate = -1;
+    sp<IPowerHintSession> mPowerHintSession = nullptr;
+    int64_t mTargetDuration = 0;
+    std::vector<WorkDuration> mPendingDurations;
 };
 
 PowerAdvisor::HalWrapper* PowerAdvisor::getPowerHal() {
@@ -17,9 +17,12 @@
 #pragma once
 
 #include <atomic>
+#include <optional>
 #include <unordered_set>
+#include <vector>
 
 #include <utils/Mutex.h>
+#include <utils/Timers.h>
 
 #include "../Scheduler/OneShotTimer.h"
 #include "DisplayIdentification.h"
@@ -40,6 +43,20 @@ public:
     virtual void setExpensiveRenderingExpected(DisplayId displayId, bool expected) = 0;
     virtual bool isUsingExpensiveRendering() = 0;
     virtual void notifyDisplayUpdateImminent() = 0;
+
+    // The work of each frame is reported to a power hint session of SurfaceFlinger's critical
+    // threads, when the power HAL supports them, so that the CPU is clocked for the deadline.
+    virtual bool usePowerHintSession() = 0;
+    virtual void setPowerHintSessionThreadIds(const std::vector<int32_t>& threadIds) = 0;
+    virtual void setTargetWorkDuration(nsecs_t targetDuration) = 0;
+    virtual void sendActualWorkDuration(nsecs_t actualDuration, nsecs_t timestamp) = 0;
+
+    // Without a power hint session, the same durations raise the uclamp.min of those threads
+    // while frames are predicted to be late, if the device configures a boost for them.
+    virtual bool useAdaptiveUclamp() = 0;
+    // Whether the main thread, the first of those threads, keeps ro.surface_flinger.uclamp.min
+    // as its floor, which it does while a display is on. Changing it ends any boost.
+    virtual void setUclampFloorEnabled(bool enabled) = 0;
 };
 
 namespace impl {
@@ -54,9 +71,17 @@ public:
 
         virtual bool setExpensiveRendering(bool enabled) = 0;
         virtual bool notifyDisplayUpdateImminent() = 0;
+
+        virtual bool supportsPowerHintSession() = 0;
+        virtual bool isPowerHintSessionRunning() = 0;
+        virtual bool startPowerHintSession(const std::vector<int32_t>& threadIds,
+                                           int64_t targetDuration) = 0;
+        virtual bool setTargetWorkDuration(int64_t targetDuration) = 0;
+        virtual bool sendActualWorkDuration(int64_t actualDuration, nsecs_t timestamp) = 0;
     };
 
     PowerAdvisor(SurfaceFlinger& flinger);
+    PowerAdvisor(SurfaceFlinger& flinger, uint32_t uclampMin, uint32_t uclampBoost);
     ~PowerAdvisor() override;
 
     void init() override;
@@ -65,8 +90,24 @@ public:
     bool isUsingExpensiveRendering() override { return mNotifiedExpensiveRendering; }
     void notifyDisplayUpdateImminent() override;
 
+    bool usePowerHintSession() override;
+    void setPowerHintSessionThreadIds(const std::vector<int32_t>& threadIds) override;
+    void setTargetWorkDuration(nsecs_t targetDuration) override;
+    void sendActualWorkDuration(nsecs_t actualDuration, nsecs_t timestamp) override;
+    bool useAdaptiveUclamp() override { return mUclampBoost > mUclampMin; }
+    void setUclampFloorEnabled(bool enabled) override;
+
+    bool isUclampBoosted() {
+        std::lock_guard lock(mPowerHalMutex);
+        return mUclampBoosted;
+    }
+
 private:
     HalWrapper* getPowerHal() REQUIRES(mPowerHalMutex);
+    // Returns the HAL once its power hint session is running, starting it if needed.
+    HalWrapper* getPowerHintSessionHal() REQUIRES(mPowerHalMutex);
+    void updateUclampBoost(nsecs_t actualDuration) REQUIRES(mPowerHalMutex);
+    void setUclampBoosted(bool boosted) REQUIRES(mPowerHalMutex);
     bool mReconnectPowerHal GUARDED_BY(mPowerHalMutex) = false;
     std::mutex mPowerHalMutex;
 
@@ -79,6 +120,22 @@ private:
     const bool mUseScreenUpdateTimer;
     std::atomic_bool mSendUpdateImminent = true;
     scheduler::OneShotTimer mScreenUpdateTimer;
+
+    const bool mPowerHintSessionEnabled;
+    std::vector<int32_t> mPowerHintSessionThreadIds GUARDED_BY(mPowerHalMutex);
+    nsecs_t mTargetDuration GUARDED_BY(mPowerHalMutex) = 0;
+
+    // The floor of the main thread while a display is on, and the uclamp.min of the threads while
+    // frames are predicted to be late.
+    const uint32_t mUclampMin;
+    const uint32_t mUclampBoost;
+    // The main thread gets the floor at startup, before SurfaceFlinger runs.
+    bool mUclampFloorEnabled GUARDED_BY(mPowerHalMutex) = true;
+    bool mUclampBoosted GUARDED_BY(mPowerHalMutex) = false;
+    // The uclamp.min each thread had before the boost, which it gets back after it.
+    // A thread whose uclamp.min couldn't be read is left as it is.
+    std::vector<std::optional<uint32_t>> mUnboostedUclampMins GUARDED_BY(mPowerHalMutex);
+    int32_t mFramesWithHeadroom GUARDED_BY(mPowerHalMutex) = 0;
 };
 
 } // namespace impl
@@ -57,6 +57,21 @@ static const char* dbgCompositionTypeStr(compositionengine::DisplaySurface::Comp
     }
 }
 
+static bool isRgbFormat(uint32_t format) {
+    switch (format) {
+        case HAL_PIXEL_FORMAT_RGBA_8888:
+        case HAL_PIXEL_FORMAT_RGBX_8888:
+        case HAL_PIXEL_FORMAT_RGB_888:
+        case HAL_PIXEL_FORMAT_RGB_565:
+        case HAL_PIXEL_FORMAT_BGRA_8888:
+        case HAL_PIXEL_FORMAT_RGBA_FP16:
+        case HAL_PIXEL_FORMAT_RGBA_1010102:
+            return true;
+        default:
+            return false;
+    }
+}
+
 VirtualDisplaySurface::VirtualDisplaySurface(HWComposer& hwc, VirtualDisplayId displayId,
                                              const sp<IGraphicBufferProducer>& sink,
                                              const sp<IGraphicBufferProducer>& bqProducer,
@@ -111,6 +126,14 @@ VirtualDisplaySurface::VirtualDisplaySurface(HWComposer& hwc, VirtualDisplayId d
     }
     mOutputFormat = mDefaultOutputFormat;
 
+    // The HWC copy of GPU-composed frames is only there to convert them to YUV, which a consumer
+    // asking for RGB doesn't need.
+    if (mForceHwcCopy && isRgbFormat(mDefaultOutputFormat)) {
+        VDS_LOGV("Not copying GPU-composed frames with HWC for RGB sink format %#x",
+                 mDefaultOutputFormat);
+        mForceHwcCopy = false;
+    }
+
     ConsumerBase::mName = String8::format("VDS: %s", mDisplayName.c_str());
     mConsumer->setConsumerName(ConsumerBase::mName);
     mConsumer->setConsumerUsageBits(GRALLOC_USAGE_HW_COMPOSER);
@@ -155,8 +178,9 @@ status_t VirtualDisplaySurface::prepareFrame(CompositionType compositionType) {
         // allows the format conversion to happen there, rather than passing RGB
         // directly to the consumer.
         //
-        // On the other hand, when the consumer prefers RGB or can consume RGB
-        // inexpensively, this forces an unnecessary copy.
+        // On the other hand, when the consumer can consume RGB inexpensively,
+        // this forces an unnecessary copy. It is skipped for consumers that
+        // ask for an RGB format.
         mCompositionType = COMPOSITION_MIXED;
     }
 
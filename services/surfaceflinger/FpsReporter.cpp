@@ -18,6 +18,8 @@
 #define LOG_TAG "FpsReporter"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <pthread.h>
+
 #include <algorithm>
 
 #include "FpsReporter.h"
@@ -28,10 +30,22 @@ namespace android {
 
 FpsReporter::FpsReporter(frametimeline::FrameTimeline& frameTimeline, SurfaceFlinger& flinger,
                          std::unique_ptr<Clock> clock)
-      : mFrameTimeline(frameTimeline), mFlinger(flinger), mClock(std::move(clock)) {
+      : mFrameTimeline(frameTimeline),
+        mFlinger(flinger),
+        mClock(std::move(clock)),
+        mReportThread(&FpsReporter::threadMain, this) {
     LOG_ALWAYS_FATAL_IF(mClock == nullptr, "Passed in null clock when constructing FpsReporter!");
 }
 
+FpsReporter::~FpsReporter() {
+    {
+        std::scoped_lock lock(mReportMutex);
+        mRunning = false;
+    }
+    mReportCondition.notify_all();
+    mReportThread.join();
+}
+
 void FpsReporter::dispatchLayerFps() {
     const auto now = mClock->now();
     if (now - mLastDispatch < kMinDispatchDuration) {
@@ -71,18 +85,64 @@ void FpsReporter::dispatchLayerFps() {
         }
     });
 
+    // Only the layer tree needs the main thread. Computing the fps scans the frame timeline, which
+    // is left to the thread of the reporter along with the binder calls.
+    std::vector<PendingReport> reports;
+    reports.reserve(listenersAndLayersToReport.size());
     for (const auto& [listener, layer] : listenersAndLayersToReport) {
         std::unordered_set<int32_t> layerIds;
 
         layer->traverse(LayerVector::StateSet::Current,
                         [&](Layer* layer) { layerIds.insert(layer->getSequence()); });
 
-        listener.listener->onFpsReported(mFrameTimeline.computeFps(layerIds));
+        reports.push_back({listener.listener, std::move(layerIds)});
     }
 
+    {
+        std::scoped_lock lock(mReportMutex);
+        mPendingReports = std::move(reports);
+    }
+    mReportCondition.notify_all();
+
     mLastDispatch = now;
 }
 
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void FpsReporter::flush() NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock(mReportMutex);
+    mReportCondition.wait(lock, [this]() NO_THREAD_SAFETY_ANALYSIS {
+        return mPendingReports.empty() && !mReporting;
+    });
+}
+
+// NO_THREAD_SAFETY_ANALYSIS is because std::unique_lock presently lacks thread safety annotations.
+void FpsReporter::threadMain() NO_THREAD_SAFETY_ANALYSIS {
+    pthread_setname_np(pthread_self(), "FpsReporter");
+
+    std::unique_lock lock(mReportMutex);
+    while (true) {
+        mReportCondition.wait(lock, [this]() NO_THREAD_SAFETY_ANALYSIS {
+            return !mRunning || !mPendingReports.empty();
+        });
+        if (!mRunning) {
+            break;
+        }
+
+        std::vector<PendingReport> reports;
+        reports.swap(mPendingReports);
+        mReporting = true;
+        lock.unlock();
+
+        for (const auto& report : reports) {
+            report.listener->onFpsReported(mFrameTimeline.computeFps(report.layerIds));
+        }
+
+        lock.lock();
+        mReporting = false;
+        mReportCondition.notify_all();
+    }
+}
+
 void FpsReporter::binderDied(const wp<IBinder>& who) {
     std::scoped_lock lock(mMutex);
     mListeners.erase(who);
@@ -20,7 +20,11 @@
 #include <android/gui/IFpsListener.h>
 #include <binder/IBinder.h>
 
+#include <condition_variable>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "Clock.h"
 #include "FrameTimeline/FrameTimeline.h"
@@ -34,11 +38,16 @@ class FpsReporter : public IBinder::DeathRecipient {
 public:
     FpsReporter(frametimeline::FrameTimeline& frameTimeline, SurfaceFlinger& flinger,
                 std::unique_ptr<Clock> clock = std::make_unique<SteadyClock>());
+    ~FpsReporter() override;
 
     // Dispatches updated layer fps values for the registered listeners
     // This method promotes Layer weak pointers and performs layer stack traversals, so mStateLock
-    // must be held when calling this method.
-    void dispatchLayerFps() EXCLUDES(mMutex);
+    // must be held when calling this method. The fps are then computed and reported from the
+    // thread of the reporter, which only reports the latest dispatch if it falls behind.
+    void dispatchLayerFps() EXCLUDES(mMutex, mReportMutex);
+
+    // Waits until the fps of the dispatches so far have been reported.
+    void flush() EXCLUDES(mReportMutex);
 
     // Override for IBinder::DeathRecipient
     void binderDied(const wp<IBinder>&) override;
@@ -68,6 +77,21 @@ private:
     std::unique_ptr<Clock> mClock;
     std::chrono::steady_clock::time_point mLastDispatch;
     std::unordered_map<wp<IBinder>, TrackedListener, WpHash> mListeners GUARDED_BY(mMutex);
+
+    // The layers of the task tracked by a listener, as found by the last dispatch.
+    struct PendingReport {
+        sp<gui::IFpsListener> listener;
+        std::unordered_set<int32_t> layerIds;
+    };
+
+    std::mutex mReportMutex;
+    std::condition_variable mReportCondition;
+    bool mRunning GUARDED_BY(mReportMutex) = true;
+    bool mReporting GUARDED_BY(mReportMutex) = false;
+    std::vector<PendingReport> mPendingReports GUARDED_BY(mReportMutex);
+    std::thread mReportThread;
+
+    void threadMain() EXCLUDES(mReportMutex);
 };
 
 } // namespace android
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 #include <chrono>
 #include <cinttypes>
+#include <memory>
 #include <numeric>
 #include <unordered_set>
 
@@ -733,6 +734,86 @@ void SurfaceFrame::trace(int64_t displayFrameToken) const {
 
 namespace impl {
 
+// A free list of the blocks that allocate_shared<SurfaceFrame> requests, which all have the size of
+// the shared_ptr control block with the SurfaceFrame in place. Blocks freed beyond the capacity go
+// back to the heap. SurfaceFrames are released on any thread that drops the last reference, hence
+// the lock.
+class SurfaceFramePool {
+public:
+    explicit SurfaceFramePool(size_t capacity) : mCapacity(capacity) {
+        mFreeBlocks.reserve(capacity);
+    }
+
+    ~SurfaceFramePool() {
+        for (void* block : mFreeBlocks) {
+            ::operator delete(block);
+        }
+    }
+
+    void* allocate(size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (size == mBlockSize && !mFreeBlocks.empty()) {
+                void* const block = mFreeBlocks.back();
+                mFreeBlocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (mBlockSize == 0) {
+                mBlockSize = size;
+            }
+            if (size == mBlockSize && mFreeBlocks.size() < mCapacity) {
+                mFreeBlocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    const size_t mCapacity;
+    std::mutex mMutex;
+    size_t mBlockSize GUARDED_BY(mMutex) = 0;
+    std::vector<void*> mFreeBlocks GUARDED_BY(mMutex);
+};
+
+namespace {
+
+// Allocator for allocate_shared, which keeps the pool alive as long as memory allocated from it.
+template <typename T>
+struct SurfaceFrameAllocator {
+    using value_type = T;
+
+    explicit SurfaceFrameAllocator(std::shared_ptr<SurfaceFramePool> pool)
+          : pool(std::move(pool)) {}
+
+    template <typename U>
+    SurfaceFrameAllocator(const SurfaceFrameAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { pool->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SurfaceFrameAllocator<U>& other) const {
+        return pool == other.pool;
+    }
+
+    template <typename U>
+    bool operator!=(const SurfaceFrameAllocator<U>& other) const {
+        return pool != other.pool;
+    }
+
+    std::shared_ptr<SurfaceFramePool> pool;
+};
+
+} // namespace
+
 int64_t TokenManager::generateTokenForPredictions(TimelineItem&& predictions) {
     ATRACE_CALL();
     std::scoped_lock lock(mMutex);
@@ -754,13 +835,70 @@ std::optional<TimelineItem> TokenManager::getPredictionsForToken(int64_t token)
 }
 
 FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                             JankClassificationThresholds thresholds)
+                             JankClassificationThresholds thresholds, bool classifyOnWorkerThread)
       : mMaxDisplayFrames(kDefaultMaxDisplayFrames),
         mTimeStats(std::move(timeStats)),
         mSurfaceFlingerPid(surfaceFlingerPid),
-        mJankClassificationThresholds(thresholds) {
+        mJankClassificationThresholds(thresholds),
+        mSurfaceFramePool(std::make_shared<SurfaceFramePool>(kDefaultMaxDisplayFrames *
+                                                             kNumSurfaceFramesInitial)) {
     mCurrentDisplayFrame =
             std::make_shared<DisplayFrame>(mTimeStats, thresholds, &mTraceCookieCounter);
+    mDisplayFramePool.reserve(mMaxDisplayFrames);
+
+    if (classifyOnWorkerThread) {
+        mWorker = std::thread(&FrameTimeline::workerMain, this);
+        pthread_setname_np(mWorker.native_handle(), "FrameTimeline");
+    }
+}
+
+FrameTimeline::~FrameTimeline() {
+    if (mWorker.joinable()) {
+        {
+            std::scoped_lock lock(mWorkerMutex);
+            mWorkerQuit = true;
+        }
+        mWorkerCondition.notify_all();
+        mWorker.join();
+    }
+}
+
+void FrameTimeline::workerMain() {
+    uint64_t polledFrameCount = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mWorkerMutex);
+            mPolledFrameCount = polledFrameCount;
+            mWorkerCondition.notify_all();
+            mWorkerCondition.wait(lock, [&]() REQUIRES(mWorkerMutex) {
+                return mWorkerQuit || mPresentedFrameCount > polledFrameCount;
+            });
+            if (mWorkerQuit) {
+                return;
+            }
+        }
+
+        // The presented DisplayFrames are no longer changed by the main thread, so they are
+        // classified without holding mMutex.
+        ATRACE_NAME("FrameTimeline::classify");
+        std::scoped_lock lock(mClassifyMutex);
+        mPresentedFrames.drain(
+                [&](PendingPresentFence&& pendingPresentFence) REQUIRES(mClassifyMutex) {
+                    mWorkerPendingPresentFences.push_back(std::move(pendingPresentFence));
+                    polledFrameCount++;
+                });
+        flushPendingPresentFences(mWorkerPendingPresentFences);
+    }
+}
+
+void FrameTimeline::waitForWorker() {
+    if (!mWorker.joinable()) {
+        return;
+    }
+    std::unique_lock lock(mWorkerMutex);
+    mWorkerCondition.wait(lock, [this]() REQUIRES(mWorkerMutex) {
+        return mPolledFrameCount >= mPresentedFrameCount;
+    });
 }
 
 void FrameTimeline::onBootFinished() {
@@ -780,27 +918,30 @@ std::shared_ptr<SurfaceFrame> FrameTimeline::createSurfaceFrameForToken(
         const FrameTimelineInfo& frameTimelineInfo, pid_t ownerPid, uid_t ownerUid, int32_t layerId,
         std::string layerName, std::string debugName, bool isBuffer, int32_t gameMode) {
     ATRACE_CALL();
+    const SurfaceFrameAllocator<SurfaceFrame> allocator(mSurfaceFramePool);
     if (frameTimelineInfo.vsyncId == FrameTimelineInfo::INVALID_VSYNC_ID) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::None, TimelineItem(), mTimeStats,
-                                              mJankClassificationThresholds, &mTraceCookieCounter,
-                                              isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::None,
+                                                  TimelineItem(), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
     }
     std::optional<TimelineItem> predictions =
             mTokenManager.getPredictionsForToken(frameTimelineInfo.vsyncId);
     if (predictions) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::Valid, std::move(*predictions),
-                                              mTimeStats, mJankClassificationThresholds,
-                                              &mTraceCookieCounter, isBuffer, gameMode);
-    }
-    return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                          std::move(layerName), std::move(debugName),
-                                          PredictionState::Expired, TimelineItem(), mTimeStats,
-                                          mJankClassificationThresholds, &mTraceCookieCounter,
-                                          isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::Valid,
+                                                  std::move(*predictions), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
+    }
+    return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                              layerId, std::move(layerName), std::move(debugName),
+                                              PredictionState::Expired, TimelineItem(), mTimeStats,
+                                              mJankClassificationThresholds, &mTraceCookieCounter,
+                                              isBuffer, gameMode);
 }
 
 FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
@@ -814,6 +955,21 @@ FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
     mSurfaceFrames.reserve(kNumSurfaceFramesInitial);
 }
 
+void FrameTimeline::DisplayFrame::reset() {
+    mToken = FrameTimelineInfo::INVALID_VSYNC_ID;
+    mSurfaceFlingerPredictions = TimelineItem();
+    mSurfaceFlingerActuals = TimelineItem();
+    // Keeps the capacity of the vector, so that the reused DisplayFrame does not allocate.
+    mSurfaceFrames.clear();
+    mPredictionState = PredictionState::None;
+    mJankType = JankType::None;
+    mGpuFence = FenceTime::NO_FENCE;
+    mFramePresentMetadata = FramePresentMetadata::UnknownPresent;
+    mFrameReadyMetadata = FrameReadyMetadata::UnknownFinish;
+    mFrameStartMetadata = FrameStartMetadata::UnknownStart;
+    mRefreshRate = Fps();
+}
+
 void FrameTimeline::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
     ATRACE_CALL();
     std::scoped_lock lock(mMutex);
@@ -831,12 +987,26 @@ void FrameTimeline::setSfPresent(nsecs_t sfPresentTime,
                                  const std::shared_ptr<FenceTime>& presentFence,
                                  const std::shared_ptr<FenceTime>& gpuFence) {
     ATRACE_CALL();
-    std::scoped_lock lock(mMutex);
-    mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
-    mCurrentDisplayFrame->setGpuFence(gpuFence);
-    mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
-    flushPendingPresentFences();
-    finalizeCurrentDisplayFrame();
+    {
+        std::scoped_lock lock(mMutex);
+        mCurrentDisplayFrame->setActualEndTime(sfPresentTime);
+        mCurrentDisplayFrame->setGpuFence(gpuFence);
+        if (mWorker.joinable()) {
+            mPresentedFrames.push(std::make_pair(presentFence, mCurrentDisplayFrame));
+        } else {
+            mPendingPresentFences.emplace_back(std::make_pair(presentFence, mCurrentDisplayFrame));
+            flushPendingPresentFences(mPendingPresentFences);
+        }
+        finalizeCurrentDisplayFrame();
+    }
+
+    if (mWorker.joinable()) {
+        {
+            std::scoped_lock lock(mWorkerMutex);
+            mPresentedFrameCount++;
+        }
+        mWorkerCondition.notify_all();
+    }
 }
 
 void FrameTimeline::DisplayFrame::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
@@ -1105,7 +1275,7 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
 
     std::vector<nsecs_t> presentTimes;
     {
-        std::scoped_lock lock(mMutex);
+        std::scoped_lock lock(mClassifyMutex, mMutex);
         presentTimes.reserve(mDisplayFrames.size());
         for (size_t i = 0; i < mDisplayFrames.size(); i++) {
             const auto& displayFrame = mDisplayFrames[i];
@@ -1157,9 +1327,10 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
             static_cast<float>(totalPresentToPresentWalls);
 }
 
-void FrameTimeline::flushPendingPresentFences() {
-    for (size_t i = 0; i < mPendingPresentFences.size(); i++) {
-        const auto& pendingPresentFence = mPendingPresentFences[i];
+void FrameTimeline::flushPendingPresentFences(
+        std::vector<PendingPresentFence>& pendingPresentFences) {
+    for (size_t i = 0; i < pendingPresentFences.size(); i++) {
+        const auto& pendingPresentFence = pendingPresentFences[i];
         nsecs_t signalTime = Fence::SIGNAL_TIME_INVALID;
         if (pendingPresentFence.first && pendingPresentFence.first->isValid()) {
             signalTime = pendingPresentFence.first->getSignalTime();
@@ -1172,7 +1343,7 @@ void FrameTimeline::flushPendingPresentFences() {
         displayFrame->trace(mSurfaceFlingerPid);
         mPreviousPresentTime = signalTime;
 
-        mPendingPresentFences.erase(mPendingPresentFences.begin() + static_cast<int>(i));
+        pendingPresentFences.erase(pendingPresentFences.begin() + static_cast<int>(i));
         --i;
     }
 }
@@ -1180,12 +1351,31 @@ void FrameTimeline::flushPendingPresentFences() {
 void FrameTimeline::finalizeCurrentDisplayFrame() {
     while (mDisplayFrames.size() >= mMaxDisplayFrames) {
         // We maintain only a fixed number of frames' data. Pop older frames
+        recycleDisplayFrame(std::move(mDisplayFrames.front()));
         mDisplayFrames.pop_front();
     }
-    mDisplayFrames.push_back(mCurrentDisplayFrame);
-    mCurrentDisplayFrame.reset();
-    mCurrentDisplayFrame = std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
-                                                          &mTraceCookieCounter);
+    mDisplayFrames.push_back(std::move(mCurrentDisplayFrame));
+    mCurrentDisplayFrame = acquireDisplayFrame();
+}
+
+std::shared_ptr<FrameTimeline::DisplayFrame> FrameTimeline::acquireDisplayFrame() {
+    if (mDisplayFramePool.empty()) {
+        return std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
+                                              &mTraceCookieCounter);
+    }
+    auto displayFrame = std::move(mDisplayFramePool.back());
+    mDisplayFramePool.pop_back();
+    return displayFrame;
+}
+
+void FrameTimeline::recycleDisplayFrame(std::shared_ptr<DisplayFrame> displayFrame) {
+    // A DisplayFrame still waiting on its present fence is in use, and is released once that
+    // fence is flushed.
+    if (displayFrame.use_count() > 1 || mDisplayFramePool.size() >= mMaxDisplayFrames) {
+        return;
+    }
+    displayFrame->reset();
+    mDisplayFramePool.push_back(std::move(displayFrame));
 }
 
 nsecs_t FrameTimeline::DisplayFrame::getBaseTime() const {
@@ -1256,7 +1446,7 @@ void FrameTimeline::DisplayFrame::dump(std::string& result, nsecs_t baseTime) co
 }
 
 void FrameTimeline::dumpAll(std::string& result) {
-    std::scoped_lock lock(mMutex);
+    std::scoped_lock lock(mClassifyMutex, mMutex);
     StringAppendF(&result, "Number of display frames : %d\n", (int)mDisplayFrames.size());
     nsecs_t baseTime = (mDisplayFrames.empty()) ? 0 : mDisplayFrames[0]->getBaseTime();
     for (size_t i = 0; i < mDisplayFrames.size(); i++) {
@@ -1266,7 +1456,7 @@ void FrameTimeline::dumpAll(std::string& result) {
 }
 
 void FrameTimeline::dumpJank(std::string& result) {
-    std::scoped_lock lock(mMutex);
+    std::scoped_lock lock(mClassifyMutex, mMutex);
     nsecs_t baseTime = (mDisplayFrames.empty()) ? 0 : mDisplayFrames[0]->getBaseTime();
     for (size_t i = 0; i < mDisplayFrames.size(); i++) {
         mDisplayFrames[i]->dumpJank(result, baseTime, static_cast<int>(i));
@@ -1293,6 +1483,7 @@ void FrameTimeline::setMaxDisplayFrames(uint32_t size) {
     // The size can either increase or decrease, clear everything, to be consistent
     mDisplayFrames.clear();
     mPendingPresentFences.clear();
+    mDisplayFramePool.clear();
     mMaxDisplayFrames = size;
 }
 
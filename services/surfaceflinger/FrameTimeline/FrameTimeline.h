@@ -17,6 +17,7 @@
 #pragma once
 
 #include <../Fps.h>
+#include <../LocklessQueue.h>
 #include <../TimeStats/TimeStats.h>
 #include <gui/ISurfaceComposer.h>
 #include <gui/JankInfo.h>
@@ -28,8 +29,10 @@
 #include <utils/Timers.h>
 #include <utils/Vector.h>
 
+#include <condition_variable>
 #include <deque>
 #include <mutex>
+#include <thread>
 
 namespace android::frametimeline {
 
@@ -338,6 +341,9 @@ private:
     static constexpr size_t kMaxTokens = 500;
 };
 
+// Recycles the memory of the SurfaceFrames created by FrameTimeline. Defined in FrameTimeline.cpp.
+class SurfaceFramePool;
+
 class FrameTimeline : public android::frametimeline::FrameTimeline {
 public:
     class FrameTimelineDataSource : public perfetto::DataSource<FrameTimelineDataSource> {
@@ -348,7 +354,8 @@ public:
 
     /*
      * DisplayFrame should be used only internally within FrameTimeline. All members and methods are
-     * guarded by FrameTimeline's mMutex.
+     * guarded by FrameTimeline's mMutex, and also by its mClassifyMutex once the DisplayFrame is
+     * handed to the worker thread.
      */
     class DisplayFrame {
     public:
@@ -376,6 +383,10 @@ public:
         void setActualEndTime(nsecs_t actualEndTime);
         void setGpuFence(const std::shared_ptr<FenceTime>& gpuFence);
 
+        // Restores the state of a newly constructed DisplayFrame, so that it can be reused once it
+        // ages out of the sliding window. Releases the SurfaceFrames it holds.
+        void reset();
+
         // BaseTime is the smallest timestamp in a DisplayFrame.
         // Used for dumping all timestamps relative to the oldest, making it easy to read.
         nsecs_t getBaseTime() const;
@@ -433,9 +444,12 @@ public:
         TraceCookieCounter& mTraceCookieCounter;
     };
 
+    // If classifyOnWorkerThread is set, present fences are handed to a worker thread, which
+    // classifies jank and emits traces once they signal. Otherwise setSfPresent does so inline.
     FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
-                  JankClassificationThresholds thresholds = {});
-    ~FrameTimeline() = default;
+                  JankClassificationThresholds thresholds = {},
+                  bool classifyOnWorkerThread = false);
+    ~FrameTimeline();
 
     frametimeline::TokenManager* getTokenManager() override { return &mTokenManager; }
     std::shared_ptr<SurfaceFrame> createSurfaceFrameForToken(
@@ -463,16 +477,32 @@ private:
     // Friend class for testing
     friend class android::frametimeline::FrameTimelineTest;
 
-    void flushPendingPresentFences() REQUIRES(mMutex);
+    using PendingPresentFence =
+            std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>;
+
+    // Classifies and traces the DisplayFrames whose present fence signaled, and removes them from
+    // pendingPresentFences. Called with mMutex held inline, and with only mClassifyMutex held on
+    // the worker thread, so that classification doesn't block the main thread.
+    void flushPendingPresentFences(std::vector<PendingPresentFence>& pendingPresentFences);
+    void workerMain();
+    // Blocks until the worker has polled the present fences of every DisplayFrame handed to it.
+    void waitForWorker();
     void finalizeCurrentDisplayFrame() REQUIRES(mMutex);
+    // Returns a DisplayFrame that aged out of the sliding window, or a new one if there are none.
+    std::shared_ptr<DisplayFrame> acquireDisplayFrame() REQUIRES(mMutex);
+    void recycleDisplayFrame(std::shared_ptr<DisplayFrame> displayFrame) REQUIRES(mMutex);
     void dumpAll(std::string& result);
     void dumpJank(std::string& result);
 
     // Sliding window of display frames. TODO(b/168072834): compare perf with fixed size array
     std::deque<std::shared_ptr<DisplayFrame>> mDisplayFrames GUARDED_BY(mMutex);
-    std::vector<std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>>
-            mPendingPresentFences GUARDED_BY(mMutex);
+    std::vector<PendingPresentFence> mPendingPresentFences GUARDED_BY(mMutex);
     std::shared_ptr<DisplayFrame> mCurrentDisplayFrame GUARDED_BY(mMutex);
+    // DisplayFrames that aged out of the sliding window, kept for reuse. Holds at most
+    // mMaxDisplayFrames, so that steady state does not allocate DisplayFrames.
+    std::vector<std::shared_ptr<DisplayFrame>> mDisplayFramePool GUARDED_BY(mMutex);
+    // Shared with the SurfaceFrames it allocated, which can outlive FrameTimeline.
+    const std::shared_ptr<SurfaceFramePool> mSurfaceFramePool;
     TokenManager mTokenManager;
     TraceCookieCounter mTraceCookieCounter;
     mutable std::mutex mMutex;
@@ -481,6 +511,21 @@ private:
     const pid_t mSurfaceFlingerPid;
     nsecs_t mPreviousPresentTime = 0;
     const JankClassificationThresholds mJankClassificationThresholds;
+
+    // Presented DisplayFrames, handed from the main thread to the worker without taking mMutex.
+    // The worker moves them to mWorkerPendingPresentFences.
+    LocklessQueue<PendingPresentFence> mPresentedFrames;
+    // Held by the worker while it classifies DisplayFrames, and by the readers of the presented
+    // DisplayFrames, before mMutex.
+    std::mutex mClassifyMutex;
+    std::vector<PendingPresentFence> mWorkerPendingPresentFences GUARDED_BY(mClassifyMutex);
+    std::mutex mWorkerMutex;
+    std::condition_variable mWorkerCondition;
+    uint64_t mPresentedFrameCount GUARDED_BY(mWorkerMutex) = 0;
+    uint64_t mPolledFrameCount GUARDED_BY(mWorkerMutex) = 0;
+    bool mWorkerQuit GUARDED_BY(mWorkerMutex) = false;
+    std::thread mWorker;
+
     static constexpr uint32_t kDefaultMaxDisplayFrames = 64;
     // The initial container size for the vector<SurfaceFrames> inside display frame. Although
     // this number doesn't represent any bounds on the number of surface frames that can go in a
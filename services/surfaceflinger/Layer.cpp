@@ -32,6 +32,7 @@
 #include <compositionengine/Display.h>
 #include <compositionengine/LayerFECompositionState.h>
 #include <compositionengine/OutputLayer.h>
+#include <compositionengine/WorkerPool.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
 #include <cutils/compiler.h>
 #include <cutils/native_handle.h>
@@ -85,6 +86,7 @@ using namespace android::flag_operators;
 using PresentState = frametimeline::SurfaceFrame::PresentState;
 
 std::atomic<int32_t> Layer::sSequence{1};
+std::atomic<uint64_t> Layer::sTraversalGeneration{1};
 
 Layer::Layer(const LayerCreationArgs& args)
       : mFlinger(args.flinger),
@@ -166,6 +168,8 @@ void Layer::onFirstRef() {
 }
 
 Layer::~Layer() {
+    // Cached traversal lists may point to this layer.
+    invalidateTraversalLists();
     sp<Client> c(mClientRef.promote());
     if (c != 0) {
         c->detachLayer(this);
@@ -329,6 +333,86 @@ FloatRect Layer::getBounds(const Region& activeTransparentRegion) const {
 
 void Layer::computeBounds(FloatRect parentBounds, ui::Transform parentTransform,
                           float parentShadowRadius) {
+    if (!computeBoundsWithoutChildren(parentBounds, parentTransform, parentShadowRadius)) {
+        return;
+    }
+
+    const float childShadowRadius = getChildShadowRadius();
+    for (const sp<Layer>& child : mDrawingChildren) {
+        child->computeBounds(mBounds, mEffectiveTransform, childShadowRadius);
+    }
+}
+
+void Layer::computeBounds(const std::vector<Layer*>& roots, FloatRect parentBounds,
+                          compositionengine::WorkerPool& workerPool) {
+    ATRACE_CALL();
+    // Each subtree only depends on the layers above it. Enough of them for the
+    // pool to balance uneven trees is a few for each thread.
+    constexpr size_t kSubtreesPerThread = 4;
+    const size_t targetSubtrees = (workerPool.getThreadCount() + 1) * kSubtreesPerThread;
+
+    struct Subtree {
+        Layer* root;
+        FloatRect parentBounds;
+        ui::Transform parentTransform;
+        float parentShadowRadius;
+    };
+    std::vector<Subtree> subtrees;
+    subtrees.reserve(roots.size());
+    for (Layer* root : roots) {
+        subtrees.push_back({root, parentBounds, ui::Transform(), 0.f /* shadowRadius */});
+    }
+
+    // Compute the tops of the trees here, a level at a time, until they split
+    // into enough subtrees. Subtrees which are still valid are dropped.
+    bool split = true;
+    while (split && subtrees.size() < targetSubtrees) {
+        split = false;
+        std::vector<Subtree> next;
+        for (const Subtree& subtree : subtrees) {
+            Layer* layer = subtree.root;
+            if (layer->mDrawingChildren.isEmpty()) {
+                next.push_back(subtree);
+                continue;
+            }
+            split = true;
+            if (!layer->computeBoundsWithoutChildren(subtree.parentBounds, subtree.parentTransform,
+                                                     subtree.parentShadowRadius)) {
+                continue;
+            }
+            const float childShadowRadius = layer->getChildShadowRadius();
+            for (const sp<Layer>& child : layer->mDrawingChildren) {
+                next.push_back({child.get(), layer->mBounds, layer->mEffectiveTransform,
+                                childShadowRadius});
+            }
+        }
+        subtrees = std::move(next);
+    }
+
+    workerPool.parallelFor(subtrees.size(), [&](size_t i) {
+        const Subtree& subtree = subtrees[i];
+        subtree.root->computeBounds(subtree.parentBounds, subtree.parentTransform,
+                                    subtree.parentShadowRadius);
+    });
+}
+
+bool Layer::computeBoundsWithoutChildren(FloatRect parentBounds, ui::Transform parentTransform,
+                                         float parentShadowRadius) {
+    if (!mBoundsDirty && parentBounds == mBoundsParentBounds &&
+        parentTransform == mBoundsParentTransform &&
+        parentShadowRadius == mBoundsParentShadowRadius) {
+        // The cached bounds are still valid, only the children could have changed.
+        const bool childBoundsDirty = mChildBoundsDirty;
+        mChildBoundsDirty = false;
+        return childBoundsDirty;
+    }
+
+    mBoundsParentBounds = parentBounds;
+    mBoundsParentTransform = parentTransform;
+    mBoundsParentShadowRadius = parentShadowRadius;
+    mBoundsDirty = false;
+    mChildBoundsDirty = false;
+
     const State& s(getDrawingState());
 
     // Calculate effective layer transform
@@ -358,13 +442,20 @@ void Layer::computeBounds(FloatRect parentBounds, ui::Transform parentTransform,
     } else {
         mEffectiveShadowRadius = parentShadowRadius;
     }
+    return true;
+}
 
+float Layer::getChildShadowRadius() const {
     // Shadow radius is passed down to only one layer so if the layer can draw shadows,
     // don't pass it to its children.
-    const float childShadowRadius = canDrawShadows() ? 0.f : mEffectiveShadowRadius;
+    return canDrawShadows() ? 0.f : mEffectiveShadowRadius;
+}
 
-    for (const sp<Layer>& child : mDrawingChildren) {
-        child->computeBounds(mBounds, mEffectiveTransform, childShadowRadius);
+void Layer::invalidateBounds() {
+    mBoundsDirty = true;
+    for (sp<Layer> parent = mDrawingParent.promote(); parent != nullptr && !parent->mChildBoundsDirty;
+         parent = parent->mDrawingParent.promote()) {
+        parent->mChildBoundsDirty = true;
     }
 }
 
@@ -692,6 +783,9 @@ uint32_t Layer::doTransaction(uint32_t flags) {
     mDrawingStateModified = mDrawingState.modified;
     mDrawingState.modified = false;
 
+    // Anything the bounds depend on may have changed.
+    invalidateBounds();
+
     const State& s(getDrawingState());
 
     if (updateGeometry()) {
@@ -779,6 +873,7 @@ bool Layer::setLayer(int32_t z) {
     if (mDrawingState.z == z && !usingRelativeZ(LayerVector::StateSet::Current)) return false;
     mDrawingState.sequence++;
     mDrawingState.z = z;
+    invalidateTraversalLists();
     mDrawingState.modified = true;
 
     mFlinger->mSomeChildrenChanged = true;
@@ -797,6 +892,7 @@ bool Layer::setLayer(int32_t z) {
 
 void Layer::removeZOrderRelative(const wp<Layer>& relative) {
     mDrawingState.zOrderRelatives.remove(relative);
+    invalidateTraversalLists();
     mDrawingState.sequence++;
     mDrawingState.modified = true;
     setTransactionFlags(eTransactionNeeded);
@@ -804,6 +900,7 @@ void Layer::removeZOrderRelative(const wp<Layer>& relative) {
 
 void Layer::addZOrderRelative(const wp<Layer>& relative) {
     mDrawingState.zOrderRelatives.add(relative);
+    invalidateTraversalLists();
     mDrawingState.modified = true;
     mDrawingState.sequence++;
     setTransactionFlags(eTransactionNeeded);
@@ -814,6 +911,7 @@ void Layer::setZOrderRelativeOf(const wp<Layer>& relativeOf) {
     mDrawingState.sequence++;
     mDrawingState.modified = true;
     mDrawingState.isRelativeOf = relativeOf != nullptr;
+    invalidateTraversalLists();
 
     setTransactionFlags(eTransactionNeeded);
 }
@@ -838,6 +936,7 @@ bool Layer::setRelativeLayer(const sp<IBinder>& relativeToHandle, int32_t relati
     mDrawingState.sequence++;
     mDrawingState.modified = true;
     mDrawingState.z = relativeZ;
+    invalidateTraversalLists();
 
     auto oldZOrderRelativeOf = mDrawingState.zOrderRelativeOf.promote();
     if (oldZOrderRelativeOf != nullptr) {
@@ -1014,6 +1113,7 @@ bool Layer::setLayerStack(uint32_t layerStack) {
     mDrawingState.sequence++;
     mDrawingState.layerStack = layerStack;
     mDrawingState.modified = true;
+    invalidateTraversalLists();
     setTransactionFlags(eTransactionNeeded);
     return true;
 }
@@ -1579,6 +1679,7 @@ void Layer::addChild(const sp<Layer>& layer) {
     setTransactionFlags(eTransactionNeeded);
 
     mCurrentChildren.add(layer);
+    invalidateTraversalLists();
     layer->setParent(this);
     layer->setGameModeForTree(mGameMode);
     updateTreeHasFrameRateVote();
@@ -1590,6 +1691,7 @@ ssize_t Layer::removeChild(const sp<Layer>& layer) {
 
     layer->setParent(nullptr);
     const auto removeResult = mCurrentChildren.remove(layer);
+    invalidateTraversalLists();
 
     updateTreeHasFrameRateVote();
     layer->setGameModeForTree(0);
@@ -1722,10 +1824,46 @@ __attribute__((no_sanitize("unsigned-integer-overflow"))) LayerVector Layer::mak
     return traverse;
 }
 
+const std::vector<Layer*>* Layer::getCachedTraversalList(LayerVector::StateSet stateSet) {
+    if (std::this_thread::get_id() != mFlinger->mMainThreadId) {
+        return nullptr;
+    }
+
+    TraversalList& list = mTraversalLists[stateSet == LayerVector::StateSet::Drawing ? 1 : 0];
+    const uint64_t generation = sTraversalGeneration;
+    if (list.generation != generation) {
+        bool skipRelativeZUsers = false;
+        const LayerVector layers = makeTraversalList(stateSet, &skipRelativeZUsers);
+        list.layers.clear();
+        list.layers.reserve(layers.size());
+        for (const sp<Layer>& layer : layers) {
+            if (skipRelativeZUsers && layer->usingRelativeZ(stateSet)) {
+                continue;
+            }
+            list.layers.push_back(layer.get());
+        }
+        list.generation = generation;
+    }
+    return &list.layers;
+}
+
 /**
  * Negatively signed relatives are before 'this' in Z-order.
  */
 void Layer::traverseInZOrder(LayerVector::StateSet stateSet, const LayerVector::Visitor& visitor) {
+    // Visitors don't change the hierarchy, so the cached list stays valid while it is traversed.
+    if (const std::vector<Layer*>* list = getCachedTraversalList(stateSet)) {
+        size_t i = 0;
+        for (; i < list->size() && (*list)[i]->getZ(stateSet) < 0; i++) {
+            (*list)[i]->traverseInZOrder(stateSet, visitor);
+        }
+        visitor(this);
+        for (; i < list->size(); i++) {
+            (*list)[i]->traverseInZOrder(stateSet, visitor);
+        }
+        return;
+    }
+
     // In the case we have other layers who are using a relative Z to us, makeTraversalList will
     // produce a new list for traversing, including our relatives, and not including our children
     // who are relatives of another surface. In the case that there are no relative Z,
@@ -1764,6 +1902,18 @@ void Layer::traverseInZOrder(LayerVector::StateSet stateSet, const LayerVector::
  */
 void Layer::traverseInReverseZOrder(LayerVector::StateSet stateSet,
                                     const LayerVector::Visitor& visitor) {
+    if (const std::vector<Layer*>* list = getCachedTraversalList(stateSet)) {
+        auto i = static_cast<int64_t>(list->size()) - 1;
+        for (; i >= 0 && (*list)[i]->getZ(stateSet) >= 0; i--) {
+            (*list)[i]->traverseInReverseZOrder(stateSet, visitor);
+        }
+        visitor(this);
+        for (; i >= 0; i--) {
+            (*list)[i]->traverseInReverseZOrder(stateSet, visitor);
+        }
+        return;
+    }
+
     // See traverseInZOrder for documentation.
     bool skipRelativeZUsers = false;
     LayerVector list = makeTraversalList(stateSet, &skipRelativeZUsers);
@@ -1980,8 +2130,18 @@ void Layer::commitChildList() {
     for (size_t i = 0; i < mCurrentChildren.size(); i++) {
         const auto& child = mCurrentChildren[i];
         child->commitChildList();
+        // Children are committed first, so this also covers new and reparented children.
+        if (child->mBoundsDirty || child->mChildBoundsDirty) {
+            mChildBoundsDirty = true;
+        }
+    }
+    if (mDrawingChildren.array() != mCurrentChildren.array()) {
+        invalidateTraversalLists();
     }
     mDrawingChildren = mCurrentChildren;
+    if (mDrawingParent != mCurrentParent) {
+        mBoundsDirty = true;
+    }
     mDrawingParent = mCurrentParent;
 }
 
@@ -2403,6 +2563,9 @@ void Layer::updateMirrorInfo() {
         return;
     }
 
+    // Mirroring copies the drawing state and children of the clones wholesale.
+    invalidateTraversalLists();
+
     std::map<sp<Layer>, sp<Layer>> clonedLayersMap;
     // If the real layer exists and is in current state, add the clone as a child of the root.
     // There's no need to remove from drawingState when the layer is offscreen since currentState is
@@ -2425,6 +2588,7 @@ void Layer::updateClonedDrawingState(std::map<sp<Layer>, sp<Layer>>& clonedLayer
         sp<Layer> clonedFrom = getClonedFrom();
         mDrawingState = clonedFrom->mDrawingState;
         clonedLayersMap.emplace(clonedFrom, this);
+        invalidateBounds();
     }
 
     // The clone layer may have children in drawingState since they may have been created and
@@ -2516,7 +2680,9 @@ void Layer::updateClonedRelatives(const std::map<sp<Layer>, sp<Layer>>& clonedLa
 
 void Layer::addChildToDrawing(const sp<Layer>& layer) {
     mDrawingChildren.add(layer);
+    invalidateTraversalLists();
     layer->mDrawingParent = this;
+    layer->invalidateBounds();
 }
 
 Layer::FrameRateCompatibility Layer::FrameRate::convertCompatibility(int8_t compatibility) {
@@ -38,6 +38,7 @@
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -72,6 +73,7 @@ class LayerDebugInfo;
 
 namespace compositionengine {
 class OutputLayer;
+class WorkerPool;
 struct LayerFECompositionState;
 }
 
@@ -648,8 +650,13 @@ public:
     FloatRect getBounds(const Region& activeTransparentRegion) const;
     FloatRect getBounds() const;
 
-    // Compute bounds for the layer and cache the results.
+    // Compute bounds for the layer and cache the results. Layers whose inputs are unchanged since
+    // the last call keep their cached results, and subtrees with nothing invalidated are skipped.
     void computeBounds(FloatRect parentBounds, ui::Transform parentTransform, float shadowRadius);
+    // Same as calling computeBounds on each of 'roots', which must not be in each other's
+    // trees, but with independent subtrees computed on 'workerPool'.
+    static void computeBounds(const std::vector<Layer*>& roots, FloatRect parentBounds,
+                              compositionengine::WorkerPool& workerPool);
 
     int32_t getSequence() const override { return sequence; }
 
@@ -943,6 +950,12 @@ protected:
     void setupRoundedCornersCropCoordinates(Rect win, const FloatRect& roundedCornersCrop) const;
     void setParent(const sp<Layer>&);
     LayerVector makeTraversalList(LayerVector::StateSet, bool* outSkipRelativeZUsers);
+    // Returns the layers traverseInZOrder visits around this one, from makeTraversalList, as
+    // long as no layer was added, removed or moved in Z since the last traversal. nullptr off the
+    // main thread, where the list is not cached.
+    const std::vector<Layer*>* getCachedTraversalList(LayerVector::StateSet);
+    // Called whenever a change to a layer can change the lists makeTraversalList returns.
+    static void invalidateTraversalLists() { sTraversalGeneration++; }
     void addZOrderRelative(const wp<Layer>& relative);
     void removeZOrderRelative(const wp<Layer>& relative);
     compositionengine::OutputLayer* findOutputLayerForDisplay(const DisplayDevice*) const;
@@ -961,6 +974,15 @@ protected:
     // These are only accessed by the main thread or the tracing thread.
     State mDrawingState;
 
+    // Traversal lists for the current and drawing children, only used by the main thread. A list
+    // is valid while its generation matches sTraversalGeneration.
+    struct TraversalList {
+        uint64_t generation = 0;
+        std::vector<Layer*> layers;
+    };
+    TraversalList mTraversalLists[2];
+    static std::atomic<uint64_t> sTraversalGeneration;
+
     uint32_t mTransactionFlags{0};
     // Updated in doTransaction, used to track the last sequence number we
     // committed. Currently this is really only used for updating visible
@@ -1024,12 +1046,23 @@ protected:
 
     mutable bool mDrawingStateModified = false;
 
+    // Marks the cached bounds of this layer stale, so the next computeBounds recomputes them even
+    // if the parent's are unchanged. Called when anything in the layer the bounds depend on changes.
+    void invalidateBounds();
+
 private:
     virtual void setTransformHint(ui::Transform::RotationFlags) {}
 
     // Returns true if the layer can draw shadows on its border.
     virtual bool canDrawShadows() const { return true; }
 
+    // Computes the bounds of this layer only, unless they are still valid for these inputs. Returns
+    // true if computeBounds needs to visit the children.
+    bool computeBoundsWithoutChildren(FloatRect parentBounds, ui::Transform parentTransform,
+                                      float parentShadowRadius);
+    // Shadow radius passed on to the children, once the bounds have been computed.
+    float getChildShadowRadius() const;
+
     Hwc2::IComposerClient::Composition getCompositionType(const DisplayDevice&) const;
 
     /**
@@ -1101,6 +1134,17 @@ private:
     // shadow radius is the set shadow radius, otherwise its the parent's shadow radius.
     float mEffectiveShadowRadius = 0.f;
 
+    // Inputs of the last computeBounds call, which the cached properties above are valid for
+    // unless mBoundsDirty is set.
+    FloatRect mBoundsParentBounds;
+    ui::Transform mBoundsParentTransform;
+    float mBoundsParentShadowRadius = 0.f;
+    // Set when the state of this layer changed since its bounds were last computed.
+    bool mBoundsDirty = true;
+    // Set when a layer under this one needs its bounds computed. Always set on the ancestors of a
+    // layer with mBoundsDirty or mChildBoundsDirty set.
+    bool mChildBoundsDirty = false;
+
     // Game mode for the layer. Set by WindowManagerShell, game mode is used in
     // metrics(SurfaceFlingerStats).
     int32_t mGameMode = 0;
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace android {
+
+// A queue which any number of threads can push to without taking a lock, and which a single
+// thread empties all at once. Values come out in the order they were pushed in, so values pushed
+// by any one thread keep their order.
+template <typename T>
+class LocklessQueue {
+public:
+    LocklessQueue() = default;
+    LocklessQueue(const LocklessQueue&) = delete;
+    LocklessQueue& operator=(const LocklessQueue&) = delete;
+
+    ~LocklessQueue() {
+        drain([](T&&) {});
+    }
+
+    // Can be called from any thread.
+    void push(T value) {
+        Node* node = new Node{std::move(value), mHead.load(std::memory_order_relaxed)};
+        while (!mHead.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    bool isEmpty() const { return mHead.load(std::memory_order_relaxed) == nullptr; }
+
+    // Removes everything pushed so far and passes each value to 'consume', oldest first. Only one
+    // thread may drain the queue at a time.
+    template <typename Consumer>
+    void drain(Consumer&& consume) {
+        // Nodes are pushed onto the front of the list, so take the whole list and reverse it.
+        Node* node = mHead.exchange(nullptr, std::memory_order_acquire);
+        Node* oldest = nullptr;
+        while (node != nullptr) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+
+        while (oldest != nullptr) {
+            Node* next = oldest->next;
+            consume(std::move(oldest->value));
+            delete oldest;
+            oldest = next;
+        }
+    }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> mHead = nullptr;
+};
+
+} // namespace android
@@ -19,6 +19,8 @@
 #pragma clang diagnostic ignored "-Wconversion"
 #pragma clang diagnostic ignored "-Wextra"
 
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
 #include <algorithm>
 
 #include "RefreshRateOverlay.h"
@@ -26,6 +28,7 @@
 #include "Layer.h"
 
 #include <gui/IProducerListener.h>
+#include <utils/Trace.h>
 
 #undef LOG_TAG
 #define LOG_TAG "RefreshRateOverlay"
@@ -211,13 +214,15 @@ bool RefreshRateOverlay::createLayer() {
 
 const std::vector<std::shared_ptr<renderengine::ExternalTexture>>&
 RefreshRateOverlay::getOrCreateBuffers(uint32_t fps) {
+    // Clip values outside the range [mLowFps, mHighFps]. The current fps may be outside
+    // of this range if the display has changed its set of supported refresh rates. The cache is
+    // keyed by the clipped value, so that such a value is not drawn again on every frame.
+    fps = std::max(fps, mLowFps);
+    fps = std::min(fps, mHighFps);
     if (mBufferCache.find(fps) == mBufferCache.end()) {
+        ATRACE_NAME("RefreshRateOverlay::drawBuffers");
         // Ensure the range is > 0, so we don't divide by 0.
         const auto rangeLength = std::max(1u, mHighFps - mLowFps);
-        // Clip values outside the range [mLowFps, mHighFps]. The current fps may be outside
-        // of this range if the display has changed its set of supported refresh rates.
-        fps = std::max(fps, mLowFps);
-        fps = std::min(fps, mHighFps);
         const auto fpsScale = static_cast<float>(fps - mLowFps) / rangeLength;
         half4 color;
         color.r = HIGH_FPS_COLOR.r * fpsScale + LOW_FPS_COLOR.r * (1 - fpsScale);
@@ -279,11 +284,23 @@ void RefreshRateOverlay::onInvalidate() {
     mFlinger.mTransactionFlags.fetch_or(eTransactionMask);
 }
 
+// Draws the buffers of every refresh rate of the display up front, so that a mode change only
+// swaps buffers, rather than allocating and drawing them on the main thread, and delaying the
+// first frames at the new rate. Other values, e.g. from a display without modes yet, are still
+// drawn on first use.
+void RefreshRateOverlay::prerenderBuffers() {
+    ATRACE_CALL();
+    for (const Fps& fps : mFlinger.mRefreshRateConfigs->getSupportedRefreshRates()) {
+        getOrCreateBuffers(fps.getIntValue());
+    }
+}
+
 void RefreshRateOverlay::reset() {
     mBufferCache.clear();
     const auto range = mFlinger.mRefreshRateConfigs->getSupportedRefreshRateRange();
     mLowFps = range.min.getIntValue();
     mHighFps = range.max.getIntValue();
+    prerenderBuffers();
 }
 
 } // namespace android
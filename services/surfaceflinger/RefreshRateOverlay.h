@@ -73,6 +73,7 @@ private:
     bool createLayer();
     const std::vector<std::shared_ptr<renderengine::ExternalTexture>>& getOrCreateBuffers(
             uint32_t fps);
+    void prerenderBuffers();
 
     SurfaceFlinger& mFlinger;
     const sp<Client> mClient;
@@ -35,6 +35,7 @@
 #include <ui/DisplayStatInfo.h>
 #include <utils/Trace.h>
 
+#include <cmath>
 #include <string>
 
 #include "DisplayDevice.h"
@@ -64,6 +65,13 @@ constexpr auto defaultRegionSamplingWorkDuration = 3ms;
 constexpr auto defaultRegionSamplingPeriod = 100ms;
 constexpr auto defaultRegionSamplingTimerTimeout = 100ms;
 constexpr auto maxRegionSamplingDelay = 100ms;
+// While the lumas don't change, the sampling period doubles up to this multiple of the tuned one
+constexpr int maxRegionSamplingPeriodMultiplier = 8;
+// The smallest change of a luma that counts as the sampled content changing
+constexpr float minRegionSamplingLumaChange = 0.01f;
+// The sampled region is rendered downscaled, so that its longest side has at most this many
+// pixels. RenderEngine filters the layers as it scales them, so that little is read back.
+constexpr int32_t maxRegionSamplingDimension = 64;
 // TODO: (b/127403193) duration to string conversion could probably be constexpr
 template <typename Rep, typename Per>
 inline std::string toNsString(std::chrono::duration<Rep, Per> t) {
@@ -105,7 +113,8 @@ RegionSamplingThread::RegionSamplingThread(SurfaceFlinger& flinger, const Timing
                 std::chrono::duration_cast<std::chrono::milliseconds>(
                         mTunables.mSamplingTimerTimeout),
                 [] {}, [this] { checkForStaleLuma(); }),
-        mLastSampleTime(0ns) {
+        mLastSampleTime(0ns),
+        mSamplingPeriod(mTunables.mSamplingPeriod) {
     mThread = std::thread([this]() { threadMain(); });
     pthread_setname_np(mThread.native_handle(), "RegionSampling");
     mIdleTimer.start();
@@ -142,6 +151,7 @@ void RegionSamplingThread::addListener(const Rect& samplingArea, const wp<Layer>
 void RegionSamplingThread::removeListener(const sp<IRegionSamplingListener>& listener) {
     std::lock_guard lock(mSamplingMutex);
     mDescriptors.erase(wp<IBinder>(IInterface::asBinder(listener)));
+    mLastLumas.erase(wp<IBinder>(IInterface::asBinder(listener)));
 }
 
 void RegionSamplingThread::checkForStaleLuma() {
@@ -163,11 +173,16 @@ void RegionSamplingThread::doSample(
         std::optional<std::chrono::steady_clock::time_point> samplingDeadline) {
     std::lock_guard lock(mThreadControlMutex);
     const auto now = std::chrono::steady_clock::now();
-    if (mLastSampleTime + mTunables.mSamplingPeriod > now) {
+    if (mLastSampleTime + mSamplingPeriod > now) {
         // content changed, but we sampled not too long ago, so we need to sample some time in the
         // future.
         ATRACE_INT(lumaSamplingStepTag, static_cast<int>(samplingStep::idleTimerWaiting));
         mSampleRequestTime = now;
+        // The idle timer fires once per sample, so it needs to check again if the period was
+        // lengthened beyond it.
+        if (mLastSampleTime + mTunables.mSamplingPeriod <= now) {
+            mIdleTimer.reset();
+        }
         return;
     }
     if (!mSampleRequestTime.has_value() || now - *mSampleRequestTime < maxRegionSamplingDelay) {
@@ -195,6 +210,7 @@ void RegionSamplingThread::doSample(
 void RegionSamplingThread::binderDied(const wp<IBinder>& who) {
     std::lock_guard lock(mSamplingMutex);
     mDescriptors.erase(who);
+    mLastLumas.erase(who);
 }
 
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
@@ -236,8 +252,21 @@ float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t st
     return accumulatedLuma / (255.0f * pixelCount);
 }
 
+Rect scaleSampleArea(const Rect& area, float scale, const ui::Size& scaledSize) {
+    Rect scaled(static_cast<int32_t>(std::floor(area.left * scale)),
+                static_cast<int32_t>(std::floor(area.top * scale)),
+                static_cast<int32_t>(std::ceil(area.right * scale)),
+                static_cast<int32_t>(std::ceil(area.bottom * scale)));
+    scaled.intersect(Rect(scaledSize), &scaled);
+    if (scaled.isEmpty()) {
+        scaled.right = std::min(scaled.left + 1, scaledSize.getWidth());
+        scaled.bottom = std::min(scaled.top + 1, scaledSize.getHeight());
+    }
+    return scaled;
+}
+
 std::vector<float> RegionSamplingThread::sampleBuffer(
-        const sp<GraphicBuffer>& buffer, const Point& leftTop,
+        const sp<GraphicBuffer>& buffer, const Point& leftTop, float scale,
         const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation) {
     void* data_raw = nullptr;
     buffer->lock(GRALLOC_USAGE_SW_READ_OFTEN, &data_raw);
@@ -252,11 +281,34 @@ std::vector<float> RegionSamplingThread::sampleBuffer(
     std::transform(descriptors.begin(), descriptors.end(), lumas.begin(),
                    [&](auto const& descriptor) {
                        return sampleArea(data.get(), width, height, stride, orientation,
-                                         descriptor.area - leftTop);
+                                         scaleSampleArea(descriptor.area - leftTop, scale,
+                                                         ui::Size(width, height)));
                    });
     return lumas;
 }
 
+void RegionSamplingThread::updateSamplingPeriod(const std::vector<Descriptor>& descriptors,
+                                                const std::vector<float>& lumas) {
+    bool lumasChanged = false;
+    for (size_t d = 0; d < descriptors.size(); ++d) {
+        const wp<IBinder> listener = IInterface::asBinder(descriptors[d].listener);
+        const auto lastLuma = mLastLumas.find(listener);
+        if (lastLuma == mLastLumas.end() ||
+            std::abs(lastLuma->second - lumas[d]) >= minRegionSamplingLumaChange) {
+            lumasChanged = true;
+        }
+        mLastLumas[listener] = lumas[d];
+    }
+
+    std::lock_guard lock(mThreadControlMutex);
+    if (lumasChanged) {
+        mSamplingPeriod = mTunables.mSamplingPeriod;
+    } else {
+        mSamplingPeriod = std::min(mSamplingPeriod * 2,
+                                   mTunables.mSamplingPeriod * maxRegionSamplingPeriodMultiplier);
+    }
+}
+
 void RegionSamplingThread::captureSample() {
     ATRACE_CALL();
     std::lock_guard lock(mSamplingMutex);
@@ -290,8 +342,17 @@ void RegionSamplingThread::captureSample() {
     const Rect sampledBounds = sampleRegion.bounds();
     constexpr bool kUseIdentityTransform = false;
 
+    const float scale = std::min(1.0f,
+                                 static_cast<float>(maxRegionSamplingDimension) /
+                                         std::max(sampledBounds.getWidth(),
+                                                  sampledBounds.getHeight()));
+    const ui::Size sampledSize(std::max(1, static_cast<int32_t>(
+                                                   std::round(sampledBounds.getWidth() * scale))),
+                               std::max(1, static_cast<int32_t>(
+                                                   std::round(sampledBounds.getHeight() * scale))));
+
     SurfaceFlinger::RenderAreaFuture renderAreaFuture = ftl::defer([=] {
-        return DisplayRenderArea::create(displayWeak, sampledBounds, sampledBounds.getSize(),
+        return DisplayRenderArea::create(displayWeak, sampledBounds, sampledSize,
                                          ui::Dataspace::V0_SRGB, kUseIdentityTransform);
     });
 
@@ -339,26 +400,28 @@ void RegionSamplingThread::captureSample() {
     };
 
     std::shared_ptr<renderengine::ExternalTexture> buffer = nullptr;
-    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledBounds.getWidth() &&
-        mCachedBuffer->getBuffer()->getHeight() == sampledBounds.getHeight()) {
+    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledSize.getWidth() &&
+        mCachedBuffer->getBuffer()->getHeight() == sampledSize.getHeight()) {
         buffer = mCachedBuffer;
     } else {
         const uint32_t usage =
                 GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
         sp<GraphicBuffer> graphicBuffer =
-                new GraphicBuffer(sampledBounds.getWidth(), sampledBounds.getHeight(),
+                new GraphicBuffer(sampledSize.getWidth(), sampledSize.getHeight(),
                                   PIXEL_FORMAT_RGBA_8888, 1, usage, "RegionSamplingThread");
         const status_t bufferStatus = graphicBuffer->initCheck();
         LOG_ALWAYS_FATAL_IF(bufferStatus != OK, "captureSample: Buffer failed to allocate: %d",
                             bufferStatus);
         buffer = std::make_shared<
                 renderengine::ExternalTexture>(graphicBuffer, mFlinger.getRenderEngine(),
-                                               renderengine::ExternalTexture::Usage::WRITEABLE);
+                                               renderengine::ExternalTexture::Usage::WRITEABLE,
+                                               renderengine::ExternalTexture::Owner::SCREENSHOT);
     }
 
     const sp<SyncScreenCaptureListener> captureListener = new SyncScreenCaptureListener();
     mFlinger.captureScreenCommon(std::move(renderAreaFuture), traverseLayers, buffer,
-                                 true /* regionSampling */, false /* grayscale */, captureListener);
+                                 true /* regionSampling */, false /* grayscale */,
+                                 false /* allowReadback */, captureListener);
     ScreenCaptureResults captureResults = captureListener->waitForResults();
 
     std::vector<Descriptor> activeDescriptors;
@@ -369,7 +432,7 @@ void RegionSamplingThread::captureSample() {
     }
 
     ALOGV("Sampling %zu descriptors", activeDescriptors.size());
-    std::vector<float> lumas = sampleBuffer(buffer->getBuffer(), sampledBounds.leftTop(),
+    std::vector<float> lumas = sampleBuffer(buffer->getBuffer(), sampledBounds.leftTop(), scale,
                                             activeDescriptors, orientation);
     if (lumas.size() != activeDescriptors.size()) {
         ALOGW("collected %zu median luma values for %zu descriptors", lumas.size(),
@@ -380,6 +443,7 @@ void RegionSamplingThread::captureSample() {
     for (size_t d = 0; d < activeDescriptors.size(); ++d) {
         activeDescriptors[d].listener->onSampleCollected(lumas[d]);
     }
+    updateSamplingPeriod(activeDescriptors, lumas);
 
     mCachedBuffer = buffer;
     ATRACE_INT(lumaSamplingStepTag, static_cast<int>(samplingStep::noWorkNeeded));
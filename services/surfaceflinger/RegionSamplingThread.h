@@ -21,6 +21,7 @@
 #include <renderengine/ExternalTexture.h>
 #include <ui/GraphicBuffer.h>
 #include <ui/Rect.h>
+#include <ui/Size.h>
 #include <utils/StrongPointer.h>
 
 #include <chrono>
@@ -42,6 +43,10 @@ struct SamplingOffsetCallback;
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
                  uint32_t orientation, const Rect& area);
 
+// Maps an area of the sampled region onto the sampled region rendered at the given scale, keeping
+// at least one pixel.
+Rect scaleSampleArea(const Rect& area, float scale, const ui::Size& scaledSize);
+
 class RegionSamplingThread : public IBinder::DeathRecipient {
 public:
     struct TimingTunables {
@@ -94,9 +99,14 @@ private:
         }
     };
     std::vector<float> sampleBuffer(
-            const sp<GraphicBuffer>& buffer, const Point& leftTop,
+            const sp<GraphicBuffer>& buffer, const Point& leftTop, float scale,
             const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation);
 
+    // Samples less often while the sampled lumas don't change, and at the tuned period again as
+    // soon as they do.
+    void updateSamplingPeriod(const std::vector<Descriptor>& descriptors,
+                              const std::vector<float>& lumas) REQUIRES(mSamplingMutex);
+
     void doSample(std::optional<std::chrono::steady_clock::time_point> samplingDeadline);
     void binderDied(const wp<IBinder>& who) override;
     void checkForStaleLuma();
@@ -117,11 +127,13 @@ private:
     std::optional<std::chrono::steady_clock::time_point> mSampleRequestTime
             GUARDED_BY(mThreadControlMutex);
     std::chrono::steady_clock::time_point mLastSampleTime GUARDED_BY(mThreadControlMutex);
+    std::chrono::nanoseconds mSamplingPeriod GUARDED_BY(mThreadControlMutex);
 
     std::mutex mSamplingMutex;
     std::unordered_map<wp<IBinder>, Descriptor, WpHash> mDescriptors GUARDED_BY(mSamplingMutex);
     std::shared_ptr<renderengine::ExternalTexture> mCachedBuffer GUARDED_BY(mSamplingMutex) =
             nullptr;
+    std::unordered_map<wp<IBinder>, float, WpHash> mLastLumas GUARDED_BY(mSamplingMutex);
 };
 
 } // namespace android
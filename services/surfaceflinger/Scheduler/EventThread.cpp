@@ -76,8 +76,8 @@ std::string toString(VSyncRequest request) {
 }
 
 std::string toString(const EventThreadConnection& connection) {
-    return StringPrintf("Connection{%p, %s}", &connection,
-                        toString(connection.vsyncRequest).c_str());
+    return StringPrintf("Connection{%p, %s, dropped=%u}", &connection,
+                        toString(connection.vsyncRequest).c_str(), connection.droppedEventCount);
 }
 
 std::string toString(const DisplayEventReceiver::Event& event) {
@@ -396,12 +396,15 @@ void EventThread::onFrameRateOverridesChanged(PhysicalDisplayId displayId,
 }
 
 size_t EventThread::getEventThreadConnectionCount() {
+    // Wait for an ongoing dispatch, which removes the connections that failed to receive it.
+    std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
     std::lock_guard<std::mutex> lock(mMutex);
     return mDisplayEventConnections.size();
 }
 
 void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
     DisplayEventConsumers consumers;
+    std::vector<status_t> results;
 
     while (mState != State::Quit) {
         std::optional<DisplayEventReceiver::Event> event;
@@ -448,8 +451,17 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
         }
 
         if (!consumers.empty()) {
-            dispatchEvent(*event, consumers);
+            dispatchEvent(*event, consumers, results, lock);
             consumers.clear();
+
+            // The lock was released while the event was sent, so connections may have requested
+            // VSYNC, or stopped requesting it, in the meantime.
+            vsyncRequested = false;
+            for (const auto& weakConnection : mDisplayEventConnections) {
+                if (const auto connection = weakConnection.promote()) {
+                    vsyncRequested |= connection->vsyncRequest != VSyncRequest::None;
+                }
+            }
         }
 
         State nextState;
@@ -569,26 +581,58 @@ bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
 }
 
 void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
-                                const DisplayEventConsumers& consumers) {
-    for (const auto& consumer : consumers) {
-        DisplayEventReceiver::Event copy = event;
-        if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
-            copy.vsync.frameInterval = mGetVsyncPeriodFunction(consumer->mOwnerUid);
+                                const DisplayEventConsumers& consumers,
+                                std::vector<status_t>& results,
+                                std::unique_lock<std::mutex>& lock) {
+    // Send without holding mMutex, so that a slow consumer does not stall clients registering
+    // or requesting vsync. The consumers were already decided under the lock, and hold strong
+    // references, so they stay valid. BitTube writes are non-blocking, so a consumer with a full
+    // socket buffer fails with -EAGAIN rather than delaying the others.
+    lock.unlock();
+    {
+        std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+        sendEvent(event, consumers, results);
+
+        lock.lock();
+        for (size_t i = 0; i < consumers.size(); i++) {
+            const auto& consumer = consumers[i];
+            switch (results[i]) {
+                case NO_ERROR:
+                    break;
+
+                case -EAGAIN:
+                    // TODO: Try again if pipe is full.
+                    consumer->droppedEventCount++;
+                    ALOGW("Failed dispatching %s for %s", toString(event).c_str(),
+                          toString(*consumer).c_str());
+                    break;
+
+                default:
+                    // Treat EPIPE and other errors as fatal.
+                    removeDisplayEventConnectionLocked(consumer);
+            }
         }
-        switch (consumer->postEvent(copy)) {
-            case NO_ERROR:
-                break;
-
-            case -EAGAIN:
-                // TODO: Try again if pipe is full.
-                ALOGW("Failed dispatching %s for %s", toString(event).c_str(),
-                      toString(*consumer).c_str());
-                break;
-
-            default:
-                // Treat EPIPE and other errors as fatal.
-                removeDisplayEventConnectionLocked(consumer);
+    }
+}
+
+void EventThread::sendEvent(const DisplayEventReceiver::Event& event,
+                            const DisplayEventConsumers& consumers,
+                            std::vector<status_t>& results) const {
+    results.resize(consumers.size());
+
+    // The payload is built once and shared by all consumers, which only differ in the frame
+    // interval of their uid. Consecutive consumers of the same uid reuse the last lookup.
+    DisplayEventReceiver::Event payload = event;
+    const bool isVsync = event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
+    std::optional<uid_t> frameIntervalUid;
+
+    for (size_t i = 0; i < consumers.size(); i++) {
+        const auto& consumer = consumers[i];
+        if (isVsync && frameIntervalUid != consumer->mOwnerUid) {
+            payload.vsync.frameInterval = mGetVsyncPeriodFunction(consumer->mOwnerUid);
+            frameIntervalUid = consumer->mOwnerUid;
         }
+        results[i] = consumer->postEvent(payload);
     }
 }
 
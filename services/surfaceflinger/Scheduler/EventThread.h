@@ -96,6 +96,8 @@ public:
     const ResyncCallback resyncCallback;
 
     VSyncRequest vsyncRequest = VSyncRequest::None;
+    // Number of events that could not be sent because the channel was full.
+    uint32_t droppedEventCount = 0;
     const uid_t mOwnerUid;
     const ISurfaceComposer::EventRegistrationFlags mEventRegistration;
 
@@ -196,8 +198,13 @@ private:
 
     bool shouldConsumeEvent(const DisplayEventReceiver::Event& event,
                             const sp<EventThreadConnection>& connection) const REQUIRES(mMutex);
+    // Sends the event to the consumers with mMutex released, then handles delivery errors.
     void dispatchEvent(const DisplayEventReceiver::Event& event,
-                       const DisplayEventConsumers& consumers) REQUIRES(mMutex);
+                       const DisplayEventConsumers& consumers, std::vector<status_t>& results,
+                       std::unique_lock<std::mutex>& lock) REQUIRES(mMutex);
+    void sendEvent(const DisplayEventReceiver::Event& event,
+                   const DisplayEventConsumers& consumers, std::vector<status_t>& results) const
+            REQUIRES(mDispatchMutex);
 
     void removeDisplayEventConnectionLocked(const wp<EventThreadConnection>& connection)
             REQUIRES(mMutex);
@@ -218,6 +225,9 @@ private:
     mutable std::mutex mMutex;
     mutable std::condition_variable mCondition;
 
+    // Held while events are sent outside of mMutex. Acquired before mMutex.
+    std::mutex mDispatchMutex;
+
     std::vector<wp<EventThreadConnection>> mDisplayEventConnections GUARDED_BY(mMutex);
     std::deque<DisplayEventReceiver::Event> mPendingEvents GUARDED_BY(mMutex);
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IdleGapHistory.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+
+namespace android::scheduler {
+
+IdleGapHistory::IdleGapHistory(Duration baseTimeout, Duration maxTimeout, Duration switchCost)
+      : mBaseTimeout(baseTimeout),
+        mMaxTimeout(std::max(baseTimeout, maxTimeout)),
+        mSwitchCost(switchCost),
+        mTimeoutInEffect(baseTimeout) {}
+
+IdleGapHistory::Duration IdleGapHistory::recordGap(uid_t uid, Duration gap) {
+    if (gap < mBaseTimeout) {
+        return selectTimeout(uid);
+    }
+
+    std::lock_guard lock(mLock);
+
+    UidHistory& history = getHistoryLocked(uid);
+    for (Stats* stats : {&history.stats, &mTotalStats}) {
+        stats->gaps++;
+        if (gap > mTimeoutInEffect) {
+            stats->downshifts++;
+            stats->idleTime += gap - mTimeoutInEffect;
+            if (gap - mTimeoutInEffect < mSwitchCost) {
+                stats->wastedDownshifts++;
+            }
+        } else if (gap > mBaseTimeout) {
+            stats->avoidedDownshifts++;
+        }
+        stats->baseIdleTime += gap - mBaseTimeout;
+    }
+
+    history.gaps.push_back(gap);
+    history.timeout = computeTimeoutLocked(history);
+    mTimeoutInEffect = history.timeout;
+    return history.timeout;
+}
+
+IdleGapHistory::Duration IdleGapHistory::selectTimeout(uid_t uid) {
+    std::lock_guard lock(mLock);
+
+    const auto it = mHistories.find(uid);
+    mTimeoutInEffect = it != mHistories.end() ? it->second.timeout : mBaseTimeout;
+    return mTimeoutInEffect;
+}
+
+void IdleGapHistory::clear() {
+    std::lock_guard lock(mLock);
+    mHistories.clear();
+    mTimeoutInEffect = mBaseTimeout;
+    mTotalStats = {};
+}
+
+IdleGapHistory::Stats IdleGapHistory::getStats() const {
+    std::lock_guard lock(mLock);
+    return mTotalStats;
+}
+
+IdleGapHistory::UidHistory& IdleGapHistory::getHistoryLocked(uid_t uid) {
+    auto it = mHistories.find(uid);
+    if (it == mHistories.end()) {
+        if (mHistories.size() >= kMaxUids) {
+            // Forget the uid that has gone idle least recently.
+            mHistories.erase(std::min_element(mHistories.begin(), mHistories.end(),
+                                              [](const auto& lhs, const auto& rhs) {
+                                                  return lhs.second.lastUpdate <
+                                                          rhs.second.lastUpdate;
+                                              }));
+        }
+        it = mHistories.try_emplace(uid).first;
+        it->second.timeout = mBaseTimeout;
+    }
+    it->second.lastUpdate = ++mUpdateCount;
+    return it->second;
+}
+
+IdleGapHistory::Duration IdleGapHistory::computeTimeoutLocked(const UidHistory& history) const {
+    if (history.gaps.size() < kMinGapsToLearn) {
+        return mBaseTimeout;
+    }
+
+    // The savings only change where the timeout crosses a gap, so the candidates are the base
+    // timeout and timeouts just past each gap, with some slack for jitter.
+    Duration bestTimeout = mBaseTimeout;
+    Duration bestSavings = netSavings(history, mBaseTimeout);
+    for (size_t i = 0; i < history.gaps.size(); i++) {
+        const Duration gap = history.gaps[i];
+        const Duration candidate = std::min(gap + gap / 4, mMaxTimeout);
+        if (candidate <= mBaseTimeout) continue;
+
+        const Duration savings = netSavings(history, candidate);
+        if (savings > bestSavings || (savings == bestSavings && candidate < bestTimeout)) {
+            bestTimeout = candidate;
+            bestSavings = savings;
+        }
+    }
+    return bestTimeout;
+}
+
+IdleGapHistory::Duration IdleGapHistory::netSavings(const UidHistory& history,
+                                                    Duration timeout) const {
+    Duration savings{0};
+    for (size_t i = 0; i < history.gaps.size(); i++) {
+        const Duration gap = history.gaps[i];
+        if (gap > timeout) {
+            savings += gap - timeout - mSwitchCost;
+        }
+    }
+    return savings;
+}
+
+std::string IdleGapHistory::dump() const {
+    using base::StringAppendF;
+
+    std::lock_guard lock(mLock);
+
+    const auto appendStats = [](std::string& result, const Stats& stats) {
+        StringAppendF(&result,
+                      "gaps=%zu downshifts=%zu (avoided=%zu wasted=%zu) "
+                      "idle=%lldms (with base timeout: %lldms)\n",
+                      stats.gaps, stats.downshifts, stats.avoidedDownshifts,
+                      stats.wastedDownshifts, static_cast<long long>(stats.idleTime.count()),
+                      static_cast<long long>(stats.baseIdleTime.count()));
+    };
+
+    std::string result;
+    StringAppendF(&result, "Idle gap history: base=%lldms max=%lldms in effect=%lldms\n",
+                  static_cast<long long>(mBaseTimeout.count()),
+                  static_cast<long long>(mMaxTimeout.count()),
+                  static_cast<long long>(mTimeoutInEffect.count()));
+    result.append("  total: ");
+    appendStats(result, mTotalStats);
+    for (const auto& [uid, history] : mHistories) {
+        StringAppendF(&result, "  uid %d: timeout=%lldms ", uid,
+                      static_cast<long long>(history.timeout.count()));
+        appendStats(result, history.stats);
+    }
+    return result;
+}
+
+} // namespace android::scheduler
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+
+#include "RingBuffer.h"
+
+namespace android::scheduler {
+
+// Learns how long each uid leaves the display idle between updates, and picks the idle timer
+// timeout for that uid. Pauses that end shortly after the timeout cost a switch down to the idle
+// refresh rate and back up without saving much, so the timeout is stretched past the pauses the
+// uid usually takes, as long as doing so saves more idle time than it gives up.
+class IdleGapHistory {
+public:
+    using Duration = std::chrono::milliseconds;
+
+    // Idle gaps shorter than baseTimeout never expire the timer, so they are not recorded.
+    // switchCost is the idle time a round trip to the idle refresh rate must save to pay off.
+    IdleGapHistory(Duration baseTimeout, Duration maxTimeout, Duration switchCost);
+
+    Duration getBaseTimeout() const { return mBaseTimeout; }
+
+    // Records an idle gap of the given uid, and returns the timeout to use for its next gap.
+    Duration recordGap(uid_t uid, Duration gap) EXCLUDES(mLock);
+
+    // Returns the timeout to use for the given uid, which becomes the timeout in effect.
+    Duration selectTimeout(uid_t uid) EXCLUDES(mLock);
+
+    void clear() EXCLUDES(mLock);
+
+    struct Stats {
+        // Number of recorded gaps, and how many of them expired the timer in effect.
+        size_t gaps = 0;
+        size_t downshifts = 0;
+        // Downshifts that would have happened with the base timeout but were avoided.
+        size_t avoidedDownshifts = 0;
+        // Downshifts that lasted less than the switch cost.
+        size_t wastedDownshifts = 0;
+        // Time spent at the idle refresh rate, and what it would have been with the base timeout.
+        Duration idleTime{0};
+        Duration baseIdleTime{0};
+    };
+
+    Stats getStats() const EXCLUDES(mLock);
+    std::string dump() const EXCLUDES(mLock);
+
+private:
+    static constexpr size_t kMaxGaps = 16;
+    static constexpr size_t kMinGapsToLearn = 4;
+    static constexpr size_t kMaxUids = 32;
+
+    struct UidHistory {
+        RingBuffer<Duration, kMaxGaps> gaps;
+        Duration timeout{0};
+        Stats stats;
+        size_t lastUpdate = 0;
+    };
+
+    UidHistory& getHistoryLocked(uid_t uid) REQUIRES(mLock);
+    Duration computeTimeoutLocked(const UidHistory&) const REQUIRES(mLock);
+
+    // Idle time saved by the given timeout over the recorded gaps, net of the switch cost.
+    Duration netSavings(const UidHistory&, Duration timeout) const;
+
+    const Duration mBaseTimeout;
+    const Duration mMaxTimeout;
+    const Duration mSwitchCost;
+
+    mutable std::mutex mLock;
+    std::unordered_map<uid_t, UidHistory> mHistories GUARDED_BY(mLock);
+    Duration mTimeoutInEffect GUARDED_BY(mLock);
+    size_t mUpdateCount GUARDED_BY(mLock) = 0;
+    Stats mTotalStats GUARDED_BY(mLock);
+};
+
+} // namespace android::scheduler
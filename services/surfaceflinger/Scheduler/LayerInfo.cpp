@@ -60,14 +60,21 @@ void LayerInfo::setLastPresentTime(nsecs_t lastPresentTime, nsecs_t now, LayerUp
             FrameTimeData frameTime = {.presentTime = lastPresentTime,
                                        .queueTime = mLastUpdatedTime,
                                        .pendingModeChange = pendingModeChange};
-            mFrameTimes.push_back(frameTime);
-            if (mFrameTimes.size() > HISTORY_SIZE) {
-                mFrameTimes.pop_front();
-            }
+            addFrameTime(frameTime);
             break;
     }
 }
 
+void LayerInfo::addFrameTime(const FrameTimeData& frameTime) {
+    mFrameTimes.push_back(frameTime);
+    mCachedAverageFrameTime.reset();
+}
+
+void LayerInfo::clearFrameTimes() {
+    mFrameTimes.clear();
+    mCachedAverageFrameTime.reset();
+}
+
 bool LayerInfo::isFrameTimeValid(const FrameTimeData& frameTime) const {
     return frameTime.queueTime >= std::chrono::duration_cast<std::chrono::nanoseconds>(
                                           mFrameTimeValidSince.time_since_epoch())
@@ -82,21 +89,20 @@ bool LayerInfo::isFrequent(nsecs_t now) const {
     }
 
     // Find the first active frame
-    auto it = mFrameTimes.begin();
-    for (; it != mFrameTimes.end(); ++it) {
-        if (it->queueTime >= getActiveLayerThreshold(now)) {
-            break;
-        }
+    const nsecs_t threshold = getActiveLayerThreshold(now);
+    size_t first = 0;
+    while (first < mFrameTimes.size() && mFrameTimes[first].queueTime < threshold) {
+        first++;
     }
 
-    const auto numFrames = std::distance(it, mFrameTimes.end());
+    const size_t numFrames = mFrameTimes.size() - first;
     if (numFrames < kFrequentLayerWindowSize) {
         return false;
     }
 
     // Layer is considered frequent if the average frame rate is higher than the threshold
-    const auto totalTime = mFrameTimes.back().queueTime - it->queueTime;
-    return Fps::fromPeriodNsecs(totalTime / (numFrames - 1))
+    const auto totalTime = mFrameTimes.back().queueTime - mFrameTimes[first].queueTime;
+    return Fps::fromPeriodNsecs(totalTime / static_cast<nsecs_t>(numFrames - 1))
             .greaterThanOrEqualWithMargin(kMinFpsForFrequentLayer);
 }
 
@@ -127,17 +133,31 @@ bool LayerInfo::hasEnoughDataForHeuristic() const {
 }
 
 std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
+    const bool hasReportedRefreshRate = mLastRefreshRate.reported.isValid();
+    if (mCachedAverageFrameTime &&
+        mCachedAverageFrameTime->hasReportedRefreshRate == hasReportedRefreshRate) {
+        return mCachedAverageFrameTime->averageFrameTime;
+    }
+
+    mCachedAverageFrameTime.emplace(
+            CachedAverageFrameTime{.hasReportedRefreshRate = hasReportedRefreshRate,
+                                   .averageFrameTime = computeAverageFrameTime()});
+    return mCachedAverageFrameTime->averageFrameTime;
+}
+
+std::optional<nsecs_t> LayerInfo::computeAverageFrameTime() const {
     // Ignore frames captured during a mode change
-    const bool isDuringModeChange =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](const auto& frame) { return frame.pendingModeChange; });
+    bool isDuringModeChange = false;
+    bool isMissingPresentTime = false;
+    for (size_t i = 0; i < mFrameTimes.size(); i++) {
+        isDuringModeChange |= mFrameTimes[i].pendingModeChange;
+        isMissingPresentTime |= mFrameTimes[i].presentTime == 0;
+    }
+
     if (isDuringModeChange) {
         return std::nullopt;
     }
 
-    const bool isMissingPresentTime =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](auto frame) { return frame.presentTime == 0; });
     if (isMissingPresentTime && !mLastRefreshRate.reported.isValid()) {
         // If there are no presentation timestamps and we haven't calculated
         // one in the past then we can't calculate the refresh rate
@@ -157,15 +177,15 @@ std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
 
     nsecs_t totalDeltas = 0;
     int numDeltas = 0;
-    auto prevFrame = mFrameTimes.begin();
-    for (auto it = mFrameTimes.begin() + 1; it != mFrameTimes.end(); ++it) {
-        const auto currDelta = getFrameTime(*it) - getFrameTime(*prevFrame);
+    size_t prevFrame = 0;
+    for (size_t i = 1; i < mFrameTimes.size(); i++) {
+        const auto currDelta = getFrameTime(mFrameTimes[i]) - getFrameTime(mFrameTimes[prevFrame]);
         if (currDelta < kMinPeriodBetweenFrames) {
             // Skip this frame, but count the delta into the next frame
             continue;
         }
 
-        prevFrame = it;
+        prevFrame = i;
 
         if (currDelta > kMaxPeriodBetweenFrames) {
             // Skip this frame and the current delta.
@@ -24,6 +24,7 @@
 
 #include "LayerHistory.h"
 #include "RefreshRateConfigs.h"
+#include "RingBuffer.h"
 #include "Scheduler/Seamlessness.h"
 #include "SchedulerUtils.h"
 
@@ -191,7 +192,7 @@ public:
 
     void clearHistory(nsecs_t now) {
         onLayerInactive(now);
-        mFrameTimes.clear();
+        clearFrameTimes();
     }
 
 private:
@@ -260,11 +261,22 @@ private:
         static constexpr float MARGIN_CONSISTENT_FPS = 1.0;
     };
 
+    // The average frame time only depends on the recorded frames and on whether a refresh rate
+    // was reported, so it is kept across summaries of a layer that has not posted since.
+    struct CachedAverageFrameTime {
+        bool hasReportedRefreshRate = false;
+        std::optional<nsecs_t> averageFrameTime;
+    };
+
+    void addFrameTime(const FrameTimeData&);
+    void clearFrameTimes();
+
     bool isFrequent(nsecs_t now) const;
     bool isAnimating(nsecs_t now) const;
     bool hasEnoughDataForHeuristic() const;
     std::optional<Fps> calculateRefreshRateIfPossible(nsecs_t now);
     std::optional<nsecs_t> calculateAverageFrameTime() const;
+    std::optional<nsecs_t> computeAverageFrameTime() const;
     bool isFrameTimeValid(const FrameTimeData&) const;
 
     const std::string mName;
@@ -287,12 +299,15 @@ private:
 
     RefreshRateHeuristicData mLastRefreshRate;
 
-    std::deque<FrameTimeData> mFrameTimes;
-    std::chrono::time_point<std::chrono::steady_clock> mFrameTimeValidSince =
-            std::chrono::steady_clock::now();
     static constexpr size_t HISTORY_SIZE = RefreshRateHistory::HISTORY_SIZE;
     static constexpr std::chrono::nanoseconds HISTORY_DURATION = 1s;
 
+    // Stored inline so that walking the history of a layer stays within its LayerInfo.
+    RingBuffer<FrameTimeData, HISTORY_SIZE> mFrameTimes;
+    mutable std::optional<CachedAverageFrameTime> mCachedAverageFrameTime;
+    std::chrono::time_point<std::chrono::steady_clock> mFrameTimeValidSince =
+            std::chrono::steady_clock::now();
+
     LayerProps mLayerProps;
 
     RefreshRateHistory mRefreshRateHistory;
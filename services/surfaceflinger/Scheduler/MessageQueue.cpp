@@ -52,13 +52,21 @@ bool MessageQueue::Handler::invalidatePending() {
 
 void MessageQueue::Handler::handleMessage(const Message& message) {
     switch (message.what) {
-        case INVALIDATE:
+        case INVALIDATE: {
             mEventMask.fetch_and(~eventMaskInvalidate);
-            mQueue.mFlinger->onMessageReceived(message.what, mVsyncId, mExpectedVSyncTime);
+            const nsecs_t expectedVSyncTime = mExpectedVSyncTime;
+            mQueue.beginFrame();
+            mQueue.mFlinger->onMessageReceived(message.what, mVsyncId, expectedVSyncTime);
+            // Unless the invalidate signaled a refresh, the frame ends here.
+            if ((mEventMask.load() & eventMaskRefresh) == 0) {
+                mQueue.finishFrame(expectedVSyncTime);
+            }
             break;
+        }
         case REFRESH:
             mEventMask.fetch_and(~eventMaskRefresh);
             mQueue.mFlinger->onMessageReceived(message.what, mVsyncId, mExpectedVSyncTime);
+            mQueue.finishFrame(mExpectedVSyncTime);
             break;
     }
 }
@@ -168,6 +176,34 @@ void MessageQueue::postMessage(sp<MessageHandler>&& handler) {
     mLooper->sendMessage(handler, Message());
 }
 
+void MessageQueue::postDeferredMessage(sp<MessageHandler>&& handler) {
+    std::lock_guard lock(mDeferred.mutex);
+    const auto nextInvalidate = nextExpectedInvalidate();
+    if (mDeferred.frameInProgress ||
+        (nextInvalidate && *nextInvalidate - std::chrono::steady_clock::now() < kDeferralWindow)) {
+        mDeferred.handlers.push_back(std::move(handler));
+        return;
+    }
+    postMessage(std::move(handler));
+}
+
+void MessageQueue::beginFrame() {
+    std::lock_guard lock(mDeferred.mutex);
+    mDeferred.frameInProgress = true;
+}
+
+void MessageQueue::finishFrame(nsecs_t expectedVSyncTime) {
+    mFrameSlack = std::chrono::nanoseconds(expectedVSyncTime - systemTime());
+
+    // Posted with the lock held, so that they stay ahead of the messages deferred from now on.
+    std::lock_guard lock(mDeferred.mutex);
+    mDeferred.frameInProgress = false;
+    for (auto& handler : mDeferred.handlers) {
+        postMessage(std::move(handler));
+    }
+    mDeferred.handlers.clear();
+}
+
 void MessageQueue::invalidate() {
     ATRACE_CALL();
 
@@ -20,6 +20,7 @@
 #include <future>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 #include <gui/IDisplayEventConnection.h>
@@ -70,6 +71,9 @@ public:
     virtual void setInjector(sp<EventThreadConnection>) = 0;
     virtual void waitMessage() = 0;
     virtual void postMessage(sp<MessageHandler>&&) = 0;
+    // Posts a message that can wait: while a frame is being composed, or is due to start within
+    // kDeferralWindow, the message is held until the main thread is done with the frame.
+    virtual void postDeferredMessage(sp<MessageHandler>&&) = 0;
     virtual void invalidate() = 0;
     virtual void refresh() = 0;
     virtual std::optional<std::chrono::steady_clock::time_point> nextExpectedInvalidate() = 0;
@@ -124,15 +128,34 @@ protected:
         sp<EventThreadConnection> connection GUARDED_BY(mutex);
     };
 
+    struct Deferred {
+        std::mutex mutex;
+        bool frameInProgress GUARDED_BY(mutex) = false;
+        std::vector<sp<MessageHandler>> handlers GUARDED_BY(mutex);
+    };
+
     Vsync mVsync;
     Injector mInjector;
+    Deferred mDeferred;
+
+    // Time left until the expected vsync of the last frame once the main thread was done with it,
+    // negative if the frame was late.
+    TracedOrdinal<std::chrono::nanoseconds> mFrameSlack = {"MainThreadSlack-sf",
+                                                           std::chrono::nanoseconds(0)};
 
     sp<Handler> mHandler;
 
     void vsyncCallback(nsecs_t vsyncTime, nsecs_t targetWakeupTime, nsecs_t readyTime);
     void injectorCallback();
 
+    // Called by the handler around the messages of a frame. Finishing the frame posts the
+    // deferred messages.
+    void beginFrame();
+    void finishFrame(nsecs_t expectedVSyncTime);
+
 public:
+    static constexpr std::chrono::nanoseconds kDeferralWindow = std::chrono::milliseconds(2);
+
     ~MessageQueue() override = default;
     void init(const sp<SurfaceFlinger>& flinger) override;
     void initVsync(scheduler::VSyncDispatch&, frametimeline::TokenManager&,
@@ -142,6 +165,7 @@ public:
 
     void waitMessage() override;
     void postMessage(sp<MessageHandler>&&) override;
+    void postDeferredMessage(sp<MessageHandler>&&) override;
 
     // sends INVALIDATE message at next VSYNC
     void invalidate() override;
@@ -114,13 +114,14 @@ void OneShotTimer::loop() {
             break;
         }
 
-        auto triggerTime = mClock->now() + mInterval;
+        Interval interval = mInterval;
+        auto triggerTime = mClock->now() + interval;
         state = TimerState::WAITING;
         while (state == TimerState::WAITING) {
             constexpr auto zero = std::chrono::steady_clock::duration::zero();
-            // Wait for mInterval time for semaphore signal.
+            // Wait for the interval for semaphore signal.
             struct timespec ts;
-            calculateTimeoutTime(std::chrono::nanoseconds(mInterval), &ts);
+            calculateTimeoutTime(std::chrono::nanoseconds(interval), &ts);
             int result = sem_clockwait(&mSemaphore, CLOCK_MONOTONIC, &ts);
             if (result && errno != ETIMEDOUT && errno != EINTR) {
                 std::stringstream ss;
@@ -130,7 +131,8 @@ void OneShotTimer::loop() {
 
             state = checkForResetAndStop(state);
             if (state == TimerState::RESET) {
-                triggerTime = mClock->now() + mInterval;
+                interval = mInterval;
+                triggerTime = mClock->now() + interval;
                 state = TimerState::WAITING;
             } else if (state == TimerState::WAITING && (triggerTime - mClock->now()) <= zero) {
                 triggerTimeout = true;
@@ -165,7 +167,7 @@ void OneShotTimer::reset() {
 
 std::string OneShotTimer::dump() const {
     std::ostringstream stream;
-    stream << mInterval.count() << " ms";
+    stream << mInterval.load().count() << " ms";
     return stream.str();
 }
 
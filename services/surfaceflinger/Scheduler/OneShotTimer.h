@@ -17,6 +17,7 @@
 #pragma once
 
 #include <semaphore.h>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <thread>
@@ -48,6 +49,9 @@ public:
     void stop();
     // Resets the wakeup time and fires the reset callback.
     void reset();
+    // Changes the interval. Takes effect the next time the timer is reset.
+    void setInterval(Interval interval) { mInterval = interval; }
+    Interval getInterval() const { return mInterval; }
 
     std::string dump() const;
 
@@ -90,7 +94,7 @@ private:
     std::string mName;
 
     // Interval after which timer expires.
-    const Interval mInterval;
+    std::atomic<Interval> mInterval;
 
     // Callback that happens when timer resets.
     const ResetCallback mResetCallback;
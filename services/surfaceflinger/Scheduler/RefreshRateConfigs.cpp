@@ -23,6 +23,7 @@
 
 #include "RefreshRateConfigs.h"
 #include <android-base/stringprintf.h>
+#include <math/HashCombine.h>
 #include <utils/Trace.h>
 #include <chrono>
 #include <cmath>
@@ -222,38 +223,75 @@ RefreshRate RefreshRateConfigs::getBestRefreshRate(const std::vector<LayerRequir
                                                    GlobalSignals* outSignalsConsidered) const {
     std::lock_guard lock(mLock);
 
-    if (auto cached = getCachedBestRefreshRate(layers, globalSignals, outSignalsConsidered)) {
+    const size_t inputsHash = hashBestRefreshRateInputs(layers, globalSignals);
+    if (auto cached =
+                getCachedBestRefreshRate(inputsHash, layers, globalSignals, outSignalsConsidered)) {
         return *cached;
     }
 
     GlobalSignals signalsConsidered;
     RefreshRate result = getBestRefreshRateLocked(layers, globalSignals, &signalsConsidered);
-    lastBestRefreshRateInvocation.emplace(
-            GetBestRefreshRateInvocation{.layerRequirements = layers,
-                                         .globalSignals = globalSignals,
-                                         .outSignalsConsidered = signalsConsidered,
-                                         .resultingBestRefreshRate = result});
+    cacheBestRefreshRateInvocation(inputsHash,
+                                   GetBestRefreshRateInvocation{.layerRequirements = layers,
+                                                                .globalSignals = globalSignals,
+                                                                .outSignalsConsidered =
+                                                                        signalsConsidered,
+                                                                .resultingBestRefreshRate =
+                                                                        result});
     if (outSignalsConsidered) {
         *outSignalsConsidered = signalsConsidered;
     }
     return result;
 }
 
+size_t RefreshRateConfigs::hashBestRefreshRateInputs(const std::vector<LayerRequirement>& layers,
+                                                     const GlobalSignals& globalSignals) {
+    size_t hash = 0;
+    android::hashCombineSingle(hash, globalSignals.touch);
+    android::hashCombineSingle(hash, globalSignals.idle);
+    for (const auto& layer : layers) {
+        android::hashCombineSingle(hash, layer.name);
+        android::hashCombineSingle(hash, layer.vote);
+        android::hashCombineSingle(hash, layer.seamlessness);
+        android::hashCombineSingle(hash, layer.weight);
+        android::hashCombineSingle(hash, layer.focused);
+    }
+    return hash;
+}
+
 std::optional<RefreshRate> RefreshRateConfigs::getCachedBestRefreshRate(
-        const std::vector<LayerRequirement>& layers, const GlobalSignals& globalSignals,
-        GlobalSignals* outSignalsConsidered) const {
-    const bool sameAsLastCall = lastBestRefreshRateInvocation &&
-            lastBestRefreshRateInvocation->layerRequirements == layers &&
-            lastBestRefreshRateInvocation->globalSignals == globalSignals;
+        size_t inputsHash, const std::vector<LayerRequirement>& layers,
+        const GlobalSignals& globalSignals, GlobalSignals* outSignalsConsidered) const {
+    const auto it =
+            std::find_if(mBestRefreshRateInvocations.begin(), mBestRefreshRateInvocations.end(),
+                         [&](const CachedBestRefreshRateInvocation& cached) {
+                             return cached.inputsHash == inputsHash &&
+                                     cached.invocation.globalSignals == globalSignals &&
+                                     cached.invocation.layerRequirements == layers;
+                         });
+    if (it == mBestRefreshRateInvocations.end()) {
+        return {};
+    }
 
-    if (sameAsLastCall) {
-        if (outSignalsConsidered) {
-            *outSignalsConsidered = lastBestRefreshRateInvocation->outSignalsConsidered;
-        }
-        return lastBestRefreshRateInvocation->resultingBestRefreshRate;
+    if (it != mBestRefreshRateInvocations.begin()) {
+        std::rotate(mBestRefreshRateInvocations.begin(), it, std::next(it));
     }
 
-    return {};
+    const auto& invocation = mBestRefreshRateInvocations.front().invocation;
+    if (outSignalsConsidered) {
+        *outSignalsConsidered = invocation.outSignalsConsidered;
+    }
+    return invocation.resultingBestRefreshRate;
+}
+
+void RefreshRateConfigs::cacheBestRefreshRateInvocation(
+        size_t inputsHash, GetBestRefreshRateInvocation&& invocation) const {
+    if (mBestRefreshRateInvocations.size() == kMaxCachedBestRefreshRateInvocations) {
+        mBestRefreshRateInvocations.pop_back();
+    }
+    mBestRefreshRateInvocations.push_front(
+            CachedBestRefreshRateInvocation{.inputsHash = inputsHash,
+                                            .invocation = std::move(invocation)});
 }
 
 RefreshRate RefreshRateConfigs::getBestRefreshRateLocked(
@@ -669,9 +707,7 @@ const RefreshRate& RefreshRateConfigs::getCurrentRefreshRateByPolicyLocked() con
 void RefreshRateConfigs::setCurrentModeId(DisplayModeId modeId) {
     std::lock_guard lock(mLock);
 
-    // Invalidate the cached invocation to getBestRefreshRate. This forces
-    // the refresh rate to be recomputed on the next call to getBestRefreshRate.
-    lastBestRefreshRateInvocation.reset();
+    clearBestRefreshRateCache();
 
     mCurrentRefreshRate = mRefreshRates.at(modeId).get();
 }
@@ -691,9 +727,7 @@ void RefreshRateConfigs::updateDisplayModes(const DisplayModes& modes,
         return mode->getId() == currentModeId;
     }));
 
-    // Invalidate the cached invocation to getBestRefreshRate. This forces
-    // the refresh rate to be recomputed on the next call to getBestRefreshRate.
-    lastBestRefreshRateInvocation.reset();
+    clearBestRefreshRateCache();
 
     mRefreshRates.clear();
     for (const auto& mode : modes) {
@@ -751,12 +785,12 @@ status_t RefreshRateConfigs::setDisplayManagerPolicy(const Policy& policy) {
         ALOGE("Invalid refresh rate policy: %s", policy.toString().c_str());
         return BAD_VALUE;
     }
-    lastBestRefreshRateInvocation.reset();
     Policy previousPolicy = *getCurrentPolicyLocked();
     mDisplayManagerPolicy = policy;
     if (*getCurrentPolicyLocked() == previousPolicy) {
         return CURRENT_POLICY_UNCHANGED;
     }
+    clearBestRefreshRateCache();
     constructAvailableRefreshRates();
     return NO_ERROR;
 }
@@ -766,12 +800,12 @@ status_t RefreshRateConfigs::setOverridePolicy(const std::optional<Policy>& poli
     if (policy && !isPolicyValidLocked(*policy)) {
         return BAD_VALUE;
     }
-    lastBestRefreshRateInvocation.reset();
     Policy previousPolicy = *getCurrentPolicyLocked();
     mOverridePolicy = policy;
     if (*getCurrentPolicyLocked() == previousPolicy) {
         return CURRENT_POLICY_UNCHANGED;
     }
+    clearBestRefreshRateCache();
     constructAvailableRefreshRates();
     return NO_ERROR;
 }
@@ -20,6 +20,7 @@
 #include <gui/DisplayEventReceiver.h>
 
 #include <algorithm>
+#include <deque>
 #include <numeric>
 #include <optional>
 #include <type_traits>
@@ -271,6 +272,18 @@ public:
         return {mMinSupportedRefreshRate->getFps(), mMaxSupportedRefreshRate->getFps()};
     }
 
+    // Returns the refresh rates of all the display modes, in no particular order. Modes that
+    // differ only in resolution or group have the same refresh rate.
+    std::vector<Fps> getSupportedRefreshRates() const EXCLUDES(mLock) {
+        std::lock_guard lock(mLock);
+        std::vector<Fps> refreshRates;
+        refreshRates.reserve(mRefreshRates.size());
+        for (const auto& [id, refreshRate] : mRefreshRates) {
+            refreshRates.push_back(refreshRate->getFps());
+        }
+        return refreshRates;
+    }
+
     std::optional<Fps> onKernelTimerChanged(std::optional<DisplayModeId> desiredActiveModeId,
                                             bool timerExpired) const EXCLUDES(mLock);
 
@@ -363,11 +376,27 @@ private:
             const std::function<bool(const RefreshRate&)>& shouldAddRefreshRate,
             std::vector<const RefreshRate*>* outRefreshRates) REQUIRES(mLock);
 
-    std::optional<RefreshRate> getCachedBestRefreshRate(const std::vector<LayerRequirement>& layers,
+    struct GetBestRefreshRateInvocation;
+
+    // Hashes the inputs of getBestRefreshRate. Equal inputs hash equally, but the desired refresh
+    // rate is left out since layer requirements compare it with a margin.
+    static size_t hashBestRefreshRateInputs(const std::vector<LayerRequirement>& layers,
+                                            const GlobalSignals& globalSignals);
+
+    std::optional<RefreshRate> getCachedBestRefreshRate(size_t inputsHash,
+                                                        const std::vector<LayerRequirement>& layers,
                                                         const GlobalSignals& globalSignals,
                                                         GlobalSignals* outSignalsConsidered) const
             REQUIRES(mLock);
 
+    void cacheBestRefreshRateInvocation(size_t inputsHash,
+                                        GetBestRefreshRateInvocation&& invocation) const
+            REQUIRES(mLock);
+
+    // Invalidates the cached invocations to getBestRefreshRate. This forces the refresh rate to be
+    // recomputed on the next call to getBestRefreshRate.
+    void clearBestRefreshRateCache() REQUIRES(mLock) { mBestRefreshRateInvocations.clear(); }
+
     RefreshRate getBestRefreshRateLocked(const std::vector<LayerRequirement>& layers,
                                          const GlobalSignals& globalSignals,
                                          GlobalSignals* outSignalsConsidered) const REQUIRES(mLock);
@@ -446,7 +475,18 @@ private:
         GlobalSignals outSignalsConsidered;
         RefreshRate resultingBestRefreshRate;
     };
-    mutable std::optional<GetBestRefreshRateInvocation> lastBestRefreshRateInvocation
+
+    // Content commonly alternates between a few layer summaries, e.g. as a video's controls are
+    // shown and hidden, so the results for the most recent distinct inputs are kept.
+    static constexpr size_t kMaxCachedBestRefreshRateInvocations = 4;
+
+    struct CachedBestRefreshRateInvocation {
+        size_t inputsHash;
+        GetBestRefreshRateInvocation invocation;
+    };
+
+    // Ordered from the most to the least recently used.
+    mutable std::deque<CachedBestRefreshRateInvocation> mBestRefreshRateInvocations
             GUARDED_BY(mLock);
 };
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace android::scheduler {
+
+// Fixed-capacity FIFO that stores its elements inline. Once full, pushing an element drops the
+// oldest one, so the buffer never allocates and its elements stay in a single block of memory.
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N > 0, "RingBuffer must have a non-zero capacity");
+
+public:
+    static constexpr size_t capacity() { return N; }
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    // Elements are indexed from oldest to newest.
+    T& operator[](size_t i) { return mData[(mBegin + i) % N]; }
+    const T& operator[](size_t i) const { return mData[(mBegin + i) % N]; }
+
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[mSize - 1]; }
+    const T& back() const { return (*this)[mSize - 1]; }
+
+    void push_back(const T& value) {
+        if (mSize == N) {
+            mData[mBegin] = value;
+            mBegin = (mBegin + 1) % N;
+            return;
+        }
+
+        mData[(mBegin + mSize) % N] = value;
+        mSize++;
+    }
+
+    void clear() {
+        mBegin = 0;
+        mSize = 0;
+    }
+
+private:
+    std::array<T, N> mData{};
+    size_t mBegin = 0;
+    size_t mSize = 0;
+};
+
+} // namespace android::scheduler
@@ -83,7 +83,9 @@ std::unique_ptr<scheduler::VSyncTracker> createVSyncTracker() {
 std::unique_ptr<scheduler::VSyncDispatch> createVSyncDispatch(scheduler::VSyncTracker& tracker) {
     // TODO(b/144707443): Tune constants.
     constexpr std::chrono::nanoseconds vsyncMoveThreshold = 3ms;
-    constexpr std::chrono::nanoseconds timerSlack = 500us;
+    // Callbacks that wake up within this window of each other are dispatched on one timer expiry.
+    const std::chrono::nanoseconds timerSlack = std::chrono::microseconds(
+            base::GetIntProperty("debug.sf.vsync_dispatch_timer_slack_us"s, 500));
     return std::make_unique<
             scheduler::VSyncDispatchTimerQueue>(std::make_unique<scheduler::Timer>(), tracker,
                                                 timerSlack.count(), vsyncMoveThreshold.count());
@@ -137,6 +139,15 @@ Scheduler::Scheduler(const scheduler::RefreshRateConfigs& configs, ISchedulerCal
                 [this, callback] { std::invoke(callback, this, TimerState::Reset); },
                 [this, callback] { std::invoke(callback, this, TimerState::Expired); });
         mIdleTimer->start();
+
+        // The kernel idle timer is driven by the display hardware, so its timeout is not ours to
+        // adapt. Otherwise, stretch the timeout up to 4x for apps that pause briefly, and count a
+        // round trip to the idle refresh rate as worth it only if it lasts another base timeout.
+        if (!mOptions.supportKernelTimer &&
+            base::GetBoolProperty("debug.sf.adaptive_idle_timer"s, true)) {
+            const auto timeout = std::chrono::milliseconds(millis);
+            mIdleGapHistory.emplace(timeout, timeout * 4, timeout);
+        }
     }
 
     if (const int64_t millis = set_touch_timer_ms(0); millis > 0) {
@@ -604,6 +615,12 @@ void Scheduler::recordLayerHistory(Layer* layer, nsecs_t presentTime,
     if (mRefreshRateConfigs.canSwitch()) {
         mLayerHistory->record(layer, presentTime, systemTime(), updateType);
     }
+
+    if (mIdleGapHistory) {
+        if (const uid_t uid = layer->getOwnerUid(); mForegroundUid.exchange(uid) != uid) {
+            mIdleTimer->setInterval(mIdleGapHistory->selectTimeout(uid));
+        }
+    }
 }
 
 void Scheduler::setModeChangePending(bool pending) {
@@ -654,6 +671,16 @@ void Scheduler::chooseRefreshRateForContent() {
 
 void Scheduler::resetIdleTimer() {
     if (mIdleTimer) {
+        if (mIdleGapHistory) {
+            const nsecs_t now = systemTime();
+            const nsecs_t lastResetTime = mLastIdleTimerResetTime.exchange(now);
+            const auto gap = std::chrono::duration_cast<scheduler::IdleGapHistory::Duration>(
+                    std::chrono::nanoseconds(now - lastResetTime));
+            // Gaps shorter than the base timeout never expire the timer, so skip the lock for them.
+            if (lastResetTime != 0 && gap >= mIdleGapHistory->getBaseTimeout()) {
+                mIdleTimer->setInterval(mIdleGapHistory->recordGap(mForegroundUid, gap));
+            }
+        }
         mIdleTimer->reset();
     }
 }
@@ -732,7 +759,8 @@ void Scheduler::displayPowerTimerCallback(TimerState state) {
 void Scheduler::dump(std::string& result) const {
     using base::StringAppendF;
 
-    StringAppendF(&result, "+  Idle timer: %s\n", mIdleTimer ? mIdleTimer->dump().c_str() : "off");
+    StringAppendF(&result, "+  Idle timer: %s%s\n", mIdleTimer ? mIdleTimer->dump().c_str() : "off",
+                  mIdleGapHistory ? " (adaptive)" : "");
     StringAppendF(&result, "+  Touch timer: %s\n",
                   mTouchTimer ? mTouchTimer->dump().c_str() : "off");
     StringAppendF(&result, "+  Content detection: %s %s\n\n",
@@ -755,6 +783,29 @@ void Scheduler::dump(std::string& result) const {
     }
 }
 
+void Scheduler::dumpIdleTimer(std::string& result) const {
+    using base::StringAppendF;
+
+    if (!mIdleGapHistory) {
+        StringAppendF(&result, "Idle timer: %s\n",
+                      mIdleTimer ? mIdleTimer->dump().c_str() : "off");
+        return;
+    }
+
+    result.append(mIdleGapHistory->dump());
+
+    // Estimate the power impact as the refresh cycles skipped by running at the lowest rather
+    // than the highest refresh rate while idle.
+    const auto stats = mIdleGapHistory->getStats();
+    const auto range = mRefreshRateConfigs.getSupportedRefreshRateRange();
+    const float skippedPerMs = (range.max.getValue() - range.min.getValue()) / 1000.f;
+    StringAppendF(&result, "  mode switches: %zu (with base timeout: %zu)\n",
+                  2 * stats.downshifts, 2 * (stats.downshifts + stats.avoidedDownshifts));
+    StringAppendF(&result, "  refresh cycles skipped while idle: %.0f (with base timeout: %.0f)\n",
+                  skippedPerMs * static_cast<float>(stats.idleTime.count()),
+                  skippedPerMs * static_cast<float>(stats.baseIdleTime.count()));
+}
+
 void Scheduler::dumpVsync(std::string& s) const {
     using base::StringAppendF;
 
@@ -31,6 +31,7 @@
 #pragma clang diagnostic pop // ignored "-Wconversion -Wextra"
 
 #include "EventThread.h"
+#include "IdleGapHistory.h"
 #include "LayerHistory.h"
 #include "OneShotTimer.h"
 #include "RefreshRateConfigs.h"
@@ -154,6 +155,7 @@ public:
     void dump(std::string&) const;
     void dump(ConnectionHandle, std::string&) const;
     void dumpVsync(std::string&) const;
+    void dumpIdleTimer(std::string&) const;
 
     // Get the appropriate refresh for current conditions.
     std::optional<DisplayModeId> getPreferredModeId();
@@ -272,6 +274,11 @@ private:
 
     // Timer that records time between requests for next vsync.
     std::optional<scheduler::OneShotTimer> mIdleTimer;
+    // Learns the idle timer timeout from the idle gaps of the foreground uid, if enabled.
+    std::optional<scheduler::IdleGapHistory> mIdleGapHistory;
+    std::atomic<nsecs_t> mLastIdleTimerResetTime = 0;
+    // Owner of the most recently updated layer, to which idle gaps are attributed.
+    std::atomic<uid_t> mForegroundUid = 0;
     // Timer used to monitor touch events.
     std::optional<scheduler::OneShotTimer> mTouchTimer;
     // Timer used to monitor display power mode.
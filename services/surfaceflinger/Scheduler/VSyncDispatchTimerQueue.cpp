@@ -17,6 +17,9 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 #include <android-base/stringprintf.h>
 #include <utils/Trace.h>
+
+#include <algorithm>
+#include <tuple>
 #include <vector>
 
 #include "TimeKeeper.h"
@@ -147,6 +150,22 @@ nsecs_t VSyncDispatchTimerQueueEntry::executing() {
     return *mLastDispatchTime;
 }
 
+void VSyncDispatchTimerQueueEntry::recordDispatch(nsecs_t now) {
+    if (!mArmedInfo) {
+        return;
+    }
+
+    const nsecs_t lateness = now - mArmedInfo->mActualWakeupTime;
+    mDispatchStats.dispatchCount++;
+    if (lateness < 0) {
+        mDispatchStats.coalescedCount++;
+        return;
+    }
+
+    mDispatchStats.totalLateness += lateness;
+    mDispatchStats.maxLateness = std::max(mDispatchStats.maxLateness, lateness);
+}
+
 void VSyncDispatchTimerQueueEntry::callback(nsecs_t vsyncTimestamp, nsecs_t wakeupTimestamp,
                                             nsecs_t deadlineTimestamp) {
     {
@@ -191,6 +210,14 @@ void VSyncDispatchTimerQueueEntry::dump(std::string& result) const {
     } else {
         StringAppendF(&result, "\t\t\tmLastDispatchTime unknown\n");
     }
+
+    const auto& stats = mDispatchStats;
+    const size_t lateCount = stats.dispatchCount - stats.coalescedCount;
+    StringAppendF(&result,
+                  "\t\t\tdispatches: %zu (%zu coalesced) lateness avg: %.3fms max: %.3fms\n",
+                  stats.dispatchCount, stats.coalescedCount,
+                  lateCount ? stats.totalLateness / 1e6f / static_cast<float>(lateCount) : 0.f,
+                  stats.maxLateness / 1e6f);
 }
 
 VSyncDispatchTimerQueue::VSyncDispatchTimerQueue(std::unique_ptr<TimeKeeper> tk,
@@ -288,6 +315,7 @@ void VSyncDispatchTimerQueue::timerCallback() {
 
             auto const lagAllowance = std::max(now - mIntendedWakeupTime, static_cast<nsecs_t>(0));
             if (*wakeupTime < mIntendedWakeupTime + mTimerSlack + lagAllowance) {
+                callback->recordDispatch(now);
                 callback->executing();
                 invocations.emplace_back(Invocation{callback, *callback->lastExecutedVsyncTarget(),
                                                     *wakeupTime, *readyTime});
@@ -298,6 +326,12 @@ void VSyncDispatchTimerQueue::timerCallback() {
         rearmTimer(mTimeKeeper->now());
     }
 
+    // Callbacks coalesced into this expiry run back to back, so serve the tightest deadline first.
+    std::sort(invocations.begin(), invocations.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.deadlineTimestamp, lhs.wakeupTimestamp) <
+                std::tie(rhs.deadlineTimestamp, rhs.wakeupTimestamp);
+    });
+
     for (auto const& invocation : invocations) {
         invocation.callback->callback(invocation.vsyncTimestamp, invocation.wakeupTimestamp,
                                       invocation.deadlineTimestamp);
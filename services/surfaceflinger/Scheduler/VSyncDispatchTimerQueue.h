@@ -73,6 +73,20 @@ public:
 
     // Checks if there is a pending update to the workload, returning true if so.
     bool hasPendingWorkloadUpdate() const;
+
+    // How far from their wakeup time the dispatches of this callback happened.
+    struct DispatchStats {
+        size_t dispatchCount = 0;
+        // Dispatches issued ahead of the wakeup time because they were coalesced into an earlier
+        // timer expiry.
+        size_t coalescedCount = 0;
+        nsecs_t totalLateness = 0;
+        nsecs_t maxLateness = 0;
+    };
+
+    // Records a dispatch at the given time, relative to the current wakeup time.
+    void recordDispatch(nsecs_t now);
+    const DispatchStats& dispatchStats() const { return mDispatchStats; }
     // End: functions that are not threadsafe.
 
     // Invoke the callback with the two given timestamps, moving the state from running->disarmed.
@@ -99,6 +113,8 @@ private:
 
     std::optional<VSyncDispatch::ScheduleTiming> mWorkloadUpdateInfo;
 
+    DispatchStats mDispatchStats;
+
     mutable std::mutex mRunningMutex;
     std::condition_variable mCv;
     bool mRunning GUARDED_BY(mRunningMutex) = false;
@@ -114,7 +130,8 @@ public:
     // \param[in] tk                    A timekeeper.
     // \param[in] tracker               A tracker.
     // \param[in] timerSlack            The threshold at which different similarly timed callbacks
-    //                                  should be grouped into one wakeup.
+    //                                  should be grouped into one wakeup. Grouped callbacks are
+    //                                  invoked in order of their deadlines.
     // \param[in] minVsyncDistance      The minimum distance between two vsync estimates before the
     //                                  vsyncs are considered the same vsync event.
     explicit VSyncDispatchTimerQueue(std::unique_ptr<TimeKeeper> tk, VSyncTracker& tracker,
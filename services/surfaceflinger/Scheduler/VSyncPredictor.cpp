@@ -29,6 +29,8 @@
 #include <utils/Trace.h>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
 #include <sstream>
 #include "RefreshRateConfigs.h"
 
@@ -126,6 +128,53 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         return true;
     }
 
+    for (auto const ts : mTimestamps) {
+        traceInt64If("VSP-ts", ts);
+    }
+
+    auto it = mRateMap.find(mIdealPeriod);
+    auto const currentPeriod = it->second.slope;
+    auto fit = fitModel(currentPeriod, std::nullopt);
+
+    // validate() only compares a new sample against a single previous one, so a sample can pass
+    // it and still push the fit past the tolerance. Retry without the sample that fits worst
+    // before throwing the whole history away, since a reset forces a resync to HW vsync.
+    if (fit && !isPeriodWithinTolerance(fit->model.slope) &&
+        mTimestamps.size() > kMinimumSamplesForPrediction) {
+        if (auto const trimmed = fitModel(currentPeriod, fit->worstIndex);
+            trimmed && isPeriodWithinTolerance(trimmed->model.slope)) {
+            ATRACE_NAME("VSP-outlier");
+            eraseTimestamp(fit->worstIndex);
+            fit = trimmed;
+        }
+    }
+
+    if (CC_UNLIKELY(!fit) || !isPeriodWithinTolerance(fit->model.slope)) {
+        it->second = {mIdealPeriod, 0};
+        clearTimestamps();
+        return false;
+    }
+
+    auto const [anticipatedPeriod, intercept] = fit->model;
+    mLastFitError = fit->rmsError;
+    traceInt64If("VSP-error", fit->rmsError);
+    traceInt64If("VSP-period", anticipatedPeriod);
+    traceInt64If("VSP-intercept", intercept);
+
+    it->second = {anticipatedPeriod, intercept};
+
+    ALOGV("model update ts: %" PRId64 " slope: %" PRId64 " intercept: %" PRId64, timestamp,
+          anticipatedPeriod, intercept);
+    return true;
+}
+
+bool VSyncPredictor::isPeriodWithinTolerance(nsecs_t period) const {
+    auto const percent = std::abs(period - mIdealPeriod) * kMaxPercent / mIdealPeriod;
+    return percent < kOutlierTolerancePercent;
+}
+
+std::optional<VSyncPredictor::Fit> VSyncPredictor::fitModel(
+        nsecs_t currentPeriod, std::optional<size_t> excludedIndex) const {
     // This is a 'simple linear regression' calculation of Y over X, with Y being the
     // vsync timestamps, and X being the ordinal of vsync count.
     // The calculated slope is the vsync period.
@@ -141,64 +190,102 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     //
     // intercept = mean(Y) - slope * mean(X)
     //
-    std::vector<nsecs_t> vsyncTS(mTimestamps.size());
-    std::vector<nsecs_t> ordinals(mTimestamps.size());
+    // The centered sums are expanded so that they can be accumulated in a single pass over the
+    // timestamps, rather than into temporary vectors that would allocate on every vsync:
+    //
+    // Sigma_i( (X_i - mean(X)) * (Y_i - mean(Y)) ) =
+    //         Sigma_i(X_i * Y_i) - mean(Y) * Sigma_i(X_i) - mean(X) * Sigma_i(Y_i)
+    //         + N * mean(X) * mean(Y)
+    //
+    // This holds exactly for the truncated integer means too, so the model is unchanged.
 
-    // normalizing to the oldest timestamp cuts down on error in calculating the intercept.
-    auto const oldest_ts = *std::min_element(mTimestamps.begin(), mTimestamps.end());
-    auto it = mRateMap.find(mIdealPeriod);
-    auto const currentPeriod = it->second.slope;
     // TODO (b/144707443): its important that there's some precision in the mean of the ordinals
     //                     for the intercept calculation, so scale the ordinals by 1000 to continue
     //                     fixed point calculation. Explore expanding
     //                     scheduler::utils::calculate_mean to have a fixed point fractional part.
     static constexpr int64_t kScalingFactor = 1000;
 
-    for (auto i = 0u; i < mTimestamps.size(); i++) {
-        traceInt64If("VSP-ts", mTimestamps[i]);
+    auto const excluded = excludedIndex.value_or(mTimestamps.size());
 
-        vsyncTS[i] = mTimestamps[i] - oldest_ts;
-        ordinals[i] = ((vsyncTS[i] + (currentPeriod / 2)) / currentPeriod) * kScalingFactor;
+    // normalizing to the oldest timestamp cuts down on error in calculating the intercept.
+    auto oldestTS = std::numeric_limits<nsecs_t>::max();
+    for (size_t i = 0; i < mTimestamps.size(); i++) {
+        if (i != excluded) {
+            oldestTS = std::min(oldestTS, mTimestamps[i]);
+        }
     }
 
-    auto meanTS = scheduler::calculate_mean(vsyncTS);
-    auto meanOrdinal = scheduler::calculate_mean(ordinals);
-    for (size_t i = 0; i < vsyncTS.size(); i++) {
-        vsyncTS[i] -= meanTS;
-        ordinals[i] -= meanOrdinal;
+    auto const ordinal = [&](nsecs_t vsyncTS) {
+        return ((vsyncTS + (currentPeriod / 2)) / currentPeriod) * kScalingFactor;
+    };
+
+    int64_t count = 0;
+    nsecs_t sumTS = 0;
+    int64_t sumOrdinal = 0;
+    int64_t sumProduct = 0;
+    int64_t sumOrdinalSquared = 0;
+    for (size_t i = 0; i < mTimestamps.size(); i++) {
+        if (i != excluded) {
+            auto const vsyncTS = mTimestamps[i] - oldestTS;
+            auto const x = ordinal(vsyncTS);
+            count++;
+            sumTS += vsyncTS;
+            sumOrdinal += x;
+            sumProduct += x * vsyncTS;
+            sumOrdinalSquared += x * x;
+        }
     }
 
-    auto top = 0ll;
-    auto bottom = 0ll;
-    for (size_t i = 0; i < vsyncTS.size(); i++) {
-        top += vsyncTS[i] * ordinals[i];
-        bottom += ordinals[i] * ordinals[i];
+    if (count == 0) {
+        return {};
     }
 
+    auto const meanTS = sumTS / count;
+    auto const meanOrdinal = sumOrdinal / count;
+    auto const top = sumProduct - meanTS * sumOrdinal - meanOrdinal * sumTS +
+            count * meanOrdinal * meanTS;
+    auto const bottom = sumOrdinalSquared - 2 * meanOrdinal * sumOrdinal +
+            count * meanOrdinal * meanOrdinal;
+
     if (CC_UNLIKELY(bottom == 0)) {
-        it->second = {mIdealPeriod, 0};
-        clearTimestamps();
-        return false;
+        return {};
     }
 
-    nsecs_t const anticipatedPeriod = top * kScalingFactor / bottom;
-    nsecs_t const intercept = meanTS - (anticipatedPeriod * meanOrdinal / kScalingFactor);
-
-    auto const percent = std::abs(anticipatedPeriod - mIdealPeriod) * kMaxPercent / mIdealPeriod;
-    if (percent >= kOutlierTolerancePercent) {
-        it->second = {mIdealPeriod, 0};
-        clearTimestamps();
-        return false;
+    nsecs_t const slope = top * kScalingFactor / bottom;
+    nsecs_t const intercept = meanTS - (slope * meanOrdinal / kScalingFactor);
+
+    // Residuals of the fitted samples, used to report the quality of the model and to find the
+    // sample that fits it worst.
+    double sumSquaredErrors = 0;
+    nsecs_t worstError = -1;
+    size_t worstIndex = 0;
+    for (size_t i = 0; i < mTimestamps.size(); i++) {
+        if (i != excluded) {
+            auto const vsyncTS = mTimestamps[i] - oldestTS;
+            auto const error =
+                    std::abs(vsyncTS - (slope * ordinal(vsyncTS) / kScalingFactor + intercept));
+            sumSquaredErrors += static_cast<double>(error) * static_cast<double>(error);
+            if (error > worstError) {
+                worstError = error;
+                worstIndex = i;
+            }
+        }
     }
 
-    traceInt64If("VSP-period", anticipatedPeriod);
-    traceInt64If("VSP-intercept", intercept);
+    auto const rmsError =
+            static_cast<nsecs_t>(std::sqrt(sumSquaredErrors / static_cast<double>(count)));
+    return Fit{{slope, intercept}, rmsError, worstIndex};
+}
 
-    it->second = {anticipatedPeriod, intercept};
+void VSyncPredictor::eraseTimestamp(size_t index) {
+    // Order the ring from oldest to newest, so that it can keep growing from its end.
+    auto const oldest = next(mLastTimestampIndex);
+    std::rotate(mTimestamps.begin(), mTimestamps.begin() + static_cast<long>(oldest),
+                mTimestamps.end());
+    index = (index + mTimestamps.size() - oldest) % mTimestamps.size();
 
-    ALOGV("model update ts: %" PRId64 " slope: %" PRId64 " intercept: %" PRId64, timestamp,
-          anticipatedPeriod, intercept);
-    return true;
+    mTimestamps.erase(mTimestamps.begin() + static_cast<long>(index));
+    mLastTimestampIndex = mTimestamps.size() - 1;
 }
 
 nsecs_t VSyncPredictor::nextAnticipatedVSyncTimeFromLocked(nsecs_t timePoint) const {
@@ -336,6 +423,7 @@ void VSyncPredictor::clearTimestamps() {
 
         mTimestamps.clear();
         mLastTimestampIndex = 0;
+        mLastFitError = 0;
     }
 }
 
@@ -353,6 +441,8 @@ void VSyncPredictor::resetModel() {
 void VSyncPredictor::dump(std::string& result) const {
     std::lock_guard lock(mMutex);
     StringAppendF(&result, "\tmIdealPeriod=%.2f\n", mIdealPeriod / 1e6f);
+    StringAppendF(&result, "\tmLastFitError=%.3fms over %zu samples\n", mLastFitError / 1e6f,
+                  mTimestamps.size());
     StringAppendF(&result, "\tRefresh Rate Map:\n");
     for (const auto& [idealPeriod, periodInterceptTuple] : mRateMap) {
         StringAppendF(&result,
@@ -18,6 +18,7 @@
 
 #include <android-base/thread_annotations.h>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 #include "SchedulerUtils.h"
@@ -86,6 +87,20 @@ private:
 
     Model getVSyncPredictionModelLocked() const REQUIRES(mMutex);
 
+    struct Fit {
+        Model model;
+        // Root mean square of the residuals of the samples the model was fitted to.
+        nsecs_t rmsError;
+        // Index in mTimestamps of the sample with the largest residual.
+        size_t worstIndex;
+    };
+
+    // Fits the model to the timestamps in the history, leaving out the sample at excludedIndex.
+    std::optional<Fit> fitModel(nsecs_t currentPeriod, std::optional<size_t> excludedIndex) const
+            REQUIRES(mMutex);
+    bool isPeriodWithinTolerance(nsecs_t period) const REQUIRES(mMutex);
+    void eraseTimestamp(size_t index) REQUIRES(mMutex);
+
     nsecs_t nextAnticipatedVSyncTimeFromLocked(nsecs_t timePoint) const REQUIRES(mMutex);
 
     nsecs_t mIdealPeriod GUARDED_BY(mMutex);
@@ -99,6 +114,7 @@ private:
 
     size_t mLastTimestampIndex GUARDED_BY(mMutex) = 0;
     std::vector<nsecs_t> mTimestamps GUARDED_BY(mMutex);
+    nsecs_t mLastFitError GUARDED_BY(mMutex) = 0;
 };
 
 } // namespace android::scheduler
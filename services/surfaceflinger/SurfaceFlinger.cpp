@@ -44,6 +44,7 @@
 #include <compositionengine/LayerFECompositionState.h>
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/RenderSurface.h>
+#include <compositionengine/WorkerPool.h>
 #include <compositionengine/impl/OutputCompositionState.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
 #include <configstore/Utils.h>
@@ -265,6 +266,20 @@ enum Permission {
     ROTATE_SURFACE_FLINGER = 0x2,
 };
 
+// Currently, there is no wrapper in bionic: b/183240349.
+struct sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
 }  // namespace anonymous
 
 struct SetInputWindowsListener : os::BnSetInputWindowsListener {
@@ -393,6 +408,17 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
         return base::GetBoolProperty(std::string("debug.sf.enable_layer_caching"), enable);
     }();
 
+    // Threads to compute layer bounds, and the visible layers of each display, in parallel
+    mCompositionWorkerThreads =
+            base::GetUintProperty<size_t>("debug.sf.composition_worker_threads"s, 0, 8);
+    // And to present the displays in parallel on those threads
+    mPresentDisplaysInParallel =
+            base::GetBoolProperty("debug.sf.present_displays_in_parallel"s, false);
+    // And to draw the client composition predicted by the layer caching planner on those threads
+    // while the HWC validates
+    mPredictClientComposition =
+            base::GetBoolProperty("debug.sf.predict_client_composition"s, false);
+
     useContextPriority = use_context_priority(true);
 
     using Values = SurfaceFlingerProperties::primary_display_orientation_values;
@@ -458,6 +484,23 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     property_get("debug.sf.disable_client_composition_cache", value, "0");
     mDisableClientCompositionCache = atoi(value);
 
+    property_get("debug.sf.client_composition_cache_size", value, "0");
+    mClientCompositionCacheSize = atoi(value);
+
+    property_get("debug.sf.enable_partial_client_composition", value, "0");
+    mPartialClientComposition = atoi(value);
+
+    // Lets SurfaceFlinger reuse the buffers it frees instead of reallocating them from gralloc.
+    // Only buffers that SurfaceFlinger renders into for itself are pooled: pooled buffers keep
+    // their contents, so none that are handed to clients, such as screenshots or the buffers of
+    // BufferQueues allocated here on behalf of clients, may be reused.
+    const int32_t bufferPoolKb = property_get_int32("debug.sf.graphic_buffer_pool_kb", 0);
+    if (bufferPoolKb > 0) {
+        GraphicBufferAllocator::get().setPoolBudget(static_cast<uint64_t>(bufferPoolKb) * 1024,
+                                                    {"Planner", "RegionSamplingThread"});
+        ALOGI("Enabling a %d KB graphic buffer pool", bufferPoolKb);
+    }
+
     // We should be reading 'persist.sys.sf.color_saturation' here
     // but since /data may be encrypted, we need to wait until after vold
     // comes online to attempt to read the property. The property is
@@ -497,7 +540,10 @@ void SurfaceFlinger::binderDied(const wp<IBinder>&) {
     mBootFinished = false;
 
     // Sever the link to inputflinger since its gone as well.
-    static_cast<void>(schedule([=] { mInputFlinger = nullptr; }));
+    static_cast<void>(schedule([=] {
+        mInputFlinger = nullptr;
+        mLastInputWindowInfos.clear();
+    }));
 
     // restore initial conditions (default device unblank, etc)
     initializeDisplays();
@@ -519,6 +565,13 @@ inline std::future<T> SurfaceFlinger::schedule(F&& f) {
     return std::move(future);
 }
 
+template <typename F, typename T>
+inline std::future<T> SurfaceFlinger::scheduleDeferred(F&& f) {
+    auto [task, future] = makeTask(std::move(f));
+    mEventQueue->postDeferredMessage(std::move(task));
+    return std::move(future);
+}
+
 sp<ISurfaceComposerClient> SurfaceFlinger::createConnection() {
     const sp<Client> client = new Client(this);
     return client->initCheck() == NO_ERROR ? client : nullptr;
@@ -694,6 +747,10 @@ void SurfaceFlinger::bootFinished() {
     const nsecs_t now = systemTime();
     const nsecs_t duration = now - mBootTime;
     ALOGI("Boot is finished (%ld ms)", long(ns2ms(duration)) );
+    {
+        Mutex::Autolock lock(mStateLock);
+        mStartupTimings.boot = duration;
+    }
 
     mFrameTracer->initialize();
     mFrameTimeline->onBootFinished();
@@ -721,6 +778,7 @@ void SurfaceFlinger::bootFinished() {
             ALOGE("Failed to link to input service");
         } else {
             mInputFlinger = interface_cast<os::IInputFlinger>(input);
+            mLastInputWindowInfos.clear();
         }
 
         readPersistentProperties();
@@ -772,13 +830,26 @@ void SurfaceFlinger::deleteTextureAsync(uint32_t texture) {
 // Do not call property_set on main thread which will be blocked by init
 // Use StartPropertySetThread instead.
 void SurfaceFlinger::init() {
+    ATRACE_CALL();
     ALOGI(  "SurfaceFlinger's main thread ready to run. "
             "Initializing graphics H/W...");
     Mutex::Autolock _l(mStateLock);
+    const nsecs_t initStart = systemTime();
+
+    // Connecting to the composer HAL doesn't depend on RenderEngine, so it is done meanwhile. Its
+    // callback is only registered later, as the hotplug of the internal display then creates the
+    // display device, which needs RenderEngine.
+    auto hwComposerFuture = std::async(std::launch::async, [this] {
+        ATRACE_NAME("createHWComposer");
+        const nsecs_t start = systemTime();
+        auto hwComposer = getFactory().createHWComposer(mHwcServiceName);
+        return std::make_pair(std::move(hwComposer), systemTime() - start);
+    });
 
     // Get a RenderEngine for the given display / config (can't fail)
     // TODO(b/77156734): We need to stop casting and use HAL types when possible.
     // Sending maxFrameBufferAcquiredBuffers as the cache size is tightly tuned to single-display.
+    ATRACE_BEGIN("createRenderEngine");
     mCompositionEngine->setRenderEngine(renderengine::RenderEngine::create(
             renderengine::RenderEngineCreationArgs::Builder()
                     .setPixelFormat(static_cast<int32_t>(defaultCompositionPixelFormat))
@@ -792,6 +863,25 @@ void SurfaceFlinger::init() {
                                     ? renderengine::RenderEngine::ContextPriority::REALTIME
                                     : renderengine::RenderEngine::ContextPriority::MEDIUM)
                     .build()));
+    ATRACE_END();
+    const nsecs_t renderEngineCreated = systemTime();
+    mStartupTimings.renderEngineCreation = renderEngineCreated - initStart;
+
+    // The displays can only render from the worker threads if RenderEngine runs
+    // the GPU work on its own thread.
+    if (mPresentDisplaysInParallel || mPredictClientComposition) {
+        using RenderEngineType = renderengine::RenderEngine::RenderEngineType;
+        const auto renderEngineType = getRenderEngine().getRenderEngineType();
+        if (renderEngineType != RenderEngineType::THREADED &&
+            renderEngineType != RenderEngineType::SKIA_GL_THREADED) {
+            ALOGW_IF(mPresentDisplaysInParallel,
+                     "Presenting displays serially, as RenderEngine is not threaded");
+            ALOGW_IF(mPredictClientComposition,
+                     "Not predicting client composition, as RenderEngine is not threaded");
+            mPresentDisplaysInParallel = false;
+            mPredictClientComposition = false;
+        }
+    }
 
     // Set SF main policy after initializing RenderEngine which has its own policy.
     if (!SetTaskProfiles(0, {"SFMainPolicy"})) {
@@ -799,16 +889,33 @@ void SurfaceFlinger::init() {
     }
 
     mCompositionEngine->setTimeStats(mTimeStats);
-    mCompositionEngine->setHwComposer(getFactory().createHWComposer(mHwcServiceName));
+    {
+        ATRACE_NAME("waitForHWComposer");
+        auto [hwComposer, hwcConnection] = hwComposerFuture.get();
+        mStartupTimings.hwcConnection = hwcConnection;
+        mStartupTimings.hwcWait = systemTime() - renderEngineCreated;
+        mCompositionEngine->setHwComposer(std::move(hwComposer));
+    }
     mCompositionEngine->getHwComposer().setCallback(this);
     ClientCache::getInstance().setRenderEngine(&getRenderEngine());
 
+    // The work of each frame is done on the main thread and, if it has one, RenderEngine's thread
+    std::vector<int32_t> powerHintSessionThreadIds = {static_cast<int32_t>(gettid())};
+    if (const auto renderEngineTid = getRenderEngine().getRenderEngineTid()) {
+        powerHintSessionThreadIds.push_back(static_cast<int32_t>(*renderEngineTid));
+    }
+    mPowerAdvisor.setPowerHintSessionThreadIds(powerHintSessionThreadIds);
+
     if (base::GetBoolProperty("debug.sf.enable_hwc_vds"s, false)) {
         enableHalVirtualDisplays(true);
     }
 
     // Process any initial hotplug and resulting display changes.
+    const nsecs_t hotplugStart = systemTime();
+    ATRACE_BEGIN("initialHotplug");
     processDisplayHotplugEventsLocked();
+    ATRACE_END();
+    mStartupTimings.initialHotplug = systemTime() - hotplugStart;
     const auto display = getDefaultDisplayDeviceLocked();
     LOG_ALWAYS_FATAL_IF(!display, "Missing internal display after registering composer callback.");
     const auto displayId = display->getPhysicalId();
@@ -819,7 +926,11 @@ void SurfaceFlinger::init() {
     mDrawingState = mCurrentState;
 
     // set initial conditions (e.g. unblank default device)
+    const nsecs_t displayInitializationStart = systemTime();
+    ATRACE_BEGIN("initializeDisplays");
     initializeDisplays();
+    ATRACE_END();
+    mStartupTimings.displayInitialization = systemTime() - displayInitializationStart;
 
     mPowerAdvisor.init();
 
@@ -849,6 +960,8 @@ void SurfaceFlinger::init() {
         ALOGE("Run StartPropertySetThread failed!");
     }
 
+    mStartupTimings.init = systemTime() - initStart;
+    ALOGI("Initialized in %.3f ms", mStartupTimings.init / 1e6);
     ALOGV("Done initializing");
 }
 
@@ -1507,7 +1620,7 @@ status_t SurfaceFlinger::injectVSync(nsecs_t when) {
 
 status_t SurfaceFlinger::getLayerDebugInfo(std::vector<LayerDebugInfo>* outLayers) {
     outLayers->clear();
-    schedule([=] {
+    scheduleDeferred([=] {
         const auto display = ON_MAIN_THREAD(getDefaultDisplayDeviceLocked());
         mDrawingState.traverseInZOrder([&](Layer* layer) {
             outLayers->push_back(layer->getLayerDebugInfo(display.get()));
@@ -2003,7 +2116,7 @@ void SurfaceFlinger::onMessageInvalidate(int64_t vsyncId, nsecs_t expectedVSyncT
     updateCursorAsync();
     updateInputFlinger();
 
-    refreshNeeded |= mRepaintEverything;
+    refreshNeeded |= mRepaintEverything || !mPendingReadbacks.empty();
     if (refreshNeeded && CC_LIKELY(mBootStage != BootStage::BOOTLOADER)) {
         // Signal a refresh if a transaction modified the window state,
         // a new buffer was latched, or if HWC has requested a full
@@ -2096,6 +2209,9 @@ void SurfaceFlinger::onMessageRefresh() {
     refreshArgs.earliestPresentTime = prevVsyncTime - hwcMinWorkDuration;
     refreshArgs.previousPresentFence = mPreviousPresentFences[0].fenceTime;
     refreshArgs.nextInvalidateTime = mEventQueue->nextExpectedInvalidate();
+    refreshArgs.workerPool = getCompositionWorkerPool();
+    refreshArgs.presentOutputsInParallel = mPresentDisplaysInParallel;
+    refreshArgs.predictClientComposition = mPredictClientComposition;
 
     mGeometryInvalid = false;
 
@@ -2103,8 +2219,18 @@ void SurfaceFlinger::onMessageRefresh() {
     // the scheduler.
     const auto presentTime = systemTime();
 
+    std::vector<PendingReadback> readbacks = setReadbackBuffers(refreshArgs);
     mCompositionEngine->present(refreshArgs);
-    mTimeStats->recordFrameDuration(mFrameStartTime, systemTime());
+    const nsecs_t presentEndTime = systemTime();
+    mTimeStats->recordFrameDuration(mFrameStartTime, presentEndTime);
+    if (mFrameStartTime > 0 &&
+        (mPowerAdvisor.usePowerHintSession() || mPowerAdvisor.useAdaptiveUclamp())) {
+        // The frame, from its first invalidate to the end of its composition, has to fit in the
+        // work duration SurfaceFlinger is scheduled for.
+        mPowerAdvisor.setTargetWorkDuration(
+                mVsyncModulator->getVsyncConfig().sfWorkDuration.count());
+        mPowerAdvisor.sendActualWorkDuration(presentEndTime - mFrameStartTime, presentEndTime);
+    }
     // Reset the frame start time now that we've recorded this frame.
     mFrameStartTime = 0;
 
@@ -2112,6 +2238,7 @@ void SurfaceFlinger::onMessageRefresh() {
 
     postFrame();
     postComposition();
+    finishReadbackCaptures(std::move(readbacks));
 
     const bool prevFrameHadClientComposition = mHadClientComposition;
 
@@ -2446,19 +2573,41 @@ FloatRect SurfaceFlinger::getLayerClipBoundsForDisplay(const DisplayDevice& disp
     return displayDevice.getLayerStackSpaceRect().toFloatRect();
 }
 
+compositionengine::WorkerPool* SurfaceFlinger::getCompositionWorkerPool() {
+    // Created here rather than at startup, so that the threads get the main
+    // thread's scheduling policy.
+    if (mCompositionWorkerThreads > 0 && !mCompositionWorkerPool) {
+        mCompositionWorkerPool =
+                std::make_unique<compositionengine::WorkerPool>(mCompositionWorkerThreads);
+    }
+    return mCompositionWorkerPool.get();
+}
+
 void SurfaceFlinger::computeLayerBounds() {
+    compositionengine::WorkerPool* workerPool = getCompositionWorkerPool();
     for (const auto& pair : ON_MAIN_THREAD(mDisplays)) {
         const auto& displayDevice = pair.second;
         const auto display = displayDevice->getCompositionDisplay();
+        std::vector<Layer*> roots;
         for (const auto& layer : mDrawingState.layersSortedByZ) {
             // only consider the layers on the given layer stack
             if (!display->belongsInOutput(layer->getLayerStack(), layer->getPrimaryDisplayOnly())) {
                 continue;
             }
 
+            if (workerPool) {
+                roots.push_back(layer.get());
+                continue;
+            }
             layer->computeBounds(getLayerClipBoundsForDisplay(*displayDevice), ui::Transform(),
                                  0.f /* shadowRadius */);
         }
+
+        // Displays are still done one after the other, since a layer on more
+        // than one display keeps the bounds computed for the last of them.
+        if (workerPool) {
+            Layer::computeBounds(roots, getLayerClipBoundsForDisplay(*displayDevice), *workerPool);
+        }
     }
 }
 
@@ -3114,9 +3263,41 @@ void SurfaceFlinger::updateInputWindowInfo() {
         inputInfos.push_back(layer->fillInputInfo(display));
     });
 
-    mInputFlinger->setInputWindows(inputInfos,
-                               mInputWindowCommands.syncInputWindows ? mSetInputWindowsListener
-                                                                     : nullptr);
+    sendInputWindowInfos(inputInfos);
+}
+
+void SurfaceFlinger::sendInputWindowInfos(const std::vector<InputWindowInfo>& inputInfos) {
+    const sp<os::ISetInputWindowsListener> listener =
+            mInputWindowCommands.syncInputWindows ? mSetInputWindowsListener : nullptr;
+
+    // Only send the windows that were added or changed, unless most of them did, or there are
+    // no windows to compare them with.
+    std::vector<InputWindowInfo> changedInfos;
+    std::vector<int32_t> ids;
+    std::unordered_map<int32_t, InputWindowInfo> infosById;
+    bool sendAllInfos = mLastInputWindowInfos.empty();
+    for (size_t i = 0; i < inputInfos.size() && !sendAllInfos; i++) {
+        const InputWindowInfo& info = inputInfos[i];
+        auto it = mLastInputWindowInfos.find(info.id);
+        if (it == mLastInputWindowInfos.end() || !(it->second == info)) {
+            changedInfos.push_back(info);
+        }
+        ids.push_back(info.id);
+        // Windows are identified by their id, which has to be unique.
+        sendAllInfos = !infosById.emplace(info.id, info).second ||
+                changedInfos.size() * 2 > inputInfos.size();
+    }
+
+    if (sendAllInfos) {
+        infosById.clear();
+        for (const InputWindowInfo& info : inputInfos) {
+            infosById.emplace(info.id, info);
+        }
+        mInputFlinger->setInputWindows(inputInfos, listener);
+    } else {
+        mInputFlinger->updateInputWindows(changedInfos, ids, listener);
+    }
+    mLastInputWindowInfos = std::move(infosById);
 }
 
 void SurfaceFlinger::updateCursorAsync() {
@@ -3302,6 +3483,9 @@ bool SurfaceFlinger::handlePageFlip() {
     ATRACE_CALL();
     ALOGV("handlePageFlip");
 
+    // Layers that were captured must not release their buffer without the capture's fence
+    releasePendingCaptures(true /* waitForDraws */);
+
     nsecs_t latchTime = systemTime();
 
     bool visibleRegions = false;
@@ -3466,11 +3650,12 @@ void SurfaceFlinger::flushTransactionQueues() {
     // to prevent onHandleDestroyed from being called while the lock is held,
     // we must keep a copy of the transactions (specifically the composer
     // states) around outside the scope of the lock
-    std::vector<const TransactionState> transactions;
+    std::vector<TransactionState> transactions;
     // Layer handles that have transactions with buffers that are ready to be applied.
     std::unordered_set<sp<IBinder>, ISurfaceComposer::SpHash<IBinder>> bufferLayersReadyToPresent;
     {
         Mutex::Autolock _l(mStateLock);
+        collectIncomingTransactions();
         {
             Mutex::Autolock _l(mQueueLock);
             // Collect transactions from pending transaction queue.
@@ -3529,6 +3714,15 @@ void SurfaceFlinger::flushTransactionQueues() {
             }
         }
 
+        // Apps often send several transactions a frame which each rewrite the same properties.
+        // Merge runs of those from the same apply token, so each layer is only updated once.
+        // Not done while the interceptor records, since it records every transaction.
+        if (transactions.size() > 1 && !mInterceptor->isEnabled()) {
+            const size_t readyTransactions = transactions.size();
+            coalesceTransactions(transactions);
+            ATRACE_INT("CoalescedTransactions", readyTransactions - transactions.size());
+        }
+
         // Now apply all transactions.
         for (const auto& transaction : transactions) {
             applyTransactionState(transaction.frameTimelineInfo, transaction.states,
@@ -3546,9 +3740,31 @@ void SurfaceFlinger::flushTransactionQueues() {
     }
 }
 
+void SurfaceFlinger::coalesceTransactions(std::vector<TransactionState>& transactions) {
+    std::vector<TransactionState> coalesced;
+    coalesced.reserve(transactions.size());
+    for (auto& transaction : transactions) {
+        if (!coalesced.empty() && coalesced.back().canMergeWith(transaction)) {
+            coalesced.back().merge(transaction);
+        } else {
+            coalesced.emplace_back(std::move(transaction));
+        }
+    }
+    transactions = std::move(coalesced);
+}
+
+void SurfaceFlinger::collectIncomingTransactions() {
+    mIncomingTransactions.drain(
+            [&](TransactionState&& transaction) { mTransactionQueue.push(std::move(transaction)); });
+    ATRACE_INT("TransactionQueue", mTransactionQueue.size());
+}
+
 bool SurfaceFlinger::transactionFlushNeeded() {
+    if (!mIncomingTransactions.isEmpty() || !mTransactionQueue.empty()) {
+        return true;
+    }
     Mutex::Autolock _l(mQueueLock);
-    return !mPendingTransactionQueues.empty() || !mTransactionQueue.empty();
+    return !mPendingTransactionQueues.empty();
 }
 
 bool SurfaceFlinger::frameIsEarly(nsecs_t expectedPresentTime, int64_t vsyncId) const {
@@ -3637,13 +3853,13 @@ bool SurfaceFlinger::transactionIsReadyToBeApplied(
 }
 
 void SurfaceFlinger::queueTransaction(TransactionState& state) {
-    Mutex::Autolock _l(mQueueLock);
-
-    // If its TransactionQueue already has a pending TransactionState or if it is pending
-    auto itr = mPendingTransactionQueues.find(state.applyToken);
     // if this is an animation frame, wait until prior animation frame has
-    // been applied by SF
+    // been applied by SF. Other transactions are queued without taking any
+    // lock the main thread holds.
     if (state.flags & eAnimation) {
+        Mutex::Autolock _l(mQueueLock);
+        // If its TransactionQueue already has a pending TransactionState or if it is pending
+        auto itr = mPendingTransactionQueues.find(state.applyToken);
         while (itr != mPendingTransactionQueues.end()) {
             status_t err = mTransactionQueueCV.waitRelative(mQueueLock, s2ns(5));
             if (CC_UNLIKELY(err != NO_ERROR)) {
@@ -3664,8 +3880,7 @@ void SurfaceFlinger::queueTransaction(TransactionState& state) {
                          : CountDownLatch::eSyncTransaction));
     }
 
-    mTransactionQueue.emplace(state);
-    ATRACE_INT("TransactionQueue", mTransactionQueue.size());
+    mIncomingTransactions.push(state);
 
     const auto schedule = [](uint32_t flags) {
         if (flags & eEarlyWakeupEnd) return TransactionSchedule::EarlyEnd;
@@ -4220,8 +4435,7 @@ uint32_t SurfaceFlinger::setClientStateLocked(
     bool cacheIdChanged = what & layer_state_t::eCachedBufferChanged;
     std::shared_ptr<renderengine::ExternalTexture> buffer;
     if (bufferChanged && cacheIdChanged && s.buffer != nullptr) {
-        ClientCache::getInstance().add(s.cachedBuffer, s.buffer);
-        buffer = ClientCache::getInstance().get(s.cachedBuffer);
+        buffer = ClientCache::getInstance().add(s.cachedBuffer, s.buffer);
     } else if (cacheIdChanged) {
         buffer = ClientCache::getInstance().get(s.cachedBuffer);
     } else if (bufferChanged && s.buffer != nullptr) {
@@ -4557,10 +4771,8 @@ void SurfaceFlinger::setPowerModeInternal(const sp<DisplayDevice>& display, hal:
     const auto vsyncPeriod = mRefreshRateConfigs->getCurrentRefreshRate().getVsyncPeriod();
     if (currentMode == hal::PowerMode::OFF) {
         // Keep uclamp in a separate syscall and set it before changing to RT due to b/190237315.
-        // We can merge the syscall later.
-        if (SurfaceFlinger::setSchedAttr(true) != NO_ERROR) {
-            ALOGW("Couldn't set uclamp.min on display on: %s\n", strerror(errno));
-        }
+        // We can merge the syscall later. PowerAdvisor sets it, as it also boosts it.
+        mPowerAdvisor.setUclampFloorEnabled(true);
         if (SurfaceFlinger::setSchedFifo(true) != NO_ERROR) {
             ALOGW("Couldn't set SCHED_FIFO on display on: %s\n", strerror(errno));
         }
@@ -4579,9 +4791,7 @@ void SurfaceFlinger::setPowerModeInternal(const sp<DisplayDevice>& display, hal:
         if (SurfaceFlinger::setSchedFifo(false) != NO_ERROR) {
             ALOGW("Couldn't set SCHED_OTHER on display off: %s\n", strerror(errno));
         }
-        if (SurfaceFlinger::setSchedAttr(false) != NO_ERROR) {
-            ALOGW("Couldn't set uclamp.min on display off: %s\n", strerror(errno));
-        }
+        mPowerAdvisor.setUclampFloorEnabled(false);
         if (display->isPrimary() && currentMode != hal::PowerMode::DOZE_SUSPEND) {
             mScheduler->disableHardwareVsync(true);
             mScheduler->onScreenReleased(mAppConnectionHandle);
@@ -4656,6 +4866,7 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
                 {"--latency-clear"s, argsDumper(&SurfaceFlinger::clearStatsLocked)},
                 {"--list"s, dumper(&SurfaceFlinger::listLayersLocked)},
                 {"--planner"s, argsDumper(&SurfaceFlinger::dumpPlannerInfo)},
+                {"--refresh-rate"s, dumper(&SurfaceFlinger::dumpRefreshRate)},
                 {"--static-screen"s, dumper(&SurfaceFlinger::dumpStaticScreenStats)},
                 {"--timestats"s, protoDumper(&SurfaceFlinger::dumpTimeStats)},
                 {"--vsync"s, dumper(&SurfaceFlinger::dumpVSync)},
@@ -4684,7 +4895,12 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
         if (dumpLayers) {
             const LayersProto layersProto = dumpProtoFromMainThread();
             if (asProto) {
-                result.append(layersProto.SerializeAsString());
+                // Encoded straight to the fd, which spares a copy of a dump of several megabytes.
+                write(fd, result.c_str(), result.size());
+                result.clear();
+                if (!layersProto.SerializeToFileDescriptor(fd)) {
+                    ALOGE("Failed to write the layers proto");
+                }
             } else {
                 // Dump info that we need to access from the main thread
                 const auto layerTree = LayerProtoParser::generateLayerTree(layersProto);
@@ -4790,6 +5006,12 @@ void SurfaceFlinger::dumpVSync(std::string& result) const {
     mScheduler->dumpVsync(result);
 }
 
+void SurfaceFlinger::dumpRefreshRate(std::string& result) const {
+    mRefreshRateStats->dump(result);
+    result.append("\n");
+    mScheduler->dumpIdleTimer(result);
+}
+
 void SurfaceFlinger::dumpPlannerInfo(const DumpArgs& args, std::string& result) const {
     for (const auto& [token, display] : mDisplays) {
         const auto compositionDisplay = display->getCompositionDisplay();
@@ -4812,6 +5034,24 @@ void SurfaceFlinger::dumpStaticScreenStats(std::string& result) const {
                   bucketTimeSec, percent);
 }
 
+void SurfaceFlinger::dumpStartupTimings(std::string& result) const {
+    const auto& timings = mStartupTimings;
+    result.append("Startup timings:\n");
+    StringAppendF(&result, "  init: %.3f ms\n", timings.init / 1e6);
+    StringAppendF(&result, "    RenderEngine creation: %.3f ms\n",
+                  timings.renderEngineCreation / 1e6);
+    StringAppendF(&result, "    HWC connection: %.3f ms (concurrently), waited %.3f ms\n",
+                  timings.hwcConnection / 1e6, timings.hwcWait / 1e6);
+    StringAppendF(&result, "    initial hotplug: %.3f ms\n", timings.initialHotplug / 1e6);
+    StringAppendF(&result, "    display initialization: %.3f ms\n",
+                  timings.displayInitialization / 1e6);
+    if (timings.boot > 0) {
+        StringAppendF(&result, "  boot finished after: %.3f ms\n", timings.boot / 1e6);
+    } else {
+        result.append("  boot not finished\n");
+    }
+}
+
 void SurfaceFlinger::recordBufferingStats(const std::string& layerName,
                                           std::vector<OccupancyTracker::Segment>&& history) {
     Mutex::Autolock lock(getBE().mBufferingStatsMutex);
@@ -4983,12 +5223,12 @@ void SurfaceFlinger::dumpOffscreenLayersProto(LayersProto& layersProto, uint32_t
 }
 
 LayersProto SurfaceFlinger::dumpProtoFromMainThread(uint32_t traceFlags) {
-    return schedule([=] { return dumpDrawingStateProto(traceFlags); }).get();
+    return scheduleDeferred([=] { return dumpDrawingStateProto(traceFlags); }).get();
 }
 
 void SurfaceFlinger::dumpOffscreenLayers(std::string& result) {
     result.append("Offscreen Layers:\n");
-    result.append(schedule([this] {
+    result.append(scheduleDeferred([this] {
                       std::string result;
                       for (Layer* offscreenLayer : mOffscreenLayers) {
                           offscreenLayer->traverse(LayerVector::StateSet::Drawing,
@@ -5040,10 +5280,19 @@ void SurfaceFlinger::dumpAllLocked(const DumpArgs& args, std::string& result) co
     dumpStaticScreenStats(result);
     result.append("\n");
 
+    dumpStartupTimings(result);
+    result.append("\n");
+
     StringAppendF(&result, "Total missed frame count: %u\n", mFrameMissedCount.load());
     StringAppendF(&result, "HWC missed frame count: %u\n", mHwcFrameMissedCount.load());
     StringAppendF(&result, "GPU missed frame count: %u\n\n", mGpuFrameMissedCount.load());
 
+    StringAppendF(&result,
+                  "Screen captures read back by HWC: %u, drawn by RenderEngine: %u (%u after a "
+                  "failed readback)\n\n",
+                  mReadbackCaptureCount.load(), mRenderEngineCaptureCount.load(),
+                  mFailedReadbackCaptureCount.load());
+
     dumpBufferingStats(result);
 
     /*
@@ -5199,6 +5448,19 @@ void SurfaceFlinger::updateColorMatrixLocked() {
     mat4 colorMatrix =
             mClientColorMatrix * calculateColorMatrix(mGlobalSaturationFactor) * mDaltonizer();
 
+    // The combined matrix may be the identity but for rounding, e.g. when the client matrix is
+    // made of transforms that cancel out. Snapping it to the identity gives HWC the IDENTITY hint
+    // rather than an arbitrary matrix it may reject, and spares RenderEngine a matrix that does
+    // nothing when it composites.
+    const mat4 identity;
+    bool isIdentity = true;
+    for (size_t i = 0; i < 4 && isIdentity; i++) {
+        isIdentity = !any(greaterThan(abs(colorMatrix[i] - identity[i]), float4{1e-4f}));
+    }
+    if (isIdentity) {
+        colorMatrix = identity;
+    }
+
     if (mCurrentState.colorMatrix != colorMatrix) {
         mCurrentState.colorMatrix = colorMatrix;
         mCurrentState.colorMatrixChanged = true;
@@ -5512,8 +5774,13 @@ status_t SurfaceFlinger::onTransact(uint32_t code, const Parcel& data, Parcel* r
             }
             case 1020: { // Layer updates interceptor
                 n = data.readInt32();
-                if (n) {
+                if (n == 3) {
+                    ALOGV("Interceptor trace written");
+                    mInterceptor->writeTraceToFile();
+                } else if (n) {
+                    // 2 only keeps the most recent increments, as a flight recorder.
                     ALOGV("Interceptor enabled");
+                    mInterceptor->setMaxTraceSize(n == 2 ? FLIGHT_RECORDER_TRACE_SIZE : 0);
                     mInterceptor->enable(mDrawingState.layersSortedByZ, mDrawingState.displays);
                 }
                 else{
@@ -5942,34 +6209,34 @@ status_t SurfaceFlinger::setSchedAttr(bool enabled) {
         return NO_ERROR;
     }
 
-    // Currently, there is no wrapper in bionic: b/183240349.
-    struct sched_attr {
-        uint32_t size;
-        uint32_t sched_policy;
-        uint64_t sched_flags;
-        int32_t sched_nice;
-        uint32_t sched_priority;
-        uint64_t sched_runtime;
-        uint64_t sched_deadline;
-        uint64_t sched_period;
-        uint32_t sched_util_min;
-        uint32_t sched_util_max;
-    };
+    return setUclampMin(0, enabled ? kUclampMin : 0);
+}
 
+status_t SurfaceFlinger::setUclampMin(pid_t tid, uint32_t uclampMin) {
     sched_attr attr = {};
     attr.size = sizeof(attr);
 
     attr.sched_flags = (SCHED_FLAG_KEEP_ALL | SCHED_FLAG_UTIL_CLAMP);
-    attr.sched_util_min = enabled ? kUclampMin : 0;
+    attr.sched_util_min = uclampMin;
     attr.sched_util_max = 1024;
 
-    if (syscall(__NR_sched_setattr, 0, &attr, 0)) {
+    if (syscall(__NR_sched_setattr, tid, &attr, 0)) {
         return -errno;
     }
 
     return NO_ERROR;
 }
 
+status_t SurfaceFlinger::getUclampMin(pid_t tid, uint32_t* outUclampMin) {
+    sched_attr attr = {};
+    if (syscall(__NR_sched_getattr, tid, &attr, sizeof(attr), 0)) {
+        return -errno;
+    }
+
+    *outUclampMin = attr.sched_util_min;
+    return NO_ERROR;
+}
+
 status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
                                         const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
@@ -6019,6 +6286,7 @@ status_t SurfaceFlinger::captureDisplay(const DisplayCaptureArgs& args,
 
     return captureScreenCommon(std::move(renderAreaFuture), traverseLayers, reqSize,
                                args.pixelFormat, args.allowProtected, args.grayscale,
+                               args.uid == CaptureArgs::UNSET_UID /* allowReadback */,
                                captureListener);
 }
 
@@ -6063,7 +6331,7 @@ status_t SurfaceFlinger::captureDisplay(uint64_t displayIdOrLayerStack,
 
     return captureScreenCommon(std::move(renderAreaFuture), traverseLayers, size,
                                ui::PixelFormat::RGBA_8888, false /* allowProtected */,
-                               false /* grayscale */, captureListener);
+                               false /* grayscale */, true /* allowReadback */, captureListener);
 }
 
 status_t SurfaceFlinger::captureLayers(const LayerCaptureArgs& args,
@@ -6188,13 +6456,14 @@ status_t SurfaceFlinger::captureLayers(const LayerCaptureArgs& args,
 
     return captureScreenCommon(std::move(renderAreaFuture), traverseLayers, reqSize,
                                args.pixelFormat, args.allowProtected, args.grayscale,
-                               captureListener);
+                               false /* allowReadback */, captureListener);
 }
 
 status_t SurfaceFlinger::captureScreenCommon(RenderAreaFuture renderAreaFuture,
                                              TraverseLayersFunction traverseLayers,
                                              ui::Size bufferSize, ui::PixelFormat reqPixelFormat,
                                              bool allowProtected, bool grayscale,
+                                             bool allowReadback,
                                              const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
 
@@ -6230,15 +6499,17 @@ status_t SurfaceFlinger::captureScreenCommon(RenderAreaFuture renderAreaFuture,
                         bufferStatus);
     const auto texture = std::make_shared<
             renderengine::ExternalTexture>(buffer, getRenderEngine(),
-                                           renderengine::ExternalTexture::Usage::WRITEABLE);
+                                           renderengine::ExternalTexture::Usage::WRITEABLE,
+                                           renderengine::ExternalTexture::Owner::SCREENSHOT);
     return captureScreenCommon(std::move(renderAreaFuture), traverseLayers, texture,
-                               false /* regionSampling */, grayscale, captureListener);
+                               false /* regionSampling */, grayscale, allowReadback,
+                               captureListener);
 }
 
 status_t SurfaceFlinger::captureScreenCommon(
         RenderAreaFuture renderAreaFuture, TraverseLayersFunction traverseLayers,
         const std::shared_ptr<renderengine::ExternalTexture>& buffer, bool regionSampling,
-        bool grayscale, const sp<IScreenCaptureListener>& captureListener) {
+        bool grayscale, bool allowReadback, const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
 
     if (captureListener == nullptr) {
@@ -6252,7 +6523,7 @@ status_t SurfaceFlinger::captureScreenCommon(
         if (mRefreshPending) {
             ALOGW("Skipping screenshot for now");
             captureScreenCommon(std::move(renderAreaFuture), traverseLayers, buffer, regionSampling,
-                                grayscale, captureListener);
+                                grayscale, allowReadback, captureListener);
             return;
         }
         ScreenCaptureResults captureResults;
@@ -6264,15 +6535,27 @@ status_t SurfaceFlinger::captureScreenCommon(
             return;
         }
 
+        if (allowReadback && !grayscale &&
+            queueReadbackCapture(renderArea, traverseLayers, buffer, canCaptureBlackoutContent,
+                                 captureListener)) {
+            return;
+        }
+        if (!regionSampling) {
+            mRenderEngineCaptureCount++;
+        }
+
         status_t result = NO_ERROR;
         renderArea->render([&] {
             result = renderScreenImplLocked(*renderArea, traverseLayers, buffer,
                                             canCaptureBlackoutContent, regionSampling, grayscale,
-                                            captureResults);
+                                            captureListener);
         });
 
-        captureResults.result = result;
-        captureListener->onScreenCaptureCompleted(captureResults);
+        // Otherwise the listener is called once RenderEngine has drawn the layers
+        if (result != NO_ERROR) {
+            captureResults.result = result;
+            captureListener->onScreenCaptureCompleted(captureResults);
+        }
     }));
 
     return NO_ERROR;
@@ -6282,9 +6565,12 @@ status_t SurfaceFlinger::renderScreenImplLocked(
         const RenderArea& renderArea, TraverseLayersFunction traverseLayers,
         const std::shared_ptr<renderengine::ExternalTexture>& buffer,
         bool canCaptureBlackoutContent, bool regionSampling, bool grayscale,
-        ScreenCaptureResults& captureResults) {
+        const sp<IScreenCaptureListener>& captureListener) {
     ATRACE_CALL();
 
+    releasePendingCaptures(false /* waitForDraws */);
+
+    ScreenCaptureResults captureResults;
     traverseLayers([&](Layer* layer) {
         captureResults.capturedSecureLayers =
                 captureResults.capturedSecureLayers || (layer->isVisible() && layer->isSecure());
@@ -6336,7 +6622,7 @@ status_t SurfaceFlinger::renderScreenImplLocked(
     clientCompositionLayers.push_back(fillLayer);
 
     const auto display = renderArea.getDisplayDevice();
-    std::vector<Layer*> renderedLayers;
+    std::vector<sp<Layer>> renderedLayers;
     Region clearRegion = Region::INVALID_REGION;
     bool disableBlurs = false;
     traverseLayers([&](Layer* layer) {
@@ -6381,37 +6667,194 @@ status_t SurfaceFlinger::renderScreenImplLocked(
 
     });
 
-    std::vector<const renderengine::LayerSettings*> clientCompositionLayerPointers(
-            clientCompositionLayers.size());
-    std::transform(clientCompositionLayers.begin(), clientCompositionLayers.end(),
-                   clientCompositionLayerPointers.begin(),
-                   std::pointer_traits<renderengine::LayerSettings*>::pointer_to);
-
     clientCompositionDisplay.clearRegion = clearRegion;
     // Use an empty fence for the buffer fence, since we just created the buffer so
     // there is no need for synchronization with the GPU.
     base::unique_fd bufferFence;
-    base::unique_fd drawFence;
     getRenderEngine().useProtectedContext(useProtected);
 
-    const constexpr bool kUseFramebufferCache = false;
-    getRenderEngine().drawLayers(clientCompositionDisplay, clientCompositionLayerPointers, buffer,
-                                 kUseFramebufferCache, std::move(bufferFence), &drawFence);
+    // The layer settings are a snapshot of the layers, so RenderEngine draws them while the main
+    // thread goes on. The rendered layers get the draw fence before they latch another buffer.
+    auto drawFencePromise = std::make_shared<std::promise<sp<Fence>>>();
+    mPendingCaptures.push_back({drawFencePromise->get_future(), std::move(renderedLayers)});
 
-    if (drawFence >= 0) {
-        sp<Fence> releaseFence = new Fence(dup(drawFence));
-        for (auto* layer : renderedLayers) {
-            layer->onLayerDisplayed(releaseFence);
-        }
-    }
+    const constexpr bool kUseFramebufferCache = false;
+    getRenderEngine().drawLayersAsync(
+            clientCompositionDisplay,
+            std::vector<renderengine::LayerSettings>(clientCompositionLayers.begin(),
+                                                     clientCompositionLayers.end()),
+            buffer, kUseFramebufferCache, std::move(bufferFence),
+            [captureResults, captureListener,
+             drawFencePromise](status_t status, base::unique_fd&& drawFence) mutable {
+                ALOGE_IF(status != NO_ERROR, "Screen capture failed to draw: %d", status);
+                drawFencePromise->set_value(drawFence >= 0 ? sp<Fence>::make(dup(drawFence))
+                                                           : Fence::NO_FENCE);
+                captureResults.fence = new Fence(drawFence.release());
+                if (captureListener) {
+                    captureListener->onScreenCaptureCompleted(captureResults);
+                }
+            });
 
-    captureResults.fence = new Fence(drawFence.release());
     // Always switch back to unprotected context.
     getRenderEngine().useProtectedContext(false);
 
     return NO_ERROR;
 }
 
+bool SurfaceFlinger::queueReadbackCapture(
+        std::unique_ptr<RenderArea>& renderArea, TraverseLayersFunction traverseLayers,
+        const std::shared_ptr<renderengine::ExternalTexture>& buffer,
+        bool canCaptureBlackoutContent, const sp<IScreenCaptureListener>& captureListener) {
+    const auto display = renderArea->getDisplayDevice();
+    if (mBootStage != BootStage::FINISHED ||
+        !isReadbackExact(*renderArea,
+                         display ? display->getCompositionDisplay()->getState().colorTransformMatrix
+                                 : mat4())) {
+        return false;
+    }
+    // Only one readback buffer can be given for each frame.
+    if (std::any_of(mPendingReadbacks.cbegin(), mPendingReadbacks.cend(),
+                    [&display](const PendingReadback& readback) {
+                        return readback.renderArea->getDisplayDevice() == display;
+                    })) {
+        return false;
+    }
+
+    ui::PixelFormat format;
+    ui::Dataspace dataspace;
+    if (getHwComposer().getReadbackBufferAttributes(display->getPhysicalId(), &format,
+                                                    &dataspace) != NO_ERROR) {
+        return false;
+    }
+    const auto& graphicBuffer = buffer->getBuffer();
+    if (static_cast<ui::PixelFormat>(graphicBuffer->getPixelFormat()) != format ||
+        dataspace != renderArea->getReqDataSpace() ||
+        (graphicBuffer->getUsage() & GRALLOC_USAGE_PROTECTED)) {
+        return false;
+    }
+
+    mPendingReadbacks.push_back({std::move(renderArea), std::move(traverseLayers), buffer,
+                                 canCaptureBlackoutContent, captureListener});
+    signalTransaction();
+    return true;
+}
+
+bool SurfaceFlinger::isReadbackExact(const RenderArea& renderArea, const mat4& colorTransform) {
+    const auto display = renderArea.getDisplayDevice();
+    if (!display || display->isVirtual() || !display->isPoweredOn()) {
+        return false;
+    }
+
+    // The readback is taken while the HWC composes the display by itself, so that no GPU work
+    // is needed at all. It is the whole frame as presented, which RenderEngine would only draw
+    // the same without scaling, rotation or a color transform.
+    const auto& state = display->getCompositionDisplay()->getState();
+    const Rect& bounds = display->getBounds();
+    if (state.usesClientComposition || !state.usesDeviceComposition ||
+        colorTransform != mat4() || display->getTransform().getType() != ui::Transform::IDENTITY ||
+        renderArea.getRotationFlags() != ui::Transform::ROT_0 ||
+        renderArea.getSourceCrop() != bounds || renderArea.getReqWidth() != bounds.getWidth() ||
+        renderArea.getReqHeight() != bounds.getHeight()) {
+        return false;
+    }
+
+    // Captures leave out the layers shown only on the primary display, and never show secure or
+    // protected content as it is presented.
+    bool hasExcludedLayer = false;
+    const auto layerStack = display->getLayerStack();
+    for (const auto& layer : mDrawingState.layersSortedByZ) {
+        if (!layer->belongsToDisplay(layerStack)) {
+            continue;
+        }
+        layer->traverseInZOrder(LayerVector::StateSet::Drawing, [&](Layer* layer) {
+            hasExcludedLayer = hasExcludedLayer ||
+                    (layer->isVisible() &&
+                     (layer->getPrimaryDisplayOnly() || layer->isSecure() ||
+                      layer->isProtected()));
+        });
+    }
+    return !hasExcludedLayer;
+}
+
+std::vector<SurfaceFlinger::PendingReadback> SurfaceFlinger::setReadbackBuffers(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    std::vector<PendingReadback> readbacks;
+    readbacks.swap(mPendingReadbacks);
+    for (auto it = readbacks.begin(); it != readbacks.end();) {
+        // Transactions committed since the capture was queued may have added a secure layer or a
+        // color transform, so the frame about to be presented is checked again.
+        const auto display = it->renderArea->getDisplayDevice();
+        const mat4 colorTransform = display
+                ? refreshArgs.colorTransformMatrix.value_or(
+                          display->getCompositionDisplay()->getState().colorTransformMatrix)
+                : mat4();
+        if (isReadbackExact(*it->renderArea, colorTransform) &&
+            getHwComposer().setReadbackBuffer(display->getPhysicalId(), it->buffer->getBuffer(),
+                                              Fence::NO_FENCE) == NO_ERROR) {
+            ++it;
+        } else {
+            renderFailedReadbackCapture(*it);
+            it = readbacks.erase(it);
+        }
+    }
+    return readbacks;
+}
+
+void SurfaceFlinger::finishReadbackCaptures(std::vector<PendingReadback>&& readbacks) {
+    for (auto& readback : readbacks) {
+        const auto displayId = readback.renderArea->getDisplayDevice()->getPhysicalId();
+        sp<Fence> readbackFence;
+        if (getHwComposer().getReadbackBufferFence(displayId, &readbackFence) != NO_ERROR) {
+            renderFailedReadbackCapture(readback);
+            continue;
+        }
+
+        mReadbackCaptureCount++;
+        ScreenCaptureResults captureResults;
+        captureResults.buffer = readback.buffer->getBuffer();
+        captureResults.capturedDataspace = readback.renderArea->getReqDataSpace();
+        captureResults.fence = readbackFence;
+        readback.captureListener->onScreenCaptureCompleted(captureResults);
+    }
+}
+
+void SurfaceFlinger::renderFailedReadbackCapture(PendingReadback& readback) {
+    mFailedReadbackCaptureCount++;
+    mRenderEngineCaptureCount++;
+
+    status_t result = NO_ERROR;
+    readback.renderArea->render([&] {
+        result = renderScreenImplLocked(*readback.renderArea, readback.traverseLayers,
+                                        readback.buffer, readback.canCaptureBlackoutContent,
+                                        false /* regionSampling */, false /* grayscale */,
+                                        readback.captureListener);
+    });
+    if (result != NO_ERROR) {
+        ScreenCaptureResults captureResults;
+        captureResults.result = result;
+        readback.captureListener->onScreenCaptureCompleted(captureResults);
+    }
+}
+
+void SurfaceFlinger::releasePendingCaptures(bool waitForDraws) {
+    while (!mPendingCaptures.empty()) {
+        auto& capture = mPendingCaptures.front();
+        if (!waitForDraws &&
+            capture.drawFence.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+
+        ATRACE_NAME("releasePendingCapture");
+        const sp<Fence> releaseFence = capture.drawFence.get();
+        if (releaseFence->isValid()) {
+            for (const auto& layer : capture.layers) {
+                layer->onLayerDisplayed(releaseFence);
+            }
+        }
+        mPendingCaptures.pop_front();
+    }
+}
+
 void SurfaceFlinger::setInputWindowsFinished() {
     Mutex::Autolock _l(mStateLock);
     signalSynchronousTransactions(CountDownLatch::eSyncInputWindows);
@@ -6893,6 +7336,51 @@ void SurfaceFlinger::TransactionState::traverseStatesWithBuffers(
     }
 }
 
+bool SurfaceFlinger::TransactionState::onlyChangesLayerProperties() const {
+    if (!displays.empty() || !inputWindowCommands.empty() || hasListenerCallbacks ||
+        !listenerCallbacks.empty() || buffer.isValid() || transactionCommittedSignal) {
+        return false;
+    }
+
+    constexpr uint64_t kUnmergeableChanges = layer_state_t::eAcquireFenceChanged |
+            layer_state_t::eHasListenerCallbacksChanged |
+            layer_state_t::eReleaseBufferListenerChanged;
+    for (const ComposerState& state : states) {
+        if (state.state.hasBufferChanges() || (state.state.what & kUnmergeableChanges)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SurfaceFlinger::TransactionState::canMergeWith(const TransactionState& other) const {
+    return applyToken == other.applyToken && flags == other.flags &&
+            permissions == other.permissions && originPid == other.originPid &&
+            originUid == other.originUid && desiredPresentTime == other.desiredPresentTime &&
+            isAutoTimestamp == other.isAutoTimestamp &&
+            // Each transaction with a vsync id gets its own surface frames.
+            frameTimelineInfo.vsyncId == FrameTimelineInfo::INVALID_VSYNC_ID &&
+            other.frameTimelineInfo.vsyncId == FrameTimelineInfo::INVALID_VSYNC_ID &&
+            frameTimelineInfo.inputEventId == other.frameTimelineInfo.inputEventId &&
+            onlyChangesLayerProperties() && other.onlyChangesLayerProperties();
+}
+
+void SurfaceFlinger::TransactionState::merge(const TransactionState& other) {
+    size_t i = 0;
+    // Merging a state into an earlier one would apply it before the states in between, which
+    // matters for changes like relative layers and reparenting. So only the last state can take
+    // the first state of 'other'.
+    const size_t last = states.size() - 1;
+    if (!states.isEmpty() && !other.states.isEmpty() && states[last].state.surface != nullptr &&
+        states[last].state.surface == other.states[0].state.surface) {
+        states.editItemAt(last).state.merge(other.states[0].state);
+        i++;
+    }
+    for (; i < other.states.size(); i++) {
+        states.add(other.states[i]);
+    }
+}
+
 void SurfaceFlinger::setLayerCreatedState(const sp<IBinder>& handle, const wp<Layer>& layer,
                                           const wp<IBinder>& parent, const wp<Layer> parentLayer,
                                           const wp<IBinder>& producer, bool addToRoot) {
@@ -24,6 +24,7 @@
 
 #include <android-base/thread_annotations.h>
 #include <compositionengine/OutputColorSetting.h>
+#include <compositionengine/WorkerPool.h>
 #include <cutils/atomic.h>
 #include <cutils/compiler.h>
 #include <gui/BufferQueue.h>
@@ -57,6 +58,7 @@
 #include "Fps.h"
 #include "FrameTracker.h"
 #include "LayerVector.h"
+#include "LocklessQueue.h"
 #include "Scheduler/RefreshRateConfigs.h"
 #include "Scheduler/RefreshRateStats.h"
 #include "Scheduler/Scheduler.h"
@@ -68,6 +70,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <future>
 #include <map>
@@ -189,6 +192,10 @@ public:
     // set main thread scheduling attributes
     static status_t setSchedAttr(bool enabled);
 
+    // set or get the uclamp.min of a thread, or of the calling thread if tid is 0
+    static status_t setUclampMin(pid_t tid, uint32_t uclampMin);
+    static status_t getUclampMin(pid_t tid, uint32_t* outUclampMin);
+
     static char const* getServiceName() ANDROID_API { return "SurfaceFlinger"; }
 
     // This is the phase offset in nanoseconds of the software vsync event
@@ -284,6 +291,9 @@ public:
     // Schedule an asynchronous or synchronous task on the main thread.
     template <typename F, typename T = std::invoke_result_t<F>>
     [[nodiscard]] std::future<T> schedule(F&&);
+    // Same, for best-effort tasks that can wait for the frame being composed, or about to be.
+    template <typename F, typename T = std::invoke_result_t<F>>
+    [[nodiscard]] std::future<T> scheduleDeferred(F&&);
 
     // force full composition on all displays
     void repaintEverything();
@@ -333,6 +343,12 @@ public:
     // If set, disables reusing client composition buffers. This can be set by
     // debug.sf.disable_client_composition_cache
     bool mDisableClientCompositionCache = false;
+    // If positive, the number of client composition requests cached per display, instead of the
+    // number of framebuffer buffers. This can be set by debug.sf.client_composition_cache_size
+    int32_t mClientCompositionCacheSize = 0;
+    // If set, only the damage of the frame is drawn with client composition when the display
+    // buffer holds a recent frame. This can be set by debug.sf.enable_partial_client_composition
+    bool mPartialClientComposition = false;
     void setInputWindowsFinished();
 
     // Disables expensive rendering for all displays
@@ -547,6 +563,17 @@ private:
 
         void traverseStatesWithBuffers(std::function<void(const layer_state_t&)> visitor);
 
+        // Returns true if applying 'other' right after this transaction is the same as applying
+        // them merged. Only transactions from the same apply token which change nothing but layer
+        // properties, and have no buffers, callbacks, frame timeline info or synchronous commit,
+        // can be merged.
+        bool canMergeWith(const TransactionState& other) const;
+        // Appends the layer states of 'other', which was queued after this one, to this
+        // transaction. Only a state for the layer this transaction changes last is merged into
+        // that layer's state, so the states are still applied in the order they were queued.
+        void merge(const TransactionState& other);
+        bool onlyChangesLayerProperties() const;
+
         FrameTimelineInfo frameTimelineInfo;
         Vector<ComposerState> states;
         Vector<DisplayState> displays;
@@ -812,6 +839,7 @@ private:
 
     void updateInputFlinger();
     void updateInputWindowInfo();
+    void sendInputWindowInfos(const std::vector<InputWindowInfo>& inputInfos);
     void commitInputWindowCommands() REQUIRES(mStateLock);
     void updateCursorAsync();
 
@@ -839,6 +867,10 @@ private:
             REQUIRES(mStateLock);
     // flush pending transaction that was presented after desiredPresentTime.
     void flushTransactionQueues();
+    // Merges each run of ready transactions that can be merged, see TransactionState::merge.
+    static void coalesceTransactions(std::vector<TransactionState>& transactions);
+    // Moves the transactions queued since the last call to mTransactionQueue.
+    void collectIncomingTransactions();
     // Returns true if there is at least one transaction that needs to be flushed
     bool transactionFlushNeeded();
     uint32_t getTransactionFlags(uint32_t flags);
@@ -909,21 +941,56 @@ private:
 
     // Traverse through all the layers and compute and cache its bounds.
     void computeLayerBounds();
+    // Null unless debug.sf.composition_worker_threads is set. Only used on the main thread.
+    compositionengine::WorkerPool* getCompositionWorkerPool();
 
     // Boot animation, on/off animations and screen capture
     void startBootAnim();
 
+    // If allowReadback is true, the capture is of a whole display, and may be read back by the
+    // HWC instead of drawn by RenderEngine when it is an exact copy of the presented frame.
     status_t captureScreenCommon(RenderAreaFuture, TraverseLayersFunction, ui::Size bufferSize,
                                  ui::PixelFormat, bool allowProtected, bool grayscale,
-                                 const sp<IScreenCaptureListener>&);
+                                 bool allowReadback, const sp<IScreenCaptureListener>&);
     status_t captureScreenCommon(RenderAreaFuture, TraverseLayersFunction,
                                  const std::shared_ptr<renderengine::ExternalTexture>&,
-                                 bool regionSampling, bool grayscale,
+                                 bool regionSampling, bool grayscale, bool allowReadback,
                                  const sp<IScreenCaptureListener>&);
+    // Queues the capture to RenderEngine. If NO_ERROR is returned, the listener, if any, is
+    // called once the layers are drawn.
     status_t renderScreenImplLocked(const RenderArea&, TraverseLayersFunction,
                                     const std::shared_ptr<renderengine::ExternalTexture>&,
                                     bool canCaptureBlackoutContent, bool regionSampling,
-                                    bool grayscale, ScreenCaptureResults&);
+                                    bool grayscale, const sp<IScreenCaptureListener>&);
+    // Gives the layers drawn by earlier screen captures their release fence. If waitForDraws is
+    // false, only the captures that RenderEngine already drew are released.
+    void releasePendingCaptures(bool waitForDraws);
+
+    // A display capture that the HWC reads back when it presents the next frame.
+    struct PendingReadback {
+        std::unique_ptr<RenderArea> renderArea;
+        TraverseLayersFunction traverseLayers;
+        std::shared_ptr<renderengine::ExternalTexture> buffer;
+        bool canCaptureBlackoutContent;
+        sp<IScreenCaptureListener> captureListener;
+    };
+    // Queues the capture for readback if the HWC composes the display by itself and its readback
+    // is exactly what RenderEngine would draw. Otherwise, returns false and leaves the render area
+    // to the caller.
+    bool queueReadbackCapture(std::unique_ptr<RenderArea>&, TraverseLayersFunction,
+                              const std::shared_ptr<renderengine::ExternalTexture>&,
+                              bool canCaptureBlackoutContent, const sp<IScreenCaptureListener>&);
+    // Returns whether the HWC readback of the display is exactly what RenderEngine would draw for
+    // the capture, given the layers of the drawing state and the display's color transform.
+    bool isReadbackExact(const RenderArea&, const mat4& colorTransform);
+    // Gives the queued readback buffers to the HWC before the frame is presented, and returns the
+    // captures to finish once it is. The captures that are no longer exact for the frame are
+    // drawn by RenderEngine instead.
+    std::vector<PendingReadback> setReadbackBuffers(
+            const compositionengine::CompositionRefreshArgs&);
+    void finishReadbackCaptures(std::vector<PendingReadback>&&);
+    // Has RenderEngine draw a capture whose readback failed.
+    void renderFailedReadbackCapture(PendingReadback&);
 
     // If the uid provided is not UNSET_UID, the traverse will skip any layers that don't have a
     // matching ownerUid
@@ -1130,7 +1197,9 @@ private:
     void logFrameStats();
 
     void dumpVSync(std::string& result) const REQUIRES(mStateLock);
+    void dumpRefreshRate(std::string& result) const REQUIRES(mStateLock);
     void dumpStaticScreenStats(std::string& result) const;
+    void dumpStartupTimings(std::string& result) const REQUIRES(mStateLock);
     // Not const because each Layer needs to query Fences and cache timestamps.
     void dumpFrameEventsLocked(std::string& result);
 
@@ -1230,6 +1299,21 @@ private:
 
     std::atomic<bool> mRepaintEverything = false;
 
+    // How long the steps of init() took, for dumpsys. The same steps are traced.
+    struct StartupTimings {
+        nsecs_t renderEngineCreation = 0;
+        // Runs concurrently with renderEngineCreation.
+        nsecs_t hwcConnection = 0;
+        // What hwcConnection took beyond renderEngineCreation.
+        nsecs_t hwcWait = 0;
+        nsecs_t initialHotplug = 0;
+        nsecs_t displayInitialization = 0;
+        nsecs_t init = 0;
+        // From the construction of SurfaceFlinger to bootFinished().
+        nsecs_t boot = 0;
+    };
+    StartupTimings mStartupTimings GUARDED_BY(mStateLock);
+
     // constant members (no synchronization needed for access)
     const nsecs_t mBootTime = systemTime();
     bool mGpuToCpuSupported = false;
@@ -1297,6 +1381,23 @@ private:
     bool mDebugDisableHWC = false;
     bool mDebugDisableTransformHint = false;
     bool mLayerCachingEnabled = false;
+    size_t mCompositionWorkerThreads = 0;
+    bool mPresentDisplaysInParallel = false;
+    bool mPredictClientComposition = false;
+
+    // Screen captures queued to RenderEngine, whose layers need the draw fence as a release fence
+    // before they latch another buffer. Only used on the main thread.
+    struct PendingCapture {
+        std::future<sp<Fence>> drawFence;
+        std::vector<sp<Layer>> layers;
+    };
+    std::deque<PendingCapture> mPendingCaptures;
+    std::vector<PendingReadback> mPendingReadbacks;
+    // How screen captures, other than region sampling, were made.
+    std::atomic<uint32_t> mReadbackCaptureCount = 0;
+    std::atomic<uint32_t> mRenderEngineCaptureCount = 0;
+    std::atomic<uint32_t> mFailedReadbackCaptureCount = 0;
+    std::unique_ptr<compositionengine::WorkerPool> mCompositionWorkerPool;
     volatile nsecs_t mDebugInTransaction = 0;
     bool mForceFullDamage = false;
     bool mPropagateBackpressureClientComposition = false;
@@ -1345,7 +1446,10 @@ private:
     Condition mTransactionQueueCV;
     std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>
             mPendingTransactionQueues GUARDED_BY(mQueueLock);
-    std::queue<TransactionState> mTransactionQueue GUARDED_BY(mQueueLock);
+    // Transactions from binder threads, which the main thread moves to mTransactionQueue.
+    LocklessQueue<TransactionState> mIncomingTransactions;
+    // Only accessed on the main thread.
+    std::queue<TransactionState> mTransactionQueue;
     /*
      * Feature prototyping
      */
@@ -1429,6 +1533,9 @@ private:
     const float mEmulatedDisplayDensity;
 
     sp<os::IInputFlinger> mInputFlinger;
+    // The input windows last sent to mInputFlinger by id, so that only the windows that changed
+    // are sent. Should only be accessed by the main thread.
+    std::unordered_map<int32_t, InputWindowInfo> mLastInputWindowInfos;
     // Should only be accessed by the main thread.
     InputWindowCommands mInputWindowCommands;
 
@@ -137,7 +137,10 @@ std::unique_ptr<FrameTracer> DefaultFactory::createFrameTracer() {
 
 std::unique_ptr<frametimeline::FrameTimeline> DefaultFactory::createFrameTimeline(
         std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid) {
-    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid);
+    using frametimeline::JankClassificationThresholds;
+    return std::make_unique<frametimeline::impl::FrameTimeline>(timeStats, surfaceFlingerPid,
+                                                                JankClassificationThresholds(),
+                                                                /*classifyOnWorkerThread*/ true);
 }
 
 } // namespace android::surfaceflinger
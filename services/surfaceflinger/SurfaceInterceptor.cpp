@@ -25,6 +25,7 @@
 #include "SurfaceFlinger.h"
 #include "SurfaceInterceptor.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include <android-base/file.h>
@@ -94,12 +95,47 @@ void SurfaceInterceptor::disable() {
     ALOGE_IF(err == PERMISSION_DENIED, "Could not save the proto file! Permission denied");
     ALOGE_IF(err == NOT_ENOUGH_DATA, "Could not save the proto file! There are missing fields");
     mTrace.Clear();
+    mIncrementSizes.clear();
+    mTraceSize = 0;
+    mDroppedSurfaces.clear();
+    mDroppedDisplays.clear();
 }
 
 bool SurfaceInterceptor::isEnabled() {
     return mEnabled;
 }
 
+void SurfaceInterceptor::setMaxTraceSize(size_t maxTraceSize) {
+    std::scoped_lock<std::mutex> protoGuard(mTraceMutex);
+    mMaxTraceSize = maxTraceSize;
+
+    // The sizes are only counted while the trace is limited, so count those of the increments
+    // recorded until now.
+    mIncrementSizes.clear();
+    mTraceSize = 0;
+    for (int i = 0; i + 1 < mTrace.increment_size(); i++) {
+        const size_t size = mTrace.increment(i).ByteSizeLong();
+        mIncrementSizes.push_back(size);
+        mTraceSize += size;
+    }
+}
+
+void SurfaceInterceptor::writeTraceToFile() {
+    if (!mEnabled) {
+        return;
+    }
+    ATRACE_CALL();
+    std::scoped_lock<std::mutex> protoGuard(mTraceMutex);
+    status_t err(writeProtoFileLocked());
+    ALOGE_IF(err == PERMISSION_DENIED, "Could not save the proto file! Permission denied");
+    ALOGE_IF(err == NOT_ENOUGH_DATA, "Could not save the proto file! There are missing fields");
+}
+
+Trace SurfaceInterceptor::getTraceForTest() {
+    std::scoped_lock<std::mutex> protoGuard(mTraceMutex);
+    return getTraceLocked();
+}
+
 void SurfaceInterceptor::saveExistingDisplaysLocked(
         const DefaultKeyedVector< wp<IBinder>, DisplayDeviceState>& displays)
 {
@@ -170,10 +206,11 @@ status_t SurfaceInterceptor::writeProtoFileLocked() {
     ATRACE_CALL();
     std::string output;
 
-    if (!mTrace.IsInitialized()) {
+    const Trace trace = getTraceLocked();
+    if (!trace.IsInitialized()) {
         return NOT_ENOUGH_DATA;
     }
-    if (!mTrace.SerializeToString(&output)) {
+    if (!trace.SerializeToString(&output)) {
         return PERMISSION_DENIED;
     }
     if (!android::base::WriteStringToFile(output, mOutputFileName, true)) {
@@ -212,7 +249,162 @@ int32_t SurfaceInterceptor::getLayerIdFromHandle(const sp<const IBinder>& handle
     return layer == nullptr ? -1 : getLayerId(layer);
 }
 
+void SurfaceInterceptor::trimTraceLocked() {
+    const int count = mTrace.increment_size();
+    if (count == 0) {
+        return;
+    }
+    // The last increment is complete once the next one is created
+    const size_t size = mTrace.increment(count - 1).ByteSizeLong();
+    mIncrementSizes.push_back(size);
+    mTraceSize += size;
+    if (mTraceSize <= mMaxTraceSize) {
+        return;
+    }
+
+    // Deleting from the front of the trace moves all the remaining increments, so drop a quarter
+    // of the limit at once.
+    int dropped = 0;
+    while (mTraceSize > mMaxTraceSize / 4 * 3 && !mIncrementSizes.empty()) {
+        foldDroppedIncrementLocked(mTrace.increment(dropped++));
+        mTraceSize -= mIncrementSizes.front();
+        mIncrementSizes.pop_front();
+    }
+    mTrace.mutable_increment()->DeleteSubrange(0, dropped);
+}
+
+// Replaces the last change of the same kind, as it no longer has an effect.
+template <typename Change, typename ChangeCase>
+static void foldChange(std::vector<Change>& changes, const Change& change,
+                       ChangeCase (Change::*getCase)() const,
+                       std::initializer_list<ChangeCase> overriddenCases = {}) {
+    const ChangeCase changeCase = (change.*getCase)();
+    changes.erase(std::remove_if(changes.begin(), changes.end(),
+                                 [&](const Change& other) {
+                                     const ChangeCase otherCase = (other.*getCase)();
+                                     return otherCase == changeCase ||
+                                             std::find(overriddenCases.begin(),
+                                                       overriddenCases.end(),
+                                                       otherCase) != overriddenCases.end();
+                                 }),
+                  changes.end());
+    changes.push_back(change);
+}
+
+void SurfaceInterceptor::foldDroppedIncrementLocked(const Increment& increment) {
+    switch (increment.increment_case()) {
+        case Increment::kTransaction:
+            for (const auto& change : increment.transaction().surface_change()) {
+                auto it = mDroppedSurfaces.find(change.id());
+                if (it == mDroppedSurfaces.end()) {
+                    continue;
+                }
+                // A layer change takes the surface out of the relative z-order it was put in, and
+                // a relative parent change sets the z of the surface as well.
+                switch (change.SurfaceChange_case()) {
+                    case SurfaceChange::kLayer:
+                        foldChange(it->second.changes, change, &SurfaceChange::SurfaceChange_case,
+                                   {SurfaceChange::kRelativeParent});
+                        break;
+                    case SurfaceChange::kRelativeParent:
+                        foldChange(it->second.changes, change, &SurfaceChange::SurfaceChange_case,
+                                   {SurfaceChange::kLayer});
+                        break;
+                    default:
+                        foldChange(it->second.changes, change, &SurfaceChange::SurfaceChange_case);
+                        break;
+                }
+            }
+            for (const auto& change : increment.transaction().display_change()) {
+                auto it = mDroppedDisplays.find(change.id());
+                if (it != mDroppedDisplays.end()) {
+                    foldChange(it->second.changes, change, &DisplayChange::DisplayChange_case);
+                }
+            }
+            break;
+        case Increment::kSurfaceCreation:
+            mDroppedSurfaces[increment.surface_creation().id()] = {increment, {}, std::nullopt};
+            break;
+        case Increment::kSurfaceDeletion:
+            mDroppedSurfaces.erase(increment.surface_deletion().id());
+            break;
+        case Increment::kBufferUpdate:
+            if (auto it = mDroppedSurfaces.find(increment.buffer_update().id());
+                it != mDroppedSurfaces.end()) {
+                it->second.bufferUpdate = increment;
+            }
+            break;
+        case Increment::kDisplayCreation:
+            mDroppedDisplays[increment.display_creation().id()] = {increment, {}, std::nullopt};
+            break;
+        case Increment::kDisplayDeletion:
+            mDroppedDisplays.erase(increment.display_deletion().id());
+            break;
+        case Increment::kPowerModeUpdate:
+            if (auto it = mDroppedDisplays.find(increment.power_mode_update().id());
+                it != mDroppedDisplays.end()) {
+                it->second.powerModeUpdate = increment;
+            }
+            break;
+        default:
+            // VSync events only pace the replay.
+            break;
+    }
+}
+
+Trace SurfaceInterceptor::getTraceLocked() const {
+    if (mDroppedSurfaces.empty() && mDroppedDisplays.empty()) {
+        return mTrace;
+    }
+
+    // Recreate the surfaces and displays in the state the dropped increments left them in, at the
+    // time the remaining increments start so that replaying doesn't wait for the dropped ones.
+    Trace trace;
+    const int64_t startTime = mTrace.increment_size() > 0 ? mTrace.increment(0).time_stamp() : 0;
+    const auto addIncrement = [&](const Increment& droppedIncrement) {
+        Increment* increment(trace.add_increment());
+        *increment = droppedIncrement;
+        increment->set_time_stamp(startTime);
+    };
+
+    Increment stateIncrement;
+    Transaction* transaction(stateIncrement.mutable_transaction());
+    transaction->set_synchronous(false);
+    transaction->set_animation(false);
+    for (const auto& [_, display] : mDroppedDisplays) {
+        addIncrement(display.creation);
+        for (const auto& change : display.changes) {
+            *transaction->add_display_change() = change;
+        }
+    }
+    for (const auto& [_, surface] : mDroppedSurfaces) {
+        addIncrement(surface.creation);
+        for (const auto& change : surface.changes) {
+            *transaction->add_surface_change() = change;
+        }
+    }
+    if (transaction->surface_change_size() > 0 || transaction->display_change_size() > 0) {
+        addIncrement(stateIncrement);
+    }
+    for (const auto& [_, display] : mDroppedDisplays) {
+        if (display.powerModeUpdate) {
+            addIncrement(*display.powerModeUpdate);
+        }
+    }
+    for (const auto& [_, surface] : mDroppedSurfaces) {
+        if (surface.bufferUpdate) {
+            addIncrement(*surface.bufferUpdate);
+        }
+    }
+
+    trace.mutable_increment()->MergeFrom(mTrace.increment());
+    return trace;
+}
+
 Increment* SurfaceInterceptor::createTraceIncrementLocked() {
+    if (mMaxTraceSize > 0) {
+        trimTraceLocked();
+    }
     Increment* increment(mTrace.add_increment());
     increment->set_time_stamp(elapsedRealtimeNano());
     return increment;
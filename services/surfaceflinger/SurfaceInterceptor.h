@@ -19,7 +19,11 @@
 
 #include <frameworks/native/cmds/surfacereplayer/proto/src/trace.pb.h>
 
+#include <deque>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <vector>
 
 #include <binder/IBinder.h>
 
@@ -49,6 +53,8 @@ using Increment = surfaceflinger::Increment;
 using DisplayChange = surfaceflinger::DisplayChange;
 
 constexpr auto DEFAULT_FILENAME = "/data/misc/wmtrace/transaction_trace.pb";
+// Size of the trace kept in memory when the interceptor runs as a flight recorder.
+constexpr size_t FLIGHT_RECORDER_TRACE_SIZE = 4 * 1024 * 1024;
 
 class SurfaceInterceptor : public IBinder::DeathRecipient {
 public:
@@ -59,6 +65,11 @@ public:
                         const DefaultKeyedVector<wp<IBinder>, DisplayDeviceState>& displays) = 0;
     virtual void disable() = 0;
     virtual bool isEnabled() = 0;
+    // Limits the size of the trace kept in memory by dropping its oldest increments, so that the
+    // interceptor can stay enabled. 0 keeps the whole trace.
+    virtual void setMaxTraceSize(size_t maxTraceSize) = 0;
+    // Writes the trace recorded so far without disabling the interceptor.
+    virtual void writeTraceToFile() = 0;
 
     virtual void addTransactionTraceListener(
             const sp<gui::ITransactionTraceListener>& listener) = 0;
@@ -100,6 +111,8 @@ public:
                 const DefaultKeyedVector<wp<IBinder>, DisplayDeviceState>& displays) override;
     void disable() override;
     bool isEnabled() override;
+    void setMaxTraceSize(size_t maxTraceSize) override;
+    void writeTraceToFile() override;
 
     void addTransactionTraceListener(const sp<gui::ITransactionTraceListener>& listener) override;
     void binderDied(const wp<IBinder>& who) override;
@@ -122,7 +135,24 @@ public:
     void savePowerModeUpdate(int32_t sequenceId, int32_t mode) override;
     void saveVSyncEvent(nsecs_t timestamp) override;
 
+    // Returns the trace that writeTraceToFile writes.
+    Trace getTraceForTest();
+
 private:
+    // The state of a surface or display left by the increments dropped from mTrace
+    struct DroppedSurfaceState {
+        Increment creation;
+        // The last change of each kind, in the order they were made
+        std::vector<SurfaceChange> changes;
+        std::optional<Increment> bufferUpdate;
+    };
+    struct DroppedDisplayState {
+        Increment creation;
+        // The last change of each kind, in the order they were made
+        std::vector<DisplayChange> changes;
+        std::optional<Increment> powerModeUpdate;
+    };
+
     // The creation increments of Surfaces and Displays do not contain enough information to capture
     // the initial state of each object, so a transaction with all of the missing properties is
     // performed at the initial snapshot for each display and surface.
@@ -133,6 +163,11 @@ private:
     void addInitialDisplayStateLocked(Increment* increment, const DisplayDeviceState& display);
 
     status_t writeProtoFileLocked();
+    Trace getTraceLocked() const;
+    // Drops the oldest increments once the trace is over mMaxTraceSize. The state they leave the
+    // surfaces and displays that are still alive in is kept aside, to start the written trace.
+    void trimTraceLocked();
+    void foldDroppedIncrementLocked(const Increment& increment);
     const sp<const Layer> getLayer(const wp<const IBinder>& weakHandle) const;
     int32_t getLayerId(const sp<const Layer>& layer) const;
     int32_t getLayerIdFromWeakRef(const wp<const Layer>& layer) const;
@@ -199,6 +234,13 @@ private:
     std::string mOutputFileName {DEFAULT_FILENAME};
     std::mutex mTraceMutex {};
     Trace mTrace {};
+    size_t mMaxTraceSize {0};
+    // Sizes of the increments of mTrace but the last one, which may still be filled in
+    std::deque<size_t> mIncrementSizes {};
+    size_t mTraceSize {0};
+    // State dropped from mTrace, by surface or display id
+    std::map<int32_t, DroppedSurfaceState> mDroppedSurfaces {};
+    std::map<int32_t, DroppedDisplayState> mDroppedDisplays {};
     std::mutex mListenersMutex;
     std::map<wp<IBinder>, sp<gui::ITransactionTraceListener>> mTraceToggledListeners
             GUARDED_BY(mListenersMutex);
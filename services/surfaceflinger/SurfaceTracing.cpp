@@ -23,12 +23,17 @@
 
 #include <android-base/file.h>
 #include <android-base/stringprintf.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <log/log.h>
 #include <utils/SystemClock.h>
 #include <utils/Trace.h>
 
 namespace android {
 
+using google::protobuf::internal::WireFormatLite;
+
 SurfaceTracing::SurfaceTracing(SurfaceFlinger& flinger) : mFlinger(flinger) {}
 
 bool SurfaceTracing::enable() {
@@ -94,31 +99,34 @@ void SurfaceTracing::dump(std::string& result) const {
 
 void SurfaceTracing::LayersTraceBuffer::reset(size_t newSize) {
     // use the swap trick to make sure memory is released
-    std::queue<LayersTraceProto>().swap(mStorage);
+    std::queue<std::string>().swap(mStorage);
     mSizeInBytes = newSize;
     mUsedInBytes = 0U;
 }
 
 void SurfaceTracing::LayersTraceBuffer::emplace(LayersTraceProto&& proto) {
-    size_t protoSize = static_cast<size_t>(proto.ByteSize());
-    while (mUsedInBytes + protoSize > mSizeInBytes) {
+    std::string entry;
+    if (!proto.SerializeToString(&entry)) {
+        ALOGE("Could not encode the trace entry");
+        return;
+    }
+    while (mUsedInBytes + entry.size() > mSizeInBytes) {
         if (mStorage.empty()) {
             return;
         }
-        mUsedInBytes -= static_cast<size_t>(mStorage.front().ByteSize());
+        mUsedInBytes -= mStorage.front().size();
         mStorage.pop();
     }
-    mUsedInBytes += protoSize;
-    mStorage.emplace();
-    mStorage.back().Swap(&proto);
+    mUsedInBytes += entry.size();
+    mStorage.push(std::move(entry));
 }
 
-void SurfaceTracing::LayersTraceBuffer::flush(LayersTraceFileProto* fileProto) {
-    fileProto->mutable_entry()->Reserve(static_cast<int>(mStorage.size()));
-
+void SurfaceTracing::LayersTraceBuffer::flush(std::string* output) {
+    google::protobuf::io::StringOutputStream stream(output);
+    google::protobuf::io::CodedOutputStream codedStream(&stream);
     while (!mStorage.empty()) {
-        auto entry = fileProto->add_entry();
-        entry->Swap(&mStorage.front());
+        WireFormatLite::WriteBytes(LayersTraceFileProto::kEntryFieldNumber, mStorage.front(),
+                                   &codedStream);
         mStorage.pop();
     }
 }
@@ -126,11 +134,59 @@ void SurfaceTracing::LayersTraceBuffer::flush(LayersTraceFileProto* fileProto) {
 SurfaceTracing::Runner::Runner(SurfaceFlinger& flinger, SurfaceTracing::Config& config)
       : mFlinger(flinger), mConfig(config) {
     mBuffer.setSize(mConfig.bufferSize);
+    mBufferThread = std::thread(&Runner::bufferLoop, this);
+}
+
+SurfaceTracing::Runner::~Runner() {
+    {
+        std::scoped_lock lock(mQueueLock);
+        mStopBufferThread = true;
+    }
+    mQueueCondition.notify_all();
+    mBufferThread.join();
 }
 
 void SurfaceTracing::Runner::notify(const char* where) {
-    LayersTraceProto entry = traceLayers(where);
-    mBuffer.emplace(std::move(entry));
+    queueEntry(traceLayers(where));
+}
+
+void SurfaceTracing::Runner::queueEntry(LayersTraceProto&& entry) {
+    {
+        std::scoped_lock lock(mQueueLock);
+        mQueue.push_back(std::move(entry));
+    }
+    mQueueCondition.notify_all();
+}
+
+void SurfaceTracing::Runner::bufferLoop() {
+    while (true) {
+        std::vector<LayersTraceProto> entries;
+        {
+            std::unique_lock<std::mutex> lock(mQueueLock);
+            mQueueBusy = false;
+            mQueueCondition.notify_all();
+            mQueueCondition.wait(lock, [this]() REQUIRES(mQueueLock) {
+                return mStopBufferThread || !mQueue.empty();
+            });
+            if (mQueue.empty()) {
+                return;
+            }
+            entries.swap(mQueue);
+            mQueueBusy = true;
+        }
+
+        std::scoped_lock lock(mBufferLock);
+        for (auto& entry : entries) {
+            mBuffer.emplace(std::move(entry));
+        }
+    }
+}
+
+void SurfaceTracing::Runner::waitForQueuedEntries() {
+    std::unique_lock<std::mutex> lock(mQueueLock);
+    mQueueCondition.wait(lock, [this]() REQUIRES(mQueueLock) {
+        return mQueue.empty() && !mQueueBusy;
+    });
 }
 
 status_t SurfaceTracing::Runner::stop() {
@@ -140,17 +196,22 @@ status_t SurfaceTracing::Runner::stop() {
 status_t SurfaceTracing::Runner::writeToFile() {
     ATRACE_CALL();
 
-    LayersTraceFileProto fileProto;
+    // The file is written in the wire format of a LayersTraceFileProto, from the encoded entries
+    // rather than from a message holding all of them.
+    const uint64_t magicNumber = uint64_t(LayersTraceFileProto_MagicNumber_MAGIC_NUMBER_H) << 32 |
+            LayersTraceFileProto_MagicNumber_MAGIC_NUMBER_L;
     std::string output;
-
-    fileProto.set_magic_number(uint64_t(LayersTraceFileProto_MagicNumber_MAGIC_NUMBER_H) << 32 |
-                               LayersTraceFileProto_MagicNumber_MAGIC_NUMBER_L);
-    mBuffer.flush(&fileProto);
-    mBuffer.reset(mConfig.bufferSize);
-
-    if (!fileProto.SerializeToString(&output)) {
-        ALOGE("Could not save the proto file! Permission denied");
-        return PERMISSION_DENIED;
+    {
+        google::protobuf::io::StringOutputStream stream(&output);
+        google::protobuf::io::CodedOutputStream codedStream(&stream);
+        WireFormatLite::WriteFixed64(LayersTraceFileProto::kMagicNumberFieldNumber, magicNumber,
+                                     &codedStream);
+    }
+    waitForQueuedEntries();
+    {
+        std::scoped_lock lock(mBufferLock);
+        mBuffer.flush(&output);
+        mBuffer.reset(mConfig.bufferSize);
     }
 
     // -rw-r--r--
@@ -191,6 +252,7 @@ LayersTraceProto SurfaceTracing::Runner::traceLayers(const char* where) {
 }
 
 void SurfaceTracing::Runner::dump(std::string& result) const {
+    std::scoped_lock lock(mBufferLock);
     base::StringAppendF(&result, "  number of entries: %zu (%.2fMB / %.2fMB)\n",
                         mBuffer.frameCount(), float(mBuffer.used()) / float(1_MB),
                         float(mBuffer.size()) / float(1_MB));
@@ -208,7 +270,7 @@ void SurfaceTracing::AsyncRunner::loop() {
         LayersTraceProto entry;
         bool entryAdded = traceWhenNotified(&entry);
         if (entryAdded) {
-            mBuffer.emplace(std::move(entry));
+            queueEntry(std::move(entry));
         }
         if (mWriteToFile) {
             Runner::writeToFile();
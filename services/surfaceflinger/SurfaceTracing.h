@@ -25,7 +25,9 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace android::surfaceflinger;
 
@@ -101,22 +103,25 @@ private:
         void setSize(size_t newSize) { mSizeInBytes = newSize; }
         void reset(size_t newSize);
         void emplace(LayersTraceProto&& proto);
-        void flush(LayersTraceFileProto* fileProto);
+        /* Appends the entries to output as the entry field of a LayersTraceFileProto. */
+        void flush(std::string* output);
 
     private:
         size_t mUsedInBytes = 0U;
         size_t mSizeInBytes = DEFAULT_BUFFER_SIZE;
-        std::queue<LayersTraceProto> mStorage;
+        // The entries are kept encoded, which takes a fraction of the memory of the messages.
+        std::queue<std::string> mStorage;
     };
 
     /*
      * Implements a synchronous way of adding trace entries. This must be called
-     * from the drawing thread.
+     * from the drawing thread. The entries are sized and added to the ring buffer by a
+     * separate thread, so the drawing thread only pays for capturing the layer states.
      */
     class Runner {
     public:
         Runner(SurfaceFlinger& flinger, SurfaceTracing::Config& config);
-        virtual ~Runner() = default;
+        virtual ~Runner();
         virtual status_t stop();
         virtual status_t writeToFile();
         virtual void notify(const char* where);
@@ -128,9 +133,23 @@ private:
         bool flagIsSet(uint32_t flags) { return (mConfig.flags & flags) == flags; }
         SurfaceFlinger& mFlinger;
         SurfaceTracing::Config mConfig;
-        SurfaceTracing::LayersTraceBuffer mBuffer;
+        mutable std::mutex mBufferLock;
+        SurfaceTracing::LayersTraceBuffer mBuffer GUARDED_BY(mBufferLock);
         uint32_t mMissedTraceEntries = 0;
         LayersTraceProto traceLayers(const char* where);
+        /* Hands the entry over to the buffer thread, which adds it to mBuffer. */
+        void queueEntry(LayersTraceProto&& entry);
+
+    private:
+        void bufferLoop();
+        /* Waits until the buffer thread has added all the queued entries to mBuffer. */
+        void waitForQueuedEntries();
+        std::mutex mQueueLock;
+        std::condition_variable mQueueCondition;
+        std::vector<LayersTraceProto> mQueue GUARDED_BY(mQueueLock);
+        bool mQueueBusy GUARDED_BY(mQueueLock) = false;
+        bool mStopBufferThread GUARDED_BY(mQueueLock) = false;
+        std::thread mBufferThread;
     };
 
     /*
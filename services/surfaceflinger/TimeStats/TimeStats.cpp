@@ -38,22 +38,33 @@ namespace impl {
 
 namespace {
 
-FrameTimingHistogram histogramToProto(const std::unordered_map<int32_t, int32_t>& histogram,
+FrameTimingHistogram histogramToProto(const TimeStatsHelper::Histogram& histogram,
                                       size_t maxPulledHistogramBuckets) {
-    auto buckets = std::vector<std::pair<int32_t, int32_t>>(histogram.begin(), histogram.end());
-    std::sort(buckets.begin(), buckets.end(),
-              [](std::pair<int32_t, int32_t>& left, std::pair<int32_t, int32_t>& right) {
-                  return left.second > right.second;
-              });
+    using Histogram = TimeStatsHelper::Histogram;
+
+    // Only non-empty buckets are pulled, most frequent first, ties by ascending time.
+    static_assert(Histogram::NUM_BUCKETS <= UINT8_MAX);
+    std::array<uint8_t, Histogram::NUM_BUCKETS> buckets;
+    size_t numBuckets = 0;
+    for (size_t i = 0; i < Histogram::NUM_BUCKETS; i++) {
+        if (histogram.counts[i] != 0) {
+            buckets[numBuckets++] = static_cast<uint8_t>(i);
+        }
+    }
+    const size_t numPulledBuckets = std::min(numBuckets, maxPulledHistogramBuckets);
+    std::partial_sort(buckets.begin(), buckets.begin() + numPulledBuckets,
+                      buckets.begin() + numBuckets, [&](uint8_t left, uint8_t right) {
+                          return histogram.counts[left] != histogram.counts[right]
+                                  ? histogram.counts[left] > histogram.counts[right]
+                                  : left < right;
+                      });
 
     FrameTimingHistogram histogramProto;
-    int histogramSize = 0;
-    for (const auto& bucket : buckets) {
-        if (++histogramSize > maxPulledHistogramBuckets) {
-            break;
-        }
-        histogramProto.add_time_millis_buckets((int32_t)bucket.first);
-        histogramProto.add_frame_counts((int64_t)bucket.second);
+    histogramProto.mutable_time_millis_buckets()->Reserve(numPulledBuckets);
+    histogramProto.mutable_frame_counts()->Reserve(numPulledBuckets);
+    for (size_t i = 0; i < numPulledBuckets; i++) {
+        histogramProto.add_time_millis_buckets(Histogram::BUCKETS_MILLIS[buckets[i]]);
+        histogramProto.add_frame_counts(static_cast<int64_t>(histogram.counts[buckets[i]]));
     }
     return histogramProto;
 }
@@ -89,144 +100,175 @@ SurfaceflingerStatsLayerInfo_SetFrameRateVote frameRateVoteToProto(
 } // namespace
 
 bool TimeStats::populateGlobalAtom(std::string* pulledData) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    ATRACE_CALL();
 
-    if (mTimeStats.statsStartLegacy == 0) {
-        return false;
+    // Histograms are fixed-size, so copying the global stats out is cheap. The atoms are then
+    // built and serialized without holding mMutex, so frame recording isn't blocked by the pull.
+    TimeStatsHelper::TimeStatsGlobal globalStats;
+    std::vector<TimeStatsHelper::TimelineStats> globalSlices;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mTimeStats.statsStartLegacy == 0) {
+            return false;
+        }
+        flushPowerTimeLocked();
+        globalStats.totalFramesLegacy = mTimeStats.totalFramesLegacy;
+        globalStats.missedFramesLegacy = mTimeStats.missedFramesLegacy;
+        globalStats.clientCompositionFramesLegacy = mTimeStats.clientCompositionFramesLegacy;
+        globalStats.displayOnTimeLegacy = mTimeStats.displayOnTimeLegacy;
+        globalStats.displayEventConnectionsCountLegacy =
+                mTimeStats.displayEventConnectionsCountLegacy;
+        globalStats.presentToPresentLegacy = mTimeStats.presentToPresentLegacy;
+        globalStats.frameDurationLegacy = mTimeStats.frameDurationLegacy;
+        globalStats.renderEngineTimingLegacy = mTimeStats.renderEngineTimingLegacy;
+
+        globalSlices.reserve(mTimeStats.stats.size());
+        for (const auto& globalSlice : mTimeStats.stats) {
+            TimeStatsHelper::TimelineStats& slice = globalSlices.emplace_back();
+            slice.key = globalSlice.first;
+            slice.jankPayload = globalSlice.second.jankPayload;
+            slice.displayDeadlineDeltas = globalSlice.second.displayDeadlineDeltas;
+            slice.displayPresentDeltas = globalSlice.second.displayPresentDeltas;
+        }
+
+        // Always clear data.
+        clearGlobalLocked();
     }
-    flushPowerTimeLocked();
+
+    const FrameTimingHistogram frameDuration =
+            histogramToProto(globalStats.frameDurationLegacy, mMaxPulledHistogramBuckets);
+    const FrameTimingHistogram renderEngineTiming =
+            histogramToProto(globalStats.renderEngineTimingLegacy, mMaxPulledHistogramBuckets);
+
     SurfaceflingerStatsGlobalInfoWrapper atomList;
-    for (const auto& globalSlice : mTimeStats.stats) {
+    for (const auto& globalSlice : globalSlices) {
         SurfaceflingerStatsGlobalInfo* atom = atomList.add_atom();
-        atom->set_total_frames(mTimeStats.totalFramesLegacy);
-        atom->set_missed_frames(mTimeStats.missedFramesLegacy);
-        atom->set_client_composition_frames(mTimeStats.clientCompositionFramesLegacy);
-        atom->set_display_on_millis(mTimeStats.displayOnTimeLegacy);
-        atom->set_animation_millis(mTimeStats.presentToPresentLegacy.totalTime());
-        atom->set_event_connection_count(mTimeStats.displayEventConnectionsCountLegacy);
-        *atom->mutable_frame_duration() =
-                histogramToProto(mTimeStats.frameDurationLegacy.hist, mMaxPulledHistogramBuckets);
-        *atom->mutable_render_engine_timing() =
-                histogramToProto(mTimeStats.renderEngineTimingLegacy.hist,
-                                 mMaxPulledHistogramBuckets);
-        atom->set_total_timeline_frames(globalSlice.second.jankPayload.totalFrames);
-        atom->set_total_janky_frames(globalSlice.second.jankPayload.totalJankyFrames);
-        atom->set_total_janky_frames_with_long_cpu(globalSlice.second.jankPayload.totalSFLongCpu);
-        atom->set_total_janky_frames_with_long_gpu(globalSlice.second.jankPayload.totalSFLongGpu);
-        atom->set_total_janky_frames_sf_unattributed(
-                globalSlice.second.jankPayload.totalSFUnattributed);
+        atom->set_total_frames(globalStats.totalFramesLegacy);
+        atom->set_missed_frames(globalStats.missedFramesLegacy);
+        atom->set_client_composition_frames(globalStats.clientCompositionFramesLegacy);
+        atom->set_display_on_millis(globalStats.displayOnTimeLegacy);
+        atom->set_animation_millis(globalStats.presentToPresentLegacy.totalTime());
+        atom->set_event_connection_count(globalStats.displayEventConnectionsCountLegacy);
+        *atom->mutable_frame_duration() = frameDuration;
+        *atom->mutable_render_engine_timing() = renderEngineTiming;
+        atom->set_total_timeline_frames(globalSlice.jankPayload.totalFrames);
+        atom->set_total_janky_frames(globalSlice.jankPayload.totalJankyFrames);
+        atom->set_total_janky_frames_with_long_cpu(globalSlice.jankPayload.totalSFLongCpu);
+        atom->set_total_janky_frames_with_long_gpu(globalSlice.jankPayload.totalSFLongGpu);
+        atom->set_total_janky_frames_sf_unattributed(globalSlice.jankPayload.totalSFUnattributed);
         atom->set_total_janky_frames_app_unattributed(
-                globalSlice.second.jankPayload.totalAppUnattributed);
-        atom->set_total_janky_frames_sf_scheduling(
-                globalSlice.second.jankPayload.totalSFScheduling);
+                globalSlice.jankPayload.totalAppUnattributed);
+        atom->set_total_janky_frames_sf_scheduling(globalSlice.jankPayload.totalSFScheduling);
         atom->set_total_jank_frames_sf_prediction_error(
-                globalSlice.second.jankPayload.totalSFPredictionError);
+                globalSlice.jankPayload.totalSFPredictionError);
         atom->set_total_jank_frames_app_buffer_stuffing(
-                globalSlice.second.jankPayload.totalAppBufferStuffing);
-        atom->set_display_refresh_rate_bucket(globalSlice.first.displayRefreshRateBucket);
+                globalSlice.jankPayload.totalAppBufferStuffing);
+        atom->set_display_refresh_rate_bucket(globalSlice.key.displayRefreshRateBucket);
         *atom->mutable_sf_deadline_misses() =
-                histogramToProto(globalSlice.second.displayDeadlineDeltas.hist,
-                                 mMaxPulledHistogramBuckets);
+                histogramToProto(globalSlice.displayDeadlineDeltas, mMaxPulledHistogramBuckets);
         *atom->mutable_sf_prediction_errors() =
-                histogramToProto(globalSlice.second.displayPresentDeltas.hist,
-                                 mMaxPulledHistogramBuckets);
-        atom->set_render_rate_bucket(globalSlice.first.renderRateBucket);
+                histogramToProto(globalSlice.displayPresentDeltas, mMaxPulledHistogramBuckets);
+        atom->set_render_rate_bucket(globalSlice.key.renderRateBucket);
     }
 
-    // Always clear data.
-    clearGlobalLocked();
-
     return atomList.SerializeToString(pulledData);
 }
 
 bool TimeStats::populateLayerAtom(std::string* pulledData) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    ATRACE_CALL();
 
-    std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
-    uint32_t numLayers = 0;
-    for (const auto& globalSlice : mTimeStats.stats) {
-        numLayers += globalSlice.second.stats.size();
-    }
+    // The layer stats are cleared by the pull anyway, so move them out and build the atoms
+    // without holding any TimeStats lock.
+    std::vector<TimeStatsHelper::TimeStatsLayer> dumpStats;
+    {
+        const auto layerLocks = lockLayerShards();
+        std::lock_guard<std::mutex> lock(mMutex);
 
-    dumpStats.reserve(numLayers);
+        size_t numLayers = 0;
+        for (const auto& globalSlice : mTimeStats.stats) {
+            numLayers += globalSlice.second.stats.size();
+        }
+
+        dumpStats.reserve(numLayers);
 
-    for (auto& globalSlice : mTimeStats.stats) {
-        for (auto& layerSlice : globalSlice.second.stats) {
-            dumpStats.push_back(&layerSlice.second);
+        for (auto& globalSlice : mTimeStats.stats) {
+            for (auto& layerSlice : globalSlice.second.stats) {
+                dumpStats.push_back(std::move(layerSlice.second));
+            }
         }
-    }
 
-    std::sort(dumpStats.begin(), dumpStats.end(),
-              [](TimeStatsHelper::TimeStatsLayer const* l,
-                 TimeStatsHelper::TimeStatsLayer const* r) {
-                  return l->totalFrames > r->totalFrames;
-              });
+        // Always clear data.
+        clearLayersLocked();
+    }
 
+    const auto byTotalFrames = [](const TimeStatsHelper::TimeStatsLayer& l,
+                                  const TimeStatsHelper::TimeStatsLayer& r) {
+        return l.totalFrames > r.totalFrames;
+    };
     if (mMaxPulledLayers < dumpStats.size()) {
+        std::partial_sort(dumpStats.begin(), dumpStats.begin() + mMaxPulledLayers,
+                          dumpStats.end(), byTotalFrames);
         dumpStats.resize(mMaxPulledLayers);
+    } else {
+        std::sort(dumpStats.begin(), dumpStats.end(), byTotalFrames);
     }
 
+    const auto deltaToProto = [this](const TimeStatsHelper::TimeStatsLayer& layer,
+                                     const char* name) -> std::optional<FrameTimingHistogram> {
+        const auto iter = layer.deltas.find(name);
+        if (iter == layer.deltas.cend()) {
+            return std::nullopt;
+        }
+        return histogramToProto(iter->second, mMaxPulledHistogramBuckets);
+    };
+
     SurfaceflingerStatsLayerInfoWrapper atomList;
-    for (auto& layer : dumpStats) {
+    for (const auto& layer : dumpStats) {
         SurfaceflingerStatsLayerInfo* atom = atomList.add_atom();
-        atom->set_layer_name(layer->layerName);
-        atom->set_total_frames(layer->totalFrames);
-        atom->set_dropped_frames(layer->droppedFrames);
-        const auto& present2PresentHist = layer->deltas.find("present2present");
-        if (present2PresentHist != layer->deltas.cend()) {
-            *atom->mutable_present_to_present() =
-                    histogramToProto(present2PresentHist->second.hist, mMaxPulledHistogramBuckets);
+        atom->set_layer_name(layer.layerName);
+        atom->set_total_frames(layer.totalFrames);
+        atom->set_dropped_frames(layer.droppedFrames);
+        if (auto histogram = deltaToProto(layer, "present2present")) {
+            *atom->mutable_present_to_present() = std::move(*histogram);
         }
-        const auto& post2presentHist = layer->deltas.find("post2present");
-        if (post2presentHist != layer->deltas.cend()) {
-            *atom->mutable_post_to_present() =
-                    histogramToProto(post2presentHist->second.hist, mMaxPulledHistogramBuckets);
+        if (auto histogram = deltaToProto(layer, "post2present")) {
+            *atom->mutable_post_to_present() = std::move(*histogram);
         }
-        const auto& acquire2presentHist = layer->deltas.find("acquire2present");
-        if (acquire2presentHist != layer->deltas.cend()) {
-            *atom->mutable_acquire_to_present() =
-                    histogramToProto(acquire2presentHist->second.hist, mMaxPulledHistogramBuckets);
+        if (auto histogram = deltaToProto(layer, "acquire2present")) {
+            *atom->mutable_acquire_to_present() = std::move(*histogram);
         }
-        const auto& latch2presentHist = layer->deltas.find("latch2present");
-        if (latch2presentHist != layer->deltas.cend()) {
-            *atom->mutable_latch_to_present() =
-                    histogramToProto(latch2presentHist->second.hist, mMaxPulledHistogramBuckets);
+        if (auto histogram = deltaToProto(layer, "latch2present")) {
+            *atom->mutable_latch_to_present() = std::move(*histogram);
         }
-        const auto& desired2presentHist = layer->deltas.find("desired2present");
-        if (desired2presentHist != layer->deltas.cend()) {
-            *atom->mutable_desired_to_present() =
-                    histogramToProto(desired2presentHist->second.hist, mMaxPulledHistogramBuckets);
+        if (auto histogram = deltaToProto(layer, "desired2present")) {
+            *atom->mutable_desired_to_present() = std::move(*histogram);
         }
-        const auto& post2acquireHist = layer->deltas.find("post2acquire");
-        if (post2acquireHist != layer->deltas.cend()) {
-            *atom->mutable_post_to_acquire() =
-                    histogramToProto(post2acquireHist->second.hist, mMaxPulledHistogramBuckets);
+        if (auto histogram = deltaToProto(layer, "post2acquire")) {
+            *atom->mutable_post_to_acquire() = std::move(*histogram);
         }
 
-        atom->set_late_acquire_frames(layer->lateAcquireFrames);
-        atom->set_bad_desired_present_frames(layer->badDesiredPresentFrames);
-        atom->set_uid(layer->uid);
-        atom->set_total_timeline_frames(layer->jankPayload.totalFrames);
-        atom->set_total_janky_frames(layer->jankPayload.totalJankyFrames);
-        atom->set_total_janky_frames_with_long_cpu(layer->jankPayload.totalSFLongCpu);
-        atom->set_total_janky_frames_with_long_gpu(layer->jankPayload.totalSFLongGpu);
-        atom->set_total_janky_frames_sf_unattributed(layer->jankPayload.totalSFUnattributed);
-        atom->set_total_janky_frames_app_unattributed(layer->jankPayload.totalAppUnattributed);
-        atom->set_total_janky_frames_sf_scheduling(layer->jankPayload.totalSFScheduling);
-        atom->set_total_jank_frames_sf_prediction_error(layer->jankPayload.totalSFPredictionError);
-        atom->set_total_jank_frames_app_buffer_stuffing(layer->jankPayload.totalAppBufferStuffing);
-        atom->set_display_refresh_rate_bucket(layer->displayRefreshRateBucket);
-        atom->set_render_rate_bucket(layer->renderRateBucket);
-        *atom->mutable_set_frame_rate_vote() = frameRateVoteToProto(layer->setFrameRateVote);
+        atom->set_late_acquire_frames(layer.lateAcquireFrames);
+        atom->set_bad_desired_present_frames(layer.badDesiredPresentFrames);
+        atom->set_uid(layer.uid);
+        atom->set_total_timeline_frames(layer.jankPayload.totalFrames);
+        atom->set_total_janky_frames(layer.jankPayload.totalJankyFrames);
+        atom->set_total_janky_frames_with_long_cpu(layer.jankPayload.totalSFLongCpu);
+        atom->set_total_janky_frames_with_long_gpu(layer.jankPayload.totalSFLongGpu);
+        atom->set_total_janky_frames_sf_unattributed(layer.jankPayload.totalSFUnattributed);
+        atom->set_total_janky_frames_app_unattributed(layer.jankPayload.totalAppUnattributed);
+        atom->set_total_janky_frames_sf_scheduling(layer.jankPayload.totalSFScheduling);
+        atom->set_total_jank_frames_sf_prediction_error(layer.jankPayload.totalSFPredictionError);
+        atom->set_total_jank_frames_app_buffer_stuffing(layer.jankPayload.totalAppBufferStuffing);
+        atom->set_display_refresh_rate_bucket(layer.displayRefreshRateBucket);
+        atom->set_render_rate_bucket(layer.renderRateBucket);
+        *atom->mutable_set_frame_rate_vote() = frameRateVoteToProto(layer.setFrameRateVote);
+        // app_deadline_misses is always set, even when the layer has no deadline deltas.
         *atom->mutable_app_deadline_misses() =
-                histogramToProto(layer->deltas["appDeadlineDeltas"].hist,
-                                 mMaxPulledHistogramBuckets);
-        atom->set_game_mode(gameModeToProto(layer->gameMode));
+                deltaToProto(layer, "appDeadlineDeltas").value_or(FrameTimingHistogram());
+        atom->set_game_mode(gameModeToProto(layer.gameMode));
     }
 
-    // Always clear data.
-    clearLayersLocked();
-
     return atomList.SerializeToString(pulledData);
 }
 
@@ -295,9 +337,9 @@ std::string TimeStats::miniDump() {
     ATRACE_CALL();
 
     std::string result = "TimeStats miniDump:\n";
-    std::lock_guard<std::mutex> lock(mMutex);
     android::base::StringAppendF(&result, "Number of layers currently being tracked is %zu\n",
-                                 mTimeStatsTracker.size());
+                                 mNumLayerRecords.load());
+    std::lock_guard<std::mutex> lock(mMutex);
     android::base::StringAppendF(&result, "Number of layers in the stats pool is %zu\n",
                                  mTimeStats.stats.size());
     return result;
@@ -451,14 +493,16 @@ static int32_t clampToNearestBucket(Fps fps, size_t bucketWidth) {
     return std::round(fps.getValue() / bucketWidth) * bucketWidth;
 }
 
-void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
-                                                   std::optional<Fps> renderRate,
-                                                   SetFrameRateVote frameRateVote,
-                                                   int32_t gameMode) {
+void TimeStats::flushAvailableRecordsToStats(int32_t layerId, LayerRecord& layerRecord,
+                                             Fps displayRefreshRate, std::optional<Fps> renderRate,
+                                             SetFrameRateVote frameRateVote, int32_t gameMode) {
     ATRACE_CALL();
-    ALOGV("[%d]-flushAvailableRecordsToStatsLocked", layerId);
+    ALOGV("[%d]-flushAvailableRecordsToStats", layerId);
+
+    // Only aggregating into mTimeStats is serialized across layers, and only once a record is
+    // ready to be aggregated.
+    std::unique_lock<std::mutex> lock(mMutex, std::defer_lock);
 
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
     TimeRecord& prevTimeRecord = layerRecord.prevTimeRecord;
     std::deque<TimeRecord>& timeRecords = layerRecord.timeRecords;
     const int32_t refreshRateBucket =
@@ -472,6 +516,9 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
               timeRecords[0].frameTime.frameNumber, timeRecords[0].frameTime.presentTime);
 
         if (prevTimeRecord.ready) {
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
             uid_t uid = layerRecord.uid;
             const std::string& layerName = layerRecord.layerName;
             TimeStatsHelper::TimelineStatsKey timelineKey = {refreshRateBucket, renderRateBucket};
@@ -489,6 +536,7 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
                 displayStats.stats[layerKey].layerName = layerName;
                 displayStats.stats[layerKey].gameMode = gameMode;
             }
+            layerRecord.aggregatedGameMode = gameMode;
             if (frameRateVote.frameRate > 0.0f) {
                 displayStats.stats[layerKey].setFrameRateVote = frameRateVote;
             }
@@ -575,22 +623,35 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     ALOGV("[%d]-[%" PRIu64 "]-[%s]-PostTime[%" PRId64 "]", layerId, frameNumber, layerName.c_str(),
           postTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
-        return;
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.records.find(layerId);
+
+    // A layer whose stats are already aggregated under this game mode can always add more, so
+    // only take mMutex to check the aggregated stats for other layers.
+    if (it == shard.records.end() || it->second.aggregatedGameMode != gameMode) {
+        std::lock_guard<std::mutex> statsLock(mMutex);
+        if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
+            return;
+        }
     }
-    if (!mTimeStatsTracker.count(layerId) && mTimeStatsTracker.size() < MAX_NUM_LAYER_RECORDS &&
-        layerNameIsValid(layerName)) {
-        mTimeStatsTracker[layerId].uid = uid;
-        mTimeStatsTracker[layerId].layerName = layerName;
-        mTimeStatsTracker[layerId].gameMode = gameMode;
+    if (it == shard.records.end() && layerNameIsValid(layerName)) {
+        if (mNumLayerRecords.fetch_add(1) < MAX_NUM_LAYER_RECORDS) {
+            it = shard.records.emplace(layerId, LayerRecord{}).first;
+            it->second.uid = uid;
+            it->second.layerName = layerName;
+            it->second.gameMode = gameMode;
+        } else {
+            mNumLayerRecords--;
+        }
     }
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.timeRecords.size() == MAX_NUM_TIME_RECORDS) {
         ALOGE("[%d]-[%s]-timeRecords is at its maximum size[%zu]. Ignore this when unittesting.",
               layerId, layerRecord.layerName.c_str(), MAX_NUM_TIME_RECORDS);
-        mTimeStatsTracker.erase(layerId);
+        shard.records.erase(it);
+        mNumLayerRecords--;
         return;
     }
     // For most media content, the acquireFence is invalid because the buffer is
@@ -618,9 +679,11 @@ void TimeStats::setLatchTime(int32_t layerId, uint64_t frameNumber, nsecs_t latc
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-LatchTime[%" PRId64 "]", layerId, frameNumber, latchTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -637,9 +700,11 @@ void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
     ALOGV("[%d]-LatchSkipped-Reason[%d]", layerId,
           static_cast<std::underlying_type<LatchSkipReason>::type>(reason));
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
 
     switch (reason) {
         case LatchSkipReason::LateAcquire:
@@ -654,9 +719,11 @@ void TimeStats::incrementBadDesiredPresent(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-BadDesiredPresent", layerId);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     layerRecord.badDesiredPresentFrames++;
 }
 
@@ -666,9 +733,11 @@ void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t de
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-DesiredTime[%" PRId64 "]", layerId, frameNumber, desiredTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -684,9 +753,11 @@ void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t ac
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-AcquireTime[%" PRId64 "]", layerId, frameNumber, acquireTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -704,9 +775,11 @@ void TimeStats::setAcquireFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-AcquireFenceTime[%" PRId64 "]", layerId, frameNumber,
           acquireFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -724,9 +797,11 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-PresentTime[%" PRId64 "]", layerId, frameNumber, presentTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -737,8 +812,8 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    flushAvailableRecordsToStats(layerId, layerRecord, displayRefreshRate, renderRate,
+                                 frameRateVote, gameMode);
 }
 
 void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
@@ -751,9 +826,11 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-PresentFenceTime[%" PRId64 "]", layerId, frameNumber,
           presentFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
@@ -764,8 +841,8 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    flushAvailableRecordsToStats(layerId, layerRecord, displayRefreshRate, renderRate,
+                                 frameRateVote, gameMode);
 }
 
 static const constexpr int32_t kValidJankyReason = JankType::DisplayHAL |
@@ -866,8 +943,9 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
 void TimeStats::onDestroy(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-onDestroy", layerId);
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStatsTracker.erase(layerId);
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    mNumLayerRecords -= shard.records.erase(layerId);
 }
 
 void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
@@ -876,9 +954,11 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-removeTimeRecord", layerId, frameNumber);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    LayerShard& shard = layerShard(layerId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.records.find(layerId);
+    if (it == shard.records.end()) return;
+    LayerRecord& layerRecord = it->second;
     size_t removeAt = 0;
     for (const TimeRecord& record : layerRecord.timeRecords) {
         if (record.frameTime.frameNumber == frameNumber) break;
@@ -1047,6 +1127,7 @@ void TimeStats::disable() {
 }
 
 void TimeStats::clearAll() {
+    const auto layerLocks = lockLayerShards();
     std::lock_guard<std::mutex> lock(mMutex);
     mTimeStats.stats.clear();
     clearGlobalLocked();
@@ -1066,9 +1147,9 @@ void TimeStats::clearGlobalLocked() {
     mTimeStats.compositionStrategyChangesLegacy = 0;
     mTimeStats.displayEventConnectionsCountLegacy = 0;
     mTimeStats.displayOnTimeLegacy = 0;
-    mTimeStats.presentToPresentLegacy.hist.clear();
-    mTimeStats.frameDurationLegacy.hist.clear();
-    mTimeStats.renderEngineTimingLegacy.hist.clear();
+    mTimeStats.presentToPresentLegacy.clear();
+    mTimeStats.frameDurationLegacy.clear();
+    mTimeStats.renderEngineTimingLegacy.clear();
     mTimeStats.refreshRateStatsLegacy.clear();
     mPowerTime.prevTime = systemTime();
     for (auto& globalRecord : mTimeStats.stats) {
@@ -1079,10 +1160,21 @@ void TimeStats::clearGlobalLocked() {
     ALOGD("Cleared global stats");
 }
 
+std::array<std::unique_lock<std::mutex>, TimeStats::NUM_LAYER_SHARDS> TimeStats::lockLayerShards() {
+    std::array<std::unique_lock<std::mutex>, NUM_LAYER_SHARDS> locks;
+    for (size_t i = 0; i < NUM_LAYER_SHARDS; i++) {
+        locks[i] = std::unique_lock<std::mutex>(mLayerShards[i].mutex);
+    }
+    return locks;
+}
+
 void TimeStats::clearLayersLocked() {
     ATRACE_CALL();
 
-    mTimeStatsTracker.clear();
+    for (LayerShard& shard : mLayerShards) {
+        shard.records.clear();
+    }
+    mNumLayerRecords = 0;
 
     for (auto& globalRecord : mTimeStats.stats) {
         globalRecord.second.stats.clear();
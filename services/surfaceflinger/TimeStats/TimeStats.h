@@ -27,6 +27,8 @@
 #include <utils/String16.h>
 #include <utils/Vector.h>
 
+#include <array>
+#include <atomic>
 #include <deque>
 #include <mutex>
 #include <optional>
@@ -193,6 +195,9 @@ class TimeStats : public android::TimeStats {
         uid_t uid;
         std::string layerName;
         int32_t gameMode = 0;
+        // Game mode under which the stats of this layer were last aggregated into mTimeStats, so
+        // that setPostTime does not need to check mTimeStats for room again.
+        std::optional<int32_t> aggregatedGameMode;
         // This is the index in timeRecords, at which the timestamps for that
         // specific frame are still not fully received. This is not waiting for
         // fences to signal, but rather waiting to receive those fences/timestamps.
@@ -276,12 +281,15 @@ public:
     static const size_t MAX_NUM_TIME_RECORDS = 64;
 
 private:
+    static const size_t NUM_LAYER_SHARDS = 8;
+
     bool populateGlobalAtom(std::string* pulledData);
     bool populateLayerAtom(std::string* pulledData);
     bool recordReadyLocked(int32_t layerId, TimeRecord* timeRecord);
-    void flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
-                                            std::optional<Fps> renderRate,
-                                            SetFrameRateVote frameRateVote, int32_t gameMode);
+    // Called with the shard of the layer locked. Takes mMutex to aggregate the ready records.
+    void flushAvailableRecordsToStats(int32_t layerId, LayerRecord& layerRecord,
+                                      Fps displayRefreshRate, std::optional<Fps> renderRate,
+                                      SetFrameRateVote frameRateVote, int32_t gameMode);
     void flushPowerTimeLocked();
     void flushAvailableGlobalRecordsToStatsLocked();
     bool canAddNewAggregatedStats(uid_t uid, const std::string& layerName, int32_t gameMode);
@@ -289,15 +297,32 @@ private:
     void enable();
     void disable();
     void clearAll();
+    // Locks every layer shard, in order. Must be called before locking mMutex.
+    std::array<std::unique_lock<std::mutex>, NUM_LAYER_SHARDS> lockLayerShards();
     void clearGlobalLocked();
     void clearLayersLocked();
     void dump(bool asProto, std::optional<uint32_t> maxLayers, std::string& result);
 
+    // Per-layer records are split across shards by layer id, each with its own lock, so that
+    // updates to different layers from the main thread and binder threads do not serialize.
+    // A shard lock is always taken before mMutex.
+    struct LayerShard {
+        std::mutex mutex;
+        // Hashmap for LayerRecord with layerId as the hash key
+        std::unordered_map<int32_t, LayerRecord> records;
+    };
+
+    LayerShard& layerShard(int32_t layerId) {
+        return mLayerShards[static_cast<uint32_t>(layerId) % NUM_LAYER_SHARDS];
+    }
+
     std::atomic<bool> mEnabled = false;
+    // Guards the aggregated stats and the global records.
     std::mutex mMutex;
     TimeStatsHelper::TimeStatsGlobal mTimeStats;
-    // Hashmap for LayerRecord with layerId as the hash key
-    std::unordered_map<int32_t, LayerRecord> mTimeStatsTracker;
+    std::array<LayerShard, NUM_LAYER_SHARDS> mLayerShards;
+    // Number of LayerRecords across all shards.
+    std::atomic<size_t> mNumLayerRecords = 0;
     PowerTime mPowerTime;
     GlobalRecord mGlobalRecord;
 
@@ -20,38 +20,36 @@
 
 #include <array>
 
-#define HISTOGRAM_SIZE 85
-
 using android::base::StringAppendF;
 using android::base::StringPrintf;
 
 namespace android {
 namespace surfaceflinger {
 
-// Time buckets for histogram, the calculated time deltas will be lower bounded
-// to the buckets in this array.
-static const std::array<int32_t, HISTOGRAM_SIZE> histogramConfig =
-        {0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,  15,  16,
-         17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,
-         34,  36,  38,  40,  42,  44,  46,  48,  50,  54,  58,  62,  66,  70,  74,  78,  82,
-         86,  90,  94,  98,  102, 106, 110, 114, 118, 122, 126, 130, 134, 138, 142, 146, 150,
-         200, 250, 300, 350, 400, 450, 500, 550, 600, 650, 700, 750, 800, 850, 900, 950, 1000};
+const std::array<int32_t, TimeStatsHelper::Histogram::NUM_BUCKETS>
+        TimeStatsHelper::Histogram::BUCKETS_MILLIS =
+                {0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
+                 15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
+                 30,  31,  32,  33,  34,  36,  38,  40,  42,  44,  46,  48,  50,  54,  58,
+                 62,  66,  70,  74,  78,  82,  86,  90,  94,  98,  102, 106, 110, 114, 118,
+                 122, 126, 130, 134, 138, 142, 146, 150, 200, 250, 300, 350, 400, 450, 500,
+                 550, 600, 650, 700, 750, 800, 850, 900, 950, 1000};
 
 void TimeStatsHelper::Histogram::insert(int32_t delta) {
     if (delta < 0) return;
     // std::lower_bound won't work on out of range values
-    if (delta > histogramConfig[HISTOGRAM_SIZE - 1]) {
-        hist[histogramConfig[HISTOGRAM_SIZE - 1]]++;
+    if (delta > BUCKETS_MILLIS[NUM_BUCKETS - 1]) {
+        counts[NUM_BUCKETS - 1]++;
         return;
     }
-    auto iter = std::lower_bound(histogramConfig.begin(), histogramConfig.end(), delta);
-    hist[*iter]++;
+    auto iter = std::lower_bound(BUCKETS_MILLIS.begin(), BUCKETS_MILLIS.end(), delta);
+    counts[iter - BUCKETS_MILLIS.begin()]++;
 }
 
 int64_t TimeStatsHelper::Histogram::totalTime() const {
     int64_t ret = 0;
-    for (const auto& ele : hist) {
-        ret += ele.first * ele.second;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        ret += static_cast<int64_t>(BUCKETS_MILLIS[i]) * counts[i];
     }
     return ret;
 }
@@ -59,19 +57,17 @@ int64_t TimeStatsHelper::Histogram::totalTime() const {
 float TimeStatsHelper::Histogram::averageTime() const {
     int64_t ret = 0;
     int64_t count = 0;
-    for (const auto& ele : hist) {
-        count += ele.second;
-        ret += ele.first * ele.second;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        count += counts[i];
+        ret += static_cast<int64_t>(BUCKETS_MILLIS[i]) * counts[i];
     }
     return static_cast<float>(ret) / count;
 }
 
 std::string TimeStatsHelper::Histogram::toString() const {
     std::string result;
-    for (int32_t i = 0; i < HISTOGRAM_SIZE; ++i) {
-        int32_t bucket = histogramConfig[i];
-        int32_t count = (hist.count(bucket) == 0) ? 0 : hist.at(bucket);
-        StringAppendF(&result, "%dms=%d ", bucket, count);
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        StringAppendF(&result, "%dms=%d ", BUCKETS_MILLIS[i], counts[i]);
     }
     result.back() = '\n';
     return result;
@@ -228,10 +224,12 @@ SFTimeStatsLayerProto TimeStatsHelper::TimeStatsLayer::toProto() const {
     for (const auto& ele : deltas) {
         SFTimeStatsDeltaProto* deltaProto = layerProto.add_deltas();
         deltaProto->set_delta_name(ele.first);
-        for (const auto& histEle : ele.second.hist) {
+        const Histogram& histogram = ele.second;
+        for (size_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+            if (histogram.counts[i] == 0) continue;
             SFTimeStatsHistogramBucketProto* histProto = deltaProto->add_histograms();
-            histProto->set_time_millis(histEle.first);
-            histProto->set_frame_count(histEle.second);
+            histProto->set_time_millis(Histogram::BUCKETS_MILLIS[i]);
+            histProto->set_frame_count(histogram.counts[i]);
         }
     }
     return layerProto;
@@ -253,20 +251,23 @@ SFTimeStatsGlobalProto TimeStatsHelper::TimeStatsGlobal::toProto(
         configProto->set_fps(ele.first);
         configBucketProto->set_duration_millis(ns2ms(ele.second));
     }
-    for (const auto& histEle : presentToPresentLegacy.hist) {
+    for (size_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+        if (presentToPresentLegacy.counts[i] == 0) continue;
         SFTimeStatsHistogramBucketProto* histProto = globalProto.add_present_to_present();
-        histProto->set_time_millis(histEle.first);
-        histProto->set_frame_count(histEle.second);
+        histProto->set_time_millis(Histogram::BUCKETS_MILLIS[i]);
+        histProto->set_frame_count(presentToPresentLegacy.counts[i]);
     }
-    for (const auto& histEle : frameDurationLegacy.hist) {
+    for (size_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+        if (frameDurationLegacy.counts[i] == 0) continue;
         SFTimeStatsHistogramBucketProto* histProto = globalProto.add_frame_duration();
-        histProto->set_time_millis(histEle.first);
-        histProto->set_frame_count(histEle.second);
+        histProto->set_time_millis(Histogram::BUCKETS_MILLIS[i]);
+        histProto->set_frame_count(frameDurationLegacy.counts[i]);
     }
-    for (const auto& histEle : renderEngineTimingLegacy.hist) {
+    for (size_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+        if (renderEngineTimingLegacy.counts[i] == 0) continue;
         SFTimeStatsHistogramBucketProto* histProto = globalProto.add_render_engine_timing();
-        histProto->set_time_millis(histEle.first);
-        histProto->set_frame_count(histEle.second);
+        histProto->set_time_millis(Histogram::BUCKETS_MILLIS[i]);
+        histProto->set_frame_count(renderEngineTimingLegacy.counts[i]);
     }
     const auto dumpStats = generateDumpStats(maxLayers);
     for (const auto& ele : dumpStats) {
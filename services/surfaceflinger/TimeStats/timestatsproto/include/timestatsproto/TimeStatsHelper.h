@@ -18,6 +18,7 @@
 #include <timestatsproto/TimeStatsProtoHeader.h>
 #include <utils/Timers.h>
 
+#include <array>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -30,11 +31,17 @@ class TimeStatsHelper {
 public:
     class Histogram {
     public:
-        // Key is the delta time between timestamps
-        // Value is the number of appearances of that delta
-        std::unordered_map<int32_t, int32_t> hist;
+        static constexpr size_t NUM_BUCKETS = 85;
+
+        // Time buckets in milliseconds. Deltas are rounded up to the nearest bucket, and deltas
+        // past the last bucket are counted in the last bucket.
+        static const std::array<int32_t, NUM_BUCKETS> BUCKETS_MILLIS;
+
+        // Number of appearances of deltas in each bucket, indexed like BUCKETS_MILLIS
+        std::array<int32_t, NUM_BUCKETS> counts{};
 
         void insert(int32_t delta);
+        void clear() { counts.fill(0); }
         int64_t totalTime() const;
         float averageTime() const;
         std::string toString() const;
@@ -52,7 +52,7 @@ static bool containsOnCommitCallbacks(const std::vector<CallbackId>& callbacks)
 TransactionCallbackInvoker::~TransactionCallbackInvoker() {
     {
         std::lock_guard lock(mMutex);
-        for (const auto& [listener, transactionStats] : mCompletedTransactions) {
+        for (const auto& [listener, completedTransactions] : mCompletedTransactions) {
             listener->unlinkToDeath(mDeathRecipient);
         }
     }
@@ -65,15 +65,26 @@ status_t TransactionCallbackInvoker::startRegistration(const ListenerCallbacks&
     auto& [listener, callbackIds] = listenerCallbacks;
 
     if (inserted) {
-        if (mCompletedTransactions.count(listener) == 0) {
+        auto completedTransactions = mCompletedTransactions.find(listener);
+        if (completedTransactions == mCompletedTransactions.end()) {
             status_t err = listener->linkToDeath(mDeathRecipient);
             if (err != NO_ERROR) {
                 ALOGE("cannot add callback because linkToDeath failed, err: %d", err);
                 return err;
             }
+            // The listener stored comes from the cross-process setTransactionState call to SF.
+            // This MUST be an ITransactionCompletedListener. We keep it as an IBinder key due to
+            // consistency reasons: if we interface_cast at the IPC boundary when reading a
+            // Parcel, we get pointers that compare unequal in the SF process.
+            completedTransactions =
+                    mCompletedTransactions
+                            .emplace(listener,
+                                     CompletedTransactions{
+                                             interface_cast<ITransactionCompletedListener>(
+                                                     listener)})
+                            .first;
         }
-        auto& transactionStatsDeque = mCompletedTransactions[listener];
-        transactionStatsDeque.emplace_back(callbackIds);
+        completedTransactions->second.transactionStats.emplace_back(callbackIds);
     }
 
     return NO_ERROR;
@@ -95,6 +106,10 @@ status_t TransactionCallbackInvoker::endRegistration(const ListenerCallbacks& li
 
 bool TransactionCallbackInvoker::isRegisteringTransaction(
         const sp<IBinder>& transactionListener, const std::vector<CallbackId>& callbackIds) {
+    // Spare the copy of the ids in the common case of no transaction being registered.
+    if (mRegisteringTransactions.empty()) {
+        return false;
+    }
     ListenerCallbacks listenerCallbacks(transactionListener, callbackIds);
 
     auto itr = mRegisteringTransactions.find(listenerCallbacks);
@@ -198,7 +213,12 @@ status_t TransactionCallbackInvoker::registerUnpresentedCallbackHandle(
 status_t TransactionCallbackInvoker::findTransactionStats(
         const sp<IBinder>& listener, const std::vector<CallbackId>& callbackIds,
         TransactionStats** outTransactionStats) {
-    auto& transactionStatsDeque = mCompletedTransactions[listener];
+    auto completedTransactions = mCompletedTransactions.find(listener);
+    if (completedTransactions == mCompletedTransactions.end()) {
+        ALOGE("could not find transaction stats");
+        return BAD_VALUE;
+    }
+    auto& transactionStatsDeque = completedTransactions->second.transactionStats;
 
     // Search back to front because the most recent transactions are at the back of the deque
     auto itr = transactionStatsDeque.rbegin();
@@ -248,13 +268,29 @@ void TransactionCallbackInvoker::addPresentFence(const sp<Fence>& presentFence)
     mPresentFence = presentFence;
 }
 
+void TransactionCallbackInvoker::removeListener(const wp<IBinder>& listener) {
+    sp<IBinder> binder = listener.promote();
+    if (!binder) {
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    mCompletedTransactions.erase(binder);
+}
+
 void TransactionCallbackInvoker::sendCallbacks() {
     std::lock_guard lock(mMutex);
 
     // For each listener
     auto completedTransactionsItr = mCompletedTransactions.begin();
     while (completedTransactionsItr != mCompletedTransactions.end()) {
-        auto& [listener, transactionStatsDeque] = *completedTransactionsItr;
+        auto& [listener, completedTransactions] = *completedTransactionsItr;
+        auto& transactionStatsDeque = completedTransactions.transactionStats;
+        if (transactionStatsDeque.empty()) {
+            completedTransactionsItr++;
+            continue;
+        }
+
+        // All the callbacks that are ready, on commit or completed, go in one call.
         ListenerStats listenerStats;
         listenerStats.listener = listener;
 
@@ -288,28 +324,22 @@ void TransactionCallbackInvoker::sendCallbacks() {
             }
 
             // Remove the transaction from completed to the callback
+            if (listenerStats.transactionStats.empty()) {
+                listenerStats.transactionStats.reserve(transactionStatsDeque.size());
+            }
             listenerStats.transactionStats.push_back(std::move(transactionStats));
-            transactionStatsItr = transactionStatsDeque.erase(transactionStatsItr);
+            transactionStatsItr++;
         }
         // If the listener has completed transactions
         if (!listenerStats.transactionStats.empty()) {
+            // Drop the sent transactions, whose stats were moved out, in one go.
+            transactionStatsDeque.erase(transactionStatsDeque.begin(), transactionStatsItr);
             // If the listener is still alive
             if (listener->isBinderAlive()) {
-                // Send callback.  The listener stored in listenerStats
-                // comes from the cross-process setTransactionState call to
-                // SF.  This MUST be an ITransactionCompletedListener.  We
-                // keep it as an IBinder due to consistency reasons: if we
-                // interface_cast at the IPC boundary when reading a Parcel,
-                // we get pointers that compare unequal in the SF process.
-                interface_cast<ITransactionCompletedListener>(listenerStats.listener)
-                        ->onTransactionCompleted(listenerStats);
-                if (transactionStatsDeque.empty()) {
-                    listener->unlinkToDeath(mDeathRecipient);
-                    completedTransactionsItr =
-                            mCompletedTransactions.erase(completedTransactionsItr);
-                } else {
-                    completedTransactionsItr++;
-                }
+                // Send callback. ListenerStats is moved in, as the call parcels it and has no
+                // use for a copy.
+                completedTransactions.listener->onTransactionCompleted(std::move(listenerStats));
+                completedTransactionsItr++;
             } else {
                 completedTransactionsItr =
                         mCompletedTransactions.erase(completedTransactionsItr);
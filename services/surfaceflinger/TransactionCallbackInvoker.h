@@ -101,17 +101,24 @@ private:
     status_t finalizeCallbackHandle(const sp<CallbackHandle>& handle,
                                     const std::vector<JankData>& jankData) REQUIRES(mMutex);
 
+    void removeListener(const wp<IBinder>& listener);
+
     class CallbackDeathRecipient : public IBinder::DeathRecipient {
     public:
-        // This function is a no-op. isBinderAlive needs a linked DeathRecipient to work.
-        // Death recipients needs a binderDied function.
-        //
-        // (isBinderAlive checks if BpBinder's mAlive is 0. mAlive is only set to 0 in sendObituary.
-        // sendObituary is only called if linkToDeath was called with a DeathRecipient.)
-        void binderDied(const wp<IBinder>& /*who*/) override {}
+        explicit CallbackDeathRecipient(TransactionCallbackInvoker& invoker)
+              : mInvoker(invoker) {}
+
+        // Listeners stay linked while they are alive, so that they aren't linked and unlinked
+        // every frame, and are only forgotten here. Linking also makes isBinderAlive work: it
+        // checks BpBinder's mAlive, which is only set to 0 by sendObituary, which is only called
+        // if linkToDeath was called with a DeathRecipient.
+        void binderDied(const wp<IBinder>& who) override { mInvoker.removeListener(who); }
+
+    private:
+        TransactionCallbackInvoker& mInvoker;
     };
     sp<CallbackDeathRecipient> mDeathRecipient =
-        new CallbackDeathRecipient();
+        new CallbackDeathRecipient(*this);
 
     std::mutex mMutex;
     std::condition_variable_any mConditionVariable;
@@ -125,8 +132,15 @@ private:
             IListenerHash>
             mPendingTransactions GUARDED_BY(mMutex);
 
-    std::unordered_map<sp<IBinder>, std::deque<TransactionStats>, IListenerHash>
-            mCompletedTransactions GUARDED_BY(mMutex);
+    struct CompletedTransactions {
+        // The listener, cast once rather than for each callback.
+        sp<ITransactionCompletedListener> listener;
+        std::deque<TransactionStats> transactionStats;
+    };
+    // Listeners are kept once their transactions have been sent, until they die, so that their
+    // entries, and the storage of their deques, are reused from one frame to the next.
+    std::unordered_map<sp<IBinder>, CompletedTransactions, IListenerHash> mCompletedTransactions
+            GUARDED_BY(mMutex);
 
     sp<Fence> mPresentFence GUARDED_BY(mMutex);
 };
@@ -96,6 +96,28 @@ TEST_F(SlotGenerationTest, getHwcCacheSlot_Reuse) {
         cacheId++;
     }
 }
+
+TEST_F(SlotGenerationTest, takeSlotsToClear_EvictedSlot) {
+    sp<IBinder> binder = new BBinder();
+    std::vector<client_cache_t> ids;
+    for (uint32_t i = 0; i <= BufferQueue::NUM_BUFFER_SLOTS; i++) {
+        client_cache_t id;
+        id.token = binder;
+        id.id = i;
+        ids.push_back(id);
+    }
+    for (uint32_t i = 0; i < BufferQueue::NUM_BUFFER_SLOTS; i++) {
+        mHwcSlotGenerator->getHwcCacheSlot(ids[i]);
+    }
+    EXPECT_TRUE(mHwcSlotGenerator->takeSlotsToClear().empty());
+
+    // Using the first buffer again makes the second one the least recently used.
+    mHwcSlotGenerator->getHwcCacheSlot(ids[0]);
+    uint32_t slot = mHwcSlotGenerator->getHwcCacheSlot(ids[BufferQueue::NUM_BUFFER_SLOTS]);
+    EXPECT_EQ(BufferQueue::NUM_BUFFER_SLOTS - 2, slot);
+    EXPECT_EQ(std::vector<uint32_t>{slot}, mHwcSlotGenerator->takeSlotsToClear());
+    EXPECT_TRUE(mHwcSlotGenerator->takeSlotsToClear().empty());
+}
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -23,6 +23,8 @@
 #undef LOG_TAG
 #define LOG_TAG "CompositionTest"
 
+#include <android/gui/BnScreenCaptureListener.h>
+#include <compositionengine/CompositionRefreshArgs.h>
 #include <compositionengine/Display.h>
 #include <compositionengine/mock/DisplaySurface.h>
 #include <gmock/gmock.h>
@@ -1508,6 +1510,69 @@ TEST_F(CompositionTest, DebugOptionForcingClientCompositionOfBufferLayerWithDirt
                             ForcedClientCompositionViaDebugOptionResultVariant>>();
 }
 
+/* ------------------------------------------------------------------------
+ *  Display captures read back by the HWC
+ */
+
+class ReadbackCaptureListener : public gui::BnScreenCaptureListener {
+public:
+    binder::Status onScreenCaptureCompleted(const gui::ScreenCaptureResults& results) override {
+        mResults.push_back(results);
+        return binder::Status::ok();
+    }
+
+    std::vector<gui::ScreenCaptureResults> mResults;
+};
+
+TEST_F(CompositionTest, readbackCaptureIsDrawnWhenSecureLayerAppearsAfterQueueing) {
+    using Case = CompositionCase<InsecureDisplaySetupVariant,
+                                 EffectLayerVariant<SecureLayerProperties>,
+                                 NoCompositionTypeVariant, NoCompositionResultVariant>;
+    Case::Display::setupPreconditionCallExpectations<Case>(this);
+    Case::Display::setupPreconditions(this);
+
+    // The HWC composed the last frame by itself, so the capture can be read back.
+    auto& displayState = mDisplay->getCompositionDisplay()->editState();
+    displayState.usesClientComposition = false;
+    displayState.usesDeviceComposition = true;
+
+    const Rect sourceCrop(0, 0, DEFAULT_DISPLAY_WIDTH, DEFAULT_DISPLAY_HEIGHT);
+    auto renderArea = DisplayRenderArea::create(mDisplay, sourceCrop, sourceCrop.getSize(),
+                                                ui::Dataspace::V0_SRGB, ui::Transform::ROT_0);
+    ASSERT_TRUE(mFlinger.isReadbackExact(*renderArea, mat4()));
+
+    auto traverseLayers = [this](const LayerVector::Visitor& visitor) {
+        return mFlinger.traverseLayersInLayerStack(mDisplay->getLayerStack(),
+                                                   CaptureArgs::UNSET_UID, visitor);
+    };
+    const uint32_t usage = GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN |
+            GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
+    const auto buffer = std::make_shared<
+            renderengine::ExternalTexture>(new GraphicBuffer(DEFAULT_DISPLAY_WIDTH,
+                                                             DEFAULT_DISPLAY_HEIGHT,
+                                                             HAL_PIXEL_FORMAT_RGBA_8888, 1, usage,
+                                                             "screenshot"),
+                                           *mRenderEngine, true);
+    const auto listener = sp<ReadbackCaptureListener>::make();
+    mFlinger.mutablePendingReadbacks().push_back({std::move(renderArea), traverseLayers, buffer,
+                                                  false /* canCaptureBlackoutContent */,
+                                                  listener});
+
+    // A transaction committed before the next frame adds a secure layer.
+    auto layer = Case::Layer::createLayer(this);
+    Case::Layer::injectLayer(this, layer);
+    ASSERT_TRUE(layer->isVisible());
+
+    // The HWC doesn't read back the frame, and the capture is drawn by RenderEngine, which
+    // refuses to show the secure layer.
+    EXPECT_CALL(*mComposer, setReadbackBuffer(_, _, _)).Times(0);
+    EXPECT_TRUE(mFlinger.setReadbackBuffers(compositionengine::CompositionRefreshArgs()).empty());
+    ASSERT_EQ(1u, listener->mResults.size());
+    EXPECT_EQ(PERMISSION_DENIED, listener->mResults[0].result);
+
+    Case::cleanup(this);
+}
+
 } // namespace
 } // namespace android
 
@@ -517,6 +517,30 @@ TEST_F(EventThreadTest, eventsDroppedIfNonfatalEventDeliveryError) {
     EXPECT_FALSE(mVSyncSetEnabledCallRecorder.waitForUnexpectedCall().has_value());
 }
 
+TEST_F(EventThreadTest, countsEventsDroppedByConnection) {
+    ConnectionEventRecorder errorConnectionEventRecorder{WOULD_BLOCK};
+    sp<MockEventThreadConnection> errorConnection = createConnection(errorConnectionEventRecorder);
+    mThread->setVsyncRate(1, errorConnection);
+
+    // EventThread should enable vsync callbacks.
+    expectVSyncSetEnabledCallReceived(true);
+
+    mCallback->onVSyncEvent(123, 456, 789);
+    expectInterceptCallReceived(123);
+    expectVsyncEventReceivedByConnection("errorConnection", errorConnectionEventRecorder, 123, 1u);
+
+    mCallback->onVSyncEvent(456, 123, 0);
+    expectInterceptCallReceived(456);
+    expectVsyncEventReceivedByConnection("errorConnection", errorConnectionEventRecorder, 456, 2u);
+
+    // Waits for the second dispatch to finish handling its delivery errors.
+    EXPECT_EQ(3, mThread->getEventThreadConnectionCount());
+
+    std::string dump;
+    mThread->dump(dump);
+    EXPECT_NE(std::string::npos, dump.find("dropped=2"));
+}
+
 TEST_F(EventThreadTest, setPhaseOffsetForwardsToVSyncSource) {
     mThread->setDuration(321ns, 456ns);
     expectVSyncSetDurationCallReceived(321ns, 456ns);
@@ -174,12 +174,14 @@ TEST_F(FpsReporterTest, callsListeners) {
     mFpsReporter->addListener(mFpsListener, kTaskId);
     mClock->advanceTime(600ms);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
     EXPECT_EQ(expectedFps, mFpsListener->lastReportedFps);
     mFpsReporter->removeListener(mFpsListener);
     Mock::VerifyAndClearExpectations(&mFrameTimeline);
 
     EXPECT_CALL(mFrameTimeline, computeFps(_)).Times(0);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
 }
 
 TEST_F(FpsReporterTest, rateLimits) {
@@ -199,15 +201,19 @@ TEST_F(FpsReporterTest, rateLimits) {
     mFpsReporter->addListener(mFpsListener, kTaskId);
     mClock->advanceTime(600ms);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
     EXPECT_EQ(firstFps, mFpsListener->lastReportedFps);
     mClock->advanceTime(200ms);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
     EXPECT_EQ(firstFps, mFpsListener->lastReportedFps);
     mClock->advanceTime(200ms);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
     EXPECT_EQ(firstFps, mFpsListener->lastReportedFps);
     mClock->advanceTime(200ms);
     mFpsReporter->dispatchLayerFps();
+    mFpsReporter->flush();
     EXPECT_EQ(secondFps, mFpsListener->lastReportedFps);
 }
 
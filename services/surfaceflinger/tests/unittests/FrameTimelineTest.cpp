@@ -76,6 +76,18 @@ public:
         maxTokens = mTokenManager->kMaxTokens;
     }
 
+    void createFrameTimelineWithWorker() {
+        mFrameTimeline = std::make_unique<impl::FrameTimeline>(mTimeStats, kSurfaceFlingerPid,
+                                                               kTestThresholds,
+                                                               /*classifyOnWorkerThread*/ true);
+        mFrameTimeline->registerDataSource();
+        mTokenManager = &mFrameTimeline->mTokenManager;
+        mTraceCookieCounter = &mFrameTimeline->mTraceCookieCounter;
+        maxDisplayFrames = &mFrameTimeline->mMaxDisplayFrames;
+    }
+
+    void waitForWorker() { mFrameTimeline->waitForWorker(); }
+
     // Each tracing session can be used for a single block of Start -> Stop.
     static std::unique_ptr<perfetto::TracingSession> getTracingSessionForTest() {
         perfetto::TraceConfig cfg;
@@ -129,6 +141,11 @@ public:
         return mFrameTimeline->mDisplayFrames[idx];
     }
 
+    std::shared_ptr<impl::FrameTimeline::DisplayFrame> getCurrentDisplayFrame() {
+        std::lock_guard<std::mutex> lock(mFrameTimeline->mMutex);
+        return mFrameTimeline->mCurrentDisplayFrame;
+    }
+
     static bool compareTimelineItems(const TimelineItem& a, const TimelineItem& b) {
         return a.startTime == b.startTime && a.endTime == b.endTime &&
                 a.presentTime == b.presentTime;
@@ -434,6 +451,73 @@ TEST_F(FrameTimelineTest, setMaxDisplayFramesSetsSizeProperly) {
     EXPECT_EQ(getNumberOfDisplayFrames(), *maxDisplayFrames);
 }
 
+TEST_F(FrameTimelineTest, displayFramesAreRecycledAfterLimit) {
+    auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    presentFence->signalForTest(2);
+
+    const auto addDisplayFrame = [&] {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
+                                                           sLayerNameOne, sLayerNameOne,
+                                                           /*isBuffer*/ true, sGameMode);
+        int64_t sfToken = mTokenManager->generateTokenForPredictions({22, 26, 30});
+        mFrameTimeline->setSfWakeUp(sfToken, 22, Fps::fromPeriodNsecs(11));
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        mFrameTimeline->setSfPresent(27, presentFence);
+    };
+
+    for (size_t i = 0; i < *maxDisplayFrames; i++) {
+        addDisplayFrame();
+    }
+    const auto* oldestDisplayFrame = getDisplayFrame(0).get();
+
+    // The oldest DisplayFrame ages out, and is reused for the next frame in its initial state.
+    addDisplayFrame();
+    EXPECT_EQ(getNumberOfDisplayFrames(), *maxDisplayFrames);
+
+    const auto currentDisplayFrame = getCurrentDisplayFrame();
+    EXPECT_EQ(currentDisplayFrame.get(), oldestDisplayFrame);
+    EXPECT_TRUE(currentDisplayFrame->getSurfaceFrames().empty());
+    EXPECT_EQ(currentDisplayFrame->getJankType(), JankType::None);
+    EXPECT_EQ(compareTimelineItems(currentDisplayFrame->getActuals(), TimelineItem()), true);
+    EXPECT_EQ(compareTimelineItems(currentDisplayFrame->getPredictions(), TimelineItem()), true);
+}
+
+TEST_F(FrameTimelineTest, presentFenceSignaled_classifiedOnWorkerThread) {
+    createFrameTimelineWithWorker();
+
+    Fps refreshRate = Fps::fromPeriodNsecs(11);
+    EXPECT_CALL(*mTimeStats,
+                incrementJankyFrames(
+                        TimeStats::JankyFramesInfo{refreshRate, std::nullopt, sUidOne,
+                                                   sLayerNameOne, sGameMode,
+                                                   JankType::SurfaceFlingerCpuDeadlineMissed, 2, 10,
+                                                   0}));
+    auto presentFence1 = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    int64_t surfaceFrameToken1 = mTokenManager->generateTokenForPredictions({10, 20, 60});
+    int64_t sfToken1 = mTokenManager->generateTokenForPredictions({52, 60, 60});
+
+    auto surfaceFrame1 =
+            mFrameTimeline->createSurfaceFrameForToken({surfaceFrameToken1, sInputEventId}, sPidOne,
+                                                       sUidOne, sLayerIdOne, sLayerNameOne,
+                                                       sLayerNameOne, /*isBuffer*/ true, sGameMode);
+    mFrameTimeline->setSfWakeUp(sfToken1, 52, refreshRate);
+    surfaceFrame1->setAcquireFenceTime(20);
+    surfaceFrame1->setPresentState(SurfaceFrame::PresentState::Presented);
+    mFrameTimeline->addSurfaceFrame(surfaceFrame1);
+    presentFence1->signalForTest(70);
+
+    mFrameTimeline->setSfPresent(62, presentFence1);
+    waitForWorker();
+
+    auto displayFrame = getDisplayFrame(0);
+    EXPECT_EQ(displayFrame->getActuals().presentTime, 70);
+    EXPECT_EQ(displayFrame->getJankType(), JankType::SurfaceFlingerCpuDeadlineMissed);
+    EXPECT_EQ(surfaceFrame1->getActuals().presentTime, 70);
+    EXPECT_EQ(surfaceFrame1->getJankType(), JankType::SurfaceFlingerCpuDeadlineMissed);
+}
+
 TEST_F(FrameTimelineTest, presentFenceSignaled_invalidSignalTime) {
     Fps refreshRate = Fps::fromPeriodNsecs(11);
 
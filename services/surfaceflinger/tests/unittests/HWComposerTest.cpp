@@ -36,6 +36,7 @@
 #include "DisplayHardware/DisplayMode.h"
 #include "DisplayHardware/HWComposer.h"
 #include "DisplayHardware/Hal.h"
+#include "DisplayIdentificationTest.h"
 #include "mock/DisplayHardware/MockComposer.h"
 #include "mock/DisplayHardware/MockHWC2.h"
 
@@ -179,5 +180,114 @@ TEST_F(HWComposerLayerGenericMetadataTest, forwardsSupportedMetadata) {
     EXPECT_EQ(hal::Error::UNSUPPORTED, result);
 }
 
+struct HWComposerLayerStateTest : public HWComposerLayerTest {
+    HWComposerLayerStateTest() : HWComposerLayerTest({}) {}
+};
+
+TEST_F(HWComposerLayerStateTest, skipsUnchangedState) {
+    const Rect frame(10, 20, 30, 40);
+    EXPECT_CALL(*mHal, setLayerDisplayFrame(kDisplayId, kLayerId, _))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 0.5f))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 3u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+        EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+        EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(3u));
+    }
+}
+
+TEST_F(HWComposerLayerStateTest, sendsChangedState) {
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 3u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 4u))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(3u));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(4u));
+}
+
+TEST_F(HWComposerLayerStateTest, resendsStateAfterError) {
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 0.5f))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NO_RESOURCES))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NO_RESOURCES, mLayer.setPlaneAlpha(0.5f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+}
+
+struct HWComposerModesTest : testing::Test {
+    static constexpr hal::HWDisplayId kHwcDisplayId = 1;
+    static constexpr hal::HWConfigId kConfigId = 7;
+    static constexpr uint8_t kPort = 2;
+
+    Hwc2::mock::Composer* mHal = new StrictMock<Hwc2::mock::Composer>();
+    impl::HWComposer mHwc{std::unique_ptr<Hwc2::Composer>(mHal)};
+
+    std::optional<DisplayIdentificationInfo> connect(const DisplayIdentificationData& edid) {
+        EXPECT_CALL(*mHal, getDisplayIdentificationData(kHwcDisplayId, _, _))
+                .WillOnce(DoAll(SetArgPointee<1>(kPort), SetArgPointee<2>(edid),
+                                Return(hardware::graphics::composer::V2_4::Error::NONE)));
+        return mHwc.onHotplug(kHwcDisplayId, hal::Connection::CONNECTED);
+    }
+};
+
+TEST_F(HWComposerModesTest, reusesModesOfReconnectedDisplay) {
+    EXPECT_CALL(*mHal, getDisplayConfigs(kHwcDisplayId, _))
+            .Times(2)
+            .WillRepeatedly(DoAll(SetArgPointee<1>(std::vector<hal::HWConfigId>{kConfigId}),
+                                  Return(hardware::graphics::composer::V2_4::Error::NONE)));
+    // One query per attribute of the single config, on the first connection only.
+    EXPECT_CALL(*mHal, getDisplayAttribute(kHwcDisplayId, kConfigId, _, _))
+            .Times(6)
+            .WillRepeatedly(DoAll(SetArgPointee<3>(60),
+                                  Return(hardware::graphics::composer::V2_4::Error::NONE)));
+    EXPECT_CALL(*mHal, setVsyncEnabled(kHwcDisplayId, _))
+            .WillRepeatedly(Return(hardware::graphics::composer::V2_4::Error::NONE));
+
+    const auto info = connect(getExternalEdid());
+    ASSERT_TRUE(info);
+    const auto modes = mHwc.getModes(info->id);
+    ASSERT_EQ(1u, modes.size());
+
+    mHwc.onHotplug(kHwcDisplayId, hal::Connection::DISCONNECTED);
+    mHwc.disconnectDisplay(info->id);
+
+    const auto reconnectedInfo = connect(getExternalEdid());
+    ASSERT_TRUE(reconnectedInfo);
+    ASSERT_EQ(info->id, reconnectedInfo->id);
+    const auto reconnectedModes = mHwc.getModes(info->id);
+    ASSERT_EQ(1u, reconnectedModes.size());
+    EXPECT_EQ(kConfigId, reconnectedModes[0].hwcId);
+    EXPECT_EQ(modes[0].width, reconnectedModes[0].width);
+    EXPECT_EQ(modes[0].vsyncPeriod, reconnectedModes[0].vsyncPeriod);
+}
+
+using HWComposerReadbackTest = HWComposerModesTest;
+
+TEST_F(HWComposerReadbackTest, reportsUnsupportedReadbackAsInvalidOperation) {
+    EXPECT_CALL(*mHal, setVsyncEnabled(kHwcDisplayId, _))
+            .WillRepeatedly(Return(hardware::graphics::composer::V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, getReadbackBufferAttributes(kHwcDisplayId, _, _))
+            .WillOnce(Return(hardware::graphics::composer::V2_4::Error::UNSUPPORTED));
+    EXPECT_CALL(*mHal, getReadbackBufferFence(kHwcDisplayId, _))
+            .WillOnce(DoAll(SetArgPointee<1>(-1),
+                            Return(hardware::graphics::composer::V2_4::Error::NONE)));
+
+    const auto info = connect(getExternalEdid());
+    ASSERT_TRUE(info);
+
+    ui::PixelFormat format;
+    ui::Dataspace dataspace;
+    EXPECT_EQ(INVALID_OPERATION, mHwc.getReadbackBufferAttributes(info->id, &format, &dataspace));
+
+    sp<Fence> fence;
+    EXPECT_EQ(NO_ERROR, mHwc.getReadbackBufferFence(info->id, &fence));
+    EXPECT_EQ(Fence::NO_FENCE, fence);
+}
+
 } // namespace
 } // namespace android
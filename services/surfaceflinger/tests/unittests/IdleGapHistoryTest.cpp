@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SchedulerUnittests"
+
+#include <gtest/gtest.h>
+
+#include "Scheduler/IdleGapHistory.h"
+
+using namespace std::chrono_literals;
+
+namespace android::scheduler {
+namespace {
+
+constexpr uid_t kUid = 10001;
+constexpr uid_t kOtherUid = 10002;
+
+class IdleGapHistoryTest : public testing::Test {
+protected:
+    void recordGaps(uid_t uid, IdleGapHistory::Duration gap, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            mTimeout = mHistory.recordGap(uid, gap);
+        }
+    }
+
+    IdleGapHistory mHistory{500ms, 2000ms, 500ms};
+    IdleGapHistory::Duration mTimeout = 500ms;
+};
+
+TEST_F(IdleGapHistoryTest, keepsBaseTimeoutUntilLearned) {
+    recordGaps(kUid, 600ms, 3);
+    EXPECT_EQ(500ms, mTimeout);
+}
+
+TEST_F(IdleGapHistoryTest, ignoresGapsShorterThanBaseTimeout) {
+    recordGaps(kUid, 100ms, 10);
+    EXPECT_EQ(500ms, mTimeout);
+    EXPECT_EQ(0u, mHistory.getStats().gaps);
+}
+
+TEST_F(IdleGapHistoryTest, stretchesTimeoutPastShortPauses) {
+    recordGaps(kUid, 600ms, 8);
+    EXPECT_EQ(750ms, mTimeout);
+}
+
+TEST_F(IdleGapHistoryTest, keepsBaseTimeoutForLongIdle) {
+    recordGaps(kUid, 10s, 8);
+    EXPECT_EQ(500ms, mTimeout);
+}
+
+TEST_F(IdleGapHistoryTest, stretchesTimeoutIfItSavesMoreThanItGivesUp) {
+    recordGaps(kUid, 600ms, 6);
+    recordGaps(kUid, 10s, 2);
+    EXPECT_EQ(750ms, mTimeout);
+}
+
+TEST_F(IdleGapHistoryTest, learnsTimeoutPerUid) {
+    recordGaps(kUid, 600ms, 8);
+    EXPECT_EQ(750ms, mTimeout);
+
+    EXPECT_EQ(500ms, mHistory.selectTimeout(kOtherUid));
+    EXPECT_EQ(750ms, mHistory.selectTimeout(kUid));
+}
+
+TEST_F(IdleGapHistoryTest, countsDownshifts) {
+    // The first gaps downshift for too short to pay off, after which the timeout is stretched.
+    recordGaps(kUid, 600ms, 5);
+    EXPECT_EQ(750ms, mTimeout);
+
+    const auto stats = mHistory.getStats();
+    EXPECT_EQ(5u, stats.gaps);
+    EXPECT_EQ(4u, stats.downshifts);
+    EXPECT_EQ(4u, stats.wastedDownshifts);
+    EXPECT_EQ(1u, stats.avoidedDownshifts);
+    EXPECT_EQ(400ms, stats.idleTime);
+    EXPECT_EQ(500ms, stats.baseIdleTime);
+}
+
+TEST_F(IdleGapHistoryTest, clear) {
+    recordGaps(kUid, 600ms, 8);
+    mHistory.clear();
+
+    EXPECT_EQ(500ms, mHistory.selectTimeout(kUid));
+    EXPECT_EQ(0u, mHistory.getStats().gaps);
+}
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerUnittests"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <gui/LayerMetadata.h>
+#include <log/log.h>
+
+#include "EffectLayer.h"
+#include "TestableSurfaceFlinger.h"
+#include "mock/DisplayHardware/MockComposer.h"
+#include "mock/MockEventThread.h"
+#include "mock/MockVsyncController.h"
+
+namespace android {
+
+using testing::_;
+using testing::Return;
+using FakeHwcDisplayInjector = TestableSurfaceFlinger::FakeHwcDisplayInjector;
+
+class LayerBoundsTest : public testing::Test {
+public:
+    LayerBoundsTest() {
+        const ::testing::TestInfo* const test_info =
+                ::testing::UnitTest::GetInstance()->current_test_info();
+        ALOGD("**** Setting up for %s.%s\n", test_info->test_case_name(), test_info->name());
+        setupScheduler();
+        mFlinger.setupComposer(std::make_unique<Hwc2::mock::Composer>());
+    }
+
+    ~LayerBoundsTest() {
+        const ::testing::TestInfo* const test_info =
+                ::testing::UnitTest::GetInstance()->current_test_info();
+        ALOGD("**** Tearing down after %s.%s\n", test_info->test_case_name(), test_info->name());
+    }
+
+    sp<EffectLayer> createEffectLayer() {
+        sp<Client> client;
+        LayerCreationArgs args(mFlinger.flinger(), client, "color-layer", 100, 100, 0,
+                               LayerMetadata());
+        return new EffectLayer(args);
+    }
+
+    void setupScheduler() {
+        auto eventThread = std::make_unique<mock::EventThread>();
+        auto sfEventThread = std::make_unique<mock::EventThread>();
+
+        EXPECT_CALL(*eventThread, registerDisplayEventConnection(_));
+        EXPECT_CALL(*eventThread, createEventConnection(_, _))
+                .WillOnce(Return(new EventThreadConnection(eventThread.get(), /*callingUid=*/0,
+                                                           ResyncCallback())));
+
+        EXPECT_CALL(*sfEventThread, registerDisplayEventConnection(_));
+        EXPECT_CALL(*sfEventThread, createEventConnection(_, _))
+                .WillOnce(Return(new EventThreadConnection(sfEventThread.get(), /*callingUid=*/0,
+                                                           ResyncCallback())));
+
+        auto vsyncController = std::make_unique<mock::VsyncController>();
+        auto vsyncTracker = std::make_unique<mock::VSyncTracker>();
+
+        EXPECT_CALL(*vsyncTracker, nextAnticipatedVSyncTimeFrom(_)).WillRepeatedly(Return(0));
+        EXPECT_CALL(*vsyncTracker, currentPeriod())
+                .WillRepeatedly(Return(FakeHwcDisplayInjector::DEFAULT_VSYNC_PERIOD));
+        mFlinger.setupScheduler(std::move(vsyncController), std::move(vsyncTracker),
+                                std::move(eventThread), std::move(sfEventThread));
+    }
+
+    void computeBounds(const sp<Layer>& root) {
+        root->computeBounds(kDisplayBounds, ui::Transform(), 0.f /* shadowRadius */);
+    }
+
+    static constexpr FloatRect kDisplayBounds{0, 0, 1000, 1000};
+
+    TestableSurfaceFlinger mFlinger;
+};
+
+TEST_F(LayerBoundsTest, UnchangedLayerKeepsCachedBounds) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> childLayer = createEffectLayer();
+    rootLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    computeBounds(rootLayer);
+    EXPECT_EQ(kDisplayBounds, childLayer->getBounds());
+
+    // A change which did not go through a transaction is not picked up...
+    TestableSurfaceFlinger::mutableLayerDrawingState(childLayer).crop = Rect(0, 0, 10, 10);
+    computeBounds(rootLayer);
+    EXPECT_EQ(kDisplayBounds, childLayer->getBounds());
+
+    // ...until the layer is committed.
+    childLayer->doTransaction(0);
+    computeBounds(rootLayer);
+    EXPECT_EQ(FloatRect(0, 0, 10, 10), childLayer->getBounds());
+}
+
+TEST_F(LayerBoundsTest, ChangedParentRecomputesChildren) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> childLayer = createEffectLayer();
+    rootLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    computeBounds(rootLayer);
+
+    rootLayer->setPosition(100, 50);
+    rootLayer->doTransaction(0);
+    computeBounds(rootLayer);
+    EXPECT_EQ(100, childLayer->getTransform().tx());
+    EXPECT_EQ(50, childLayer->getTransform().ty());
+}
+
+TEST_F(LayerBoundsTest, ReparentedLayerIsRecomputed) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> parentLayer = createEffectLayer();
+    sp<EffectLayer> childLayer = createEffectLayer();
+    rootLayer->addChild(parentLayer);
+    rootLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    parentLayer->setPosition(100, 50);
+    parentLayer->doTransaction(0);
+    computeBounds(rootLayer);
+    EXPECT_EQ(0, childLayer->getTransform().tx());
+
+    rootLayer->removeChild(childLayer);
+    parentLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    computeBounds(rootLayer);
+    EXPECT_EQ(100, childLayer->getTransform().tx());
+    EXPECT_EQ(50, childLayer->getTransform().ty());
+}
+
+} // namespace android
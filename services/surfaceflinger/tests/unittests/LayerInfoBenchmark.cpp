@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DisplayHardware/HWC2.h"
+#include "Scheduler/LayerHistory.h"
+#include "Scheduler/LayerInfo.h"
+#include "Scheduler/RefreshRateConfigs.h"
+
+namespace android::scheduler {
+namespace {
+
+namespace hal = android::hardware::graphics::composer::hal;
+
+constexpr Fps kContentFps{60.0f};
+
+// Enough frames to fill the frame time history of a layer.
+constexpr size_t kWarmUpFrames = 120;
+
+DisplayModePtr createDisplayMode(DisplayModeId modeId, Fps fps) {
+    return DisplayMode::Builder(hal::HWConfigId(modeId.value()))
+            .setId(modeId)
+            .setVsyncPeriod(static_cast<int32_t>(fps.getPeriodNsecs()))
+            .setGroup(0)
+            .build();
+}
+
+// Mirrors the per-vsync work of LayerHistory::summarize: a subset of the active layers posts a
+// frame, and every active layer is asked for its vote.
+void BM_summarizeActiveLayers(benchmark::State& state) {
+    const auto numLayers = static_cast<size_t>(state.range(0));
+    const auto numPostingLayers = static_cast<size_t>(state.range(1));
+
+    const DisplayModes modes = {createDisplayMode(DisplayModeId(0), Fps(60.0f)),
+                                createDisplayMode(DisplayModeId(1), Fps(90.0f))};
+    const RefreshRateConfigs configs(modes, DisplayModeId(0));
+    LayerInfo::setRefreshRateConfigs(configs);
+
+    std::vector<std::unique_ptr<LayerInfo>> infos;
+    for (size_t i = 0; i < numLayers; i++) {
+        infos.push_back(std::make_unique<LayerInfo>("Layer" + std::to_string(i), 0,
+                                                    LayerHistory::LayerVoteType::Heuristic));
+    }
+
+    const LayerInfo::LayerProps props{.visible = true};
+    const nsecs_t period = kContentFps.getPeriodNsecs();
+    nsecs_t time = systemTime();
+
+    const auto recordFrame = [&](LayerInfo& info) {
+        info.setLastPresentTime(time, time, LayerHistory::LayerUpdateType::Buffer,
+                                /*pendingModeChange*/ false, props);
+    };
+
+    // Fill the history of every layer so that the heuristic runs on each summary.
+    for (size_t frame = 0; frame < kWarmUpFrames; frame++) {
+        for (auto& info : infos) {
+            recordFrame(*info);
+        }
+        time += period;
+    }
+
+    size_t nextPostingLayer = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < numPostingLayers; i++) {
+            recordFrame(*infos[nextPostingLayer]);
+            nextPostingLayer = (nextPostingLayer + 1) % numLayers;
+        }
+
+        for (auto& info : infos) {
+            benchmark::DoNotOptimize(info->getRefreshRateVote(time));
+        }
+        time += period;
+    }
+}
+BENCHMARK(BM_summarizeActiveLayers)
+        ->Args({8, 1})
+        ->Args({8, 8})
+        ->Args({32, 1})
+        ->Args({32, 32})
+        ->Args({128, 1})
+        ->Args({128, 128});
+
+} // namespace
+} // namespace android::scheduler
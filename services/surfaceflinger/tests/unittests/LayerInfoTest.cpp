@@ -30,7 +30,10 @@ protected:
     using FrameTimeData = LayerInfo::FrameTimeData;
 
     void setFrameTimes(const std::deque<FrameTimeData>& frameTimes) {
-        layerInfo.mFrameTimes = frameTimes;
+        layerInfo.clearFrameTimes();
+        for (const auto& frameTime : frameTimes) {
+            layerInfo.addFrameTime(frameTime);
+        }
     }
 
     void setLastRefreshRate(Fps fps) {
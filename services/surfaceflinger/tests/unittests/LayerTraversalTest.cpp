@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerUnittests"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <gui/LayerMetadata.h>
+#include <log/log.h>
+
+#include "EffectLayer.h"
+#include "TestableSurfaceFlinger.h"
+#include "mock/DisplayHardware/MockComposer.h"
+#include "mock/MockEventThread.h"
+#include "mock/MockVsyncController.h"
+
+namespace android {
+
+using testing::_;
+using testing::ElementsAre;
+using testing::Return;
+using FakeHwcDisplayInjector = TestableSurfaceFlinger::FakeHwcDisplayInjector;
+
+class LayerTraversalTest : public testing::Test {
+public:
+    LayerTraversalTest() {
+        const ::testing::TestInfo* const test_info =
+                ::testing::UnitTest::GetInstance()->current_test_info();
+        ALOGD("**** Setting up for %s.%s\n", test_info->test_case_name(), test_info->name());
+        setupScheduler();
+        mFlinger.setupComposer(std::make_unique<Hwc2::mock::Composer>());
+    }
+
+    ~LayerTraversalTest() {
+        const ::testing::TestInfo* const test_info =
+                ::testing::UnitTest::GetInstance()->current_test_info();
+        ALOGD("**** Tearing down after %s.%s\n", test_info->test_case_name(), test_info->name());
+    }
+
+    sp<EffectLayer> createEffectLayer() {
+        sp<Client> client;
+        LayerCreationArgs args(mFlinger.flinger(), client, "color-layer", 100, 100, 0,
+                               LayerMetadata());
+        return new EffectLayer(args);
+    }
+
+    void setupScheduler() {
+        auto eventThread = std::make_unique<mock::EventThread>();
+        auto sfEventThread = std::make_unique<mock::EventThread>();
+
+        EXPECT_CALL(*eventThread, registerDisplayEventConnection(_));
+        EXPECT_CALL(*eventThread, createEventConnection(_, _))
+                .WillOnce(Return(new EventThreadConnection(eventThread.get(), /*callingUid=*/0,
+                                                           ResyncCallback())));
+
+        EXPECT_CALL(*sfEventThread, registerDisplayEventConnection(_));
+        EXPECT_CALL(*sfEventThread, createEventConnection(_, _))
+                .WillOnce(Return(new EventThreadConnection(sfEventThread.get(), /*callingUid=*/0,
+                                                           ResyncCallback())));
+
+        auto vsyncController = std::make_unique<mock::VsyncController>();
+        auto vsyncTracker = std::make_unique<mock::VSyncTracker>();
+
+        EXPECT_CALL(*vsyncTracker, nextAnticipatedVSyncTimeFrom(_)).WillRepeatedly(Return(0));
+        EXPECT_CALL(*vsyncTracker, currentPeriod())
+                .WillRepeatedly(Return(FakeHwcDisplayInjector::DEFAULT_VSYNC_PERIOD));
+        mFlinger.setupScheduler(std::move(vsyncController), std::move(vsyncTracker),
+                                std::move(eventThread), std::move(sfEventThread));
+    }
+
+    std::vector<Layer*> traverse(const sp<Layer>& root) {
+        std::vector<Layer*> layers;
+        root->traverseInZOrder(LayerVector::StateSet::Drawing,
+                               [&](Layer* layer) { layers.push_back(layer); });
+        return layers;
+    }
+
+    std::vector<Layer*> traverseInReverse(const sp<Layer>& root) {
+        std::vector<Layer*> layers;
+        root->traverseInReverseZOrder(LayerVector::StateSet::Drawing,
+                                      [&](Layer* layer) { layers.push_back(layer); });
+        return layers;
+    }
+
+    TestableSurfaceFlinger mFlinger;
+};
+
+TEST_F(LayerTraversalTest, ReorderedChildrenAreTraversedInNewOrder) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> firstLayer = createEffectLayer();
+    sp<EffectLayer> secondLayer = createEffectLayer();
+    firstLayer->setLayer(1);
+    secondLayer->setLayer(2);
+    rootLayer->addChild(firstLayer);
+    rootLayer->addChild(secondLayer);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer),
+                ElementsAre(rootLayer.get(), firstLayer.get(), secondLayer.get()));
+    // Traversing again goes through the cached list.
+    EXPECT_THAT(traverse(rootLayer),
+                ElementsAre(rootLayer.get(), firstLayer.get(), secondLayer.get()));
+
+    rootLayer->setChildLayer(secondLayer, 0);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer),
+                ElementsAre(rootLayer.get(), secondLayer.get(), firstLayer.get()));
+    EXPECT_THAT(traverseInReverse(rootLayer),
+                ElementsAre(firstLayer.get(), secondLayer.get(), rootLayer.get()));
+}
+
+TEST_F(LayerTraversalTest, NegativeChildrenAreTraversedBeforeParent) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> childLayer = createEffectLayer();
+    rootLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer), ElementsAre(rootLayer.get(), childLayer.get()));
+
+    rootLayer->setChildLayer(childLayer, -1);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer), ElementsAre(childLayer.get(), rootLayer.get()));
+    EXPECT_THAT(traverseInReverse(rootLayer), ElementsAre(rootLayer.get(), childLayer.get()));
+}
+
+TEST_F(LayerTraversalTest, RemovedChildIsNotTraversed) {
+    sp<EffectLayer> rootLayer = createEffectLayer();
+    sp<EffectLayer> childLayer = createEffectLayer();
+    rootLayer->addChild(childLayer);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer), ElementsAre(rootLayer.get(), childLayer.get()));
+
+    rootLayer->removeChild(childLayer);
+    rootLayer->commitChildList();
+    EXPECT_THAT(traverse(rootLayer), ElementsAre(rootLayer.get()));
+}
+
+} // namespace android
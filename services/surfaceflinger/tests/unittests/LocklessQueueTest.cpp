@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerUnittests"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "LocklessQueue.h"
+
+namespace android {
+namespace {
+
+TEST(LocklessQueueTest, drainsInPushOrder) {
+    LocklessQueue<int> queue;
+    EXPECT_TRUE(queue.isEmpty());
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    EXPECT_FALSE(queue.isEmpty());
+
+    std::vector<int> drained;
+    queue.drain([&](int&& value) { drained.push_back(value); });
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), drained);
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(LocklessQueueTest, movesValues) {
+    LocklessQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(7));
+
+    std::unique_ptr<int> drained;
+    queue.drain([&](std::unique_ptr<int>&& value) { drained = std::move(value); });
+    ASSERT_NE(nullptr, drained);
+    EXPECT_EQ(7, *drained);
+}
+
+TEST(LocklessQueueTest, keepsOrderOfEachProducer) {
+    constexpr int kProducers = 4;
+    constexpr int kValuesPerProducer = 10000;
+    LocklessQueue<std::pair<int, int>> queue;
+
+    std::vector<int> next(kProducers, 0);
+    bool ordered = true;
+    const auto consume = [&](std::pair<int, int>&& value) {
+        ordered &= value.second == next[value.first]++;
+    };
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; producer++) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push({producer, i});
+            }
+        });
+    }
+    while (std::any_of(next.begin(), next.end(),
+                       [](int count) { return count < kValuesPerProducer; }) &&
+           ordered) {
+        queue.drain(consume);
+    }
+    for (std::thread& thread : producers) {
+        thread.join();
+    }
+    queue.drain(consume);
+
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(std::vector<int>(kProducers, kValuesPerProducer), next);
+}
+
+} // namespace
+} // namespace android
@@ -44,6 +44,9 @@ public:
     ~TestableMessageQueue() override = default;
 
     void initHandler(const sp<MockHandler>& handler) { mHandler = handler; }
+    void initLooper() { mLooper = new Looper(true); }
+    void pollMessages() { mLooper->pollOnce(0); }
+    void finishFrame() { impl::MessageQueue::finishFrame(0); }
 
     void triggerVsyncCallback(nsecs_t vsyncTime, nsecs_t targetWakeupTime, nsecs_t readyTime) {
         vsyncCallback(vsyncTime, targetWakeupTime, readyTime);
@@ -174,5 +177,32 @@ TEST_F(MessageQueueTest, invalidateWithDurationChange) {
     EXPECT_NO_FATAL_FAILURE(mEventQueue.invalidate());
 }
 
+TEST_F(MessageQueueTest, postDeferredMessageWithoutFrameDue) {
+    mEventQueue.initLooper();
+
+    bool handled = false;
+    auto [task, future] = makeTask([&handled] { handled = true; });
+    mEventQueue.postDeferredMessage(std::move(task));
+    mEventQueue.pollMessages();
+    EXPECT_TRUE(handled);
+}
+
+TEST_F(MessageQueueTest, postDeferredMessageWaitsForFrameDue) {
+    mEventQueue.initLooper();
+
+    EXPECT_CALL(mVSyncDispatch, schedule(mCallbackToken, _)).WillOnce(Return(systemTime()));
+    EXPECT_NO_FATAL_FAILURE(mEventQueue.invalidate());
+
+    bool handled = false;
+    auto [task, future] = makeTask([&handled] { handled = true; });
+    mEventQueue.postDeferredMessage(std::move(task));
+    mEventQueue.pollMessages();
+    EXPECT_FALSE(handled);
+
+    mEventQueue.finishFrame();
+    mEventQueue.pollMessages();
+    EXPECT_TRUE(handled);
+}
+
 } // namespace
 } // namespace android
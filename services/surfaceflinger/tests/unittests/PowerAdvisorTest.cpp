@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "PowerAdvisorTest"
+
+#include <chrono>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "DisplayHardware/PowerAdvisor.h"
+#include "TestableSurfaceFlinger.h"
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr uint32_t kUclampMin = 100;
+constexpr uint32_t kUclampBoost = 500;
+constexpr nsecs_t kTargetDuration = std::chrono::nanoseconds(10ms).count();
+
+// No thread ids are given to the advisor, so only its boost state changes and no thread is
+// touched. It isn't told that boot finished, so it never reaches the power HAL either.
+class PowerAdvisorTest : public testing::Test {
+protected:
+    PowerAdvisorTest() { mPowerAdvisor.setTargetWorkDuration(kTargetDuration); }
+
+    void sendFrame(int percentOfTarget) {
+        mPowerAdvisor.sendActualWorkDuration(kTargetDuration * percentOfTarget / 100, 0);
+    }
+
+    TestableSurfaceFlinger mFlinger;
+    Hwc2::impl::PowerAdvisor mPowerAdvisor{*mFlinger.flinger(), kUclampMin, kUclampBoost};
+};
+
+TEST_F(PowerAdvisorTest, usesAdaptiveUclampOnlyWithBoostAboveFloor) {
+    EXPECT_TRUE(mPowerAdvisor.useAdaptiveUclamp());
+    Hwc2::impl::PowerAdvisor withoutBoost(*mFlinger.flinger(), kUclampMin, kUclampMin);
+    EXPECT_FALSE(withoutBoost.useAdaptiveUclamp());
+
+    withoutBoost.setTargetWorkDuration(kTargetDuration);
+    withoutBoost.sendActualWorkDuration(kTargetDuration, 0);
+    EXPECT_FALSE(withoutBoost.isUclampBoosted());
+}
+
+TEST_F(PowerAdvisorTest, boostsAtNinetyPercentOfTarget) {
+    sendFrame(89);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+    sendFrame(90);
+    EXPECT_TRUE(mPowerAdvisor.isUclampBoosted());
+}
+
+TEST_F(PowerAdvisorTest, unboostsAfterTenFramesWithHeadroom) {
+    sendFrame(120);
+    ASSERT_TRUE(mPowerAdvisor.isUclampBoosted());
+
+    for (int i = 0; i < 9; i++) {
+        sendFrame(50);
+        EXPECT_TRUE(mPowerAdvisor.isUclampBoosted()) << "frame " << i;
+    }
+    sendFrame(50);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+}
+
+TEST_F(PowerAdvisorTest, framesWithoutHeadroomRestartTheCount) {
+    sendFrame(95);
+    ASSERT_TRUE(mPowerAdvisor.isUclampBoosted());
+
+    for (int i = 0; i < 9; i++) {
+        sendFrame(59);
+    }
+    // Between 60% and 90%, the boost is kept and the frames with headroom are counted again.
+    sendFrame(60);
+    for (int i = 0; i < 9; i++) {
+        sendFrame(10);
+    }
+    EXPECT_TRUE(mPowerAdvisor.isUclampBoosted());
+    sendFrame(10);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+
+    // A late frame restarts the count too.
+    sendFrame(90);
+    for (int i = 0; i < 9; i++) {
+        sendFrame(10);
+    }
+    sendFrame(100);
+    for (int i = 0; i < 9; i++) {
+        sendFrame(10);
+    }
+    EXPECT_TRUE(mPowerAdvisor.isUclampBoosted());
+}
+
+TEST_F(PowerAdvisorTest, displayOffEndsBoostUntilDisplayOn) {
+    sendFrame(100);
+    ASSERT_TRUE(mPowerAdvisor.isUclampBoosted());
+
+    mPowerAdvisor.setUclampFloorEnabled(false);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+    sendFrame(100);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+
+    mPowerAdvisor.setUclampFloorEnabled(true);
+    EXPECT_FALSE(mPowerAdvisor.isUclampBoosted());
+    sendFrame(100);
+    EXPECT_TRUE(mPowerAdvisor.isUclampBoosted());
+}
+
+} // namespace
+} // namespace android
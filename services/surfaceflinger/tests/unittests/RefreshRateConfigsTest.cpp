@@ -81,14 +81,24 @@ protected:
     void setLastBestRefreshRateInvocation(RefreshRateConfigs& refreshRateConfigs,
                                           const GetBestRefreshRateInvocation& invocation) {
         std::lock_guard lock(refreshRateConfigs.mLock);
-        refreshRateConfigs.lastBestRefreshRateInvocation.emplace(
+        refreshRateConfigs.cacheBestRefreshRateInvocation(
+                RefreshRateConfigs::hashBestRefreshRateInputs(invocation.layerRequirements,
+                                                              invocation.globalSignals),
                 GetBestRefreshRateInvocation(invocation));
     }
 
     std::optional<GetBestRefreshRateInvocation> getLastBestRefreshRateInvocation(
             const RefreshRateConfigs& refreshRateConfigs) {
         std::lock_guard lock(refreshRateConfigs.mLock);
-        return refreshRateConfigs.lastBestRefreshRateInvocation;
+        if (refreshRateConfigs.mBestRefreshRateInvocations.empty()) {
+            return {};
+        }
+        return refreshRateConfigs.mBestRefreshRateInvocations.front().invocation;
+    }
+
+    size_t getCachedBestRefreshRateInvocationCount(const RefreshRateConfigs& refreshRateConfigs) {
+        std::lock_guard lock(refreshRateConfigs.mLock);
+        return refreshRateConfigs.mBestRefreshRateInvocations.size();
     }
 
     // Test config IDs
@@ -233,6 +243,19 @@ TEST_F(RefreshRateConfigsTest, twoDeviceConfigs_storesFullRefreshRateMap) {
     ASSERT_EQ(performanceRateByPolicy, performanceRate);
 }
 
+TEST_F(RefreshRateConfigsTest, getSupportedRefreshRates) {
+    auto refreshRateConfigs =
+            std::make_unique<RefreshRateConfigs>(m60_90_72_120Device,
+                                                 /*currentConfigId=*/HWC_CONFIG_ID_60);
+
+    std::vector<int> refreshRates;
+    for (const Fps& fps : refreshRateConfigs->getSupportedRefreshRates()) {
+        refreshRates.push_back(fps.getIntValue());
+    }
+    std::sort(refreshRates.begin(), refreshRates.end());
+    EXPECT_EQ((std::vector<int>{60, 72, 90, 120}), refreshRates);
+}
+
 TEST_F(RefreshRateConfigsTest, twoDeviceConfigs_storesFullRefreshRateMap_differentGroups) {
     auto refreshRateConfigs =
             std::make_unique<RefreshRateConfigs>(m60_90DeviceWithDifferentGroups,
@@ -2003,6 +2026,54 @@ TEST_F(RefreshRateConfigsTest, getBestRefreshRate_WritesCache) {
     ASSERT_FALSE(detaultSignals == lastInvocation->outSignalsConsidered);
 }
 
+TEST_F(RefreshRateConfigsTest, getBestRefreshRate_ReadsCacheOfAlternatingInputs) {
+    using GlobalSignals = RefreshRateConfigs::GlobalSignals;
+
+    auto refreshRateConfigs =
+            std::make_unique<RefreshRateConfigs>(m30_60_72_90_120Device,
+                                                 /*currentConfigId=*/HWC_CONFIG_ID_60);
+
+    const GlobalSignals globalSignals{.touch = false, .idle = false};
+    const auto videoLayers = std::vector<LayerRequirement>{
+            {.name = "Video", .vote = LayerVoteType::ExplicitExactOrMultiple,
+             .desiredRefreshRate = Fps(30.0f), .weight = 1.0f}};
+    const auto controlsLayers = std::vector<LayerRequirement>{
+            {.name = "Video", .vote = LayerVoteType::ExplicitExactOrMultiple,
+             .desiredRefreshRate = Fps(30.0f), .weight = 1.0f},
+            {.name = "Controls", .vote = LayerVoteType::Max, .weight = 0.1f}};
+
+    refreshRateConfigs->getBestRefreshRate(videoLayers, globalSignals);
+    const auto controlsResult =
+            refreshRateConfigs->getBestRefreshRate(controlsLayers, globalSignals);
+    EXPECT_EQ(2u, getCachedBestRefreshRateInvocationCount(*refreshRateConfigs));
+
+    // Cache a different result for the video layers to check that the cache is read, and that
+    // reading an older entry makes it the most recently used one.
+    setLastBestRefreshRateInvocation(*refreshRateConfigs,
+                                     GetBestRefreshRateInvocation{.layerRequirements = videoLayers,
+                                                                  .globalSignals = globalSignals,
+                                                                  .resultingBestRefreshRate =
+                                                                          createRefreshRate(
+                                                                                  mConfig72)});
+    EXPECT_EQ(createRefreshRate(mConfig72),
+              refreshRateConfigs->getBestRefreshRate(videoLayers, globalSignals));
+    EXPECT_EQ(controlsResult,
+              refreshRateConfigs->getBestRefreshRate(controlsLayers, globalSignals));
+    EXPECT_EQ(controlsLayers,
+              getLastBestRefreshRateInvocation(*refreshRateConfigs)->layerRequirements);
+
+    // Only a change of policy invalidates the cache.
+    EXPECT_EQ(RefreshRateConfigs::CURRENT_POLICY_UNCHANGED,
+              refreshRateConfigs->setDisplayManagerPolicy(
+                      refreshRateConfigs->getDisplayManagerPolicy()));
+    EXPECT_NE(0u, getCachedBestRefreshRateInvocationCount(*refreshRateConfigs));
+
+    ASSERT_GE(refreshRateConfigs->setDisplayManagerPolicy(
+                      {HWC_CONFIG_ID_60, {Fps(60.0f), Fps(60.0f)}}),
+              0);
+    EXPECT_EQ(0u, getCachedBestRefreshRateInvocationCount(*refreshRateConfigs));
+}
+
 TEST_F(RefreshRateConfigsTest, getBestRefreshRate_ExplicitExactTouchBoost) {
     RefreshRateConfigs::Config config = {.enableFrameRateOverride = true};
     auto refreshRateConfigs =
@@ -140,6 +140,16 @@ TEST_F(RegionSamplingTest, orientation_90) {
                 testing::Eq(1.0));
 }
 
+TEST_F(RegionSamplingTest, scale_sample_area) {
+    const ui::Size scaledSize(10, 5);
+
+    EXPECT_EQ(Rect(0, 0, 10, 5), scaleSampleArea(Rect(0, 0, 100, 50), 0.1f, scaledSize));
+    // Partially covered pixels are sampled, and the area is clipped to the scaled buffer
+    EXPECT_EQ(Rect(1, 1, 3, 5), scaleSampleArea(Rect(15, 15, 25, 60), 0.1f, scaledSize));
+    // An area that scales down to nothing still samples a pixel
+    EXPECT_EQ(Rect(2, 2, 3, 3), scaleSampleArea(Rect(20, 20, 20, 20), 0.1f, scaledSize));
+}
+
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SchedulerUnittests"
+
+#include <gtest/gtest.h>
+
+#include "Scheduler/RingBuffer.h"
+
+namespace android::scheduler {
+namespace {
+
+TEST(RingBufferTest, pushesUntilFull) {
+    RingBuffer<int, 3> buffer;
+    EXPECT_TRUE(buffer.empty());
+
+    buffer.push_back(1);
+    buffer.push_back(2);
+    ASSERT_EQ(2u, buffer.size());
+    EXPECT_EQ(1, buffer.front());
+    EXPECT_EQ(2, buffer.back());
+    EXPECT_EQ(2, buffer[1]);
+}
+
+TEST(RingBufferTest, dropsOldestWhenFull) {
+    RingBuffer<int, 3> buffer;
+    for (int i = 1; i <= 5; i++) {
+        buffer.push_back(i);
+    }
+
+    ASSERT_EQ(3u, buffer.size());
+    EXPECT_EQ(3, buffer[0]);
+    EXPECT_EQ(4, buffer[1]);
+    EXPECT_EQ(5, buffer[2]);
+    EXPECT_EQ(3, buffer.front());
+    EXPECT_EQ(5, buffer.back());
+}
+
+TEST(RingBufferTest, clear) {
+    RingBuffer<int, 3> buffer;
+    for (int i = 1; i <= 4; i++) {
+        buffer.push_back(i);
+    }
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+
+    buffer.push_back(7);
+    ASSERT_EQ(1u, buffer.size());
+    EXPECT_EQ(7, buffer.front());
+    EXPECT_EQ(7, buffer.back());
+}
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerUnittests"
+
+#include <android/os/BnInputFlinger.h>
+#include <binder/Binder.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "TestableSurfaceFlinger.h"
+
+namespace android {
+namespace {
+
+using testing::_;
+using testing::ElementsAre;
+using testing::Return;
+
+class MockInputFlinger : public os::BnInputFlinger {
+public:
+    MOCK_METHOD(binder::Status, setInputWindows,
+                (const std::vector<InputWindowInfo>&, const sp<os::ISetInputWindowsListener>&),
+                (override));
+    MOCK_METHOD(binder::Status, updateInputWindows,
+                (const std::vector<InputWindowInfo>&, const std::vector<int32_t>&,
+                 const sp<os::ISetInputWindowsListener>&),
+                (override));
+    MOCK_METHOD(binder::Status, createInputChannel, (const std::string&, InputChannel*),
+                (override));
+    MOCK_METHOD(binder::Status, removeInputChannel, (const sp<IBinder>&), (override));
+    MOCK_METHOD(binder::Status, setFocusedWindow, (const FocusRequest&), (override));
+};
+
+MATCHER_P(InputWindowInfoIdIs, id, "") {
+    return arg.id == id;
+}
+
+class SendInputWindowInfosTest : public testing::Test {
+protected:
+    SendInputWindowInfosTest() {
+        mFlinger.mutableInputFlinger() = mInputFlinger;
+
+        for (int32_t id = 1; id <= 4; id++) {
+            InputWindowInfo info;
+            info.id = id;
+            info.name = "Window " + std::to_string(id);
+            info.alpha = 1.0f;
+            info.touchableRegionCropHandle = mCropHandle;
+            mInfos.push_back(info);
+        }
+
+        // The first windows sent can't be compared with previous ones.
+        EXPECT_CALL(*mInputFlinger, setInputWindows(_, _)).WillOnce(Return(binder::Status::ok()));
+        mFlinger.sendInputWindowInfos(mInfos);
+    }
+
+    void expectOnlyWindowSent(int32_t id) {
+        EXPECT_CALL(*mInputFlinger, setInputWindows(_, _)).Times(0);
+        EXPECT_CALL(*mInputFlinger,
+                    updateInputWindows(ElementsAre(InputWindowInfoIdIs(id)),
+                                       ElementsAre(1, 2, 3, 4), _))
+                .WillOnce(Return(binder::Status::ok()));
+    }
+
+    TestableSurfaceFlinger mFlinger;
+    sp<MockInputFlinger> mInputFlinger = new MockInputFlinger();
+    sp<IBinder> mCropHandle = new BBinder();
+    std::vector<InputWindowInfo> mInfos;
+};
+
+TEST_F(SendInputWindowInfosTest, sendsNothingChangedWhenWindowsAreTheSame) {
+    EXPECT_CALL(*mInputFlinger, setInputWindows(_, _)).Times(0);
+    EXPECT_CALL(*mInputFlinger, updateInputWindows(testing::IsEmpty(), ElementsAre(1, 2, 3, 4), _))
+            .WillOnce(Return(binder::Status::ok()));
+    mFlinger.sendInputWindowInfos(mInfos);
+}
+
+TEST_F(SendInputWindowInfosTest, sendsWindowWhoseAlphaChanged) {
+    mInfos[1].alpha = 0.5f;
+    expectOnlyWindowSent(2);
+    mFlinger.sendInputWindowInfos(mInfos);
+}
+
+TEST_F(SendInputWindowInfosTest, sendsWindowWhoseTouchableRegionCropChanged) {
+    sp<IBinder> otherCropHandle = new BBinder();
+    mInfos[2].touchableRegionCropHandle = otherCropHandle;
+    expectOnlyWindowSent(3);
+    mFlinger.sendInputWindowInfos(mInfos);
+}
+
+} // namespace
+} // namespace android
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SurfaceInterceptorTest"
+
+#include <binder/Binder.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "DisplayDevice.h"
+#include "Layer.h"
+#include "SurfaceInterceptor.h"
+
+namespace android {
+namespace {
+
+// The state of the displays after replaying a trace: the last change of each kind, and the last
+// power mode, by display id.
+using ReplayedDisplays = std::map<int32_t, std::map<int, std::string>>;
+
+constexpr int kPowerModeKey = -1;
+
+ReplayedDisplays replay(const Trace& trace) {
+    ReplayedDisplays displays;
+    for (const auto& increment : trace.increment()) {
+        switch (increment.increment_case()) {
+            case Increment::kDisplayCreation:
+                displays[increment.display_creation().id()].clear();
+                break;
+            case Increment::kDisplayDeletion:
+                displays.erase(increment.display_deletion().id());
+                break;
+            case Increment::kTransaction:
+                for (const auto& change : increment.transaction().display_change()) {
+                    // Changes to displays that aren't created yet would block the replayer.
+                    EXPECT_TRUE(displays.count(change.id())) << "display " << change.id();
+                    displays[change.id()][change.DisplayChange_case()] =
+                            change.SerializeAsString();
+                }
+                break;
+            case Increment::kPowerModeUpdate: {
+                const auto& update = increment.power_mode_update();
+                EXPECT_TRUE(displays.count(update.id())) << "display " << update.id();
+                displays[update.id()][kPowerModeKey] = std::to_string(update.mode());
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return displays;
+}
+
+class SurfaceInterceptorTest : public testing::Test {
+protected:
+    static constexpr size_t kMaxTraceSize = 4096;
+
+    SurfaceInterceptorTest() {
+        for (uint32_t i = 0; i < 2; i++) {
+            DisplayDeviceState state;
+            state.layerStack = i;
+            state.width = 1080;
+            state.height = 1920;
+            state.displayName = "Display " + std::to_string(i);
+            mTokens.push_back(new BBinder());
+            mDisplays.add(mTokens.back(), state);
+        }
+    }
+
+    void enable(impl::SurfaceInterceptor& interceptor) { interceptor.enable({}, mDisplays); }
+
+    // Records count transactions changing the displays, each followed by a vsync event.
+    void recordIncrements(int count) {
+        for (int i = 0; i < count; i++) {
+            const int sequence = mSequence++;
+            Vector<DisplayState> changes;
+            DisplayState change;
+            change.token = mTokens[sequence % 2];
+            change.what = DisplayState::eLayerStackChanged;
+            change.layerStack = static_cast<uint32_t>(sequence);
+            if (sequence % 7 == 0) {
+                change.what |= DisplayState::eDisplaySizeChanged;
+                change.width = static_cast<uint32_t>(sequence);
+                change.height = static_cast<uint32_t>(sequence * 2);
+            }
+            changes.add(change);
+            for (auto* interceptor : {&mFullInterceptor, &mBoundedInterceptor}) {
+                interceptor->saveTransaction({}, mDisplays, changes, 0, 0, 0, sequence);
+                interceptor->saveVSyncEvent(sequence);
+                if (sequence % 11 == 0) {
+                    interceptor->savePowerModeUpdate(mDisplays.valueAt(sequence % 2).sequenceId,
+                                                     sequence % 4);
+                }
+            }
+        }
+    }
+
+    void expectSameReplay() {
+        const Trace fullTrace = mFullInterceptor.getTraceForTest();
+        const Trace boundedTrace = mBoundedInterceptor.getTraceForTest();
+        ASSERT_LT(boundedTrace.ByteSizeLong(), fullTrace.ByteSizeLong() / 4);
+        EXPECT_EQ(replay(fullTrace), replay(boundedTrace));
+    }
+
+    impl::SurfaceInterceptor mFullInterceptor;
+    impl::SurfaceInterceptor mBoundedInterceptor;
+    std::vector<sp<IBinder>> mTokens;
+    DefaultKeyedVector<wp<IBinder>, DisplayDeviceState> mDisplays;
+    int mSequence = 0;
+};
+
+TEST_F(SurfaceInterceptorTest, boundedTraceReplaysToTheSameDisplayState) {
+    mBoundedInterceptor.setMaxTraceSize(kMaxTraceSize);
+    enable(mFullInterceptor);
+    enable(mBoundedInterceptor);
+
+    recordIncrements(2000);
+
+    expectSameReplay();
+}
+
+TEST_F(SurfaceInterceptorTest, boundedTraceKeepsDisplaysCreatedAndDropsDeletedOnes) {
+    mBoundedInterceptor.setMaxTraceSize(kMaxTraceSize);
+    enable(mFullInterceptor);
+    enable(mBoundedInterceptor);
+
+    DisplayDeviceState created;
+    created.displayName = "Created";
+    DisplayDeviceState deleted;
+    deleted.displayName = "Deleted";
+    for (auto* interceptor : {&mFullInterceptor, &mBoundedInterceptor}) {
+        interceptor->saveDisplayCreation(created);
+        interceptor->saveDisplayCreation(deleted);
+        interceptor->savePowerModeUpdate(created.sequenceId, 2);
+    }
+    recordIncrements(1000);
+    for (auto* interceptor : {&mFullInterceptor, &mBoundedInterceptor}) {
+        interceptor->saveDisplayDeletion(deleted.sequenceId);
+    }
+    recordIncrements(1000);
+
+    expectSameReplay();
+    const auto displays = replay(mBoundedInterceptor.getTraceForTest());
+    EXPECT_EQ(1u, displays.count(created.sequenceId));
+    EXPECT_EQ(0u, displays.count(deleted.sequenceId));
+}
+
+TEST_F(SurfaceInterceptorTest, limitingTraceWhileTracingReplaysToTheSameDisplayState) {
+    enable(mFullInterceptor);
+    enable(mBoundedInterceptor);
+    recordIncrements(1000);
+
+    mBoundedInterceptor.setMaxTraceSize(kMaxTraceSize);
+    recordIncrements(1000);
+
+    expectSameReplay();
+}
+
+} // namespace
+} // namespace android
@@ -181,6 +181,7 @@ public:
 class TestableSurfaceFlinger final : private ISchedulerCallback {
 public:
     using HotplugEvent = SurfaceFlinger::HotplugEvent;
+    using TransactionState = SurfaceFlinger::TransactionState;
 
     SurfaceFlinger* flinger() { return mFlinger.get(); }
     TestableScheduler* scheduler() { return mScheduler; }
@@ -351,10 +352,21 @@ public:
                                 SurfaceFlinger::TraverseLayersFunction traverseLayers,
                                 const std::shared_ptr<renderengine::ExternalTexture>& buffer,
                                 bool forSystem, bool regionSampling) {
-        ScreenCaptureResults captureResults;
         return mFlinger->renderScreenImplLocked(renderArea, traverseLayers, buffer, forSystem,
                                                 regionSampling, false /* grayscale */,
-                                                captureResults);
+                                                nullptr /* captureListener */);
+    }
+
+    auto isReadbackExact(const RenderArea& renderArea, const mat4& colorTransform) {
+        return mFlinger->isReadbackExact(renderArea, colorTransform);
+    }
+
+    auto setReadbackBuffers(const compositionengine::CompositionRefreshArgs& refreshArgs) {
+        return mFlinger->setReadbackBuffers(refreshArgs);
+    }
+
+    auto sendInputWindowInfos(const std::vector<InputWindowInfo>& inputInfos) {
+        return mFlinger->sendInputWindowInfos(inputInfos);
     }
 
     auto traverseLayersInLayerStack(ui::LayerStack layerStack, int32_t uid,
@@ -367,7 +379,10 @@ public:
         return mFlinger->SurfaceFlinger::getDisplayNativePrimaries(displayToken, primaries);
     }
 
-    auto& getTransactionQueue() { return mFlinger->mTransactionQueue; }
+    auto& getTransactionQueue() {
+        mFlinger->collectIncomingTransactions();
+        return mFlinger->mTransactionQueue;
+    }
     auto& getPendingTransactionQueue() { return mFlinger->mPendingTransactionQueues; }
 
     auto setTransactionState(
@@ -384,6 +399,10 @@ public:
 
     auto flushTransactionQueues() { return mFlinger->flushTransactionQueues(); };
 
+    static void coalesceTransactions(std::vector<TransactionState>& transactions) {
+        SurfaceFlinger::coalesceTransactions(transactions);
+    }
+
     auto onTransact(uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags) {
         return mFlinger->onTransact(code, data, reply, flags);
     }
@@ -427,9 +446,11 @@ public:
     auto& mutableDrawingState() { return mFlinger->mDrawingState; }
     auto& mutableEventQueue() { return mFlinger->mEventQueue; }
     auto& mutableGeometryInvalid() { return mFlinger->mGeometryInvalid; }
+    auto& mutableInputFlinger() { return mFlinger->mInputFlinger; }
     auto& mutableInterceptor() { return mFlinger->mInterceptor; }
     auto& mutableMainThreadId() { return mFlinger->mMainThreadId; }
     auto& mutablePendingHotplugEvents() { return mFlinger->mPendingHotplugEvents; }
+    auto& mutablePendingReadbacks() { return mFlinger->mPendingReadbacks; }
     auto& mutablePhysicalDisplayTokens() { return mFlinger->mPhysicalDisplayTokens; }
     auto& mutableTexturePool() { return mFlinger->mTexturePool; }
     auto& mutableTransactionFlags() { return mFlinger->mTransactionFlags; }
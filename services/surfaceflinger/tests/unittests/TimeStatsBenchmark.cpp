@@ -0,0 +1,72 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+#include "TimeStats/TimeStats.h"
+
+namespace android {
+namespace {
+
+constexpr nsecs_t kFramePeriod = 16'666'667;
+constexpr int32_t kGameMode = TimeStatsHelper::GameModeUnsupported;
+
+impl::TimeStats& enabledTimeStats() {
+    static impl::TimeStats* const timeStats = [] {
+        auto* timeStats = new impl::TimeStats();
+        Vector<String16> args;
+        args.push_back(String16("-enable"));
+        std::string result;
+        timeStats->parseArgs(/*asProto*/ false, args, result);
+        return timeStats;
+    }();
+    return *timeStats;
+}
+
+// The per-buffer calls that a layer makes into TimeStats, with each benchmark thread driving its
+// own layer, as the main thread and binder threads do for different layers.
+void BM_recordLayerFrames(benchmark::State& state) {
+    impl::TimeStats& timeStats = enabledTimeStats();
+
+    const int32_t layerId = state.thread_index;
+    const std::string layerName = "com.example.benchmark/Layer#" + std::to_string(layerId);
+    const Fps refreshRate = Fps::fromPeriodNsecs(kFramePeriod);
+
+    uint64_t frameNumber = 0;
+    nsecs_t time = 0;
+    for (auto _ : state) {
+        frameNumber++;
+        time += kFramePeriod;
+        timeStats.setPostTime(layerId, frameNumber, layerName, /*uid*/ 0, time, kGameMode);
+        timeStats.setDesiredTime(layerId, frameNumber, time);
+        timeStats.setAcquireTime(layerId, frameNumber, time + 1'000'000);
+        timeStats.setLatchTime(layerId, frameNumber, time + 2'000'000);
+        timeStats.setPresentTime(layerId, frameNumber, time + kFramePeriod, refreshRate,
+                                 std::nullopt, {}, kGameMode);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    timeStats.onDestroy(layerId);
+}
+BENCHMARK(BM_recordLayerFrames)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+} // namespace android
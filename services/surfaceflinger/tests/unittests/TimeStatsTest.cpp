@@ -32,6 +32,7 @@
 
 #include <chrono>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 #include "libsurfaceflinger_unittest_main.h"
@@ -683,6 +684,34 @@ TEST_F(TimeStatsTest, canInsertMultipleLayersTimeStats) {
     EXPECT_EQ(2, globalProto.stats_size());
 }
 
+TEST_F(TimeStatsTest, canInsertLayerTimeStatsFromMultipleThreads) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    constexpr int32_t kNumLayers = 16;
+    constexpr int32_t kNumFrames = 50;
+    std::vector<std::thread> threads;
+    for (int32_t id = 0; id < kNumLayers; id++) {
+        threads.emplace_back([this, id] {
+            for (int32_t frameNumber = 1; frameNumber <= kNumFrames; frameNumber++) {
+                insertTimeRecord(NORMAL_SEQUENCE, id, frameNumber, frameNumber * 10000000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(kNumLayers, globalProto.stats_size());
+    for (const SFTimeStatsLayerProto& layerProto : globalProto.stats()) {
+        ASSERT_TRUE(layerProto.has_total_frames());
+        // The first frame of each layer only seeds the deltas.
+        EXPECT_EQ(kNumFrames - 1, layerProto.total_frames());
+    }
+}
+
 TEST_F(TimeStatsTest, canInsertUnorderedLayerTimeStats) {
     EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
 
@@ -330,4 +330,99 @@ TEST_F(TransactionApplicationTest, FromHandle) {
     auto ret = mFlinger.fromHandle(badHandle);
     EXPECT_EQ(nullptr, ret.promote().get());
 }
+
+class TransactionCoalescingTest : public testing::Test {
+protected:
+    using TransactionState = TestableSurfaceFlinger::TransactionState;
+
+    // Returns a transaction from mApplyToken which moves each given layer to x.
+    TransactionState makeTransaction(std::vector<std::pair<sp<IBinder>, float>> positions,
+                                     const FrameTimelineInfo& frameTimelineInfo = {}) {
+        Vector<ComposerState> states;
+        for (const auto& [surface, x] : positions) {
+            ComposerState state;
+            state.state.surface = surface;
+            state.state.what = layer_state_t::ePositionChanged;
+            state.state.x = x;
+            states.add(state);
+        }
+        return TransactionState(frameTimelineInfo, states, /*displayStates*/ {}, /*flags*/ 0,
+                                mApplyToken, InputWindowCommands{}, /*desiredPresentTime*/ 0,
+                                /*isAutoTimestamp*/ true, client_cache_t{}, /*postTime*/ 0,
+                                /*permissions*/ 0, /*hasListenerCallbacks*/ false,
+                                /*listenerCallbacks*/ {}, /*originPid*/ 0, /*originUid*/ 0,
+                                mNextId++);
+    }
+
+    static void expectStates(const TransactionState& transaction,
+                             std::vector<std::pair<sp<IBinder>, float>> positions) {
+        ASSERT_EQ(positions.size(), transaction.states.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            EXPECT_EQ(positions[i].first, transaction.states[i].state.surface) << "state " << i;
+            EXPECT_EQ(positions[i].second, transaction.states[i].state.x) << "state " << i;
+        }
+    }
+
+    sp<IBinder> mApplyToken = new BBinder();
+    sp<IBinder> mLayerA = new BBinder();
+    sp<IBinder> mLayerB = new BBinder();
+    uint64_t mNextId = 0;
+};
+
+TEST_F(TransactionCoalescingTest, MergesStatesOfTheSameLayer) {
+    std::vector<TransactionState> transactions;
+    transactions.emplace_back(makeTransaction({{mLayerA, 1}}));
+    transactions.emplace_back(makeTransaction({{mLayerA, 2}}));
+    transactions.emplace_back(makeTransaction({{mLayerA, 3}, {mLayerB, 4}}));
+
+    TestableSurfaceFlinger::coalesceTransactions(transactions);
+
+    ASSERT_EQ(1u, transactions.size());
+    expectStates(transactions[0], {{mLayerA, 3}, {mLayerB, 4}});
+}
+
+TEST_F(TransactionCoalescingTest, KeepsTheOrderOfStates) {
+    std::vector<TransactionState> transactions;
+    transactions.emplace_back(makeTransaction({{mLayerA, 1}, {mLayerB, 2}}));
+    transactions.emplace_back(makeTransaction({{mLayerA, 3}, {mLayerB, 4}}));
+
+    TestableSurfaceFlinger::coalesceTransactions(transactions);
+
+    // Merging the second state of A into the first would apply it before the first state of B.
+    ASSERT_EQ(1u, transactions.size());
+    expectStates(transactions[0], {{mLayerA, 1}, {mLayerB, 2}, {mLayerA, 3}, {mLayerB, 4}});
+}
+
+TEST_F(TransactionCoalescingTest, KeepsTransactionsWithFrameTimelineInfo) {
+    FrameTimelineInfo frameTimelineInfo;
+    frameTimelineInfo.vsyncId = 42;
+    std::vector<TransactionState> transactions;
+    transactions.emplace_back(makeTransaction({{mLayerA, 1}}, frameTimelineInfo));
+    transactions.emplace_back(makeTransaction({{mLayerA, 2}}, frameTimelineInfo));
+    transactions.emplace_back(makeTransaction({{mLayerA, 3}}));
+
+    TestableSurfaceFlinger::coalesceTransactions(transactions);
+
+    // Each gets its own surface frame when applied.
+    ASSERT_EQ(3u, transactions.size());
+    expectStates(transactions[0], {{mLayerA, 1}});
+    expectStates(transactions[1], {{mLayerA, 2}});
+    expectStates(transactions[2], {{mLayerA, 3}});
+}
+
+TEST_F(TransactionCoalescingTest, KeepsTransactionsFromOtherApplyTokens) {
+    std::vector<TransactionState> transactions;
+    transactions.emplace_back(makeTransaction({{mLayerA, 1}}));
+    transactions.emplace_back(makeTransaction({{mLayerA, 2}}));
+    transactions.back().applyToken = new BBinder();
+    transactions.emplace_back(makeTransaction({{mLayerA, 3}}));
+
+    TestableSurfaceFlinger::coalesceTransactions(transactions);
+
+    ASSERT_EQ(3u, transactions.size());
+    expectStates(transactions[0], {{mLayerA, 1}});
+    expectStates(transactions[1], {{mLayerA, 2}});
+    expectStates(transactions[2], {{mLayerA, 3}});
+}
+
 } // namespace android
@@ -921,6 +921,30 @@ TEST_F(VSyncDispatchTimerQueueTest, laggedTimerGroupsCallbacksWithinLag) {
     EXPECT_THAT(cb2.mReadyTime[0], Eq(1000));
 }
 
+TEST_F(VSyncDispatchTimerQueueTest, groupedCallbacksAreInvokedInDeadlineOrder) {
+    std::vector<std::string> invocationOrder;
+    const auto early = mDispatch.registerCallback(
+            [&](nsecs_t, nsecs_t, nsecs_t) { invocationOrder.push_back("early"); }, "early");
+    const auto tight = mDispatch.registerCallback(
+            [&](nsecs_t, nsecs_t, nsecs_t) { invocationOrder.push_back("tight"); }, "tight");
+
+    EXPECT_CALL(mMockClock, alarmAt(_, 600));
+
+    // "early" wakes up first but has until vsync, while "tight" wakes up within the group
+    // threshold and has to be ready well before vsync.
+    mDispatch.schedule(early, {.workDuration = 400, .readyDuration = 0, .earliestVsync = 1000});
+    mDispatch.schedule(tight,
+                       {.workDuration = 200,
+                        .readyDuration = 200 - mDispatchGroupThreshold + 1,
+                        .earliestVsync = 1000});
+
+    advanceToNextCallback();
+    EXPECT_THAT(invocationOrder, ElementsAre("tight", "early"));
+
+    mDispatch.unregisterCallback(early);
+    mDispatch.unregisterCallback(tight);
+}
+
 TEST_F(VSyncDispatchTimerQueueTest, basicAlarmSettingFutureWithReadyDuration) {
     auto intended = mPeriod - 230;
     EXPECT_CALL(mMockClock, alarmAt(_, 900));
@@ -1175,6 +1199,30 @@ TEST_F(VSyncDispatchTimerQueueEntryTest, storesPendingUpdatesUntilUpdate) {
     EXPECT_THAT(*entry.wakeupTime(), Eq(mPeriod - effectualOffset));
 }
 
+TEST_F(VSyncDispatchTimerQueueEntryTest, recordsDispatchLateness) {
+    VSyncDispatchTimerQueueEntry entry(
+            "test", [](auto, auto, auto) {}, mVsyncMoveThreshold);
+
+    entry.recordDispatch(100);
+    EXPECT_THAT(entry.dispatchStats().dispatchCount, Eq(0));
+
+    entry.schedule({.workDuration = 100, .readyDuration = 0, .earliestVsync = 500}, mStubTracker,
+                   0);
+    entry.recordDispatch(930);
+    entry.executing();
+
+    entry.schedule({.workDuration = 100, .readyDuration = 0, .earliestVsync = 1500}, mStubTracker,
+                   1000);
+    entry.recordDispatch(1890);
+    entry.executing();
+
+    const auto& stats = entry.dispatchStats();
+    EXPECT_THAT(stats.dispatchCount, Eq(2));
+    EXPECT_THAT(stats.coalescedCount, Eq(1));
+    EXPECT_THAT(stats.totalLateness, Eq(30));
+    EXPECT_THAT(stats.maxLateness, Eq(30));
+}
+
 TEST_F(VSyncDispatchTimerQueueEntryTest, runCallbackWithReadyDuration) {
     auto callCount = 0;
     auto vsyncCalledTime = 0;
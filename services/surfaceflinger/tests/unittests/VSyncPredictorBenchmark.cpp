@@ -0,0 +1,64 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "Scheduler/VSyncPredictor.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr nsecs_t kPeriod = 16'666'667;
+constexpr size_t kHistorySize = 20;
+constexpr size_t kMinimumSamplesForPrediction = 6;
+constexpr uint32_t kOutlierTolerancePercent = 25;
+
+// A 60Hz vsync with a repeating few hundred microseconds of jitter, as reported by HW vsync.
+std::vector<nsecs_t> generateJitteredVsyncs(size_t count) {
+    static constexpr nsecs_t kJitter[] = {0, 120'000, -80'000, 310'000, -250'000, 40'000};
+
+    std::vector<nsecs_t> vsyncs(count);
+    for (size_t i = 0; i < count; i++) {
+        vsyncs[i] = static_cast<nsecs_t>(i + 1) * kPeriod + kJitter[i % std::size(kJitter)];
+    }
+    return vsyncs;
+}
+
+// Cost of refitting the model on each HW vsync once the history is full.
+void BM_addVsyncTimestamp(benchmark::State& state) {
+    VSyncPredictor tracker(kPeriod, kHistorySize, kMinimumSamplesForPrediction,
+                           kOutlierTolerancePercent);
+
+    const auto vsyncs = generateJitteredVsyncs(kHistorySize);
+    for (const auto vsync : vsyncs) {
+        tracker.addVsyncTimestamp(vsync);
+    }
+
+    nsecs_t offset = 0;
+    for (auto _ : state) {
+        offset += kPeriod * static_cast<nsecs_t>(kHistorySize);
+        for (const auto vsync : vsyncs) {
+            benchmark::DoNotOptimize(tracker.addVsyncTimestamp(vsync + offset));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(vsyncs.size()));
+}
+BENCHMARK(BM_addVsyncTimestamp);
+
+} // namespace
+} // namespace android::scheduler
@@ -532,6 +532,22 @@ TEST_F(VSyncPredictorTest, robustToDuplicateTimestamps_60hzRealTraceData) {
     EXPECT_THAT(intercept, IsCloseTo(expectedIntercept, mMaxRoundingError));
 }
 
+TEST_F(VSyncPredictorTest, trimsSampleThatSkewsFitPastTolerance) {
+    // Every sample is in phase with the one before it, but 10127 snaps to an ordinal that pushes
+    // the fitted period past the tolerance. Dropping it keeps the rest of the history.
+    std::vector<nsecs_t> const simulatedVsyncs{
+            3202, 4349, 5140, 5967, 6774, 7743, 8968, 10127, 10973, 11926, 12866,
+    };
+
+    for (auto const& timestamp : simulatedVsyncs) {
+        EXPECT_TRUE(tracker.addVsyncTimestamp(timestamp));
+    }
+    EXPECT_FALSE(tracker.needsMoreSamples());
+
+    auto const [slope, intercept] = tracker.getVSyncPredictionModel();
+    EXPECT_THAT(slope, IsCloseTo(mPeriod, mPeriod * kOutlierTolerancePercent / 100));
+}
+
 } // namespace android::scheduler
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
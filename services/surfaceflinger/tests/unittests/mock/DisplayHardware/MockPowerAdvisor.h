@@ -32,6 +32,12 @@ public:
     MOCK_METHOD2(setExpensiveRenderingExpected, void(DisplayId displayId, bool expected));
     MOCK_METHOD0(isUsingExpensiveRendering, bool());
     MOCK_METHOD0(notifyDisplayUpdateImminent, void());
+    MOCK_METHOD0(usePowerHintSession, bool());
+    MOCK_METHOD0(useAdaptiveUclamp, bool());
+    MOCK_METHOD1(setUclampFloorEnabled, void(bool enabled));
+    MOCK_METHOD1(setPowerHintSessionThreadIds, void(const std::vector<int32_t>& threadIds));
+    MOCK_METHOD1(setTargetWorkDuration, void(nsecs_t targetDuration));
+    MOCK_METHOD2(sendActualWorkDuration, void(nsecs_t actualDuration, nsecs_t timestamp));
 };
 
 } // namespace android::Hwc2::mock
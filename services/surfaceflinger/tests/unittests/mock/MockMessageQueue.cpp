@@ -23,6 +23,9 @@ MessageQueue::MessageQueue() {
         // Execute task to prevent broken promise exception on destruction.
         handler->handleMessage(Message());
     });
+    ON_CALL(*this, postDeferredMessage).WillByDefault([](sp<MessageHandler>&& handler) {
+        handler->handleMessage(Message());
+    });
 }
 
 MessageQueue::~MessageQueue() = default;
@@ -32,6 +32,8 @@ public:
                       const DefaultKeyedVector<wp<IBinder>, DisplayDeviceState>&));
     MOCK_METHOD0(disable, void());
     MOCK_METHOD0(isEnabled, bool());
+    MOCK_METHOD1(setMaxTraceSize, void(size_t));
+    MOCK_METHOD0(writeTraceToFile, void());
     MOCK_METHOD1(addTransactionTraceListener, void(const sp<gui::ITransactionTraceListener>&));
     MOCK_METHOD1(binderDied, void(const wp<IBinder>&));
     MOCK_METHOD7(saveTransaction,
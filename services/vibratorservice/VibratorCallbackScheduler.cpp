@@ -14,9 +14,18 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "VibratorCallbackScheduler"
+
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <utils/Log.h>
+
 #include <vibratorservice/VibratorCallbackScheduler.h>
 
 namespace android {
@@ -47,30 +56,67 @@ bool DelayedCallback::operator>(const DelayedCallback& other) const {
 
 // -------------------------------------------------------------------------------------------------
 
+static itimerspec toTimerSpec(DelayedCallback::Timestamp expiration) {
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            expiration.time_since_epoch());
+    // A zero expiration would disarm the timer, and one in the past expires right away.
+    int64_t nanos = std::max<int64_t>(sinceEpoch.count(), 1);
+    itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(nanos / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(nanos % 1000000000);
+    return spec;
+}
+
+// -------------------------------------------------------------------------------------------------
+
 CallbackScheduler::~CallbackScheduler() {
     {
         std::lock_guard<std::mutex> lock(mMutex);
         mFinished = true;
+        if (mTimerFd >= 0) {
+            armTimerLocked();
+        }
     }
-    mCondition.notify_all();
     if (mCallbackThread && mCallbackThread->joinable()) {
         mCallbackThread->join();
     }
+    if (mTimerFd >= 0) {
+        close(mTimerFd);
+    }
 }
 
 void CallbackScheduler::schedule(std::function<void()> callback, std::chrono::milliseconds delay) {
-    {
-        std::lock_guard<std::mutex> lock(mMutex);
-        if (mCallbackThread == nullptr) {
-            mCallbackThread = std::make_unique<std::thread>(&CallbackScheduler::loop, this);
-        }
-        mQueue.emplace(DelayedCallback(callback, delay));
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mCallbackThread == nullptr) {
+        mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        LOG_ALWAYS_FATAL_IF(mTimerFd < 0, "Could not create timerfd: %s", strerror(errno));
+        mCallbackThread = std::make_unique<std::thread>(&CallbackScheduler::loop, this);
+    }
+    mQueue.emplace(DelayedCallback(callback, delay));
+    armTimerLocked();
+}
+
+void CallbackScheduler::armTimerLocked() {
+    itimerspec spec = {};
+    if (mFinished) {
+        // Wake the callback thread up right away, so it can see it has to finish.
+        spec = toTimerSpec(DelayedCallback::Timestamp());
+    } else if (!mQueue.empty()) {
+        spec = toTimerSpec(mQueue.top().getExpiration());
+    }
+    if (timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        ALOGE("Could not arm timerfd: %s", strerror(errno));
     }
-    mCondition.notify_all();
 }
 
 void CallbackScheduler::loop() {
     while (true) {
+        // Wait until the first callback expires, or the destructor is called.
+        uint64_t expirations;
+        if (TEMP_FAILURE_RETRY(read(mTimerFd, &expirations, sizeof(expirations))) < 0) {
+            ALOGE("Could not read timerfd: %s", strerror(errno));
+        }
+
         std::unique_lock<std::mutex> lock(mMutex);
         if (mFinished) {
             // Destructor was called, so let the callback thread die.
@@ -83,13 +129,7 @@ void CallbackScheduler::loop() {
             callback.run();
             lock.lock();
         }
-        if (mQueue.empty()) {
-            // Wait until a new callback is scheduled.
-            mCondition.wait(mMutex);
-        } else {
-            // Wait until next callback expires, or a new one is scheduled.
-            mCondition.wait_until(mMutex, mQueue.top().getExpiration());
-        }
+        armTimerLocked();
     }
 }
 
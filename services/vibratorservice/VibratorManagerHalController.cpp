@@ -37,7 +37,9 @@ std::shared_ptr<ManagerHalWrapper> connectManagerHal(std::shared_ptr<CallbackSch
     }
 
     gHalExists = false;
-    return std::make_shared<LegacyManagerHalWrapper>();
+    // The single vibrator shares the scheduler of the manager, like the ones from the AIDL HAL.
+    return std::make_shared<LegacyManagerHalWrapper>(
+            std::make_shared<HalController>(std::move(scheduler), &connectHal));
 }
 
 static constexpr int MAX_RETRIES = 1;
@@ -17,8 +17,11 @@
 #define LOG_TAG "PowerHalControllerBenchmarks"
 
 #include <benchmark/benchmark.h>
+#include <vibratorservice/VibratorCallbackScheduler.h>
 #include <vibratorservice/VibratorHalController.h>
 
+#include <condition_variable>
+
 using ::android::enum_range;
 using ::android::hardware::vibrator::CompositeEffect;
 using ::android::hardware::vibrator::CompositePrimitive;
@@ -468,4 +471,43 @@ BENCHMARK_WRAPPER(VibratorPrimitivesBench, performComposedEffect, {
     }
 });
 
+// Measures how late the callbacks of vibrators sharing a scheduler run, when they are all scheduled
+// to expire together as for a synced effect. This doesn't need a vibrator HAL.
+static void BM_CallbackSchedulerLatency(State& state) {
+    const int64_t callbackCount = state.range(0);
+    vibrator::CallbackScheduler scheduler;
+    std::mutex mutex;
+    std::condition_variable condition;
+    double totalLatenessUs = 0;
+    double totalSpreadUs = 0;
+
+    for (auto _ : state) {
+        std::vector<std::chrono::steady_clock::time_point> runTimes;
+        auto expiration = std::chrono::steady_clock::now() + 1ms;
+        for (int64_t i = 0; i < callbackCount; i++) {
+            scheduler.schedule(
+                    [&]() {
+                        auto now = std::chrono::steady_clock::now();
+                        std::lock_guard<std::mutex> lock(mutex);
+                        runTimes.push_back(now);
+                        condition.notify_all();
+                    },
+                    1ms);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock,
+                       [&]() { return static_cast<int64_t>(runTimes.size()) == callbackCount; });
+
+        std::chrono::duration<double, std::micro> lateness = runTimes.back() - expiration;
+        std::chrono::duration<double, std::micro> spread = runTimes.back() - runTimes.front();
+        totalLatenessUs += lateness.count();
+        totalSpreadUs += spread.count();
+    }
+
+    state.counters["lateness_us"] = Counter(totalLatenessUs, Counter::kAvgIterations);
+    state.counters["spread_us"] = Counter(totalSpreadUs, Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_CallbackSchedulerLatency)->Arg(1)->Arg(4)->Unit(kMicrosecond);
+
 BENCHMARK_MAIN();
\ No newline at end of file
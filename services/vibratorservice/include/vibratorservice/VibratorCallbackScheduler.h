@@ -19,7 +19,8 @@
 
 #include <android-base/thread_annotations.h>
 #include <chrono>
-#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <thread>
 
@@ -50,19 +51,23 @@ private:
 };
 
 // Schedules callbacks to be executed after a delay.
+// The callback thread sleeps on a CLOCK_MONOTONIC timerfd armed for the earliest expiration, so
+// callbacks are not delayed by changes to the wall clock, and the ones that expire together run in
+// a single wakeup. A single scheduler is shared by all the vibrators of a manager.
 class CallbackScheduler {
 public:
-    CallbackScheduler() : mCallbackThread(nullptr), mFinished(false) {}
+    CallbackScheduler() : mCallbackThread(nullptr), mTimerFd(-1), mFinished(false) {}
     virtual ~CallbackScheduler();
 
     virtual void schedule(std::function<void()> callback, std::chrono::milliseconds delay);
 
 private:
-    std::condition_variable_any mCondition;
     std::mutex mMutex;
 
     // Lazily instantiated only at the first time this scheduler is used.
     std::unique_ptr<std::thread> mCallbackThread;
+    // Created with the callback thread, and armed for the expiration on top of mQueue.
+    int mTimerFd;
 
     // Used to quit the callback thread when this instance is being destroyed.
     bool mFinished GUARDED_BY(mMutex);
@@ -73,6 +78,9 @@ private:
             mQueue GUARDED_BY(mMutex);
 
     void loop();
+    // Arms mTimerFd for the first callback to expire, for right away once finished, or disarms it
+    // if there is nothing to wait for.
+    void armTimerLocked() REQUIRES(mMutex);
 };
 
 }; // namespace vibrator
@@ -114,6 +114,19 @@ TEST_F(VibratorCallbackSchedulerTest, TestScheduleInParallelRunsInDelayOrder) {
     ASSERT_THAT(getExpiredCallbacks(), ElementsAre(0, 1, 2, 3, 4));
 }
 
+TEST_F(VibratorCallbackSchedulerTest, TestScheduleFromCallbackRunsInDelayOrder) {
+    mScheduler->schedule(
+            [this]() {
+                createCallback(1)();
+                mScheduler->schedule(createCallback(3), 10ms);
+                mScheduler->schedule(createCallback(2), 1ms);
+            },
+            1ms);
+
+    ASSERT_TRUE(waitForCallbacks(3, 20ms));
+    ASSERT_THAT(getExpiredCallbacks(), ElementsAre(1, 2, 3));
+}
+
 TEST_F(VibratorCallbackSchedulerTest, TestDestructorDropsPendingCallbacksAndKillsThread) {
     mScheduler->schedule(createCallback(1), 5ms);
     mScheduler.reset(nullptr);
@@ -76,19 +76,37 @@ class Hal {
 
     int GetDebugReportIndex() const { return debug_report_index_; }
 
+    // The HAL instance extensions and vkEnumerateInstanceVersion do not depend
+    // on any instance, so they are looked up once when the HAL is opened and
+    // reused by every vkCreateInstance.
+    VkResult EnumerateInstanceExtensionProperties(
+        uint32_t* count,
+        VkExtensionProperties* props) const;
+    PFN_vkEnumerateInstanceVersion GetEnumerateInstanceVersion() const {
+        return enumerate_instance_version_;
+    }
+
    private:
-    Hal() : dev_(nullptr), debug_report_index_(-1) {}
+    Hal()
+        : dev_(nullptr),
+          debug_report_index_(-1),
+          instance_extensions_valid_(false),
+          enumerate_instance_version_(nullptr) {}
     Hal(const Hal&) = delete;
     Hal& operator=(const Hal&) = delete;
 
     bool ShouldUnloadBuiltinDriver();
     void UnloadBuiltinDriver();
-    bool InitDebugReportIndex();
+    bool InitInstanceExtensions();
 
     static Hal hal_;
 
     const hwvulkan_device_t* dev_;
     int debug_report_index_;
+
+    std::vector<VkExtensionProperties> instance_extensions_;
+    bool instance_extensions_valid_;
+    PFN_vkEnumerateInstanceVersion enumerate_instance_version_;
 };
 
 class CreateInfoWrapper {
@@ -283,7 +301,10 @@ bool Hal::Open() {
 
     hal_.dev_ = device;
 
-    hal_.InitDebugReportIndex();
+    hal_.InitInstanceExtensions();
+    hal_.enumerate_instance_version_ =
+        reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+            device->GetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
 
     android::GraphicsEnv::getInstance().setDriverLoaded(
         android::GpuStatsInfo::Api::API_VK, true, systemTime() - openTime);
@@ -321,9 +342,12 @@ void Hal::UnloadBuiltinDriver() {
 
     hal_.dev_ = nullptr;
     hal_.debug_report_index_ = -1;
+    hal_.instance_extensions_.clear();
+    hal_.instance_extensions_valid_ = false;
+    hal_.enumerate_instance_version_ = nullptr;
 }
 
-bool Hal::InitDebugReportIndex() {
+bool Hal::InitInstanceExtensions() {
     ATRACE_CALL();
 
     uint32_t count;
@@ -333,33 +357,48 @@ bool Hal::InitDebugReportIndex() {
         return false;
     }
 
-    VkExtensionProperties* exts = reinterpret_cast<VkExtensionProperties*>(
-        malloc(sizeof(VkExtensionProperties) * count));
-    if (!exts) {
-        ALOGE("failed to allocate HAL instance extension array");
-        return false;
-    }
-
-    if (dev_->EnumerateInstanceExtensionProperties(nullptr, &count, exts) !=
-        VK_SUCCESS) {
+    instance_extensions_.resize(count);
+    if (dev_->EnumerateInstanceExtensionProperties(
+            nullptr, &count, instance_extensions_.data()) != VK_SUCCESS) {
         ALOGE("failed to enumerate HAL instance extensions");
-        free(exts);
+        instance_extensions_.clear();
         return false;
     }
+    instance_extensions_.resize(count);
 
     for (uint32_t i = 0; i < count; i++) {
-        if (strcmp(exts[i].extensionName, VK_EXT_DEBUG_REPORT_EXTENSION_NAME) ==
-            0) {
+        if (strcmp(instance_extensions_[i].extensionName,
+                   VK_EXT_DEBUG_REPORT_EXTENSION_NAME) == 0) {
             debug_report_index_ = static_cast<int>(i);
             break;
         }
     }
 
-    free(exts);
+    instance_extensions_valid_ = true;
 
     return true;
 }
 
+VkResult Hal::EnumerateInstanceExtensionProperties(
+    uint32_t* count,
+    VkExtensionProperties* props) const {
+    if (!instance_extensions_valid_)
+        return dev_->EnumerateInstanceExtensionProperties(nullptr, count,
+                                                          props);
+
+    const uint32_t total = static_cast<uint32_t>(instance_extensions_.size());
+    if (!props) {
+        *count = total;
+        return VK_SUCCESS;
+    }
+
+    const uint32_t copied = std::min(*count, total);
+    std::copy_n(instance_extensions_.data(), copied, props);
+    *count = copied;
+
+    return (copied == total) ? VK_SUCCESS : VK_INCOMPLETE;
+}
+
 CreateInfoWrapper::CreateInfoWrapper(const VkInstanceCreateInfo& create_info,
                                      uint32_t icd_api_version,
                                      const VkAllocationCallbacks& allocator)
@@ -540,8 +579,7 @@ VkResult CreateInfoWrapper::SanitizeExtensions() {
 
 VkResult CreateInfoWrapper::QueryExtensionCount(uint32_t& count) const {
     if (is_instance_) {
-        return Hal::Device().EnumerateInstanceExtensionProperties(
-            nullptr, &count, nullptr);
+        return Hal::Get().EnumerateInstanceExtensionProperties(&count, nullptr);
     } else {
         const auto& driver = GetData(physical_dev_).driver;
         return driver.EnumerateDeviceExtensionProperties(physical_dev_, nullptr,
@@ -553,8 +591,7 @@ VkResult CreateInfoWrapper::EnumerateExtensions(
     uint32_t& count,
     VkExtensionProperties* props) const {
     if (is_instance_) {
-        return Hal::Device().EnumerateInstanceExtensionProperties(
-            nullptr, &count, props);
+        return Hal::Get().EnumerateInstanceExtensionProperties(&count, props);
     } else {
         const auto& driver = GetData(physical_dev_).driver;
         return driver.EnumerateDeviceExtensionProperties(physical_dev_, nullptr,
@@ -955,8 +992,11 @@ VkResult EnumerateInstanceExtensionProperties(
     }
 
     ATRACE_BEGIN("driver.EnumerateInstanceExtensionProperties");
-    VkResult result = Hal::Device().EnumerateInstanceExtensionProperties(
-        pLayerName, pPropertyCount, pProperties);
+    VkResult result =
+        pLayerName ? Hal::Device().EnumerateInstanceExtensionProperties(
+                         pLayerName, pPropertyCount, pProperties)
+                   : Hal::Get().EnumerateInstanceExtensionProperties(
+                         pPropertyCount, pProperties);
     ATRACE_END();
 
     if (!pLayerName && (result == VK_SUCCESS || result == VK_INCOMPLETE)) {
@@ -1089,9 +1129,7 @@ VkResult CreateInstance(const VkInstanceCreateInfo* pCreateInfo,
     VkResult result = VK_SUCCESS;
     uint32_t icd_api_version = VK_API_VERSION_1_0;
     PFN_vkEnumerateInstanceVersion pfn_enumerate_instance_version =
-        reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
-            Hal::Device().GetInstanceProcAddr(nullptr,
-                                              "vkEnumerateInstanceVersion"));
+        Hal::Get().GetEnumerateInstanceVersion();
     if (pfn_enumerate_instance_version) {
         ATRACE_BEGIN("pfn_enumerate_instance_version");
         result = (*pfn_enumerate_instance_version)(&icd_api_version);
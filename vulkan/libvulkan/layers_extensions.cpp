@@ -26,6 +26,7 @@
 
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <android/dlext.h>
@@ -95,7 +96,7 @@ class LayerLibrary {
     bool EnumerateLayers(size_t library_idx,
                          std::vector<Layer>& instance_layers) const;
 
-    void* GetGPA(const Layer& layer, const std::string_view gpa_name) const;
+    void* GetGPA(const Layer& layer, const std::string_view gpa_name);
 
     const std::string GetFilename() { return filename_; }
 
@@ -120,6 +121,11 @@ class LayerLibrary {
     void* dlhandle_;
     bool native_bridge_;
     size_t refcount_;
+
+    // Memoizes GetGPA while the library stays open, so that instances and
+    // devices enabling the same layers don't look the symbols up again.
+    // Keyed by layer name followed by the GPA name.
+    std::unordered_map<std::string, void*> gpa_cache_;
 };
 
 bool LayerLibrary::Open() {
@@ -167,6 +173,7 @@ void LayerLibrary::Close() {
             refcount_++;
         } else {
            dlhandle_ = nullptr;
+           gpa_cache_.clear();
         }
     }
 }
@@ -312,11 +319,20 @@ bool LayerLibrary::EnumerateLayers(size_t library_idx,
     return true;
 }
 
-void* LayerLibrary::GetGPA(const Layer& layer, const std::string_view gpa_name) const {
+void* LayerLibrary::GetGPA(const Layer& layer, const std::string_view gpa_name) {
     std::string layer_name { layer.properties.layerName };
-    if (void* gpa = GetTrampoline((layer_name.append(gpa_name).c_str())))
-        return gpa;
-    return GetTrampoline((std::string {"vk"}.append(gpa_name)).c_str());
+    layer_name.append(gpa_name);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cached = gpa_cache_.find(layer_name);
+    if (cached != gpa_cache_.end())
+        return cached->second;
+
+    void* gpa = GetTrampoline(layer_name.c_str());
+    if (!gpa)
+        gpa = GetTrampoline((std::string {"vk"}.append(gpa_name)).c_str());
+    gpa_cache_.emplace(std::move(layer_name), gpa);
+    return gpa;
 }
 
 // ----------------------------------------------------------------------------
@@ -452,7 +468,7 @@ const VkExtensionProperties* FindExtension(
 
 void* GetLayerGetProcAddr(const Layer& layer,
                           const std::string_view gpa_name) {
-    const LayerLibrary& library = g_layer_libraries[layer.library_idx];
+    LayerLibrary& library = g_layer_libraries[layer.library_idx];
     return library.GetGPA(layer, gpa_name);
 }
 
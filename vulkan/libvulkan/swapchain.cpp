@@ -237,6 +237,9 @@ struct Swapchain {
         native_window_get_refresh_cycle_duration(
             window,
             &refresh_duration);
+        // Presents append one record and trim back to MAX_TIMING_INFOS, so
+        // reserving room for one more keeps them from allocating.
+        timing.reserve(MAX_TIMING_INFOS + 1);
     }
     uint64_t get_refresh_duration()
     {
@@ -561,6 +564,55 @@ int get_min_buffer_count(ANativeWindow* window,
     return android::OK;
 }
 
+// Returns whether a swapchain created with create_info can take over the
+// buffers of old_swapchain instead of reconnecting to the window and
+// dequeueing new ones. This requires the old swapchain to still own the
+// window with none of its images acquired, to use the same non-shared present
+// mode and image count, and to have buffers that satisfy the new dimensions,
+// format and usage, so that the window would not reallocate them anyway.
+bool CanReuseSwapchainBuffers(ANativeWindow* window,
+                              const Swapchain& old_swapchain,
+                              const VkSwapchainCreateInfoKHR* create_info,
+                              android_pixel_format native_pixel_format,
+                              uint64_t native_usage) {
+    if (old_swapchain.surface.swapchain_handle !=
+        HandleFromSwapchain(&old_swapchain))
+        return false;
+
+    const bool shared =
+        create_info->presentMode ==
+            VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR ||
+        create_info->presentMode ==
+            VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR;
+    const bool mailbox_mode =
+        create_info->presentMode == VK_PRESENT_MODE_MAILBOX_KHR;
+    if (shared || old_swapchain.shared ||
+        mailbox_mode != old_swapchain.mailbox_mode)
+        return false;
+
+    uint32_t min_buffer_count;
+    if (get_min_buffer_count(window, &min_buffer_count) != android::OK)
+        return false;
+    if (std::max(min_buffer_count, create_info->minImageCount) !=
+        old_swapchain.num_images)
+        return false;
+
+    for (uint32_t i = 0; i < old_swapchain.num_images; i++) {
+        const Swapchain::Image& img = old_swapchain.images[i];
+        if (img.dequeued || !img.buffer)
+            return false;
+        if (static_cast<uint32_t>(img.buffer->width) !=
+                create_info->imageExtent.width ||
+            static_cast<uint32_t>(img.buffer->height) !=
+                create_info->imageExtent.height ||
+            img.buffer->format != native_pixel_format ||
+            (img.buffer->usage & native_usage) != native_usage)
+            return false;
+    }
+
+    return true;
+}
+
 }  // anonymous namespace
 
 VKAPI_ATTR
@@ -1084,29 +1136,91 @@ VkResult CreateSwapchainKHR(VkDevice device,
               reinterpret_cast<uint64_t>(create_info->oldSwapchain));
         return VK_ERROR_NATIVE_WINDOW_IN_USE_KHR;
     }
-    if (create_info->oldSwapchain != VK_NULL_HANDLE)
-        OrphanSwapchain(device, SwapchainFromHandle(create_info->oldSwapchain));
-
-    // -- Reset the native window --
-    // The native window might have been used previously, and had its properties
-    // changed from defaults. That will affect the answer we get for queries
-    // like MIN_UNDEQUED_BUFFERS. Reset to a known/default state before we
-    // attempt such queries.
-
-    // The native window only allows dequeueing all buffers before any have
-    // been queued, since after that point at least one is assumed to be in
-    // non-FREE state at any given time. Disconnecting and re-connecting
-    // orphans the previous buffers, getting us back to the state where we can
-    // dequeue all buffers.
-    //
-    // TODO(http://b/134186185) recycle swapchain images more efficiently
+    const auto& dispatch = GetData(device).driver;
+
+    VkSwapchainImageUsageFlagsANDROID swapchain_image_usage = 0;
+    if (create_info->presentMode == VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR ||
+        create_info->presentMode == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR) {
+        swapchain_image_usage |= VK_SWAPCHAIN_IMAGE_USAGE_SHARED_BIT_ANDROID;
+    }
+
+    int32_t legacy_usage = 0;
+    if (dispatch.GetSwapchainGrallocUsage2ANDROID) {
+        uint64_t consumer_usage, producer_usage;
+        ATRACE_BEGIN("GetSwapchainGrallocUsage2ANDROID");
+        result = dispatch.GetSwapchainGrallocUsage2ANDROID(
+            device, create_info->imageFormat, create_info->imageUsage,
+            swapchain_image_usage, &consumer_usage, &producer_usage);
+        ATRACE_END();
+        if (result != VK_SUCCESS) {
+            ALOGE("vkGetSwapchainGrallocUsage2ANDROID failed: %d", result);
+            return VK_ERROR_SURFACE_LOST_KHR;
+        }
+        legacy_usage =
+            android_convertGralloc1To0Usage(producer_usage, consumer_usage);
+    } else if (dispatch.GetSwapchainGrallocUsageANDROID) {
+        ATRACE_BEGIN("GetSwapchainGrallocUsageANDROID");
+        result = dispatch.GetSwapchainGrallocUsageANDROID(
+            device, create_info->imageFormat, create_info->imageUsage,
+            &legacy_usage);
+        ATRACE_END();
+        if (result != VK_SUCCESS) {
+            ALOGE("vkGetSwapchainGrallocUsageANDROID failed: %d", result);
+            return VK_ERROR_SURFACE_LOST_KHR;
+        }
+    }
+    uint64_t native_usage = static_cast<uint64_t>(legacy_usage);
+
+    bool createProtectedSwapchain = false;
+    if (create_info->flags & VK_SWAPCHAIN_CREATE_PROTECTED_BIT_KHR) {
+        createProtectedSwapchain = true;
+        native_usage |= BufferUsage::PROTECTED;
+    }
+
+    // -- Retire the old swapchain --
+    // When the old swapchain's buffers still fit, keep references to them so
+    // that the new swapchain can take them over, and keep the window connected
+    // so that it doesn't reallocate them.
     ANativeWindow* window = surface.window.get();
-    err = native_window_api_disconnect(window, NATIVE_WINDOW_API_EGL);
-    ALOGW_IF(err != android::OK, "native_window_api_disconnect failed: %s (%d)",
-             strerror(-err), err);
-    err = native_window_api_connect(window, NATIVE_WINDOW_API_EGL);
-    ALOGW_IF(err != android::OK, "native_window_api_connect failed: %s (%d)",
-             strerror(-err), err);
+    android::sp<ANativeWindowBuffer>
+        reused_buffers[android::BufferQueueDefs::NUM_BUFFER_SLOTS];
+    uint32_t num_reused_buffers = 0;
+    if (create_info->oldSwapchain != VK_NULL_HANDLE) {
+        Swapchain* old_swapchain =
+            SwapchainFromHandle(create_info->oldSwapchain);
+        if (CanReuseSwapchainBuffers(window, *old_swapchain, create_info,
+                                     native_pixel_format, native_usage)) {
+            ATRACE_NAME("reuse swapchain buffers");
+            num_reused_buffers = old_swapchain->num_images;
+            for (uint32_t i = 0; i < num_reused_buffers; i++)
+                reused_buffers[i] = old_swapchain->images[i].buffer;
+            if (old_swapchain->frame_timestamps_enabled)
+                native_window_enable_frame_timestamps(window, false);
+        }
+        OrphanSwapchain(device, old_swapchain);
+    }
+
+    if (!num_reused_buffers) {
+        // -- Reset the native window --
+        // The native window might have been used previously, and had its
+        // properties changed from defaults. That will affect the answer we get
+        // for queries like MIN_UNDEQUED_BUFFERS. Reset to a known/default state
+        // before we attempt such queries.
+
+        // The native window only allows dequeueing all buffers before any have
+        // been queued, since after that point at least one is assumed to be in
+        // non-FREE state at any given time. Disconnecting and re-connecting
+        // orphans the previous buffers, getting us back to the state where we
+        // can dequeue all buffers.
+        err = native_window_api_disconnect(window, NATIVE_WINDOW_API_EGL);
+        ALOGW_IF(err != android::OK,
+                 "native_window_api_disconnect failed: %s (%d)",
+                 strerror(-err), err);
+        err = native_window_api_connect(window, NATIVE_WINDOW_API_EGL);
+        ALOGW_IF(err != android::OK,
+                 "native_window_api_connect failed: %s (%d)", strerror(-err),
+                 err);
+    }
 
     err =
         window->perform(window, NATIVE_WINDOW_SET_DEQUEUE_TIMEOUT, nsecs_t{-1});
@@ -1141,8 +1255,6 @@ VkResult CreateSwapchainKHR(VkDevice device,
 
     // -- Configure the native window --
 
-    const auto& dispatch = GetData(device).driver;
-
     err = native_window_set_buffers_format(window, native_pixel_format);
     if (err != android::OK) {
         ALOGE("native_window_set_buffers_format(%d) failed: %s (%d)",
@@ -1191,10 +1303,7 @@ VkResult CreateSwapchainKHR(VkDevice device,
         return VK_ERROR_SURFACE_LOST_KHR;
     }
 
-    VkSwapchainImageUsageFlagsANDROID swapchain_image_usage = 0;
-    if (create_info->presentMode == VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR ||
-        create_info->presentMode == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR) {
-        swapchain_image_usage |= VK_SWAPCHAIN_IMAGE_USAGE_SHARED_BIT_ANDROID;
+    if (swapchain_image_usage & VK_SWAPCHAIN_IMAGE_USAGE_SHARED_BIT_ANDROID) {
         err = native_window_set_shared_buffer_mode(window, true);
         if (err != android::OK) {
             ALOGE("native_window_set_shared_buffer_mode failed: %s (%d)", strerror(-err), err);
@@ -1219,6 +1328,19 @@ VkResult CreateSwapchainKHR(VkDevice device,
     uint32_t num_images =
         std::max(min_buffer_count, create_info->minImageCount);
 
+    if (num_reused_buffers && num_reused_buffers != num_images) {
+        // The window was not reset, so it can't be made to hand out a
+        // different number of buffers. Start over without the old swapchain,
+        // which has already been retired.
+        ALOGW("swapchain image count changed from %u to %u; not reusing "
+              "buffers",
+              num_reused_buffers, num_images);
+        VkSwapchainCreateInfoKHR reset_create_info = *create_info;
+        reset_create_info.oldSwapchain = VK_NULL_HANDLE;
+        return CreateSwapchainKHR(device, &reset_create_info, allocator,
+                                  swapchain_handle);
+    }
+
     // Lower layer insists that we have at least two buffers. This is wasteful
     // and we'd like to relax it in the shared case, but not all the pieces are
     // in place for that to work yet. Note we only lie to the lower layer-- we
@@ -1231,38 +1353,6 @@ VkResult CreateSwapchainKHR(VkDevice device,
         return VK_ERROR_SURFACE_LOST_KHR;
     }
 
-    int32_t legacy_usage = 0;
-    if (dispatch.GetSwapchainGrallocUsage2ANDROID) {
-        uint64_t consumer_usage, producer_usage;
-        ATRACE_BEGIN("GetSwapchainGrallocUsage2ANDROID");
-        result = dispatch.GetSwapchainGrallocUsage2ANDROID(
-            device, create_info->imageFormat, create_info->imageUsage,
-            swapchain_image_usage, &consumer_usage, &producer_usage);
-        ATRACE_END();
-        if (result != VK_SUCCESS) {
-            ALOGE("vkGetSwapchainGrallocUsage2ANDROID failed: %d", result);
-            return VK_ERROR_SURFACE_LOST_KHR;
-        }
-        legacy_usage =
-            android_convertGralloc1To0Usage(producer_usage, consumer_usage);
-    } else if (dispatch.GetSwapchainGrallocUsageANDROID) {
-        ATRACE_BEGIN("GetSwapchainGrallocUsageANDROID");
-        result = dispatch.GetSwapchainGrallocUsageANDROID(
-            device, create_info->imageFormat, create_info->imageUsage,
-            &legacy_usage);
-        ATRACE_END();
-        if (result != VK_SUCCESS) {
-            ALOGE("vkGetSwapchainGrallocUsageANDROID failed: %d", result);
-            return VK_ERROR_SURFACE_LOST_KHR;
-        }
-    }
-    uint64_t native_usage = static_cast<uint64_t>(legacy_usage);
-
-    bool createProtectedSwapchain = false;
-    if (create_info->flags & VK_SWAPCHAIN_CREATE_PROTECTED_BIT_KHR) {
-        createProtectedSwapchain = true;
-        native_usage |= BufferUsage::PROTECTED;
-    }
     err = native_window_set_usage(window, native_usage);
     if (err != android::OK) {
         ALOGE("native_window_set_usage failed: %s (%d)", strerror(-err), err);
@@ -1290,6 +1380,8 @@ VkResult CreateSwapchainKHR(VkDevice device,
                   TranslateVulkanToNativeTransform(create_info->preTransform));
     // -- Dequeue all buffers and create a VkImage for each --
     // Any failures during or after this must cancel the dequeued buffers.
+    // Buffers taken over from the old swapchain are not dequeued, since the
+    // window still tracks them in its own slots.
 
     VkSwapchainImageCreateInfoANDROID swapchain_image_create = {
 #pragma clang diagnostic push
@@ -1326,22 +1418,27 @@ VkResult CreateSwapchainKHR(VkDevice device,
     for (uint32_t i = 0; i < num_images; i++) {
         Swapchain::Image& img = swapchain->images[i];
 
-        ANativeWindowBuffer* buffer;
-        err = window->dequeueBuffer(window, &buffer, &img.dequeue_fence);
-        if (err != android::OK) {
-            ALOGE("dequeueBuffer[%u] failed: %s (%d)", i, strerror(-err), err);
-            switch (-err) {
-                case ENOMEM:
-                    result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
-                    break;
-                default:
-                    result = VK_ERROR_SURFACE_LOST_KHR;
-                    break;
+        if (num_reused_buffers) {
+            img.buffer = reused_buffers[i];
+        } else {
+            ANativeWindowBuffer* buffer;
+            err = window->dequeueBuffer(window, &buffer, &img.dequeue_fence);
+            if (err != android::OK) {
+                ALOGE("dequeueBuffer[%u] failed: %s (%d)", i, strerror(-err),
+                      err);
+                switch (-err) {
+                    case ENOMEM:
+                        result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                        break;
+                    default:
+                        result = VK_ERROR_SURFACE_LOST_KHR;
+                        break;
+                }
+                break;
             }
-            break;
+            img.buffer = buffer;
+            img.dequeued = true;
         }
-        img.buffer = buffer;
-        img.dequeued = true;
 
         image_create.extent =
             VkExtent3D{static_cast<uint32_t>(img.buffer->width),
@@ -1607,8 +1704,34 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
     const VkPresentTimeGOOGLE* times =
         (present_times) ? present_times->pTimes : nullptr;
     const VkAllocationCallbacks* allocator = &GetData(device).allocator;
-    android_native_rect_t* rects = nullptr;
-    uint32_t nrects = 0;
+
+    // Damage rectangles are converted into a stack buffer, unless a swapchain
+    // has more of them; the buffer is then allocated once for the largest.
+    constexpr uint32_t kMaxStackRects = 16;
+    android_native_rect_t stack_rects[kMaxStackRects];
+    android_native_rect_t* rects = stack_rects;
+    uint32_t nrects = kMaxStackRects;
+    if (regions) {
+        uint32_t max_rects = 0;
+        for (uint32_t sc = 0; sc < present_info->swapchainCount; sc++)
+            max_rects = std::max(max_rects, regions[sc].rectangleCount);
+        if (max_rects > kMaxStackRects) {
+            android_native_rect_t* heap_rects =
+                static_cast<android_native_rect_t*>(allocator->pfnAllocation(
+                    allocator->pUserData,
+                    sizeof(android_native_rect_t) * max_rects,
+                    alignof(android_native_rect_t),
+                    VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+            if (heap_rects) {
+                rects = heap_rects;
+                nrects = max_rects;
+            }
+        }
+    }
+
+    // The wait semaphores are only waited on by the first release; its fence
+    // is shared with the images of the other swapchains.
+    int wait_fence = -1;
 
     for (uint32_t sc = 0; sc < present_info->swapchainCount; sc++) {
         Swapchain& swapchain =
@@ -1624,12 +1747,28 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
 
         int fence = -1;
         result = dispatch.QueueSignalReleaseImageANDROID(
-            queue, present_info->waitSemaphoreCount,
+            queue, sc == 0 ? present_info->waitSemaphoreCount : 0,
             present_info->pWaitSemaphores, img.image, &fence);
         if (result != VK_SUCCESS) {
             ALOGE("QueueSignalReleaseImageANDROID failed: %d", result);
             swapchain_result = result;
         }
+        if (sc == 0) {
+            wait_fence = fence < 0 ? -1 : dup(fence);
+        } else if (wait_fence >= 0) {
+            if (fence < 0) {
+                fence = dup(wait_fence);
+            } else {
+                int merged = sync_merge("vkQueuePresentKHR", wait_fence, fence);
+                if (merged >= 0) {
+                    close(fence);
+                    fence = merged;
+                } else {
+                    ALOGE("sync_merge failed: %s (%d)", strerror(errno), errno);
+                    sync_wait(wait_fence, -1 /* forever */);
+                }
+            }
+        }
         if (img.release_fence >= 0)
             close(img.release_fence);
         img.release_fence = fence < 0 ? -1 : dup(fence);
@@ -1642,19 +1781,7 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
                     // Process the incremental-present hint for this swapchain:
                     uint32_t rcount = region->rectangleCount;
                     if (rcount > nrects) {
-                        android_native_rect_t* new_rects =
-                            static_cast<android_native_rect_t*>(
-                                allocator->pfnReallocation(
-                                    allocator->pUserData, rects,
-                                    sizeof(android_native_rect_t) * rcount,
-                                    alignof(android_native_rect_t),
-                                    VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
-                        if (new_rects) {
-                            rects = new_rects;
-                            nrects = rcount;
-                        } else {
-                            rcount = 0;  // Ignore the hint for this swapchain
-                        }
+                        rcount = 0;  // Ignore the hint for this swapchain
                     }
                     for (uint32_t r = 0; r < rcount; ++r) {
                         if (region->pRectangles[r].layer > 0) {
@@ -1776,7 +1903,10 @@ VkResult QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
         if (swapchain_result != final_result)
             final_result = WorstPresentResult(final_result, swapchain_result);
     }
-    if (rects) {
+    if (wait_fence >= 0) {
+        close(wait_fence);
+    }
+    if (rects != stack_rects) {
         allocator->pfnFree(allocator->pUserData, rects);
     }
 